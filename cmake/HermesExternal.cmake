@@ -11,6 +11,10 @@
 #                      If set, skips auto-build and uses existing Hermes
 #   HERMES_GIT_URL   - Git repository URL (default: https://github.com/facebook/hermes.git)
 #   HERMES_GIT_TAG   - Git tag/commit/branch to checkout (default: specific commit)
+#   REACT_IMGUI_NO_ICU - Build Hermes with HERMES_UNICODE_LITE instead of ICU
+#                      (a HERMES_BUILD_DIR must have been configured with it)
+#   REACT_IMGUI_OOM_EXCEPTIONS - Build Hermes with HERMESVM_EXCEPTION_ON_OOM
+#                      (likewise)
 #
 # The module sets the following variables:
 #   HERMES_SRC    - Path to Hermes source directory
@@ -49,6 +53,20 @@ if(HERMES_BUILD_DIR)
         message(FATAL_ERROR "Hermes source directory from cache does not exist: ${HERMES_SRC_FROM_CACHE}")
     endif()
 
+    # Without ICU, Hermes must not reference it either
+    if(REACT_IMGUI_NO_ICU)
+        file(STRINGS "${CACHE_FILE}" UNICODE_LITE_LINES REGEX "^HERMES_UNICODE_LITE:")
+        if(NOT UNICODE_LITE_LINES MATCHES "=(ON|TRUE|1)$")
+            message(FATAL_ERROR "REACT_IMGUI_NO_ICU needs a Hermes build configured with -DHERMES_UNICODE_LITE=ON: ${HERMES_BUILD_DIR}")
+        endif()
+    endif()
+    if(REACT_IMGUI_OOM_EXCEPTIONS)
+        file(STRINGS "${CACHE_FILE}" OOM_EXCEPTION_LINES REGEX "^HERMESVM_EXCEPTION_ON_OOM:")
+        if(NOT OOM_EXCEPTION_LINES MATCHES "=(ON|TRUE|1)$")
+            message(FATAL_ERROR "REACT_IMGUI_OOM_EXCEPTIONS needs a Hermes build configured with -DHERMESVM_EXCEPTION_ON_OOM=ON: ${HERMES_BUILD_DIR}")
+        endif()
+    endif()
+
     # Set paths
     set(HERMES_SRC "${HERMES_SRC_FROM_CACHE}")
     set(HERMES_BUILD "${HERMES_BUILD_DIR}")
@@ -96,6 +114,12 @@ else()
         -DCMAKE_C_COMPILER=${CMAKE_C_COMPILER}
         -DCMAKE_CXX_COMPILER=${CMAKE_CXX_COMPILER}
     )
+    if(REACT_IMGUI_NO_ICU)
+        list(APPEND HERMES_CMAKE_ARGS -DHERMES_UNICODE_LITE=ON)
+    endif()
+    if(REACT_IMGUI_OOM_EXCEPTIONS)
+        list(APPEND HERMES_CMAKE_ARGS -DHERMESVM_EXCEPTION_ON_OOM=ON)
+    endif()
 
     # Add Hermes as external project
     ExternalProject_Add(hermes
@@ -8,6 +8,8 @@
 # - Compiling JS to native code with shermes
 # - Compiling JS to bytecode with hermes
 # - Creating static libraries from compiled JS units
+# - Profile-guided optimization of the native code (hermes_setup_pgo)
+# - Link-time optimization of the native code (hermes_setup_lto)
 
 #[[
 Compile JavaScript source files to native code (.o) using shermes
@@ -79,6 +81,11 @@ function(hermes_compile_native)
     if(ARG_FLAGS)
         list(APPEND COMPILER_FLAGS ${ARG_FLAGS})
     endif()
+    # shermes compiles the generated C itself, so the PGO and LTO flags are
+    # passed on
+    foreach(flag ${HERMES_PGO_FLAGS} ${HERMES_LTO_FLAGS})
+        list(APPEND COMPILER_FLAGS -Wc,${flag})
+    endforeach()
     list(APPEND COMPILER_FLAGS -c)
 
     # Add sources
@@ -91,7 +98,7 @@ function(hermes_compile_native)
     add_custom_command(
         OUTPUT ${ARG_OUTPUT}
         COMMAND ${CMAKE_COMMAND} -E env CC=${CMAKE_C_COMPILER} ${SHERMES} ${COMPILER_FLAGS}
-        DEPENDS ${ARG_SOURCES} ${ARG_DEPENDS}
+        DEPENDS ${ARG_SOURCES} ${ARG_DEPENDS} ${HERMES_PGO_DEPENDS}
         WORKING_DIRECTORY ${ARG_WORKING_DIRECTORY}
         COMMENT ${ARG_COMMENT}
     )
@@ -181,3 +188,198 @@ function(hermes_compile_bytecode)
         COMMENT ${ARG_COMMENT}
     )
 endfunction()
+
+#[[
+Set up profile-guided optimization of all native code
+
+Usage:
+  hermes_setup_pgo(<mode> <profile-dir>)
+
+Arguments:
+  mode         - OFF, GENERATE (instrumented build) or USE (build with the
+                 profile collected by the instrumented one)
+  profile-dir  - Directory of the raw profiles and of the merged profile
+
+Must be called before the units and apps are added. The flags apply to the
+C and C++ of this project (imgui-runtime, cimgui, sokol, the imgui unit's C
+helpers and the apps) and, through hermes_compile_native(), to the C that
+shermes generates for the JS units, i.e. jslib, the typed imgui unit and,
+in mode 0, the React bundle. Hermes itself is built separately and is not
+instrumented.
+
+With Clang the raw profiles go to <profile-dir>/raw and are merged by the
+pgo-merge target into <profile-dir>/default.profdata, which USE reads. GCC
+writes its .gcda files per object file, so GENERATE and USE must use the
+same build directory.
+
+Sets HERMES_PGO_FLAGS (the flags, passed to shermes with -Wc) and
+HERMES_PGO_DEPENDS (the profile, so that the units are rebuilt when it
+changes) in the caller's scope.
+]]
+function(hermes_setup_pgo MODE PROFILE_DIR)
+    set(HERMES_PGO_FLAGS "" PARENT_SCOPE)
+    set(HERMES_PGO_DEPENDS "" PARENT_SCOPE)
+    if(NOT MODE OR MODE STREQUAL "OFF")
+        return()
+    endif()
+    if(NOT MODE MATCHES "^(GENERATE|USE)$")
+        message(FATAL_ERROR "hermes_setup_pgo: mode must be OFF, GENERATE or USE, not '${MODE}'")
+    endif()
+
+    if(CMAKE_C_COMPILER_ID MATCHES "Clang")
+        set(profdata ${PROFILE_DIR}/default.profdata)
+        if(MODE STREQUAL "GENERATE")
+            set(flags -fprofile-generate=${PROFILE_DIR}/raw)
+        else()
+            if(NOT EXISTS ${profdata})
+                message(FATAL_ERROR "hermes_setup_pgo: ${profdata} not found; "
+                    "run the pgo-train target of an instrumented build first")
+            endif()
+            set(flags -fprofile-use=${profdata} -Wno-profile-instr-unprofiled
+                -Wno-profile-instr-out-of-date)
+            set(HERMES_PGO_DEPENDS ${profdata} PARENT_SCOPE)
+        endif()
+
+        # llvm-profdata must match the compiler's version
+        get_filename_component(compiler_dir ${CMAKE_C_COMPILER} DIRECTORY)
+        find_program(LLVM_PROFDATA NAMES llvm-profdata HINTS ${compiler_dir})
+        if(NOT LLVM_PROFDATA AND APPLE)
+            execute_process(COMMAND xcrun -f llvm-profdata
+                OUTPUT_VARIABLE LLVM_PROFDATA OUTPUT_STRIP_TRAILING_WHITESPACE)
+        endif()
+        if(MODE STREQUAL "GENERATE" AND NOT LLVM_PROFDATA)
+            message(FATAL_ERROR "hermes_setup_pgo: llvm-profdata not found; set LLVM_PROFDATA")
+        endif()
+        set(LLVM_PROFDATA ${LLVM_PROFDATA} PARENT_SCOPE)
+    elseif(CMAKE_C_COMPILER_ID STREQUAL "GNU")
+        if(MODE STREQUAL "GENERATE")
+            set(flags -fprofile-generate=${PROFILE_DIR} -fprofile-update=atomic)
+        else()
+            if(NOT IS_DIRECTORY ${PROFILE_DIR})
+                message(FATAL_ERROR "hermes_setup_pgo: ${PROFILE_DIR} not found; "
+                    "run the pgo-train target of an instrumented build first")
+            endif()
+            # Code the training run didn't reach stays optimized for speed
+            set(flags -fprofile-use=${PROFILE_DIR} -fprofile-partial-training
+                -Wno-missing-profile)
+        endif()
+    else()
+        message(FATAL_ERROR "hermes_setup_pgo: PGO needs Clang or GCC, not ${CMAKE_C_COMPILER_ID}")
+    endif()
+
+    add_compile_options(${flags})
+    add_link_options(${flags})
+    set(HERMES_PGO_FLAGS ${flags} PARENT_SCOPE)
+endfunction()
+
+#[[
+Add the training run of an instrumented (GENERATE) build
+
+Usage:
+  hermes_add_pgo_training(
+    PROFILE_DIR <profile-dir>
+    RUNS <target> <args>... [RUNS <target> <args>...]...
+  )
+
+Adds the pgo-train target, which deletes the previous profiles, runs each
+target with its arguments and, with Clang, merges the raw profiles (the
+pgo-merge target). The runs should be headless and drive the hot paths:
+reconciliation, the render plans and the ImGui frame.
+
+Example:
+  hermes_add_pgo_training(
+    PROFILE_DIR ${REACT_IMGUI_PGO_DIR}
+    RUNS bench --headless --frames=3000
+  )
+]]
+function(hermes_add_pgo_training)
+    cmake_parse_arguments(ARG "" "PROFILE_DIR" "" ${ARGN})
+    if(NOT ARG_PROFILE_DIR)
+        message(FATAL_ERROR "hermes_add_pgo_training: PROFILE_DIR is required")
+    endif()
+
+    # Split the arguments into one command per RUNS
+    set(commands)
+    set(targets)
+    set(run)
+    foreach(arg ${ARG_UNPARSED_ARGUMENTS} RUNS)
+        if(arg STREQUAL "RUNS")
+            if(run)
+                list(POP_FRONT run target)
+                list(APPEND targets ${target})
+                list(APPEND commands COMMAND $<TARGET_FILE:${target}> ${run})
+            endif()
+            set(run)
+        else()
+            list(APPEND run ${arg})
+        endif()
+    endforeach()
+    if(NOT targets)
+        message(FATAL_ERROR "hermes_add_pgo_training: at least one RUNS is required")
+    endif()
+
+    # Also a target of its own, to merge the profiles of manual runs
+    set(merge)
+    if(CMAKE_C_COMPILER_ID MATCHES "Clang")
+        set(merge COMMAND ${LLVM_PROFDATA} merge
+            -o ${ARG_PROFILE_DIR}/default.profdata ${ARG_PROFILE_DIR}/raw)
+        add_custom_target(pgo-merge
+            ${merge}
+            COMMENT "Merging PGO profiles into ${ARG_PROFILE_DIR}/default.profdata"
+            VERBATIM
+        )
+    endif()
+
+    # GCC accumulates counters in existing .gcda files, so a new run starts
+    # from no profile
+    add_custom_target(pgo-train
+        COMMAND ${CMAKE_COMMAND} -E rm -rf ${ARG_PROFILE_DIR}
+        COMMAND ${CMAKE_COMMAND} -E make_directory ${ARG_PROFILE_DIR}
+        ${commands}
+        ${merge}
+        DEPENDS ${targets}
+        WORKING_DIRECTORY ${CMAKE_BINARY_DIR}
+        COMMENT "Running the PGO training workload"
+        VERBATIM
+    )
+endfunction()
+
+#[[
+Set up link-time optimization of all native code
+
+Usage:
+  hermes_setup_lto(<enabled>)
+
+Must be called before the units and apps are added. Turns on
+CMAKE_INTERPROCEDURAL_OPTIMIZATION for the targets of this project, so the
+typed FFI calls of the imgui unit can inline through the cimgui wrappers
+and js_externs_cwrap.c into Dear ImGui, sokol and stb. The C that shermes
+generates for the JS units is compiled with the matching flag
+(HERMES_LTO_FLAGS, passed with -Wc). Hermes itself is built separately and
+is linked as regular objects.
+
+Fails if the compiler and linker can't do LTO.
+]]
+function(hermes_setup_lto ENABLED)
+    set(HERMES_LTO_FLAGS "" PARENT_SCOPE)
+    if(NOT ENABLED)
+        return()
+    endif()
+
+    include(CheckIPOSupported)
+    check_ipo_supported(RESULT supported OUTPUT output LANGUAGES C CXX)
+    if(NOT supported)
+        message(FATAL_ERROR "hermes_setup_lto: LTO is not supported: ${output}")
+    endif()
+
+    # The same mode CMake uses for the other targets: the shermes objects
+    # end up in the same archives and link
+    if(CMAKE_C_COMPILER_ID MATCHES "Clang")
+        set(HERMES_LTO_FLAGS -flto=thin PARENT_SCOPE)
+    elseif(CMAKE_C_COMPILER_ID STREQUAL "GNU")
+        set(HERMES_LTO_FLAGS -flto=auto -fno-fat-lto-objects PARENT_SCOPE)
+    else()
+        message(FATAL_ERROR "hermes_setup_lto: LTO needs Clang or GCC, not ${CMAKE_C_COMPILER_ID}")
+    endif()
+    set(CMAKE_INTERPROCEDURAL_OPTIMIZATION ON PARENT_SCOPE)
+endfunction()
@@ -23,6 +23,15 @@ Usage:
     ENTRY_POINT <entry-js-file>
     SOURCES <cpp-source-files>...
     [ADDITIONAL_JS_DEPS <extra-js-dependencies>...]
+    [LAZY_UNITS <name>=<entry-js-file>...]
+    [WORKERS <name>=<entry-js-file>...]
+    [IMAGES <name>=<image-file>...]
+    [CONFIG <json-file>]
+    [HERMES_CONFIG <settings>]
+    [MEMORY_PROFILE <profile>]
+    [TEXTURES <image-files>...]
+    [TEXTURE_FORMATS <formats>...]
+    [SPECIALIZE_INCLUDE <components>...]
   )
 
 Arguments:
@@ -30,6 +39,50 @@ Arguments:
   ENTRY_POINT        - JavaScript entry point file (e.g., index.js)
   SOURCES            - C++ source files to compile (e.g., jsdemo.cpp)
   ADDITIONAL_JS_DEPS - Optional additional JS dependencies beyond auto-detected files
+  LAZY_UNITS         - Optional parts of the app that are bundled and compiled
+                       separately and only evaluated when JS first asks for
+                       them with lazyUnit('<name>') (see
+                       lib/react-imgui-reconciler/lazy-unit.js). Names may
+                       contain letters, digits and underscores.
+  WORKERS            - Optional worker units, bundled and compiled like
+                       LAZY_UNITS but with their own dependencies, which
+                       new Worker('<name>') runs on a runtime and thread of
+                       its own. In mode 0, a worker unit runs in one Worker
+                       at a time.
+  CONFIG             - Optional JSON file with sappConfig settings, built into
+                       the executable and applied before the React bundle is
+                       evaluated. With "async_init": true the window opens
+                       with a splash screen while the bundle loads.
+  HERMES_CONFIG      - Optional Hermes heap and GC settings, which have to be
+                       known before the runtime is created, e.g.
+                       "init_heap=64M,max_heap=1G,occupancy=0.6".
+                       IMGUI_HERMES_CONFIG overrides them at run time.
+  MEMORY_PROFILE     - Optional memory profile: "default", or "embedded" for
+                       devices with little RAM, which caps the Hermes heap,
+                       the texture budget, the temp arena and the font atlas
+                       (the default with REACT_IMGUI_EMBEDDED). Explicit
+                       settings override each limit, and
+                       IMGUI_MEMORY_PROFILE the profile, at run time.
+  IMAGES             - Optional <name>=<image-file> entries: images linked
+                       into the executable, which loadImageAsync('<name>')
+                       and <image src="<name>"> load without touching the
+                       file system. Names may contain letters, digits and
+                       underscores.
+  TEXTURES           - Optional images of the app directory to compress
+                       offline with Compressonator's compressonatorcli
+                       (COMPRESSONATOR_CLI). Each one gets a
+                       <stem>.<format>.ktx2 per format under textures/ in the
+                       build directory, and loading the image picks the best
+                       one the GPU backend samples, falling back to the
+                       image itself. Without the tool, the images are loaded
+                       as they are.
+  TEXTURE_FORMATS    - Formats of the TEXTURES variants, from bc7, etc2, bc3
+                       and bc1 (default: bc7 etc2, for desktop and mobile
+                       GPUs).
+  SPECIALIZE_INCLUDE - Optional host components (e.g. "datagrid") to keep in
+                       the specialized renderer although the bundles don't
+                       name them, because the element type is computed at
+                       run time.
 
 Example:
   add_react_imgui_app(
@@ -43,14 +96,34 @@ This will create an executable named 'jsdemo' that:
 2. Compiles the bundle based on REACT_BUNDLE_MODE
 3. Links with imgui-runtime and Hermes
 4. Defines REACT_BUNDLE_MODE and REACT_BUNDLE_PATH macros
+
+In mode 0 with REACT_VENDOR_UNIT, React and the reconciler are not in the
+bundle: the app links the shared react-vendor-unit (lib/react-vendor-unit),
+which the runtime evaluates first, and only the app's own modules are
+recompiled when they change.
+
+With REACT_EMBED_BYTECODE in mode 1, the bytecode is linked into the
+executable instead, page-aligned in a read-only section, and evaluated in
+place.
+
+With REACT_IMGUI_SIZE_REPORT, the link writes <target>.map, and the
+<target>_size_report target (tools/size-report.py) prints the size of the
+executable by library and by compiled unit, writes it to <target>.size.json
+and appends it to the history in REACT_IMGUI_SIZE_HISTORY_DIR.
+
+With REACT_IMGUI_SPECIALIZE_RENDERER, the app links its own imgui unit
+instead of the shared one: tools/specialize-renderer.py removes the
+renderNode() cases of the host components that the app and lazy unit bundles
+don't name as string literals (as the JSX transform does), with the render
+functions and FFI bindings that only they used.
 ]]
 function(add_react_imgui_app)
     # Parse arguments
     cmake_parse_arguments(
         ARG                                      # Prefix
         ""                                       # Options
-        "TARGET;ENTRY_POINT"                    # Single value args
-        "SOURCES;ADDITIONAL_JS_DEPS"            # Multi-value args
+        "TARGET;ENTRY_POINT;CONFIG;HERMES_CONFIG;MEMORY_PROFILE" # Single value args
+        "SOURCES;ADDITIONAL_JS_DEPS;LAZY_UNITS;WORKERS;IMAGES;TEXTURES;TEXTURE_FORMATS;SPECIALIZE_INCLUDE" # Multi-value args
         ${ARGN}
     )
 
@@ -91,6 +164,29 @@ function(add_react_imgui_app)
         list(APPEND REACT_UNIT_DEPS ${ARG_ADDITIONAL_JS_DEPS})
     endif()
 
+    # With the vendor unit, the app and lazy unit bundles don't contain the
+    # reconciler, and don't depend on it
+    set(USE_VENDOR_UNIT OFF)
+    set(APP_UNIT_DEPS ${REACT_UNIT_DEPS})
+    set(VENDOR_OPTION "")
+    if(REACT_BUNDLE_MODE EQUAL 0 AND REACT_VENDOR_UNIT)
+        set(USE_VENDOR_UNIT ON)
+        if(RECONCILER_FILES)
+            list(REMOVE_ITEM APP_UNIT_DEPS ${RECONCILER_FILES})
+        endif()
+        set(VENDOR_OPTION --use-vendor)
+    endif()
+
+    # Modes 1 and 2 load the bundles as they are: minify them
+    set(MINIFY_OPTION "")
+    if(NOT REACT_BUNDLE_MODE EQUAL 0 AND REACT_MINIFY_BUNDLE)
+        if(REACT_MINIFY_IDENTIFIERS)
+            set(MINIFY_OPTION --minify-identifiers)
+        else()
+            set(MINIFY_OPTION --minify)
+        endif()
+    endif()
+
     # Bundle with esbuild
     add_custom_command(OUTPUT ${REACT_UNIT_BUNDLE}
         COMMAND ${CMAKE_COMMAND} -E env
@@ -99,7 +195,9 @@ function(add_react_imgui_app)
             ${ARG_ENTRY_POINT}
             ${REACT_UNIT_BUNDLE}
             $<IF:$<CONFIG:Debug>,development,production>
-        DEPENDS ${REACT_UNIT_DEPS}
+            ${VENDOR_OPTION}
+            ${MINIFY_OPTION}
+        DEPENDS ${APP_UNIT_DEPS}
         WORKING_DIRECTORY ${CMAKE_CURRENT_SOURCE_DIR}
         COMMENT "Bundling ${ARG_TARGET} React unit with esbuild (NODE_ENV=$<IF:$<CONFIG:Debug>,development,production>, React Compiler=${USE_REACT_COMPILER})"
     )
@@ -139,24 +237,444 @@ function(add_react_imgui_app)
 
     message(STATUS "${ARG_TARGET}: React bundle path: ${REACT_UNIT_OUTPUT}")
 
+    # The generated <target>-units.cpp registers the bundle file (prefetched
+    # with IMGUI_BUNDLE_MAP=prefetch) and the lazy units with the runtime.
+    set(LAZY_UNIT_OUTPUTS "")
+    set(LAZY_UNIT_DECLARATIONS "")
+    set(LAZY_UNIT_REGISTRATIONS "")
+    set(EMBED_BYTECODE OFF)
+    if(REACT_BUNDLE_MODE EQUAL 1 AND REACT_EMBED_BYTECODE)
+        set(EMBED_BYTECODE ON)
+    endif()
+    # Files linked into the executable (the bytecode, IMAGES) are .incbin'd
+    # into read-only sections. The assembler reads them, so the compiler
+    # doesn't have to parse them as array initializers.
+    set(EMBED_DEPENDS "")
+    if(EMBED_BYTECODE OR ARG_IMAGES)
+        string(APPEND LAZY_UNIT_DECLARATIONS
+"#ifdef __APPLE__
+#define EMBED_SYMBOL(name) \"_\" #name
+#define EMBED_SECTION(name) \".section __TEXT,__const\"
+#define EMBED_PREVIOUS \".text\"
+#else
+#define EMBED_SYMBOL(name) #name
+#define EMBED_SECTION(name) \".pushsection .rodata.\" #name \",\\\"a\\\"\"
+#define EMBED_PREVIOUS \".popsection\"
+#endif
+")
+    endif()
+    if(EMBED_BYTECODE)
+        # The bytecode is page-aligned, so that it is mapped with the
+        # executable and Hermes can run it in place.
+        string(APPEND LAZY_UNIT_DECLARATIONS
+"extern \"C\" const unsigned char react_bundle_hbc[];
+extern \"C\" const unsigned char react_bundle_hbc_end[];
+__asm__(EMBED_SECTION(react_bundle) \"\\n\"
+        \".balign 4096\\n\"
+        \".globl \" EMBED_SYMBOL(react_bundle_hbc) \"\\n\"
+        EMBED_SYMBOL(react_bundle_hbc) \":\\n\"
+        \".incbin \\\"${REACT_UNIT_OUTPUT}\\\"\\n\"
+        \".globl \" EMBED_SYMBOL(react_bundle_hbc_end) \"\\n\"
+        EMBED_SYMBOL(react_bundle_hbc_end) \":\\n\"
+        \".byte 0\\n\"
+        EMBED_PREVIOUS);
+")
+        string(APPEND LAZY_UNIT_REGISTRATIONS
+"  imgui_register_embedded_bundle(
+      react_bundle_hbc, (size_t)(react_bundle_hbc_end - react_bundle_hbc));
+")
+        list(APPEND EMBED_DEPENDS ${REACT_UNIT_OUTPUT})
+    elseif(NOT REACT_BUNDLE_MODE EQUAL 0)
+        string(APPEND LAZY_UNIT_REGISTRATIONS
+            "  imgui_register_bundle_file(\"${REACT_UNIT_OUTPUT}\");\n")
+    endif()
+    if(USE_VENDOR_UNIT)
+        string(APPEND LAZY_UNIT_DECLARATIONS
+            "extern \"C\" SHUnit *sh_export_react_vendor(void);\n")
+        string(APPEND LAZY_UNIT_REGISTRATIONS
+            "  imgui_register_vendor_unit(sh_export_react_vendor);\n")
+    endif()
+
+    # Lazy units: each one is bundled and compiled like the main bundle
+    set(LAZY_BUNDLES "")
+    foreach(LAZY_UNIT ${ARG_LAZY_UNITS})
+        if(NOT LAZY_UNIT MATCHES "^([A-Za-z0-9_]+)=(.+)$")
+            message(FATAL_ERROR "add_react_imgui_app: LAZY_UNITS entries must be <name>=<entry-js-file>, got '${LAZY_UNIT}'")
+        endif()
+        set(LAZY_NAME ${CMAKE_MATCH_1})
+        set(LAZY_ENTRY ${CMAKE_MATCH_2})
+        set(LAZY_BUNDLE ${CMAKE_CURRENT_BINARY_DIR}/react-lazy-${LAZY_NAME}.js)
+        list(APPEND LAZY_BUNDLES ${LAZY_BUNDLE})
+
+        add_custom_command(OUTPUT ${LAZY_BUNDLE}
+            COMMAND ${CMAKE_COMMAND} -E env
+                USE_REACT_COMPILER=$<IF:$<BOOL:${USE_REACT_COMPILER}>,true,false>
+                node ${CMAKE_SOURCE_DIR}/scripts/bundle-react-unit.js
+                ${LAZY_ENTRY}
+                ${LAZY_BUNDLE}
+                $<IF:$<CONFIG:Debug>,development,production>
+                --lazy-unit=${LAZY_NAME}
+                ${MINIFY_OPTION}
+            DEPENDS ${APP_UNIT_DEPS}
+            WORKING_DIRECTORY ${CMAKE_CURRENT_SOURCE_DIR}
+            COMMENT "Bundling ${ARG_TARGET} lazy unit '${LAZY_NAME}' with esbuild"
+        )
+
+        if(REACT_BUNDLE_MODE EQUAL 0)
+            set(LAZY_OUTPUT ${CMAKE_CURRENT_BINARY_DIR}/react-lazy-${LAZY_NAME}${CMAKE_C_OUTPUT_EXTENSION})
+            hermes_compile_native(
+                OUTPUT ${LAZY_OUTPUT}
+                SOURCES ${LAZY_BUNDLE}
+                UNIT_NAME lazy_${LAZY_NAME}
+                DEPENDS ${LAZY_BUNDLE}
+                WORKING_DIRECTORY ${CMAKE_CURRENT_BINARY_DIR}
+                COMMENT "Compiling ${ARG_TARGET} lazy unit '${LAZY_NAME}' to native code"
+            )
+            string(APPEND LAZY_UNIT_DECLARATIONS
+                "extern \"C\" SHUnit *sh_export_lazy_${LAZY_NAME}(void);\n")
+            string(APPEND LAZY_UNIT_REGISTRATIONS
+                "  imgui_register_lazy_unit(\"${LAZY_NAME}\", sh_export_lazy_${LAZY_NAME}, false, nullptr);\n")
+        elseif(REACT_BUNDLE_MODE EQUAL 1)
+            set(LAZY_OUTPUT ${CMAKE_CURRENT_BINARY_DIR}/react-lazy-${LAZY_NAME}.hbc)
+            hermes_compile_bytecode(
+                OUTPUT ${LAZY_OUTPUT}
+                SOURCE ${LAZY_BUNDLE}
+                SOURCE_MAP ${LAZY_BUNDLE}.map
+                DEPENDS ${LAZY_BUNDLE}
+            )
+            string(APPEND LAZY_UNIT_REGISTRATIONS
+                "  imgui_register_lazy_unit(\"${LAZY_NAME}\", nullptr, true, \"${LAZY_OUTPUT}\");\n")
+        else()
+            set(LAZY_OUTPUT ${LAZY_BUNDLE})
+            string(APPEND LAZY_UNIT_REGISTRATIONS
+                "  imgui_register_lazy_unit(\"${LAZY_NAME}\", nullptr, false, \"${LAZY_OUTPUT}\");\n")
+        endif()
+        list(APPEND LAZY_UNIT_OUTPUTS ${LAZY_OUTPUT})
+    endforeach()
+
+    # Worker units: plain bundles of their entries, compiled the same way
+    foreach(WORKER ${ARG_WORKERS})
+        if(NOT WORKER MATCHES "^([A-Za-z0-9_]+)=(.+)$")
+            message(FATAL_ERROR "add_react_imgui_app: WORKERS entries must be <name>=<entry-js-file>, got '${WORKER}'")
+        endif()
+        set(WORKER_NAME ${CMAKE_MATCH_1})
+        set(WORKER_ENTRY ${CMAKE_MATCH_2})
+        set(WORKER_BUNDLE ${CMAKE_CURRENT_BINARY_DIR}/worker-${WORKER_NAME}.js)
+
+        add_custom_command(OUTPUT ${WORKER_BUNDLE}
+            COMMAND ${CMAKE_COMMAND} -E env
+                USE_REACT_COMPILER=false
+                node ${CMAKE_SOURCE_DIR}/scripts/bundle-react-unit.js
+                ${WORKER_ENTRY}
+                ${WORKER_BUNDLE}
+                $<IF:$<CONFIG:Debug>,development,production>
+                ${MINIFY_OPTION}
+            DEPENDS ${REACT_UNIT_DEPS}
+            WORKING_DIRECTORY ${CMAKE_CURRENT_SOURCE_DIR}
+            COMMENT "Bundling ${ARG_TARGET} worker '${WORKER_NAME}' with esbuild"
+        )
+
+        if(REACT_BUNDLE_MODE EQUAL 0)
+            set(WORKER_OUTPUT ${CMAKE_CURRENT_BINARY_DIR}/worker-${WORKER_NAME}${CMAKE_C_OUTPUT_EXTENSION})
+            hermes_compile_native(
+                OUTPUT ${WORKER_OUTPUT}
+                SOURCES ${WORKER_BUNDLE}
+                UNIT_NAME worker_${WORKER_NAME}
+                DEPENDS ${WORKER_BUNDLE}
+                WORKING_DIRECTORY ${CMAKE_CURRENT_BINARY_DIR}
+                COMMENT "Compiling ${ARG_TARGET} worker '${WORKER_NAME}' to native code"
+            )
+            string(APPEND LAZY_UNIT_DECLARATIONS
+                "extern \"C\" SHUnit *sh_export_worker_${WORKER_NAME}(void);\n")
+            string(APPEND LAZY_UNIT_REGISTRATIONS
+                "  imgui_register_worker_unit(\"${WORKER_NAME}\", sh_export_worker_${WORKER_NAME}, false, nullptr);\n")
+        elseif(REACT_BUNDLE_MODE EQUAL 1)
+            set(WORKER_OUTPUT ${CMAKE_CURRENT_BINARY_DIR}/worker-${WORKER_NAME}.hbc)
+            hermes_compile_bytecode(
+                OUTPUT ${WORKER_OUTPUT}
+                SOURCE ${WORKER_BUNDLE}
+                SOURCE_MAP ${WORKER_BUNDLE}.map
+                DEPENDS ${WORKER_BUNDLE}
+            )
+            string(APPEND LAZY_UNIT_REGISTRATIONS
+                "  imgui_register_worker_unit(\"${WORKER_NAME}\", nullptr, true, \"${WORKER_OUTPUT}\");\n")
+        else()
+            set(WORKER_OUTPUT ${WORKER_BUNDLE})
+            string(APPEND LAZY_UNIT_REGISTRATIONS
+                "  imgui_register_worker_unit(\"${WORKER_NAME}\", nullptr, false, \"${WORKER_OUTPUT}\");\n")
+        endif()
+        list(APPEND LAZY_UNIT_OUTPUTS ${WORKER_OUTPUT})
+    endforeach()
+
+    # Embedded images, loaded by name
+    foreach(IMAGE ${ARG_IMAGES})
+        if(NOT IMAGE MATCHES "^([A-Za-z0-9_]+)=(.+)$")
+            message(FATAL_ERROR "add_react_imgui_app: IMAGES entries must be <name>=<image-file>, got '${IMAGE}'")
+        endif()
+        set(IMAGE_NAME ${CMAKE_MATCH_1})
+        get_filename_component(IMAGE_FILE ${CMAKE_MATCH_2} ABSOLUTE)
+        string(APPEND LAZY_UNIT_DECLARATIONS
+"extern \"C\" const unsigned char embedded_image_${IMAGE_NAME}[];
+extern \"C\" const unsigned char embedded_image_${IMAGE_NAME}_end[];
+__asm__(EMBED_SECTION(embedded_images) \"\\n\"
+        \".balign 16\\n\"
+        \".globl \" EMBED_SYMBOL(embedded_image_${IMAGE_NAME}) \"\\n\"
+        EMBED_SYMBOL(embedded_image_${IMAGE_NAME}) \":\\n\"
+        \".incbin \\\"${IMAGE_FILE}\\\"\\n\"
+        \".globl \" EMBED_SYMBOL(embedded_image_${IMAGE_NAME}_end) \"\\n\"
+        EMBED_SYMBOL(embedded_image_${IMAGE_NAME}_end) \":\\n\"
+        EMBED_PREVIOUS);
+")
+        string(APPEND LAZY_UNIT_REGISTRATIONS
+"  imgui_register_image(\"${IMAGE_NAME}\", embedded_image_${IMAGE_NAME},
+      (size_t)(embedded_image_${IMAGE_NAME}_end - embedded_image_${IMAGE_NAME}));
+")
+        list(APPEND EMBED_DEPENDS ${IMAGE_FILE})
+    endforeach()
+
+    if(ARG_CONFIG)
+        get_filename_component(CONFIG_FILE ${ARG_CONFIG} ABSOLUTE)
+        file(READ ${CONFIG_FILE} APP_CONFIG_JSON)
+        set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS
+            ${CONFIG_FILE})
+        string(APPEND LAZY_UNIT_REGISTRATIONS
+            "  imgui_register_app_config(R\"json(${APP_CONFIG_JSON})json\");\n")
+    endif()
+    if(ARG_HERMES_CONFIG)
+        string(APPEND LAZY_UNIT_REGISTRATIONS
+            "  imgui_register_hermes_config(\"${ARG_HERMES_CONFIG}\");\n")
+    endif()
+    if(ARG_MEMORY_PROFILE)
+        string(APPEND LAZY_UNIT_REGISTRATIONS
+            "  imgui_register_memory_profile(\"${ARG_MEMORY_PROFILE}\");\n")
+    endif()
+
+    # Compressed variants of the app's images
+    set(TEXTURE_OUTPUTS "")
+    if(ARG_TEXTURES)
+        find_program(COMPRESSONATOR_CLI NAMES compressonatorcli CompressonatorCLI)
+        if(NOT ARG_TEXTURE_FORMATS)
+            set(ARG_TEXTURE_FORMATS bc7 etc2)
+        endif()
+        set(TEXTURE_DIR ${CMAKE_CURRENT_BINARY_DIR}/textures)
+        if(NOT COMPRESSONATOR_CLI)
+            message(WARNING "${ARG_TARGET}: compressonatorcli not found (set COMPRESSONATOR_CLI); TEXTURES are loaded uncompressed")
+        endif()
+        foreach(TEXTURE ${ARG_TEXTURES})
+            get_filename_component(TEXTURE_SOURCE ${TEXTURE} ABSOLUTE)
+            file(RELATIVE_PATH TEXTURE_REL ${CMAKE_CURRENT_SOURCE_DIR} ${TEXTURE_SOURCE})
+            get_filename_component(TEXTURE_REL_DIR ${TEXTURE_REL} DIRECTORY)
+            get_filename_component(TEXTURE_STEM ${TEXTURE_REL} NAME_WLE)
+            foreach(FORMAT ${ARG_TEXTURE_FORMATS})
+                if(FORMAT STREQUAL "bc7")
+                    set(CLI_FORMAT BC7)
+                elseif(FORMAT STREQUAL "etc2")
+                    set(CLI_FORMAT ETC2_RGBA)
+                elseif(FORMAT STREQUAL "bc3")
+                    set(CLI_FORMAT BC3)
+                elseif(FORMAT STREQUAL "bc1")
+                    set(CLI_FORMAT BC1)
+                else()
+                    message(FATAL_ERROR "add_react_imgui_app: unknown TEXTURE_FORMATS entry '${FORMAT}' (expected bc7, etc2, bc3 or bc1)")
+                endif()
+                if(NOT COMPRESSONATOR_CLI)
+                    continue()
+                endif()
+                set(TEXTURE_OUTPUT ${TEXTURE_DIR}/${TEXTURE_REL_DIR}/${TEXTURE_STEM}.${FORMAT}.ktx2)
+                # Only the top level is used (see CompressedTexture.h)
+                add_custom_command(OUTPUT ${TEXTURE_OUTPUT}
+                    COMMAND ${CMAKE_COMMAND} -E make_directory ${TEXTURE_DIR}/${TEXTURE_REL_DIR}
+                    COMMAND ${COMPRESSONATOR_CLI} -fd ${CLI_FORMAT} -nomipmap
+                        ${TEXTURE_SOURCE} ${TEXTURE_OUTPUT}
+                    DEPENDS ${TEXTURE_SOURCE}
+                    COMMENT "Compressing ${TEXTURE_REL} to ${FORMAT}"
+                )
+                list(APPEND TEXTURE_OUTPUTS ${TEXTURE_OUTPUT})
+            endforeach()
+        endforeach()
+        string(APPEND LAZY_UNIT_REGISTRATIONS
+            "  imgui_register_texture_variants(\"${CMAKE_CURRENT_SOURCE_DIR}\", \"${TEXTURE_DIR}\");\n")
+    endif()
+
+    # The imgui unit: the shared one, or one with only the components that
+    # the bundles use. Workers don't render, so their bundles aren't scanned;
+    # with the vendor unit, the reconciler's components are in neither bundle.
+    set(IMGUI_UNIT_OUTPUTS "")
+    if(REACT_IMGUI_SPECIALIZE_RENDERER)
+        set(IMGUI_UNIT_DIR ${CMAKE_SOURCE_DIR}/lib/imgui-unit)
+        get_directory_property(IMGUI_UNIT_SCANNED_SOURCES
+            DIRECTORY ${IMGUI_UNIT_DIR} DEFINITION IMGUI_UNIT_SCANNED_SOURCES)
+        set(SPECIALIZED_DIR ${CMAKE_CURRENT_BINARY_DIR}/imgui-specialized)
+        set(IMGUI_UNIT_SCANNED_PATHS "")
+        set(SPECIALIZED_SOURCES "")
+        set(SPECIALIZED_INLINED "")
+        foreach(SOURCE ${IMGUI_UNIT_SCANNED_SOURCES})
+            list(APPEND IMGUI_UNIT_SCANNED_PATHS ${IMGUI_UNIT_DIR}/${SOURCE})
+            list(APPEND SPECIALIZED_SOURCES ${SPECIALIZED_DIR}/${SOURCE})
+            list(APPEND SPECIALIZED_INLINED ${SPECIALIZED_DIR}/inlined/${SOURCE})
+        endforeach()
+        set(SPECIALIZE_SCAN ${REACT_UNIT_BUNDLE} ${LAZY_BUNDLES})
+        if(USE_VENDOR_UNIT)
+            list(APPEND SPECIALIZE_SCAN ${RECONCILER_FILES})
+        endif()
+        set(SPECIALIZE_ARGS "")
+        foreach(SCANNED ${SPECIALIZE_SCAN})
+            list(APPEND SPECIALIZE_ARGS --scan ${SCANNED})
+        endforeach()
+        if(ARG_SPECIALIZE_INCLUDE)
+            string(REPLACE ";" "," SPECIALIZE_INCLUDE "${ARG_SPECIALIZE_INCLUDE}")
+            list(APPEND SPECIALIZE_ARGS --include ${SPECIALIZE_INCLUDE})
+        endif()
+        add_custom_command(OUTPUT ${SPECIALIZED_SOURCES}
+            COMMAND ${Python3_EXECUTABLE} ${CMAKE_SOURCE_DIR}/tools/specialize-renderer.py
+                --node-tags ${CMAKE_SOURCE_DIR}/lib/react-imgui-reconciler/node-tags.js
+                --out-dir ${SPECIALIZED_DIR}
+                ${SPECIALIZE_ARGS}
+                ${IMGUI_UNIT_SCANNED_SOURCES}
+            DEPENDS
+                ${CMAKE_SOURCE_DIR}/tools/specialize-renderer.py
+                ${CMAKE_SOURCE_DIR}/lib/react-imgui-reconciler/node-tags.js
+                ${SPECIALIZE_SCAN}
+                ${IMGUI_UNIT_SCANNED_PATHS}
+            WORKING_DIRECTORY ${IMGUI_UNIT_DIR}
+            COMMENT "Specializing the ${ARG_TARGET} renderer"
+        )
+
+        # Bindings pruned for what is left, as in lib/imgui-unit
+        set(SPECIALIZED_EXTERNS_JS ${SPECIALIZED_DIR}/js_externs.pruned.js)
+        set(SPECIALIZED_EXTERNS_C ${SPECIALIZED_DIR}/js_externs_cwrap.pruned.c)
+        set(PRUNE_ARGS "")
+        if(IMGUI_UNIT_BINDINGS_ALLOWLIST)
+            set(PRUNE_ARGS --allowlist ${IMGUI_UNIT_BINDINGS_ALLOWLIST})
+        endif()
+        if(NOT IMGUI_UNIT_CHECKS)
+            list(APPEND PRUNE_ARGS --define _IMGUI_UNIT_CHECKS=0)
+        endif()
+        add_custom_command(
+            OUTPUT ${SPECIALIZED_EXTERNS_JS} ${SPECIALIZED_EXTERNS_C}
+                ${SPECIALIZED_INLINED}
+            COMMAND ${Python3_EXECUTABLE} ${CMAKE_SOURCE_DIR}/tools/prune-externs.py
+                --externs ${IMGUI_UNIT_DIR}/js_externs.js
+                --cwrap ${IMGUI_UNIT_DIR}/js_externs_cwrap.c
+                --out-externs ${SPECIALIZED_EXTERNS_JS}
+                --out-cwrap ${SPECIALIZED_EXTERNS_C}
+                --out-sources ${SPECIALIZED_DIR}/inlined
+                ${PRUNE_ARGS}
+                ${IMGUI_UNIT_SCANNED_SOURCES}
+            DEPENDS
+                ${CMAKE_SOURCE_DIR}/tools/prune-externs.py
+                ${IMGUI_UNIT_DIR}/js_externs.js
+                ${IMGUI_UNIT_DIR}/js_externs_cwrap.c
+                ${SPECIALIZED_SOURCES}
+                ${IMGUI_UNIT_BINDINGS_ALLOWLIST}
+            WORKING_DIRECTORY ${SPECIALIZED_DIR}
+            COMMENT "Pruning ImGui FFI bindings of the ${ARG_TARGET} renderer"
+        )
+        # The bindings are compiled between sapp.js and renderer.js
+        list(INSERT SPECIALIZED_INLINED 3 ${SPECIALIZED_EXTERNS_JS})
+
+        set(SPECIALIZED_O ${CMAKE_CURRENT_BINARY_DIR}/imgui-specialized-unit${CMAKE_C_OUTPUT_EXTENSION})
+        hermes_compile_native(
+            OUTPUT ${SPECIALIZED_O}
+            SOURCES ${SPECIALIZED_INLINED}
+            UNIT_NAME imgui_specialized
+            FLAGS -typed -Wc,-I${IMGUI_UNIT_DIR}
+            DEPENDS ${SPECIALIZED_INLINED}
+            WORKING_DIRECTORY ${SPECIALIZED_DIR}
+            COMMENT "Compiling the ${ARG_TARGET} renderer to native code"
+        )
+        # Linked instead of the shared unit and its bindings, which nothing
+        # references then
+        set(IMGUI_UNIT_OUTPUTS ${SPECIALIZED_O} ${SPECIALIZED_EXTERNS_C})
+        string(APPEND LAZY_UNIT_DECLARATIONS
+            "extern \"C\" SHUnit *sh_export_imgui_specialized(void);\n")
+        string(APPEND LAZY_UNIT_REGISTRATIONS
+            "  imgui_register_imgui_unit(sh_export_imgui_specialized);\n")
+    else()
+        string(APPEND LAZY_UNIT_DECLARATIONS
+            "extern \"C\" SHUnit *sh_export_imgui(void);\n")
+        string(APPEND LAZY_UNIT_REGISTRATIONS
+            "  imgui_register_imgui_unit(sh_export_imgui);\n")
+    endif()
+
+    set(UNITS_CPP ${CMAKE_CURRENT_BINARY_DIR}/${ARG_TARGET}-units.cpp)
+    file(CONFIGURE OUTPUT ${UNITS_CPP} CONTENT
+"// Generated by add_react_imgui_app() for ${ARG_TARGET}; do not edit.
+#include \"imgui-runtime.h\"
+
+@LAZY_UNIT_DECLARATIONS@
+static const bool s_units_registered = [] {
+@LAZY_UNIT_REGISTRATIONS@  return true;
+}();
+" @ONLY)
+    set(LAZY_UNIT_SOURCES ${UNITS_CPP} ${IMGUI_UNIT_OUTPUTS})
+    if(EMBED_DEPENDS)
+        # Reassemble when an embedded file changes
+        set_source_files_properties(${UNITS_CPP} PROPERTIES
+            OBJECT_DEPENDS "${EMBED_DEPENDS}")
+    endif()
+    # Native lazy units are linked like the main unit
+    if(REACT_BUNDLE_MODE EQUAL 0)
+        list(APPEND LAZY_UNIT_SOURCES ${LAZY_UNIT_OUTPUTS})
+    endif()
+
     # Create the executable
     if(REACT_BUNDLE_MODE EQUAL 0)
         # In mode 0, the .o file gets linked directly
-        add_executable(${ARG_TARGET} ${ARG_SOURCES} ${REACT_UNIT_OUTPUT})
+        add_executable(${ARG_TARGET} ${ARG_SOURCES} ${REACT_UNIT_OUTPUT}
+            ${LAZY_UNIT_SOURCES})
     else()
         # In modes 1 and 2, the bundle is loaded at runtime
-        add_executable(${ARG_TARGET} ${ARG_SOURCES})
+        add_executable(${ARG_TARGET} ${ARG_SOURCES} ${LAZY_UNIT_SOURCES})
         # Make sure React bundle/bytecode is built before linking
-        add_custom_target(${ARG_TARGET}_react_unit DEPENDS ${REACT_UNIT_OUTPUT})
+        add_custom_target(${ARG_TARGET}_react_unit
+            DEPENDS ${REACT_UNIT_OUTPUT} ${LAZY_UNIT_OUTPUTS})
         add_dependencies(${ARG_TARGET} ${ARG_TARGET}_react_unit)
     endif()
 
+    if(TEXTURE_OUTPUTS)
+        add_custom_target(${ARG_TARGET}_textures DEPENDS ${TEXTURE_OUTPUTS})
+        add_dependencies(${ARG_TARGET} ${ARG_TARGET}_textures)
+    endif()
+
     # Set compile definitions
     target_compile_definitions(${ARG_TARGET} PRIVATE
         REACT_BUNDLE_MODE=${REACT_BUNDLE_MODE}
         REACT_BUNDLE_PATH="${REACT_UNIT_OUTPUT}"
+        REACT_BUNDLE_SOURCE_MAP="${REACT_UNIT_BUNDLE}.map"
     )
 
     # Link libraries
+    if(USE_VENDOR_UNIT)
+        target_link_libraries(${ARG_TARGET} react-vendor-unit)
+    endif()
     target_link_libraries(${ARG_TARGET} imgui-runtime)
+
+    # Linker map and size report
+    if(REACT_IMGUI_SIZE_REPORT)
+        set(APP_MAP ${CMAKE_CURRENT_BINARY_DIR}/${ARG_TARGET}.map)
+        if(APPLE)
+            target_link_options(${ARG_TARGET} PRIVATE LINKER:-map,${APP_MAP})
+        else()
+            target_link_options(${ARG_TARGET} PRIVATE LINKER:-Map=${APP_MAP})
+        endif()
+        set(SIZE_BASELINE_OPTION)
+        if(REACT_IMGUI_SIZE_BASELINE)
+            set(SIZE_BASELINE_OPTION
+                --baseline ${REACT_IMGUI_SIZE_BASELINE}/${ARG_TARGET}.size.json)
+        endif()
+        add_custom_target(${ARG_TARGET}_size_report
+            COMMAND ${Python3_EXECUTABLE} ${CMAKE_SOURCE_DIR}/tools/size-report.py
+                --map ${APP_MAP}
+                --executable $<TARGET_FILE:${ARG_TARGET}>
+                --app ${ARG_TARGET}
+                --output ${CMAKE_CURRENT_BINARY_DIR}/${ARG_TARGET}.size.json
+                --history ${REACT_IMGUI_SIZE_HISTORY_DIR}/${ARG_TARGET}.jsonl
+                ${SIZE_BASELINE_OPTION}
+            DEPENDS ${ARG_TARGET}
+            COMMENT "Size report of ${ARG_TARGET}"
+            VERBATIM
+        )
+        add_dependencies(size-report ${ARG_TARGET}_size_report)
+    endif()
 endfunction()
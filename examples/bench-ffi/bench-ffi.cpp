@@ -0,0 +1,110 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// FFI/JSI call-cost micro-benchmarks.
+//
+// The typed FFI measurements run in the imgui unit (lib/imgui-unit/bench.js).
+// This file adds the C++ -> JS side: jsi::Function::call() as used for
+// peekMacroTask/runMacroTask, and reading perfMetrics properties through
+// JSI, which is what the native RuntimeMetrics block saves every frame.
+
+#include "imgui-runtime.h"
+
+#include "sokol_app.h"
+#include "sokol_time.h"
+
+#include <cstdio>
+
+namespace jsi = facebook::jsi;
+
+/// Nanoseconds per iteration since `start`.
+static double ns_since(uint64_t start, double iterations) {
+  return stm_ns(stm_since(start)) / iterations;
+}
+
+/// __benchJsi(fn, iterations): measures C++ -> JS calls of `fn` and JSI
+/// reads of perfMetrics properties. Returns ns per call.
+static jsi::Value bench_jsi(jsi::Runtime &rt, const jsi::Value &,
+                            const jsi::Value *args, size_t count) {
+  if (count < 2 || !args[0].isObject() || !args[1].isNumber())
+    throw jsi::JSError(rt, "__benchJsi expects (function, iterations)");
+  jsi::Function fn = args[0].getObject(rt).asFunction(rt);
+  double iterations = args[1].getNumber();
+  int n = (int)iterations;
+  jsi::Object result(rt);
+
+  // Like peekMacroTask: no arguments, numeric result
+  uint64_t start = stm_now();
+  double sink = 0;
+  for (int i = 0; i < n; ++i)
+    sink += fn.call(rt).getNumber();
+  result.setProperty(rt, "jsiCall", ns_since(start, iterations));
+
+  // Like runMacroTask(curTimeMs): one numeric argument
+  start = stm_now();
+  for (int i = 0; i < n; ++i)
+    sink += fn.call(rt, (double)i).getNumber();
+  result.setProperty(rt, "jsiCallWithArg", ns_since(start, iterations));
+
+  // The global lookup and hasProperty/getProperty pairs that
+  // update_performance_metrics() used before RuntimeMetrics, per frame
+  start = stm_now();
+  for (int i = 0; i < n; ++i) {
+    auto global = rt.global();
+    if (global.hasProperty(rt, "perfMetrics")) {
+      auto metrics = global.getPropertyAsObject(rt, "perfMetrics");
+      if (metrics.hasProperty(rt, "reconciliationAvg"))
+        sink += metrics.getProperty(rt, "reconciliationAvg").asNumber();
+      if (metrics.hasProperty(rt, "reconciliationMax"))
+        sink += metrics.getProperty(rt, "reconciliationMax").asNumber();
+      if (metrics.hasProperty(rt, "renderTime"))
+        sink += metrics.getProperty(rt, "renderTime").asNumber();
+    }
+  }
+  result.setProperty(rt, "perfMetricsRead", ns_since(start, iterations));
+
+  // Keep the loops from being optimized away
+  result.setProperty(rt, "checksum", sink);
+  return result;
+}
+
+/// __benchFinish(json): prints the report and quits the app.
+static jsi::Value bench_finish(jsi::Runtime &rt, const jsi::Value &,
+                               const jsi::Value *args, size_t count) {
+  if (count < 1 || !args[0].isString())
+    throw jsi::JSError(rt, "__benchFinish expects a string");
+  printf("%s\n", args[0].getString(rt).utf8(rt).c_str());
+  fflush(stdout);
+  sapp_request_quit();
+  return jsi::Value::undefined();
+}
+
+static void install_bench_functions(facebook::hermes::HermesRuntime *hermes) {
+  jsi::Runtime &rt = *hermes;
+  rt.global().setProperty(
+      rt, "__benchJsi",
+      jsi::Function::createFromHostFunction(
+          rt, jsi::PropNameID::forAscii(rt, "__benchJsi"), 2, bench_jsi));
+  rt.global().setProperty(
+      rt, "__benchFinish",
+      jsi::Function::createFromHostFunction(
+          rt, jsi::PropNameID::forAscii(rt, "__benchFinish"), 1,
+          bench_finish));
+}
+
+#if REACT_BUNDLE_MODE == 0
+extern "C" SHUnit *sh_export_react(void);
+#endif
+
+void imgui_main(int argc, char *argv[],
+                facebook::hermes::HermesRuntime *hermes) {
+#if REACT_BUNDLE_MODE != 0
+  static constexpr SHUnit *(*sh_export_react)(void) = nullptr;
+#endif
+  // The host functions must exist before the React unit runs
+  install_bench_functions(hermes);
+  imgui_main_default<REACT_BUNDLE_MODE>(hermes, sh_export_react,
+                                        REACT_BUNDLE_PATH,
+                                        REACT_BUNDLE_SOURCE_MAP);
+}
@@ -0,0 +1,45 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// FFI/JSI call-cost micro-benchmarks. After a few frames have been rendered,
+// runs the typed FFI benchmarks of the imgui unit and the C++ -> JS
+// benchmarks of bench-ffi.cpp, then prints one JSON object to stdout and
+// exits.
+
+import React from 'react';
+import { createRoot, render } from 'react-imgui-reconciler/reconciler.js';
+
+const ITERATIONS = 100000;
+const WARMUP_MS = 500;
+
+globalThis.sappConfig.title = 'bench-ffi';
+globalThis.sappConfig.width = 320;
+globalThis.sappConfig.height = 120;
+
+function App() {
+  return (
+    <root>
+      <text>Running FFI benchmarks...</text>
+    </root>
+  );
+}
+
+const root = createRoot();
+
+globalThis.reactApp = {
+  render() {
+    render(React.createElement(App), root);
+  },
+};
+
+globalThis.reactApp.render();
+
+// Macrotasks run inside the frame, so ImGui calls are valid here
+setTimeout(() => {
+  const report = {
+    ffi: globalThis.imguiUnit.runFfiBench(ITERATIONS),
+    jsi: globalThis.__benchJsi((x) => 0, ITERATIONS),
+  };
+  globalThis.__benchFinish(JSON.stringify(report));
+}, WARMUP_MS);
@@ -0,0 +1,360 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// Parametric stress test. Renders `windows` windows with a `rows` x `cols`
+// table each and a window with `shapes` rects and circles, and `rate` times
+// a second changes a `churn` fraction of the cells and shapes. Cell texts
+// are `text` characters long. Unchanged rows, windows and shapes keep their
+// props, so each update re-renders about as many nodes as it changes.
+import React, { memo, useEffect, useLayoutEffect, useState } from 'react';
+
+// Initial parameters, overridden by globalThis.benchParams (the command line,
+// see bench.cpp)
+const DEFAULT_PARAMS = {
+  windows: 4,
+  rows: 20,
+  cols: 6,
+  rate: 30,
+  shapes: 200,
+  text: 8,
+  churn: 0.1,
+};
+
+// [min, max, step] of every parameter in the Controls window
+const PARAM_LIMITS = {
+  windows: [0, 64, 1],
+  rows: [0, 1000, 10],
+  cols: [1, 32, 1],
+  rate: [0, 240, 10],
+  shapes: [0, 10000, 100],
+  text: [1, 256, 4],
+  churn: [0, 1, 0.05],
+};
+
+const SHAPE_AREA_WIDTH = 400;
+const SHAPE_AREA_HEIGHT = 300;
+const REPORT_INTERVAL_MS = 5000;
+const STATS_REFRESH_MS = 500;
+
+// Time from an update's setState() to its commit, and between frames
+const updateStats = new RollingStats({
+  capacity: 1024,
+  windowMs: REPORT_INTERVAL_MS,
+});
+const frameStats = new RollingStats({
+  capacity: 1024,
+  windowMs: REPORT_INTERVAL_MS,
+});
+let updateStart = -1; // performance.now() of the uncommitted update
+let updateCount = 0;
+
+function clampParam(name, value) {
+  const [min, max] = PARAM_LIMITS[name];
+  return Math.min(max, Math.max(min, value));
+}
+
+function initialParams() {
+  const given = globalThis.benchParams || {};
+  const params = {};
+  for (const name of Object.keys(DEFAULT_PARAMS)) {
+    const value = given[name];
+    const valid = typeof value === 'number' && !isNaN(value);
+    params[name] = clampParam(name, valid ? value : DEFAULT_PARAMS[name]);
+  }
+  return params;
+}
+
+function randomShape() {
+  return {
+    x: Math.random() * SHAPE_AREA_WIDTH,
+    y: Math.random() * SHAPE_AREA_HEIGHT,
+    size: 4 + Math.random() * 12,
+    color: Math.random() < 0.5 ? '#4080FFC0' : '#FF8040C0',
+  };
+}
+
+function createModel(params) {
+  const windows = [];
+  for (let w = 0; w < params.windows; w++) {
+    const rows = [];
+    for (let r = 0; r < params.rows; r++) {
+      const row = [];
+      for (let c = 0; c < params.cols; c++) row.push(Math.random() * 100);
+      rows.push(row);
+    }
+    windows.push(rows);
+  }
+  const shapes = [];
+  for (let i = 0; i < params.shapes; i++) shapes.push(randomShape());
+  return { windows, shapes };
+}
+
+// Change about a `churn` fraction of the cells and shapes of `model`. Only
+// the rows, windows and the shape list that change are copied.
+function updateModel(model, churn) {
+  const numWindows = model.windows.length;
+  const numRows = numWindows ? model.windows[0].length : 0;
+  const numCols = numRows ? model.windows[0][0].length : 0;
+  const perWindow = numRows * numCols;
+  const cells = numWindows * perWindow;
+  const total = cells + model.shapes.length;
+  const changes = Math.round(total * churn);
+  const windows = model.windows.slice();
+  const copiedWindows = new Uint8Array(numWindows);
+  const copiedRows = new Uint8Array(numWindows * numRows);
+  let shapes = model.shapes;
+  for (let i = 0; i < changes; i++) {
+    const index = Math.floor(Math.random() * total);
+    if (index >= cells) {
+      if (shapes === model.shapes) shapes = shapes.slice();
+      shapes[index - cells] = randomShape();
+      continue;
+    }
+    const w = Math.floor(index / perWindow);
+    const r = Math.floor((index % perWindow) / numCols);
+    const c = index % numCols;
+    if (!copiedWindows[w]) {
+      copiedWindows[w] = 1;
+      windows[w] = windows[w].slice();
+    }
+    const rows = windows[w];
+    if (!copiedRows[w * numRows + r]) {
+      copiedRows[w * numRows + r] = 1;
+      rows[r] = rows[r].slice();
+    }
+    const value = rows[r][c] + (Math.random() - 0.5) * 10;
+    rows[r][c] = Math.min(100, Math.max(0, value));
+  }
+  return { windows, shapes };
+}
+
+// `value` as exactly `length` characters
+function formatCell(value, length) {
+  const text = value.toFixed(2);
+  return text.length >= length
+    ? text.slice(0, length)
+    : text.padEnd(length, '.');
+}
+
+function cellColor(value) {
+  if (value < 33.0) return '#FF6060';
+  if (value < 66.0) return '#60FF60';
+  return '#FFFFFF';
+}
+
+const Row = memo(function Row({ index, values, textLength }) {
+  return (
+    <tablerow>
+      <tablecell index={0}>
+        <text>Row {index}</text>
+      </tablecell>
+      {values.map((value, c) => (
+        <tablecell key={c} index={c + 1}>
+          <text color={cellColor(value)}>{formatCell(value, textLength)}</text>
+        </tablecell>
+      ))}
+    </tablerow>
+  );
+});
+
+const TableWindow = memo(function TableWindow({ index, rows, textLength }) {
+  const cols = rows.length ? rows[0].length : 0;
+  const columns = [];
+  for (let c = 0; c < cols; c++) {
+    columns.push(<tablecolumn key={c} label={`Col ${c + 1}`} flags={8} />);
+  }
+  return (
+    <window
+      title={`Table ${index + 1}`}
+      defaultX={340 + (index % 8) * 30}
+      defaultY={20 + (index % 8) * 30}
+      defaultWidth={500}
+      defaultHeight={300}
+    >
+      <table id={`benchTable${index}`} columns={cols + 1}>
+        <tablecolumn label="Row" flags={16} />
+        {columns}
+        <tableheader />
+        {rows.map((values, r) => (
+          <Row key={r} index={r} values={values} textLength={textLength} />
+        ))}
+      </table>
+    </window>
+  );
+});
+
+const Shape = memo(function Shape({ index, shape }) {
+  return index % 2 === 0 ? (
+    <rect
+      x={shape.x}
+      y={shape.y}
+      width={shape.size}
+      height={shape.size}
+      color={shape.color}
+      filled={true}
+    />
+  ) : (
+    <circle
+      x={shape.x}
+      y={shape.y}
+      radius={shape.size / 2}
+      color={shape.color}
+      filled={true}
+    />
+  );
+});
+
+const ShapesWindow = memo(function ShapesWindow({ shapes }) {
+  return (
+    <window
+      title="Primitives"
+      defaultX={20}
+      defaultY={420}
+      defaultWidth={SHAPE_AREA_WIDTH + 20}
+      defaultHeight={SHAPE_AREA_HEIGHT + 40}
+    >
+      {shapes.map((shape, i) => (
+        <Shape key={i} index={i} shape={shape} />
+      ))}
+    </window>
+  );
+});
+
+function formatParam(name, value) {
+  return name === 'churn' ? value.toFixed(2) : String(value);
+}
+
+function Controls({ params, setParam }) {
+  return (
+    <window title="Controls" defaultX={20} defaultY={20} defaultWidth={300}>
+      {Object.keys(PARAM_LIMITS).map((name) => {
+        const step = PARAM_LIMITS[name][2];
+        return (
+          <group key={name}>
+            <button onClick={() => setParam(name, params[name] - step)}>
+              {`-##${name}`}
+            </button>
+            <sameline />
+            <button onClick={() => setParam(name, params[name] + step)}>
+              {`+##${name}`}
+            </button>
+            <sameline />
+            <text>{`${name}: ${formatParam(name, params[name])}`}</text>
+          </group>
+        );
+      })}
+    </window>
+  );
+}
+
+function ms(value) {
+  return value.toFixed(2) + 'ms';
+}
+
+function summary(stats) {
+  return (
+    `avg ${ms(stats.average())}, p50 ${ms(stats.percentile(0.5))}, ` +
+    `p95 ${ms(stats.percentile(0.95))}, max ${ms(stats.max())}`
+  );
+}
+
+// The workload's own timings, refreshed every STATS_REFRESH_MS and printed
+// every REPORT_INTERVAL_MS
+function Stats({ params, nodes }) {
+  const [, setRefresh] = useState(0);
+
+  useEffect(() => {
+    const id = setInterval(() => setRefresh((n) => n + 1), STATS_REFRESH_MS);
+    return () => clearInterval(id);
+  }, []);
+
+  useEffect(() => {
+    let last = -1;
+    let rafId;
+    function onFrame(t) {
+      if (last >= 0) frameStats.add(t - last, t);
+      last = t;
+      rafId = requestAnimationFrame(onFrame);
+    }
+    rafId = requestAnimationFrame(onFrame);
+    return () => cancelAnimationFrame(rafId);
+  }, []);
+
+  useEffect(() => {
+    let lastCount = updateCount;
+    const id = setInterval(() => {
+      const rate = ((updateCount - lastCount) * 1000) / REPORT_INTERVAL_MS;
+      lastCount = updateCount;
+      console.log(
+        `bench: ${JSON.stringify(params)} nodes=${nodes}` +
+          ` updates/s=${rate.toFixed(1)}` +
+          ` | update ${summary(updateStats)}` +
+          ` | frame ${summary(frameStats)}`,
+      );
+    }, REPORT_INTERVAL_MS);
+    return () => clearInterval(id);
+  }, [params, nodes]);
+
+  const metrics = globalThis.perfMetrics;
+  return (
+    <window title="Stress Test Stats" defaultX={20} defaultY={250}>
+      <text>Nodes: {nodes}</text>
+      <text>{`Update: ${summary(updateStats)}`}</text>
+      <text>{`Frame: ${summary(frameStats)}`}</text>
+      <text>
+        {`Reconciliation: p50 ${ms(metrics.reconciliationP50)}, ` +
+          `p95 ${ms(metrics.reconciliationP95)}`}
+      </text>
+      <text>{`ImGui render: ${ms(metrics.renderTime)}`}</text>
+    </window>
+  );
+}
+
+export function App() {
+  const [params, setParams] = useState(initialParams);
+  const [model, setModel] = useState(() => createModel(params));
+
+  function setParam(name, value) {
+    const next = { ...params, [name]: clampParam(name, value) };
+    setParams(next);
+    if (name !== 'rate' && name !== 'text' && name !== 'churn') {
+      setModel(createModel(next));
+    }
+  }
+
+  useEffect(() => {
+    if (params.rate <= 0) return undefined;
+    const id = setInterval(() => {
+      if (updateStart < 0) updateStart = performance.now();
+      setModel((prev) => updateModel(prev, params.churn));
+    }, 1000 / params.rate);
+    return () => clearInterval(id);
+  }, [params]);
+
+  useLayoutEffect(() => {
+    if (updateStart >= 0) {
+      const now = performance.now();
+      updateStats.add(now - updateStart, now);
+      updateStart = -1;
+      updateCount++;
+    }
+  });
+
+  // Host nodes of the workload, not counting text instances: per window a
+  // window, a table, the columns, a header and the rows with their cells and
+  // texts; then the shapes and their window
+  const perWindow = params.cols + 4 + params.rows * (3 + 2 * params.cols);
+  const nodes = params.windows * perWindow + params.shapes + 1;
+
+  return (
+    <root>
+      <Controls params={params} setParam={setParam} />
+      <Stats params={params} nodes={nodes} />
+      {model.windows.map((rows, w) => (
+        <TableWindow key={w} index={w} rows={rows} textLength={params.text} />
+      ))}
+      <ShapesWindow shapes={model.shapes} />
+    </root>
+  );
+}
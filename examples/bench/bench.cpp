@@ -0,0 +1,55 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// Parametric stress test. The workload parameters come from the command
+// line (--windows=N, --rows=N, --cols=N, --rate=HZ, --shapes=N, --text=N,
+// --churn=F) and are passed to the React unit as globalThis.benchParams;
+// they can be changed at runtime from the app's Controls window.
+
+#include "imgui-runtime.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace jsi = facebook::jsi;
+
+/// Command line options that become properties of globalThis.benchParams.
+static const char *const kParamNames[] = {
+    "windows", "rows", "cols", "rate", "shapes", "text", "churn",
+};
+
+static void install_bench_params(int argc, char *argv[],
+                                 facebook::hermes::HermesRuntime *hermes) {
+  jsi::Runtime &rt = *hermes;
+  jsi::Object params(rt);
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    if (strncmp(arg, "--", 2) != 0)
+      continue;
+    for (const char *name : kParamNames) {
+      size_t len = strlen(name);
+      if (strncmp(arg + 2, name, len) == 0 && arg[2 + len] == '=') {
+        params.setProperty(rt, name, strtod(arg + 3 + len, nullptr));
+        break;
+      }
+    }
+  }
+  rt.global().setProperty(rt, "benchParams", params);
+}
+
+#if REACT_BUNDLE_MODE == 0
+extern "C" SHUnit *sh_export_react(void);
+#endif
+
+void imgui_main(int argc, char *argv[],
+                facebook::hermes::HermesRuntime *hermes) {
+#if REACT_BUNDLE_MODE != 0
+  static constexpr SHUnit *(*sh_export_react)(void) = nullptr;
+#endif
+  // The parameters must exist before the React unit runs
+  install_bench_params(argc, argv, hermes);
+  imgui_main_default<REACT_BUNDLE_MODE>(hermes, sh_export_react,
+                                        REACT_BUNDLE_PATH,
+                                        REACT_BUNDLE_SOURCE_MAP);
+}
@@ -0,0 +1,21 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+import React from 'react';
+import { createRoot, render } from 'react-imgui-reconciler/reconciler.js';
+import { App } from './app.jsx';
+
+globalThis.sappConfig.title = 'Stress Test';
+globalThis.sappConfig.width = 1280;
+globalThis.sappConfig.height = 800;
+
+const root = createRoot();
+
+globalThis.reactApp = {
+  render() {
+    render(React.createElement(App), root);
+  },
+};
+
+globalThis.reactApp.render();
@@ -7,8 +7,6 @@ const root = createRoot();
 
 // Expose to typed unit via global
 globalThis.reactApp = {
-  rootChildren: [],
-
   // Render the app
   render() {
     render(React.createElement(App), root);
@@ -18,10 +18,7 @@ const root = createRoot();
 
 // Expose to typed unit via global
 globalThis.reactApp = {
-  rootChildren: [],
-
   // Render the app
-  // Note: resetAfterCommit in host-config.js will sync rootChildren after each render
   render() {
     render(React.createElement(App), root);
   },
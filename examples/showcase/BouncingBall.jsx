@@ -3,7 +3,9 @@
 // See LICENSE file for full license text
 
 // Bouncing ball component - demonstrates custom drawing with rect and circle
-import React, { useState, useEffect } from 'react';
+// and animated values: the ball moves without any React render
+import React, { useEffect } from 'react';
+import { useAnimatedValue } from 'react-imgui-reconciler/animated.js';
 
 export function BouncingBall() {
   // Content dimensions
@@ -12,69 +14,30 @@ export function BouncingBall() {
   const borderThickness = 4;
   const ballRadius = 20;
 
-  // Ball physics state
-  const [ballX, setBallX] = useState(200);
-  const [ballY, setBallY] = useState(150);
+  // Ball position, moved by the renderer
+  const ballX = useAnimatedValue(200);
+  const ballY = useAnimatedValue(150);
 
-  // Update ball position every animation frame
   useEffect(() => {
-    // Initialize velocity with random angle
-    const speed = 5.0;
+    // Random direction, 500 pixels per second
+    const speed = 500;
     const angle = Math.random() * 2 * Math.PI;
-    let vx = Math.cos(angle) * speed;
-    let vy = Math.sin(angle) * speed;
-
-    let time = performance.now();
-    let rafId;
-    function render(t) {
-      const dt = (t - time) / 10;
-      time = t;
-
-      setBallX((prevX) => {
-        let newX = prevX + vx * dt;
-
-        // Bounce off left/right walls
-        if (
-          newX - ballRadius <= borderThickness ||
-          newX + ballRadius >= contentWidth - borderThickness
-        ) {
-          vx = -vx;
-          // Clamp position to stay within bounds
-          newX =
-            newX - ballRadius <= borderThickness
-              ? borderThickness + ballRadius
-              : contentWidth - borderThickness - ballRadius;
-        }
-
-        return newX;
-      });
-
-      setBallY((prevY) => {
-        let newY = prevY + vy * dt;
-
-        // Bounce off top/bottom walls
-        if (
-          newY - ballRadius <= borderThickness ||
-          newY + ballRadius >= contentHeight - borderThickness
-        ) {
-          vy = -vy;
-          // Clamp position to stay within bounds
-          newY =
-            newY - ballRadius <= borderThickness
-              ? borderThickness + ballRadius
-              : contentHeight - borderThickness - ballRadius;
-        }
-
-        return newY;
-      });
-
-      // Request next frame
-      rafId = requestAnimationFrame(render);
-    }
-
-    rafId = requestAnimationFrame(render);
-    return () => cancelAnimationFrame(rafId);
-  }, []);
+    // Bounce off the walls
+    ballX.bounce({
+      velocity: Math.cos(angle) * speed,
+      min: borderThickness + ballRadius,
+      max: contentWidth - borderThickness - ballRadius,
+    });
+    ballY.bounce({
+      velocity: Math.sin(angle) * speed,
+      min: borderThickness + ballRadius,
+      max: contentHeight - borderThickness - ballRadius,
+    });
+    return () => {
+      ballX.stop();
+      ballY.stop();
+    };
+  }, [ballX, ballY]);
 
   return (
     <window title="Bouncing Ball" defaultX={600} defaultY={350} flags={64}>
@@ -0,0 +1,49 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// Runtime stats tool window. Built as the lazy unit 'stats' (see
+// CMakeLists.txt), so it is only evaluated when the window is first opened.
+import React, { useState, useEffect } from 'react';
+
+const REFRESH_MS = 500;
+
+function ms(value) {
+  return `${value.toFixed(2)} ms`;
+}
+
+export function StatsWindow({ onClose }) {
+  const [, setRefresh] = useState(0);
+
+  useEffect(() => {
+    const id = setInterval(() => setRefresh((n) => n + 1), REFRESH_MS);
+    return () => clearInterval(id);
+  }, []);
+
+  const metrics = globalThis.perfMetrics;
+  const startup = startupTimes();
+
+  return (
+    <window
+      title="Runtime Stats"
+      defaultX={350}
+      defaultY={300}
+      defaultWidth={320}
+      onClose={onClose}
+    >
+      <text color="#FFFF00">Frame</text>
+      <number value={metrics.reconciliationP95} format="Reconciliation p95: %.2f ms" />
+      <number value={metrics.renderTime} format="ImGui render: %.2f ms" />
+      <number value={metrics.heapSize / 1048576} format="Heap: %.1f MB" />
+      <separator />
+      <text color="#FFFF00">Startup</text>
+      {startup ? (
+        Object.keys(startup).map((phase) => (
+          <text key={phase}>{`${phase}: ${ms(startup[phase])}`}</text>
+        ))
+      ) : (
+        <text>Not finished</text>
+      )}
+    </window>
+  );
+}
@@ -4,6 +4,7 @@
 
 // Stock table component - displays live-updating stock prices for cities
 import React, { useState, useEffect } from 'react';
+import { createSharedArray } from 'react-imgui-reconciler/shared-buffer.js';
 
 // City names for the stock table
 const CITIES = [
@@ -52,48 +53,56 @@ const CITIES = [
 const NUM_ROWS = 40;
 const NUM_COLS = 8;
 
-// Get color based on value
-function getValueColor(value) {
-  if (value < 33.0) return '#FF0000'; // Red
-  if (value < 66.0) return '#00FF00'; // Green
-  return '#FFFFFF'; // White
+// Text colors of the cells, indexed by valueColor()
+const PALETTE = [null, '#FF0000', '#00FF00', '#FFFFFF'];
+
+// Get the palette index for a value
+function valueColor(value) {
+  if (value < 33.0) return 1; // Red
+  if (value < 66.0) return 2; // Green
+  return 3; // White
+}
+
+// One column of prices and their colors, in memory shared with the renderer
+function createPriceColumn(label) {
+  const values = createSharedArray(Float32Array, NUM_ROWS);
+  const colors = createSharedArray(Uint8Array, NUM_ROWS);
+  for (let i = 0; i < NUM_ROWS; i++) {
+    values[i] = Math.random() * 100;
+    colors[i] = valueColor(values[i]);
+  }
+  // Cells flash green or red on a change, faded out natively
+  return { label, values, colors, decimals: 2, align: 'right', flash: true };
 }
 
 export function StockTable() {
-  const [data, setData] = useState(() => {
-    // Initialize full dataset
-    const initialData = [];
-    for (let i = 0; i < NUM_ROWS; i++) {
-      const row = [];
-      for (let j = 0; j < NUM_COLS; j++) {
-        row.push(Math.random() * 100);
-      }
-      initialData.push(row);
+  // The <datagrid> reads the shared columns on every frame, so the updates
+  // below are plain buffer writes: the component never re-renders.
+  const [columns] = useState(() => {
+    const cols = [{ label: 'City', values: CITIES.slice(0, NUM_ROWS), width: 120 }];
+    for (let j = 0; j < NUM_COLS; j++) {
+      cols.push(createPriceColumn(`Col ${j + 1}`));
     }
-    return initialData;
+    return cols;
   });
 
   // Update data every second using setInterval
   useEffect(() => {
     const intervalId = setInterval(() => {
-      setData((prevData) => {
-        const newData = [];
+      for (let j = 1; j <= NUM_COLS; j++) {
+        const { values, colors } = columns[j];
         for (let i = 0; i < NUM_ROWS; i++) {
-          const newRow = [];
-          for (let j = 0; j < NUM_COLS; j++) {
-            let newVal = prevData[i][j] + (Math.random() - 0.5) * 2;
-            newVal = Math.min(100, Math.max(0, newVal));
-            newRow.push(newVal);
-          }
-          newData.push(newRow);
+          let newVal = values[i] + (Math.random() - 0.5) * 2;
+          newVal = Math.min(100, Math.max(0, newVal));
+          values[i] = newVal;
+          colors[i] = valueColor(newVal);
         }
-        return newData;
-      });
+      }
     }, 1000);
 
     // Cleanup function to clear interval when component unmounts
     return () => clearInterval(intervalId);
-  }, []);
+  }, [columns]);
 
   return (
     <window
@@ -101,32 +110,9 @@ export function StockTable() {
       defaultX={100}
       defaultY={150}
       defaultWidth={600}
+      defaultHeight={400}
     >
-      <table id="stockTable" columns={NUM_COLS + 1}>
-        <tablecolumn label="City" flags={16} width={0} />
-        <tablecolumn label="Col 1" flags={8} width={0} />
-        <tablecolumn label="Col 2" flags={8} width={0} />
-        <tablecolumn label="Col 3" flags={8} width={0} />
-        <tablecolumn label="Col 4" flags={8} width={0} />
-        <tablecolumn label="Col 5" flags={8} width={0} />
-        <tablecolumn label="Col 6" flags={8} width={0} />
-        <tablecolumn label="Col 7" flags={8} width={0} />
-        <tablecolumn label="Col 8" flags={8} width={0} />
-        <tableheader />
-
-        {data.map((row, rowIndex) => (
-          <tablerow key={rowIndex}>
-            <tablecell index={0}>
-              <text>{CITIES[rowIndex % CITIES.length]}</text>
-            </tablecell>
-            {row.map((value, colIndex) => (
-              <tablecell key={colIndex} index={colIndex + 1}>
-                <text color={getValueColor(value)}>{value.toFixed(2)}</text>
-              </tablecell>
-            ))}
-          </tablerow>
-        ))}
-      </table>
+      <datagrid id="stockTable" rows={NUM_ROWS} columns={columns} palette={PALETTE} />
     </window>
   );
 }
@@ -7,12 +7,21 @@ import React, { useState } from 'react';
 import { StockTable } from './StockTable.jsx';
 import { BouncingBall } from './BouncingBall.jsx';
 import { ControlledWindow } from './ControlledWindow.jsx';
+import { useLazyUnit } from 'react-imgui-reconciler/lazy-unit.js';
+
+// The Runtime Stats window lives in the lazy unit 'stats', loaded the first
+// time it is opened
+function RuntimeStats({ onClose }) {
+  const stats = useLazyUnit('stats');
+  return stats ? <stats.StatsWindow onClose={onClose} /> : null;
+}
 
 export function App() {
   const [counter1, setCounter1] = useState(0);
   const [counter2, setCounter2] = useState(0);
+  const [showStats, setShowStats] = useState(false);
 
-  console.debug('App rendering, counter1 =', counter1, 'counter2 =', counter2);
+  DEBUG: console.debug('App rendering, counter1 =', counter1, 'counter2 =', counter2);
 
   return (
     <root>
@@ -72,6 +81,7 @@ export function App() {
       <BouncingBall />
       <StockTable />
       <ControlledWindow />
+      {showStats && <RuntimeStats onClose={() => setShowStats(false)} />}
 
       <window title="Hello from React!" defaultX={20} defaultY={40}>
         <text>This is a React component rendering to ImGui</text>
@@ -152,6 +162,10 @@ export function App() {
         <button onClick={() => setCounter2(counter2 + 10)}>+10</button>
         <sameline />
         <button onClick={() => setCounter2(counter2 - 10)}>-10</button>
+
+        <separator />
+
+        <button onClick={() => setShowStats(true)}>Runtime Stats...</button>
       </window>
 
       {/* Footer info bar */}
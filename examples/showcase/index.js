@@ -6,22 +6,16 @@ import React from 'react';
 import { createRoot, render } from 'react-imgui-reconciler/reconciler.js';
 import { App } from './app.jsx';
 
-// Configure window (optional - defaults are provided)
-// globalThis.sappConfig is created by imgui-unit with { title: "imgui-react-runtime" }
-// Applications can override properties here before rendering
-globalThis.sappConfig.title = 'React + ImGui Showcase';
-globalThis.sappConfig.width = 1024;
-globalThis.sappConfig.height = 768;
+// The window is configured by app-config.json (the CONFIG of
+// add_react_imgui_app()), which opens it before this bundle is loaded.
+// Settings assigned to globalThis.sappConfig here would come too late.
 
 // Create React root with fiber root and container
 const root = createRoot();
 
 // Expose to typed unit via global
 globalThis.reactApp = {
-  rootChildren: [],
-
   // Render the app
-  // Note: resetAfterCommit in host-config.js will sync rootChildren after each render
   render() {
     render(React.createElement(App), root);
   },
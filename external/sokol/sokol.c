@@ -6,6 +6,8 @@
  */
 
 #define SOKOL_IMPL
+// The runtime counts draw calls and uploads through sg_install_trace_hooks().
+#define SOKOL_TRACE_HOOKS
 #include "sokol_app.h"
 #include "sokol_gfx.h"
 #include "sokol_glue.h"
@@ -14,8 +16,617 @@
 
 #define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
 #include "cimgui.h"
+
+// simgui_setup() builds the default font atlas; the runtime reports how long
+// that took in its startup times, and can build it through its font atlas
+// cache. The implementation below calls this wrapper instead of
+// ImFontAtlas_GetTexDataAsRGBA32().
+static double _simgui_font_atlas_ms;
+static void (*_simgui_font_atlas_builder)(ImFontAtlas* atlas);
+static void _simgui_timed_font_atlas(ImFontAtlas* atlas, unsigned char** pixels,
+    int* width, int* height, int* bytes_per_pixel) {
+    uint64_t start = stm_now();
+    if (_simgui_font_atlas_builder) {
+        _simgui_font_atlas_builder(atlas);
+    }
+    ImFontAtlas_GetTexDataAsRGBA32(atlas, pixels, width, height,
+        bytes_per_pixel);
+    _simgui_font_atlas_ms = stm_ms(stm_since(start));
+}
+// The atlas the context of simgui_setup() shares, built ahead of it.
+static ImFontAtlas* _simgui_shared_font_atlas;
+// simgui_render() sizes its vertex and index buffers for the draw data it
+// fetches before copying it (see _simgui_fit_draw_buffers() below).
+static ImDrawData* _simgui_fitted_draw_data(void);
+#define ImFontAtlas_GetTexDataAsRGBA32 _simgui_timed_font_atlas
+#define igCreateContext(shared_font_atlas) \
+    igCreateContext(_simgui_shared_font_atlas)
+#define igGetDrawData() _simgui_fitted_draw_data()
 #define SOKOL_IMGUI_IMPL
 #include "sokol_imgui.h"
+#undef igGetDrawData
+#undef igCreateContext
+#undef ImFontAtlas_GetTexDataAsRGBA32
+
+// Time the font atlas build of the last simgui_setup() took, in ms.
+double simgui_font_atlas_ms(void) {
+    return _simgui_font_atlas_ms;
+}
+
+// Build the font atlas with `builder` in simgui_setup(), before its pixels
+// are fetched. Null builds it the usual way.
+void simgui_set_font_atlas_builder(void (*builder)(ImFontAtlas* atlas)) {
+    _simgui_font_atlas_builder = builder;
+}
+
+// Create the ImGui context of simgui_setup() with `atlas` as its font atlas,
+// which the context doesn't own. Pass simgui_desc_t.no_default_font when it
+// already has its fonts. Null gives the context an atlas of its own.
+void simgui_set_shared_font_atlas(ImFontAtlas* atlas) {
+    _simgui_shared_font_atlas = atlas;
+}
+
+// Make the font atlas texture of simgui_setup() again from the atlas of the
+// current context, destroying the old one: for a shared atlas, whose context
+// was created with no_default_font and so got no texture, or to make it
+// `dynamic`. A dynamic texture gets its pixels from
+// simgui_update_font_image(), at most once per frame and first in the next
+// frame; an immutable one is made from the atlas's RGBA32 pixels.
+void simgui_make_font_image(bool dynamic) {
+    SOKOL_ASSERT(_SIMGUI_INIT_COOKIE == _simgui.init_cookie);
+    ImFontAtlas* atlas = igGetIO()->Fonts;
+    unsigned char* pixels;
+    int width, height, bytes_per_pixel;
+    ImFontAtlas_GetTexDataAsRGBA32(atlas, &pixels, &width, &height,
+        &bytes_per_pixel);
+    simgui_destroy_image(_simgui.default_font);
+    sg_destroy_image(_simgui.font_img);
+    sg_image_desc img_desc;
+    _simgui_clear(&img_desc, sizeof(img_desc));
+    img_desc.width = width;
+    img_desc.height = height;
+    img_desc.pixel_format = SG_PIXELFORMAT_RGBA8;
+    if (dynamic) {
+        img_desc.usage = SG_USAGE_DYNAMIC;
+    } else {
+        img_desc.data.subimage[0][0].ptr = pixels;
+        img_desc.data.subimage[0][0].size =
+            (size_t)(width * height) * sizeof(uint32_t);
+    }
+    img_desc.label = "sokol-imgui-font-image";
+    _simgui.font_img = sg_make_image(&img_desc);
+    simgui_image_desc_t font_desc;
+    _simgui_clear(&font_desc, sizeof(font_desc));
+    font_desc.image = _simgui.font_img;
+    font_desc.sampler = _simgui.font_smp;
+    _simgui.default_font = simgui_make_image(&font_desc);
+    atlas->TexID = simgui_imtextureid(_simgui.default_font);
+}
+
+// Replace the pixels of a font atlas texture made dynamic by
+// simgui_make_font_image(); `size` bytes of RGBA8.
+void simgui_update_font_image(const void* pixels, size_t size) {
+    SOKOL_ASSERT(_SIMGUI_INIT_COOKIE == _simgui.init_cookie);
+    sg_image_data data;
+    _simgui_clear(&data, sizeof(data));
+    data.subimage[0][0].ptr = pixels;
+    data.subimage[0][0].size = size;
+    sg_update_image(_simgui.font_img, &data);
+}
 
 // Must be separate to avoid reordering.
 #include "sokol_debugtext.h"
+
+// sokol_imgui allocates its vertex and index buffers once, for
+// simgui_desc_t.max_vertices, and leaves out the command lists that don't
+// fit. Both renderers call _simgui_fit_draw_buffers() before the upload
+// instead: a buffer too small for the frame is made again at the next power
+// of two that holds it, and one that frames have used less than a quarter
+// of for _SIMGUI_SHRINK_FRAMES frames in a row is halved, but never below
+// its size at simgui_setup().
+#define _SIMGUI_SHRINK_FRAMES 600
+
+typedef struct {
+    int setup_capacity;
+    int used;
+    int high_water;
+    int small_frames;
+} _simgui_buffer_usage_t;
+
+static _simgui_buffer_usage_t _simgui_vtx_usage;
+static _simgui_buffer_usage_t _simgui_idx_usage;
+static int _simgui_buffer_resizes;
+
+// The capacity a buffer of `capacity` elements should have for a frame that
+// needs `needed` of them.
+static int _simgui_fit_capacity(_simgui_buffer_usage_t* usage, int capacity,
+    int needed) {
+    if (usage->setup_capacity == 0) {
+        usage->setup_capacity = capacity;
+    }
+    usage->used = needed;
+    if (needed > usage->high_water) {
+        usage->high_water = needed;
+    }
+    if (needed > capacity) {
+        usage->small_frames = 0;
+        while (capacity < needed) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+    if (needed >= capacity / 4 || capacity <= usage->setup_capacity) {
+        usage->small_frames = 0;
+        return capacity;
+    }
+    if (++usage->small_frames < _SIMGUI_SHRINK_FRAMES) {
+        return capacity;
+    }
+    usage->small_frames = 0;
+    capacity /= 2;
+    return capacity < usage->setup_capacity ? usage->setup_capacity : capacity;
+}
+
+// Replace `*buf` and its staging memory `*range` with ones of `size` bytes.
+static void _simgui_resize_buffer(sg_buffer* buf, sg_range* range,
+    sg_buffer_type type, size_t size, const char* label) {
+    sg_destroy_buffer(*buf);
+    _simgui_free((void*)range->ptr);
+    range->size = size;
+    range->ptr = _simgui_malloc(size);
+    sg_buffer_desc desc;
+    _simgui_clear(&desc, sizeof(desc));
+    desc.type = type;
+    desc.usage = SG_USAGE_STREAM;
+    desc.size = size;
+    desc.label = label;
+    *buf = sg_make_buffer(&desc);
+    _simgui_buffer_resizes++;
+}
+
+// Grow or shrink the vertex and index buffers for `draw_data`.
+static void _simgui_fit_draw_buffers(ImDrawData* draw_data) {
+    if (0 == draw_data) {
+        return;
+    }
+    const int vtx_capacity = (int)(_simgui.vertices.size / sizeof(ImDrawVert));
+    const int idx_capacity = (int)(_simgui.indices.size / sizeof(ImDrawIdx));
+    const int new_vtx_capacity = _simgui_fit_capacity(&_simgui_vtx_usage,
+        vtx_capacity, draw_data->TotalVtxCount);
+    const int new_idx_capacity = _simgui_fit_capacity(&_simgui_idx_usage,
+        idx_capacity, draw_data->TotalIdxCount);
+    if (new_vtx_capacity != vtx_capacity) {
+        _simgui_resize_buffer(&_simgui.vbuf, &_simgui.vertices,
+            SG_BUFFERTYPE_VERTEXBUFFER,
+            (size_t)new_vtx_capacity * sizeof(ImDrawVert),
+            "sokol-imgui-vertices");
+    }
+    if (new_idx_capacity != idx_capacity) {
+        _simgui_resize_buffer(&_simgui.ibuf, &_simgui.indices,
+            SG_BUFFERTYPE_INDEXBUFFER,
+            (size_t)new_idx_capacity * sizeof(ImDrawIdx),
+            "sokol-imgui-indices");
+    }
+}
+
+static ImDrawData* _simgui_fitted_draw_data(void) {
+    ImDrawData* draw_data = igGetDrawData();
+    _simgui_fit_draw_buffers(draw_data);
+    return draw_data;
+}
+
+// Usage of the vertex and index buffers: the elements the last frame drew,
+// the current capacities, the most a frame has needed so far, and how many
+// times a buffer was made again.
+typedef struct {
+    int vertices;
+    int indices;
+    int vertex_capacity;
+    int index_capacity;
+    int vertex_high_water;
+    int index_high_water;
+    int resizes;
+} simgui_draw_buffer_stats_t;
+
+void simgui_draw_buffer_stats(simgui_draw_buffer_stats_t* stats) {
+    SOKOL_ASSERT(_SIMGUI_INIT_COOKIE == _simgui.init_cookie);
+    stats->vertices = _simgui_vtx_usage.used;
+    stats->indices = _simgui_idx_usage.used;
+    stats->vertex_capacity = (int)(_simgui.vertices.size / sizeof(ImDrawVert));
+    stats->index_capacity = (int)(_simgui.indices.size / sizeof(ImDrawIdx));
+    stats->vertex_high_water = _simgui_vtx_usage.high_water;
+    stats->index_high_water = _simgui_idx_usage.high_water;
+    stats->resizes = _simgui_buffer_resizes;
+}
+
+// Change the swap interval of a running app. sokol_app only applies
+// sapp_desc.swap_interval at startup; this re-applies it through the same
+// platform calls (MTKView frame rate, glXSwapIntervalEXT, eglSwapInterval,
+// wglSwapIntervalEXT). D3D11 reads it on every present. 0 disables vsync
+// where the platform allows it (not with Metal, which is clamped to 1).
+void sapp_set_swap_interval(int interval) {
+    if (interval < 0) {
+        interval = 0;
+    }
+#if defined(_SAPP_MACOS) && defined(SOKOL_METAL)
+    if (interval < 1) {
+        interval = 1;
+    }
+    NSInteger max_fps = 60;
+    #if (__MAC_OS_X_VERSION_MAX_ALLOWED >= 120000)
+    if (@available(macOS 12.0, *)) {
+        max_fps = [NSScreen.mainScreen maximumFramesPerSecond];
+    }
+    #endif
+    _sapp.swap_interval = interval;
+    _sapp.macos.view.preferredFramesPerSecond = max_fps / interval;
+#elif defined(_SAPP_GLX)
+    _sapp.swap_interval = interval;
+    _sapp_glx_swapinterval(interval);
+#elif defined(_SAPP_LINUX)
+    _sapp.swap_interval = interval;
+    eglSwapInterval(_sapp.egl.display, interval);
+#elif defined(_SAPP_WIN32) && defined(SOKOL_GLCORE33)
+    _sapp.swap_interval = interval;
+    if (_sapp.wgl.ext_swap_control) {
+        _sapp.wgl.SwapIntervalEXT(interval);
+    }
+#else
+    _sapp.swap_interval = interval;
+#endif
+}
+
+// The current swap interval.
+int sapp_swap_interval(void) {
+    return _sapp.swap_interval;
+}
+
+// The drawing half of simgui_render(), for draw data that was built (and
+// copied) elsewhere, e.g. by a thread that ran igNewFrame()..igRender().
+// Uses the display size stored in the draw data and `dpi_scale` instead of
+// the live ImGuiIO, which belongs to that other thread. Must run between
+// sg_begin_*_pass() and sg_end_pass(), like simgui_render().
+void simgui_render_draw_data(ImDrawData* draw_data, float dpi_scale) {
+    SOKOL_ASSERT(_SIMGUI_INIT_COOKIE == _simgui.init_cookie);
+    if (0 == draw_data || draw_data->CmdListsCount == 0) {
+        return;
+    }
+    _simgui_fit_draw_buffers(draw_data);
+    size_t all_vtx_size = 0;
+    size_t all_idx_size = 0;
+    int cmd_list_count = 0;
+    for (int cl_index = 0; cl_index < draw_data->CmdListsCount;
+         cl_index++, cmd_list_count++) {
+        ImDrawList* cl = _simgui_imdrawlist_at(draw_data, cl_index);
+        const size_t vtx_size = (size_t)cl->VtxBuffer.Size * sizeof(ImDrawVert);
+        const size_t idx_size = (size_t)cl->IdxBuffer.Size * sizeof(ImDrawIdx);
+        if (((all_vtx_size + vtx_size) > _simgui.vertices.size) ||
+            ((all_idx_size + idx_size) > _simgui.indices.size))
+        {
+            break;
+        }
+        if (vtx_size > 0) {
+            memcpy(((uint8_t*)_simgui.vertices.ptr) + all_vtx_size,
+                cl->VtxBuffer.Data, vtx_size);
+        }
+        if (idx_size > 0) {
+            memcpy(((uint8_t*)_simgui.indices.ptr) + all_idx_size,
+                cl->IdxBuffer.Data, idx_size);
+        }
+        all_vtx_size += vtx_size;
+        all_idx_size += idx_size;
+    }
+    if (0 == cmd_list_count) {
+        return;
+    }
+
+    sg_push_debug_group("sokol-imgui");
+    if (all_vtx_size > 0) {
+        sg_range vtx_data = _simgui.vertices;
+        vtx_data.size = all_vtx_size;
+        sg_update_buffer(_simgui.vbuf, &vtx_data);
+    }
+    if (all_idx_size > 0) {
+        sg_range idx_data = _simgui.indices;
+        idx_data.size = all_idx_size;
+        sg_update_buffer(_simgui.ibuf, &idx_data);
+    }
+
+    const int fb_width = (int) (draw_data->DisplaySize.x * dpi_scale);
+    const int fb_height = (int) (draw_data->DisplaySize.y * dpi_scale);
+    sg_apply_viewport(0, 0, fb_width, fb_height, true);
+    sg_apply_scissor_rect(0, 0, fb_width, fb_height, true);
+
+    sg_apply_pipeline(_simgui.pip);
+    _simgui_vs_params_t vs_params;
+    _simgui_clear((void*)&vs_params, sizeof(vs_params));
+    vs_params.disp_size.x = draw_data->DisplaySize.x;
+    vs_params.disp_size.y = draw_data->DisplaySize.y;
+    sg_apply_uniforms(SG_SHADERSTAGE_VS, 0, SG_RANGE_REF(vs_params));
+    sg_bindings bind;
+    _simgui_clear((void*)&bind, sizeof(bind));
+    bind.vertex_buffers[0] = _simgui.vbuf;
+    bind.index_buffer = _simgui.ibuf;
+    // The font atlas texture is set up once by simgui_setup().
+    ImTextureID tex_id = igGetIO()->Fonts->TexID;
+    _simgui_bind_image_sampler(&bind, tex_id);
+    int vb_offset = 0;
+    int ib_offset = 0;
+    for (int cl_index = 0; cl_index < cmd_list_count; cl_index++) {
+        ImDrawList* cl = _simgui_imdrawlist_at(draw_data, cl_index);
+
+        bind.vertex_buffer_offsets[0] = vb_offset;
+        bind.index_buffer_offset = ib_offset;
+        sg_apply_bindings(&bind);
+
+        const int num_cmds = cl->CmdBuffer.Size;
+        uint32_t vtx_offset = 0;
+        for (int cmd_index = 0; cmd_index < num_cmds; cmd_index++) {
+            ImDrawCmd* pcmd = &cl->CmdBuffer.Data[cmd_index];
+            if (pcmd->UserCallback) {
+                pcmd->UserCallback(cl, pcmd);
+                sg_apply_viewport(0, 0, fb_width, fb_height, true);
+                sg_apply_pipeline(_simgui.pip);
+                sg_apply_uniforms(SG_SHADERSTAGE_VS, 0,
+                    SG_RANGE_REF(vs_params));
+                sg_apply_bindings(&bind);
+            } else {
+                if ((tex_id != pcmd->TextureId) ||
+                    (vtx_offset != pcmd->VtxOffset)) {
+                    tex_id = pcmd->TextureId;
+                    vtx_offset = pcmd->VtxOffset;
+                    _simgui_bind_image_sampler(&bind, tex_id);
+                    bind.vertex_buffer_offsets[0] = vb_offset +
+                        (int)(pcmd->VtxOffset * sizeof(ImDrawVert));
+                    sg_apply_bindings(&bind);
+                }
+                const int scissor_x = (int) (pcmd->ClipRect.x * dpi_scale);
+                const int scissor_y = (int) (pcmd->ClipRect.y * dpi_scale);
+                const int scissor_w =
+                    (int) ((pcmd->ClipRect.z - pcmd->ClipRect.x) * dpi_scale);
+                const int scissor_h =
+                    (int) ((pcmd->ClipRect.w - pcmd->ClipRect.y) * dpi_scale);
+                sg_apply_scissor_rect(scissor_x, scissor_y, scissor_w,
+                    scissor_h, true);
+                sg_draw((int)pcmd->IdxOffset, (int)pcmd->ElemCount, 1);
+            }
+        }
+        vb_offset += (int)((size_t)cl->VtxBuffer.Size * sizeof(ImDrawVert));
+        ib_offset += (int)((size_t)cl->IdxBuffer.Size * sizeof(ImDrawIdx));
+    }
+    sg_apply_viewport(0, 0, fb_width, fb_height, true);
+    sg_apply_scissor_rect(0, 0, fb_width, fb_height, true);
+    sg_pop_debug_group();
+}
+
+// Hand an input event to the current ImGui context the way
+// simgui_handle_event() does, for runs without sokol_imgui (headless
+// replays of input scripts). Mouse positions are in ImGui coordinates (a DPI
+// scale of 1). Covers mouse, scroll, key and char events.
+void simgui_feed_event(const sapp_event* ev) {
+    ImGuiIO* io = igGetIO();
+    switch (ev->type) {
+        case SAPP_EVENTTYPE_MOUSE_DOWN:
+        case SAPP_EVENTTYPE_MOUSE_UP:
+            ImGuiIO_AddMousePosEvent(io, ev->mouse_x, ev->mouse_y);
+            ImGuiIO_AddMouseButtonEvent(io, (int)ev->mouse_button,
+                ev->type == SAPP_EVENTTYPE_MOUSE_DOWN);
+            _simgui_update_modifiers(io, ev->modifiers);
+            break;
+        case SAPP_EVENTTYPE_MOUSE_MOVE:
+            ImGuiIO_AddMousePosEvent(io, ev->mouse_x, ev->mouse_y);
+            break;
+        case SAPP_EVENTTYPE_MOUSE_SCROLL:
+            ImGuiIO_AddMouseWheelEvent(io, ev->scroll_x, ev->scroll_y);
+            break;
+        case SAPP_EVENTTYPE_KEY_DOWN:
+        case SAPP_EVENTTYPE_KEY_UP:
+            _simgui_update_modifiers(io, ev->modifiers);
+            _simgui_add_sapp_key_event(io, ev->key_code,
+                ev->type == SAPP_EVENTTYPE_KEY_DOWN);
+            break;
+        case SAPP_EVENTTYPE_CHAR:
+            _simgui_update_modifiers(io, ev->modifiers);
+            if ((ev->char_code >= 32) && (ev->char_code != 127) &&
+                (0 == (ev->modifiers & (SAPP_MODIFIER_ALT|SAPP_MODIFIER_CTRL|
+                                        SAPP_MODIFIER_SUPER))))
+            {
+                ImGuiIO_AddInputCharacter(io, ev->char_code);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// GPU time of a frame, where the backend can measure it. GL core uses a
+// GL_TIME_ELAPSED query around the commands between sg_gpu_timer_begin()
+// and sg_gpu_timer_end(); Metal uses the GPU start and end times of the
+// frame's whole command buffer and ignores sg_gpu_timer_begin(). Call
+// sg_gpu_timer_end() before sg_commit(). Results arrive a few frames late:
+// sg_gpu_timer_ms() returns the most recent one, or -1 if there is none yet
+// or the backend has no timer queries.
+#if defined(SOKOL_GLCORE33) && !defined(_SOKOL_USE_WIN32_GL_LOADER)
+#define _GPU_TIMER_QUERIES (4)
+static struct {
+    GLuint queries[_GPU_TIMER_QUERIES];
+    bool pending[_GPU_TIMER_QUERIES];
+    // The slot of the next query, which is also the oldest pending one.
+    int next;
+    bool active;
+    double last_ms;
+} _gpu_timer = { .last_ms = -1.0 };
+
+void sg_gpu_timer_begin(void) {
+    // Collect the finished queries, oldest first.
+    for (int i = 0; i < _GPU_TIMER_QUERIES; i++) {
+        int slot = (_gpu_timer.next + i) % _GPU_TIMER_QUERIES;
+        if (!_gpu_timer.pending[slot]) {
+            continue;
+        }
+        GLint available = 0;
+        glGetQueryObjectiv(_gpu_timer.queries[slot],
+            GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) {
+            continue;
+        }
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(_gpu_timer.queries[slot], GL_QUERY_RESULT, &ns);
+        _gpu_timer.last_ms = (double)ns / 1000000.0;
+        _gpu_timer.pending[slot] = false;
+    }
+    // All queries in flight: this frame goes untimed.
+    if (_gpu_timer.pending[_gpu_timer.next]) {
+        return;
+    }
+    if (0 == _gpu_timer.queries[0]) {
+        glGenQueries(_GPU_TIMER_QUERIES, _gpu_timer.queries);
+    }
+    glBeginQuery(GL_TIME_ELAPSED, _gpu_timer.queries[_gpu_timer.next]);
+    _gpu_timer.active = true;
+}
+
+void sg_gpu_timer_end(void) {
+    if (!_gpu_timer.active) {
+        return;
+    }
+    glEndQuery(GL_TIME_ELAPSED);
+    _gpu_timer.pending[_gpu_timer.next] = true;
+    _gpu_timer.next = (_gpu_timer.next + 1) % _GPU_TIMER_QUERIES;
+    _gpu_timer.active = false;
+}
+
+double sg_gpu_timer_ms(void) {
+    return _gpu_timer.last_ms;
+}
+#elif defined(SOKOL_METAL)
+// Written by the command buffer completion handlers on a Metal thread.
+static int64_t _gpu_timer_ns = -1;
+
+void sg_gpu_timer_begin(void) {
+}
+
+void sg_gpu_timer_end(void) {
+    if (@available(macOS 10.15, iOS 10.3, *)) {
+        [_sg.mtl.cmd_buffer
+            addCompletedHandler:^(id<MTLCommandBuffer> cmd_buffer) {
+            int64_t ns = (int64_t)(
+                (cmd_buffer.GPUEndTime - cmd_buffer.GPUStartTime) * 1e9);
+            __atomic_store_n(&_gpu_timer_ns, ns, __ATOMIC_RELAXED);
+        }];
+    }
+}
+
+double sg_gpu_timer_ms(void) {
+    int64_t ns = __atomic_load_n(&_gpu_timer_ns, __ATOMIC_RELAXED);
+    return ns < 0 ? -1.0 : (double)ns / 1000000.0;
+}
+#else
+void sg_gpu_timer_begin(void) {
+}
+
+void sg_gpu_timer_end(void) {
+}
+
+double sg_gpu_timer_ms(void) {
+    return -1.0;
+}
+#endif
+
+// Asynchronous readback of the default framebuffer, for screenshots that
+// don't stall the GPU. Call sg_readback_begin() after the sg_end_pass() of
+// the default pass and before sg_commit(): GL core copies the framebuffer
+// into one of a few pixel pack buffers and fences the copy, so glReadPixels()
+// returns at once. A few frames later sg_readback_map() finds the fence
+// signalled and maps the buffer: width * height * 4 bytes of RGBA, bottom
+// row first, readable from any thread until sg_readback_release(). Until
+// then it returns NULL without waiting. Other backends have no readback:
+// sg_readback_begin() returns -1.
+#if defined(SOKOL_GLCORE33) && !defined(_SOKOL_USE_WIN32_GL_LOADER)
+#define _READBACK_SLOTS (3)
+static struct {
+    GLuint buffers[_READBACK_SLOTS];
+    GLsizeiptr sizes[_READBACK_SLOTS];
+    GLsync fences[_READBACK_SLOTS];
+    bool busy[_READBACK_SLOTS];
+} _readback;
+
+int sg_readback_begin(int width, int height) {
+    if (width <= 0 || height <= 0) {
+        return -1;
+    }
+    int slot = 0;
+    while (slot < _READBACK_SLOTS && _readback.busy[slot]) {
+        slot++;
+    }
+    if (slot == _READBACK_SLOTS) {
+        return -1;
+    }
+    if (0 == _readback.buffers[0]) {
+        glGenBuffers(_READBACK_SLOTS, _readback.buffers);
+    }
+    GLsizeiptr size = (GLsizeiptr)width * height * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, _readback.buffers[slot]);
+    if (_readback.sizes[slot] != size) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+        _readback.sizes[slot] = size;
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER,
+        _sg.gl.cur_context->default_framebuffer);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    _readback.fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    _readback.busy[slot] = true;
+    return slot;
+}
+
+const void* sg_readback_map(int slot) {
+    if (slot < 0 || slot >= _READBACK_SLOTS || !_readback.busy[slot]) {
+        return NULL;
+    }
+    if (_readback.fences[slot]) {
+        GLenum status = glClientWaitSync(_readback.fences[slot], 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            return NULL;
+        }
+        glDeleteSync(_readback.fences[slot]);
+        _readback.fences[slot] = 0;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, _readback.buffers[slot]);
+    const void* ptr = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+        _readback.sizes[slot], GL_MAP_READ_BIT);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return ptr;
+}
+
+void sg_readback_release(int slot) {
+    if (slot < 0 || slot >= _READBACK_SLOTS || !_readback.busy[slot]) {
+        return;
+    }
+    if (_readback.fences[slot]) {
+        glDeleteSync(_readback.fences[slot]);
+        _readback.fences[slot] = 0;
+    } else {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, _readback.buffers[slot]);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    _readback.busy[slot] = false;
+}
+#else
+int sg_readback_begin(int width, int height) {
+    (void)width;
+    (void)height;
+    return -1;
+}
+
+const void* sg_readback_map(int slot) {
+    (void)slot;
+    return NULL;
+}
+
+void sg_readback_release(int slot) {
+    (void)slot;
+}
+#endif
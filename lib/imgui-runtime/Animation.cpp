@@ -0,0 +1,545 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "Animation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// Drivers of __animStart(). Must match Driver in the reconciler's
+/// animated.js.
+enum AnimDriver {
+  AnimNone = 0,
+  /// param1: stiffness, param2: damping (mass 1)
+  AnimSpring = 2,
+  /// to: initial velocity, param1: deceleration per ms (0.998)
+  AnimDecay = 3,
+  /// param1: min, param2: max, reflected at both
+  AnimBounce = 4,
+};
+
+/// Easing curves of the tweens. Must match Easing in animated.js.
+enum AnimEasing {
+  EaseLinear,
+  EaseIn,
+  EaseOut,
+  EaseInOut,
+  EaseOutBack,
+};
+
+/// Doubles per tween in the buffer of __animPlay(): slot, delay (ms),
+/// duration (ms), from (NaN: the value when the tween starts), to, easing,
+/// color (1 to interpolate the channels of packed ABGR colors).
+constexpr size_t kTweenFields = 7;
+
+/// A spring is at rest once it is this close to its target, this slowly.
+constexpr double kRestDelta = 0.01;
+constexpr double kRestSpeed = 0.01;
+/// A decay ends once it is slower than this, in units per second.
+constexpr double kDecayRestSpeed = 1;
+/// Longest step: a frame after a stall doesn't make springs overshoot.
+constexpr double kMaxStepMs = 64;
+/// Substep of the spring integration.
+constexpr double kSpringStepMs = 4;
+
+struct Slot {
+  /// Units per second.
+  double velocity = 0;
+  int driver = AnimNone;
+  double from = 0;
+  double to = 0;
+  double startMs = 0;
+  double param1 = 0;
+  double param2 = 0;
+  /// Incremented by every driver start, so that a finish is matched to it.
+  uint32_t generation = 0;
+  /// Incremented on release, so that a tween of a timeline started before
+  /// doesn't write the slot once it is reused.
+  uint32_t life = 0;
+  /// The timeline whose tween writes the slot, 0 if none.
+  uint32_t timeline = 0;
+};
+
+struct Tween {
+  int slot;
+  uint32_t life;
+  double delayMs;
+  double durationMs;
+  double from;
+  double to;
+  int easing;
+  bool color;
+  bool started = false;
+  bool done = false;
+};
+
+struct Timeline {
+  uint32_t id;
+  double startMs;
+  std::vector<Tween> tweens;
+  size_t left;
+  /// Set once a tween lost its slot to something else.
+  bool interrupted = false;
+};
+
+enum FinishedKind { FinishedDriver, FinishedTimeline };
+
+struct Finished {
+  FinishedKind kind;
+  uint32_t id;
+  uint32_t generation;
+  bool finished;
+};
+
+/// The values apart from the rest of the slot, for the renderer.
+std::vector<double> s_values;
+std::vector<Slot> s_slots;
+std::vector<int> s_free_slots;
+/// Slots with a driver.
+std::vector<int> s_active;
+std::vector<Timeline> s_timelines;
+uint32_t s_next_timeline = 1;
+double s_last_step_ms = -1;
+/// A slot was set or started since the last step.
+bool s_dirty = false;
+/// Ends reported by the next animation_step().
+std::vector<Finished> s_finished;
+
+facebook::jsi::Runtime *s_runtime = nullptr;
+/// The time base of animation_step(), in ms.
+double (*s_clock_ms)() = nullptr;
+std::shared_ptr<facebook::jsi::Function> s_on_finished;
+
+int create_slot(double value) {
+  int slot;
+  if (!s_free_slots.empty()) {
+    slot = s_free_slots.back();
+    s_free_slots.pop_back();
+  } else {
+    slot = (int)s_slots.size();
+    s_slots.emplace_back();
+    s_values.push_back(0);
+  }
+  Slot &s = s_slots[slot];
+  s.velocity = 0;
+  s.driver = AnimNone;
+  s.timeline = 0;
+  s_values[slot] = value;
+  s_dirty = true;
+  return slot;
+}
+
+/// Stop the driver of `slot`, reporting it unfinished if `report`.
+void stop_driver(int slot, bool report) {
+  Slot &s = s_slots[slot];
+  if (s.driver == AnimNone)
+    return;
+  s.driver = AnimNone;
+  s_active.erase(std::find(s_active.begin(), s_active.end(), slot));
+  if (report)
+    s_finished.push_back({FinishedDriver, (uint32_t)slot, s.generation, false});
+}
+
+double ease(int easing, double t) {
+  switch (easing) {
+  case EaseIn:
+    return t * t * t;
+  case EaseOut: {
+    double u = 1 - t;
+    return 1 - u * u * u;
+  }
+  case EaseInOut: {
+    if (t < 0.5)
+      return 4 * t * t * t;
+    double u = -2 * t + 2;
+    return 1 - u * u * u / 2;
+  }
+  case EaseOutBack: {
+    // Overshoots by about 10% before settling
+    constexpr double c1 = 1.70158;
+    constexpr double c3 = c1 + 1;
+    double u = t - 1;
+    return 1 + c3 * u * u * u + c1 * u * u;
+  }
+  default:
+    return t;
+  }
+}
+
+/// Interpolate each channel of two packed ABGR colors.
+double lerp_color(double from, double to, double k) {
+  uint32_t a = (uint32_t)from;
+  uint32_t b = (uint32_t)to;
+  uint32_t out = 0;
+  for (int shift = 0; shift < 32; shift += 8) {
+    double ca = (a >> shift) & 0xFF;
+    double cb = (b >> shift) & 0xFF;
+    double c = std::round(ca + (cb - ca) * k);
+    out |= (uint32_t)std::clamp(c, 0.0, 255.0) << shift;
+  }
+  return out;
+}
+
+/// Advance the driver of `slot` to `nowMs`, by `dtMs` since the last step.
+/// Returns false once it has finished.
+bool step_driver(int slot, double nowMs, double dtMs) {
+  Slot &s = s_slots[slot];
+  double &value = s_values[slot];
+  switch (s.driver) {
+  case AnimSpring: {
+    double x = value;
+    double v = s.velocity;
+    // Semi-implicit Euler in substeps, stable for the usual stiffnesses
+    for (double left = dtMs; left > 0; left -= kSpringStepMs) {
+      double h = std::min(left, kSpringStepMs) / 1000;
+      v += (-s.param1 * (x - s.to) - s.param2 * v) * h;
+      x += v * h;
+    }
+    if (std::fabs(x - s.to) < kRestDelta && std::fabs(v) < kRestSpeed) {
+      value = s.to;
+      s.velocity = 0;
+      return false;
+    }
+    value = x;
+    s.velocity = v;
+    return true;
+  }
+  case AnimDecay: {
+    // As React Native's decay: the velocity shrinks by `deceleration` per ms
+    double k = 1 - s.param1;
+    double decay = std::exp(-k * (nowMs - s.startMs));
+    double v0 = s.to;
+    value = s.from + (k > 0 ? v0 / 1000 / k * (1 - decay) : 0);
+    s.velocity = v0 * decay;
+    return k > 0 && std::fabs(s.velocity) >= kDecayRestSpeed;
+  }
+  case AnimBounce: {
+    double min = s.param1;
+    double max = s.param2;
+    double x = value + s.velocity * dtMs / 1000;
+    if (max > min) {
+      if (x < min) {
+        x = min + (min - x);
+        s.velocity = std::fabs(s.velocity);
+      }
+      if (x > max) {
+        x = max - (x - max);
+        s.velocity = -std::fabs(s.velocity);
+      }
+      x = std::clamp(x, min, max);
+    }
+    value = x;
+    return true;
+  }
+  default:
+    return false;
+  }
+}
+
+/// Advance the tweens of `timeline` to `nowMs`. Returns false once all of
+/// them are done.
+bool step_timeline(Timeline &timeline, double nowMs) {
+  double elapsed = nowMs - timeline.startMs;
+  for (Tween &tween : timeline.tweens) {
+    if (tween.done || elapsed < tween.delayMs)
+      continue;
+    Slot &s = s_slots[tween.slot];
+    if (!tween.started) {
+      tween.started = true;
+      if (s.life != tween.life) {
+        // Released since the timeline started
+        tween.done = true;
+        --timeline.left;
+        continue;
+      }
+      stop_driver(tween.slot, true);
+      s.timeline = timeline.id;
+      s.velocity = 0;
+      if (std::isnan(tween.from))
+        tween.from = s_values[tween.slot];
+    } else if (s.timeline != timeline.id || s.life != tween.life) {
+      // Taken over by a set, a driver or a later timeline
+      tween.done = true;
+      timeline.interrupted = true;
+      --timeline.left;
+      continue;
+    }
+    double t = tween.durationMs > 0
+                   ? (elapsed - tween.delayMs) / tween.durationMs
+                   : 1;
+    if (t >= 1) {
+      t = 1;
+      tween.done = true;
+      --timeline.left;
+    }
+    double k = ease(tween.easing, t);
+    s_values[tween.slot] = tween.color
+                               ? lerp_color(tween.from, tween.to, k)
+                               : tween.from + (tween.to - tween.from) * k;
+  }
+  return timeline.left > 0;
+}
+
+/// The slot in the first argument, or throw.
+int slot_arg(facebook::jsi::Runtime &rt, const facebook::jsi::Value *args,
+             size_t count, const char *name) {
+  if (count > 0 && args[0].isNumber()) {
+    double slot = args[0].getNumber();
+    if (slot >= 0 && slot < (double)s_slots.size())
+      return (int)slot;
+  }
+  throw facebook::jsi::JSError(rt, std::string(name) + ": invalid slot");
+}
+
+double number_arg(const facebook::jsi::Value *args, size_t count, size_t i) {
+  return i < count && args[i].isNumber() ? args[i].getNumber() : 0;
+}
+
+void set_function(
+    facebook::jsi::Runtime &rt, const char *name, unsigned params,
+    std::function<facebook::jsi::Value(facebook::jsi::Runtime &,
+                                       const facebook::jsi::Value *, size_t)>
+        fn) {
+  rt.global().setProperty(
+      rt, name,
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, name), params,
+          [fn = std::move(fn)](facebook::jsi::Runtime &rt,
+                               const facebook::jsi::Value &,
+                               const facebook::jsi::Value *args,
+                               size_t count) { return fn(rt, args, count); }));
+}
+
+} // namespace
+
+void install_animation(facebook::jsi::Runtime &rt, double (*clockMs)()) {
+  s_runtime = &rt;
+  s_clock_ms = clockMs;
+
+  set_function(rt, "__animCreate", 1, [](facebook::jsi::Runtime &,
+                                        const facebook::jsi::Value *args,
+                                        size_t count) -> facebook::jsi::Value {
+    return create_slot(number_arg(args, count, 0));
+  });
+
+  set_function(rt, "__animRelease", 1,
+               [](facebook::jsi::Runtime &rt, const facebook::jsi::Value *args,
+                  size_t count) -> facebook::jsi::Value {
+                 int slot = slot_arg(rt, args, count, "__animRelease");
+                 stop_driver(slot, false);
+                 Slot &s = s_slots[slot];
+                 ++s.generation;
+                 ++s.life;
+                 s.timeline = 0;
+                 s_free_slots.push_back(slot);
+                 return facebook::jsi::Value::undefined();
+               });
+
+  set_function(rt, "__animSet", 2,
+               [](facebook::jsi::Runtime &rt, const facebook::jsi::Value *args,
+                  size_t count) -> facebook::jsi::Value {
+                 int slot =
+                     slot_arg(rt, args, count, "__animSet");
+                 stop_driver(slot, false);
+                 Slot &s = s_slots[slot];
+                 s.timeline = 0;
+                 s.velocity = 0;
+                 s_values[slot] = number_arg(args, count, 1);
+                 s_dirty = true;
+                 return facebook::jsi::Value::undefined();
+               });
+
+  set_function(rt, "__animGet", 1,
+               [](facebook::jsi::Runtime &rt, const facebook::jsi::Value *args,
+                  size_t count) -> facebook::jsi::Value {
+                 return s_values[slot_arg(rt, args, count, "__animGet")];
+               });
+
+  set_function(rt, "__animVelocity", 1,
+               [](facebook::jsi::Runtime &rt, const facebook::jsi::Value *args,
+                  size_t count) -> facebook::jsi::Value {
+                 return s_slots[slot_arg(rt, args, count, "__animVelocity")]
+                     .velocity;
+               });
+
+  // __animStart(slot, driver, to, param1, param2, velocity) -> generation
+  set_function(
+      rt, "__animStart", 6,
+      [](facebook::jsi::Runtime &rt, const facebook::jsi::Value *args,
+         size_t count) -> facebook::jsi::Value {
+        int slot = slot_arg(rt, args, count, "__animStart");
+        int driver = (int)number_arg(args, count, 1);
+        if (driver != AnimSpring && driver != AnimDecay &&
+            driver != AnimBounce)
+          throw facebook::jsi::JSError(rt, "__animStart: unknown driver");
+        Slot &s = s_slots[slot];
+        if (s.driver == AnimNone)
+          s_active.push_back(slot);
+        s.driver = driver;
+        s.timeline = 0;
+        s.from = s_values[slot];
+        s.to = number_arg(args, count, 2);
+        s.param1 = number_arg(args, count, 3);
+        s.param2 = number_arg(args, count, 4);
+        s.velocity = number_arg(args, count, 5);
+        s.startMs = s_clock_ms();
+        // The first step of a driver started while idle is a short one
+        if (s_active.size() == 1)
+          s_last_step_ms = s.startMs;
+        s_dirty = true;
+        return (double)++s.generation;
+      });
+
+  set_function(rt, "__animStop", 1,
+               [](facebook::jsi::Runtime &rt, const facebook::jsi::Value *args,
+                  size_t count) -> facebook::jsi::Value {
+                 int slot =
+                     slot_arg(rt, args, count, "__animStop");
+                 stop_driver(slot, false);
+                 s_slots[slot].timeline = 0;
+                 return facebook::jsi::Value::undefined();
+               });
+
+  // __animPlay(buffer) -> timeline id, the buffer holding kTweenFields
+  // doubles per tween
+  set_function(
+      rt, "__animPlay", 1,
+      [](facebook::jsi::Runtime &rt, const facebook::jsi::Value *args,
+         size_t count) -> facebook::jsi::Value {
+        if (count < 1 || !args[0].isObject() ||
+            !args[0].getObject(rt).isArrayBuffer(rt))
+          throw facebook::jsi::JSError(rt, "__animPlay expects an ArrayBuffer");
+        facebook::jsi::ArrayBuffer ab =
+            args[0].getObject(rt).getArrayBuffer(rt);
+        size_t n = ab.size(rt) / (sizeof(double) * kTweenFields);
+        const double *fields = reinterpret_cast<const double *>(ab.data(rt));
+        Timeline timeline;
+        timeline.id = s_next_timeline++;
+        timeline.startMs = s_clock_ms();
+        timeline.tweens.reserve(n);
+        for (size_t i = 0; i < n; ++i, fields += kTweenFields) {
+          double slot = fields[0];
+          if (!(slot >= 0 && slot < (double)s_slots.size()))
+            throw facebook::jsi::JSError(rt, "__animPlay: invalid slot");
+          Tween tween;
+          tween.slot = (int)slot;
+          tween.life = s_slots[tween.slot].life;
+          tween.delayMs = std::max(0.0, fields[1]);
+          tween.durationMs = std::max(0.0, fields[2]);
+          tween.from = fields[3];
+          tween.to = fields[4];
+          tween.easing = (int)fields[5];
+          tween.color = fields[6] != 0;
+          timeline.tweens.push_back(tween);
+        }
+        timeline.left = n;
+        uint32_t id = timeline.id;
+        s_timelines.push_back(std::move(timeline));
+        s_dirty = true;
+        return (double)id;
+      });
+
+  set_function(rt, "__animStopTimeline", 1,
+               [](facebook::jsi::Runtime &, const facebook::jsi::Value *args,
+                  size_t count) -> facebook::jsi::Value {
+                 uint32_t id = (uint32_t)number_arg(args, count, 0);
+                 // Its slots stay where they are, and still name it as
+                 // their timeline, which no longer exists
+                 s_timelines.erase(
+                     std::remove_if(s_timelines.begin(), s_timelines.end(),
+                                    [id](const Timeline &timeline) {
+                                      return timeline.id == id;
+                                    }),
+                     s_timelines.end());
+                 return facebook::jsi::Value::undefined();
+               });
+
+  // __animOnFinished(cb(kind, id, generation, finished)): kind 0 is a driver
+  // (id is its slot), 1 a timeline
+  set_function(rt, "__animOnFinished", 1,
+               [](facebook::jsi::Runtime &rt, const facebook::jsi::Value *args,
+                  size_t count) -> facebook::jsi::Value {
+                 if (count > 0 && args[0].isObject() &&
+                     args[0].getObject(rt).isFunction(rt))
+                   s_on_finished = std::make_shared<facebook::jsi::Function>(
+                       args[0].getObject(rt).getFunction(rt));
+                 else
+                   s_on_finished.reset();
+                 return facebook::jsi::Value::undefined();
+               });
+}
+
+bool animation_step(double nowMs) {
+  bool changed = s_dirty;
+  s_dirty = false;
+  if (!s_active.empty()) {
+    double dtMs =
+        std::min(kMaxStepMs, std::max(0.0, nowMs - s_last_step_ms));
+    for (size_t i = 0; i < s_active.size();) {
+      int slot = s_active[i];
+      if (step_driver(slot, nowMs, dtMs)) {
+        ++i;
+        continue;
+      }
+      Slot &s = s_slots[slot];
+      s.driver = AnimNone;
+      s_active.erase(s_active.begin() + i);
+      s_finished.push_back(
+          {FinishedDriver, (uint32_t)slot, s.generation, true});
+    }
+    changed = true;
+  }
+  s_last_step_ms = nowMs;
+
+  // Timelines started by a callback below wait for the next frame
+  for (size_t i = 0; i < s_timelines.size();) {
+    Timeline &timeline = s_timelines[i];
+    if (step_timeline(timeline, nowMs)) {
+      ++i;
+    } else {
+      s_finished.push_back(
+          {FinishedTimeline, timeline.id, 0, !timeline.interrupted});
+      s_timelines.erase(s_timelines.begin() + i);
+    }
+    changed = true;
+  }
+
+  if (!s_finished.empty()) {
+    std::vector<Finished> finished;
+    std::swap(finished, s_finished);
+    // Held by the calls, in case a callback replaces it
+    std::shared_ptr<facebook::jsi::Function> callback = s_on_finished;
+    if (callback) {
+      for (const Finished &f : finished) {
+        try {
+          callback->call(*s_runtime, (int)f.kind, (double)f.id,
+                         (double)f.generation, f.finished);
+        } catch (facebook::jsi::JSIException &e) {
+          fprintf(stderr, "Error in animation callback: %s\n", e.what());
+        }
+      }
+    }
+  }
+  return changed;
+}
+
+void shutdown_animation() {
+  s_on_finished.reset();
+  s_timelines.clear();
+  s_active.clear();
+  s_finished.clear();
+  s_runtime = nullptr;
+}
+
+extern "C" const double *imgui_anim_values(void) { return s_values.data(); }
+
+extern "C" int imgui_anim_create(double value) { return create_slot(value); }
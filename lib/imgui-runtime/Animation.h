@@ -0,0 +1,52 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include <hermes/hermes.h>
+
+/// Animated values and timelines, advanced natively once per frame before
+/// on_frame(). A slot holds one number: a coordinate, or a packed ABGR
+/// color. The typed renderer reads the slots of the AnimatedValue props
+/// straight from imgui_anim_values(), so a running animation costs nothing
+/// in JS and never causes a React commit.
+///
+/// A slot is moved by at most one thing at a time: a driver (spring, decay,
+/// bounce), a timeline tween, or a set. Whichever starts last takes the
+/// slot over; a driver taken over by a tween is reported unfinished.
+///
+/// A timeline is a list of tweens, each with a slot, a delay from the start
+/// of the timeline, a duration, an easing curve and from/to values, color
+/// tweens interpolating each channel. Sequences and staggers are built from
+/// the delays by the reconciler's animated.js.
+///
+/// Everything here belongs to the thread that runs JS.
+
+/// Install the __anim* host functions behind the reconciler's AnimatedValue
+/// and timeline(), which start animations at `clockMs()`. Called once at
+/// startup.
+void install_animation(facebook::jsi::Runtime &rt, double (*clockMs)());
+
+/// Advance the drivers and timelines to `nowMs` (on the clock given to
+/// install_animation()) and report the ones that ended to the
+/// __animOnFinished() callback. Returns whether a slot changed since the
+/// last call or is still moving, i.e. whether frames should keep coming.
+bool animation_step(double nowMs);
+
+/// Forget the slots, timelines and callback. Must be called before the
+/// runtime is destroyed.
+void shutdown_animation();
+
+extern "C" {
+
+/// The value column, indexed by slot. Moves when a slot is added, so it is
+/// fetched again after imgui_anim_create(), after every event callback
+/// (which may call __animCreate) and at the start of each frame.
+const double *imgui_anim_values(void);
+
+/// A new slot holding `value`, for a prop value the renderer sees before
+/// the React unit used it.
+int imgui_anim_create(double value);
+
+} // extern "C"
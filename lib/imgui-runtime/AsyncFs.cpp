@@ -0,0 +1,568 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "AsyncFs.h"
+
+#include "MappedFileBuffer.h"
+#include "SharedBuffer.h"
+#include "ThreadPool.h"
+
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+/// Files at least this large are memory mapped instead of read.
+constexpr size_t kMapThreshold = 64 * 1024;
+
+/// Default and smallest chunk sizes of __fsStreamOpen().
+constexpr size_t kStreamChunkSize = 1024 * 1024;
+constexpr size_t kMinStreamChunkSize = 4096;
+
+enum class FsOp { ReadFile, Stat, Readdir };
+
+/// Buffer of a file that was read instead of mapped.
+class HeapBuffer : public facebook::jsi::MutableBuffer {
+public:
+  explicit HeapBuffer(std::vector<uint8_t> &&bytes)
+      : bytes_(std::move(bytes)) {}
+
+  size_t size() const override { return bytes_.size(); }
+  uint8_t *data() override { return bytes_.data(); }
+
+private:
+  std::vector<uint8_t> bytes_;
+};
+
+/// A part of a mapped file, as the buffer of one chunk of a stream. Keeps
+/// the mapping alive.
+class SliceBuffer : public facebook::jsi::MutableBuffer {
+public:
+  SliceBuffer(std::shared_ptr<facebook::jsi::MutableBuffer> file,
+              size_t offset, size_t size)
+      : file_(std::move(file)), offset_(offset), size_(size) {}
+
+  size_t size() const override { return size_; }
+  uint8_t *data() override { return file_->data() + offset_; }
+
+private:
+  std::shared_ptr<facebook::jsi::MutableBuffer> file_;
+  size_t offset_;
+  size_t size_;
+};
+
+/// A file read in chunks by __fsStreamRead(). It is opened by the first
+/// read, on a worker. Regular files are mapped, and a chunk is a slice of
+/// the mapping; others are read() into a buffer per chunk.
+struct FsStream {
+  std::string path;
+  size_t chunkSize;
+  /// End each chunk after a newline, unless it has none.
+  bool lines;
+  /// Held by the worker of a read; jslib issues one read at a time anyway.
+  std::mutex mutex;
+  bool opened = false;
+  /// The file of a stream that isn't mapped, -1 if closed.
+  int fd = -1;
+  std::shared_ptr<facebook::jsi::MutableBuffer> map;
+  size_t size = 0;
+  /// The position in the file of the next chunk.
+  size_t offset = 0;
+  /// Read past the last newline of the previous chunk, for `fd` and
+  /// `lines`.
+  std::vector<uint8_t> carry;
+
+  ~FsStream() {
+    if (fd >= 0)
+      close(fd);
+  }
+};
+
+/// Result of a stream read: null `data` at the end of the file.
+struct FsChunk {
+  int err = 0;
+  std::shared_ptr<facebook::jsi::MutableBuffer> data;
+  size_t offset = 0;
+};
+
+/// Open streams by stream ID. Main thread only.
+std::unordered_map<unsigned, std::shared_ptr<FsStream>> s_streams{};
+unsigned s_next_stream = 1;
+
+/// Result of a request, filled in by a worker.
+struct FsResult {
+  /// errno of the failed call, 0 on success.
+  int err = 0;
+  /// ReadFile: the contents.
+  std::shared_ptr<facebook::jsi::MutableBuffer> data;
+  /// Stat: size, mode, mtimeMs, atimeMs, ctimeMs.
+  double stat[5] = {};
+  /// Readdir: the entry names, without "." and "..".
+  std::vector<std::string> names;
+};
+
+/// Callbacks of the requests in flight, by request ID. Main thread only.
+std::unordered_map<unsigned, facebook::jsi::Function> s_callbacks{};
+unsigned s_next_request = 1;
+
+/// Node's error code for an errno value.
+const char *errno_code(int err) {
+  switch (err) {
+  case ENOENT:
+    return "ENOENT";
+  case EACCES:
+    return "EACCES";
+  case EPERM:
+    return "EPERM";
+  case ENOTDIR:
+    return "ENOTDIR";
+  case EISDIR:
+    return "EISDIR";
+  case ELOOP:
+    return "ELOOP";
+  case ENAMETOOLONG:
+    return "ENAMETOOLONG";
+  case EMFILE:
+    return "EMFILE";
+  case ENFILE:
+    return "ENFILE";
+  case ENOMEM:
+    return "ENOMEM";
+  case EIO:
+    return "EIO";
+  default:
+    return "UNKNOWN";
+  }
+}
+
+const char *op_name(FsOp op) {
+  switch (op) {
+  case FsOp::ReadFile:
+    return "open";
+  case FsOp::Stat:
+    return "stat";
+  case FsOp::Readdir:
+    return "scandir";
+  }
+  return "";
+}
+
+double timespec_ms(const struct timespec &ts) {
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+void read_file(const std::string &path, FsResult &res) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    res.err = errno;
+    return;
+  }
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    res.err = errno;
+    close(fd);
+    return;
+  }
+  if (S_ISDIR(st.st_mode)) {
+    res.err = EISDIR;
+    close(fd);
+    return;
+  }
+
+  size_t size = (size_t)st.st_size;
+  if (S_ISREG(st.st_mode) && size >= kMapThreshold) {
+    res.data = mapFileMutableBuffer(fd, size);
+    if (res.data) {
+      close(fd);
+      return;
+    }
+  }
+
+  // Small files, files that couldn't be mapped and non-regular files (whose
+  // size isn't known up front) are read until EOF.
+  std::vector<uint8_t> bytes(S_ISREG(st.st_mode) ? size : 0);
+  size_t len = 0;
+  for (;;) {
+    if (len == bytes.size())
+      bytes.resize(bytes.size() ? bytes.size() * 2 : 4096);
+    ssize_t n = read(fd, bytes.data() + len, bytes.size() - len);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      res.err = errno;
+      close(fd);
+      return;
+    }
+    if (n == 0)
+      break;
+    len += (size_t)n;
+  }
+  close(fd);
+  bytes.resize(len);
+  res.data = std::make_shared<HeapBuffer>(std::move(bytes));
+}
+
+void stat_file(const std::string &path, FsResult &res) {
+  struct stat st;
+  if (stat(path.c_str(), &st) < 0) {
+    res.err = errno;
+    return;
+  }
+  res.stat[0] = (double)st.st_size;
+  res.stat[1] = (double)st.st_mode;
+#ifdef __APPLE__
+  res.stat[2] = timespec_ms(st.st_mtimespec);
+  res.stat[3] = timespec_ms(st.st_atimespec);
+  res.stat[4] = timespec_ms(st.st_ctimespec);
+#else
+  res.stat[2] = timespec_ms(st.st_mtim);
+  res.stat[3] = timespec_ms(st.st_atim);
+  res.stat[4] = timespec_ms(st.st_ctim);
+#endif
+}
+
+void read_dir(const std::string &path, FsResult &res) {
+  DIR *dir = opendir(path.c_str());
+  if (!dir) {
+    res.err = errno;
+    return;
+  }
+  while (struct dirent *ent = readdir(dir)) {
+    if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0)
+      continue;
+    res.names.emplace_back(ent->d_name);
+  }
+  closedir(dir);
+}
+
+/// Length of `data[0, size)` up to and including its last newline, or `size`
+/// if it has none.
+size_t last_line_end(const uint8_t *data, size_t size) {
+  for (size_t i = size; i > 0; --i)
+    if (data[i - 1] == '\n')
+      return i;
+  return size;
+}
+
+void open_stream(FsStream &stream, FsChunk &res) {
+  stream.opened = true;
+  int fd = open(stream.path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    res.err = errno;
+    return;
+  }
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    res.err = errno;
+    close(fd);
+    return;
+  }
+  if (S_ISDIR(st.st_mode)) {
+    res.err = EISDIR;
+    close(fd);
+    return;
+  }
+  stream.size = (size_t)st.st_size;
+  if (S_ISREG(st.st_mode)) {
+    // An empty file is at its end already
+    if (stream.size)
+      stream.map = mapFileMutableBuffer(fd, stream.size);
+    if (stream.map || !stream.size) {
+      close(fd);
+      return;
+    }
+  }
+  stream.fd = fd;
+}
+
+/// Worker job of __fsStreamRead(): the next chunk of `stream`.
+void read_stream(FsStream &stream, FsChunk &res) {
+  std::lock_guard<std::mutex> lock(stream.mutex);
+  if (!stream.opened) {
+    open_stream(stream, res);
+    if (res.err)
+      return;
+  }
+  res.offset = stream.offset;
+
+  if (stream.map) {
+    if (stream.offset >= stream.size)
+      return;
+    uint8_t *base = stream.map->data();
+    size_t end = std::min(stream.size, stream.offset + stream.chunkSize);
+    if (stream.lines && end < stream.size)
+      end = stream.offset + last_line_end(base + stream.offset,
+                                          end - stream.offset);
+    // Fault the chunk in here rather than in JS, and have the kernel read
+    // the next one while JS works on this one.
+    static const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    volatile uint8_t sink = 0;
+    for (size_t i = stream.offset; i < end; i += pageSize)
+      sink = sink + base[i];
+    if (end < stream.size) {
+      size_t start = end & ~(pageSize - 1);
+      madvise(base + start,
+              std::min(stream.size, end + stream.chunkSize) - start,
+              MADV_WILLNEED);
+    }
+    res.data = std::make_shared<SliceBuffer>(stream.map, stream.offset,
+                                             end - stream.offset);
+    stream.offset = end;
+    return;
+  }
+
+  std::vector<uint8_t> bytes = std::move(stream.carry);
+  stream.carry.clear();
+  size_t len = bytes.size();
+  bool eof = stream.fd < 0;
+  if (!eof) {
+    bytes.resize(std::max(len, stream.chunkSize));
+    while (len < bytes.size()) {
+      ssize_t n = read(stream.fd, bytes.data() + len, bytes.size() - len);
+      if (n < 0) {
+        if (errno == EINTR)
+          continue;
+        res.err = errno;
+        return;
+      }
+      if (n == 0) {
+        eof = true;
+        close(stream.fd);
+        stream.fd = -1;
+        break;
+      }
+      len += (size_t)n;
+    }
+  }
+  if (!len)
+    return;
+  size_t end = len;
+  if (stream.lines && !eof)
+    end = last_line_end(bytes.data(), len);
+  stream.carry.assign(bytes.begin() + end, bytes.begin() + len);
+  bytes.resize(end);
+  stream.offset += end;
+  res.data = std::make_shared<HeapBuffer>(std::move(bytes));
+}
+
+/// Pass the result of a stream read to its callback.
+void complete_stream(facebook::jsi::Runtime &rt, unsigned id,
+                     const std::string &path, FsChunk &res) {
+  auto it = s_callbacks.find(id);
+  if (it == s_callbacks.end())
+    return;
+  facebook::jsi::Function callback = std::move(it->second);
+  s_callbacks.erase(it);
+
+  if (res.err) {
+    std::string message = std::string(errno_code(res.err)) + ": " +
+                          strerror(res.err) + ", open '" + path + "'";
+    callback.call(rt, errno_code(res.err), message);
+    return;
+  }
+  if (!res.data) {
+    callback.call(rt, facebook::jsi::Value::null(),
+                  facebook::jsi::Value::null(), facebook::jsi::Value::null(),
+                  (double)res.offset);
+    return;
+  }
+  register_transferable_buffer(res.data, false);
+  callback.call(rt, facebook::jsi::Value::null(), facebook::jsi::Value::null(),
+                facebook::jsi::ArrayBuffer(rt, std::move(res.data)),
+                (double)res.offset);
+}
+
+/// Convert the result of a request to JS and pass it to its callback.
+void complete(facebook::jsi::Runtime &rt, unsigned id, FsOp op, bool utf8,
+              const std::string &path, FsResult &res) {
+  auto it = s_callbacks.find(id);
+  if (it == s_callbacks.end())
+    return;
+  facebook::jsi::Function callback = std::move(it->second);
+  s_callbacks.erase(it);
+
+  if (res.err) {
+    std::string message = std::string(errno_code(res.err)) + ": " +
+                          strerror(res.err) + ", " + op_name(op) + " '" +
+                          path + "'";
+    callback.call(rt, errno_code(res.err), message);
+    return;
+  }
+
+  facebook::jsi::Value result;
+  switch (op) {
+  case FsOp::ReadFile:
+    if (utf8) {
+      result = facebook::jsi::String::createFromUtf8(rt, res.data->data(),
+                                                     res.data->size());
+    } else {
+      // A worker can hand the file to another runtime without a copy
+      register_transferable_buffer(res.data, false);
+      result = facebook::jsi::ArrayBuffer(rt, std::move(res.data));
+    }
+    break;
+  case FsOp::Stat: {
+    facebook::jsi::Array arr(rt, 5);
+    for (size_t i = 0; i < 5; ++i)
+      arr.setValueAtIndex(rt, i, res.stat[i]);
+    result = std::move(arr);
+    break;
+  }
+  case FsOp::Readdir: {
+    facebook::jsi::Array arr(rt, res.names.size());
+    for (size_t i = 0; i < res.names.size(); ++i) {
+      arr.setValueAtIndex(
+          rt, i, facebook::jsi::String::createFromUtf8(rt, res.names[i]));
+    }
+    result = std::move(arr);
+    break;
+  }
+  }
+  callback.call(rt, facebook::jsi::Value::null(), facebook::jsi::Value::null(),
+                result);
+}
+
+} // namespace
+
+void install_async_fs(facebook::jsi::Runtime &rt, ThreadPool &pool,
+                      MainThreadPoster postToMain) {
+  rt.global().setProperty(
+      rt, "__fsAsync",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__fsAsync"), 4,
+          [&pool, postToMain](facebook::jsi::Runtime &rt,
+                              const facebook::jsi::Value &,
+                              const facebook::jsi::Value *args,
+                              size_t count) -> facebook::jsi::Value {
+            if (count < 4 || !args[0].isString() || !args[1].isString() ||
+                !args[3].isObject() || !args[3].getObject(rt).isFunction(rt)) {
+              throw facebook::jsi::JSError(
+                  rt, "__fsAsync expects an operation, a path, a utf8 flag "
+                      "and a callback");
+            }
+            std::string opName = args[0].getString(rt).utf8(rt);
+            FsOp op;
+            if (opName == "readFile")
+              op = FsOp::ReadFile;
+            else if (opName == "stat")
+              op = FsOp::Stat;
+            else if (opName == "readdir")
+              op = FsOp::Readdir;
+            else
+              throw facebook::jsi::JSError(
+                  rt, "__fsAsync: unknown operation " + opName);
+            std::string path = args[1].getString(rt).utf8(rt);
+            bool utf8 = args[2].isBool() && args[2].getBool();
+
+            unsigned id = s_next_request++;
+            s_callbacks.emplace(id, args[3].getObject(rt).getFunction(rt));
+
+            facebook::jsi::Runtime *rtp = &rt;
+            pool.post(
+                [rtp, id, op, utf8, path, postToMain] {
+                  auto res = std::make_shared<FsResult>();
+                  switch (op) {
+                  case FsOp::ReadFile:
+                    read_file(path, *res);
+                    break;
+                  case FsOp::Stat:
+                    stat_file(path, *res);
+                    break;
+                  case FsOp::Readdir:
+                    read_dir(path, *res);
+                    break;
+                  }
+                  postToMain([rtp, id, op, utf8, path, res] {
+                    complete(*rtp, id, op, utf8, path, *res);
+                  });
+                },
+                {TaskPriority::Normal, TraceTaskFs});
+            return facebook::jsi::Value::undefined();
+          }));
+
+  rt.global().setProperty(
+      rt, "__fsStreamOpen",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__fsStreamOpen"), 3,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count < 1 || !args[0].isString())
+              throw facebook::jsi::JSError(rt,
+                                           "__fsStreamOpen expects a path");
+            auto stream = std::make_shared<FsStream>();
+            stream->path = args[0].getString(rt).utf8(rt);
+            double chunkSize = count > 1 && args[1].isNumber()
+                                   ? args[1].getNumber()
+                                   : (double)kStreamChunkSize;
+            stream->chunkSize = (size_t)std::clamp(
+                chunkSize, (double)kMinStreamChunkSize, (double)(1u << 30));
+            stream->lines = count > 2 && args[2].isBool() && args[2].getBool();
+            unsigned id = s_next_stream++;
+            s_streams.emplace(id, std::move(stream));
+            return (double)id;
+          }));
+
+  rt.global().setProperty(
+      rt, "__fsStreamRead",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__fsStreamRead"), 2,
+          [&pool, postToMain](facebook::jsi::Runtime &rt,
+                              const facebook::jsi::Value &,
+                              const facebook::jsi::Value *args,
+                              size_t count) -> facebook::jsi::Value {
+            if (count < 2 || !args[0].isNumber() || !args[1].isObject() ||
+                !args[1].getObject(rt).isFunction(rt))
+              throw facebook::jsi::JSError(
+                  rt, "__fsStreamRead expects a stream and a callback");
+            auto it = s_streams.find((unsigned)args[0].getNumber());
+            if (it == s_streams.end())
+              throw facebook::jsi::JSError(rt, "__fsStreamRead: closed stream");
+            std::shared_ptr<FsStream> stream = it->second;
+
+            unsigned id = s_next_request++;
+            s_callbacks.emplace(id, args[1].getObject(rt).getFunction(rt));
+
+            facebook::jsi::Runtime *rtp = &rt;
+            pool.post(
+                [rtp, id, stream, postToMain] {
+                  auto res = std::make_shared<FsChunk>();
+                  read_stream(*stream, *res);
+                  postToMain([rtp, id, stream, res] {
+                    complete_stream(*rtp, id, stream->path, *res);
+                  });
+                },
+                {TaskPriority::Normal, TraceTaskFs});
+            return facebook::jsi::Value::undefined();
+          }));
+
+  rt.global().setProperty(
+      rt, "__fsStreamClose",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__fsStreamClose"), 1,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            // A read in flight keeps the stream until it completes
+            if (count >= 1 && args[0].isNumber())
+              s_streams.erase((unsigned)args[0].getNumber());
+            return facebook::jsi::Value::undefined();
+          }));
+}
+
+void shutdown_async_fs() {
+  s_callbacks.clear();
+  s_streams.clear();
+}
@@ -0,0 +1,35 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include <hermes/hermes.h>
+
+#include <functional>
+
+class ThreadPool;
+
+/// Queues a function to run on the main (JS) thread. Must be thread-safe.
+using MainThreadPoster = void (*)(std::function<void()> fn);
+
+/// Install the __fsAsync(op, path, utf8, callback) host function behind
+/// jslib's fs.promises. The file operation runs on `pool`; `postToMain` brings
+/// its result back to the main thread, where `callback(code, message,
+/// result)` is called. Files of 64 KiB and more are memory mapped, so reading
+/// them into an ArrayBuffer doesn't copy them.
+///
+/// It also installs the stream host functions behind jslib's
+/// openFileStream(): __fsStreamOpen(path, chunkSize, lines) returns a stream
+/// ID, __fsStreamRead(id, callback) reads its next chunk on `pool` and calls
+/// `callback(code, message, chunk, offset)` with an ArrayBuffer, or a null
+/// chunk at the end of the file, and __fsStreamClose(id) closes it. A chunk
+/// of a regular file is a slice of its mapping, faulted in by the worker,
+/// which also has the kernel read ahead the next one; with `lines`, chunks
+/// end after a newline unless a line is longer than `chunkSize`.
+void install_async_fs(facebook::jsi::Runtime &rt, ThreadPool &pool,
+                      MainThreadPoster postToMain);
+
+/// Forget the callbacks of the requests in flight and the open streams
+/// (see "Shutdown order" in ThreadPool.h).
+void shutdown_async_fs();
@@ -0,0 +1,294 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "Audio.h"
+
+#include "ThreadPool.h"
+#include "Trace.h"
+
+#include "miniaudio.h"
+#include "soloud.h"
+#include "soloud_wav.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+/// Most samples loaded at once; a handle is a slot index + 1.
+constexpr unsigned kMaxSamples = 1024;
+/// Most frames mixed by one Soloud::mix() call, within its scratch buffer.
+constexpr unsigned kMixChunk = 2048;
+
+enum class AudioOp : uint8_t { Play, StopAll, SetVolume };
+
+struct AudioCommand {
+  AudioOp op;
+  unsigned sample;
+  float volume;
+  float pan;
+};
+
+/// Lock-free single-producer/single-consumer queue from the JS thread to the
+/// audio thread. Full means the audio thread is stalled; commands are then
+/// dropped rather than waited for.
+class CommandQueue {
+public:
+  bool push(const AudioCommand &command) {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) >= kCapacity)
+      return false;
+    slots_[head % kCapacity] = command;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(AudioCommand &command) {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire))
+      return false;
+    command = slots_[tail % kCapacity];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Consumer: drop the queued commands.
+  void clear() {
+    tail_.store(head_.load(std::memory_order_acquire),
+                std::memory_order_release);
+  }
+
+private:
+  static constexpr uint32_t kCapacity = 256;
+
+  AudioCommand slots_[kCapacity];
+  alignas(64) std::atomic<uint32_t> head_{0};
+  alignas(64) std::atomic<uint32_t> tail_{0};
+};
+
+CommandQueue s_commands;
+
+/// The decoded samples by slot, published by the worker that loaded them
+/// and read by the audio thread.
+std::atomic<SoLoud::Wav *> s_samples[kMaxSamples];
+unsigned s_sample_count = 0;
+
+/// The mixer and the device that runs it, opened by the first load. Only the
+/// audio thread touches the mixer while the device is open.
+std::mutex s_device_mutex;
+std::unique_ptr<SoLoud::Soloud> s_soloud;
+ma_device s_device;
+bool s_device_tried = false;
+std::atomic<bool> s_device_open{false};
+
+/// Callbacks of the loads in flight, by sample handle. Main thread only.
+std::unordered_map<unsigned, facebook::jsi::Function> s_callbacks{};
+
+void apply(const AudioCommand &command) {
+  switch (command.op) {
+  case AudioOp::Play:
+    // SoLoud allocates the voice's instance here, a small object
+    if (SoLoud::Wav *wav =
+            s_samples[command.sample].load(std::memory_order_acquire))
+      s_soloud->play(*wav, command.volume, command.pan);
+    break;
+  case AudioOp::StopAll:
+    s_soloud->stopAll();
+    break;
+  case AudioOp::SetVolume:
+    s_soloud->setGlobalVolume(command.volume);
+    break;
+  }
+}
+
+/// The device's callback, on its audio thread.
+void mix(ma_device *device, void *output, const void *, ma_uint32 frames) {
+  AudioCommand command;
+  while (s_commands.pop(command))
+    apply(command);
+  float *out = static_cast<float *>(output);
+  while (frames) {
+    unsigned n = std::min<unsigned>(frames, kMixChunk);
+    s_soloud->mix(out, n);
+    out += (size_t)n * device->playback.channels;
+    frames -= n;
+  }
+}
+
+/// Open the default output device and start mixing, once. A missing device
+/// isn't an error: samples still load, and play() does nothing.
+void open_device() {
+  std::lock_guard<std::mutex> lock(s_device_mutex);
+  if (s_device_tried)
+    return;
+  s_device_tried = true;
+
+  ma_device_config config = ma_device_config_init(ma_device_type_playback);
+  config.playback.format = ma_format_f32;
+  config.playback.channels = 2;
+  config.performanceProfile = ma_performance_profile_low_latency;
+  config.dataCallback = mix;
+  if (ma_device_init(nullptr, &config, &s_device) != MA_SUCCESS) {
+    fprintf(stderr, "audio: no output device, sounds are muted\n");
+    return;
+  }
+  auto soloud = std::make_unique<SoLoud::Soloud>();
+  unsigned period = std::max<unsigned>(
+      s_device.playback.internalPeriodSizeInFrames, SAMPLE_GRANULARITY);
+  if (soloud->init(SoLoud::Soloud::CLIP_ROUNDOFF, SoLoud::Soloud::NULLDRIVER,
+                   s_device.sampleRate, period,
+                   s_device.playback.channels) != SoLoud::SO_NO_ERROR) {
+    fprintf(stderr, "audio: can't mix for the output device\n");
+    ma_device_uninit(&s_device);
+    return;
+  }
+  s_soloud = std::move(soloud);
+  if (ma_device_start(&s_device) != MA_SUCCESS) {
+    fprintf(stderr, "audio: can't start the output device\n");
+    ma_device_uninit(&s_device);
+    s_soloud.reset();
+    return;
+  }
+  s_device_open.store(true, std::memory_order_release);
+}
+
+const char *load_error(SoLoud::result res) {
+  switch (res) {
+  case SoLoud::FILE_NOT_FOUND:
+    return "file not found";
+  case SoLoud::FILE_LOAD_FAILED:
+    return "not a WAV, MP3, FLAC or Ogg Vorbis file";
+  case SoLoud::OUT_OF_MEMORY:
+    return "out of memory";
+  default:
+    return "can't decode";
+  }
+}
+
+/// Pass the result of a load to its callback.
+void complete(facebook::jsi::Runtime &rt, unsigned handle,
+              const std::string &path, const char *error) {
+  auto it = s_callbacks.find(handle);
+  if (it == s_callbacks.end())
+    return;
+  facebook::jsi::Function callback = std::move(it->second);
+  s_callbacks.erase(it);
+  if (error) {
+    callback.call(rt, "audio: " + path + ": " + error,
+                  facebook::jsi::Value::undefined());
+  } else {
+    callback.call(rt, facebook::jsi::Value::null(), (double)handle);
+  }
+}
+
+bool push_command(const AudioCommand &command) {
+  return s_device_open.load(std::memory_order_acquire) &&
+         s_commands.push(command);
+}
+
+float number_arg(const facebook::jsi::Value *args, size_t count, size_t i,
+                 float fallback) {
+  return i < count && args[i].isNumber() ? (float)args[i].getNumber()
+                                         : fallback;
+}
+
+void set_function(facebook::jsi::Runtime &rt, const char *name,
+                  unsigned paramCount,
+                  facebook::jsi::HostFunctionType fn) {
+  rt.global().setProperty(
+      rt, name,
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, name), paramCount,
+          std::move(fn)));
+}
+
+} // namespace
+
+void install_audio(facebook::jsi::Runtime &rt, ThreadPool &pool,
+                   MainThreadPoster postToMain) {
+  set_function(
+      rt, "__audioLoad", 2,
+      [&pool, postToMain](facebook::jsi::Runtime &rt,
+                          const facebook::jsi::Value &,
+                          const facebook::jsi::Value *args,
+                          size_t count) -> facebook::jsi::Value {
+        if (count < 2 || !args[0].isString() || !args[1].isObject() ||
+            !args[1].getObject(rt).isFunction(rt)) {
+          throw facebook::jsi::JSError(
+              rt, "__audioLoad expects a path and a callback");
+        }
+        if (s_sample_count == kMaxSamples)
+          throw facebook::jsi::JSError(rt, "audio: too many samples loaded");
+        std::string path = args[0].getString(rt).utf8(rt);
+        unsigned handle = ++s_sample_count;
+        s_callbacks.emplace(handle, args[1].getObject(rt).getFunction(rt));
+
+        facebook::jsi::Runtime *rtp = &rt;
+        pool.post(
+            [rtp, handle, path, postToMain] {
+              open_device();
+              auto wav = std::make_unique<SoLoud::Wav>();
+              SoLoud::result res = wav->load(path.c_str());
+              const char *error = nullptr;
+              if (res == SoLoud::SO_NO_ERROR)
+                s_samples[handle - 1].store(wav.release(),
+                                            std::memory_order_release);
+              else
+                error = load_error(res);
+              postToMain([rtp, handle, path, error] {
+                complete(*rtp, handle, path, error);
+              });
+            },
+            {TaskPriority::Normal, TraceTaskAudio});
+        return facebook::jsi::Value::undefined();
+      });
+
+  set_function(rt, "__audioPlay", 3,
+               [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+                  const facebook::jsi::Value *args,
+                  size_t count) -> facebook::jsi::Value {
+                 double handle = count > 0 && args[0].isNumber()
+                                     ? args[0].getNumber()
+                                     : 0;
+                 if (!(handle >= 1 && handle <= s_sample_count))
+                   return false;
+                 return push_command({AudioOp::Play, (unsigned)handle - 1,
+                                      number_arg(args, count, 1, 1),
+                                      number_arg(args, count, 2, 0)});
+               });
+
+  set_function(rt, "__audioStopAll", 0,
+               [](facebook::jsi::Runtime &, const facebook::jsi::Value &,
+                  const facebook::jsi::Value *,
+                  size_t) -> facebook::jsi::Value {
+                 return push_command({AudioOp::StopAll, 0, 0, 0});
+               });
+
+  set_function(rt, "__audioSetVolume", 1,
+               [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+                  const facebook::jsi::Value *args,
+                  size_t count) -> facebook::jsi::Value {
+                 return push_command({AudioOp::SetVolume, 0,
+                                      number_arg(args, count, 0, 1), 0});
+               });
+}
+
+void shutdown_audio() {
+  std::lock_guard<std::mutex> lock(s_device_mutex);
+  if (s_device_open.exchange(false, std::memory_order_acq_rel))
+    ma_device_uninit(&s_device);
+  s_device_tried = false;
+  s_commands.clear();
+  // Before the mixer: a sample stops its voices in it
+  for (unsigned i = 0; i < s_sample_count; ++i)
+    delete s_samples[i].exchange(nullptr, std::memory_order_relaxed);
+  s_sample_count = 0;
+  s_soloud.reset();
+  s_callbacks.clear();
+}
@@ -0,0 +1,29 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include "AsyncFs.h"
+
+#include <hermes/hermes.h>
+
+/// Install the audio host functions behind jslib's audio:
+///
+/// - __audioLoad(path, callback) decodes the sound file `path` (WAV, MP3,
+///   FLAC or Ogg Vorbis) into memory on `pool`, and `postToMain` brings back
+///   `callback(message, handle)`, with a null message on success. The first
+///   load opens the output device.
+/// - __audioPlay(handle, volume, pan), __audioStopAll() and
+///   __audioSetVolume(volume) only push a command onto a lock-free queue and
+///   return whether it fit. The device's audio thread applies the queued
+///   commands at the start of each buffer it mixes, so a sound starts within
+///   one device period and JS never waits for the mixer's lock.
+///
+/// Samples stay loaded until shutdown_audio().
+void install_audio(facebook::jsi::Runtime &rt, ThreadPool &pool,
+                   MainThreadPoster postToMain);
+
+/// Close the device, free the samples and forget the callbacks of the loads
+/// in flight (see "Shutdown order" in ThreadPool.h).
+void shutdown_audio();
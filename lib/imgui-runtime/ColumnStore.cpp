@@ -0,0 +1,569 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "ColumnStore.h"
+
+#include "SharedBuffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct StoreColumn {
+  /// The createSharedArray() memory, `capacity` elements.
+  std::shared_ptr<SharedBuffer> buffer;
+  size_t elementSize;
+  /// The version of the last write to each block.
+  std::vector<uint64_t> blocks;
+};
+
+struct Store {
+  size_t capacity;
+  size_t rows = 0;
+  std::vector<StoreColumn> columns;
+  /// The version of the last write.
+  uint64_t version = 0;
+  /// Written to since the last delivery.
+  bool changed = false;
+};
+
+struct Selection {
+  unsigned store;
+  size_t first;
+  size_t count;
+  /// Column indices; empty for all of them.
+  std::vector<unsigned> columns;
+  /// The version last delivered to JS.
+  uint64_t version;
+};
+
+/// Guards the stores, the selections and s_posted; writes come from any
+/// thread.
+std::mutex s_mutex;
+std::unordered_map<unsigned, std::unique_ptr<Store>> s_stores;
+std::unordered_map<unsigned, Selection> s_selections;
+unsigned s_next_store = 1;
+unsigned s_next_selection = 1;
+/// A delivery is posted and hasn't run yet.
+bool s_posted = false;
+
+std::atomic<MainThreadPoster> s_post_to_main{nullptr};
+
+/// Main thread only.
+facebook::jsi::Runtime *s_runtime = nullptr;
+std::shared_ptr<facebook::jsi::Function> s_callback;
+
+void deliver();
+
+/// Stamp rows [first, first + count) of a column (-1: of all of them) with
+/// the store's next version. Holds s_mutex. Returns whether the caller must
+/// post the delivery once it has released the lock.
+bool stamp(Store &store, int column, size_t first, size_t count) {
+  if (count == 0)
+    return false;
+  uint64_t version = ++store.version;
+  size_t from = first / kStoreBlockRows;
+  size_t to = (first + count - 1) / kStoreBlockRows;
+  for (size_t c = 0; c < store.columns.size(); ++c) {
+    if (column >= 0 && (size_t)column != c)
+      continue;
+    std::vector<uint64_t> &blocks = store.columns[c].blocks;
+    std::fill(blocks.begin() + from, blocks.begin() + to + 1, version);
+  }
+  store.changed = true;
+  if (s_posted)
+    return false;
+  s_posted = true;
+  return true;
+}
+
+void post_delivery(bool post) {
+  if (!post)
+    return;
+  if (MainThreadPoster poster = s_post_to_main.load(std::memory_order_acquire))
+    poster(deliver);
+}
+
+/// The highest version of the blocks of a selection. Holds s_mutex.
+uint64_t selection_version(const Store &store, const Selection &selection) {
+  size_t end =
+      std::min(store.capacity,
+               selection.first + std::min(selection.count, store.capacity));
+  if (selection.first >= end)
+    return 0;
+  size_t from = selection.first / kStoreBlockRows;
+  size_t to = (end - 1) / kStoreBlockRows;
+  uint64_t version = 0;
+  auto scan = [&](const StoreColumn &column) {
+    for (size_t b = from; b <= to; ++b)
+      version = std::max(version, column.blocks[b]);
+  };
+  if (selection.columns.empty()) {
+    for (const StoreColumn &column : store.columns)
+      scan(column);
+  } else {
+    for (unsigned c : selection.columns)
+      scan(store.columns[c]);
+  }
+  return version;
+}
+
+/// Main thread: pass the selections whose version changed to JS.
+void deliver() {
+  std::vector<double> changes;
+  {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_posted = false;
+    for (auto &entry : s_selections) {
+      Selection &selection = entry.second;
+      auto it = s_stores.find(selection.store);
+      if (it == s_stores.end() || !it->second->changed)
+        continue;
+      uint64_t version = selection_version(*it->second, selection);
+      if (version == selection.version)
+        continue;
+      selection.version = version;
+      changes.push_back(entry.first);
+      changes.push_back((double)version);
+    }
+    for (auto &entry : s_stores)
+      entry.second->changed = false;
+  }
+  if (changes.empty() || !s_callback || !s_runtime)
+    return;
+  facebook::jsi::Runtime &rt = *s_runtime;
+  facebook::jsi::Array array(rt, changes.size());
+  for (size_t i = 0; i < changes.size(); ++i)
+    array.setValueAtIndex(rt, i, changes[i]);
+  // The callback may replace itself
+  std::shared_ptr<facebook::jsi::Function> callback = s_callback;
+  callback->call(rt, array);
+}
+
+size_t element_size(const std::string &type) {
+  if (type == "f64")
+    return 8;
+  if (type == "f32" || type == "i32" || type == "u32")
+    return 4;
+  return 0;
+}
+
+/// The store of args[0], under s_mutex.
+Store &store_arg(facebook::jsi::Runtime &rt, const facebook::jsi::Value *args,
+                 size_t count, const char *name) {
+  auto it = count > 0 && args[0].isNumber()
+                ? s_stores.find((unsigned)args[0].getNumber())
+                : s_stores.end();
+  if (it == s_stores.end())
+    throw facebook::jsi::JSError(rt, std::string(name) + ": closed store");
+  return *it->second;
+}
+
+size_t size_arg(const facebook::jsi::Value *args, size_t count, size_t i) {
+  if (i >= count || !args[i].isNumber() || !(args[i].getNumber() >= 0))
+    return 0;
+  return (size_t)args[i].getNumber();
+}
+
+/// The bytes of ArrayBuffer args[i] from args[i + 1] onwards, which must
+/// hold `bytes` bytes.
+const uint8_t *bytes_arg(facebook::jsi::Runtime &rt,
+                         const facebook::jsi::Value *args, size_t count,
+                         size_t i, size_t bytes, const char *name) {
+  if (i >= count || !args[i].isObject() ||
+      !args[i].getObject(rt).isArrayBuffer(rt))
+    throw facebook::jsi::JSError(rt,
+                                 std::string(name) + " expects an ArrayBuffer");
+  facebook::jsi::ArrayBuffer ab = args[i].getObject(rt).getArrayBuffer(rt);
+  size_t offset = size_arg(args, count, i + 1);
+  if (offset > ab.size(rt) || bytes > ab.size(rt) - offset)
+    throw facebook::jsi::JSError(rt, std::string(name) + ": bad range");
+  return ab.data(rt) + offset;
+}
+
+void check_rows(facebook::jsi::Runtime &rt, const Store &store, size_t first,
+                size_t count, const char *name) {
+  if (first > store.capacity || count > store.capacity - first)
+    throw facebook::jsi::JSError(
+        rt, std::string(name) + ": rows outside the store's capacity");
+}
+
+} // namespace
+
+void install_column_stores(facebook::jsi::Runtime &rt,
+                           MainThreadPoster postToMain) {
+  s_runtime = &rt;
+  s_post_to_main.store(postToMain, std::memory_order_release);
+
+  rt.global().setProperty(
+      rt, "__storeCreate",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__storeCreate"), 3,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count < 3 || !args[0].isNumber() || !args[1].isObject() ||
+                !args[2].isObject())
+              throw facebook::jsi::JSError(
+                  rt, "__storeCreate expects a capacity, buffers and types");
+            auto store = std::make_unique<Store>();
+            store->capacity = size_arg(args, count, 0);
+            facebook::jsi::Array handles = args[1].getObject(rt).getArray(rt);
+            facebook::jsi::Array types = args[2].getObject(rt).getArray(rt);
+            size_t blocks =
+                (store->capacity + kStoreBlockRows - 1) / kStoreBlockRows;
+            for (size_t i = 0; i < handles.size(rt); ++i) {
+              StoreColumn column;
+              column.elementSize = element_size(
+                  types.getValueAtIndex(rt, i).getString(rt).utf8(rt));
+              column.buffer = lock_shared_buffer(
+                  (int)handles.getValueAtIndex(rt, i).getNumber());
+              if (!column.elementSize || !column.buffer ||
+                  column.buffer->size() < store->capacity * column.elementSize)
+                throw facebook::jsi::JSError(
+                    rt, "__storeCreate: a column isn't a shared array of the "
+                        "store's capacity");
+              column.blocks.assign(blocks, 0);
+              store->columns.push_back(std::move(column));
+            }
+            std::lock_guard<std::mutex> lock(s_mutex);
+            unsigned id = s_next_store++;
+            s_stores.emplace(id, std::move(store));
+            return (double)id;
+          }));
+
+  rt.global().setProperty(
+      rt, "__storeWrite",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__storeWrite"), 6,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            bool post;
+            {
+              std::lock_guard<std::mutex> lock(s_mutex);
+              Store &store = store_arg(rt, args, count, "__storeWrite");
+              size_t column = size_arg(args, count, 1);
+              size_t first = size_arg(args, count, 2);
+              size_t n = size_arg(args, count, 5);
+              if (column >= store.columns.size())
+                throw facebook::jsi::JSError(rt, "__storeWrite: bad column");
+              check_rows(rt, store, first, n, "__storeWrite");
+              StoreColumn &col = store.columns[column];
+              const uint8_t *values = bytes_arg(
+                  rt, args, count, 3, n * col.elementSize, "__storeWrite");
+              memcpy(col.buffer->data() + first * col.elementSize, values,
+                     n * col.elementSize);
+              post = stamp(store, (int)column, first, n);
+            }
+            post_delivery(post);
+            return facebook::jsi::Value::undefined();
+          }));
+
+  rt.global().setProperty(
+      rt, "__storeUpdate",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__storeUpdate"), 7,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            bool post = false;
+            {
+              std::lock_guard<std::mutex> lock(s_mutex);
+              Store &store = store_arg(rt, args, count, "__storeUpdate");
+              size_t column = size_arg(args, count, 1);
+              size_t n = size_arg(args, count, 6);
+              if (column >= store.columns.size())
+                throw facebook::jsi::JSError(rt, "__storeUpdate: bad column");
+              StoreColumn &col = store.columns[column];
+              const uint8_t *rowBytes =
+                  bytes_arg(rt, args, count, 2, n * 4, "__storeUpdate");
+              const uint8_t *values = bytes_arg(
+                  rt, args, count, 4, n * col.elementSize, "__storeUpdate");
+              std::vector<uint32_t> rows(n);
+              memcpy(rows.data(), rowBytes, n * 4);
+              for (uint32_t row : rows) {
+                if (row >= store.capacity)
+                  throw facebook::jsi::JSError(
+                      rt, "__storeUpdate: rows outside the store's capacity");
+              }
+              if (n) {
+                uint64_t version = ++store.version;
+                for (size_t i = 0; i < n; ++i) {
+                  memcpy(col.buffer->data() + rows[i] * col.elementSize,
+                         values + i * col.elementSize, col.elementSize);
+                  col.blocks[rows[i] / kStoreBlockRows] = version;
+                }
+                store.changed = true;
+                post = !s_posted;
+                s_posted = true;
+              }
+            }
+            post_delivery(post);
+            return facebook::jsi::Value::undefined();
+          }));
+
+  rt.global().setProperty(
+      rt, "__storeAppend",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__storeAppend"), 4,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            bool post;
+            size_t first;
+            {
+              std::lock_guard<std::mutex> lock(s_mutex);
+              Store &store = store_arg(rt, args, count, "__storeAppend");
+              if (count < 4 || !args[1].isObject() || !args[2].isObject())
+                throw facebook::jsi::JSError(
+                    rt, "__storeAppend expects buffers and offsets");
+              facebook::jsi::Array buffers = args[1].getObject(rt).getArray(rt);
+              facebook::jsi::Array offsets = args[2].getObject(rt).getArray(rt);
+              size_t n = size_arg(args, count, 3);
+              first = store.rows;
+              check_rows(rt, store, first, n, "__storeAppend");
+              if (buffers.size(rt) != store.columns.size())
+                throw facebook::jsi::JSError(
+                    rt, "__storeAppend: one buffer per column");
+              for (size_t c = 0; c < store.columns.size(); ++c) {
+                StoreColumn &col = store.columns[c];
+                facebook::jsi::Value pair[2] = {buffers.getValueAtIndex(rt, c),
+                                                offsets.getValueAtIndex(rt, c)};
+                const uint8_t *values = bytes_arg(
+                    rt, pair, 2, 0, n * col.elementSize, "__storeAppend");
+                memcpy(col.buffer->data() + first * col.elementSize, values,
+                       n * col.elementSize);
+              }
+              store.rows += n;
+              post = stamp(store, -1, first, n);
+            }
+            post_delivery(post);
+            return (double)first;
+          }));
+
+  rt.global().setProperty(
+      rt, "__storeTouch",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__storeTouch"), 4,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            bool post;
+            {
+              std::lock_guard<std::mutex> lock(s_mutex);
+              Store &store = store_arg(rt, args, count, "__storeTouch");
+              int column = count > 1 && args[1].isNumber()
+                               ? (int)args[1].getNumber()
+                               : -1;
+              size_t first = size_arg(args, count, 2);
+              size_t n = size_arg(args, count, 3);
+              if (column >= (int)store.columns.size())
+                throw facebook::jsi::JSError(rt, "__storeTouch: bad column");
+              check_rows(rt, store, first, n, "__storeTouch");
+              post = stamp(store, column < 0 ? -1 : column, first, n);
+            }
+            post_delivery(post);
+            return facebook::jsi::Value::undefined();
+          }));
+
+  rt.global().setProperty(
+      rt, "__storeSetRowCount",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__storeSetRowCount"), 2,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            bool post;
+            {
+              std::lock_guard<std::mutex> lock(s_mutex);
+              Store &store = store_arg(rt, args, count, "__storeSetRowCount");
+              size_t rows = size_arg(args, count, 1);
+              check_rows(rt, store, 0, rows, "__storeSetRowCount");
+              // The rows that appeared or went away changed
+              size_t from = std::min(rows, store.rows);
+              size_t to = std::max(rows, store.rows);
+              store.rows = rows;
+              post = stamp(store, -1, from, to - from);
+            }
+            post_delivery(post);
+            return facebook::jsi::Value::undefined();
+          }));
+
+  rt.global().setProperty(
+      rt, "__storeRowCount",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__storeRowCount"), 1,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            return (double)store_arg(rt, args, count, "__storeRowCount")
+                .rows;
+          }));
+
+  rt.global().setProperty(
+      rt, "__storeSelect",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__storeSelect"), 4,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            Store &store = store_arg(rt, args, count, "__storeSelect");
+            Selection selection;
+            selection.store = (unsigned)args[0].getNumber();
+            selection.first = size_arg(args, count, 1);
+            // Infinity selects the rest of the store
+            double rows = count > 2 && args[2].isNumber() ? args[2].getNumber()
+                                                          : 0;
+            selection.count = rows >= (double)store.capacity
+                                  ? store.capacity
+                                  : size_arg(args, count, 2);
+            if (count > 3 && args[3].isObject()) {
+              facebook::jsi::Array columns = args[3].getObject(rt).getArray(rt);
+              for (size_t i = 0; i < columns.size(rt); ++i) {
+                double c = columns.getValueAtIndex(rt, i).getNumber();
+                if (!(c >= 0) || c >= (double)store.columns.size())
+                  throw facebook::jsi::JSError(rt, "__storeSelect: bad column");
+                selection.columns.push_back((unsigned)c);
+              }
+            }
+            selection.version = selection_version(store, selection);
+            unsigned id = s_next_selection++;
+            s_selections.emplace(id, std::move(selection));
+            return (double)id;
+          }));
+
+  rt.global().setProperty(
+      rt, "__storeSelectionVersion",
+      facebook::jsi::Function::createFromHostFunction(
+          rt,
+          facebook::jsi::PropNameID::forAscii(rt, "__storeSelectionVersion"),
+          1,
+          [](facebook::jsi::Runtime &, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            auto it = s_selections.find((unsigned)size_arg(args, count, 0));
+            return it == s_selections.end() ? 0.0
+                                            : (double)it->second.version;
+          }));
+
+  rt.global().setProperty(
+      rt, "__storeUnselect",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__storeUnselect"), 1,
+          [](facebook::jsi::Runtime &, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            s_selections.erase((unsigned)size_arg(args, count, 0));
+            return facebook::jsi::Value::undefined();
+          }));
+
+  rt.global().setProperty(
+      rt, "__storeOnChanges",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__storeOnChanges"), 1,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count > 0 && args[0].isObject() &&
+                args[0].getObject(rt).isFunction(rt))
+              s_callback = std::make_shared<facebook::jsi::Function>(
+                  args[0].getObject(rt).getFunction(rt));
+            else
+              s_callback.reset();
+            return facebook::jsi::Value::undefined();
+          }));
+
+  rt.global().setProperty(
+      rt, "__storeClose",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__storeClose"), 1,
+          [](facebook::jsi::Runtime &, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            unsigned id = (unsigned)size_arg(args, count, 0);
+            std::lock_guard<std::mutex> lock(s_mutex);
+            s_stores.erase(id);
+            for (auto it = s_selections.begin();
+                 it != s_selections.end();) {
+              if (it->second.store == id)
+                it = s_selections.erase(it);
+              else
+                ++it;
+            }
+            return facebook::jsi::Value::undefined();
+          }));
+}
+
+void shutdown_column_stores() {
+  s_post_to_main.store(nullptr, std::memory_order_release);
+  {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_stores.clear();
+    s_selections.clear();
+    s_posted = false;
+  }
+  s_callback.reset();
+  s_runtime = nullptr;
+}
+
+extern "C" long imgui_column_store_write(unsigned store, unsigned column,
+                                         size_t firstRow, const void *values,
+                                         size_t count) {
+  bool post;
+  {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    auto it = s_stores.find(store);
+    if (it == s_stores.end())
+      return -1;
+    Store &s = *it->second;
+    if (column >= s.columns.size() || firstRow > s.capacity ||
+        count > s.capacity - firstRow)
+      return -1;
+    StoreColumn &col = s.columns[column];
+    memcpy(col.buffer->data() + firstRow * col.elementSize, values,
+           count * col.elementSize);
+    post = stamp(s, (int)column, firstRow, count);
+  }
+  post_delivery(post);
+  return 0;
+}
+
+extern "C" long imgui_column_store_append(unsigned store,
+                                          const void *const *values,
+                                          size_t count) {
+  bool post;
+  size_t first;
+  {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    auto it = s_stores.find(store);
+    if (it == s_stores.end())
+      return -1;
+    Store &s = *it->second;
+    first = s.rows;
+    if (count > s.capacity - first)
+      return -1;
+    for (size_t c = 0; c < s.columns.size(); ++c) {
+      StoreColumn &col = s.columns[c];
+      memcpy(col.buffer->data() + first * col.elementSize, values[c],
+             count * col.elementSize);
+    }
+    s.rows += count;
+    post = stamp(s, -1, first, count);
+  }
+  post_delivery(post);
+  return (long)first;
+}
@@ -0,0 +1,71 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include "AsyncFs.h"
+
+#include <hermes/hermes.h>
+
+#include <cstddef>
+
+/// Rows per block of a column, the unit that writes are versioned in.
+constexpr size_t kStoreBlockRows = 1024;
+
+/// Observable column stores behind react-imgui-reconciler's
+/// createColumnStore() and useStoreSelector().
+///
+/// A store is a table of typed columns, each a createSharedArray() array of
+/// `capacity` elements, and a row count. Every write goes through the
+/// store, which stamps each column's blocks of kStoreBlockRows rows that it
+/// touched with the store's next version. A selection (a row range and
+/// some columns) is then at the highest version of the blocks it covers.
+///
+/// The first write after a delivery posts the next one, which compares the
+/// selections of the changed stores with the versions they were delivered
+/// at and passes only the changed ones to JS, so a component is woken only
+/// when the rows and columns it shows changed, at most once per frame,
+/// however many writes there were.
+///
+/// Host functions:
+///  - __storeCreate(capacity, handles, types) returns the ID of a store
+///    over the shared buffers `handles`, whose element types are 'f64',
+///    'f32', 'i32' or 'u32';
+///  - __storeWrite(id, column, firstRow, buffer, byteOffset, count) copies
+///    `count` elements into rows firstRow onwards;
+///  - __storeUpdate(id, column, rows, rowsOffset, values, valuesOffset,
+///    count) writes values[i] to row rows[i] (a Uint32Array);
+///  - __storeAppend(id, buffers, byteOffsets, count) writes `count` rows
+///    after the last, one buffer per column, and returns the first;
+///  - __storeTouch(id, column, firstRow, count) marks rows written in place
+///    as changed (column -1: all columns);
+///  - __storeSetRowCount(id, rows) and __storeRowCount(id);
+///  - __storeSelect(id, firstRow, count, columns) returns the ID of a
+///    selection; __storeSelectionVersion(selection) its version, and
+///    __storeUnselect(selection) drops it;
+///  - __storeOnChanges(callback) sets the delivery callback, which gets a
+///    flat array of selection IDs and their new versions;
+///  - __storeClose(id) drops a store and its selections.
+void install_column_stores(facebook::jsi::Runtime &rt,
+                           MainThreadPoster postToMain);
+
+/// Forget the stores and the callback. Must be called before the runtime
+/// is destroyed.
+void shutdown_column_stores();
+
+extern "C" {
+
+/// Write `count` elements of the column's type from `values` into rows
+/// `firstRow` onwards of column `column` of store `store` (its jslib
+/// `id`), from any thread, e.g. a native feed. Returns 0, or -1 if there is
+/// no such store or column or the rows are outside its capacity.
+long imgui_column_store_write(unsigned store, unsigned column, size_t firstRow,
+                              const void *values, size_t count);
+
+/// Append `count` rows, `values[c]` holding those of column c. Returns the
+/// first row, or -1 if there is no such store or no room.
+long imgui_column_store_append(unsigned store, const void *const *values,
+                               size_t count);
+
+} // extern "C"
@@ -0,0 +1,870 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "ColumnarParse.h"
+
+#include "MappedFileBuffer.h"
+#include "SharedBuffer.h"
+#include "ThreadPool.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+// Scanning. Fields and strings are scanned eight bytes at a time for the
+// bytes that end them, with the usual has-zero-byte bit trick on 64-bit
+// words: portable, and most of the speed of SSE for short fields.
+
+constexpr uint64_t kOnes = 0x0101010101010101ULL;
+constexpr uint64_t kHighs = 0x8080808080808080ULL;
+
+/// The high bit of every byte of `word` equal to `c`, and possibly of bytes
+/// above the first match; the lowest set bit is always exact.
+inline uint64_t match_byte(uint64_t word, char c) {
+  uint64_t x = word ^ (kOnes * (uint8_t)c);
+  return (x - kOnes) & ~x & kHighs;
+}
+
+/// The first byte of [p, end) equal to `a`, `b` or `c`, or `end`.
+const char *find_any(const char *p, const char *end, char a, char b, char c) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  while (end - p >= 8) {
+    uint64_t word;
+    memcpy(&word, p, 8);
+    uint64_t m =
+        match_byte(word, a) | match_byte(word, b) | match_byte(word, c);
+    if (m)
+      return p + (__builtin_ctzll(m) >> 3);
+    p += 8;
+  }
+#endif
+  while (p < end && *p != a && *p != b && *p != c)
+    ++p;
+  return p;
+}
+
+// Numbers.
+
+const double kPow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                         1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                         1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+/// Parse the decimal number `s[0, n)`, surrounded by optional blanks.
+/// Numbers of up to 15 significant digits and small exponents are exact
+/// without strtod(); the rest go through it.
+bool parse_number(const char *s, size_t n, double &out) {
+  const char *p = s, *end = s + n;
+  while (p < end && (*p == ' ' || *p == '\t'))
+    ++p;
+  while (end > p && (end[-1] == ' ' || end[-1] == '\t'))
+    --end;
+  const char *start = p;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+'))
+    negative = *p++ == '-';
+  uint64_t mantissa = 0;
+  int digits = 0, exponent = 0;
+  bool any = false;
+  for (; p < end && *p >= '0' && *p <= '9'; ++p, any = true) {
+    if (digits < 19) {
+      mantissa = mantissa * 10 + (*p - '0');
+      digits += mantissa != 0;
+    } else {
+      ++exponent;
+    }
+  }
+  if (p < end && *p == '.') {
+    for (++p; p < end && *p >= '0' && *p <= '9'; ++p, any = true) {
+      if (digits < 19) {
+        mantissa = mantissa * 10 + (*p - '0');
+        digits += mantissa != 0;
+        --exponent;
+      }
+    }
+  }
+  if (!any)
+    return false;
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    ++p;
+    bool negExp = false;
+    if (p < end && (*p == '-' || *p == '+'))
+      negExp = *p++ == '-';
+    if (p == end || *p < '0' || *p > '9')
+      return false;
+    int e = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p)
+      e = e < 100000 ? e * 10 + (*p - '0') : e;
+    exponent += negExp ? -e : e;
+  }
+  if (p != end)
+    return false;
+  if (digits <= 15 && exponent >= -22 && exponent <= 22) {
+    double value = (double)mantissa;
+    value = exponent < 0 ? value / kPow10[-exponent] : value * kPow10[exponent];
+    out = negative ? -value : value;
+    return true;
+  }
+  std::string copy(start, end);
+  out = strtod(copy.c_str(), nullptr);
+  return true;
+}
+
+// Columns.
+
+/// A column being filled: its value of the current row is pending until
+/// end_row(). A column typed by its first value holds the missing values
+/// before that one in `pendingMissing`.
+struct ColumnBuilder {
+  ParsedColumn *column;
+  bool untyped;
+  size_t pendingMissing = 0;
+  size_t lastRow = std::numeric_limits<size_t>::max();
+};
+
+class TableBuilder {
+public:
+  TableBuilder(const ParseOptions &options, ParsedTable &table)
+      : table_(table), infer_(options.columns.empty()) {
+    for (const auto &spec : options.columns)
+      add(spec.first, spec.second, false);
+  }
+
+  /// The index of the column `name`, or -1 if it isn't kept. Adds it when
+  /// every column is kept.
+  int find(const std::string &name) {
+    auto it = byName_.find(name);
+    if (it != byName_.end())
+      return it->second;
+    if (!infer_)
+      return -1;
+    int index = add(name, ColumnType::F64, true);
+    builders_[index].pendingMissing = table_.rows;
+    return index;
+  }
+
+  void text(int index, const char *s, size_t n) {
+    if (ColumnBuilder *b = claim(index))
+      put(*b, s, n);
+  }
+
+  void boolean(int index, bool value) {
+    ColumnBuilder *b = claim(index);
+    if (!b)
+      return;
+    if (b->column->type == ColumnType::String && !b->untyped)
+      put(*b, value ? "true" : "false", value ? 4 : 5);
+    else
+      put(*b, value ? "1" : "0", 1);
+  }
+
+  /// A null or nested value.
+  void none(int index) {
+    ColumnBuilder *b = claim(index);
+    if (!b)
+      return;
+    if (b->untyped)
+      ++b->pendingMissing;
+    else
+      missing(*b);
+  }
+
+  void end_row() {
+    for (ColumnBuilder &b : builders_) {
+      if (b.lastRow == table_.rows)
+        continue;
+      if (b.untyped)
+        ++b.pendingMissing;
+      else
+        missing(b);
+    }
+    ++table_.rows;
+  }
+
+  /// Columns that never got a value become F64. Returns false if a string
+  /// column overflowed.
+  bool finish() {
+    for (ColumnBuilder &b : builders_) {
+      if (b.untyped)
+        settle(b, ColumnType::F64);
+    }
+    return !tooLarge_;
+  }
+
+private:
+  int add(const std::string &name, ColumnType type, bool untyped) {
+    int index = (int)table_.columns.size();
+    table_.columns.emplace_back();
+    table_.columns.back().name = name;
+    table_.columns.back().type = type;
+    if (type == ColumnType::String)
+      table_.columns.back().offsets.push_back(0);
+    byName_.emplace(name, index);
+    // Column pointers are fixed up, as emplace_back() may have moved them
+    builders_.push_back(ColumnBuilder{nullptr, untyped});
+    for (size_t i = 0; i < builders_.size(); ++i)
+      builders_[i].column = &table_.columns[i];
+    return index;
+  }
+
+  void put(ColumnBuilder &b, const char *s, size_t n) {
+    ParsedColumn &col = *b.column;
+    if (n == 0 && (b.untyped || col.type != ColumnType::String)) {
+      if (b.untyped)
+        ++b.pendingMissing;
+      else
+        missing(b);
+      return;
+    }
+    double value = 0;
+    bool numeric = col.type != ColumnType::String && parse_number(s, n, value);
+    if (b.untyped)
+      settle(b, numeric ? ColumnType::F64 : ColumnType::String);
+    switch (col.type) {
+    case ColumnType::F64:
+      col.f64.push_back(numeric ? value : NAN);
+      break;
+    case ColumnType::I32:
+      col.i32.push_back(numeric && value >= INT32_MIN && value <= INT32_MAX
+                            ? (int32_t)value
+                            : 0);
+      break;
+    case ColumnType::String:
+      if (col.bytes.size() + n > UINT32_MAX) {
+        tooLarge_ = true;
+        n = 0;
+      }
+      col.bytes.insert(col.bytes.end(), s, s + n);
+      col.offsets.push_back((uint32_t)col.bytes.size());
+      break;
+    case ColumnType::Skip:
+      break;
+    }
+  }
+
+  /// The builder of column `index` if it hasn't got a value in this row;
+  /// a repeated key keeps its first value.
+  ColumnBuilder *claim(int index) {
+    if (index < 0 || (size_t)index >= builders_.size())
+      return nullptr;
+    ColumnBuilder &b = builders_[index];
+    if (b.lastRow == table_.rows)
+      return nullptr;
+    b.lastRow = table_.rows;
+    return &b;
+  }
+
+  void settle(ColumnBuilder &b, ColumnType type) {
+    b.untyped = false;
+    b.column->type = type;
+    if (type == ColumnType::String)
+      b.column->offsets.push_back(0);
+    for (; b.pendingMissing; --b.pendingMissing)
+      missing(b);
+  }
+
+  void missing(ColumnBuilder &b) {
+    ParsedColumn &col = *b.column;
+    switch (col.type) {
+    case ColumnType::F64:
+      col.f64.push_back(NAN);
+      break;
+    case ColumnType::I32:
+      col.i32.push_back(0);
+      break;
+    case ColumnType::String:
+      col.offsets.push_back((uint32_t)col.bytes.size());
+      break;
+    case ColumnType::Skip:
+      break;
+    }
+  }
+
+  ParsedTable &table_;
+  bool infer_;
+  bool tooLarge_ = false;
+  std::vector<ColumnBuilder> builders_;
+  std::unordered_map<std::string, int> byName_;
+};
+
+// CSV.
+
+/// One field at `p`, unquoting it into `scratch` if needed. Leaves `p` on
+/// the delimiter or line break after it, or at `end`.
+std::pair<const char *, size_t> csv_field(const char *&p, const char *end,
+                                          char delimiter,
+                                          std::string &scratch) {
+  if (p < end && *p == '"') {
+    scratch.clear();
+    ++p;
+    while (p < end) {
+      const char *q = find_any(p, end, '"', '"', '"');
+      scratch.append(p, q);
+      if (q == end) {
+        p = end;
+        break;
+      }
+      if (q + 1 < end && q[1] == '"') {
+        scratch.push_back('"');
+        p = q + 2;
+        continue;
+      }
+      p = q + 1;
+      break;
+    }
+    // Anything between the closing quote and the delimiter is dropped
+    p = find_any(p, end, delimiter, '\n', '\n');
+    return {scratch.data(), scratch.size()};
+  }
+  const char *start = p;
+  p = find_any(p, end, delimiter, '\n', '\n');
+  const char *stop = p;
+  if (stop > start && stop[-1] == '\r')
+    --stop;
+  return {start, (size_t)(stop - start)};
+}
+
+void parse_csv(const char *p, const char *end, const ParseOptions &options,
+               TableBuilder &builder) {
+  std::string scratch;
+  std::vector<int> fieldColumns;
+  auto column_of = [&](size_t field) {
+    while (fieldColumns.size() <= field)
+      fieldColumns.push_back(builder.find(std::to_string(fieldColumns.size())));
+    return fieldColumns[field];
+  };
+  // The header names the fields
+  if (options.header) {
+    while (p < end && *p != '\n') {
+      auto name = csv_field(p, end, options.delimiter, scratch);
+      fieldColumns.push_back(
+          builder.find(std::string(name.first, name.second)));
+      if (p < end && *p == options.delimiter)
+        ++p;
+    }
+    if (p < end)
+      ++p;
+  }
+  while (p < end) {
+    if (*p == '\n' || (*p == '\r' && p + 1 < end && p[1] == '\n')) {
+      // Blank line
+      p += *p == '\r' ? 2 : 1;
+      continue;
+    }
+    size_t field = 0;
+    for (;;) {
+      auto value = csv_field(p, end, options.delimiter, scratch);
+      int index = options.header ? (field < fieldColumns.size()
+                                        ? fieldColumns[field]
+                                        : -1)
+                                 : column_of(field);
+      builder.text(index, value.first, value.second);
+      ++field;
+      if (p < end && *p == options.delimiter) {
+        ++p;
+        continue;
+      }
+      break;
+    }
+    builder.end_row();
+    if (p < end)
+      ++p;
+  }
+}
+
+// JSON.
+
+class JsonParser {
+public:
+  JsonParser(const char *p, const char *end, TableBuilder &builder)
+      : start_(p), p_(p), end_(end), builder_(builder) {}
+
+  bool array() {
+    skip_ws();
+    if (!expect('['))
+      return false;
+    skip_ws();
+    if (p_ < end_ && *p_ == ']')
+      return true;
+    for (;;) {
+      if (!row())
+        return false;
+      skip_ws();
+      if (p_ < end_ && *p_ == ',') {
+        ++p_;
+        continue;
+      }
+      return expect(']');
+    }
+  }
+
+  bool lines() {
+    for (;;) {
+      skip_ws();
+      if (p_ == end_)
+        return true;
+      if (!row())
+        return false;
+    }
+  }
+
+  /// Where the input stopped making sense.
+  size_t offset() const { return (size_t)(p_ - start_); }
+
+private:
+  void skip_ws() {
+    while (p_ < end_ &&
+           (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t'))
+      ++p_;
+  }
+
+  bool expect(char c) {
+    skip_ws();
+    if (p_ == end_ || *p_ != c)
+      return false;
+    ++p_;
+    return true;
+  }
+
+  /// One object, a row.
+  bool row() {
+    skip_ws();
+    if (!expect('{'))
+      return false;
+    skip_ws();
+    if (p_ < end_ && *p_ == '}') {
+      ++p_;
+      builder_.end_row();
+      return true;
+    }
+    for (;;) {
+      skip_ws();
+      const char *key;
+      size_t keyLength;
+      if (!string(key, keyLength, keyScratch_))
+        return false;
+      int index = builder_.find(std::string(key, keyLength));
+      if (!expect(':') || !value(index))
+        return false;
+      skip_ws();
+      if (p_ < end_ && *p_ == ',') {
+        ++p_;
+        continue;
+      }
+      if (!expect('}'))
+        return false;
+      builder_.end_row();
+      return true;
+    }
+  }
+
+  bool value(int index) {
+    skip_ws();
+    if (p_ == end_)
+      return false;
+    switch (*p_) {
+    case '"': {
+      const char *s;
+      size_t n;
+      if (!string(s, n, valueScratch_))
+        return false;
+      builder_.text(index, s, n);
+      return true;
+    }
+    case '{':
+    case '[':
+      builder_.none(index);
+      return skip_nested();
+    case 't':
+    case 'f': {
+      bool truth = *p_ == 't';
+      if (!literal(truth ? "true" : "false"))
+        return false;
+      builder_.boolean(index, truth);
+      return true;
+    }
+    case 'n':
+      builder_.none(index);
+      return literal("null");
+    default: {
+      const char *s = p_;
+      while (p_ < end_ && ((*p_ >= '0' && *p_ <= '9') || *p_ == '-' ||
+                           *p_ == '+' || *p_ == '.' || *p_ == 'e' ||
+                           *p_ == 'E'))
+        ++p_;
+      if (p_ == s)
+        return false;
+      builder_.text(index, s, (size_t)(p_ - s));
+      return true;
+    }
+    }
+  }
+
+  bool literal(const char *word) {
+    size_t n = strlen(word);
+    if ((size_t)(end_ - p_) < n || memcmp(p_, word, n) != 0)
+      return false;
+    p_ += n;
+    return true;
+  }
+
+  /// The string at `p_`: in place if it has no escapes, otherwise decoded
+  /// into `scratch`.
+  bool string(const char *&s, size_t &n, std::string &scratch) {
+    if (p_ == end_ || *p_ != '"')
+      return false;
+    ++p_;
+    const char *q = find_any(p_, end_, '"', '\\', '"');
+    if (q < end_ && *q == '"') {
+      s = p_;
+      n = (size_t)(q - p_);
+      p_ = q + 1;
+      return true;
+    }
+    scratch.clear();
+    for (;;) {
+      scratch.append(p_, q);
+      p_ = q;
+      if (p_ == end_)
+        return false;
+      if (*p_ == '"') {
+        ++p_;
+        s = scratch.data();
+        n = scratch.size();
+        return true;
+      }
+      if (!escape(scratch))
+        return false;
+      q = find_any(p_, end_, '"', '\\', '"');
+    }
+  }
+
+  bool hex4(unsigned &code) {
+    if (end_ - p_ < 4)
+      return false;
+    code = 0;
+    for (int i = 0; i < 4; ++i, ++p_) {
+      char c = *p_;
+      code <<= 4;
+      if (c >= '0' && c <= '9')
+        code |= c - '0';
+      else if (c >= 'a' && c <= 'f')
+        code |= c - 'a' + 10;
+      else if (c >= 'A' && c <= 'F')
+        code |= c - 'A' + 10;
+      else
+        return false;
+    }
+    return true;
+  }
+
+  /// The escape at `p_` (a backslash), appended to `out` as UTF-8.
+  bool escape(std::string &out) {
+    if (end_ - p_ < 2)
+      return false;
+    char c = p_[1];
+    p_ += 2;
+    switch (c) {
+    case '"':
+    case '\\':
+    case '/':
+      out.push_back(c);
+      return true;
+    case 'b':
+      out.push_back('\b');
+      return true;
+    case 'f':
+      out.push_back('\f');
+      return true;
+    case 'n':
+      out.push_back('\n');
+      return true;
+    case 'r':
+      out.push_back('\r');
+      return true;
+    case 't':
+      out.push_back('\t');
+      return true;
+    case 'u':
+      break;
+    default:
+      return false;
+    }
+    unsigned code;
+    if (!hex4(code))
+      return false;
+    if (code >= 0xD800 && code < 0xDC00 && end_ - p_ >= 6 && p_[0] == '\\' &&
+        p_[1] == 'u') {
+      p_ += 2;
+      unsigned low;
+      if (!hex4(low))
+        return false;
+      if (low >= 0xDC00 && low < 0xE000)
+        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+      else
+        code = 0xFFFD;
+    } else if (code >= 0xD800 && code < 0xE000) {
+      code = 0xFFFD;
+    }
+    if (code < 0x80) {
+      out.push_back((char)code);
+    } else if (code < 0x800) {
+      out.push_back((char)(0xC0 | (code >> 6)));
+      out.push_back((char)(0x80 | (code & 0x3F)));
+    } else if (code < 0x10000) {
+      out.push_back((char)(0xE0 | (code >> 12)));
+      out.push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+      out.push_back((char)(0x80 | (code & 0x3F)));
+    } else {
+      out.push_back((char)(0xF0 | (code >> 18)));
+      out.push_back((char)(0x80 | ((code >> 12) & 0x3F)));
+      out.push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+      out.push_back((char)(0x80 | (code & 0x3F)));
+    }
+    return true;
+  }
+
+  /// Skip the object or array at `p_`.
+  bool skip_nested() {
+    int depth = 0;
+    while (p_ < end_) {
+      char c = *p_;
+      if (c == '"') {
+        const char *s;
+        size_t n;
+        if (!string(s, n, valueScratch_))
+          return false;
+        continue;
+      }
+      ++p_;
+      if (c == '{' || c == '[')
+        ++depth;
+      else if ((c == '}' || c == ']') && --depth == 0)
+        return true;
+    }
+    return false;
+  }
+
+  const char *start_;
+  const char *p_;
+  const char *end_;
+  TableBuilder &builder_;
+  std::string keyScratch_, valueScratch_;
+};
+
+template <typename T>
+facebook::jsi::ArrayBuffer to_array_buffer(facebook::jsi::Runtime &rt,
+                                           std::vector<T> &items) {
+  auto buffer = std::make_shared<VectorBuffer<T>>(std::move(items));
+  // Workers can be handed the columns without a copy
+  register_transferable_buffer(buffer, false);
+  return facebook::jsi::ArrayBuffer(rt, std::move(buffer));
+}
+
+const char *type_name(ColumnType type) {
+  switch (type) {
+  case ColumnType::F64:
+    return "f64";
+  case ColumnType::I32:
+    return "i32";
+  case ColumnType::String:
+    return "string";
+  case ColumnType::Skip:
+    break;
+  }
+  return "skip";
+}
+
+/// A parse in flight, filled in by a worker.
+struct ParseJob {
+  std::string path;
+  std::shared_ptr<facebook::jsi::MutableBuffer> input;
+  ParseOptions options;
+  ParsedTable table;
+  std::string error;
+};
+
+/// Callbacks of the parses in flight, by request ID. Main thread only.
+std::unordered_map<unsigned, facebook::jsi::Function> s_callbacks{};
+unsigned s_next_request = 1;
+
+void run_parse(ParseJob &job) {
+  std::shared_ptr<facebook::jsi::Buffer> file;
+  const char *data;
+  size_t size;
+  if (job.input) {
+    data = reinterpret_cast<const char *>(job.input->data());
+    size = job.input->size();
+  } else {
+    try {
+      MapFileOptions mapOptions;
+      mapOptions.sequential = true;
+      file = mapFileBuffer(job.path.c_str(), false, &mapOptions);
+    } catch (const std::exception &) {
+      job.error = "can't open file '" + job.path + "'";
+      return;
+    }
+    data = reinterpret_cast<const char *>(file->data());
+    size = file->size();
+  }
+  parse_columns(data, size, job.options, job.table, job.error);
+}
+
+/// Convert the table of a parse to JS and pass it to its callback.
+void complete(facebook::jsi::Runtime &rt, unsigned id, ParseJob &job) {
+  auto it = s_callbacks.find(id);
+  if (it == s_callbacks.end())
+    return;
+  facebook::jsi::Function callback = std::move(it->second);
+  s_callbacks.erase(it);
+
+  if (!job.error.empty()) {
+    callback.call(rt, "parseColumns: " + job.error);
+    return;
+  }
+  size_t count = job.table.columns.size();
+  facebook::jsi::Array names(rt, count), types(rt, count);
+  std::vector<facebook::jsi::Value> buffers;
+  for (size_t i = 0; i < count; ++i) {
+    ParsedColumn &col = job.table.columns[i];
+    names.setValueAtIndex(rt, i,
+                          facebook::jsi::String::createFromUtf8(rt, col.name));
+    types.setValueAtIndex(
+        rt, i, facebook::jsi::String::createFromAscii(rt, type_name(col.type)));
+    switch (col.type) {
+    case ColumnType::F64:
+      buffers.emplace_back(to_array_buffer(rt, col.f64));
+      break;
+    case ColumnType::I32:
+      buffers.emplace_back(to_array_buffer(rt, col.i32));
+      break;
+    case ColumnType::String:
+      buffers.emplace_back(to_array_buffer(rt, col.offsets));
+      buffers.emplace_back(to_array_buffer(rt, col.bytes));
+      break;
+    case ColumnType::Skip:
+      break;
+    }
+  }
+  facebook::jsi::Array buffersArray(rt, buffers.size());
+  for (size_t i = 0; i < buffers.size(); ++i)
+    buffersArray.setValueAtIndex(rt, i, std::move(buffers[i]));
+  callback.call(rt, facebook::jsi::Value::null(), (double)job.table.rows,
+                names, types, buffersArray);
+}
+
+ColumnType parse_type(const std::string &name) {
+  if (name == "i32")
+    return ColumnType::I32;
+  if (name == "string")
+    return ColumnType::String;
+  return ColumnType::F64;
+}
+
+} // namespace
+
+bool parse_columns(const char *data, size_t size, const ParseOptions &options,
+                   ParsedTable &table, std::string &error) {
+  TableBuilder builder(options, table);
+  const char *end = data + size;
+  // A UTF-8 byte order mark
+  if (size >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+    data += 3;
+  if (options.format == TableFormat::Csv) {
+    parse_csv(data, end, options, builder);
+  } else {
+    JsonParser parser(data, end, builder);
+    bool ok = options.format == TableFormat::Json ? parser.array()
+                                                  : parser.lines();
+    if (!ok) {
+      error = "JSON syntax error at byte " + std::to_string(parser.offset());
+      return false;
+    }
+  }
+  if (!builder.finish()) {
+    error = "a string column is larger than 4 GiB";
+    return false;
+  }
+  return true;
+}
+
+void install_columnar_parse(facebook::jsi::Runtime &rt, ThreadPool &pool,
+                            MainThreadPoster postToMain) {
+  rt.global().setProperty(
+      rt, "__parseColumns",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__parseColumns"), 7,
+          [&pool, postToMain](facebook::jsi::Runtime &rt,
+                              const facebook::jsi::Value &,
+                              const facebook::jsi::Value *args,
+                              size_t count) -> facebook::jsi::Value {
+            if (count < 7 || !args[1].isString() || !args[2].isString() ||
+                !args[6].isObject() || !args[6].getObject(rt).isFunction(rt)) {
+              throw facebook::jsi::JSError(
+                  rt, "__parseColumns expects a source, the options and a "
+                      "callback");
+            }
+            auto job = std::make_shared<ParseJob>();
+            if (args[0].isString()) {
+              job->path = args[0].getString(rt).utf8(rt);
+            } else if (args[0].isObject() &&
+                       args[0].getObject(rt).isArrayBuffer(rt)) {
+              facebook::jsi::ArrayBuffer ab =
+                  args[0].getObject(rt).getArrayBuffer(rt);
+              // The JS heap may move or free its own memory
+              job->input = shared_buffer_for_message(rt, ab, false);
+            } else {
+              throw facebook::jsi::JSError(
+                  rt, "parseColumns expects a path or an ArrayBuffer");
+            }
+
+            std::string format = args[1].getString(rt).utf8(rt);
+            if (format == "json")
+              job->options.format = TableFormat::Json;
+            else if (format == "ndjson")
+              job->options.format = TableFormat::Ndjson;
+            else if (format != "csv")
+              throw facebook::jsi::JSError(
+                  rt, "parseColumns: unknown format " + format);
+            std::string delimiter = args[2].getString(rt).utf8(rt);
+            if (delimiter.size() != 1 || delimiter[0] == '"' ||
+                delimiter[0] == '\n')
+              throw facebook::jsi::JSError(
+                  rt, "parseColumns: the delimiter must be one character");
+            job->options.delimiter = delimiter[0];
+            job->options.header = !args[3].isBool() || args[3].getBool();
+            if (args[4].isObject() && args[4].getObject(rt).isArray(rt) &&
+                args[5].isObject() && args[5].getObject(rt).isArray(rt)) {
+              facebook::jsi::Array names = args[4].getObject(rt).getArray(rt);
+              facebook::jsi::Array types = args[5].getObject(rt).getArray(rt);
+              size_t n = std::min(names.size(rt), types.size(rt));
+              for (size_t i = 0; i < n; ++i) {
+                job->options.columns.emplace_back(
+                    names.getValueAtIndex(rt, i).asString(rt).utf8(rt),
+                    parse_type(
+                        types.getValueAtIndex(rt, i).asString(rt).utf8(rt)));
+              }
+            }
+
+            unsigned id = s_next_request++;
+            s_callbacks.emplace(id, args[6].getObject(rt).getFunction(rt));
+
+            facebook::jsi::Runtime *rtp = &rt;
+            pool.post(
+                [rtp, id, job, postToMain] {
+                  run_parse(*job);
+                  // The input isn't needed any more
+                  job->input.reset();
+                  postToMain([rtp, id, job] { complete(*rtp, id, *job); });
+                },
+                {TaskPriority::Normal, TraceTaskParse});
+            return facebook::jsi::Value::undefined();
+          }));
+}
+
+void shutdown_columnar_parse() { s_callbacks.clear(); }
@@ -0,0 +1,72 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include "AsyncFs.h"
+
+#include <hermes/hermes.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// The type of a parsed column.
+enum class ColumnType { F64, I32, String, Skip };
+
+/// A column of a table parsed by parse_columns(). Missing and unparsable
+/// values are NaN (F64), 0 (I32) or "" (String).
+struct ParsedColumn {
+  std::string name;
+  ColumnType type = ColumnType::F64;
+  std::vector<double> f64;
+  std::vector<int32_t> i32;
+  /// String: row i is bytes[offsets[i], offsets[i + 1]), UTF-8.
+  std::vector<uint32_t> offsets;
+  std::vector<uint8_t> bytes;
+};
+
+enum class TableFormat { Csv, Json, Ndjson };
+
+struct ParseOptions {
+  TableFormat format = TableFormat::Csv;
+  /// CSV field separator.
+  char delimiter = ',';
+  /// CSV: whether the first row holds the column names; otherwise the
+  /// columns are "0", "1", ...
+  bool header = true;
+  /// The columns to keep and their types, in the order given. When empty,
+  /// every column is kept, typed by its first value: F64 for numbers (and
+  /// booleans), String otherwise.
+  std::vector<std::pair<std::string, ColumnType>> columns;
+};
+
+struct ParsedTable {
+  size_t rows = 0;
+  std::vector<ParsedColumn> columns;
+};
+
+/// Parse CSV, a JSON array of flat objects or newline-delimited JSON
+/// objects in `data[0, size)` into columns. Nested values are taken as
+/// missing. Returns false, with the reason in `error`, on malformed JSON or
+/// a string column over 4 GiB. Safe to call from any thread.
+bool parse_columns(const char *data, size_t size, const ParseOptions &options,
+                   ParsedTable &table, std::string &error);
+
+/// Install the __parseColumns(source, format, delimiter, header, names,
+/// types, callback) host function behind jslib's parseColumns(). `source` is
+/// a path, mapped on `pool`, or an ArrayBuffer, which the parse gets a
+/// native copy of (a shared buffer's own memory). The rest are the
+/// ParseOptions, with the columns as parallel arrays of names and 'f64',
+/// 'i32' or 'string'. The parse runs on `pool`; `postToMain` brings the
+/// table back, as `callback(message, rows, names, types, buffers)`: one
+/// ArrayBuffer per F64 and I32 column and two (offsets, bytes) per String
+/// column, over the parsed vectors without a copy.
+void install_columnar_parse(facebook::jsi::Runtime &rt, ThreadPool &pool,
+                            MainThreadPoster postToMain);
+
+/// Forget the callbacks of the parses in flight (see "Shutdown order" in
+/// ThreadPool.h).
+void shutdown_columnar_parse();
@@ -0,0 +1,270 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "CompressedTexture.h"
+
+#include "MappedFileBuffer.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <strings.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace {
+
+/// The formats variants are made in, most preferred first, with the file
+/// name suffix of add_react_imgui_app(TEXTURE_FORMATS ...).
+struct VariantFormat {
+  const char *suffix;
+  sg_pixel_format format;
+};
+constexpr VariantFormat kVariantFormats[] = {
+    {"bc7", SG_PIXELFORMAT_BC7_RGBA},
+    {"etc2", SG_PIXELFORMAT_ETC2_RGBA8},
+    {"bc3", SG_PIXELFORMAT_BC3_RGBA},
+    {"bc1", SG_PIXELFORMAT_BC1_RGBA},
+};
+
+/// The formats of the files we take, by sg_pixel_format, that the backend
+/// samples. Written once by init_compressed_texture_formats(), read by the
+/// workers.
+std::atomic<bool> s_supported[_SG_PIXELFORMAT_NUM];
+
+std::vector<std::pair<std::string, std::string>> &variant_dirs() {
+  static std::vector<std::pair<std::string, std::string>> dirs;
+  return dirs;
+}
+
+uint32_t read32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, 4);
+  return v;
+}
+
+uint64_t read64(const uint8_t *p) {
+  uint64_t v;
+  memcpy(&v, p, 8);
+  return v;
+}
+
+/// Bytes of a `width` x `height` level, 0 for formats we don't take.
+size_t level_size(sg_pixel_format format, int width, int height) {
+  size_t blocks = (size_t)((width + 3) / 4) * ((height + 3) / 4);
+  switch (format) {
+  case SG_PIXELFORMAT_BC1_RGBA:
+  case SG_PIXELFORMAT_ETC2_RGB8:
+  case SG_PIXELFORMAT_ETC2_RGB8A1:
+    return blocks * 8;
+  case SG_PIXELFORMAT_BC3_RGBA:
+  case SG_PIXELFORMAT_BC7_RGBA:
+  case SG_PIXELFORMAT_ETC2_RGBA8:
+    return blocks * 16;
+  default:
+    return 0;
+  }
+}
+
+/// The sokol format of a Vulkan format in a KTX2 file. The sRGB formats
+/// map to the plain ones: like the RGBA8 images, the pixels are drawn as
+/// stored.
+sg_pixel_format ktx2_format(uint32_t vkFormat) {
+  switch (vkFormat) {
+  case 133: // VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+  case 134: // VK_FORMAT_BC1_RGBA_SRGB_BLOCK
+    return SG_PIXELFORMAT_BC1_RGBA;
+  case 137: // VK_FORMAT_BC3_UNORM_BLOCK
+  case 138: // VK_FORMAT_BC3_SRGB_BLOCK
+    return SG_PIXELFORMAT_BC3_RGBA;
+  case 145: // VK_FORMAT_BC7_UNORM_BLOCK
+  case 146: // VK_FORMAT_BC7_SRGB_BLOCK
+    return SG_PIXELFORMAT_BC7_RGBA;
+  case 147: // VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK
+  case 148: // VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK
+    return SG_PIXELFORMAT_ETC2_RGB8;
+  case 149: // VK_FORMAT_ETC2_R8G8B8A1_UNORM_BLOCK
+  case 150: // VK_FORMAT_ETC2_R8G8B8A1_SRGB_BLOCK
+    return SG_PIXELFORMAT_ETC2_RGB8A1;
+  case 151: // VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK
+  case 152: // VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK
+    return SG_PIXELFORMAT_ETC2_RGBA8;
+  default:
+    return SG_PIXELFORMAT_NONE;
+  }
+}
+
+/// The sokol format of a DXGI format in a DDS DX10 header.
+sg_pixel_format dxgi_format(uint32_t dxgiFormat) {
+  switch (dxgiFormat) {
+  case 71: // DXGI_FORMAT_BC1_UNORM
+  case 72: // DXGI_FORMAT_BC1_UNORM_SRGB
+    return SG_PIXELFORMAT_BC1_RGBA;
+  case 77: // DXGI_FORMAT_BC3_UNORM
+  case 78: // DXGI_FORMAT_BC3_UNORM_SRGB
+    return SG_PIXELFORMAT_BC3_RGBA;
+  case 98: // DXGI_FORMAT_BC7_UNORM
+  case 99: // DXGI_FORMAT_BC7_UNORM_SRGB
+    return SG_PIXELFORMAT_BC7_RGBA;
+  default:
+    return SG_PIXELFORMAT_NONE;
+  }
+}
+
+constexpr uint8_t kKtx2Identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32,
+                                         0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+/// Find the format, size and top level of a KTX2 file.
+const char *parse_ktx2(const uint8_t *data, size_t size,
+                       CompressedTexture &texture, size_t &offset) {
+  // Identifier, header and the first level index entry
+  if (size < 104)
+    return "truncated KTX2 header";
+  if (read32(data + 44) != 0)
+    return "supercompressed KTX2 files (Basis, zstd) aren't supported";
+  if (read32(data + 28) > 1 || read32(data + 32) > 1 || read32(data + 36) != 1)
+    return "only 2D KTX2 textures are supported";
+  texture.format = ktx2_format(read32(data + 12));
+  if (texture.format == SG_PIXELFORMAT_NONE)
+    return "unsupported KTX2 format";
+  texture.width = (int)read32(data + 20);
+  texture.height = (int)read32(data + 24);
+  offset = read64(data + 80);
+  return nullptr;
+}
+
+/// Find the format, size and top level of a DDS file.
+const char *parse_dds(const uint8_t *data, size_t size,
+                      CompressedTexture &texture, size_t &offset) {
+  if (size < 128 || read32(data + 4) != 124)
+    return "truncated DDS header";
+  texture.height = (int)read32(data + 12);
+  texture.width = (int)read32(data + 16);
+  offset = 128;
+  const uint8_t *fourCC = data + 84;
+  if (memcmp(fourCC, "DXT1", 4) == 0) {
+    texture.format = SG_PIXELFORMAT_BC1_RGBA;
+  } else if (memcmp(fourCC, "DXT5", 4) == 0) {
+    texture.format = SG_PIXELFORMAT_BC3_RGBA;
+  } else if (memcmp(fourCC, "DX10", 4) == 0) {
+    if (size < 148)
+      return "truncated DDS header";
+    // 2D texture, one element
+    if (read32(data + 132) != 3 || read32(data + 140) > 1)
+      return "only 2D DDS textures are supported";
+    texture.format = dxgi_format(read32(data + 128));
+    offset = 148;
+  }
+  if (texture.format == SG_PIXELFORMAT_NONE)
+    return "unsupported DDS format";
+  return nullptr;
+}
+
+bool readable(const std::string &path) {
+  return access(path.c_str(), R_OK) == 0;
+}
+
+/// The first `<stem>.<format>.ktx2` or `.dds` of a supported format.
+std::string find_variant(const std::string &stem) {
+  for (const VariantFormat &variant : kVariantFormats) {
+    if (!compressed_texture_supported(variant.format))
+      continue;
+    std::string base = stem + "." + variant.suffix;
+    if (readable(base + ".ktx2"))
+      return base + ".ktx2";
+    if (readable(base + ".dds"))
+      return base + ".dds";
+  }
+  return {};
+}
+
+} // namespace
+
+bool is_compressed_texture_path(const std::string &path) {
+  auto endsWith = [&](const char *ext) {
+    size_t n = strlen(ext);
+    return path.size() >= n &&
+           strcasecmp(path.c_str() + path.size() - n, ext) == 0;
+  };
+  return endsWith(".ktx2") || endsWith(".dds");
+}
+
+std::shared_ptr<CompressedTexture>
+load_compressed_texture(const char *path, const char *&failure) {
+  auto texture = std::make_shared<CompressedTexture>();
+  try {
+    texture->file = mapFileBuffer(path);
+  } catch (const std::exception &) {
+    failure = "can't open file";
+    return nullptr;
+  }
+  const uint8_t *data = texture->file->data();
+  size_t size = texture->file->size();
+  size_t offset = 0;
+  if (size >= 12 && memcmp(data, kKtx2Identifier, 12) == 0)
+    failure = parse_ktx2(data, size, *texture, offset);
+  else if (size >= 4 && memcmp(data, "DDS ", 4) == 0)
+    failure = parse_dds(data, size, *texture, offset);
+  else
+    failure = "not a KTX2 or DDS file";
+  if (failure)
+    return nullptr;
+
+  size_t levelSize = level_size(texture->format, texture->width,
+                                texture->height);
+  if (texture->width <= 0 || texture->height <= 0 || offset > size ||
+      size - offset < levelSize) {
+    failure = "truncated texture data";
+    return nullptr;
+  }
+  texture->level = {.ptr = data + offset, .size = levelSize};
+  return texture;
+}
+
+void init_compressed_texture_formats() {
+  for (sg_pixel_format format :
+       {SG_PIXELFORMAT_BC1_RGBA, SG_PIXELFORMAT_BC3_RGBA,
+        SG_PIXELFORMAT_BC7_RGBA, SG_PIXELFORMAT_ETC2_RGB8,
+        SG_PIXELFORMAT_ETC2_RGB8A1, SG_PIXELFORMAT_ETC2_RGBA8})
+    s_supported[format].store(sg_query_pixelformat(format).sample,
+                              std::memory_order_release);
+}
+
+bool compressed_texture_supported(sg_pixel_format format) {
+  return s_supported[format].load(std::memory_order_acquire);
+}
+
+void add_texture_variant_dir(const char *sourceDir, const char *variantDir) {
+  variant_dirs().emplace_back(sourceDir, variantDir);
+}
+
+std::string compressed_texture_variant(const std::string &path) {
+  if (is_compressed_texture_path(path))
+    return path;
+  std::filesystem::path file(path);
+  std::string stem = file.replace_extension().string();
+  if (std::string variant = find_variant(stem); !variant.empty())
+    return variant;
+  if (variant_dirs().empty())
+    return {};
+
+  std::error_code ec;
+  std::string absolute =
+      std::filesystem::absolute(stem, ec).lexically_normal().string();
+  if (ec)
+    return {};
+  for (const auto &[sourceDir, variantDir] : variant_dirs()) {
+    if (absolute.size() > sourceDir.size() &&
+        absolute.compare(0, sourceDir.size(), sourceDir) == 0 &&
+        absolute[sourceDir.size()] == '/') {
+      std::string variant =
+          find_variant(variantDir + absolute.substr(sourceDir.size()));
+      if (!variant.empty())
+        return variant;
+    }
+  }
+  return {};
+}
@@ -0,0 +1,50 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include "sokol_gfx.h"
+
+#include <hermes/hermes.h>
+
+#include <memory>
+#include <string>
+
+/// A block-compressed texture (BC1, BC3, BC7 or ETC2) read from a KTX2 or
+/// DDS file, uploaded as is instead of being decoded to RGBA8. Only the top
+/// mip level is kept: the image sampler doesn't filter between levels.
+struct CompressedTexture {
+  sg_pixel_format format = SG_PIXELFORMAT_NONE;
+  int width = 0, height = 0;
+  /// The top level, in `file`.
+  sg_range level = {};
+  std::shared_ptr<facebook::jsi::Buffer> file;
+};
+
+/// Whether `path` names a KTX2 or DDS file.
+bool is_compressed_texture_path(const std::string &path);
+
+/// Map the KTX2 or DDS file at `path`. Returns null, with the reason in
+/// `failure`, if it can't be read or its format isn't one of the above.
+/// Safe to call from any thread.
+std::shared_ptr<CompressedTexture>
+load_compressed_texture(const char *path, const char *&failure);
+
+/// Record which compressed formats the backend can sample. Render thread,
+/// after sg_setup(); until then (and in headless runs) no variants are
+/// picked.
+void init_compressed_texture_formats();
+/// Whether the backend samples `format`. Safe to call from any thread.
+bool compressed_texture_supported(sg_pixel_format format);
+
+/// Variants of images under `sourceDir` are looked up under `variantDir`,
+/// at the same relative path. Called by the generated <target>-units.cpp
+/// (add_react_imgui_app(TEXTURES ...)) during static initialization.
+void add_texture_variant_dir(const char *sourceDir, const char *variantDir);
+
+/// The compressed file to load in place of image `path`, or "" to decode
+/// `path` itself: `path` if it is a KTX2 or DDS file, otherwise the first
+/// `<stem>.<format>.ktx2` or `.dds` of a supported format, next to `path`
+/// or in its variant dir. Safe to call from any thread.
+std::string compressed_texture_variant(const std::string &path);
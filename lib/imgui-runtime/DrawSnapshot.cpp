@@ -0,0 +1,73 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "DrawSnapshot.h"
+
+#include <cstring>
+#include <utility>
+
+namespace {
+
+/// Copy an ImVector of trivially copyable elements, growing `dst` with
+/// ImGui's allocator (which the owning ImDrawList frees) only if needed.
+template <typename V> void copy_vector(V &dst, const V &src) {
+  if (dst.Capacity < src.Size) {
+    igMemFree(dst.Data);
+    dst.Data = static_cast<decltype(dst.Data)>(
+        igMemAlloc((size_t)src.Size * sizeof(*src.Data)));
+    dst.Capacity = src.Size;
+  }
+  if (src.Size)
+    memcpy(dst.Data, src.Data, (size_t)src.Size * sizeof(*src.Data));
+  dst.Size = src.Size;
+}
+
+} // namespace
+
+DrawSnapshot::DrawSnapshot() = default;
+
+DrawSnapshot::~DrawSnapshot() {
+  for (ImDrawList *list : lists_)
+    ImDrawList_destroy(list);
+}
+
+void DrawSnapshot::capture(const ImDrawData *src) {
+  int count = src && src->Valid ? src->CmdListsCount : 0;
+  while ((int)lists_.size() < count)
+    lists_.push_back(ImDrawList_ImDrawList(igGetDrawListSharedData()));
+
+  for (int i = 0; i < count; ++i) {
+    const ImDrawList *from = src->CmdLists.Data[i];
+    ImDrawList *to = lists_[i];
+    copy_vector(to->CmdBuffer, from->CmdBuffer);
+    copy_vector(to->IdxBuffer, from->IdxBuffer);
+    copy_vector(to->VtxBuffer, from->VtxBuffer);
+  }
+
+  drawData_ = src ? *src : ImDrawData{};
+  drawData_.Valid = count > 0;
+  drawData_.CmdListsCount = count;
+  // The vector is only read through, never grown, so it can point into
+  // lists_ directly.
+  drawData_.CmdLists.Size = count;
+  drawData_.CmdLists.Capacity = count;
+  drawData_.CmdLists.Data = lists_.data();
+  // The viewport belongs to the ImGui context.
+  drawData_.OwnerViewport = nullptr;
+}
+
+void DrawSnapshotQueue::publish() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::swap(back_, ready_);
+  fresh_ = true;
+}
+
+DrawSnapshot *DrawSnapshotQueue::acquire() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!fresh_)
+    return nullptr;
+  std::swap(front_, ready_);
+  fresh_ = false;
+  return &slots_[front_];
+}
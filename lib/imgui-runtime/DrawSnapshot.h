@@ -0,0 +1,96 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#ifndef CIMGUI_DEFINE_ENUMS_AND_STRUCTS
+#define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
+#endif
+#include "cimgui.h"
+
+#include "PerfHud.h"
+
+#include <mutex>
+#include <vector>
+
+/// Values shown by the stats overlay, computed by the thread that runs JS.
+struct OverlayStats {
+  double fps = 0;
+  int deferredTasks = 0;
+  int budgetOverruns = 0;
+  /// Host config mutations and duration of the last React commit.
+  int commitMutations = 0;
+  double commitMs = 0;
+  /// Hermes heap at the end of the frame.
+  double heapAllocated = 0;
+  double heapSize = 0;
+  int gcCount = 0;
+  /// Native memory shown on the HUD's memory line (see MemoryStats), only
+  /// filled in while the HUD is visible.
+  double textureBytes = 0;
+  double drawListBytes = 0;
+  double fontAtlasBytes = 0;
+  double bundleBytes = 0;
+};
+
+/// A copy of everything needed to draw one frame that ImGui produced on
+/// another thread: the ImDrawData and its draw lists, plus the frame state
+/// that lives outside of it.
+///
+/// Only the vertex, index and command buffers of the draw lists are copied,
+/// into lists owned by the snapshot whose buffers are reused from frame to
+/// frame. Draw commands with a UserCallback are copied as they are, so the
+/// callback runs on the render thread.
+class DrawSnapshot {
+public:
+  DrawSnapshot();
+  ~DrawSnapshot();
+
+  DrawSnapshot(const DrawSnapshot &) = delete;
+  DrawSnapshot &operator=(const DrawSnapshot &) = delete;
+
+  /// Copy the output of igRender(). Must be called on the thread that owns
+  /// the ImGui context, before the next igNewFrame().
+  void capture(const ImDrawData *src);
+
+  /// The copied draw data, valid until the next capture().
+  ImDrawData *drawData() { return &drawData_; }
+
+  float dpiScale = 1.0f;
+  /// igGetMouseCursor() of the frame.
+  ImGuiMouseCursor mouseCursor = ImGuiMouseCursor_Arrow;
+  float bgColor[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+  OverlayStats stats{};
+  /// Phase timings of the JS thread's frame.
+  HudFrame hud{};
+
+private:
+  ImDrawData drawData_{};
+  /// Draw lists in use by drawData_ come first; the rest are kept for reuse.
+  std::vector<ImDrawList *> lists_{};
+};
+
+/// Three snapshots handed from a producer thread to a consumer thread
+/// without either waiting for the other: the producer fills back() and
+/// publishes it, and the consumer always gets the latest published
+/// snapshot. Frames the consumer didn't pick up in time are dropped.
+class DrawSnapshotQueue {
+public:
+  /// The snapshot to fill next. Producer only.
+  DrawSnapshot &back() { return slots_[back_]; }
+  /// Make back() the latest snapshot and start on another one.
+  void publish();
+  /// The latest published snapshot, or nullptr if none was published since
+  /// the previous call. Consumer only; the snapshot stays valid until the
+  /// next call.
+  DrawSnapshot *acquire();
+
+private:
+  DrawSnapshot slots_[3];
+  std::mutex mutex_;
+  unsigned back_ = 0;
+  unsigned ready_ = 1;
+  unsigned front_ = 2;
+  bool fresh_ = false;
+};
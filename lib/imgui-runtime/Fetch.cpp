@@ -0,0 +1,1234 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "Fetch.h"
+
+#include "SharedBuffer.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#ifdef REACT_IMGUI_TLS
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+/// Redirects followed before a request fails.
+constexpr int kMaxRedirects = 20;
+/// Largest response head (status line and headers).
+constexpr size_t kMaxHeadBytes = 64 << 10;
+/// Largest chunk-size or trailer line of a chunked body.
+constexpr size_t kMaxLineBytes = 8 << 10;
+/// Bytes read from the socket at a time.
+constexpr size_t kReadBytes = 64 << 10;
+/// Default and largest chunk sizes of __fetchRead().
+constexpr size_t kChunkSize = 64 << 10;
+constexpr size_t kMaxChunkSize = 16 << 20;
+/// Largest body buffered by __fetchReadAll(), and what it reserves up front
+/// for a body of known length; the buffer grows by doubling from there.
+constexpr size_t kMaxBodyBytes = (size_t)1 << 30;
+constexpr size_t kInitialBodyBytes = 1 << 20;
+/// Body bytes of a redirect drained to keep its connection; a longer body
+/// closes it.
+constexpr size_t kMaxDrainBytes = 64 << 10;
+/// Idle connections kept per origin, and for how long.
+constexpr size_t kMaxIdlePerOrigin = 6;
+constexpr auto kIdleTimeout = std::chrono::seconds(30);
+
+enum class Redirect { Follow, Manual, Error };
+
+struct Url {
+  bool tls = false;
+  /// Without the brackets of an IPv6 address.
+  std::string host;
+  std::string port;
+  /// Path and query, at least "/".
+  std::string path;
+  /// The Host header: the host, and the port unless it is the default.
+  std::string hostHeader;
+  /// scheme://host[:port], the key of the pooled connections.
+  std::string origin;
+};
+
+/// A connection to an origin. Registered in s_live while it exists, so that
+/// its socket can be shut down from another thread.
+struct Conn {
+  int fd = -1;
+#ifdef REACT_IMGUI_TLS
+  SSL *ssl = nullptr;
+#endif
+  std::string origin;
+  /// Received bytes; those before `inPos` are consumed.
+  std::vector<uint8_t> in;
+  size_t inPos = 0;
+  /// Taken from the idle connections rather than opened for the request.
+  bool reused = false;
+  std::chrono::steady_clock::time_point idleSince;
+
+  Conn();
+  ~Conn();
+
+  size_t available() const { return in.size() - inPos; }
+};
+
+enum class BodyKind { None, Length, Chunked, UntilClose };
+enum class ChunkState { Size, Data, DataEnd, Trailers };
+
+/// A response whose body is still on its connection, read by one worker at
+/// a time.
+struct Response {
+  std::mutex mutex;
+  std::unique_ptr<Conn> conn;
+  int timeoutMs = 0;
+  int status = 0;
+  std::string statusText;
+  std::string url;
+  bool redirected = false;
+  std::vector<std::pair<std::string, std::string>> headers;
+  BodyKind kind = BodyKind::None;
+  /// Length: body bytes left; Chunked: bytes left of the current chunk.
+  uint64_t remaining = 0;
+  ChunkState chunk = ChunkState::Size;
+  /// The body was read to its end.
+  bool done = false;
+  /// The connection can take another request once the body is read.
+  bool keepAlive = true;
+  /// Why reading the body failed; later reads fail the same way.
+  std::string failure;
+  /// The socket of `conn`, for __fetchClose(); guarded by s_live_mutex.
+  int fd = -1;
+  std::atomic<bool> cancelled{false};
+};
+
+struct Request {
+  std::string method;
+  std::string url;
+  std::vector<std::pair<std::string, std::string>> headers;
+  std::string body;
+  bool hasBody = false;
+  Redirect redirect = Redirect::Follow;
+  int timeoutMs = 0;
+};
+
+/// Result of a worker job, converted to JS by complete().
+struct Result {
+  /// Empty on success.
+  std::string error;
+  /// __fetch(): the response.
+  std::shared_ptr<Response> response;
+  /// __fetchRead() and __fetchReadAll(): the bytes, null at the end of the
+  /// body for __fetchRead().
+  std::shared_ptr<VectorBuffer<uint8_t>> data;
+  /// __fetchSave(): bytes written.
+  uint64_t bytes = 0;
+};
+
+enum class Op { Request, Read, ReadAll, ReadText, Save };
+
+ThreadPool *s_pool = nullptr;
+MainThreadPoster s_post_to_main = nullptr;
+
+/// Main thread only.
+std::unordered_map<unsigned, facebook::jsi::Function> s_callbacks{};
+unsigned s_next_request = 1;
+std::unordered_map<unsigned, std::shared_ptr<Response>> s_responses{};
+unsigned s_next_response = 1;
+
+/// The existing connections, and whether new ones are refused.
+std::mutex s_live_mutex;
+std::unordered_set<Conn *> s_live;
+bool s_stopping = false;
+
+/// Idle keep-alive connections by origin, oldest first.
+std::mutex s_idle_mutex;
+std::unordered_map<std::string, std::vector<std::unique_ptr<Conn>>> s_idle;
+
+Conn::Conn() {
+  std::lock_guard<std::mutex> lock(s_live_mutex);
+  s_live.insert(this);
+}
+
+Conn::~Conn() {
+  {
+    // Unregistered before the fd is closed, so that a shutdown() under the
+    // mutex never hits a reused fd
+    std::lock_guard<std::mutex> lock(s_live_mutex);
+    s_live.erase(this);
+  }
+#ifdef REACT_IMGUI_TLS
+  if (ssl)
+    SSL_free(ssl);
+#endif
+  if (fd >= 0)
+    close(fd);
+}
+
+#ifdef REACT_IMGUI_TLS
+/// The client context of all TLS connections, verifying the peer against
+/// the system's certificates. Lives as long as the process.
+SSL_CTX *tls_context() {
+  static SSL_CTX *ctx = [] {
+    SSL_CTX *c = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_default_verify_paths(c);
+    SSL_CTX_set_verify(c, SSL_VERIFY_PEER, nullptr);
+    SSL_CTX_set_min_proto_version(c, TLS1_2_VERSION);
+    return c;
+  }();
+  return ctx;
+}
+#endif
+
+std::string lowercase(std::string s) {
+  for (char &c : s)
+    c = (char)tolower((unsigned char)c);
+  return s;
+}
+
+std::string trim(const std::string &s) {
+  size_t start = s.find_first_not_of(" \t");
+  if (start == std::string::npos)
+    return "";
+  return s.substr(start, s.find_last_not_of(" \t") - start + 1);
+}
+
+/// Parse an http:// or https:// URL into `url`, or return the error. The
+/// fragment is dropped.
+std::string parse_url(std::string text, Url &url) {
+  text = text.substr(0, text.find('#'));
+  std::string lower = lowercase(text);
+  size_t rest;
+  if (lower.compare(0, 7, "http://") == 0) {
+    rest = 7;
+  } else if (lower.compare(0, 8, "https://") == 0) {
+    url.tls = true;
+    rest = 8;
+  } else {
+    return "unsupported URL scheme: " + text;
+  }
+  size_t end = text.find_first_of("/?", rest);
+  std::string authority =
+      text.substr(rest, end == std::string::npos ? std::string::npos
+                                                 : end - rest);
+  if (authority.find('@') != std::string::npos)
+    return "URLs with credentials aren't supported";
+  size_t portStart = std::string::npos;
+  if (!authority.empty() && authority[0] == '[') {
+    size_t close = authority.find(']');
+    if (close == std::string::npos)
+      return "invalid host in " + text;
+    url.host = authority.substr(1, close - 1);
+    if (close + 1 < authority.size()) {
+      if (authority[close + 1] != ':')
+        return "invalid host in " + text;
+      portStart = close + 2;
+    }
+  } else {
+    size_t colon = authority.find(':');
+    url.host = authority.substr(0, colon);
+    if (colon != std::string::npos)
+      portStart = colon + 1;
+  }
+  if (url.host.empty())
+    return "no host in " + text;
+  std::string defaultPort = url.tls ? "443" : "80";
+  url.port = portStart == std::string::npos || portStart == authority.size()
+                 ? defaultPort
+                 : authority.substr(portStart);
+  if (url.port.find_first_not_of("0123456789") != std::string::npos ||
+      url.port.size() > 5 || std::stoul(url.port) > 65535)
+    return "invalid port in " + text;
+  url.path = end == std::string::npos ? "/" : text.substr(end);
+  if (url.path[0] == '?')
+    url.path = "/" + url.path;
+  url.hostHeader = lowercase(authority.substr(
+      0, portStart == std::string::npos ? std::string::npos : portStart - 1));
+  if (url.port != defaultPort)
+    url.hostHeader += ":" + url.port;
+  url.origin = (url.tls ? "https://" : "http://") + url.hostHeader;
+  return "";
+}
+
+/// The absolute URL of a Location header, relative to `base`.
+std::string resolve_location(const Url &base, const std::string &location) {
+  size_t scheme = location.find("://");
+  if (scheme != std::string::npos &&
+      location.find_first_of("/?#") > scheme)
+    return location;
+  if (location.compare(0, 2, "//") == 0)
+    return (base.tls ? "https:" : "http:") + location;
+  if (!location.empty() && location[0] == '/')
+    return base.origin + location;
+  std::string path = base.path.substr(0, base.path.find('?'));
+  if (!location.empty() && location[0] == '?')
+    return base.origin + path + location;
+  return base.origin + path.substr(0, path.rfind('/') + 1) + location;
+}
+
+/// Apply the request timeout to the blocking reads and writes of `fd`.
+void set_timeouts(int fd, int timeoutMs) {
+  timeval tv = {timeoutMs / 1000, (timeoutMs % 1000) * 1000};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof tv);
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof tv);
+}
+
+std::string socket_error(const char *what, int err) {
+  if (err == EAGAIN || err == EWOULDBLOCK)
+    return std::string(what) + " timed out";
+  return std::string(what) + " failed: " + strerror(err);
+}
+
+/// Connect to `url`, trying each of its addresses, then do the TLS
+/// handshake of https:// URLs.
+std::unique_ptr<Conn> open_connection(const Url &url, int timeoutMs,
+                                      std::string &error) {
+  addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo *res = nullptr;
+  int rc = getaddrinfo(url.host.c_str(), url.port.c_str(), &hints, &res);
+  if (rc != 0) {
+    error = "can't resolve " + url.host + ": " + gai_strerror(rc);
+    return nullptr;
+  }
+  std::unique_ptr<Conn> conn;
+  int lastError = ECONNREFUSED;
+  for (addrinfo *ai = res; ai && !conn; ai = ai->ai_next) {
+    auto c = std::make_unique<Conn>();
+    int fd = socket(ai->ai_family, SOCK_STREAM, 0);
+    if (fd < 0) {
+      lastError = errno;
+      continue;
+    }
+    {
+      // Set under the mutex, so that shutdown_fetch() either sees the fd or
+      // is seen here
+      std::lock_guard<std::mutex> lock(s_live_mutex);
+      c->fd = fd;
+      if (s_stopping) {
+        lastError = ECANCELED;
+        break;
+      }
+    }
+    fcntl(c->fd, F_SETFD, FD_CLOEXEC);
+    int flags = fcntl(c->fd, F_GETFL);
+    fcntl(c->fd, F_SETFL, flags | O_NONBLOCK);
+    if (connect(c->fd, ai->ai_addr, ai->ai_addrlen) != 0) {
+      if (errno != EINPROGRESS) {
+        lastError = errno;
+        continue;
+      }
+      pollfd pfd = {c->fd, POLLOUT, 0};
+      int ready = poll(&pfd, 1, timeoutMs > 0 ? timeoutMs : -1);
+      int err = 0;
+      socklen_t len = sizeof err;
+      if (ready <= 0)
+        err = ready == 0 ? ETIMEDOUT : errno;
+      else
+        getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &err, &len);
+      if (err) {
+        lastError = err;
+        continue;
+      }
+    }
+    fcntl(c->fd, F_SETFL, flags);
+    conn = std::move(c);
+  }
+  freeaddrinfo(res);
+  if (!conn) {
+    error = "can't connect to " + url.hostHeader + ": " + strerror(lastError);
+    return nullptr;
+  }
+  conn->origin = url.origin;
+  int one = 1;
+  setsockopt(conn->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+#ifdef SO_NOSIGPIPE
+  setsockopt(conn->fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof one);
+#endif
+  set_timeouts(conn->fd, timeoutMs);
+  if (!url.tls)
+    return conn;
+#ifdef REACT_IMGUI_TLS
+  ERR_clear_error();
+  conn->ssl = SSL_new(tls_context());
+  SSL_set_fd(conn->ssl, conn->fd);
+  SSL_set_tlsext_host_name(conn->ssl, url.host.c_str());
+  SSL_set1_host(conn->ssl, url.host.c_str());
+  if (SSL_connect(conn->ssl) != 1) {
+    long verify = SSL_get_verify_result(conn->ssl);
+    char detail[256];
+    ERR_error_string_n(ERR_get_error(), detail, sizeof detail);
+    error = "TLS handshake with " + url.hostHeader + " failed: " +
+            (verify != X509_V_OK ? X509_verify_cert_error_string(verify)
+                                 : detail);
+    return nullptr;
+  }
+  return conn;
+#else
+  error = "https:// needs a runtime built with TLS (OpenSSL)";
+  return nullptr;
+#endif
+}
+
+/// An idle connection to `origin` that the server hasn't closed, if any.
+std::unique_ptr<Conn> take_idle(const std::string &origin) {
+  std::lock_guard<std::mutex> lock(s_idle_mutex);
+  auto it = s_idle.find(origin);
+  if (it == s_idle.end())
+    return nullptr;
+  auto now = std::chrono::steady_clock::now();
+  std::unique_ptr<Conn> conn;
+  while (!it->second.empty() && !conn) {
+    std::unique_ptr<Conn> c = std::move(it->second.back());
+    it->second.pop_back();
+    // Readable while idle means closed by the server (or garbage)
+    pollfd pfd = {c->fd, POLLIN, 0};
+    if (now - c->idleSince < kIdleTimeout && poll(&pfd, 1, 0) == 0)
+      conn = std::move(c);
+  }
+  if (it->second.empty())
+    s_idle.erase(it);
+  if (conn)
+    conn->reused = true;
+  return conn;
+}
+
+/// Keep `conn` for the next request to its origin.
+void keep_idle(std::unique_ptr<Conn> conn) {
+  {
+    std::lock_guard<std::mutex> lock(s_live_mutex);
+    if (s_stopping)
+      return;
+  }
+  conn->idleSince = std::chrono::steady_clock::now();
+  conn->in.clear();
+  conn->inPos = 0;
+  std::lock_guard<std::mutex> lock(s_idle_mutex);
+  std::vector<std::unique_ptr<Conn>> &idle = s_idle[conn->origin];
+  idle.push_back(std::move(conn));
+  if (idle.size() > kMaxIdlePerOrigin)
+    idle.erase(idle.begin());
+}
+
+/// Bytes read, 0 at the end of the stream, -1 on an error.
+ssize_t raw_read(Conn &c, void *buf, size_t size, std::string &error) {
+#ifdef REACT_IMGUI_TLS
+  if (c.ssl) {
+    int n = SSL_read(c.ssl, buf, (int)size);
+    if (n > 0)
+      return n;
+    int err = SSL_get_error(c.ssl, n);
+    if (err == SSL_ERROR_ZERO_RETURN)
+      return 0;
+    if (err == SSL_ERROR_SYSCALL && n == 0 && errno == 0)
+      return 0;
+    error = err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE
+                ? "read timed out"
+                : socket_error("read", errno ? errno : EPROTO);
+    return -1;
+  }
+#endif
+  for (;;) {
+    ssize_t n = recv(c.fd, buf, size, 0);
+    if (n >= 0)
+      return n;
+    if (errno != EINTR) {
+      error = socket_error("read", errno);
+      return -1;
+    }
+  }
+}
+
+bool write_all(Conn &c, const char *data, size_t size, std::string &error) {
+  while (size > 0) {
+    ssize_t n;
+#ifdef REACT_IMGUI_TLS
+    if (c.ssl) {
+      n = SSL_write(c.ssl, data, (int)std::min<size_t>(size, 1 << 30));
+      if (n <= 0) {
+        int err = SSL_get_error(c.ssl, (int)n);
+        error = err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE
+                    ? "write timed out"
+                    : socket_error("write", errno ? errno : EPROTO);
+        return false;
+      }
+    } else
+#endif
+    {
+#ifdef MSG_NOSIGNAL
+      n = send(c.fd, data, size, MSG_NOSIGNAL);
+#else
+      n = send(c.fd, data, size, 0);
+#endif
+      if (n < 0) {
+        if (errno == EINTR)
+          continue;
+        error = socket_error("write", errno);
+        return false;
+      }
+    }
+    data += n;
+    size -= (size_t)n;
+  }
+  return true;
+}
+
+/// Read more of the response into c.in. Returns the bytes read, 0 at the
+/// end of the stream, -1 on an error.
+ssize_t fill(Conn &c, std::string &error) {
+  if (c.inPos > 0 && c.inPos * 2 >= c.in.size()) {
+    c.in.erase(c.in.begin(), c.in.begin() + c.inPos);
+    c.inPos = 0;
+  }
+  size_t used = c.in.size();
+  c.in.resize(used + kReadBytes);
+  ssize_t n = raw_read(c, c.in.data() + used, kReadBytes, error);
+  c.in.resize(used + (n > 0 ? (size_t)n : 0));
+  return n;
+}
+
+/// The next CRLF-terminated line of c.in, reading more as needed.
+bool take_line(Conn &c, std::string &line, std::string &error) {
+  for (;;) {
+    const uint8_t *start = c.in.data() + c.inPos;
+    const uint8_t *end = c.in.data() + c.in.size();
+    const uint8_t *lf = std::find(start, end, (uint8_t)'\n');
+    if (lf != end) {
+      line.assign(start, lf);
+      if (!line.empty() && line.back() == '\r')
+        line.pop_back();
+      c.inPos += (size_t)(lf - start) + 1;
+      return true;
+    }
+    if (c.available() > kMaxLineBytes) {
+      error = "invalid chunked body";
+      return false;
+    }
+    ssize_t n = fill(c, error);
+    if (n <= 0) {
+      if (n == 0)
+        error = "connection closed in the middle of the body";
+      return false;
+    }
+  }
+}
+
+/// Give the connection of `r` back to the idle ones if `reuse`, or close
+/// it.
+void release_connection(Response &r, bool reuse) {
+  std::unique_ptr<Conn> conn = std::move(r.conn);
+  {
+    std::lock_guard<std::mutex> lock(s_live_mutex);
+    r.fd = -1;
+  }
+  // Bytes past the body would be the start of nothing
+  if (conn && reuse && r.keepAlive && conn->available() == 0 &&
+      !r.cancelled.load())
+    keep_idle(std::move(conn));
+}
+
+void end_body(Response &r) {
+  r.done = true;
+  release_connection(r, r.kind != BodyKind::UntilClose);
+}
+
+ssize_t read_body_bytes(Response &r, uint8_t *dst, size_t max,
+                        std::string &error) {
+  for (;;) {
+    if (r.done)
+      return 0;
+    if (r.cancelled.load()) {
+      error = "the body was cancelled";
+      return -1;
+    }
+    Conn &c = *r.conn;
+    if (r.kind == BodyKind::None || (r.kind == BodyKind::Length &&
+                                     r.remaining == 0)) {
+      end_body(r);
+      return 0;
+    }
+    if (r.kind == BodyKind::Chunked && r.chunk != ChunkState::Data) {
+      std::string line;
+      if (!take_line(c, line, error))
+        return -1;
+      if (r.chunk == ChunkState::DataEnd) {
+        if (!line.empty()) {
+          error = "invalid chunked body";
+          return -1;
+        }
+        r.chunk = ChunkState::Size;
+      } else if (r.chunk == ChunkState::Size) {
+        char *end = nullptr;
+        line = line.substr(0, line.find(';'));
+        unsigned long long size = strtoull(line.c_str(), &end, 16);
+        if (line.empty() || (*end && !isspace((unsigned char)*end))) {
+          error = "invalid chunked body";
+          return -1;
+        }
+        r.remaining = size;
+        r.chunk = size ? ChunkState::Data : ChunkState::Trailers;
+      } else if (line.empty()) {
+        end_body(r);
+        return 0;
+      }
+      continue;
+    }
+    if (c.available() == 0) {
+      ssize_t n = fill(c, error);
+      if (n < 0)
+        return -1;
+      if (n == 0) {
+        if (r.kind == BodyKind::UntilClose) {
+          end_body(r);
+          return 0;
+        }
+        error = "connection closed in the middle of the body";
+        return -1;
+      }
+    }
+    size_t n = std::min(c.available(), max);
+    if (r.kind != BodyKind::UntilClose)
+      n = (size_t)std::min<uint64_t>(n, r.remaining);
+    memcpy(dst, c.in.data() + c.inPos, n);
+    c.inPos += n;
+    if (r.kind != BodyKind::UntilClose) {
+      r.remaining -= n;
+      if (r.kind == BodyKind::Chunked && r.remaining == 0)
+        r.chunk = ChunkState::DataEnd;
+    }
+    return (ssize_t)n;
+  }
+}
+
+/// Read up to `max` bytes of the body into `dst`: what is buffered, or else
+/// what one read of the socket brings. Returns 0 at the end of the body and
+/// -1 on an error, which closes the connection.
+ssize_t read_body(Response &r, uint8_t *dst, size_t max, std::string &error) {
+  if (!r.failure.empty()) {
+    error = r.failure;
+    return -1;
+  }
+  ssize_t n = read_body_bytes(r, dst, max, error);
+  if (n < 0) {
+    r.failure = error;
+    release_connection(r, false);
+  }
+  return n;
+}
+
+/// Read the status line and headers of the response on r.conn, skipping
+/// informational responses, and work out how its body is framed.
+bool read_head(Response &r, const std::string &method, bool &nothingRead,
+               std::string &error) {
+  Conn &c = *r.conn;
+  nothingRead = true;
+  for (;;) {
+    static const char kEnd[] = "\r\n\r\n";
+    auto begin = c.in.begin() + (ptrdiff_t)c.inPos;
+    auto end = std::search(begin, c.in.end(), kEnd, kEnd + 4);
+    if (end == c.in.end()) {
+      if (c.available() > kMaxHeadBytes) {
+        error = "the response head is too large";
+        return false;
+      }
+      ssize_t n = fill(c, error);
+      if (n <= 0) {
+        if (n == 0)
+          error = "connection closed before the response";
+        return false;
+      }
+      nothingRead = false;
+      continue;
+    }
+    std::string head(begin, end);
+    c.inPos = (size_t)(end - c.in.begin()) + 4;
+
+    size_t lineEnd = head.find("\r\n");
+    std::string status = head.substr(0, lineEnd);
+    // HTTP/1.x <code> <reason>
+    if (status.compare(0, 7, "HTTP/1.") != 0 || status.size() < 12 ||
+        !isdigit((unsigned char)status[9])) {
+      error = "invalid response: " + status.substr(0, 80);
+      return false;
+    }
+    r.status = atoi(status.c_str() + 9);
+    r.statusText = status.size() > 13 ? status.substr(13) : "";
+    r.headers.clear();
+    while (lineEnd != std::string::npos) {
+      size_t start = lineEnd + 2;
+      lineEnd = head.find("\r\n", start);
+      std::string line = head.substr(start, lineEnd == std::string::npos
+                                                ? std::string::npos
+                                                : lineEnd - start);
+      size_t colon = line.find(':');
+      if (colon != std::string::npos)
+        r.headers.emplace_back(lowercase(trim(line.substr(0, colon))),
+                               trim(line.substr(colon + 1)));
+    }
+    if (r.status >= 100 && r.status < 200)
+      continue;
+    break;
+  }
+
+  std::string connection, transferEncoding, contentLength;
+  for (const auto &header : r.headers) {
+    if (header.first == "connection")
+      connection = lowercase(header.second);
+    else if (header.first == "transfer-encoding")
+      transferEncoding = lowercase(header.second);
+    else if (header.first == "content-length")
+      contentLength = header.second;
+  }
+  r.keepAlive = connection.find("close") == std::string::npos;
+  if (method == "HEAD" || r.status == 204 || r.status == 304) {
+    r.kind = BodyKind::None;
+  } else if (transferEncoding.find("chunked") != std::string::npos) {
+    r.kind = BodyKind::Chunked;
+    r.chunk = ChunkState::Size;
+  } else if (!contentLength.empty()) {
+    if (contentLength.find_first_not_of("0123456789") != std::string::npos) {
+      error = "invalid Content-Length: " + contentLength;
+      return false;
+    }
+    r.kind = BodyKind::Length;
+    r.remaining = strtoull(contentLength.c_str(), nullptr, 10);
+  } else {
+    r.kind = BodyKind::UntilClose;
+    r.keepAlive = false;
+  }
+  r.done = false;
+  return true;
+}
+
+std::string header_value(const Response &r, const char *name) {
+  for (const auto &header : r.headers)
+    if (header.first == name)
+      return header.second;
+  return "";
+}
+
+/// Send `req` to `url` on a pooled or new connection and read the response
+/// head into `r`. A pooled connection that the server closed meanwhile is
+/// replaced by a new one.
+bool exchange(const Request &req, const Url &url, Response &r,
+              std::string &error) {
+  std::string head = req.method + " " + url.path + " HTTP/1.1\r\nHost: " +
+                     url.hostHeader + "\r\n";
+  bool hasAccept = false, hasAgent = false;
+  for (const auto &header : req.headers) {
+    std::string name = lowercase(header.first);
+    // Framing and connection management are the client's
+    if (name == "host" || name == "content-length" || name == "connection" ||
+        name == "transfer-encoding" || name == "keep-alive" ||
+        name == "upgrade" || name == "te")
+      continue;
+    hasAccept |= name == "accept";
+    hasAgent |= name == "user-agent";
+    head += header.first + ": " + header.second + "\r\n";
+  }
+  if (!hasAccept)
+    head += "Accept: */*\r\n";
+  if (!hasAgent)
+    head += "User-Agent: imgui-react-runtime\r\n";
+  if (req.hasBody || req.method == "POST" || req.method == "PUT" ||
+      req.method == "PATCH")
+    head += "Content-Length: " + std::to_string(req.body.size()) + "\r\n";
+  head += "\r\n";
+
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    std::unique_ptr<Conn> conn = attempt == 0 ? take_idle(url.origin) : nullptr;
+    if (!conn)
+      conn = open_connection(url, req.timeoutMs, error);
+    if (!conn)
+      return false;
+    bool reused = conn->reused;
+    set_timeouts(conn->fd, req.timeoutMs);
+    r.conn = std::move(conn);
+    {
+      std::lock_guard<std::mutex> lock(s_live_mutex);
+      r.fd = r.conn->fd;
+    }
+    bool nothingRead = true;
+    if (write_all(*r.conn, head.data(), head.size(), error) &&
+        write_all(*r.conn, req.body.data(), req.body.size(), error) &&
+        read_head(r, req.method, nothingRead, error))
+      return true;
+    release_connection(r, false);
+    if (!reused || !nothingRead)
+      return false;
+    error.clear();
+  }
+  return false;
+}
+
+/// Worker job of __fetch(): the request, and the redirects it leads to.
+std::shared_ptr<Response> perform(Request req, std::string &error) {
+  auto r = std::make_shared<Response>();
+  r->timeoutMs = req.timeoutMs;
+  for (int redirects = 0;; ++redirects) {
+    Url url;
+    error = parse_url(req.url, url);
+    if (!error.empty())
+      return nullptr;
+    if (!exchange(req, url, *r, error))
+      return nullptr;
+    r->url = req.url.substr(0, req.url.find('#'));
+    std::string location = header_value(*r, "location");
+    bool isRedirect = r->status == 301 || r->status == 302 ||
+                      r->status == 303 || r->status == 307 ||
+                      r->status == 308;
+    if (!isRedirect || location.empty() || req.redirect == Redirect::Manual)
+      return r;
+    if (req.redirect == Redirect::Error) {
+      error = "unexpected redirect to " + location;
+      release_connection(*r, false);
+      return nullptr;
+    }
+    if (redirects == kMaxRedirects) {
+      error = "too many redirects";
+      release_connection(*r, false);
+      return nullptr;
+    }
+    // Drain a short body to keep the connection; give up on a long one
+    std::vector<uint8_t> scratch(kReadBytes);
+    size_t drained = 0;
+    while (r->conn && drained <= kMaxDrainBytes) {
+      std::string ignored;
+      ssize_t n = read_body(*r, scratch.data(), scratch.size(), ignored);
+      if (n <= 0)
+        break;
+      drained += (size_t)n;
+    }
+    if (r->conn)
+      release_connection(*r, false);
+    if (r->status == 303 ||
+        ((r->status == 301 || r->status == 302) && req.method == "POST")) {
+      if (req.method != "HEAD")
+        req.method = "GET";
+      req.body.clear();
+      req.hasBody = false;
+      req.headers.erase(
+          std::remove_if(req.headers.begin(), req.headers.end(),
+                         [](const std::pair<std::string, std::string> &h) {
+                           std::string name = lowercase(h.first);
+                           return name == "content-type" ||
+                                  name == "content-encoding" ||
+                                  name == "content-language" ||
+                                  name == "content-location";
+                         }),
+          req.headers.end());
+    }
+    std::string next = resolve_location(url, location);
+    Url nextUrl;
+    // Credentials don't follow a redirect to another origin
+    if (parse_url(next, nextUrl).empty() && nextUrl.origin != url.origin)
+      req.headers.erase(
+          std::remove_if(req.headers.begin(), req.headers.end(),
+                         [](const std::pair<std::string, std::string> &h) {
+                           std::string name = lowercase(h.first);
+                           return name == "authorization" ||
+                                  name == "cookie";
+                         }),
+          req.headers.end());
+    req.url = next;
+    r->redirected = true;
+  }
+}
+
+/// Worker job of __fetchRead(): the next chunk, null at the end.
+void read_chunk(Response &r, size_t chunkSize, Result &res) {
+  std::lock_guard<std::mutex> lock(r.mutex);
+  std::vector<uint8_t> bytes(chunkSize);
+  ssize_t n = read_body(r, bytes.data(), bytes.size(), res.error);
+  if (n > 0) {
+    bytes.resize((size_t)n);
+    bytes.shrink_to_fit();
+    res.data = std::make_shared<VectorBuffer<uint8_t>>(std::move(bytes));
+  }
+}
+
+/// Worker job of __fetchReadAll(): the rest of the body, up to
+/// kMaxBodyBytes. Content-Length comes from the server, so it only sizes
+/// the first reservation.
+void read_all(Response &r, Result &res) {
+  std::lock_guard<std::mutex> lock(r.mutex);
+  const std::string tooLarge =
+      "response body larger than " + std::to_string(kMaxBodyBytes >> 20) +
+      " MiB";
+  std::vector<uint8_t> bytes;
+  if (r.kind == BodyKind::Length && !r.done) {
+    if (r.remaining > kMaxBodyBytes) {
+      res.error = tooLarge;
+      return;
+    }
+    bytes.reserve((size_t)std::min<uint64_t>(r.remaining, kInitialBodyBytes));
+  }
+  for (;;) {
+    size_t used = bytes.size();
+    if (used == bytes.capacity())
+      bytes.reserve(std::min(std::max(used * 2, kReadBytes),
+                             kMaxBodyBytes + kReadBytes));
+    size_t want = bytes.capacity() - used;
+    bytes.resize(used + want);
+    ssize_t n = read_body(r, bytes.data() + used, want, res.error);
+    bytes.resize(used + (n > 0 ? (size_t)n : 0));
+    if (n < 0)
+      return;
+    if (n == 0)
+      break;
+    if (bytes.size() > kMaxBodyBytes) {
+      res.error = tooLarge;
+      return;
+    }
+  }
+  bytes.shrink_to_fit();
+  res.data = std::make_shared<VectorBuffer<uint8_t>>(std::move(bytes));
+}
+
+/// Worker job of __fetchSave(): the rest of the body into `path`, through a
+/// temporary file renamed once the body is complete.
+void save_body(Response &r, const std::string &path, Result &res) {
+  std::lock_guard<std::mutex> lock(r.mutex);
+  std::string tmpPath = path + "." + std::to_string(getpid()) + ".download";
+  int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                0644);
+  if (fd < 0) {
+    res.error = "can't write " + tmpPath + ": " + strerror(errno);
+    return;
+  }
+  std::vector<uint8_t> buf(1 << 20);
+  bool ok = true;
+  for (;;) {
+    ssize_t n = read_body(r, buf.data(), buf.size(), res.error);
+    if (n < 0) {
+      ok = false;
+      break;
+    }
+    if (n == 0)
+      break;
+    // read_body() returns what is at hand; fill the buffer before writing
+    size_t size = (size_t)n;
+    while (size < buf.size()) {
+      ssize_t more =
+          read_body(r, buf.data() + size, buf.size() - size, res.error);
+      if (more <= 0) {
+        ok = more == 0;
+        break;
+      }
+      size += (size_t)more;
+    }
+    for (size_t written = 0; written < size;) {
+      ssize_t w = write(fd, buf.data() + written, size - written);
+      if (w < 0 && errno == EINTR)
+        continue;
+      if (w < 0) {
+        res.error = "can't write " + tmpPath + ": " + strerror(errno);
+        ok = false;
+        break;
+      }
+      written += (size_t)w;
+    }
+    res.bytes += size;
+    if (!ok || r.done)
+      break;
+  }
+  ok = close(fd) == 0 && ok;
+  if (ok && rename(tmpPath.c_str(), path.c_str()) != 0) {
+    res.error = "can't write " + path + ": " + strerror(errno);
+    ok = false;
+  }
+  if (!ok) {
+    if (res.error.empty())
+      res.error = "can't write " + path;
+    unlink(tmpPath.c_str());
+  }
+}
+
+/// Convert the result of a job to JS and pass it to its callback.
+void complete(facebook::jsi::Runtime &rt, unsigned id, Op op, Result &res) {
+  auto it = s_callbacks.find(id);
+  if (it == s_callbacks.end())
+    return;
+  facebook::jsi::Function callback = std::move(it->second);
+  s_callbacks.erase(it);
+
+  if (!res.error.empty()) {
+    callback.call(rt, facebook::jsi::String::createFromUtf8(rt, res.error));
+    return;
+  }
+  switch (op) {
+  case Op::Request: {
+    Response &r = *res.response;
+    unsigned responseId = s_next_response++;
+    s_responses.emplace(responseId, res.response);
+    facebook::jsi::Array headers(rt, r.headers.size() * 2);
+    for (size_t i = 0; i < r.headers.size(); ++i) {
+      headers.setValueAtIndex(
+          rt, i * 2,
+          facebook::jsi::String::createFromUtf8(rt, r.headers[i].first));
+      headers.setValueAtIndex(
+          rt, i * 2 + 1,
+          facebook::jsi::String::createFromUtf8(rt, r.headers[i].second));
+    }
+    facebook::jsi::Value args[] = {
+        facebook::jsi::Value::null(),
+        (double)responseId,
+        r.status,
+        facebook::jsi::String::createFromUtf8(rt, r.statusText),
+        facebook::jsi::String::createFromUtf8(rt, r.url),
+        r.redirected,
+        std::move(headers),
+    };
+    callback.call(rt, static_cast<const facebook::jsi::Value *>(args),
+                  sizeof args / sizeof args[0]);
+    break;
+  }
+  case Op::Read:
+  case Op::ReadAll:
+    if (!res.data) {
+      callback.call(rt, facebook::jsi::Value::null(),
+                    facebook::jsi::Value::null());
+      break;
+    }
+    // A worker can take the bytes over without a copy
+    register_transferable_buffer(res.data, false);
+    callback.call(rt, facebook::jsi::Value::null(),
+                  facebook::jsi::ArrayBuffer(rt, res.data));
+    break;
+  case Op::ReadText:
+    callback.call(rt, facebook::jsi::Value::null(),
+                  facebook::jsi::String::createFromUtf8(
+                      rt, res.data->data(), res.data->size()));
+    break;
+  case Op::Save:
+    callback.call(rt, facebook::jsi::Value::null(), (double)res.bytes);
+    break;
+  }
+}
+
+/// Queue `job` on the pool and `complete()` its result with the callback
+/// in `callbackArg`.
+void run_job(facebook::jsi::Runtime &rt,
+             const facebook::jsi::Value &callbackArg, Op op,
+             std::function<void(Result &)> job) {
+  unsigned id = s_next_request++;
+  s_callbacks.emplace(id, callbackArg.getObject(rt).getFunction(rt));
+  facebook::jsi::Runtime *rtp = &rt;
+  MainThreadPoster postToMain = s_post_to_main;
+  s_pool->post(
+      [rtp, id, op, job, postToMain] {
+        auto res = std::make_shared<Result>();
+        // A failed allocation must reach the callback, not the pool
+        try {
+          job(*res);
+        } catch (const std::exception &e) {
+          res->error = e.what();
+        } catch (...) {
+          res->error = "fetch job failed";
+        }
+        postToMain([rtp, id, op, res] { complete(*rtp, id, op, *res); });
+      },
+      {TaskPriority::Normal, TraceTaskFetch});
+}
+
+bool is_function(facebook::jsi::Runtime &rt, const facebook::jsi::Value &v) {
+  return v.isObject() && v.getObject(rt).isFunction(rt);
+}
+
+/// The response of `args[0]`, for the __fetchRead*() functions.
+std::shared_ptr<Response> response_arg(facebook::jsi::Runtime &rt,
+                                       const facebook::jsi::Value *args,
+                                       size_t count, size_t callbackIndex,
+                                       const char *name) {
+  if (count <= callbackIndex || !args[0].isNumber() ||
+      !is_function(rt, args[callbackIndex]))
+    throw facebook::jsi::JSError(
+        rt, std::string(name) + " expects a response and a callback");
+  auto it = s_responses.find((unsigned)args[0].getNumber());
+  if (it == s_responses.end())
+    throw facebook::jsi::JSError(rt, std::string(name) + ": closed response");
+  return it->second;
+}
+
+} // namespace
+
+void install_fetch(facebook::jsi::Runtime &rt, ThreadPool &pool,
+                   MainThreadPoster postToMain) {
+  s_pool = &pool;
+  s_post_to_main = postToMain;
+  {
+    std::lock_guard<std::mutex> lock(s_live_mutex);
+    s_stopping = false;
+  }
+
+  rt.global().setProperty(
+      rt, "__fetch",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__fetch"), 7,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count < 7 || !args[0].isString() || !args[1].isString() ||
+                !args[2].isObject() || !is_function(rt, args[6]))
+              throw facebook::jsi::JSError(
+                  rt, "__fetch expects a method, a URL, headers, a body, a "
+                      "redirect mode, a timeout and a callback");
+            Request req;
+            req.method = args[0].getString(rt).utf8(rt);
+            req.url = args[1].getString(rt).utf8(rt);
+            facebook::jsi::Array headers = args[2].getObject(rt).getArray(rt);
+            size_t headerValues = headers.size(rt);
+            for (size_t i = 0; i + 1 < headerValues; i += 2) {
+              std::string name =
+                  headers.getValueAtIndex(rt, i).toString(rt).utf8(rt);
+              std::string value =
+                  headers.getValueAtIndex(rt, i + 1).toString(rt).utf8(rt);
+              if (name.find_first_of("\r\n:") != std::string::npos ||
+                  value.find_first_of("\r\n") != std::string::npos)
+                throw facebook::jsi::JSError(rt,
+                                             "__fetch: invalid header " + name);
+              req.headers.emplace_back(std::move(name), std::move(value));
+            }
+            if (args[3].isString()) {
+              req.body = args[3].getString(rt).utf8(rt);
+              req.hasBody = true;
+            } else if (args[3].isObject() &&
+                       args[3].getObject(rt).isArrayBuffer(rt)) {
+              facebook::jsi::ArrayBuffer ab =
+                  args[3].getObject(rt).getArrayBuffer(rt);
+              req.body.assign((const char *)ab.data(rt), ab.size(rt));
+              req.hasBody = true;
+            }
+            std::string redirect =
+                args[4].isString() ? args[4].getString(rt).utf8(rt) : "follow";
+            req.redirect = redirect == "manual"  ? Redirect::Manual
+                           : redirect == "error" ? Redirect::Error
+                                                 : Redirect::Follow;
+            req.timeoutMs =
+                args[5].isNumber() ? (int)std::clamp(args[5].getNumber(), 0.0,
+                                                     2147483647.0)
+                                   : 0;
+            auto shared = std::make_shared<Request>(std::move(req));
+            run_job(rt, args[6], Op::Request, [shared](Result &res) {
+              res.response = perform(std::move(*shared), res.error);
+            });
+            return facebook::jsi::Value::undefined();
+          }));
+
+  rt.global().setProperty(
+      rt, "__fetchRead",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__fetchRead"), 3,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            std::shared_ptr<Response> r =
+                response_arg(rt, args, count, 2, "__fetchRead");
+            size_t chunkSize =
+                args[1].isNumber()
+                    ? (size_t)std::clamp(args[1].getNumber(), 1.0,
+                                         (double)kMaxChunkSize)
+                    : kChunkSize;
+            run_job(rt, args[2], Op::Read, [r, chunkSize](Result &res) {
+              read_chunk(*r, chunkSize, res);
+            });
+            return facebook::jsi::Value::undefined();
+          }));
+
+  rt.global().setProperty(
+      rt, "__fetchReadAll",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__fetchReadAll"), 3,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            std::shared_ptr<Response> r =
+                response_arg(rt, args, count, 2, "__fetchReadAll");
+            bool utf8 = args[1].isBool() && args[1].getBool();
+            run_job(rt, args[2], utf8 ? Op::ReadText : Op::ReadAll,
+                    [r](Result &res) { read_all(*r, res); });
+            return facebook::jsi::Value::undefined();
+          }));
+
+  rt.global().setProperty(
+      rt, "__fetchSave",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__fetchSave"), 3,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            std::shared_ptr<Response> r =
+                response_arg(rt, args, count, 2, "__fetchSave");
+            if (!args[1].isString())
+              throw facebook::jsi::JSError(rt, "__fetchSave expects a path");
+            std::string path = args[1].getString(rt).utf8(rt);
+            run_job(rt, args[2], Op::Save,
+                    [r, path](Result &res) { save_body(*r, path, res); });
+            return facebook::jsi::Value::undefined();
+          }));
+
+  rt.global().setProperty(
+      rt, "__fetchClose",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__fetchClose"), 1,
+          [](facebook::jsi::Runtime &, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count < 1 || !args[0].isNumber())
+              return facebook::jsi::Value::undefined();
+            auto it = s_responses.find((unsigned)args[0].getNumber());
+            if (it == s_responses.end())
+              return facebook::jsi::Value::undefined();
+            Response &r = *it->second;
+            r.cancelled.store(true);
+            {
+              // Wakes a read in flight, which then drops the connection
+              std::lock_guard<std::mutex> lock(s_live_mutex);
+              if (r.fd >= 0)
+                shutdown(r.fd, SHUT_RDWR);
+            }
+            s_responses.erase(it);
+            return facebook::jsi::Value::undefined();
+          }));
+}
+
+void shutdown_fetch() {
+  {
+    std::lock_guard<std::mutex> lock(s_live_mutex);
+    s_stopping = true;
+    for (Conn *conn : s_live)
+      shutdown(conn->fd, SHUT_RDWR);
+  }
+  {
+    std::lock_guard<std::mutex> lock(s_idle_mutex);
+    s_idle.clear();
+  }
+  s_callbacks.clear();
+  s_responses.clear();
+}
@@ -0,0 +1,47 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include "AsyncFs.h"
+
+#include <hermes/hermes.h>
+
+class ThreadPool;
+
+/// The HTTP/1.1 client behind jslib's fetch().
+///
+/// Requests run on the pool with blocking sockets: the name lookup, the
+/// connection (TLS for https:// URLs with OpenSSL, when the runtime is built
+/// with REACT_IMGUI_TLS), the request and the response head, following
+/// redirects. Connections are kept alive and pooled per origin once a body
+/// has been read to its end, and reused by the next request to the same
+/// origin.
+///
+/// The body stays on the socket until JS asks for it, one operation at a
+/// time per response: the next chunk (response.body), all of it as one
+/// ArrayBuffer or string, or all of it written to a file, so a large
+/// download never passes through the JS heap.
+///
+/// __fetch(method, url, headers, body, redirect, timeoutMs, callback) starts
+/// a request: `headers` is a flat array of names and values, `body` a
+/// string, an ArrayBuffer or undefined, `redirect` 'follow', 'manual' or
+/// 'error'. It calls `callback(message, id, status, statusText, url,
+/// redirected, headers)`, with a null message on success and the response's
+/// headers as a flat array. With the response `id`:
+///  - __fetchRead(id, chunkSize, callback) reads the next chunk of the body
+///    and calls `callback(message, chunk)`, a null chunk at its end;
+///  - __fetchReadAll(id, utf8, callback) reads the rest of it into one
+///    ArrayBuffer (or string, with `utf8`);
+///  - __fetchSave(id, path, callback) writes the rest of it to `path` and
+///    calls `callback(message, bytes)`;
+///  - __fetchClose(id) drops the response, closing its connection unless
+///    the body was read.
+void install_fetch(facebook::jsi::Runtime &rt, ThreadPool &pool,
+                   MainThreadPoster postToMain);
+
+/// Shut down the sockets of the requests in flight, so that the pool's
+/// workers don't wait for them, and forget the callbacks, responses and
+/// idle connections. Must be called before the pool is stopped.
+void shutdown_fetch();
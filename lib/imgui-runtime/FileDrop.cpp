@@ -0,0 +1,79 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "FileDrop.h"
+
+#include "sokol_app.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+/// The JS callback; thread of the runtime only. `s_has_callback` lets the
+/// main thread skip drops that nobody listens to.
+std::unique_ptr<facebook::jsi::Function> s_callback;
+std::atomic<bool> s_has_callback{false};
+facebook::jsi::Runtime *s_runtime = nullptr;
+MainThreadPoster s_post_to_main = nullptr;
+
+void call_callback(const std::vector<std::string> &paths) {
+  if (!s_callback)
+    return;
+  facebook::jsi::Runtime &rt = *s_runtime;
+  facebook::jsi::Array arr(rt, paths.size());
+  for (size_t i = 0; i < paths.size(); ++i)
+    arr.setValueAtIndex(rt, i,
+                        facebook::jsi::String::createFromUtf8(rt, paths[i]));
+  s_callback->call(rt, arr);
+}
+
+} // namespace
+
+void install_file_drop(facebook::jsi::Runtime &rt,
+                       MainThreadPoster postToMain) {
+  s_runtime = &rt;
+  s_post_to_main = postToMain;
+
+  rt.global().setProperty(
+      rt, "__onFilesDropped",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__onFilesDropped"), 1,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count >= 1 && args[0].isObject() &&
+                args[0].getObject(rt).isFunction(rt)) {
+              s_callback = std::make_unique<facebook::jsi::Function>(
+                  args[0].getObject(rt).getFunction(rt));
+            } else {
+              s_callback.reset();
+            }
+            s_has_callback.store(s_callback != nullptr,
+                                 std::memory_order_relaxed);
+            return facebook::jsi::Value::undefined();
+          }));
+}
+
+void file_drop_capture() {
+  if (!s_has_callback.load(std::memory_order_relaxed) || !s_post_to_main)
+    return;
+  int count = sapp_get_num_dropped_files();
+  if (count <= 0)
+    return;
+  std::vector<std::string> paths;
+  paths.reserve(count);
+  for (int i = 0; i < count; ++i)
+    paths.emplace_back(sapp_get_dropped_file_path(i));
+  s_post_to_main([paths = std::move(paths)] { call_callback(paths); });
+}
+
+void shutdown_file_drop() {
+  s_has_callback.store(false, std::memory_order_relaxed);
+  s_callback.reset();
+  s_post_to_main = nullptr;
+  s_runtime = nullptr;
+}
@@ -0,0 +1,28 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include "AsyncFs.h"
+
+#include <hermes/hermes.h>
+
+/// Files dropped on the window (sappConfig.enable_dragndrop). sokol only
+/// keeps the paths of the last drop, and on some platforms only during the
+/// event callback, so file_drop_capture() copies them on the main thread
+/// as the event arrives, threaded or not, and posts one call of the JS
+/// callback with them. Loading the files is up to JS, through
+/// fs.promises.readFile() or openFileStream(), both on the pool.
+
+/// Install the __onFilesDropped(callback) host function behind jslib's
+/// onFilesDropped(), with `postToMain` for the calls of `callback(paths)`.
+/// An undefined callback removes it.
+void install_file_drop(facebook::jsi::Runtime &rt, MainThreadPoster postToMain);
+
+/// In sokol's event callback, on a SAPP_EVENTTYPE_FILES_DROPPED event: post
+/// the dropped paths to the callback, if there is one.
+void file_drop_capture();
+
+/// Forget the callback. Must be called before the runtime is destroyed.
+void shutdown_file_drop();
@@ -0,0 +1,293 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "FileWatcher.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#else
+#include <sys/event.h>
+#include <sys/time.h>
+#endif
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+/// How often the path of a watch without a file is looked up, in
+/// milliseconds.
+constexpr int kRetryMs = 250;
+
+struct Watch {
+  std::string path;
+  std::function<void()> onChange;
+  /// The inotify watch descriptor (shared by the watches of one file), or
+  /// the descriptor of the file kqueue watches; -1 while there is no file.
+  int target = -1;
+  /// The watched file, to notice that the path now names another one.
+  dev_t dev = 0;
+  ino_t ino = 0;
+};
+
+/// Guards everything below but the thread's own fds.
+std::mutex s_mutex;
+std::unordered_map<unsigned, Watch> s_watches;
+unsigned s_next_id = 1;
+/// The inotify or kqueue descriptor.
+int s_notify_fd = -1;
+/// Written to by shutdown_file_watcher() and by watches added without a
+/// file, so that the thread starts retrying them.
+int s_wake[2] = {-1, -1};
+std::thread s_thread;
+std::atomic<bool> s_stop{false};
+
+/// Watch the file at the watch's path, if there is one. Holds s_mutex.
+bool attach(unsigned id, Watch &w) {
+  struct stat st;
+  if (stat(w.path.c_str(), &st) != 0)
+    return false;
+#if defined(__linux__)
+  int target = inotify_add_watch(s_notify_fd, w.path.c_str(),
+                                 IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF |
+                                     IN_DELETE_SELF);
+  if (target < 0)
+    return false;
+#else
+#ifdef O_EVTONLY
+  int target = open(w.path.c_str(), O_EVTONLY | O_CLOEXEC);
+#else
+  int target = open(w.path.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+  if (target < 0)
+    return false;
+  struct kevent ev;
+  EV_SET(&ev, target, EVFILT_VNODE, EV_ADD | EV_CLEAR,
+         NOTE_WRITE | NOTE_EXTEND | NOTE_ATTRIB | NOTE_DELETE | NOTE_RENAME |
+             NOTE_REVOKE,
+         0, (void *)(uintptr_t)id);
+  if (kevent(s_notify_fd, &ev, 1, nullptr, 0, nullptr) < 0) {
+    close(target);
+    return false;
+  }
+#endif
+  (void)id;
+  w.target = target;
+  w.dev = st.st_dev;
+  w.ino = st.st_ino;
+  return true;
+}
+
+/// Stop watching the watch's file. Holds s_mutex.
+void detach(Watch &w) {
+  if (w.target < 0)
+    return;
+  int target = w.target;
+  w.target = -1;
+#if defined(__linux__)
+  // Watches of the same file share the descriptor
+  for (const auto &other : s_watches) {
+    if (other.second.target == target)
+      return;
+  }
+  inotify_rm_watch(s_notify_fd, target);
+#else
+  // Closing it removes its kevent
+  close(target);
+#endif
+}
+
+/// Whether the path of an attached watch names another file, or none.
+bool replaced(const Watch &w) {
+  struct stat st;
+  return stat(w.path.c_str(), &st) != 0 || st.st_dev != w.dev ||
+         st.st_ino != w.ino;
+}
+
+/// A change of the watch `id`: note its callback, and watch the file at its
+/// path again if that isn't the watched one any more. Holds s_mutex.
+void changed(unsigned id, Watch &w, bool gone,
+             std::vector<std::function<void()>> &calls) {
+  calls.push_back(w.onChange);
+  if (gone || replaced(w)) {
+    detach(w);
+    attach(id, w);
+  }
+}
+
+/// Attach the watches without a file whose path exists now. Returns whether
+/// any is still without one. Holds s_mutex.
+bool retry(std::vector<std::function<void()>> &calls) {
+  bool waiting = false;
+  for (auto &entry : s_watches) {
+    if (entry.second.target >= 0)
+      continue;
+    if (attach(entry.first, entry.second))
+      calls.push_back(entry.second.onChange);
+    else
+      waiting = true;
+  }
+  return waiting;
+}
+
+void drain_wake_pipe() {
+  char buf[64];
+  while (read(s_wake[0], buf, sizeof buf) > 0) {
+  }
+}
+
+void watcher_main() {
+  std::vector<std::function<void()>> calls;
+  bool waiting;
+  {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    waiting = retry(calls);
+  }
+  for (;;) {
+    for (const auto &call : calls)
+      call();
+    calls.clear();
+    if (s_stop.load(std::memory_order_acquire))
+      return;
+
+    int timeout = waiting ? kRetryMs : -1;
+#if defined(__linux__)
+    struct pollfd fds[2] = {{s_wake[0], POLLIN, 0}, {s_notify_fd, POLLIN, 0}};
+    int ready = poll(fds, 2, timeout);
+    if (ready > 0 && (fds[0].revents & POLLIN))
+      drain_wake_pipe();
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (ready > 0 && (fds[1].revents & POLLIN)) {
+      alignas(struct inotify_event) char buf[4096];
+      ssize_t n;
+      while ((n = read(s_notify_fd, buf, sizeof buf)) > 0) {
+        for (char *p = buf; p < buf + n;) {
+          auto *ev = reinterpret_cast<struct inotify_event *>(p);
+          p += sizeof(struct inotify_event) + ev->len;
+          bool gone = ev->mask & (IN_MOVE_SELF | IN_DELETE_SELF | IN_IGNORED);
+          for (auto &entry : s_watches) {
+            // An overflowed queue lost events of any file
+            if ((ev->mask & IN_Q_OVERFLOW) ? entry.second.target >= 0
+                                           : entry.second.target == ev->wd)
+              changed(entry.first, entry.second, gone, calls);
+          }
+        }
+      }
+    }
+#else
+    struct kevent events[32];
+    struct timespec ts = {timeout / 1000, (timeout % 1000) * 1000000L};
+    int ready = kevent(s_notify_fd, nullptr, 0, events, 32,
+                       timeout < 0 ? nullptr : &ts);
+    std::lock_guard<std::mutex> lock(s_mutex);
+    for (int i = 0; i < ready; ++i) {
+      if (events[i].filter != EVFILT_VNODE) {
+        drain_wake_pipe();
+        continue;
+      }
+      auto it = s_watches.find((unsigned)(uintptr_t)events[i].udata);
+      if (it == s_watches.end() || it->second.target != (int)events[i].ident)
+        continue;
+      bool gone = events[i].fflags & (NOTE_DELETE | NOTE_RENAME | NOTE_REVOKE);
+      changed(it->first, it->second, gone, calls);
+    }
+#endif
+    waiting = retry(calls);
+  }
+}
+
+/// Create the descriptors and start the thread. Holds s_mutex.
+bool start_watcher() {
+#if defined(__linux__)
+  s_notify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#else
+  s_notify_fd = kqueue();
+  if (s_notify_fd >= 0)
+    fcntl(s_notify_fd, F_SETFD, FD_CLOEXEC);
+#endif
+  if (s_notify_fd < 0 || pipe(s_wake) < 0) {
+    perror("FileWatcher");
+    if (s_notify_fd >= 0)
+      close(s_notify_fd);
+    s_notify_fd = -1;
+    return false;
+  }
+  for (int fd : s_wake) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+  }
+#if !defined(__linux__)
+  struct kevent ev;
+  EV_SET(&ev, s_wake[0], EVFILT_READ, EV_ADD, 0, 0, nullptr);
+  kevent(s_notify_fd, &ev, 1, nullptr, 0, nullptr);
+#endif
+  s_stop.store(false, std::memory_order_relaxed);
+  s_thread = std::thread(watcher_main);
+  return true;
+}
+
+void wake_watcher() {
+  char c = 1;
+  (void)!write(s_wake[1], &c, 1);
+}
+
+} // namespace
+
+unsigned watch_file(const std::string &path, std::function<void()> onChange) {
+  std::lock_guard<std::mutex> lock(s_mutex);
+  if (s_notify_fd < 0 && !start_watcher())
+    return 0;
+  unsigned id = s_next_id++;
+  Watch &w = s_watches[id];
+  w.path = path;
+  w.onChange = std::move(onChange);
+  // Without a file yet, the thread looks for one
+  if (!attach(id, w))
+    wake_watcher();
+  return id;
+}
+
+void unwatch_file(unsigned id) {
+  std::lock_guard<std::mutex> lock(s_mutex);
+  auto it = s_watches.find(id);
+  if (it == s_watches.end())
+    return;
+  Watch w = std::move(it->second);
+  s_watches.erase(it);
+  detach(w);
+}
+
+void shutdown_file_watcher() {
+  {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (s_notify_fd < 0)
+      return;
+    s_stop.store(true, std::memory_order_release);
+    wake_watcher();
+  }
+  s_thread.join();
+  std::lock_guard<std::mutex> lock(s_mutex);
+#if !defined(__linux__)
+  for (auto &entry : s_watches) {
+    if (entry.second.target >= 0)
+      close(entry.second.target);
+  }
+#endif
+  s_watches.clear();
+  close(s_notify_fd);
+  close(s_wake[0]);
+  close(s_wake[1]);
+  s_notify_fd = -1;
+  s_wake[0] = s_wake[1] = -1;
+}
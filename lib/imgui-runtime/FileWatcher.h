@@ -0,0 +1,29 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include <functional>
+#include <string>
+
+/// Change notifications for files, from one native thread waiting on
+/// inotify (Linux) or kqueue (macOS and the BSDs), started with the first
+/// watch. Nothing polls while a watched file is unchanged. A file that is
+/// removed or renamed away, as by log rotation, is looked up again every
+/// kRetrySeconds until its path exists again, and the new file is watched.
+
+/// Call `onChange` on the watcher thread whenever the file at `path` is
+/// written to, truncated, replaced or removed. Changes that arrive together
+/// make one call, so `onChange` should note the change and hand the work to
+/// another thread rather than do it. The path need not exist yet. Returns
+/// the watch's ID. Any thread.
+unsigned watch_file(const std::string &path, std::function<void()> onChange);
+
+/// Stop a watch. A call of its `onChange` in progress may still finish.
+/// Any thread.
+void unwatch_file(unsigned id);
+
+/// Stop the watcher thread and drop the watches. Must be called before
+/// whatever the callbacks use is destroyed, e.g. the thread pool.
+void shutdown_file_watcher();
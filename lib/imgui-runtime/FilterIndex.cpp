@@ -0,0 +1,281 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "FilterIndex.h"
+
+#include "SharedBuffer.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+struct Index {
+  /// The folded strings, each followed by a NUL.
+  std::vector<uint8_t> arena;
+  /// Where each string starts in `arena`, and its end.
+  std::vector<uint32_t> starts;
+  /// The last query and its matches.
+  bool queried = false;
+  std::string lastQuery;
+  std::vector<int32_t> last;
+
+  size_t count() const { return starts.size() - 1; }
+
+  void add(const uint8_t *bytes, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+      uint8_t c = bytes[i];
+      // A NUL would let a match span two strings
+      arena.push_back(c >= 'A' && c <= 'Z' ? c | 0x20 : c ? c : 1);
+    }
+    arena.push_back(0);
+    starts.push_back((uint32_t)arena.size());
+  }
+};
+
+/// Main thread only.
+std::unordered_map<unsigned, std::unique_ptr<Index>> s_indexes;
+unsigned s_next_id = 1;
+
+std::string fold(std::string query) {
+  for (char &c : query) {
+    if (c >= 'A' && c <= 'Z')
+      c |= 0x20;
+  }
+  // The separators match no query
+  size_t nul = query.find('\0');
+  if (nul != std::string::npos)
+    query.resize(nul);
+  return query;
+}
+
+#if defined(__SSE2__)
+constexpr int kMaskBitsPerByte = 1;
+
+/// Bit i * kMaskBitsPerByte is set where data[i] == first and
+/// data[i + n - 1] == last, for i in [0, 16).
+inline uint64_t candidates(const uint8_t *data, size_t n, __m128i first,
+                           __m128i last) {
+  __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+  __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + n - 1));
+  return (unsigned)_mm_movemask_epi8(
+      _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+}
+#elif defined(__ARM_NEON)
+constexpr int kMaskBitsPerByte = 4;
+
+inline uint64_t candidates(const uint8_t *data, size_t n, uint8x16_t first,
+                           uint8x16_t last) {
+  uint8x16_t eq = vandq_u8(vceqq_u8(vld1q_u8(data), first),
+                           vceqq_u8(vld1q_u8(data + n - 1), last));
+  // Narrowing by 4 bits keeps a nibble per byte
+  uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+  return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0) & 0x1111111111111111ull;
+}
+#endif
+
+/// The strings of `index` containing the folded, non-empty `query`.
+std::vector<int32_t> scan_all(const Index &index, const std::string &query) {
+  std::vector<int32_t> result;
+  const uint8_t *data = index.arena.data();
+  const auto *q = reinterpret_cast<const uint8_t *>(query.data());
+  size_t n = query.size();
+  size_t size = index.arena.size();
+  size_t s = 0;
+  // A match at `pos`: note its string and go on after it
+  auto matched = [&](size_t pos) {
+    while (index.starts[s + 1] <= pos)
+      ++s;
+    result.push_back((int32_t)s);
+    return (size_t)index.starts[s + 1];
+  };
+  size_t p = 0;
+#if defined(__SSE2__) || defined(__ARM_NEON)
+#if defined(__SSE2__)
+  __m128i first = _mm_set1_epi8((char)q[0]);
+  __m128i last = _mm_set1_epi8((char)q[n - 1]);
+#else
+  uint8x16_t first = vdupq_n_u8(q[0]);
+  uint8x16_t last = vdupq_n_u8(q[n - 1]);
+#endif
+  while (p + n - 1 + 16 <= size) {
+    uint64_t mask = candidates(data + p, n, first, last);
+    size_t next = p + 16;
+    while (mask) {
+      size_t pos = p + __builtin_ctzll(mask) / kMaskBitsPerByte;
+      if (n <= 2 || memcmp(data + pos + 1, q + 1, n - 2) == 0) {
+        next = matched(pos);
+        break;
+      }
+      mask &= mask - 1;
+    }
+    p = next;
+  }
+#endif
+  while (p + n <= size) {
+    const void *hit = memchr(data + p, q[0], size - n + 1 - p);
+    if (!hit)
+      break;
+    size_t pos = (size_t)(static_cast<const uint8_t *>(hit) - data);
+    p = memcmp(data + pos, q, n) == 0 ? matched(pos) : pos + 1;
+  }
+  return result;
+}
+
+/// Whether string `i` of `index` contains the folded, non-empty `query`.
+bool contains(const Index &index, size_t i, const std::string &query) {
+  const uint8_t *begin = index.arena.data() + index.starts[i];
+  const uint8_t *end = index.arena.data() + index.starts[i + 1] - 1;
+  const auto *q = reinterpret_cast<const uint8_t *>(query.data());
+  size_t n = query.size();
+  for (const uint8_t *p = begin; (size_t)(end - p) >= n;) {
+    const void *hit = memchr(p, q[0], (size_t)(end - p) - n + 1);
+    if (!hit)
+      return false;
+    p = static_cast<const uint8_t *>(hit);
+    if (memcmp(p, q, n) == 0)
+      return true;
+    ++p;
+  }
+  return false;
+}
+
+/// The matches of `query`, from the last ones if it contains the last
+/// query.
+const std::vector<int32_t> &query_index(Index &index, std::string query) {
+  query = fold(std::move(query));
+  if (index.queried && query == index.lastQuery)
+    return index.last;
+  std::vector<int32_t> result;
+  if (query.empty()) {
+    result.resize(index.count());
+    for (size_t i = 0; i < result.size(); ++i)
+      result[i] = (int32_t)i;
+  } else if (!index.lastQuery.empty() &&
+             query.find(index.lastQuery) != std::string::npos) {
+    for (int32_t i : index.last) {
+      if (contains(index, (size_t)i, query))
+        result.push_back(i);
+    }
+  } else {
+    result = scan_all(index, query);
+  }
+  index.queried = true;
+  index.lastQuery = std::move(query);
+  index.last = std::move(result);
+  return index.last;
+}
+
+/// The bytes of ArrayBuffer args[i] from args[i + 1] onwards, which must
+/// hold `bytes` bytes.
+const uint8_t *bytes_arg(facebook::jsi::Runtime &rt,
+                         const facebook::jsi::Value *args, size_t count,
+                         size_t i, size_t bytes) {
+  if (i + 1 >= count || !args[i].isObject() ||
+      !args[i].getObject(rt).isArrayBuffer(rt) || !args[i + 1].isNumber())
+    throw facebook::jsi::JSError(rt, "__filterCreate expects ArrayBuffers");
+  facebook::jsi::ArrayBuffer ab = args[i].getObject(rt).getArrayBuffer(rt);
+  double offset = args[i + 1].getNumber();
+  if (!(offset >= 0) || offset > ab.size(rt) ||
+      bytes > ab.size(rt) - (size_t)offset)
+    throw facebook::jsi::JSError(rt, "__filterCreate: bad range");
+  return ab.data(rt) + (size_t)offset;
+}
+
+} // namespace
+
+void install_filter_indexes(facebook::jsi::Runtime &rt) {
+  rt.global().setProperty(
+      rt, "__filterCreate",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__filterCreate"), 7,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            auto index = std::make_unique<Index>();
+            index->starts.push_back(0);
+            if (count > 0 && args[0].isObject()) {
+              facebook::jsi::Array strings = args[0].getObject(rt).getArray(rt);
+              size_t n = strings.size(rt);
+              index->starts.reserve(n + 1);
+              for (size_t i = 0; i < n; ++i) {
+                facebook::jsi::Value v = strings.getValueAtIndex(rt, i);
+                std::string s = v.isString() ? v.getString(rt).utf8(rt)
+                                             : v.toString(rt).utf8(rt);
+                index->add(reinterpret_cast<const uint8_t *>(s.data()),
+                           s.size());
+              }
+            } else {
+              // A StringColumn: (offsets, offset, count + 1, bytes, offset,
+              // length)
+              double n = count > 3 && args[3].isNumber() ? args[3].getNumber()
+                                                         : 0;
+              double length =
+                  count > 6 && args[6].isNumber() ? args[6].getNumber() : 0;
+              if (!(n >= 1) || !(length >= 0))
+                throw facebook::jsi::JSError(
+                    rt, "__filterCreate expects strings or a StringColumn");
+              auto *offsets = reinterpret_cast<const uint32_t *>(
+                  bytes_arg(rt, args, count, 1, (size_t)n * 4));
+              const uint8_t *bytes =
+                  bytes_arg(rt, args, count, 4, (size_t)length);
+              index->starts.reserve((size_t)n);
+              index->arena.reserve((size_t)length + (size_t)n);
+              for (size_t i = 0; i + 1 < (size_t)n; ++i) {
+                uint32_t from = offsets[i], to = offsets[i + 1];
+                if (from > to || to > length)
+                  throw facebook::jsi::JSError(
+                      rt, "__filterCreate: bad StringColumn offsets");
+                index->add(bytes + from, to - from);
+              }
+            }
+            unsigned id = s_next_id++;
+            s_indexes.emplace(id, std::move(index));
+            return (double)id;
+          }));
+
+  rt.global().setProperty(
+      rt, "__filterQuery",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__filterQuery"), 2,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            auto it = count > 1 && args[0].isNumber() && args[1].isString()
+                          ? s_indexes.find((unsigned)args[0].getNumber())
+                          : s_indexes.end();
+            if (it == s_indexes.end())
+              throw facebook::jsi::JSError(
+                  rt, "__filterQuery expects an open index and a string");
+            std::vector<int32_t> matches(
+                query_index(*it->second, args[1].getString(rt).utf8(rt)));
+            auto buffer =
+                std::make_shared<VectorBuffer<int32_t>>(std::move(matches));
+            return facebook::jsi::ArrayBuffer(rt, std::move(buffer));
+          }));
+
+  rt.global().setProperty(
+      rt, "__filterClose",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__filterClose"), 1,
+          [](facebook::jsi::Runtime &, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count > 0 && args[0].isNumber())
+              s_indexes.erase((unsigned)args[0].getNumber());
+            return facebook::jsi::Value::undefined();
+          }));
+}
+
+void shutdown_filter_indexes() { s_indexes.clear(); }
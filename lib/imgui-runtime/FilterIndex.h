@@ -0,0 +1,33 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include <hermes/hermes.h>
+
+/// Substring filters over large string lists behind jslib's
+/// createFilterIndex(), for type-to-filter boxes.
+///
+/// An index copies its strings once into an arena, folded to lower case
+/// (ASCII letters; other bytes match exactly) and separated by NULs so that
+/// no match spans two strings. A query scans the whole arena 16 bytes at a
+/// time (SSE2 or NEON, a scalar loop elsewhere), testing the first and the
+/// last byte of the query at every position at once and comparing the rest
+/// only where both match; a hit skips to the next string.
+///
+/// The index keeps its last query and result. A query that contains the
+/// last one can only match strings that matched it, so typing one more
+/// character rechecks the previous matches instead of scanning everything.
+///
+/// Host functions:
+///  - __filterCreate(strings) returns the ID of an index over an array of
+///    strings; __filterCreate(null, offsets, offsetsByteOffset, count + 1,
+///    bytes, bytesByteOffset, length) over the buffers of a StringColumn;
+///  - __filterQuery(id, query) returns an ArrayBuffer of the int32 indices
+///    of the strings containing `query`, in order;
+///  - __filterClose(id) drops an index.
+void install_filter_indexes(facebook::jsi::Runtime &rt);
+
+/// Drop the indexes.
+void shutdown_filter_indexes();
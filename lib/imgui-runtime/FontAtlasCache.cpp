@@ -0,0 +1,403 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "FontAtlasCache.h"
+
+#include "MappedFileBuffer.h"
+#include "TextMeasure.h"
+#include "ThreadPool.h"
+
+// The C++ API: restoring an atlas needs ImGui's internal build steps, which
+// cimgui doesn't expose.
+#include "imgui/imgui.h"
+#include "imgui/imgui_internal.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <vector>
+
+namespace {
+
+std::string s_dir;
+/// Largest side of the atlas texture, 0 for no limit.
+int s_max_size = 0;
+
+/// The atlas of font_atlas_cache_prebuild(), with the cache directory and
+/// key its build used.
+ImFontAtlas *s_prebuilt = nullptr;
+std::string s_prebuilt_dir;
+uint64_t s_prebuilt_key = 0;
+std::future<void> s_prebuilt_done;
+
+constexpr char kMagic[4] = {'I', 'F', 'A', 'C'};
+constexpr uint32_t kVersion = 1;
+
+/// Layout of a cache file: the header, `rectCount` CachedRects, `fontCount`
+/// CachedFonts each followed by its glyphs, then the alpha8 pixels.
+struct CacheHeader {
+  char magic[4];
+  uint32_t version;
+  uint64_t key;
+  int32_t texWidth, texHeight;
+  int32_t packIdMouseCursors, packIdLines;
+  uint32_t rectCount, fontCount;
+};
+
+struct CachedRect {
+  uint16_t width, height, x, y;
+  uint32_t glyphId;
+  float glyphAdvanceX;
+  float glyphOffsetX, glyphOffsetY;
+  /// Index in ImFontAtlas::Fonts, -1 without a font.
+  int32_t font;
+};
+
+struct CachedFont {
+  float ascent, descent;
+  uint32_t glyphCount;
+};
+
+/// FNV-1a, 64 bit.
+struct Hash {
+  uint64_t value = 14695981039346656037ull;
+
+  void add(const void *data, size_t size) {
+    auto *p = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i) {
+      value ^= p[i];
+      value *= 1099511628211ull;
+    }
+  }
+  template <typename T> void add(const T &v) { add(&v, sizeof(v)); }
+};
+
+int font_index(const ImFontAtlas *atlas, const ImFont *font) {
+  for (int i = 0; i < atlas->Fonts.Size; ++i)
+    if (atlas->Fonts[i] == font)
+      return i;
+  return -1;
+}
+
+/// Everything the build depends on, before it runs.
+uint64_t build_key(ImFontAtlas *atlas) {
+  Hash h;
+  h.add(IMGUI_VERSION_NUM);
+  h.add(sizeof(ImFontGlyph));
+  h.add(atlas->Flags);
+  h.add(atlas->TexDesiredWidth);
+  h.add(atlas->TexGlyphPadding);
+  h.add(atlas->FontBuilderFlags);
+  h.add(atlas->FontBuilderIO != nullptr);
+  h.add(s_max_size);
+  for (const ImFontConfig &cfg : atlas->ConfigData) {
+    h.add(cfg.FontData, (size_t)cfg.FontDataSize);
+    h.add(cfg.FontNo);
+    h.add(cfg.SizePixels);
+    h.add(cfg.OversampleH);
+    h.add(cfg.OversampleV);
+    h.add(cfg.PixelSnapH);
+    h.add(cfg.GlyphExtraSpacing);
+    h.add(cfg.GlyphOffset);
+    const ImWchar *ranges =
+        cfg.GlyphRanges ? cfg.GlyphRanges : atlas->GetGlyphRangesDefault();
+    for (; ranges[0]; ranges += 2)
+      h.add(ranges, 2 * sizeof(ImWchar));
+    h.add(cfg.GlyphMinAdvanceX);
+    h.add(cfg.GlyphMaxAdvanceX);
+    h.add(cfg.MergeMode);
+    h.add(cfg.FontBuilderFlags);
+    h.add(cfg.RasterizerMultiply);
+    h.add(cfg.EllipsisChar);
+    h.add(font_index(atlas, cfg.DstFont));
+  }
+  for (const ImFontAtlasCustomRect &r : atlas->CustomRects) {
+    h.add(r.Width);
+    h.add(r.Height);
+    h.add(r.GlyphID);
+    h.add(r.GlyphAdvanceX);
+    h.add(r.GlyphOffset);
+    h.add(font_index(atlas, r.Font));
+  }
+  return h.value;
+}
+
+std::string cache_path(const std::string &dir, uint64_t key) {
+  char name[64];
+  snprintf(name, sizeof(name), "/font-atlas-%016llx.bin",
+           (unsigned long long)key);
+  return dir + name;
+}
+
+/// Reads consecutive records out of a mapped file, failing once one would
+/// extend past its end.
+struct Reader {
+  const uint8_t *p, *end;
+
+  template <typename T> const T *take(size_t count = 1) {
+    if ((size_t)(end - p) / sizeof(T) < count)
+      return nullptr;
+    auto *result = reinterpret_cast<const T *>(p);
+    p += sizeof(T) * count;
+    return result;
+  }
+};
+
+bool restore(ImFontAtlas *atlas, uint64_t key, const std::string &path) {
+  std::shared_ptr<facebook::jsi::Buffer> buffer;
+  try {
+    buffer = mapFileBuffer(path.c_str());
+  } catch (const std::exception &) {
+    return false;
+  }
+  Reader in{buffer->data(), buffer->data() + buffer->size()};
+  const CacheHeader *header = in.take<CacheHeader>();
+  if (!header || memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 ||
+      header->version != kVersion || header->key != key ||
+      header->texWidth <= 0 || header->texHeight <= 0 ||
+      header->fontCount != (uint32_t)atlas->Fonts.Size)
+    return false;
+  const CachedRect *rects = in.take<CachedRect>(header->rectCount);
+  if (!rects)
+    return false;
+  std::vector<const CachedFont *> fonts;
+  std::vector<const ImFontGlyph *> glyphs;
+  for (uint32_t i = 0; i < header->fontCount; ++i) {
+    const CachedFont *font = in.take<CachedFont>();
+    const ImFontGlyph *fontGlyphs =
+        font ? in.take<ImFontGlyph>(font->glyphCount) : nullptr;
+    if (!fontGlyphs)
+      return false;
+    fonts.push_back(font);
+    glyphs.push_back(fontGlyphs);
+  }
+  size_t pixelCount = (size_t)header->texWidth * header->texHeight;
+  const uint8_t *pixels = in.take<uint8_t>(pixelCount);
+  if (!pixels)
+    return false;
+
+  atlas->ClearTexData();
+  atlas->TexWidth = header->texWidth;
+  atlas->TexHeight = header->texHeight;
+  atlas->TexUvScale = ImVec2(1.0f / atlas->TexWidth, 1.0f / atlas->TexHeight);
+  atlas->TexPixelsAlpha8 = (unsigned char *)IM_ALLOC(pixelCount);
+  memcpy(atlas->TexPixelsAlpha8, pixels, pixelCount);
+  atlas->PackIdMouseCursors = header->packIdMouseCursors;
+  atlas->PackIdLines = header->packIdLines;
+  atlas->CustomRects.resize((int)header->rectCount);
+  for (uint32_t i = 0; i < header->rectCount; ++i) {
+    ImFontAtlasCustomRect &r = atlas->CustomRects[(int)i];
+    const CachedRect &c = rects[i];
+    r.Width = c.width;
+    r.Height = c.height;
+    r.X = c.x;
+    r.Y = c.y;
+    r.GlyphID = c.glyphId;
+    r.GlyphAdvanceX = c.glyphAdvanceX;
+    r.GlyphOffset = ImVec2(c.glyphOffsetX, c.glyphOffsetY);
+    // The cached glyph tables already have the custom glyphs, which
+    // ImFontAtlasBuildFinish() would add again.
+    r.Font = nullptr;
+  }
+
+  for (ImFontConfig &cfg : atlas->ConfigData) {
+    int index = font_index(atlas, cfg.DstFont);
+    ImFontAtlasBuildSetupFont(atlas, cfg.DstFont, &cfg, fonts[index]->ascent,
+                              fonts[index]->descent);
+  }
+  for (int i = 0; i < atlas->Fonts.Size; ++i) {
+    ImFont *font = atlas->Fonts[i];
+    font->Glyphs.resize((int)fonts[i]->glyphCount);
+    memcpy(font->Glyphs.Data, glyphs[i],
+           sizeof(ImFontGlyph) * fonts[i]->glyphCount);
+    font->DirtyLookupTables = true;
+  }
+  ImFontAtlasBuildFinish(atlas);
+  for (uint32_t i = 0; i < header->rectCount; ++i)
+    if (rects[i].font >= 0)
+      atlas->CustomRects[(int)i].Font = atlas->Fonts[rects[i].font];
+  return true;
+}
+
+/// Create `dir` and its parent, if they don't exist.
+void make_dirs(const std::string &dir) {
+  size_t slash = dir.find_last_of('/');
+  if (slash != std::string::npos && slash > 0)
+    mkdir(dir.substr(0, slash).c_str(), 0755);
+  mkdir(dir.c_str(), 0755);
+}
+
+void save(const ImFontAtlas *atlas, uint64_t key, const std::string &dir,
+          const std::string &path) {
+  // Builders that render colored glyphs only produce RGBA32 pixels.
+  if (!atlas->TexPixelsAlpha8)
+    return;
+  make_dirs(dir);
+  // Written to a temporary file and renamed, so that a concurrent launch
+  // never maps a partial file.
+  std::string tmpPath = path + "." + std::to_string(getpid());
+  FILE *f = fopen(tmpPath.c_str(), "wb");
+  if (!f) {
+    fprintf(stderr, "Can't write font atlas cache %s: %s\n", tmpPath.c_str(),
+            strerror(errno));
+    return;
+  }
+
+  CacheHeader header{};
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.key = key;
+  header.texWidth = atlas->TexWidth;
+  header.texHeight = atlas->TexHeight;
+  header.packIdMouseCursors = atlas->PackIdMouseCursors;
+  header.packIdLines = atlas->PackIdLines;
+  header.rectCount = (uint32_t)atlas->CustomRects.Size;
+  header.fontCount = (uint32_t)atlas->Fonts.Size;
+  bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+  for (const ImFontAtlasCustomRect &r : atlas->CustomRects) {
+    CachedRect c{r.Width,         r.Height,        r.X,
+                 r.Y,             r.GlyphID,       r.GlyphAdvanceX,
+                 r.GlyphOffset.x, r.GlyphOffset.y, font_index(atlas, r.Font)};
+    ok = ok && fwrite(&c, sizeof(c), 1, f) == 1;
+  }
+  for (const ImFont *font : atlas->Fonts) {
+    CachedFont c{font->Ascent, font->Descent, (uint32_t)font->Glyphs.Size};
+    ok = ok && fwrite(&c, sizeof(c), 1, f) == 1;
+    ok = ok && fwrite(font->Glyphs.Data, sizeof(ImFontGlyph),
+                      (size_t)font->Glyphs.Size,
+                      f) == (size_t)font->Glyphs.Size;
+  }
+  size_t pixelCount = (size_t)atlas->TexWidth * atlas->TexHeight;
+  ok = ok && fwrite(atlas->TexPixelsAlpha8, 1, pixelCount, f) == pixelCount;
+  ok = fclose(f) == 0 && ok;
+  if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+    fprintf(stderr, "Can't write font atlas cache %s\n", path.c_str());
+    unlink(tmpPath.c_str());
+  }
+}
+
+/// Build `atlas`. If its texture is larger than s_max_size, build it again
+/// at most s_max_size wide and without oversampling, which halves the area
+/// of its glyphs, and report it if that still doesn't fit.
+void build_within_limit(ImFontAtlas *atlas) {
+  atlas->Build();
+  if (!s_max_size ||
+      (atlas->TexWidth <= s_max_size && atlas->TexHeight <= s_max_size))
+    return;
+  for (ImFontConfig &cfg : atlas->ConfigData) {
+    cfg.OversampleH = 1;
+    cfg.OversampleV = 1;
+  }
+  if (!atlas->TexDesiredWidth || atlas->TexDesiredWidth > s_max_size)
+    atlas->TexDesiredWidth = s_max_size;
+  atlas->ClearTexData();
+  atlas->Build();
+  if (atlas->TexWidth > s_max_size || atlas->TexHeight > s_max_size)
+    fprintf(stderr,
+            "Font atlas is %dx%d, over the limit of %d; use fewer fonts, "
+            "sizes or glyph ranges\n",
+            atlas->TexWidth, atlas->TexHeight, s_max_size);
+}
+
+/// font_atlas_cache_build() with the cache in `dir`. Returns the key of the
+/// build.
+uint64_t build(ImFontAtlas *atlas, const std::string &dir) {
+  if (atlas->ConfigData.Size == 0)
+    atlas->AddFontDefault();
+  uint64_t key = build_key(atlas);
+  if (dir.empty()) {
+    build_within_limit(atlas);
+    return key;
+  }
+
+  std::string path = cache_path(dir, key);
+  if (restore(atlas, key, path)) {
+    printf("Font atlas loaded from %s\n", path.c_str());
+    return key;
+  }
+  build_within_limit(atlas);
+  save(atlas, key, dir, path);
+  return key;
+}
+
+} // namespace
+
+void font_atlas_cache_set_dir(const std::string &dir) { s_dir = dir; }
+
+void font_atlas_cache_set_max_size(int size) { s_max_size = size; }
+
+std::string font_atlas_cache_default_dir() {
+  std::string base;
+  if (const char *xdg = getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+    base = xdg;
+  } else if (const char *home = getenv("HOME"); home && *home) {
+#ifdef __APPLE__
+    base = std::string(home) + "/Library/Caches";
+#else
+    base = std::string(home) + "/.cache";
+#endif
+  } else {
+    return std::string();
+  }
+  return base + "/imgui-react-runtime";
+}
+
+void font_atlas_cache_build(ImFontAtlas *atlas) {
+  // Glyph metrics may change with the new atlas
+  text_measure_invalidate();
+  // Already built by font_atlas_cache_prebuild()
+  if (atlas->IsBuilt())
+    return;
+  build(atlas, s_dir);
+}
+
+void font_atlas_cache_build_standalone(ImFontAtlas *atlas) {
+  if (!atlas->IsBuilt())
+    build(atlas, s_dir);
+}
+
+void font_atlas_cache_prebuild(ThreadPool &pool) {
+  if (s_prebuilt)
+    return;
+  s_prebuilt = IM_NEW(ImFontAtlas)();
+  s_prebuilt_dir = s_dir;
+  auto done = std::make_shared<std::promise<void>>();
+  s_prebuilt_done = done->get_future();
+  pool.post(
+      [done] {
+        s_prebuilt_key = build(s_prebuilt, s_prebuilt_dir);
+        // The RGBA32 conversion simgui_setup() asks for
+        unsigned char *pixels;
+        int width, height;
+        s_prebuilt->GetTexDataAsRGBA32(&pixels, &width, &height);
+        done->set_value();
+      },
+      {TaskPriority::Interactive});
+}
+
+ImFontAtlas *font_atlas_cache_take_prebuilt() {
+  if (!s_prebuilt)
+    return nullptr;
+  s_prebuilt_done.get();
+  // sappConfig.font_cache is read after the build started, which then ran
+  // without it: write the file its next start won't have to build again.
+  if (!s_dir.empty() && s_dir != s_prebuilt_dir) {
+    std::string path = cache_path(s_dir, s_prebuilt_key);
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0)
+      save(s_prebuilt, s_prebuilt_key, s_dir, path);
+  }
+  return s_prebuilt;
+}
+
+void font_atlas_cache_destroy_prebuilt() {
+  IM_DELETE(s_prebuilt);
+  s_prebuilt = nullptr;
+}
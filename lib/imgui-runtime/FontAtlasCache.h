@@ -0,0 +1,53 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include <string>
+
+struct ImFontAtlas;
+class ThreadPool;
+
+/// On-disk cache of the built ImGui font atlas: the rasterized texture, the
+/// packed rectangles and the glyph tables of every font. A cache file is
+/// keyed by a hash of everything that goes into the build (font data, sizes,
+/// glyph ranges, oversampling, the ImGui version), so a change of any of
+/// them builds and writes a new one.
+
+/// The directory holding the cache files; empty disables the cache.
+void font_atlas_cache_set_dir(const std::string &dir);
+
+/// Limit the atlas texture to `size` pixels a side (0: no limit). A larger
+/// atlas is built again without oversampling, and reported on stderr if it
+/// is still too large. Must be called before font_atlas_cache_prebuild().
+void font_atlas_cache_set_max_size(int size);
+
+/// The per-user cache directory of the runtime: $XDG_CACHE_HOME or
+/// ~/.cache (~/Library/Caches on macOS), plus /imgui-react-runtime.
+std::string font_atlas_cache_default_dir();
+
+/// Build `atlas` (with the default font if it has none), restoring it from
+/// the cache when there is a matching file and writing one otherwise. The
+/// atlas is then ready, so ImFontAtlas::GetTexDataAsRGBA32() only converts
+/// the pixels. An atlas that is already built is left alone.
+void font_atlas_cache_build(ImFontAtlas *atlas);
+
+/// font_atlas_cache_build() for a standalone atlas that no context uses
+/// yet (a <font>'s), from any thread. Text measurements, which are of the
+/// default font, are kept.
+void font_atlas_cache_build_standalone(ImFontAtlas *atlas);
+
+/// Start building a standalone atlas with the default font, through the
+/// cache directory set so far, on one of the workers of `pool`, so that the
+/// rasterization overlaps runtime and unit initialization.
+void font_atlas_cache_prebuild(ThreadPool &pool);
+
+/// Wait for the atlas of font_atlas_cache_prebuild(), for ImGui contexts to
+/// share; null if none was started. When a cache directory was only set
+/// after the build started, the atlas is written there if that has no file
+/// for it yet.
+ImFontAtlas *font_atlas_cache_take_prebuilt();
+
+/// Free the prebuilt atlas, once no context uses it.
+void font_atlas_cache_destroy_prebuilt();
@@ -0,0 +1,225 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "FontRegistry.h"
+
+#include "FontAtlasCache.h"
+#include "MappedFileBuffer.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+
+#include "imgui/imgui.h"
+
+#include "sokol_app.h"
+#include "sokol_gfx.h"
+#include "sokol_imgui.h"
+
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+struct Font {
+  std::string file;
+  float size;
+  int ranges;
+  /// Keeps the font file mapped: the atlas doesn't copy it.
+  std::shared_ptr<facebook::jsi::Buffer> data;
+  ImFontAtlas *atlas = IM_NEW(ImFontAtlas)();
+  /// Set once the texture is made; the atlas and `font` don't change after.
+  std::atomic<bool> ready{false};
+  ImFont *font = nullptr;
+  sg_image image = {};
+  simgui_image_t simguiImage = {};
+
+  ~Font() { IM_DELETE(atlas); }
+};
+
+ThreadPool *s_pool = nullptr;
+bool s_gpu = true;
+MainThreadPoster s_post = nullptr;
+
+/// Fonts by handle, and the handle of each (file, size, ranges). Thread of
+/// the ImGui context only.
+std::vector<std::shared_ptr<Font>> s_fonts;
+std::map<std::tuple<std::string, float, int>, int> s_handles;
+
+/// Fonts built and waiting for font_registry_upload().
+std::mutex s_built_mutex;
+std::vector<std::shared_ptr<Font>> s_built;
+
+/// Render thread: the fonts with a texture, and the sampler they share.
+std::vector<std::shared_ptr<Font>> s_uploaded;
+sg_sampler s_sampler = {};
+
+const ImWchar *glyph_ranges(ImFontAtlas *atlas, int ranges) {
+  switch (ranges) {
+  case FontRangesGreek:
+    return atlas->GetGlyphRangesGreek();
+  case FontRangesCyrillic:
+    return atlas->GetGlyphRangesCyrillic();
+  case FontRangesKorean:
+    return atlas->GetGlyphRangesKorean();
+  case FontRangesJapanese:
+    return atlas->GetGlyphRangesJapanese();
+  case FontRangesChinese:
+    return atlas->GetGlyphRangesChineseSimplifiedCommon();
+  case FontRangesChineseFull:
+    return atlas->GetGlyphRangesChineseFull();
+  case FontRangesThai:
+    return atlas->GetGlyphRangesThai();
+  case FontRangesVietnamese:
+    return atlas->GetGlyphRangesVietnamese();
+  default:
+    return atlas->GetGlyphRangesDefault();
+  }
+}
+
+/// Worker job: add the font to its atlas, build it and convert its pixels
+/// for the texture.
+void build_font(const std::shared_ptr<Font> &font) {
+  ImFontAtlas *atlas = font->atlas;
+  ImFontConfig cfg;
+  cfg.GlyphRanges = glyph_ranges(atlas, font->ranges);
+  if (font->file.empty()) {
+    // As AddFontDefault() without a config
+    cfg.SizePixels = font->size;
+    cfg.OversampleH = cfg.OversampleV = 1;
+    cfg.PixelSnapH = true;
+    atlas->AddFontDefault(&cfg);
+  } else {
+    try {
+      font->data = mapFileBuffer(font->file.c_str());
+    } catch (const std::exception &e) {
+      fprintf(stderr, "Can't load font %s: %s\n", font->file.c_str(),
+              e.what());
+      return;
+    }
+    // Only read, and not freed by the atlas
+    cfg.FontDataOwnedByAtlas = false;
+    void *data = const_cast<uint8_t *>(font->data->data());
+    if (!atlas->AddFontFromMemoryTTF(data, (int)font->data->size(), font->size,
+                                     &cfg, cfg.GlyphRanges)) {
+      fprintf(stderr, "Can't load font %s\n", font->file.c_str());
+      return;
+    }
+  }
+  font_atlas_cache_build_standalone(atlas);
+  if (!atlas->IsBuilt()) {
+    fprintf(stderr, "Can't build font %s\n",
+            font->file.empty() ? "default" : font->file.c_str());
+    return;
+  }
+  unsigned char *pixels;
+  int width, height;
+  atlas->GetTexDataAsRGBA32(&pixels, &width, &height);
+  font->font = atlas->Fonts[0];
+  {
+    std::lock_guard<std::mutex> lock(s_built_mutex);
+    s_built.push_back(font);
+  }
+  // An idle main thread draws a frame, which uploads it
+  s_post([] {});
+}
+
+} // namespace
+
+void install_font_registry(ThreadPool &pool, bool gpu,
+                           MainThreadPoster postToMain) {
+  s_pool = &pool;
+  s_gpu = gpu;
+  s_post = postToMain;
+}
+
+void font_registry_upload() {
+  std::vector<std::shared_ptr<Font>> built;
+  {
+    std::lock_guard<std::mutex> lock(s_built_mutex);
+    if (s_built.empty())
+      return;
+    std::swap(built, s_built);
+  }
+  for (auto &font : built) {
+    if (s_gpu) {
+      if (s_sampler.id == SG_INVALID_ID)
+        s_sampler = sg_make_sampler(sg_sampler_desc{
+            .min_filter = SG_FILTER_LINEAR,
+            .mag_filter = SG_FILTER_LINEAR,
+        });
+      ImFontAtlas *atlas = font->atlas;
+      sg_image_desc desc = {
+          .width = atlas->TexWidth,
+          .height = atlas->TexHeight,
+      };
+      desc.data.subimage[0][0] = {.ptr = atlas->TexPixelsRGBA32,
+                                  .size = (size_t)atlas->TexWidth *
+                                          atlas->TexHeight * 4};
+      font->image = sg_make_image(desc);
+      font->simguiImage =
+          simgui_make_image(simgui_image_desc_t{font->image, s_sampler});
+      atlas->SetTexID(simgui_imtextureid(font->simguiImage));
+      // The texture has the pixels now
+      atlas->ClearTexData();
+      s_uploaded.push_back(font);
+    }
+    font->ready.store(true, std::memory_order_release);
+  }
+}
+
+void shutdown_font_registry() {
+  for (auto &font : s_uploaded) {
+    simgui_destroy_image(font->simguiImage);
+    sg_destroy_image(font->image);
+  }
+  s_uploaded.clear();
+  if (s_sampler.id != SG_INVALID_ID)
+    sg_destroy_sampler(s_sampler);
+  s_sampler = {};
+  {
+    std::lock_guard<std::mutex> lock(s_built_mutex);
+    s_built.clear();
+  }
+  s_fonts.clear();
+  s_handles.clear();
+}
+
+extern "C" int font_load(const char *file, float size, int ranges) {
+  std::string path = file ? file : "";
+  if (path == "default")
+    path.clear();
+  if (!(size > 0.0f))
+    size = 13.0f;
+  if (ranges < 0 || ranges >= FontRangesCount)
+    ranges = FontRangesDefault;
+  auto key = std::make_tuple(path, size, ranges);
+  auto it = s_handles.find(key);
+  if (it != s_handles.end())
+    return it->second;
+
+  auto font = std::make_shared<Font>();
+  font->file = std::move(path);
+  font->size = size;
+  font->ranges = ranges;
+  int handle = (int)s_fonts.size();
+  s_fonts.push_back(font);
+  s_handles.emplace(std::move(key), handle);
+  s_pool->post([font] { build_font(font); },
+               {TaskPriority::Interactive, TraceTaskFont});
+  return handle;
+}
+
+extern "C" bool font_push(int handle) {
+  if (handle < 0 || (size_t)handle >= s_fonts.size())
+    return false;
+  Font *font = s_fonts[handle].get();
+  if (!font->ready.load(std::memory_order_acquire))
+    return false;
+  ImGui::PushFont(font->font);
+  return true;
+}
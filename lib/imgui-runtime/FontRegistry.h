@@ -0,0 +1,64 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include "AsyncFs.h"
+
+class ThreadPool;
+
+/// The fonts of <font>, beyond the default one. A font is loaded once per
+/// (file, size, glyph ranges) and kept until shutdown, so that every
+/// <font> with the same props shares it.
+///
+/// ImGui 1.89 can't add a font to an atlas that is built and in use, so
+/// each font gets an atlas and a texture of its own. The atlas is built on
+/// the pool, through the font atlas cache; its texture is made on the
+/// render thread by font_registry_upload() before the next frame is drawn,
+/// and only then does font_push() push the font. Until then, and if the
+/// load fails, <font> draws its children in the current font.
+///
+/// The handles belong to the thread that owns the ImGui context.
+
+/// Build the atlases on `pool`, and wake an idle main thread through
+/// `postToMain` when one is built. Without `gpu` (headless runs), no
+/// texture is made. Called once at startup.
+void install_font_registry(ThreadPool &pool, bool gpu,
+                           MainThreadPoster postToMain);
+
+/// On the render thread, before the frame is drawn: make the textures of
+/// the atlases built since the last call.
+void font_registry_upload();
+
+/// Destroy the textures and the fonts. Must be called before the GPU
+/// context is shut down; builds still running are dropped.
+void shutdown_font_registry();
+
+extern "C" {
+
+/// The handle of the font `file` (TrueType or OpenType; the built-in
+/// ProggyClean if empty or "default") at `size` pixels, with the glyph
+/// ranges `ranges` (FontRanges), starting its load if it's new.
+int font_load(const char *file, float size, int ranges);
+
+/// igPushFont() the font of `handle` if it is ready, and return whether it
+/// was pushed: the caller pops it after the text drawn with it.
+bool font_push(int handle);
+
+} // extern "C"
+
+/// Glyph ranges of font_load(), ImGui's GetGlyphRanges*(). Must match
+/// FONT_RANGES in the typed imgui unit's renderer.
+enum FontRanges {
+  FontRangesDefault,
+  FontRangesGreek,
+  FontRangesCyrillic,
+  FontRangesKorean,
+  FontRangesJapanese,
+  FontRangesChinese,
+  FontRangesChineseFull,
+  FontRangesThai,
+  FontRangesVietnamese,
+  FontRangesCount
+};
@@ -0,0 +1,369 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "FrameCapture.h"
+
+#include "SharedBuffer.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+// Framebuffer readback, defined in external/sokol/sokol.c.
+extern "C" int sg_readback_begin(int width, int height);
+extern "C" const void *sg_readback_map(int slot);
+extern "C" void sg_readback_release(int slot);
+// Defined in external/stb/stb.c; the result is freed with free().
+extern "C" unsigned char *stbi_write_png_to_mem(unsigned char *pixels,
+                                                int stride_bytes, int x, int y,
+                                                int n, int *out_len);
+// Defined in imgui-runtime.cpp.
+extern "C" void imgui_keep_rendering(void);
+
+namespace {
+
+enum class Format { Png, Qoi };
+
+struct Request {
+  unsigned id;
+  /// Empty to pass the image to the callback.
+  std::string path;
+  Format format;
+};
+
+/// A framebuffer copy in flight and the requests it serves. Drawing thread
+/// only.
+struct Readback {
+  int slot;
+  int width, height;
+  std::vector<Request> requests;
+  /// Handed to a pool job, which returns the slot through s_done_slots.
+  bool encoding = false;
+};
+
+struct Result {
+  std::string error;
+  std::vector<uint8_t> bytes;
+  bool hasBytes = false;
+  int width = 0, height = 0;
+};
+
+ThreadPool *s_pool = nullptr;
+facebook::jsi::Runtime *s_runtime = nullptr;
+std::atomic<MainThreadPoster> s_post_to_main{nullptr};
+bool s_enabled = false;
+
+/// Requests queued by JS until a frame serves them, and the slots whose
+/// pixels have been encoded.
+std::mutex s_mutex;
+std::vector<Request> s_requests;
+std::vector<int> s_done_slots;
+
+std::vector<Readback> s_readbacks;
+
+/// Callbacks of the requests, by request ID. Main thread only.
+std::unordered_map<unsigned, facebook::jsi::Function> s_callbacks;
+unsigned s_next_id = 1;
+
+/// The bottom-up RGBA rows of a readback as top-down RGB.
+std::vector<uint8_t> to_rgb(const uint8_t *rgba, int width, int height) {
+  std::vector<uint8_t> rgb((size_t)width * height * 3);
+  uint8_t *out = rgb.data();
+  for (int y = height - 1; y >= 0; --y) {
+    const uint8_t *in = rgba + (size_t)y * width * 4;
+    for (int x = 0; x < width; ++x, in += 4, out += 3) {
+      out[0] = in[0];
+      out[1] = in[1];
+      out[2] = in[2];
+    }
+  }
+  return rgb;
+}
+
+void put_u32_be(std::vector<uint8_t> &out, uint32_t v) {
+  out.push_back((uint8_t)(v >> 24));
+  out.push_back((uint8_t)(v >> 16));
+  out.push_back((uint8_t)(v >> 8));
+  out.push_back((uint8_t)v);
+}
+
+/// Encode opaque RGB pixels as QOI (qoiformat.org): a single pass, several
+/// times faster than PNG for files about as small on UI screenshots.
+std::vector<uint8_t> encode_qoi(const uint8_t *rgb, int width, int height) {
+  std::vector<uint8_t> out{'q', 'o', 'i', 'f'};
+  out.reserve(14 + (size_t)width * height + 8);
+  put_u32_be(out, (uint32_t)width);
+  put_u32_be(out, (uint32_t)height);
+  out.push_back(3); // channels
+  out.push_back(0); // sRGB with linear alpha
+
+  // Seen pixels by hash; alpha is always 255
+  uint32_t index[64] = {};
+  uint8_t pr = 0, pg = 0, pb = 0;
+  int run = 0;
+  size_t count = (size_t)width * height;
+  for (size_t i = 0; i < count; ++i, rgb += 3) {
+    uint8_t r = rgb[0], g = rgb[1], b = rgb[2];
+    if (r == pr && g == pg && b == pb) {
+      if (++run == 62) {
+        out.push_back((uint8_t)(0xc0 | (run - 1)));
+        run = 0;
+      }
+      continue;
+    }
+    if (run) {
+      out.push_back((uint8_t)(0xc0 | (run - 1)));
+      run = 0;
+    }
+    uint32_t px = (uint32_t)r << 24 | (uint32_t)g << 16 | (uint32_t)b << 8;
+    unsigned hash = (r * 3 + g * 5 + b * 7 + 255 * 11) % 64;
+    // index[] starts out zeroed, so store px + 1 to tell it from black
+    if (index[hash] == px + 1) {
+      out.push_back((uint8_t)hash);
+    } else {
+      index[hash] = px + 1;
+      int dr = (int8_t)(r - pr), dg = (int8_t)(g - pg), db = (int8_t)(b - pb);
+      int drg = dr - dg, dbg = db - dg;
+      if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+        out.push_back(
+            (uint8_t)(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+      } else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 &&
+                 dbg <= 7) {
+        out.push_back((uint8_t)(0x80 | (dg + 32)));
+        out.push_back((uint8_t)((drg + 8) << 4 | (dbg + 8)));
+      } else {
+        out.push_back(0xfe);
+        out.push_back(r);
+        out.push_back(g);
+        out.push_back(b);
+      }
+    }
+    pr = r;
+    pg = g;
+    pb = b;
+  }
+  if (run)
+    out.push_back((uint8_t)(0xc0 | (run - 1)));
+  // The end marker
+  out.resize(out.size() + 7, 0);
+  out.push_back(1);
+  return out;
+}
+
+std::vector<uint8_t> encode_png(const uint8_t *rgb, int width, int height) {
+  int length = 0;
+  unsigned char *png = stbi_write_png_to_mem(const_cast<uint8_t *>(rgb),
+                                             width * 3, width, height, 3,
+                                             &length);
+  std::vector<uint8_t> out(png, png + (png ? length : 0));
+  free(png);
+  return out;
+}
+
+/// Write `bytes` to `path` through a temporary file. Returns an error
+/// message, empty on success.
+std::string write_file(const std::string &path,
+                       const std::vector<uint8_t> &bytes) {
+  std::string tmpPath = path + "." + std::to_string(getpid());
+  FILE *f = fopen(tmpPath.c_str(), "wb");
+  if (!f)
+    return "can't write '" + tmpPath + "': " + strerror(errno);
+  bool ok = fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+  ok = fclose(f) == 0 && ok;
+  if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+    unlink(tmpPath.c_str());
+    return "can't write '" + path + "'";
+  }
+  return {};
+}
+
+void complete(unsigned id, Result result) {
+  auto it = s_callbacks.find(id);
+  if (it == s_callbacks.end())
+    return;
+  facebook::jsi::Function callback = std::move(it->second);
+  s_callbacks.erase(it);
+  facebook::jsi::Runtime &rt = *s_runtime;
+  if (!result.error.empty()) {
+    callback.call(rt, facebook::jsi::String::createFromUtf8(rt, result.error));
+    return;
+  }
+  facebook::jsi::Value bytes = facebook::jsi::Value::null();
+  if (result.hasBytes)
+    bytes = facebook::jsi::ArrayBuffer(
+        rt, std::make_shared<VectorBuffer<uint8_t>>(std::move(result.bytes)));
+  callback.call(rt, facebook::jsi::Value::null(), std::move(bytes),
+                result.width, result.height);
+}
+
+void post_result(unsigned id, Result result) {
+  if (MainThreadPoster post = s_post_to_main.load(std::memory_order_acquire))
+    post([id, result = std::move(result)]() mutable {
+      complete(id, std::move(result));
+    });
+}
+
+/// Pool job: copy the mapped pixels of `slot` out, hand the slot back to the
+/// drawing thread, then encode the copy for each request.
+void encode(int slot, const uint8_t *rgba, int width, int height,
+            std::vector<Request> requests) {
+  std::vector<uint8_t> rgb = to_rgb(rgba, width, height);
+  {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_done_slots.push_back(slot);
+  }
+  std::vector<uint8_t> encoded[2];
+  for (Request &request : requests) {
+    std::vector<uint8_t> &bytes = encoded[(int)request.format];
+    if (bytes.empty())
+      bytes = request.format == Format::Png ? encode_png(rgb.data(), width,
+                                                         height)
+                                            : encode_qoi(rgb.data(), width,
+                                                         height);
+    Result result;
+    result.width = width;
+    result.height = height;
+    if (bytes.empty())
+      result.error = "can't encode the frame";
+    else if (!request.path.empty())
+      result.error = write_file(request.path, bytes);
+    else {
+      result.bytes = bytes;
+      result.hasBytes = true;
+    }
+    post_result(request.id, std::move(result));
+  }
+}
+
+void fail(std::vector<Request> &requests, const char *message) {
+  for (const Request &request : requests) {
+    Result result;
+    result.error = message;
+    post_result(request.id, std::move(result));
+  }
+  requests.clear();
+}
+
+} // namespace
+
+bool frame_capture_end_pass(int width, int height) {
+  std::vector<Request> requests;
+  std::vector<int> done;
+  {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (s_requests.empty() && s_readbacks.empty())
+      return false;
+    std::swap(requests, s_requests);
+    std::swap(done, s_done_slots);
+  }
+
+  for (int slot : done) {
+    sg_readback_release(slot);
+    for (size_t i = 0; i < s_readbacks.size(); ++i) {
+      if (s_readbacks[i].slot == slot) {
+        s_readbacks.erase(s_readbacks.begin() + (ptrdiff_t)i);
+        break;
+      }
+    }
+  }
+
+  for (Readback &readback : s_readbacks) {
+    if (readback.encoding)
+      continue;
+    const void *pixels = sg_readback_map(readback.slot);
+    if (!pixels)
+      continue;
+    readback.encoding = true;
+    s_pool->post(
+        [slot = readback.slot, pixels, width = readback.width,
+         height = readback.height,
+         requests = std::move(readback.requests)]() mutable {
+          encode(slot, static_cast<const uint8_t *>(pixels), width, height,
+                 std::move(requests));
+        },
+        {TaskPriority::Background, TraceTaskCapture});
+  }
+
+  if (!requests.empty()) {
+    int slot = sg_readback_begin(width, height);
+    if (slot >= 0) {
+      s_readbacks.push_back(Readback{slot, width, height, std::move(requests)});
+    } else if (s_readbacks.empty()) {
+      fail(requests, "framebuffer readback is not supported by this backend");
+    } else {
+      // Every slot is in flight: try again next frame
+      std::lock_guard<std::mutex> lock(s_mutex);
+      s_requests.insert(s_requests.begin(), requests.begin(), requests.end());
+    }
+  }
+  return !s_readbacks.empty();
+}
+
+void install_frame_capture(facebook::jsi::Runtime &rt, ThreadPool &pool,
+                           bool enabled, MainThreadPoster postToMain) {
+  s_pool = &pool;
+  s_runtime = &rt;
+  s_enabled = enabled;
+  s_post_to_main.store(postToMain, std::memory_order_release);
+
+  rt.global().setProperty(
+      rt, "__captureFrame",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__captureFrame"), 3,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count < 3 || !(args[0].isString() || args[0].isNull()) ||
+                !args[1].isString() || !args[2].isObject() ||
+                !args[2].getObject(rt).isFunction(rt))
+              throw facebook::jsi::JSError(
+                  rt, "__captureFrame expects a path or null, a format and "
+                      "a callback");
+            std::string format = args[1].getString(rt).utf8(rt);
+            if (format != "png" && format != "qoi")
+              throw facebook::jsi::JSError(
+                  rt, "captureFrame: unknown format '" + format + "'");
+            if (!s_enabled)
+              throw facebook::jsi::JSError(
+                  rt, "captureFrame needs a window to capture");
+            Request request;
+            request.id = s_next_id++;
+            request.format = format == "png" ? Format::Png : Format::Qoi;
+            if (args[0].isString())
+              request.path = args[0].getString(rt).utf8(rt);
+            s_callbacks.emplace(request.id,
+                                args[2].getObject(rt).getFunction(rt));
+            {
+              std::lock_guard<std::mutex> lock(s_mutex);
+              s_requests.push_back(std::move(request));
+            }
+            // An idle on-demand loop must still draw the frame
+            imgui_keep_rendering();
+            return facebook::jsi::Value::undefined();
+          }));
+}
+
+void shutdown_frame_capture() {
+  s_post_to_main.store(nullptr, std::memory_order_release);
+  {
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_requests.clear();
+    // Their jobs were dropped with the pool: the next frame frees the slots
+    for (Readback &readback : s_readbacks) {
+      readback.requests.clear();
+      s_done_slots.push_back(readback.slot);
+    }
+  }
+  s_callbacks.clear();
+}
@@ -0,0 +1,44 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include "AsyncFs.h"
+
+#include <hermes/hermes.h>
+
+/// Screenshots behind jslib's captureFrame(), taken without stalling the
+/// frame loop.
+///
+/// A request is served by the next frame drawn: right after its
+/// sg_end_pass(), sg_readback_begin() (external/sokol/sokol.c) has the GPU
+/// copy the framebuffer into one of a ring of pixel pack buffers, which
+/// returns at once. Later frames poll the copy's fence and map the buffer
+/// once the GPU is done with it, usually two or three frames on. A pool job
+/// then copies the rows out, flipped and without alpha, which returns the
+/// buffer to the ring at the next frame, and encodes PNG or QOI. The frame
+/// loop only issues the copy and the map; the pixels are touched on a
+/// worker.
+///
+/// Readback needs the GL core backend; elsewhere, and in headless runs,
+/// requests fail.
+///
+/// Host function:
+///  - __captureFrame(path, format, callback) queues a capture in `format`
+///    ("png" or "qoi"), written to `path` (through a temporary file renamed
+///    once complete) or, with a null path, passed as an ArrayBuffer.
+///    `callback(message, bytes, width, height)` is called on the main
+///    thread with a null message on success.
+void install_frame_capture(facebook::jsi::Runtime &rt, ThreadPool &pool,
+                           bool enabled, MainThreadPoster postToMain);
+
+/// Forget the requests and their callbacks (see "Shutdown order" in
+/// ThreadPool.h).
+void shutdown_frame_capture();
+
+/// Serve the queued requests from the default framebuffer of `width` x
+/// `height` pixels, and collect the readbacks of earlier frames. Call on
+/// the drawing thread right after the sg_end_pass() of the default pass.
+/// Returns whether readbacks are still in flight, which need more frames.
+bool frame_capture_end_pass(int width, int height);
@@ -0,0 +1,450 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "GlyphCache.h"
+
+#include "MappedFileBuffer.h"
+#include "TextMeasure.h"
+
+// The C++ API, like FontAtlasCache.cpp: glyphs are added to the font's
+// tables directly.
+#include "imgui/imgui.h"
+#include "imgui/imgui_internal.h"
+
+// A private copy of stb_truetype, as imgui_draw.cpp has
+#define STBTT_malloc(x, u) ((void)(u), IM_ALLOC(x))
+#define STBTT_free(x, u) ((void)(u), IM_FREE(x))
+#define STBTT_assert(x) IM_ASSERT(x)
+#define STBTT_STATIC
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "imgui/imstb_truetype.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Defined in sokol.c.
+extern "C" void simgui_update_font_image(const void *pixels, size_t size);
+
+namespace {
+
+/// A glyph touched this many frames ago may still be drawn by a frame in
+/// flight (threaded mode draws the previous frame's snapshot), so it isn't
+/// evicted.
+constexpr uint32_t kEvictAfterFrames = 2;
+
+std::string s_font_path;
+int s_region_height = 512;
+
+bool s_enabled = false;
+ImFontAtlas *s_atlas = nullptr;
+ImFont *s_font = nullptr;
+std::shared_ptr<facebook::jsi::Buffer> s_font_file;
+stbtt_fontinfo s_info;
+float s_scale = 0.0f;
+
+/// The font's ellipsis, which its lookup tables are rebuilt with: a cached
+/// U+2026 mustn't become it, since it can be evicted.
+ImWchar s_ellipsis_char;
+int s_ellipsis_count;
+float s_ellipsis_width, s_ellipsis_step;
+
+/// The cells: square, `s_cell` pixels a side including one pixel of
+/// padding, from row `s_region_top` of the texture.
+int s_cell = 0;
+int s_region_top = 0;
+int s_columns = 0;
+std::vector<uint32_t> s_cell_codepoints;
+/// Index of each cell's glyph in ImFont::Glyphs.
+std::vector<int> s_cell_glyphs;
+int s_used_cells = 0;
+
+enum class State : uint8_t {
+  /// In the atlas it was built with.
+  Base,
+  /// Not in the fallback font either.
+  Missing,
+  /// Waiting for glyph_cache_update().
+  Pending,
+  /// In cell `cell`.
+  Cached,
+  /// Not in a cell; pending again once registered.
+  Evicted,
+};
+
+struct Entry {
+  State state;
+  int32_t refs = 0;
+  uint32_t lastTouch = 0;
+  int32_t cell = -1;
+};
+
+std::unordered_map<uint32_t, Entry> s_entries;
+std::vector<uint32_t> s_pending;
+/// The codepoints of each glyph_cache_retain() handle (index + 1), which
+/// glyph_cache_release() releases. Recorded, since the retained bytes may
+/// be edited in place meanwhile. Freed handles are reused.
+std::vector<std::vector<uint32_t>> s_retained;
+std::vector<int> s_free_retained;
+uint32_t s_frame = 0;
+bool s_reported_full = false;
+
+/// Guards the pixels of the region and s_dirty, which the main thread
+/// uploads.
+std::mutex s_pixels_mutex;
+bool s_dirty = false;
+
+Entry &entry_of(uint32_t c) {
+  auto it = s_entries.find(c);
+  if (it != s_entries.end())
+    return it->second;
+  Entry &e = s_entries[c];
+  // Glyphs added so far all have entries, so a glyph found now is the
+  // atlas's own
+  e.state = s_font->FindGlyphNoFallback((ImWchar)c) ? State::Base
+                                                     : State::Pending;
+  if (e.state == State::Pending)
+    s_pending.push_back(c);
+  return e;
+}
+
+/// Call `fn` with each non-ASCII codepoint of `len` bytes of UTF-8 at `s`
+/// (NUL-terminated if negative). Invalid sequences and codepoints ImWchar
+/// can't hold are skipped.
+template <typename Fn> void for_each_codepoint(const char *s, int len, Fn fn) {
+  const auto *p = reinterpret_cast<const unsigned char *>(s);
+  const unsigned char *end =
+      p + (len < 0 ? strlen(s) : static_cast<size_t>(len));
+  while (p < end) {
+    unsigned c = *p++;
+    if (c < 0x80)
+      continue;
+    int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : -1;
+    if (extra < 0 || end - p < extra)
+      continue;
+    c &= 0x3F >> extra;
+    bool valid = true;
+    for (int i = 0; i < extra; ++i) {
+      if ((p[i] & 0xC0) != 0x80) {
+        valid = false;
+        break;
+      }
+      c = (c << 6) | (p[i] & 0x3F);
+    }
+    if (!valid)
+      continue;
+    p += extra;
+    if (c >= 0x80 && c <= IM_UNICODE_CODEPOINT_MAX)
+      fn(c);
+  }
+}
+
+/// Clear cell `cell` and draw the glyph of `c` into it. Returns the glyph.
+ImFontGlyph rasterize(int cell, uint32_t c, int glyphIndex) {
+  int ix0, iy0, ix1, iy1, advance, lsb;
+  stbtt_GetGlyphHMetrics(&s_info, glyphIndex, &advance, &lsb);
+  stbtt_GetGlyphBitmapBox(&s_info, glyphIndex, s_scale, s_scale, &ix0, &iy0,
+                          &ix1, &iy1);
+  // Larger glyphs are cut to the cell, keeping its padding
+  int w = std::min(ix1 - ix0, s_cell - 1);
+  int h = std::min(iy1 - iy0, s_cell - 1);
+  int x = (cell % s_columns) * s_cell;
+  int y = s_region_top + (cell / s_columns) * s_cell;
+
+  static std::vector<unsigned char> alpha;
+  alpha.assign((size_t)s_cell * s_cell, 0);
+  if (w > 0 && h > 0)
+    stbtt_MakeGlyphBitmap(&s_info, alpha.data(), w, h, w, s_scale, s_scale,
+                          glyphIndex);
+  unsigned int *pixels = s_atlas->TexPixelsRGBA32;
+  for (int row = 0; row < s_cell; ++row) {
+    unsigned int *dst = pixels + (size_t)(y + row) * s_atlas->TexWidth + x;
+    for (int col = 0; col < s_cell; ++col)
+      dst[col] = IM_COL32(255, 255, 255,
+                          row < h && col < w ? alpha[row * w + col] : 0);
+  }
+
+  ImFontGlyph g{};
+  g.Codepoint = c;
+  g.Visible = w > 0 && h > 0;
+  g.AdvanceX = IM_ROUND(advance * s_scale);
+  g.X0 = (float)ix0;
+  g.Y0 = IM_ROUND(s_font->Ascent) + (float)iy0;
+  g.X1 = g.X0 + w;
+  g.Y1 = g.Y0 + h;
+  g.U0 = x * s_atlas->TexUvScale.x;
+  g.V0 = y * s_atlas->TexUvScale.y;
+  g.U1 = (x + w) * s_atlas->TexUvScale.x;
+  g.V1 = (y + h) * s_atlas->TexUvScale.y;
+  return g;
+}
+
+/// The cells that can be evicted, least recently touched first.
+std::vector<int> eviction_order() {
+  std::vector<int> cells;
+  for (int i = 0; i < s_used_cells; ++i) {
+    const Entry &e = s_entries[s_cell_codepoints[i]];
+    if (e.refs == 0 && e.lastTouch + kEvictAfterFrames <= s_frame)
+      cells.push_back(i);
+  }
+  std::sort(cells.begin(), cells.end(), [](int a, int b) {
+    return s_entries[s_cell_codepoints[a]].lastTouch <
+           s_entries[s_cell_codepoints[b]].lastTouch;
+  });
+  return cells;
+}
+
+} // namespace
+
+void glyph_cache_set_font(const std::string &path) { s_font_path = path; }
+
+void glyph_cache_set_height(int height) { s_region_height = height; }
+
+bool glyph_cache_attach(ImFontAtlas *atlas) {
+  if (s_font_path.empty() || atlas->Fonts.Size == 0 || s_region_height <= 0)
+    return false;
+  try {
+    s_font_file = mapFileBuffer(s_font_path.c_str());
+  } catch (const std::exception &e) {
+    fprintf(stderr, "Can't read glyph font %s: %s\n", s_font_path.c_str(),
+            e.what());
+    return false;
+  }
+  const unsigned char *data = s_font_file->data();
+  int offset = stbtt_GetFontOffsetForIndex(data, 0);
+  if (offset < 0 || !stbtt_InitFont(&s_info, data, offset)) {
+    fprintf(stderr, "Glyph font %s isn't a TrueType or OpenType font\n",
+            s_font_path.c_str());
+    s_font_file.reset();
+    return false;
+  }
+
+  s_atlas = atlas;
+  s_font = atlas->Fonts[0];
+  s_scale = stbtt_ScaleForPixelHeight(&s_info, s_font->FontSize);
+  s_cell = (int)ImCeil(s_font->FontSize * 1.25f) + 1;
+  s_columns = atlas->TexWidth / s_cell;
+  int rows = s_region_height / s_cell;
+  if (s_columns == 0 || rows == 0) {
+    s_font_file.reset();
+    return false;
+  }
+  s_cell_codepoints.assign((size_t)s_columns * rows, 0);
+  s_cell_glyphs.assign(s_cell_codepoints.size(), -1);
+  s_ellipsis_char = s_font->EllipsisChar;
+  s_ellipsis_count = s_font->EllipsisCharCount;
+  s_ellipsis_width = s_font->EllipsisWidth;
+  s_ellipsis_step = s_font->EllipsisCharStep;
+
+  // Grow the texture by the region. The existing pixels keep their place,
+  // so only the V coordinates change.
+  if (!atlas->TexPixelsRGBA32) {
+    unsigned char *pixels;
+    int width, height;
+    atlas->GetTexDataAsRGBA32(&pixels, &width, &height);
+  }
+  int oldHeight = atlas->TexHeight;
+  int height = oldHeight + rows * s_cell;
+  size_t oldCount = (size_t)atlas->TexWidth * oldHeight;
+  size_t count = (size_t)atlas->TexWidth * height;
+  auto *pixels = (unsigned int *)IM_ALLOC(count * sizeof(unsigned int));
+  memcpy(pixels, atlas->TexPixelsRGBA32, oldCount * sizeof(unsigned int));
+  std::fill(pixels + oldCount, pixels + count, IM_COL32(255, 255, 255, 0));
+  IM_FREE(atlas->TexPixelsRGBA32);
+  atlas->TexPixelsRGBA32 = pixels;
+  // Only the RGBA32 pixels are kept up to date
+  IM_FREE(atlas->TexPixelsAlpha8);
+  atlas->TexPixelsAlpha8 = nullptr;
+
+  float scale = (float)oldHeight / height;
+  for (ImFont *font : atlas->Fonts) {
+    for (ImFontGlyph &g : font->Glyphs) {
+      g.V0 *= scale;
+      g.V1 *= scale;
+    }
+  }
+  atlas->TexUvWhitePixel.y *= scale;
+  for (ImVec4 &uv : atlas->TexUvLines) {
+    uv.y *= scale;
+    uv.w *= scale;
+  }
+  atlas->TexHeight = height;
+  atlas->TexUvScale.y = 1.0f / height;
+  s_region_top = oldHeight;
+
+  s_enabled = true;
+  s_dirty = true;
+  // Text measured before may contain codepoints retained since
+  text_measure_invalidate();
+  return true;
+}
+
+void glyph_cache_update() {
+  if (!s_enabled)
+    return;
+  ++s_frame;
+  if (s_pending.empty())
+    return;
+
+  std::vector<int> evictable;
+  bool evictableListed = false;
+  size_t nextEvictable = 0;
+  size_t done = 0;
+  bool added = false;
+  {
+    std::lock_guard<std::mutex> lock(s_pixels_mutex);
+    for (; done < s_pending.size(); ++done) {
+      uint32_t c = s_pending[done];
+      Entry &e = s_entries[c];
+      if (e.state != State::Pending)
+        continue;
+      // Released and not drawn since it was registered
+      if (e.refs == 0 && e.lastTouch + kEvictAfterFrames <= s_frame) {
+        e.state = State::Evicted;
+        continue;
+      }
+      int glyphIndex = stbtt_FindGlyphIndex(&s_info, (int)c);
+      if (glyphIndex == 0) {
+        e.state = State::Missing;
+        continue;
+      }
+
+      int cell;
+      if (s_used_cells < (int)s_cell_codepoints.size()) {
+        cell = s_used_cells++;
+      } else {
+        if (!evictableListed) {
+          evictable = eviction_order();
+          evictableListed = true;
+        }
+        if (nextEvictable == evictable.size())
+          break;
+        cell = evictable[nextEvictable++];
+        Entry &old = s_entries[s_cell_codepoints[cell]];
+        old.state = State::Evicted;
+        old.cell = -1;
+      }
+
+      ImFontGlyph g = rasterize(cell, c, glyphIndex);
+      if (s_cell_glyphs[cell] >= 0) {
+        s_font->Glyphs[s_cell_glyphs[cell]] = g;
+      } else {
+        // Before the TAB glyph, which BuildLookupTable() expects last
+        int index = s_font->Glyphs.Size;
+        if (index > 0 && s_font->Glyphs.back().Codepoint == '\t') {
+          --index;
+          s_font->Glyphs.insert(s_font->Glyphs.begin() + index, g);
+        } else {
+          s_font->Glyphs.push_back(g);
+        }
+        s_cell_glyphs[cell] = index;
+      }
+      s_cell_codepoints[cell] = c;
+      e.state = State::Cached;
+      e.cell = cell;
+      e.lastTouch = s_frame;
+      added = true;
+    }
+    if (added)
+      s_dirty = true;
+  }
+
+  if (done < s_pending.size() && !s_reported_full) {
+    s_reported_full = true;
+    fprintf(stderr,
+            "Glyph cache full: %zu glyphs wait for a cell; raise "
+            "sappConfig.glyph_cache.height\n",
+            s_pending.size() - done);
+  }
+  s_pending.erase(s_pending.begin(), s_pending.begin() + done);
+  if (!added)
+    return;
+
+  s_font->BuildLookupTable();
+  s_font->EllipsisChar = s_ellipsis_char;
+  s_font->EllipsisCharCount = s_ellipsis_count;
+  s_font->EllipsisWidth = s_ellipsis_width;
+  s_font->EllipsisCharStep = s_ellipsis_step;
+  // Widths measured with the fallback glyph
+  text_measure_invalidate();
+}
+
+void glyph_cache_upload() {
+  if (!s_enabled)
+    return;
+  std::lock_guard<std::mutex> lock(s_pixels_mutex);
+  if (!s_dirty)
+    return;
+  s_dirty = false;
+  simgui_update_font_image(s_atlas->TexPixelsRGBA32,
+                           (size_t)s_atlas->TexWidth * s_atlas->TexHeight *
+                               sizeof(unsigned int));
+}
+
+/// Mark `e`, the entry of `c`, as drawn in this frame.
+static void touch_entry(uint32_t c, Entry &e) {
+  e.lastTouch = s_frame;
+  if (e.state == State::Evicted) {
+    e.state = State::Pending;
+    s_pending.push_back(c);
+  }
+}
+
+void glyph_cache_touch_codepoint(uint32_t c) {
+  if (!s_enabled || c < 0x80 || c > IM_UNICODE_CODEPOINT_MAX)
+    return;
+  touch_entry(c, entry_of(c));
+}
+
+extern "C" int glyph_cache_retain(const char *s, int len) {
+  if (!s_enabled)
+    return 0;
+  int handle;
+  if (!s_free_retained.empty()) {
+    handle = s_free_retained.back();
+    s_free_retained.pop_back();
+  } else {
+    s_retained.emplace_back();
+    handle = (int)s_retained.size();
+  }
+  std::vector<uint32_t> &codepoints = s_retained[handle - 1];
+  for_each_codepoint(s, len, [&codepoints](uint32_t c) {
+    Entry &e = entry_of(c);
+    ++e.refs;
+    touch_entry(c, e);
+    codepoints.push_back(c);
+  });
+  if (codepoints.empty()) {
+    s_free_retained.push_back(handle);
+    return 0;
+  }
+  return handle;
+}
+
+extern "C" void glyph_cache_release(int handle) {
+  if (handle <= 0 || handle > (int)s_retained.size())
+    return;
+  std::vector<uint32_t> &codepoints = s_retained[handle - 1];
+  for (uint32_t c : codepoints) {
+    auto it = s_entries.find(c);
+    if (it != s_entries.end() && it->second.refs > 0) {
+      --it->second.refs;
+      // Not drawn from now on, unless touched: evictable as soon as it's
+      // out of the frames in flight
+      it->second.lastTouch = s_frame;
+    }
+  }
+  codepoints.clear();
+  s_free_retained.push_back(handle);
+}
+
+extern "C" void glyph_cache_touch(const char *s, int len) {
+  if (!s_enabled)
+    return;
+  for_each_codepoint(s, len,
+                     [](uint32_t c) { touch_entry(c, entry_of(c)); });
+}
@@ -0,0 +1,68 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+struct ImFontAtlas;
+
+/// Glyphs the font atlas wasn't built with (CJK, Cyrillic, ...), rasterized
+/// from a fallback font the first time text needs them, instead of baking
+/// whole ranges into the atlas at startup. They go into cells of a region
+/// added below the atlas texture, and into the glyph table of the default
+/// font, so that they mix with its own glyphs in any string.
+///
+/// Text registers its codepoints: the typed unit retains the ones of the
+/// strings it keeps in persistent slots for as long as it keeps them, and
+/// touches the ones of strings it encodes for one frame, as the native
+/// widgets do for the text they draw. Codepoints registered during a frame
+/// are rasterized together by glyph_cache_update() before the next one
+/// (they show as the fallback glyph until then), and the texture is updated
+/// at most once per frame. When the cells are all used, the glyphs least
+/// recently touched that no string retains are evicted.
+///
+/// The registry and the font belong to the thread that owns the ImGui
+/// context; only glyph_cache_upload() runs on the main thread.
+
+/// The fallback font file (TrueType or OpenType); empty disables the cache.
+void glyph_cache_set_font(const std::string &path);
+
+/// Height in pixels of the region of cells, 512 by default.
+void glyph_cache_set_height(int height);
+
+/// Add the region to `atlas`, which must be built and have its RGBA32
+/// pixels, and map the fallback font. Returns false, leaving the atlas
+/// alone, if no font was set or it can't be read; the atlas texture must
+/// otherwise be made dynamic (see simgui_make_font_image()).
+bool glyph_cache_attach(ImFontAtlas *atlas);
+
+/// Once per frame, before igNewFrame(): rasterize the codepoints registered
+/// since the last call into the atlas.
+void glyph_cache_update();
+
+/// On the main thread, before the frame is drawn: update the atlas texture
+/// if glyphs were rasterized since the last call.
+void glyph_cache_upload();
+
+/// Register a typed character for this frame, without a reference: the
+/// <inputtext> that receives it retains its buffer once edited.
+void glyph_cache_touch_codepoint(uint32_t c);
+
+extern "C" {
+
+/// Register the codepoints of `len` bytes of UTF-8 at `s` (NUL-terminated
+/// if `len` is negative) until glyph_cache_release() of the returned
+/// handle. Returns 0 if there was nothing to retain.
+int glyph_cache_retain(const char *s, int len);
+
+/// Undo glyph_cache_retain(): release the codepoints it retained, whatever
+/// the bytes hold now. A handle of 0 is ignored.
+void glyph_cache_release(int handle);
+
+/// Register the codepoints of text drawn in this frame.
+void glyph_cache_touch(const char *s, int len);
+
+} // extern "C"
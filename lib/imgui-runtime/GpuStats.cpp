@@ -0,0 +1,114 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "GpuStats.h"
+
+#include "Trace.h"
+
+#define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
+#include "cimgui.h"
+#include "sokol_gfx.h"
+
+#include <cstdint>
+
+// GPU frame timing, defined in external/sokol/sokol.c.
+extern "C" void sg_gpu_timer_begin(void);
+extern "C" void sg_gpu_timer_end(void);
+extern "C" double sg_gpu_timer_ms(void);
+
+namespace {
+
+/// All hooks run on the thread that calls sokol_gfx, as does everything
+/// else here.
+GpuFrameStats s_frame{};
+bool s_paused = false;
+/// Image bound in every fragment and vertex stage slot since the last
+/// gpu_stats_end_frame().
+uint32_t s_bound_images[2][SG_MAX_SHADERSTAGE_IMAGES];
+
+void on_draw(int, int, int, void *) {
+  if (!s_paused)
+    ++s_frame.drawCalls;
+}
+
+void count_binds(int stage, const sg_stage_bindings &bindings) {
+  for (int i = 0; i < SG_MAX_SHADERSTAGE_IMAGES; ++i) {
+    uint32_t id = bindings.images[i].id;
+    if (id && id != s_bound_images[stage][i]) {
+      s_bound_images[stage][i] = id;
+      ++s_frame.textureBinds;
+    }
+  }
+}
+
+void on_apply_bindings(const sg_bindings *bindings, void *) {
+  if (s_paused)
+    return;
+  count_binds(0, bindings->vs);
+  count_binds(1, bindings->fs);
+}
+
+void count_upload(size_t bytes) {
+  if (s_paused)
+    return;
+  ++s_frame.uploads;
+  s_frame.uploadBytes += (double)bytes;
+}
+
+void on_update_buffer(sg_buffer, const sg_range *data, void *) {
+  count_upload(data->size);
+}
+
+void on_append_buffer(sg_buffer, const sg_range *data, int, void *) {
+  count_upload(data->size);
+}
+
+void on_update_image(sg_image, const sg_image_data *data, void *) {
+  size_t bytes = 0;
+  for (const auto &face : data->subimage)
+    for (const sg_range &mip : face)
+      bytes += mip.size;
+  count_upload(bytes);
+}
+
+} // namespace
+
+void gpu_stats_setup() {
+  sg_trace_hooks hooks = {};
+  hooks.draw = on_draw;
+  hooks.apply_bindings = on_apply_bindings;
+  hooks.update_buffer = on_update_buffer;
+  hooks.append_buffer = on_append_buffer;
+  hooks.update_image = on_update_image;
+  sg_install_trace_hooks(&hooks);
+}
+
+void gpu_stats_pause() { s_paused = true; }
+
+void gpu_stats_resume() { s_paused = false; }
+
+void gpu_stats_begin_draw() { sg_gpu_timer_begin(); }
+
+GpuFrameStats gpu_stats_end_frame(const ImDrawData *drawData) {
+  sg_gpu_timer_end();
+  GpuFrameStats stats = s_frame;
+  s_frame = GpuFrameStats{};
+  for (auto &stage : s_bound_images)
+    for (uint32_t &id : stage)
+      id = 0;
+
+  if (drawData) {
+    stats.drawLists = drawData->CmdListsCount;
+    stats.vertices = drawData->TotalVtxCount;
+    stats.indices = drawData->TotalIdxCount;
+  }
+  stats.gpuMs = sg_gpu_timer_ms();
+
+  trace_counter(TraceDrawCalls, stats.drawCalls);
+  trace_counter(TraceVertices, stats.vertices);
+  trace_counter(TraceUploadBytes, stats.uploadBytes);
+  if (stats.gpuMs >= 0)
+    trace_counter(TraceGpuTime, stats.gpuMs);
+  return stats;
+}
@@ -0,0 +1,45 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+struct ImDrawData;
+
+/// GPU work of one frame: what sokol_gfx submitted, ImGui's draw data totals
+/// and, where the backend has timer queries, the time the GPU spent on it.
+struct GpuFrameStats {
+  /// sg_draw() calls.
+  int drawCalls = 0;
+  /// Images bound by sg_apply_bindings() that differ from the ones bound
+  /// before in the same slot.
+  int textureBinds = 0;
+  /// sg_update_buffer(), sg_append_buffer() and sg_update_image() calls, and
+  /// the bytes they uploaded.
+  int uploads = 0;
+  double uploadBytes = 0;
+  /// ImGui's draw lists, vertices and indices.
+  int drawLists = 0;
+  int vertices = 0;
+  int indices = 0;
+  /// GPU time of the most recent frame whose timing is available, which
+  /// lags a few frames behind; negative when the backend can't measure it.
+  double gpuMs = -1;
+};
+
+/// Install the sokol_gfx trace hooks that do the counting. Call after
+/// sg_setup().
+void gpu_stats_setup();
+
+/// Stop counting sokol_gfx work (the HUD's own drawing) until
+/// gpu_stats_resume().
+void gpu_stats_pause();
+void gpu_stats_resume();
+
+/// Start timing the GPU, right before the frame's ImGui draws.
+void gpu_stats_begin_draw();
+/// Stop timing after the frame's last sg_end_pass() and before sg_commit().
+/// Returns the work counted since the previous call, ImGui's totals from
+/// `drawData` (may be null) and the latest GPU time, and records them as
+/// trace counters.
+GpuFrameStats gpu_stats_end_frame(const ImDrawData *drawData);
@@ -0,0 +1,228 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "Hotkeys.h"
+
+#include "imgui/imgui.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t kChordModifiers = SAPP_MODIFIER_SHIFT | SAPP_MODIFIER_CTRL |
+                                     SAPP_MODIFIER_ALT | SAPP_MODIFIER_SUPER;
+
+struct Hotkey {
+  int id;
+  sapp_keycode key;
+  uint32_t modifiers;
+  bool repeat;
+  std::shared_ptr<facebook::jsi::Function> callback;
+};
+
+/// The hotkeys, in registration order: the first match wins. Thread of the
+/// ImGui context only, which is the one that runs JS.
+std::vector<Hotkey> s_hotkeys;
+int s_next_id = 1;
+facebook::jsi::Runtime *s_runtime = nullptr;
+MainThreadPoster s_post_to_main = nullptr;
+
+struct KeyName {
+  const char *name;
+  sapp_keycode key;
+};
+
+/// Named keys, lowercase; letters, digits and F1-F25 are handled apart.
+constexpr KeyName kKeyNames[] = {
+    {"space", SAPP_KEYCODE_SPACE},
+    {"'", SAPP_KEYCODE_APOSTROPHE},
+    {"apostrophe", SAPP_KEYCODE_APOSTROPHE},
+    {",", SAPP_KEYCODE_COMMA},
+    {"comma", SAPP_KEYCODE_COMMA},
+    {"-", SAPP_KEYCODE_MINUS},
+    {"minus", SAPP_KEYCODE_MINUS},
+    {".", SAPP_KEYCODE_PERIOD},
+    {"period", SAPP_KEYCODE_PERIOD},
+    {"/", SAPP_KEYCODE_SLASH},
+    {"slash", SAPP_KEYCODE_SLASH},
+    {";", SAPP_KEYCODE_SEMICOLON},
+    {"semicolon", SAPP_KEYCODE_SEMICOLON},
+    {"=", SAPP_KEYCODE_EQUAL},
+    {"equal", SAPP_KEYCODE_EQUAL},
+    {"[", SAPP_KEYCODE_LEFT_BRACKET},
+    {"bracketleft", SAPP_KEYCODE_LEFT_BRACKET},
+    {"\\", SAPP_KEYCODE_BACKSLASH},
+    {"backslash", SAPP_KEYCODE_BACKSLASH},
+    {"]", SAPP_KEYCODE_RIGHT_BRACKET},
+    {"bracketright", SAPP_KEYCODE_RIGHT_BRACKET},
+    {"`", SAPP_KEYCODE_GRAVE_ACCENT},
+    {"backquote", SAPP_KEYCODE_GRAVE_ACCENT},
+    {"escape", SAPP_KEYCODE_ESCAPE},
+    {"esc", SAPP_KEYCODE_ESCAPE},
+    {"enter", SAPP_KEYCODE_ENTER},
+    {"return", SAPP_KEYCODE_ENTER},
+    {"tab", SAPP_KEYCODE_TAB},
+    {"backspace", SAPP_KEYCODE_BACKSPACE},
+    {"insert", SAPP_KEYCODE_INSERT},
+    {"delete", SAPP_KEYCODE_DELETE},
+    {"right", SAPP_KEYCODE_RIGHT},
+    {"left", SAPP_KEYCODE_LEFT},
+    {"down", SAPP_KEYCODE_DOWN},
+    {"up", SAPP_KEYCODE_UP},
+    {"pageup", SAPP_KEYCODE_PAGE_UP},
+    {"pagedown", SAPP_KEYCODE_PAGE_DOWN},
+    {"home", SAPP_KEYCODE_HOME},
+    {"end", SAPP_KEYCODE_END},
+};
+
+sapp_keycode parse_key(const std::string &name) {
+  if (name.size() == 1 && isalnum((unsigned char)name[0]))
+    return (sapp_keycode)toupper((unsigned char)name[0]);
+  if (name.size() >= 2 && name[0] == 'f' && isdigit((unsigned char)name[1])) {
+    int n = atoi(name.c_str() + 1);
+    if (n >= 1 && n <= 25 && name.find_first_not_of("0123456789", 1) ==
+                                 std::string::npos)
+      return (sapp_keycode)(SAPP_KEYCODE_F1 + n - 1);
+  }
+  for (const KeyName &k : kKeyNames)
+    if (name == k.name)
+      return k.key;
+  return SAPP_KEYCODE_INVALID;
+}
+
+/// Parse "Mod+Shift+P" into a key and modifiers: Ctrl (Control), Shift, Alt
+/// (Option), Cmd (Super, Meta) and Mod, which is Cmd on macOS and Ctrl
+/// elsewhere, then one key. Case-insensitive. Returns false if it isn't a
+/// chord.
+bool parse_chord(const std::string &chord, sapp_keycode &key,
+                 uint32_t &modifiers) {
+  key = SAPP_KEYCODE_INVALID;
+  modifiers = 0;
+  size_t start = 0;
+  while (start <= chord.size()) {
+    // "Ctrl++" isn't supported; the key is "Equal" or "=" with Shift
+    size_t end = chord.find('+', start);
+    if (end == std::string::npos)
+      end = chord.size();
+    std::string part;
+    for (size_t i = start; i < end; ++i)
+      if (!isspace((unsigned char)chord[i]))
+        part += (char)tolower((unsigned char)chord[i]);
+    start = end + 1;
+    if (key != SAPP_KEYCODE_INVALID || part.empty())
+      return false;
+    if (part == "ctrl" || part == "control") {
+      modifiers |= SAPP_MODIFIER_CTRL;
+    } else if (part == "shift") {
+      modifiers |= SAPP_MODIFIER_SHIFT;
+    } else if (part == "alt" || part == "option") {
+      modifiers |= SAPP_MODIFIER_ALT;
+    } else if (part == "cmd" || part == "super" || part == "meta") {
+      modifiers |= SAPP_MODIFIER_SUPER;
+    } else if (part == "mod") {
+#ifdef __APPLE__
+      modifiers |= SAPP_MODIFIER_SUPER;
+#else
+      modifiers |= SAPP_MODIFIER_CTRL;
+#endif
+    } else {
+      key = parse_key(part);
+      if (key == SAPP_KEYCODE_INVALID)
+        return false;
+    }
+  }
+  return key != SAPP_KEYCODE_INVALID;
+}
+
+void call_hotkey(int id) {
+  for (const Hotkey &hotkey : s_hotkeys) {
+    if (hotkey.id == id) {
+      // Held by the call, in case the callback unregisters its hotkey
+      std::shared_ptr<facebook::jsi::Function> callback = hotkey.callback;
+      callback->call(*s_runtime);
+      return;
+    }
+  }
+}
+
+} // namespace
+
+void install_hotkeys(facebook::jsi::Runtime &rt, MainThreadPoster postToMain) {
+  s_runtime = &rt;
+  s_post_to_main = postToMain;
+
+  rt.global().setProperty(
+      rt, "__hotkeyRegister",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__hotkeyRegister"), 3,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count < 2 || !args[0].isString() || !args[1].isObject() ||
+                !args[1].getObject(rt).isFunction(rt))
+              throw facebook::jsi::JSError(
+                  rt, "__hotkeyRegister expects a chord and a callback");
+            std::string chord = args[0].getString(rt).utf8(rt);
+            Hotkey hotkey;
+            if (!parse_chord(chord, hotkey.key, hotkey.modifiers))
+              throw facebook::jsi::JSError(rt, "Invalid hotkey: " + chord);
+            hotkey.id = s_next_id++;
+            hotkey.repeat = count > 2 && args[2].isBool() && args[2].getBool();
+            hotkey.callback = std::make_shared<facebook::jsi::Function>(
+                args[1].getObject(rt).getFunction(rt));
+            s_hotkeys.push_back(std::move(hotkey));
+            return s_hotkeys.back().id;
+          }));
+
+  rt.global().setProperty(
+      rt, "__hotkeyUnregister",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__hotkeyUnregister"), 1,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count < 1 || !args[0].isNumber())
+              return facebook::jsi::Value::undefined();
+            int id = (int)args[0].getNumber();
+            for (auto it = s_hotkeys.begin(); it != s_hotkeys.end(); ++it) {
+              if (it->id == id) {
+                s_hotkeys.erase(it);
+                break;
+              }
+            }
+            return facebook::jsi::Value::undefined();
+          }));
+}
+
+bool hotkey_dispatch(const sapp_event &ev) {
+  if (ev.type != SAPP_EVENTTYPE_KEY_DOWN || s_hotkeys.empty() ||
+      !s_post_to_main)
+    return false;
+  uint32_t modifiers = ev.modifiers & kChordModifiers;
+  bool typing = ImGui::GetIO().WantTextInput;
+  for (const Hotkey &hotkey : s_hotkeys) {
+    if (hotkey.key != ev.key_code || hotkey.modifiers != modifiers)
+      continue;
+    if (typing && !(hotkey.modifiers & (SAPP_MODIFIER_CTRL | SAPP_MODIFIER_ALT |
+                                        SAPP_MODIFIER_SUPER)))
+      return false;
+    if (!ev.key_repeat || hotkey.repeat) {
+      int id = hotkey.id;
+      s_post_to_main([id] { call_hotkey(id); });
+    }
+    return true;
+  }
+  return false;
+}
+
+void shutdown_hotkeys() {
+  s_hotkeys.clear();
+  s_post_to_main = nullptr;
+  s_runtime = nullptr;
+}
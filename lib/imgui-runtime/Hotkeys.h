@@ -0,0 +1,37 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include "AsyncFs.h"
+
+#include "sokol_app.h"
+
+#include <hermes/hermes.h>
+
+/// App shortcuts matched natively. JS registers chords ("Ctrl+S",
+/// "Mod+Shift+P", "F2") with a callback; every key-down event is matched
+/// against the table in C++ on the thread that feeds ImGui, before ImGui
+/// sees it. A match posts one call of the callback, which runs in the next
+/// frame's macrotask phase, and the event goes no further. Events that
+/// don't match cost a table lookup and never enter JS on their own.
+///
+/// Chords without Ctrl, Alt or Cmd don't fire while ImGui wants text input,
+/// so that a "Shift+A" or "Delete" hotkey doesn't steal the keys of a text
+/// field. Key repeats fire only the chords registered with `repeat`, and
+/// are swallowed for the others.
+
+/// Install the __hotkeyRegister(chord, callback, repeat) and
+/// __hotkeyUnregister(id) host functions behind jslib's registerHotkey(),
+/// with `postToMain` for the calls. __hotkeyRegister() throws on a chord
+/// it can't parse.
+void install_hotkeys(facebook::jsi::Runtime &rt, MainThreadPoster postToMain);
+
+/// Match `ev` against the hotkeys, on the thread that owns the ImGui
+/// context. Returns true if it matched a hotkey, in which case neither ImGui
+/// nor JS should get it.
+bool hotkey_dispatch(const sapp_event &ev);
+
+/// Forget the callbacks. Must be called before the runtime is destroyed.
+void shutdown_hotkeys();
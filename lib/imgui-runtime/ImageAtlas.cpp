@@ -0,0 +1,110 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "ImageAtlas.h"
+
+#include <algorithm>
+#include <cstring>
+
+void ImageAtlas::setMaxSize(int maxSize) {
+  // Leave room for the border
+  maxSize_ = std::clamp(maxSize, 0, kPageSize - 2);
+}
+
+bool ImageAtlas::fits(int w, int h) const {
+  return maxSize_ > 0 && w > 0 && h > 0 && w <= maxSize_ && h <= maxSize_;
+}
+
+bool ImageAtlas::place(Page &page, int w, int h, int &x, int &y) {
+  // A shelf that is tall enough, but not so tall that most of it is wasted
+  for (Shelf &shelf : page.shelves) {
+    if (shelf.height >= h && shelf.height <= h + h / 2 &&
+        shelf.x + w <= kPageSize) {
+      x = shelf.x;
+      y = shelf.y;
+      shelf.x += w;
+      return true;
+    }
+  }
+  if (page.nextY + h > kPageSize)
+    return false;
+  page.shelves.push_back(Shelf{page.nextY, h, w});
+  x = 0;
+  y = page.nextY;
+  page.nextY += h;
+  return true;
+}
+
+ImageAtlas::Slot ImageAtlas::add(int w, int h, const unsigned char *pixels) {
+  int bw = w + 2, bh = h + 2;
+  int x = 0, y = 0;
+  int index = 0;
+  for (; index < (int)pages_.size(); ++index)
+    if (place(pages_[index], bw, bh, x, y))
+      break;
+  if (index == (int)pages_.size()) {
+    Page page;
+    page.pixels.assign((size_t)kPageSize * kPageSize * 4, 0);
+    sg_image_desc desc = {};
+    desc.width = kPageSize;
+    desc.height = kPageSize;
+    desc.usage = SG_USAGE_DYNAMIC;
+    desc.label = "image-atlas-page";
+    page.image = sg_make_image(desc);
+    pages_.push_back(std::move(page));
+    place(pages_[index], bw, bh, x, y);
+  }
+
+  // The image at (x + 1, y + 1), with its edge rows and columns repeated
+  // around it
+  Page &page = pages_[index];
+  for (int row = 0; row < bh; ++row) {
+    int srcRow = std::clamp(row - 1, 0, h - 1);
+    const unsigned char *src = pixels + (size_t)srcRow * w * 4;
+    uint8_t *dst = page.pixels.data() + ((size_t)(y + row) * kPageSize + x) * 4;
+    memcpy(dst, src, 4);
+    memcpy(dst + 4, src, (size_t)w * 4);
+    memcpy(dst + (size_t)(w + 1) * 4, src + (size_t)(w - 1) * 4, 4);
+  }
+  ++page.live;
+  page.dirty = true;
+
+  Slot slot;
+  slot.page = index;
+  slot.uv0[0] = (float)(x + 1) / kPageSize;
+  slot.uv0[1] = (float)(y + 1) / kPageSize;
+  slot.uv1[0] = (float)(x + 1 + w) / kPageSize;
+  slot.uv1[1] = (float)(y + 1 + h) / kPageSize;
+  return slot;
+}
+
+void ImageAtlas::remove(const Slot &slot) {
+  if (slot.page < 0 || slot.page >= (int)pages_.size())
+    return;
+  Page &page = pages_[slot.page];
+  // The texture stays, for the page to be filled again; the stale pixels
+  // are overwritten as it is.
+  if (--page.live == 0) {
+    page.shelves.clear();
+    page.nextY = 0;
+  }
+}
+
+void ImageAtlas::flush() {
+  for (Page &page : pages_) {
+    if (!page.dirty)
+      continue;
+    sg_image_data data = {};
+    data.subimage[0][0] = {.ptr = page.pixels.data(),
+                           .size = page.pixels.size()};
+    sg_update_image(page.image, &data);
+    page.dirty = false;
+  }
+}
+
+void ImageAtlas::shutdown() {
+  for (Page &page : pages_)
+    sg_destroy_image(page.image);
+  pages_.clear();
+}
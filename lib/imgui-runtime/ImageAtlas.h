@@ -0,0 +1,77 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include "sokol_gfx.h"
+
+#include <cstdint>
+#include <vector>
+
+/// Packs small RGBA8 images (icons) into shared texture pages, so that the
+/// images drawn together use one texture and ImGui draws them in one batch
+/// instead of switching textures per image. Images are placed on shelves:
+/// rows as tall as their first image, filled left to right. Each image gets
+/// a one pixel border of its own edge pixels, so that linear filtering
+/// never samples a neighbor. The space of a removed image is only
+/// reclaimed once its page is empty. Render thread only.
+class ImageAtlas {
+public:
+  /// Side of a page, in pixels.
+  static constexpr int kPageSize = 1024;
+
+  /// Where add() put an image: its page and UV rectangle.
+  struct Slot {
+    int page = -1;
+    float uv0[2] = {0, 0};
+    float uv1[2] = {1, 1};
+  };
+
+  ImageAtlas() = default;
+
+  ImageAtlas(const ImageAtlas &) = delete;
+  ImageAtlas &operator=(const ImageAtlas &) = delete;
+
+  /// Images of at most `maxSize` pixels per side go into the atlas; 0 (the
+  /// default) turns it off.
+  void setMaxSize(int maxSize);
+  bool fits(int w, int h) const;
+
+  /// Copy `w` x `h` RGBA8 `pixels` into a page, adding one when none has
+  /// room. The copy reaches the GPU with the next flush().
+  Slot add(int w, int h, const unsigned char *pixels);
+  /// Release the space of `slot`.
+  void remove(const Slot &slot);
+
+  /// The texture of `page`.
+  sg_image pageImage(int page) const { return pages_[page].image; }
+  int pageCount() const { return (int)pages_.size(); }
+
+  /// Upload the pages that changed since the last call. At most once per
+  /// frame, before the frame's draws.
+  void flush();
+  /// Destroy the page textures, before sg_shutdown().
+  void shutdown();
+
+private:
+  struct Shelf {
+    int y, height, x;
+  };
+  struct Page {
+    std::vector<uint8_t> pixels;
+    std::vector<Shelf> shelves;
+    /// Top of the unused space below the shelves.
+    int nextY = 0;
+    /// Images in the page.
+    int live = 0;
+    bool dirty = false;
+    sg_image image = {};
+  };
+
+  /// Find room for a `w` x `h` rectangle in `page`.
+  static bool place(Page &page, int w, int h, int &x, int &y);
+
+  int maxSize_ = 0;
+  std::vector<Page> pages_;
+};
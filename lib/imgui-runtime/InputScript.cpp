@@ -0,0 +1,165 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "InputScript.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+struct EventName {
+  const char *name;
+  sapp_event_type type;
+};
+
+const EventName kEventNames[] = {
+    {"mouse_move", SAPP_EVENTTYPE_MOUSE_MOVE},
+    {"mouse_down", SAPP_EVENTTYPE_MOUSE_DOWN},
+    {"mouse_up", SAPP_EVENTTYPE_MOUSE_UP},
+    {"scroll", SAPP_EVENTTYPE_MOUSE_SCROLL},
+    {"key_down", SAPP_EVENTTYPE_KEY_DOWN},
+    {"key_up", SAPP_EVENTTYPE_KEY_UP},
+    {"char", SAPP_EVENTTYPE_CHAR},
+};
+
+const char *name_of(sapp_event_type type) {
+  for (const EventName &e : kEventNames)
+    if (e.type == type)
+      return e.name;
+  return nullptr;
+}
+
+/// Parse the arguments of an event line into `ev`, whose type is set.
+bool parse_args(const char *args, sapp_event &ev) {
+  unsigned mods = 0;
+  int button = 0, code = 0;
+  switch (ev.type) {
+  case SAPP_EVENTTYPE_MOUSE_MOVE:
+    return sscanf(args, "%f %f", &ev.mouse_x, &ev.mouse_y) == 2;
+  case SAPP_EVENTTYPE_MOUSE_DOWN:
+  case SAPP_EVENTTYPE_MOUSE_UP:
+    if (sscanf(args, "%d %f %f %u", &button, &ev.mouse_x, &ev.mouse_y,
+               &mods) < 3)
+      return false;
+    ev.mouse_button = (sapp_mousebutton)button;
+    break;
+  case SAPP_EVENTTYPE_MOUSE_SCROLL:
+    return sscanf(args, "%f %f", &ev.scroll_x, &ev.scroll_y) == 2;
+  case SAPP_EVENTTYPE_KEY_DOWN:
+  case SAPP_EVENTTYPE_KEY_UP:
+    if (sscanf(args, "%d %u", &code, &mods) < 1)
+      return false;
+    ev.key_code = (sapp_keycode)code;
+    break;
+  case SAPP_EVENTTYPE_CHAR:
+    if (sscanf(args, "%u %u", &ev.char_code, &mods) < 1)
+      return false;
+    break;
+  default:
+    return false;
+  }
+  ev.modifiers = mods;
+  return true;
+}
+
+} // namespace
+
+bool load_input_script(const char *path, InputScript &script) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "Can't read input script %s\n", path);
+    return false;
+  }
+  script = InputScript{};
+  char line[256];
+  int lineNo = 0;
+  bool ok = true;
+  while (ok && fgets(line, sizeof(line), f)) {
+    ++lineNo;
+    if (char *comment = strchr(line, '#'))
+      *comment = 0;
+    char word[32];
+    int frame, used = 0;
+    if (sscanf(line, " %31s", word) != 1)
+      continue;
+    if (strcmp(word, "size") == 0) {
+      ok = sscanf(line, " size %d %d", &script.width, &script.height) == 2;
+      continue;
+    }
+    ok = sscanf(line, " %d %31s%n", &frame, word, &used) == 2 && frame >= 0;
+    ScriptEvent event{frame, {}};
+    event.ev.type = SAPP_EVENTTYPE_INVALID;
+    for (const EventName &e : kEventNames)
+      if (ok && strcmp(word, e.name) == 0)
+        event.ev.type = e.type;
+    ok = ok && event.ev.type != SAPP_EVENTTYPE_INVALID &&
+         parse_args(line + used, event.ev);
+    if (ok)
+      script.events.push_back(event);
+  }
+  fclose(f);
+  if (!ok) {
+    fprintf(stderr, "%s:%d: malformed input script line\n", path, lineNo);
+    return false;
+  }
+  std::stable_sort(script.events.begin(), script.events.end(),
+                   [](const ScriptEvent &a, const ScriptEvent &b) {
+                     return a.frame < b.frame;
+                   });
+  return true;
+}
+
+bool InputRecorder::start(const char *path, int width, int height,
+                          uint64_t firstFrame) {
+  stop();
+  file_ = fopen(path, "w");
+  if (!file_) {
+    fprintf(stderr, "Can't write input script %s\n", path);
+    return false;
+  }
+  firstFrame_ = firstFrame;
+  fprintf(file_, "# Input script, replay with --headless --script=%s\n", path);
+  fprintf(file_, "size %d %d\n", width, height);
+  printf("Recording input to %s\n", path);
+  return true;
+}
+
+void InputRecorder::record(uint64_t frame, const sapp_event &ev) {
+  const char *name = name_of(ev.type);
+  if (!file_ || !name)
+    return;
+  int rel = (int)(frame - firstFrame_);
+  switch (ev.type) {
+  case SAPP_EVENTTYPE_MOUSE_MOVE:
+    fprintf(file_, "%d %s %g %g\n", rel, name, ev.mouse_x, ev.mouse_y);
+    break;
+  case SAPP_EVENTTYPE_MOUSE_DOWN:
+  case SAPP_EVENTTYPE_MOUSE_UP:
+    fprintf(file_, "%d %s %d %g %g %u\n", rel, name, (int)ev.mouse_button,
+            ev.mouse_x, ev.mouse_y, ev.modifiers);
+    break;
+  case SAPP_EVENTTYPE_MOUSE_SCROLL:
+    fprintf(file_, "%d %s %g %g\n", rel, name, ev.scroll_x, ev.scroll_y);
+    break;
+  case SAPP_EVENTTYPE_KEY_DOWN:
+  case SAPP_EVENTTYPE_KEY_UP:
+    // Auto-repeats come back as repeated downs.
+    fprintf(file_, "%d %s %d %u\n", rel, name, (int)ev.key_code,
+            ev.modifiers);
+    break;
+  case SAPP_EVENTTYPE_CHAR:
+    fprintf(file_, "%d %s %u %u\n", rel, name, ev.char_code, ev.modifiers);
+    break;
+  default:
+    break;
+  }
+}
+
+void InputRecorder::stop() {
+  if (!file_)
+    return;
+  fclose(file_);
+  file_ = nullptr;
+}
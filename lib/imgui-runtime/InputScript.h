@@ -0,0 +1,68 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include "sokol_app.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+/// Input scripts: sokol_app input events tagged with the frame that handles
+/// them, recorded in a window (IMGUI_RECORD) and replayed by headless runs
+/// (--script) at a fixed time step. One event per line:
+///
+///   size <width> <height>
+///   <frame> mouse_move <x> <y>
+///   <frame> mouse_down <button> <x> <y> [<modifiers>]
+///   <frame> mouse_up <button> <x> <y> [<modifiers>]
+///   <frame> scroll <dx> <dy>
+///   <frame> key_down <keycode> [<modifiers>]
+///   <frame> key_up <keycode> [<modifiers>]
+///   <frame> char <codepoint> [<modifiers>]
+///
+/// Frames count from 0, the first frame of the run. Buttons, key codes and
+/// modifier bits are sokol_app's (SAPP_MOUSEBUTTON_*, SAPP_KEYCODE_*,
+/// SAPP_MODIFIER_*) and coordinates are framebuffer pixels. Clicks and drags
+/// are down, move and up events. `#` starts a comment.
+
+struct ScriptEvent {
+  int frame;
+  sapp_event ev;
+};
+
+struct InputScript {
+  /// Window size of the recording, 0 if the script doesn't say.
+  int width = 0;
+  int height = 0;
+  /// Events by frame, in file order within a frame.
+  std::vector<ScriptEvent> events;
+};
+
+/// Read the script at `path`. Returns false, after printing the reason, if
+/// the file can't be read or has a malformed line.
+bool load_input_script(const char *path, InputScript &script);
+
+/// Writes the input events of a windowed session as a script.
+class InputRecorder {
+public:
+  InputRecorder() = default;
+  ~InputRecorder() { stop(); }
+
+  InputRecorder(const InputRecorder &) = delete;
+  InputRecorder &operator=(const InputRecorder &) = delete;
+
+  /// Start writing to `path`, with frame numbers relative to `firstFrame`.
+  bool start(const char *path, int width, int height, uint64_t firstFrame);
+  /// Record `ev` if it is one of the scripted event types.
+  void record(uint64_t frame, const sapp_event &ev);
+  void stop();
+
+  bool recording() const { return file_ != nullptr; }
+
+private:
+  FILE *file_ = nullptr;
+  uint64_t firstFrame_ = 0;
+};
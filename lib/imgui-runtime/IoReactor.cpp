@@ -0,0 +1,172 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "IoReactor.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#else
+#include <sys/event.h>
+#include <sys/time.h>
+#endif
+
+namespace {
+
+/// Maximum number of events fetched by one wait().
+constexpr int kMaxEvents = 64;
+
+void setNonBlockingCloExec(int fd) {
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  fcntl(fd, F_SETFD, fcntl(fd, F_GETFD) | FD_CLOEXEC);
+}
+
+} // namespace
+
+IoReactor::IoReactor() {
+#if defined(__linux__)
+  pollFd_ = epoll_create1(EPOLL_CLOEXEC);
+#else
+  pollFd_ = kqueue();
+  if (pollFd_ >= 0)
+    fcntl(pollFd_, F_SETFD, FD_CLOEXEC);
+#endif
+  if (pollFd_ < 0 || pipe(wakePipe_) < 0) {
+    perror("IoReactor");
+    abort();
+  }
+  setNonBlockingCloExec(wakePipe_[0]);
+  setNonBlockingCloExec(wakePipe_[1]);
+  update(wakePipe_[0], 0, kReadable);
+}
+
+IoReactor::~IoReactor() {
+  close(wakePipe_[0]);
+  close(wakePipe_[1]);
+  close(pollFd_);
+}
+
+bool IoReactor::watch(int fd, unsigned events) {
+  if (fd < 0 || fd == wakePipe_[0] || fd == wakePipe_[1])
+    return false;
+  events &= kReadable | kWritable;
+  if (!events) {
+    unwatch(fd);
+    return true;
+  }
+  auto it = watched_.find(fd);
+  unsigned oldEvents = it != watched_.end() ? it->second : 0;
+  if (!update(fd, oldEvents, events))
+    return false;
+  watched_[fd] = events;
+  return true;
+}
+
+void IoReactor::unwatch(int fd) {
+  auto it = watched_.find(fd);
+  if (it == watched_.end())
+    return;
+  update(fd, it->second, 0);
+  watched_.erase(it);
+}
+
+#if defined(__linux__)
+
+bool IoReactor::update(int fd, unsigned oldEvents, unsigned newEvents) {
+  if (!newEvents)
+    return epoll_ctl(pollFd_, EPOLL_CTL_DEL, fd, nullptr) == 0;
+  epoll_event ev{};
+  // EPOLLIN/EPOLLOUT are enumerators; keep both ternary arms uint32_t.
+  ev.events = ((newEvents & kReadable) ? (uint32_t)EPOLLIN : 0u) |
+              ((newEvents & kWritable) ? (uint32_t)EPOLLOUT : 0u);
+  ev.data.fd = fd;
+  return epoll_ctl(pollFd_, oldEvents ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd,
+                   &ev) == 0;
+}
+
+bool IoReactor::wait(double timeoutMs, std::vector<Event> *ready) {
+  // Round up, so that a timer deadline is never missed by waking early.
+  int ms = timeoutMs > 0 ? (int)std::ceil(timeoutMs) : 0;
+  epoll_event evs[kMaxEvents];
+  int n = epoll_wait(pollFd_, evs, kMaxEvents, ms);
+  if (n < 0)
+    return false; // EINTR
+  for (int i = 0; i < n; ++i) {
+    if (evs[i].data.fd == wakePipe_[0]) {
+      drainWakePipe();
+      continue;
+    }
+    if (!ready)
+      continue;
+    unsigned events = 0;
+    // Errors and hang-ups are reported as readable: the read returns them.
+    if (evs[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+      events |= kReadable;
+    if (evs[i].events & EPOLLOUT)
+      events |= kWritable;
+    ready->push_back({evs[i].data.fd, events});
+  }
+  return n > 0;
+}
+
+#else
+
+bool IoReactor::update(int fd, unsigned oldEvents, unsigned newEvents) {
+  struct kevent changes[2];
+  int n = 0;
+  unsigned changed = oldEvents ^ newEvents;
+  if (changed & kReadable) {
+    EV_SET(&changes[n++], fd, EVFILT_READ,
+           (newEvents & kReadable) ? EV_ADD : EV_DELETE, 0, 0, nullptr);
+  }
+  if (changed & kWritable) {
+    EV_SET(&changes[n++], fd, EVFILT_WRITE,
+           (newEvents & kWritable) ? EV_ADD : EV_DELETE, 0, 0, nullptr);
+  }
+  return kevent(pollFd_, changes, n, nullptr, 0, nullptr) == 0;
+}
+
+bool IoReactor::wait(double timeoutMs, std::vector<Event> *ready) {
+  double ms = timeoutMs > 0 ? timeoutMs : 0;
+  struct timespec ts;
+  ts.tv_sec = (time_t)(ms / 1000);
+  ts.tv_nsec = (long)((ms - ts.tv_sec * 1000.0) * 1e6);
+  struct kevent evs[kMaxEvents];
+  int n = kevent(pollFd_, nullptr, 0, evs, kMaxEvents, &ts);
+  if (n < 0)
+    return false; // EINTR
+  for (int i = 0; i < n; ++i) {
+    int fd = (int)evs[i].ident;
+    if (fd == wakePipe_[0]) {
+      drainWakePipe();
+      continue;
+    }
+    if (ready) {
+      unsigned events = evs[i].filter == EVFILT_WRITE ? kWritable : kReadable;
+      ready->push_back({fd, events});
+    }
+  }
+  return n > 0;
+}
+
+#endif
+
+void IoReactor::wake() {
+  char c = 0;
+  // A full pipe already has a wakeup pending, so EAGAIN can be ignored.
+  while (write(wakePipe_[1], &c, 1) < 0 && errno == EINTR) {
+  }
+}
+
+void IoReactor::drainWakePipe() {
+  char buf[64];
+  while (read(wakePipe_[0], buf, sizeof(buf)) > 0) {
+  }
+}
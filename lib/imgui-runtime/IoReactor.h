@@ -0,0 +1,61 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+/// Readiness notifications for file descriptors (sockets, pipes), waited on
+/// by the main loop together with its timer deadline. Uses epoll on Linux and
+/// kqueue on macOS and the BSDs. Level-triggered: a descriptor is reported by
+/// every wait() for as long as it stays ready.
+class IoReactor {
+public:
+  enum : unsigned { kReadable = 1, kWritable = 2 };
+
+  struct Event {
+    int fd;
+    unsigned events;
+  };
+
+  IoReactor();
+  ~IoReactor();
+
+  IoReactor(const IoReactor &) = delete;
+  IoReactor &operator=(const IoReactor &) = delete;
+
+  /// Watch `fd` for `events` (kReadable | kWritable), replacing the mask of
+  /// an fd that is already watched. An empty mask unwatches it.
+  /// Returns false if the fd can't be watched.
+  bool watch(int fd, unsigned events);
+
+  /// Stop watching `fd`. Must be called before the fd is closed.
+  void unwatch(int fd);
+
+  /// Number of watched file descriptors.
+  size_t watchCount() const { return watched_.size(); }
+
+  /// Wait for up to `timeoutMs` milliseconds (0 just polls) until a watched
+  /// fd is ready or wake() is called. Ready fds are appended to `ready` if it
+  /// isn't null. Returns true if an fd was ready or wake() was called since
+  /// the previous wait().
+  bool wait(double timeoutMs, std::vector<Event> *ready);
+
+  /// Make the current or the next wait() return. Safe to call from any
+  /// thread.
+  void wake();
+
+private:
+  bool update(int fd, unsigned oldEvents, unsigned newEvents);
+  void drainWakePipe();
+
+  /// epoll or kqueue descriptor.
+  int pollFd_ = -1;
+  /// Self-pipe used by wake(): [0] is watched, [1] is written to.
+  int wakePipe_[2] = {-1, -1};
+  /// Event masks of the watched fds.
+  std::unordered_map<int, unsigned> watched_{};
+};
@@ -9,12 +9,15 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <vector>
+
 namespace {
 
 // Memory-mapped file buffer for loading bytecode/source
 class MappedFileBuffer : public facebook::jsi::Buffer {
 public:
-  explicit MappedFileBuffer(const char *path, bool attemptTrailingZero) {
+  MappedFileBuffer(const char *path, bool attemptTrailingZero,
+                   const MapFileOptions &options) {
     assert(path && path[0]);
     fd_ = open(path, O_RDONLY);
     if (fd_ < 0) {
@@ -44,14 +47,33 @@ public:
       size_ = fileSize_;
     }
 
+#ifdef MADV_HUGEPAGE
+    if (options.hugePages && fileSize_ >= kHugePageSize &&
+        readIntoHugePages(attemptTrailingZero)) {
+      return;
+    }
+#endif
+
+    int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    if (options.populate)
+      flags |= MAP_POPULATE;
+#endif
     data_ = static_cast<const uint8_t *>(
-        mmap(nullptr, mappedSize_, PROT_READ, MAP_PRIVATE, fd_, 0));
+        mmap(nullptr, mappedSize_, PROT_READ, flags, fd_, 0));
 
     if (data_ == MAP_FAILED) {
       close(fd_);
       throw std::runtime_error(std::string("Failed to mmap React bundle: ") +
                                path);
     }
+
+    // Advice is only a hint, failures don't matter
+    void *addr = const_cast<uint8_t *>(data_);
+    if (options.sequential)
+      madvise(addr, mappedSize_, MADV_SEQUENTIAL);
+    if (options.willNeed)
+      madvise(addr, mappedSize_, MADV_WILLNEED);
   }
 
   ~MappedFileBuffer() override {
@@ -67,6 +89,45 @@ public:
   const uint8_t *data() const override { return data_; }
 
 private:
+#ifdef MADV_HUGEPAGE
+  /// Read the file into an anonymous mapping aligned to huge pages. Returns
+  /// false, with nothing allocated, if that fails.
+  bool readIntoHugePages(bool attemptTrailingZero) {
+    // Anonymous memory is zeroed, so the extra byte is always available.
+    size_t allocSize = ((fileSize_ + 1 + kHugePageSize - 1) / kHugePageSize) *
+                       kHugePageSize;
+    void *mem = mmap(nullptr, allocSize + kHugePageSize,
+                     PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                     -1, 0);
+    if (mem == MAP_FAILED)
+      return false;
+    // Trim the reservation to a huge page boundary
+    uintptr_t start = reinterpret_cast<uintptr_t>(mem);
+    uintptr_t aligned = (start + kHugePageSize - 1) & ~(kHugePageSize - 1);
+    if (aligned > start)
+      munmap(mem, aligned - start);
+    munmap(reinterpret_cast<void *>(aligned + allocSize),
+           start + kHugePageSize - aligned);
+    uint8_t *data = reinterpret_cast<uint8_t *>(aligned);
+    madvise(data, allocSize, MADV_HUGEPAGE);
+
+    size_t done = 0;
+    while (done < fileSize_) {
+      ssize_t n = pread(fd_, data + done, fileSize_ - done, (off_t)done);
+      if (n <= 0) {
+        munmap(data, allocSize);
+        return false;
+      }
+      done += (size_t)n;
+    }
+    mprotect(data, allocSize, PROT_READ);
+    data_ = data;
+    mappedSize_ = allocSize;
+    size_ = attemptTrailingZero ? fileSize_ + 1 : fileSize_;
+    return true;
+  }
+#endif
+
   int fd_ = -1;
   const uint8_t *data_ = nullptr;
   size_t fileSize_ = 0;   // Actual file size
@@ -74,9 +135,52 @@ private:
   size_t size_ = 0;       // Size to report (may include null terminator)
 };
 
+// Copy-on-write mapping of a whole file, for ArrayBuffers
+class MappedMutableFileBuffer : public facebook::jsi::MutableBuffer {
+public:
+  MappedMutableFileBuffer(uint8_t *data, size_t size)
+      : data_(data), size_(size) {}
+  ~MappedMutableFileBuffer() override { munmap(data_, size_); }
+
+  size_t size() const override { return size_; }
+  uint8_t *data() override { return data_; }
+
+private:
+  uint8_t *data_;
+  size_t size_;
+};
+
 }
 
 std::shared_ptr<facebook::jsi::Buffer>
-mapFileBuffer(const char *path, bool attemptTrailingZero) {
-  return std::make_shared<MappedFileBuffer>(path, attemptTrailingZero);
+mapFileBuffer(const char *path, bool attemptTrailingZero,
+              const MapFileOptions *options) {
+  return std::make_shared<MappedFileBuffer>(
+      path, attemptTrailingZero, options ? *options : MapFileOptions{});
+}
+
+bool prefetchFile(const char *path) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return false;
+#ifdef POSIX_FADV_SEQUENTIAL
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+  // Reading, rather than only advising, also works on file systems that
+  // ignore read-ahead hints
+  std::vector<char> chunk(1024 * 1024);
+  ssize_t n;
+  while ((n = read(fd, chunk.data(), chunk.size())) > 0) {
+  }
+  close(fd);
+  return n == 0;
+}
+
+std::shared_ptr<facebook::jsi::MutableBuffer>
+mapFileMutableBuffer(int fd, size_t size) {
+  void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  if (data == MAP_FAILED)
+    return nullptr;
+  return std::make_shared<MappedMutableFileBuffer>(static_cast<uint8_t *>(data),
+                                                   size);
 }
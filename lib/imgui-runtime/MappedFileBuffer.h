@@ -7,11 +7,46 @@
 #include <hermes/hermes.h>
 #include <memory>
 
+/// How mapFileBuffer() brings a file into memory. By default pages are
+/// faulted in as they are first touched.
+struct MapFileOptions {
+  /// MAP_POPULATE: read the whole file during mmap() (Linux only).
+  bool populate = false;
+  /// madvise(MADV_WILLNEED): start reading the file in the background.
+  bool willNeed = false;
+  /// madvise(MADV_SEQUENTIAL): read ahead aggressively.
+  bool sequential = false;
+  /// Read files of at least kHugePageSize into anonymous memory backed by
+  /// transparent huge pages instead of mapping them, which takes one read()
+  /// instead of a fault per page and fewer TLB entries (Linux only).
+  bool hugePages = false;
+};
+
+constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
 /// Memory map a file.
 ///
 /// @param path the file path to map
 /// @param attemptTrailingZero if possible, add a trailing zero and increase the
 ///   logical mapped size to include it.
+/// @param options how to load the pages, defaults if null
 /// @return memory mapped buffer
 std::shared_ptr<facebook::jsi::Buffer>
-mapFileBuffer(const char *path, bool attemptTrailingZero = false);
+mapFileBuffer(const char *path, bool attemptTrailingZero = false,
+              const MapFileOptions *options = nullptr);
+
+/// Read `path` into the page cache, so that mapping it later doesn't wait
+/// for the disk. Blocks; runs on a background thread at startup. Returns
+/// false if the file can't be read.
+bool prefetchFile(const char *path);
+
+/// Memory map a file as a private, copy-on-write mutable buffer, which can
+/// back a jsi::ArrayBuffer without copying the file. Writes are never
+/// written back to the file.
+///
+/// @param fd an open file descriptor of a regular, non-empty file; it can be
+///   closed after the call
+/// @param size the size of the file in bytes
+/// @return memory mapped buffer, or nullptr if mmap() failed (errno is set)
+std::shared_ptr<facebook::jsi::MutableBuffer>
+mapFileMutableBuffer(int fd, size_t size);
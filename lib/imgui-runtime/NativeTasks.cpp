@@ -0,0 +1,185 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "NativeTasks.h"
+
+#include "SharedBuffer.h"
+#include "ThreadPool.h"
+#include "imgui-runtime.h"
+
+#include <exception>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using Kernel = void (*)(ImguiNativeTask &);
+
+/// The kernels by name. A function-local static, as the kernels register
+/// during static initialization.
+std::unordered_map<std::string, Kernel> &kernels() {
+  static std::unordered_map<std::string, Kernel> table;
+  return table;
+}
+
+/// The output buffer of a kernel, handed to JS without a copy.
+class OutputBuffer : public facebook::jsi::MutableBuffer {
+public:
+  explicit OutputBuffer(std::vector<uint8_t> &&bytes)
+      : bytes_(std::move(bytes)) {}
+
+  size_t size() const override { return bytes_.size(); }
+  uint8_t *data() override { return bytes_.data(); }
+
+private:
+  std::vector<uint8_t> bytes_;
+};
+
+/// A task in flight, filled in by a worker.
+struct TaskState {
+  ImguiNativeTask task;
+  /// Keeps `task.data` alive.
+  std::shared_ptr<facebook::jsi::MutableBuffer> input;
+  /// What the kernel threw, "" on success.
+  std::string error;
+};
+
+/// Callbacks of the tasks in flight, by task ID. Main thread only.
+std::unordered_map<unsigned, facebook::jsi::Function> s_callbacks{};
+unsigned s_next_task = 1;
+
+void run_kernel(Kernel kernel, TaskState &state) {
+  // Dropped while it was queued
+  if (ThreadPool::cancelled()) {
+    state.error = "cancelled";
+    return;
+  }
+  try {
+    kernel(state.task);
+  } catch (const std::exception &e) {
+    state.error = e.what();
+    if (state.error.empty())
+      state.error = "native task failed";
+  } catch (...) {
+    state.error = "native task failed";
+  }
+}
+
+/// Pass the result of a task to its callback.
+void complete(facebook::jsi::Runtime &rt, unsigned id, const std::string &name,
+              TaskState &state) {
+  auto it = s_callbacks.find(id);
+  if (it == s_callbacks.end())
+    return;
+  facebook::jsi::Function callback = std::move(it->second);
+  s_callbacks.erase(it);
+
+  if (!state.error.empty()) {
+    callback.call(rt, "runNative('" + name + "'): " + state.error);
+    return;
+  }
+  facebook::jsi::Value buffer = facebook::jsi::Value::null();
+  bool inPlace = state.task.output.empty();
+  if (!inPlace) {
+    auto output = std::make_shared<OutputBuffer>(std::move(state.task.output));
+    // A worker can be handed the result without a copy. (Inputs are
+    // registered already.)
+    register_transferable_buffer(output, false);
+    buffer = facebook::jsi::ArrayBuffer(rt, std::move(output));
+  } else if (state.input) {
+    buffer = facebook::jsi::ArrayBuffer(rt, std::move(state.input));
+  }
+  callback.call(rt, facebook::jsi::Value::null(),
+                facebook::jsi::String::createFromUtf8(rt, state.task.result),
+                buffer, inPlace);
+}
+
+/// The priority named by `value`, if it is a string.
+TaskPriority parse_priority(facebook::jsi::Runtime &rt,
+                            const facebook::jsi::Value *value) {
+  if (!value || !value->isString())
+    return TaskPriority::Normal;
+  std::string name = value->getString(rt).utf8(rt);
+  if (name == "interactive")
+    return TaskPriority::Interactive;
+  if (name == "background")
+    return TaskPriority::Background;
+  if (name != "normal")
+    throw facebook::jsi::JSError(rt, "runNative: unknown priority " + name);
+  return TaskPriority::Normal;
+}
+
+} // namespace
+
+bool ImguiNativeTask::cancelled() const { return ThreadPool::cancelled(); }
+
+void add_native_task(const char *name, Kernel kernel) {
+  kernels()[name] = kernel;
+}
+
+void install_native_tasks(facebook::jsi::Runtime &rt, ThreadPool &pool,
+                          MainThreadPoster postToMain) {
+  rt.global().setProperty(
+      rt, "__runNative",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__runNative"), 6,
+          [&pool, postToMain](facebook::jsi::Runtime &rt,
+                              const facebook::jsi::Value &,
+                              const facebook::jsi::Value *args,
+                              size_t count) -> facebook::jsi::Value {
+            if (count < 6 || !args[0].isString() || !args[4].isString() ||
+                !args[5].isObject() || !args[5].getObject(rt).isFunction(rt)) {
+              throw facebook::jsi::JSError(
+                  rt, "__runNative expects a name, a buffer, its range, the "
+                      "params and a callback");
+            }
+            std::string name = args[0].getString(rt).utf8(rt);
+            auto found = kernels().find(name);
+            if (found == kernels().end())
+              throw facebook::jsi::JSError(
+                  rt, "runNative: no native task named '" + name + "'");
+            Kernel kernel = found->second;
+            TaskOptions options;
+            options.priority =
+                parse_priority(rt, count > 6 ? &args[6] : nullptr);
+            options.traceName = TraceTaskNative;
+            options.cancel = std::make_shared<CancelToken>();
+
+            auto state = std::make_shared<TaskState>();
+            state->task.params = args[4].getString(rt).utf8(rt);
+            if (args[1].isObject() && args[1].getObject(rt).isArrayBuffer(rt)) {
+              facebook::jsi::ArrayBuffer ab =
+                  args[1].getObject(rt).getArrayBuffer(rt);
+              size_t size = ab.size(rt);
+              double offset = args[2].isNumber() ? args[2].getNumber() : 0;
+              double length = args[3].isNumber() ? args[3].getNumber() : 0;
+              if (!(offset >= 0) || !(length >= 0) || offset + length > size)
+                throw facebook::jsi::JSError(rt, "runNative: bad input range");
+              // The JS heap may move or free its own memory, so the worker
+              // gets native memory: a shared buffer's, or a copy
+              state->input = shared_buffer_for_message(rt, ab, false);
+              state->task.data = state->input->data() + (size_t)offset;
+              state->task.size = (size_t)length;
+            }
+
+            unsigned id = s_next_task++;
+            s_callbacks.emplace(id, args[5].getObject(rt).getFunction(rt));
+
+            facebook::jsi::Runtime *rtp = &rt;
+            unsigned cancelId = register_cancel_token(options.cancel);
+            pool.post(
+                [rtp, id, name, kernel, state, postToMain] {
+                  run_kernel(kernel, *state);
+                  postToMain([rtp, id, name, state] {
+                    complete(*rtp, id, name, *state);
+                  });
+                },
+                std::move(options));
+            return (double)cancelId;
+          }));
+}
+
+void shutdown_native_tasks() { s_callbacks.clear(); }
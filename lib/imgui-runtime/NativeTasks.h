@@ -0,0 +1,32 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include "AsyncFs.h"
+
+#include <hermes/hermes.h>
+
+struct ImguiNativeTask;
+
+/// Register the kernel behind runNative(name, ...) (see
+/// imgui_register_native_task()). A second kernel of the same name replaces
+/// the first.
+void add_native_task(const char *name, void (*kernel)(ImguiNativeTask &));
+
+/// Install the __runNative(name, buffer, byteOffset, byteLength, params,
+/// callback, priority) host function behind jslib's runNative(). The kernel
+/// runs on `pool`, at `priority` ('interactive', 'normal' or 'background'),
+/// with a native copy of the buffer's bytes (a shared buffer's own memory)
+/// and the params' JSON text. `postToMain` brings the result back to the
+/// main thread, where `callback(message, result, buffer, inPlace)` is
+/// called: the error message or null, the kernel's JSON text, and its
+/// output buffer or, when `inPlace`, the input's. Returns the task's
+/// __cancelTask() ID.
+void install_native_tasks(facebook::jsi::Runtime &rt, ThreadPool &pool,
+                          MainThreadPoster postToMain);
+
+/// Forget the callbacks of the tasks in flight (see "Shutdown order" in
+/// ThreadPool.h).
+void shutdown_native_tasks();
@@ -0,0 +1,116 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "Notifier.h"
+
+#include "imgui-runtime.h"
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+/// The notifiers by name. They live until the process exits; the list only
+/// grows, under the mutex.
+std::mutex s_notifiers_mutex;
+std::unordered_map<std::string, Notifier *> s_notifiers_by_name;
+std::vector<std::unique_ptr<Notifier>> s_notifiers;
+
+/// Set by install_notifiers(); until then signals only accumulate.
+std::atomic<MainThreadPoster> s_post_to_main{nullptr};
+
+/// The JS callbacks by notifier. Main thread only.
+std::unordered_map<Notifier *, facebook::jsi::Function> s_callbacks;
+facebook::jsi::Runtime *s_runtime = nullptr;
+
+/// Main thread: pass the batch of signals of `notifier` to its callback.
+void deliver(Notifier *notifier) {
+  uint32_t count = notifier->take();
+  auto it = s_callbacks.find(notifier);
+  if (!count || it == s_callbacks.end() || !s_runtime)
+    return;
+  it->second.call(*s_runtime, (double)count);
+}
+
+void post_delivery(Notifier *notifier) {
+  if (MainThreadPoster post = s_post_to_main.load(std::memory_order_acquire))
+    post([notifier] { deliver(notifier); });
+}
+
+} // namespace
+
+void Notifier::signal(uint32_t count) {
+  // Only the first signal of a batch posts; deliver() starts the next one
+  if (count && pending_.fetch_add(count, std::memory_order_acq_rel) == 0)
+    post_delivery(this);
+}
+
+Notifier &imgui_notifier(const char *name) {
+  std::lock_guard<std::mutex> lock(s_notifiers_mutex);
+  auto it = s_notifiers_by_name.find(name);
+  if (it != s_notifiers_by_name.end())
+    return *it->second;
+  s_notifiers.push_back(std::make_unique<Notifier>(name));
+  s_notifiers_by_name.emplace(name, s_notifiers.back().get());
+  return *s_notifiers.back();
+}
+
+void install_notify(facebook::jsi::Runtime &rt) {
+  rt.global().setProperty(
+      rt, "__notify",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__notify"), 2,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count < 1 || !args[0].isString())
+              throw facebook::jsi::JSError(rt, "__notify expects a name");
+            double times = count > 1 && args[1].isNumber()
+                               ? args[1].getNumber()
+                               : 1;
+            if (times >= 1)
+              imgui_notifier(args[0].getString(rt).utf8(rt).c_str())
+                  .signal(times < 4294967295.0 ? (uint32_t)times
+                                               : 4294967295u);
+            return facebook::jsi::Value::undefined();
+          }));
+}
+
+void install_notifiers(facebook::jsi::Runtime &rt,
+                       MainThreadPoster postToMain) {
+  s_runtime = &rt;
+  install_notify(rt);
+  rt.global().setProperty(
+      rt, "__onNotify",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__onNotify"), 2,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count < 1 || !args[0].isString())
+              throw facebook::jsi::JSError(rt, "__onNotify expects a name");
+            Notifier *notifier =
+                &imgui_notifier(args[0].getString(rt).utf8(rt).c_str());
+            s_callbacks.erase(notifier);
+            if (count > 1 && args[1].isObject() &&
+                args[1].getObject(rt).isFunction(rt))
+              s_callbacks.emplace(notifier,
+                                  args[1].getObject(rt).getFunction(rt));
+            return facebook::jsi::Value::undefined();
+          }));
+
+  s_post_to_main.store(postToMain, std::memory_order_release);
+  // Signals that came before the poster: their first one couldn't post
+  std::lock_guard<std::mutex> lock(s_notifiers_mutex);
+  for (auto &notifier : s_notifiers)
+    post_delivery(notifier.get());
+}
+
+void shutdown_notifiers() {
+  s_post_to_main.store(nullptr, std::memory_order_release);
+  s_callbacks.clear();
+  s_runtime = nullptr;
+}
@@ -0,0 +1,55 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include "AsyncFs.h"
+
+#include <hermes/hermes.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/// A wakeup from any thread to JS on the main thread, without polling.
+/// signal() is lock-free and coalesces: the first signal since the last
+/// delivery posts one call to the main thread, which wakes it from an idle
+/// sleep and, in on-demand mode, schedules a frame; those that follow only
+/// add to the count. The JS listener (jslib's onNotify()) then runs once for
+/// the whole batch, in the next frame's macrotask phase, with the number of
+/// signals. Without signals nothing runs at all.
+class Notifier {
+public:
+  explicit Notifier(std::string name) : name_(std::move(name)) {}
+
+  Notifier(const Notifier &) = delete;
+  Notifier &operator=(const Notifier &) = delete;
+
+  const std::string &name() const { return name_; }
+
+  /// Signal the notifier `count` times. Safe to call from any thread.
+  void signal(uint32_t count = 1);
+
+  /// Main thread: the signals since the last call.
+  uint32_t take() { return pending_.exchange(0, std::memory_order_acq_rel); }
+
+private:
+  std::string name_;
+  std::atomic<uint32_t> pending_{0};
+};
+
+/// Install the __notify(name, count) host function behind jslib's notify(),
+/// which signals the notifier `name`. Workers' runtimes get it too.
+void install_notify(facebook::jsi::Runtime &rt);
+
+/// Install __notify() and the __onNotify(name, callback) host function
+/// behind jslib's onNotify() on the main runtime: `callback(count)` is
+/// called with each batch of signals, or no longer if it is undefined.
+/// Signals are delivered through `postToMain`; those that arrived before
+/// are delivered now.
+void install_notifiers(facebook::jsi::Runtime &rt,
+                       MainThreadPoster postToMain);
+
+/// Forget the callbacks. Must be called before the runtime is destroyed.
+void shutdown_notifiers();
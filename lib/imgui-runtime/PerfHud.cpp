@@ -0,0 +1,295 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "PerfHud.h"
+
+#include "sokol_debugtext.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+struct HudVertex {
+  float x, y;
+  uint32_t color;
+};
+
+/// Width and height of the graph in framebuffer pixels.
+constexpr float kColumnWidth = 2.0f;
+constexpr float kGraphHeight = 120.0f;
+
+/// One quad per phase, one for the rest of the frame, a GC mark and a GPU
+/// tick in every column, plus the background and the budget line.
+constexpr int kMaxVertices = PerfHud::kHistory * (HudPhaseCount + 3) * 6 + 12;
+HudVertex s_vertices[kMaxVertices];
+
+struct PhaseStyle {
+  const char *label;
+  uint8_t r, g, b;
+};
+
+const PhaseStyle kPhaseStyles[HudPhaseCount] = {
+    {"Tasks ", 255, 160, 0},  {"rAF   ", 180, 100, 255},
+    {"React ", 0, 200, 255},  {"Tree  ", 80, 220, 80},
+    {"ImGui ", 255, 220, 0},  {"Commit", 255, 80, 80},
+};
+const PhaseStyle kOtherStyle = {"Frame ", 160, 160, 160};
+const PhaseStyle kGcStyle = {"GC    ", 255, 0, 160};
+const PhaseStyle kGpuStyle = {"GPU   ", 0, 255, 160};
+
+/// Height of the GC marks above the graph.
+constexpr float kGcMarkHeight = 4.0f;
+
+uint32_t pack_color(const PhaseStyle &style, uint8_t a = 255) {
+  return (uint32_t)style.r | ((uint32_t)style.g << 8) |
+         ((uint32_t)style.b << 16) | ((uint32_t)a << 24);
+}
+
+#if defined(SOKOL_GLCORE33)
+const char *kVertexSource = R"(#version 330
+uniform vec4 vs_params[1];
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec4 color0;
+out vec4 color;
+void main() {
+  gl_Position = vec4((position / vs_params[0].xy - 0.5) * vec2(2.0, -2.0),
+                     0.5, 1.0);
+  color = color0;
+}
+)";
+const char *kFragmentSource = R"(#version 330
+in vec4 color;
+layout(location = 0) out vec4 frag_color;
+void main() { frag_color = color; }
+)";
+#elif defined(SOKOL_METAL)
+const char *kVertexSource = R"(#include <metal_stdlib>
+using namespace metal;
+struct vs_params { float4 disp_size; };
+struct vs_in {
+  float2 position [[attribute(0)]];
+  float4 color0 [[attribute(1)]];
+};
+struct vs_out {
+  float4 pos [[position]];
+  float4 color;
+};
+vertex vs_out main0(vs_in in [[stage_in]],
+                    constant vs_params &params [[buffer(0)]]) {
+  vs_out out;
+  out.pos = float4((in.position / params.disp_size.xy - 0.5) *
+                   float2(2.0, -2.0), 0.5, 1.0);
+  out.color = in.color0;
+  return out;
+}
+)";
+const char *kFragmentSource = R"(#include <metal_stdlib>
+using namespace metal;
+struct vs_out {
+  float4 pos [[position]];
+  float4 color;
+};
+fragment float4 main0(vs_out in [[stage_in]]) { return in.color; }
+)";
+#else
+const char *kVertexSource = nullptr;
+const char *kFragmentSource = nullptr;
+#endif
+
+/// Appends quads to s_vertices.
+struct QuadWriter {
+  int count = 0;
+
+  void quad(float x0, float y0, float x1, float y1, uint32_t color) {
+    if (count + 6 > kMaxVertices)
+      return;
+    HudVertex *v = s_vertices + count;
+    v[0] = {x0, y0, color};
+    v[1] = {x1, y0, color};
+    v[2] = {x1, y1, color};
+    v[3] = {x0, y0, color};
+    v[4] = {x1, y1, color};
+    v[5] = {x0, y1, color};
+    count += 6;
+  }
+};
+
+} // namespace
+
+void PerfHud::setup() {
+  if (!kVertexSource)
+    return;
+
+  sg_shader_desc shd_desc = {};
+  shd_desc.attrs[0].name = "position";
+  shd_desc.attrs[1].name = "color0";
+  shd_desc.vs.source = kVertexSource;
+  shd_desc.fs.source = kFragmentSource;
+#if defined(SOKOL_METAL)
+  shd_desc.vs.entry = "main0";
+  shd_desc.fs.entry = "main0";
+#endif
+  sg_shader_uniform_block_desc *ub = &shd_desc.vs.uniform_blocks[0];
+  ub->size = 4 * sizeof(float);
+  ub->uniforms[0].name = "vs_params";
+  ub->uniforms[0].type = SG_UNIFORMTYPE_FLOAT4;
+  shd_desc.label = "perf-hud-shader";
+  shader_ = sg_make_shader(&shd_desc);
+
+  sg_pipeline_desc pip_desc = {};
+  pip_desc.layout.buffers[0].stride = sizeof(HudVertex);
+  pip_desc.layout.attrs[0].offset = offsetof(HudVertex, x);
+  pip_desc.layout.attrs[0].format = SG_VERTEXFORMAT_FLOAT2;
+  pip_desc.layout.attrs[1].offset = offsetof(HudVertex, color);
+  pip_desc.layout.attrs[1].format = SG_VERTEXFORMAT_UBYTE4N;
+  pip_desc.shader = shader_;
+  pip_desc.colors[0].blend.enabled = true;
+  pip_desc.colors[0].blend.src_factor_rgb = SG_BLENDFACTOR_SRC_ALPHA;
+  pip_desc.colors[0].blend.dst_factor_rgb = SG_BLENDFACTOR_ONE_MINUS_SRC_ALPHA;
+  pip_desc.label = "perf-hud-pipeline";
+  pipeline_ = sg_make_pipeline(&pip_desc);
+
+  sg_buffer_desc buf_desc = {};
+  buf_desc.size = sizeof(s_vertices);
+  buf_desc.usage = SG_USAGE_STREAM;
+  buf_desc.label = "perf-hud-vertices";
+  vertices_ = sg_make_buffer(&buf_desc);
+}
+
+void PerfHud::shutdown() {
+  if (!pipeline_.id)
+    return;
+  sg_destroy_buffer(vertices_);
+  sg_destroy_pipeline(pipeline_);
+  sg_destroy_shader(shader_);
+  vertices_ = {};
+  pipeline_ = {};
+  shader_ = {};
+}
+
+void PerfHud::record(const HudFrame &frame) {
+  frames_[next_] = frame;
+  next_ = (next_ + 1) % kHistory;
+  count_ = std::min(count_ + 1, kHistory);
+}
+
+void PerfHud::drawGraph(int fbWidth, int fbHeight, float bottomY,
+                        double budgetMs) {
+  if (!pipeline_.id || count_ == 0)
+    return;
+  if (budgetMs <= 0)
+    budgetMs = 1000.0 / 60.0;
+  // The budget line sits at half the height, so frames up to twice the
+  // budget fit.
+  const float scale = kGraphHeight / (float)(2.0 * budgetMs);
+  const float top = bottomY - kGraphHeight;
+
+  QuadWriter w;
+  w.quad(0.0f, top, kHistory * kColumnWidth, bottomY, 0xA0000000u);
+
+  // Oldest frame on the left, so the newest one is always next to the
+  // column that was drawn last.
+  int first = (next_ - count_ + kHistory) % kHistory;
+  int column = kHistory - count_;
+  for (int i = 0; i < count_; ++i, ++column) {
+    const HudFrame &frame = frames_[(first + i) % kHistory];
+    float x0 = column * kColumnWidth;
+    float x1 = x0 + kColumnWidth;
+    float y = bottomY;
+    double phasesMs = 0;
+    for (int p = 0; p < HudPhaseCount && y > top; ++p) {
+      phasesMs += frame.phaseMs[p];
+      float h = (float)frame.phaseMs[p] * scale;
+      if (h <= 0)
+        continue;
+      float y0 = std::max(top, y - h);
+      w.quad(x0, y0, x1, y, pack_color(kPhaseStyles[p]));
+      y = y0;
+    }
+    float rest = (float)(frame.totalMs - phasesMs) * scale;
+    if (rest > 0 && y > top)
+      w.quad(x0, std::max(top, y - rest), x1, y, pack_color(kOtherStyle));
+    if (frame.gcCount > 0)
+      w.quad(x0, top - kGcMarkHeight, x1, top, pack_color(kGcStyle));
+    float gpuY = bottomY - (float)frame.gpu.gpuMs * scale;
+    if (frame.gpu.gpuMs >= 0 && gpuY > top)
+      w.quad(x0, gpuY - 1.0f, x1, gpuY + 1.0f, pack_color(kGpuStyle));
+  }
+
+  float budgetY = bottomY - (float)budgetMs * scale;
+  w.quad(0.0f, budgetY - 1.0f, kHistory * kColumnWidth, budgetY, 0xC0FFFFFFu);
+
+  sg_range data = {s_vertices, (size_t)w.count * sizeof(HudVertex)};
+  sg_update_buffer(vertices_, &data);
+
+  float params[4] = {(float)fbWidth, (float)fbHeight, 0.0f, 0.0f};
+  sg_apply_viewport(0, 0, fbWidth, fbHeight, true);
+  sg_apply_scissor_rect(0, 0, fbWidth, fbHeight, true);
+  sg_apply_pipeline(pipeline_);
+  sg_apply_uniforms(SG_SHADERSTAGE_VS, 0, SG_RANGE_REF(params));
+  sg_bindings bind = {};
+  bind.vertex_buffers[0] = vertices_;
+  sg_apply_bindings(&bind);
+  sg_draw(0, w.count, 1);
+}
+
+void PerfHud::printLegend() const {
+  double avg[HudPhaseCount + 1] = {};
+  double max[HudPhaseCount + 1] = {};
+  double gcAvg = 0, gcMax = 0;
+  int gcFrames = 0;
+  double gpuAvg = 0, gpuMax = 0;
+  int gpuFrames = 0;
+  for (int i = 0; i < count_; ++i) {
+    const HudFrame &frame = frames_[i];
+    for (int p = 0; p < HudPhaseCount; ++p) {
+      avg[p] += frame.phaseMs[p];
+      max[p] = std::max(max[p], frame.phaseMs[p]);
+    }
+    avg[HudPhaseCount] += frame.totalMs;
+    max[HudPhaseCount] = std::max(max[HudPhaseCount], frame.totalMs);
+    gcAvg += frame.gcMs;
+    gcMax = std::max(gcMax, frame.gcMs);
+    gcFrames += frame.gcCount > 0;
+    if (frame.gpu.gpuMs >= 0) {
+      gpuAvg += frame.gpu.gpuMs;
+      gpuMax = std::max(gpuMax, frame.gpu.gpuMs);
+      ++gpuFrames;
+    }
+  }
+  for (int p = 0; p <= HudPhaseCount; ++p) {
+    const PhaseStyle &style =
+        p < HudPhaseCount ? kPhaseStyles[p] : kOtherStyle;
+    double a = count_ ? avg[p] / count_ : 0;
+    sdtx_color3b(style.r, style.g, style.b);
+    sdtx_printf("%s %6dus avg %6dus max\n", style.label,
+                (int)(a * 1000.0 + 0.5), (int)(max[p] * 1000.0 + 0.5));
+  }
+  sdtx_color3b(kGcStyle.r, kGcStyle.g, kGcStyle.b);
+  sdtx_printf("%s %6dus avg %6dus max %3d frames\n", kGcStyle.label,
+              (int)((count_ ? gcAvg / count_ : 0) * 1000.0 + 0.5),
+              (int)(gcMax * 1000.0 + 0.5), gcFrames);
+
+  sdtx_color3b(kGpuStyle.r, kGpuStyle.g, kGpuStyle.b);
+  if (gpuFrames) {
+    // Comparing with the CPU side of the frame tells which one limits it.
+    gpuAvg /= gpuFrames;
+    double frameAvg = avg[HudPhaseCount] / count_;
+    sdtx_printf("%s %6dus avg %6dus max %s-bound\n", kGpuStyle.label,
+                (int)(gpuAvg * 1000.0 + 0.5), (int)(gpuMax * 1000.0 + 0.5),
+                gpuAvg > frameAvg ? "GPU" : "CPU");
+  } else {
+    sdtx_printf("%s    n/a\n", kGpuStyle.label);
+  }
+  const GpuFrameStats &last =
+      frames_[(next_ - 1 + kHistory) % kHistory].gpu;
+  sdtx_printf("Draw   %d calls %d vtx %d tex %d up %dKB\n", last.drawCalls,
+              last.vertices, last.textureBinds, last.uploads,
+              (int)(last.uploadBytes / 1024.0 + 0.5));
+  // Back to sokol_debugtext's default color.
+  sdtx_color3b(255, 255, 0);
+}
@@ -0,0 +1,84 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include "GpuStats.h"
+
+#include "sokol_gfx.h"
+
+/// Phases of a frame whose durations the HUD tracks.
+enum HudPhase {
+  /// Worker results, ready fds, timers and React's scheduler, without the
+  /// React commits among them.
+  HudMacrotasks,
+  /// requestAnimationFrame() callbacks.
+  HudRaf,
+  /// React commits, wherever they ran.
+  HudReactCommit,
+  /// renderTree() in the imgui unit.
+  HudRenderTree,
+  /// simgui_render() (or capturing and drawing a snapshot).
+  HudImGuiRender,
+  /// sg_commit().
+  HudCommit,
+  HudPhaseCount
+};
+
+/// Phase timings of one frame, in ms.
+struct HudFrame {
+  double phaseMs[HudPhaseCount] = {};
+  /// Whole frame, including the work outside of the phases.
+  double totalMs = 0;
+  /// Hermes collections during the frame and the time they paused JS. The
+  /// pauses are part of the phases they happened in.
+  int gcCount = 0;
+  double gcMs = 0;
+  /// GPU work submitted for the frame, counted on the thread that draws.
+  GpuFrameStats gpu{};
+};
+
+/// Performance HUD: a ring buffer of per-frame phase timings, drawn as a
+/// stacked frame-time graph with a budget line, plus per-phase average and
+/// maximum over the buffered frames. Everything is drawn natively with
+/// sokol_gfx and sokol_debugtext, so showing it doesn't change the JS work
+/// being measured.
+class PerfHud {
+public:
+  /// Frames kept in the ring buffer, one graph column each.
+  static constexpr int kHistory = 240;
+
+  /// Create the graph pipeline. The graph is only drawn on backends that
+  /// have a shader for it (GL core and Metal); the text works everywhere.
+  void setup();
+  void shutdown();
+
+  void record(const HudFrame &frame);
+
+  /// Number of text lines printed by printLegend().
+  static constexpr int kLegendLines = HudPhaseCount + 4;
+
+  /// Draw the graph in the current pass, its bottom edge at `bottomY` in
+  /// framebuffer pixels. `budgetMs` is drawn as a line at half the height.
+  /// Frames with a collection get a mark above their column, and the GPU
+  /// time of a frame, where known, is a tick in its column.
+  void drawGraph(int fbWidth, int fbHeight, float bottomY, double budgetMs);
+  /// Print one line per phase and one for the whole frame with the average
+  /// and maximum over the buffered frames, then the GC pauses and the number
+  /// of frames that had any, the GPU time and the last frame's draw
+  /// statistics, through sokol_debugtext.
+  void printLegend() const;
+
+  bool visible = true;
+
+private:
+  HudFrame frames_[kHistory];
+  /// Index of the next frame to write.
+  int next_ = 0;
+  int count_ = 0;
+
+  sg_shader shader_{};
+  sg_pipeline pipeline_{};
+  sg_buffer vertices_{};
+};
@@ -0,0 +1,953 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "RecordDecoder.h"
+
+#include "MappedFileBuffer.h"
+#include "SharedBuffer.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <unordered_map>
+
+namespace {
+
+/// Bytes of a mapped file decoded at a time, so that other input and the
+/// deliveries get the decoder between slices.
+constexpr size_t kFileSlice = 1 << 20;
+/// Nesting of msgpack maps and arrays skipped inside a record.
+constexpr int kMaxMsgpackDepth = 32;
+
+/// Input queued by JS, decoded in order by one pool job at a time.
+struct FeedInput {
+  std::vector<uint8_t> bytes;
+  /// A file to decode instead, with the callback to call once it is.
+  std::string path;
+  unsigned request = 0;
+};
+
+struct FeedQueue {
+  std::mutex mutex;
+  std::deque<FeedInput> inputs;
+  bool draining = false;
+};
+
+struct DecoderEntry {
+  std::shared_ptr<RecordDecoder> decoder;
+  std::shared_ptr<FeedQueue> feeds;
+};
+
+ThreadPool *s_pool = nullptr;
+std::atomic<MainThreadPoster> s_post_to_main{nullptr};
+facebook::jsi::Runtime *s_runtime = nullptr;
+
+/// Open decoders by ID. Any thread.
+std::mutex s_decoders_mutex;
+std::unordered_map<unsigned, DecoderEntry> s_decoders;
+
+/// Main thread only.
+unsigned s_next_decoder = 1;
+std::unordered_map<unsigned, facebook::jsi::Function> s_row_callbacks{};
+std::unordered_map<unsigned, facebook::jsi::Function> s_file_callbacks{};
+unsigned s_next_request = 1;
+
+void deliver(unsigned id);
+
+void post_delivery(unsigned id) {
+  if (MainThreadPoster post = s_post_to_main.load(std::memory_order_acquire))
+    post([id] { deliver(id); });
+}
+
+ColumnType column_type(FieldType type) {
+  switch (type) {
+  case FieldType::U8:
+  case FieldType::I8:
+  case FieldType::U16:
+  case FieldType::I16:
+  case FieldType::I32:
+    return ColumnType::I32;
+  case FieldType::String:
+  case FieldType::String8:
+  case FieldType::String16:
+    return ColumnType::String;
+  case FieldType::Skip:
+    return ColumnType::Skip;
+  default:
+    return ColumnType::F64;
+  }
+}
+
+/// Bytes of a binary field before its value; 0 for fixed strings and skips,
+/// whose `size` is used.
+size_t field_width(FieldType type) {
+  switch (type) {
+  case FieldType::U8:
+  case FieldType::I8:
+  case FieldType::String8:
+    return 1;
+  case FieldType::U16:
+  case FieldType::I16:
+  case FieldType::String16:
+    return 2;
+  case FieldType::U32:
+  case FieldType::I32:
+  case FieldType::F32:
+    return 4;
+  case FieldType::U64:
+  case FieldType::I64:
+  case FieldType::F64:
+    return 8;
+  default:
+    return 0;
+  }
+}
+
+uint64_t read_uint(const uint8_t *p, size_t width, bool littleEndian) {
+  uint64_t v = 0;
+  for (size_t i = 0; i < width; ++i)
+    v |= (uint64_t)p[littleEndian ? i : width - 1 - i] << (i * 8);
+  return v;
+}
+
+int32_t to_i32(double v) {
+  if (!(v == v))
+    return 0;
+  return (int32_t)std::clamp(v, -2147483648.0, 2147483647.0);
+}
+
+/// A msgpack value: a number (booleans included), a string in the input, or
+/// something a column can't hold (nil, binary, extensions, containers).
+struct MpValue {
+  enum { Other, Number, String } kind = Other;
+  double number = 0;
+  const uint8_t *text = nullptr;
+  size_t size = 0;
+};
+
+/// Read the msgpack value at `p` (always big-endian), skipping containers.
+/// Returns 1, 0 if it is truncated, -1 if it is invalid.
+int mp_value(const uint8_t *&p, const uint8_t *end, MpValue &v, int depth) {
+  if (p >= end)
+    return 0;
+  uint8_t b = *p++;
+  auto need = [&](size_t n) { return (size_t)(end - p) >= n; };
+  auto uint = [&](size_t n) {
+    uint64_t x = read_uint(p, n, false);
+    p += n;
+    return x;
+  };
+  v.kind = MpValue::Other;
+  size_t skip = 0;
+  size_t elements = 0;
+  if (b <= 0x7f) {
+    v.kind = MpValue::Number;
+    v.number = b;
+    return 1;
+  }
+  if (b >= 0xe0) {
+    v.kind = MpValue::Number;
+    v.number = (int8_t)b;
+    return 1;
+  }
+  if (b >= 0xa0 && b <= 0xbf) {
+    size_t n = b & 0x1f;
+    if (!need(n))
+      return 0;
+    v.kind = MpValue::String;
+    v.text = p;
+    v.size = n;
+    p += n;
+    return 1;
+  }
+  if (b <= 0x8f) {
+    elements = (size_t)(b & 0x0f) * 2;
+  } else if (b <= 0x9f) {
+    elements = b & 0x0f;
+  } else {
+    switch (b) {
+    case 0xc0:
+      return 1;
+    case 0xc2:
+    case 0xc3:
+      v.kind = MpValue::Number;
+      v.number = b == 0xc3;
+      return 1;
+    case 0xc4:
+    case 0xc5:
+    case 0xc6: {
+      size_t n = (size_t)1 << (b - 0xc4);
+      if (!need(n))
+        return 0;
+      uint64_t len = uint(n);
+      if (len > RecordDecoder::kMaxRecordBytes)
+        return -1;
+      skip = (size_t)len;
+      break;
+    }
+    case 0xc7:
+    case 0xc8:
+    case 0xc9: {
+      size_t n = (size_t)1 << (b - 0xc7);
+      if (!need(n))
+        return 0;
+      uint64_t len = uint(n);
+      if (len > RecordDecoder::kMaxRecordBytes)
+        return -1;
+      skip = (size_t)len + 1;
+      break;
+    }
+    case 0xca:
+    case 0xcb: {
+      size_t n = b == 0xca ? 4 : 8;
+      if (!need(n))
+        return 0;
+      uint64_t bits = uint(n);
+      v.kind = MpValue::Number;
+      if (n == 4) {
+        uint32_t u = (uint32_t)bits;
+        float f;
+        memcpy(&f, &u, 4);
+        v.number = f;
+      } else {
+        memcpy(&v.number, &bits, 8);
+      }
+      return 1;
+    }
+    case 0xcc:
+    case 0xcd:
+    case 0xce:
+    case 0xcf:
+    case 0xd0:
+    case 0xd1:
+    case 0xd2:
+    case 0xd3: {
+      bool isSigned = b >= 0xd0;
+      size_t n = (size_t)1 << ((b - (isSigned ? 0xd0 : 0xcc)));
+      if (!need(n))
+        return 0;
+      uint64_t x = uint(n);
+      v.kind = MpValue::Number;
+      if (isSigned) {
+        // Sign-extend from n bytes
+        int shift = 64 - (int)n * 8;
+        v.number = (double)((int64_t)(x << shift) >> shift);
+      } else {
+        v.number = (double)x;
+      }
+      return 1;
+    }
+    case 0xd4:
+    case 0xd5:
+    case 0xd6:
+    case 0xd7:
+    case 0xd8:
+      skip = ((size_t)1 << (b - 0xd4)) + 1;
+      break;
+    case 0xd9:
+    case 0xda:
+    case 0xdb: {
+      size_t n = (size_t)1 << (b - 0xd9);
+      if (!need(n))
+        return 0;
+      uint64_t len = uint(n);
+      if (len > RecordDecoder::kMaxRecordBytes)
+        return -1;
+      if (!need((size_t)len))
+        return 0;
+      v.kind = MpValue::String;
+      v.text = p;
+      v.size = len;
+      p += len;
+      return 1;
+    }
+    case 0xdc:
+    case 0xdd:
+    case 0xde:
+    case 0xdf: {
+      size_t n = b == 0xdc || b == 0xde ? 2 : 4;
+      if (!need(n))
+        return 0;
+      elements = (size_t)uint(n) * (b >= 0xde ? 2 : 1);
+      // Every element takes at least a byte
+      if (elements > RecordDecoder::kMaxRecordBytes)
+        return -1;
+      break;
+    }
+    default:
+      // 0xc1 is never used
+      return -1;
+    }
+  }
+  if (skip) {
+    if (!need(skip))
+      return 0;
+    p += skip;
+    return 1;
+  }
+  if (elements && depth >= kMaxMsgpackDepth)
+    return -1;
+  for (size_t i = 0; i < elements; ++i) {
+    MpValue ignored;
+    int r = mp_value(p, end, ignored, depth + 1);
+    if (r <= 0)
+      return r;
+  }
+  v.kind = MpValue::Other;
+  return 1;
+}
+
+template <typename T>
+facebook::jsi::ArrayBuffer to_array_buffer(facebook::jsi::Runtime &rt,
+                                           std::vector<T> &items) {
+  auto buffer = std::make_shared<VectorBuffer<T>>(std::move(items));
+  // Workers can be handed the columns without a copy
+  register_transferable_buffer(buffer, false);
+  return facebook::jsi::ArrayBuffer(rt, std::move(buffer));
+}
+
+/// Main thread: pass the rows decoded since the last delivery to JS.
+void deliver(unsigned id) {
+  std::shared_ptr<RecordDecoder> decoder = find_record_decoder(id);
+  auto it = s_row_callbacks.find(id);
+  if (!decoder || it == s_row_callbacks.end() || !s_runtime)
+    return;
+  facebook::jsi::Runtime &rt = *s_runtime;
+  std::vector<ParsedColumn> columns;
+  uint64_t errors = 0;
+  size_t rows = decoder->take(columns, errors);
+  std::vector<facebook::jsi::Value> buffers;
+  for (ParsedColumn &col : columns) {
+    switch (col.type) {
+    case ColumnType::F64:
+      buffers.emplace_back(to_array_buffer(rt, col.f64));
+      break;
+    case ColumnType::I32:
+      buffers.emplace_back(to_array_buffer(rt, col.i32));
+      break;
+    case ColumnType::String:
+      buffers.emplace_back(to_array_buffer(rt, col.offsets));
+      buffers.emplace_back(to_array_buffer(rt, col.bytes));
+      break;
+    case ColumnType::Skip:
+      break;
+    }
+  }
+  facebook::jsi::Array buffersArray(rt, buffers.size());
+  for (size_t i = 0; i < buffers.size(); ++i)
+    buffersArray.setValueAtIndex(rt, i, std::move(buffers[i]));
+  // The callback may close the decoder, which erases it
+  facebook::jsi::Function &callback = it->second;
+  facebook::jsi::Value fn(rt, callback);
+  fn.getObject(rt).getFunction(rt).call(rt, (double)rows, buffersArray,
+                                        (double)errors);
+}
+
+void complete_file(unsigned request, std::string error, size_t records) {
+  auto it = s_file_callbacks.find(request);
+  if (it == s_file_callbacks.end() || !s_runtime)
+    return;
+  facebook::jsi::Function callback = std::move(it->second);
+  s_file_callbacks.erase(it);
+  facebook::jsi::Runtime &rt = *s_runtime;
+  if (!error.empty())
+    callback.call(rt, facebook::jsi::String::createFromUtf8(rt, error));
+  else
+    callback.call(rt, facebook::jsi::Value::null(), (double)records);
+}
+
+/// Pool job: decode the queued input of a decoder until there is none.
+void drain(std::shared_ptr<RecordDecoder> decoder,
+           std::shared_ptr<FeedQueue> feeds) {
+  for (;;) {
+    FeedInput input;
+    {
+      std::lock_guard<std::mutex> lock(feeds->mutex);
+      if (feeds->inputs.empty()) {
+        feeds->draining = false;
+        return;
+      }
+      input = std::move(feeds->inputs.front());
+      feeds->inputs.pop_front();
+    }
+    if (input.path.empty()) {
+      decoder->feed(input.bytes.data(), input.bytes.size());
+      continue;
+    }
+    std::string error;
+    size_t records = 0;
+    try {
+      MapFileOptions mapOptions;
+      mapOptions.sequential = true;
+      std::shared_ptr<facebook::jsi::Buffer> file =
+          mapFileBuffer(input.path.c_str(), false, &mapOptions);
+      for (size_t offset = 0; offset < file->size(); offset += kFileSlice)
+        records += decoder->feed(file->data() + offset,
+                                 std::min(kFileSlice, file->size() - offset));
+    } catch (const std::exception &) {
+      error = "can't open file '" + input.path + "'";
+    }
+    if (MainThreadPoster post = s_post_to_main.load(std::memory_order_acquire))
+      post([request = input.request, error, records] {
+        complete_file(request, error, records);
+      });
+  }
+}
+
+void queue_input(unsigned id, FeedInput input) {
+  DecoderEntry entry;
+  {
+    std::lock_guard<std::mutex> lock(s_decoders_mutex);
+    auto it = s_decoders.find(id);
+    if (it == s_decoders.end())
+      return;
+    entry = it->second;
+  }
+  bool start;
+  {
+    std::lock_guard<std::mutex> lock(entry.feeds->mutex);
+    entry.feeds->inputs.push_back(std::move(input));
+    start = !entry.feeds->draining;
+    entry.feeds->draining = true;
+  }
+  if (start)
+    s_pool->post([entry] { drain(entry.decoder, entry.feeds); },
+                 {TaskPriority::Normal, TraceTaskDecode});
+}
+
+FieldType parse_field_type(const std::string &name) {
+  static const std::pair<const char *, FieldType> kTypes[] = {
+      {"u8", FieldType::U8},         {"i8", FieldType::I8},
+      {"u16", FieldType::U16},       {"i16", FieldType::I16},
+      {"u32", FieldType::U32},       {"i32", FieldType::I32},
+      {"u64", FieldType::U64},       {"i64", FieldType::I64},
+      {"f32", FieldType::F32},       {"f64", FieldType::F64},
+      {"string", FieldType::String}, {"string8", FieldType::String8},
+      {"string16", FieldType::String16}, {"skip", FieldType::Skip},
+  };
+  for (const auto &type : kTypes)
+    if (name == type.first)
+      return type.second;
+  throw std::invalid_argument("unknown field type '" + name + "'");
+}
+
+} // namespace
+
+RecordDecoder::RecordDecoder(unsigned id, RecordFraming framing,
+                             bool littleEndian, size_t recordSize,
+                             std::vector<RecordField> fields)
+    : id_(id), framing_(framing), littleEndian_(littleEndian),
+      recordSize_(recordSize), fields_(std::move(fields)) {
+  int next = 0;
+  for (const RecordField &field : fields_)
+    columnOf_.push_back(column_type(field.type) == ColumnType::Skip ? -1
+                                                                    : next++);
+  rowNumbers_.resize(fields_.size());
+  rowText_.resize(fields_.size());
+  resumeText_.resize(fields_.size());
+  reset_columns();
+}
+
+void RecordDecoder::reset_columns() {
+  columns_.clear();
+  for (size_t i = 0; i < fields_.size(); ++i) {
+    if (columnOf_[i] < 0)
+      continue;
+    ParsedColumn col;
+    col.name = fields_[i].name;
+    col.type = column_type(fields_[i].type);
+    if (col.type == ColumnType::String)
+      col.offsets.push_back(0);
+    columns_.push_back(std::move(col));
+  }
+  rows_ = 0;
+}
+
+void RecordDecoder::append_row() {
+  for (size_t i = 0; i < fields_.size(); ++i) {
+    if (columnOf_[i] < 0)
+      continue;
+    ParsedColumn &col = columns_[(size_t)columnOf_[i]];
+    switch (col.type) {
+    case ColumnType::F64:
+      col.f64.push_back(rowNumbers_[i]);
+      break;
+    case ColumnType::I32:
+      col.i32.push_back(to_i32(rowNumbers_[i]));
+      break;
+    case ColumnType::String:
+      col.bytes.insert(col.bytes.end(), rowText_[i].first,
+                       rowText_[i].first + rowText_[i].second);
+      col.offsets.push_back((uint32_t)col.bytes.size());
+      break;
+    case ColumnType::Skip:
+      break;
+    }
+  }
+  ++rows_;
+}
+
+bool RecordDecoder::decode_binary(const uint8_t *p, size_t size) {
+  size_t pos = 0;
+  for (size_t i = 0; i < fields_.size(); ++i) {
+    const RecordField &field = fields_[i];
+    size_t width = field_width(field.type);
+    if (field.type == FieldType::String || field.type == FieldType::Skip) {
+      if (size - pos < field.size)
+        return false;
+      const uint8_t *start = p + pos;
+      rowText_[i] = {start, (size_t)(std::find(start, start + field.size, 0) -
+                                     start)};
+      pos += field.size;
+      continue;
+    }
+    if (size - pos < width)
+      return false;
+    uint64_t bits = read_uint(p + pos, width, littleEndian_);
+    pos += width;
+    double &v = rowNumbers_[i];
+    switch (field.type) {
+    case FieldType::I8:
+      v = (int8_t)bits;
+      break;
+    case FieldType::I16:
+      v = (int16_t)bits;
+      break;
+    case FieldType::I32:
+      v = (int32_t)bits;
+      break;
+    case FieldType::I64:
+      v = (double)(int64_t)bits;
+      break;
+    case FieldType::F32: {
+      uint32_t u = (uint32_t)bits;
+      float f;
+      memcpy(&f, &u, 4);
+      v = f;
+      break;
+    }
+    case FieldType::F64:
+      memcpy(&v, &bits, 8);
+      break;
+    case FieldType::String8:
+    case FieldType::String16:
+      if (size - pos < bits)
+        return false;
+      rowText_[i] = {p + pos, (size_t)bits};
+      pos += (size_t)bits;
+      break;
+    default:
+      v = (double)bits;
+      break;
+    }
+  }
+  return true;
+}
+
+int RecordDecoder::decode_msgpack(const uint8_t *p, size_t size,
+                                  size_t &used, bool resume) {
+  const uint8_t *q = p;
+  const uint8_t *end = p + size;
+  uint8_t b = *q;
+  size_t count;
+  bool isMap;
+  if ((b & 0xf0) == 0x80 || (b & 0xf0) == 0x90) {
+    isMap = (b & 0xf0) == 0x80;
+    count = b & 0x0f;
+    ++q;
+  } else if (b >= 0xdc && b <= 0xdf) {
+    size_t n = b == 0xdc || b == 0xde ? 2 : 4;
+    if (size < 1 + n)
+      return 0;
+    isMap = b >= 0xde;
+    count = (size_t)read_uint(q + 1, n, false);
+    q += 1 + n;
+    if (count > kMaxRecordBytes) {
+      used = size;
+      return -1;
+    }
+  } else {
+    // Not a record: skip the value
+    MpValue ignored;
+    int r = mp_value(q, end, ignored, 0);
+    if (r == 0)
+      return 0;
+    used = r < 0 ? size : (size_t)(q - p);
+    return -1;
+  }
+
+  size_t first = 0;
+  if (resume && resumeOffset_) {
+    // The fields before resumeField_ are in the row already
+    first = resumeField_;
+    q = p + resumeOffset_;
+    for (size_t i = 0; i < fields_.size(); ++i) {
+      if (resumeText_[i] != kNoText)
+        rowText_[i].first = p + resumeText_[i];
+    }
+  } else {
+    for (size_t i = 0; i < fields_.size(); ++i) {
+      rowNumbers_[i] = NAN;
+      rowText_[i] = {nullptr, 0};
+    }
+  }
+  resumeOffset_ = 0;
+  for (size_t k = first; k < count; ++k) {
+    const uint8_t *fieldStart = q;
+    // Remember where to pick the record up once more of it arrives. The
+    // strings read so far are kept as offsets, as the input moves.
+    auto suspend = [&] {
+      resumeField_ = k;
+      resumeOffset_ = (size_t)(fieldStart - p);
+      for (size_t i = 0; i < fields_.size(); ++i)
+        resumeText_[i] =
+            rowText_[i].first ? (size_t)(rowText_[i].first - p) : kNoText;
+    };
+    size_t field = fields_.size();
+    if (isMap) {
+      MpValue key;
+      int r = mp_value(q, end, key, 1);
+      if (r == 0)
+        suspend();
+      if (r <= 0) {
+        used = size;
+        return r;
+      }
+      if (key.kind == MpValue::String) {
+        for (size_t i = 0; i < fields_.size(); ++i) {
+          if (fields_[i].name.size() == key.size &&
+              memcmp(fields_[i].name.data(), key.text, key.size) == 0) {
+            field = i;
+            break;
+          }
+        }
+      }
+    } else {
+      field = k;
+    }
+    MpValue value;
+    int r = mp_value(q, end, value, 1);
+    if (r == 0)
+      suspend();
+    if (r <= 0) {
+      used = size;
+      return r;
+    }
+    if (field >= fields_.size())
+      continue;
+    if (value.kind == MpValue::Number)
+      rowNumbers_[field] = value.number;
+    else if (value.kind == MpValue::String)
+      rowText_[field] = {value.text, value.size};
+  }
+  used = (size_t)(q - p);
+  return 1;
+}
+
+size_t RecordDecoder::decode(const uint8_t *data, size_t size, bool stream) {
+  // Append to the carried-over record in place, so that a record arriving
+  // in many chunks is copied once rather than once per chunk
+  bool carried = stream && !carry_.empty();
+  if (carried) {
+    carry_.insert(carry_.end(), data, data + size);
+    data = carry_.data();
+    size = carry_.size();
+  }
+  size_t records = 0;
+  size_t pos = 0;
+  size_t prefix = framing_ == RecordFraming::Prefix8    ? 1
+                  : framing_ == RecordFraming::Prefix16 ? 2
+                  : framing_ == RecordFraming::Prefix32 ? 4
+                                                        : 0;
+  while (pos < size) {
+    const uint8_t *p = data + pos;
+    size_t avail = size - pos;
+    size_t used;
+    bool ok;
+    if (framing_ == RecordFraming::Msgpack) {
+      int r = decode_msgpack(p, avail, used, carried && pos == 0);
+      if (r == 0 && avail > kMaxRecordBytes) {
+        // Lost framing, as for an oversized length prefix
+        ++errors_;
+        resumeOffset_ = 0;
+        carry_.clear();
+        return records;
+      }
+      if (r == 0)
+        break;
+      ok = r > 0;
+    } else if (prefix) {
+      if (avail < prefix)
+        break;
+      uint64_t length = read_uint(p, prefix, littleEndian_);
+      if (length > kMaxRecordBytes) {
+        // Lost framing: nothing after this can be trusted
+        ++errors_;
+        carry_.clear();
+        return records;
+      }
+      if (avail - prefix < length)
+        break;
+      used = prefix + (size_t)length;
+      ok = decode_binary(p + prefix, (size_t)length);
+    } else {
+      if (avail < recordSize_)
+        break;
+      used = recordSize_;
+      ok = decode_binary(p, recordSize_);
+    }
+    if (ok) {
+      append_row();
+      ++records;
+    } else {
+      ++errors_;
+    }
+    pos += used;
+  }
+  if (pos < size) {
+    if (!stream) {
+      ++errors_;
+      // Nothing carries a message's partial record on
+      resumeOffset_ = 0;
+    } else if (carried) {
+      carry_.erase(carry_.begin(), carry_.begin() + pos);
+    } else {
+      carry_.assign(data + pos, data + size);
+    }
+  } else if (carried) {
+    carry_.clear();
+  }
+  return records;
+}
+
+size_t RecordDecoder::decode_input(const uint8_t *data, size_t size,
+                                   bool stream) {
+  bool post = false;
+  size_t records;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (closed_)
+      return 0;
+    uint64_t errors = errors_;
+    records = decode(data, size, stream);
+    if (!posted_ && (records || errors_ != errors)) {
+      posted_ = true;
+      post = true;
+    }
+  }
+  if (post)
+    post_delivery(id_);
+  return records;
+}
+
+size_t RecordDecoder::feed(const uint8_t *data, size_t size) {
+  return decode_input(data, size, true);
+}
+
+size_t RecordDecoder::feed_message(const uint8_t *data, size_t size) {
+  return decode_input(data, size, false);
+}
+
+size_t RecordDecoder::take(std::vector<ParsedColumn> &columns,
+                           uint64_t &errors) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t rows = rows_;
+  columns = std::move(columns_);
+  errors = errors_;
+  errors_ = 0;
+  posted_ = false;
+  reset_columns();
+  return rows;
+}
+
+void RecordDecoder::close() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  closed_ = true;
+  carry_.clear();
+  carry_.shrink_to_fit();
+  resumeOffset_ = 0;
+}
+
+std::shared_ptr<RecordDecoder> find_record_decoder(unsigned id) {
+  std::lock_guard<std::mutex> lock(s_decoders_mutex);
+  auto it = s_decoders.find(id);
+  return it == s_decoders.end() ? nullptr : it->second.decoder;
+}
+
+void install_record_decoders(facebook::jsi::Runtime &rt, ThreadPool &pool,
+                             MainThreadPoster postToMain) {
+  s_pool = &pool;
+  s_runtime = &rt;
+  s_post_to_main.store(postToMain, std::memory_order_release);
+
+  rt.global().setProperty(
+      rt, "__decoderCreate",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__decoderCreate"), 7,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count < 7 || !args[0].isString() || !args[4].isObject() ||
+                !args[6].isObject() || !args[6].getObject(rt).isFunction(rt))
+              throw facebook::jsi::JSError(
+                  rt, "__decoderCreate expects a framing, a byte order, a "
+                      "record size, the fields and a callback");
+            std::string framingName = args[0].getString(rt).utf8(rt);
+            RecordFraming framing;
+            if (framingName == "fixed")
+              framing = RecordFraming::Fixed;
+            else if (framingName == "u8")
+              framing = RecordFraming::Prefix8;
+            else if (framingName == "u16")
+              framing = RecordFraming::Prefix16;
+            else if (framingName == "u32")
+              framing = RecordFraming::Prefix32;
+            else if (framingName == "msgpack")
+              framing = RecordFraming::Msgpack;
+            else
+              throw facebook::jsi::JSError(
+                  rt, "__decoderCreate: unknown framing '" + framingName + "'");
+            bool littleEndian = !args[1].isBool() || args[1].getBool();
+            size_t recordSize =
+                args[2].isNumber() ? (size_t)std::max(0.0, args[2].getNumber())
+                                   : 0;
+
+            facebook::jsi::Array names = args[3].getObject(rt).getArray(rt);
+            facebook::jsi::Array types = args[4].getObject(rt).getArray(rt);
+            facebook::jsi::Array sizes = args[5].getObject(rt).getArray(rt);
+            std::vector<RecordField> fields(names.size(rt));
+            for (size_t i = 0; i < fields.size(); ++i) {
+              fields[i].name =
+                  names.getValueAtIndex(rt, i).getString(rt).utf8(rt);
+              try {
+                fields[i].type = parse_field_type(
+                    types.getValueAtIndex(rt, i).getString(rt).utf8(rt));
+              } catch (const std::invalid_argument &e) {
+                throw facebook::jsi::JSError(
+                    rt, std::string("__decoderCreate: ") + e.what());
+              }
+              facebook::jsi::Value size = sizes.getValueAtIndex(rt, i);
+              fields[i].size =
+                  size.isNumber() ? (size_t)std::max(0.0, size.getNumber()) : 0;
+            }
+            if (framing == RecordFraming::Fixed && recordSize == 0)
+              throw facebook::jsi::JSError(
+                  rt, "__decoderCreate: fixed records need a size");
+
+            unsigned id = s_next_decoder++;
+            DecoderEntry entry;
+            entry.decoder = std::make_shared<RecordDecoder>(
+                id, framing, littleEndian, recordSize, std::move(fields));
+            entry.feeds = std::make_shared<FeedQueue>();
+            {
+              std::lock_guard<std::mutex> lock(s_decoders_mutex);
+              s_decoders.emplace(id, std::move(entry));
+            }
+            s_row_callbacks.emplace(id,
+                                    args[6].getObject(rt).getFunction(rt));
+            return (double)id;
+          }));
+
+  rt.global().setProperty(
+      rt, "__decoderFeed",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__decoderFeed"), 4,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count < 2 || !args[0].isNumber() || !args[1].isObject() ||
+                !args[1].getObject(rt).isArrayBuffer(rt))
+              throw facebook::jsi::JSError(
+                  rt, "__decoderFeed expects a decoder and an ArrayBuffer");
+            facebook::jsi::ArrayBuffer ab =
+                args[1].getObject(rt).getArrayBuffer(rt);
+            size_t size = ab.size(rt);
+            double offset =
+                count > 2 && args[2].isNumber() ? args[2].getNumber() : 0;
+            double length = count > 3 && args[3].isNumber()
+                                ? args[3].getNumber()
+                                : (double)size - offset;
+            if (!(offset >= 0) || !(length >= 0) || offset + length > size)
+              throw facebook::jsi::JSError(rt, "__decoderFeed: bad range");
+            FeedInput input;
+            const uint8_t *start = ab.data(rt) + (size_t)offset;
+            input.bytes.assign(start, start + (size_t)length);
+            queue_input((unsigned)args[0].getNumber(), std::move(input));
+            return facebook::jsi::Value::undefined();
+          }));
+
+  rt.global().setProperty(
+      rt, "__decoderFeedFile",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__decoderFeedFile"), 3,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count < 3 || !args[0].isNumber() || !args[1].isString() ||
+                !args[2].isObject() || !args[2].getObject(rt).isFunction(rt))
+              throw facebook::jsi::JSError(
+                  rt, "__decoderFeedFile expects a decoder, a path and a "
+                      "callback");
+            unsigned id = (unsigned)args[0].getNumber();
+            if (!find_record_decoder(id))
+              throw facebook::jsi::JSError(rt,
+                                           "__decoderFeedFile: closed decoder");
+            FeedInput input;
+            input.path = args[1].getString(rt).utf8(rt);
+            input.request = s_next_request++;
+            s_file_callbacks.emplace(input.request,
+                                     args[2].getObject(rt).getFunction(rt));
+            queue_input(id, std::move(input));
+            return facebook::jsi::Value::undefined();
+          }));
+
+  rt.global().setProperty(
+      rt, "__decoderClose",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__decoderClose"), 1,
+          [](facebook::jsi::Runtime &, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count < 1 || !args[0].isNumber())
+              return facebook::jsi::Value::undefined();
+            unsigned id = (unsigned)args[0].getNumber();
+            std::shared_ptr<RecordDecoder> decoder;
+            {
+              std::lock_guard<std::mutex> lock(s_decoders_mutex);
+              auto it = s_decoders.find(id);
+              if (it == s_decoders.end())
+                return facebook::jsi::Value::undefined();
+              decoder = it->second.decoder;
+              s_decoders.erase(it);
+            }
+            // Sockets and jobs still holding it stop feeding it
+            decoder->close();
+            s_row_callbacks.erase(id);
+            return facebook::jsi::Value::undefined();
+          }));
+}
+
+void shutdown_record_decoders() {
+  s_post_to_main.store(nullptr, std::memory_order_release);
+  {
+    std::lock_guard<std::mutex> lock(s_decoders_mutex);
+    for (auto &entry : s_decoders)
+      entry.second.decoder->close();
+    s_decoders.clear();
+  }
+  s_row_callbacks.clear();
+  s_file_callbacks.clear();
+  s_runtime = nullptr;
+}
+
+extern "C" long imgui_record_decoder_feed(unsigned id, const void *data,
+                                          size_t size) {
+  std::shared_ptr<RecordDecoder> decoder = find_record_decoder(id);
+  if (!decoder)
+    return -1;
+  return (long)decoder->feed(static_cast<const uint8_t *>(data), size);
+}
@@ -0,0 +1,179 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include "AsyncFs.h"
+#include "ColumnarParse.h"
+
+#include <hermes/hermes.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+class ThreadPool;
+
+/// How the records of a decoder's input are delimited.
+enum class RecordFraming {
+  /// Every record is `recordSize` bytes.
+  Fixed,
+  /// Each record follows its length, an unsigned integer of 1, 2 or 4 bytes
+  /// in the decoder's byte order, not counting itself.
+  Prefix8,
+  Prefix16,
+  Prefix32,
+  /// Each record is a msgpack map (fields by name) or array (by position).
+  Msgpack,
+};
+
+/// The encoding of a field in a binary record.
+enum class FieldType {
+  U8,
+  I8,
+  U16,
+  I16,
+  U32,
+  I32,
+  U64,
+  I64,
+  F32,
+  F64,
+  /// `size` bytes of UTF-8, cut at the first NUL.
+  String,
+  /// UTF-8 after its length in a 1 or 2 byte unsigned integer.
+  String8,
+  String16,
+  /// `size` bytes ignored.
+  Skip,
+};
+
+struct RecordField {
+  std::string name;
+  FieldType type = FieldType::F64;
+  /// String and Skip.
+  size_t size = 0;
+};
+
+/// Decodes binary records into typed columns: F64 for 32-bit unsigned,
+/// 64-bit and floating-point fields, I32 for the smaller integers and
+/// String for strings. Binary fields are read one after the other; msgpack
+/// fields take the value of their name or position, a missing one NaN, 0 or
+/// "", and ignore nested maps and arrays.
+///
+/// Input comes from any thread: a stream through feed(), whose records may
+/// span calls, or whole messages through feed_message(). The rows pile up
+/// until take() hands them to the JS thread; the first row or error after a
+/// take() posts the delivery that takes them, so JS gets one batch per
+/// frame however the input arrived. A record that doesn't decode
+/// (too short, invalid msgpack) is skipped and counted; a length prefix,
+/// msgpack length or count over kMaxRecordBytes, or a msgpack record that
+/// is still incomplete past it, drops the rest of the stream's buffered
+/// input.
+class RecordDecoder {
+public:
+  static constexpr size_t kMaxRecordBytes = 16 << 20;
+
+  RecordDecoder(unsigned id, RecordFraming framing, bool littleEndian,
+                size_t recordSize, std::vector<RecordField> fields);
+
+  RecordDecoder(const RecordDecoder &) = delete;
+  RecordDecoder &operator=(const RecordDecoder &) = delete;
+
+  /// Decode the next `size` bytes of the stream. Returns the number of
+  /// records decoded.
+  size_t feed(const uint8_t *data, size_t size);
+
+  /// Decode `size` bytes holding whole records, e.g. a WebSocket message;
+  /// a partial record at the end counts as an error.
+  size_t feed_message(const uint8_t *data, size_t size);
+
+  /// JS thread: move the rows decoded since the last call into `columns`
+  /// (one per named field) and return how many there are. `errors` is the
+  /// number of records skipped meanwhile.
+  size_t take(std::vector<ParsedColumn> &columns, uint64_t &errors);
+
+  /// Stop decoding: later input is ignored.
+  void close();
+
+  const std::vector<RecordField> &fields() const { return fields_; }
+
+private:
+  size_t decode_input(const uint8_t *data, size_t size, bool stream);
+  size_t decode(const uint8_t *data, size_t size, bool stream);
+  /// Read one binary record into the row; false if it is too short.
+  bool decode_binary(const uint8_t *p, size_t size);
+  /// Decode one msgpack record at `p`: 1 with `used` set, 0 if truncated,
+  /// -1 if invalid with `used` set to what to skip (all of it). A truncated
+  /// record saves where it stopped; `resume` continues from there, for the
+  /// same record with more input after it.
+  int decode_msgpack(const uint8_t *p, size_t size, size_t &used,
+                     bool resume);
+  void reset_columns();
+  void append_row();
+
+  const unsigned id_;
+  const RecordFraming framing_;
+  const bool littleEndian_;
+  const size_t recordSize_;
+  const std::vector<RecordField> fields_;
+  /// Index of the column of each field, -1 for Skip.
+  std::vector<int> columnOf_;
+
+  std::mutex mutex_;
+  bool closed_ = false;
+  /// A delivery was posted and hasn't taken the rows yet.
+  bool posted_ = false;
+  /// The start of a record that the stream hasn't finished yet.
+  std::vector<uint8_t> carry_;
+  /// Where decode_msgpack() stopped in the carried record: the field to
+  /// read next and its offset (0 when there is nothing to resume), and the
+  /// offsets of the strings in the row so far, kNoText for none.
+  static constexpr size_t kNoText = ~(size_t)0;
+  size_t resumeField_ = 0;
+  size_t resumeOffset_ = 0;
+  std::vector<size_t> resumeText_;
+  std::vector<ParsedColumn> columns_;
+  size_t rows_ = 0;
+  uint64_t errors_ = 0;
+  /// The values of the record being decoded, by field, appended once it
+  /// is complete; strings point into the input.
+  std::vector<double> rowNumbers_;
+  std::vector<std::pair<const uint8_t *, size_t>> rowText_;
+};
+
+/// The decoder with jslib ID `id`, or null once it is closed. Any thread.
+std::shared_ptr<RecordDecoder> find_record_decoder(unsigned id);
+
+/// Install the host functions behind jslib's createRecordDecoder():
+/// __decoderCreate(framing, littleEndian, recordSize, names, types, sizes,
+/// callback) returns an ID; __decoderFeed(id, buffer, offset, length)
+/// decodes a copy of the bytes on `pool`, in order with the other feeds;
+/// __decoderFeedFile(id, path, callback) decodes a mapped file there and
+/// calls `callback(message, records)`; __decoderClose(id) closes it. The
+/// first input after a delivery posts the next one through `postToMain`,
+/// which calls `callback(rows, buffers, errors)` with the buffers of the
+/// columns (two, offsets and bytes, per string column), over the decoded
+/// vectors.
+void install_record_decoders(facebook::jsi::Runtime &rt, ThreadPool &pool,
+                             MainThreadPoster postToMain);
+
+/// Close the decoders and forget their callbacks (see "Shutdown order" in
+/// ThreadPool.h).
+void shutdown_record_decoders();
+
+extern "C" {
+
+/// Feed `size` bytes of a stream, e.g. read from a pipe by a native thread,
+/// to the decoder whose jslib `id` the app passed down; they are decoded on
+/// the calling thread. Returns the number of records decoded, or -1 if
+/// there is no such decoder.
+long imgui_record_decoder_feed(unsigned id, const void *data, size_t size);
+
+} // extern "C"
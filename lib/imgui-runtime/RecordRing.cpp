@@ -0,0 +1,122 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "RecordRing.h"
+
+#include "imgui-runtime.h"
+
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+/// Non-owning view of a ring's memory. Rings live until the process exits.
+class RingMemory : public facebook::jsi::MutableBuffer {
+public:
+  RingMemory(uint8_t *data, size_t size) : data_(data), size_(size) {}
+
+  size_t size() const override { return size_; }
+  uint8_t *data() override { return data_; }
+
+private:
+  uint8_t *data_;
+  size_t size_;
+};
+
+/// The rings by name, and in creation order for sync_record_rings(). The
+/// list only grows, under the mutex; the JS thread reads it under the
+/// mutex too, which producers never take.
+std::mutex s_rings_mutex;
+std::unordered_map<std::string, RecordRing *> s_rings_by_name;
+std::vector<std::unique_ptr<RecordRing>> s_rings;
+
+} // namespace
+
+RecordRing::RecordRing(size_t recordSize, size_t capacity)
+    : recordSize_(recordSize ? recordSize : 1) {
+  size_t rounded = 1;
+  while (rounded < capacity && rounded < ((size_t)1 << 31))
+    rounded <<= 1;
+  mask_ = (uint32_t)(rounded - 1);
+  data_ = static_cast<uint8_t *>(
+      calloc(kHeaderBytes + rounded * recordSize_, 1));
+  if (!data_)
+    throw std::bad_alloc();
+  header()[kHeaderRecordSize] = (uint32_t)recordSize_;
+  header()[kHeaderCapacity] = (uint32_t)rounded;
+}
+
+RecordRing::~RecordRing() { free(data_); }
+
+bool RecordRing::sync() {
+  // The records up to kHeaderRead have been read by JS, on this thread
+  tail_.store(header()[kHeaderRead], std::memory_order_release);
+  // Arm the wakeup before looking at head_, so that a record committed after
+  // the load below wakes the main loop
+  armed_.store(true, std::memory_order_seq_cst);
+  uint32_t head = head_.load(std::memory_order_seq_cst);
+  bool fresh = head != header()[kHeaderEnd];
+  header()[kHeaderEnd] = head;
+  header()[kHeaderDropped] = dropped_.load(std::memory_order_relaxed);
+  return fresh;
+}
+
+std::shared_ptr<facebook::jsi::MutableBuffer> RecordRing::memory() {
+  return std::make_shared<RingMemory>(data_,
+                                      kHeaderBytes + capacity() * recordSize_);
+}
+
+void RecordRing::wake() { imgui_wake_main_loop(); }
+
+RecordRing &imgui_create_record_ring(const char *name, size_t recordSize,
+                                     size_t capacity) {
+  std::lock_guard<std::mutex> lock(s_rings_mutex);
+  auto it = s_rings_by_name.find(name);
+  if (it != s_rings_by_name.end()) {
+    if (it->second->recordSize() != recordSize)
+      throw std::invalid_argument(std::string("record ring '") + name +
+                                  "' exists with another record size");
+    return *it->second;
+  }
+  s_rings.push_back(std::make_unique<RecordRing>(recordSize, capacity));
+  s_rings_by_name.emplace(name, s_rings.back().get());
+  return *s_rings.back();
+}
+
+bool sync_record_rings() {
+  std::lock_guard<std::mutex> lock(s_rings_mutex);
+  bool fresh = false;
+  for (auto &ring : s_rings)
+    fresh |= ring->sync();
+  return fresh;
+}
+
+void install_record_rings(facebook::jsi::Runtime &rt) {
+  rt.global().setProperty(
+      rt, "__recordRing",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__recordRing"), 1,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count < 1 || !args[0].isString())
+              throw facebook::jsi::JSError(rt, "__recordRing expects a name");
+            std::string name = args[0].getString(rt).utf8(rt);
+            RecordRing *ring = nullptr;
+            {
+              std::lock_guard<std::mutex> lock(s_rings_mutex);
+              auto it = s_rings_by_name.find(name);
+              if (it != s_rings_by_name.end())
+                ring = it->second;
+            }
+            if (!ring)
+              return facebook::jsi::Value::undefined();
+            return facebook::jsi::ArrayBuffer(rt, ring->memory());
+          }));
+}
@@ -0,0 +1,117 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include <hermes/hermes.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+/// Lock-free single-producer/single-consumer queue of fixed-size records,
+/// from a native thread to JS. The producer writes records with push() or
+/// reserve()/commit(), without locks or allocation. The consumer is the JS
+/// thread: once per frame sync() publishes the records written since the
+/// last frame to JS, which reads them in place through an ArrayBuffer over
+/// the ring's memory (jslib's recordRing()). The first record after a sync
+/// wakes the main loop from an idle sleep.
+///
+/// The memory starts with a header of 32-bit fields (the kHeader* indices),
+/// followed by `capacity` records. Indices count records since the start
+/// and wrap around at 2^32; a record's slot is its index modulo `capacity`.
+class RecordRing {
+public:
+  /// Fields of the header, as indices of a Uint32Array over the memory.
+  enum : unsigned {
+    /// recordSize and capacity, fixed.
+    kHeaderRecordSize,
+    kHeaderCapacity,
+    /// Index of the first record JS hasn't read, written by JS.
+    kHeaderRead,
+    /// Index after the last record published by sync().
+    kHeaderEnd,
+    /// Records dropped because the ring was full, published by sync().
+    kHeaderDropped,
+  };
+  /// Offset of the first record.
+  static constexpr size_t kHeaderBytes = 64;
+
+  /// `capacity` is rounded up to a power of two. Throws std::bad_alloc.
+  RecordRing(size_t recordSize, size_t capacity);
+  ~RecordRing();
+
+  RecordRing(const RecordRing &) = delete;
+  RecordRing &operator=(const RecordRing &) = delete;
+
+  size_t recordSize() const { return recordSize_; }
+  size_t capacity() const { return mask_ + 1; }
+
+  /// Producer: the slot of the next record, or null if the ring is full (the
+  /// record is then counted as dropped). commit() publishes it.
+  void *reserve() {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) > mask_) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    return slot(head);
+  }
+
+  /// Producer: publish the record written to the slot from reserve().
+  void commit() {
+    head_.store(head_.load(std::memory_order_relaxed) + 1,
+                std::memory_order_seq_cst);
+    // Paired with sync(): either it sees the record, or the wakeup
+    if (armed_.exchange(false, std::memory_order_seq_cst))
+      wake();
+  }
+
+  /// Producer: copy `recordSize()` bytes from `record` into the ring.
+  /// Returns false, dropping the record, if the ring is full.
+  bool push(const void *record) {
+    void *dest = reserve();
+    if (!dest)
+      return false;
+    memcpy(dest, record, recordSize_);
+    commit();
+    return true;
+  }
+
+  /// Consumer (JS thread): release the records JS has read to the producer
+  /// and publish the ones written since the last call. Returns whether there
+  /// are new ones.
+  bool sync();
+
+  /// The ring's memory, header included, for an ArrayBuffer.
+  std::shared_ptr<facebook::jsi::MutableBuffer> memory();
+
+private:
+  uint8_t *slot(uint32_t index) {
+    return data_ + kHeaderBytes + (size_t)(index & mask_) * recordSize_;
+  }
+  uint32_t *header() { return reinterpret_cast<uint32_t *>(data_); }
+  static void wake();
+
+  uint8_t *data_;
+  size_t recordSize_;
+  uint32_t mask_;
+
+  /// Written by the producer.
+  alignas(64) std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> dropped_{0};
+  /// Written by the consumer.
+  alignas(64) std::atomic<uint32_t> tail_{0};
+  /// Set by sync(), taken by the first commit() after it.
+  std::atomic<bool> armed_{true};
+};
+
+/// Install the __recordRing(name) host function behind jslib's recordRing():
+/// the ArrayBuffer over the memory of the ring `name`, or undefined.
+void install_record_rings(facebook::jsi::Runtime &rt);
+
+/// sync() every ring. Returns whether any has new records. JS thread.
+bool sync_record_rings();
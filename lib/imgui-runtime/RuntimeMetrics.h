@@ -0,0 +1,110 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+/// Performance counters shared by the units and the runtime without JSI
+/// calls. The typed imgui unit writes them through imgui_runtime_metrics(),
+/// jslib and the React unit through globalThis.__runtimeMetrics (a
+/// Float64Array over the same memory), and the runtime reads the fields
+/// directly every frame. jslib's globalThis.perfMetrics exposes them to JS by
+/// name.
+///
+/// Every field is a double, so the struct doubles as an array. To add a
+/// counter, append a field and its name to METRIC_NAMES in jslib.js, then
+/// write it by index (untyped units) or byte offset (imgui unit).
+struct RuntimeMetrics {
+  /// Duration of the last renderTree() in ms (imgui unit).
+  double renderTime;
+  /// Average and maximum of the React commits of the last 5 seconds in ms
+  /// (React unit; the percentiles are at the end).
+  double reconciliationAvg;
+  double reconciliationMax;
+  /// Due macrotasks moved to a later frame, and runReady() calls that took
+  /// longer than the budget (jslib, running totals).
+  double deferredTasks;
+  double budgetOverruns;
+  /// Temp arena usage of the previous frame (imgui unit).
+  double tmpBytes;
+  double tmpPeakBytes;
+  double tmpBlocks;
+  /// Time from the first input event of a frame until the frame was handed
+  /// over for presentation, in ms: the last such frame, a moving average, and
+  /// the maximum over the last second (runtime).
+  double inputLatency;
+  double inputLatencyAvg;
+  double inputLatencyMax;
+  /// Duration of the React commits since the runtime last collected it, in
+  /// ms (React unit adds, the runtime resets it every frame).
+  double commitTime;
+  /// 1 while a trace capture runs (see Trace.h), so that JS markers skip
+  /// their host function calls otherwise (runtime).
+  double traceCapturing;
+  /// Host config mutations of the last React commit, including the nodes
+  /// created in the render phase before it, and its duration in ms (React
+  /// unit). Moves to and from root containers count as appendChild,
+  /// insertBefore and removeChild.
+  double commitCreateInstance;
+  double commitCreateTextInstance;
+  double commitAppendChild;
+  double commitInsertBefore;
+  double commitRemoveChild;
+  double commitUpdate;
+  double commitTextUpdate;
+  double lastCommitTime;
+  /// Percentiles of the same React commits as reconciliationAvg, from a
+  /// histogram with 5% buckets (React unit).
+  double reconciliationP50;
+  double reconciliationP95;
+  double reconciliationP99;
+  /// Hermes collections so far, the time they paused JS during the last
+  /// frame in ms, and the heap size and allocated bytes at its end
+  /// (runtime, sampled after every frame).
+  double gcCount;
+  double gcPauseTime;
+  double heapSize;
+  double heapAllocated;
+  /// Allocations of the last completed frame: allocTmp() calls, malloc()
+  /// and calloc() calls of the imgui unit's helpers and their bytes (imgui
+  /// unit), ImGui allocator calls and their bytes, and the bytes allocated
+  /// on the Hermes heap (runtime).
+  double tmpAllocs;
+  double nativeAllocs;
+  double nativeAllocBytes;
+  double imguiAllocs;
+  double imguiAllocBytes;
+  double jsAllocBytes;
+  /// Macrotasks (immediates and timers) and rAF callbacks run since the
+  /// runtime last collected them (jslib adds, the runtime resets them every
+  /// frame), and their totals for the last completed frame (runtime).
+  double frameTasks;
+  double frameRafCallbacks;
+  double tasksPerFrame;
+  double rafCallbacksPerFrame;
+  /// Live timers and immediates left queued by the last runReady() (jslib).
+  double macrotaskQueueDepth;
+  /// How late the timers of the last 5 seconds ran, in ms: the time they
+  /// started minus their deadline, averaged, at the 95th percentile of a
+  /// histogram with 5% buckets, and the maximum (jslib).
+  double timerLatenessAvg;
+  double timerLatenessP95;
+  double timerLatenessMax;
+  /// Time spent draining the microtask queue during the last completed
+  /// frame, in ms (runtime).
+  double microtaskDrainTime;
+  /// Vertices and indices of the last frame drawn, the capacity of
+  /// sokol_imgui's vertex and index buffers, which grow on demand, and how
+  /// many times they were resized (runtime, on the drawing thread).
+  double drawBufferVertices;
+  double drawBufferIndices;
+  double drawBufferVertexCapacity;
+  double drawBufferIndexCapacity;
+  double drawBufferResizes;
+  /// Microtask queue drains during the last completed frame, including the
+  /// empty ones (runtime). Depends on sappConfig.microtask_drain.
+  double microtaskDrains;
+};
+
+/// The metrics block. Valid for the lifetime of the process.
+extern "C" RuntimeMetrics *imgui_runtime_metrics(void);
@@ -0,0 +1,331 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "SettingsStore.h"
+
+#include "MappedFileBuffer.h"
+#include "ThreadPool.h"
+
+#define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
+#include "cimgui.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+
+namespace {
+
+constexpr char kAppType[] = "App";
+constexpr char kValuePrefix[] = "value=";
+
+ThreadPool *s_pool = nullptr;
+std::string s_app_name;
+bool s_persist = false;
+bool s_opened = false;
+/// The settings file; empty keeps everything in memory.
+std::string s_path;
+/// The mapped file, until settings_store_apply() hands it to ImGui.
+std::shared_ptr<facebook::jsi::Buffer> s_file;
+bool s_applied = false;
+
+/// The app entries, JSON by key.
+std::map<std::string, std::string> s_entries;
+/// An entry changed since the last settings_store_update().
+bool s_entries_dirty = false;
+
+/// The writes: the latest serialized settings not written yet, and whether
+/// a worker is writing.
+std::mutex s_write_mutex;
+std::condition_variable s_write_done;
+std::string s_pending;
+bool s_has_pending = false;
+bool s_writing = false;
+
+/// Create `dir` and its parent, if they don't exist.
+void make_dirs(const std::string &dir) {
+  size_t slash = dir.find_last_of('/');
+  if (slash != std::string::npos && slash > 0)
+    mkdir(dir.substr(0, slash).c_str(), 0755);
+  mkdir(dir.c_str(), 0755);
+}
+
+/// Write `data` to `path` through a temporary file, which is synced before
+/// it replaces the old one.
+void write_file(const std::string &path, const std::string &data) {
+  size_t slash = path.find_last_of('/');
+  if (slash != std::string::npos && slash > 0)
+    make_dirs(path.substr(0, slash));
+  std::string tmpPath = path + "." + std::to_string(getpid());
+  FILE *f = fopen(tmpPath.c_str(), "wb");
+  if (!f) {
+    fprintf(stderr, "Can't write settings %s: %s\n", tmpPath.c_str(),
+            strerror(errno));
+    return;
+  }
+  bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+  ok = ok && fflush(f) == 0 && fsync(fileno(f)) == 0;
+  ok = fclose(f) == 0 && ok;
+  if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+    fprintf(stderr, "Can't write settings %s\n", path.c_str());
+    unlink(tmpPath.c_str());
+  }
+}
+
+/// Worker job: write the pending settings until there are none.
+void write_pending() {
+  std::unique_lock<std::mutex> lock(s_write_mutex);
+  while (s_has_pending) {
+    std::string data = std::move(s_pending);
+    s_has_pending = false;
+    lock.unlock();
+    write_file(s_path, data);
+    lock.lock();
+  }
+  s_writing = false;
+  s_write_done.notify_all();
+}
+
+void queue_write(std::string data) {
+  std::lock_guard<std::mutex> lock(s_write_mutex);
+  s_pending = std::move(data);
+  s_has_pending = true;
+  if (s_writing)
+    return;
+  s_writing = true;
+  s_pool->post(write_pending, {TaskPriority::Background});
+}
+
+/// Collect the `[App][<key>]` sections of the file. ImGui reads the rest.
+void parse_entries(const char *data, size_t size) {
+  const char *end = data + size;
+  const char *key = nullptr;
+  size_t keyLen = 0;
+  for (const char *line = data; line < end;) {
+    const char *lineEnd = line;
+    while (lineEnd < end && *lineEnd != '\n' && *lineEnd != '\r')
+      ++lineEnd;
+    size_t len = lineEnd - line;
+    if (len > 0 && line[0] == '[') {
+      constexpr size_t prefixLen = sizeof(kAppType) + 2; // "[App]["
+      key = nullptr;
+      if (len > prefixLen && line[len - 1] == ']' &&
+          memcmp(line + 1, kAppType, sizeof(kAppType) - 1) == 0 &&
+          memcmp(line + sizeof(kAppType), "][", 2) == 0) {
+        key = line + prefixLen;
+        keyLen = len - prefixLen - 1;
+      }
+    } else if (key && len >= sizeof(kValuePrefix) - 1 &&
+               memcmp(line, kValuePrefix, sizeof(kValuePrefix) - 1) == 0) {
+      s_entries[std::string(key, keyLen)] = std::string(
+          line + sizeof(kValuePrefix) - 1, len - (sizeof(kValuePrefix) - 1));
+    }
+    line = lineEnd;
+    while (line < end && (*line == '\n' || *line == '\r'))
+      ++line;
+  }
+}
+
+// The handler of the app entries. They were parsed by settings_store_open(),
+// so reading skips them; writing appends them to ImGui's own settings.
+void *app_read_open(ImGuiContext *, ImGuiSettingsHandler *, const char *) {
+  return nullptr;
+}
+
+void app_read_line(ImGuiContext *, ImGuiSettingsHandler *, void *,
+                   const char *) {}
+
+void app_write_all(ImGuiContext *, ImGuiSettingsHandler *,
+                   ImGuiTextBuffer *out) {
+  for (const auto &[key, value] : s_entries)
+    ImGuiTextBuffer_appendf(out, "[%s][%s]\n%s%s\n\n", kAppType, key.c_str(),
+                            kValuePrefix, value.c_str());
+}
+
+std::string string_arg(facebook::jsi::Runtime &rt,
+                       const facebook::jsi::Value *args, size_t count,
+                       size_t index, const char *error) {
+  if (count <= index || !args[index].isString())
+    throw facebook::jsi::JSError(rt, error);
+  return args[index].getString(rt).utf8(rt);
+}
+
+} // namespace
+
+std::string settings_store_default_dir() {
+  std::string base;
+  if (const char *xdg = getenv("XDG_CONFIG_HOME"); xdg && *xdg) {
+    base = xdg;
+  } else if (const char *home = getenv("HOME"); home && *home) {
+#ifdef __APPLE__
+    base = std::string(home) + "/Library/Application Support";
+#else
+    base = std::string(home) + "/.config";
+#endif
+  } else {
+    return std::string();
+  }
+  return base + "/imgui-react-runtime";
+}
+
+void settings_store_open(facebook::jsi::Runtime &rt) {
+  if (s_opened)
+    return;
+  s_opened = true;
+  if (!s_persist)
+    return;
+
+  if (const char *env = getenv("IMGUI_SETTINGS")) {
+    s_path = env;
+  } else {
+    auto global = rt.global();
+    if (global.hasProperty(rt, "sappConfig")) {
+      auto value = global.getPropertyAsObject(rt, "sappConfig")
+                       .getProperty(rt, "settings");
+      if (value.isBool() && value.getBool()) {
+        std::string dir = settings_store_default_dir();
+        if (!dir.empty())
+          s_path = dir + "/" + s_app_name + ".ini";
+      } else if (value.isString()) {
+        s_path = value.getString(rt).utf8(rt);
+      }
+    }
+  }
+  if (s_path.empty())
+    return;
+
+  struct stat st;
+  if (stat(s_path.c_str(), &st) != 0 || st.st_size == 0)
+    return;
+  try {
+    s_file = mapFileBuffer(s_path.c_str());
+  } catch (const std::exception &e) {
+    fprintf(stderr, "Can't read settings %s: %s\n", s_path.c_str(), e.what());
+    return;
+  }
+  parse_entries(reinterpret_cast<const char *>(s_file->data()),
+                s_file->size());
+}
+
+void settings_store_apply() {
+  if (s_applied)
+    return;
+  s_applied = true;
+
+  ImGuiSettingsHandler handler{};
+  handler.TypeName = kAppType;
+  handler.TypeHash = igImHashStr(kAppType, 0, 0);
+  handler.ReadOpenFn = app_read_open;
+  handler.ReadLineFn = app_read_line;
+  handler.WriteAllFn = app_write_all;
+  igAddSettingsHandler(&handler);
+
+  // ImGui copies the file
+  if (s_file) {
+    igLoadIniSettingsFromMemory(
+        reinterpret_cast<const char *>(s_file->data()), s_file->size());
+    s_file.reset();
+  }
+}
+
+void settings_store_update() {
+  if (s_path.empty() || !s_applied)
+    return;
+  if (s_entries_dirty) {
+    s_entries_dirty = false;
+    igMarkIniSettingsDirty_Nil();
+  }
+  ImGuiIO *io = igGetIO();
+  if (!io->WantSaveIniSettings)
+    return;
+  io->WantSaveIniSettings = false;
+  size_t size = 0;
+  const char *ini = igSaveIniSettingsToMemory(&size);
+  queue_write(std::string(ini, size));
+}
+
+void settings_store_shutdown() {
+  if (s_path.empty() || !s_applied)
+    return;
+  std::unique_lock<std::mutex> lock(s_write_mutex);
+  // Settings that changed since the last save, or whose save is still
+  // waiting for its delay
+  std::string data;
+  bool dirty = s_entries_dirty || igGetIO()->WantSaveIniSettings ||
+               igGetCurrentContext()->SettingsDirtyTimer > 0.0f;
+  if (dirty) {
+    size_t size = 0;
+    const char *ini = igSaveIniSettingsToMemory(&size);
+    data.assign(ini, size);
+  } else if (s_has_pending) {
+    data = std::move(s_pending);
+  }
+  s_has_pending = false;
+  s_write_done.wait(lock, [] { return !s_writing; });
+  lock.unlock();
+  if (dirty || !data.empty())
+    write_file(s_path, data);
+  s_entries_dirty = false;
+}
+
+void install_settings_store(facebook::jsi::Runtime &rt, ThreadPool &pool,
+                            std::string appName, bool persist) {
+  s_pool = &pool;
+  s_app_name = std::move(appName);
+  s_persist = persist;
+
+  rt.global().setProperty(
+      rt, "__settingsGet",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__settingsGet"), 1,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            std::string key =
+                string_arg(rt, args, count, 0, "__settingsGet expects a key");
+            settings_store_open(rt);
+            auto it = s_entries.find(key);
+            if (it == s_entries.end())
+              return facebook::jsi::Value::undefined();
+            return facebook::jsi::String::createFromUtf8(rt, it->second);
+          }));
+
+  // __settingsSet(key, json), or __settingsSet(key) to remove the entry
+  rt.global().setProperty(
+      rt, "__settingsSet",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__settingsSet"), 2,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            std::string key =
+                string_arg(rt, args, count, 0, "__settingsSet expects a key");
+            // Each entry is one section header and one line
+            if (key.empty() || key.find_first_of("\r\n") != std::string::npos)
+              throw facebook::jsi::JSError(
+                  rt, "Settings keys must be non-empty single lines");
+            settings_store_open(rt);
+            if (count < 2 || args[1].isUndefined()) {
+              s_entries_dirty |= s_entries.erase(key) > 0;
+              return facebook::jsi::Value::undefined();
+            }
+            std::string value =
+                string_arg(rt, args, count, 1, "__settingsSet expects JSON");
+            if (value.find_first_of("\r\n") != std::string::npos)
+              throw facebook::jsi::JSError(
+                  rt, "Settings values must be single lines");
+            std::string &entry = s_entries[key];
+            if (entry != value) {
+              entry = std::move(value);
+              s_entries_dirty = true;
+            }
+            return facebook::jsi::Value::undefined();
+          }));
+}
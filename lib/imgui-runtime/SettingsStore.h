@@ -0,0 +1,55 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include <hermes/hermes.h>
+
+#include <string>
+
+class ThreadPool;
+
+/// ImGui's persisted settings (window positions and sizes, table column
+/// widths and order) and the app's own entries, in one ini file. The file is
+/// mapped and parsed at startup. ImGui marks its settings dirty when they
+/// change, and after io.IniSavingRate seconds of that (5 by default) asks
+/// for a save: settings_store_update() then serializes them, which is fast,
+/// and a worker writes the file to a temporary and renames it, so that a
+/// crash never leaves a partial file. Saves requested while one is written
+/// are coalesced into the latest.
+///
+/// The app entries are JSON strings, written as `[App][<key>]` sections that
+/// ImGui skips. Everything here runs on the thread that owns the ImGui
+/// context, except the writes.
+
+/// Install the __settingsGet(key) and __settingsSet(key, json) host functions
+/// behind jslib's appSettings, with `pool` for the writes. `appName` names
+/// the file in the per-user directory (see settings_store_open()). Without
+/// `persist` (headless runs), no file is read or written.
+void install_settings_store(facebook::jsi::Runtime &rt, ThreadPool &pool,
+                            std::string appName, bool persist);
+
+/// The per-user settings directory of the runtime: $XDG_CONFIG_HOME or
+/// ~/.config (~/Library/Application Support on macOS), plus
+/// /imgui-react-runtime.
+std::string settings_store_default_dir();
+
+/// Map and parse the settings file, once: IMGUI_SETTINGS (empty disables
+/// the store), or else sappConfig.settings, true for <appName>.ini in the
+/// per-user directory or a path. Without either, the app entries are only
+/// kept in memory. Called when the config is read, or by the first
+/// appSettings call if that comes first.
+void settings_store_open(facebook::jsi::Runtime &rt);
+
+/// Hand the settings read by settings_store_open() to the ImGui context,
+/// which must exist, before its first frame.
+void settings_store_apply();
+
+/// Once per frame, after igRender(): start writing the settings if ImGui
+/// asked for a save.
+void settings_store_update();
+
+/// Write the settings if they changed since the last save, and wait for
+/// the writes. Must be called before the ImGui context is destroyed.
+void settings_store_shutdown();
@@ -0,0 +1,322 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "SharedBuffer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <unordered_map>
+
+namespace {
+
+/// The registered buffers by data pointer, for finding the one an
+/// ArrayBuffer wraps. Entries of buffers that are gone are swept whenever
+/// the table has doubled since the last sweep.
+struct Registered {
+  std::weak_ptr<facebook::jsi::MutableBuffer> buffer;
+  bool shared;
+};
+std::mutex s_registry_mutex;
+std::unordered_map<const uint8_t *, Registered> s_registry;
+size_t s_registry_swept_size = 16;
+
+/// A thread blocked in __atomicsWait(). It lives on the waiting thread's
+/// stack; __atomicsNotify() sets `notified` and signals `cv`, so a
+/// notification goes to one particular waiter and a later waiter on the
+/// same address can't take it.
+struct Waiter {
+  std::condition_variable cv;
+  bool notified = false;
+  /// The waiting thread's abort flag, if it has one.
+  const AtomicsWaitAbort *abort = nullptr;
+};
+/// The waiters on each address, oldest first, as Atomics.notify() wakes
+/// them in FIFO order. Guarded by s_wait_mutex, as are the abort flags.
+std::mutex s_wait_mutex;
+std::unordered_map<const int32_t *, std::deque<Waiter *>> s_wait_lists;
+/// This thread's abort flag (set_atomics_wait_abort()).
+thread_local AtomicsWaitAbort *t_wait_abort = nullptr;
+
+/// ToInt32() of a JS number.
+int32_t to_int32(double value) {
+  if (!std::isfinite(value))
+    return 0;
+  double wrapped = std::fmod(std::trunc(value), 4294967296.0);
+  if (wrapped < 0)
+    wrapped += 4294967296.0;
+  return (int32_t)(uint32_t)wrapped;
+}
+
+/// The 32-bit integer at `byteIndex` of ArrayBuffer `buffer`.
+int32_t *atomic_slot(facebook::jsi::Runtime &rt,
+                     const facebook::jsi::Value &buffer,
+                     const facebook::jsi::Value &byteIndex) {
+  if (!buffer.isObject() || !buffer.getObject(rt).isArrayBuffer(rt) ||
+      !byteIndex.isNumber())
+    throw facebook::jsi::JSError(
+        rt, "Atomics expects an ArrayBuffer and a byte index");
+  facebook::jsi::ArrayBuffer ab = buffer.getObject(rt).getArrayBuffer(rt);
+  double index = byteIndex.getNumber();
+  if (!(index >= 0) || std::fmod(index, 4) != 0 || index + 4 > ab.size(rt))
+    throw facebook::jsi::JSError(rt, "Atomics: index out of range");
+  return reinterpret_cast<int32_t *>(ab.data(rt) + (size_t)index);
+}
+
+int32_t atomic_op(AtomicOp op, int32_t *slot, int32_t value,
+                  int32_t replacement) {
+  switch (op) {
+  case AtomicOp::Load:
+    return __atomic_load_n(slot, __ATOMIC_SEQ_CST);
+  case AtomicOp::Store:
+    __atomic_store_n(slot, value, __ATOMIC_SEQ_CST);
+    return value;
+  case AtomicOp::Add:
+    return __atomic_fetch_add(slot, value, __ATOMIC_SEQ_CST);
+  case AtomicOp::Sub:
+    return __atomic_fetch_sub(slot, value, __ATOMIC_SEQ_CST);
+  case AtomicOp::And:
+    return __atomic_fetch_and(slot, value, __ATOMIC_SEQ_CST);
+  case AtomicOp::Or:
+    return __atomic_fetch_or(slot, value, __ATOMIC_SEQ_CST);
+  case AtomicOp::Xor:
+    return __atomic_fetch_xor(slot, value, __ATOMIC_SEQ_CST);
+  case AtomicOp::Exchange:
+    return __atomic_exchange_n(slot, value, __ATOMIC_SEQ_CST);
+  case AtomicOp::CompareExchange:
+    // `value` becomes the value found, whether or not it was replaced
+    __atomic_compare_exchange_n(slot, &value, replacement, false,
+                                __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return value;
+  }
+  return 0;
+}
+
+} // namespace
+
+SharedBuffer::SharedBuffer(size_t size)
+    : data_(static_cast<uint8_t *>(calloc(size ? size : 1, 1))), size_(size) {
+  if (!data_)
+    throw std::bad_alloc();
+}
+
+SharedBuffer::~SharedBuffer() { free(data_); }
+
+void register_transferable_buffer(
+    const std::shared_ptr<facebook::jsi::MutableBuffer> &buffer, bool shared) {
+  std::lock_guard<std::mutex> lock(s_registry_mutex);
+  s_registry[buffer->data()] = Registered{buffer, shared};
+  if (s_registry.size() < 2 * s_registry_swept_size)
+    return;
+  for (auto it = s_registry.begin(); it != s_registry.end();) {
+    if (it->second.buffer.expired())
+      it = s_registry.erase(it);
+    else
+      ++it;
+  }
+  s_registry_swept_size = std::max<size_t>(s_registry.size(), 16);
+}
+
+std::shared_ptr<facebook::jsi::MutableBuffer>
+shared_buffer_for_message(facebook::jsi::Runtime &rt,
+                          facebook::jsi::ArrayBuffer &buffer, bool transfer) {
+  uint8_t *data = buffer.data(rt);
+  size_t size = buffer.size(rt);
+  {
+    std::lock_guard<std::mutex> lock(s_registry_mutex);
+    auto it = s_registry.find(data);
+    if (it != s_registry.end() && (it->second.shared || transfer)) {
+      std::shared_ptr<facebook::jsi::MutableBuffer> own =
+          it->second.buffer.lock();
+      if (own && own->size() == size)
+        return own;
+    }
+  }
+  // Memory of the sender's heap, or a buffer that is copied anyway. The copy
+  // is registered so that the receiver can transfer it on.
+  auto copy = std::make_shared<SharedBuffer>(size);
+  memcpy(copy->data(), data, size);
+  register_transferable_buffer(copy, false);
+  return copy;
+}
+
+std::shared_ptr<facebook::jsi::MutableBuffer>
+borrow_buffer(facebook::jsi::Runtime &rt, facebook::jsi::ArrayBuffer &buffer) {
+  // Any registered buffer will do: the job only reads it
+  return shared_buffer_for_message(rt, buffer, true);
+}
+
+SharedBuffers shared_buffers_for_message(facebook::jsi::Runtime &rt,
+                                         const facebook::jsi::Value &buffers,
+                                         const facebook::jsi::Value &transfer) {
+  SharedBuffers result;
+  if (!buffers.isObject() || !buffers.getObject(rt).isArray(rt))
+    return result;
+  facebook::jsi::Array list = buffers.getObject(rt).getArray(rt);
+  std::optional<facebook::jsi::Array> flags;
+  if (transfer.isObject() && transfer.getObject(rt).isArray(rt))
+    flags = transfer.getObject(rt).getArray(rt);
+  size_t count = list.size(rt);
+  result.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    facebook::jsi::Value item = list.getValueAtIndex(rt, i);
+    if (!item.isObject() || !item.getObject(rt).isArrayBuffer(rt))
+      throw facebook::jsi::JSError(rt,
+                                   "Message buffers must be ArrayBuffers");
+    facebook::jsi::ArrayBuffer ab = item.getObject(rt).getArrayBuffer(rt);
+    bool move = false;
+    if (flags && i < flags->size(rt)) {
+      facebook::jsi::Value flag = flags->getValueAtIndex(rt, i);
+      move = flag.isBool() && flag.getBool();
+    }
+    result.push_back(shared_buffer_for_message(rt, ab, move));
+  }
+  return result;
+}
+
+facebook::jsi::Array shared_buffers_to_js(facebook::jsi::Runtime &rt,
+                                          const SharedBuffers &buffers) {
+  facebook::jsi::Array result(rt, buffers.size());
+  for (size_t i = 0; i < buffers.size(); ++i)
+    result.setValueAtIndex(rt, i, facebook::jsi::ArrayBuffer(rt, buffers[i]));
+  return result;
+}
+
+void install_shared_buffers(facebook::jsi::Runtime &rt) {
+  rt.global().setProperty(
+      rt, "__createSharedMemory",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__createSharedMemory"),
+          1,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count < 1 || !args[0].isNumber() ||
+                !(args[0].getNumber() >= 0))
+              throw facebook::jsi::JSError(
+                  rt, "createSharedBuffer expects a size in bytes");
+            auto buffer =
+                std::make_shared<SharedBuffer>((size_t)args[0].getNumber());
+            register_transferable_buffer(buffer, true);
+            return facebook::jsi::ArrayBuffer(rt, std::move(buffer));
+          }));
+
+  rt.global().setProperty(
+      rt, "__atomics",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__atomics"), 5,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count < 3 || !args[0].isNumber())
+              throw facebook::jsi::JSError(
+                  rt, "__atomics expects an operation, a buffer and an index");
+            int32_t *slot = atomic_slot(rt, args[1], args[2]);
+            int32_t value = 0, replacement = 0;
+            if (count > 3 && args[3].isNumber())
+              value = to_int32(args[3].getNumber());
+            if (count > 4 && args[4].isNumber())
+              replacement = to_int32(args[4].getNumber());
+            return (double)atomic_op((AtomicOp)(int)args[0].getNumber(), slot,
+                                     value, replacement);
+          }));
+
+  rt.global().setProperty(
+      rt, "__atomicsWait",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__atomicsWait"), 4,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count < 4 || !args[2].isNumber() || !args[3].isNumber())
+              throw facebook::jsi::JSError(
+                  rt, "__atomicsWait expects a buffer, an index, a value and "
+                      "a timeout");
+            int32_t *slot = atomic_slot(rt, args[0], args[1]);
+            int32_t expected = to_int32(args[2].getNumber());
+            double timeoutMs = args[3].getNumber();
+
+            std::unique_lock<std::mutex> lock(s_wait_mutex);
+            if (t_wait_abort && t_wait_abort->aborted)
+              return facebook::jsi::String::createFromAscii(rt, "timed-out");
+            if (__atomic_load_n(slot, __ATOMIC_SEQ_CST) != expected)
+              return facebook::jsi::String::createFromAscii(rt, "not-equal");
+            Waiter waiter;
+            waiter.abort = t_wait_abort;
+            s_wait_lists[slot].push_back(&waiter);
+            auto notified = [&] {
+              return waiter.notified ||
+                     (waiter.abort && waiter.abort->aborted);
+            };
+            if (timeoutMs < 0 || std::isinf(timeoutMs)) {
+              waiter.cv.wait(lock, notified);
+            } else {
+              waiter.cv.wait_for(
+                  lock, std::chrono::duration<double, std::milli>(timeoutMs),
+                  notified);
+            }
+            // A notified waiter has already been dequeued by the notifier;
+            // one that timed out or was aborted dequeues itself.
+            if (!waiter.notified) {
+              auto it = s_wait_lists.find(slot);
+              std::deque<Waiter *> &queue = it->second;
+              queue.erase(std::find(queue.begin(), queue.end(), &waiter));
+              if (queue.empty())
+                s_wait_lists.erase(it);
+            }
+            return facebook::jsi::String::createFromAscii(
+                rt, waiter.notified ? "ok" : "timed-out");
+          }));
+
+  rt.global().setProperty(
+      rt, "__atomicsNotify",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__atomicsNotify"), 3,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count < 2)
+              throw facebook::jsi::JSError(
+                  rt, "__atomicsNotify expects a buffer and an index");
+            int32_t *slot = atomic_slot(rt, args[0], args[1]);
+            double limit = count > 2 && args[2].isNumber()
+                               ? args[2].getNumber()
+                               : INFINITY;
+            std::lock_guard<std::mutex> lock(s_wait_mutex);
+            auto it = s_wait_lists.find(slot);
+            if (it == s_wait_lists.end())
+              return 0;
+            std::deque<Waiter *> &queue = it->second;
+            int woken = 0;
+            while (!queue.empty() && woken < limit) {
+              Waiter *waiter = queue.front();
+              queue.pop_front();
+              waiter->notified = true;
+              waiter->cv.notify_one();
+              ++woken;
+            }
+            if (queue.empty())
+              s_wait_lists.erase(it);
+            return woken;
+          }));
+}
+
+void set_atomics_wait_abort(AtomicsWaitAbort *abort) { t_wait_abort = abort; }
+
+void abort_atomics_waits(AtomicsWaitAbort *abort) {
+  std::lock_guard<std::mutex> lock(s_wait_mutex);
+  abort->aborted = true;
+  for (auto &[slot, queue] : s_wait_lists)
+    for (Waiter *waiter : queue)
+      if (waiter->abort == abort)
+        waiter->cv.notify_one();
+}
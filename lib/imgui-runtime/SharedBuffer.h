@@ -0,0 +1,131 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include <hermes/hermes.h>
+
+#include <memory>
+#include <vector>
+
+/// Zeroed native memory for ArrayBuffers, which the ArrayBuffers of several
+/// runtimes can wrap at once. Throws std::bad_alloc.
+class SharedBuffer : public facebook::jsi::MutableBuffer {
+public:
+  explicit SharedBuffer(size_t size);
+  ~SharedBuffer() override;
+
+  SharedBuffer(const SharedBuffer &) = delete;
+  SharedBuffer &operator=(const SharedBuffer &) = delete;
+
+  size_t size() const override { return size_; }
+  uint8_t *data() override { return data_; }
+
+private:
+  uint8_t *data_;
+  size_t size_;
+};
+
+/// An ArrayBuffer's memory over a vector of results computed natively.
+template <typename T>
+class VectorBuffer : public facebook::jsi::MutableBuffer {
+public:
+  explicit VectorBuffer(std::vector<T> &&items) : items_(std::move(items)) {}
+
+  size_t size() const override { return items_.size() * sizeof(T); }
+  uint8_t *data() override {
+    if (items_.empty())
+      return &empty_;
+    return reinterpret_cast<uint8_t *>(items_.data());
+  }
+
+private:
+  std::vector<T> items_;
+  uint8_t empty_ = 0;
+};
+
+/// Let worker messages carry `buffer` without copying it. A `shared` buffer
+/// (createSharedBuffer()) is the SharedArrayBuffer of the runtimes: every
+/// message that carries it shares it. Others are only handed over when
+/// they are in the message's transfer list, and copied otherwise. Safe to
+/// call from any thread.
+void register_transferable_buffer(
+    const std::shared_ptr<facebook::jsi::MutableBuffer> &buffer, bool shared);
+
+/// The shared buffer of `handle` (the nativeHandle of a createSharedArray()
+/// array), kept alive by the caller, or null if it has been collected.
+/// Main thread. Defined in imgui-runtime.cpp, with the registry.
+std::shared_ptr<SharedBuffer> lock_shared_buffer(int handle);
+
+/// The operations of __atomics(), as jslib numbers them.
+enum class AtomicOp {
+  Load,
+  Store,
+  Add,
+  Sub,
+  And,
+  Or,
+  Xor,
+  Exchange,
+  CompareExchange,
+};
+
+/// The buffers of a worker message.
+using SharedBuffers =
+    std::vector<std::shared_ptr<facebook::jsi::MutableBuffer>>;
+
+/// The native memory to send for ArrayBuffer `buffer`: its own if it wraps a
+/// registered buffer that is shared or being transferred (`transfer`),
+/// otherwise a copy. Thread of `rt`.
+std::shared_ptr<facebook::jsi::MutableBuffer>
+shared_buffer_for_message(facebook::jsi::Runtime &rt,
+                          facebook::jsi::ArrayBuffer &buffer, bool transfer);
+
+/// The native memory of ArrayBuffer `buffer` for a job on another thread
+/// that reads it: a registered buffer's own, which the job keeps alive,
+/// otherwise a copy. JS must not write to it until the job is done. Thread
+/// of `rt`.
+std::shared_ptr<facebook::jsi::MutableBuffer>
+borrow_buffer(facebook::jsi::Runtime &rt, facebook::jsi::ArrayBuffer &buffer);
+
+/// Convert the ArrayBuffers of a message, `buffers[i]` transferred if
+/// `transfer[i]` is true. Thread of `rt`.
+SharedBuffers shared_buffers_for_message(facebook::jsi::Runtime &rt,
+                                         const facebook::jsi::Value &buffers,
+                                         const facebook::jsi::Value &transfer);
+
+/// ArrayBuffers of `rt` wrapping `buffers`, for the receiver of a message.
+facebook::jsi::Array shared_buffers_to_js(facebook::jsi::Runtime &rt,
+                                          const SharedBuffers &buffers);
+
+/// Lets another thread interrupt a thread's __atomicsWait() calls, which
+/// would otherwise block a worker's termination. Guarded by the wait mutex.
+struct AtomicsWaitAbort {
+  bool aborted = false;
+};
+
+/// Use `abort` for this thread's __atomicsWait() calls, or none if null.
+/// `abort` must outlive the thread's runtime.
+void set_atomics_wait_abort(AtomicsWaitAbort *abort);
+
+/// Wake the __atomicsWait() calls of the threads using `abort` and make
+/// their later ones return at once, all with "timed-out". Any thread.
+void abort_atomics_waits(AtomicsWaitAbort *abort);
+
+/// Install the host functions behind jslib's createSharedBuffer() and
+/// Atomics, in the main runtime and every worker's:
+/// - __createSharedMemory(size) returns the ArrayBuffer of a new SharedBuffer,
+///   registered as shared. (The main runtime's __createSharedBuffer(), behind
+///   createSharedArray(), registers its buffers as shared as well.)
+/// - __atomics(op, buffer, byteIndex, value, replacement) performs a
+///   sequentially consistent operation on the 32-bit integer at
+///   `byteIndex`, an AtomicOp. It returns the old value (Store: the new
+///   one).
+/// - __atomicsWait(buffer, byteIndex, expected, timeoutMs) blocks while the
+///   integer is `expected` until notified, returning "ok", "not-equal" or
+///   "timed-out". A negative timeout waits forever, or until
+///   abort_atomics_waits().
+/// - __atomicsNotify(buffer, byteIndex, count) wakes up to `count` waiters
+///   and returns how many it woke.
+void install_shared_buffers(facebook::jsi::Runtime &rt);
@@ -0,0 +1,82 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "StreamTexture.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+/// Zeroed native memory, for an ArrayBuffer.
+class PixelBuffer : public facebook::jsi::MutableBuffer {
+public:
+  explicit PixelBuffer(size_t size)
+      : data_(static_cast<uint8_t *>(calloc(size ? size : 1, 1))),
+        size_(size) {
+    if (!data_)
+      throw std::bad_alloc();
+  }
+  ~PixelBuffer() override { free(data_); }
+
+  size_t size() const override { return size_; }
+  uint8_t *data() override { return data_; }
+
+private:
+  uint8_t *data_;
+  size_t size_;
+};
+
+} // namespace
+
+StreamTexture::StreamTexture(int width, int height, bool gpu)
+    : width_(width), height_(height) {
+  size_t size = (size_t)width * height * 4;
+  buffers_[0] = std::make_shared<PixelBuffer>(size);
+  buffers_[1] = std::make_shared<PixelBuffer>(size);
+  if (gpu) {
+    image_ = sg_make_image(sg_image_desc{
+        .width = width,
+        .height = height,
+        .usage = SG_USAGE_STREAM,
+        .label = "stream-texture",
+    });
+  }
+}
+
+StreamTexture::~StreamTexture() {
+  if (image_.id)
+    sg_destroy_image(image_);
+}
+
+int StreamTexture::update() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  int next = 1 - back_;
+  uploaded_.wait(lock, [&] { return uploading_ != next; });
+  pending_ = back_;
+  back_ = next;
+  return back_;
+}
+
+void StreamTexture::flush() {
+  int index;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_ < 0 || !image_.id)
+      return;
+    index = pending_;
+    pending_ = -1;
+    uploading_ = index;
+  }
+  sg_image_data data = {};
+  data.subimage[0][0] = {.ptr = buffers_[index]->data(),
+                         .size = buffers_[index]->size()};
+  sg_update_image(image_, &data);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uploading_ = -1;
+  }
+  uploaded_.notify_all();
+}
@@ -0,0 +1,68 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include "sokol_gfx.h"
+
+#include <hermes/hermes.h>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+/// An RGBA8 texture that JS rewrites every frame (heatmaps, spectrograms,
+/// camera frames). It has two native pixel buffers, which JS sees as
+/// ArrayBuffers. JS fills one while the render thread uploads the other
+/// with sg_update_image() straight from its memory, so neither copies nor
+/// waits on the other. The texture is SG_USAGE_STREAM, which sokol_gfx
+/// keeps one copy of per frame in flight, so an upload doesn't stall on the
+/// GPU still drawing the previous one.
+class StreamTexture {
+public:
+  /// Without `gpu` (headless runs), there is no texture and flush() does
+  /// nothing. Render thread.
+  StreamTexture(int width, int height, bool gpu);
+  /// Render thread.
+  ~StreamTexture();
+
+  StreamTexture(const StreamTexture &) = delete;
+  StreamTexture &operator=(const StreamTexture &) = delete;
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+  sg_image image() const { return image_; }
+
+  /// Pixel buffer 0 or 1, width * height * 4 bytes.
+  const std::shared_ptr<facebook::jsi::MutableBuffer> &buffer(int i) const {
+    return buffers_[i];
+  }
+
+  /// The pixels of the buffer to fill next, for native code filling it on
+  /// the JS thread in place of JS.
+  uint8_t *pixels() { return buffers_[back_]->data(); }
+
+  /// Queue the buffer JS has been filling for upload and return the index
+  /// of the one to fill next. Waits while the render thread still uploads
+  /// that one. A buffer queued again before it was uploaded replaces the
+  /// older one. JS thread.
+  int update();
+
+  /// Upload the buffer queued by update(), if any. Render thread, once per
+  /// frame, before the texture is drawn.
+  void flush();
+
+private:
+  int width_, height_;
+  sg_image image_ = {};
+  std::shared_ptr<facebook::jsi::MutableBuffer> buffers_[2];
+
+  std::mutex mutex_;
+  std::condition_variable uploaded_;
+  /// The buffer JS fills, the one queued for upload and the one uploading
+  /// (-1 for none).
+  int back_ = 0;
+  int pending_ = -1;
+  int uploading_ = -1;
+};
@@ -0,0 +1,838 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "TableKernels.h"
+
+#include "SharedBuffer.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+/// Chunks are at least this many rows; smaller inputs run as one.
+constexpr size_t kMinChunkRows = 32 * 1024;
+
+// Columns.
+
+enum class Kind { F64, I32, U32, String };
+
+/// A column or index array from JS, in native memory that the operation
+/// keeps alive.
+struct Column {
+  Kind kind = Kind::F64;
+  std::shared_ptr<facebook::jsi::MutableBuffer> data, offsetsData;
+  const uint8_t *base = nullptr;
+  const uint32_t *offsets = nullptr;
+  size_t bytes = 0;
+  size_t rows = 0;
+
+  double number(uint32_t row) const {
+    switch (kind) {
+    case Kind::F64:
+      return reinterpret_cast<const double *>(base)[row];
+    case Kind::I32:
+      return reinterpret_cast<const int32_t *>(base)[row];
+    case Kind::U32:
+      return reinterpret_cast<const uint32_t *>(base)[row];
+    case Kind::String:
+      break;
+    }
+    return NAN;
+  }
+
+  /// String columns: the bytes of `row`, empty if its offsets are bad.
+  std::string_view text(uint32_t row) const {
+    uint32_t start = offsets[row], end = offsets[row + 1];
+    if (start > end || end > bytes)
+      return {};
+    return {reinterpret_cast<const char *>(base) + start, end - start};
+  }
+};
+
+/// -1, 0 or 1 as row `a` sorts before, with or after row `b`. NaNs sort
+/// after all numbers.
+int compare(const Column &col, uint32_t a, uint32_t b) {
+  if (col.kind == Kind::String) {
+    int c = col.text(a).compare(col.text(b));
+    return c < 0 ? -1 : c > 0;
+  }
+  double x = col.number(a), y = col.number(b);
+  if (x < y)
+    return -1;
+  if (x > y)
+    return 1;
+  bool nx = std::isnan(x), ny = std::isnan(y);
+  return nx == ny ? 0 : nx ? 1 : -1;
+}
+
+struct SortKey {
+  Column column;
+  bool descending = false;
+};
+
+/// Orders rows by the keys, then by row index, which makes the order total
+/// and the sort stable.
+struct RowLess {
+  const std::vector<SortKey> *keys;
+  bool operator()(uint32_t a, uint32_t b) const {
+    for (const SortKey &key : *keys) {
+      int c = compare(key.column, a, b);
+      if (c)
+        return key.descending ? c > 0 : c < 0;
+    }
+    return a < b;
+  }
+};
+
+/// The rows an operation runs over: `ids`, or 0 to `count` - 1 if null.
+struct RowSet {
+  Column ids;
+  bool all = true;
+  size_t count = 0;
+
+  uint32_t at(size_t i) const {
+    return all ? (uint32_t)i
+               : reinterpret_cast<const uint32_t *>(ids.base)[i];
+  }
+};
+
+enum class FilterOp {
+  Eq,
+  Ne,
+  Lt,
+  Le,
+  Gt,
+  Ge,
+  Between,
+  Contains,
+  StartsWith,
+  EndsWith,
+};
+
+enum class AggregateOp { Count, Sum, Min, Max, Mean };
+
+struct Aggregate {
+  AggregateOp op = AggregateOp::Count;
+  Column column;
+  bool hasColumn = false;
+};
+
+/// Per group and aggregate: the sum, count, min and max of its non-NaN
+/// values.
+struct Accumulator {
+  double sum = 0;
+  double min = INFINITY;
+  double max = -INFINITY;
+  size_t n = 0;
+
+  void add(double v) {
+    if (std::isnan(v))
+      return;
+    sum += v;
+    min = std::min(min, v);
+    max = std::max(max, v);
+    ++n;
+  }
+  void merge(const Accumulator &other) {
+    sum += other.sum;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+    n += other.n;
+  }
+};
+
+/// The groups of one chunk, in the order they first appear.
+struct Groups {
+  std::vector<uint32_t> first;
+  std::vector<uint32_t> count;
+  /// Group-major: group g's accumulators are [g * aggregates, ...).
+  std::vector<Accumulator> acc;
+  std::unordered_map<uint64_t, uint32_t> byNumber;
+  std::unordered_map<std::string_view, uint32_t> byText;
+};
+
+enum class Op { Sort, Resort, Filter, GroupBy };
+
+/// An operation in flight, shared by its chunks.
+struct Job {
+  Op op = Op::Sort;
+  RowSet rows;
+  /// Sort and resort.
+  std::vector<SortKey> keys;
+  Column order, changed;
+  /// Filter.
+  Column column;
+  FilterOp filterOp = FilterOp::Eq;
+  double value = 0, value2 = 0;
+  std::string text;
+  /// GroupBy: `column` is the key.
+  std::vector<Aggregate> aggregates;
+
+  /// Sort, resort and filter: the rows. Filter chunks fill `parts`.
+  std::vector<uint32_t> result;
+  std::vector<std::vector<uint32_t>> parts;
+  std::vector<size_t> bounds;
+  std::vector<Groups> groups;
+
+  std::shared_ptr<CancelToken> cancel = std::make_shared<CancelToken>();
+  std::atomic<size_t> remaining{0};
+  std::mutex errorMutex;
+  std::string error;
+
+  void fail(const std::string &message) {
+    std::lock_guard<std::mutex> lock(errorMutex);
+    if (error.empty())
+      error = message;
+  }
+};
+
+/// Check that the rows of chunk [lo, hi) exist in every column used.
+bool check_rows(Job &job, size_t lo, size_t hi, size_t limit) {
+  if (job.rows.all)
+    return true;
+  uint32_t max = 0;
+  for (size_t i = lo; i < hi; ++i)
+    max = std::max(max, job.rows.at(i));
+  if (hi > lo && max >= limit) {
+    job.fail("row index " + std::to_string(max) + " is out of range");
+    return false;
+  }
+  return true;
+}
+
+/// Rows in the columns of the job, which every index must be below.
+size_t column_rows(const Job &job) {
+  size_t rows = SIZE_MAX;
+  for (const SortKey &key : job.keys)
+    rows = std::min(rows, key.column.rows);
+  if (job.op == Op::Filter || job.op == Op::GroupBy)
+    rows = std::min(rows, job.column.rows);
+  for (const Aggregate &agg : job.aggregates) {
+    if (agg.hasColumn)
+      rows = std::min(rows, agg.column.rows);
+  }
+  return rows;
+}
+
+// Filter.
+
+template <typename Pred>
+void filter_numbers(const Job &job, size_t lo, size_t hi,
+                    std::vector<uint32_t> &out, Pred pred) {
+  out.resize(hi - lo);
+  size_t n = 0;
+  const Column &col = job.column;
+  // Branch-free compaction: every row is stored, and kept by advancing n
+  if (job.rows.all && col.kind == Kind::F64) {
+    const double *v = reinterpret_cast<const double *>(col.base);
+    for (size_t i = lo; i < hi; ++i) {
+      out[n] = (uint32_t)i;
+      n += pred(v[i]);
+    }
+  } else if (job.rows.all && col.kind == Kind::I32) {
+    const int32_t *v = reinterpret_cast<const int32_t *>(col.base);
+    for (size_t i = lo; i < hi; ++i) {
+      out[n] = (uint32_t)i;
+      n += pred((double)v[i]);
+    }
+  } else {
+    for (size_t i = lo; i < hi; ++i) {
+      uint32_t row = job.rows.at(i);
+      out[n] = row;
+      n += pred(col.number(row));
+    }
+  }
+  out.resize(n);
+}
+
+template <typename Pred>
+void filter_texts(const Job &job, size_t lo, size_t hi,
+                  std::vector<uint32_t> &out, Pred pred) {
+  for (size_t i = lo; i < hi; ++i) {
+    uint32_t row = job.rows.at(i);
+    if (pred(job.column.text(row)))
+      out.push_back(row);
+  }
+}
+
+void filter_chunk(Job &job, size_t lo, size_t hi, std::vector<uint32_t> &out) {
+  double a = job.value, b = job.value2;
+  if (job.column.kind != Kind::String) {
+    switch (job.filterOp) {
+    case FilterOp::Eq:
+      return filter_numbers(job, lo, hi, out, [a](double v) { return v == a; });
+    case FilterOp::Ne:
+      return filter_numbers(job, lo, hi, out, [a](double v) { return v != a; });
+    case FilterOp::Lt:
+      return filter_numbers(job, lo, hi, out, [a](double v) { return v < a; });
+    case FilterOp::Le:
+      return filter_numbers(job, lo, hi, out, [a](double v) { return v <= a; });
+    case FilterOp::Gt:
+      return filter_numbers(job, lo, hi, out, [a](double v) { return v > a; });
+    case FilterOp::Ge:
+      return filter_numbers(job, lo, hi, out, [a](double v) { return v >= a; });
+    case FilterOp::Between:
+      return filter_numbers(job, lo, hi, out,
+                            [a, b](double v) { return v >= a && v <= b; });
+    default:
+      job.fail("this filter needs a string column");
+      return;
+    }
+  }
+  std::string_view t = job.text;
+  switch (job.filterOp) {
+  case FilterOp::Eq:
+    return filter_texts(job, lo, hi, out,
+                        [t](std::string_view s) { return s == t; });
+  case FilterOp::Ne:
+    return filter_texts(job, lo, hi, out,
+                        [t](std::string_view s) { return s != t; });
+  case FilterOp::Contains:
+    return filter_texts(job, lo, hi, out, [t](std::string_view s) {
+      return s.find(t) != std::string_view::npos;
+    });
+  case FilterOp::StartsWith:
+    return filter_texts(job, lo, hi, out, [t](std::string_view s) {
+      return s.substr(0, t.size()) == t;
+    });
+  case FilterOp::EndsWith:
+    return filter_texts(job, lo, hi, out, [t](std::string_view s) {
+      return s.size() >= t.size() && s.substr(s.size() - t.size()) == t;
+    });
+  default:
+    job.fail("this filter needs a number column");
+    return;
+  }
+}
+
+// GroupBy.
+
+/// A numeric key: its bits, with -0 and all NaNs folded.
+uint64_t number_key(double v) {
+  if (v == 0)
+    v = 0;
+  if (std::isnan(v))
+    v = NAN;
+  uint64_t bits;
+  memcpy(&bits, &v, sizeof bits);
+  return bits;
+}
+
+/// The group of `row` in `groups`, added if new; whether it was added.
+std::pair<uint32_t, bool> find_group(const Job &job, Groups &groups,
+                                     uint32_t row) {
+  auto id = (uint32_t)groups.first.size();
+  std::pair<uint32_t, bool> found;
+  if (job.column.kind == Kind::String) {
+    auto it = groups.byText.emplace(job.column.text(row), id);
+    found = {it.first->second, it.second};
+  } else {
+    auto it = groups.byNumber.emplace(number_key(job.column.number(row)), id);
+    found = {it.first->second, it.second};
+  }
+  if (found.second) {
+    groups.first.push_back(row);
+    groups.count.push_back(0);
+    groups.acc.resize(groups.acc.size() + job.aggregates.size());
+  }
+  return found;
+}
+
+void group_chunk(Job &job, size_t lo, size_t hi, Groups &groups) {
+  size_t naggs = job.aggregates.size();
+  for (size_t i = lo; i < hi; ++i) {
+    uint32_t row = job.rows.at(i);
+    uint32_t group = find_group(job, groups, row).first;
+    ++groups.count[group];
+    Accumulator *acc = &groups.acc[(size_t)group * naggs];
+    for (size_t k = 0; k < naggs; ++k) {
+      if (job.aggregates[k].hasColumn)
+        acc[k].add(job.aggregates[k].column.number(row));
+    }
+  }
+}
+
+/// Merge the groups of the later chunks into the first one's, keeping the
+/// order of first appearance.
+void merge_groups(Job &job) {
+  size_t naggs = job.aggregates.size();
+  Groups &all = job.groups[0];
+  for (size_t c = 1; c < job.groups.size(); ++c) {
+    Groups &part = job.groups[c];
+    for (size_t g = 0; g < part.first.size(); ++g) {
+      uint32_t group = find_group(job, all, part.first[g]).first;
+      all.count[group] += part.count[g];
+      for (size_t k = 0; k < naggs; ++k)
+        all.acc[(size_t)group * naggs + k].merge(part.acc[g * naggs + k]);
+    }
+    part = Groups();
+  }
+}
+
+// Running.
+
+/// Split `count` items into chunks for the pool.
+std::vector<size_t> chunk_bounds(size_t count, unsigned threads) {
+  size_t chunks = std::max<size_t>(
+      1, std::min<size_t>(threads, count / kMinChunkRows));
+  std::vector<size_t> bounds;
+  for (size_t i = 0; i <= chunks; ++i)
+    bounds.push_back(count * i / chunks);
+  return bounds;
+}
+
+/// Run `work(i)` for chunk i of the job on the pool, then `done()` on the
+/// thread of the last chunk to finish. Chunks that start after the job was
+/// cancelled are skipped.
+void run_chunks(ThreadPool &pool, const std::shared_ptr<Job> &job,
+                std::function<void(Job &, size_t)> work,
+                std::function<void()> done) {
+  size_t chunks = job->bounds.size() - 1;
+  job->remaining = chunks;
+  TaskOptions options;
+  options.priority = TaskPriority::Interactive;
+  options.traceName = TraceTaskTable;
+  options.cancel = job->cancel;
+  for (size_t i = 0; i < chunks; ++i) {
+    pool.post(
+        [job, i, work, done] {
+          try {
+            if (ThreadPool::cancelled())
+              job->fail("cancelled");
+            else
+              work(*job, i);
+          } catch (const std::exception &e) {
+            job->fail(e.what());
+          }
+          if (job->remaining.fetch_sub(1) == 1)
+            done();
+        },
+        options);
+  }
+}
+
+/// Merge the sorted runs of `job.result` between `job.bounds` pairwise.
+void merge_runs(Job &job, const RowLess &less) {
+  std::vector<size_t> bounds = job.bounds;
+  while (bounds.size() > 2) {
+    std::vector<size_t> merged;
+    for (size_t i = 0; i + 2 < bounds.size(); i += 2) {
+      std::inplace_merge(job.result.begin() + bounds[i],
+                         job.result.begin() + bounds[i + 1],
+                         job.result.begin() + bounds[i + 2], less);
+      merged.push_back(bounds[i]);
+    }
+    if (bounds.size() % 2 == 0)
+      merged.push_back(bounds[bounds.size() - 2]);
+    merged.push_back(bounds.back());
+    bounds = std::move(merged);
+  }
+}
+
+/// Incremental sort: `order` was sorted before the `changed` rows changed.
+/// Takes those out, sorts them and merges them back, in O(n + k log k).
+void resort(Job &job) {
+  size_t limit = column_rows(job);
+  const uint32_t *order = reinterpret_cast<const uint32_t *>(job.order.base);
+  const uint32_t *changed =
+      reinterpret_cast<const uint32_t *>(job.changed.base);
+  std::vector<uint8_t> isChanged(limit, 0);
+  std::vector<uint32_t> moved;
+  for (size_t i = 0; i < job.changed.rows; ++i) {
+    uint32_t row = changed[i];
+    if (row >= limit) {
+      job.fail("row index " + std::to_string(row) + " is out of range");
+      return;
+    }
+    if (!isChanged[row]) {
+      isChanged[row] = 1;
+      moved.push_back(row);
+    }
+  }
+  std::vector<uint32_t> kept;
+  kept.reserve(job.order.rows);
+  for (size_t i = 0; i < job.order.rows; ++i) {
+    uint32_t row = order[i];
+    if (row >= limit) {
+      job.fail("row index " + std::to_string(row) + " is out of range");
+      return;
+    }
+    if (!isChanged[row])
+      kept.push_back(row);
+  }
+  RowLess less{&job.keys};
+  std::sort(moved.begin(), moved.end(), less);
+  job.result.resize(kept.size() + moved.size());
+  std::merge(kept.begin(), kept.end(), moved.begin(), moved.end(),
+             job.result.begin(), less);
+}
+
+// JS.
+
+Kind parse_kind(facebook::jsi::Runtime &rt, const std::string &name) {
+  if (name == "f64")
+    return Kind::F64;
+  if (name == "i32")
+    return Kind::I32;
+  if (name == "u32")
+    return Kind::U32;
+  if (name == "string")
+    return Kind::String;
+  throw facebook::jsi::JSError(rt, "tableOps: unknown column kind " + name);
+}
+
+size_t kind_size(Kind kind) { return kind == Kind::F64 ? 8 : 4; }
+
+/// `view` of `obj`, an ArrayBuffer, checked to hold `bytes` from `offset`.
+std::shared_ptr<facebook::jsi::MutableBuffer>
+read_buffer(facebook::jsi::Runtime &rt, const facebook::jsi::Object &obj,
+            const char *name, double offset, double bytes) {
+  facebook::jsi::Value value = obj.getProperty(rt, name);
+  if (!value.isObject() || !value.getObject(rt).isArrayBuffer(rt))
+    throw facebook::jsi::JSError(rt, std::string("tableOps: ") + name +
+                                         " must be an ArrayBuffer");
+  facebook::jsi::ArrayBuffer ab = value.getObject(rt).getArrayBuffer(rt);
+  if (!(offset >= 0) || !(bytes >= 0) || offset + bytes > ab.size(rt))
+    throw facebook::jsi::JSError(rt, "tableOps: column out of its buffer");
+  return borrow_buffer(rt, ab);
+}
+
+double number_property(facebook::jsi::Runtime &rt,
+                       const facebook::jsi::Object &obj, const char *name) {
+  facebook::jsi::Value value = obj.getProperty(rt, name);
+  return value.isNumber() ? value.getNumber() : 0;
+}
+
+Column read_column(facebook::jsi::Runtime &rt, const facebook::jsi::Value &v) {
+  if (!v.isObject())
+    throw facebook::jsi::JSError(rt, "tableOps: expected a column");
+  facebook::jsi::Object obj = v.getObject(rt);
+  Column col;
+  col.kind = parse_kind(
+      rt, obj.getProperty(rt, "kind").asString(rt).utf8(rt));
+  col.rows = (size_t)number_property(rt, obj, "rows");
+  if (col.kind == Kind::String) {
+    double offsetsOffset = number_property(rt, obj, "offsetsOffset");
+    col.offsetsData = read_buffer(rt, obj, "offsets", offsetsOffset,
+                                  ((double)col.rows + 1) * 4);
+    col.offsets = reinterpret_cast<const uint32_t *>(
+        col.offsetsData->data() + (size_t)offsetsOffset);
+    double offset = number_property(rt, obj, "offset");
+    double bytes = number_property(rt, obj, "bytes");
+    col.data = read_buffer(rt, obj, "data", offset, bytes);
+    col.base = col.data->data() + (size_t)offset;
+    col.bytes = (size_t)bytes;
+  } else {
+    double offset = number_property(rt, obj, "offset");
+    col.data = read_buffer(rt, obj, "data", offset,
+                           (double)col.rows * kind_size(col.kind));
+    col.base = col.data->data() + (size_t)offset;
+  }
+  return col;
+}
+
+std::vector<SortKey> read_keys(facebook::jsi::Runtime &rt,
+                               const facebook::jsi::Object &args) {
+  facebook::jsi::Array list =
+      args.getProperty(rt, "keys").asObject(rt).getArray(rt);
+  std::vector<SortKey> keys;
+  for (size_t i = 0; i < list.size(rt); ++i) {
+    facebook::jsi::Object spec = list.getValueAtIndex(rt, i).asObject(rt);
+    SortKey key;
+    key.column = read_column(rt, spec.getProperty(rt, "column"));
+    facebook::jsi::Value desc = spec.getProperty(rt, "descending");
+    key.descending = desc.isBool() && desc.getBool();
+    keys.push_back(std::move(key));
+  }
+  if (keys.empty())
+    throw facebook::jsi::JSError(rt, "tableOps.sort: no keys");
+  return keys;
+}
+
+FilterOp parse_filter_op(facebook::jsi::Runtime &rt, const std::string &op) {
+  static const std::pair<const char *, FilterOp> kOps[] = {
+      {"==", FilterOp::Eq},
+      {"!=", FilterOp::Ne},
+      {"<", FilterOp::Lt},
+      {"<=", FilterOp::Le},
+      {">", FilterOp::Gt},
+      {">=", FilterOp::Ge},
+      {"between", FilterOp::Between},
+      {"contains", FilterOp::Contains},
+      {"startsWith", FilterOp::StartsWith},
+      {"endsWith", FilterOp::EndsWith},
+  };
+  for (const auto &entry : kOps) {
+    if (op == entry.first)
+      return entry.second;
+  }
+  throw facebook::jsi::JSError(rt, "tableOps.filter: unknown operator " + op);
+}
+
+AggregateOp parse_aggregate_op(facebook::jsi::Runtime &rt,
+                               const std::string &op) {
+  if (op == "count")
+    return AggregateOp::Count;
+  if (op == "sum")
+    return AggregateOp::Sum;
+  if (op == "min")
+    return AggregateOp::Min;
+  if (op == "max")
+    return AggregateOp::Max;
+  if (op == "mean")
+    return AggregateOp::Mean;
+  throw facebook::jsi::JSError(rt, "tableOps.groupBy: unknown aggregate " + op);
+}
+
+/// Read the arguments of `op` from `args` into a job.
+std::shared_ptr<Job> read_job(facebook::jsi::Runtime &rt, Op op,
+                              const facebook::jsi::Object &args) {
+  auto job = std::make_shared<Job>();
+  job->op = op;
+  facebook::jsi::Value indices = args.getProperty(rt, "indices");
+  if (!indices.isUndefined() && !indices.isNull()) {
+    job->rows.ids = read_column(rt, indices);
+    job->rows.all = false;
+    job->rows.count = job->rows.ids.rows;
+  }
+  switch (op) {
+  case Op::Sort:
+  case Op::Resort:
+    job->keys = read_keys(rt, args);
+    if (op == Op::Resort) {
+      job->order = read_column(rt, args.getProperty(rt, "order"));
+      job->changed = read_column(rt, args.getProperty(rt, "changed"));
+    }
+    break;
+  case Op::Filter: {
+    job->column = read_column(rt, args.getProperty(rt, "column"));
+    job->filterOp =
+        parse_filter_op(rt, args.getProperty(rt, "op").asString(rt).utf8(rt));
+    facebook::jsi::Value value = args.getProperty(rt, "value");
+    if (value.isString())
+      job->text = value.getString(rt).utf8(rt);
+    else if (value.isNumber())
+      job->value = value.getNumber();
+    job->value2 = number_property(rt, args, "value2");
+    break;
+  }
+  case Op::GroupBy: {
+    job->column = read_column(rt, args.getProperty(rt, "key"));
+    facebook::jsi::Array list =
+        args.getProperty(rt, "aggregates").asObject(rt).getArray(rt);
+    for (size_t i = 0; i < list.size(rt); ++i) {
+      facebook::jsi::Object spec = list.getValueAtIndex(rt, i).asObject(rt);
+      Aggregate agg;
+      agg.op = parse_aggregate_op(
+          rt, spec.getProperty(rt, "op").asString(rt).utf8(rt));
+      facebook::jsi::Value column = spec.getProperty(rt, "column");
+      if (!column.isUndefined() && !column.isNull()) {
+        agg.column = read_column(rt, column);
+        agg.hasColumn = true;
+        if (agg.column.kind == Kind::String)
+          throw facebook::jsi::JSError(
+              rt, "tableOps.groupBy: aggregates need number columns");
+      } else if (agg.op != AggregateOp::Count) {
+        throw facebook::jsi::JSError(
+            rt, "tableOps.groupBy: this aggregate needs a column");
+      }
+      job->aggregates.push_back(std::move(agg));
+    }
+    break;
+  }
+  }
+  if (job->rows.all) {
+    size_t rows = column_rows(*job);
+    job->rows.count = op == Op::Resort ? 0 : rows;
+  }
+  return job;
+}
+
+template <typename T>
+facebook::jsi::ArrayBuffer to_array_buffer(facebook::jsi::Runtime &rt,
+                                           std::vector<T> &&items) {
+  auto buffer = std::make_shared<VectorBuffer<T>>(std::move(items));
+  register_transferable_buffer(buffer, false);
+  return facebook::jsi::ArrayBuffer(rt, std::move(buffer));
+}
+
+facebook::jsi::Value group_result(facebook::jsi::Runtime &rt, Job &job) {
+  Groups &groups = job.groups[0];
+  size_t count = groups.first.size(), naggs = job.aggregates.size();
+  facebook::jsi::Array values(rt, naggs);
+  for (size_t k = 0; k < naggs; ++k) {
+    std::vector<double> out(count);
+    for (size_t g = 0; g < count; ++g) {
+      const Accumulator &acc = groups.acc[g * naggs + k];
+      switch (job.aggregates[k].op) {
+      case AggregateOp::Count:
+        out[g] = job.aggregates[k].hasColumn ? (double)acc.n : groups.count[g];
+        break;
+      case AggregateOp::Sum:
+        out[g] = acc.sum;
+        break;
+      case AggregateOp::Min:
+        out[g] = acc.n ? acc.min : NAN;
+        break;
+      case AggregateOp::Max:
+        out[g] = acc.n ? acc.max : NAN;
+        break;
+      case AggregateOp::Mean:
+        out[g] = acc.n ? acc.sum / acc.n : NAN;
+        break;
+      }
+    }
+    values.setValueAtIndex(rt, k, to_array_buffer(rt, std::move(out)));
+  }
+  facebook::jsi::Object result(rt);
+  result.setProperty(rt, "first", to_array_buffer(rt, std::move(groups.first)));
+  result.setProperty(rt, "count", to_array_buffer(rt, std::move(groups.count)));
+  result.setProperty(rt, "values", values);
+  return result;
+}
+
+/// Callbacks of the operations in flight, by request ID. Main thread only.
+std::unordered_map<unsigned, facebook::jsi::Function> s_callbacks{};
+unsigned s_next_request = 1;
+
+void complete(facebook::jsi::Runtime &rt, unsigned id, Job &job) {
+  auto it = s_callbacks.find(id);
+  if (it == s_callbacks.end())
+    return;
+  facebook::jsi::Function callback = std::move(it->second);
+  s_callbacks.erase(it);
+  if (!job.error.empty()) {
+    callback.call(rt, "tableOps: " + job.error);
+    return;
+  }
+  facebook::jsi::Value result = job.op == Op::GroupBy
+                                    ? group_result(rt, job)
+                                    : facebook::jsi::Value(to_array_buffer(
+                                          rt, std::move(job.result)));
+  callback.call(rt, facebook::jsi::Value::null(), result);
+}
+
+void start(ThreadPool &pool, MainThreadPoster postToMain,
+           facebook::jsi::Runtime *rtp, unsigned id,
+           const std::shared_ptr<Job> &job) {
+  auto finish = [postToMain, rtp, id, job] {
+    postToMain([rtp, id, job] { complete(*rtp, id, *job); });
+  };
+  size_t limit = column_rows(*job);
+  job->bounds = chunk_bounds(job->rows.count, pool.size());
+  switch (job->op) {
+  case Op::Sort:
+    job->result.resize(job->rows.count);
+    run_chunks(
+        pool, job,
+        [limit](Job &job, size_t c) {
+          size_t lo = job.bounds[c], hi = job.bounds[c + 1];
+          if (!check_rows(job, lo, hi, limit))
+            return;
+          for (size_t i = lo; i < hi; ++i)
+            job.result[i] = job.rows.at(i);
+          std::sort(job.result.begin() + lo, job.result.begin() + hi,
+                    RowLess{&job.keys});
+        },
+        [job, finish] {
+          if (job->error.empty())
+            merge_runs(*job, RowLess{&job->keys});
+          finish();
+        });
+    break;
+  case Op::Resort:
+    job->bounds = {0, 1};
+    run_chunks(
+        pool, job, [](Job &job, size_t) { resort(job); }, finish);
+    break;
+  case Op::Filter:
+    job->parts.resize(job->bounds.size() - 1);
+    run_chunks(
+        pool, job,
+        [limit](Job &job, size_t c) {
+          size_t lo = job.bounds[c], hi = job.bounds[c + 1];
+          if (check_rows(job, lo, hi, limit))
+            filter_chunk(job, lo, hi, job.parts[c]);
+        },
+        [job, finish] {
+          size_t total = 0;
+          for (auto &part : job->parts)
+            total += part.size();
+          job->result.reserve(total);
+          for (auto &part : job->parts) {
+            job->result.insert(job->result.end(), part.begin(), part.end());
+            part = std::vector<uint32_t>();
+          }
+          finish();
+        });
+    break;
+  case Op::GroupBy:
+    job->groups.resize(job->bounds.size() - 1);
+    run_chunks(
+        pool, job,
+        [limit](Job &job, size_t c) {
+          size_t lo = job.bounds[c], hi = job.bounds[c + 1];
+          if (check_rows(job, lo, hi, limit))
+            group_chunk(job, lo, hi, job.groups[c]);
+        },
+        [job, finish] {
+          if (job->error.empty())
+            merge_groups(*job);
+          finish();
+        });
+    break;
+  }
+}
+
+} // namespace
+
+void install_table_kernels(facebook::jsi::Runtime &rt, ThreadPool &pool,
+                           MainThreadPoster postToMain) {
+  rt.global().setProperty(
+      rt, "__tableOp",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__tableOp"), 3,
+          [&pool, postToMain](facebook::jsi::Runtime &rt,
+                              const facebook::jsi::Value &,
+                              const facebook::jsi::Value *args,
+                              size_t count) -> facebook::jsi::Value {
+            if (count < 3 || !args[0].isString() || !args[1].isObject() ||
+                !args[2].isObject() || !args[2].getObject(rt).isFunction(rt)) {
+              throw facebook::jsi::JSError(
+                  rt, "__tableOp expects an operation, its arguments and a "
+                      "callback");
+            }
+            std::string name = args[0].getString(rt).utf8(rt);
+            Op op;
+            if (name == "sort")
+              op = Op::Sort;
+            else if (name == "resort")
+              op = Op::Resort;
+            else if (name == "filter")
+              op = Op::Filter;
+            else if (name == "groupBy")
+              op = Op::GroupBy;
+            else
+              throw facebook::jsi::JSError(
+                  rt, "__tableOp: unknown operation " + name);
+            std::shared_ptr<Job> job = read_job(rt, op, args[1].getObject(rt));
+
+            unsigned id = s_next_request++;
+            s_callbacks.emplace(id, args[2].getObject(rt).getFunction(rt));
+            start(pool, postToMain, &rt, id, job);
+            return (double)register_cancel_token(job->cancel);
+          }));
+}
+
+void shutdown_table_kernels() { s_callbacks.clear(); }
@@ -0,0 +1,26 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include "AsyncFs.h"
+
+#include <hermes/hermes.h>
+
+/// Install the __tableOp(op, args, callback) host function behind jslib's
+/// tableOps: sort, resort, filter and groupBy over columns (Float64Array,
+/// Int32Array and parseColumns() string columns, described by jslib as
+/// { kind, data, offset, rows } objects). The work is split into chunks that
+/// run in parallel on `pool`; the last chunk to finish merges them and
+/// `postToMain` brings the result back to the main thread, where
+/// `callback(message, result)` is called. Columns from native memory
+/// (parseColumns(), shared buffers) are read in place, others are copied.
+/// The chunks run at Interactive priority. Returns the operation's
+/// __cancelTask() ID.
+void install_table_kernels(facebook::jsi::Runtime &rt, ThreadPool &pool,
+                           MainThreadPoster postToMain);
+
+/// Forget the callbacks of the operations in flight (see "Shutdown order"
+/// in ThreadPool.h).
+void shutdown_table_kernels();
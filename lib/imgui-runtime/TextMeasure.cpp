@@ -0,0 +1,109 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "TextMeasure.h"
+
+#include "imgui/imgui.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Entry {
+  uint64_t hash = 0;
+  ImFont *font = nullptr;
+  float fontSize = 0;
+  float wrapWidth = 0;
+  bool hide = false;
+  bool used = false;
+  std::string text;
+  ImVec2 size;
+};
+
+/// Open addressing with linear probing. When it is 3/4 full it is cleared
+/// rather than grown: the labels of a UI are few and stable, so this is
+/// only reached by text that changes every frame, which wouldn't hit anyway.
+constexpr size_t kCapacity = 4096;
+std::vector<Entry> s_entries;
+size_t s_count = 0;
+
+/// Bumped by text_measure_invalidate(); the cache is cleared when it moves.
+std::atomic<unsigned> s_generation{0};
+unsigned s_seen_generation = 0;
+
+void clear() {
+  for (Entry &e : s_entries) {
+    e.used = false;
+    e.text.clear();
+  }
+  s_count = 0;
+}
+
+/// FNV-1a, 64-bit.
+uint64_t hash_text(const char *text, size_t length) {
+  uint64_t h = 14695981039346656037ull;
+  for (size_t i = 0; i < length; ++i) {
+    h ^= (uint8_t)text[i];
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+} // namespace
+
+extern "C" void imgui_text_size(ImVec2 *out, const char *text,
+                                const char *textEnd, bool hideAfterDoubleHash,
+                                float wrapWidth) {
+  if (s_entries.empty())
+    s_entries.resize(kCapacity);
+  unsigned generation = s_generation.load(std::memory_order_acquire);
+  if (generation != s_seen_generation) {
+    s_seen_generation = generation;
+    clear();
+  }
+
+  size_t length = textEnd ? (size_t)(textEnd - text) : strlen(text);
+  ImFont *font = ImGui::GetFont();
+  float fontSize = ImGui::GetFontSize();
+  uint64_t hash = hash_text(text, length);
+  size_t mask = kCapacity - 1;
+  size_t i = (size_t)(hash ^ (hash >> 32)) & mask;
+  for (;; i = (i + 1) & mask) {
+    Entry &e = s_entries[i];
+    if (!e.used)
+      break;
+    if (e.hash == hash && e.font == font && e.fontSize == fontSize &&
+        e.wrapWidth == wrapWidth && e.hide == hideAfterDoubleHash &&
+        e.text.size() == length && memcmp(e.text.data(), text, length) == 0) {
+      *out = e.size;
+      return;
+    }
+  }
+
+  ImVec2 size = ImGui::CalcTextSize(text, text + length, hideAfterDoubleHash,
+                                    wrapWidth);
+  *out = size;
+  if (s_count + 1 > kCapacity / 4 * 3) {
+    clear();
+    i = (size_t)(hash ^ (hash >> 32)) & mask;
+  }
+  Entry &e = s_entries[i];
+  e.hash = hash;
+  e.font = font;
+  e.fontSize = fontSize;
+  e.wrapWidth = wrapWidth;
+  e.hide = hideAfterDoubleHash;
+  e.used = true;
+  e.text.assign(text, length);
+  e.size = size;
+  ++s_count;
+}
+
+void text_measure_invalidate() {
+  s_generation.fetch_add(1, std::memory_order_release);
+}
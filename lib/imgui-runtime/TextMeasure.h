@@ -0,0 +1,23 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+struct ImVec2;
+
+/// Cache of ImGui text measurements, for widgets that center or lay out the
+/// same labels every frame. Results are keyed by the current font, the font
+/// size, the text and the wrap width, and dropped when the font atlas is
+/// rebuilt. JS thread (the thread running ImGui frames).
+
+/// igCalcTextSize() through the cache: the size of [text, textEnd) (to the
+/// NUL if `textEnd` is null) in the current font. FFI entry point for the
+/// typed imgui unit.
+extern "C" void imgui_text_size(ImVec2 *out, const char *text,
+                                const char *textEnd, bool hideAfterDoubleHash,
+                                float wrapWidth);
+
+/// Drop every cached size. Called when the font atlas is (re)built; safe to
+/// call from any thread.
+void text_measure_invalidate();
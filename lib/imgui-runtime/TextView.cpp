@@ -0,0 +1,466 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "TextView.h"
+
+#include "FileWatcher.h"
+#include "GlyphCache.h"
+#include "MappedFileBuffer.h"
+#include "SharedBuffer.h"
+#include "ThreadPool.h"
+#include "imgui-runtime.h"
+
+#include "imgui/imgui.h"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+/// The start of every kCheckpointLines-th line is kept; the lines between
+/// two checkpoints are found by scanning from the first. A file of 50M
+/// lines then takes 6 MB of index instead of 400 MB.
+constexpr uint64_t kCheckpointLines = 64;
+/// Bytes indexed by one pool job, so that a huge file doesn't hold a worker
+/// for long and a closed view stops soon.
+constexpr size_t kIndexChunk = 16 * 1024 * 1024;
+/// Lines __tailLines() returns at most per call.
+constexpr double kMaxTailLines = 100000;
+
+struct TextView {
+  /// The file; empty for a buffer.
+  std::string path;
+  bool follow = false;
+  /// The handle, and whether the view is a tail whose growth is posted to
+  /// its JS callback.
+  int handle = -1;
+  bool tail = false;
+  std::shared_ptr<CancelToken> cancel = std::make_shared<CancelToken>();
+  /// Whether a job maps or indexes the view. Only that job changes the
+  /// data and the index, and no other job is posted meanwhile.
+  std::atomic<bool> busy{false};
+  /// The followed file changed since the job started mapping it.
+  std::atomic<bool> stale{false};
+  /// A tail's delivery is posted and hasn't run yet.
+  std::atomic<bool> deliveryPosted{false};
+  /// The FileWatcher watch of a followed file.
+  unsigned watch = 0;
+
+  /// Guards the fields below, which the job publishes and the main thread
+  /// draws from.
+  std::mutex mutex;
+  /// Keeps the mapping or the shared buffer alive.
+  std::shared_ptr<void> owner;
+  const char *data = nullptr;
+  size_t size = 0;
+  /// Bytes of `data` indexed so far.
+  size_t indexed = 0;
+  /// Newlines in the indexed bytes, and the start of the line after the
+  /// last one.
+  uint64_t newlines = 0;
+  size_t lastLineStart = 0;
+  /// The start of line k * kCheckpointLines, for every k.
+  std::vector<size_t> checkpoints{0};
+  std::string error;
+};
+
+ThreadPool *s_pool = nullptr;
+std::atomic<MainThreadPoster> s_post_to_main{nullptr};
+facebook::jsi::Runtime *s_runtime = nullptr;
+/// Open views by handle; closed handles are reused. Main thread only.
+std::vector<std::shared_ptr<TextView>> s_views{};
+/// The callbacks of the tails opened by fs.watchTail(), by handle. Main
+/// thread only.
+std::unordered_map<int, facebook::jsi::Function> s_tail_callbacks{};
+
+TextView *find_view(int view) {
+  if (view < 0 || (size_t)view >= s_views.size())
+    return nullptr;
+  return s_views[view].get();
+}
+
+int add_view(std::shared_ptr<TextView> view) {
+  for (size_t i = 0; i < s_views.size(); ++i) {
+    if (!s_views[i]) {
+      view->handle = (int)i;
+      s_views[i] = std::move(view);
+      return (int)i;
+    }
+  }
+  view->handle = (int)s_views.size();
+  s_views.push_back(std::move(view));
+  return (int)s_views.size() - 1;
+}
+
+/// Lines indexed so far; a last line without a newline counts. Holds the
+/// view's lock.
+uint64_t line_count(const TextView &view) {
+  return view.newlines + (view.indexed > view.lastLineStart ? 1 : 0);
+}
+
+/// Map the view's file again, for its first index or once it changed size.
+/// A file that shrank was replaced or truncated and is indexed again from
+/// the start. Returns false, with the error set, if it can't be read.
+bool remap(TextView &view) {
+  struct stat st;
+  bool found = stat(view.path.c_str(), &st) == 0;
+  std::shared_ptr<facebook::jsi::Buffer> file;
+  // An empty file can't be mapped, and has no lines yet
+  if (found && st.st_size > 0) {
+    try {
+      MapFileOptions options;
+      options.sequential = true;
+      file = mapFileBuffer(view.path.c_str(), false, &options);
+    } catch (const std::exception &) {
+    }
+  }
+  std::lock_guard<std::mutex> lock(view.mutex);
+  if (!found || (st.st_size > 0 && !file)) {
+    view.error = "can't open file '" + view.path + "'";
+    return false;
+  }
+  view.error.clear();
+  size_t size = file ? file->size() : 0;
+  if (size < view.indexed) {
+    view.indexed = 0;
+    view.newlines = 0;
+    view.lastLineStart = 0;
+    view.checkpoints.assign(1, 0);
+  }
+  view.data = file ? reinterpret_cast<const char *>(file->data()) : nullptr;
+  view.size = size;
+  view.owner = std::move(file);
+  return true;
+}
+
+void post_remap(const std::shared_ptr<TextView> &view);
+void deliver_tail(const std::shared_ptr<TextView> &view);
+
+/// Let the file's watcher post the next job, or post it now if the file
+/// changed while this one ran.
+void finish_job(const std::shared_ptr<TextView> &view) {
+  view->busy = false;
+  if (view->stale && !view->cancel->cancelled() && !view->busy.exchange(true))
+    post_remap(view);
+}
+
+/// The followed file changed: map and index it again, now or once the job
+/// in flight is done. Called on the watcher thread.
+void file_changed(const std::shared_ptr<TextView> &view) {
+  view->stale = true;
+  if (!view->cancel->cancelled() && !view->busy.exchange(true))
+    post_remap(view);
+}
+
+/// Tell a tail's callback that lines were indexed, once per batch.
+void post_tail_delivery(const std::shared_ptr<TextView> &view) {
+  if (!view->tail || view->deliveryPosted.exchange(true))
+    return;
+  if (MainThreadPoster post = s_post_to_main.load(std::memory_order_acquire))
+    post([view] { deliver_tail(view); });
+}
+
+/// Index the next chunk of the view, then post the one after it.
+void index_chunk(const std::shared_ptr<TextView> &view) {
+  if (view->cancel->cancelled()) {
+    view->busy = false;
+    return;
+  }
+  // Only this job changes the data, so it reads it without the lock
+  const char *data = view->data;
+  size_t start = view->indexed;
+  size_t end = std::min(view->size, start + kIndexChunk);
+  uint64_t newlines = view->newlines;
+  size_t lastLineStart = view->lastLineStart;
+  std::vector<size_t> checkpoints;
+  for (const char *p = data + start, *stop = data + end; p < stop;) {
+    p = static_cast<const char *>(memchr(p, '\n', stop - p));
+    if (!p)
+      break;
+    ++p;
+    lastLineStart = p - data;
+    if (++newlines % kCheckpointLines == 0)
+      checkpoints.push_back(lastLineStart);
+  }
+  {
+    std::lock_guard<std::mutex> lock(view->mutex);
+    view->indexed = end;
+    view->newlines = newlines;
+    view->lastLineStart = lastLineStart;
+    view->checkpoints.insert(view->checkpoints.end(), checkpoints.begin(),
+                             checkpoints.end());
+  }
+  imgui_wake_main_loop();
+  post_tail_delivery(view);
+
+  if (end < view->size) {
+    s_pool->post([view] { index_chunk(view); },
+                 {TaskPriority::Background, TraceTaskTextIndex, view->cancel});
+  } else {
+    finish_job(view);
+  }
+}
+
+/// Map the file of `view` (again) and index what is new, on the pool. The
+/// caller has set `busy`.
+void post_remap(const std::shared_ptr<TextView> &view) {
+  s_pool->post(
+      [view] {
+        view->stale = false;
+        if (view->cancel->cancelled()) {
+          view->busy = false;
+          return;
+        }
+        if (!remap(*view)) {
+          post_tail_delivery(view);
+          finish_job(view);
+          return;
+        }
+        index_chunk(view);
+      },
+      {TaskPriority::Background, TraceTaskTextIndex, view->cancel});
+}
+
+/// Close a view; its indexing stops after the current chunk.
+void close_view(int handle) {
+  TextView &view = *s_views[handle];
+  if (view.watch)
+    unwatch_file(view.watch);
+  // A job in flight holds the view until it sees the cancellation
+  view.cancel->cancel();
+  s_views[handle].reset();
+  s_tail_callbacks.erase(handle);
+}
+
+/// Open a followed view of the file at `path`.
+int open_file_view(const char *path, bool follow, bool tail) {
+  auto view = std::make_shared<TextView>();
+  view->path = path;
+  view->follow = follow;
+  view->tail = tail;
+  view->busy = true;
+  post_remap(view);
+  if (follow)
+    view->watch = watch_file(view->path, [view] { file_changed(view); });
+  return add_view(std::move(view));
+}
+
+/// The start of line `line` of the indexed bytes. Holds the view's lock.
+const char *line_start(const TextView &view, uint64_t line) {
+  const char *p = view.data + view.checkpoints[line / kCheckpointLines];
+  const char *end = view.data + view.indexed;
+  for (uint64_t i = line % kCheckpointLines; i; --i)
+    p = static_cast<const char *>(memchr(p, '\n', end - p)) + 1;
+  return p;
+}
+
+/// Main thread: pass a tail's size and line count to its callback.
+void deliver_tail(const std::shared_ptr<TextView> &view) {
+  view->deliveryPosted = false;
+  if (view->cancel->cancelled() || !s_runtime)
+    return;
+  auto it = s_tail_callbacks.find(view->handle);
+  if (it == s_tail_callbacks.end())
+    return;
+  facebook::jsi::Runtime &rt = *s_runtime;
+  double size, lines;
+  facebook::jsi::Value message = facebook::jsi::Value::null();
+  {
+    std::lock_guard<std::mutex> lock(view->mutex);
+    size = (double)view->indexed;
+    lines = (double)line_count(*view);
+    if (!view->error.empty())
+      message = facebook::jsi::String::createFromUtf8(rt, view->error);
+  }
+  // The callback may close the tail, which erases it
+  facebook::jsi::Value fn(rt, it->second);
+  fn.getObject(rt).getFunction(rt).call(rt, message, size, lines);
+}
+
+int view_arg(const facebook::jsi::Value *args, size_t count) {
+  if (count < 1 || !args[0].isNumber())
+    return -1;
+  int view = (int)args[0].getNumber();
+  return find_view(view) ? view : -1;
+}
+
+} // namespace
+
+void install_text_views(facebook::jsi::Runtime &rt, ThreadPool &pool,
+                        MainThreadPoster postToMain) {
+  s_pool = &pool;
+  s_runtime = &rt;
+  s_post_to_main.store(postToMain, std::memory_order_release);
+
+  rt.global().setProperty(
+      rt, "__tailOpen",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__tailOpen"), 2,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count < 2 || !args[0].isString() || !args[1].isObject() ||
+                !args[1].getObject(rt).isFunction(rt))
+              throw facebook::jsi::JSError(
+                  rt, "__tailOpen expects a path and a callback");
+            std::string path = args[0].getString(rt).utf8(rt);
+            int view = open_file_view(path.c_str(), true, true);
+            s_tail_callbacks.emplace(view,
+                                     args[1].getObject(rt).getFunction(rt));
+            return (double)view;
+          }));
+
+  rt.global().setProperty(
+      rt, "__tailLines",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__tailLines"), 3,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            int handle = view_arg(args, count);
+            if (handle < 0)
+              return facebook::jsi::Array(rt, 0);
+            double from =
+                count > 1 && args[1].isNumber() ? args[1].getNumber() : 0;
+            double n = count > 2 && args[2].isNumber() ? args[2].getNumber()
+                                                       : kMaxTailLines;
+            TextView &view = *s_views[handle];
+            std::lock_guard<std::mutex> lock(view.mutex);
+            double total = (double)line_count(view);
+            from = std::clamp(std::floor(from), 0.0, total);
+            n = std::clamp(std::floor(n), 0.0,
+                           std::min(total - from, kMaxTailLines));
+            facebook::jsi::Array lines(rt, (size_t)n);
+            if (n == 0)
+              return lines;
+            const char *p = line_start(view, (uint64_t)from);
+            const char *end = view.data + view.indexed;
+            for (size_t i = 0; i < (size_t)n; ++i) {
+              const char *eol =
+                  static_cast<const char *>(memchr(p, '\n', end - p));
+              const char *next = eol ? eol + 1 : end;
+              if (!eol)
+                eol = end;
+              if (eol > p && eol[-1] == '\r')
+                --eol;
+              lines.setValueAtIndex(
+                  rt, i,
+                  facebook::jsi::String::createFromUtf8(
+                      rt, reinterpret_cast<const uint8_t *>(p), eol - p));
+              p = next;
+            }
+            return lines;
+          }));
+
+  rt.global().setProperty(
+      rt, "__tailClose",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__tailClose"), 1,
+          [](facebook::jsi::Runtime &, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            int handle = view_arg(args, count);
+            if (handle >= 0)
+              close_view(handle);
+            return facebook::jsi::Value::undefined();
+          }));
+}
+
+void shutdown_text_views() {
+  s_post_to_main.store(nullptr, std::memory_order_release);
+  for (auto &view : s_views) {
+    if (view) {
+      if (view->watch)
+        unwatch_file(view->watch);
+      view->cancel->cancel();
+    }
+  }
+  s_views.clear();
+  s_tail_callbacks.clear();
+  s_runtime = nullptr;
+  s_pool = nullptr;
+}
+
+extern "C" int text_view_open_file(const char *path, bool follow) {
+  return open_file_view(path, follow, false);
+}
+
+extern "C" int text_view_open_buffer(int handle, size_t offset,
+                                     size_t length) {
+  std::shared_ptr<SharedBuffer> buffer = lock_shared_buffer(handle);
+  if (!buffer || offset > buffer->size() || length > buffer->size() - offset)
+    return -1;
+  auto view = std::make_shared<TextView>();
+  view->data = reinterpret_cast<const char *>(buffer->data()) + offset;
+  view->size = length;
+  view->owner = std::move(buffer);
+  view->busy = true;
+  s_pool->post([view] { index_chunk(view); },
+               {TaskPriority::Background, TraceTaskTextIndex, view->cancel});
+  return add_view(std::move(view));
+}
+
+extern "C" void text_view_close(int view) {
+  if (find_view(view))
+    close_view(view);
+}
+
+extern "C" double text_view_line_count(int view) {
+  TextView *v = find_view(view);
+  if (!v)
+    return 0;
+  std::lock_guard<std::mutex> lock(v->mutex);
+  return (double)line_count(*v);
+}
+
+extern "C" void text_view_render(int view, const char *id, float width,
+                                 float height, bool stickToEnd) {
+  TextView *v = find_view(view);
+  if (!v)
+    return;
+
+  if (ImGui::BeginChild(id, ImVec2(width, height), false,
+                        ImGuiWindowFlags_HorizontalScrollbar)) {
+    // At the end before this frame's lines are added
+    bool atEnd = ImGui::GetScrollY() >= ImGui::GetScrollMaxY();
+    std::lock_guard<std::mutex> lock(v->mutex);
+    if (!v->error.empty()) {
+      ImGui::TextDisabled("%s", v->error.c_str());
+    } else {
+      uint64_t count = line_count(*v);
+      const char *end = v->data + v->indexed;
+      // ImGuiListClipper counts items in an int
+      ImGuiListClipper clipper;
+      clipper.Begin((int)std::min<uint64_t>(count, INT32_MAX));
+      while (clipper.Step()) {
+        const char *p = line_start(*v, clipper.DisplayStart);
+        for (int line = clipper.DisplayStart; line < clipper.DisplayEnd;
+             ++line) {
+          const char *eol =
+              static_cast<const char *>(memchr(p, '\n', end - p));
+          const char *next = eol ? eol + 1 : end;
+          if (!eol)
+            eol = end;
+          if (eol > p && eol[-1] == '\r')
+            --eol;
+          glyph_cache_touch(p, (int)(eol - p));
+          ImGui::TextUnformatted(p, eol);
+          p = next;
+        }
+      }
+      if (stickToEnd && atEnd)
+        ImGui::SetScrollHereY(1.0f);
+    }
+  }
+  ImGui::EndChild();
+}
@@ -0,0 +1,62 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include "AsyncFs.h"
+
+#include <hermes/hermes.h>
+
+#include <cstddef>
+
+class ThreadPool;
+
+/// Line-indexed views of large text for <textview>. A view is over a mapped
+/// file or a shared buffer; its line index is built incrementally on the
+/// pool, and only the lines in view are drawn, straight from the mapping.
+/// Nothing is copied into the JS heap. The FFI entry points are called by
+/// the typed imgui unit on the JS thread.
+///
+/// A followed file is watched by the FileWatcher thread: each change posts
+/// one job that maps the file again and indexes what was appended, and
+/// changes during that job post one more once it is done. A file that
+/// shrank or was replaced is indexed again from the start.
+
+/// Use `pool` for indexing, and install the host functions behind jslib's
+/// fs.watchTail(): __tailOpen(path, callback) opens a followed view and
+/// returns its handle, posting `callback(message, size, lines)` through
+/// `postToMain` once per batch of indexed bytes (message is null unless
+/// the file can't be read); __tailLines(handle, start, count) returns the
+/// lines in that range as strings; __tailClose(handle) closes it. Called
+/// once at startup.
+void install_text_views(facebook::jsi::Runtime &rt, ThreadPool &pool,
+                        MainThreadPoster postToMain);
+
+/// Drop every view and forget the tail callbacks. Must be called once the
+/// pool and the FileWatcher have been stopped.
+void shutdown_text_views();
+
+/// Open a view of the file at `path`, mapped and indexed in the background.
+/// New lines of a followed file are indexed as they are written. Returns
+/// the view's handle; a handle from __tailOpen() can be drawn the same
+/// way.
+extern "C" int text_view_open_file(const char *path, bool follow);
+
+/// Open a view of `[offset, offset + length)` of the shared buffer `handle`
+/// (the nativeHandle of a createSharedArray() array), which the view keeps
+/// alive. JS must not write to that range while the view is open. Returns
+/// the view's handle, or -1 if the buffer is gone or the range outside it.
+extern "C" int text_view_open_buffer(int handle, size_t offset, size_t length);
+
+/// Close a view; its indexing stops after the current chunk.
+extern "C" void text_view_close(int view);
+
+/// The number of lines indexed so far.
+extern "C" double text_view_line_count(int view);
+
+/// Draw a view in a child window `id` of `width` x `height` (0: fill), the
+/// lines in view only. With `stickToEnd`, a view scrolled to its end stays
+/// there as lines are added, like `tail -f`.
+extern "C" void text_view_render(int view, const char *id, float width,
+                                 float height, bool stickToEnd);
@@ -0,0 +1,161 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include <unordered_map>
+
+namespace {
+
+/// The pool and worker of the calling thread, if it is a worker.
+thread_local ThreadPool *t_pool = nullptr;
+thread_local unsigned t_worker = 0;
+/// The token of the job running on the calling thread.
+thread_local const CancelToken *t_cancel = nullptr;
+
+/// register_cancel_token() IDs, swept of dead tokens as they accumulate.
+std::unordered_map<unsigned, std::weak_ptr<CancelToken>> s_cancel_tokens;
+unsigned s_next_cancel_id = 1;
+size_t s_sweep_at = 64;
+
+} // namespace
+
+ThreadPool::ThreadPool(unsigned numThreads) {
+  if (numThreads == 0)
+    numThreads = 1;
+  workers_.reserve(numThreads);
+  for (unsigned i = 0; i < numThreads; ++i)
+    workers_.push_back(std::make_unique<Worker>());
+  // Started once every deque exists, as the workers steal from each other
+  for (unsigned i = 0; i < numThreads; ++i)
+    workers_[i]->thread = std::thread([this, i] { workerLoop(i); });
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  for (auto &w : workers_)
+    w->thread.join();
+}
+
+void ThreadPool::post(std::function<void()> job, TaskOptions options) {
+  Task task{std::move(job), options.traceName, std::move(options.cancel)};
+  auto priority = (size_t)options.priority;
+  if (t_pool == this) {
+    {
+      Worker &own = *workers_[t_worker];
+      std::lock_guard<std::mutex> lock(own.mutex);
+      own.tasks[priority].push_back(std::move(task));
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    queued_.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shared_[priority].push_back(std::move(task));
+    queued_.fetch_add(1, std::memory_order_relaxed);
+  }
+  cv_.notify_one();
+}
+
+bool ThreadPool::cancelled() { return t_cancel && t_cancel->cancelled(); }
+
+bool ThreadPool::take(unsigned index, Task &task) {
+  auto found = [this, &task](std::deque<Task> &tasks, bool newest) {
+    if (tasks.empty())
+      return false;
+    task = std::move(newest ? tasks.back() : tasks.front());
+    if (newest)
+      tasks.pop_back();
+    else
+      tasks.pop_front();
+    queued_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  };
+  size_t count = workers_.size();
+  for (int p = 0; p < kTaskPriorityCount; ++p) {
+    {
+      Worker &own = *workers_[index];
+      std::lock_guard<std::mutex> lock(own.mutex);
+      if (found(own.tasks[p], true))
+        return true;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (found(shared_[p], false))
+        return true;
+    }
+    for (size_t k = 1; k < count; ++k) {
+      Worker &victim = *workers_[(index + k) % count];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (found(victim.tasks[p], false))
+        return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::workerLoop(unsigned index) {
+  t_pool = this;
+  t_worker = index;
+  char name[32];
+  snprintf(name, sizeof name, "pool %u", index);
+  trace_set_thread_name(name);
+  for (;;) {
+    Task task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] {
+        return stopping_ || queued_.load(std::memory_order_relaxed) > 0;
+      });
+      if (stopping_)
+        return;
+    }
+    // Another worker may have taken the job that woke this one
+    if (!take(index, task))
+      continue;
+    t_cancel = task.cancel.get();
+    trace_begin(task.traceName);
+    // Jobs report their own errors; one that escapes must not take the
+    // process down
+    try {
+      task.run();
+    } catch (const std::exception &e) {
+      fprintf(stderr, "ThreadPool: job failed: %s\n", e.what());
+    } catch (...) {
+      fprintf(stderr, "ThreadPool: job failed\n");
+    }
+    trace_end();
+    t_cancel = nullptr;
+  }
+}
+
+unsigned register_cancel_token(const std::shared_ptr<CancelToken> &token) {
+  if (s_cancel_tokens.size() >= s_sweep_at) {
+    for (auto it = s_cancel_tokens.begin(); it != s_cancel_tokens.end();) {
+      if (it->second.expired())
+        it = s_cancel_tokens.erase(it);
+      else
+        ++it;
+    }
+    s_sweep_at = std::max<size_t>(64, s_cancel_tokens.size() * 2);
+  }
+  unsigned id = s_next_cancel_id++;
+  s_cancel_tokens.emplace(id, token);
+  return id;
+}
+
+void cancel_task(unsigned id) {
+  auto it = s_cancel_tokens.find(id);
+  if (it == s_cancel_tokens.end())
+    return;
+  if (std::shared_ptr<CancelToken> token = it->second.lock())
+    token->cancel();
+  s_cancel_tokens.erase(it);
+}
@@ -0,0 +1,106 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include "Trace.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Higher priorities run first: a queued Interactive job starts before any
+/// queued Normal or Background one.
+enum class TaskPriority { Interactive, Normal, Background };
+constexpr int kTaskPriorityCount = 3;
+
+/// Cooperative cancellation of a job. The owner cancels; the job checks
+/// cancelled() between steps and ends early, still reporting back.
+class CancelToken {
+public:
+  void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+  bool cancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+
+private:
+  std::atomic<bool> cancelled_{false};
+};
+
+struct TaskOptions {
+  TaskPriority priority = TaskPriority::Normal;
+  /// The trace event around the job, on its worker's track.
+  int traceName = TracePoolTask;
+  /// Returned by ThreadPool::cancelled() while the job runs.
+  std::shared_ptr<CancelToken> cancel;
+};
+
+// Shutdown order. The modules whose install_*() takes the pool keep the JS
+// callbacks of their jobs in flight. shutdown_workers() (imgui-runtime.cpp)
+// stops the pool first, so that no job completes into a forgotten
+// callback, then calls their shutdown_*() functions, which forget the
+// callbacks, before the runtime that owns them is destroyed. Modules whose
+// jobs can block a worker (Fetch) shut down before the pool stops instead.
+
+/// Work-stealing scheduler for the runtime's native jobs (file I/O, image
+/// decoding, parsing, kernels) off the main thread. Each worker has a deque
+/// per priority: jobs posted by a job go to the back of its worker's deque
+/// and are taken from there, newest first; jobs from other threads go to a
+/// shared queue; an idle worker steals the oldest job of another. Jobs must
+/// not touch the JS runtime; they hand their results back to the main
+/// thread instead.
+class ThreadPool {
+public:
+  explicit ThreadPool(unsigned numThreads);
+  /// Stops the workers after their current job; queued jobs are dropped.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /// Queue `job` to run on one of the workers. Safe to call from any thread.
+  void post(std::function<void()> job, TaskOptions options = {});
+
+  unsigned size() const { return (unsigned)workers_.size(); }
+
+  /// Whether the job running on the calling thread has been cancelled.
+  static bool cancelled();
+
+private:
+  struct Task {
+    std::function<void()> run;
+    int traceName;
+    std::shared_ptr<CancelToken> cancel;
+  };
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Task> tasks[kTaskPriorityCount];
+    std::thread thread;
+  };
+
+  void workerLoop(unsigned index);
+  bool take(unsigned index, Task &task);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  /// Jobs posted from outside the pool, and the sleep of idle workers.
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Task> shared_[kTaskPriorityCount];
+  /// Jobs queued anywhere; raised under mutex_, so that a worker going to
+  /// sleep can't miss a job. Briefly -1 when a job is stolen before its
+  /// post() raises the count.
+  std::atomic<long> queued_{0};
+  bool stopping_ = false;
+};
+
+/// An ID for `token`, which JS passes to __cancelTask() to cancel the job.
+/// The token is held weakly. Main thread.
+unsigned register_cancel_token(const std::shared_ptr<CancelToken> &token);
+
+/// Cancel the job of a register_cancel_token() ID, if it is still alive.
+/// Main thread.
+void cancel_task(unsigned id);
@@ -0,0 +1,447 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "TimeSeries.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+/// The bucket widths of the levels, in milliseconds.
+constexpr double kLevelMs[] = {1000, 10000, 60000};
+constexpr int kLevels = 3;
+
+struct Sample {
+  double time;
+  float value;
+};
+
+struct Bucket {
+  /// floor(time / width) of its samples.
+  int64_t index;
+  float min, max, last;
+  /// The minimum came before the maximum.
+  bool lowFirst;
+};
+
+/// A ring of at most `capacity` items, oldest first.
+template <typename T> struct Ring {
+  std::vector<T> items;
+  size_t head = 0;
+  size_t size = 0;
+  /// Items were overwritten, so the oldest isn't the first there was.
+  bool wrapped = false;
+
+  explicit Ring(size_t capacity) : items(capacity) {}
+
+  T &at(size_t i) { return items[(head + i) % items.size()]; }
+  const T &at(size_t i) const { return items[(head + i) % items.size()]; }
+  T &newest() { return at(size - 1); }
+
+  void push(const T &item) {
+    if (size < items.size()) {
+      at(size++) = item;
+      return;
+    }
+    items[head] = item;
+    head = (head + 1) % items.size();
+    wrapped = true;
+  }
+};
+
+struct Series {
+  std::mutex mutex;
+  Ring<Sample> raw;
+  std::vector<Ring<Bucket>> levels;
+  double newest = -INFINITY;
+  double oldest = NAN;
+  uint64_t pushed = 0;
+
+  Series(size_t capacity, size_t buckets)
+      : raw(capacity), levels(kLevels, Ring<Bucket>(buckets)) {}
+
+  void push(double time, float value) {
+    if (std::isnan(value) || std::isnan(time))
+      return;
+    // Out of order samples keep the rings sorted
+    time = std::max(time, newest);
+    newest = time;
+    if (pushed++ == 0)
+      oldest = time;
+    raw.push({time, value});
+    for (int l = 0; l < kLevels; ++l) {
+      Ring<Bucket> &level = levels[l];
+      auto index = (int64_t)std::floor(time / kLevelMs[l]);
+      if (level.size > 0 && level.newest().index == index) {
+        Bucket &b = level.newest();
+        if (value < b.min) {
+          b.min = value;
+          b.lowFirst = false;
+        }
+        if (value > b.max) {
+          b.max = value;
+          b.lowFirst = true;
+        }
+        b.last = value;
+      } else {
+        level.push({index, value, value, value, true});
+      }
+    }
+  }
+};
+
+/// Guards s_series; each series has its own mutex for its data.
+std::mutex s_mutex;
+std::unordered_map<unsigned, std::shared_ptr<Series>> s_series;
+unsigned s_next_id = 1;
+
+std::shared_ptr<Series> find_series(unsigned id) {
+  std::lock_guard<std::mutex> lock(s_mutex);
+  auto it = s_series.find(id);
+  return it == s_series.end() ? nullptr : it->second;
+}
+
+/// The per-pixel result of a query.
+struct Pixels {
+  std::vector<float> min, max, last;
+  /// The order the minimum and the maximum of each pixel occurred in.
+  std::vector<uint64_t> minAt, maxAt;
+  std::vector<uint8_t> seen;
+
+  void reset(int width) {
+    min.assign(width, NAN);
+    max.assign(width, NAN);
+    last.assign(width, NAN);
+    minAt.assign(width, 0);
+    maxAt.assign(width, 0);
+    seen.assign(width, 0);
+  }
+};
+
+/// What a query reads of a sample or a bucket.
+struct Item {
+  double start, end;
+  float min, max, last;
+  bool lowFirst;
+};
+
+Item item_of(const Sample &s, double) {
+  return {s.time, s.time, s.value, s.value, s.value, true};
+}
+
+Item item_of(const Bucket &b, double width) {
+  return {b.index * width, (b.index + 1) * width, b.min, b.max, b.last,
+          b.lowFirst};
+}
+
+/// The items of `ring` overlapping [from, to): [*lo, *hi). A sample at
+/// `from` is in, a bucket ending there isn't.
+template <typename T>
+void find_range(const Ring<T> &ring, double width, double from, double to,
+                size_t *lo, size_t *hi) {
+  auto search = [&](auto before) {
+    size_t a = 0, b = ring.size;
+    while (a < b) {
+      size_t mid = a + (b - a) / 2;
+      if (before(item_of(ring.at(mid), width)))
+        a = mid + 1;
+      else
+        b = mid;
+    }
+    return a;
+  };
+  *lo = search([&](const Item &it) {
+    return width > 0 ? it.end <= from : it.end < from;
+  });
+  *hi = search([&](const Item &it) { return it.start < to; });
+}
+
+/// Whether `ring` still holds what there was at `from`.
+template <typename T>
+bool covers(const Ring<T> &ring, double width, double from) {
+  return !ring.wrapped ||
+         (ring.size > 0 && item_of(ring.at(0), width).start <= from);
+}
+
+/// Merge items [lo, hi) of `ring` into `width` pixels over [from, to), and
+/// fill the pixels without any with the last value before them.
+template <typename T>
+void fill_pixels(const Ring<T> &ring, double itemWidth, size_t lo, size_t hi,
+                 double from, double to, int width, Pixels &px) {
+  px.reset(width);
+  double perPixel = (to - from) / width;
+  for (size_t i = lo; i < hi; ++i) {
+    Item it = item_of(ring.at(i), itemWidth);
+    double at = std::max(it.start, from);
+    int p = std::min(width - 1, std::max(0, (int)((at - from) / perPixel)));
+    uint64_t minAt = 2 * i + (it.lowFirst ? 0 : 1);
+    uint64_t maxAt = 2 * i + (it.lowFirst ? 1 : 0);
+    if (!px.seen[p]) {
+      px.seen[p] = 1;
+      px.min[p] = it.min;
+      px.max[p] = it.max;
+      px.minAt[p] = minAt;
+      px.maxAt[p] = maxAt;
+    } else {
+      if (it.min < px.min[p]) {
+        px.min[p] = it.min;
+        px.minAt[p] = minAt;
+      }
+      if (it.max > px.max[p]) {
+        px.max[p] = it.max;
+        px.maxAt[p] = maxAt;
+      }
+    }
+    px.last[p] = it.last;
+  }
+  float prev = lo > 0 ? item_of(ring.at(lo - 1), itemWidth).last : NAN;
+  for (int p = 0; p < width; ++p) {
+    if (px.seen[p]) {
+      prev = px.last[p];
+      continue;
+    }
+    px.min[p] = px.max[p] = px.last[p] = prev;
+  }
+}
+
+/// Query `series` over [from, to) at `width` pixels from the finest source
+/// that covers `from` with at most kSeriesItemsPerPixel items per pixel,
+/// the coarsest level if none does. Holds the series' mutex.
+void query(const Series &series, double from, double to, int width,
+           Pixels &px) {
+  size_t lo, hi;
+  size_t most = (size_t)width * kSeriesItemsPerPixel;
+  if (covers(series.raw, 0, from)) {
+    find_range(series.raw, 0, from, to, &lo, &hi);
+    if (hi - lo <= most) {
+      fill_pixels(series.raw, 0, lo, hi, from, to, width, px);
+      return;
+    }
+  }
+  for (int l = 0; l < kLevels; ++l) {
+    const Ring<Bucket> &level = series.levels[l];
+    if (l < kLevels - 1 && !covers(level, kLevelMs[l], from))
+      continue;
+    find_range(level, kLevelMs[l], from, to, &lo, &hi);
+    if (hi - lo <= most || l == kLevels - 1) {
+      fill_pixels(level, kLevelMs[l], lo, hi, from, to, width, px);
+      return;
+    }
+  }
+}
+
+double number_arg(const facebook::jsi::Value *args, size_t count, size_t i) {
+  return i < count && args[i].isNumber() ? args[i].getNumber() : NAN;
+}
+
+std::shared_ptr<Series> series_arg(facebook::jsi::Runtime &rt,
+                                   const facebook::jsi::Value *args,
+                                   size_t count, const char *name) {
+  std::shared_ptr<Series> series =
+      count > 0 && args[0].isNumber()
+          ? find_series((unsigned)args[0].getNumber())
+          : nullptr;
+  if (!series)
+    throw facebook::jsi::JSError(rt, std::string(name) + ": closed series");
+  return series;
+}
+
+/// The bytes of ArrayBuffer args[i] from args[i + 1] onwards, which must
+/// hold `bytes` bytes.
+uint8_t *bytes_arg(facebook::jsi::Runtime &rt, const facebook::jsi::Value *args,
+                   size_t count, size_t i, size_t bytes, const char *name) {
+  if (i >= count || !args[i].isObject() ||
+      !args[i].getObject(rt).isArrayBuffer(rt))
+    throw facebook::jsi::JSError(rt,
+                                 std::string(name) + " expects an ArrayBuffer");
+  facebook::jsi::ArrayBuffer ab = args[i].getObject(rt).getArrayBuffer(rt);
+  double offset = number_arg(args, count, i + 1);
+  if (!(offset >= 0) || offset > ab.size(rt) ||
+      bytes > ab.size(rt) - (size_t)offset)
+    throw facebook::jsi::JSError(rt, std::string(name) + ": bad range");
+  return ab.data(rt) + (size_t)offset;
+}
+
+} // namespace
+
+void install_time_series(facebook::jsi::Runtime &rt) {
+  rt.global().setProperty(
+      rt, "__seriesCreate",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__seriesCreate"), 2,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            double capacity = number_arg(args, count, 0);
+            double buckets = number_arg(args, count, 1);
+            if (!(capacity >= 1 && capacity <= 1e9) ||
+                !(buckets >= 1 && buckets <= 1e9))
+              throw facebook::jsi::JSError(
+                  rt, "__seriesCreate expects a capacity and a bucket count");
+            auto series =
+                std::make_shared<Series>((size_t)capacity, (size_t)buckets);
+            std::lock_guard<std::mutex> lock(s_mutex);
+            unsigned id = s_next_id++;
+            s_series.emplace(id, std::move(series));
+            return (double)id;
+          }));
+
+  rt.global().setProperty(
+      rt, "__seriesPush",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__seriesPush"), 3,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            std::shared_ptr<Series> series =
+                series_arg(rt, args, count, "__seriesPush");
+            std::lock_guard<std::mutex> lock(series->mutex);
+            series->push(number_arg(args, count, 1),
+                         (float)number_arg(args, count, 2));
+            return facebook::jsi::Value::undefined();
+          }));
+
+  rt.global().setProperty(
+      rt, "__seriesPushMany",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__seriesPushMany"), 6,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            std::shared_ptr<Series> series =
+                series_arg(rt, args, count, "__seriesPushMany");
+            double n = number_arg(args, count, 5);
+            size_t samples = n >= 0 ? (size_t)n : 0;
+            auto *times = reinterpret_cast<const double *>(bytes_arg(
+                rt, args, count, 1, samples * 8, "__seriesPushMany"));
+            auto *values = reinterpret_cast<const float *>(bytes_arg(
+                rt, args, count, 3, samples * 4, "__seriesPushMany"));
+            std::lock_guard<std::mutex> lock(series->mutex);
+            for (size_t i = 0; i < samples; ++i)
+              series->push(times[i], values[i]);
+            return facebook::jsi::Value::undefined();
+          }));
+
+  rt.global().setProperty(
+      rt, "__seriesQuery",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__seriesQuery"), 10,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            std::shared_ptr<Series> series =
+                series_arg(rt, args, count, "__seriesQuery");
+            double from = number_arg(args, count, 1);
+            double to = number_arg(args, count, 2);
+            double width = number_arg(args, count, 3);
+            if (!(to > from) || !(width >= 1 && width <= 1e6))
+              throw facebook::jsi::JSError(
+                  rt, "__seriesQuery expects a time range and a width");
+            int w = (int)width;
+            float *out[3];
+            for (int k = 0; k < 3; ++k)
+              out[k] = reinterpret_cast<float *>(bytes_arg(
+                  rt, args, count, 4 + 2 * k, w * 4, "__seriesQuery"));
+            thread_local Pixels px;
+            {
+              std::lock_guard<std::mutex> lock(series->mutex);
+              query(*series, from, to, w, px);
+            }
+            std::copy(px.min.begin(), px.min.end(), out[0]);
+            std::copy(px.max.begin(), px.max.end(), out[1]);
+            std::copy(px.last.begin(), px.last.end(), out[2]);
+            return facebook::jsi::Value::undefined();
+          }));
+
+  rt.global().setProperty(
+      rt, "__seriesRange",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__seriesRange"), 1,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            std::shared_ptr<Series> series =
+                series_arg(rt, args, count, "__seriesRange");
+            double oldest, newest, pushed;
+            {
+              std::lock_guard<std::mutex> lock(series->mutex);
+              if (series->pushed == 0)
+                return facebook::jsi::Value::null();
+              oldest = series->oldest;
+              newest = series->newest;
+              pushed = (double)series->pushed;
+            }
+            facebook::jsi::Array range(rt, 3);
+            range.setValueAtIndex(rt, 0, oldest);
+            range.setValueAtIndex(rt, 1, newest);
+            range.setValueAtIndex(rt, 2, pushed);
+            return range;
+          }));
+
+  rt.global().setProperty(
+      rt, "__seriesClose",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__seriesClose"), 1,
+          [](facebook::jsi::Runtime &, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            double id = number_arg(args, count, 0);
+            if (id >= 0) {
+              std::lock_guard<std::mutex> lock(s_mutex);
+              s_series.erase((unsigned)id);
+            }
+            return facebook::jsi::Value::undefined();
+          }));
+}
+
+void shutdown_time_series() {
+  std::lock_guard<std::mutex> lock(s_mutex);
+  s_series.clear();
+}
+
+extern "C" long imgui_time_series_push(unsigned series, double time,
+                                       float value) {
+  std::shared_ptr<Series> s = find_series(series);
+  if (!s)
+    return -1;
+  std::lock_guard<std::mutex> lock(s->mutex);
+  s->push(time, value);
+  return 0;
+}
+
+extern "C" int time_series_plot(unsigned series, double from, double to,
+                                int buckets, float *out) {
+  std::shared_ptr<Series> s = find_series(series);
+  if (!s || buckets <= 0 || !(to > from))
+    return 0;
+  thread_local Pixels px;
+  {
+    std::lock_guard<std::mutex> lock(s->mutex);
+    if (s->pushed == 0)
+      return 0;
+    query(*s, from, to, buckets, px);
+  }
+  int written = 0;
+  for (int b = 0; b < buckets; ++b) {
+    bool lowFirst = px.minAt[b] <= px.maxAt[b];
+    out[written++] = lowFirst ? px.min[b] : px.max[b];
+    out[written++] = lowFirst ? px.max[b] : px.min[b];
+  }
+  return written;
+}
+
+extern "C" double time_series_newest(unsigned series) {
+  std::shared_ptr<Series> s = find_series(series);
+  if (!s)
+    return NAN;
+  std::lock_guard<std::mutex> lock(s->mutex);
+  return s->pushed ? s->newest : NAN;
+}
@@ -0,0 +1,64 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include <hermes/hermes.h>
+
+#include <cstddef>
+
+/// Multi-resolution time series behind jslib's createTimeSeries() and
+/// `<plotlines series>`.
+///
+/// A series keeps its newest samples (a time in milliseconds and a value)
+/// in a ring of fixed capacity, and maintains three downsampled levels as
+/// samples arrive: the minimum, the maximum and the last value of every
+/// second, every 10 seconds and every minute, each in a ring of its own
+/// bucket count. Memory is fixed when the series is created, however long
+/// the app runs.
+///
+/// A query of a time range at a width of N pixels reads the finest source
+/// that still covers the range's start and has at most kSeriesItemsPerPixel
+/// items per pixel in it, after two binary searches, so its cost is O(N)
+/// whether the range is the last second or the last two days.
+///
+/// Samples are pushed in time order; one older than the newest is counted
+/// at the newest's time. NaN values are ignored.
+///
+/// Host functions:
+///  - __seriesCreate(capacity, buckets) returns the ID of a series keeping
+///    `capacity` samples and `buckets` buckets per level;
+///  - __seriesPush(id, time, value) adds a sample;
+///  - __seriesPushMany(id, times, timesOffset, values, valuesOffset, count)
+///    adds `count` samples from a Float64Array and a Float32Array;
+///  - __seriesQuery(id, from, to, width, min, minOffset, max, maxOffset,
+///    last, lastOffset) fills the three Float32Arrays of `width` elements;
+///  - __seriesRange(id) returns [oldest, newest, samples pushed] or null;
+///  - __seriesClose(id) drops a series.
+void install_time_series(facebook::jsi::Runtime &rt);
+
+/// Drop the series.
+void shutdown_time_series();
+
+/// Items per pixel above which a query reads the next coarser level.
+constexpr int kSeriesItemsPerPixel = 4;
+
+extern "C" {
+
+/// Add a sample to series `series` (its jslib `id`) from any thread, e.g. a
+/// native feed. Returns 0, or -1 if there is no such series.
+long imgui_time_series_push(unsigned series, double time, float value);
+
+/// Write `buckets` pairs of values of `series` over [from, to) to `out`, the
+/// minimum and the maximum of each bucket in the order they occurred, as
+/// plot_reduce() does for <plotlines>. A bucket without samples holds the
+/// last value before it, NaN before the first. Returns the number of values
+/// written, 0 if the series is gone or empty.
+int time_series_plot(unsigned series, double from, double to, int buckets,
+                     float *out);
+
+/// The time of the newest sample, NaN if there is none.
+double time_series_newest(unsigned series);
+
+} // extern "C"
@@ -0,0 +1,228 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "Trace.h"
+
+#include "sokol_time.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+
+std::atomic<bool> g_trace_capturing{false};
+
+namespace {
+
+struct TraceEvent {
+  uint64_t ticks;
+  double value;
+  int32_t name;
+  uint16_t tid;
+  char phase;
+};
+
+#if IMGUI_EMBEDDED_PROFILE
+/// 16K events, 384 KB: a few seconds of frames, on devices short of memory.
+constexpr uint64_t kCapacity = 1u << 14;
+#else
+/// 256K events, 6 MB. At a few dozen events per frame that is well over a
+/// minute of frames.
+constexpr uint64_t kCapacity = 1u << 18;
+#endif
+TraceEvent s_events[kCapacity];
+/// Total number of events recorded by the current capture; the slot of the
+/// next one is s_next % kCapacity.
+std::atomic<uint64_t> s_next{0};
+uint64_t s_start_ticks = 0;
+
+const char *const kBuiltinNames[TraceBuiltinCount] = {
+    "frame",
+    "idle sleep",
+    "input",
+    "macrotasks",
+    "rAF",
+    "onFrame",
+    "renderTree",
+    "ImGui render",
+    "sg_commit",
+    "idle callbacks",
+    "idle GC",
+    "React commit",
+    "hermes_allocatedBytes",
+    "hermes_numCollections",
+    "GC",
+    "hermes_heapSize",
+    "sg_drawCalls",
+    "imgui_vertices",
+    "sg_uploadBytes",
+    "gpu_ms",
+    "js_tasksPerFrame",
+    "js_rafCallbacks",
+    "js_macrotaskQueue",
+    "js_microtaskDrainMs",
+    "pool task",
+    "fs",
+    "decode image",
+    "runNative",
+    "parseColumns",
+    "tableOps",
+    "decode audio",
+    "index text",
+    "build font",
+    "resolve host",
+    "fetch",
+    "decode records",
+    "encode capture",
+};
+
+/// Guards s_names and s_thread_names.
+std::mutex s_names_mutex;
+/// Interned names, in ID order after the builtins. A deque so that the
+/// strings never move.
+std::deque<std::string> s_names;
+std::map<int, std::string> s_thread_names;
+
+std::atomic<int> s_next_tid{1};
+thread_local int t_tid = 0;
+
+int current_tid() {
+  if (!t_tid)
+    t_tid = s_next_tid.fetch_add(1, std::memory_order_relaxed);
+  return t_tid;
+}
+
+const char *name_of(int id) {
+  if (id >= 0 && id < TraceBuiltinCount)
+    return kBuiltinNames[id];
+  id -= TraceBuiltinCount;
+  if (id >= 0 && id < (int)s_names.size())
+    return s_names[id].c_str();
+  return "?";
+}
+
+void write_string(FILE *f, const char *s) {
+  fputc('"', f);
+  for (; *s; ++s) {
+    unsigned char c = (unsigned char)*s;
+    if (c == '"' || c == '\\')
+      fprintf(f, "\\%c", c);
+    else if (c < 0x20)
+      fprintf(f, "\\u%04x", c);
+    else
+      fputc(c, f);
+  }
+  fputc('"', f);
+}
+
+} // namespace
+
+void trace_record(int name, char phase, double value) {
+  uint64_t index = s_next.fetch_add(1, std::memory_order_relaxed);
+  TraceEvent &ev = s_events[index % kCapacity];
+  ev.ticks = stm_now();
+  ev.value = value;
+  ev.name = name;
+  ev.tid = (uint16_t)current_tid();
+  ev.phase = phase;
+}
+
+int trace_intern(const char *name) {
+  for (int i = 0; i < TraceBuiltinCount; ++i)
+    if (strcmp(kBuiltinNames[i], name) == 0)
+      return i;
+  std::lock_guard<std::mutex> lock(s_names_mutex);
+  for (size_t i = 0; i < s_names.size(); ++i)
+    if (s_names[i] == name)
+      return TraceBuiltinCount + (int)i;
+  s_names.emplace_back(name);
+  return TraceBuiltinCount + (int)s_names.size() - 1;
+}
+
+void trace_set_thread_name(const char *name) {
+  int tid = current_tid();
+  std::lock_guard<std::mutex> lock(s_names_mutex);
+  s_thread_names[tid] = name;
+}
+
+void trace_start() {
+  s_next.store(0, std::memory_order_relaxed);
+  s_start_ticks = stm_now();
+  g_trace_capturing.store(true, std::memory_order_release);
+}
+
+bool trace_stop_and_write(const char *path) {
+  g_trace_capturing.store(false, std::memory_order_release);
+  uint64_t total = s_next.load(std::memory_order_acquire);
+  uint64_t count = total < kCapacity ? total : kCapacity;
+
+  FILE *f = fopen(path, "w");
+  if (!f) {
+    fprintf(stderr, "Failed to write trace %s\n", path);
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(s_names_mutex);
+  fputs("{\"traceEvents\":[\n", f);
+  bool first = true;
+  auto separator = [&] {
+    if (!first)
+      fputs(",\n", f);
+    first = false;
+  };
+
+  for (const auto &[tid, name] : s_thread_names) {
+    separator();
+    fprintf(f,
+            "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+            "\"args\":{\"name\":",
+            tid);
+    write_string(f, name.c_str());
+    fputs("}}", f);
+  }
+
+  // Open events per thread. When the ring buffer wrapped, the beginnings of
+  // the oldest events are gone, and their ends must be dropped too.
+  std::map<int, int> depth;
+  for (uint64_t i = total - count; i < total; ++i) {
+    const TraceEvent &ev = s_events[i % kCapacity];
+    if (ev.ticks < s_start_ticks)
+      continue;
+    double ts = stm_us(stm_diff(ev.ticks, s_start_ticks));
+    if (ev.phase == 'E') {
+      if (depth[ev.tid] == 0)
+        continue;
+      --depth[ev.tid];
+      separator();
+      fprintf(f, "{\"ph\":\"E\",\"pid\":1,\"tid\":%d,\"ts\":%.3f}", ev.tid,
+              ts);
+      continue;
+    }
+    if (ev.phase == 'B')
+      ++depth[ev.tid];
+    separator();
+    fputs("{\"name\":", f);
+    write_string(f, name_of(ev.name));
+    fprintf(f, ",\"ph\":\"%c\",\"pid\":1,\"tid\":%d,\"ts\":%.3f", ev.phase,
+            ev.tid, ts);
+    if (ev.phase == 'C')
+      fprintf(f, ",\"args\":{\"value\":%.17g}", ev.value);
+    fputc('}', f);
+  }
+  fputs("\n],\"displayTimeUnit\":\"ms\"}\n", f);
+  bool ok = fclose(f) == 0;
+
+  printf("Trace written to %s (%llu events", path, (unsigned long long)count);
+  if (total > count)
+    printf(", %llu oldest dropped", (unsigned long long)(total - count));
+  printf(")\n");
+  return ok;
+}
+
+extern "C" void imgui_trace_begin(int name) { trace_begin(name); }
+
+extern "C" void imgui_trace_end(void) { trace_end(); }
@@ -0,0 +1,109 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include <atomic>
+
+/// Frame phase tracing in the Chrome Trace Event format, which
+/// chrome://tracing and ui.perfetto.dev open directly.
+///
+/// While a capture runs, begin/end markers and counters go into a fixed-size
+/// ring buffer (the oldest events are overwritten), which
+/// trace_stop_and_write() turns into a JSON file. When no capture runs, a
+/// marker costs one relaxed atomic load. Markers may be recorded on any
+/// thread; each thread gets its own track.
+
+/// Names of the runtime's own events. Names from JS are interned after them
+/// by trace_intern().
+enum TraceName : int {
+  TraceFrame,
+  TraceSleep,
+  TraceInput,
+  TraceMacrotasks,
+  TraceRaf,
+  TraceOnFrame,
+  TraceRenderTree,
+  TraceImGuiRender,
+  TraceCommit,
+  TraceIdle,
+  TraceIdleGc,
+  TraceReactCommit,
+  TraceHeap,
+  TraceGcCount,
+  TraceGc,
+  TraceHeapSize,
+  TraceDrawCalls,
+  TraceVertices,
+  TraceUploadBytes,
+  TraceGpuTime,
+  TraceTasksPerFrame,
+  TraceRafCallbacks,
+  TraceMacrotaskQueue,
+  TraceMicrotaskDrain,
+  TracePoolTask,
+  TraceTaskFs,
+  TraceTaskImage,
+  TraceTaskNative,
+  TraceTaskParse,
+  TraceTaskTable,
+  TraceTaskAudio,
+  TraceTaskTextIndex,
+  TraceTaskFont,
+  TraceTaskResolve,
+  TraceTaskFetch,
+  TraceTaskDecode,
+  TraceTaskCapture,
+  TraceBuiltinCount
+};
+
+extern std::atomic<bool> g_trace_capturing;
+
+/// Record an event: 'B' (begin), 'E' (end) or 'C' (counter `value`).
+void trace_record(int name, char phase, double value = 0);
+
+inline bool trace_capturing() {
+  return g_trace_capturing.load(std::memory_order_relaxed);
+}
+inline void trace_begin(int name) {
+  if (trace_capturing())
+    trace_record(name, 'B');
+}
+/// Ends the innermost open event of the calling thread.
+inline void trace_end() {
+  if (trace_capturing())
+    trace_record(-1, 'E');
+}
+inline void trace_counter(int name, double value) {
+  if (trace_capturing())
+    trace_record(name, 'C', value);
+}
+
+/// Begin/end pair for a C++ scope.
+class TraceScope {
+public:
+  explicit TraceScope(int name) { trace_begin(name); }
+  ~TraceScope() { trace_end(); }
+
+  TraceScope(const TraceScope &) = delete;
+  TraceScope &operator=(const TraceScope &) = delete;
+};
+
+/// ID of the event name `name`, for trace_begin() and trace_counter().
+/// Interning takes a lock; callers cache the result.
+int trace_intern(const char *name);
+
+/// Name the calling thread's track.
+void trace_set_thread_name(const char *name);
+
+/// Start a capture, discarding the events of the previous one.
+void trace_start();
+/// Stop the capture and write its events to `path`. Returns false if the
+/// file couldn't be written.
+bool trace_stop_and_write(const char *path);
+
+/// FFI entry points for the typed imgui unit, which marks its phases with
+/// the builtin names (ad-hoc names go through globalThis.trace).
+extern "C" void imgui_trace_begin(int name);
+extern "C" void imgui_trace_end(void);
@@ -0,0 +1,1347 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "WebSocket.h"
+
+#include "IoReactor.h"
+#include "RecordDecoder.h"
+#include "SharedBuffer.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/random.h>
+#endif
+
+#ifdef REACT_IMGUI_TLS
+#include <openssl/err.h>
+#include <openssl/rand.h>
+#include <openssl/ssl.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+/// Appended to Sec-WebSocket-Key to compute Sec-WebSocket-Accept.
+constexpr char kAcceptGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+/// Largest message assembled; a bigger one closes the connection (1009).
+constexpr size_t kMaxMessageBytes = 256u << 20;
+/// Largest HTTP response to the upgrade request.
+constexpr size_t kMaxHandshakeBytes = 16 << 10;
+/// Bytes read at a time.
+constexpr size_t kReadChunk = 64 << 10;
+/// How long a close handshake we started may take before the socket is
+/// closed anyway.
+constexpr auto kCloseTimeout = std::chrono::seconds(5);
+/// Longest wait of the I/O thread; commands wake it earlier.
+constexpr double kIoWaitMs = 1000;
+
+enum Opcode {
+  OpContinuation = 0x0,
+  OpText = 0x1,
+  OpBinary = 0x2,
+  OpClose = 0x8,
+  OpPing = 0x9,
+  OpPong = 0xA,
+};
+
+/// Kinds of the events delivered to JS. Must match WS_EVENT_* in jslib.
+enum EventKind {
+  EventOpen,
+  EventText,
+  EventBinary,
+  EventError,
+  EventClose,
+};
+
+/// Values per event in the batches passed to the __wsOnEvents() callback:
+/// id, kind, data (a string, or an ArrayBuffer for EventBinary), close
+/// code, whether the close was clean.
+constexpr size_t kEventFields = 5;
+
+struct Event {
+  Event *next = nullptr;
+  uint32_t id;
+  EventKind kind;
+  /// The protocol (open), message (text), error message or close reason.
+  std::string text;
+  std::vector<uint8_t> binary;
+  int code = 0;
+  bool clean = false;
+};
+
+struct Url {
+  bool tls = false;
+  /// Without the brackets of an IPv6 address.
+  std::string host;
+  std::string port;
+  /// Path and query, at least "/".
+  std::string path;
+  /// The Host header: the host, and the port unless it is the default.
+  std::string hostHeader;
+};
+
+struct Address {
+  sockaddr_storage addr;
+  socklen_t len;
+};
+
+enum class State {
+  Resolving,
+  Connecting,
+  TlsHandshake,
+  Upgrading,
+  Open,
+  Closing,
+  Closed,
+};
+
+/// A connection, owned by the I/O thread once connected.
+struct Connection {
+  uint32_t id;
+  Url url;
+  /// Requested subprotocols, comma-separated.
+  std::string protocols;
+  /// bufferedAmount: bytes of messages sent by JS and not yet written.
+  std::shared_ptr<std::atomic<uint64_t>> buffered;
+  State state = State::Resolving;
+  std::vector<Address> addrs;
+  size_t nextAddr = 0;
+  int lastError = 0;
+  int fd = -1;
+  unsigned watched = 0;
+#ifdef REACT_IMGUI_TLS
+  SSL *ssl = nullptr;
+  /// IoReactor events the handshake waits for.
+  unsigned tlsWants = 0;
+#endif
+  /// Sec-WebSocket-Key of the upgrade request.
+  std::string key;
+  /// Received bytes not parsed yet.
+  std::vector<uint8_t> in;
+  struct Output {
+    std::string bytes;
+    /// Bytes counted in `buffered`.
+    size_t payload;
+  };
+  std::deque<Output> out;
+  size_t outOffset = 0;
+  /// The fragments of a message, and its opcode (0: none in progress).
+  std::vector<uint8_t> message;
+  int messageOpcode = 0;
+  bool closeSent = false;
+  bool closeReceived = false;
+  int closeCode = 1005;
+  std::string closeReason;
+  std::chrono::steady_clock::time_point closeDeadline;
+  /// Decodes the binary messages instead of JS, when set.
+  std::shared_ptr<RecordDecoder> decoder;
+};
+
+enum CommandKind {
+  CommandConnect,
+  CommandResolved,
+  CommandSend,
+  CommandClose,
+  CommandDecode
+};
+
+/// A request of the JS thread (or of a name lookup) to the I/O thread.
+struct Command {
+  CommandKind kind;
+  uint32_t id = 0;
+  /// CommandConnect.
+  std::unique_ptr<Connection> connection;
+  /// CommandResolved: the addresses, or the error.
+  std::vector<Address> addrs;
+  std::string error;
+  /// CommandSend.
+  int opcode = 0;
+  std::string payload;
+  /// CommandClose: 0 for no code.
+  int code = 0;
+  std::string reason;
+  /// CommandDecode: null to deliver binary messages to JS again.
+  std::shared_ptr<RecordDecoder> decoder;
+};
+
+ThreadPool *s_pool = nullptr;
+std::atomic<MainThreadPoster> s_post_to_main{nullptr};
+
+/// JS thread.
+facebook::jsi::Runtime *s_runtime = nullptr;
+std::shared_ptr<facebook::jsi::Function> s_callback;
+uint32_t s_next_id = 1;
+std::unordered_map<uint32_t, std::shared_ptr<std::atomic<uint64_t>>>
+    s_buffered;
+
+/// Events for JS: a lock-free stack, newest first, pushed by the I/O thread
+/// and taken whole by deliver().
+std::atomic<Event *> s_events{nullptr};
+
+std::mutex s_commands_mutex;
+std::vector<Command> s_commands;
+std::unique_ptr<IoReactor> s_reactor;
+std::thread s_io_thread;
+std::atomic<bool> s_io_stop{false};
+
+/// I/O thread.
+std::unordered_map<uint32_t, std::unique_ptr<Connection>> s_connections;
+std::unordered_map<int, Connection *> s_by_fd;
+/// Bytes from the entropy source not handed out yet, for random_bytes().
+uint8_t s_random_pool[256];
+size_t s_random_left = 0;
+#ifdef REACT_IMGUI_TLS
+SSL_CTX *s_ssl_ctx = nullptr;
+#endif
+
+/// Fill `size` bytes at `out` from a strong entropy source, as RFC 6455
+/// requires of masking keys: OpenSSL's CSPRNG when TLS is built in, the
+/// kernel's otherwise. Drawn through a pool, so that masking a frame costs
+/// no system call. I/O thread only.
+void random_bytes(uint8_t *out, size_t size) {
+  while (size > 0) {
+    if (s_random_left == 0) {
+      bool ok = false;
+#ifdef REACT_IMGUI_TLS
+      ok = RAND_bytes(s_random_pool, (int)sizeof s_random_pool) == 1;
+#endif
+#if defined(__linux__)
+      for (size_t got = 0; !ok;) {
+        ssize_t n = getrandom(s_random_pool + got, sizeof s_random_pool - got,
+                              0);
+        if (n < 0 && errno == EINTR)
+          continue;
+        if (n < 0) {
+          perror("getrandom");
+          abort();
+        }
+        got += (size_t)n;
+        ok = got == sizeof s_random_pool;
+      }
+#else
+      if (!ok)
+        arc4random_buf(s_random_pool, sizeof s_random_pool);
+#endif
+      s_random_left = sizeof s_random_pool;
+    }
+    size_t n = std::min(size, s_random_left);
+    memcpy(out, s_random_pool + sizeof s_random_pool - s_random_left, n);
+    s_random_left -= n;
+    out += n;
+    size -= n;
+  }
+}
+
+std::array<uint8_t, 20> sha1(const std::string &text) {
+  uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476,
+                   0xC3D2E1F0};
+  std::string msg = text;
+  uint64_t bits = (uint64_t)text.size() * 8;
+  msg += (char)0x80;
+  while (msg.size() % 64 != 56)
+    msg += (char)0;
+  for (int i = 7; i >= 0; --i)
+    msg += (char)(bits >> (i * 8));
+  auto rol = [](uint32_t v, int n) { return (v << n) | (v >> (32 - n)); };
+  for (size_t chunk = 0; chunk < msg.size(); chunk += 64) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; ++i) {
+      const uint8_t *p = (const uint8_t *)msg.data() + chunk + i * 4;
+      w[i] = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 |
+             (uint32_t)p[2] << 8 | p[3];
+    }
+    for (int i = 16; i < 80; ++i)
+      w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; ++i) {
+      uint32_t f, k;
+      if (i < 20) {
+        f = (b & c) | (~b & d);
+        k = 0x5A827999;
+      } else if (i < 40) {
+        f = b ^ c ^ d;
+        k = 0x6ED9EBA1;
+      } else if (i < 60) {
+        f = (b & c) | (b & d) | (c & d);
+        k = 0x8F1BBCDC;
+      } else {
+        f = b ^ c ^ d;
+        k = 0xCA62C1D6;
+      }
+      uint32_t t = rol(a, 5) + f + e + k + w[i];
+      e = d;
+      d = c;
+      c = rol(b, 30);
+      b = a;
+      a = t;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+  }
+  std::array<uint8_t, 20> digest;
+  for (int i = 0; i < 20; ++i)
+    digest[i] = (uint8_t)(h[i / 4] >> (24 - (i % 4) * 8));
+  return digest;
+}
+
+std::string base64(const uint8_t *data, size_t size) {
+  static const char kDigits[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string out;
+  for (size_t i = 0; i < size; i += 3) {
+    uint32_t v = (uint32_t)data[i] << 16;
+    if (i + 1 < size)
+      v |= (uint32_t)data[i + 1] << 8;
+    if (i + 2 < size)
+      v |= data[i + 2];
+    out += kDigits[(v >> 18) & 63];
+    out += kDigits[(v >> 12) & 63];
+    out += i + 1 < size ? kDigits[(v >> 6) & 63] : '=';
+    out += i + 2 < size ? kDigits[v & 63] : '=';
+  }
+  return out;
+}
+
+std::string lowercase(std::string s) {
+  for (char &c : s)
+    c = (char)tolower((unsigned char)c);
+  return s;
+}
+
+std::string trim(const std::string &s) {
+  size_t start = s.find_first_not_of(" \t");
+  if (start == std::string::npos)
+    return "";
+  return s.substr(start, s.find_last_not_of(" \t") - start + 1);
+}
+
+/// Parse a ws:// or wss:// URL into `url`, or return the error.
+std::string parse_url(const std::string &text, Url &url) {
+  std::string lower = lowercase(text);
+  size_t rest;
+  if (lower.compare(0, 5, "ws://") == 0) {
+    rest = 5;
+  } else if (lower.compare(0, 6, "wss://") == 0) {
+    url.tls = true;
+    rest = 6;
+  } else {
+    return "The URL's scheme must be 'ws' or 'wss'";
+  }
+  if (text.find('#') != std::string::npos)
+    return "The URL contains a fragment identifier";
+  size_t end = text.find_first_of("/?", rest);
+  std::string authority =
+      text.substr(rest, end == std::string::npos ? std::string::npos
+                                                 : end - rest);
+  if (authority.find('@') != std::string::npos)
+    return "The URL contains credentials";
+  size_t portStart = std::string::npos;
+  if (!authority.empty() && authority[0] == '[') {
+    size_t close = authority.find(']');
+    if (close == std::string::npos)
+      return "The URL's host is invalid";
+    url.host = authority.substr(1, close - 1);
+    if (close + 1 < authority.size()) {
+      if (authority[close + 1] != ':')
+        return "The URL's host is invalid";
+      portStart = close + 2;
+    }
+  } else {
+    size_t colon = authority.find(':');
+    url.host = authority.substr(0, colon);
+    if (colon != std::string::npos)
+      portStart = colon + 1;
+  }
+  if (url.host.empty())
+    return "The URL has no host";
+  std::string defaultPort = url.tls ? "443" : "80";
+  url.port = portStart == std::string::npos ? defaultPort
+                                            : authority.substr(portStart);
+  if (url.port.empty() ||
+      url.port.find_first_not_of("0123456789") != std::string::npos ||
+      url.port.size() > 5 || std::stoul(url.port) > 65535)
+    return "The URL's port is invalid";
+  url.path = end == std::string::npos ? "/" : text.substr(end);
+  if (url.path[0] == '?')
+    url.path = "/" + url.path;
+  url.hostHeader = authority.substr(0, portStart == std::string::npos
+                                           ? std::string::npos
+                                           : portStart - 1);
+  if (url.port != defaultPort)
+    url.hostHeader += ":" + url.port;
+  return "";
+}
+
+void deliver();
+
+/// I/O thread: queue `event` for JS. The first event of a batch posts the
+/// delivery; the others ride along.
+void push_event(Event *event) {
+  Event *head = s_events.load(std::memory_order_relaxed);
+  do {
+    event->next = head;
+  } while (!s_events.compare_exchange_weak(head, event,
+                                           std::memory_order_release,
+                                           std::memory_order_relaxed));
+  if (!head) {
+    if (MainThreadPoster post = s_post_to_main.load(std::memory_order_acquire))
+      post([] { deliver(); });
+  }
+}
+
+void push_event(uint32_t id, EventKind kind, std::string text = "",
+                int code = 0, bool clean = false) {
+  Event *event = new Event;
+  event->id = id;
+  event->kind = kind;
+  event->text = std::move(text);
+  event->code = code;
+  event->clean = clean;
+  push_event(event);
+}
+
+/// Main thread: pass the events queued since the last delivery to JS, in
+/// order, in one call.
+void deliver() {
+  Event *list = s_events.exchange(nullptr, std::memory_order_acquire);
+  Event *ordered = nullptr;
+  size_t count = 0;
+  while (list) {
+    Event *next = list->next;
+    list->next = ordered;
+    ordered = list;
+    list = next;
+    ++count;
+  }
+  std::unique_ptr<facebook::jsi::Array> batch;
+  if (s_callback && s_runtime)
+    batch = std::make_unique<facebook::jsi::Array>(*s_runtime,
+                                                   count * kEventFields);
+  size_t i = 0;
+  while (ordered) {
+    std::unique_ptr<Event> event(ordered);
+    ordered = ordered->next;
+    if (event->kind == EventClose)
+      s_buffered.erase(event->id);
+    if (!batch)
+      continue;
+    facebook::jsi::Runtime &rt = *s_runtime;
+    batch->setValueAtIndex(rt, i++, (double)event->id);
+    batch->setValueAtIndex(rt, i++, (int)event->kind);
+    if (event->kind == EventBinary) {
+      // The ArrayBuffer takes the assembled message over
+      batch->setValueAtIndex(
+          rt, i++,
+          facebook::jsi::ArrayBuffer(
+              rt, std::make_shared<VectorBuffer<uint8_t>>(
+                      std::move(event->binary))));
+    } else {
+      batch->setValueAtIndex(
+          rt, i++, facebook::jsi::String::createFromUtf8(rt, event->text));
+    }
+    batch->setValueAtIndex(rt, i++, event->code);
+    batch->setValueAtIndex(rt, i++, event->clean);
+  }
+  if (batch) {
+    // Held by the call, in case the callback replaces it
+    std::shared_ptr<facebook::jsi::Function> callback = s_callback;
+    callback->call(*s_runtime, *batch);
+  }
+}
+
+void io_main();
+
+void push_command(Command command) {
+  {
+    std::lock_guard<std::mutex> lock(s_commands_mutex);
+    s_commands.push_back(std::move(command));
+  }
+  s_reactor->wake();
+}
+
+void start_io_thread() {
+  if (s_io_thread.joinable())
+    return;
+  s_reactor = std::make_unique<IoReactor>();
+  s_io_stop.store(false);
+  s_io_thread = std::thread(io_main);
+}
+
+// I/O thread from here on, up to the host functions.
+
+void update_watch(Connection &c) {
+  if (c.fd < 0)
+    return;
+  unsigned events = 0;
+  switch (c.state) {
+  case State::Connecting:
+    events = IoReactor::kWritable;
+    break;
+  case State::TlsHandshake:
+#ifdef REACT_IMGUI_TLS
+    events = c.tlsWants;
+#endif
+    break;
+  case State::Upgrading:
+  case State::Open:
+  case State::Closing:
+    events = IoReactor::kReadable | (c.out.empty() ? 0 : IoReactor::kWritable);
+    break;
+  default:
+    break;
+  }
+  if (events != c.watched) {
+    s_reactor->watch(c.fd, events);
+    c.watched = events;
+  }
+}
+
+/// Close the socket and report the close to JS.
+void finish(Connection &c, int code, std::string reason, bool clean) {
+  if (c.state == State::Closed)
+    return;
+  c.state = State::Closed;
+#ifdef REACT_IMGUI_TLS
+  if (c.ssl) {
+    SSL_free(c.ssl);
+    c.ssl = nullptr;
+  }
+#endif
+  if (c.fd >= 0) {
+    s_reactor->unwatch(c.fd);
+    s_by_fd.erase(c.fd);
+    close(c.fd);
+    c.fd = -1;
+  }
+  push_event(c.id, EventClose, std::move(reason), code, clean);
+}
+
+/// Fail the connection: an error event, then an abnormal close.
+void fail(Connection &c, std::string message) {
+  if (c.state == State::Closed)
+    return;
+  push_event(c.id, EventError, std::move(message));
+  finish(c, 1006, "", false);
+}
+
+/// Queue a frame of `size` bytes at `data`, masked as a client must.
+/// `payload` bytes of it count in bufferedAmount.
+void queue_frame(Connection &c, int opcode, const void *data, size_t size,
+                 size_t payload) {
+  std::string frame;
+  frame.reserve(size + 14);
+  frame += (char)(0x80 | opcode);
+  if (size < 126) {
+    frame += (char)(0x80 | size);
+  } else if (size <= 0xFFFF) {
+    frame += (char)(0x80 | 126);
+    frame += (char)(size >> 8);
+    frame += (char)size;
+  } else {
+    frame += (char)(0x80 | 127);
+    for (int i = 7; i >= 0; --i)
+      frame += (char)((uint64_t)size >> (i * 8));
+  }
+  uint8_t mask[4];
+  random_bytes(mask, sizeof mask);
+  frame.append((const char *)mask, 4);
+  size_t start = frame.size();
+  frame.append((const char *)data, size);
+  for (size_t i = 0; i < size; ++i)
+    frame[start + i] ^= mask[i & 3];
+  c.out.push_back({std::move(frame), payload});
+}
+
+/// Send a close frame with `code` (none if 0) and wait for the server's.
+void start_close(Connection &c, int code, const std::string &reason) {
+  if (c.state != State::Open)
+    return;
+  std::string body;
+  if (code) {
+    body += (char)(code >> 8);
+    body += (char)code;
+    body += reason;
+  }
+  queue_frame(c, OpClose, body.data(), body.size(), 0);
+  c.closeSent = true;
+  c.state = State::Closing;
+  c.closeDeadline = std::chrono::steady_clock::now() + kCloseTimeout;
+}
+
+/// Bytes read into `buf`, 0 at the end of the stream, -1 if none are
+/// available yet, -2 on an error (in c.lastError).
+ssize_t raw_read(Connection &c, void *buf, size_t size) {
+#ifdef REACT_IMGUI_TLS
+  if (c.ssl) {
+    int n = SSL_read(c.ssl, buf, (int)std::min<size_t>(size, INT32_MAX));
+    if (n > 0)
+      return n;
+    int err = SSL_get_error(c.ssl, n);
+    if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE)
+      return -1;
+    if (err == SSL_ERROR_ZERO_RETURN)
+      return 0;
+    c.lastError = EPROTO;
+    return -2;
+  }
+#endif
+  ssize_t n = recv(c.fd, buf, size, 0);
+  if (n >= 0)
+    return n;
+  if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+    return -1;
+  c.lastError = errno;
+  return -2;
+}
+
+/// As raw_read(), for writing.
+ssize_t raw_write(Connection &c, const void *buf, size_t size) {
+#ifdef REACT_IMGUI_TLS
+  if (c.ssl) {
+    int n = SSL_write(c.ssl, buf, (int)std::min<size_t>(size, INT32_MAX));
+    if (n > 0)
+      return n;
+    int err = SSL_get_error(c.ssl, n);
+    if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE)
+      return -1;
+    c.lastError = EPROTO;
+    return -2;
+  }
+#endif
+#ifdef MSG_NOSIGNAL
+  ssize_t n = send(c.fd, buf, size, MSG_NOSIGNAL);
+#else
+  ssize_t n = send(c.fd, buf, size, 0);
+#endif
+  if (n >= 0)
+    return n;
+  if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+    return -1;
+  c.lastError = errno;
+  return -2;
+}
+
+void flush_output(Connection &c) {
+  while (!c.out.empty() && c.state != State::Closed) {
+    Connection::Output &front = c.out.front();
+    ssize_t n = raw_write(c, front.bytes.data() + c.outOffset,
+                          front.bytes.size() - c.outOffset);
+    if (n == -1)
+      return;
+    if (n < 0) {
+      fail(c, std::string("Write failed: ") + strerror(c.lastError));
+      return;
+    }
+    c.outOffset += (size_t)n;
+    if (c.outOffset < front.bytes.size())
+      continue;
+    c.buffered->fetch_sub(front.payload, std::memory_order_relaxed);
+    c.out.pop_front();
+    c.outOffset = 0;
+  }
+  // Both close frames went through: the handshake is over
+  if (c.state == State::Closing && c.closeSent && c.closeReceived &&
+      c.out.empty())
+    finish(c, c.closeCode, c.closeReason, true);
+}
+
+void start_upgrade(Connection &c) {
+  uint8_t nonce[16];
+  random_bytes(nonce, sizeof nonce);
+  c.key = base64(nonce, sizeof nonce);
+  std::string request = "GET " + c.url.path + " HTTP/1.1\r\n" +
+                        "Host: " + c.url.hostHeader + "\r\n" +
+                        "Upgrade: websocket\r\n"
+                        "Connection: Upgrade\r\n"
+                        "Sec-WebSocket-Key: " +
+                        c.key + "\r\n" + "Sec-WebSocket-Version: 13\r\n";
+  if (!c.protocols.empty())
+    request += "Sec-WebSocket-Protocol: " + c.protocols + "\r\n";
+  request += "\r\n";
+  c.out.push_back({std::move(request), 0});
+  c.state = State::Upgrading;
+}
+
+#ifdef REACT_IMGUI_TLS
+void continue_tls(Connection &c) {
+  ERR_clear_error();
+  int r = SSL_connect(c.ssl);
+  if (r == 1) {
+    start_upgrade(c);
+    return;
+  }
+  int err = SSL_get_error(c.ssl, r);
+  if (err == SSL_ERROR_WANT_READ) {
+    c.tlsWants = IoReactor::kReadable;
+  } else if (err == SSL_ERROR_WANT_WRITE) {
+    c.tlsWants = IoReactor::kWritable;
+  } else {
+    long verify = SSL_get_verify_result(c.ssl);
+    char detail[256];
+    ERR_error_string_n(ERR_get_error(), detail, sizeof detail);
+    fail(c, std::string("TLS handshake failed: ") +
+                (verify != X509_V_OK
+                     ? X509_verify_cert_error_string(verify)
+                     : detail));
+  }
+}
+#endif
+
+void on_connected(Connection &c) {
+  int one = 1;
+  setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+  if (!c.url.tls) {
+    start_upgrade(c);
+    return;
+  }
+#ifdef REACT_IMGUI_TLS
+  if (!s_ssl_ctx) {
+    s_ssl_ctx = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_default_verify_paths(s_ssl_ctx);
+    SSL_CTX_set_verify(s_ssl_ctx, SSL_VERIFY_PEER, nullptr);
+    SSL_CTX_set_min_proto_version(s_ssl_ctx, TLS1_2_VERSION);
+  }
+  c.ssl = SSL_new(s_ssl_ctx);
+  SSL_set_fd(c.ssl, c.fd);
+  SSL_set_tlsext_host_name(c.ssl, c.url.host.c_str());
+  SSL_set1_host(c.ssl, c.url.host.c_str());
+  c.state = State::TlsHandshake;
+  continue_tls(c);
+#else
+  fail(c, "wss:// needs a runtime built with TLS (OpenSSL)");
+#endif
+}
+
+/// Connect to the next address, or fail once none is left.
+void try_connect(Connection &c) {
+  while (c.nextAddr < c.addrs.size()) {
+    const Address &a = c.addrs[c.nextAddr++];
+    int fd = socket(a.addr.ss_family, SOCK_STREAM, 0);
+    if (fd < 0) {
+      c.lastError = errno;
+      continue;
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof one);
+#endif
+    int r = connect(fd, (const sockaddr *)&a.addr, a.len);
+    if (r != 0 && errno != EINPROGRESS) {
+      c.lastError = errno;
+      close(fd);
+      continue;
+    }
+    c.fd = fd;
+    c.watched = 0;
+    s_by_fd[fd] = &c;
+    c.state = State::Connecting;
+    if (r == 0)
+      on_connected(c);
+    return;
+  }
+  fail(c, std::string("Can't connect to ") + c.url.hostHeader + ": " +
+              strerror(c.lastError ? c.lastError : ECONNREFUSED));
+}
+
+/// Parse the response to the upgrade request, once it is all in.
+void parse_handshake(Connection &c) {
+  static const char kEnd[] = "\r\n\r\n";
+  auto end = std::search(c.in.begin(), c.in.end(), kEnd, kEnd + 4);
+  if (end == c.in.end()) {
+    if (c.in.size() > kMaxHandshakeBytes)
+      fail(c, "The upgrade response is too large");
+    return;
+  }
+  std::string head(c.in.begin(), end);
+  c.in.erase(c.in.begin(), end + 4);
+
+  std::unordered_map<std::string, std::string> headers;
+  size_t lineEnd = head.find("\r\n");
+  std::string status = head.substr(0, lineEnd);
+  while (lineEnd != std::string::npos) {
+    size_t start = lineEnd + 2;
+    lineEnd = head.find("\r\n", start);
+    std::string line = head.substr(start, lineEnd == std::string::npos
+                                              ? std::string::npos
+                                              : lineEnd - start);
+    size_t colon = line.find(':');
+    if (colon != std::string::npos)
+      headers[lowercase(trim(line.substr(0, colon)))] =
+          trim(line.substr(colon + 1));
+  }
+
+  if (status.compare(0, 12, "HTTP/1.1 101") != 0) {
+    fail(c, "Unexpected response to the upgrade: " + status);
+    return;
+  }
+  std::array<uint8_t, 20> digest = sha1(c.key + kAcceptGuid);
+  if (lowercase(headers["upgrade"]) != "websocket" ||
+      lowercase(headers["connection"]).find("upgrade") == std::string::npos ||
+      headers["sec-websocket-accept"] != base64(digest.data(), digest.size())) {
+    fail(c, "Invalid upgrade response");
+    return;
+  }
+  if (!headers["sec-websocket-extensions"].empty()) {
+    fail(c, "The server chose an extension that wasn't offered");
+    return;
+  }
+  std::string protocol = headers["sec-websocket-protocol"];
+  if (!protocol.empty()) {
+    bool offered = false;
+    size_t start = 0;
+    while (start <= c.protocols.size()) {
+      size_t comma = c.protocols.find(',', start);
+      if (comma == std::string::npos)
+        comma = c.protocols.size();
+      if (trim(c.protocols.substr(start, comma - start)) == protocol)
+        offered = true;
+      start = comma + 1;
+    }
+    if (!offered) {
+      fail(c, "The server chose a subprotocol that wasn't offered");
+      return;
+    }
+  }
+  c.state = State::Open;
+  push_event(c.id, EventOpen, protocol);
+}
+
+/// The message is complete: hand it to JS.
+void deliver_message(Connection &c, int opcode, std::vector<uint8_t> data) {
+  if (opcode != OpText && c.decoder) {
+    // JS only hears of the rows, with the decoder's next delivery
+    c.decoder->feed_message(data.data(), data.size());
+    return;
+  }
+  Event *event = new Event;
+  event->id = c.id;
+  if (opcode == OpText) {
+    event->kind = EventText;
+    event->text.assign(data.begin(), data.end());
+  } else {
+    event->kind = EventBinary;
+    event->binary = std::move(data);
+  }
+  push_event(event);
+}
+
+/// Parse the complete frames in c.in.
+void parse_frames(Connection &c) {
+  size_t pos = 0;
+  const uint8_t *in = c.in.data();
+  while (c.state == State::Open || c.state == State::Closing) {
+    size_t avail = c.in.size() - pos;
+    if (avail < 2)
+      break;
+    const uint8_t *p = in + pos;
+    bool fin = p[0] & 0x80;
+    int opcode = p[0] & 0x0F;
+    if ((p[0] & 0x70) || (p[1] & 0x80)) {
+      // No extension was negotiated, and servers don't mask
+      fail(c, "Invalid frame header");
+      return;
+    }
+    uint64_t size = p[1] & 0x7F;
+    size_t header = 2;
+    if (size == 126) {
+      if (avail < 4)
+        break;
+      size = (uint64_t)p[2] << 8 | p[3];
+      header = 4;
+    } else if (size == 127) {
+      if (avail < 10)
+        break;
+      // The most significant bit must be 0 (RFC 6455, 5.2)
+      if (p[2] & 0x80) {
+        fail(c, "Invalid frame length");
+        return;
+      }
+      size = 0;
+      for (int i = 0; i < 8; ++i)
+        size = size << 8 | p[2 + i];
+      header = 10;
+    }
+    // c.message never exceeds the limit, so this can't wrap
+    if (size > kMaxMessageBytes - c.message.size()) {
+      c.in.clear();
+      start_close(c, 1009, "Message too big");
+      return;
+    }
+    if (avail - header < size)
+      break;
+    const uint8_t *payload = p + header;
+    pos += header + (size_t)size;
+
+    if (opcode >= OpClose) {
+      if (!fin || size > 125) {
+        fail(c, "Invalid control frame");
+        return;
+      }
+      if (opcode == OpPing) {
+        queue_frame(c, OpPong, payload, (size_t)size, 0);
+      } else if (opcode == OpClose) {
+        c.closeReceived = true;
+        if (size >= 2) {
+          c.closeCode = payload[0] << 8 | payload[1];
+          c.closeReason.assign((const char *)payload + 2, (size_t)size - 2);
+        }
+        if (!c.closeSent) {
+          // Echo the code; the server then closes the socket
+          queue_frame(c, OpClose, payload, size >= 2 ? 2 : 0, 0);
+          c.closeSent = true;
+        }
+        c.state = State::Closing;
+        c.in.clear();
+        return;
+      } else if (opcode != OpPong) {
+        fail(c, "Unknown control frame");
+        return;
+      }
+      continue;
+    }
+
+    if (opcode == OpContinuation) {
+      if (!c.messageOpcode) {
+        fail(c, "Unexpected continuation frame");
+        return;
+      }
+      c.message.insert(c.message.end(), payload, payload + size);
+      if (fin) {
+        int messageOpcode = c.messageOpcode;
+        c.messageOpcode = 0;
+        deliver_message(c, messageOpcode, std::move(c.message));
+        c.message.clear();
+      }
+    } else if (opcode == OpText || opcode == OpBinary) {
+      if (c.messageOpcode) {
+        fail(c, "Expected a continuation frame");
+        return;
+      }
+      if (fin) {
+        deliver_message(c, opcode,
+                        std::vector<uint8_t>(payload, payload + size));
+      } else {
+        c.messageOpcode = opcode;
+        c.message.assign(payload, payload + size);
+      }
+    } else {
+      fail(c, "Unknown opcode");
+      return;
+    }
+  }
+  if (c.state != State::Closed)
+    c.in.erase(c.in.begin(), c.in.begin() + pos);
+}
+
+void read_input(Connection &c) {
+  for (;;) {
+    size_t used = c.in.size();
+    c.in.resize(used + kReadChunk);
+    ssize_t n = raw_read(c, c.in.data() + used, kReadChunk);
+    c.in.resize(used + (n > 0 ? (size_t)n : 0));
+    if (n > 0)
+      continue;
+    if (n == 0) {
+      // A close handshake ended by the server, or a dropped connection
+      if (c.closeReceived)
+        finish(c, c.closeCode, c.closeReason, true);
+      else
+        finish(c, 1006, "", false);
+      return;
+    }
+    if (n == -2) {
+      fail(c, std::string("Read failed: ") + strerror(c.lastError));
+      return;
+    }
+    break;
+  }
+  if (c.state == State::Upgrading)
+    parse_handshake(c);
+  if (c.state == State::Open || c.state == State::Closing)
+    parse_frames(c);
+}
+
+void handle_io(Connection &c, unsigned events) {
+  switch (c.state) {
+  case State::Connecting: {
+    int err = 0;
+    socklen_t len = sizeof err;
+    getsockopt(c.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+    if (err) {
+      c.lastError = err;
+      s_reactor->unwatch(c.fd);
+      s_by_fd.erase(c.fd);
+      close(c.fd);
+      c.fd = -1;
+      try_connect(c);
+    } else {
+      on_connected(c);
+    }
+    break;
+  }
+#ifdef REACT_IMGUI_TLS
+  case State::TlsHandshake:
+    continue_tls(c);
+    break;
+#endif
+  case State::Upgrading:
+  case State::Open:
+  case State::Closing:
+    if (events & IoReactor::kReadable)
+      read_input(c);
+    break;
+  default:
+    break;
+  }
+  if (c.state == State::Upgrading || c.state == State::Open ||
+      c.state == State::Closing)
+    flush_output(c);
+  update_watch(c);
+}
+
+void run_command(Command &command) {
+  if (command.kind == CommandConnect) {
+    uint32_t id = command.id;
+    s_connections[id] = std::move(command.connection);
+    return;
+  }
+  auto it = s_connections.find(command.id);
+  if (it == s_connections.end())
+    return;
+  Connection &c = *it->second;
+  switch (command.kind) {
+  case CommandResolved:
+    if (c.state != State::Resolving)
+      break;
+    if (!command.error.empty()) {
+      fail(c, "Can't resolve " + c.url.host + ": " + command.error);
+      break;
+    }
+    c.addrs = std::move(command.addrs);
+    try_connect(c);
+    break;
+  case CommandSend:
+    if (c.state == State::Open) {
+      queue_frame(c, command.opcode, command.payload.data(),
+                  command.payload.size(), command.payload.size());
+      flush_output(c);
+    } else {
+      c.buffered->fetch_sub(command.payload.size(), std::memory_order_relaxed);
+    }
+    break;
+  case CommandClose:
+    if (c.state == State::Open) {
+      start_close(c, command.code, command.reason);
+      flush_output(c);
+    } else if (c.state != State::Closing && c.state != State::Closed) {
+      fail(c, "The connection was closed before it was established");
+    }
+    break;
+  case CommandDecode:
+    c.decoder = std::move(command.decoder);
+    break;
+  default:
+    break;
+  }
+  update_watch(c);
+}
+
+void io_main() {
+  std::vector<Command> commands;
+  std::vector<IoReactor::Event> ready;
+  while (!s_io_stop.load(std::memory_order_acquire)) {
+    {
+      std::lock_guard<std::mutex> lock(s_commands_mutex);
+      std::swap(commands, s_commands);
+    }
+    for (Command &command : commands)
+      run_command(command);
+    commands.clear();
+
+    ready.clear();
+    s_reactor->wait(kIoWaitMs, &ready);
+    for (const IoReactor::Event &ev : ready) {
+      // A connection closed by an earlier event is no longer found
+      auto it = s_by_fd.find(ev.fd);
+      if (it != s_by_fd.end())
+        handle_io(*it->second, ev.events);
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    for (auto it = s_connections.begin(); it != s_connections.end();) {
+      Connection &c = *it->second;
+      if (c.state == State::Closing && !c.closeReceived &&
+          now > c.closeDeadline)
+        finish(c, 1006, "", false);
+      if (c.state == State::Closed)
+        it = s_connections.erase(it);
+      else
+        ++it;
+    }
+  }
+
+  // Shutdown: no close handshake, and no events
+  for (auto &entry : s_connections) {
+    Connection &c = *entry.second;
+#ifdef REACT_IMGUI_TLS
+    if (c.ssl)
+      SSL_free(c.ssl);
+#endif
+    if (c.fd >= 0) {
+      s_reactor->unwatch(c.fd);
+      close(c.fd);
+    }
+  }
+  s_connections.clear();
+  s_by_fd.clear();
+#ifdef REACT_IMGUI_TLS
+  if (s_ssl_ctx) {
+    SSL_CTX_free(s_ssl_ctx);
+    s_ssl_ctx = nullptr;
+  }
+#endif
+}
+
+/// The id in `args[0]`, or 0 if it isn't a connection of JS.
+uint32_t id_arg(const facebook::jsi::Value *args, size_t count) {
+  if (count < 1 || !args[0].isNumber())
+    return 0;
+  uint32_t id = (uint32_t)args[0].getNumber();
+  return s_buffered.count(id) ? id : 0;
+}
+
+} // namespace
+
+void install_websockets(facebook::jsi::Runtime &rt, ThreadPool &pool,
+                        MainThreadPoster postToMain) {
+  s_runtime = &rt;
+  s_pool = &pool;
+  s_post_to_main.store(postToMain, std::memory_order_release);
+
+  rt.global().setProperty(
+      rt, "__wsConnect",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__wsConnect"), 2,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count < 1 || !args[0].isString())
+              throw facebook::jsi::JSError(rt, "__wsConnect expects a URL");
+            auto c = std::make_unique<Connection>();
+            std::string error =
+                parse_url(args[0].getString(rt).utf8(rt), c->url);
+            if (!error.empty())
+              throw facebook::jsi::JSError(rt, error);
+#ifndef REACT_IMGUI_TLS
+            if (c->url.tls)
+              throw facebook::jsi::JSError(
+                  rt, "wss:// needs a runtime built with TLS (OpenSSL)");
+#endif
+            if (count > 1 && args[1].isString())
+              c->protocols = args[1].getString(rt).utf8(rt);
+            uint32_t id = s_next_id++;
+            c->id = id;
+            c->buffered = std::make_shared<std::atomic<uint64_t>>(0);
+            s_buffered[id] = c->buffered;
+            std::string host = c->url.host;
+            std::string port = c->url.port;
+
+            start_io_thread();
+            Command command{CommandConnect};
+            command.id = id;
+            command.connection = std::move(c);
+            push_command(std::move(command));
+
+            s_pool->post(
+                [id, host, port] {
+                  Command resolved{CommandResolved};
+                  resolved.id = id;
+                  addrinfo hints = {};
+                  hints.ai_family = AF_UNSPEC;
+                  hints.ai_socktype = SOCK_STREAM;
+                  addrinfo *res = nullptr;
+                  int rc =
+                      getaddrinfo(host.c_str(), port.c_str(), &hints, &res);
+                  if (rc != 0) {
+                    resolved.error = gai_strerror(rc);
+                  } else {
+                    for (addrinfo *ai = res; ai; ai = ai->ai_next) {
+                      Address a = {};
+                      memcpy(&a.addr, ai->ai_addr, ai->ai_addrlen);
+                      a.len = ai->ai_addrlen;
+                      resolved.addrs.push_back(a);
+                    }
+                    freeaddrinfo(res);
+                  }
+                  push_command(std::move(resolved));
+                },
+                {TaskPriority::Interactive, TraceTaskResolve});
+            return (double)id;
+          }));
+
+  // __wsSend(id, data, offset, length): a string is sent as text, an
+  // ArrayBuffer (or its [offset, offset + length) range) as binary
+  rt.global().setProperty(
+      rt, "__wsSend",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__wsSend"), 4,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            uint32_t id = id_arg(args, count);
+            if (!id || count < 2)
+              return facebook::jsi::Value::undefined();
+            Command command{CommandSend};
+            command.id = id;
+            if (args[1].isString()) {
+              command.opcode = OpText;
+              command.payload = args[1].getString(rt).utf8(rt);
+            } else if (args[1].isObject() &&
+                       args[1].getObject(rt).isArrayBuffer(rt)) {
+              facebook::jsi::ArrayBuffer ab =
+                  args[1].getObject(rt).getArrayBuffer(rt);
+              size_t size = ab.size(rt);
+              double offset = count > 2 && args[2].isNumber()
+                                  ? args[2].getNumber()
+                                  : 0;
+              double length = count > 3 && args[3].isNumber()
+                                  ? args[3].getNumber()
+                                  : (double)size - offset;
+              if (!(offset >= 0) || !(length >= 0) || offset + length > size)
+                throw facebook::jsi::JSError(rt, "__wsSend: bad range");
+              command.opcode = OpBinary;
+              command.payload.assign(
+                  (const char *)ab.data(rt) + (size_t)offset, (size_t)length);
+            } else {
+              throw facebook::jsi::JSError(
+                  rt, "__wsSend expects a string or an ArrayBuffer");
+            }
+            s_buffered[id]->fetch_add(command.payload.size(),
+                                      std::memory_order_relaxed);
+            push_command(std::move(command));
+            return facebook::jsi::Value::undefined();
+          }));
+
+  rt.global().setProperty(
+      rt, "__wsClose",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__wsClose"), 3,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            uint32_t id = id_arg(args, count);
+            if (!id)
+              return facebook::jsi::Value::undefined();
+            Command command{CommandClose};
+            command.id = id;
+            command.code =
+                count > 1 && args[1].isNumber() ? (int)args[1].getNumber() : 0;
+            if (count > 2 && args[2].isString())
+              command.reason = args[2].getString(rt).utf8(rt);
+            push_command(std::move(command));
+            return facebook::jsi::Value::undefined();
+          }));
+
+  rt.global().setProperty(
+      rt, "__wsDecodeInto",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__wsDecodeInto"), 2,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            uint32_t id = id_arg(args, count);
+            if (!id)
+              return facebook::jsi::Value::undefined();
+            Command command{CommandDecode};
+            command.id = id;
+            if (count > 1 && args[1].isNumber() && args[1].getNumber() != 0) {
+              command.decoder =
+                  find_record_decoder((unsigned)args[1].getNumber());
+              if (!command.decoder)
+                throw facebook::jsi::JSError(rt,
+                                             "__wsDecodeInto: closed decoder");
+            }
+            push_command(std::move(command));
+            return facebook::jsi::Value::undefined();
+          }));
+
+  rt.global().setProperty(
+      rt, "__wsBufferedAmount",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__wsBufferedAmount"), 1,
+          [](facebook::jsi::Runtime &, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            uint32_t id = id_arg(args, count);
+            return id ? (double)s_buffered[id]->load(std::memory_order_relaxed)
+                      : 0.0;
+          }));
+
+  rt.global().setProperty(
+      rt, "__wsOnEvents",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__wsOnEvents"), 1,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count > 0 && args[0].isObject() &&
+                args[0].getObject(rt).isFunction(rt))
+              s_callback = std::make_shared<facebook::jsi::Function>(
+                  args[0].getObject(rt).getFunction(rt));
+            else
+              s_callback.reset();
+            return facebook::jsi::Value::undefined();
+          }));
+}
+
+void shutdown_websockets() {
+  if (s_io_thread.joinable()) {
+    s_io_stop.store(true, std::memory_order_release);
+    s_reactor->wake();
+    s_io_thread.join();
+  }
+  s_post_to_main.store(nullptr, std::memory_order_release);
+  s_reactor.reset();
+  {
+    std::lock_guard<std::mutex> lock(s_commands_mutex);
+    s_commands.clear();
+  }
+  Event *list = s_events.exchange(nullptr, std::memory_order_acquire);
+  while (list) {
+    Event *next = list->next;
+    delete list;
+    list = next;
+  }
+  s_buffered.clear();
+  s_callback.reset();
+  s_runtime = nullptr;
+}
@@ -0,0 +1,40 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include "AsyncFs.h"
+
+#include <hermes/hermes.h>
+
+class ThreadPool;
+
+/// WebSocket client connections (RFC 6455) behind jslib's WebSocket.
+///
+/// Everything but the JS API runs natively: host names are resolved on the
+/// pool, and one I/O thread owns the sockets, waiting on them with an
+/// IoReactor. It does the TLS of wss:// URLs (OpenSSL, when the runtime is
+/// built with REACT_IMGUI_TLS), the HTTP upgrade, the framing, masking,
+/// fragmentation and ping/pong. JS hands it sends and closes through a
+/// command queue.
+///
+/// What the I/O thread receives goes onto a lock-free queue of events. The
+/// first event of a batch posts one delivery to the main thread, so JS gets
+/// all the messages of all the connections in one call per frame, in the
+/// macrotask phase, however many arrived. Binary messages become
+/// ArrayBuffers over the memory the I/O thread assembled them in, without a
+/// copy into the JS heap. A connection given a RecordDecoder decodes its
+/// binary messages on the I/O thread instead, and JS only gets the rows.
+
+/// Install the __wsConnect(url, protocols), __wsSend(id, data),
+/// __wsClose(id, code, reason), __wsDecodeInto(id, decoderId),
+/// __wsBufferedAmount(id) and __wsOnEvents(callback) host functions on the
+/// main runtime, with `pool` for the name lookups and `postToMain` for the
+/// deliveries. The I/O thread starts with the first connection.
+void install_websockets(facebook::jsi::Runtime &rt, ThreadPool &pool,
+                        MainThreadPoster postToMain);
+
+/// Stop the I/O thread, closing the connections without a close handshake,
+/// and forget the callback. Must be called before the runtime is destroyed.
+void shutdown_websockets();
@@ -0,0 +1,547 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#include "WebWorker.h"
+
+#include "MappedFileBuffer.h"
+#include "Notifier.h"
+#include "SharedBuffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/// The jslib unit as bytecode (lib/jslib-unit), for the worker runtimes:
+/// the native jslib unit can only be evaluated by the main runtime.
+extern "C" const unsigned char jslib_hbc[];
+extern "C" const unsigned char jslib_hbc_end[];
+
+namespace {
+
+/// Tasks a worker runs before it looks at its messages again.
+constexpr double kSliceMs = 10;
+/// How long shutdown_web_workers() waits for the workers to stop before it
+/// leaves those that didn't running.
+constexpr std::chrono::milliseconds kStopTimeout{1000};
+
+struct WorkerUnit {
+  std::string name;
+  SHUnitCreator nativeUnit;
+  bool bytecode;
+  std::string path;
+};
+
+/// Registered worker units. Registration runs during static initialization,
+/// so the list is constructed on first use.
+std::vector<WorkerUnit> &worker_units() {
+  static std::vector<WorkerUnit> units;
+  return units;
+}
+
+/// A native unit can only be evaluated by one runtime at a time: those a
+/// worker runs.
+std::mutex s_native_mutex;
+std::unordered_set<SHUnitCreator> s_native_in_use;
+
+/// Bytecode linked into the executable, which isn't freed.
+class EmbeddedBuffer : public facebook::jsi::Buffer {
+public:
+  EmbeddedBuffer(const unsigned char *data, size_t size)
+      : data_(data), size_(size) {}
+  size_t size() const override { return size_; }
+  const uint8_t *data() const override { return data_; }
+
+private:
+  const unsigned char *data_;
+  size_t size_;
+};
+
+/// A message: JSON text, and the buffers it refers to by index.
+struct WorkerMessage {
+  std::string text;
+  SharedBuffers buffers;
+};
+
+/// A unit running on its own runtime and thread, with its own event loop.
+class WebWorker {
+public:
+  WebWorker(unsigned id, WorkerUnit unit,
+            const ::hermes::vm::RuntimeConfig &config,
+            facebook::jsi::Runtime *mainRt);
+  /// Terminates the worker and waits for its thread, unless detach()ed.
+  ~WebWorker();
+
+  WebWorker(const WebWorker &) = delete;
+  WebWorker &operator=(const WebWorker &) = delete;
+
+  /// Queue a message for the worker's onmessage. Main thread.
+  void post(WorkerMessage message);
+  /// Stop the worker, interrupting the JS it is running: the runtime
+  /// throws at its next async-break check, so a task stuck in a loop ends
+  /// too, and an Atomics.wait() returns "timed-out". Main thread.
+  void terminate();
+  /// Whether its thread is done, so that joining it doesn't wait.
+  bool done() const { return done_.load(std::memory_order_acquire); }
+  /// Wait until the thread is done or `deadline` passes. Whether it's done.
+  bool waitDone(std::chrono::steady_clock::time_point deadline);
+  /// Stop owning the thread, for a worker that didn't stop in time. The
+  /// thread goes on using the worker, which must then be leaked.
+  void detach() { thread_.detach(); }
+  unsigned id() const { return id_; }
+
+private:
+  void run();
+  /// Load the jslib and worker units and run the event loop until the
+  /// worker closes or is terminated. Returns the error that ended it, or "".
+  std::string runUnit(facebook::hermes::HermesRuntime &rt);
+  /// Milliseconds since the worker started, its performance.now().
+  double nowMs() const;
+  /// Call the Worker's callback on the main thread.
+  void postToMain(const char *kind, WorkerMessage message);
+
+  unsigned id_;
+  WorkerUnit unit_;
+  ::hermes::vm::RuntimeConfig config_;
+  facebook::jsi::Runtime *mainRt_;
+  std::chrono::steady_clock::time_point start_;
+
+  std::mutex mutex_;
+  std::condition_variable wakeup_;
+  /// Signalled when done_ is set.
+  std::condition_variable stopped_;
+  std::vector<WorkerMessage> inbox_;
+  bool terminated_ = false;
+  /// The worker's runtime while it exists, for terminate() to interrupt.
+  facebook::hermes::HermesRuntime *runtime_ = nullptr;
+  /// Ends the worker's Atomics.wait() calls on terminate().
+  AtomicsWaitAbort waitAbort_;
+
+  /// Set by the worker's close(). Worker thread only.
+  bool closing_ = false;
+  std::atomic<bool> done_{false};
+  std::thread thread_;
+};
+
+std::unique_ptr<::hermes::vm::RuntimeConfig> s_config;
+MainThreadPoster s_post_to_main = nullptr;
+
+/// Running workers and their callbacks, by ID. Main thread only.
+std::unordered_map<unsigned, std::unique_ptr<WebWorker>> s_workers;
+std::unordered_map<unsigned, facebook::jsi::Function> s_callbacks;
+unsigned s_next_worker = 1;
+/// Workers that were terminated or ended, until their threads are joined.
+std::vector<std::unique_ptr<WebWorker>> s_stopped;
+
+/// Join the threads of the stopped workers that are done.
+void reap_stopped_workers() {
+  s_stopped.erase(std::remove_if(s_stopped.begin(), s_stopped.end(),
+                                 [](const std::unique_ptr<WebWorker> &w) {
+                                   return w->done();
+                                 }),
+                  s_stopped.end());
+}
+
+/// Stop tracking worker `id`, whose thread ends or has ended.
+void retire_worker(unsigned id) {
+  s_callbacks.erase(id);
+  auto it = s_workers.find(id);
+  if (it == s_workers.end())
+    return;
+  s_stopped.push_back(std::move(it->second));
+  s_workers.erase(it);
+}
+
+/// Pass an event of worker `id` to its callback. Main thread.
+void deliver(facebook::jsi::Runtime &rt, unsigned id, const char *kind,
+             const WorkerMessage &message) {
+  auto it = s_callbacks.find(id);
+  if (it == s_callbacks.end())
+    return;
+  auto text = facebook::jsi::String::createFromUtf8(rt, message.text);
+  auto buffers = shared_buffers_to_js(rt, message.buffers);
+  if (strcmp(kind, "message") == 0) {
+    it->second.call(rt, kind, text, buffers);
+    return;
+  }
+  // The worker has ended: this is its last event
+  facebook::jsi::Function callback = std::move(it->second);
+  retire_worker(id);
+  callback.call(rt, kind, text, buffers);
+}
+
+WebWorker::WebWorker(unsigned id, WorkerUnit unit,
+                     const ::hermes::vm::RuntimeConfig &config,
+                     facebook::jsi::Runtime *mainRt)
+    : id_(id), unit_(std::move(unit)), config_(config), mainRt_(mainRt),
+      start_(std::chrono::steady_clock::now()) {
+  thread_ = std::thread([this] { run(); });
+}
+
+WebWorker::~WebWorker() {
+  terminate();
+  if (thread_.joinable())
+    thread_.join();
+}
+
+void WebWorker::post(WorkerMessage message) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    inbox_.push_back(std::move(message));
+  }
+  wakeup_.notify_one();
+}
+
+void WebWorker::terminate() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    terminated_ = true;
+    if (runtime_)
+      runtime_->asyncTriggerTimeout();
+  }
+  wakeup_.notify_one();
+  abort_atomics_waits(&waitAbort_);
+}
+
+bool WebWorker::waitDone(std::chrono::steady_clock::time_point deadline) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return stopped_.wait_until(lock, deadline, [this] { return done(); });
+}
+
+double WebWorker::nowMs() const {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start_)
+      .count();
+}
+
+void WebWorker::postToMain(const char *kind, WorkerMessage message) {
+  // Nothing listens once the worker is terminated, and after
+  // shutdown_web_workers() the main runtime may be gone
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (terminated_)
+      return;
+  }
+  facebook::jsi::Runtime *rt = mainRt_;
+  unsigned id = id_;
+  auto shared = std::make_shared<WorkerMessage>(std::move(message));
+  s_post_to_main([rt, id, kind, shared] { deliver(*rt, id, kind, *shared); });
+}
+
+void WebWorker::run() {
+  set_atomics_wait_abort(&waitAbort_);
+  SHRuntime *shr = _sh_init(config_);
+  facebook::hermes::HermesRuntime *rt = _sh_get_hermes_runtime(shr);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    runtime_ = rt;
+    // Terminated before the runtime existed
+    if (terminated_)
+      rt->asyncTriggerTimeout();
+  }
+  std::string error = runUnit(*rt);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    runtime_ = nullptr;
+  }
+  _sh_done(shr);
+  if (unit_.nativeUnit) {
+    std::lock_guard<std::mutex> lock(s_native_mutex);
+    s_native_in_use.erase(unit_.nativeUnit);
+  }
+
+  // Both are dropped if the worker was terminated, which is also how the
+  // interrupted task's error ends up
+  if (!error.empty())
+    postToMain("error", WorkerMessage{std::move(error), {}});
+  else
+    postToMain("exit", {});
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_.store(true, std::memory_order_release);
+  }
+  stopped_.notify_all();
+}
+
+std::string WebWorker::runUnit(facebook::hermes::HermesRuntime &rt) {
+  try {
+    facebook::jsi::Object helpers =
+        rt.evaluateJavaScript(
+              std::make_shared<EmbeddedBuffer>(
+                  jslib_hbc, (size_t)(jslib_hbc_end - jslib_hbc)),
+              "jslib.hbc")
+            .asObject(rt);
+
+#ifdef NDEBUG
+    const char *nodeEnv = "production";
+#else
+    const char *nodeEnv = "development";
+#endif
+    rt.global()
+        .getPropertyAsObject(rt, "process")
+        .getPropertyAsObject(rt, "env")
+        .setProperty(rt, "NODE_ENV", nodeEnv);
+
+    auto perf = facebook::jsi::Object(rt);
+    perf.setProperty(
+        rt, "now",
+        facebook::jsi::Function::createFromHostFunction(
+            rt, facebook::jsi::PropNameID::forAscii(rt, "now"), 0,
+            [this](facebook::jsi::Runtime &, const facebook::jsi::Value &,
+                   const facebook::jsi::Value *,
+                   size_t) -> facebook::jsi::Value { return nowMs(); }));
+    rt.global().setProperty(rt, "performance", perf);
+
+    rt.global().setProperty(
+        rt, "__drainMicrotasks",
+        facebook::jsi::Function::createFromHostFunction(
+            rt, facebook::jsi::PropNameID::forAscii(rt, "__drainMicrotasks"),
+            0,
+            [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+               const facebook::jsi::Value *,
+               size_t) -> facebook::jsi::Value {
+              rt.drainMicrotasks();
+              return facebook::jsi::Value::undefined();
+            }));
+
+    install_shared_buffers(rt);
+    install_notify(rt);
+
+    // The worker's postMessage(), as post(text, buffers, transfer), and
+    // close()
+    auto post = facebook::jsi::Function::createFromHostFunction(
+        rt, facebook::jsi::PropNameID::forAscii(rt, "post"), 3,
+        [this](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+               const facebook::jsi::Value *args,
+               size_t count) -> facebook::jsi::Value {
+          if (count < 1 || !args[0].isString())
+            throw facebook::jsi::JSError(rt, "post expects a string");
+          auto undefined = facebook::jsi::Value::undefined();
+          postToMain("message",
+                     WorkerMessage{args[0].getString(rt).utf8(rt),
+                                   shared_buffers_for_message(
+                                       rt, count > 1 ? args[1] : undefined,
+                                       count > 2 ? args[2] : undefined)});
+          return facebook::jsi::Value::undefined();
+        });
+    auto close = facebook::jsi::Function::createFromHostFunction(
+        rt, facebook::jsi::PropNameID::forAscii(rt, "close"), 0,
+        [this](facebook::jsi::Runtime &, const facebook::jsi::Value &,
+               const facebook::jsi::Value *,
+               size_t) -> facebook::jsi::Value {
+          closing_ = true;
+          return facebook::jsi::Value::undefined();
+        });
+    helpers.getPropertyAsFunction(rt, "workerScope").call(rt, post, close);
+
+    // jslib's current time, for the timers the unit sets
+    helpers.getPropertyAsFunction(rt, "run").call(rt, nowMs());
+    if (unit_.nativeUnit) {
+      rt.evaluateSHUnit(unit_.nativeUnit);
+    } else {
+      auto buffer = mapFileBuffer(unit_.path.c_str(), !unit_.bytecode);
+      rt.evaluateJavaScript(buffer, unit_.path);
+    }
+
+    facebook::jsi::Function runReady =
+        helpers.getPropertyAsFunction(rt, "runReady");
+    facebook::jsi::Function queueMessage =
+        helpers.getPropertyAsFunction(rt, "queueMessage");
+    std::vector<WorkerMessage> inbox;
+    while (!closing_) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (terminated_)
+          break;
+        inbox.swap(inbox_);
+      }
+      for (const WorkerMessage &message : inbox) {
+        queueMessage.call(
+            rt, facebook::jsi::String::createFromUtf8(rt, message.text),
+            shared_buffers_to_js(rt, message.buffers));
+      }
+      inbox.clear();
+      double next = runReady.call(rt, nowMs(), kSliceMs).asNumber();
+      rt.drainMicrotasks();
+      if (closing_)
+        break;
+
+      // Sleep until the next timer or message
+      std::unique_lock<std::mutex> lock(mutex_);
+      auto woken = [&] { return terminated_ || !inbox_.empty(); };
+      if (next < 0) {
+        wakeup_.wait(lock, woken);
+      } else if (double wait = next - nowMs(); wait > 0) {
+        wakeup_.wait_for(lock, std::chrono::duration<double, std::milli>(wait),
+                         woken);
+      }
+    }
+    return {};
+  } catch (facebook::jsi::JSIException &e) {
+    return e.what();
+  } catch (const std::exception &e) {
+    return std::string("Worker '") + unit_.name + "': " + e.what();
+  }
+}
+
+/// The worker settings with the heap capped at `maxHeap` bytes. The
+/// initial and minimum sizes shrink with it if needed.
+::hermes::vm::RuntimeConfig capped_config(::hermes::vm::gcheapsize_t maxHeap) {
+  const ::hermes::vm::GCConfig &gc = s_config->getGCConfig();
+  auto builder = gc.rebuild().withMaxHeapSize(maxHeap);
+  if (gc.getInitHeapSize() > maxHeap)
+    builder.withInitHeapSize(maxHeap);
+  if (gc.getMinHeapSize() > maxHeap)
+    builder.withMinHeapSize(maxHeap);
+  return s_config->rebuild().withGCConfig(builder.build()).build();
+}
+
+bool ends_with(const std::string &s, const char *suffix) {
+  size_t n = strlen(suffix);
+  return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+} // namespace
+
+void add_web_worker_unit(const char *name, SHUnitCreator nativeUnit,
+                         bool bytecode, const char *path) {
+  worker_units().push_back(
+      WorkerUnit{name, nativeUnit, bytecode, path ? path : ""});
+}
+
+void install_web_workers(facebook::jsi::Runtime &rt,
+                         const ::hermes::vm::RuntimeConfig &config,
+                         MainThreadPoster postToMain) {
+  s_config = std::make_unique<::hermes::vm::RuntimeConfig>(config);
+  s_post_to_main = postToMain;
+  install_shared_buffers(rt);
+
+  rt.global().setProperty(
+      rt, "__workerCreate",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__workerCreate"), 3,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count < 2 || !args[0].isString() || !args[1].isObject() ||
+                !args[1].getObject(rt).isFunction(rt)) {
+              throw facebook::jsi::JSError(
+                  rt, "__workerCreate expects a name and a callback");
+            }
+            double maxHeap =
+                count > 2 && args[2].isNumber() ? args[2].getNumber() : 0;
+            if (!(maxHeap >= 0) ||
+                maxHeap > (double)std::numeric_limits<
+                              ::hermes::vm::gcheapsize_t>::max())
+              throw facebook::jsi::JSError(
+                  rt, "__workerCreate: bad heap size");
+            reap_stopped_workers();
+            std::string name = args[0].getString(rt).utf8(rt);
+            std::vector<WorkerUnit> &units = worker_units();
+            auto it = std::find_if(
+                units.begin(), units.end(),
+                [&](const WorkerUnit &u) { return u.name == name; });
+            WorkerUnit unit;
+            if (it != units.end())
+              unit = *it;
+            else if (ends_with(name, ".hbc") || ends_with(name, ".js"))
+              unit = WorkerUnit{name, nullptr, ends_with(name, ".hbc"), name};
+            else
+              throw facebook::jsi::JSError(
+                  rt, "Unknown worker unit '" + name + "'");
+
+            if (unit.nativeUnit) {
+              std::lock_guard<std::mutex> lock(s_native_mutex);
+              if (!s_native_in_use.insert(unit.nativeUnit).second) {
+                throw facebook::jsi::JSError(
+                    rt, "Worker unit '" + name +
+                            "' is already running: native units run in one "
+                            "worker at a time");
+              }
+            }
+            unsigned id = s_next_worker++;
+            s_callbacks.emplace(id, args[1].getObject(rt).getFunction(rt));
+            s_workers.emplace(
+                id, std::make_unique<WebWorker>(
+                        id, std::move(unit),
+                        maxHeap > 0
+                            ? capped_config((::hermes::vm::gcheapsize_t)maxHeap)
+                            : *s_config,
+                        &rt));
+            return (double)id;
+          }));
+
+  rt.global().setProperty(
+      rt, "__workerPost",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__workerPost"), 4,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count < 2 || !args[0].isNumber() || !args[1].isString())
+              throw facebook::jsi::JSError(
+                  rt, "__workerPost expects a worker ID and a string");
+            auto it = s_workers.find((unsigned)args[0].getNumber());
+            if (it == s_workers.end())
+              return facebook::jsi::Value::undefined();
+            auto undefined = facebook::jsi::Value::undefined();
+            it->second->post(
+                WorkerMessage{args[1].getString(rt).utf8(rt),
+                              shared_buffers_for_message(
+                                  rt, count > 2 ? args[2] : undefined,
+                                  count > 3 ? args[3] : undefined)});
+            return facebook::jsi::Value::undefined();
+          }));
+
+  rt.global().setProperty(
+      rt, "__workerTerminate",
+      facebook::jsi::Function::createFromHostFunction(
+          rt, facebook::jsi::PropNameID::forAscii(rt, "__workerTerminate"), 1,
+          [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+             const facebook::jsi::Value *args,
+             size_t count) -> facebook::jsi::Value {
+            if (count < 1 || !args[0].isNumber())
+              throw facebook::jsi::JSError(
+                  rt, "__workerTerminate expects a worker ID");
+            unsigned id = (unsigned)args[0].getNumber();
+            auto it = s_workers.find(id);
+            if (it != s_workers.end())
+              it->second->terminate();
+            retire_worker(id);
+            return facebook::jsi::Value::undefined();
+          }));
+}
+
+void shutdown_web_workers() {
+  for (auto &[id, worker] : s_workers) {
+    worker->terminate();
+    s_stopped.push_back(std::move(worker));
+  }
+  s_workers.clear();
+  // One deadline for all of them. A worker still running after it, such
+  // as one blocked in native code, is detached and leaked rather than
+  // holding up the exit.
+  auto deadline = std::chrono::steady_clock::now() + kStopTimeout;
+  for (std::unique_ptr<WebWorker> &worker : s_stopped) {
+    if (worker->waitDone(deadline))
+      continue;
+    fprintf(stderr, "Worker %u didn't stop, leaving its thread running\n",
+            worker->id());
+    worker->detach();
+    (void)worker.release();
+  }
+  // The destructors join the threads that are done
+  s_stopped.clear();
+  s_callbacks.clear();
+}
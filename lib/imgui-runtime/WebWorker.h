@@ -0,0 +1,47 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+#pragma once
+
+#include "AsyncFs.h"
+
+#include <hermes/VM/static_h.h>
+#include <hermes/hermes.h>
+
+/// Register a worker unit (add_react_imgui_app(WORKERS ...)), which
+/// `new Worker(name)` runs. `nativeUnit` is set in mode 0; otherwise `path`
+/// is its bytecode (`bytecode`) or source file. Called during static
+/// initialization.
+void add_web_worker_unit(const char *name, SHUnitCreator nativeUnit,
+                         bool bytecode, const char *path);
+
+/// Install the host functions behind jslib's Worker:
+/// - __workerCreate(name, callback, maxHeap) starts a worker and returns its
+///   ID. The worker gets its own runtime, created with `config`, and thread.
+///   It runs the jslib event loop and the worker unit `name`; a name that
+///   isn't registered is the path of a .hbc or .js file to run instead. A
+///   non-zero `maxHeap` caps the worker's heap at that many bytes instead
+///   of `config`'s max_heap (plugin panels, see plugin-panel.js).
+/// - __workerPost(id, text, buffers, transfer) queues a message for the
+///   worker: JSON text, the ArrayBuffers it refers to, and which of them
+///   are transferred (see SharedBuffer.h).
+/// - __workerTerminate(id) stops it: a task it is running is interrupted
+///   at the runtime's next async-break check (see shutdown_web_workers()
+///   for one that can't be).
+/// __createSharedMemory() and the Atomics functions are installed in all
+/// the runtimes (install_shared_buffers()).
+/// `callback(kind, text, buffers)` is called on the main thread, through
+/// `postToMain`, for each message the worker posts ("message"), when it
+/// fails to load or dies ("error"), and when it closes itself ("exit").
+void install_web_workers(facebook::jsi::Runtime &rt,
+                         const ::hermes::vm::RuntimeConfig &config,
+                         MainThreadPoster postToMain);
+
+/// Stop the workers, wait for their threads and forget their callbacks.
+/// Must be called before the runtime is destroyed, while nothing runs the
+/// functions they post. A worker that hasn't stopped within a second (one
+/// blocked in native code, which the interrupt doesn't reach) is detached
+/// and leaked with a warning on stderr instead of being joined; it posts
+/// nothing more, and its thread ends with the process.
+void shutdown_web_workers();
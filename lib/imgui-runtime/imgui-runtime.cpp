@@ -3,6 +3,42 @@
 // See LICENSE file for full license text
 
 #include "imgui-runtime.h"
+#include "Animation.h"
+#include "AsyncFs.h"
+#include "Audio.h"
+#include "ColumnarParse.h"
+#include "ColumnStore.h"
+#include "CompressedTexture.h"
+#include "DrawSnapshot.h"
+#include "Fetch.h"
+#include "FileDrop.h"
+#include "FileWatcher.h"
+#include "FilterIndex.h"
+#include "FontAtlasCache.h"
+#include "FontRegistry.h"
+#include "FrameCapture.h"
+#include "GlyphCache.h"
+#include "GpuStats.h"
+#include "Hotkeys.h"
+#include "ImageAtlas.h"
+#include "NativeTasks.h"
+#include "InputScript.h"
+#include "IoReactor.h"
+#include "PerfHud.h"
+#include "Notifier.h"
+#include "RecordDecoder.h"
+#include "RecordRing.h"
+#include "RuntimeMetrics.h"
+#include "SettingsStore.h"
+#include "SharedBuffer.h"
+#include "StreamTexture.h"
+#include "TableKernels.h"
+#include "TextView.h"
+#include "ThreadPool.h"
+#include "TimeSeries.h"
+#include "Trace.h"
+#include "WebSocket.h"
+#include "WebWorker.h"
 
 #include "sokol_app.h"
 #include "sokol_gfx.h"
@@ -11,15 +47,73 @@
 #include "sokol_time.h"
 #include "stb_image.h"
 
+#define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
+#include "cimgui.h"
 #include "sokol_imgui.h"
 
 // Must be separate to avoid reordering.
 #include "sokol_debugtext.h"
 
+// Runtime swap interval changes, defined in external/sokol/sokol.c.
+extern "C" void sapp_set_swap_interval(int interval);
+extern "C" int sapp_swap_interval(void);
+// Draws an ImDrawData captured on another thread, defined in
+// external/sokol/sokol.c.
+extern "C" void simgui_render_draw_data(ImDrawData *draw_data,
+                                        float dpi_scale);
+// Passes an input event to ImGui without sokol_imgui, defined in
+// external/sokol/sokol.c.
+extern "C" void simgui_feed_event(const sapp_event *ev);
+// Time the font atlas build in the last simgui_setup() took, defined in
+// external/sokol/sokol.c.
+extern "C" double simgui_font_atlas_ms(void);
+// Builds the atlas in simgui_setup() through the font atlas cache.
+extern "C" void simgui_set_font_atlas_builder(void (*builder)(ImFontAtlas *));
+// Gives the context of simgui_setup() an atlas built ahead of it.
+extern "C" void simgui_set_shared_font_atlas(ImFontAtlas *atlas);
+// Makes the font atlas texture again after simgui_setup(), optionally
+// dynamic.
+extern "C" void simgui_make_font_image(bool dynamic);
+// Usage of sokol_imgui's vertex and index buffers, which grow and shrink
+// with the draw data; mirrors the struct in external/sokol/sokol.c.
+struct simgui_draw_buffer_stats_t {
+  int vertices;
+  int indices;
+  int vertex_capacity;
+  int index_capacity;
+  int vertex_high_water;
+  int index_high_water;
+  int resizes;
+};
+extern "C" void simgui_draw_buffer_stats(simgui_draw_buffer_stats_t *stats);
+// Vertex capacity the buffers start with, a quarter of sokol_imgui's
+// default; enough for typical apps, and dense ones grow them.
+static constexpr int kInitialDrawVertices = 16384;
+
 #include <hermes/VM/static_h.h>
 
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <cstddef>
 #include <climits>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 // Hermes runtime and event loop management
@@ -29,13 +123,55 @@ public:
   facebook::hermes::HermesRuntime *hermes = nullptr;
   facebook::jsi::Function peekMacroTask;
   facebook::jsi::Function runMacroTask;
+  /// runReady(curTimeMs, budgetMs): runs all due macrotasks within the
+  /// budget and returns the next deadline (-1 if none).
+  facebook::jsi::Function runReady;
   facebook::jsi::Function flushRaf;
+  /// runIdle(remainingMs): runs requestIdleCallback() callbacks in the time
+  /// left before the next vsync; returns true if some are still queued.
+  facebook::jsi::Function runIdle;
+  /// queueIo(fd, events): queues the callback of a watched fd that became
+  /// ready as an immediate.
+  facebook::jsi::Function queueIo;
+  /// windowResized(width, height): the window size of the coming frame
+  /// differs from the previous frame's.
+  facebook::jsi::Function windowResized;
+  /// beforeHotReload(): runs the onHotReload() handlers before the bundle is
+  /// evaluated again.
+  facebook::jsi::Function beforeHotReload;
+  /// symbolicateProfile(profile, sourceMap, bundleNames): maps the call
+  /// frames of a DevTools profile through a source map.
+  facebook::jsi::Function symbolicateProfile;
+
+  /// Entry points of the imgui unit, set by resolveEntryPoints() once it has
+  /// been loaded.
+  std::optional<facebook::jsi::Function> onInit;
+  std::optional<facebook::jsi::Function> onFrame;
+  std::optional<facebook::jsi::Function> onEvents;
 
-  HermesApp(SHRuntime *shr, facebook::jsi::Function &&peek,
-            facebook::jsi::Function &&run, facebook::jsi::Function &&flushRaf)
+  /// `helpers` is the object returned by the jslib unit.
+  HermesApp(SHRuntime *shr, const facebook::jsi::Object &helpers)
       : shRuntime(shr, &_sh_done), hermes(_sh_get_hermes_runtime(shr)),
-        peekMacroTask(std::move(peek)), runMacroTask(std::move(run)),
-        flushRaf(std::move(flushRaf)) {}
+        peekMacroTask(helpers.getPropertyAsFunction(*hermes, "peek")),
+        runMacroTask(helpers.getPropertyAsFunction(*hermes, "run")),
+        runReady(helpers.getPropertyAsFunction(*hermes, "runReady")),
+        flushRaf(helpers.getPropertyAsFunction(*hermes, "flushRaf")),
+        runIdle(helpers.getPropertyAsFunction(*hermes, "runIdle")),
+        queueIo(helpers.getPropertyAsFunction(*hermes, "queueIo")),
+        windowResized(helpers.getPropertyAsFunction(*hermes, "windowResized")),
+        beforeHotReload(
+            helpers.getPropertyAsFunction(*hermes, "beforeHotReload")),
+        symbolicateProfile(
+            helpers.getPropertyAsFunction(*hermes, "symbolicateProfile")) {}
+
+  /// Look up on_init(), on_frame() and on_events(), which the imgui unit
+  /// defines on globalThis.
+  void resolveEntryPoints() {
+    auto global = hermes->global();
+    onInit = global.getPropertyAsFunction(*hermes, "on_init");
+    onFrame = global.getPropertyAsFunction(*hermes, "on_frame");
+    onEvents = global.getPropertyAsFunction(*hermes, "on_events");
+  }
 
   // Delete copy/move to ensure singleton behavior
   HermesApp(const HermesApp &) = delete;
@@ -47,59 +183,744 @@ public:
 static HermesApp *s_hermesApp = nullptr;
 
 static sg_sampler s_sampler = {};
+/// Trilinear sampler of the images loaded with mipmaps.
+static sg_sampler s_mip_sampler = {};
+
+// Headless mode, for benchmarks and CI machines without a display. Enabled
+// with --headless on the command line: sokol_main() then runs a fixed
+// number of frames itself instead of handing control to sokol_app, and
+// exits with timing stats. ImGui builds every frame as usual, but nothing is
+// submitted to a GPU.
+struct HeadlessOptions {
+  bool enabled = false;
+  /// --frames=N, also the frames timed by a windowed benchmark run.
+  int frames = 600;
+  /// --frame-ms=MS: the simulated frame duration, passed to ImGui and to
+  /// on_frame() and used for the macrotask budget, and the step of the
+  /// benchmark clock. Frames don't wait for it.
+  double frameMs = 1000.0 / 60.0;
+  /// --size=WxH, defaulting to sappConfig.width/height.
+  int width = 0;
+  int height = 0;
+  /// --max-native-bytes=N and --max-js-bytes=N: fail the run if a frame
+  /// after the first --warmup=N allocates more native (imgui unit helpers
+  /// and ImGui) or Hermes heap bytes than this. -1 disables a check.
+  double maxNativeBytes = -1;
+  double maxJsBytes = -1;
+  /// Also the frames a windowed benchmark run leaves out of its timing.
+  int warmupFrames = 60;
+  /// --script=PATH: input script to replay (see InputScript.h). The run is
+  /// extended to the last scripted frame, and the script's size applies
+  /// unless --size is given.
+  const char *script = nullptr;
+  /// --report=PATH: write the results as JSON.
+  const char *report = nullptr;
+};
+static HeadlessOptions s_headless{};
+
+// Benchmark mode, to compare the throughput of builds. Enabled with --bench
+// on the command line: frames are presented without waiting for vsync
+// (where the platform allows it) and every frame is rendered, while
+// performance.now(), the timers, the rAF timestamps, native animations and
+// on_frame() follow a clock that advances by exactly --frame-ms per frame.
+// Each run then does the same work, however fast it goes. Windowed runs
+// quit after --warmup and --frames frames and print the frame rate of the
+// latter. Works with --headless and threaded mode; workers keep the real
+// clock.
+struct BenchmarkOptions {
+  bool enabled = false;
+  /// --seed=N: seed Math.random() (see seedRandom() in jslib), with or
+  /// without --bench.
+  bool seeded = false;
+  double seed = 0;
+};
+static BenchmarkOptions s_bench{};
+/// The benchmark clock in ms, on the thread that runs JS.
+static double s_bench_clock_ms = 0;
+/// Frames ended by a windowed benchmark run, and the end of its warmup.
+static int s_bench_frames = 0;
+static uint64_t s_bench_start = 0;
+
+/// The clock of the timers and performance.now(), in ms.
+static double js_clock_ms() {
+  return s_bench.enabled ? s_bench_clock_ms : stm_ms(stm_now());
+}
+
+/// The duration of a window's frames in seconds: the display's, or the
+/// step of the benchmark clock.
+static double frame_duration_sec() {
+  return s_bench.enabled ? s_headless.frameMs / 1000.0 : sapp_frame_duration();
+}
+
+/// End a frame of a benchmark run: advance the clock by one step, and in a
+/// window, time the frames after the warmup and quit once --frames of them
+/// have run. On the thread that runs JS.
+static void bench_frame_end() {
+  if (!s_bench.enabled)
+    return;
+  s_bench_clock_ms += s_headless.frameMs;
+  if (s_headless.enabled)
+    return;
+  int frame = s_bench_frames++;
+  if (frame == s_headless.warmupFrames) {
+    s_bench_start = stm_now();
+  } else if (frame == s_headless.warmupFrames + s_headless.frames) {
+    double totalMs = stm_ms(stm_since(s_bench_start));
+    printf("Benchmark: %d frames in %.1fms, %.1f frames/s, %.3fms per frame\n",
+           s_headless.frames, totalMs, s_headless.frames * 1000.0 / totalMs,
+           totalMs / s_headless.frames);
+    sapp_request_quit();
+  }
+}
+
+/// Startup phases, from sokol_main() to the first presented frame. Printed
+/// when IMGUI_STARTUP_TIMES is set and returned by __startupTimes().
+enum StartupPhase {
+  StartupRuntimeInit,
+  StartupJslibUnit,
+  StartupImguiMain,
+  StartupBundleMap,
+  StartupBundleEval,
+  StartupImguiUnit,
+  StartupWindow,
+  StartupGfxSetup,
+  StartupFontAtlas,
+  StartupOnInit,
+  StartupFirstFrame,
+  StartupPhaseCount
+};
+
+struct StartupPhaseInfo {
+  /// Property name in __startupTimes().
+  const char *key;
+  const char *label;
+  /// Phases of depth 1 are part of the preceding phase of depth 0.
+  int depth;
+};
+
+static const StartupPhaseInfo kStartupPhases[StartupPhaseCount] = {
+    {"runtimeInit", "_sh_init", 0},
+    {"jslibUnit", "jslib unit", 0},
+    {"imguiMain", "imgui_main", 0},
+    {"bundleMap", "map bundle", 1},
+    {"bundleEval", "evaluate React unit", 1},
+    {"imguiUnit", "imgui unit", 0},
+    {"window", "window and GPU context", 0},
+    {"gfxSetup", "sokol and ImGui setup", 0},
+    {"fontAtlas", "font atlas", 1},
+    {"onInit", "on_init", 0},
+    {"firstFrame", "first frame", 0},
+};
+
+/// Start (since stm_setup()) and duration of every phase in ms, negative
+/// until measured. Written by the main thread, except onInit in threaded
+/// mode, which the JS thread writes before its first frame; readers on
+/// other threads wait for s_startup_done.
+static double s_startup_start[StartupPhaseCount];
+static double s_startup_ms[StartupPhaseCount];
+/// Major (I/O) and minor page faults of the process during every phase
+/// measured with startup_begin()/startup_end().
+static double s_startup_major_faults[StartupPhaseCount];
+static double s_startup_minor_faults[StartupPhaseCount];
+/// Set when the first frame has been presented.
+static std::atomic<bool> s_startup_done{false};
+
+static void page_faults(double &major, double &minor) {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  major = (double)usage.ru_majflt;
+  minor = (double)usage.ru_minflt;
+}
+
+/// Peak resident set size of the process in bytes.
+static double peak_rss_bytes() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return (double)usage.ru_maxrss;
+#else
+  return (double)usage.ru_maxrss * 1024;
+#endif
+}
+
+/// The phases before the first frame are also trace events, for captures
+/// started with IMGUI_TRACE.
+static void startup_begin(StartupPhase phase) {
+  // A hot reload evaluates the bundle again; the phases keep their startup
+  // values
+  if (s_startup_done.load(std::memory_order_relaxed))
+    return;
+  s_startup_start[phase] = stm_ms(stm_now());
+  page_faults(s_startup_major_faults[phase], s_startup_minor_faults[phase]);
+  if (trace_capturing())
+    trace_begin(trace_intern(kStartupPhases[phase].label));
+}
+
+static void startup_end(StartupPhase phase) {
+  if (s_startup_done.load(std::memory_order_relaxed))
+    return;
+  s_startup_ms[phase] = stm_ms(stm_now()) - s_startup_start[phase];
+  double major, minor;
+  page_faults(major, minor);
+  s_startup_major_faults[phase] = major - s_startup_major_faults[phase];
+  s_startup_minor_faults[phase] = minor - s_startup_minor_faults[phase];
+  trace_end();
+}
+
+/// How the React bundle (and the lazy units) are mapped, from the comma
+/// separated IMGUI_BUNDLE_MAP flags populate, willneed, sequential and
+/// hugepages (see MapFileOptions).
+static MapFileOptions s_bundle_map_options{};
+
+/// Worker threads for blocking native work, such as fs.promises requests,
+/// and for the startup jobs that overlap _sh_init() and unit loading.
+static std::unique_ptr<ThreadPool> s_thread_pool;
+/// The bundle file registered by <target>-units.cpp, empty in mode 0.
+static std::string &bundle_file() {
+  static std::string path;
+  return path;
+}
+
+void imgui_register_bundle_file(const char *path) { bundle_file() = path; }
+
+namespace {
+/// The bytecode linked into the executable by REACT_EMBED_BYTECODE. It lives
+/// as long as the process, so the buffer only points at it.
+class EmbeddedBuffer : public facebook::jsi::Buffer {
+public:
+  EmbeddedBuffer(const unsigned char *data, size_t size)
+      : data_(data), size_(size) {}
+  size_t size() const override { return size_; }
+  const uint8_t *data() const override { return data_; }
+
+private:
+  const unsigned char *data_;
+  size_t size_;
+};
+
+const unsigned char *s_embedded_bundle = nullptr;
+size_t s_embedded_bundle_size = 0;
+} // namespace
+
+void imgui_register_embedded_bundle(const unsigned char *data, size_t size) {
+  s_embedded_bundle = data;
+  s_embedded_bundle_size = size;
+}
+
+/// The React vendor unit, evaluated before the app's native unit.
+static SHUnitCreator s_vendor_unit = nullptr;
+
+void imgui_register_vendor_unit(SHUnitCreator vendorUnit) {
+  s_vendor_unit = vendorUnit;
+}
+
+/// Parse IMGUI_BUNDLE_MAP and, with its `prefetch` flag, start reading the
+/// bundle on a worker thread, so that it is in the page cache by the time
+/// it is mapped. Called before _sh_init(), which it overlaps.
+static void setup_bundle_map(const char *flags) {
+  bool prefetch = false;
+  std::stringstream stream(flags);
+  std::string flag;
+  while (std::getline(stream, flag, ',')) {
+    if (flag == "populate")
+      s_bundle_map_options.populate = true;
+    else if (flag == "willneed")
+      s_bundle_map_options.willNeed = true;
+    else if (flag == "sequential")
+      s_bundle_map_options.sequential = true;
+    else if (flag == "hugepages")
+      s_bundle_map_options.hugePages = true;
+    else if (flag == "prefetch")
+      prefetch = true;
+    else if (!flag.empty())
+      fprintf(stderr, "IMGUI_BUNDLE_MAP: unknown flag '%s'\n", flag.c_str());
+  }
+  if (prefetch && !bundle_file().empty()) {
+    // Only warms the page cache; nothing waits for it
+    s_thread_pool->post(
+        [path = bundle_file()] {
+          if (!prefetchFile(path.c_str()))
+            fprintf(stderr, "Can't prefetch %s\n", path.c_str());
+        },
+        {TaskPriority::Background, TraceTaskFs});
+  }
+}
+
+/// Time from stm_setup() to the end of the first frame.
+static double startup_total_ms() {
+  return s_startup_start[StartupFirstFrame] + s_startup_ms[StartupFirstFrame];
+}
+
+static void print_startup_times() {
+  printf("Startup times (ms, major/minor page faults):\n");
+  for (int i = 0; i < StartupPhaseCount; ++i) {
+    const StartupPhaseInfo &info = kStartupPhases[i];
+    if (s_startup_ms[i] < 0)
+      continue;
+    printf("  %*s%-*s %8.2f", info.depth * 2, "", 26 - info.depth * 2,
+           info.label, s_startup_ms[i]);
+    if (s_startup_start[i] >= 0)
+      printf("  at %8.2f  %5.0f/%.0f", s_startup_start[i],
+             s_startup_major_faults[i], s_startup_minor_faults[i]);
+    printf("\n");
+  }
+  double major, minor;
+  page_faults(major, minor);
+  printf("  %-26s %8.2f  process %5.0f/%.0f\n", "total", startup_total_ms(),
+         major, minor);
+  printf("  %-26s %8.1f MB\n", "peak RSS", peak_rss_bytes() / (1024 * 1024));
+}
+
+/// Call at the start of every frame until the first one has been presented.
+/// The frame has its own trace event.
+static void startup_frame_begin() {
+  if (s_startup_start[StartupFirstFrame] < 0)
+    s_startup_start[StartupFirstFrame] = stm_ms(stm_now());
+}
 
-std::array<InternalImage *, 0> s_internalImages;
+/// Call once a frame with the app's content has been presented (or, in
+/// headless runs, rendered); the first call completes the startup times.
+static void startup_frame_end() {
+  if (s_startup_done.load(std::memory_order_relaxed))
+    return;
+  s_startup_ms[StartupFirstFrame] =
+      stm_ms(stm_now()) - s_startup_start[StartupFirstFrame];
+  s_startup_done.store(true, std::memory_order_release);
+  if (getenv("IMGUI_STARTUP_TIMES"))
+    print_startup_times();
+}
+
+namespace {
+/// An image embedded in the executable.
+struct InternalImage {
+  std::string name;
+  const unsigned char *data;
+  size_t size;
+};
+
+/// The embedded images, and their indexes by name.
+struct InternalImages {
+  std::vector<InternalImage> list;
+  std::unordered_map<std::string, size_t> byName;
+};
+} // namespace
+
+/// Registration runs during static initialization, so the registry is
+/// constructed on first use. It is only read once main() has started.
+static InternalImages &internal_images() {
+  static InternalImages images;
+  return images;
+}
+
+void imgui_register_image(const char *name, const unsigned char *data,
+                          size_t size) {
+  InternalImages &images = internal_images();
+  auto [it, inserted] = images.byName.emplace(name, images.list.size());
+  if (inserted)
+    images.list.push_back(InternalImage{name, data, size});
+  else
+    images.list[it->second] = InternalImage{name, data, size};
+}
+
+/// The index of the embedded image `name`, or -1.
+static int find_internal_image(const char *name) {
+  const InternalImages &images = internal_images();
+  auto it = images.byName.find(name);
+  return it == images.byName.end() ? -1 : (int)it->second;
+}
+
+/// Mip levels 1 and down of an RGBA8 image, each half the size of the one
+/// before, to 1x1.
+using MipLevels = std::vector<std::vector<unsigned char>>;
+
+/// Pixels of an image, decoded to RGBA8 ahead of its upload, or its
+/// `compressed` texture. Neither is set, with the `failure` reason, if it
+/// couldn't be loaded. `mipmaps` images get the `mips` of their pixels.
+struct DecodedImage {
+  int w = 0, h = 0;
+  unsigned char *data = nullptr;
+  std::shared_ptr<CompressedTexture> compressed;
+  bool mipmaps = false;
+  std::shared_ptr<MipLevels> mips;
+  const char *failure = nullptr;
+
+  bool ok() const { return data || compressed; }
+
+  /// Size of the texture.
+  size_t gpuBytes() const {
+    if (compressed)
+      return compressed->level.size;
+    size_t bytes = (size_t)w * h * 4;
+    if (mips)
+      for (const auto &level : *mips)
+        bytes += level.size();
+    return bytes;
+  }
+};
+
+/// The mip chain of `w` x `h` RGBA8 `pixels`, by 2x2 box filtering. Colors
+/// are weighted by alpha, so that transparent pixels don't darken the
+/// edges of shapes.
+static std::shared_ptr<MipLevels>
+generate_mipmaps(int w, int h, const unsigned char *pixels) {
+  auto mips = std::make_shared<MipLevels>();
+  const unsigned char *src = pixels;
+  int level = 1;
+  while ((w > 1 || h > 1) && level < SG_MAX_MIPMAPS) {
+    int dw = std::max(w / 2, 1), dh = std::max(h / 2, 1);
+    std::vector<unsigned char> dst((size_t)dw * dh * 4);
+    for (int y = 0; y < dh; ++y) {
+      int y0 = std::min(y * 2, h - 1), y1 = std::min(y * 2 + 1, h - 1);
+      for (int x = 0; x < dw; ++x) {
+        int x0 = std::min(x * 2, w - 1), x1 = std::min(x * 2 + 1, w - 1);
+        const unsigned char *p[4] = {
+            src + ((size_t)y0 * w + x0) * 4, src + ((size_t)y0 * w + x1) * 4,
+            src + ((size_t)y1 * w + x0) * 4, src + ((size_t)y1 * w + x1) * 4};
+        unsigned alpha = p[0][3] + p[1][3] + p[2][3] + p[3][3];
+        unsigned char *out = dst.data() + ((size_t)y * dw + x) * 4;
+        for (int c = 0; c < 3; ++c) {
+          unsigned sum = 0;
+          for (const unsigned char *q : p)
+            sum += alpha ? q[c] * q[3] : q[c];
+          unsigned div = alpha ? alpha : 4;
+          out[c] = (unsigned char)((sum + div / 2) / div);
+        }
+        out[3] = (unsigned char)((alpha + 2) / 4);
+      }
+    }
+    mips->push_back(std::move(dst));
+    src = mips->back().data();
+    w = dw;
+    h = dh;
+    ++level;
+  }
+  return mips;
+}
+
+/// Decode the file at `path`, or the internal image of that name. A KTX2 or
+/// DDS file, or a compressed variant of the file in a format the backend
+/// samples, is loaded as is. Safe to call from any thread.
+static DecodedImage decode_image_file(const char *path) {
+  DecodedImage result;
+  int n;
+  if (int index = find_internal_image(path); index >= 0) {
+    const InternalImage &img = internal_images().list[index];
+    if (img.size > INT_MAX) {
+      result.failure = "image too large";
+      return result;
+    }
+    result.data = stbi_load_from_memory(img.data, (int)img.size, &result.w,
+                                        &result.h, &n, 4);
+    if (!result.data)
+      result.failure = stbi_failure_reason();
+    return result;
+  }
+  std::string variant = compressed_texture_variant(path);
+  if (!variant.empty()) {
+    result.compressed = load_compressed_texture(variant.c_str(),
+                                                result.failure);
+    if (result.compressed && !s_headless.enabled &&
+        !compressed_texture_supported(result.compressed->format)) {
+      result.compressed.reset();
+      result.failure = "texture format not supported by the GPU backend";
+    }
+    if (result.compressed) {
+      result.w = result.compressed->width;
+      result.h = result.compressed->height;
+      return result;
+    }
+    // A broken variant falls back to the file itself
+    if (variant == path)
+      return result;
+    result.failure = nullptr;
+  }
+  // Decoded from the mapped pages rather than through stdio, which would
+  // copy the file into its buffer first
+  std::shared_ptr<facebook::jsi::Buffer> file;
+  try {
+    MapFileOptions options{.sequential = true};
+    file = mapFileBuffer(path, false, &options);
+  } catch (const std::exception &) {
+    result.failure = "can't open file";
+    return result;
+  }
+  if (file->size() > INT_MAX) {
+    result.failure = "file too large";
+    return result;
+  }
+  result.data = stbi_load_from_memory(file->data(), (int)file->size(),
+                                      &result.w, &result.h, &n, 4);
+  if (!result.data)
+    result.failure = stbi_failure_reason();
+  return result;
+}
+
+/// decode_image_file(), with the mip chain of the pixels if `mipmaps` is
+/// set. Safe to call from any thread.
+static DecodedImage decode_image(const char *path, bool mipmaps = false) {
+  DecodedImage result = decode_image_file(path);
+  result.mipmaps = mipmaps;
+  if (mipmaps && result.data)
+    result.mips = generate_mipmaps(result.w, result.h, result.data);
+  return result;
+}
+
+/// By index in internal_images().list, filled by
+/// predecode_internal_images(). The first load of a name takes its pixels.
+static std::vector<std::future<DecodedImage>> s_decoded_images;
+
+/// Decode the internal images on the worker threads while the runtime and
+/// the units initialize; only their GPU uploads are left for load_image().
+static void predecode_internal_images() {
+  s_decoded_images.clear();
+  for (const InternalImage &img : internal_images().list) {
+    auto decoded = std::make_shared<std::promise<DecodedImage>>();
+    s_decoded_images.push_back(decoded->get_future());
+    const char *name = img.name.c_str();
+    s_thread_pool->post(
+        [name, decoded] { decoded->set_value(decode_image(name)); },
+        {TaskPriority::Interactive, TraceTaskImage});
+  }
+}
+
+/// The pixels of `path`: predecoded for the first load of an internal
+/// image, decoded now otherwise.
+static DecodedImage take_decoded_image(const char *path) {
+  int index = find_internal_image(path);
+  if (index >= 0 && index < (int)s_decoded_images.size() &&
+      s_decoded_images[index].valid())
+    return s_decoded_images[index].get();
+  return decode_image(path);
+}
+
+/// Pages shared by the images of up to sappConfig.image_atlas pixels per
+/// side, and their ImGui textures by page.
+static ImageAtlas s_image_atlas;
+static std::vector<simgui_image_t> s_atlas_page_images;
+
+/// The stream textures among the images, uploaded before every frame's
+/// draws.
+static std::vector<StreamTexture *> s_stream_textures;
+
+/// JS frames run so far, the clock of Image::lastUsedFrame_. JS thread only.
+static uint64_t s_js_frames = 0;
+/// GPU bytes of the images with a texture of their own, and the budget
+/// (sappConfig.texture_budget_mb) past which the least recently drawn ones
+/// are evicted; 0 for no budget.
+static size_t s_texture_bytes = 0;
+static size_t s_texture_budget = 0;
+
+/// The key in s_image_refs of `path` loaded with or without mipmaps. NUL
+/// can't be part of a path, so it sets the mipmapped copies apart.
+static std::string image_key(const std::string &path, bool mipmaps) {
+  return mipmaps ? path + '\0' : path;
+}
 
 class Image {
 public:
   int w_ = 0, h_ = 0;
+  /// What the image was loaded from, and whether with mipmaps (drawn with
+  /// s_mip_sampler); key() in s_image_refs.
+  std::string path_;
+  bool mipmaps_ = false;
   sg_image image_ = {};
+  /// The image's own texture, or the atlas page of `slot_`.
   simgui_image_t simguiImage_ = {};
+  /// Page and UV rectangle in s_image_atlas; page -1 with a texture of its
+  /// own.
+  ImageAtlas::Slot slot_;
+  /// The JS frame that last asked for the texture, for evicting the least
+  /// recently drawn ones.
+  uint64_t lastUsedFrame_ = 0;
+  /// The texture was dropped by enforce_texture_budget(); `reloading_` while
+  /// it is decoded again.
+  bool evicted_ = false;
+  bool reloading_ = false;
+  /// The pixels of a stream texture, which JS updates.
+  std::unique_ptr<StreamTexture> stream_;
+  /// Size of the image's own texture.
+  size_t gpuBytes_ = 0;
 
-  explicit Image(const char *path) {
-    const unsigned char *buf = nullptr;
-    unsigned size = 0;
-
-    for (auto img : s_internalImages) {
-      if (strcmp(img->name, path) == 0) {
-        buf = img->data;
-        size = img->size;
-        break;
+  /// Upload `w` x `h` RGBA8 `pixels`, which the caller keeps.
+  Image(std::string path, int w, int h, const unsigned char *pixels)
+      : w_(w), h_(h), path_(std::move(path)), lastUsedFrame_(s_js_frames),
+        gpuBytes_((size_t)w * h * 4) {
+    // Headless runs only need the size.
+    if (s_headless.enabled)
+      return;
+    if (s_image_atlas.fits(w_, h_)) {
+      slot_ = s_image_atlas.add(w_, h_, pixels);
+      while ((int)s_atlas_page_images.size() < s_image_atlas.pageCount()) {
+        sg_image page =
+            s_image_atlas.pageImage((int)s_atlas_page_images.size());
+        s_atlas_page_images.push_back(
+            simgui_make_image(simgui_image_desc_t{page, s_sampler}));
       }
+      simguiImage_ = s_atlas_page_images[slot_.page];
+      return;
     }
+    upload(pixels);
+  }
 
-    unsigned char *data;
-    int n;
-    if (buf) {
-      data = stbi_load_from_memory(buf, size, &w_, &h_, &n, 4);
-    } else {
-      data = stbi_load(path, &w_, &h_, &n, 4);
-    }
+  /// Upload a compressed texture or mipmapped pixels, which the caller
+  /// keeps. Never in the atlas, whose pages are RGBA8 without mipmaps.
+  Image(std::string path, const DecodedImage &decoded)
+      : w_(decoded.w), h_(decoded.h), path_(std::move(path)),
+        mipmaps_(decoded.mipmaps), lastUsedFrame_(s_js_frames),
+        gpuBytes_(decoded.gpuBytes()) {
+    if (!s_headless.enabled)
+      upload(decoded);
+  }
 
-    if (!data) {
-      slog_func("ERROR", 1, 0, "Failed to load image", __LINE__, __FILE__,
-                nullptr);
-      abort();
+  /// A stream texture, named `path`.
+  Image(std::string path, std::unique_ptr<StreamTexture> stream)
+      : w_(stream->width()), h_(stream->height()), path_(std::move(path)),
+        lastUsedFrame_(s_js_frames), stream_(std::move(stream)) {
+    s_stream_textures.push_back(stream_.get());
+    if (!s_headless.enabled)
+      simguiImage_ =
+          simgui_make_image(simgui_image_desc_t{stream_->image(), s_sampler});
+  }
+
+  ~Image() {
+    if (stream_) {
+      s_stream_textures.erase(std::find(s_stream_textures.begin(),
+                                        s_stream_textures.end(),
+                                        stream_.get()));
+      if (!s_headless.enabled)
+        simgui_destroy_image(simguiImage_);
+      return;
     }
+    if (s_headless.enabled)
+      return;
+    if (slot_.page >= 0) {
+      s_image_atlas.remove(slot_);
+      return;
+    }
+    evict();
+  }
 
-    image_ = sg_make_image(sg_image_desc{
+  std::string key() const { return image_key(path_, mipmaps_); }
+  size_t gpuBytes() const { return gpuBytes_; }
+
+  /// Create the image's own texture, again after an eviction.
+  void upload(const unsigned char *pixels, const MipLevels *mips = nullptr) {
+    sg_image_desc desc = {
         .width = w_,
         .height = h_,
-        .data{.subimage[0][0] = {.ptr = data, .size = (size_t)w_ * h_ * 4}},
-    });
-
-    stbi_image_free(data);
-    simguiImage_ = simgui_make_image(simgui_image_desc_t{image_, s_sampler});
+        .data{.subimage[0][0] = {.ptr = pixels, .size = (size_t)w_ * h_ * 4}},
+    };
+    if (mips) {
+      desc.num_mipmaps = 1 + (int)mips->size();
+      for (size_t i = 0; i < mips->size(); ++i)
+        desc.data.subimage[0][i + 1] = {.ptr = (*mips)[i].data(),
+                                        .size = (*mips)[i].size()};
+    }
+    adopt(sg_make_image(desc), mips ? s_mip_sampler : s_sampler);
+  }
+  void upload(const CompressedTexture &texture) {
+    adopt(sg_make_image(sg_image_desc{
+              .width = w_,
+              .height = h_,
+              .pixel_format = texture.format,
+              .data{.subimage[0][0] = texture.level},
+          }),
+          s_sampler);
+  }
+  /// Load whichever `decoded` holds.
+  void upload(const DecodedImage &decoded) {
+    if (decoded.compressed)
+      upload(*decoded.compressed);
+    else
+      upload(decoded.data, decoded.mips.get());
   }
 
-  ~Image() {
+  /// Destroy the image's own texture, keeping its size and handle.
+  void evict() {
+    if (evicted_)
+      return;
     simgui_destroy_image(simguiImage_);
     sg_destroy_image(image_);
+    image_ = {};
+    simguiImage_ = {};
+    s_texture_bytes -= gpuBytes();
+    evicted_ = true;
+  }
+
+private:
+  void adopt(sg_image image, sg_sampler sampler) {
+    image_ = image;
+    simguiImage_ = simgui_make_image(simgui_image_desc_t{image_, sampler});
+    s_texture_bytes += gpuBytes();
+    evicted_ = false;
+    reloading_ = false;
   }
 };
 
+/// Upload the stream textures that JS updated since the last frame.
+static void flush_stream_textures() {
+  for (StreamTexture *stream : s_stream_textures)
+    stream->flush();
+}
+
+/// Destroy the atlas pages, once their images are gone.
+static void shutdown_image_atlas() {
+  for (simgui_image_t image : s_atlas_page_images)
+    simgui_destroy_image(image);
+  s_atlas_page_images.clear();
+  s_image_atlas.shutdown();
+}
+
+/// Loaded images by handle; the slots of unloaded ones are null until
+/// load_image() reuses them.
 static std::vector<std::unique_ptr<Image>> s_images{};
 
+/// Frames an image has to go undrawn before it can be evicted: the
+/// snapshots of threaded mode may still draw it meanwhile.
+constexpr uint64_t kEvictAfterFrames = 3;
+
+/// Evict the least recently drawn textures while the images are over
+/// s_texture_budget. Render thread, while JS waits (textures are added in
+/// such calls, and only those grow s_texture_bytes).
+static void enforce_texture_budget() {
+  if (!s_texture_budget || s_texture_bytes <= s_texture_budget)
+    return;
+  std::vector<Image *> candidates;
+  for (auto &image : s_images) {
+    // Atlas images share their page; the placeholder and stream textures
+    // have no source.
+    if (image && !image->evicted_ && image->slot_.page < 0 &&
+        !image->path_.empty() && !image->stream_ &&
+        image->lastUsedFrame_ + kEvictAfterFrames <= s_js_frames)
+      candidates.push_back(image.get());
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Image *a, const Image *b) {
+              return a->lastUsedFrame_ < b->lastUsedFrame_;
+            });
+  for (Image *image : candidates) {
+    if (s_texture_bytes <= s_texture_budget)
+      break;
+    image->evict();
+  }
+}
+
+/// The handle and the load_image() calls not yet matched by an
+/// unload_image() of every loaded path (or internal image name).
+struct ImageRef {
+  int index;
+  int refs;
+};
+static std::unordered_map<std::string, ImageRef> s_image_refs;
+static std::vector<int> s_free_image_slots;
+/// The 1x1 texture of imagePlaceholder(), -1 until first asked for.
+static int s_placeholder_image = -1;
+
+/// Callbacks of the loadImageAsync() requests in flight, by request ID.
+static std::unordered_map<unsigned, facebook::jsi::Function>
+    s_image_callbacks{};
+static unsigned s_next_image_request = 1;
+
 static bool s_started = false;
 static uint64_t s_start_time = 0;
 static uint64_t s_last_fps_time = 0;
@@ -109,152 +930,1873 @@ static double s_fps = 0;
 static double s_react_avg_ms = 0;              // React reconciliation average (accumulated)
 static double s_react_max_ms = 0;              // React reconciliation max (accumulated)
 static double s_imgui_avg_ms = 0;              // ImGui render average (EMA, accumulated)
-static double s_react_avg_ms_display = 0;      // React avg (displayed, updated once/sec)
-static double s_react_max_ms_display = 0;      // React max (displayed, updated once/sec)
-static double s_imgui_avg_ms_display = 0;      // ImGui render average (displayed, updated once/sec)
+/// Due macrotasks moved to a later frame, and frames whose macrotasks
+/// exceeded the budget (totals).
+static int s_deferred_tasks = 0;
+static int s_budget_overruns = 0;
 
+/// Performance HUD, toggled with F3. Shown by default; configurable through
+/// globalThis.sappConfig.perf_hud.
+static PerfHud s_hud;
+/// Phase timings of the frame in progress, on the thread that runs JS.
+static HudFrame s_hud_frame{};
 
-extern "C" int load_image(const char *path) {
-  s_images.emplace_back(std::make_unique<Image>(path));
-  return s_images.size() - 1;
+/// Counters written by the units (see RuntimeMetrics.h).
+static RuntimeMetrics s_metrics{};
+extern "C" RuntimeMetrics *imgui_runtime_metrics(void) { return &s_metrics; }
+
+/// Contents of the __runtimeMetrics ArrayBuffer: aliases s_metrics, which
+/// outlives the runtime.
+class MetricsBuffer : public facebook::jsi::MutableBuffer {
+public:
+  size_t size() const override { return sizeof(s_metrics); }
+  uint8_t *data() override { return reinterpret_cast<uint8_t *>(&s_metrics); }
+};
+
+/// Time spent draining the microtask queue and the number of drains since
+/// the last sample_scheduler_stats(), on the thread that runs JS.
+static uint64_t s_microtask_drain_ticks = 0;
+static uint64_t s_microtask_drain_count = 0;
+
+/// Drain the microtask queue of `rt`, counting the time towards the frame's
+/// microtaskDrainTime.
+static void drain_microtasks(facebook::jsi::Runtime &rt) {
+  uint64_t start = stm_now();
+  rt.drainMicrotasks();
+  s_microtask_drain_ticks += stm_since(start);
+  ++s_microtask_drain_count;
 }
-extern "C" int image_width(int index) {
-  if (index < 0 || index >= s_images.size()) {
-    slog_func("ERROR", 1, 0, "Invalid image index", __LINE__, __FILE__,
-              nullptr);
-    return 0;
+
+// When the JS thread drains the microtask queue. Configurable through
+// globalThis.sappConfig.microtask_drain:
+//   "task"  - after every macrotask, event batch, rAF and idle callback, as
+//             in a browser (jslib drains through __drainMicrotasks())
+//   "phase" - once after each phase of the frame: input events, macrotasks,
+//             rAF callbacks, on_frame() and idle callbacks
+//   "frame" - before on_frame() and after the idle callbacks only
+// Every policy drains right before on_frame(), so the continuations of the
+// frame's React commits land before renderTree() walks the tree.
+enum class MicrotaskDrain { Task, Phase, Frame };
+static MicrotaskDrain s_microtask_drain = MicrotaskDrain::Task;
+static const char *const kMicrotaskDrainNames[] = {"task", "phase", "frame"};
+
+/// Parse the microtask_drain setting. Returns false for an unknown value.
+static bool parse_microtask_drain(const std::string &value) {
+  if (value == "task")
+    s_microtask_drain = MicrotaskDrain::Task;
+  else if (value == "phase")
+    s_microtask_drain = MicrotaskDrain::Phase;
+  else if (value == "frame")
+    s_microtask_drain = MicrotaskDrain::Frame;
+  else
+    return false;
+  return true;
+}
+
+/// Drain the microtask queue at the end of a phase of the frame, unless the
+/// policy leaves it to the frame boundaries.
+static void drain_after_phase(facebook::jsi::Runtime &rt) {
+  if (s_microtask_drain != MicrotaskDrain::Frame)
+    drain_microtasks(rt);
+}
+
+// Threaded mode (experimental). JS, React and the ImGui frame run on a
+// dedicated JS thread, which hands each frame to the main thread as a
+// DrawSnapshot. The main thread only handles sokol events and draws the
+// latest snapshot, so a slow JS frame delays the UI's next update but not
+// the presentation of frames or the processing of window events.
+// Configurable through globalThis.sappConfig.threaded.
+static bool s_threaded = false;
+static std::thread s_js_thread;
+/// Set by js_thread_main(). s_js_thread can't tell: the main thread assigns
+/// it while the JS thread is already running on_init().
+static thread_local bool t_is_js_thread = false;
+/// sokol-gfx and window calls made by the JS thread, run by the main thread
+/// at the start of its next frame (see run_on_render_thread()).
+static std::mutex s_render_calls_mutex;
+static std::vector<std::function<void()>> s_render_calls;
+static std::vector<std::function<void()>> s_render_calls_running;
+
+// Async init. With sappConfig.async_init in the app's CONFIG file (see
+// imgui_register_app_config()), sokol_main() returns after the jslib unit
+// and the window opens right away with a splash screen. The React bundle,
+// the imgui unit and on_init() then run in the first frames, one step per
+// frame, or before the first frame on the JS thread in threaded mode.
+enum AsyncInitStep {
+  AsyncInitSplash,
+  AsyncInitReactUnit,
+  AsyncInitImguiUnit,
+  AsyncInitOnInit,
+  AsyncInitDone,
+};
+/// Written by the thread that runs the steps, read by the main thread in
+/// threaded mode.
+static std::atomic<int> s_async_init_step{AsyncInitDone};
+/// The arguments for imgui_main() in an async init.
+static int s_argc = 0;
+static char **s_argv = nullptr;
+
+/// sapp_desc that will be populated from globalThis.sappConfig
+static sapp_desc s_app_desc{};
+
+/// Run `fn` on the thread that owns the GPU context and the window. In
+/// threaded mode, a call from the JS thread waits until the main thread has
+/// run it, so `fn` may capture locals by reference.
+static void run_on_render_thread(const std::function<void()> &fn) {
+  if (!s_threaded || !t_is_js_thread) {
+    fn();
+    return;
+  }
+  std::packaged_task<void()> task(fn);
+  std::future<void> done = task.get_future();
+  {
+    std::lock_guard<std::mutex> lock(s_render_calls_mutex);
+    s_render_calls.emplace_back([&task] { task(); });
   }
-  return s_images[index]->w_;
+  done.get();
 }
-extern "C" int image_height(int index) {
-  if (index < 0 || index >= s_images.size()) {
+
+/// Run the calls queued by run_on_render_thread(). Main thread only.
+static void run_render_thread_calls() {
+  {
+    std::lock_guard<std::mutex> lock(s_render_calls_mutex);
+    if (s_render_calls.empty())
+      return;
+    std::swap(s_render_calls, s_render_calls_running);
+  }
+  for (auto &fn : s_render_calls_running)
+    fn();
+  s_render_calls_running.clear();
+}
+
+/// The image of a handle, or null after logging an error.
+static Image *find_image(int index) {
+  if (index < 0 || index >= s_images.size() || !s_images[index]) {
     slog_func("ERROR", 1, 0, "Invalid image index", __LINE__, __FILE__,
               nullptr);
-    return 0;
+    return nullptr;
   }
-  return s_images[index]->h_;
+  return s_images[index].get();
+}
+
+/// Take a reference to `path` and return its handle, if it is loaded (with
+/// `mipmaps` or without); -1 otherwise. s_image_refs only changes in calls
+/// that the JS thread waits for, so that thread can use this directly.
+static int ref_loaded_image(const std::string &path, bool mipmaps = false) {
+  auto it = s_image_refs.find(image_key(path, mipmaps));
+  if (it == s_image_refs.end())
+    return -1;
+  ++it->second.refs;
+  return it->second.index;
+}
+
+/// Give `image` a handle, with one reference under its path. Render thread
+/// only.
+static int register_image(std::unique_ptr<Image> image) {
+  int index;
+  if (s_free_image_slots.empty()) {
+    index = (int)s_images.size();
+    s_images.emplace_back();
+  } else {
+    index = s_free_image_slots.back();
+    s_free_image_slots.pop_back();
+  }
+  s_image_refs.emplace(image->key(), ImageRef{index, 1});
+  s_images[index] = std::move(image);
+  enforce_texture_budget();
+  return index;
+}
+
+/// Upload `w` x `h` RGBA8 `pixels` as the image of `path`, with one
+/// reference, and return its handle. Render thread only.
+static int add_image(const std::string &path, int w, int h,
+                     const unsigned char *pixels) {
+  return register_image(std::make_unique<Image>(path, w, h, pixels));
+}
+
+/// add_image() for the pixels (with their mipmaps) or the compressed
+/// texture of `decoded`.
+static int add_decoded_image(const std::string &path,
+                             const DecodedImage &decoded) {
+  if (decoded.compressed || decoded.mipmaps)
+    return register_image(std::make_unique<Image>(path, decoded));
+  return add_image(path, decoded.w, decoded.h, decoded.data);
+}
+
+/// Load the image at `path` (or the internal image of that name), returning
+/// its handle. Loading a path that is already loaded returns the same
+/// handle without decoding it again; each call needs an unload_image().
+extern "C" int load_image(const char *path) {
+  int index = 0;
+  run_on_render_thread([path, &index] {
+    index = ref_loaded_image(path);
+    if (index >= 0)
+      return;
+    DecodedImage decoded = take_decoded_image(path);
+    if (!decoded.ok()) {
+      slog_func("ERROR", 1, 0, "Failed to load image", __LINE__, __FILE__,
+                nullptr);
+      abort();
+    }
+    index = add_decoded_image(path, decoded);
+    stbi_image_free(decoded.data);
+  });
+  return index;
+}
+/// Release a load_image() handle. The texture is destroyed with the last
+/// one, so it must not be drawn in the frame that releases it.
+extern "C" void unload_image(int index) {
+  run_on_render_thread([index] {
+    Image *image = find_image(index);
+    if (!image || index == s_placeholder_image)
+      return;
+    auto it = s_image_refs.find(image->key());
+    if (--it->second.refs == 0) {
+      s_image_refs.erase(it);
+      s_images[index].reset();
+      s_free_image_slots.push_back(index);
+    }
+  });
+}
+extern "C" int image_width(int index) {
+  Image *image = find_image(index);
+  return image ? image->w_ : 0;
+}
+extern "C" int image_height(int index) {
+  Image *image = find_image(index);
+  return image ? image->h_ : 0;
 }
+static int placeholder_image();
+static void reload_image(int index);
+
+/// The texture to draw image `index` with: its own, or its atlas page. This
+/// marks the image as drawn in this frame. An evicted image is decoded
+/// again in the background and drawn as the placeholder meanwhile.
 extern "C" const simgui_image_t *image_simgui_image(int index) {
-  if (index < 0 || index >= s_images.size()) {
-    slog_func("ERROR", 1, 0, "Invalid image index", __LINE__, __FILE__,
-              nullptr);
-    return 0;
+  Image *image = find_image(index);
+  if (!image)
+    return nullptr;
+  image->lastUsedFrame_ = s_js_frames;
+  if (image->evicted_) {
+    reload_image(index);
+    return &s_images[placeholder_image()]->simguiImage_;
   }
-  return &s_images[index]->simguiImage_;
+  return &image->simguiImage_;
+}
+/// The UV rectangle of image `index` in that texture, as u0, v0, u1, v1:
+/// 0, 0, 1, 1 unless the image is in the atlas.
+extern "C" void image_uv(int index, float *uv) {
+  Image *image = find_image(index);
+  ImageAtlas::Slot slot = image ? image->slot_ : ImageAtlas::Slot{};
+  uv[0] = slot.uv0[0];
+  uv[1] = slot.uv0[1];
+  uv[2] = slot.uv1[0];
+  uv[3] = slot.uv1[1];
+}
+/// image_simgui_image() as an ImTextureID, with image_uv() in `uv`, for
+/// the renderer's <image>. A handle that doesn't exist (-1 while the image
+/// loads) is drawn as the placeholder.
+extern "C" void *image_texture(int index, float *uv) {
+  if (!find_image(index))
+    index = placeholder_image();
+  image_uv(index, uv);
+  return simgui_imtextureid(*image_simgui_image(index));
+}
+
+/// The pixels to fill next of stream texture `index`, or null if it isn't
+/// one, for the renderer's <heatmap>. JS thread.
+extern "C" uint8_t *stream_texture_pixels(int index) {
+  Image *image = find_image(index);
+  return image && image->stream_ ? image->stream_->pixels() : nullptr;
+}
+/// Queue the pixels filled for upload: StreamTexture::update(). JS thread.
+extern "C" void stream_texture_update(int index) {
+  Image *image = find_image(index);
+  if (image && image->stream_)
+    image->stream_->update();
 }
 
+static void start_js_thread();
+static void stop_js_thread();
+static void run_async_init_step();
+
+/// Records the session's input when IMGUI_RECORD is set.
+static InputRecorder s_recorder;
+
 static void app_init() {
+  startup_end(StartupWindow);
+  startup_begin(StartupGfxSetup);
   sg_desc desc = {.logger.func = slog_func, .context = sapp_sgcontext()};
   sg_setup(&desc);
-  simgui_setup(simgui_desc_t{});
+  init_compressed_texture_formats();
+  simgui_set_font_atlas_builder(font_atlas_cache_build);
+  // Built on a worker since sokol_main(); this only waits for it, if it's
+  // still running, and the font atlas time becomes that wait.
+  uint64_t atlasWaitStart = stm_now();
+  ImFontAtlas *prebuiltAtlas = font_atlas_cache_take_prebuilt();
+  double atlasWaitMs = stm_ms(stm_since(atlasWaitStart));
+  simgui_set_shared_font_atlas(prebuiltAtlas);
+  // In threaded mode, the cursor ImGui asks for is applied when its frame is
+  // drawn (see app_frame_threaded()). The vertex and index buffers start
+  // small and grow with the draw data (see simgui_draw_buffer_stats()).
+  simgui_setup(simgui_desc_t{.max_vertices = kInitialDrawVertices,
+                             .no_default_font = prebuiltAtlas != nullptr,
+                             .disable_set_mouse_cursor = s_threaded});
+  // simgui_setup() makes no texture for a shared atlas, and the glyph cache
+  // grows the atlas and updates its texture as glyphs are added.
+  bool glyphCache = glyph_cache_attach(igGetIO()->Fonts);
+  if (prebuiltAtlas || glyphCache)
+    simgui_make_font_image(glyphCache);
+  settings_store_apply();
+  s_startup_ms[StartupFontAtlas] = atlasWaitMs + simgui_font_atlas_ms();
 
   s_sampler = sg_make_sampler(sg_sampler_desc{
       .min_filter = SG_FILTER_LINEAR,
       .mag_filter = SG_FILTER_LINEAR,
   });
+  s_mip_sampler = sg_make_sampler(sg_sampler_desc{
+      .min_filter = SG_FILTER_LINEAR,
+      .mag_filter = SG_FILTER_LINEAR,
+      .mipmap_filter = SG_FILTER_LINEAR,
+  });
 
   sdtx_desc_t sdtx_desc = {.fonts = {sdtx_font_kc854()},
                            .logger.func = slog_func};
   sdtx_setup(&sdtx_desc);
+  s_hud.setup();
+  gpu_stats_setup();
+  // Benchmark runs don't wait for vsync
+  if (s_bench.enabled)
+    sapp_set_swap_interval(0);
+  if (const char *recordPath = getenv("IMGUI_RECORD"))
+    s_recorder.start(recordPath, sapp_width(), sapp_height(),
+                     sapp_frame_count());
+  startup_end(StartupGfxSetup);
+
+  if (s_threaded) {
+    start_js_thread();
+    return;
+  }
+  // on_init() is the last step of an async init
+  if (s_async_init_step != AsyncInitDone)
+    return;
 
   try {
-    s_hermesApp->hermes->global()
-        .getPropertyAsFunction(*s_hermesApp->hermes, "on_init")
-        .call(*s_hermesApp->hermes);
+    startup_begin(StartupOnInit);
+    s_hermesApp->onInit->call(*s_hermesApp->hermes);
     s_hermesApp->hermes->drainMicrotasks();
+    startup_end(StartupOnInit);
   } catch (facebook::jsi::JSIException &e) {
     slog_func("ERROR", 1, 0, e.what(), __LINE__, __FILE__, nullptr);
     abort();
   }
 }
 
+static void shutdown_workers();
+static void note_input_activity(const sapp_event *ev);
+static void post_event_to_js_thread(const sapp_event *ev);
+static void start_trace_capture();
+static void stop_trace_capture();
+static void stop_cpu_profile();
+static void request_cpu_profile_toggle();
+static void load_lazy_unit(facebook::jsi::Runtime &rt,
+                           const std::string &name);
+
 static void app_cleanup() {
+  stop_js_thread();
+  stop_trace_capture();
+  stop_cpu_profile();
+  s_recorder.stop();
   s_images.clear();
+  s_image_refs.clear();
+  s_free_image_slots.clear();
+  s_placeholder_image = -1;
+  shutdown_image_atlas();
+  shutdown_font_registry();
+  s_hud.shutdown();
+  settings_store_shutdown();
   simgui_shutdown();
+  font_atlas_cache_destroy_prebuilt();
   sdtx_shutdown();
   sg_shutdown();
 
+  shutdown_workers();
   delete s_hermesApp;
   s_hermesApp = nullptr;
 }
 
+/// Input events received since the last frame, delivered to JS in one batch
+/// by deliver_input_events(). Consecutive mouse moves and scrolls are merged
+/// unless s_raw_input_events is set.
+static std::vector<sapp_event> s_input_events{};
+/// Deliver every input event to JS as it arrived, without merging.
+/// Configurable through globalThis.sappConfig.raw_input_events.
+static bool s_raw_input_events = false;
+/// The event types JS handles, one bit per sapp_event_type, set by the imgui
+/// unit through imgui_set_input_event_mask(). The others only go to ImGui,
+/// and a frame without any of these makes no on_events() call.
+static uint32_t s_input_event_mask = ~0u;
+
+static_assert(_SAPP_EVENTTYPE_NUM <= 32,
+              "sapp_event_type no longer fits the input event mask");
+
+// The imgui unit reads the records through the accessors in sapp.js, which
+// hardcode this layout.
+static_assert(sizeof(sapp_event) == 272 &&
+                  offsetof(sapp_event, touches) == 64 &&
+                  sizeof(sapp_touchpoint) == 24,
+              "update the sapp_event accessors in lib/imgui-unit/sapp.js");
+
+/// Pointer to the batch passed to on_events(count), for the imgui unit. Only
+/// valid during that call.
+extern "C" const sapp_event *imgui_input_events(void) {
+  return s_input_events.data();
+}
+
+/// Set the event types on_events() gets, as a mask of 1 << sapp_event_type.
+/// Thread of the ImGui context.
+extern "C" void imgui_set_input_event_mask(uint32_t mask) {
+  s_input_event_mask = mask;
+}
+
+/// Queue `ev` for the next batch, unless JS doesn't handle its type, merging
+/// it into the previous event if both are mouse moves or both are scrolls
+/// with the same modifiers. A merged event has the latest state and the
+/// summed deltas.
+static void queue_input_event(const sapp_event *ev) {
+  if (!(s_input_event_mask & (1u << ev->type)))
+    return;
+  if (!s_raw_input_events && !s_input_events.empty()) {
+    sapp_event &last = s_input_events.back();
+    if (last.type == ev->type && last.modifiers == ev->modifiers) {
+      if (ev->type == SAPP_EVENTTYPE_MOUSE_MOVE) {
+        float dx = last.mouse_dx + ev->mouse_dx;
+        float dy = last.mouse_dy + ev->mouse_dy;
+        last = *ev;
+        last.mouse_dx = dx;
+        last.mouse_dy = dy;
+        return;
+      }
+      if (ev->type == SAPP_EVENTTYPE_MOUSE_SCROLL) {
+        float sx = last.scroll_x + ev->scroll_x;
+        float sy = last.scroll_y + ev->scroll_y;
+        last = *ev;
+        last.scroll_x = sx;
+        last.scroll_y = sy;
+        return;
+      }
+    }
+  }
+  s_input_events.push_back(*ev);
+}
+
+/// Hand the queued input events to JS with a single on_events(count) call,
+/// then drain the microtasks once (rather than after every event) unless
+/// the drain policy is "frame".
+static void deliver_input_events() {
+  if (s_input_events.empty())
+    return;
+  TraceScope trace(TraceInput);
+  try {
+    s_hermesApp->onEvents->call(*s_hermesApp->hermes,
+                                (double)s_input_events.size());
+    drain_after_phase(*s_hermesApp->hermes);
+  } catch (facebook::jsi::JSIException &e) {
+    slog_func("ERROR", 1, 0, e.what(), __LINE__, __FILE__, nullptr);
+  }
+  s_input_events.clear();
+}
+
 static void app_event(const sapp_event *ev) {
   if (ev->type == SAPP_EVENTTYPE_KEY_DOWN && ev->key_code == SAPP_KEYCODE_Q &&
       (ev->modifiers & SAPP_MODIFIER_SUPER)) {
     sapp_request_quit();
     return;
   }
+  if (ev->type == SAPP_EVENTTYPE_KEY_DOWN && ev->key_code == SAPP_KEYCODE_F3 &&
+      !ev->key_repeat) {
+    s_hud.visible = !s_hud.visible;
+    return;
+  }
+  if (ev->type == SAPP_EVENTTYPE_KEY_DOWN && ev->key_code == SAPP_KEYCODE_F4 &&
+      !ev->key_repeat) {
+    if (trace_capturing())
+      stop_trace_capture();
+    else
+      start_trace_capture();
+    return;
+  }
+  if (ev->type == SAPP_EVENTTYPE_KEY_DOWN && ev->key_code == SAPP_KEYCODE_F5 &&
+      !ev->key_repeat) {
+    request_cpu_profile_toggle();
+    return;
+  }
+  if (s_recorder.recording())
+    s_recorder.record(sapp_frame_count(), *ev);
+  // The paths are only valid in this callback, on this thread
+  if (ev->type == SAPP_EVENTTYPE_FILES_DROPPED)
+    file_drop_capture();
 
-  try {
-    s_hermesApp->hermes->global()
-        .getPropertyAsFunction(*s_hermesApp->hermes, "on_event")
-        .call(*s_hermesApp->hermes, (double)ev->type, (double)ev->key_code,
-              (double)ev->modifiers);
-    // Drain microtasks after event (browser behavior)
-    s_hermesApp->hermes->drainMicrotasks();
-  } catch (facebook::jsi::JSIException &e) {
-    slog_func("ERROR", 1, 0, e.what(), __LINE__, __FILE__, nullptr);
+  // In threaded mode, the JS thread passes them to ImGui with its next frame.
+  if (s_threaded) {
+    post_event_to_js_thread(ev);
+    return;
   }
 
-  if (simgui_handle_event(ev))
+  note_input_activity(ev);
+  if (hotkey_dispatch(*ev))
     return;
+
+  // ImGui gets every event right away; JS gets them with the next frame.
+  queue_input_event(ev);
+  if (ev->type == SAPP_EVENTTYPE_CHAR)
+    glyph_cache_touch_codepoint(ev->char_code);
+  simgui_handle_event(ev);
 }
 
 static float s_bg_color[4] = {0.0f, 0.0f, 0.0f, 0.0f};
 extern "C" float *get_bg_color() { return s_bg_color; }
 
-static void update_performance_metrics() {
-  // Read performance metrics from JavaScript
-  try {
-    auto global = s_hermesApp->hermes->global();
+/// UTF-8 bytes of the last string passed to the __encodeUtf8() host function.
+/// The imgui unit copies them out with a single memcpy() instead of encoding
+/// the string one byte at a time in JS.
+static std::string s_utf8_staging;
+extern "C" const char *utf8_staging_buffer() { return s_utf8_staging.data(); }
 
-    if (global.hasProperty(*s_hermesApp->hermes, "perfMetrics")) {
-      auto metrics = global.getPropertyAsObject(*s_hermesApp->hermes, "perfMetrics");
+/// Native memory (SharedBuffer.h) exposed to the React unit as an external
+/// ArrayBuffer and to the imgui unit as a raw pointer, so bulk data crosses
+/// units without copies. The ArrayBuffer owns the memory; the registry only
+/// keeps weak references indexed by the handle returned to JS.
+static std::vector<std::weak_ptr<SharedBuffer>> s_shared_buffers{};
 
-      // Read React reconciliation stats (calculated in JS)
-      if (metrics.hasProperty(*s_hermesApp->hermes, "reconciliationAvg")) {
-        s_react_avg_ms = metrics.getProperty(*s_hermesApp->hermes, "reconciliationAvg").asNumber();
-      }
-      if (metrics.hasProperty(*s_hermesApp->hermes, "reconciliationMax")) {
-        s_react_max_ms = metrics.getProperty(*s_hermesApp->hermes, "reconciliationMax").asNumber();
-      }
+/// Size of the React unit's bundle (source or bytecode) once loaded.
+static size_t s_bundle_bytes = 0;
 
-      // Read and calculate EMA for ImGui render time (every frame)
-      if (metrics.hasProperty(*s_hermesApp->hermes, "renderTime")) {
-        double renderTime = metrics.getProperty(*s_hermesApp->hermes, "renderTime").asNumber();
-        const double alpha = 0.1;  // Smoothing factor
-        s_imgui_avg_ms = s_imgui_avg_ms * (1.0 - alpha) + renderTime * alpha;
-      }
+/// Register a new shared buffer and return its handle. Handles of buffers
+/// that have been garbage collected are reused.
+static int register_shared_buffer(const std::shared_ptr<SharedBuffer> &buf) {
+  for (size_t i = 0; i < s_shared_buffers.size(); ++i) {
+    if (s_shared_buffers[i].expired()) {
+      s_shared_buffers[i] = buf;
+      return (int)i;
     }
-  } catch (...) {
-    // Ignore errors reading metrics
   }
+  s_shared_buffers.push_back(buf);
+  return (int)s_shared_buffers.size() - 1;
 }
 
-static void app_frame() {
-  uint64_t now = stm_now();
-  double curTimeMs = stm_ms(now);
+/// Data pointer of a shared buffer, or NULL if the handle is invalid or the
+/// buffer has been collected. The pointer is valid as long as JS keeps the
+/// ArrayBuffer (or a view of it) alive.
+extern "C" void *shared_buffer_data(int handle) {
+  if (handle < 0 || (size_t)handle >= s_shared_buffers.size())
+    return nullptr;
+  auto buf = s_shared_buffers[handle].lock();
+  return buf ? buf->data() : nullptr;
+}
+
+std::shared_ptr<SharedBuffer> lock_shared_buffer(int handle) {
+  if (handle < 0 || (size_t)handle >= s_shared_buffers.size())
+    return nullptr;
+  return s_shared_buffers[handle].lock();
+}
+
+/// Size in bytes of a shared buffer, or 0 if it is not alive.
+extern "C" size_t shared_buffer_size(int handle) {
+  if (handle < 0 || (size_t)handle >= s_shared_buffers.size())
+    return 0;
+  auto buf = s_shared_buffers[handle].lock();
+  return buf ? buf->size() : 0;
+}
+
+// Version of the React tree, incremented by the host config after every
+// commit that changed the tree (see __setTreeVersion).
+static unsigned s_tree_version = 0;
+
+/// Current version of the React tree. Comparing it with a value saved
+/// earlier tells whether anything changed since then.
+extern "C" unsigned imgui_tree_version(void) { return s_tree_version; }
+
+/// Monotonic time in ms (stm_ms() time base), for timing inside the imgui
+/// unit without a host function call.
+extern "C" double imgui_now_ms(void) { return stm_ms(stm_now()); }
+
+// Fraction of the frame duration that macrotasks (timers, React's scheduler)
+// may use before the frame is rendered. Work still pending at that point
+// (e.g. a large concurrent React render that yielded) continues next frame.
+// Configurable through globalThis.sappConfig.macrotask_budget.
+static double s_macrotask_budget = 0.5;
+// Fixed macrotask budget in milliseconds; overrides s_macrotask_budget if
+// positive. Configurable through globalThis.sappConfig.macrotask_budget_ms.
+static double s_macrotask_budget_ms = 0;
+
+// Longest idle sleep in milliseconds (0 disables idle sleep). When nothing
+// happened for a few frames, app_frame() sleeps until the next macrotask
+// deadline, at most this long, instead of rendering at the display rate.
+// Input arriving meanwhile is only delivered by sokol after the sleep, so
+// this also bounds the input latency of an idle app.
+// Configurable through globalThis.sappConfig.idle_sleep_ms.
+static double s_idle_sleep_ms = 0;
+/// Frames rendered at full rate after any activity, so that ImGui can settle
+/// hover, focus and popup state before the app goes idle.
+static constexpr int kActiveFrames = 3;
+static int s_active_frames = kActiveFrames;
+/// Deadline of the next macrotask (stm_ms() time base), -1 if there is none.
+static double s_next_deadline_ms = -1;
+/// Tree version seen by the last frame.
+static unsigned s_frame_tree_version = 0;
+
+// On-demand rendering. Once the app is idle, frames are only produced when
+// something happened: input, a due timer or immediate, a worker result, a
+// ready fd, a tree change or pending rAF/idle callbacks. The frames in
+// between skip the JS frame, ImGui and the GPU submission entirely and leave
+// the previous image on screen.
+// Configurable through globalThis.sappConfig.on_demand.
+static bool s_on_demand = false;
+/// How long a stationary mouse over an item keeps frames coming, so that
+/// ImGui's delayed hover effects (tooltips) can appear.
+static constexpr double kHoverSettleMs = 1000.0;
+/// When the current hover started (stm_ms() time base), -1 if none.
+static double s_hover_start_ms = -1;
+
+// Low-latency frames. The macrotask phase (worker results, I/O, timers and
+// React's scheduler) moves from before rendering to after sg_commit(), where
+// it gets the time left until the next vsync, so a frame goes from the
+// input that sokol just delivered straight to rendering.
+// Configurable through globalThis.sappConfig.low_latency.
+static bool s_low_latency = false;
+/// Arrival time of the first input event since the last frame (stm_ms()
+/// time base), -1 if none.
+static double s_input_start_ms = -1;
+/// Highest input latency since the overlay was last updated.
+static double s_latency_window_max = 0;
+
+/// Time kept free before the next expected vsync when handing the rest of
+/// the frame to requestIdleCallback() callbacks.
+static constexpr double kIdleMarginMs = 1.0;
+
+/// Any input keeps the frame loop running at full rate for a while.
+static void note_input_activity(const sapp_event *ev) {
+  s_active_frames = kActiveFrames;
+  if (s_input_start_ms < 0)
+    s_input_start_ms = stm_ms(stm_now());
+  // A moving mouse restarts the hover delay of the item under it.
+  if (ev->type == SAPP_EVENTTYPE_MOUSE_MOVE)
+    s_hover_start_ms = -1;
+}
+
+/// File descriptors watched from JS (ioReactor.watch()). Idle sleeps wait on
+/// it, so they also end when a watched fd becomes ready or another thread
+/// calls imgui_wake_main_loop().
+static IoReactor s_reactor;
+/// Ready fds of the last poll, kept to reuse the allocation.
+static std::vector<IoReactor::Event> s_io_ready;
+
+/// Functions posted to the main thread by workers, run before the frame's
+/// macrotasks.
+static std::mutex s_main_queue_mutex;
+static std::vector<std::function<void()>> s_main_queue;
+static std::vector<std::function<void()>> s_main_queue_running;
+
+/// Queue `fn` to run on the main thread, waking it from an idle sleep. Safe
+/// to call from any thread.
+static void post_to_main_thread(std::function<void()> fn) {
+  {
+    std::lock_guard<std::mutex> lock(s_main_queue_mutex);
+    s_main_queue.push_back(std::move(fn));
+  }
+  s_reactor.wake();
+}
+
+/// Run the functions posted by post_to_main_thread(), each a macrotask: with
+/// the "task" drain policy, the microtasks it queued (e.g. the reactions of
+/// the promises it settled) run before the next one. The other policies
+/// leave them to run_macrotasks().
+static void run_main_thread_queue() {
+  {
+    std::lock_guard<std::mutex> lock(s_main_queue_mutex);
+    if (s_main_queue.empty())
+      return;
+    std::swap(s_main_queue, s_main_queue_running);
+  }
+  s_active_frames = kActiveFrames;
+  for (auto &fn : s_main_queue_running) {
+    try {
+      fn();
+      if (s_microtask_drain == MicrotaskDrain::Task)
+        drain_microtasks(*s_hermesApp->hermes);
+    } catch (facebook::jsi::JSIException &e) {
+      slog_func("ERROR", 1, 0, e.what(), __LINE__, __FILE__, nullptr);
+    }
+  }
+  s_main_queue_running.clear();
+}
+
+/// Stop the workers and drop their pending results, before the runtime that
+/// the results are for is destroyed.
+static void shutdown_workers() {
+  // Requests blocked on their sockets would hold up the pool
+  shutdown_fetch();
+  // Its callbacks post index jobs
+  shutdown_file_watcher();
+  s_thread_pool.reset();
+  shutdown_web_workers();
+  shutdown_websockets();
+  shutdown_record_decoders();
+  shutdown_column_stores();
+  shutdown_time_series();
+  shutdown_filter_indexes();
+  shutdown_frame_capture();
+  shutdown_async_fs();
+  shutdown_native_tasks();
+  shutdown_columnar_parse();
+  shutdown_table_kernels();
+  shutdown_notifiers();
+  shutdown_hotkeys();
+  shutdown_file_drop();
+  shutdown_animation();
+  shutdown_audio();
+  shutdown_text_views();
+  s_image_callbacks.clear();
+  s_main_queue.clear();
+}
+
+/// Behind loadImageAsync(): decode `path` (and make its mipmaps) on a
+/// worker, then upload it at the start of a later JS frame and call
+/// `callback(message, handle)`, with a null message on success.
+static void load_image_async(facebook::jsi::Runtime &rt,
+                             const std::string &path, bool mipmaps,
+                             facebook::jsi::Function callback) {
+  unsigned id = s_next_image_request++;
+  s_image_callbacks.emplace(id, std::move(callback));
+  facebook::jsi::Runtime *rtp = &rt;
+  auto complete = [rtp, id](const std::string &path, DecodedImage decoded,
+                            int index) {
+    auto it = s_image_callbacks.find(id);
+    if (it == s_image_callbacks.end())
+      return;
+    facebook::jsi::Function callback = std::move(it->second);
+    s_image_callbacks.erase(it);
+    if (index < 0 && !decoded.ok()) {
+      std::string message = "Can't load image " + path + ": " +
+                            (decoded.failure ? decoded.failure : "unknown");
+      callback.call(*rtp, message, facebook::jsi::Value::null());
+      return;
+    }
+    if (index < 0) {
+      // A load of the same path may have finished meanwhile.
+      run_on_render_thread([&] {
+        index = ref_loaded_image(path, decoded.mipmaps);
+        if (index < 0)
+          index = add_decoded_image(path, decoded);
+      });
+      stbi_image_free(decoded.data);
+    }
+    callback.call(*rtp, facebook::jsi::Value::null(), index);
+  };
+
+  // Already loaded: settles in the next frame's macrotask phase, like the
+  // others.
+  if (int index = ref_loaded_image(path, mipmaps); index >= 0) {
+    post_to_main_thread([complete, path, index] {
+      complete(path, DecodedImage{}, index);
+    });
+    return;
+  }
+  s_thread_pool->post(
+      [complete, path, mipmaps] {
+        DecodedImage decoded = decode_image(path.c_str(), mipmaps);
+        post_to_main_thread([complete, path, decoded] {
+          complete(path, decoded, -1);
+        });
+      },
+      {TaskPriority::Interactive, TraceTaskImage});
+}
+
+/// Decode evicted image `index` again on a worker and upload it in a later
+/// JS frame, unless it was unloaded meanwhile.
+static void reload_image(int index) {
+  Image *image = s_images[index].get();
+  if (image->reloading_)
+    return;
+  image->reloading_ = true;
+  s_thread_pool->post(
+      [index, path = image->path_, mipmaps = image->mipmaps_] {
+        DecodedImage decoded = decode_image(path.c_str(), mipmaps);
+        post_to_main_thread([index, path, decoded] {
+          run_on_render_thread([&] {
+            Image *current = index < (int)s_images.size()
+                                 ? s_images[index].get()
+                                 : nullptr;
+            if (!current || current->path_ != path || !current->evicted_)
+              return;
+            // A failed reload isn't retried; the placeholder stays.
+            if (!decoded.ok()) {
+              slog_func("ERROR", 1, 0, "Failed to reload image", __LINE__,
+                        __FILE__, nullptr);
+              return;
+            }
+            current->upload(decoded);
+            enforce_texture_budget();
+          });
+          stbi_image_free(decoded.data);
+        });
+      },
+      {TaskPriority::Interactive, TraceTaskImage});
+}
+
+/// Behind imagePlaceholder(): the handle of a 1x1 gray texture to draw in
+/// place of images that are still loading.
+static int placeholder_image() {
+  if (s_placeholder_image < 0) {
+    static const unsigned char kGray[4] = {0x80, 0x80, 0x80, 0xff};
+    run_on_render_thread(
+        [] { s_placeholder_image = add_image("", 1, 1, kGray); });
+  }
+  return s_placeholder_image;
+}
+
+extern "C" void imgui_wake_main_loop(void) { s_reactor.wake(); }
+
+/// Keep the frame loop running at full rate for a few more frames, for
+/// effects that the imgui unit fades without touching the tree (<datagrid>
+/// flashes). Thread of the frame loop only.
+extern "C" void imgui_keep_rendering(void) { s_active_frames = kActiveFrames; }
+
+/// Sleep before an idle frame (see s_idle_sleep_ms).
+static void idle_sleep() {
+  if (s_idle_sleep_ms <= 0 || s_active_frames > 0)
+    return;
+  TraceScope trace(TraceSleep);
+  double ms = s_idle_sleep_ms;
+  if (s_next_deadline_ms >= 0)
+    ms = std::min(ms, s_next_deadline_ms - stm_ms(stm_now()));
+  // Ready fds are only noted here; deliver_io_events() fetches them again
+  // (the reactor is level-triggered).
+  if (ms > 0 && s_reactor.wait(ms, nullptr))
+    s_active_frames = kActiveFrames;
+}
+
+/// Pass the watched fds that are ready to jslib, which runs their callbacks
+/// as immediates in the frame's macrotask phase.
+static void deliver_io_events() {
+  if (!s_reactor.watchCount())
+    return;
+  s_io_ready.clear();
+  if (!s_reactor.wait(0, &s_io_ready))
+    return;
+  s_active_frames = kActiveFrames;
+  for (const auto &ev : s_io_ready) {
+    s_hermesApp->queueIo.call(*s_hermesApp->hermes, ev.fd, (double)ev.events);
+  }
+}
+
+/// Whether ImGui needs frames even without input: a text field blinking its
+/// cursor, a widget being dragged or held, or a freshly hovered item.
+/// Called after simgui_render().
+static bool imgui_wants_frames(double nowMs) {
+  if (igGetIO()->WantTextInput || igIsAnyItemActive() || igIsAnyMouseDown())
+    return true;
+  if (!igIsAnyItemHovered()) {
+    s_hover_start_ms = -1;
+    return false;
+  }
+  if (s_hover_start_ms < 0)
+    s_hover_start_ms = nowMs;
+  return nowMs - s_hover_start_ms < kHoverSettleMs;
+}
+
+/// In on-demand mode, decide whether an idle frame can be skipped. Runs the
+/// cheap checks that may produce work (worker results, ready fds); they set
+/// s_active_frames if they did.
+static bool skip_idle_frame(double nowMs) {
+  try {
+    run_main_thread_queue();
+    deliver_io_events();
+    if (sync_record_rings())
+      s_active_frames = kActiveFrames;
+  } catch (facebook::jsi::JSIException &e) {
+    slog_func("ERROR", 1, 0, e.what(), __LINE__, __FILE__, nullptr);
+    s_active_frames = kActiveFrames;
+  }
+  if (s_active_frames > 0)
+    return false;
+  return s_next_deadline_ms < 0 || nowMs < s_next_deadline_ms;
+}
+
+/// The frame's macrotask phase: results posted by workers and ready fds
+/// (unless an idle on-demand frame has `polled` them already), then due
+/// timers and immediates until `budgetMs` is spent. At least one runs every
+/// frame, so work always makes progress. jslib runs them all in one call
+/// and, with the "task" drain policy, drains the microtask queue after each
+/// through __drainMicrotasks(). The "phase" policy drains once at the end.
+static void run_macrotasks(double curTimeMs, double budgetMs, bool polled) {
+  TraceScope trace(TraceMacrotasks);
+  uint64_t start = stm_now();
+  try {
+    if (!polled) {
+      run_main_thread_queue();
+      deliver_io_events();
+      if (sync_record_rings())
+        s_active_frames = kActiveFrames;
+    }
+    s_next_deadline_ms =
+        s_hermesApp->runReady.call(*s_hermesApp->hermes, curTimeMs, budgetMs)
+            .asNumber();
+    if (s_microtask_drain == MicrotaskDrain::Phase)
+      drain_microtasks(*s_hermesApp->hermes);
+  } catch (facebook::jsi::JSIException &e) {
+    slog_func("ERROR", 1, 0, e.what(), __LINE__, __FILE__, nullptr);
+  }
+  s_hud_frame.phaseMs[HudMacrotasks] += stm_ms(stm_since(start));
+}
+
+/// Publish the time from the first input event of a frame (`inputMs`, -1 if
+/// there was none) until the frame is handed over for presentation.
+static void record_input_latency(double inputMs) {
+  if (inputMs < 0)
+    return;
+  double latency = stm_ms(stm_now()) - inputMs;
+  const double alpha = 0.1; // Smoothing factor
+  s_metrics.inputLatency = latency;
+  s_metrics.inputLatencyAvg = s_metrics.inputLatencyAvg
+                                  ? s_metrics.inputLatencyAvg * (1.0 - alpha) +
+                                        latency * alpha
+                                  : latency;
+  s_latency_window_max = std::max(s_latency_window_max, latency);
+}
+
+/// Record what happened in the frame that just ran, to decide whether the
+/// next one may sleep. `pending` tells whether rAF or idle callbacks are
+/// waiting for a frame.
+static void update_idle_state(bool pending) {
+  if (pending || s_tree_version != s_frame_tree_version) {
+    s_frame_tree_version = s_tree_version;
+    s_active_frames = kActiveFrames;
+  } else if (s_active_frames > 0) {
+    --s_active_frames;
+  }
+}
+
+static void update_performance_metrics() {
+  // The units write their counters into s_metrics directly.
+  s_react_avg_ms = s_metrics.reconciliationAvg;
+  s_react_max_ms = s_metrics.reconciliationMax;
+
+  // EMA of the ImGui render time (every frame)
+  const double alpha = 0.1;  // Smoothing factor
+  s_imgui_avg_ms =
+      s_imgui_avg_ms * (1.0 - alpha) + s_metrics.renderTime * alpha;
+
+  // Macrotask budget counters (maintained by jslib's runReady())
+  s_deferred_tasks = (int)s_metrics.deferredTasks;
+  s_budget_overruns = (int)s_metrics.budgetOverruns;
+}
+
+/// Publish the event loop counters of the frame that is ending: the
+/// macrotasks and rAF callbacks jslib counted, the time spent draining
+/// microtasks and the number of drains go to s_metrics, and with the
+/// macrotask queue depth to a running trace capture. Called on the thread
+/// that runs JS.
+static void sample_scheduler_stats() {
+  s_metrics.tasksPerFrame = s_metrics.frameTasks;
+  s_metrics.rafCallbacksPerFrame = s_metrics.frameRafCallbacks;
+  s_metrics.frameTasks = 0;
+  s_metrics.frameRafCallbacks = 0;
+  s_metrics.microtaskDrainTime = stm_ms(s_microtask_drain_ticks);
+  s_metrics.microtaskDrains = (double)s_microtask_drain_count;
+  s_microtask_drain_ticks = 0;
+  s_microtask_drain_count = 0;
+
+  if (trace_capturing()) {
+    trace_counter(TraceTasksPerFrame, s_metrics.tasksPerFrame);
+    trace_counter(TraceRafCallbacks, s_metrics.rafCallbacksPerFrame);
+    trace_counter(TraceMacrotaskQueue, s_metrics.macrotaskQueueDepth);
+    trace_counter(TraceMicrotaskDrain, s_metrics.microtaskDrainTime);
+  }
+}
 
+/// Publish the usage of sokol_imgui's vertex and index buffers after a frame
+/// was drawn, and log their high-water marks whenever they were resized.
+/// Called on the drawing thread.
+static void sample_draw_buffer_stats() {
+  simgui_draw_buffer_stats_t stats;
+  simgui_draw_buffer_stats(&stats);
+  s_metrics.drawBufferVertices = stats.vertices;
+  s_metrics.drawBufferIndices = stats.indices;
+  s_metrics.drawBufferVertexCapacity = stats.vertex_capacity;
+  s_metrics.drawBufferIndexCapacity = stats.index_capacity;
+  if (stats.resizes != (int)s_metrics.drawBufferResizes) {
+    fprintf(stderr,
+            "ImGui draw buffers resized to %d vertices, %d indices "
+            "(high-water %d vertices, %d indices)\n",
+            stats.vertex_capacity, stats.index_capacity,
+            stats.vertex_high_water, stats.index_high_water);
+    s_metrics.drawBufferResizes = stats.resizes;
+  }
+}
+
+/// Start the frame clock on the first frame, and update the FPS and the
+/// latency window once per second after that.
+static void update_frame_stats(uint64_t now, double frameDuration) {
   if (!s_started) {
     s_started = true;
     s_start_time = now;
     s_last_fps_time = now;
+    return;
+  }
+  uint64_t diff = stm_diff(now, s_last_fps_time);
+  if (diff > 1000000000) {
+    s_fps = 1.0 / frameDuration;
+    s_metrics.inputLatencyMax = s_latency_window_max;
+    s_latency_window_max = 0;
+    s_last_fps_time = now;
+  }
+}
+
+/// Memory held by the subsystems outside the Hermes heap, for the HUD and
+/// __memoryReport(). Thread that runs JS.
+struct MemoryStats {
+  /// Own textures of images, and the pages of the image atlas.
+  size_t textureBytes = 0;
+  size_t atlasBytes = 0;
+  /// Capacity of the vertex, index and command buffers of the last
+  /// frame's draw lists.
+  size_t vertexBytes = 0;
+  size_t indexBytes = 0;
+  size_t commandBytes = 0;
+  /// The font atlas texture (RGBA8).
+  size_t fontAtlasBytes = 0;
+  size_t sharedBufferBytes = 0;
+  size_t bundleBytes = 0;
+};
+
+static MemoryStats memory_stats() {
+  MemoryStats stats;
+  stats.textureBytes = s_texture_bytes;
+  stats.atlasBytes = (size_t)s_image_atlas.pageCount() *
+                     ImageAtlas::kPageSize * ImageAtlas::kPageSize * 4;
+  if (ImDrawData *data = igGetDrawData()) {
+    for (int i = 0; i < data->CmdListsCount; ++i) {
+      const ImDrawList *list = data->CmdLists.Data[i];
+      stats.vertexBytes +=
+          (size_t)list->VtxBuffer.Capacity * sizeof(ImDrawVert);
+      stats.indexBytes += (size_t)list->IdxBuffer.Capacity * sizeof(ImDrawIdx);
+      stats.commandBytes +=
+          (size_t)list->CmdBuffer.Capacity * sizeof(ImDrawCmd);
+    }
+  }
+  ImFontAtlas *fonts = igGetIO()->Fonts;
+  stats.fontAtlasBytes = (size_t)fonts->TexWidth * fonts->TexHeight * 4;
+  for (auto &weak : s_shared_buffers) {
+    if (auto buffer = weak.lock())
+      stats.sharedBufferBytes += buffer->size();
+  }
+  stats.bundleBytes = s_bundle_bytes;
+  return stats;
+}
+
+static OverlayStats overlay_stats() {
+  OverlayStats stats;
+  stats.fps = s_fps;
+  stats.deferredTasks = s_deferred_tasks;
+  stats.budgetOverruns = s_budget_overruns;
+  stats.commitMutations =
+      (int)(s_metrics.commitCreateInstance +
+            s_metrics.commitCreateTextInstance + s_metrics.commitAppendChild +
+            s_metrics.commitInsertBefore + s_metrics.commitRemoveChild +
+            s_metrics.commitUpdate + s_metrics.commitTextUpdate);
+  stats.commitMs = s_metrics.lastCommitTime;
+  stats.heapAllocated = s_metrics.heapAllocated;
+  stats.heapSize = s_metrics.heapSize;
+  stats.gcCount = (int)s_metrics.gcCount;
+  if (s_hud.visible) {
+    MemoryStats memory = memory_stats();
+    stats.textureBytes = (double)(memory.textureBytes + memory.atlasBytes);
+    stats.drawListBytes = (double)(memory.vertexBytes + memory.indexBytes +
+                                   memory.commandBytes);
+    stats.fontAtlasBytes = (double)memory.fontAtlasBytes;
+    stats.bundleBytes = (double)memory.bundleBytes;
+  }
+  return stats;
+}
+
+/// Finish the phase timings of the frame that took `totalMs` and start the
+/// next one. React commits run inside the other JS phases (mostly the
+/// macrotasks), so their time is taken out of the macrotasks.
+static HudFrame take_hud_frame(double totalMs) {
+  HudFrame frame = s_hud_frame;
+  s_hud_frame = HudFrame{};
+  frame.phaseMs[HudReactCommit] = s_metrics.commitTime;
+  s_metrics.commitTime = 0;
+  frame.phaseMs[HudMacrotasks] = std::max(
+      0.0, frame.phaseMs[HudMacrotasks] - frame.phaseMs[HudReactCommit]);
+  frame.phaseMs[HudRenderTree] = s_metrics.renderTime;
+  frame.totalMs = totalMs;
+  return frame;
+}
+
+// Output file of trace captures, from the IMGUI_TRACE environment variable.
+static std::string s_trace_path = "imgui-trace.json";
+
+static void start_trace_capture() {
+  trace_start();
+  s_metrics.traceCapturing = 1;
+  printf("Trace capture started\n");
+}
+
+/// Stop the capture, if one runs, and write it to s_trace_path.
+static void stop_trace_capture() {
+  if (!trace_capturing())
+    return;
+  s_metrics.traceCapturing = 0;
+  trace_stop_and_write(s_trace_path.c_str());
+}
+
+// CPU profiles (F5, IMGUI_PROFILE, globalThis.profiler): the Hermes sampling
+// profiler runs for a number of seconds, then its samples are written in the
+// DevTools .cpuprofile format. Profiles start and stop on the thread that
+// runs JS; F5 only requests a toggle, which update_cpu_profile() carries out
+// at the end of the next JS frame.
+static std::string s_profile_path = "imgui-profile.cpuprofile";
+/// Default duration, from IMGUI_PROFILE_SECONDS.
+static double s_profile_seconds = 10;
+/// Sampling rate; Hermes' default of 100 Hz is coarse for 16 ms frames.
+static constexpr double kProfileHz = 1000;
+static bool s_profiling = false;
+/// Time at which the running profile stops, in ms; 0 runs until stopped.
+static double s_profile_stop_ms = 0;
+static std::atomic<bool> s_profile_toggle{false};
+/// Source map and bundle names for symbolication, from
+/// imgui_set_profile_source_map().
+static std::string s_profile_source_map;
+static std::vector<std::string> s_profile_bundle_names;
+
+void imgui_set_profile_source_map(const char *sourceMapPath,
+                                  const char *bundleURL) {
+  s_profile_source_map = sourceMapPath ? sourceMapPath : "";
+  s_profile_bundle_names.clear();
+  if (s_profile_source_map.empty())
+    return;
+  // The bundle is named after its map, e.g. react-unit-bundle.js.map.
+  std::string name = s_profile_source_map;
+  size_t slash = name.find_last_of("/\\");
+  if (slash != std::string::npos)
+    name.erase(0, slash + 1);
+  if (name.size() > 4 && name.compare(name.size() - 4, 4, ".map") == 0)
+    name.erase(name.size() - 4);
+  s_profile_bundle_names.push_back(name);
+  if (bundleURL)
+    s_profile_bundle_names.push_back(bundleURL);
+}
+
+static void request_cpu_profile_toggle() {
+  s_profile_toggle.store(true, std::memory_order_relaxed);
+  imgui_wake_main_loop();
+}
+
+/// Start profiling for `seconds` (negative: s_profile_seconds, 0: until
+/// stop_cpu_profile()).
+static void start_cpu_profile(double seconds) {
+  if (s_profiling)
+    return;
+  if (seconds < 0)
+    seconds = s_profile_seconds;
+  facebook::hermes::HermesRuntime::enableSamplingProfiler(kProfileHz);
+  s_profiling = true;
+  s_profile_stop_ms = seconds > 0 ? stm_ms(stm_now()) + seconds * 1000.0 : 0;
+  if (seconds > 0)
+    printf("CPU profile started (%.1f s)\n", seconds);
+  else
+    printf("CPU profile started\n");
+}
+
+/// Map the call frames in the bundle through s_profile_source_map. Returns
+/// `profile` unchanged if that fails.
+static std::string symbolicate_profile(const std::string &profile) {
+  auto &rt = *s_hermesApp->hermes;
+  try {
+    auto map = mapFileBuffer(s_profile_source_map.c_str(), false);
+    facebook::jsi::Array names(rt, s_profile_bundle_names.size());
+    for (size_t i = 0; i < s_profile_bundle_names.size(); ++i) {
+      names.setValueAtIndex(
+          rt, i,
+          facebook::jsi::String::createFromUtf8(rt, s_profile_bundle_names[i]));
+    }
+    return s_hermesApp->symbolicateProfile
+        .call(rt, facebook::jsi::String::createFromUtf8(rt, profile),
+              facebook::jsi::String::createFromUtf8(rt, map->data(),
+                                                    map->size()),
+              names)
+        .getString(rt)
+        .utf8(rt);
+  } catch (const std::exception &e) {
+    fprintf(stderr, "CPU profile left unsymbolicated: %s\n", e.what());
+    return profile;
+  }
+}
+
+/// Stop the profile, if one runs, and write it to s_profile_path.
+static void stop_cpu_profile() {
+  if (!s_profiling || !s_hermesApp)
+    return;
+  s_profiling = false;
+  facebook::hermes::HermesRuntime::disableSamplingProfiler();
+  std::ostringstream out;
+  s_hermesApp->hermes->sampledTraceToStreamInDevToolsFormat(out);
+  std::string profile = out.str();
+  if (!s_profile_source_map.empty())
+    profile = symbolicate_profile(profile);
+
+  FILE *f = fopen(s_profile_path.c_str(), "w");
+  if (!f || fwrite(profile.data(), 1, profile.size(), f) != profile.size()) {
+    fprintf(stderr, "Failed to write CPU profile %s\n", s_profile_path.c_str());
+    if (f)
+      fclose(f);
+    return;
+  }
+  fclose(f);
+  printf("CPU profile written to %s\n", s_profile_path.c_str());
+}
+
+/// Carry out a toggle requested with F5 and stop a profile whose time is up.
+/// Called at the end of every JS frame.
+static void update_cpu_profile() {
+  if (s_profile_toggle.exchange(false, std::memory_order_relaxed)) {
+    if (s_profiling)
+      stop_cpu_profile();
+    else
+      start_cpu_profile(-1);
+  } else if (s_profiling && s_profile_stop_ms > 0 &&
+             stm_ms(stm_now()) >= s_profile_stop_ms) {
+    stop_cpu_profile();
+  }
+}
+
+// Hermes collections, counted by gc_event_callback(). Collections that
+// pause JS run on the thread that runs JS (s_gc_js_thread); the time from
+// their start to their end is added to s_gc_pause_ticks. Hades may also
+// finish old-generation collections on its own thread; those are counted,
+// but don't pause JS.
+static std::atomic<std::thread::id> s_gc_js_thread{};
+static std::atomic<uint64_t> s_gc_collections{0};
+static std::atomic<uint64_t> s_gc_pause_ticks{0};
+static thread_local uint64_t t_gc_start = 0;
+// Totals at the previous sample_gc_stats().
+static uint64_t s_gc_sampled_collections = 0;
+static uint64_t s_gc_sampled_pause_ticks = 0;
+static double s_js_sampled_total_bytes = -1;
+
+// ImGui allocations since the last sample_gc_stats(), counted by the
+// allocator installed in sokol_main(). Atomic because the main thread
+// frees snapshot draw lists in threaded mode.
+static std::atomic<uint64_t> s_imgui_allocs{0};
+static std::atomic<uint64_t> s_imgui_alloc_bytes{0};
+
+static void *imgui_counting_alloc(size_t size, void *) {
+  s_imgui_allocs.fetch_add(1, std::memory_order_relaxed);
+  s_imgui_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+  return malloc(size);
+}
+static void imgui_counting_free(void *ptr, void *) { free(ptr); }
+
+/// GCConfig callback, installed in sokol_main(). Also marks the
+/// collections in trace captures, on the track of the thread they ran on.
+static void gc_event_callback(::hermes::vm::GCEventKind kind, const char *) {
+  if (kind == ::hermes::vm::GCEventKind::CollectionStart) {
+    t_gc_start = stm_now();
+    trace_begin(TraceGc);
+    return;
+  }
+  trace_end();
+  s_gc_collections.fetch_add(1, std::memory_order_relaxed);
+  if (t_gc_start && std::this_thread::get_id() ==
+                        s_gc_js_thread.load(std::memory_order_relaxed)) {
+    s_gc_pause_ticks.fetch_add(stm_since(t_gc_start),
+                               std::memory_order_relaxed);
+  }
+  t_gc_start = 0;
+}
+
+/// Sample the GC, heap and allocation statistics of the frame that is
+/// ending: the collections and pauses since the previous call go to
+/// s_hud_frame (so call it before take_hud_frame()), the totals, the heap
+/// and the frame's JS and ImGui allocations to s_metrics, and the heap to a
+/// running trace capture. Called on the thread that runs JS.
+static void sample_gc_stats() {
+  uint64_t collections = s_gc_collections.load(std::memory_order_relaxed);
+  uint64_t pauseTicks = s_gc_pause_ticks.load(std::memory_order_relaxed);
+  s_hud_frame.gcCount = (int)(collections - s_gc_sampled_collections);
+  s_hud_frame.gcMs = stm_ms(pauseTicks - s_gc_sampled_pause_ticks);
+  s_gc_sampled_collections = collections;
+  s_gc_sampled_pause_ticks = pauseTicks;
+
+  auto info = s_hermesApp->hermes->instrumentation().getHeapInfo(false);
+  s_metrics.gcCount = (double)collections;
+  s_metrics.gcPauseTime = s_hud_frame.gcMs;
+  s_metrics.heapSize = (double)info["hermes_heapSize"];
+  s_metrics.heapAllocated = (double)info["hermes_allocatedBytes"];
+  double totalBytes = (double)info["hermes_totalAllocatedBytes"];
+  s_metrics.jsAllocBytes =
+      s_js_sampled_total_bytes >= 0 ? totalBytes - s_js_sampled_total_bytes : 0;
+  s_js_sampled_total_bytes = totalBytes;
+  s_metrics.imguiAllocs =
+      (double)s_imgui_allocs.exchange(0, std::memory_order_relaxed);
+  s_metrics.imguiAllocBytes =
+      (double)s_imgui_alloc_bytes.exchange(0, std::memory_order_relaxed);
+
+  if (trace_capturing()) {
+    trace_counter(TraceHeap, s_metrics.heapAllocated);
+    trace_counter(TraceHeapSize, s_metrics.heapSize);
+    trace_counter(TraceGcCount, s_metrics.gcCount);
+  }
+}
+
+// Idle-time collections (sappConfig.idle_gc). After a frame, a full
+// collection is started in the time left before the next vsync when enough
+// has been allocated since the last collection and the collection is
+// expected to fit, so that Hermes' own collections, which start whenever an
+// allocation needs them, have less to do and land in the middle of
+// renderTree() less often.
+enum class IdleGcPolicy { Off, Balanced, Aggressive };
+static IdleGcPolicy s_idle_gc = IdleGcPolicy::Off;
+/// Expected duration of an idle collection in milliseconds: a running
+/// average of the measured ones, or an estimate from the heap size before
+/// the first.
+static double s_idle_gc_ms = -1;
+/// Assumed collection speed before the first idle collection, in bytes per
+/// millisecond.
+static constexpr double kIdleGcBytesPerMs = 256.0 * 1024;
+/// Collections counted by gc_event_callback() and allocated bytes when the
+/// runtime last looked, to measure what was allocated since the last one.
+/// No count yet at first, so the first frame only takes the baseline.
+static uint64_t s_idle_gc_collections = UINT64_MAX;
+static double s_idle_gc_allocated = 0;
+
+/// Parse the idle_gc setting. Returns false for an unknown value.
+static bool parse_idle_gc_policy(const std::string &value) {
+  if (value == "off")
+    s_idle_gc = IdleGcPolicy::Off;
+  else if (value == "balanced")
+    s_idle_gc = IdleGcPolicy::Balanced;
+  else if (value == "aggressive")
+    s_idle_gc = IdleGcPolicy::Aggressive;
+  else
+    return false;
+  return true;
+}
+
+/// Collect in the slack left by the frame that started at `frameStart`, if
+/// the idle_gc policy asks for it. Balanced waits for the heap to grow by a
+/// quarter and for twice the expected pause to be free; aggressive collects
+/// after a tenth and whenever the expected pause fits.
+static void run_idle_gc(uint64_t frameStart, double frameDuration) {
+  if (s_idle_gc == IdleGcPolicy::Off)
+    return;
+  bool aggressive = s_idle_gc == IdleGcPolicy::Aggressive;
+  double remainingMs =
+      frameDuration * 1000.0 - stm_ms(stm_since(frameStart)) - kIdleMarginMs;
+  if (remainingMs <= 0)
+    return;
+
+  auto &instrumentation = s_hermesApp->hermes->instrumentation();
+  auto info = instrumentation.getHeapInfo(false);
+  double allocated = (double)info["hermes_allocatedBytes"];
+  double heapSize = (double)info["hermes_heapSize"];
+  uint64_t collections = s_gc_collections.load(std::memory_order_relaxed);
+  if (collections != s_idle_gc_collections) {
+    // Hermes collected on its own (or this is the first frame); count from
+    // what survived
+    s_idle_gc_collections = collections;
+    s_idle_gc_allocated = allocated;
+    return;
+  }
+  double growth = allocated - s_idle_gc_allocated;
+  if (growth < heapSize * (aggressive ? 0.1 : 0.25))
+    return;
+  double expectedMs =
+      s_idle_gc_ms >= 0 ? s_idle_gc_ms : allocated / kIdleGcBytesPerMs;
+  if (expectedMs * (aggressive ? 1.0 : 2.0) > remainingMs)
+    return;
+
+  TraceScope trace(TraceIdleGc);
+  uint64_t start = stm_now();
+  instrumentation.collectGarbage("idle");
+  double ms = stm_ms(stm_since(start));
+  s_idle_gc_ms = s_idle_gc_ms >= 0 ? s_idle_gc_ms * 0.75 + ms * 0.25 : ms;
+  s_idle_gc_collections = s_gc_collections.load(std::memory_order_relaxed);
+  s_idle_gc_allocated =
+      (double)instrumentation.getHeapInfo(false)["hermes_allocatedBytes"];
+}
+
+/// Draw the performance HUD in the bottom-left corner of the current pass:
+/// the frame-time graph above the FPS, the phase legend and the counters.
+static void draw_overlay(const OverlayStats &stats) {
+  if (!s_hud.visible)
+    return;
+  // The HUD's own drawing stays out of the GPU statistics it shows.
+  gpu_stats_pause();
+  sdtx_canvas((float)sapp_width(), (float)sapp_height());
+
+  // Position at bottom-left corner
+  // Each character is 8x8 pixels, calculate rows from bottom
+  int num_rows = (int)sapp_height() / 8;
+  bool show_tasks = stats.deferredTasks > 0 || stats.budgetOverruns > 0;
+  bool show_commit = stats.commitMutations > 0;
+  // FPS + phases + Heap + Memory [+ Tasks] [+ Commit] [+ Latency]
+  int num_lines =
+      3 + PerfHud::kLegendLines + show_tasks + show_commit + s_low_latency;
+  int first_row = num_rows - num_lines;
+  s_hud.drawGraph(sapp_width(), sapp_height(), first_row * 8.0f - 4.0f,
+                  sapp_frame_duration() * 1000.0);
+  sdtx_pos(0.0f, (float)first_row);
+
+  sdtx_printf("FPS: %d\n", (int)(stats.fps + 0.5));
+  s_hud.printLegend();
+  sdtx_printf("Heap: %.1f/%.1f MB, %d GCs\n", stats.heapAllocated / 1048576.0,
+              stats.heapSize / 1048576.0, stats.gcCount);
+  sdtx_printf("Mem: tex %.1f MB, draw %.0f KB, font %.0f KB, bundle %.1f MB\n",
+              stats.textureBytes / 1048576.0, stats.drawListBytes / 1024.0,
+              stats.fontAtlasBytes / 1024.0, stats.bundleBytes / 1048576.0);
+  if (show_tasks) {
+    sdtx_printf("Tasks: %d deferred, %d overruns\n", stats.deferredTasks,
+                stats.budgetOverruns);
+  }
+  if (show_commit) {
+    sdtx_printf("Commit: %d mutations, %dus\n", stats.commitMutations,
+                (int)(stats.commitMs * 1000.0 + 0.5));
+  }
+  if (s_low_latency) {
+    sdtx_printf("Latency: %d/%dus",
+                (int)(s_metrics.inputLatencyAvg * 1000.0 + 0.5),
+                (int)(s_metrics.inputLatencyMax * 1000.0 + 0.5));
+  }
+  sdtx_draw();
+  gpu_stats_resume();
+}
+
+/// The window's content while an async init is loading the app.
+static void draw_splash() {
+  gpu_stats_pause();
+  sdtx_canvas(sapp_widthf() / 2.0f, sapp_heightf() / 2.0f);
+  const char *title = s_app_desc.window_title ? s_app_desc.window_title : "";
+  float cols = sapp_widthf() / 16.0f;
+  float rows = sapp_heightf() / 16.0f;
+  sdtx_pos(std::max(0.0f, (cols - (float)strlen(title)) / 2.0f),
+           rows / 2.0f - 1.0f);
+  sdtx_color3f(0.8f, 0.8f, 0.8f);
+  sdtx_puts(title);
+  sdtx_pos(std::max(0.0f, (cols - 10.0f) / 2.0f), rows / 2.0f + 1.0f);
+  sdtx_color3f(0.5f, 0.5f, 0.5f);
+  sdtx_puts("Loading...");
+  // The HUD's default
+  sdtx_color3b(255, 255, 0);
+  sdtx_draw();
+  gpu_stats_resume();
+}
+
+/// Macrotask budget of a frame of `frameDuration` seconds, in ms.
+static double macrotask_budget_ms(double frameDuration) {
+  return s_macrotask_budget_ms > 0
+             ? s_macrotask_budget_ms
+             : frameDuration * 1000.0 * s_macrotask_budget;
+}
+
+/// The window size of the last run_js_frame(), to notice resizes.
+static float s_js_window_width = -1.0f;
+static float s_js_window_height = -1.0f;
+
+/// Run the frame's rAF callbacks and on_frame() (`timeSec` is the time since
+/// the first frame), returning whether more rAF callbacks are waiting for the
+/// next frame.
+static bool run_js_frame(double timeSec, float width, float height) {
+  bool rafPending = false;
+  ++s_js_frames;
+  try {
+    // One call per frame while the window is resized; jslib throttles what
+    // reaches the app
+    if (width != s_js_window_width || height != s_js_window_height) {
+      s_js_window_width = width;
+      s_js_window_height = height;
+      s_hermesApp->windowResized.call(*s_hermesApp->hermes, width, height);
+    }
+
+    // Flush RAF callbacks (also a macrotask)
+    uint64_t start = stm_now();
+    {
+      TraceScope trace(TraceRaf);
+      rafPending = s_hermesApp->flushRaf.call(*s_hermesApp->hermes).getBool();
+    }
+    s_hud_frame.phaseMs[HudRaf] = stm_ms(stm_since(start));
+
+    // Move the animated values drawn by this frame; frames keep coming at
+    // full rate while any moves
+    if (animation_step(js_clock_ms()))
+      s_active_frames = kActiveFrames;
+
+    // Whatever the policy, the continuations queued so far (by events,
+    // macrotasks and rAF callbacks, e.g. React's microtask-scheduled
+    // commits) run before on_frame() renders the tree
+    drain_microtasks(*s_hermesApp->hermes);
+
+    // Render frame (this is also a macrotask)
+    TraceScope trace(TraceOnFrame);
+    s_hermesApp->onFrame->call(*s_hermesApp->hermes, width, height, timeSec);
+
+    // Drain microtasks after frame rendering
+    drain_after_phase(*s_hermesApp->hermes);
+  } catch (facebook::jsi::JSIException &e) {
+    slog_func("ERROR", 1, 0, e.what(), __LINE__, __FILE__, nullptr);
+  }
+  return rafPending;
+}
+
+/// Give the time left until the next expected vsync to
+/// requestIdleCallback() callbacks (expired timeouts run even without).
+/// Returns whether some are still queued.
+static bool run_idle_callbacks(uint64_t frameStart, double frameDuration) {
+  TraceScope trace(TraceIdle);
+  try {
+    double remainingMs =
+        frameDuration * 1000.0 - stm_ms(stm_since(frameStart)) - kIdleMarginMs;
+    bool pending = s_hermesApp->runIdle
+                       .call(*s_hermesApp->hermes, std::max(0.0, remainingMs))
+                       .getBool();
+    // The end of the frame: only the "task" policy has drained already
+    if (s_microtask_drain != MicrotaskDrain::Task)
+      drain_microtasks(*s_hermesApp->hermes);
+    return pending;
+  } catch (facebook::jsi::JSIException &e) {
+    slog_func("ERROR", 1, 0, e.what(), __LINE__, __FILE__, nullptr);
+  }
+  return false;
+}
+
+// State shared by the main thread and the JS thread in threaded mode.
+/// Window state of the frame the JS thread is asked to produce.
+struct JsFrameParams {
+  int width = 0;
+  int height = 0;
+  float dpiScale = 1.0f;
+  double frameDuration = 0;
+};
+static std::mutex s_js_mutex;
+static std::condition_variable s_js_cv;
+/// Set by the main thread once per frame to let the JS thread produce the
+/// next one.
+static bool s_js_tick = false;
+static bool s_js_stop = false;
+static JsFrameParams s_js_frame_params{};
+/// Events received by the main thread since the last tick.
+static std::vector<sapp_event> s_js_inbox{};
+/// Set by the JS thread when it has finished, so that the main thread can
+/// stop serving its render thread calls.
+static std::atomic<bool> s_js_done{false};
+/// Frames produced by the JS thread.
+static std::unique_ptr<DrawSnapshotQueue> s_snapshots;
+/// The snapshot drawn by the main thread's last frame. JS frames don't keep
+/// up with the display when they take longer than a vsync interval; the
+/// main thread then draws the same snapshot again.
+static DrawSnapshot *s_shown_snapshot = nullptr;
+
+static void post_event_to_js_thread(const sapp_event *ev) {
+  std::lock_guard<std::mutex> lock(s_js_mutex);
+  s_js_inbox.push_back(*ev);
+}
+
+static sapp_mouse_cursor sapp_cursor_for(ImGuiMouseCursor cursor) {
+  switch (cursor) {
+  case ImGuiMouseCursor_TextInput:
+    return SAPP_MOUSECURSOR_IBEAM;
+  case ImGuiMouseCursor_ResizeAll:
+    return SAPP_MOUSECURSOR_RESIZE_ALL;
+  case ImGuiMouseCursor_ResizeNS:
+    return SAPP_MOUSECURSOR_RESIZE_NS;
+  case ImGuiMouseCursor_ResizeEW:
+    return SAPP_MOUSECURSOR_RESIZE_EW;
+  case ImGuiMouseCursor_ResizeNESW:
+    return SAPP_MOUSECURSOR_RESIZE_NESW;
+  case ImGuiMouseCursor_ResizeNWSE:
+    return SAPP_MOUSECURSOR_RESIZE_NWSE;
+  case ImGuiMouseCursor_Hand:
+    return SAPP_MOUSECURSOR_POINTING_HAND;
+  case ImGuiMouseCursor_NotAllowed:
+    return SAPP_MOUSECURSOR_NOT_ALLOWED;
+  default:
+    return SAPP_MOUSECURSOR_ARROW;
+  }
+}
+
+/// ImGui's clipboard setter, which calls into the window system, runs on
+/// the main thread in threaded mode.
+static void set_clipboard_on_render_thread(void *, const char *text) {
+  std::string copy = text ? text : "";
+  run_on_render_thread([&copy] { sapp_set_clipboard_string(copy.c_str()); });
+}
+
+/// One frame of the JS thread: the same phases as app_frame(), except that
+/// the ImGui output is captured into a snapshot instead of being drawn.
+static void js_thread_frame(const JsFrameParams &params) {
+  TraceScope trace(TraceFrame);
+  uint64_t now = stm_now();
+  update_frame_stats(now, params.frameDuration);
+
+  // The glyphs text asked for in the last frame
+  glyph_cache_update();
+  simgui_new_frame({
+      .width = params.width,
+      .height = params.height,
+      .delta_time = params.frameDuration,
+      .dpi_scale = params.dpiScale,
+  });
+
+  deliver_input_events();
+  run_macrotasks(js_clock_ms(), macrotask_budget_ms(params.frameDuration),
+                 false);
+  double timeSec = s_bench.enabled ? s_bench_clock_ms / 1000.0
+                                   : stm_sec(stm_diff(now, s_start_time));
+  run_js_frame(timeSec, (float)params.width, (float)params.height);
+  update_performance_metrics();
+
+  uint64_t renderStart = stm_now();
+  trace_begin(TraceImGuiRender);
+  igRender();
+  DrawSnapshot &snapshot = s_snapshots->back();
+  snapshot.capture(igGetDrawData());
+  trace_end();
+  settings_store_update();
+  s_hud_frame.phaseMs[HudImGuiRender] = stm_ms(stm_since(renderStart));
+  snapshot.dpiScale = params.dpiScale;
+  snapshot.mouseCursor = igGetMouseCursor();
+  std::copy(s_bg_color, s_bg_color + 4, snapshot.bgColor);
+  sample_gc_stats();
+  sample_scheduler_stats();
+  update_cpu_profile();
+  snapshot.stats = overlay_stats();
+  snapshot.hud = take_hud_frame(stm_ms(stm_since(now)));
+  s_snapshots->publish();
+
+  run_idle_callbacks(now, params.frameDuration);
+  run_idle_gc(now, params.frameDuration);
+  bench_frame_end();
+}
+
+static void js_thread_main() {
+  t_is_js_thread = true;
+  trace_set_thread_name("JS");
+  s_gc_js_thread = std::this_thread::get_id();
+  // The sampling profiler samples the thread that registered last.
+  s_hermesApp->hermes->registerForProfiling();
+  // The main thread shows the splash screen meanwhile
+  if (s_async_init_step != AsyncInitDone) {
+    while (s_async_init_step != AsyncInitDone)
+      run_async_init_step();
   } else {
-    // Update FPS and displayed performance metrics every second
-    uint64_t diff = stm_diff(now, s_last_fps_time);
-    if (diff > 1000000000) {
-      s_fps = 1.0 / sapp_frame_duration();
-      s_imgui_avg_ms_display = s_imgui_avg_ms;  // Update displayed value
-      s_react_avg_ms_display = s_react_avg_ms;  // Update displayed value
-      s_react_max_ms_display = s_react_max_ms;  // Update displayed value
-      s_last_fps_time = now;
+    try {
+      startup_begin(StartupOnInit);
+      s_hermesApp->onInit->call(*s_hermesApp->hermes);
+      s_hermesApp->hermes->drainMicrotasks();
+      startup_end(StartupOnInit);
+    } catch (facebook::jsi::JSIException &e) {
+      slog_func("ERROR", 1, 0, e.what(), __LINE__, __FILE__, nullptr);
+      abort();
     }
   }
 
+  std::vector<sapp_event> events;
+  for (;;) {
+    JsFrameParams params;
+    {
+      std::unique_lock<std::mutex> lock(s_js_mutex);
+      s_js_cv.wait(lock, [] { return s_js_tick || s_js_stop; });
+      if (s_js_stop)
+        break;
+      s_js_tick = false;
+      params = s_js_frame_params;
+      std::swap(events, s_js_inbox);
+    }
+    // ImGui's input state belongs to this thread.
+    for (const sapp_event &ev : events) {
+      if (hotkey_dispatch(ev))
+        continue;
+      queue_input_event(&ev);
+      if (ev.type == SAPP_EVENTTYPE_CHAR)
+        glyph_cache_touch_codepoint(ev.char_code);
+      simgui_handle_event(&ev);
+    }
+    events.clear();
+    js_thread_frame(params);
+  }
+  s_js_done = true;
+}
+
+/// Start the JS thread, which calls on_init() and then waits for the first
+/// tick. Called by app_init() once sokol is set up.
+static void start_js_thread() {
+  // The main thread sets the cursor and the clipboard contents.
+  ImGuiIO *io = igGetIO();
+  io->BackendFlags |= ImGuiBackendFlags_HasMouseCursors;
+  io->SetClipboardTextFn = set_clipboard_on_render_thread;
+
+  s_snapshots = std::make_unique<DrawSnapshotQueue>();
+  s_js_thread = std::thread(js_thread_main);
+}
+
+/// Stop the JS thread after its current frame. It may still be waiting for
+/// a render thread call, so those keep being served until it is done.
+static void stop_js_thread() {
+  if (!s_js_thread.joinable())
+    return;
+  {
+    std::lock_guard<std::mutex> lock(s_js_mutex);
+    s_js_stop = true;
+  }
+  s_js_cv.notify_one();
+  while (!s_js_done) {
+    run_render_thread_calls();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  run_render_thread_calls();
+  s_js_thread.join();
+  s_shown_snapshot = nullptr;
+  s_snapshots.reset();
+}
+
+/// app_frame() in threaded mode: draw the latest snapshot, then let the JS
+/// thread produce the next one while this frame is being presented.
+static void app_frame_threaded() {
+  startup_frame_begin();
+  TraceScope trace(TraceFrame);
+  run_render_thread_calls();
+  DrawSnapshot *latest = s_snapshots->acquire();
+  if (latest)
+    s_shown_snapshot = latest;
+  DrawSnapshot *snapshot = s_shown_snapshot;
+  // The HUD gets one entry per JS frame: its phases plus the drawing and
+  // the commit on this thread.
+  HudFrame hud = latest ? latest->hud : HudFrame{};
+  const float *bg = snapshot ? snapshot->bgColor : s_bg_color;
+
+  sg_pass_action pass_action = {
+      .colors[0] = {.load_action = SG_LOADACTION_CLEAR,
+                    .clear_value = {bg[0], bg[1], bg[2], bg[3]}}};
+  sg_begin_default_pass(&pass_action, sapp_width(), sapp_height());
+  if (snapshot) {
+    sapp_set_mouse_cursor(sapp_cursor_for(snapshot->mouseCursor));
+    uint64_t start = stm_now();
+    trace_begin(TraceImGuiRender);
+    gpu_stats_begin_draw();
+    s_image_atlas.flush();
+    flush_stream_textures();
+    glyph_cache_upload();
+    font_registry_upload();
+    simgui_render_draw_data(snapshot->drawData(), snapshot->dpiScale);
+    trace_end();
+    sample_draw_buffer_stats();
+    hud.phaseMs[HudImGuiRender] += stm_ms(stm_since(start));
+    draw_overlay(snapshot->stats);
+  } else if (s_async_init_step != AsyncInitDone) {
+    draw_splash();
+  }
+  sg_end_pass();
+  frame_capture_end_pass(sapp_width(), sapp_height());
+  hud.gpu = gpu_stats_end_frame(snapshot ? snapshot->drawData() : nullptr);
+  uint64_t commitStart = stm_now();
+  trace_begin(TraceCommit);
+  sg_commit();
+  trace_end();
+  if (latest) {
+    hud.phaseMs[HudCommit] = stm_ms(stm_since(commitStart));
+    s_hud.record(hud);
+  }
+  if (snapshot)
+    startup_frame_end();
+
+  {
+    std::lock_guard<std::mutex> lock(s_js_mutex);
+    s_js_frame_params = JsFrameParams{sapp_width(), sapp_height(),
+                                      sapp_dpi_scale(), frame_duration_sec()};
+    s_js_tick = true;
+  }
+  s_js_cv.notify_one();
+}
+
+/// A frame of an async init: the splash screen, then the next step, after
+/// the splash of the previous frame has been presented.
+static void app_frame_splash() {
+  sg_pass_action pass_action = {
+      .colors[0] = {.load_action = SG_LOADACTION_CLEAR,
+                    .clear_value = {s_bg_color[0], s_bg_color[1], s_bg_color[2],
+                                    s_bg_color[3]}}};
+  sg_begin_default_pass(&pass_action, sapp_width(), sapp_height());
+  draw_splash();
+  sg_end_pass();
+  sg_commit();
+  run_async_init_step();
+}
+
+/// Draw the last frame's ImGui draw data again, for a skipped on-demand
+/// frame. sokol swaps buffers after every GL frame callback and the back
+/// buffer is undefined after a swap, so each frame needs a real pass; the
+/// draw data stays valid until the next igNewFrame().
+static void replay_last_frame() {
+  sg_pass_action pass_action = {
+      .colors[0] = {.load_action = SG_LOADACTION_CLEAR,
+                    .clear_value = {s_bg_color[0], s_bg_color[1], s_bg_color[2],
+                                    s_bg_color[3]}}};
+  sg_begin_default_pass(&pass_action, sapp_width(), sapp_height());
+  ImDrawData *drawData = igGetDrawData();
+  if (drawData && drawData->Valid)
+    simgui_render_draw_data(drawData, sapp_dpi_scale());
+  draw_overlay(overlay_stats());
+  sg_end_pass();
+  sg_commit();
+}
+
+static void app_frame() {
+  if (s_threaded) {
+    app_frame_threaded();
+    return;
+  }
+  if (s_async_init_step != AsyncInitDone) {
+    app_frame_splash();
+    return;
+  }
+
+  idle_sleep();
+
+  uint64_t now = stm_now();
+  double curTimeMs = stm_ms(now);
+
+  // An idle on-demand frame has already polled the main thread queue and the
+  // reactor, so the frame below mustn't deliver the same events again.
+  bool polled = false;
+  if (s_on_demand && s_active_frames == 0) {
+    if (skip_idle_frame(curTimeMs)) {
+#if !defined(SOKOL_METAL)
+      replay_last_frame();
+#endif
+      return;
+    }
+    polled = true;
+  }
+
+  startup_frame_begin();
+  TraceScope trace(TraceFrame);
+
+  // Input for this frame was delivered by sokol before the callback.
+  double inputMs = s_input_start_ms;
+  s_input_start_ms = -1;
+
+  double frameDuration = frame_duration_sec();
+  update_frame_stats(now, frameDuration);
+
+  // The glyphs text asked for in the last frame
+  glyph_cache_update();
   simgui_new_frame({
       .width = sapp_width(),
       .height = sapp_height(),
-      .delta_time = sapp_frame_duration(),
+      .delta_time = frameDuration,
       .dpi_scale = sapp_dpi_scale(),
   });
 
@@ -264,59 +2806,387 @@ static void app_frame() {
                     .clear_value = {s_bg_color[0], s_bg_color[1], s_bg_color[2],
                                     s_bg_color[3]}}};
 
-  // Begin and end pass
-  sg_begin_default_pass(&pass_action, sapp_width(), sapp_height());
+  // Begin and end pass
+  sg_begin_default_pass(&pass_action, sapp_width(), sapp_height());
+
+  // The frame's input comes first, then the other macrotasks.
+  deliver_input_events();
+
+  // Run the ready macrotasks before rendering the frame, until the frame's
+  // macrotask budget is used up. Low-latency frames run them after
+  // sg_commit() instead.
+  if (!s_low_latency)
+    run_macrotasks(js_clock_ms(), macrotask_budget_ms(frameDuration), polled);
+
+  double timeSec = s_bench.enabled ? s_bench_clock_ms / 1000.0
+                                   : stm_sec(stm_diff(now, s_start_time));
+  bool rafPending = run_js_frame(timeSec, sapp_widthf(), sapp_heightf());
+
+  update_performance_metrics();
+
+  uint64_t renderStart = stm_now();
+  trace_begin(TraceImGuiRender);
+  gpu_stats_begin_draw();
+  s_image_atlas.flush();
+  flush_stream_textures();
+  glyph_cache_upload();
+  font_registry_upload();
+  simgui_render();
+  trace_end();
+  sample_draw_buffer_stats();
+  s_hud_frame.phaseMs[HudImGuiRender] = stm_ms(stm_since(renderStart));
+  settings_store_update();
+  draw_overlay(overlay_stats());
+  sg_end_pass();
+  // Readbacks in flight need frames to be collected
+  if (frame_capture_end_pass(sapp_width(), sapp_height()))
+    s_active_frames = kActiveFrames;
+  s_hud_frame.gpu = gpu_stats_end_frame(igGetDrawData());
+  uint64_t commitStart = stm_now();
+  trace_begin(TraceCommit);
+  sg_commit();
+  trace_end();
+  s_hud_frame.phaseMs[HudCommit] = stm_ms(stm_since(commitStart));
+  startup_frame_end();
+#if defined(SOKOL_METAL)
+  // The drawable is presented by the command buffer committed here.
+  record_input_latency(inputMs);
+#endif
+
+  if (s_low_latency) {
+    double remainingMs =
+        frameDuration * 1000.0 - stm_ms(stm_since(now)) - kIdleMarginMs;
+    run_macrotasks(js_clock_ms(), std::max(0.0, remainingMs), polled);
+  }
+
+  bool idlePending = run_idle_callbacks(now, frameDuration);
+  run_idle_gc(now, frameDuration);
+  // Queued idle callbacks need frames to run in, like rAF callbacks.
+  update_idle_state(rafPending || idlePending || imgui_wants_frames(curTimeMs));
+#if !defined(SOKOL_METAL)
+  // GL swaps buffers once this callback returns.
+  record_input_latency(inputMs);
+#endif
+  sample_gc_stats();
+  sample_scheduler_stats();
+  update_cpu_profile();
+  s_hud.record(take_hud_frame(stm_ms(stm_since(now))));
+  bench_frame_end();
+}
+
+/// Parse the headless and benchmark options (see HeadlessOptions and
+/// BenchmarkOptions) from the command line. Other arguments are left to
+/// imgui_main().
+static void parse_headless_args(int argc, char *argv[]) {
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    if (strcmp(arg, "--headless") == 0) {
+      s_headless.enabled = true;
+    } else if (strncmp(arg, "--frames=", 9) == 0) {
+      s_headless.frames = std::max(1, atoi(arg + 9));
+    } else if (strncmp(arg, "--frame-ms=", 11) == 0) {
+      double ms = strtod(arg + 11, nullptr);
+      if (ms > 0)
+        s_headless.frameMs = ms;
+    } else if (strncmp(arg, "--size=", 7) == 0) {
+      int w = 0, h = 0;
+      if (sscanf(arg + 7, "%dx%d", &w, &h) == 2 && w > 0 && h > 0) {
+        s_headless.width = w;
+        s_headless.height = h;
+      }
+    } else if (strncmp(arg, "--max-native-bytes=", 19) == 0) {
+      s_headless.maxNativeBytes = std::max(0.0, strtod(arg + 19, nullptr));
+    } else if (strncmp(arg, "--max-js-bytes=", 15) == 0) {
+      s_headless.maxJsBytes = std::max(0.0, strtod(arg + 15, nullptr));
+    } else if (strncmp(arg, "--warmup=", 9) == 0) {
+      s_headless.warmupFrames = std::max(0, atoi(arg + 9));
+    } else if (strncmp(arg, "--script=", 9) == 0) {
+      s_headless.script = arg + 9;
+    } else if (strncmp(arg, "--report=", 9) == 0) {
+      s_headless.report = arg + 9;
+    } else if (strcmp(arg, "--bench") == 0) {
+      s_bench.enabled = true;
+    } else if (strncmp(arg, "--seed=", 7) == 0) {
+      s_bench.seeded = true;
+      s_bench.seed = strtod(arg + 7, nullptr);
+    }
+  }
+}
+
+/// Value at fraction `p` of the sorted `values`.
+static double percentile(const std::vector<double> &values, double p) {
+  if (values.empty())
+    return 0;
+  return values[(size_t)((values.size() - 1) * p + 0.5)];
+}
+
+/// Write the average, percentiles and maximum of `values` as a JSON object.
+static void write_stats_json(FILE *f, std::vector<double> &values) {
+  double sum = 0;
+  for (double v : values)
+    sum += v;
+  std::sort(values.begin(), values.end());
+  fprintf(f,
+          "{\"avg\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, "
+          "\"max\": %.4f}",
+          values.empty() ? 0 : sum / values.size(), percentile(values, 0.5),
+          percentile(values, 0.95), percentile(values, 0.99),
+          values.empty() ? 0 : values.back());
+}
 
-  try {
-    // Run all ready macrotasks before rendering frame
-    double nextTimeMs;
-    while ((nextTimeMs = s_hermesApp->peekMacroTask.call(*s_hermesApp->hermes)
-                             .getNumber()) >= 0 &&
-           nextTimeMs <= curTimeMs) {
-      s_hermesApp->runMacroTask.call(*s_hermesApp->hermes, curTimeMs);
-      s_hermesApp->hermes->drainMicrotasks();
-    }
+/// Run the app headless (see HeadlessOptions) and print the frame timings.
+/// Each frame runs the phases of app_frame() up to igRender(), after feeding
+/// it the frame's events of the input script; the timers and
+/// performance.now() keep using the real clock, unless --bench fixes it.
+/// Returns false if an allocation check (--max-native-bytes, --max-js-bytes)
+/// failed.
+static bool run_headless() {
+  int width = s_headless.width ? s_headless.width
+                               : (s_app_desc.width ? s_app_desc.width : 640);
+  int height = s_headless.height
+                   ? s_headless.height
+                   : (s_app_desc.height ? s_app_desc.height : 480);
+  double frameSec = s_headless.frameMs / 1000.0;
 
-    // Flush RAF callbacks (also a macrotask)
-    s_hermesApp->flushRaf.call(*s_hermesApp->hermes);
+  InputScript script;
+  if (s_headless.script) {
+    if (!load_input_script(s_headless.script, script))
+      return false;
+    if (!s_headless.width && script.width > 0) {
+      width = script.width;
+      height = script.height;
+    }
+  }
+  int frames = s_headless.frames;
+  if (!script.events.empty())
+    frames = std::max(frames, script.events.back().frame + 1);
 
-    // Render frame (this is also a macrotask)
-    s_hermesApp->hermes->global()
-        .getPropertyAsFunction(*s_hermesApp->hermes, "on_frame")
-        .call(*s_hermesApp->hermes, sapp_widthf(), sapp_heightf(),
-              stm_sec(stm_diff(now, s_start_time)));
+  // ImGui without the sokol backend: the font atlas is built, but never
+  // uploaded.
+  startup_begin(StartupGfxSetup);
+  igCreateContext(nullptr);
+  ImGuiIO *io = igGetIO();
+  io->IniFilename = nullptr;
+  unsigned char *pixels;
+  int atlasWidth, atlasHeight;
+  startup_begin(StartupFontAtlas);
+  font_atlas_cache_build(io->Fonts);
+  ImFontAtlas_GetTexDataAsRGBA32(io->Fonts, &pixels, &atlasWidth, &atlasHeight,
+                                 nullptr);
+  // Text is measured with the same glyphs as in a window
+  glyph_cache_attach(io->Fonts);
+  startup_end(StartupFontAtlas);
+  startup_end(StartupGfxSetup);
 
-    // Drain microtasks after frame rendering
+  try {
+    startup_begin(StartupOnInit);
+    s_hermesApp->onInit->call(*s_hermesApp->hermes);
     s_hermesApp->hermes->drainMicrotasks();
+    startup_end(StartupOnInit);
   } catch (facebook::jsi::JSIException &e) {
     slog_func("ERROR", 1, 0, e.what(), __LINE__, __FILE__, nullptr);
+    abort();
   }
 
-  update_performance_metrics();
+  std::vector<double> frameTimes;
+  frameTimes.reserve(frames);
+  double reactMaxMs = 0;
+  HudFrame phaseSum{}, phaseMax{};
+  std::vector<double> phaseTimes[HudPhaseCount];
+  size_t nextEvent = 0;
+  int gcFrames = 0;
+  double gcPauseSum = 0, gcPauseMax = 0;
+  // Microtask drains, to compare the overhead of the drain policies
+  double drainCount = 0, drainMs = 0;
+  // Largest allocations of a frame after the warmup, and where they were.
+  double nativeMax = 0, jsMax = 0;
+  int nativeMaxFrame = -1, jsMaxFrame = -1;
+  uint64_t start = stm_now();
+  for (int frame = 0; frame < frames; ++frame) {
+    startup_frame_begin();
+    TraceScope trace(TraceFrame);
+    uint64_t frameStart = stm_now();
+    io->DisplaySize = ImVec2{(float)width, (float)height};
+    io->DeltaTime = (float)frameSec;
+    // Scripted input reaches ImGui before igNewFrame() and JS with the
+    // frame's on_events(), as in app_frame().
+    for (; nextEvent < script.events.size() &&
+           script.events[nextEvent].frame <= frame;
+         ++nextEvent) {
+      const sapp_event &ev = script.events[nextEvent].ev;
+      if (hotkey_dispatch(ev))
+        continue;
+      queue_input_event(&ev);
+      if (ev.type == SAPP_EVENTTYPE_CHAR)
+        glyph_cache_touch_codepoint(ev.char_code);
+      simgui_feed_event(&ev);
+    }
+    glyph_cache_update();
+    font_registry_upload();
+    igNewFrame();
+    deliver_input_events();
 
-  simgui_render();
-  sdtx_canvas((float)sapp_width(), (float)sapp_height());
+    run_macrotasks(s_bench.enabled ? js_clock_ms() : stm_ms(frameStart),
+                   macrotask_budget_ms(frameSec), false);
+    run_js_frame(frame * frameSec, (float)width, (float)height);
+    update_performance_metrics();
+    reactMaxMs = std::max(reactMaxMs, s_react_max_ms);
+    uint64_t renderStart = stm_now();
+    trace_begin(TraceImGuiRender);
+    igRender();
+    trace_end();
+    s_hud_frame.phaseMs[HudImGuiRender] = stm_ms(stm_since(renderStart));
+    startup_frame_end();
 
-  // Position at bottom-left corner
-  // Each character is 8x8 pixels, calculate rows from bottom
-  int num_rows = (int)sapp_height() / 8;
-  int num_lines = s_react_avg_ms_display > 0 ? 3 : 2;  // FPS + ImGui [+ React]
-  sdtx_pos(0.0f, (float)(num_rows - num_lines));
+    frameTimes.push_back(stm_ms(stm_since(frameStart)));
+    sample_gc_stats();
+    sample_scheduler_stats();
+    update_cpu_profile();
+    HudFrame phases = take_hud_frame(frameTimes.back());
+    for (int p = 0; p < HudPhaseCount; ++p) {
+      phaseSum.phaseMs[p] += phases.phaseMs[p];
+      phaseMax.phaseMs[p] = std::max(phaseMax.phaseMs[p], phases.phaseMs[p]);
+      phaseTimes[p].push_back(phases.phaseMs[p]);
+    }
+    gcFrames += phases.gcCount > 0;
+    gcPauseSum += phases.gcMs;
+    gcPauseMax = std::max(gcPauseMax, phases.gcMs);
+    drainCount += s_metrics.microtaskDrains;
+    drainMs += s_metrics.microtaskDrainTime;
+    if (frame >= s_headless.warmupFrames) {
+      double nativeBytes =
+          s_metrics.nativeAllocBytes + s_metrics.imguiAllocBytes;
+      if (nativeBytes > nativeMax) {
+        nativeMax = nativeBytes;
+        nativeMaxFrame = frame;
+      }
+      if (s_metrics.jsAllocBytes > jsMax) {
+        jsMax = s_metrics.jsAllocBytes;
+        jsMaxFrame = frame;
+      }
+    }
+    run_idle_callbacks(frameStart, frameSec);
+    run_idle_gc(frameStart, frameSec);
+    bench_frame_end();
+  }
+  double totalMs = stm_ms(stm_since(start));
 
-  sdtx_printf("FPS: %d\n", (int)(s_fps + 0.5));
-  sdtx_printf("ImGui: %dus\n", (int)(s_imgui_avg_ms_display * 1000.0 + 0.5));
-  if (s_react_avg_ms_display > 0) {
-    sdtx_printf("React: %d/%dus",
-                (int)(s_react_avg_ms_display * 1000.0 + 0.5),
-                (int)(s_react_max_ms_display * 1000.0 + 0.5));
+  double sumMs = 0;
+  for (double ms : frameTimes)
+    sumMs += ms;
+  std::sort(frameTimes.begin(), frameTimes.end());
+  printf("Headless: %d frames at %dx%d, %.2fms step, %.1fms total, "
+         "%.1f frames/s%s\n",
+         frames, width, height, s_headless.frameMs, totalMs,
+         frames * 1000.0 / totalMs, s_bench.enabled ? " (fixed clock)" : "");
+  if (s_headless.script)
+    printf("Replayed %zu input events from %s\n", script.events.size(),
+           s_headless.script);
+  printf("Frame: avg %.3fms, min %.3fms, p50 %.3fms, p95 %.3fms, "
+         "p99 %.3fms, max %.3fms\n",
+         sumMs / frameTimes.size(), frameTimes.front(),
+         percentile(frameTimes, 0.5), percentile(frameTimes, 0.95),
+         percentile(frameTimes, 0.99), frameTimes.back());
+  printf("ImGui render: avg %.3fms; React commit: avg %.3fms, p50 %.3fms, "
+         "p95 %.3fms, p99 %.3fms, max %.3fms\n",
+         s_imgui_avg_ms, s_react_avg_ms, s_metrics.reconciliationP50,
+         s_metrics.reconciliationP95, s_metrics.reconciliationP99,
+         reactMaxMs);
+  printf("Tasks: %d deferred, %d overruns\n", s_deferred_tasks,
+         s_budget_overruns);
+  const char *drainPolicy = kMicrotaskDrainNames[(int)s_microtask_drain];
+  printf("Microtasks (%s drain policy): %.1f drains, %.3fms per frame\n",
+         drainPolicy, drainCount / frames, drainMs / frames);
+  printf("GC: %d collections in %d frames, pauses %.3fms total, %.3fms max "
+         "per frame; heap %.1f/%.1f MB\n",
+         (int)s_metrics.gcCount, gcFrames, gcPauseSum, gcPauseMax,
+         s_metrics.heapAllocated / 1048576.0, s_metrics.heapSize / 1048576.0);
+  printf("Allocations per frame after %d warmup frames: native max %.0f "
+         "bytes (frame %d), JS max %.0f bytes (frame %d)\n",
+         s_headless.warmupFrames, nativeMax, nativeMaxFrame, jsMax,
+         jsMaxFrame);
+  static const char *const phaseNames[HudPhaseCount] = {
+      "macrotasks", "rAF", "React commit", "renderTree", "ImGui render",
+      "commit"};
+  printf("Phases (avg/max):");
+  for (int p = 0; p < HudPhaseCount; ++p) {
+    printf("%s %s %.3f/%.3fms", p ? "," : "", phaseNames[p],
+           phaseSum.phaseMs[p] / frames, phaseMax.phaseMs[p]);
   }
-  sdtx_draw();
-  sg_end_pass();
-  sg_commit();
-}
+  printf("\n");
+  stop_trace_capture();
+  stop_cpu_profile();
 
-/// sapp_desc that will be populated from globalThis.sappConfig
-static sapp_desc s_app_desc{};
+  bool ok = true;
+  if (s_headless.report) {
+    FILE *f = fopen(s_headless.report, "w");
+    if (!f) {
+      fprintf(stderr, "Can't write report %s\n", s_headless.report);
+      ok = false;
+    } else {
+      fprintf(f,
+              "{\n  \"frames\": %d,\n  \"frameMs\": %.4f,\n"
+              "  \"framesPerSec\": %.2f,\n  \"fixedClock\": %s,\n"
+              "  \"width\": %d,\n  \"height\": %d,\n"
+              "  \"scriptEvents\": %zu,\n  \"frame\": ",
+              frames, s_headless.frameMs, frames * 1000.0 / totalMs,
+              s_bench.enabled ? "true" : "false", width, height,
+              script.events.size());
+      write_stats_json(f, frameTimes);
+      fputs(",\n  \"phases\": {", f);
+      for (int p = 0; p < HudPhaseCount; ++p) {
+        fprintf(f, "%s\n    \"%s\": ", p ? "," : "", phaseNames[p]);
+        write_stats_json(f, phaseTimes[p]);
+      }
+      fprintf(f,
+              "\n  },\n  \"reactCommit\": {\"avg\": %.4f, \"p50\": %.4f, "
+              "\"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f},\n",
+              s_react_avg_ms, s_metrics.reconciliationP50,
+              s_metrics.reconciliationP95, s_metrics.reconciliationP99,
+              reactMaxMs);
+      fprintf(f,
+              "  \"gc\": {\"collections\": %d, \"frames\": %d, "
+              "\"pauseTotalMs\": %.4f, \"pauseMaxMs\": %.4f},\n",
+              (int)s_metrics.gcCount, gcFrames, gcPauseSum, gcPauseMax);
+      fprintf(f,
+              "  \"allocations\": {\"warmupFrames\": %d, "
+              "\"nativeMaxBytes\": %.0f, \"jsMaxBytes\": %.0f},\n",
+              s_headless.warmupFrames, nativeMax, jsMax);
+      fprintf(f,
+              "  \"microtasks\": {\"drainPolicy\": \"%s\", "
+              "\"drainsPerFrame\": %.2f, \"drainMsPerFrame\": %.4f},\n",
+              drainPolicy, drainCount / frames, drainMs / frames);
+      fprintf(f, "  \"tasks\": {\"deferred\": %d, \"overruns\": %d}\n}\n",
+              s_deferred_tasks, s_budget_overruns);
+      fclose(f);
+      printf("Report written to %s\n", s_headless.report);
+    }
+  }
+  if (s_headless.maxNativeBytes >= 0 && nativeMax > s_headless.maxNativeBytes) {
+    fprintf(stderr,
+            "Allocation check failed: frame %d allocated %.0f native bytes "
+            "(limit %.0f)\n",
+            nativeMaxFrame, nativeMax, s_headless.maxNativeBytes);
+    ok = false;
+  }
+  if (s_headless.maxJsBytes >= 0 && jsMax > s_headless.maxJsBytes) {
+    fprintf(stderr,
+            "Allocation check failed: frame %d allocated %.0f JS heap bytes "
+            "(limit %.0f)\n",
+            jsMaxFrame, jsMax, s_headless.maxJsBytes);
+    ok = false;
+  }
+
+  s_images.clear();
+  s_image_refs.clear();
+  s_free_image_slots.clear();
+  s_placeholder_image = -1;
+  igDestroyContext(nullptr);
+  shutdown_workers();
+  delete s_hermesApp;
+  s_hermesApp = nullptr;
+  return ok;
+}
 
 /// Safely convert double to int, avoiding undefined behavior
 static int safe_double_to_int(double value, int defaultValue) {
@@ -388,6 +3258,120 @@ static void populate_sapp_desc_from_config(facebook::hermes::HermesRuntime *herm
     READ_INT_PROP("max_dropped_files", max_dropped_files, 1);
     READ_INT_PROP("max_dropped_file_path_length", max_dropped_file_path_length, 2048);
 
+    // Runtime settings
+    if (config.hasProperty(*hermes, "macrotask_budget")) {
+      auto value = config.getProperty(*hermes, "macrotask_budget");
+      if (value.isNumber() && value.asNumber() > 0)
+        s_macrotask_budget = value.asNumber();
+    }
+    if (config.hasProperty(*hermes, "macrotask_budget_ms")) {
+      auto value = config.getProperty(*hermes, "macrotask_budget_ms");
+      if (value.isNumber() && value.asNumber() > 0)
+        s_macrotask_budget_ms = value.asNumber();
+    }
+    if (config.hasProperty(*hermes, "idle_sleep_ms")) {
+      auto value = config.getProperty(*hermes, "idle_sleep_ms");
+      if (value.isNumber() && value.asNumber() >= 0)
+        s_idle_sleep_ms = value.asNumber();
+    }
+    if (config.hasProperty(*hermes, "idle_gc")) {
+      auto value = config.getProperty(*hermes, "idle_gc");
+      if (!value.isString() ||
+          !parse_idle_gc_policy(value.getString(*hermes).utf8(*hermes)))
+        fprintf(stderr, "sappConfig.idle_gc must be \"off\", \"balanced\" "
+                        "or \"aggressive\"\n");
+    }
+    if (config.hasProperty(*hermes, "microtask_drain")) {
+      auto value = config.getProperty(*hermes, "microtask_drain");
+      if (!value.isString() ||
+          !parse_microtask_drain(value.getString(*hermes).utf8(*hermes)))
+        fprintf(stderr, "sappConfig.microtask_drain must be \"task\", "
+                        "\"phase\" or \"frame\"\n");
+    }
+    // Lets benchmarks compare the policies without editing the app
+    if (const char *drain = getenv("IMGUI_MICROTASK_DRAIN")) {
+      if (!parse_microtask_drain(drain))
+        fprintf(stderr, "IMGUI_MICROTASK_DRAIN: unknown policy '%s'\n", drain);
+    }
+    // Without the hook, jslib runs its tasks and callbacks back to back and
+    // the host drains at the end of the phase
+    if (s_microtask_drain != MicrotaskDrain::Task)
+      hermes->global().setProperty(*hermes, "__drainMicrotasks",
+                                   facebook::jsi::Value::undefined());
+    if (config.hasProperty(*hermes, "low_latency")) {
+      auto value = config.getProperty(*hermes, "low_latency");
+      if (value.isBool())
+        s_low_latency = value.asBool();
+    }
+    if (config.hasProperty(*hermes, "raw_input_events")) {
+      auto value = config.getProperty(*hermes, "raw_input_events");
+      if (value.isBool())
+        s_raw_input_events = value.asBool();
+    }
+    if (config.hasProperty(*hermes, "on_demand")) {
+      auto value = config.getProperty(*hermes, "on_demand");
+      if (value.isBool())
+        s_on_demand = value.asBool();
+    }
+    if (config.hasProperty(*hermes, "perf_hud")) {
+      auto value = config.getProperty(*hermes, "perf_hud");
+      if (value.isBool())
+        s_hud.visible = value.asBool();
+    }
+    // true for the per-user cache directory, or a directory
+    if (config.hasProperty(*hermes, "font_cache")) {
+      auto value = config.getProperty(*hermes, "font_cache");
+      if (value.isBool() && value.getBool())
+        font_atlas_cache_set_dir(font_atlas_cache_default_dir());
+      else if (value.isString())
+        font_atlas_cache_set_dir(value.getString(*hermes).utf8(*hermes));
+    }
+    // The fallback font of the glyph cache, or {font, height}
+    if (config.hasProperty(*hermes, "glyph_cache")) {
+      auto value = config.getProperty(*hermes, "glyph_cache");
+      if (value.isString()) {
+        glyph_cache_set_font(value.getString(*hermes).utf8(*hermes));
+      } else if (value.isObject()) {
+        auto options = value.getObject(*hermes);
+        auto font = options.getProperty(*hermes, "font");
+        if (font.isString())
+          glyph_cache_set_font(font.getString(*hermes).utf8(*hermes));
+        auto height = options.getProperty(*hermes, "height");
+        if (height.isNumber())
+          glyph_cache_set_height(safe_double_to_int(height.getNumber(), 0));
+      }
+    }
+    if (config.hasProperty(*hermes, "texture_budget_mb")) {
+      auto value = config.getProperty(*hermes, "texture_budget_mb");
+      if (value.isNumber() && value.getNumber() >= 0)
+        s_texture_budget = (size_t)(value.getNumber() * 1024 * 1024);
+    }
+    // The largest side of the images packed into the atlas; true for 64
+    if (config.hasProperty(*hermes, "image_atlas")) {
+      auto value = config.getProperty(*hermes, "image_atlas");
+      if (value.isBool())
+        s_image_atlas.setMaxSize(value.getBool() ? 64 : 0);
+      else if (value.isNumber())
+        s_image_atlas.setMaxSize(safe_double_to_int(value.getNumber(), 0));
+    }
+    if (config.hasProperty(*hermes, "threaded")) {
+      auto value = config.getProperty(*hermes, "threaded");
+      if (value.isBool())
+        s_threaded = value.asBool();
+    }
+    // The frame pacing modes schedule the JS work of the main thread's
+    // frames, which threaded mode moves elsewhere.
+    if (s_threaded) {
+      s_idle_sleep_ms = 0;
+      s_on_demand = false;
+      s_low_latency = false;
+    }
+    // Benchmark runs render every frame
+    if (s_bench.enabled) {
+      s_idle_sleep_ms = 0;
+      s_on_demand = false;
+    }
+
     // Read bool fields
     READ_BOOL_PROP("fullscreen", fullscreen);
     READ_BOOL_PROP("high_dpi", high_dpi);
@@ -398,32 +3382,321 @@ static void populate_sapp_desc_from_config(facebook::hermes::HermesRuntime *herm
 #undef READ_INT_PROP
 #undef READ_BOOL_PROP
   }
+  // Overrides sappConfig.font_cache; empty disables the cache
+  if (const char *fontCache = getenv("IMGUI_FONT_CACHE"))
+    font_atlas_cache_set_dir(fontCache);
+  // Overrides the font of sappConfig.glyph_cache; empty disables the cache
+  if (const char *glyphFont = getenv("IMGUI_GLYPH_FONT"))
+    glyph_cache_set_font(glyphFont);
+  // Read before the window opens (sappConfig.settings, IMGUI_SETTINGS)
+  settings_store_open(*hermes);
 
   s_app_desc = desc;
 }
 
 /// jslib-unit initialization.
 extern "C" SHUnit *sh_export_jslib(void);
-/// imgui-unit initialization.
-extern "C" SHUnit *sh_export_imgui(void);
+/// The imgui unit: the shared one (sh_export_imgui) or the app's
+/// specialized one. Not referenced here, so that only the registered one is
+/// linked in.
+static SHUnitCreator s_imgui_unit = nullptr;
+
+void imgui_register_imgui_unit(SHUnitCreator imguiUnit) {
+  s_imgui_unit = imguiUnit;
+}
+
+/// The app's CONFIG file (add_react_imgui_app()), null without one.
+static const char *s_app_config = nullptr;
+
+void imgui_register_app_config(const char *json) { s_app_config = json; }
+
+/// add_react_imgui_app(HERMES_CONFIG ...), applied before IMGUI_HERMES_CONFIG.
+static const char *s_hermes_config = nullptr;
+
+void imgui_register_texture_variants(const char *sourceDir,
+                                     const char *variantDir) {
+  add_texture_variant_dir(sourceDir, variantDir);
+}
+
+void imgui_register_hermes_config(const char *spec) {
+  s_hermes_config = spec;
+}
+
+/// Defaults for a class of devices. Each one is overridden by the explicit
+/// setting: HERMES_CONFIG and IMGUI_HERMES_CONFIG, or the sappConfig key.
+struct MemoryProfile {
+  const char *name;
+  /// Hermes settings, applied before HERMES_CONFIG.
+  const char *hermesConfig;
+  /// sappConfig.texture_budget_mb; 0 for no budget.
+  double textureBudgetMb;
+  /// sappConfig.tmp_arena_limit_kb; 0 for no limit.
+  double tmpArenaLimitKb;
+  /// Largest side of the font atlas texture; 0 for no limit.
+  int fontAtlasMaxSize;
+};
+
+static const MemoryProfile kMemoryProfiles[] = {
+    {"default", nullptr, 0, 0, 0},
+    // Panels with 512 MB of RAM, shared with the system and the GPU
+    {"embedded", "init_heap=8M,max_heap=96M,release_unused=young_always", 48,
+     1024, 2048},
+};
+
+#if IMGUI_EMBEDDED_PROFILE
+static const MemoryProfile *s_memory_profile = &kMemoryProfiles[1];
+#else
+static const MemoryProfile *s_memory_profile = &kMemoryProfiles[0];
+#endif
+
+/// Select the memory profile `name`. Returns false if there is none.
+static bool set_memory_profile(const char *name) {
+  for (const MemoryProfile &profile : kMemoryProfiles) {
+    if (strcmp(profile.name, name) == 0) {
+      s_memory_profile = &profile;
+      return true;
+    }
+  }
+  return false;
+}
+
+void imgui_register_memory_profile(const char *name) {
+  if (!set_memory_profile(name))
+    fprintf(stderr, "MEMORY_PROFILE: unknown profile '%s'\n", name);
+}
+
+/// Parse a heap size: bytes, or a number with a K, M or G suffix.
+static bool parse_heap_size(const std::string &text,
+                            ::hermes::vm::gcheapsize_t &size) {
+  char *end;
+  double value = strtod(text.c_str(), &end);
+  double scale = 1;
+  if (*end == 'K' || *end == 'k')
+    scale = 1 << 10;
+  else if (*end == 'M' || *end == 'm')
+    scale = 1 << 20;
+  else if (*end == 'G' || *end == 'g')
+    scale = 1 << 30;
+  if (scale != 1)
+    ++end;
+  value *= scale;
+  if (end == text.c_str() || *end || !(value >= 0) ||
+      value > (double)std::numeric_limits<::hermes::vm::gcheapsize_t>::max())
+    return false;
+  size = (::hermes::vm::gcheapsize_t)value;
+  return true;
+}
+
+/// Apply the comma separated `key=value` settings of `spec` (`source` names
+/// it in errors), which have to be known before _sh_init().
+static void apply_hermes_config(const char *source, const char *spec,
+                                ::hermes::vm::GCConfig::Builder &gc,
+                                ::hermes::vm::RuntimeConfig::Builder &runtime) {
+  std::stringstream stream(spec);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    if (item.empty())
+      continue;
+    size_t eq = item.find('=');
+    std::string key = item.substr(0, eq);
+    std::string value = eq == std::string::npos ? "" : item.substr(eq + 1);
+    ::hermes::vm::gcheapsize_t size = 0;
+    bool ok = true;
+    if (key == "min_heap" || key == "init_heap" || key == "max_heap") {
+      ok = parse_heap_size(value, size);
+      if (ok && key == "min_heap")
+        gc.withMinHeapSize(size);
+      else if (ok && key == "init_heap")
+        gc.withInitHeapSize(size);
+      else if (ok)
+        gc.withMaxHeapSize(size);
+    } else if (key == "occupancy") {
+      char *end;
+      double target = strtod(value.c_str(), &end);
+      ok = !value.empty() && !*end && target > 0 && target < 1;
+      if (ok)
+        gc.withOccupancyTarget(target);
+    } else if (key == "release_unused") {
+      if (value == "none")
+        gc.withShouldReleaseUnused(::hermes::vm::kReleaseUnusedNone);
+      else if (value == "old")
+        gc.withShouldReleaseUnused(::hermes::vm::kReleaseUnusedOld);
+      else if (value == "young_on_full")
+        gc.withShouldReleaseUnused(::hermes::vm::kReleaseUnusedYoungOnFull);
+      else if (value == "young_always")
+        gc.withShouldReleaseUnused(::hermes::vm::kReleaseUnusedYoungAlways);
+      else
+        ok = false;
+    } else if (key == "alloc_in_young") {
+      ok = value == "0" || value == "1";
+      if (ok)
+        gc.withAllocInYoung(value == "1");
+    } else if (key == "max_registers") {
+      char *end;
+      unsigned long count = strtoul(value.c_str(), &end, 10);
+      ok = !value.empty() && !*end && count > 0 && count <= UINT32_MAX;
+      if (ok)
+        runtime.withMaxNumRegisters((unsigned)count);
+    } else {
+      fprintf(stderr, "%s: unknown setting '%s'\n", source, key.c_str());
+      continue;
+    }
+    if (!ok)
+      fprintf(stderr, "%s: invalid value for %s: '%s'\n", source, key.c_str(),
+              value.c_str());
+  }
+}
+
+/// Merge the CONFIG file into globalThis.sappConfig, before the React
+/// bundle adds to it. Returns its async_init setting.
+static bool apply_app_config(facebook::hermes::HermesRuntime *hermes) {
+  if (!s_app_config)
+    return false;
+  auto &rt = *hermes;
+  auto global = rt.global();
+  auto config =
+      global.getPropertyAsObject(rt, "JSON")
+          .getPropertyAsFunction(rt, "parse")
+          .call(rt, facebook::jsi::String::createFromUtf8(rt, s_app_config));
+  if (!config.isObject())
+    throw facebook::jsi::JSINativeException("CONFIG must be a JSON object");
+  global.getPropertyAsObject(rt, "Object")
+      .getPropertyAsFunction(rt, "assign")
+      .call(rt, global.getProperty(rt, "sappConfig"), config);
+  auto async = config.asObject(rt).getProperty(rt, "async_init");
+  return async.isBool() && async.getBool();
+}
+
+/// Evaluate the React bundle through imgui_main().
+static void load_react_unit(int argc, char *argv[]) {
+  startup_begin(StartupImguiMain);
+  imgui_main(argc, argv, s_hermesApp->hermes);
+  startup_end(StartupImguiMain);
+}
+
+/// Evaluate the imgui unit, which defines the entry points.
+static void load_imgui_unit() {
+  startup_begin(StartupImguiUnit);
+  if (!s_imgui_unit) {
+    fprintf(stderr, "No imgui unit registered (see add_react_imgui_app())\n");
+    abort();
+  }
+  s_hermesApp->hermes->evaluateSHUnit(s_imgui_unit);
+  s_hermesApp->resolveEntryPoints();
+  startup_end(StartupImguiUnit);
+}
+
+/// Run the next step of an async init. Exits if the app fails to load,
+/// like sokol_main() does.
+static void run_async_init_step() {
+  int step = s_async_init_step;
+  try {
+    switch (step) {
+    case AsyncInitReactUnit:
+      load_react_unit(s_argc, s_argv);
+      break;
+    case AsyncInitImguiUnit:
+      load_imgui_unit();
+      break;
+    case AsyncInitOnInit:
+      startup_begin(StartupOnInit);
+      s_hermesApp->onInit->call(*s_hermesApp->hermes);
+      s_hermesApp->hermes->drainMicrotasks();
+      startup_end(StartupOnInit);
+      break;
+    default:
+      break;
+    }
+  } catch (facebook::jsi::JSError &e) {
+    printf("JS Exception: %s\n", e.getStack().c_str());
+    exit(1);
+  } catch (facebook::jsi::JSIException &e) {
+    printf("JSI Exception: %s\n", e.what());
+    exit(1);
+  } catch (const std::exception &e) {
+    printf("C++ Exception: %s\n", e.what());
+    exit(1);
+  }
+  s_async_init_step = step + 1;
+}
 
 sapp_desc sokol_main(int argc, char *argv[]) {
   // Initialize Sokol time before anything else
   stm_setup();
+  std::fill_n(s_startup_start, (int)StartupPhaseCount, -1.0);
+  std::fill_n(s_startup_ms, (int)StartupPhaseCount, -1.0);
+  // Created first, for the startup jobs, which overlap _sh_init() and the
+  // loading of the units below
+  s_thread_pool = std::make_unique<ThreadPool>(
+      std::clamp(std::thread::hardware_concurrency(), 2u, 4u));
+  if (const char *mapFlags = getenv("IMGUI_BUNDLE_MAP"))
+    setup_bundle_map(mapFlags);
+  parse_headless_args(argc, argv);
+  if (const char *profile = getenv("IMGUI_MEMORY_PROFILE")) {
+    if (!set_memory_profile(profile))
+      fprintf(stderr, "IMGUI_MEMORY_PROFILE: unknown profile '%s'\n", profile);
+  }
+  s_texture_budget =
+      (size_t)(s_memory_profile->textureBudgetMb * 1024 * 1024);
+  font_atlas_cache_set_max_size(s_memory_profile->fontAtlasMaxSize);
+  igSetAllocatorFunctions(imgui_counting_alloc, imgui_counting_free, nullptr);
+  predecode_internal_images();
+  // The headless context builds its own atlas, without sokol_imgui.
+  if (!s_headless.enabled) {
+    // IMGUI_FONT_CACHE is reapplied over sappConfig.font_cache later
+    if (const char *fontCache = getenv("IMGUI_FONT_CACHE"))
+      font_atlas_cache_set_dir(fontCache);
+    font_atlas_cache_prebuild(*s_thread_pool);
+  }
+  trace_set_thread_name("main");
+  if (const char *tracePath = getenv("IMGUI_TRACE")) {
+    if (*tracePath)
+      s_trace_path = tracePath;
+    start_trace_capture();
+  }
 
   // Enable microtask queue for Promise support
-  auto runtimeConfig = ::hermes::vm::RuntimeConfig::Builder()
-                           .withMicrotaskQueue(true)
-                           .withES6BlockScoping(true)
-                           .build();
+  s_gc_js_thread = std::this_thread::get_id();
+  ::hermes::vm::GCConfig::Builder gcBuilder;
+  gcBuilder.withCallback(gc_event_callback);
+  ::hermes::vm::RuntimeConfig::Builder runtimeBuilder;
+  runtimeBuilder.withMicrotaskQueue(true).withES6BlockScoping(true);
+  // Heap and GC settings, from the memory profile, the build and then the
+  // environment
+  if (s_memory_profile->hermesConfig)
+    apply_hermes_config("IMGUI_MEMORY_PROFILE", s_memory_profile->hermesConfig,
+                        gcBuilder, runtimeBuilder);
+  if (s_hermes_config)
+    apply_hermes_config("HERMES_CONFIG", s_hermes_config, gcBuilder,
+                        runtimeBuilder);
+  if (const char *spec = getenv("IMGUI_HERMES_CONFIG"))
+    apply_hermes_config("IMGUI_HERMES_CONFIG", spec, gcBuilder,
+                        runtimeBuilder);
+  auto runtimeConfig = runtimeBuilder.withGCConfig(gcBuilder.build()).build();
+  // Workers get the same settings. Their collections don't pause this
+  // thread's JS, so they aren't counted.
+  gcBuilder.withCallback(nullptr);
+  auto workerConfig = runtimeBuilder.withGCConfig(gcBuilder.build()).build();
+  startup_begin(StartupRuntimeInit);
   SHRuntime *shr = _sh_init(runtimeConfig);
   facebook::hermes::HermesRuntime *hermes = _sh_get_hermes_runtime(shr);
+  startup_end(StartupRuntimeInit);
+  hermes->registerForProfiling();
+  if (const char *seconds = getenv("IMGUI_PROFILE_SECONDS"))
+    s_profile_seconds = strtod(seconds, nullptr);
+  if (const char *profilePath = getenv("IMGUI_PROFILE")) {
+    if (*profilePath)
+      s_profile_path = profilePath;
+    start_cpu_profile(-1);
+  }
 
   try {
     // Load jslib unit first to set up event loop and extract helper functions
     // from jslib result
+    startup_begin(StartupJslibUnit);
     facebook::jsi::Object helpers =
         hermes->evaluateSHUnit(sh_export_jslib).asObject(*hermes);
+    startup_end(StartupJslibUnit);
 
     // Set NODE_ENV based on build configuration
 #ifdef NDEBUG
@@ -437,16 +3710,16 @@ sapp_desc sokol_main(int argc, char *argv[]) {
         .setProperty(*hermes, "NODE_ENV", nodeEnv);
 
     // Create and initialize HermesApp
-    s_hermesApp =
-        new HermesApp(shr, helpers.getPropertyAsFunction(*hermes, "peek"),
-                      helpers.getPropertyAsFunction(*hermes, "run"),
-                      helpers.getPropertyAsFunction(*hermes, "flushRaf"));
+    s_hermesApp = new HermesApp(shr, helpers);
 
     // Initialize jslib's current time
-    double curTimeMs = stm_ms(stm_now());
-    s_hermesApp->runMacroTask.call(*s_hermesApp->hermes, curTimeMs);
+    s_hermesApp->runMacroTask.call(*s_hermesApp->hermes, js_clock_ms());
+    if (s_bench.seeded)
+      helpers.getPropertyAsFunction(*hermes, "seedRandom")
+          .call(*hermes, s_bench.seed);
 
-    // Add performance.now() host function using Sokol time
+    // Add performance.now() host function using Sokol time, or the
+    // benchmark clock
     auto perf = facebook::jsi::Object(*s_hermesApp->hermes);
     perf.setProperty(
         *s_hermesApp->hermes, "now",
@@ -455,22 +3728,700 @@ sapp_desc sokol_main(int argc, char *argv[]) {
             facebook::jsi::PropNameID::forAscii(*s_hermesApp->hermes, "now"), 0,
             [](facebook::jsi::Runtime &, const facebook::jsi::Value &,
                const facebook::jsi::Value *,
-               size_t) -> facebook::jsi::Value { return stm_ms(stm_now()); }));
+               size_t) -> facebook::jsi::Value { return js_clock_ms(); }));
     s_hermesApp->hermes->global().setProperty(*s_hermesApp->hermes,
                                               "performance", perf);
 
+    // Add __encodeUtf8(str) host function: encodes a whole string into the
+    // native staging buffer and returns its length in bytes.
+    s_hermesApp->hermes->global().setProperty(
+        *s_hermesApp->hermes, "__encodeUtf8",
+        facebook::jsi::Function::createFromHostFunction(
+            *s_hermesApp->hermes,
+            facebook::jsi::PropNameID::forAscii(*s_hermesApp->hermes,
+                                                "__encodeUtf8"),
+            1,
+            [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+               const facebook::jsi::Value *args,
+               size_t count) -> facebook::jsi::Value {
+              if (count < 1 || !args[0].isString())
+                throw facebook::jsi::JSError(rt,
+                                             "__encodeUtf8 expects a string");
+              s_utf8_staging = args[0].getString(rt).utf8(rt);
+              return (double)s_utf8_staging.size();
+            }));
+
+    // Add __drainMicrotasks() host function: lets jslib's runReady() drain
+    // the microtask queue between macrotasks without returning to C++.
+    s_hermesApp->hermes->global().setProperty(
+        *s_hermesApp->hermes, "__drainMicrotasks",
+        facebook::jsi::Function::createFromHostFunction(
+            *s_hermesApp->hermes,
+            facebook::jsi::PropNameID::forAscii(*s_hermesApp->hermes,
+                                                "__drainMicrotasks"),
+            0,
+            [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+               const facebook::jsi::Value *,
+               size_t) -> facebook::jsi::Value {
+              drain_microtasks(rt);
+              return facebook::jsi::Value::undefined();
+            }));
+
+    // Add __setTreeVersion(version) host function: called by the host config
+    // after each commit that changed the tree.
+    s_hermesApp->hermes->global().setProperty(
+        *s_hermesApp->hermes, "__setTreeVersion",
+        facebook::jsi::Function::createFromHostFunction(
+            *s_hermesApp->hermes,
+            facebook::jsi::PropNameID::forAscii(*s_hermesApp->hermes,
+                                                "__setTreeVersion"),
+            1,
+            [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+               const facebook::jsi::Value *args,
+               size_t count) -> facebook::jsi::Value {
+              if (count < 1 || !args[0].isNumber())
+                throw facebook::jsi::JSError(
+                    rt, "__setTreeVersion expects a version number");
+              s_tree_version = (unsigned)args[0].getNumber();
+              return facebook::jsi::Value::undefined();
+            }));
+
+    // Add __ioWatch(fd, events) and __ioUnwatch(fd) host functions, used by
+    // jslib's ioReactor. __ioWatch returns false if the fd can't be watched.
+    s_hermesApp->hermes->global().setProperty(
+        *s_hermesApp->hermes, "__ioWatch",
+        facebook::jsi::Function::createFromHostFunction(
+            *s_hermesApp->hermes,
+            facebook::jsi::PropNameID::forAscii(*s_hermesApp->hermes,
+                                                "__ioWatch"),
+            2,
+            [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+               const facebook::jsi::Value *args,
+               size_t count) -> facebook::jsi::Value {
+              if (count < 2 || !args[0].isNumber() || !args[1].isNumber())
+                throw facebook::jsi::JSError(
+                    rt, "__ioWatch expects a file descriptor and events");
+              return s_reactor.watch((int)args[0].getNumber(),
+                                     (unsigned)args[1].getNumber());
+            }));
+    s_hermesApp->hermes->global().setProperty(
+        *s_hermesApp->hermes, "__ioUnwatch",
+        facebook::jsi::Function::createFromHostFunction(
+            *s_hermesApp->hermes,
+            facebook::jsi::PropNameID::forAscii(*s_hermesApp->hermes,
+                                                "__ioUnwatch"),
+            1,
+            [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+               const facebook::jsi::Value *args,
+               size_t count) -> facebook::jsi::Value {
+              if (count < 1 || !args[0].isNumber())
+                throw facebook::jsi::JSError(
+                    rt, "__ioUnwatch expects a file descriptor");
+              s_reactor.unwatch((int)args[0].getNumber());
+              return facebook::jsi::Value::undefined();
+            }));
+
+    // Add __traceIntern(name), __traceBegin(id), __traceEnd() and
+    // __traceCounter(id, value) host functions, behind jslib's
+    // globalThis.trace. __traceIntern returns the
+    // ID of an event name, which jslib caches.
+    s_hermesApp->hermes->global().setProperty(
+        *s_hermesApp->hermes, "__traceIntern",
+        facebook::jsi::Function::createFromHostFunction(
+            *s_hermesApp->hermes,
+            facebook::jsi::PropNameID::forAscii(*s_hermesApp->hermes,
+                                                "__traceIntern"),
+            1,
+            [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+               const facebook::jsi::Value *args,
+               size_t count) -> facebook::jsi::Value {
+              if (count < 1 || !args[0].isString())
+                throw facebook::jsi::JSError(rt,
+                                             "__traceIntern expects a name");
+              return trace_intern(args[0].getString(rt).utf8(rt).c_str());
+            }));
+    s_hermesApp->hermes->global().setProperty(
+        *s_hermesApp->hermes, "__traceBegin",
+        facebook::jsi::Function::createFromHostFunction(
+            *s_hermesApp->hermes,
+            facebook::jsi::PropNameID::forAscii(*s_hermesApp->hermes,
+                                                "__traceBegin"),
+            1,
+            [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+               const facebook::jsi::Value *args,
+               size_t count) -> facebook::jsi::Value {
+              if (count < 1 || !args[0].isNumber())
+                throw facebook::jsi::JSError(rt,
+                                             "__traceBegin expects a name ID");
+              trace_begin((int)args[0].getNumber());
+              return facebook::jsi::Value::undefined();
+            }));
+    s_hermesApp->hermes->global().setProperty(
+        *s_hermesApp->hermes, "__traceEnd",
+        facebook::jsi::Function::createFromHostFunction(
+            *s_hermesApp->hermes,
+            facebook::jsi::PropNameID::forAscii(*s_hermesApp->hermes,
+                                                "__traceEnd"),
+            0,
+            [](facebook::jsi::Runtime &, const facebook::jsi::Value &,
+               const facebook::jsi::Value *,
+               size_t) -> facebook::jsi::Value {
+              trace_end();
+              return facebook::jsi::Value::undefined();
+            }));
+    s_hermesApp->hermes->global().setProperty(
+        *s_hermesApp->hermes, "__traceCounter",
+        facebook::jsi::Function::createFromHostFunction(
+            *s_hermesApp->hermes,
+            facebook::jsi::PropNameID::forAscii(*s_hermesApp->hermes,
+                                                "__traceCounter"),
+            2,
+            [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+               const facebook::jsi::Value *args,
+               size_t count) -> facebook::jsi::Value {
+              if (count < 2 || !args[0].isNumber() || !args[1].isNumber())
+                throw facebook::jsi::JSError(
+                    rt, "__traceCounter expects a name ID and a value");
+              trace_counter((int)args[0].getNumber(), args[1].getNumber());
+              return facebook::jsi::Value::undefined();
+            }));
+
+    // Add __profilerStart(seconds) and __profilerStop() host functions,
+    // behind jslib's globalThis.profiler. A negative duration means the
+    // default one.
+    s_hermesApp->hermes->global().setProperty(
+        *s_hermesApp->hermes, "__profilerStart",
+        facebook::jsi::Function::createFromHostFunction(
+            *s_hermesApp->hermes,
+            facebook::jsi::PropNameID::forAscii(*s_hermesApp->hermes,
+                                                "__profilerStart"),
+            1,
+            [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+               const facebook::jsi::Value *args,
+               size_t count) -> facebook::jsi::Value {
+              if (count < 1 || !args[0].isNumber())
+                throw facebook::jsi::JSError(
+                    rt, "__profilerStart expects a duration");
+              start_cpu_profile(args[0].getNumber());
+              return facebook::jsi::Value::undefined();
+            }));
+    s_hermesApp->hermes->global().setProperty(
+        *s_hermesApp->hermes, "__profilerStop",
+        facebook::jsi::Function::createFromHostFunction(
+            *s_hermesApp->hermes,
+            facebook::jsi::PropNameID::forAscii(*s_hermesApp->hermes,
+                                                "__profilerStop"),
+            0,
+            [](facebook::jsi::Runtime &, const facebook::jsi::Value &,
+               const facebook::jsi::Value *,
+               size_t) -> facebook::jsi::Value {
+              stop_cpu_profile();
+              return facebook::jsi::Value::undefined();
+            }));
+
+    // Add __startupTimes() host function, behind jslib's
+    // globalThis.startupTimes(). Returns null until the first frame has
+    // been presented.
+    s_hermesApp->hermes->global().setProperty(
+        *s_hermesApp->hermes, "__startupTimes",
+        facebook::jsi::Function::createFromHostFunction(
+            *s_hermesApp->hermes,
+            facebook::jsi::PropNameID::forAscii(*s_hermesApp->hermes,
+                                                "__startupTimes"),
+            0,
+            [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+               const facebook::jsi::Value *,
+               size_t) -> facebook::jsi::Value {
+              if (!s_startup_done.load(std::memory_order_acquire))
+                return facebook::jsi::Value::null();
+              facebook::jsi::Object times(rt);
+              for (int i = 0; i < StartupPhaseCount; ++i) {
+                if (s_startup_ms[i] >= 0)
+                  times.setProperty(rt, kStartupPhases[i].key,
+                                    s_startup_ms[i]);
+              }
+              times.setProperty(rt, "total", startup_total_ms());
+              times.setProperty(rt, "peakRss", peak_rss_bytes());
+              facebook::jsi::Object majorFaults(rt), minorFaults(rt);
+              for (int i = 0; i < StartupPhaseCount; ++i) {
+                if (s_startup_ms[i] >= 0 && s_startup_start[i] >= 0) {
+                  majorFaults.setProperty(rt, kStartupPhases[i].key,
+                                          s_startup_major_faults[i]);
+                  minorFaults.setProperty(rt, kStartupPhases[i].key,
+                                          s_startup_minor_faults[i]);
+                }
+              }
+              times.setProperty(rt, "majorFaults", majorFaults);
+              times.setProperty(rt, "minorFaults", minorFaults);
+              return times;
+            }));
+
+    // Add __loadLazyUnit(name) host function, behind lazyUnit() in
+    // lib/react-imgui-reconciler/lazy-unit.js. Evaluates the unit once.
+    s_hermesApp->hermes->global().setProperty(
+        *s_hermesApp->hermes, "__loadLazyUnit",
+        facebook::jsi::Function::createFromHostFunction(
+            *s_hermesApp->hermes,
+            facebook::jsi::PropNameID::forAscii(*s_hermesApp->hermes,
+                                                "__loadLazyUnit"),
+            1,
+            [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+               const facebook::jsi::Value *args,
+               size_t count) -> facebook::jsi::Value {
+              if (count < 1 || !args[0].isString())
+                throw facebook::jsi::JSError(
+                    rt, "__loadLazyUnit expects a unit name");
+              load_lazy_unit(rt, args[0].getString(rt).utf8(rt));
+              return facebook::jsi::Value::undefined();
+            }));
+
+    // Add __loadImageAsync(path, callback, mipmaps), __unloadImage(handle),
+    // __imageInfo(handle) and __imagePlaceholder() host functions, behind
+    // jslib's loadImageAsync(), unloadImage(), imageInfo() and
+    // imagePlaceholder().
+    s_hermesApp->hermes->global().setProperty(
+        *s_hermesApp->hermes, "__loadImageAsync",
+        facebook::jsi::Function::createFromHostFunction(
+            *s_hermesApp->hermes,
+            facebook::jsi::PropNameID::forAscii(*s_hermesApp->hermes,
+                                                "__loadImageAsync"),
+            2,
+            [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+               const facebook::jsi::Value *args,
+               size_t count) -> facebook::jsi::Value {
+              if (count < 2 || !args[0].isString() || !args[1].isObject() ||
+                  !args[1].getObject(rt).isFunction(rt))
+                throw facebook::jsi::JSError(
+                    rt, "__loadImageAsync expects a path and a callback");
+              bool mipmaps = count >= 3 && args[2].isBool() &&
+                             args[2].getBool();
+              load_image_async(rt, args[0].getString(rt).utf8(rt), mipmaps,
+                               args[1].getObject(rt).getFunction(rt));
+              return facebook::jsi::Value::undefined();
+            }));
+    s_hermesApp->hermes->global().setProperty(
+        *s_hermesApp->hermes, "__unloadImage",
+        facebook::jsi::Function::createFromHostFunction(
+            *s_hermesApp->hermes,
+            facebook::jsi::PropNameID::forAscii(*s_hermesApp->hermes,
+                                                "__unloadImage"),
+            1,
+            [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+               const facebook::jsi::Value *args,
+               size_t count) -> facebook::jsi::Value {
+              if (count < 1 || !args[0].isNumber())
+                throw facebook::jsi::JSError(
+                    rt, "__unloadImage expects an image handle");
+              unload_image(safe_double_to_int(args[0].getNumber(), -1));
+              return facebook::jsi::Value::undefined();
+            }));
+    s_hermesApp->hermes->global().setProperty(
+        *s_hermesApp->hermes, "__imageInfo",
+        facebook::jsi::Function::createFromHostFunction(
+            *s_hermesApp->hermes,
+            facebook::jsi::PropNameID::forAscii(*s_hermesApp->hermes,
+                                                "__imageInfo"),
+            1,
+            [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+               const facebook::jsi::Value *args,
+               size_t count) -> facebook::jsi::Value {
+              if (count < 1 || !args[0].isNumber())
+                throw facebook::jsi::JSError(
+                    rt, "__imageInfo expects an image handle");
+              int index = safe_double_to_int(args[0].getNumber(), -1);
+              Image *image = find_image(index);
+              if (!image)
+                return facebook::jsi::Value::null();
+              float uv[4];
+              image_uv(index, uv);
+              // Counts as drawing the image, reloading it if it was evicted
+              const simgui_image_t *texture = image_simgui_image(index);
+              facebook::jsi::Object info(rt);
+              info.setProperty(rt, "width", image->w_);
+              info.setProperty(rt, "height", image->h_);
+              info.setProperty(rt, "resident", !image->evicted_);
+              info.setProperty(
+                  rt, "texture",
+                  (double)(uintptr_t)simgui_imtextureid(*texture));
+              info.setProperty(rt, "u0", uv[0]);
+              info.setProperty(rt, "v0", uv[1]);
+              info.setProperty(rt, "u1", uv[2]);
+              info.setProperty(rt, "v1", uv[3]);
+              return info;
+            }));
+    // Add __createStreamTexture(width, height) and
+    // __updateStreamTexture(handle) host functions, behind jslib's
+    // createStreamTexture(). The former returns {handle, buffers}, the two
+    // pixel buffers as ArrayBuffers; the latter queues the buffer JS filled
+    // for upload and returns the index of the one to fill next.
+    s_hermesApp->hermes->global().setProperty(
+        *s_hermesApp->hermes, "__createStreamTexture",
+        facebook::jsi::Function::createFromHostFunction(
+            *s_hermesApp->hermes,
+            facebook::jsi::PropNameID::forAscii(*s_hermesApp->hermes,
+                                                "__createStreamTexture"),
+            2,
+            [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+               const facebook::jsi::Value *args,
+               size_t count) -> facebook::jsi::Value {
+              int width = count >= 2 && args[0].isNumber()
+                              ? safe_double_to_int(args[0].getNumber(), 0)
+                              : 0;
+              int height = count >= 2 && args[1].isNumber()
+                               ? safe_double_to_int(args[1].getNumber(), 0)
+                               : 0;
+              if (width <= 0 || height <= 0)
+                throw facebook::jsi::JSError(
+                    rt, "__createStreamTexture expects a width and a height");
+              static unsigned s_next_stream = 1;
+              std::string name = "stream:" + std::to_string(s_next_stream++);
+              int index = 0;
+              StreamTexture *stream = nullptr;
+              run_on_render_thread([&] {
+                auto texture = std::make_unique<StreamTexture>(
+                    width, height, !s_headless.enabled);
+                stream = texture.get();
+                index = register_image(
+                    std::make_unique<Image>(name, std::move(texture)));
+              });
+              facebook::jsi::Array buffers(rt, 2);
+              for (int i = 0; i < 2; ++i)
+                buffers.setValueAtIndex(
+                    rt, i, facebook::jsi::ArrayBuffer(rt, stream->buffer(i)));
+              facebook::jsi::Object result(rt);
+              result.setProperty(rt, "handle", index);
+              result.setProperty(rt, "buffers", buffers);
+              return result;
+            }));
+    s_hermesApp->hermes->global().setProperty(
+        *s_hermesApp->hermes, "__updateStreamTexture",
+        facebook::jsi::Function::createFromHostFunction(
+            *s_hermesApp->hermes,
+            facebook::jsi::PropNameID::forAscii(*s_hermesApp->hermes,
+                                                "__updateStreamTexture"),
+            1,
+            [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+               const facebook::jsi::Value *args,
+               size_t count) -> facebook::jsi::Value {
+              Image *image =
+                  count >= 1 && args[0].isNumber()
+                      ? find_image(safe_double_to_int(args[0].getNumber(), -1))
+                      : nullptr;
+              if (!image || !image->stream_)
+                throw facebook::jsi::JSError(
+                    rt, "__updateStreamTexture expects a stream texture");
+              return image->stream_->update();
+            }));
+    s_hermesApp->hermes->global().setProperty(
+        *s_hermesApp->hermes, "__imagePlaceholder",
+        facebook::jsi::Function::createFromHostFunction(
+            *s_hermesApp->hermes,
+            facebook::jsi::PropNameID::forAscii(*s_hermesApp->hermes,
+                                                "__imagePlaceholder"),
+            0,
+            [](facebook::jsi::Runtime &, const facebook::jsi::Value &,
+               const facebook::jsi::Value *,
+               size_t) -> facebook::jsi::Value {
+              return placeholder_image();
+            }));
+
+    // Add setSwapInterval(interval) host function: changes the swap
+    // interval of the running app (sappConfig.swap_interval only applies at
+    // startup). Returns the interval now in effect.
+    s_hermesApp->hermes->global().setProperty(
+        *s_hermesApp->hermes, "setSwapInterval",
+        facebook::jsi::Function::createFromHostFunction(
+            *s_hermesApp->hermes,
+            facebook::jsi::PropNameID::forAscii(*s_hermesApp->hermes,
+                                                "setSwapInterval"),
+            1,
+            [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+               const facebook::jsi::Value *args,
+               size_t count) -> facebook::jsi::Value {
+              if (count < 1 || !args[0].isNumber())
+                throw facebook::jsi::JSError(
+                    rt, "setSwapInterval expects an interval");
+              int interval = safe_double_to_int(args[0].getNumber(), 1);
+              // There is no swap chain to configure.
+              if (s_headless.enabled)
+                return interval;
+              run_on_render_thread([&interval] {
+                sapp_set_swap_interval(interval);
+                interval = sapp_swap_interval();
+              });
+              return interval;
+            }));
+
+    // Add __createSharedBuffer(byteLength) host function: allocates native
+    // memory and returns {handle, buffer}, where buffer is an ArrayBuffer
+    // over that memory and handle identifies it to shared_buffer_data().
+    s_hermesApp->hermes->global().setProperty(
+        *s_hermesApp->hermes, "__createSharedBuffer",
+        facebook::jsi::Function::createFromHostFunction(
+            *s_hermesApp->hermes,
+            facebook::jsi::PropNameID::forAscii(*s_hermesApp->hermes,
+                                                "__createSharedBuffer"),
+            1,
+            [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+               const facebook::jsi::Value *args,
+               size_t count) -> facebook::jsi::Value {
+              if (count < 1 || !args[0].isNumber() || args[0].getNumber() < 0)
+                throw facebook::jsi::JSError(
+                    rt, "__createSharedBuffer expects a byte length");
+              auto buf = std::make_shared<SharedBuffer>(
+                  (size_t)args[0].getNumber());
+              int handle = register_shared_buffer(buf);
+              // Posting it to a worker shares it too
+              register_transferable_buffer(buf, true);
+              facebook::jsi::Object result(rt);
+              result.setProperty(rt, "handle", handle);
+              result.setProperty(
+                  rt, "buffer", facebook::jsi::ArrayBuffer(rt, std::move(buf)));
+              return result;
+            }));
+
+    // Add __memoryReport() host function behind jslib's
+    // runtime.memoryReport(): the native side of the report, in bytes.
+    s_hermesApp->hermes->global().setProperty(
+        *s_hermesApp->hermes, "__memoryReport",
+        facebook::jsi::Function::createFromHostFunction(
+            *s_hermesApp->hermes,
+            facebook::jsi::PropNameID::forAscii(*s_hermesApp->hermes,
+                                                "__memoryReport"),
+            0,
+            [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+               const facebook::jsi::Value *,
+               size_t) -> facebook::jsi::Value {
+              MemoryStats memory = memory_stats();
+              auto info =
+                  s_hermesApp->hermes->instrumentation().getHeapInfo(false);
+              facebook::jsi::Object report(rt);
+
+              facebook::jsi::Object heap(rt);
+              heap.setProperty(rt, "used",
+                               (double)info["hermes_allocatedBytes"]);
+              heap.setProperty(rt, "capacity", (double)info["hermes_heapSize"]);
+              report.setProperty(rt, "hermesHeap", heap);
+
+              size_t imageCount = 0;
+              for (auto &image : s_images)
+                imageCount += image != nullptr;
+              facebook::jsi::Array images(rt, imageCount);
+              size_t next = 0;
+              for (size_t i = 0; i < s_images.size(); ++i) {
+                const Image *image = s_images[i].get();
+                if (!image)
+                  continue;
+                facebook::jsi::Object entry(rt);
+                entry.setProperty(rt, "handle", (int)i);
+                entry.setProperty(
+                    rt, "path",
+                    facebook::jsi::String::createFromUtf8(rt, image->path_));
+                entry.setProperty(rt, "width", image->w_);
+                entry.setProperty(rt, "height", image->h_);
+                // Images in the atlas share its pages, counted below
+                bool own = image->slot_.page < 0 && !image->evicted_;
+                entry.setProperty(rt, "bytes",
+                                  own ? (double)image->gpuBytes() : 0.0);
+                entry.setProperty(rt, "inAtlas", image->slot_.page >= 0);
+                images.setValueAtIndex(rt, next++, entry);
+              }
+              facebook::jsi::Object textures(rt);
+              textures.setProperty(rt, "bytes", (double)memory.textureBytes);
+              textures.setProperty(rt, "atlasBytes", (double)memory.atlasBytes);
+              textures.setProperty(rt, "images", images);
+              report.setProperty(rt, "textures", textures);
+
+              facebook::jsi::Object drawLists(rt);
+              drawLists.setProperty(rt, "vertexBytes",
+                                    (double)memory.vertexBytes);
+              drawLists.setProperty(rt, "indexBytes",
+                                    (double)memory.indexBytes);
+              drawLists.setProperty(rt, "commandBytes",
+                                    (double)memory.commandBytes);
+              report.setProperty(rt, "imguiDrawLists", drawLists);
+
+              report.setProperty(rt, "fontAtlasBytes",
+                                 (double)memory.fontAtlasBytes);
+              report.setProperty(rt, "sharedBufferBytes",
+                                 (double)memory.sharedBufferBytes);
+              report.setProperty(rt, "bundleBytes", (double)memory.bundleBytes);
+              return report;
+            }));
+
+    // Add __collectGarbage() host function behind jslib's
+    // runtime.collectGarbage(): a full collection, for leak checkpoints.
+    s_hermesApp->hermes->global().setProperty(
+        *s_hermesApp->hermes, "__collectGarbage",
+        facebook::jsi::Function::createFromHostFunction(
+            *s_hermesApp->hermes,
+            facebook::jsi::PropNameID::forAscii(*s_hermesApp->hermes,
+                                                "__collectGarbage"),
+            0,
+            [](facebook::jsi::Runtime &, const facebook::jsi::Value &,
+               const facebook::jsi::Value *,
+               size_t) -> facebook::jsi::Value {
+              s_hermesApp->hermes->instrumentation().collectGarbage(
+                  "checkpoint");
+              return facebook::jsi::Value::undefined();
+            }));
+
+    // Expose the metrics block to the untyped units as
+    // globalThis.__runtimeMetrics, a Float64Array over s_metrics.
+    {
+      auto &rt = *s_hermesApp->hermes;
+      facebook::jsi::ArrayBuffer buffer(rt, std::make_shared<MetricsBuffer>());
+      rt.global().setProperty(
+          rt, "__runtimeMetrics",
+          rt.global()
+              .getPropertyAsFunction(rt, "Float64Array")
+              .callAsConstructor(rt, buffer));
+    }
+
+    // Add __fsAsync() host function behind jslib's fs.promises, running the
+    // file operations on the worker threads.
+    install_async_fs(*s_hermesApp->hermes, *s_thread_pool,
+                     post_to_main_thread);
+
+    // Add __runNative() host function behind jslib's runNative(), running
+    // the kernels registered with imgui_register_native_task() on the same
+    // threads.
+    install_native_tasks(*s_hermesApp->hermes, *s_thread_pool,
+                         post_to_main_thread);
+
+    // Add __parseColumns() host function behind jslib's parseColumns(),
+    // parsing CSV and JSON into columns on the worker threads
+    install_columnar_parse(*s_hermesApp->hermes, *s_thread_pool,
+                           post_to_main_thread);
+
+    // Add the __decoder*() host functions behind jslib's
+    // createRecordDecoder(), decoding binary and msgpack records into
+    // columns on the worker threads and the WebSocket I/O thread
+    install_record_decoders(*s_hermesApp->hermes, *s_thread_pool,
+                            post_to_main_thread);
+
+    // Add the __store*() host functions behind react-imgui-reconciler's
+    // createColumnStore(): versioned writes to shared-array columns, and
+    // the changed selections diffed natively once per batch
+    install_column_stores(*s_hermesApp->hermes, post_to_main_thread);
+
+    // Add __tableOp() host function behind jslib's tableOps, sorting,
+    // filtering and grouping columns in parallel on the worker threads
+    install_table_kernels(*s_hermesApp->hermes, *s_thread_pool,
+                          post_to_main_thread);
+
+    // Add __cancelTask(id) host function: cancels the pool job of an ID
+    // returned by __runNative() or __tableOp(), the cancel() of their
+    // promises
+    s_hermesApp->hermes->global().setProperty(
+        *s_hermesApp->hermes, "__cancelTask",
+        facebook::jsi::Function::createFromHostFunction(
+            *s_hermesApp->hermes,
+            facebook::jsi::PropNameID::forAscii(*s_hermesApp->hermes,
+                                                "__cancelTask"),
+            1,
+            [](facebook::jsi::Runtime &rt, const facebook::jsi::Value &,
+               const facebook::jsi::Value *args,
+               size_t count) -> facebook::jsi::Value {
+              if (count >= 1 && args[0].isNumber())
+                cancel_task((unsigned)args[0].getNumber());
+              return facebook::jsi::Value::undefined();
+            }));
+
+    // Add the __audioLoad(), __audioPlay(), __audioStopAll() and
+    // __audioSetVolume() host functions behind jslib's audio: samples decoded
+    // on the worker threads, mixed on the audio device's thread
+    install_audio(*s_hermesApp->hermes, *s_thread_pool, post_to_main_thread);
+
+    // Add the __fetch*() host functions behind jslib's fetch(): HTTP/1.1
+    // requests with pooled keep-alive connections on the worker threads,
+    // bodies read in chunks, into one buffer or into a file
+    install_fetch(*s_hermesApp->hermes, *s_thread_pool, post_to_main_thread);
+
+    // Add the __ws*() host functions behind jslib's WebSocket: sockets, TLS
+    // and framing on a native I/O thread, messages delivered once per frame
+    install_websockets(*s_hermesApp->hermes, *s_thread_pool,
+                       post_to_main_thread);
+
+    // Index the files and buffers of <textview> on the worker threads, and
+    // add the __tail*() host functions behind jslib's fs.watchTail()
+    install_text_views(*s_hermesApp->hermes, *s_thread_pool,
+                       post_to_main_thread);
+
+    // Build the atlases of <font> on the worker threads
+    install_font_registry(*s_thread_pool, !s_headless.enabled,
+                          post_to_main_thread);
+
+    // Add __recordRing() host function behind jslib's recordRing()
+    install_record_rings(*s_hermesApp->hermes);
+
+    // Add the __series*() host functions behind jslib's createTimeSeries():
+    // sample rings with 1 s, 10 s and 1 min levels for <plotlines series>
+    install_time_series(*s_hermesApp->hermes);
+
+    // Add the __filter*() host functions behind jslib's createFilterIndex():
+    // SIMD substring matching over a folded string arena, incremental as
+    // the query grows
+    install_filter_indexes(*s_hermesApp->hermes);
+
+    // Add __captureFrame() host function behind jslib's captureFrame():
+    // framebuffer readback through a ring of pixel buffers, encoded on the
+    // worker threads
+    install_frame_capture(*s_hermesApp->hermes, *s_thread_pool,
+                          !s_headless.enabled, post_to_main_thread);
+
+    // Add __notify() and __onNotify() host functions behind jslib's notify()
+    // and onNotify(): batched wakeups from native threads and workers
+    install_notifiers(*s_hermesApp->hermes, post_to_main_thread);
+
+    // Add __hotkeyRegister() and __hotkeyUnregister() host functions behind
+    // jslib's registerHotkey(): shortcuts matched natively in the key events
+    install_hotkeys(*s_hermesApp->hermes, post_to_main_thread);
+
+    // Add __onFilesDropped() host function behind jslib's onFilesDropped():
+    // the paths of the files dropped on the window
+    install_file_drop(*s_hermesApp->hermes, post_to_main_thread);
+
+    // Add the __anim*() host functions behind the reconciler's AnimatedValue
+    // and timeline(): slots moved natively before each on_frame()
+    install_animation(*s_hermesApp->hermes, js_clock_ms);
+
+    // Add __settingsGet() and __settingsSet() host functions behind jslib's
+    // appSettings, kept with ImGui's settings in <executable name>.ini
+    {
+      const char *exe = argc > 0 ? strrchr(argv[0], '/') : nullptr;
+      install_settings_store(*s_hermesApp->hermes, *s_thread_pool,
+                             exe ? exe + 1 : (argc > 0 ? argv[0] : "app"),
+                             !s_headless.enabled);
+    }
+
+    // Add the __workerCreate(), __workerPost() and __workerTerminate() host
+    // functions behind jslib's Worker
+    install_web_workers(*s_hermesApp->hermes, workerConfig,
+                        post_to_main_thread);
+
     // Create globalThis.sappConfig with default title
     auto sappConfig = facebook::jsi::Object(*s_hermesApp->hermes);
     sappConfig.setProperty(*s_hermesApp->hermes, "title",
                            facebook::jsi::String::createFromAscii(
                                *s_hermesApp->hermes, "imgui-react-runtime"));
+    // Read by the imgui unit when it is loaded
+    if (s_memory_profile->tmpArenaLimitKb > 0)
+      sappConfig.setProperty(*s_hermesApp->hermes, "tmp_arena_limit_kb",
+                             s_memory_profile->tmpArenaLimitKb);
     s_hermesApp->hermes->global().setProperty(*s_hermesApp->hermes,
                                               "sappConfig", sappConfig);
 
-    imgui_main(argc, argv, hermes);
-
-    // Load imgui unit
-    hermes->evaluateSHUnit(sh_export_imgui);
+    // Headless runs don't draw a splash screen, so they load everything here
+    if (apply_app_config(hermes) && !s_headless.enabled) {
+      // The window only needs the config file's settings
+      s_argc = argc;
+      s_argv = argv;
+      s_async_init_step = AsyncInitSplash;
+    } else {
+      load_react_unit(argc, argv);
+      load_imgui_unit();
+    }
 
     // Populate sapp_desc from globalThis.sappConfig
     populate_sapp_desc_from_config(hermes);
@@ -479,6 +4430,13 @@ sapp_desc sokol_main(int argc, char *argv[]) {
       throw facebook::jsi::JSINativeException(
           "sokol_app not configured from JS");
 
+    if (s_headless.enabled) {
+      s_threaded = false;
+      exit(run_headless() ? 0 : 1);
+    }
+
+    // Ends in app_init(), once sokol_app has opened the window
+    startup_begin(StartupWindow);
     return s_app_desc;
   } catch (facebook::jsi::JSError &e) {
     // Handle JS exceptions here.
@@ -494,24 +4452,53 @@ sapp_desc sokol_main(int argc, char *argv[]) {
   exit(1);
 }
 
+static void start_hot_reload(facebook::hermes::HermesRuntime *hermes,
+                             const char *jsPath, const char *sourceURL);
+
 void imgui_load_unit(facebook::hermes::HermesRuntime *hermes,
                        SHUnitCreator nativeUnit, bool bytecode,
                        const char *jsPath, const char *sourceURL) {
   if (nativeUnit) {
+    startup_begin(StartupBundleEval);
+    // The app unit takes React and the reconciler from the vendor unit
+    if (s_vendor_unit) {
+      hermes->evaluateSHUnit(s_vendor_unit);
+      s_vendor_unit = nullptr;
+    }
     hermes->evaluateSHUnit(nativeUnit);
+    startup_end(StartupBundleEval);
     printf("Native unit loaded.\n");
   }
 
-  if (jsPath && bytecode) {
+  if (bytecode && s_embedded_bundle) {
+    // Mode 1 with REACT_EMBED_BYTECODE: evaluate the bytecode in place
+    printf("Loading React unit from embedded bytecode (%zu bytes)\n",
+           s_embedded_bundle_size);
+    s_bundle_bytes = s_embedded_bundle_size;
+    auto buffer = std::make_shared<EmbeddedBuffer>(s_embedded_bundle,
+                                                   s_embedded_bundle_size);
+    startup_begin(StartupBundleEval);
+    hermes->evaluateJavaScript(buffer,
+                               sourceURL ? sourceURL : "react-unit-bundle.hbc");
+    startup_end(StartupBundleEval);
+    printf("React unit loaded (embedded bytecode).\n");
+  } else if (jsPath && bytecode) {
     // Mode 1: Bytecode - load .hbc file via evaluateJavaScript
     printf("Loading React unit from bytecode: '%s'\n", jsPath);
-    auto buffer = mapFileBuffer(jsPath, false);
+    startup_begin(StartupBundleMap);
+    auto buffer = mapFileBuffer(jsPath, false, &s_bundle_map_options);
+    startup_end(StartupBundleMap);
+    s_bundle_bytes = buffer->size();
+    startup_begin(StartupBundleEval);
     hermes->evaluateJavaScript(buffer, sourceURL ? sourceURL : jsPath);
+    startup_end(StartupBundleEval);
     printf("React unit loaded (bytecode).\n");
   } else if (jsPath && !bytecode) {
     // Mode 2: Source - load .js file with source map
     printf("Loading React unit from source: '%s'\n", jsPath);
-    auto buffer = mapFileBuffer(jsPath, true);
+    startup_begin(StartupBundleMap);
+    auto buffer = mapFileBuffer(jsPath, true, &s_bundle_map_options);
+    s_bundle_bytes = buffer->size();
 
     // Try to load source map (bundle path + ".map")
     std::string sourceMapPath = std::string(jsPath) + ".map";
@@ -524,14 +4511,143 @@ void imgui_load_unit(facebook::hermes::HermesRuntime *hermes,
     } catch (const std::exception &e) {
       printf("Source map not found: %s\n", e.what());
     }
+    startup_end(StartupBundleMap);
 
     // Evaluate JavaScript with or without source map
+    startup_begin(StartupBundleEval);
     if (hasSourceMap) {
       hermes->evaluateJavaScriptWithSourceMap(buffer, sourceMapBuf,
                                               sourceURL ? sourceURL : jsPath);
     } else {
       hermes->evaluateJavaScript(buffer, sourceURL ? sourceURL : jsPath);
     }
+    startup_end(StartupBundleEval);
     printf("React unit loaded (source).\n");
+    start_hot_reload(hermes, jsPath, sourceURL);
   }
 }
+
+namespace {
+struct LazyUnit {
+  std::string name;
+  SHUnitCreator nativeUnit;
+  bool bytecode;
+  std::string path;
+  bool loaded = false;
+};
+} // namespace
+
+/// Registered lazy units. Registration runs during static initialization,
+/// so the list is constructed on first use.
+static std::vector<LazyUnit> &lazy_units() {
+  static std::vector<LazyUnit> units;
+  return units;
+}
+
+void imgui_register_lazy_unit(const char *name, SHUnitCreator nativeUnit,
+                              bool bytecode, const char *path) {
+  lazy_units().push_back(
+      LazyUnit{name, nativeUnit, bytecode, path ? path : ""});
+}
+
+void imgui_register_worker_unit(const char *name, SHUnitCreator nativeUnit,
+                                bool bytecode, const char *path) {
+  add_web_worker_unit(name, nativeUnit, bytecode, path);
+}
+
+void imgui_register_native_task(const char *name,
+                                void (*kernel)(ImguiNativeTask &task)) {
+  add_native_task(name, kernel);
+}
+
+/// Evaluate the lazy unit `name` unless that happened already. Called by
+/// __loadLazyUnit() on the thread that runs JS.
+static void load_lazy_unit(facebook::jsi::Runtime &rt,
+                           const std::string &name) {
+  std::vector<LazyUnit> &units = lazy_units();
+  auto it = std::find_if(units.begin(), units.end(), [&](const LazyUnit &u) {
+    return u.name == name;
+  });
+  if (it == units.end())
+    throw facebook::jsi::JSError(rt, "Unknown lazy unit '" + name + "'");
+  if (it->loaded)
+    return;
+  // Marked first, so that an exception doesn't lead to a second evaluation
+  // of the part that ran
+  it->loaded = true;
+
+  TraceScope trace(trace_intern("lazy unit"));
+  uint64_t start = stm_now();
+  auto *hermes = s_hermesApp->hermes;
+  if (it->nativeUnit) {
+    hermes->evaluateSHUnit(it->nativeUnit);
+  } else {
+    auto buffer = mapFileBuffer(it->path.c_str(), !it->bytecode,
+                                &s_bundle_map_options);
+    std::string url = "react-lazy-" + name + (it->bytecode ? ".hbc" : ".js");
+    hermes->evaluateJavaScript(buffer, url);
+  }
+  printf("Lazy unit '%s' loaded in %.2f ms.\n", name.c_str(),
+         stm_ms(stm_since(start)));
+}
+
+// Hot reload of the mode 2 bundle, with sappConfig.hot_reload or
+// IMGUI_HOT_RELOAD=1. The bundle file is watched, and each change posts one
+// hot_reload_bundle() to the main thread, which evaluates the new bundle in
+// the running runtime between two frames. jslib, the imgui unit, the
+// textures and the ImGui context (window positions, sizes, tree and tab
+// state) stay; React state starts over.
+static std::string s_hot_reload_path;
+static std::string s_hot_reload_url;
+static unsigned s_hot_reload_watch = 0;
+/// Set from the change until the posted reload runs, so that a burst of
+/// changes makes one reload.
+static std::atomic<bool> s_hot_reload_posted{false};
+
+/// Run jslib's onHotReload() handlers (the reconciler's unmounts its roots),
+/// let the lazy units be evaluated again against the new bundle and
+/// evaluate it. Main thread.
+static void hot_reload_bundle() {
+  s_hot_reload_posted.store(false, std::memory_order_relaxed);
+  TraceScope trace(trace_intern("hot reload"));
+  uint64_t start = stm_now();
+  auto *hermes = s_hermesApp->hermes;
+  s_hermesApp->beforeHotReload.call(*hermes);
+  for (LazyUnit &unit : lazy_units())
+    unit.loaded = false;
+  try {
+    imgui_load_unit(hermes, nullptr, false, s_hot_reload_path.c_str(),
+                    s_hot_reload_url.c_str());
+  } catch (facebook::jsi::JSError &e) {
+    // The roots stay unmounted until a bundle evaluates cleanly
+    fprintf(stderr, "Hot reload failed: %s\n", e.getStack().c_str());
+    return;
+  }
+  printf("Hot reload: %.2f ms\n", stm_ms(stm_since(start)));
+}
+
+/// Watch the bundle just evaluated from `jsPath` if hot reload is enabled.
+static void start_hot_reload(facebook::hermes::HermesRuntime *hermes,
+                             const char *jsPath, const char *sourceURL) {
+  if (s_hot_reload_watch || s_headless.enabled)
+    return;
+  bool enabled = false;
+  if (const char *env = getenv("IMGUI_HOT_RELOAD")) {
+    enabled = *env && strcmp(env, "0") != 0;
+  } else {
+    auto config = hermes->global().getProperty(*hermes, "sappConfig");
+    if (config.isObject()) {
+      auto value = config.getObject(*hermes).getProperty(*hermes, "hot_reload");
+      enabled = value.isBool() && value.getBool();
+    }
+  }
+  if (!enabled)
+    return;
+  s_hot_reload_path = jsPath;
+  s_hot_reload_url = sourceURL ? sourceURL : jsPath;
+  s_hot_reload_watch = watch_file(s_hot_reload_path, [] {
+    if (!s_hot_reload_posted.exchange(true, std::memory_order_relaxed))
+      post_to_main_thread(hot_reload_bundle);
+  });
+  printf("Hot reload: watching '%s'\n", jsPath);
+}
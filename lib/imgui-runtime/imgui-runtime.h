@@ -5,18 +5,81 @@
 #pragma once
 
 #include "MappedFileBuffer.h"
+#include "Notifier.h"
+#include "RecordRing.h"
 
-struct InternalImage {
-  const char unsigned *data;
-  unsigned size;
-  const char *name;
-};
+#include <string>
+#include <vector>
+
+/// Register an image embedded in the executable: `data` is its encoded file
+/// (any format stb_image decodes), loaded by `name` in place of a path. A
+/// second image of the same name replaces the first. Called during static
+/// initialization, by IMPORT_IMAGE() or the generated <target>-units.cpp
+/// (add_react_imgui_app(IMAGES ...)).
+void imgui_register_image(const char *name, const unsigned char *data,
+                          size_t size);
 
+/// Register the PNG linked in as img_<name>_png[img_<name>_png_size] as the
+/// embedded image `name`.
 #define IMPORT_IMAGE(name)                                                     \
   extern "C" const unsigned char img_##name##_png[];                           \
   extern "C" const unsigned img_##name##_png_size;                             \
-  static InternalImage s_img_##name = {img_##name##_png,                       \
-                                       img_##name##_png_size, #name}
+  static const bool s_img_##name##_registered =                                \
+      (imgui_register_image(#name, img_##name##_png, img_##name##_png_size),   \
+       true)
+
+/// A call of runNative(name, input, params) from JS, handed to the kernel
+/// registered as `name` on one of the runtime's worker threads. The kernel
+/// must not touch the JS runtime. It reports failure by throwing a
+/// std::exception, whose message rejects the promise.
+struct ImguiNativeTask {
+  /// The bytes of `input` (an ArrayBuffer or a view of one): a private copy
+  /// that the kernel may change in place, or, for a shared buffer, the
+  /// memory JS sees. Null without an input.
+  uint8_t *data = nullptr;
+  size_t size = 0;
+  /// The JSON text of `params`, "" if it is undefined.
+  std::string params;
+  /// Set by the kernel: the JSON text of the promise's `result` ("" for
+  /// undefined), and the bytes of its `buffer`. Without an output, `buffer`
+  /// is the input, as the kernel left it.
+  std::string result;
+  std::vector<uint8_t> output;
+
+  /// Whether JS cancelled the task. A long kernel checks now and then and
+  /// returns early; its result is ignored.
+  bool cancelled() const;
+};
+
+/// Register `kernel` as the native task `name`, run by JS with
+/// runNative(name, input, params). A second kernel of the same name
+/// replaces the first. Called during static initialization, usually by
+/// IMGUI_NATIVE_TASK(), or from imgui_main() before the React unit runs.
+void imgui_register_native_task(const char *name,
+                                void (*kernel)(ImguiNativeTask &task));
+
+/// Define and register the native task `name`; the body follows, with the
+/// ImguiNativeTask as `task`:
+///   IMGUI_NATIVE_TASK(sortColumn) { double *v = (double *)task.data; ... }
+#define IMGUI_NATIVE_TASK(name)                                                \
+  static void imgui_native_task_##name(ImguiNativeTask &task);                 \
+  static const bool s_native_task_##name##_registered =                        \
+      (imgui_register_native_task(#name, imgui_native_task_##name), true);     \
+  static void imgui_native_task_##name(ImguiNativeTask &task)
+
+/// The record ring `name` (see RecordRing.h), created with `recordSize`-byte
+/// records and room for `capacity` of them (rounded up to a power of two)
+/// the first time. JS finds it with recordRing(name). Rings live until the
+/// process exits. Safe to call from any thread; throws
+/// std::invalid_argument if the ring exists with another record size.
+RecordRing &imgui_create_record_ring(const char *name, size_t recordSize,
+                                     size_t capacity);
+
+/// The notifier `name` (see Notifier.h), created the first time. A native
+/// thread that finished some work signals it; JS listens with
+/// onNotify(name, fn). Notifiers live until the process exits. Safe to call
+/// from any thread.
+Notifier &imgui_notifier(const char *name);
 
 /// Main function provided by the user. It has to initialize the React and user
 /// code.
@@ -28,15 +91,107 @@ void imgui_load_unit(facebook::hermes::HermesRuntime *hermes,
                      SHUnitCreator nativeUnit, bool bytecode,
                      const char *jsPath, const char *sourceURL);
 
-/// A simple default implementation of imgui_main().
+/// Register a lazy unit: a separately compiled part of the React bundle
+/// (add_react_imgui_app(LAZY_UNITS ...)), evaluated the first time JS asks
+/// for it with lazyUnit(name). `nativeUnit` is set in mode 0; otherwise
+/// `path` is its bytecode (`bytecode`) or source file. Called by the
+/// generated <target>-units.cpp during static initialization.
+void imgui_register_lazy_unit(const char *name, SHUnitCreator nativeUnit,
+                              bool bytecode, const char *path);
+
+/// Register a worker unit (add_react_imgui_app(WORKERS ...)), run by
+/// `new Worker(name)` on a runtime and thread of its own. `nativeUnit` is
+/// set in mode 0; otherwise `path` is its bytecode (`bytecode`) or source
+/// file. Called by the generated <target>-units.cpp during static
+/// initialization.
+void imgui_register_worker_unit(const char *name, SHUnitCreator nativeUnit,
+                                bool bytecode, const char *path);
+
+/// The file of the React bundle (modes 1 and 2), which IMGUI_BUNDLE_MAP=
+/// prefetch starts reading before the runtime is initialized. Called by the
+/// generated <target>-units.cpp during static initialization.
+void imgui_register_bundle_file(const char *path);
+
+/// Bytecode of the React bundle linked into the executable (mode 1 with
+/// REACT_EMBED_BYTECODE), which imgui_load_unit() evaluates in place instead
+/// of loading `jsPath`. Called by the generated <target>-units.cpp during
+/// static initialization.
+void imgui_register_embedded_bundle(const unsigned char *data, size_t size);
+
+/// The React vendor unit (mode 0 with REACT_VENDOR_UNIT): React,
+/// react-reconciler and react-imgui-reconciler, compiled once for all apps.
+/// imgui_load_unit() evaluates it before the app's native unit, which takes
+/// those modules from it. Called by the generated <target>-units.cpp during
+/// static initialization.
+void imgui_register_vendor_unit(SHUnitCreator vendorUnit);
+
+/// The imgui unit evaluated at startup: the shared sh_export_imgui, or with
+/// REACT_IMGUI_SPECIALIZE_RENDERER the app's own, which only renders the
+/// host components it uses. Called by the generated <target>-units.cpp
+/// during static initialization.
+void imgui_register_imgui_unit(SHUnitCreator imguiUnit);
+
+/// The app's CONFIG file (add_react_imgui_app(CONFIG ...)): JSON merged into
+/// globalThis.sappConfig before the React bundle is evaluated. With
+/// `"async_init": true`, the window opens with a splash screen before the
+/// bundle is loaded. Called by the generated <target>-units.cpp during
+/// static initialization.
+void imgui_register_app_config(const char *json);
+
+/// Hermes runtime and GC settings of the app (add_react_imgui_app(
+/// HERMES_CONFIG ...)), comma separated `key=value` pairs such as
+/// "init_heap=64M,max_heap=1G", applied before IMGUI_HERMES_CONFIG when the
+/// runtime is created. Called by the generated <target>-units.cpp during
+/// static initialization.
+void imgui_register_hermes_config(const char *spec);
+
+/// The memory profile of the app (add_react_imgui_app(MEMORY_PROFILE ...)):
+/// "default", or "embedded" for devices with little RAM. A profile sets the
+/// Hermes heap limits, the texture budget, the temp arena limit and the
+/// font atlas size, each overridden by its explicit setting.
+/// IMGUI_MEMORY_PROFILE overrides it at run time. Called by the generated
+/// <target>-units.cpp during static initialization.
+void imgui_register_memory_profile(const char *name);
+
+/// Where add_react_imgui_app(TEXTURES ...) put the compressed variants of
+/// the images under `sourceDir`: the same relative paths under
+/// `variantDir`, as `<stem>.<format>.ktx2`. Loading an image picks the
+/// variant of the best format the backend samples. Called by the generated
+/// <target>-units.cpp during static initialization.
+void imgui_register_texture_variants(const char *sourceDir,
+                                     const char *variantDir);
+
+/// Source map of the React bundle, for symbolicating CPU profiles in the
+/// modes that don't evaluate the bundle together with it (0 and 1).
+/// `bundleURL`, if not null, is the name the bundle was loaded under.
+void imgui_set_profile_source_map(const char *sourceMapPath,
+                                  const char *bundleURL);
+
+/// Version of the React tree, incremented after every React commit that
+/// changed it. Frame loops can compare it against a saved value to detect
+/// frames where nothing changed.
+extern "C" unsigned imgui_tree_version(void);
+
+/// Ends an idle sleep of the main loop (see sappConfig.idle_sleep_ms), so
+/// that the next frame runs right away. Safe to call from any thread, e.g.
+/// after queueing data that the JS side has to pick up.
+extern "C" void imgui_wake_main_loop(void);
+
+/// A simple default implementation of imgui_main(). `sourceMapPath` is the
+/// bundle's source map, used by CPU profiles in modes 0 and 1.
 template <int BUNDLE_MODE>
 void imgui_main_default(facebook::hermes::HermesRuntime *hermes,
-                        SHUnitCreator sh_export_react, const char *bundlePath) {
+                        SHUnitCreator sh_export_react, const char *bundlePath,
+                        const char *sourceMapPath = nullptr) {
   // Load react unit based on compilation mode
   if constexpr (BUNDLE_MODE == 0) {
+    if (sourceMapPath)
+      imgui_set_profile_source_map(sourceMapPath, nullptr);
     imgui_load_unit(hermes, sh_export_react, false, nullptr, nullptr);
   } else if constexpr (BUNDLE_MODE == 1) {
     // Mode 1: Bytecode - load .hbc file via evaluateJavaScript
+    if (sourceMapPath)
+      imgui_set_profile_source_map(sourceMapPath, "react-unit-bundle.hbc");
     imgui_load_unit(hermes, nullptr, true, bundlePath, "react-unit-bundle.hbc");
   } else if constexpr (BUNDLE_MODE == 2) {
     // Mode 2: Source - load .js file with source map
@@ -46,6 +201,10 @@ void imgui_main_default(facebook::hermes::HermesRuntime *hermes,
 
 #ifdef PROVIDE_IMGUI_MAIN
 
+#ifndef REACT_BUNDLE_SOURCE_MAP
+#define REACT_BUNDLE_SOURCE_MAP nullptr
+#endif
+
 #if REACT_BUNDLE_MODE == 0
 extern "C" SHUnit *sh_export_react(void);
 #elif !(REACT_BUNDLE_MODE >= 0 && REACT_BUNDLE_MODE < 4)
@@ -58,7 +217,8 @@ void imgui_main(int argc, char *argv[],
   static constexpr SHUnit *(*sh_export_react)(void) = nullptr;
 #endif
   imgui_main_default<REACT_BUNDLE_MODE>(hermes, sh_export_react,
-                                        REACT_BUNDLE_PATH);
+                                        REACT_BUNDLE_PATH,
+                                        REACT_BUNDLE_SOURCE_MAP);
 }
 
 #endif
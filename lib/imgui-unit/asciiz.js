@@ -9,11 +9,51 @@ const _ptr_read_uchar = $SHBuiltin.extern_c({declared: true}, function _sh_ptr_r
     throw 0;
 });
 
+// Native bulk encoder provided by imgui-runtime. __encodeUtf8(s) encodes the
+// whole string into a staging buffer and returns the byte count; the bytes
+// are then copied out with one memcpy(). The call itself costs more than
+// the JS loop for short strings, so it is only used from
+// NATIVE_ENCODE_MIN_LENGTH characters on.
+const _utf8_staging_buffer = $SHBuiltin.extern_c({}, function utf8_staging_buffer(): c_ptr {
+    throw 0;
+});
+const _nativeEncodeUtf8: any = (globalThis as any).__encodeUtf8;
+const NATIVE_ENCODE_MIN_LENGTH = 64;
+
+// Glyph cache of imgui-runtime (GlyphCache.h). Encoded strings with
+// non-ASCII characters register their codepoints, so that the glyphs the
+// atlas lacks are rasterized: persistent slots retain them for as long as
+// they hold the string, temporary strings touch them for the frame.
+const _glyph_cache_retain = $SHBuiltin.extern_c({}, function glyph_cache_retain(s: c_ptr, len: c_int): c_int { throw 0; });
+const _glyph_cache_release = $SHBuiltin.extern_c({}, function glyph_cache_release(handle: c_int): void {});
+const _glyph_cache_touch = $SHBuiltin.extern_c({}, function glyph_cache_touch(s: c_ptr, len: c_int): void {});
+
+/// Encode `s` with the native encoder into `buf`, NUL-terminated.
+/// Returns the number of bytes written (excluding null terminator).
+function nativeCopyToUtf8(s: any, buf: c_ptr, maxSize: number): number {
+    "use unsafe";
+
+    const n: number = +_nativeEncodeUtf8(s);
+    if (n >= maxSize) throw Error("String too long");
+    _memcpy(buf, _utf8_staging_buffer(), n);
+    _ptr_write_char(buf, n, 0);
+    return n;
+}
+
+// calloc() and malloc() calls and their bytes since the last flushAllocTmp(),
+// and the totals of the last completed frame (see nativeStats*()).
+let _nativeAllocs: number = 0;
+let _nativeAllocBytes: number = 0;
+let _lastNativeAllocs: number = 0;
+let _lastNativeAllocBytes: number = 0;
+
 /// Allocate native memory using calloc() or throw an exception.
 function calloc(size: number): c_ptr {
     "inline";
     "use unsafe";
 
+    _nativeAllocs++;
+    _nativeAllocBytes += size;
     let res = _calloc(1, size);
     if (res === 0) throw Error("OOM");
     return res;
@@ -24,6 +64,8 @@ function malloc(size: number): c_ptr {
     "inline";
     "use unsafe";
 
+    _nativeAllocs++;
+    _nativeAllocBytes += size;
     let res = _malloc(size);
     if (res === 0) throw Error("OOM");
     return res;
@@ -31,6 +73,11 @@ function malloc(size: number): c_ptr {
 
 function copyToAsciiz(s: any, buf: c_ptr, size: number): void {
     if (s.length >= size) throw Error("String too long");
+    if (s.length >= NATIVE_ENCODE_MIN_LENGTH && _nativeEncodeUtf8) {
+        // UTF-8 is one byte per UTF-16 unit only if every char is ASCII
+        if (nativeCopyToUtf8(s, buf, size) !== s.length) throw Error("String is not ASCII");
+        return;
+    }
     let i = 0;
     for (let e = s.length; i < e; ++i) {
         let code: number = s.charCodeAt(i);
@@ -43,6 +90,9 @@ function copyToAsciiz(s: any, buf: c_ptr, size: number): void {
 /// Convert a JS string to UTF-8 encoded null-terminated string.
 /// Returns the number of bytes written (excluding null terminator).
 function copyToUtf8(s: any, buf: c_ptr, maxSize: number): number {
+    if (s.length >= NATIVE_ENCODE_MIN_LENGTH && _nativeEncodeUtf8)
+        return nativeCopyToUtf8(s, buf, maxSize);
+
     let byteIndex = 0;
     for (let i = 0, e = s.length; i < e; ++i) {
         let code: number = s.charCodeAt(i);
@@ -103,7 +153,9 @@ function tmpUtf8(s: any): c_ptr {
     if (typeof s !== "string") s = String(s);
     // UTF-8 can be up to 4 bytes per char, so allocate conservatively
     let buf = allocTmp(s.length * 4 + 1);
-    copyToUtf8(s, buf, s.length * 4 + 1);
+    const n = copyToUtf8(s, buf, s.length * 4 + 1);
+    // More bytes than UTF-16 units only with non-ASCII characters
+    if (n !== s.length) _glyph_cache_touch(buf, n);
     return buf;
 }
 
@@ -118,20 +170,296 @@ function tmpAsciiz(s: any): c_ptr {
 }
 
 
-// Bump pointer allocator for temporary allocations
+// Persistent native buffers.
+// Data that outlives a frame (labels and draw commands of retained tree
+// nodes) is kept in malloc'ed buffers addressed by an integer slot, so the
+// slot can be stored on untyped objects and the buffer reused until it is
+// released.
+let _slotBufs: c_ptr[] = [];
+let _slotCaps: number[] = [];
+// Byte length of the string setUtf8Slot() last encoded into each slot,
+// without the NUL; 0 for slots used as plain buffers.
+let _slotLens: number[] = [];
+// glyph_cache_retain() handle of the codepoints each slot retains, 0 for
+// none. The glyph cache records them, since ImGui edits <inputtext>
+// buffers in place.
+let _slotGlyphs: number[] = [];
+let _freeSlots: number[] = [];
+let _freeSlotCount: number = 0;
+let _slotBytes: number = 0;              // Sum of _slotCaps
+
+/// Make persistent slot `slot`, or a new slot if `slot` is negative, hold at
+/// least `size` bytes. The buffer is only reallocated when it is too small,
+/// in which case its contents are lost. Either way the caller rewrites it,
+/// so the glyphs of the old contents are released. Returns the slot.
+function reserveSlot(slot: number, size: number): number {
+    if (slot < 0) {
+        if (_freeSlotCount > 0) {
+            slot = _freeSlots[--_freeSlotCount];
+        } else {
+            slot = _slotBufs.length;
+            _slotBufs.push(c_null);
+            _slotCaps.push(0);
+            _slotLens.push(0);
+            _slotGlyphs.push(0);
+        }
+    } else if (_slotGlyphs[slot] !== 0) {
+        releaseSlotGlyphs(slot);
+    }
+    _slotLens[slot] = 0;
+    if (_slotCaps[slot] < size) {
+        _free(_slotBufs[slot]);
+        _slotBytes -= _slotCaps[slot];
+        _slotBufs[slot] = c_null;
+        _slotCaps[slot] = 0;
+        _slotBufs[slot] = malloc(size);
+        _slotCaps[slot] = size;
+        _slotBytes += size;
+    }
+    return slot;
+}
+
+/// Return the buffer of a persistent slot.
+function slotPtr(slot: number): c_ptr {
+    "inline";
+    return _slotBufs[slot];
+}
+
+/// Retain the codepoints of bytes `start` to `end` of persistent slot `slot`
+/// with the glyph cache, until the slot is rewritten or freed. Replaces
+/// what the slot retained before, e.g. after an in-place edit.
+function retainSlotGlyphs(slot: number, start: number, end: number): void {
+    "use unsafe";
+
+    const old = _slotGlyphs[slot];
+    _slotGlyphs[slot] = _glyph_cache_retain(_sh_ptr_add(_slotBufs[slot], start), end - start);
+    // After the new retain, so that glyphs in both are never unreferenced
+    if (old !== 0) _glyph_cache_release(old);
+}
+
+/// Undo retainSlotGlyphs() of a slot.
+function releaseSlotGlyphs(slot: number): void {
+    const handle = _slotGlyphs[slot];
+    if (handle === 0) return;
+    _slotGlyphs[slot] = 0;
+    _glyph_cache_release(handle);
+}
+
+/// Free the buffer of a persistent slot and make the slot reusable.
+function freeSlot(slot: number): void {
+    if (_slotGlyphs[slot] !== 0) releaseSlotGlyphs(slot);
+    _free(_slotBufs[slot]);
+    _slotBytes -= _slotCaps[slot];
+    _slotBufs[slot] = c_null;
+    _slotCaps[slot] = 0;
+    if (_freeSlotCount < _freeSlots.length) {
+        _freeSlots[_freeSlotCount] = slot;
+    } else {
+        _freeSlots.push(slot);
+    }
+    ++_freeSlotCount;
+}
+
+/// Encode a JS string into persistent slot `slot`, or into a new slot if
+/// `slot` is negative. Returns the slot holding the string.
+function setUtf8Slot(slot: number, s: any): number {
+    if (typeof s !== "string") s = String(s);
+    // UTF-8 can be up to 4 bytes per char, so allocate conservatively
+    const need = s.length * 4 + 1;
+    slot = reserveSlot(slot, need);
+    const n = copyToUtf8(s, _slotBufs[slot], _slotCaps[slot]);
+    _slotLens[slot] = n;
+    if (n !== s.length) retainSlotGlyphs(slot, 0, n);
+    return slot;
+}
+
+/// Return the NUL-terminated UTF-8 buffer of a persistent slot.
+function utf8SlotPtr(slot: number): c_ptr {
+    "inline";
+    return _slotBufs[slot];
+}
+
+/// Return the end of the string in a persistent slot written by
+/// setUtf8Slot(), for the `text_end` arguments of ImGui, which then don't
+/// scan it with strlen().
+function utf8SlotEnd(slot: number): c_ptr {
+    "inline";
+    "use unsafe";
+    return _sh_ptr_add(_slotBufs[slot], _slotLens[slot]);
+}
+
+/// Capacity in bytes of a persistent slot.
+function slotCapacity(slot: number): number {
+    "inline";
+    return _slotCaps[slot];
+}
+
+/// Replace the buffer of a persistent slot with `buf` of `cap` bytes, after
+/// native code has realloc()'ed it. The old buffer must not be freed.
+function adoptSlotBuffer(slot: number, buf: c_ptr, cap: number): void {
+    _slotBytes += cap - _slotCaps[slot];
+    _slotBufs[slot] = buf;
+    _slotCaps[slot] = cap;
+}
+
+/// Persistent slots in use.
+function slotStatsCount(): number {
+    return _slotBufs.length - _freeSlotCount;
+}
+
+/// Bytes held by the persistent slots.
+function slotStatsBytes(): number {
+    return _slotBytes;
+}
+
+/// Decode `len` bytes of UTF-8 at `buf` into a JS string. Invalid sequences
+/// decode as U+FFFD.
+function utf8ToString(buf: c_ptr, len: number): string {
+    "use unsafe";
+
+    let result = "";
+    let i = 0;
+    while (i < len) {
+        let c = _ptr_read_uchar(buf, i++);
+        if (c < 0x80) {
+            result += String.fromCharCode(c);
+            continue;
+        }
+        let extra = 0;
+        if ((c & 0xE0) === 0xC0) { c &= 0x1F; extra = 1; }
+        else if ((c & 0xF0) === 0xE0) { c &= 0x0F; extra = 2; }
+        else if ((c & 0xF8) === 0xF0) { c &= 0x07; extra = 3; }
+        else { result += "\uFFFD"; continue; }
+        if (i + extra > len) { result += "\uFFFD"; break; }
+        let valid = true;
+        for (let j = 0; j < extra; j++) {
+            const cc = _ptr_read_uchar(buf, i + j);
+            if ((cc & 0xC0) !== 0x80) { valid = false; break; }
+            c = (c << 6) | (cc & 0x3F);
+        }
+        if (!valid) { result += "\uFFFD"; continue; }
+        i += extra;
+        result += String.fromCodePoint(c);
+    }
+    return result;
+}
+
+// Shared native buffers, allocated by imgui-runtime and exposed to the React
+// unit as typed arrays (lib/react-imgui-reconciler/shared-buffer.js). Such an
+// array carries a `nativeHandle` that shared_buffer_data() turns back into a
+// pointer to the same memory.
+const _shared_buffer_data = $SHBuiltin.extern_c({}, function shared_buffer_data(handle: c_int): c_ptr {
+    throw 0;
+});
+const _shared_buffer_size = $SHBuiltin.extern_c({}, function shared_buffer_size(handle: c_int): c_size_t {
+    throw 0;
+});
+
+/// Whether `array` is a typed array backed by a live shared native buffer.
+function isSharedArray(array: any): boolean {
+    if (!array || typeof array.nativeHandle !== "number") return false;
+    // The size is 0 for invalid handles and collected buffers
+    const size = _shared_buffer_size(+array.nativeHandle);
+    return size !== 0 && +array.byteOffset + +array.byteLength <= size;
+}
+
+/// Return a pointer to the first element of a shared typed array, or c_null
+/// if isSharedArray(array) is false. The pointer is valid as long as the
+/// array is reachable from JS (e.g. through node props).
+function sharedArrayPtr(array: any): c_ptr {
+    if (!isSharedArray(array)) return c_null;
+    // Views may start inside the buffer
+    return _sh_ptr_add(_shared_buffer_data(+array.nativeHandle), +array.byteOffset);
+}
+
+// Native metrics block of imgui-runtime (RuntimeMetrics.h), read by the
+// runtime every frame. Fields are doubles; the offsets are in bytes.
+const _imgui_runtime_metrics = $SHBuiltin.extern_c({}, function imgui_runtime_metrics(): c_ptr {
+    throw 0;
+});
+const METRIC_RENDER_TIME = 0;
+const METRIC_TMP_BYTES = 40;
+const METRIC_TMP_PEAK_BYTES = 48;
+const METRIC_TMP_BLOCKS = 56;
+const METRIC_TRACE_CAPTURING = 96;
+const METRIC_TMP_ALLOCS = 224;
+const METRIC_NATIVE_ALLOCS = 232;
+const METRIC_NATIVE_ALLOC_BYTES = 240;
+const _runtimeMetrics: c_ptr = _imgui_runtime_metrics();
+
+/// Store `value` in the metrics field at byte offset `offset`.
+function setRuntimeMetric(offset: number, value: number): void {
+    _sh_ptr_write_c_double(_runtimeMetrics, offset, value);
+}
+
+/// The metrics field at byte offset `offset`.
+function runtimeMetric(offset: number): number {
+    return +_sh_ptr_read_c_double(_runtimeMetrics, offset);
+}
+
+// Trace markers of imgui-runtime (Trace.h). They only cost a flag check
+// while no trace capture runs. The IDs are builtin TraceName values.
+const _imgui_trace_begin = $SHBuiltin.extern_c({}, function imgui_trace_begin(name: c_int): void {
+    throw 0;
+});
+const _imgui_trace_end = $SHBuiltin.extern_c({}, function imgui_trace_end(): void {
+    throw 0;
+});
+const TRACE_RENDER_TREE = 6;
+
+// Memory is NOT zero-filled. One primary block is retained across frames and
+// flushAllocTmp() only resets its offset. Allocations that don't fit spill
+// into overflow blocks; at the next flush those are freed and the primary
+// block is regrown to the frame's peak usage, so a steady workload ends up
+// with a single block and no malloc/free per frame. The primary block is
+// shrunk only after SHRINK_AFTER_FRAMES consecutive frames of low usage.
+//
+// tmpMark()/tmpRelease() return memory early within a frame: everything
+// allocated after a mark is released with it (marks are strictly LIFO).
 const INITIAL_BLOCK_SIZE = 4096;
 const MAX_BLOCK_SIZE = 65536;
 const ALIGNMENT = 8;
+const SHRINK_AFTER_FRAMES = 120;
 
-let _blocks: c_ptr[] = [];
+let _blocks: c_ptr[] = [];               // Overflow blocks, freed at flush
+let _blockSizes: number[] = [];
+let _primaryBlock: c_ptr = c_null;
+let _primarySize: number = 0;
 let _currentBlock: c_ptr = c_null;
 let _currentOffset: number = 0;
 let _currentSize: number = 0;
 let _nextBlockSize: number = INITIAL_BLOCK_SIZE;
+let _overflowed: boolean = false;        // An overflow block was needed this frame
+let _liveLimit: number = 0;              // Most bytes live at once, 0 for no limit
+
+// Mark stack: overflow block count, offset and live bytes at each mark
+let _markBlocks: number[] = [];
+let _markOffsets: number[] = [];
+let _markLive: number[] = [];
+let _markDepth: number = 0;
+
+// Per-frame statistics
+let _frameBytes: number = 0;             // Bytes allocated since the last flush
+let _frameAllocs: number = 0;            // allocTmp() calls since the last flush
+let _liveBytes: number = 0;              // Bytes currently allocated
+let _peakBytes: number = 0;              // Peak of _liveBytes since the last flush
+let _peakBlocks: number = 0;             // Peak number of blocks in use
+let _lowUsageFrames: number = 0;
+
+// Statistics of the last completed frame, see tmpStats*()
+let _lastFrameBytes: number = 0;
+let _lastPeakBytes: number = 0;
+let _lastBlocks: number = 0;
+let _lastAllocs: number = 0;
 
 function allocTmp(size: number): c_ptr {
     // Round up to alignment boundary
     size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    _frameAllocs++;
+    _frameBytes += size;
+    _liveBytes += size;
+    if (_liveBytes > _peakBytes)
+        _peakBytes = _liveBytes;
 
     // Check if allocation fits in current block
     if (_currentOffset + size <= _currentSize) {
@@ -140,17 +468,26 @@ function allocTmp(size: number): c_ptr {
         return ptr;
     }
 
-    // Need a new block
+    // Need an overflow block, unless that takes the arena past its limit
+    if (_liveLimit > 0 && _liveBytes > _liveLimit) {
+        _liveBytes -= size;
+        throw new Error(
+            "allocTmp: temp arena limit of " + _liveLimit + " bytes exceeded");
+    }
     let blockSize = _nextBlockSize;
     // Large allocation - allocate exact size but don't grow block size
     if (size > blockSize)
         blockSize = size;
 
-    let newBlock = calloc(blockSize);
+    let newBlock = malloc(blockSize);
     _blocks.push(newBlock);
+    _blockSizes.push(blockSize);
     _currentBlock = newBlock;
     _currentSize = blockSize;
     _currentOffset = size;
+    _overflowed = true;
+    if (_blocks.length + 1 > _peakBlocks)
+        _peakBlocks = _blocks.length + 1;
 
     // Grow next block size
     if (_nextBlockSize < MAX_BLOCK_SIZE)
@@ -159,17 +496,141 @@ function allocTmp(size: number): c_ptr {
     return newBlock;
 }
 
+/// Limit the bytes live in the temp arena at once (0: no limit). An
+/// allocation past it throws instead of adding a block, so a runaway frame
+/// fails its window rather than growing the arena.
+function setTmpArenaLimit(bytes: number): void {
+    _liveLimit = bytes;
+}
+
+/// Record the current arena position. Returns a mark for tmpRelease().
+function tmpMark(): number {
+    if (_markDepth < _markBlocks.length) {
+        _markBlocks[_markDepth] = _blocks.length;
+        _markOffsets[_markDepth] = _currentOffset;
+        _markLive[_markDepth] = _liveBytes;
+    } else {
+        _markBlocks.push(_blocks.length);
+        _markOffsets.push(_currentOffset);
+        _markLive.push(_liveBytes);
+    }
+    return _markDepth++;
+}
+
+/// Release everything allocated since `mark` (and any marks taken after it).
+function tmpRelease(mark: number): void {
+    if (mark < 0 || mark >= _markDepth) return;
+
+    // Free overflow blocks created after the mark
+    const blockCount = _markBlocks[mark];
+    while (_blocks.length > blockCount) {
+        _free(_blocks[_blocks.length - 1]);
+        _blocks.pop();
+        _blockSizes.pop();
+    }
+
+    if (blockCount === 0) {
+        _currentBlock = _primaryBlock;
+        _currentSize = _primarySize;
+    } else {
+        _currentBlock = _blocks[blockCount - 1];
+        _currentSize = _blockSizes[blockCount - 1];
+    }
+    _currentOffset = _markOffsets[mark];
+    _liveBytes = _markLive[mark];
+    _markDepth = mark;
+}
+
+/// Replace the primary block with one of `size` bytes.
+function resizePrimaryBlock(size: number): void {
+    _free(_primaryBlock);
+    _primaryBlock = c_null;
+    _primarySize = 0;
+    _primaryBlock = malloc(size);
+    _primarySize = size;
+}
+
 function flushAllocTmp(): void {
-    // Free all blocks
+    const peak = _peakBytes;
+
+    _lastFrameBytes = _frameBytes;
+    _lastPeakBytes = peak;
+    _lastBlocks = _peakBlocks;
+    _lastAllocs = _frameAllocs;
+    // A primary block resize below counts towards the next frame.
+    _lastNativeAllocs = _nativeAllocs;
+    _lastNativeAllocBytes = _nativeAllocBytes;
+    _nativeAllocs = 0;
+    _nativeAllocBytes = 0;
+
+    // Free remaining overflow blocks
     for (let i = 0; i < _blocks.length; ++i) {
         _free(_blocks[i]);
     }
-
-    // Reset all state
     let empty: c_ptr[] = [];
     _blocks = empty;
-    _currentBlock = c_null;
+    let emptySizes: number[] = [];
+    _blockSizes = emptySizes;
+
+    if (_overflowed) {
+        // Grow the primary block so that the next frame of the same size
+        // fits in it.
+        let newSize = _primarySize > 0 ? _primarySize : INITIAL_BLOCK_SIZE;
+        while (newSize < peak)
+            newSize = newSize * 2;
+        resizePrimaryBlock(newSize);
+        _lowUsageFrames = 0;
+    } else if (_primarySize > INITIAL_BLOCK_SIZE && peak * 4 < _primarySize) {
+        // Shrink only after sustained low usage
+        if (++_lowUsageFrames >= SHRINK_AFTER_FRAMES) {
+            resizePrimaryBlock(_primarySize / 2);
+            _lowUsageFrames = 0;
+        }
+    } else {
+        _lowUsageFrames = 0;
+    }
+
+    // Reset to the start of the primary block
+    _currentBlock = _primaryBlock;
     _currentOffset = 0;
-    _currentSize = 0;
+    _currentSize = _primarySize;
     _nextBlockSize = INITIAL_BLOCK_SIZE;
+    _overflowed = false;
+    _markDepth = 0;
+    _frameBytes = 0;
+    _frameAllocs = 0;
+    _liveBytes = 0;
+    _peakBytes = 0;
+    _peakBlocks = _primarySize > 0 ? 1 : 0;
+}
+
+/// Bytes allocated with allocTmp() during the last completed frame.
+function tmpStatsFrameBytes(): number {
+    return _lastFrameBytes;
+}
+
+/// Peak live arena bytes during the last completed frame.
+function tmpStatsPeakBytes(): number {
+    return _lastPeakBytes;
+}
+
+/// Peak number of arena blocks in use during the last completed frame.
+function tmpStatsBlocks(): number {
+    return _lastBlocks;
+}
+
+/// allocTmp() calls during the last completed frame.
+function tmpStatsAllocs(): number {
+    return _lastAllocs;
+}
+
+/// calloc() and malloc() calls during the last completed frame, including
+/// the arena's own blocks.
+function nativeStatsAllocs(): number {
+    return _lastNativeAllocs;
+}
+
+/// Bytes requested by those calls.
+function nativeStatsAllocBytes(): number {
+    return _lastNativeAllocBytes;
 }
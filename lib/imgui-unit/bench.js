@@ -0,0 +1,117 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// FFI micro-benchmarks, run by examples/bench-ffi through
+// globalThis.imguiUnit.runFfiBench(). They measure the per-call cost of the
+// typed unit's native calls from inside a real frame, so the numbers include
+// everything a render function pays. Must be called while an ImGui frame is
+// active (e.g. from a macrotask), since it emits text.
+
+const BENCH_TEXT = "Hello";
+const BENCH_UTF8_LENGTHS = [8, 64, 256, 1024];
+
+/// Nanoseconds per iteration, given a duration in milliseconds.
+function nsPerIteration(ms: number, iterations: number): number {
+  return ms * 1e6 / iterations;
+}
+
+/// Empty FFI call: igGetCurrentContext() only loads a global pointer.
+function benchEmptyCall(iterations: number): number {
+  const start = globalThis.performance.now();
+  for (let i = 0; i < iterations; ++i) {
+    _igGetCurrentContext();
+  }
+  return nsPerIteration(globalThis.performance.now() - start, iterations);
+}
+
+/// Lines of text that fit in the current window below the cursor. The
+/// visible text benchmarks move the cursor back up after this many, so
+/// every line is laid out and drawn instead of being clipped.
+function visibleTextRows(): number {
+  const free = +_igGetWindowHeight() - +_igGetCursorPosY();
+  const rows = Math.floor(free / +_igGetTextLineHeightWithSpacing()) - 1;
+  return rows > 0 ? rows : 1;
+}
+
+/// igText() with a short, already encoded string. With `visible` false the
+/// lines run off the bottom of the window, so most of them only pay for
+/// the clipping test.
+function benchTextShort(iterations: number, visible: boolean): number {
+  const slot = setUtf8Slot(-1, BENCH_TEXT);
+  const label = utf8SlotPtr(slot);
+
+  _igBegin(label, c_null, 0);
+  const top = +_igGetCursorPosY();
+  const rows = visible ? visibleTextRows() : iterations;
+  const start = globalThis.performance.now();
+  for (let done = 0; done < iterations; done += rows) {
+    _igSetCursorPosY(top);
+    const n = Math.min(rows, iterations - done);
+    for (let i = 0; i < n; ++i) {
+      _igText(label);
+    }
+  }
+  const ms = globalThis.performance.now() - start;
+  _igEnd();
+
+  freeSlot(slot);
+  return nsPerIteration(ms, iterations);
+}
+
+/// textSlot(), the renderer's path for text: igTextUnformatted() with the
+/// end of the same string, which skips the format parsing and strlen().
+/// `visible` as for benchTextShort().
+function benchTextSlotShort(iterations: number, visible: boolean): number {
+  const slot = setUtf8Slot(-1, BENCH_TEXT);
+
+  _igBegin(utf8SlotPtr(slot), c_null, 0);
+  const top = +_igGetCursorPosY();
+  const rows = visible ? visibleTextRows() : iterations;
+  const start = globalThis.performance.now();
+  for (let done = 0; done < iterations; done += rows) {
+    _igSetCursorPosY(top);
+    const n = Math.min(rows, iterations - done);
+    for (let i = 0; i < n; ++i) {
+      textSlot(slot);
+    }
+  }
+  const ms = globalThis.performance.now() - start;
+  _igEnd();
+
+  freeSlot(slot);
+  return nsPerIteration(ms, iterations);
+}
+
+/// tmpUtf8() of an ASCII string of `length` characters.
+function benchTmpUtf8(iterations: number, length: number): number {
+  const s = "x".repeat(length);
+  const start = globalThis.performance.now();
+  for (let i = 0; i < iterations; ++i) {
+    const mark = tmpMark();
+    tmpUtf8(s);
+    tmpRelease(mark);
+  }
+  return nsPerIteration(globalThis.performance.now() - start, iterations);
+}
+
+/// Runs all FFI benchmarks and returns their results in ns per call.
+function runFfiBench(iterations: number): any {
+  const results: any = {
+    iterations: iterations,
+    emptyFfiCall: benchEmptyCall(iterations),
+    igTextShort: benchTextShort(iterations, true),
+    igTextShortClipped: benchTextShort(iterations, false),
+    textSlotShort: benchTextSlotShort(iterations, true),
+    textSlotShortClipped: benchTextSlotShort(iterations, false),
+  };
+  const utf8: any = {};
+  for (let i = 0; i < BENCH_UTF8_LENGTHS.length; ++i) {
+    const length = BENCH_UTF8_LENGTHS[i];
+    utf8[String(length)] = benchTmpUtf8(iterations, length);
+  }
+  results.tmpUtf8 = utf8;
+  return results;
+}
+
+globalThis.imguiUnit.runFfiBench = runFfiBench;
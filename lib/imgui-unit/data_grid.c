@@ -0,0 +1,256 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// Native cells for <datagrid>.
+// The renderer describes each column with a DataGridColumn (values, per-row
+// color indices, format) over typed arrays, shared ones read in place, and
+// data_grid_render() draws the visible rows of the table straight from
+// them: a cell is formatted into a stack buffer and drawn with
+// igTextUnformatted(), without any JS string or tree node per cell.
+//
+// Numeric columns may flash: every frame, each row is compared with the
+// value seen the frame before, and a cell that rose or fell gets a
+// background that fades out over the flash duration. The previous values
+// live in a DataGridFlash buffer owned by the node, so a change costs no
+// JS at all, whether it is a write into a shared array or a commit.
+
+#define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
+#include "cimgui.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// The string tables of string_table.c: headers and string columns.
+typedef struct StringTable {
+  int32_t count;
+  int32_t offsets[];
+} StringTable;
+
+enum {
+  DATA_GRID_F64 = 0,
+  DATA_GRID_F32 = 1,
+  DATA_GRID_I32 = 2,
+  DATA_GRID_STRING = 3,
+};
+
+enum {
+  DATA_GRID_ALIGN_RIGHT = 1,
+};
+
+// imgui-runtime.cpp: keep frames coming while a flash fades.
+void imgui_keep_rendering(void);
+
+typedef struct DataGridFlashCell {
+  double prev;
+  // igGetTime() of the last change
+  double changed;
+  // 1 if it rose, -1 if it fell, 0 once the flash has faded
+  int32_t dir;
+  int32_t reserved;
+} DataGridFlashCell;
+
+// Flash state of a column, kept by the renderer across plan rebuilds, which
+// writes `rows` = 0 into a new buffer.
+typedef struct DataGridFlash {
+  // Rows whose previous value is known; the others take the first one seen
+  int32_t rows;
+  int32_t reserved;
+  DataGridFlashCell cells[];
+} DataGridFlash;
+
+// Written field by field by the renderer (buildDataGridPlan()): 56 bytes.
+typedef struct DataGridColumn {
+  // F64/F32/I32: one element per row. String: a StringTable.
+  const void *values;
+  // One palette index per row, 0 for the default text color; may be NULL.
+  const uint8_t *colors;
+  int32_t type;
+  // Numbers: digits after the decimal point, or < 0 for the shortest form.
+  int32_t decimals;
+  // Fixed width in pixels, or 0 to share the remaining width.
+  float width;
+  int32_t flags;
+  // Numeric columns: the flash state, or NULL if the column doesn't flash.
+  DataGridFlash *flash;
+  // ImU32 cell backgrounds of a rise and a fall, faded out over
+  // flash_seconds.
+  uint32_t flash_up;
+  uint32_t flash_down;
+  float flash_seconds;
+  int32_t reserved;
+} DataGridColumn;
+
+static double data_grid_number(const DataGridColumn *column, int row) {
+  switch (column->type) {
+  case DATA_GRID_I32:
+    return ((const int32_t *)column->values)[row];
+  case DATA_GRID_F32:
+    return ((const float *)column->values)[row];
+  default:
+    return ((const double *)column->values)[row];
+  }
+}
+
+// Compares the `rows` values of a flashing column with those of the last
+// frame, starting a flash on each change. Returns whether a flash is still
+// fading.
+static bool data_grid_track(const DataGridColumn *column, int rows,
+                            double now) {
+  DataGridFlash *flash = column->flash;
+  bool fading = false;
+  for (int row = 0; row < rows; ++row) {
+    DataGridFlashCell *cell = &flash->cells[row];
+    double v = data_grid_number(column, row);
+    if (row >= flash->rows) {
+      cell->prev = v;
+      cell->dir = 0;
+      continue;
+    }
+    // A value becoming or leaving NaN (an empty cell) doesn't flash
+    if (v != cell->prev && !isnan(v) && !isnan(cell->prev)) {
+      cell->dir = v > cell->prev ? 1 : -1;
+      cell->changed = now;
+    }
+    cell->prev = v;
+    if (cell->dir != 0) {
+      if (now - cell->changed < column->flash_seconds)
+        fading = true;
+      else
+        cell->dir = 0;
+    }
+  }
+  flash->rows = rows;
+  return fading;
+}
+
+// Sets the background of the current cell if its flash is still fading.
+static void data_grid_flash_cell(const DataGridColumn *column, int row,
+                                 double now) {
+  const DataGridFlashCell *cell = &column->flash->cells[row];
+  if (cell->dir == 0)
+    return;
+  double k = 1.0 - (now - cell->changed) / column->flash_seconds;
+  if (!(k > 0))
+    return;
+  uint32_t color = cell->dir > 0 ? column->flash_up : column->flash_down;
+  uint32_t alpha = (uint32_t)((color >> 24) * k);
+  igTableSetBgColor(ImGuiTableBgTarget_CellBg,
+                    (color & 0x00FFFFFF) | (alpha << 24), -1);
+}
+
+// Formats the cell of `column` at `row` into `buf`, returning its end.
+static const char *data_grid_cell(const DataGridColumn *column, int row,
+                                  char *buf, size_t size, const char **start) {
+  double v;
+  switch (column->type) {
+  case DATA_GRID_STRING: {
+    const StringTable *table = (const StringTable *)column->values;
+    if (row >= table->count) {
+      *start = buf;
+      return buf;
+    }
+    *start = (const char *)table + table->offsets[row];
+    return NULL;
+  }
+  case DATA_GRID_I32:
+    *start = buf;
+    return buf + snprintf(buf, size, "%d",
+                          (int)((const int32_t *)column->values)[row]);
+  case DATA_GRID_F32:
+    v = ((const float *)column->values)[row];
+    break;
+  default:
+    v = ((const double *)column->values)[row];
+    break;
+  }
+  *start = buf;
+  // Missing values are empty cells
+  if (isnan(v))
+    return buf;
+  int n = column->decimals >= 0
+              ? snprintf(buf, size, "%.*f", (int)column->decimals, v)
+              : snprintf(buf, size, "%g", v);
+  return buf + (n < (int)size ? n : (int)size - 1);
+}
+
+// Draws the table `id` of `column_count` columns and `rows` rows, clipped
+// to the visible ones. `palette` maps the color indices to ImU32 colors.
+// Returns the row clicked this frame, or -1.
+int data_grid_render(const char *id, const StringTable *headers,
+                     const DataGridColumn *columns, int column_count,
+                     int rows, const uint32_t *palette, int palette_count,
+                     int flags, float width, float height) {
+  if (column_count <= 0)
+    return -1;
+
+  // Off-screen rows are tracked too, so that scrolling doesn't show stale
+  // flashes or miss them
+  double now = igGetTime();
+  bool fading = false;
+  for (int c = 0; c < column_count; ++c) {
+    if (columns[c].flash && columns[c].values)
+      fading |= data_grid_track(&columns[c], rows, now);
+  }
+  if (fading)
+    imgui_keep_rendering();
+
+  if (!igBeginTable(id, column_count, flags, (ImVec2){width, height}, 0))
+    return -1;
+
+  igTableSetupScrollFreeze(0, 1);
+  for (int c = 0; c < column_count; ++c) {
+    const char *label = c < headers->count
+                            ? (const char *)headers + headers->offsets[c]
+                            : "";
+    ImGuiTableColumnFlags flags = columns[c].width > 0
+                                      ? ImGuiTableColumnFlags_WidthFixed
+                                      : ImGuiTableColumnFlags_WidthStretch;
+    igTableSetupColumn(label, flags, columns[c].width, 0);
+  }
+  igTableHeadersRow();
+
+  char buf[64];
+  ImGuiListClipper *clipper = ImGuiListClipper_ImGuiListClipper();
+  ImGuiListClipper_Begin(clipper, rows, -1.0f);
+  while (ImGuiListClipper_Step(clipper)) {
+    for (int row = clipper->DisplayStart; row < clipper->DisplayEnd; ++row) {
+      igTableNextRow(0, 0);
+      for (int c = 0; c < column_count; ++c) {
+        const DataGridColumn *column = &columns[c];
+        igTableNextColumn();
+        if (!column->values)
+          continue;
+        if (column->flash)
+          data_grid_flash_cell(column, row, now);
+        const char *start;
+        const char *end = data_grid_cell(column, row, buf, sizeof buf, &start);
+        if (column->flags & DATA_GRID_ALIGN_RIGHT) {
+          ImVec2 size, avail;
+          igCalcTextSize(&size, start, end, false, -1.0f);
+          igGetContentRegionAvail(&avail);
+          if (avail.x > size.x)
+            igSetCursorPosX(igGetCursorPosX() + avail.x - size.x);
+        }
+        int color = column->colors ? column->colors[row] : 0;
+        if (color > 0 && color < palette_count) {
+          igPushStyleColor_U32(ImGuiCol_Text, palette[color]);
+          igTextUnformatted(start, end);
+          igPopStyleColor(1);
+        } else {
+          igTextUnformatted(start, end);
+        }
+      }
+    }
+  }
+  ImGuiListClipper_destroy(clipper);
+
+  // Row 0 is the header
+  int clicked = -1;
+  int hovered = igTableGetHoveredRow();
+  if (hovered > 0 && hovered <= rows && igIsMouseClicked_Bool(0, false))
+    clicked = hovered - 1;
+  igEndTable();
+  return clicked;
+}
@@ -0,0 +1,195 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// Replay of packed draw commands into an ImDrawList.
+// Used by <canvas>: the renderer encodes the command array into a native
+// buffer once per commit, and each frame replays it with a single call
+// instead of several FFI round-trips per shape.
+//
+// <canvas cache> goes further: the vertices and indices emitted by one replay
+// are kept in a cache buffer, and later frames copy them into the draw list,
+// translated to the current origin, without tessellating again.
+
+#define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
+#include "cimgui.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Must match DRAW_OP_* in renderer.js and DrawOp in
+// react-imgui-reconciler/draw-commands.js.
+//
+// RECT:   a,b = min  c,d = max  e = thickness (0 = filled)  f = rounding
+// CIRCLE: a,b = center  c = radius  d = segments  e = thickness (0 = filled)
+// LINE:   a,b = p1  c,d = p2  e = thickness
+enum {
+  DRAW_OP_RECT = 1,
+  DRAW_OP_CIRCLE = 2,
+  DRAW_OP_LINE = 3,
+};
+
+// One 32-byte record. Coordinates are relative to the canvas origin.
+typedef struct DrawCommand {
+  uint32_t op;
+  uint32_t color; // ABGR (ImU32)
+  float a, b, c, d, e, f;
+} DrawCommand;
+
+void draw_commands_replay(ImDrawList *dl, const DrawCommand *cmds, int count,
+                          float ox, float oy) {
+  for (int i = 0; i < count; ++i) {
+    const DrawCommand *cmd = &cmds[i];
+    switch (cmd->op) {
+    case DRAW_OP_RECT: {
+      ImVec2 pmin = {ox + cmd->a, oy + cmd->b};
+      ImVec2 pmax = {ox + cmd->c, oy + cmd->d};
+      if (cmd->e <= 0)
+        ImDrawList_AddRectFilled(dl, pmin, pmax, cmd->color, cmd->f, 0);
+      else
+        ImDrawList_AddRect(dl, pmin, pmax, cmd->color, cmd->f, 0, cmd->e);
+      break;
+    }
+    case DRAW_OP_CIRCLE: {
+      ImVec2 center = {ox + cmd->a, oy + cmd->b};
+      if (cmd->e <= 0)
+        ImDrawList_AddCircleFilled(dl, center, cmd->c, cmd->color, (int)cmd->d);
+      else
+        ImDrawList_AddCircle(dl, center, cmd->c, cmd->color, (int)cmd->d,
+                             cmd->e);
+      break;
+    }
+    case DRAW_OP_LINE: {
+      ImVec2 p1 = {ox + cmd->a, oy + cmd->b};
+      ImVec2 p2 = {ox + cmd->c, oy + cmd->d};
+      ImDrawList_AddLine(dl, p1, p2, cmd->color, cmd->e);
+      break;
+    }
+    default:
+      // Unknown op - skip the record
+      break;
+    }
+  }
+}
+
+// Header of a cache buffer, followed by vtx_count ImDrawVert and idx_count
+// ImDrawIdx. The buffer comes from malloc() in asciiz.js and is grown with
+// realloc(); the renderer clears `valid` whenever the commands change.
+typedef struct DrawCache {
+  int valid;
+  int vtx_count;
+  int idx_count;
+  int flags;       // ImDrawList flags (anti-aliasing) at capture
+  float ox, oy;    // origin at capture
+  ImVec2 white;    // font atlas white pixel at capture
+  float fringe;    // fringe scale at capture
+  int reserved;
+} DrawCache;
+
+typedef struct DrawCacheState {
+  DrawCache *buf;
+  int cap;
+} DrawCacheState;
+
+// Cache buffer of the last draw_commands_replay_cached() call.
+static DrawCacheState s_cache;
+
+// Whether a capture made into `dl` can be emitted into it again.
+static bool cache_matches(const DrawCache *cache, const ImDrawList *dl) {
+  return cache->valid && cache->flags == dl->Flags &&
+         cache->white.x == dl->_Data->TexUvWhitePixel.x &&
+         cache->white.y == dl->_Data->TexUvWhitePixel.y &&
+         cache->fringe == dl->_FringeScale;
+}
+
+// Copy what draw_commands_replay() emitted since the draw list had `vtx0`
+// vertices and `idx0` indices into the cache, with indices relative to the
+// first vertex.
+static void cache_capture(ImDrawList *dl, int vtx0, int idx0,
+                          unsigned int base, float ox, float oy) {
+  int vtx_count = dl->VtxBuffer.Size - vtx0;
+  int idx_count = dl->IdxBuffer.Size - idx0;
+  int need = (int)sizeof(DrawCache) + vtx_count * (int)sizeof(ImDrawVert) +
+             idx_count * (int)sizeof(ImDrawIdx);
+  if (need > s_cache.cap) {
+    int cap = s_cache.cap > 0 ? s_cache.cap : 256;
+    while (cap < need)
+      cap *= 2;
+    DrawCache *buf = (DrawCache *)realloc(s_cache.buf, cap);
+    if (!buf)
+      return;
+    s_cache.buf = buf;
+    s_cache.cap = cap;
+  }
+  DrawCache *cache = s_cache.buf;
+  ImDrawVert *vtx = (ImDrawVert *)(cache + 1);
+  ImDrawIdx *idx = (ImDrawIdx *)(vtx + vtx_count);
+  memcpy(vtx, dl->VtxBuffer.Data + vtx0, vtx_count * sizeof(ImDrawVert));
+  for (int i = 0; i < idx_count; ++i)
+    idx[i] = (ImDrawIdx)(dl->IdxBuffer.Data[idx0 + i] - base);
+  cache->valid = 1;
+  cache->vtx_count = vtx_count;
+  cache->idx_count = idx_count;
+  cache->flags = dl->Flags;
+  cache->ox = ox;
+  cache->oy = oy;
+  cache->white = dl->_Data->TexUvWhitePixel;
+  cache->fringe = dl->_FringeScale;
+}
+
+// Emit the cached geometry into `dl`, translated to origin (ox, oy).
+static void cache_emit(ImDrawList *dl, const DrawCache *cache, float ox,
+                       float oy) {
+  const ImDrawVert *vtx = (const ImDrawVert *)(cache + 1);
+  const ImDrawIdx *idx = (const ImDrawIdx *)(vtx + cache->vtx_count);
+  float dx = ox - cache->ox;
+  float dy = oy - cache->oy;
+  // May start a new command with a vertex offset, so read the base after it
+  ImDrawList_PrimReserve(dl, cache->idx_count, cache->vtx_count);
+  unsigned int base = dl->_VtxCurrentIdx;
+  ImDrawVert *vw = dl->_VtxWritePtr;
+  for (int i = 0; i < cache->vtx_count; ++i) {
+    vw[i] = vtx[i];
+    vw[i].pos.x += dx;
+    vw[i].pos.y += dy;
+  }
+  ImDrawIdx *iw = dl->_IdxWritePtr;
+  for (int i = 0; i < cache->idx_count; ++i)
+    iw[i] = (ImDrawIdx)(idx[i] + base);
+  dl->_VtxWritePtr += cache->vtx_count;
+  dl->_IdxWritePtr += cache->idx_count;
+  dl->_VtxCurrentIdx += cache->vtx_count;
+}
+
+// Like draw_commands_replay(), but through the cache buffer `cache` of `cap`
+// bytes (at least sizeof(DrawCache)): a valid capture is emitted again, and
+// otherwise the commands are replayed and captured. A replay that had to
+// start a new draw command or vertex offset is not captured. The
+// (possibly reallocated) buffer and its capacity are returned through
+// draw_cache_buffer()/draw_cache_capacity().
+void draw_commands_replay_cached(ImDrawList *dl, const DrawCommand *cmds,
+                                 int count, float ox, float oy, void *cache,
+                                 int cap) {
+  s_cache.buf = (DrawCache *)cache;
+  s_cache.cap = cap;
+  if (cache_matches(s_cache.buf, dl)) {
+    cache_emit(dl, s_cache.buf, ox, oy);
+    return;
+  }
+  s_cache.buf->valid = 0;
+  int cmd0 = dl->CmdBuffer.Size;
+  int vtx0 = dl->VtxBuffer.Size;
+  int idx0 = dl->IdxBuffer.Size;
+  unsigned int base = dl->_VtxCurrentIdx;
+  draw_commands_replay(dl, cmds, count, ox, oy);
+  if (dl->CmdBuffer.Size == cmd0 &&
+      dl->_VtxCurrentIdx == base + (unsigned int)(dl->VtxBuffer.Size - vtx0))
+    cache_capture(dl, vtx0, idx0, base, ox, oy);
+}
+
+// Cache buffer after the last draw_commands_replay_cached() call (may have
+// been reallocated).
+void *draw_cache_buffer(void) { return s_cache.buf; }
+
+// Capacity of draw_cache_buffer() in bytes.
+int draw_cache_capacity(void) { return s_cache.cap; }
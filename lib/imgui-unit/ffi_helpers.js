@@ -42,6 +42,9 @@ const _calloc = $SHBuiltin.extern_c({include: "stdlib.h"}, function calloc(count
 });
 const _free = $SHBuiltin.extern_c({include: "stdlib.h"}, function free(p: c_ptr): void {
 });
+const _memcpy = $SHBuiltin.extern_c({include: "string.h"}, function memcpy(dst: c_ptr, src: c_ptr, n: c_size_t): c_ptr {
+    throw 0;
+});
 
 const c_null = $SHBuiltin.c_null();
 
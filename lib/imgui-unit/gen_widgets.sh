@@ -0,0 +1,8 @@
+#!/bin/bash
+
+../../tools/widgetgen.py \
+    --schema widgets.json \
+    --node-tags ../react-imgui-reconciler/node-tags.js \
+    --renderer widgets.js \
+    --props ../react-imgui-reconciler/widget-props.js \
+    --typings ../react-imgui-reconciler/widgets.d.ts
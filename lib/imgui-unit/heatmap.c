@@ -0,0 +1,48 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// Value grids to pixels for <heatmap>.
+// The renderer turns the `palette` prop into a 256-entry lookup table of
+// ABGR colors once per commit; heatmap_fill() then maps every value of the
+// grid through it into the RGBA8 pixels of the heatmap's stream texture,
+// which is drawn as a single image quad.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Stores the smallest and the largest value of `values[0, count)` in
+// out[0] and out[1], skipping NaNs. Returns false if there are none.
+bool heatmap_range(const float *values, int count, float *out) {
+  float lo = INFINITY, hi = -INFINITY;
+  for (int i = 0; i < count; ++i) {
+    float v = values[i];
+    if (v < lo)
+      lo = v;
+    if (v > hi)
+      hi = v;
+  }
+  out[0] = lo;
+  out[1] = hi;
+  return lo <= hi;
+}
+
+// Writes `total` pixels: the colors of `values[0, count)` in `lut` over
+// [lo, hi], then transparent ones. Values outside the range take the color
+// of its nearest end; NaNs are transparent.
+void heatmap_fill(const float *values, int count, int total, float lo,
+                  float hi, const uint32_t *lut, uint32_t *pixels) {
+  float scale = hi > lo ? 255.0f / (hi - lo) : 0.0f;
+  for (int i = 0; i < count; ++i) {
+    float t = (values[i] - lo) * scale;
+    if (isnan(t)) {
+      pixels[i] = 0;
+      continue;
+    }
+    int index = t <= 0 ? 0 : t >= 255 ? 255 : (int)(t + 0.5f);
+    pixels[i] = lut[index];
+  }
+  for (int i = count; i < total; ++i)
+    pixels[i] = 0;
+}
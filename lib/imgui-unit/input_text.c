@@ -0,0 +1,70 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// Text editing with a growable, persistent buffer.
+// Used by <inputtext>: the renderer keeps the edit buffer in a persistent
+// native slot across frames and passes it here. ImGui grows it through
+// ImGuiInputTextFlags_CallbackResize, which may realloc() the buffer, so the
+// (possibly new) buffer and capacity are returned through
+// input_text_buffer()/input_text_capacity() after every call.
+
+#define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
+#include "cimgui.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct InputTextState {
+  char *buf;
+  int cap;
+} InputTextState;
+
+// Buffer state of the last input_text_edit() call.
+static InputTextState s_state;
+
+static int input_text_resize(ImGuiInputTextCallbackData *data) {
+  if (data->EventFlag != ImGuiInputTextFlags_CallbackResize)
+    return 0;
+  InputTextState *st = (InputTextState *)data->UserData;
+  int cap = st->cap > 0 ? st->cap : 64;
+  while (cap < data->BufTextLen + 1)
+    cap *= 2;
+  // The buffer comes from malloc() in asciiz.js, so realloc() is fine.
+  char *buf = (char *)realloc(st->buf, cap);
+  if (!buf)
+    return 0;
+  st->buf = buf;
+  st->cap = cap;
+  data->Buf = buf;
+  data->BufSize = cap;
+  return 0;
+}
+
+// Edit `buf` (`cap` bytes, NUL-terminated) with InputText, InputTextWithHint
+// (non-empty `hint`) or, if `multiline`, InputTextMultiline of size w x h.
+// Returns true if the text was changed this frame.
+bool input_text_edit(const char *label, const char *hint, char *buf, int cap,
+                     int flags, bool multiline, float w, float h) {
+  s_state.buf = buf;
+  s_state.cap = cap;
+  flags |= ImGuiInputTextFlags_CallbackResize;
+  if (multiline) {
+    ImVec2 size = {w, h};
+    return igInputTextMultiline(label, buf, (size_t)cap, size, flags,
+                                input_text_resize, &s_state);
+  }
+  if (hint && hint[0])
+    return igInputTextWithHint(label, hint, buf, (size_t)cap, flags,
+                               input_text_resize, &s_state);
+  return igInputText(label, buf, (size_t)cap, flags, input_text_resize,
+                     &s_state);
+}
+
+// Buffer after the last input_text_edit() call (may have been reallocated).
+char *input_text_buffer(void) { return s_state.buf; }
+
+// Capacity of input_text_buffer() in bytes.
+int input_text_capacity(void) { return s_state.cap; }
+
+// Length of the NUL-terminated text in input_text_buffer().
+int input_text_length(void) { return (int)strlen(s_state.buf); }
@@ -0,0 +1,69 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// Screen rect of what a node drew, for the outline of the tree inspector's
+// hovered node. Items extend their window's DC.CursorMaxPos, like they do
+// for igBeginGroup(), so it is reset to the cursor before the node renders
+// and read after it, then restored to cover both. Nothing is submitted and
+// the layout doesn't change. A <window> or <root> draws into a window of
+// its own, whose rect is taken instead.
+
+#define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
+#include "cimgui.h"
+
+#include <stdbool.h>
+
+// Window of the inspector_rect_begin() in progress, or null.
+static ImGuiWindow *s_window;
+static ImVec2 s_saved_max;
+// Rect of the last inspector_rect_end() not drawn yet.
+static ImVec2 s_min;
+static ImVec2 s_max;
+static bool s_valid;
+
+static float max_f(float a, float b) { return a > b ? a : b; }
+
+// Start measuring the node about to render in the current window.
+void inspector_rect_begin(void) {
+  ImGuiWindow *window = igGetCurrentWindow();
+  s_window = window;
+  s_saved_max = window->DC.CursorMaxPos;
+  s_min = window->DC.CursorPos;
+  window->DC.CursorMaxPos = window->DC.CursorPos;
+}
+
+// Finish measuring the node: the rect of the window named `window_name`
+// (after its igEnd()), or with null, of the items submitted since
+// inspector_rect_begin(). Also called when the node's rendering threw.
+void inspector_rect_end(const char *window_name) {
+  ImGuiWindow *window = s_window;
+  if (!window)
+    return;
+  s_window = NULL;
+  ImVec2 max = window->DC.CursorMaxPos;
+  window->DC.CursorMaxPos.x = max_f(s_saved_max.x, max.x);
+  window->DC.CursorMaxPos.y = max_f(s_saved_max.y, max.y);
+  s_max = max;
+  s_valid = true;
+  if (window_name) {
+    ImGuiWindow *own = igFindWindowByName(window_name);
+    if (!own || !own->Active) {
+      s_valid = false;
+      return;
+    }
+    s_min = own->Pos;
+    s_max.x = own->Pos.x + own->Size.x;
+    s_max.y = own->Pos.y + own->Size.y;
+  }
+}
+
+// Outline the last measured rect on the foreground and forget it.
+void inspector_draw_highlight(void) {
+  if (!s_valid)
+    return;
+  s_valid = false;
+  ImDrawList *list = igGetForegroundDrawList_Nil();
+  ImDrawList_AddRectFilled(list, s_min, s_max, 0x3000FFFF, 0, 0);
+  ImDrawList_AddRect(list, s_min, s_max, 0xFF00FFFF, 0, 0, 2.0f);
+}
@@ -30,7 +30,9 @@ const _igStyleColorsClassic = $SHBuiltin.extern_c({}, function igStyleColorsClas
 const _igBegin = $SHBuiltin.extern_c({}, function igBegin(_name: c_ptr, _p_open: c_ptr, _flags: c_int): c_bool { throw 0; });
 const _igEnd = $SHBuiltin.extern_c({}, function igEnd(): void { throw 0; });
 const _igBeginChild_Str = $SHBuiltin.extern_c({}, function igBeginChild_Str_cwrap(_str_id: c_ptr, _size: c_ptr, _border: c_bool, _flags: c_int): c_bool { throw 0; });
+const _igBeginChild_Str_flat = $SHBuiltin.extern_c({}, function igBeginChild_Str_flat(_str_id: c_ptr, _size_x: c_float, _size_y: c_float, _border: c_bool, _flags: c_int): c_bool { throw 0; });
 const _igBeginChild_ID = $SHBuiltin.extern_c({}, function igBeginChild_ID_cwrap(_id: c_uint, _size: c_ptr, _border: c_bool, _flags: c_int): c_bool { throw 0; });
+const _igBeginChild_ID_flat = $SHBuiltin.extern_c({}, function igBeginChild_ID_flat(_id: c_uint, _size_x: c_float, _size_y: c_float, _border: c_bool, _flags: c_int): c_bool { throw 0; });
 const _igEndChild = $SHBuiltin.extern_c({}, function igEndChild(): void { throw 0; });
 const _igIsWindowAppearing = $SHBuiltin.extern_c({}, function igIsWindowAppearing(): c_bool { throw 0; });
 const _igIsWindowCollapsed = $SHBuiltin.extern_c({}, function igIsWindowCollapsed(): c_bool { throw 0; });
@@ -42,20 +44,29 @@ const _igGetWindowSize = $SHBuiltin.extern_c({}, function igGetWindowSize(_pOut:
 const _igGetWindowWidth = $SHBuiltin.extern_c({}, function igGetWindowWidth(): c_float { throw 0; });
 const _igGetWindowHeight = $SHBuiltin.extern_c({}, function igGetWindowHeight(): c_float { throw 0; });
 const _igSetNextWindowPos = $SHBuiltin.extern_c({}, function igSetNextWindowPos_cwrap(_pos: c_ptr, _cond: c_int, _pivot: c_ptr): void { throw 0; });
+const _igSetNextWindowPos_flat = $SHBuiltin.extern_c({}, function igSetNextWindowPos_flat(_pos_x: c_float, _pos_y: c_float, _cond: c_int, _pivot_x: c_float, _pivot_y: c_float): void { throw 0; });
 const _igSetNextWindowSize = $SHBuiltin.extern_c({}, function igSetNextWindowSize_cwrap(_size: c_ptr, _cond: c_int): void { throw 0; });
+const _igSetNextWindowSize_flat = $SHBuiltin.extern_c({}, function igSetNextWindowSize_flat(_size_x: c_float, _size_y: c_float, _cond: c_int): void { throw 0; });
 const _igSetNextWindowSizeConstraints = $SHBuiltin.extern_c({}, function igSetNextWindowSizeConstraints_cwrap(_size_min: c_ptr, _size_max: c_ptr, _custom_callback: c_ptr, _custom_callback_data: c_ptr): void { throw 0; });
+const _igSetNextWindowSizeConstraints_flat = $SHBuiltin.extern_c({}, function igSetNextWindowSizeConstraints_flat(_size_min_x: c_float, _size_min_y: c_float, _size_max_x: c_float, _size_max_y: c_float, _custom_callback: c_ptr, _custom_callback_data: c_ptr): void { throw 0; });
 const _igSetNextWindowContentSize = $SHBuiltin.extern_c({}, function igSetNextWindowContentSize_cwrap(_size: c_ptr): void { throw 0; });
+const _igSetNextWindowContentSize_flat = $SHBuiltin.extern_c({}, function igSetNextWindowContentSize_flat(_size_x: c_float, _size_y: c_float): void { throw 0; });
 const _igSetNextWindowCollapsed = $SHBuiltin.extern_c({}, function igSetNextWindowCollapsed(_collapsed: c_bool, _cond: c_int): void { throw 0; });
 const _igSetNextWindowFocus = $SHBuiltin.extern_c({}, function igSetNextWindowFocus(): void { throw 0; });
 const _igSetNextWindowScroll = $SHBuiltin.extern_c({}, function igSetNextWindowScroll_cwrap(_scroll: c_ptr): void { throw 0; });
+const _igSetNextWindowScroll_flat = $SHBuiltin.extern_c({}, function igSetNextWindowScroll_flat(_scroll_x: c_float, _scroll_y: c_float): void { throw 0; });
 const _igSetNextWindowBgAlpha = $SHBuiltin.extern_c({}, function igSetNextWindowBgAlpha(_alpha: c_float): void { throw 0; });
 const _igSetWindowPos_Vec2 = $SHBuiltin.extern_c({}, function igSetWindowPos_Vec2_cwrap(_pos: c_ptr, _cond: c_int): void { throw 0; });
+const _igSetWindowPos_Vec2_flat = $SHBuiltin.extern_c({}, function igSetWindowPos_Vec2_flat(_pos_x: c_float, _pos_y: c_float, _cond: c_int): void { throw 0; });
 const _igSetWindowSize_Vec2 = $SHBuiltin.extern_c({}, function igSetWindowSize_Vec2_cwrap(_size: c_ptr, _cond: c_int): void { throw 0; });
+const _igSetWindowSize_Vec2_flat = $SHBuiltin.extern_c({}, function igSetWindowSize_Vec2_flat(_size_x: c_float, _size_y: c_float, _cond: c_int): void { throw 0; });
 const _igSetWindowCollapsed_Bool = $SHBuiltin.extern_c({}, function igSetWindowCollapsed_Bool(_collapsed: c_bool, _cond: c_int): void { throw 0; });
 const _igSetWindowFocus_Nil = $SHBuiltin.extern_c({}, function igSetWindowFocus_Nil(): void { throw 0; });
 const _igSetWindowFontScale = $SHBuiltin.extern_c({}, function igSetWindowFontScale(_scale: c_float): void { throw 0; });
 const _igSetWindowPos_Str = $SHBuiltin.extern_c({}, function igSetWindowPos_Str_cwrap(_name: c_ptr, _pos: c_ptr, _cond: c_int): void { throw 0; });
+const _igSetWindowPos_Str_flat = $SHBuiltin.extern_c({}, function igSetWindowPos_Str_flat(_name: c_ptr, _pos_x: c_float, _pos_y: c_float, _cond: c_int): void { throw 0; });
 const _igSetWindowSize_Str = $SHBuiltin.extern_c({}, function igSetWindowSize_Str_cwrap(_name: c_ptr, _size: c_ptr, _cond: c_int): void { throw 0; });
+const _igSetWindowSize_Str_flat = $SHBuiltin.extern_c({}, function igSetWindowSize_Str_flat(_name: c_ptr, _size_x: c_float, _size_y: c_float, _cond: c_int): void { throw 0; });
 const _igSetWindowCollapsed_Str = $SHBuiltin.extern_c({}, function igSetWindowCollapsed_Str(_name: c_ptr, _collapsed: c_bool, _cond: c_int): void { throw 0; });
 const _igSetWindowFocus_Str = $SHBuiltin.extern_c({}, function igSetWindowFocus_Str(_name: c_ptr): void { throw 0; });
 const _igGetContentRegionAvail = $SHBuiltin.extern_c({}, function igGetContentRegionAvail(_pOut: c_ptr): void { throw 0; });
@@ -76,9 +87,11 @@ const _igPushFont = $SHBuiltin.extern_c({}, function igPushFont(_font: c_ptr): v
 const _igPopFont = $SHBuiltin.extern_c({}, function igPopFont(): void { throw 0; });
 const _igPushStyleColor_U32 = $SHBuiltin.extern_c({}, function igPushStyleColor_U32(_idx: c_int, _col: c_uint): void { throw 0; });
 const _igPushStyleColor_Vec4 = $SHBuiltin.extern_c({}, function igPushStyleColor_Vec4_cwrap(_idx: c_int, _col: c_ptr): void { throw 0; });
+const _igPushStyleColor_Vec4_flat = $SHBuiltin.extern_c({}, function igPushStyleColor_Vec4_flat(_idx: c_int, _col_x: c_float, _col_y: c_float, _col_z: c_float, _col_w: c_float): void { throw 0; });
 const _igPopStyleColor = $SHBuiltin.extern_c({}, function igPopStyleColor(_count: c_int): void { throw 0; });
 const _igPushStyleVar_Float = $SHBuiltin.extern_c({}, function igPushStyleVar_Float(_idx: c_int, _val: c_float): void { throw 0; });
 const _igPushStyleVar_Vec2 = $SHBuiltin.extern_c({}, function igPushStyleVar_Vec2_cwrap(_idx: c_int, _val: c_ptr): void { throw 0; });
+const _igPushStyleVar_Vec2_flat = $SHBuiltin.extern_c({}, function igPushStyleVar_Vec2_flat(_idx: c_int, _val_x: c_float, _val_y: c_float): void { throw 0; });
 const _igPopStyleVar = $SHBuiltin.extern_c({}, function igPopStyleVar(_count: c_int): void { throw 0; });
 const _igPushTabStop = $SHBuiltin.extern_c({}, function igPushTabStop(_tab_stop: c_bool): void { throw 0; });
 const _igPopTabStop = $SHBuiltin.extern_c({}, function igPopTabStop(): void { throw 0; });
@@ -95,6 +108,7 @@ const _igGetFontSize = $SHBuiltin.extern_c({}, function igGetFontSize(): c_float
 const _igGetFontTexUvWhitePixel = $SHBuiltin.extern_c({}, function igGetFontTexUvWhitePixel(_pOut: c_ptr): void { throw 0; });
 const _igGetColorU32_Col = $SHBuiltin.extern_c({}, function igGetColorU32_Col(_idx: c_int, _alpha_mul: c_float): c_uint { throw 0; });
 const _igGetColorU32_Vec4 = $SHBuiltin.extern_c({}, function igGetColorU32_Vec4_cwrap(_col: c_ptr): c_uint { throw 0; });
+const _igGetColorU32_Vec4_flat = $SHBuiltin.extern_c({}, function igGetColorU32_Vec4_flat(_col_x: c_float, _col_y: c_float, _col_z: c_float, _col_w: c_float): c_uint { throw 0; });
 const _igGetColorU32_U32 = $SHBuiltin.extern_c({}, function igGetColorU32_U32(_col: c_uint): c_uint { throw 0; });
 const _igGetStyleColorVec4 = $SHBuiltin.extern_c({}, function igGetStyleColorVec4(_idx: c_int): c_ptr { throw 0; });
 const _igSeparator = $SHBuiltin.extern_c({}, function igSeparator(): void { throw 0; });
@@ -102,6 +116,7 @@ const _igSameLine = $SHBuiltin.extern_c({}, function igSameLine(_offset_from_sta
 const _igNewLine = $SHBuiltin.extern_c({}, function igNewLine(): void { throw 0; });
 const _igSpacing = $SHBuiltin.extern_c({}, function igSpacing(): void { throw 0; });
 const _igDummy = $SHBuiltin.extern_c({}, function igDummy_cwrap(_size: c_ptr): void { throw 0; });
+const _igDummy_flat = $SHBuiltin.extern_c({}, function igDummy_flat(_size_x: c_float, _size_y: c_float): void { throw 0; });
 const _igIndent = $SHBuiltin.extern_c({}, function igIndent(_indent_w: c_float): void { throw 0; });
 const _igUnindent = $SHBuiltin.extern_c({}, function igUnindent(_indent_w: c_float): void { throw 0; });
 const _igBeginGroup = $SHBuiltin.extern_c({}, function igBeginGroup(): void { throw 0; });
@@ -110,11 +125,13 @@ const _igGetCursorPos = $SHBuiltin.extern_c({}, function igGetCursorPos(_pOut: c
 const _igGetCursorPosX = $SHBuiltin.extern_c({}, function igGetCursorPosX(): c_float { throw 0; });
 const _igGetCursorPosY = $SHBuiltin.extern_c({}, function igGetCursorPosY(): c_float { throw 0; });
 const _igSetCursorPos = $SHBuiltin.extern_c({}, function igSetCursorPos_cwrap(_local_pos: c_ptr): void { throw 0; });
+const _igSetCursorPos_flat = $SHBuiltin.extern_c({}, function igSetCursorPos_flat(_local_pos_x: c_float, _local_pos_y: c_float): void { throw 0; });
 const _igSetCursorPosX = $SHBuiltin.extern_c({}, function igSetCursorPosX(_local_x: c_float): void { throw 0; });
 const _igSetCursorPosY = $SHBuiltin.extern_c({}, function igSetCursorPosY(_local_y: c_float): void { throw 0; });
 const _igGetCursorStartPos = $SHBuiltin.extern_c({}, function igGetCursorStartPos(_pOut: c_ptr): void { throw 0; });
 const _igGetCursorScreenPos = $SHBuiltin.extern_c({}, function igGetCursorScreenPos(_pOut: c_ptr): void { throw 0; });
 const _igSetCursorScreenPos = $SHBuiltin.extern_c({}, function igSetCursorScreenPos_cwrap(_pos: c_ptr): void { throw 0; });
+const _igSetCursorScreenPos_flat = $SHBuiltin.extern_c({}, function igSetCursorScreenPos_flat(_pos_x: c_float, _pos_y: c_float): void { throw 0; });
 const _igAlignTextToFramePadding = $SHBuiltin.extern_c({}, function igAlignTextToFramePadding(): void { throw 0; });
 const _igGetTextLineHeight = $SHBuiltin.extern_c({}, function igGetTextLineHeight(): c_float { throw 0; });
 const _igGetTextLineHeightWithSpacing = $SHBuiltin.extern_c({}, function igGetTextLineHeightWithSpacing(): c_float { throw 0; });
@@ -132,7 +149,9 @@ const _igTextUnformatted = $SHBuiltin.extern_c({}, function igTextUnformatted(_t
 const _igText = $SHBuiltin.extern_c({}, function igText(_fmt: c_ptr): void { throw 0; });
 const _igTextV = $SHBuiltin.extern_c({}, function igTextV(_fmt: c_ptr, _args: c_ptr): void { throw 0; });
 const _igTextColored = $SHBuiltin.extern_c({}, function igTextColored_cwrap(_col: c_ptr, _fmt: c_ptr): void { throw 0; });
+const _igTextColored_flat = $SHBuiltin.extern_c({}, function igTextColored_flat(_col_x: c_float, _col_y: c_float, _col_z: c_float, _col_w: c_float, _fmt: c_ptr): void { throw 0; });
 const _igTextColoredV = $SHBuiltin.extern_c({}, function igTextColoredV_cwrap(_col: c_ptr, _fmt: c_ptr, _args: c_ptr): void { throw 0; });
+const _igTextColoredV_flat = $SHBuiltin.extern_c({}, function igTextColoredV_flat(_col_x: c_float, _col_y: c_float, _col_z: c_float, _col_w: c_float, _fmt: c_ptr, _args: c_ptr): void { throw 0; });
 const _igTextDisabled = $SHBuiltin.extern_c({}, function igTextDisabled(_fmt: c_ptr): void { throw 0; });
 const _igTextDisabledV = $SHBuiltin.extern_c({}, function igTextDisabledV(_fmt: c_ptr, _args: c_ptr): void { throw 0; });
 const _igTextWrapped = $SHBuiltin.extern_c({}, function igTextWrapped(_fmt: c_ptr): void { throw 0; });
@@ -143,8 +162,10 @@ const _igBulletText = $SHBuiltin.extern_c({}, function igBulletText(_fmt: c_ptr)
 const _igBulletTextV = $SHBuiltin.extern_c({}, function igBulletTextV(_fmt: c_ptr, _args: c_ptr): void { throw 0; });
 const _igSeparatorText = $SHBuiltin.extern_c({}, function igSeparatorText(_label: c_ptr): void { throw 0; });
 const _igButton = $SHBuiltin.extern_c({}, function igButton_cwrap(_label: c_ptr, _size: c_ptr): c_bool { throw 0; });
+const _igButton_flat = $SHBuiltin.extern_c({}, function igButton_flat(_label: c_ptr, _size_x: c_float, _size_y: c_float): c_bool { throw 0; });
 const _igSmallButton = $SHBuiltin.extern_c({}, function igSmallButton(_label: c_ptr): c_bool { throw 0; });
 const _igInvisibleButton = $SHBuiltin.extern_c({}, function igInvisibleButton_cwrap(_str_id: c_ptr, _size: c_ptr, _flags: c_int): c_bool { throw 0; });
+const _igInvisibleButton_flat = $SHBuiltin.extern_c({}, function igInvisibleButton_flat(_str_id: c_ptr, _size_x: c_float, _size_y: c_float, _flags: c_int): c_bool { throw 0; });
 const _igArrowButton = $SHBuiltin.extern_c({}, function igArrowButton(_str_id: c_ptr, _dir: c_int): c_bool { throw 0; });
 const _igCheckbox = $SHBuiltin.extern_c({}, function igCheckbox(_label: c_ptr, _v: c_ptr): c_bool { throw 0; });
 const _igCheckboxFlags_IntPtr = $SHBuiltin.extern_c({}, function igCheckboxFlags_IntPtr(_label: c_ptr, _flags: c_ptr, _flags_value: c_int): c_bool { throw 0; });
@@ -152,9 +173,12 @@ const _igCheckboxFlags_UintPtr = $SHBuiltin.extern_c({}, function igCheckboxFlag
 const _igRadioButton_Bool = $SHBuiltin.extern_c({}, function igRadioButton_Bool(_label: c_ptr, _active: c_bool): c_bool { throw 0; });
 const _igRadioButton_IntPtr = $SHBuiltin.extern_c({}, function igRadioButton_IntPtr(_label: c_ptr, _v: c_ptr, _v_button: c_int): c_bool { throw 0; });
 const _igProgressBar = $SHBuiltin.extern_c({}, function igProgressBar_cwrap(_fraction: c_float, _size_arg: c_ptr, _overlay: c_ptr): void { throw 0; });
+const _igProgressBar_flat = $SHBuiltin.extern_c({}, function igProgressBar_flat(_fraction: c_float, _size_arg_x: c_float, _size_arg_y: c_float, _overlay: c_ptr): void { throw 0; });
 const _igBullet = $SHBuiltin.extern_c({}, function igBullet(): void { throw 0; });
 const _igImage = $SHBuiltin.extern_c({}, function igImage_cwrap(_user_texture_id: c_ptr, _size: c_ptr, _uv0: c_ptr, _uv1: c_ptr, _tint_col: c_ptr, _border_col: c_ptr): void { throw 0; });
+const _igImage_flat = $SHBuiltin.extern_c({}, function igImage_flat(_user_texture_id: c_ptr, _size_x: c_float, _size_y: c_float, _uv0_x: c_float, _uv0_y: c_float, _uv1_x: c_float, _uv1_y: c_float, _tint_col_x: c_float, _tint_col_y: c_float, _tint_col_z: c_float, _tint_col_w: c_float, _border_col_x: c_float, _border_col_y: c_float, _border_col_z: c_float, _border_col_w: c_float): void { throw 0; });
 const _igImageButton = $SHBuiltin.extern_c({}, function igImageButton_cwrap(_str_id: c_ptr, _user_texture_id: c_ptr, _size: c_ptr, _uv0: c_ptr, _uv1: c_ptr, _bg_col: c_ptr, _tint_col: c_ptr): c_bool { throw 0; });
+const _igImageButton_flat = $SHBuiltin.extern_c({}, function igImageButton_flat(_str_id: c_ptr, _user_texture_id: c_ptr, _size_x: c_float, _size_y: c_float, _uv0_x: c_float, _uv0_y: c_float, _uv1_x: c_float, _uv1_y: c_float, _bg_col_x: c_float, _bg_col_y: c_float, _bg_col_z: c_float, _bg_col_w: c_float, _tint_col_x: c_float, _tint_col_y: c_float, _tint_col_z: c_float, _tint_col_w: c_float): c_bool { throw 0; });
 const _igBeginCombo = $SHBuiltin.extern_c({}, function igBeginCombo(_label: c_ptr, _preview_value: c_ptr, _flags: c_int): c_bool { throw 0; });
 const _igEndCombo = $SHBuiltin.extern_c({}, function igEndCombo(): void { throw 0; });
 const _igCombo_Str_arr = $SHBuiltin.extern_c({}, function igCombo_Str_arr(_label: c_ptr, _current_item: c_ptr, _items: c_ptr, _items_count: c_int, _popup_max_height_in_items: c_int): c_bool { throw 0; });
@@ -184,10 +208,14 @@ const _igSliderInt4 = $SHBuiltin.extern_c({}, function igSliderInt4(_label: c_pt
 const _igSliderScalar = $SHBuiltin.extern_c({}, function igSliderScalar(_label: c_ptr, _data_type: c_int, _p_data: c_ptr, _p_min: c_ptr, _p_max: c_ptr, _format: c_ptr, _flags: c_int): c_bool { throw 0; });
 const _igSliderScalarN = $SHBuiltin.extern_c({}, function igSliderScalarN(_label: c_ptr, _data_type: c_int, _p_data: c_ptr, _components: c_int, _p_min: c_ptr, _p_max: c_ptr, _format: c_ptr, _flags: c_int): c_bool { throw 0; });
 const _igVSliderFloat = $SHBuiltin.extern_c({}, function igVSliderFloat_cwrap(_label: c_ptr, _size: c_ptr, _v: c_ptr, _v_min: c_float, _v_max: c_float, _format: c_ptr, _flags: c_int): c_bool { throw 0; });
+const _igVSliderFloat_flat = $SHBuiltin.extern_c({}, function igVSliderFloat_flat(_label: c_ptr, _size_x: c_float, _size_y: c_float, _v: c_ptr, _v_min: c_float, _v_max: c_float, _format: c_ptr, _flags: c_int): c_bool { throw 0; });
 const _igVSliderInt = $SHBuiltin.extern_c({}, function igVSliderInt_cwrap(_label: c_ptr, _size: c_ptr, _v: c_ptr, _v_min: c_int, _v_max: c_int, _format: c_ptr, _flags: c_int): c_bool { throw 0; });
+const _igVSliderInt_flat = $SHBuiltin.extern_c({}, function igVSliderInt_flat(_label: c_ptr, _size_x: c_float, _size_y: c_float, _v: c_ptr, _v_min: c_int, _v_max: c_int, _format: c_ptr, _flags: c_int): c_bool { throw 0; });
 const _igVSliderScalar = $SHBuiltin.extern_c({}, function igVSliderScalar_cwrap(_label: c_ptr, _size: c_ptr, _data_type: c_int, _p_data: c_ptr, _p_min: c_ptr, _p_max: c_ptr, _format: c_ptr, _flags: c_int): c_bool { throw 0; });
+const _igVSliderScalar_flat = $SHBuiltin.extern_c({}, function igVSliderScalar_flat(_label: c_ptr, _size_x: c_float, _size_y: c_float, _data_type: c_int, _p_data: c_ptr, _p_min: c_ptr, _p_max: c_ptr, _format: c_ptr, _flags: c_int): c_bool { throw 0; });
 const _igInputText = $SHBuiltin.extern_c({}, function igInputText(_label: c_ptr, _buf: c_ptr, _buf_size: c_ulong, _flags: c_int, _callback: c_ptr, _user_data: c_ptr): c_bool { throw 0; });
 const _igInputTextMultiline = $SHBuiltin.extern_c({}, function igInputTextMultiline_cwrap(_label: c_ptr, _buf: c_ptr, _buf_size: c_ulong, _size: c_ptr, _flags: c_int, _callback: c_ptr, _user_data: c_ptr): c_bool { throw 0; });
+const _igInputTextMultiline_flat = $SHBuiltin.extern_c({}, function igInputTextMultiline_flat(_label: c_ptr, _buf: c_ptr, _buf_size: c_ulong, _size_x: c_float, _size_y: c_float, _flags: c_int, _callback: c_ptr, _user_data: c_ptr): c_bool { throw 0; });
 const _igInputTextWithHint = $SHBuiltin.extern_c({}, function igInputTextWithHint(_label: c_ptr, _hint: c_ptr, _buf: c_ptr, _buf_size: c_ulong, _flags: c_int, _callback: c_ptr, _user_data: c_ptr): c_bool { throw 0; });
 const _igInputFloat = $SHBuiltin.extern_c({}, function igInputFloat(_label: c_ptr, _v: c_ptr, _step: c_float, _step_fast: c_float, _format: c_ptr, _flags: c_int): c_bool { throw 0; });
 const _igInputFloat2 = $SHBuiltin.extern_c({}, function igInputFloat2(_label: c_ptr, _v: c_ptr, _format: c_ptr, _flags: c_int): c_bool { throw 0; });
@@ -205,6 +233,7 @@ const _igColorEdit4 = $SHBuiltin.extern_c({}, function igColorEdit4(_label: c_pt
 const _igColorPicker3 = $SHBuiltin.extern_c({}, function igColorPicker3(_label: c_ptr, _col: c_ptr, _flags: c_int): c_bool { throw 0; });
 const _igColorPicker4 = $SHBuiltin.extern_c({}, function igColorPicker4(_label: c_ptr, _col: c_ptr, _flags: c_int, _ref_col: c_ptr): c_bool { throw 0; });
 const _igColorButton = $SHBuiltin.extern_c({}, function igColorButton_cwrap(_desc_id: c_ptr, _col: c_ptr, _flags: c_int, _size: c_ptr): c_bool { throw 0; });
+const _igColorButton_flat = $SHBuiltin.extern_c({}, function igColorButton_flat(_desc_id: c_ptr, _col_x: c_float, _col_y: c_float, _col_z: c_float, _col_w: c_float, _flags: c_int, _size_x: c_float, _size_y: c_float): c_bool { throw 0; });
 const _igSetColorEditOptions = $SHBuiltin.extern_c({}, function igSetColorEditOptions(_flags: c_int): void { throw 0; });
 const _igTreeNode_Str = $SHBuiltin.extern_c({}, function igTreeNode_Str(_label: c_ptr): c_bool { throw 0; });
 const _igTreeNode_StrStr = $SHBuiltin.extern_c({}, function igTreeNode_StrStr(_str_id: c_ptr, _fmt: c_ptr): c_bool { throw 0; });
@@ -224,15 +253,22 @@ const _igCollapsingHeader_TreeNodeFlags = $SHBuiltin.extern_c({}, function igCol
 const _igCollapsingHeader_BoolPtr = $SHBuiltin.extern_c({}, function igCollapsingHeader_BoolPtr(_label: c_ptr, _p_visible: c_ptr, _flags: c_int): c_bool { throw 0; });
 const _igSetNextItemOpen = $SHBuiltin.extern_c({}, function igSetNextItemOpen(_is_open: c_bool, _cond: c_int): void { throw 0; });
 const _igSelectable_Bool = $SHBuiltin.extern_c({}, function igSelectable_Bool_cwrap(_label: c_ptr, _selected: c_bool, _flags: c_int, _size: c_ptr): c_bool { throw 0; });
+const _igSelectable_Bool_flat = $SHBuiltin.extern_c({}, function igSelectable_Bool_flat(_label: c_ptr, _selected: c_bool, _flags: c_int, _size_x: c_float, _size_y: c_float): c_bool { throw 0; });
 const _igSelectable_BoolPtr = $SHBuiltin.extern_c({}, function igSelectable_BoolPtr_cwrap(_label: c_ptr, _p_selected: c_ptr, _flags: c_int, _size: c_ptr): c_bool { throw 0; });
+const _igSelectable_BoolPtr_flat = $SHBuiltin.extern_c({}, function igSelectable_BoolPtr_flat(_label: c_ptr, _p_selected: c_ptr, _flags: c_int, _size_x: c_float, _size_y: c_float): c_bool { throw 0; });
 const _igBeginListBox = $SHBuiltin.extern_c({}, function igBeginListBox_cwrap(_label: c_ptr, _size: c_ptr): c_bool { throw 0; });
+const _igBeginListBox_flat = $SHBuiltin.extern_c({}, function igBeginListBox_flat(_label: c_ptr, _size_x: c_float, _size_y: c_float): c_bool { throw 0; });
 const _igEndListBox = $SHBuiltin.extern_c({}, function igEndListBox(): void { throw 0; });
 const _igListBox_Str_arr = $SHBuiltin.extern_c({}, function igListBox_Str_arr(_label: c_ptr, _current_item: c_ptr, _items: c_ptr, _items_count: c_int, _height_in_items: c_int): c_bool { throw 0; });
 const _igListBox_FnBoolPtr = $SHBuiltin.extern_c({}, function igListBox_FnBoolPtr(_label: c_ptr, _current_item: c_ptr, _items_getter: c_ptr, _data: c_ptr, _items_count: c_int, _height_in_items: c_int): c_bool { throw 0; });
 const _igPlotLines_FloatPtr = $SHBuiltin.extern_c({}, function igPlotLines_FloatPtr_cwrap(_label: c_ptr, _values: c_ptr, _values_count: c_int, _values_offset: c_int, _overlay_text: c_ptr, _scale_min: c_float, _scale_max: c_float, _graph_size: c_ptr, _stride: c_int): void { throw 0; });
+const _igPlotLines_FloatPtr_flat = $SHBuiltin.extern_c({}, function igPlotLines_FloatPtr_flat(_label: c_ptr, _values: c_ptr, _values_count: c_int, _values_offset: c_int, _overlay_text: c_ptr, _scale_min: c_float, _scale_max: c_float, _graph_size_x: c_float, _graph_size_y: c_float, _stride: c_int): void { throw 0; });
 const _igPlotLines_FnFloatPtr = $SHBuiltin.extern_c({}, function igPlotLines_FnFloatPtr_cwrap(_label: c_ptr, _values_getter: c_ptr, _data: c_ptr, _values_count: c_int, _values_offset: c_int, _overlay_text: c_ptr, _scale_min: c_float, _scale_max: c_float, _graph_size: c_ptr): void { throw 0; });
+const _igPlotLines_FnFloatPtr_flat = $SHBuiltin.extern_c({}, function igPlotLines_FnFloatPtr_flat(_label: c_ptr, _values_getter: c_ptr, _data: c_ptr, _values_count: c_int, _values_offset: c_int, _overlay_text: c_ptr, _scale_min: c_float, _scale_max: c_float, _graph_size_x: c_float, _graph_size_y: c_float): void { throw 0; });
 const _igPlotHistogram_FloatPtr = $SHBuiltin.extern_c({}, function igPlotHistogram_FloatPtr_cwrap(_label: c_ptr, _values: c_ptr, _values_count: c_int, _values_offset: c_int, _overlay_text: c_ptr, _scale_min: c_float, _scale_max: c_float, _graph_size: c_ptr, _stride: c_int): void { throw 0; });
+const _igPlotHistogram_FloatPtr_flat = $SHBuiltin.extern_c({}, function igPlotHistogram_FloatPtr_flat(_label: c_ptr, _values: c_ptr, _values_count: c_int, _values_offset: c_int, _overlay_text: c_ptr, _scale_min: c_float, _scale_max: c_float, _graph_size_x: c_float, _graph_size_y: c_float, _stride: c_int): void { throw 0; });
 const _igPlotHistogram_FnFloatPtr = $SHBuiltin.extern_c({}, function igPlotHistogram_FnFloatPtr_cwrap(_label: c_ptr, _values_getter: c_ptr, _data: c_ptr, _values_count: c_int, _values_offset: c_int, _overlay_text: c_ptr, _scale_min: c_float, _scale_max: c_float, _graph_size: c_ptr): void { throw 0; });
+const _igPlotHistogram_FnFloatPtr_flat = $SHBuiltin.extern_c({}, function igPlotHistogram_FnFloatPtr_flat(_label: c_ptr, _values_getter: c_ptr, _data: c_ptr, _values_count: c_int, _values_offset: c_int, _overlay_text: c_ptr, _scale_min: c_float, _scale_max: c_float, _graph_size_x: c_float, _graph_size_y: c_float): void { throw 0; });
 const _igValue_Bool = $SHBuiltin.extern_c({}, function igValue_Bool(_prefix: c_ptr, _b: c_bool): void { throw 0; });
 const _igValue_Int = $SHBuiltin.extern_c({}, function igValue_Int(_prefix: c_ptr, _v: c_int): void { throw 0; });
 const _igValue_Uint = $SHBuiltin.extern_c({}, function igValue_Uint(_prefix: c_ptr, _v: c_uint): void { throw 0; });
@@ -264,6 +300,7 @@ const _igBeginPopupContextWindow = $SHBuiltin.extern_c({}, function igBeginPopup
 const _igBeginPopupContextVoid = $SHBuiltin.extern_c({}, function igBeginPopupContextVoid(_str_id: c_ptr, _popup_flags: c_int): c_bool { throw 0; });
 const _igIsPopupOpen_Str = $SHBuiltin.extern_c({}, function igIsPopupOpen_Str(_str_id: c_ptr, _flags: c_int): c_bool { throw 0; });
 const _igBeginTable = $SHBuiltin.extern_c({}, function igBeginTable_cwrap(_str_id: c_ptr, _column: c_int, _flags: c_int, _outer_size: c_ptr, _inner_width: c_float): c_bool { throw 0; });
+const _igBeginTable_flat = $SHBuiltin.extern_c({}, function igBeginTable_flat(_str_id: c_ptr, _column: c_int, _flags: c_int, _outer_size_x: c_float, _outer_size_y: c_float, _inner_width: c_float): c_bool { throw 0; });
 const _igEndTable = $SHBuiltin.extern_c({}, function igEndTable(): void { throw 0; });
 const _igTableNextRow = $SHBuiltin.extern_c({}, function igTableNextRow(_row_flags: c_int, _min_row_height: c_float): void { throw 0; });
 const _igTableNextColumn = $SHBuiltin.extern_c({}, function igTableNextColumn(): c_bool { throw 0; });
@@ -310,6 +347,7 @@ const _igGetDragDropPayload = $SHBuiltin.extern_c({}, function igGetDragDropPayl
 const _igBeginDisabled = $SHBuiltin.extern_c({}, function igBeginDisabled(_disabled: c_bool): void { throw 0; });
 const _igEndDisabled = $SHBuiltin.extern_c({}, function igEndDisabled(): void { throw 0; });
 const _igPushClipRect = $SHBuiltin.extern_c({}, function igPushClipRect_cwrap(_clip_rect_min: c_ptr, _clip_rect_max: c_ptr, _intersect_with_current_clip_rect: c_bool): void { throw 0; });
+const _igPushClipRect_flat = $SHBuiltin.extern_c({}, function igPushClipRect_flat(_clip_rect_min_x: c_float, _clip_rect_min_y: c_float, _clip_rect_max_x: c_float, _clip_rect_max_y: c_float, _intersect_with_current_clip_rect: c_bool): void { throw 0; });
 const _igPopClipRect = $SHBuiltin.extern_c({}, function igPopClipRect(): void { throw 0; });
 const _igSetItemDefaultFocus = $SHBuiltin.extern_c({}, function igSetItemDefaultFocus(): void { throw 0; });
 const _igSetKeyboardFocusHere = $SHBuiltin.extern_c({}, function igSetKeyboardFocusHere(_offset: c_int): void { throw 0; });
@@ -335,7 +373,9 @@ const _igGetMainViewport = $SHBuiltin.extern_c({}, function igGetMainViewport():
 const _igGetBackgroundDrawList_Nil = $SHBuiltin.extern_c({}, function igGetBackgroundDrawList_Nil(): c_ptr { throw 0; });
 const _igGetForegroundDrawList_Nil = $SHBuiltin.extern_c({}, function igGetForegroundDrawList_Nil(): c_ptr { throw 0; });
 const _igIsRectVisible_Nil = $SHBuiltin.extern_c({}, function igIsRectVisible_Nil_cwrap(_size: c_ptr): c_bool { throw 0; });
+const _igIsRectVisible_Nil_flat = $SHBuiltin.extern_c({}, function igIsRectVisible_Nil_flat(_size_x: c_float, _size_y: c_float): c_bool { throw 0; });
 const _igIsRectVisible_Vec2 = $SHBuiltin.extern_c({}, function igIsRectVisible_Vec2_cwrap(_rect_min: c_ptr, _rect_max: c_ptr): c_bool { throw 0; });
+const _igIsRectVisible_Vec2_flat = $SHBuiltin.extern_c({}, function igIsRectVisible_Vec2_flat(_rect_min_x: c_float, _rect_min_y: c_float, _rect_max_x: c_float, _rect_max_y: c_float): c_bool { throw 0; });
 const _igGetTime = $SHBuiltin.extern_c({}, function igGetTime(): c_double { throw 0; });
 const _igGetFrameCount = $SHBuiltin.extern_c({}, function igGetFrameCount(): c_int { throw 0; });
 const _igGetDrawListSharedData = $SHBuiltin.extern_c({}, function igGetDrawListSharedData(): c_ptr { throw 0; });
@@ -343,10 +383,12 @@ const _igGetStyleColorName = $SHBuiltin.extern_c({}, function igGetStyleColorNam
 const _igSetStateStorage = $SHBuiltin.extern_c({}, function igSetStateStorage(_storage: c_ptr): void { throw 0; });
 const _igGetStateStorage = $SHBuiltin.extern_c({}, function igGetStateStorage(): c_ptr { throw 0; });
 const _igBeginChildFrame = $SHBuiltin.extern_c({}, function igBeginChildFrame_cwrap(_id: c_uint, _size: c_ptr, _flags: c_int): c_bool { throw 0; });
+const _igBeginChildFrame_flat = $SHBuiltin.extern_c({}, function igBeginChildFrame_flat(_id: c_uint, _size_x: c_float, _size_y: c_float, _flags: c_int): c_bool { throw 0; });
 const _igEndChildFrame = $SHBuiltin.extern_c({}, function igEndChildFrame(): void { throw 0; });
 const _igCalcTextSize = $SHBuiltin.extern_c({}, function igCalcTextSize(_pOut: c_ptr, _text: c_ptr, _text_end: c_ptr, _hide_text_after_double_hash: c_bool, _wrap_width: c_float): void { throw 0; });
 const _igColorConvertU32ToFloat4 = $SHBuiltin.extern_c({}, function igColorConvertU32ToFloat4(_pOut: c_ptr, _in: c_uint): void { throw 0; });
 const _igColorConvertFloat4ToU32 = $SHBuiltin.extern_c({}, function igColorConvertFloat4ToU32_cwrap(_in: c_ptr): c_uint { throw 0; });
+const _igColorConvertFloat4ToU32_flat = $SHBuiltin.extern_c({}, function igColorConvertFloat4ToU32_flat(_in_x: c_float, _in_y: c_float, _in_z: c_float, _in_w: c_float): c_uint { throw 0; });
 const _igColorConvertRGBtoHSV = $SHBuiltin.extern_c({}, function igColorConvertRGBtoHSV(_r: c_float, _g: c_float, _b: c_float, _out_h: c_ptr, _out_s: c_ptr, _out_v: c_ptr): void { throw 0; });
 const _igColorConvertHSVtoRGB = $SHBuiltin.extern_c({}, function igColorConvertHSVtoRGB(_h: c_float, _s: c_float, _v: c_float, _out_r: c_ptr, _out_g: c_ptr, _out_b: c_ptr): void { throw 0; });
 const _igIsKeyDown_Nil = $SHBuiltin.extern_c({}, function igIsKeyDown_Nil(_key: c_int): c_bool { throw 0; });
@@ -361,6 +403,7 @@ const _igIsMouseReleased_Nil = $SHBuiltin.extern_c({}, function igIsMouseRelease
 const _igIsMouseDoubleClicked = $SHBuiltin.extern_c({}, function igIsMouseDoubleClicked(_button: c_int): c_bool { throw 0; });
 const _igGetMouseClickedCount = $SHBuiltin.extern_c({}, function igGetMouseClickedCount(_button: c_int): c_int { throw 0; });
 const _igIsMouseHoveringRect = $SHBuiltin.extern_c({}, function igIsMouseHoveringRect_cwrap(_r_min: c_ptr, _r_max: c_ptr, _clip: c_bool): c_bool { throw 0; });
+const _igIsMouseHoveringRect_flat = $SHBuiltin.extern_c({}, function igIsMouseHoveringRect_flat(_r_min_x: c_float, _r_min_y: c_float, _r_max_x: c_float, _r_max_y: c_float, _clip: c_bool): c_bool { throw 0; });
 const _igIsMousePosValid = $SHBuiltin.extern_c({}, function igIsMousePosValid(_mouse_pos: c_ptr): c_bool { throw 0; });
 const _igIsAnyMouseDown = $SHBuiltin.extern_c({}, function igIsAnyMouseDown(): c_bool { throw 0; });
 const _igGetMousePos = $SHBuiltin.extern_c({}, function igGetMousePos(_pOut: c_ptr): void { throw 0; });
@@ -474,6 +517,7 @@ const _ImColor_ImColor_Nil = $SHBuiltin.extern_c({}, function ImColor_ImColor_Ni
 const _ImColor_destroy = $SHBuiltin.extern_c({}, function ImColor_destroy(_self: c_ptr): void { throw 0; });
 const _ImColor_ImColor_Float = $SHBuiltin.extern_c({}, function ImColor_ImColor_Float(_r: c_float, _g: c_float, _b: c_float, _a: c_float): c_ptr { throw 0; });
 const _ImColor_ImColor_Vec4 = $SHBuiltin.extern_c({}, function ImColor_ImColor_Vec4_cwrap(_col: c_ptr): c_ptr { throw 0; });
+const _ImColor_ImColor_Vec4_flat = $SHBuiltin.extern_c({}, function ImColor_ImColor_Vec4_flat(_col_x: c_float, _col_y: c_float, _col_z: c_float, _col_w: c_float): c_ptr { throw 0; });
 const _ImColor_ImColor_Int = $SHBuiltin.extern_c({}, function ImColor_ImColor_Int(_r: c_int, _g: c_int, _b: c_int, _a: c_int): c_ptr { throw 0; });
 const _ImColor_ImColor_U32 = $SHBuiltin.extern_c({}, function ImColor_ImColor_U32(_rgba: c_uint): c_ptr { throw 0; });
 const _ImColor_SetHSV = $SHBuiltin.extern_c({}, function ImColor_SetHSV(_self: c_ptr, _h: c_float, _s: c_float, _v: c_float, _a: c_float): void { throw 0; });
@@ -491,6 +535,7 @@ const _ImDrawListSplitter_SetCurrentChannel = $SHBuiltin.extern_c({}, function I
 const _ImDrawList_ImDrawList = $SHBuiltin.extern_c({}, function ImDrawList_ImDrawList(_shared_data: c_ptr): c_ptr { throw 0; });
 const _ImDrawList_destroy = $SHBuiltin.extern_c({}, function ImDrawList_destroy(_self: c_ptr): void { throw 0; });
 const _ImDrawList_PushClipRect = $SHBuiltin.extern_c({}, function ImDrawList_PushClipRect_cwrap(_self: c_ptr, _clip_rect_min: c_ptr, _clip_rect_max: c_ptr, _intersect_with_current_clip_rect: c_bool): void { throw 0; });
+const _ImDrawList_PushClipRect_flat = $SHBuiltin.extern_c({}, function ImDrawList_PushClipRect_flat(_self: c_ptr, _clip_rect_min_x: c_float, _clip_rect_min_y: c_float, _clip_rect_max_x: c_float, _clip_rect_max_y: c_float, _intersect_with_current_clip_rect: c_bool): void { throw 0; });
 const _ImDrawList_PushClipRectFullScreen = $SHBuiltin.extern_c({}, function ImDrawList_PushClipRectFullScreen(_self: c_ptr): void { throw 0; });
 const _ImDrawList_PopClipRect = $SHBuiltin.extern_c({}, function ImDrawList_PopClipRect(_self: c_ptr): void { throw 0; });
 const _ImDrawList_PushTextureID = $SHBuiltin.extern_c({}, function ImDrawList_PushTextureID(_self: c_ptr, _texture_id: c_ptr): void { throw 0; });
@@ -498,36 +543,62 @@ const _ImDrawList_PopTextureID = $SHBuiltin.extern_c({}, function ImDrawList_Pop
 const _ImDrawList_GetClipRectMin = $SHBuiltin.extern_c({}, function ImDrawList_GetClipRectMin(_pOut: c_ptr, _self: c_ptr): void { throw 0; });
 const _ImDrawList_GetClipRectMax = $SHBuiltin.extern_c({}, function ImDrawList_GetClipRectMax(_pOut: c_ptr, _self: c_ptr): void { throw 0; });
 const _ImDrawList_AddLine = $SHBuiltin.extern_c({}, function ImDrawList_AddLine_cwrap(_self: c_ptr, _p1: c_ptr, _p2: c_ptr, _col: c_uint, _thickness: c_float): void { throw 0; });
+const _ImDrawList_AddLine_flat = $SHBuiltin.extern_c({}, function ImDrawList_AddLine_flat(_self: c_ptr, _p1_x: c_float, _p1_y: c_float, _p2_x: c_float, _p2_y: c_float, _col: c_uint, _thickness: c_float): void { throw 0; });
 const _ImDrawList_AddRect = $SHBuiltin.extern_c({}, function ImDrawList_AddRect_cwrap(_self: c_ptr, _p_min: c_ptr, _p_max: c_ptr, _col: c_uint, _rounding: c_float, _flags: c_int, _thickness: c_float): void { throw 0; });
+const _ImDrawList_AddRect_flat = $SHBuiltin.extern_c({}, function ImDrawList_AddRect_flat(_self: c_ptr, _p_min_x: c_float, _p_min_y: c_float, _p_max_x: c_float, _p_max_y: c_float, _col: c_uint, _rounding: c_float, _flags: c_int, _thickness: c_float): void { throw 0; });
 const _ImDrawList_AddRectFilled = $SHBuiltin.extern_c({}, function ImDrawList_AddRectFilled_cwrap(_self: c_ptr, _p_min: c_ptr, _p_max: c_ptr, _col: c_uint, _rounding: c_float, _flags: c_int): void { throw 0; });
+const _ImDrawList_AddRectFilled_flat = $SHBuiltin.extern_c({}, function ImDrawList_AddRectFilled_flat(_self: c_ptr, _p_min_x: c_float, _p_min_y: c_float, _p_max_x: c_float, _p_max_y: c_float, _col: c_uint, _rounding: c_float, _flags: c_int): void { throw 0; });
 const _ImDrawList_AddRectFilledMultiColor = $SHBuiltin.extern_c({}, function ImDrawList_AddRectFilledMultiColor_cwrap(_self: c_ptr, _p_min: c_ptr, _p_max: c_ptr, _col_upr_left: c_uint, _col_upr_right: c_uint, _col_bot_right: c_uint, _col_bot_left: c_uint): void { throw 0; });
+const _ImDrawList_AddRectFilledMultiColor_flat = $SHBuiltin.extern_c({}, function ImDrawList_AddRectFilledMultiColor_flat(_self: c_ptr, _p_min_x: c_float, _p_min_y: c_float, _p_max_x: c_float, _p_max_y: c_float, _col_upr_left: c_uint, _col_upr_right: c_uint, _col_bot_right: c_uint, _col_bot_left: c_uint): void { throw 0; });
 const _ImDrawList_AddQuad = $SHBuiltin.extern_c({}, function ImDrawList_AddQuad_cwrap(_self: c_ptr, _p1: c_ptr, _p2: c_ptr, _p3: c_ptr, _p4: c_ptr, _col: c_uint, _thickness: c_float): void { throw 0; });
+const _ImDrawList_AddQuad_flat = $SHBuiltin.extern_c({}, function ImDrawList_AddQuad_flat(_self: c_ptr, _p1_x: c_float, _p1_y: c_float, _p2_x: c_float, _p2_y: c_float, _p3_x: c_float, _p3_y: c_float, _p4_x: c_float, _p4_y: c_float, _col: c_uint, _thickness: c_float): void { throw 0; });
 const _ImDrawList_AddQuadFilled = $SHBuiltin.extern_c({}, function ImDrawList_AddQuadFilled_cwrap(_self: c_ptr, _p1: c_ptr, _p2: c_ptr, _p3: c_ptr, _p4: c_ptr, _col: c_uint): void { throw 0; });
+const _ImDrawList_AddQuadFilled_flat = $SHBuiltin.extern_c({}, function ImDrawList_AddQuadFilled_flat(_self: c_ptr, _p1_x: c_float, _p1_y: c_float, _p2_x: c_float, _p2_y: c_float, _p3_x: c_float, _p3_y: c_float, _p4_x: c_float, _p4_y: c_float, _col: c_uint): void { throw 0; });
 const _ImDrawList_AddTriangle = $SHBuiltin.extern_c({}, function ImDrawList_AddTriangle_cwrap(_self: c_ptr, _p1: c_ptr, _p2: c_ptr, _p3: c_ptr, _col: c_uint, _thickness: c_float): void { throw 0; });
+const _ImDrawList_AddTriangle_flat = $SHBuiltin.extern_c({}, function ImDrawList_AddTriangle_flat(_self: c_ptr, _p1_x: c_float, _p1_y: c_float, _p2_x: c_float, _p2_y: c_float, _p3_x: c_float, _p3_y: c_float, _col: c_uint, _thickness: c_float): void { throw 0; });
 const _ImDrawList_AddTriangleFilled = $SHBuiltin.extern_c({}, function ImDrawList_AddTriangleFilled_cwrap(_self: c_ptr, _p1: c_ptr, _p2: c_ptr, _p3: c_ptr, _col: c_uint): void { throw 0; });
+const _ImDrawList_AddTriangleFilled_flat = $SHBuiltin.extern_c({}, function ImDrawList_AddTriangleFilled_flat(_self: c_ptr, _p1_x: c_float, _p1_y: c_float, _p2_x: c_float, _p2_y: c_float, _p3_x: c_float, _p3_y: c_float, _col: c_uint): void { throw 0; });
 const _ImDrawList_AddCircle = $SHBuiltin.extern_c({}, function ImDrawList_AddCircle_cwrap(_self: c_ptr, _center: c_ptr, _radius: c_float, _col: c_uint, _num_segments: c_int, _thickness: c_float): void { throw 0; });
+const _ImDrawList_AddCircle_flat = $SHBuiltin.extern_c({}, function ImDrawList_AddCircle_flat(_self: c_ptr, _center_x: c_float, _center_y: c_float, _radius: c_float, _col: c_uint, _num_segments: c_int, _thickness: c_float): void { throw 0; });
 const _ImDrawList_AddCircleFilled = $SHBuiltin.extern_c({}, function ImDrawList_AddCircleFilled_cwrap(_self: c_ptr, _center: c_ptr, _radius: c_float, _col: c_uint, _num_segments: c_int): void { throw 0; });
+const _ImDrawList_AddCircleFilled_flat = $SHBuiltin.extern_c({}, function ImDrawList_AddCircleFilled_flat(_self: c_ptr, _center_x: c_float, _center_y: c_float, _radius: c_float, _col: c_uint, _num_segments: c_int): void { throw 0; });
 const _ImDrawList_AddNgon = $SHBuiltin.extern_c({}, function ImDrawList_AddNgon_cwrap(_self: c_ptr, _center: c_ptr, _radius: c_float, _col: c_uint, _num_segments: c_int, _thickness: c_float): void { throw 0; });
+const _ImDrawList_AddNgon_flat = $SHBuiltin.extern_c({}, function ImDrawList_AddNgon_flat(_self: c_ptr, _center_x: c_float, _center_y: c_float, _radius: c_float, _col: c_uint, _num_segments: c_int, _thickness: c_float): void { throw 0; });
 const _ImDrawList_AddNgonFilled = $SHBuiltin.extern_c({}, function ImDrawList_AddNgonFilled_cwrap(_self: c_ptr, _center: c_ptr, _radius: c_float, _col: c_uint, _num_segments: c_int): void { throw 0; });
+const _ImDrawList_AddNgonFilled_flat = $SHBuiltin.extern_c({}, function ImDrawList_AddNgonFilled_flat(_self: c_ptr, _center_x: c_float, _center_y: c_float, _radius: c_float, _col: c_uint, _num_segments: c_int): void { throw 0; });
 const _ImDrawList_AddText_Vec2 = $SHBuiltin.extern_c({}, function ImDrawList_AddText_Vec2_cwrap(_self: c_ptr, _pos: c_ptr, _col: c_uint, _text_begin: c_ptr, _text_end: c_ptr): void { throw 0; });
+const _ImDrawList_AddText_Vec2_flat = $SHBuiltin.extern_c({}, function ImDrawList_AddText_Vec2_flat(_self: c_ptr, _pos_x: c_float, _pos_y: c_float, _col: c_uint, _text_begin: c_ptr, _text_end: c_ptr): void { throw 0; });
 const _ImDrawList_AddText_FontPtr = $SHBuiltin.extern_c({}, function ImDrawList_AddText_FontPtr_cwrap(_self: c_ptr, _font: c_ptr, _font_size: c_float, _pos: c_ptr, _col: c_uint, _text_begin: c_ptr, _text_end: c_ptr, _wrap_width: c_float, _cpu_fine_clip_rect: c_ptr): void { throw 0; });
+const _ImDrawList_AddText_FontPtr_flat = $SHBuiltin.extern_c({}, function ImDrawList_AddText_FontPtr_flat(_self: c_ptr, _font: c_ptr, _font_size: c_float, _pos_x: c_float, _pos_y: c_float, _col: c_uint, _text_begin: c_ptr, _text_end: c_ptr, _wrap_width: c_float, _cpu_fine_clip_rect: c_ptr): void { throw 0; });
 const _ImDrawList_AddPolyline = $SHBuiltin.extern_c({}, function ImDrawList_AddPolyline(_self: c_ptr, _points: c_ptr, _num_points: c_int, _col: c_uint, _flags: c_int, _thickness: c_float): void { throw 0; });
 const _ImDrawList_AddConvexPolyFilled = $SHBuiltin.extern_c({}, function ImDrawList_AddConvexPolyFilled(_self: c_ptr, _points: c_ptr, _num_points: c_int, _col: c_uint): void { throw 0; });
 const _ImDrawList_AddBezierCubic = $SHBuiltin.extern_c({}, function ImDrawList_AddBezierCubic_cwrap(_self: c_ptr, _p1: c_ptr, _p2: c_ptr, _p3: c_ptr, _p4: c_ptr, _col: c_uint, _thickness: c_float, _num_segments: c_int): void { throw 0; });
+const _ImDrawList_AddBezierCubic_flat = $SHBuiltin.extern_c({}, function ImDrawList_AddBezierCubic_flat(_self: c_ptr, _p1_x: c_float, _p1_y: c_float, _p2_x: c_float, _p2_y: c_float, _p3_x: c_float, _p3_y: c_float, _p4_x: c_float, _p4_y: c_float, _col: c_uint, _thickness: c_float, _num_segments: c_int): void { throw 0; });
 const _ImDrawList_AddBezierQuadratic = $SHBuiltin.extern_c({}, function ImDrawList_AddBezierQuadratic_cwrap(_self: c_ptr, _p1: c_ptr, _p2: c_ptr, _p3: c_ptr, _col: c_uint, _thickness: c_float, _num_segments: c_int): void { throw 0; });
+const _ImDrawList_AddBezierQuadratic_flat = $SHBuiltin.extern_c({}, function ImDrawList_AddBezierQuadratic_flat(_self: c_ptr, _p1_x: c_float, _p1_y: c_float, _p2_x: c_float, _p2_y: c_float, _p3_x: c_float, _p3_y: c_float, _col: c_uint, _thickness: c_float, _num_segments: c_int): void { throw 0; });
 const _ImDrawList_AddImage = $SHBuiltin.extern_c({}, function ImDrawList_AddImage_cwrap(_self: c_ptr, _user_texture_id: c_ptr, _p_min: c_ptr, _p_max: c_ptr, _uv_min: c_ptr, _uv_max: c_ptr, _col: c_uint): void { throw 0; });
+const _ImDrawList_AddImage_flat = $SHBuiltin.extern_c({}, function ImDrawList_AddImage_flat(_self: c_ptr, _user_texture_id: c_ptr, _p_min_x: c_float, _p_min_y: c_float, _p_max_x: c_float, _p_max_y: c_float, _uv_min_x: c_float, _uv_min_y: c_float, _uv_max_x: c_float, _uv_max_y: c_float, _col: c_uint): void { throw 0; });
 const _ImDrawList_AddImageQuad = $SHBuiltin.extern_c({}, function ImDrawList_AddImageQuad_cwrap(_self: c_ptr, _user_texture_id: c_ptr, _p1: c_ptr, _p2: c_ptr, _p3: c_ptr, _p4: c_ptr, _uv1: c_ptr, _uv2: c_ptr, _uv3: c_ptr, _uv4: c_ptr, _col: c_uint): void { throw 0; });
+const _ImDrawList_AddImageQuad_flat = $SHBuiltin.extern_c({}, function ImDrawList_AddImageQuad_flat(_self: c_ptr, _user_texture_id: c_ptr, _p1_x: c_float, _p1_y: c_float, _p2_x: c_float, _p2_y: c_float, _p3_x: c_float, _p3_y: c_float, _p4_x: c_float, _p4_y: c_float, _uv1_x: c_float, _uv1_y: c_float, _uv2_x: c_float, _uv2_y: c_float, _uv3_x: c_float, _uv3_y: c_float, _uv4_x: c_float, _uv4_y: c_float, _col: c_uint): void { throw 0; });
 const _ImDrawList_AddImageRounded = $SHBuiltin.extern_c({}, function ImDrawList_AddImageRounded_cwrap(_self: c_ptr, _user_texture_id: c_ptr, _p_min: c_ptr, _p_max: c_ptr, _uv_min: c_ptr, _uv_max: c_ptr, _col: c_uint, _rounding: c_float, _flags: c_int): void { throw 0; });
+const _ImDrawList_AddImageRounded_flat = $SHBuiltin.extern_c({}, function ImDrawList_AddImageRounded_flat(_self: c_ptr, _user_texture_id: c_ptr, _p_min_x: c_float, _p_min_y: c_float, _p_max_x: c_float, _p_max_y: c_float, _uv_min_x: c_float, _uv_min_y: c_float, _uv_max_x: c_float, _uv_max_y: c_float, _col: c_uint, _rounding: c_float, _flags: c_int): void { throw 0; });
 const _ImDrawList_PathClear = $SHBuiltin.extern_c({}, function ImDrawList_PathClear(_self: c_ptr): void { throw 0; });
 const _ImDrawList_PathLineTo = $SHBuiltin.extern_c({}, function ImDrawList_PathLineTo_cwrap(_self: c_ptr, _pos: c_ptr): void { throw 0; });
+const _ImDrawList_PathLineTo_flat = $SHBuiltin.extern_c({}, function ImDrawList_PathLineTo_flat(_self: c_ptr, _pos_x: c_float, _pos_y: c_float): void { throw 0; });
 const _ImDrawList_PathLineToMergeDuplicate = $SHBuiltin.extern_c({}, function ImDrawList_PathLineToMergeDuplicate_cwrap(_self: c_ptr, _pos: c_ptr): void { throw 0; });
+const _ImDrawList_PathLineToMergeDuplicate_flat = $SHBuiltin.extern_c({}, function ImDrawList_PathLineToMergeDuplicate_flat(_self: c_ptr, _pos_x: c_float, _pos_y: c_float): void { throw 0; });
 const _ImDrawList_PathFillConvex = $SHBuiltin.extern_c({}, function ImDrawList_PathFillConvex(_self: c_ptr, _col: c_uint): void { throw 0; });
 const _ImDrawList_PathStroke = $SHBuiltin.extern_c({}, function ImDrawList_PathStroke(_self: c_ptr, _col: c_uint, _flags: c_int, _thickness: c_float): void { throw 0; });
 const _ImDrawList_PathArcTo = $SHBuiltin.extern_c({}, function ImDrawList_PathArcTo_cwrap(_self: c_ptr, _center: c_ptr, _radius: c_float, _a_min: c_float, _a_max: c_float, _num_segments: c_int): void { throw 0; });
+const _ImDrawList_PathArcTo_flat = $SHBuiltin.extern_c({}, function ImDrawList_PathArcTo_flat(_self: c_ptr, _center_x: c_float, _center_y: c_float, _radius: c_float, _a_min: c_float, _a_max: c_float, _num_segments: c_int): void { throw 0; });
 const _ImDrawList_PathArcToFast = $SHBuiltin.extern_c({}, function ImDrawList_PathArcToFast_cwrap(_self: c_ptr, _center: c_ptr, _radius: c_float, _a_min_of_12: c_int, _a_max_of_12: c_int): void { throw 0; });
+const _ImDrawList_PathArcToFast_flat = $SHBuiltin.extern_c({}, function ImDrawList_PathArcToFast_flat(_self: c_ptr, _center_x: c_float, _center_y: c_float, _radius: c_float, _a_min_of_12: c_int, _a_max_of_12: c_int): void { throw 0; });
 const _ImDrawList_PathBezierCubicCurveTo = $SHBuiltin.extern_c({}, function ImDrawList_PathBezierCubicCurveTo_cwrap(_self: c_ptr, _p2: c_ptr, _p3: c_ptr, _p4: c_ptr, _num_segments: c_int): void { throw 0; });
+const _ImDrawList_PathBezierCubicCurveTo_flat = $SHBuiltin.extern_c({}, function ImDrawList_PathBezierCubicCurveTo_flat(_self: c_ptr, _p2_x: c_float, _p2_y: c_float, _p3_x: c_float, _p3_y: c_float, _p4_x: c_float, _p4_y: c_float, _num_segments: c_int): void { throw 0; });
 const _ImDrawList_PathBezierQuadraticCurveTo = $SHBuiltin.extern_c({}, function ImDrawList_PathBezierQuadraticCurveTo_cwrap(_self: c_ptr, _p2: c_ptr, _p3: c_ptr, _num_segments: c_int): void { throw 0; });
+const _ImDrawList_PathBezierQuadraticCurveTo_flat = $SHBuiltin.extern_c({}, function ImDrawList_PathBezierQuadraticCurveTo_flat(_self: c_ptr, _p2_x: c_float, _p2_y: c_float, _p3_x: c_float, _p3_y: c_float, _num_segments: c_int): void { throw 0; });
 const _ImDrawList_PathRect = $SHBuiltin.extern_c({}, function ImDrawList_PathRect_cwrap(_self: c_ptr, _rect_min: c_ptr, _rect_max: c_ptr, _rounding: c_float, _flags: c_int): void { throw 0; });
+const _ImDrawList_PathRect_flat = $SHBuiltin.extern_c({}, function ImDrawList_PathRect_flat(_self: c_ptr, _rect_min_x: c_float, _rect_min_y: c_float, _rect_max_x: c_float, _rect_max_y: c_float, _rounding: c_float, _flags: c_int): void { throw 0; });
 const _ImDrawList_AddCallback = $SHBuiltin.extern_c({}, function ImDrawList_AddCallback(_self: c_ptr, _callback: c_ptr, _callback_data: c_ptr): void { throw 0; });
 const _ImDrawList_AddDrawCmd = $SHBuiltin.extern_c({}, function ImDrawList_AddDrawCmd(_self: c_ptr): void { throw 0; });
 const _ImDrawList_CloneOutput = $SHBuiltin.extern_c({}, function ImDrawList_CloneOutput(_self: c_ptr): c_ptr { throw 0; });
@@ -537,11 +608,16 @@ const _ImDrawList_ChannelsSetCurrent = $SHBuiltin.extern_c({}, function ImDrawLi
 const _ImDrawList_PrimReserve = $SHBuiltin.extern_c({}, function ImDrawList_PrimReserve(_self: c_ptr, _idx_count: c_int, _vtx_count: c_int): void { throw 0; });
 const _ImDrawList_PrimUnreserve = $SHBuiltin.extern_c({}, function ImDrawList_PrimUnreserve(_self: c_ptr, _idx_count: c_int, _vtx_count: c_int): void { throw 0; });
 const _ImDrawList_PrimRect = $SHBuiltin.extern_c({}, function ImDrawList_PrimRect_cwrap(_self: c_ptr, _a: c_ptr, _b: c_ptr, _col: c_uint): void { throw 0; });
+const _ImDrawList_PrimRect_flat = $SHBuiltin.extern_c({}, function ImDrawList_PrimRect_flat(_self: c_ptr, _a_x: c_float, _a_y: c_float, _b_x: c_float, _b_y: c_float, _col: c_uint): void { throw 0; });
 const _ImDrawList_PrimRectUV = $SHBuiltin.extern_c({}, function ImDrawList_PrimRectUV_cwrap(_self: c_ptr, _a: c_ptr, _b: c_ptr, _uv_a: c_ptr, _uv_b: c_ptr, _col: c_uint): void { throw 0; });
+const _ImDrawList_PrimRectUV_flat = $SHBuiltin.extern_c({}, function ImDrawList_PrimRectUV_flat(_self: c_ptr, _a_x: c_float, _a_y: c_float, _b_x: c_float, _b_y: c_float, _uv_a_x: c_float, _uv_a_y: c_float, _uv_b_x: c_float, _uv_b_y: c_float, _col: c_uint): void { throw 0; });
 const _ImDrawList_PrimQuadUV = $SHBuiltin.extern_c({}, function ImDrawList_PrimQuadUV_cwrap(_self: c_ptr, _a: c_ptr, _b: c_ptr, _c: c_ptr, _d: c_ptr, _uv_a: c_ptr, _uv_b: c_ptr, _uv_c: c_ptr, _uv_d: c_ptr, _col: c_uint): void { throw 0; });
+const _ImDrawList_PrimQuadUV_flat = $SHBuiltin.extern_c({}, function ImDrawList_PrimQuadUV_flat(_self: c_ptr, _a_x: c_float, _a_y: c_float, _b_x: c_float, _b_y: c_float, _c_x: c_float, _c_y: c_float, _d_x: c_float, _d_y: c_float, _uv_a_x: c_float, _uv_a_y: c_float, _uv_b_x: c_float, _uv_b_y: c_float, _uv_c_x: c_float, _uv_c_y: c_float, _uv_d_x: c_float, _uv_d_y: c_float, _col: c_uint): void { throw 0; });
 const _ImDrawList_PrimWriteVtx = $SHBuiltin.extern_c({}, function ImDrawList_PrimWriteVtx_cwrap(_self: c_ptr, _pos: c_ptr, _uv: c_ptr, _col: c_uint): void { throw 0; });
+const _ImDrawList_PrimWriteVtx_flat = $SHBuiltin.extern_c({}, function ImDrawList_PrimWriteVtx_flat(_self: c_ptr, _pos_x: c_float, _pos_y: c_float, _uv_x: c_float, _uv_y: c_float, _col: c_uint): void { throw 0; });
 const _ImDrawList_PrimWriteIdx = $SHBuiltin.extern_c({}, function ImDrawList_PrimWriteIdx(_self: c_ptr, _idx: c_ushort): void { throw 0; });
 const _ImDrawList_PrimVtx = $SHBuiltin.extern_c({}, function ImDrawList_PrimVtx_cwrap(_self: c_ptr, _pos: c_ptr, _uv: c_ptr, _col: c_uint): void { throw 0; });
+const _ImDrawList_PrimVtx_flat = $SHBuiltin.extern_c({}, function ImDrawList_PrimVtx_flat(_self: c_ptr, _pos_x: c_float, _pos_y: c_float, _uv_x: c_float, _uv_y: c_float, _col: c_uint): void { throw 0; });
 const _ImDrawList__ResetForNewFrame = $SHBuiltin.extern_c({}, function ImDrawList__ResetForNewFrame(_self: c_ptr): void { throw 0; });
 const _ImDrawList__ClearFreeMemory = $SHBuiltin.extern_c({}, function ImDrawList__ClearFreeMemory(_self: c_ptr): void { throw 0; });
 const _ImDrawList__PopUnusedDrawCmd = $SHBuiltin.extern_c({}, function ImDrawList__PopUnusedDrawCmd(_self: c_ptr): void { throw 0; });
@@ -551,13 +627,16 @@ const _ImDrawList__OnChangedTextureID = $SHBuiltin.extern_c({}, function ImDrawL
 const _ImDrawList__OnChangedVtxOffset = $SHBuiltin.extern_c({}, function ImDrawList__OnChangedVtxOffset(_self: c_ptr): void { throw 0; });
 const _ImDrawList__CalcCircleAutoSegmentCount = $SHBuiltin.extern_c({}, function ImDrawList__CalcCircleAutoSegmentCount(_self: c_ptr, _radius: c_float): c_int { throw 0; });
 const _ImDrawList__PathArcToFastEx = $SHBuiltin.extern_c({}, function ImDrawList__PathArcToFastEx_cwrap(_self: c_ptr, _center: c_ptr, _radius: c_float, _a_min_sample: c_int, _a_max_sample: c_int, _a_step: c_int): void { throw 0; });
+const _ImDrawList__PathArcToFastEx_flat = $SHBuiltin.extern_c({}, function ImDrawList__PathArcToFastEx_flat(_self: c_ptr, _center_x: c_float, _center_y: c_float, _radius: c_float, _a_min_sample: c_int, _a_max_sample: c_int, _a_step: c_int): void { throw 0; });
 const _ImDrawList__PathArcToN = $SHBuiltin.extern_c({}, function ImDrawList__PathArcToN_cwrap(_self: c_ptr, _center: c_ptr, _radius: c_float, _a_min: c_float, _a_max: c_float, _num_segments: c_int): void { throw 0; });
+const _ImDrawList__PathArcToN_flat = $SHBuiltin.extern_c({}, function ImDrawList__PathArcToN_flat(_self: c_ptr, _center_x: c_float, _center_y: c_float, _radius: c_float, _a_min: c_float, _a_max: c_float, _num_segments: c_int): void { throw 0; });
 const _ImDrawData_ImDrawData = $SHBuiltin.extern_c({}, function ImDrawData_ImDrawData(): c_ptr { throw 0; });
 const _ImDrawData_destroy = $SHBuiltin.extern_c({}, function ImDrawData_destroy(_self: c_ptr): void { throw 0; });
 const _ImDrawData_Clear = $SHBuiltin.extern_c({}, function ImDrawData_Clear(_self: c_ptr): void { throw 0; });
 const _ImDrawData_AddDrawList = $SHBuiltin.extern_c({}, function ImDrawData_AddDrawList(_self: c_ptr, _draw_list: c_ptr): void { throw 0; });
 const _ImDrawData_DeIndexAllBuffers = $SHBuiltin.extern_c({}, function ImDrawData_DeIndexAllBuffers(_self: c_ptr): void { throw 0; });
 const _ImDrawData_ScaleClipRects = $SHBuiltin.extern_c({}, function ImDrawData_ScaleClipRects_cwrap(_self: c_ptr, _fb_scale: c_ptr): void { throw 0; });
+const _ImDrawData_ScaleClipRects_flat = $SHBuiltin.extern_c({}, function ImDrawData_ScaleClipRects_flat(_self: c_ptr, _fb_scale_x: c_float, _fb_scale_y: c_float): void { throw 0; });
 const _ImFontConfig_ImFontConfig = $SHBuiltin.extern_c({}, function ImFontConfig_ImFontConfig(): c_ptr { throw 0; });
 const _ImFontConfig_destroy = $SHBuiltin.extern_c({}, function ImFontConfig_destroy(_self: c_ptr): void { throw 0; });
 const _ImFontGlyphRangesBuilder_ImFontGlyphRangesBuilder = $SHBuiltin.extern_c({}, function ImFontGlyphRangesBuilder_ImFontGlyphRangesBuilder(): c_ptr { throw 0; });
@@ -600,6 +679,7 @@ const _ImFontAtlas_GetGlyphRangesThai = $SHBuiltin.extern_c({}, function ImFontA
 const _ImFontAtlas_GetGlyphRangesVietnamese = $SHBuiltin.extern_c({}, function ImFontAtlas_GetGlyphRangesVietnamese(_self: c_ptr): c_ptr { throw 0; });
 const _ImFontAtlas_AddCustomRectRegular = $SHBuiltin.extern_c({}, function ImFontAtlas_AddCustomRectRegular(_self: c_ptr, _width: c_int, _height: c_int): c_int { throw 0; });
 const _ImFontAtlas_AddCustomRectFontGlyph = $SHBuiltin.extern_c({}, function ImFontAtlas_AddCustomRectFontGlyph_cwrap(_self: c_ptr, _font: c_ptr, _id: c_ushort, _width: c_int, _height: c_int, _advance_x: c_float, _offset: c_ptr): c_int { throw 0; });
+const _ImFontAtlas_AddCustomRectFontGlyph_flat = $SHBuiltin.extern_c({}, function ImFontAtlas_AddCustomRectFontGlyph_flat(_self: c_ptr, _font: c_ptr, _id: c_ushort, _width: c_int, _height: c_int, _advance_x: c_float, _offset_x: c_float, _offset_y: c_float): c_int { throw 0; });
 const _ImFontAtlas_GetCustomRectByIndex = $SHBuiltin.extern_c({}, function ImFontAtlas_GetCustomRectByIndex(_self: c_ptr, _index: c_int): c_ptr { throw 0; });
 const _ImFontAtlas_CalcCustomRectUV = $SHBuiltin.extern_c({}, function ImFontAtlas_CalcCustomRectUV(_self: c_ptr, _rect: c_ptr, _out_uv_min: c_ptr, _out_uv_max: c_ptr): void { throw 0; });
 const _ImFontAtlas_GetMouseCursorTexData = $SHBuiltin.extern_c({}, function ImFontAtlas_GetMouseCursorTexData(_self: c_ptr, _cursor: c_int, _out_offset: c_ptr, _out_size: c_ptr, _out_uv_border: c_ptr, _out_uv_fill: c_ptr): c_bool { throw 0; });
@@ -613,7 +693,9 @@ const _ImFont_GetDebugName = $SHBuiltin.extern_c({}, function ImFont_GetDebugNam
 const _ImFont_CalcTextSizeA = $SHBuiltin.extern_c({}, function ImFont_CalcTextSizeA(_pOut: c_ptr, _self: c_ptr, _size: c_float, _max_width: c_float, _wrap_width: c_float, _text_begin: c_ptr, _text_end: c_ptr, _remaining: c_ptr): void { throw 0; });
 const _ImFont_CalcWordWrapPositionA = $SHBuiltin.extern_c({}, function ImFont_CalcWordWrapPositionA(_self: c_ptr, _scale: c_float, _text: c_ptr, _text_end: c_ptr, _wrap_width: c_float): c_ptr { throw 0; });
 const _ImFont_RenderChar = $SHBuiltin.extern_c({}, function ImFont_RenderChar_cwrap(_self: c_ptr, _draw_list: c_ptr, _size: c_float, _pos: c_ptr, _col: c_uint, _c: c_ushort): void { throw 0; });
+const _ImFont_RenderChar_flat = $SHBuiltin.extern_c({}, function ImFont_RenderChar_flat(_self: c_ptr, _draw_list: c_ptr, _size: c_float, _pos_x: c_float, _pos_y: c_float, _col: c_uint, _c: c_ushort): void { throw 0; });
 const _ImFont_RenderText = $SHBuiltin.extern_c({}, function ImFont_RenderText_cwrap(_self: c_ptr, _draw_list: c_ptr, _size: c_float, _pos: c_ptr, _col: c_uint, _clip_rect: c_ptr, _text_begin: c_ptr, _text_end: c_ptr, _wrap_width: c_float, _cpu_fine_clip: c_bool): void { throw 0; });
+const _ImFont_RenderText_flat = $SHBuiltin.extern_c({}, function ImFont_RenderText_flat(_self: c_ptr, _draw_list: c_ptr, _size: c_float, _pos_x: c_float, _pos_y: c_float, _col: c_uint, _clip_rect_x: c_float, _clip_rect_y: c_float, _clip_rect_z: c_float, _clip_rect_w: c_float, _text_begin: c_ptr, _text_end: c_ptr, _wrap_width: c_float, _cpu_fine_clip: c_bool): void { throw 0; });
 const _ImFont_BuildLookupTable = $SHBuiltin.extern_c({}, function ImFont_BuildLookupTable(_self: c_ptr): void { throw 0; });
 const _ImFont_ClearOutputData = $SHBuiltin.extern_c({}, function ImFont_ClearOutputData(_self: c_ptr): void { throw 0; });
 const _ImFont_GrowIndex = $SHBuiltin.extern_c({}, function ImFont_GrowIndex(_self: c_ptr, _new_size: c_int): void { throw 0; });
@@ -685,35 +767,58 @@ const _igImSign_double = $SHBuiltin.extern_c({}, function igImSign_double(_x: c_
 const _igImRsqrt_Float = $SHBuiltin.extern_c({}, function igImRsqrt_Float(_x: c_float): c_float { throw 0; });
 const _igImRsqrt_double = $SHBuiltin.extern_c({}, function igImRsqrt_double(_x: c_double): c_double { throw 0; });
 const _igImMin = $SHBuiltin.extern_c({}, function igImMin_cwrap(_pOut: c_ptr, _lhs: c_ptr, _rhs: c_ptr): void { throw 0; });
+const _igImMin_flat = $SHBuiltin.extern_c({}, function igImMin_flat(_pOut: c_ptr, _lhs_x: c_float, _lhs_y: c_float, _rhs_x: c_float, _rhs_y: c_float): void { throw 0; });
 const _igImMax = $SHBuiltin.extern_c({}, function igImMax_cwrap(_pOut: c_ptr, _lhs: c_ptr, _rhs: c_ptr): void { throw 0; });
+const _igImMax_flat = $SHBuiltin.extern_c({}, function igImMax_flat(_pOut: c_ptr, _lhs_x: c_float, _lhs_y: c_float, _rhs_x: c_float, _rhs_y: c_float): void { throw 0; });
 const _igImClamp = $SHBuiltin.extern_c({}, function igImClamp_cwrap(_pOut: c_ptr, _v: c_ptr, _mn: c_ptr, _mx: c_ptr): void { throw 0; });
+const _igImClamp_flat = $SHBuiltin.extern_c({}, function igImClamp_flat(_pOut: c_ptr, _v_x: c_float, _v_y: c_float, _mn_x: c_float, _mn_y: c_float, _mx_x: c_float, _mx_y: c_float): void { throw 0; });
 const _igImLerp_Vec2Float = $SHBuiltin.extern_c({}, function igImLerp_Vec2Float_cwrap(_pOut: c_ptr, _a: c_ptr, _b: c_ptr, _t: c_float): void { throw 0; });
+const _igImLerp_Vec2Float_flat = $SHBuiltin.extern_c({}, function igImLerp_Vec2Float_flat(_pOut: c_ptr, _a_x: c_float, _a_y: c_float, _b_x: c_float, _b_y: c_float, _t: c_float): void { throw 0; });
 const _igImLerp_Vec2Vec2 = $SHBuiltin.extern_c({}, function igImLerp_Vec2Vec2_cwrap(_pOut: c_ptr, _a: c_ptr, _b: c_ptr, _t: c_ptr): void { throw 0; });
+const _igImLerp_Vec2Vec2_flat = $SHBuiltin.extern_c({}, function igImLerp_Vec2Vec2_flat(_pOut: c_ptr, _a_x: c_float, _a_y: c_float, _b_x: c_float, _b_y: c_float, _t_x: c_float, _t_y: c_float): void { throw 0; });
 const _igImLerp_Vec4 = $SHBuiltin.extern_c({}, function igImLerp_Vec4_cwrap(_pOut: c_ptr, _a: c_ptr, _b: c_ptr, _t: c_float): void { throw 0; });
+const _igImLerp_Vec4_flat = $SHBuiltin.extern_c({}, function igImLerp_Vec4_flat(_pOut: c_ptr, _a_x: c_float, _a_y: c_float, _a_z: c_float, _a_w: c_float, _b_x: c_float, _b_y: c_float, _b_z: c_float, _b_w: c_float, _t: c_float): void { throw 0; });
 const _igImSaturate = $SHBuiltin.extern_c({}, function igImSaturate(_f: c_float): c_float { throw 0; });
 const _igImLengthSqr_Vec2 = $SHBuiltin.extern_c({}, function igImLengthSqr_Vec2_cwrap(_lhs: c_ptr): c_float { throw 0; });
+const _igImLengthSqr_Vec2_flat = $SHBuiltin.extern_c({}, function igImLengthSqr_Vec2_flat(_lhs_x: c_float, _lhs_y: c_float): c_float { throw 0; });
 const _igImLengthSqr_Vec4 = $SHBuiltin.extern_c({}, function igImLengthSqr_Vec4_cwrap(_lhs: c_ptr): c_float { throw 0; });
+const _igImLengthSqr_Vec4_flat = $SHBuiltin.extern_c({}, function igImLengthSqr_Vec4_flat(_lhs_x: c_float, _lhs_y: c_float, _lhs_z: c_float, _lhs_w: c_float): c_float { throw 0; });
 const _igImInvLength = $SHBuiltin.extern_c({}, function igImInvLength_cwrap(_lhs: c_ptr, _fail_value: c_float): c_float { throw 0; });
+const _igImInvLength_flat = $SHBuiltin.extern_c({}, function igImInvLength_flat(_lhs_x: c_float, _lhs_y: c_float, _fail_value: c_float): c_float { throw 0; });
 const _igImFloor_Float = $SHBuiltin.extern_c({}, function igImFloor_Float(_f: c_float): c_float { throw 0; });
 const _igImFloorSigned_Float = $SHBuiltin.extern_c({}, function igImFloorSigned_Float(_f: c_float): c_float { throw 0; });
 const _igImFloor_Vec2 = $SHBuiltin.extern_c({}, function igImFloor_Vec2_cwrap(_pOut: c_ptr, _v: c_ptr): void { throw 0; });
+const _igImFloor_Vec2_flat = $SHBuiltin.extern_c({}, function igImFloor_Vec2_flat(_pOut: c_ptr, _v_x: c_float, _v_y: c_float): void { throw 0; });
 const _igImFloorSigned_Vec2 = $SHBuiltin.extern_c({}, function igImFloorSigned_Vec2_cwrap(_pOut: c_ptr, _v: c_ptr): void { throw 0; });
+const _igImFloorSigned_Vec2_flat = $SHBuiltin.extern_c({}, function igImFloorSigned_Vec2_flat(_pOut: c_ptr, _v_x: c_float, _v_y: c_float): void { throw 0; });
 const _igImModPositive = $SHBuiltin.extern_c({}, function igImModPositive(_a: c_int, _b: c_int): c_int { throw 0; });
 const _igImDot = $SHBuiltin.extern_c({}, function igImDot_cwrap(_a: c_ptr, _b: c_ptr): c_float { throw 0; });
+const _igImDot_flat = $SHBuiltin.extern_c({}, function igImDot_flat(_a_x: c_float, _a_y: c_float, _b_x: c_float, _b_y: c_float): c_float { throw 0; });
 const _igImRotate = $SHBuiltin.extern_c({}, function igImRotate_cwrap(_pOut: c_ptr, _v: c_ptr, _cos_a: c_float, _sin_a: c_float): void { throw 0; });
+const _igImRotate_flat = $SHBuiltin.extern_c({}, function igImRotate_flat(_pOut: c_ptr, _v_x: c_float, _v_y: c_float, _cos_a: c_float, _sin_a: c_float): void { throw 0; });
 const _igImLinearSweep = $SHBuiltin.extern_c({}, function igImLinearSweep(_current: c_float, _target: c_float, _speed: c_float): c_float { throw 0; });
 const _igImMul = $SHBuiltin.extern_c({}, function igImMul_cwrap(_pOut: c_ptr, _lhs: c_ptr, _rhs: c_ptr): void { throw 0; });
+const _igImMul_flat = $SHBuiltin.extern_c({}, function igImMul_flat(_pOut: c_ptr, _lhs_x: c_float, _lhs_y: c_float, _rhs_x: c_float, _rhs_y: c_float): void { throw 0; });
 const _igImIsFloatAboveGuaranteedIntegerPrecision = $SHBuiltin.extern_c({}, function igImIsFloatAboveGuaranteedIntegerPrecision(_f: c_float): c_bool { throw 0; });
 const _igImExponentialMovingAverage = $SHBuiltin.extern_c({}, function igImExponentialMovingAverage(_avg: c_float, _sample: c_float, _n: c_int): c_float { throw 0; });
 const _igImBezierCubicCalc = $SHBuiltin.extern_c({}, function igImBezierCubicCalc_cwrap(_pOut: c_ptr, _p1: c_ptr, _p2: c_ptr, _p3: c_ptr, _p4: c_ptr, _t: c_float): void { throw 0; });
+const _igImBezierCubicCalc_flat = $SHBuiltin.extern_c({}, function igImBezierCubicCalc_flat(_pOut: c_ptr, _p1_x: c_float, _p1_y: c_float, _p2_x: c_float, _p2_y: c_float, _p3_x: c_float, _p3_y: c_float, _p4_x: c_float, _p4_y: c_float, _t: c_float): void { throw 0; });
 const _igImBezierCubicClosestPoint = $SHBuiltin.extern_c({}, function igImBezierCubicClosestPoint_cwrap(_pOut: c_ptr, _p1: c_ptr, _p2: c_ptr, _p3: c_ptr, _p4: c_ptr, _p: c_ptr, _num_segments: c_int): void { throw 0; });
+const _igImBezierCubicClosestPoint_flat = $SHBuiltin.extern_c({}, function igImBezierCubicClosestPoint_flat(_pOut: c_ptr, _p1_x: c_float, _p1_y: c_float, _p2_x: c_float, _p2_y: c_float, _p3_x: c_float, _p3_y: c_float, _p4_x: c_float, _p4_y: c_float, _p_x: c_float, _p_y: c_float, _num_segments: c_int): void { throw 0; });
 const _igImBezierCubicClosestPointCasteljau = $SHBuiltin.extern_c({}, function igImBezierCubicClosestPointCasteljau_cwrap(_pOut: c_ptr, _p1: c_ptr, _p2: c_ptr, _p3: c_ptr, _p4: c_ptr, _p: c_ptr, _tess_tol: c_float): void { throw 0; });
+const _igImBezierCubicClosestPointCasteljau_flat = $SHBuiltin.extern_c({}, function igImBezierCubicClosestPointCasteljau_flat(_pOut: c_ptr, _p1_x: c_float, _p1_y: c_float, _p2_x: c_float, _p2_y: c_float, _p3_x: c_float, _p3_y: c_float, _p4_x: c_float, _p4_y: c_float, _p_x: c_float, _p_y: c_float, _tess_tol: c_float): void { throw 0; });
 const _igImBezierQuadraticCalc = $SHBuiltin.extern_c({}, function igImBezierQuadraticCalc_cwrap(_pOut: c_ptr, _p1: c_ptr, _p2: c_ptr, _p3: c_ptr, _t: c_float): void { throw 0; });
+const _igImBezierQuadraticCalc_flat = $SHBuiltin.extern_c({}, function igImBezierQuadraticCalc_flat(_pOut: c_ptr, _p1_x: c_float, _p1_y: c_float, _p2_x: c_float, _p2_y: c_float, _p3_x: c_float, _p3_y: c_float, _t: c_float): void { throw 0; });
 const _igImLineClosestPoint = $SHBuiltin.extern_c({}, function igImLineClosestPoint_cwrap(_pOut: c_ptr, _a: c_ptr, _b: c_ptr, _p: c_ptr): void { throw 0; });
+const _igImLineClosestPoint_flat = $SHBuiltin.extern_c({}, function igImLineClosestPoint_flat(_pOut: c_ptr, _a_x: c_float, _a_y: c_float, _b_x: c_float, _b_y: c_float, _p_x: c_float, _p_y: c_float): void { throw 0; });
 const _igImTriangleContainsPoint = $SHBuiltin.extern_c({}, function igImTriangleContainsPoint_cwrap(_a: c_ptr, _b: c_ptr, _c: c_ptr, _p: c_ptr): c_bool { throw 0; });
+const _igImTriangleContainsPoint_flat = $SHBuiltin.extern_c({}, function igImTriangleContainsPoint_flat(_a_x: c_float, _a_y: c_float, _b_x: c_float, _b_y: c_float, _c_x: c_float, _c_y: c_float, _p_x: c_float, _p_y: c_float): c_bool { throw 0; });
 const _igImTriangleClosestPoint = $SHBuiltin.extern_c({}, function igImTriangleClosestPoint_cwrap(_pOut: c_ptr, _a: c_ptr, _b: c_ptr, _c: c_ptr, _p: c_ptr): void { throw 0; });
+const _igImTriangleClosestPoint_flat = $SHBuiltin.extern_c({}, function igImTriangleClosestPoint_flat(_pOut: c_ptr, _a_x: c_float, _a_y: c_float, _b_x: c_float, _b_y: c_float, _c_x: c_float, _c_y: c_float, _p_x: c_float, _p_y: c_float): void { throw 0; });
 const _igImTriangleBarycentricCoords = $SHBuiltin.extern_c({}, function igImTriangleBarycentricCoords_cwrap(_a: c_ptr, _b: c_ptr, _c: c_ptr, _p: c_ptr, _out_u: c_ptr, _out_v: c_ptr, _out_w: c_ptr): void { throw 0; });
+const _igImTriangleBarycentricCoords_flat = $SHBuiltin.extern_c({}, function igImTriangleBarycentricCoords_flat(_a_x: c_float, _a_y: c_float, _b_x: c_float, _b_y: c_float, _c_x: c_float, _c_y: c_float, _p_x: c_float, _p_y: c_float, _out_u: c_ptr, _out_v: c_ptr, _out_w: c_ptr): void { throw 0; });
 const _igImTriangleArea = $SHBuiltin.extern_c({}, function igImTriangleArea_cwrap(_a: c_ptr, _b: c_ptr, _c: c_ptr): c_float { throw 0; });
+const _igImTriangleArea_flat = $SHBuiltin.extern_c({}, function igImTriangleArea_flat(_a_x: c_float, _a_y: c_float, _b_x: c_float, _b_y: c_float, _c_x: c_float, _c_y: c_float): c_float { throw 0; });
 const _ImVec1_ImVec1_Nil = $SHBuiltin.extern_c({}, function ImVec1_ImVec1_Nil(): c_ptr { throw 0; });
 const _ImVec1_destroy = $SHBuiltin.extern_c({}, function ImVec1_destroy(_self: c_ptr): void { throw 0; });
 const _ImVec1_ImVec1_Float = $SHBuiltin.extern_c({}, function ImVec1_ImVec1_Float(__x: c_float): c_ptr { throw 0; });
@@ -721,10 +826,13 @@ const _ImVec2ih_ImVec2ih_Nil = $SHBuiltin.extern_c({}, function ImVec2ih_ImVec2i
 const _ImVec2ih_destroy = $SHBuiltin.extern_c({}, function ImVec2ih_destroy(_self: c_ptr): void { throw 0; });
 const _ImVec2ih_ImVec2ih_short = $SHBuiltin.extern_c({}, function ImVec2ih_ImVec2ih_short(__x: c_short, __y: c_short): c_ptr { throw 0; });
 const _ImVec2ih_ImVec2ih_Vec2 = $SHBuiltin.extern_c({}, function ImVec2ih_ImVec2ih_Vec2_cwrap(_rhs: c_ptr): c_ptr { throw 0; });
+const _ImVec2ih_ImVec2ih_Vec2_flat = $SHBuiltin.extern_c({}, function ImVec2ih_ImVec2ih_Vec2_flat(_rhs_x: c_float, _rhs_y: c_float): c_ptr { throw 0; });
 const _ImRect_ImRect_Nil = $SHBuiltin.extern_c({}, function ImRect_ImRect_Nil(): c_ptr { throw 0; });
 const _ImRect_destroy = $SHBuiltin.extern_c({}, function ImRect_destroy(_self: c_ptr): void { throw 0; });
 const _ImRect_ImRect_Vec2 = $SHBuiltin.extern_c({}, function ImRect_ImRect_Vec2_cwrap(_min: c_ptr, _max: c_ptr): c_ptr { throw 0; });
+const _ImRect_ImRect_Vec2_flat = $SHBuiltin.extern_c({}, function ImRect_ImRect_Vec2_flat(_min_x: c_float, _min_y: c_float, _max_x: c_float, _max_y: c_float): c_ptr { throw 0; });
 const _ImRect_ImRect_Vec4 = $SHBuiltin.extern_c({}, function ImRect_ImRect_Vec4_cwrap(_v: c_ptr): c_ptr { throw 0; });
+const _ImRect_ImRect_Vec4_flat = $SHBuiltin.extern_c({}, function ImRect_ImRect_Vec4_flat(_v_x: c_float, _v_y: c_float, _v_z: c_float, _v_w: c_float): c_ptr { throw 0; });
 const _ImRect_ImRect_Float = $SHBuiltin.extern_c({}, function ImRect_ImRect_Float(_x1: c_float, _y1: c_float, _x2: c_float, _y2: c_float): c_ptr { throw 0; });
 const _ImRect_GetCenter = $SHBuiltin.extern_c({}, function ImRect_GetCenter(_pOut: c_ptr, _self: c_ptr): void { throw 0; });
 const _ImRect_GetSize = $SHBuiltin.extern_c({}, function ImRect_GetSize(_pOut: c_ptr, _self: c_ptr): void { throw 0; });
@@ -736,13 +844,17 @@ const _ImRect_GetTR = $SHBuiltin.extern_c({}, function ImRect_GetTR(_pOut: c_ptr
 const _ImRect_GetBL = $SHBuiltin.extern_c({}, function ImRect_GetBL(_pOut: c_ptr, _self: c_ptr): void { throw 0; });
 const _ImRect_GetBR = $SHBuiltin.extern_c({}, function ImRect_GetBR(_pOut: c_ptr, _self: c_ptr): void { throw 0; });
 const _ImRect_Contains_Vec2 = $SHBuiltin.extern_c({}, function ImRect_Contains_Vec2_cwrap(_self: c_ptr, _p: c_ptr): c_bool { throw 0; });
+const _ImRect_Contains_Vec2_flat = $SHBuiltin.extern_c({}, function ImRect_Contains_Vec2_flat(_self: c_ptr, _p_x: c_float, _p_y: c_float): c_bool { throw 0; });
 const _ImRect_Contains_Rect = $SHBuiltin.extern_c({}, function ImRect_Contains_Rect_cwrap(_self: c_ptr, _r: c_ptr): c_bool { throw 0; });
 const _ImRect_Overlaps = $SHBuiltin.extern_c({}, function ImRect_Overlaps_cwrap(_self: c_ptr, _r: c_ptr): c_bool { throw 0; });
 const _ImRect_Add_Vec2 = $SHBuiltin.extern_c({}, function ImRect_Add_Vec2_cwrap(_self: c_ptr, _p: c_ptr): void { throw 0; });
+const _ImRect_Add_Vec2_flat = $SHBuiltin.extern_c({}, function ImRect_Add_Vec2_flat(_self: c_ptr, _p_x: c_float, _p_y: c_float): void { throw 0; });
 const _ImRect_Add_Rect = $SHBuiltin.extern_c({}, function ImRect_Add_Rect_cwrap(_self: c_ptr, _r: c_ptr): void { throw 0; });
 const _ImRect_Expand_Float = $SHBuiltin.extern_c({}, function ImRect_Expand_Float(_self: c_ptr, _amount: c_float): void { throw 0; });
 const _ImRect_Expand_Vec2 = $SHBuiltin.extern_c({}, function ImRect_Expand_Vec2_cwrap(_self: c_ptr, _amount: c_ptr): void { throw 0; });
+const _ImRect_Expand_Vec2_flat = $SHBuiltin.extern_c({}, function ImRect_Expand_Vec2_flat(_self: c_ptr, _amount_x: c_float, _amount_y: c_float): void { throw 0; });
 const _ImRect_Translate = $SHBuiltin.extern_c({}, function ImRect_Translate_cwrap(_self: c_ptr, _d: c_ptr): void { throw 0; });
+const _ImRect_Translate_flat = $SHBuiltin.extern_c({}, function ImRect_Translate_flat(_self: c_ptr, _d_x: c_float, _d_y: c_float): void { throw 0; });
 const _ImRect_TranslateX = $SHBuiltin.extern_c({}, function ImRect_TranslateX(_self: c_ptr, _dx: c_float): void { throw 0; });
 const _ImRect_TranslateY = $SHBuiltin.extern_c({}, function ImRect_TranslateY(_self: c_ptr, _dy: c_float): void { throw 0; });
 const _ImRect_ClipWith = $SHBuiltin.extern_c({}, function ImRect_ClipWith_cwrap(_self: c_ptr, _r: c_ptr): void { throw 0; });
@@ -776,6 +888,7 @@ const _ImGuiStyleMod_ImGuiStyleMod_Int = $SHBuiltin.extern_c({}, function ImGuiS
 const _ImGuiStyleMod_destroy = $SHBuiltin.extern_c({}, function ImGuiStyleMod_destroy(_self: c_ptr): void { throw 0; });
 const _ImGuiStyleMod_ImGuiStyleMod_Float = $SHBuiltin.extern_c({}, function ImGuiStyleMod_ImGuiStyleMod_Float(_idx: c_int, _v: c_float): c_ptr { throw 0; });
 const _ImGuiStyleMod_ImGuiStyleMod_Vec2 = $SHBuiltin.extern_c({}, function ImGuiStyleMod_ImGuiStyleMod_Vec2_cwrap(_idx: c_int, _v: c_ptr): c_ptr { throw 0; });
+const _ImGuiStyleMod_ImGuiStyleMod_Vec2_flat = $SHBuiltin.extern_c({}, function ImGuiStyleMod_ImGuiStyleMod_Vec2_flat(_idx: c_int, _v_x: c_float, _v_y: c_float): c_ptr { throw 0; });
 const _ImGuiComboPreviewData_ImGuiComboPreviewData = $SHBuiltin.extern_c({}, function ImGuiComboPreviewData_ImGuiComboPreviewData(): c_ptr { throw 0; });
 const _ImGuiComboPreviewData_destroy = $SHBuiltin.extern_c({}, function ImGuiComboPreviewData_destroy(_self: c_ptr): void { throw 0; });
 const _ImGuiMenuColumns_ImGuiMenuColumns = $SHBuiltin.extern_c({}, function ImGuiMenuColumns_ImGuiMenuColumns(): c_ptr { throw 0; });
@@ -842,7 +955,9 @@ const _ImGuiOldColumns_destroy = $SHBuiltin.extern_c({}, function ImGuiOldColumn
 const _ImGuiViewportP_ImGuiViewportP = $SHBuiltin.extern_c({}, function ImGuiViewportP_ImGuiViewportP(): c_ptr { throw 0; });
 const _ImGuiViewportP_destroy = $SHBuiltin.extern_c({}, function ImGuiViewportP_destroy(_self: c_ptr): void { throw 0; });
 const _ImGuiViewportP_CalcWorkRectPos = $SHBuiltin.extern_c({}, function ImGuiViewportP_CalcWorkRectPos_cwrap(_pOut: c_ptr, _self: c_ptr, _off_min: c_ptr): void { throw 0; });
+const _ImGuiViewportP_CalcWorkRectPos_flat = $SHBuiltin.extern_c({}, function ImGuiViewportP_CalcWorkRectPos_flat(_pOut: c_ptr, _self: c_ptr, _off_min_x: c_float, _off_min_y: c_float): void { throw 0; });
 const _ImGuiViewportP_CalcWorkRectSize = $SHBuiltin.extern_c({}, function ImGuiViewportP_CalcWorkRectSize_cwrap(_pOut: c_ptr, _self: c_ptr, _off_min: c_ptr, _off_max: c_ptr): void { throw 0; });
+const _ImGuiViewportP_CalcWorkRectSize_flat = $SHBuiltin.extern_c({}, function ImGuiViewportP_CalcWorkRectSize_flat(_pOut: c_ptr, _self: c_ptr, _off_min_x: c_float, _off_min_y: c_float, _off_max_x: c_float, _off_max_y: c_float): void { throw 0; });
 const _ImGuiViewportP_UpdateWorkRect = $SHBuiltin.extern_c({}, function ImGuiViewportP_UpdateWorkRect(_self: c_ptr): void { throw 0; });
 const _ImGuiViewportP_GetMainRect = $SHBuiltin.extern_c({}, function ImGuiViewportP_GetMainRect(_pOut: c_ptr, _self: c_ptr): void { throw 0; });
 const _ImGuiViewportP_GetWorkRect = $SHBuiltin.extern_c({}, function ImGuiViewportP_GetWorkRect(_pOut: c_ptr, _self: c_ptr): void { throw 0; });
@@ -900,13 +1015,17 @@ const _igIsWindowWithinBeginStackOf = $SHBuiltin.extern_c({}, function igIsWindo
 const _igIsWindowAbove = $SHBuiltin.extern_c({}, function igIsWindowAbove(_potential_above: c_ptr, _potential_below: c_ptr): c_bool { throw 0; });
 const _igIsWindowNavFocusable = $SHBuiltin.extern_c({}, function igIsWindowNavFocusable(_window: c_ptr): c_bool { throw 0; });
 const _igSetWindowPos_WindowPtr = $SHBuiltin.extern_c({}, function igSetWindowPos_WindowPtr_cwrap(_window: c_ptr, _pos: c_ptr, _cond: c_int): void { throw 0; });
+const _igSetWindowPos_WindowPtr_flat = $SHBuiltin.extern_c({}, function igSetWindowPos_WindowPtr_flat(_window: c_ptr, _pos_x: c_float, _pos_y: c_float, _cond: c_int): void { throw 0; });
 const _igSetWindowSize_WindowPtr = $SHBuiltin.extern_c({}, function igSetWindowSize_WindowPtr_cwrap(_window: c_ptr, _size: c_ptr, _cond: c_int): void { throw 0; });
+const _igSetWindowSize_WindowPtr_flat = $SHBuiltin.extern_c({}, function igSetWindowSize_WindowPtr_flat(_window: c_ptr, _size_x: c_float, _size_y: c_float, _cond: c_int): void { throw 0; });
 const _igSetWindowCollapsed_WindowPtr = $SHBuiltin.extern_c({}, function igSetWindowCollapsed_WindowPtr(_window: c_ptr, _collapsed: c_bool, _cond: c_int): void { throw 0; });
 const _igSetWindowHitTestHole = $SHBuiltin.extern_c({}, function igSetWindowHitTestHole_cwrap(_window: c_ptr, _pos: c_ptr, _size: c_ptr): void { throw 0; });
+const _igSetWindowHitTestHole_flat = $SHBuiltin.extern_c({}, function igSetWindowHitTestHole_flat(_window: c_ptr, _pos_x: c_float, _pos_y: c_float, _size_x: c_float, _size_y: c_float): void { throw 0; });
 const _igSetWindowHiddendAndSkipItemsForCurrentFrame = $SHBuiltin.extern_c({}, function igSetWindowHiddendAndSkipItemsForCurrentFrame(_window: c_ptr): void { throw 0; });
 const _igWindowRectAbsToRel = $SHBuiltin.extern_c({}, function igWindowRectAbsToRel_cwrap(_pOut: c_ptr, _window: c_ptr, _r: c_ptr): void { throw 0; });
 const _igWindowRectRelToAbs = $SHBuiltin.extern_c({}, function igWindowRectRelToAbs_cwrap(_pOut: c_ptr, _window: c_ptr, _r: c_ptr): void { throw 0; });
 const _igWindowPosRelToAbs = $SHBuiltin.extern_c({}, function igWindowPosRelToAbs_cwrap(_pOut: c_ptr, _window: c_ptr, _p: c_ptr): void { throw 0; });
+const _igWindowPosRelToAbs_flat = $SHBuiltin.extern_c({}, function igWindowPosRelToAbs_flat(_pOut: c_ptr, _window: c_ptr, _p_x: c_float, _p_y: c_float): void { throw 0; });
 const _igFocusWindow = $SHBuiltin.extern_c({}, function igFocusWindow(_window: c_ptr, _flags: c_int): void { throw 0; });
 const _igFocusTopMostWindowUnderOne = $SHBuiltin.extern_c({}, function igFocusTopMostWindowUnderOne(_under_this_window: c_ptr, _ignore_window: c_ptr, _filter_viewport: c_ptr, _flags: c_int): void { throw 0; });
 const _igBringWindowToFocusFront = $SHBuiltin.extern_c({}, function igBringWindowToFocusFront(_window: c_ptr): void { throw 0; });
@@ -967,6 +1086,7 @@ const _igPushOverrideID = $SHBuiltin.extern_c({}, function igPushOverrideID(_id:
 const _igGetIDWithSeed_Str = $SHBuiltin.extern_c({}, function igGetIDWithSeed_Str(_str_id_begin: c_ptr, _str_id_end: c_ptr, _seed: c_uint): c_uint { throw 0; });
 const _igGetIDWithSeed_Int = $SHBuiltin.extern_c({}, function igGetIDWithSeed_Int(_n: c_int, _seed: c_uint): c_uint { throw 0; });
 const _igItemSize_Vec2 = $SHBuiltin.extern_c({}, function igItemSize_Vec2_cwrap(_size: c_ptr, _text_baseline_y: c_float): void { throw 0; });
+const _igItemSize_Vec2_flat = $SHBuiltin.extern_c({}, function igItemSize_Vec2_flat(_size_x: c_float, _size_y: c_float, _text_baseline_y: c_float): void { throw 0; });
 const _igItemSize_Rect = $SHBuiltin.extern_c({}, function igItemSize_Rect_cwrap(_bb: c_ptr, _text_baseline_y: c_float): void { throw 0; });
 const _igItemAdd = $SHBuiltin.extern_c({}, function igItemAdd_cwrap(_bb: c_ptr, _id: c_uint, _nav_bb: c_ptr, _extra_flags: c_int): c_bool { throw 0; });
 const _igItemHoverable = $SHBuiltin.extern_c({}, function igItemHoverable_cwrap(_bb: c_ptr, _id: c_uint, _item_flags: c_int): c_bool { throw 0; });
@@ -974,7 +1094,9 @@ const _igIsWindowContentHoverable = $SHBuiltin.extern_c({}, function igIsWindowC
 const _igIsClippedEx = $SHBuiltin.extern_c({}, function igIsClippedEx_cwrap(_bb: c_ptr, _id: c_uint): c_bool { throw 0; });
 const _igSetLastItemData = $SHBuiltin.extern_c({}, function igSetLastItemData_cwrap(_item_id: c_uint, _in_flags: c_int, _status_flags: c_int, _item_rect: c_ptr): void { throw 0; });
 const _igCalcItemSize = $SHBuiltin.extern_c({}, function igCalcItemSize_cwrap(_pOut: c_ptr, _size: c_ptr, _default_w: c_float, _default_h: c_float): void { throw 0; });
+const _igCalcItemSize_flat = $SHBuiltin.extern_c({}, function igCalcItemSize_flat(_pOut: c_ptr, _size_x: c_float, _size_y: c_float, _default_w: c_float, _default_h: c_float): void { throw 0; });
 const _igCalcWrapWidthForPos = $SHBuiltin.extern_c({}, function igCalcWrapWidthForPos_cwrap(_pos: c_ptr, _wrap_pos_x: c_float): c_float { throw 0; });
+const _igCalcWrapWidthForPos_flat = $SHBuiltin.extern_c({}, function igCalcWrapWidthForPos_flat(_pos_x: c_float, _pos_y: c_float, _wrap_pos_x: c_float): c_float { throw 0; });
 const _igPushMultiItemsWidths = $SHBuiltin.extern_c({}, function igPushMultiItemsWidths(_components: c_int, _width_full: c_float): void { throw 0; });
 const _igIsItemToggledSelection = $SHBuiltin.extern_c({}, function igIsItemToggledSelection(): c_bool { throw 0; });
 const _igGetContentRegionMaxAbs = $SHBuiltin.extern_c({}, function igGetContentRegionMaxAbs(_pOut: c_ptr): void { throw 0; });
@@ -987,6 +1109,7 @@ const _igLogToBuffer = $SHBuiltin.extern_c({}, function igLogToBuffer(_auto_open
 const _igLogRenderedText = $SHBuiltin.extern_c({}, function igLogRenderedText(_ref_pos: c_ptr, _text: c_ptr, _text_end: c_ptr): void { throw 0; });
 const _igLogSetNextTextDecoration = $SHBuiltin.extern_c({}, function igLogSetNextTextDecoration(_prefix: c_ptr, _suffix: c_ptr): void { throw 0; });
 const _igBeginChildEx = $SHBuiltin.extern_c({}, function igBeginChildEx_cwrap(_name: c_ptr, _id: c_uint, _size_arg: c_ptr, _border: c_bool, _flags: c_int): c_bool { throw 0; });
+const _igBeginChildEx_flat = $SHBuiltin.extern_c({}, function igBeginChildEx_flat(_name: c_ptr, _id: c_uint, _size_arg_x: c_float, _size_arg_y: c_float, _border: c_bool, _flags: c_int): c_bool { throw 0; });
 const _igOpenPopupEx = $SHBuiltin.extern_c({}, function igOpenPopupEx(_id: c_uint, _popup_flags: c_int): void { throw 0; });
 const _igClosePopupToLevel = $SHBuiltin.extern_c({}, function igClosePopupToLevel(_remaining: c_int, _restore_focus_to_window_under_popup: c_bool): void { throw 0; });
 const _igClosePopupsOverWindow = $SHBuiltin.extern_c({}, function igClosePopupsOverWindow(_ref_window: c_ptr, _restore_focus_to_window_under_popup: c_bool): void { throw 0; });
@@ -1000,6 +1123,7 @@ const _igGetTopMostAndVisiblePopupModal = $SHBuiltin.extern_c({}, function igGet
 const _igFindBlockingModal = $SHBuiltin.extern_c({}, function igFindBlockingModal(_window: c_ptr): c_ptr { throw 0; });
 const _igFindBestWindowPosForPopup = $SHBuiltin.extern_c({}, function igFindBestWindowPosForPopup(_pOut: c_ptr, _window: c_ptr): void { throw 0; });
 const _igFindBestWindowPosForPopupEx = $SHBuiltin.extern_c({}, function igFindBestWindowPosForPopupEx_cwrap(_pOut: c_ptr, _ref_pos: c_ptr, _size: c_ptr, _last_dir: c_ptr, _r_outer: c_ptr, _r_avoid: c_ptr, _policy: c_int): void { throw 0; });
+const _igFindBestWindowPosForPopupEx_flat = $SHBuiltin.extern_c({}, function igFindBestWindowPosForPopupEx_flat(_pOut: c_ptr, _ref_pos_x: c_float, _ref_pos_y: c_float, _size_x: c_float, _size_y: c_float, _last_dir: c_ptr, _r_outer: c_ptr, _r_avoid: c_ptr, _policy: c_int): void { throw 0; });
 const _igBeginViewportSideBar = $SHBuiltin.extern_c({}, function igBeginViewportSideBar(_name: c_ptr, _viewport: c_ptr, _dir: c_int, _size: c_float, _window_flags: c_int): c_bool { throw 0; });
 const _igBeginMenuEx = $SHBuiltin.extern_c({}, function igBeginMenuEx(_label: c_ptr, _icon: c_ptr, _enabled: c_bool): c_bool { throw 0; });
 const _igMenuItemEx = $SHBuiltin.extern_c({}, function igMenuItemEx(_label: c_ptr, _icon: c_ptr, _shortcut: c_ptr, _selected: c_bool, _enabled: c_bool): c_bool { throw 0; });
@@ -1087,6 +1211,7 @@ const _igTablePopBackgroundChannel = $SHBuiltin.extern_c({}, function igTablePop
 const _igGetCurrentTable = $SHBuiltin.extern_c({}, function igGetCurrentTable(): c_ptr { throw 0; });
 const _igTableFindByID = $SHBuiltin.extern_c({}, function igTableFindByID(_id: c_uint): c_ptr { throw 0; });
 const _igBeginTableEx = $SHBuiltin.extern_c({}, function igBeginTableEx_cwrap(_name: c_ptr, _id: c_uint, _columns_count: c_int, _flags: c_int, _outer_size: c_ptr, _inner_width: c_float): c_bool { throw 0; });
+const _igBeginTableEx_flat = $SHBuiltin.extern_c({}, function igBeginTableEx_flat(_name: c_ptr, _id: c_uint, _columns_count: c_int, _flags: c_int, _outer_size_x: c_float, _outer_size_y: c_float, _inner_width: c_float): c_bool { throw 0; });
 const _igTableBeginInitMemory = $SHBuiltin.extern_c({}, function igTableBeginInitMemory(_table: c_ptr, _columns_count: c_int): void { throw 0; });
 const _igTableBeginApplyRequests = $SHBuiltin.extern_c({}, function igTableBeginApplyRequests(_table: c_ptr): void { throw 0; });
 const _igTableSetupDrawChannels = $SHBuiltin.extern_c({}, function igTableSetupDrawChannels(_table: c_ptr): void { throw 0; });
@@ -1137,39 +1262,59 @@ const _igTabBarCloseTab = $SHBuiltin.extern_c({}, function igTabBarCloseTab(_tab
 const _igTabBarQueueFocus = $SHBuiltin.extern_c({}, function igTabBarQueueFocus(_tab_bar: c_ptr, _tab: c_ptr): void { throw 0; });
 const _igTabBarQueueReorder = $SHBuiltin.extern_c({}, function igTabBarQueueReorder(_tab_bar: c_ptr, _tab: c_ptr, _offset: c_int): void { throw 0; });
 const _igTabBarQueueReorderFromMousePos = $SHBuiltin.extern_c({}, function igTabBarQueueReorderFromMousePos_cwrap(_tab_bar: c_ptr, _tab: c_ptr, _mouse_pos: c_ptr): void { throw 0; });
+const _igTabBarQueueReorderFromMousePos_flat = $SHBuiltin.extern_c({}, function igTabBarQueueReorderFromMousePos_flat(_tab_bar: c_ptr, _tab: c_ptr, _mouse_pos_x: c_float, _mouse_pos_y: c_float): void { throw 0; });
 const _igTabBarProcessReorder = $SHBuiltin.extern_c({}, function igTabBarProcessReorder(_tab_bar: c_ptr): c_bool { throw 0; });
 const _igTabItemEx = $SHBuiltin.extern_c({}, function igTabItemEx(_tab_bar: c_ptr, _label: c_ptr, _p_open: c_ptr, _flags: c_int, _docked_window: c_ptr): c_bool { throw 0; });
 const _igTabItemCalcSize_Str = $SHBuiltin.extern_c({}, function igTabItemCalcSize_Str(_pOut: c_ptr, _label: c_ptr, _has_close_button_or_unsaved_marker: c_bool): void { throw 0; });
 const _igTabItemCalcSize_WindowPtr = $SHBuiltin.extern_c({}, function igTabItemCalcSize_WindowPtr(_pOut: c_ptr, _window: c_ptr): void { throw 0; });
 const _igTabItemBackground = $SHBuiltin.extern_c({}, function igTabItemBackground_cwrap(_draw_list: c_ptr, _bb: c_ptr, _flags: c_int, _col: c_uint): void { throw 0; });
 const _igTabItemLabelAndCloseButton = $SHBuiltin.extern_c({}, function igTabItemLabelAndCloseButton_cwrap(_draw_list: c_ptr, _bb: c_ptr, _flags: c_int, _frame_padding: c_ptr, _label: c_ptr, _tab_id: c_uint, _close_button_id: c_uint, _is_contents_visible: c_bool, _out_just_closed: c_ptr, _out_text_clipped: c_ptr): void { throw 0; });
+const _igTabItemLabelAndCloseButton_flat = $SHBuiltin.extern_c({}, function igTabItemLabelAndCloseButton_flat(_draw_list: c_ptr, _bb: c_ptr, _flags: c_int, _frame_padding_x: c_float, _frame_padding_y: c_float, _label: c_ptr, _tab_id: c_uint, _close_button_id: c_uint, _is_contents_visible: c_bool, _out_just_closed: c_ptr, _out_text_clipped: c_ptr): void { throw 0; });
 const _igRenderText = $SHBuiltin.extern_c({}, function igRenderText_cwrap(_pos: c_ptr, _text: c_ptr, _text_end: c_ptr, _hide_text_after_hash: c_bool): void { throw 0; });
+const _igRenderText_flat = $SHBuiltin.extern_c({}, function igRenderText_flat(_pos_x: c_float, _pos_y: c_float, _text: c_ptr, _text_end: c_ptr, _hide_text_after_hash: c_bool): void { throw 0; });
 const _igRenderTextWrapped = $SHBuiltin.extern_c({}, function igRenderTextWrapped_cwrap(_pos: c_ptr, _text: c_ptr, _text_end: c_ptr, _wrap_width: c_float): void { throw 0; });
+const _igRenderTextWrapped_flat = $SHBuiltin.extern_c({}, function igRenderTextWrapped_flat(_pos_x: c_float, _pos_y: c_float, _text: c_ptr, _text_end: c_ptr, _wrap_width: c_float): void { throw 0; });
 const _igRenderTextClipped = $SHBuiltin.extern_c({}, function igRenderTextClipped_cwrap(_pos_min: c_ptr, _pos_max: c_ptr, _text: c_ptr, _text_end: c_ptr, _text_size_if_known: c_ptr, _align: c_ptr, _clip_rect: c_ptr): void { throw 0; });
+const _igRenderTextClipped_flat = $SHBuiltin.extern_c({}, function igRenderTextClipped_flat(_pos_min_x: c_float, _pos_min_y: c_float, _pos_max_x: c_float, _pos_max_y: c_float, _text: c_ptr, _text_end: c_ptr, _text_size_if_known: c_ptr, _align_x: c_float, _align_y: c_float, _clip_rect: c_ptr): void { throw 0; });
 const _igRenderTextClippedEx = $SHBuiltin.extern_c({}, function igRenderTextClippedEx_cwrap(_draw_list: c_ptr, _pos_min: c_ptr, _pos_max: c_ptr, _text: c_ptr, _text_end: c_ptr, _text_size_if_known: c_ptr, _align: c_ptr, _clip_rect: c_ptr): void { throw 0; });
+const _igRenderTextClippedEx_flat = $SHBuiltin.extern_c({}, function igRenderTextClippedEx_flat(_draw_list: c_ptr, _pos_min_x: c_float, _pos_min_y: c_float, _pos_max_x: c_float, _pos_max_y: c_float, _text: c_ptr, _text_end: c_ptr, _text_size_if_known: c_ptr, _align_x: c_float, _align_y: c_float, _clip_rect: c_ptr): void { throw 0; });
 const _igRenderTextEllipsis = $SHBuiltin.extern_c({}, function igRenderTextEllipsis_cwrap(_draw_list: c_ptr, _pos_min: c_ptr, _pos_max: c_ptr, _clip_max_x: c_float, _ellipsis_max_x: c_float, _text: c_ptr, _text_end: c_ptr, _text_size_if_known: c_ptr): void { throw 0; });
+const _igRenderTextEllipsis_flat = $SHBuiltin.extern_c({}, function igRenderTextEllipsis_flat(_draw_list: c_ptr, _pos_min_x: c_float, _pos_min_y: c_float, _pos_max_x: c_float, _pos_max_y: c_float, _clip_max_x: c_float, _ellipsis_max_x: c_float, _text: c_ptr, _text_end: c_ptr, _text_size_if_known: c_ptr): void { throw 0; });
 const _igRenderFrame = $SHBuiltin.extern_c({}, function igRenderFrame_cwrap(_p_min: c_ptr, _p_max: c_ptr, _fill_col: c_uint, _border: c_bool, _rounding: c_float): void { throw 0; });
+const _igRenderFrame_flat = $SHBuiltin.extern_c({}, function igRenderFrame_flat(_p_min_x: c_float, _p_min_y: c_float, _p_max_x: c_float, _p_max_y: c_float, _fill_col: c_uint, _border: c_bool, _rounding: c_float): void { throw 0; });
 const _igRenderFrameBorder = $SHBuiltin.extern_c({}, function igRenderFrameBorder_cwrap(_p_min: c_ptr, _p_max: c_ptr, _rounding: c_float): void { throw 0; });
+const _igRenderFrameBorder_flat = $SHBuiltin.extern_c({}, function igRenderFrameBorder_flat(_p_min_x: c_float, _p_min_y: c_float, _p_max_x: c_float, _p_max_y: c_float, _rounding: c_float): void { throw 0; });
 const _igRenderColorRectWithAlphaCheckerboard = $SHBuiltin.extern_c({}, function igRenderColorRectWithAlphaCheckerboard_cwrap(_draw_list: c_ptr, _p_min: c_ptr, _p_max: c_ptr, _fill_col: c_uint, _grid_step: c_float, _grid_off: c_ptr, _rounding: c_float, _flags: c_int): void { throw 0; });
+const _igRenderColorRectWithAlphaCheckerboard_flat = $SHBuiltin.extern_c({}, function igRenderColorRectWithAlphaCheckerboard_flat(_draw_list: c_ptr, _p_min_x: c_float, _p_min_y: c_float, _p_max_x: c_float, _p_max_y: c_float, _fill_col: c_uint, _grid_step: c_float, _grid_off_x: c_float, _grid_off_y: c_float, _rounding: c_float, _flags: c_int): void { throw 0; });
 const _igRenderNavHighlight = $SHBuiltin.extern_c({}, function igRenderNavHighlight_cwrap(_bb: c_ptr, _id: c_uint, _flags: c_int): void { throw 0; });
 const _igFindRenderedTextEnd = $SHBuiltin.extern_c({}, function igFindRenderedTextEnd(_text: c_ptr, _text_end: c_ptr): c_ptr { throw 0; });
 const _igRenderMouseCursor = $SHBuiltin.extern_c({}, function igRenderMouseCursor_cwrap(_pos: c_ptr, _scale: c_float, _mouse_cursor: c_int, _col_fill: c_uint, _col_border: c_uint, _col_shadow: c_uint): void { throw 0; });
+const _igRenderMouseCursor_flat = $SHBuiltin.extern_c({}, function igRenderMouseCursor_flat(_pos_x: c_float, _pos_y: c_float, _scale: c_float, _mouse_cursor: c_int, _col_fill: c_uint, _col_border: c_uint, _col_shadow: c_uint): void { throw 0; });
 const _igRenderArrow = $SHBuiltin.extern_c({}, function igRenderArrow_cwrap(_draw_list: c_ptr, _pos: c_ptr, _col: c_uint, _dir: c_int, _scale: c_float): void { throw 0; });
+const _igRenderArrow_flat = $SHBuiltin.extern_c({}, function igRenderArrow_flat(_draw_list: c_ptr, _pos_x: c_float, _pos_y: c_float, _col: c_uint, _dir: c_int, _scale: c_float): void { throw 0; });
 const _igRenderBullet = $SHBuiltin.extern_c({}, function igRenderBullet_cwrap(_draw_list: c_ptr, _pos: c_ptr, _col: c_uint): void { throw 0; });
+const _igRenderBullet_flat = $SHBuiltin.extern_c({}, function igRenderBullet_flat(_draw_list: c_ptr, _pos_x: c_float, _pos_y: c_float, _col: c_uint): void { throw 0; });
 const _igRenderCheckMark = $SHBuiltin.extern_c({}, function igRenderCheckMark_cwrap(_draw_list: c_ptr, _pos: c_ptr, _col: c_uint, _sz: c_float): void { throw 0; });
+const _igRenderCheckMark_flat = $SHBuiltin.extern_c({}, function igRenderCheckMark_flat(_draw_list: c_ptr, _pos_x: c_float, _pos_y: c_float, _col: c_uint, _sz: c_float): void { throw 0; });
 const _igRenderArrowPointingAt = $SHBuiltin.extern_c({}, function igRenderArrowPointingAt_cwrap(_draw_list: c_ptr, _pos: c_ptr, _half_sz: c_ptr, _direction: c_int, _col: c_uint): void { throw 0; });
+const _igRenderArrowPointingAt_flat = $SHBuiltin.extern_c({}, function igRenderArrowPointingAt_flat(_draw_list: c_ptr, _pos_x: c_float, _pos_y: c_float, _half_sz_x: c_float, _half_sz_y: c_float, _direction: c_int, _col: c_uint): void { throw 0; });
 const _igRenderRectFilledRangeH = $SHBuiltin.extern_c({}, function igRenderRectFilledRangeH_cwrap(_draw_list: c_ptr, _rect: c_ptr, _col: c_uint, _x_start_norm: c_float, _x_end_norm: c_float, _rounding: c_float): void { throw 0; });
 const _igRenderRectFilledWithHole = $SHBuiltin.extern_c({}, function igRenderRectFilledWithHole_cwrap(_draw_list: c_ptr, _outer: c_ptr, _inner: c_ptr, _col: c_uint, _rounding: c_float): void { throw 0; });
 const _igTextEx = $SHBuiltin.extern_c({}, function igTextEx(_text: c_ptr, _text_end: c_ptr, _flags: c_int): void { throw 0; });
 const _igButtonEx = $SHBuiltin.extern_c({}, function igButtonEx_cwrap(_label: c_ptr, _size_arg: c_ptr, _flags: c_int): c_bool { throw 0; });
+const _igButtonEx_flat = $SHBuiltin.extern_c({}, function igButtonEx_flat(_label: c_ptr, _size_arg_x: c_float, _size_arg_y: c_float, _flags: c_int): c_bool { throw 0; });
 const _igArrowButtonEx = $SHBuiltin.extern_c({}, function igArrowButtonEx_cwrap(_str_id: c_ptr, _dir: c_int, _size_arg: c_ptr, _flags: c_int): c_bool { throw 0; });
+const _igArrowButtonEx_flat = $SHBuiltin.extern_c({}, function igArrowButtonEx_flat(_str_id: c_ptr, _dir: c_int, _size_arg_x: c_float, _size_arg_y: c_float, _flags: c_int): c_bool { throw 0; });
 const _igImageButtonEx = $SHBuiltin.extern_c({}, function igImageButtonEx_cwrap(_id: c_uint, _texture_id: c_ptr, _size: c_ptr, _uv0: c_ptr, _uv1: c_ptr, _bg_col: c_ptr, _tint_col: c_ptr, _flags: c_int): c_bool { throw 0; });
+const _igImageButtonEx_flat = $SHBuiltin.extern_c({}, function igImageButtonEx_flat(_id: c_uint, _texture_id: c_ptr, _size_x: c_float, _size_y: c_float, _uv0_x: c_float, _uv0_y: c_float, _uv1_x: c_float, _uv1_y: c_float, _bg_col_x: c_float, _bg_col_y: c_float, _bg_col_z: c_float, _bg_col_w: c_float, _tint_col_x: c_float, _tint_col_y: c_float, _tint_col_z: c_float, _tint_col_w: c_float, _flags: c_int): c_bool { throw 0; });
 const _igSeparatorEx = $SHBuiltin.extern_c({}, function igSeparatorEx(_flags: c_int, _thickness: c_float): void { throw 0; });
 const _igSeparatorTextEx = $SHBuiltin.extern_c({}, function igSeparatorTextEx(_id: c_uint, _label: c_ptr, _label_end: c_ptr, _extra_width: c_float): void { throw 0; });
 const _igCheckboxFlags_S64Ptr = $SHBuiltin.extern_c({}, function igCheckboxFlags_S64Ptr(_label: c_ptr, _flags: c_ptr, _flags_value: c_longlong): c_bool { throw 0; });
 const _igCheckboxFlags_U64Ptr = $SHBuiltin.extern_c({}, function igCheckboxFlags_U64Ptr(_label: c_ptr, _flags: c_ptr, _flags_value: c_ulonglong): c_bool { throw 0; });
 const _igCloseButton = $SHBuiltin.extern_c({}, function igCloseButton_cwrap(_id: c_uint, _pos: c_ptr): c_bool { throw 0; });
+const _igCloseButton_flat = $SHBuiltin.extern_c({}, function igCloseButton_flat(_id: c_uint, _pos_x: c_float, _pos_y: c_float): c_bool { throw 0; });
 const _igCollapseButton = $SHBuiltin.extern_c({}, function igCollapseButton_cwrap(_id: c_uint, _pos: c_ptr): c_bool { throw 0; });
+const _igCollapseButton_flat = $SHBuiltin.extern_c({}, function igCollapseButton_flat(_id: c_uint, _pos_x: c_float, _pos_y: c_float): c_bool { throw 0; });
 const _igScrollbar = $SHBuiltin.extern_c({}, function igScrollbar(_axis: c_int): void { throw 0; });
 const _igScrollbarEx = $SHBuiltin.extern_c({}, function igScrollbarEx_cwrap(_bb: c_ptr, _id: c_uint, _axis: c_int, _p_scroll_v: c_ptr, _avail_v: c_longlong, _contents_v: c_longlong, _flags: c_int): c_bool { throw 0; });
 const _igGetWindowScrollbarRect = $SHBuiltin.extern_c({}, function igGetWindowScrollbarRect(_pOut: c_ptr, _window: c_ptr, _axis: c_int): void { throw 0; });
@@ -1191,6 +1336,7 @@ const _igDataTypeApplyFromText = $SHBuiltin.extern_c({}, function igDataTypeAppl
 const _igDataTypeCompare = $SHBuiltin.extern_c({}, function igDataTypeCompare(_data_type: c_int, _arg_1: c_ptr, _arg_2: c_ptr): c_int { throw 0; });
 const _igDataTypeClamp = $SHBuiltin.extern_c({}, function igDataTypeClamp(_data_type: c_int, _p_data: c_ptr, _p_min: c_ptr, _p_max: c_ptr): c_bool { throw 0; });
 const _igInputTextEx = $SHBuiltin.extern_c({}, function igInputTextEx_cwrap(_label: c_ptr, _hint: c_ptr, _buf: c_ptr, _buf_size: c_int, _size_arg: c_ptr, _flags: c_int, _callback: c_ptr, _user_data: c_ptr): c_bool { throw 0; });
+const _igInputTextEx_flat = $SHBuiltin.extern_c({}, function igInputTextEx_flat(_label: c_ptr, _hint: c_ptr, _buf: c_ptr, _buf_size: c_int, _size_arg_x: c_float, _size_arg_y: c_float, _flags: c_int, _callback: c_ptr, _user_data: c_ptr): c_bool { throw 0; });
 const _igInputTextDeactivateHook = $SHBuiltin.extern_c({}, function igInputTextDeactivateHook(_id: c_uint): void { throw 0; });
 const _igTempInputText = $SHBuiltin.extern_c({}, function igTempInputText_cwrap(_bb: c_ptr, _id: c_uint, _label: c_ptr, _buf: c_ptr, _buf_size: c_int, _flags: c_int): c_bool { throw 0; });
 const _igTempInputScalar = $SHBuiltin.extern_c({}, function igTempInputScalar_cwrap(_bb: c_ptr, _id: c_uint, _label: c_ptr, _data_type: c_int, _p_data: c_ptr, _format: c_ptr, _p_clamp_min: c_ptr, _p_clamp_max: c_ptr): c_bool { throw 0; });
@@ -1200,8 +1346,11 @@ const _igColorTooltip = $SHBuiltin.extern_c({}, function igColorTooltip(_text: c
 const _igColorEditOptionsPopup = $SHBuiltin.extern_c({}, function igColorEditOptionsPopup(_col: c_ptr, _flags: c_int): void { throw 0; });
 const _igColorPickerOptionsPopup = $SHBuiltin.extern_c({}, function igColorPickerOptionsPopup(_ref_col: c_ptr, _flags: c_int): void { throw 0; });
 const _igPlotEx = $SHBuiltin.extern_c({}, function igPlotEx_cwrap(_plot_type: c_int, _label: c_ptr, _values_getter: c_ptr, _data: c_ptr, _values_count: c_int, _values_offset: c_int, _overlay_text: c_ptr, _scale_min: c_float, _scale_max: c_float, _size_arg: c_ptr): c_int { throw 0; });
+const _igPlotEx_flat = $SHBuiltin.extern_c({}, function igPlotEx_flat(_plot_type: c_int, _label: c_ptr, _values_getter: c_ptr, _data: c_ptr, _values_count: c_int, _values_offset: c_int, _overlay_text: c_ptr, _scale_min: c_float, _scale_max: c_float, _size_arg_x: c_float, _size_arg_y: c_float): c_int { throw 0; });
 const _igShadeVertsLinearColorGradientKeepAlpha = $SHBuiltin.extern_c({}, function igShadeVertsLinearColorGradientKeepAlpha_cwrap(_draw_list: c_ptr, _vert_start_idx: c_int, _vert_end_idx: c_int, _gradient_p0: c_ptr, _gradient_p1: c_ptr, _col0: c_uint, _col1: c_uint): void { throw 0; });
+const _igShadeVertsLinearColorGradientKeepAlpha_flat = $SHBuiltin.extern_c({}, function igShadeVertsLinearColorGradientKeepAlpha_flat(_draw_list: c_ptr, _vert_start_idx: c_int, _vert_end_idx: c_int, _gradient_p0_x: c_float, _gradient_p0_y: c_float, _gradient_p1_x: c_float, _gradient_p1_y: c_float, _col0: c_uint, _col1: c_uint): void { throw 0; });
 const _igShadeVertsLinearUV = $SHBuiltin.extern_c({}, function igShadeVertsLinearUV_cwrap(_draw_list: c_ptr, _vert_start_idx: c_int, _vert_end_idx: c_int, _a: c_ptr, _b: c_ptr, _uv_a: c_ptr, _uv_b: c_ptr, _clamp: c_bool): void { throw 0; });
+const _igShadeVertsLinearUV_flat = $SHBuiltin.extern_c({}, function igShadeVertsLinearUV_flat(_draw_list: c_ptr, _vert_start_idx: c_int, _vert_end_idx: c_int, _a_x: c_float, _a_y: c_float, _b_x: c_float, _b_y: c_float, _uv_a_x: c_float, _uv_a_y: c_float, _uv_b_x: c_float, _uv_b_y: c_float, _clamp: c_bool): void { throw 0; });
 const _igGcCompactTransientMiscBuffers = $SHBuiltin.extern_c({}, function igGcCompactTransientMiscBuffers(): void { throw 0; });
 const _igGcCompactTransientWindowBuffers = $SHBuiltin.extern_c({}, function igGcCompactTransientWindowBuffers(_window: c_ptr): void { throw 0; });
 const _igGcAwakeTransientWindowBuffers = $SHBuiltin.extern_c({}, function igGcAwakeTransientWindowBuffers(_window: c_ptr): void { throw 0; });
@@ -8,330 +8,657 @@
 bool igBeginChild_Str_cwrap(char* a0, struct ImVec2* a1, bool a2, int a3){
   return igBeginChild_Str(a0, *a1, a2, a3);
 }
+bool igBeginChild_Str_flat(char* a0, float a1_x, float a1_y, bool a2, int a3){
+  return igBeginChild_Str(a0, (struct ImVec2){a1_x, a1_y}, a2, a3);
+}
 bool igBeginChild_ID_cwrap(unsigned int a0, struct ImVec2* a1, bool a2, int a3){
   return igBeginChild_ID(a0, *a1, a2, a3);
 }
+bool igBeginChild_ID_flat(unsigned int a0, float a1_x, float a1_y, bool a2, int a3){
+  return igBeginChild_ID(a0, (struct ImVec2){a1_x, a1_y}, a2, a3);
+}
 void igSetNextWindowPos_cwrap(struct ImVec2* a0, int a1, struct ImVec2* a2){
   return igSetNextWindowPos(*a0, a1, *a2);
 }
+void igSetNextWindowPos_flat(float a0_x, float a0_y, int a1, float a2_x, float a2_y){
+  return igSetNextWindowPos((struct ImVec2){a0_x, a0_y}, a1, (struct ImVec2){a2_x, a2_y});
+}
 void igSetNextWindowSize_cwrap(struct ImVec2* a0, int a1){
   return igSetNextWindowSize(*a0, a1);
 }
+void igSetNextWindowSize_flat(float a0_x, float a0_y, int a1){
+  return igSetNextWindowSize((struct ImVec2){a0_x, a0_y}, a1);
+}
 void igSetNextWindowSizeConstraints_cwrap(struct ImVec2* a0, struct ImVec2* a1, void* a2, void* a3){
   return igSetNextWindowSizeConstraints(*a0, *a1, a2, a3);
 }
+void igSetNextWindowSizeConstraints_flat(float a0_x, float a0_y, float a1_x, float a1_y, void* a2, void* a3){
+  return igSetNextWindowSizeConstraints((struct ImVec2){a0_x, a0_y}, (struct ImVec2){a1_x, a1_y}, a2, a3);
+}
 void igSetNextWindowContentSize_cwrap(struct ImVec2* a0){
   return igSetNextWindowContentSize(*a0);
 }
+void igSetNextWindowContentSize_flat(float a0_x, float a0_y){
+  return igSetNextWindowContentSize((struct ImVec2){a0_x, a0_y});
+}
 void igSetNextWindowScroll_cwrap(struct ImVec2* a0){
   return igSetNextWindowScroll(*a0);
 }
+void igSetNextWindowScroll_flat(float a0_x, float a0_y){
+  return igSetNextWindowScroll((struct ImVec2){a0_x, a0_y});
+}
 void igSetWindowPos_Vec2_cwrap(struct ImVec2* a0, int a1){
   return igSetWindowPos_Vec2(*a0, a1);
 }
+void igSetWindowPos_Vec2_flat(float a0_x, float a0_y, int a1){
+  return igSetWindowPos_Vec2((struct ImVec2){a0_x, a0_y}, a1);
+}
 void igSetWindowSize_Vec2_cwrap(struct ImVec2* a0, int a1){
   return igSetWindowSize_Vec2(*a0, a1);
 }
+void igSetWindowSize_Vec2_flat(float a0_x, float a0_y, int a1){
+  return igSetWindowSize_Vec2((struct ImVec2){a0_x, a0_y}, a1);
+}
 void igSetWindowPos_Str_cwrap(char* a0, struct ImVec2* a1, int a2){
   return igSetWindowPos_Str(a0, *a1, a2);
 }
+void igSetWindowPos_Str_flat(char* a0, float a1_x, float a1_y, int a2){
+  return igSetWindowPos_Str(a0, (struct ImVec2){a1_x, a1_y}, a2);
+}
 void igSetWindowSize_Str_cwrap(char* a0, struct ImVec2* a1, int a2){
   return igSetWindowSize_Str(a0, *a1, a2);
 }
+void igSetWindowSize_Str_flat(char* a0, float a1_x, float a1_y, int a2){
+  return igSetWindowSize_Str(a0, (struct ImVec2){a1_x, a1_y}, a2);
+}
 void igPushStyleColor_Vec4_cwrap(int a0, struct ImVec4* a1){
   return igPushStyleColor_Vec4(a0, *a1);
 }
+void igPushStyleColor_Vec4_flat(int a0, float a1_x, float a1_y, float a1_z, float a1_w){
+  return igPushStyleColor_Vec4(a0, (struct ImVec4){a1_x, a1_y, a1_z, a1_w});
+}
 void igPushStyleVar_Vec2_cwrap(int a0, struct ImVec2* a1){
   return igPushStyleVar_Vec2(a0, *a1);
 }
+void igPushStyleVar_Vec2_flat(int a0, float a1_x, float a1_y){
+  return igPushStyleVar_Vec2(a0, (struct ImVec2){a1_x, a1_y});
+}
 unsigned int igGetColorU32_Vec4_cwrap(struct ImVec4* a0){
   return igGetColorU32_Vec4(*a0);
 }
+unsigned int igGetColorU32_Vec4_flat(float a0_x, float a0_y, float a0_z, float a0_w){
+  return igGetColorU32_Vec4((struct ImVec4){a0_x, a0_y, a0_z, a0_w});
+}
 void igDummy_cwrap(struct ImVec2* a0){
   return igDummy(*a0);
 }
+void igDummy_flat(float a0_x, float a0_y){
+  return igDummy((struct ImVec2){a0_x, a0_y});
+}
 void igSetCursorPos_cwrap(struct ImVec2* a0){
   return igSetCursorPos(*a0);
 }
+void igSetCursorPos_flat(float a0_x, float a0_y){
+  return igSetCursorPos((struct ImVec2){a0_x, a0_y});
+}
 void igSetCursorScreenPos_cwrap(struct ImVec2* a0){
   return igSetCursorScreenPos(*a0);
 }
+void igSetCursorScreenPos_flat(float a0_x, float a0_y){
+  return igSetCursorScreenPos((struct ImVec2){a0_x, a0_y});
+}
 void igTextColored_cwrap(struct ImVec4* a0, char* a1){
   return igTextColored(*a0, a1);
 }
+void igTextColored_flat(float a0_x, float a0_y, float a0_z, float a0_w, char* a1){
+  return igTextColored((struct ImVec4){a0_x, a0_y, a0_z, a0_w}, a1);
+}
 void igTextColoredV_cwrap(struct ImVec4* a0, char* a1, char* a2){
   return igTextColoredV(*a0, a1, a2);
 }
+void igTextColoredV_flat(float a0_x, float a0_y, float a0_z, float a0_w, char* a1, char* a2){
+  return igTextColoredV((struct ImVec4){a0_x, a0_y, a0_z, a0_w}, a1, a2);
+}
 bool igButton_cwrap(char* a0, struct ImVec2* a1){
   return igButton(a0, *a1);
 }
+bool igButton_flat(char* a0, float a1_x, float a1_y){
+  return igButton(a0, (struct ImVec2){a1_x, a1_y});
+}
 bool igInvisibleButton_cwrap(char* a0, struct ImVec2* a1, int a2){
   return igInvisibleButton(a0, *a1, a2);
 }
+bool igInvisibleButton_flat(char* a0, float a1_x, float a1_y, int a2){
+  return igInvisibleButton(a0, (struct ImVec2){a1_x, a1_y}, a2);
+}
 void igProgressBar_cwrap(float a0, struct ImVec2* a1, char* a2){
   return igProgressBar(a0, *a1, a2);
 }
+void igProgressBar_flat(float a0, float a1_x, float a1_y, char* a2){
+  return igProgressBar(a0, (struct ImVec2){a1_x, a1_y}, a2);
+}
 void igImage_cwrap(void* a0, struct ImVec2* a1, struct ImVec2* a2, struct ImVec2* a3, struct ImVec4* a4, struct ImVec4* a5){
   return igImage(a0, *a1, *a2, *a3, *a4, *a5);
 }
+void igImage_flat(void* a0, float a1_x, float a1_y, float a2_x, float a2_y, float a3_x, float a3_y, float a4_x, float a4_y, float a4_z, float a4_w, float a5_x, float a5_y, float a5_z, float a5_w){
+  return igImage(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y}, (struct ImVec4){a4_x, a4_y, a4_z, a4_w}, (struct ImVec4){a5_x, a5_y, a5_z, a5_w});
+}
 bool igImageButton_cwrap(char* a0, void* a1, struct ImVec2* a2, struct ImVec2* a3, struct ImVec2* a4, struct ImVec4* a5, struct ImVec4* a6){
   return igImageButton(a0, a1, *a2, *a3, *a4, *a5, *a6);
 }
+bool igImageButton_flat(char* a0, void* a1, float a2_x, float a2_y, float a3_x, float a3_y, float a4_x, float a4_y, float a5_x, float a5_y, float a5_z, float a5_w, float a6_x, float a6_y, float a6_z, float a6_w){
+  return igImageButton(a0, a1, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y}, (struct ImVec2){a4_x, a4_y}, (struct ImVec4){a5_x, a5_y, a5_z, a5_w}, (struct ImVec4){a6_x, a6_y, a6_z, a6_w});
+}
 bool igVSliderFloat_cwrap(char* a0, struct ImVec2* a1, float* a2, float a3, float a4, char* a5, int a6){
   return igVSliderFloat(a0, *a1, a2, a3, a4, a5, a6);
 }
+bool igVSliderFloat_flat(char* a0, float a1_x, float a1_y, float* a2, float a3, float a4, char* a5, int a6){
+  return igVSliderFloat(a0, (struct ImVec2){a1_x, a1_y}, a2, a3, a4, a5, a6);
+}
 bool igVSliderInt_cwrap(char* a0, struct ImVec2* a1, int* a2, int a3, int a4, char* a5, int a6){
   return igVSliderInt(a0, *a1, a2, a3, a4, a5, a6);
 }
+bool igVSliderInt_flat(char* a0, float a1_x, float a1_y, int* a2, int a3, int a4, char* a5, int a6){
+  return igVSliderInt(a0, (struct ImVec2){a1_x, a1_y}, a2, a3, a4, a5, a6);
+}
 bool igVSliderScalar_cwrap(char* a0, struct ImVec2* a1, int a2, void* a3, void* a4, void* a5, char* a6, int a7){
   return igVSliderScalar(a0, *a1, a2, a3, a4, a5, a6, a7);
 }
+bool igVSliderScalar_flat(char* a0, float a1_x, float a1_y, int a2, void* a3, void* a4, void* a5, char* a6, int a7){
+  return igVSliderScalar(a0, (struct ImVec2){a1_x, a1_y}, a2, a3, a4, a5, a6, a7);
+}
 bool igInputTextMultiline_cwrap(char* a0, char* a1, long unsigned int a2, struct ImVec2* a3, int a4, void* a5, void* a6){
   return igInputTextMultiline(a0, a1, a2, *a3, a4, a5, a6);
 }
+bool igInputTextMultiline_flat(char* a0, char* a1, long unsigned int a2, float a3_x, float a3_y, int a4, void* a5, void* a6){
+  return igInputTextMultiline(a0, a1, a2, (struct ImVec2){a3_x, a3_y}, a4, a5, a6);
+}
 bool igColorButton_cwrap(char* a0, struct ImVec4* a1, int a2, struct ImVec2* a3){
   return igColorButton(a0, *a1, a2, *a3);
 }
+bool igColorButton_flat(char* a0, float a1_x, float a1_y, float a1_z, float a1_w, int a2, float a3_x, float a3_y){
+  return igColorButton(a0, (struct ImVec4){a1_x, a1_y, a1_z, a1_w}, a2, (struct ImVec2){a3_x, a3_y});
+}
 bool igSelectable_Bool_cwrap(char* a0, bool a1, int a2, struct ImVec2* a3){
   return igSelectable_Bool(a0, a1, a2, *a3);
 }
+bool igSelectable_Bool_flat(char* a0, bool a1, int a2, float a3_x, float a3_y){
+  return igSelectable_Bool(a0, a1, a2, (struct ImVec2){a3_x, a3_y});
+}
 bool igSelectable_BoolPtr_cwrap(char* a0, bool* a1, int a2, struct ImVec2* a3){
   return igSelectable_BoolPtr(a0, a1, a2, *a3);
 }
+bool igSelectable_BoolPtr_flat(char* a0, bool* a1, int a2, float a3_x, float a3_y){
+  return igSelectable_BoolPtr(a0, a1, a2, (struct ImVec2){a3_x, a3_y});
+}
 bool igBeginListBox_cwrap(char* a0, struct ImVec2* a1){
   return igBeginListBox(a0, *a1);
 }
+bool igBeginListBox_flat(char* a0, float a1_x, float a1_y){
+  return igBeginListBox(a0, (struct ImVec2){a1_x, a1_y});
+}
 void igPlotLines_FloatPtr_cwrap(char* a0, float* a1, int a2, int a3, char* a4, float a5, float a6, struct ImVec2* a7, int a8){
   return igPlotLines_FloatPtr(a0, a1, a2, a3, a4, a5, a6, *a7, a8);
 }
+void igPlotLines_FloatPtr_flat(char* a0, float* a1, int a2, int a3, char* a4, float a5, float a6, float a7_x, float a7_y, int a8){
+  return igPlotLines_FloatPtr(a0, a1, a2, a3, a4, a5, a6, (struct ImVec2){a7_x, a7_y}, a8);
+}
 void igPlotLines_FnFloatPtr_cwrap(char* a0, void* a1, void* a2, int a3, int a4, char* a5, float a6, float a7, struct ImVec2* a8){
   return igPlotLines_FnFloatPtr(a0, a1, a2, a3, a4, a5, a6, a7, *a8);
 }
+void igPlotLines_FnFloatPtr_flat(char* a0, void* a1, void* a2, int a3, int a4, char* a5, float a6, float a7, float a8_x, float a8_y){
+  return igPlotLines_FnFloatPtr(a0, a1, a2, a3, a4, a5, a6, a7, (struct ImVec2){a8_x, a8_y});
+}
 void igPlotHistogram_FloatPtr_cwrap(char* a0, float* a1, int a2, int a3, char* a4, float a5, float a6, struct ImVec2* a7, int a8){
   return igPlotHistogram_FloatPtr(a0, a1, a2, a3, a4, a5, a6, *a7, a8);
 }
+void igPlotHistogram_FloatPtr_flat(char* a0, float* a1, int a2, int a3, char* a4, float a5, float a6, float a7_x, float a7_y, int a8){
+  return igPlotHistogram_FloatPtr(a0, a1, a2, a3, a4, a5, a6, (struct ImVec2){a7_x, a7_y}, a8);
+}
 void igPlotHistogram_FnFloatPtr_cwrap(char* a0, void* a1, void* a2, int a3, int a4, char* a5, float a6, float a7, struct ImVec2* a8){
   return igPlotHistogram_FnFloatPtr(a0, a1, a2, a3, a4, a5, a6, a7, *a8);
 }
+void igPlotHistogram_FnFloatPtr_flat(char* a0, void* a1, void* a2, int a3, int a4, char* a5, float a6, float a7, float a8_x, float a8_y){
+  return igPlotHistogram_FnFloatPtr(a0, a1, a2, a3, a4, a5, a6, a7, (struct ImVec2){a8_x, a8_y});
+}
 bool igBeginTable_cwrap(char* a0, int a1, int a2, struct ImVec2* a3, float a4){
   return igBeginTable(a0, a1, a2, *a3, a4);
 }
+bool igBeginTable_flat(char* a0, int a1, int a2, float a3_x, float a3_y, float a4){
+  return igBeginTable(a0, a1, a2, (struct ImVec2){a3_x, a3_y}, a4);
+}
 void igPushClipRect_cwrap(struct ImVec2* a0, struct ImVec2* a1, bool a2){
   return igPushClipRect(*a0, *a1, a2);
 }
+void igPushClipRect_flat(float a0_x, float a0_y, float a1_x, float a1_y, bool a2){
+  return igPushClipRect((struct ImVec2){a0_x, a0_y}, (struct ImVec2){a1_x, a1_y}, a2);
+}
 bool igIsRectVisible_Nil_cwrap(struct ImVec2* a0){
   return igIsRectVisible_Nil(*a0);
 }
+bool igIsRectVisible_Nil_flat(float a0_x, float a0_y){
+  return igIsRectVisible_Nil((struct ImVec2){a0_x, a0_y});
+}
 bool igIsRectVisible_Vec2_cwrap(struct ImVec2* a0, struct ImVec2* a1){
   return igIsRectVisible_Vec2(*a0, *a1);
 }
+bool igIsRectVisible_Vec2_flat(float a0_x, float a0_y, float a1_x, float a1_y){
+  return igIsRectVisible_Vec2((struct ImVec2){a0_x, a0_y}, (struct ImVec2){a1_x, a1_y});
+}
 bool igBeginChildFrame_cwrap(unsigned int a0, struct ImVec2* a1, int a2){
   return igBeginChildFrame(a0, *a1, a2);
 }
+bool igBeginChildFrame_flat(unsigned int a0, float a1_x, float a1_y, int a2){
+  return igBeginChildFrame(a0, (struct ImVec2){a1_x, a1_y}, a2);
+}
 unsigned int igColorConvertFloat4ToU32_cwrap(struct ImVec4* a0){
   return igColorConvertFloat4ToU32(*a0);
 }
+unsigned int igColorConvertFloat4ToU32_flat(float a0_x, float a0_y, float a0_z, float a0_w){
+  return igColorConvertFloat4ToU32((struct ImVec4){a0_x, a0_y, a0_z, a0_w});
+}
 bool igIsMouseHoveringRect_cwrap(struct ImVec2* a0, struct ImVec2* a1, bool a2){
   return igIsMouseHoveringRect(*a0, *a1, a2);
 }
+bool igIsMouseHoveringRect_flat(float a0_x, float a0_y, float a1_x, float a1_y, bool a2){
+  return igIsMouseHoveringRect((struct ImVec2){a0_x, a0_y}, (struct ImVec2){a1_x, a1_y}, a2);
+}
 struct ImColor* ImColor_ImColor_Vec4_cwrap(struct ImVec4* a0){
   return ImColor_ImColor_Vec4(*a0);
 }
+struct ImColor* ImColor_ImColor_Vec4_flat(float a0_x, float a0_y, float a0_z, float a0_w){
+  return ImColor_ImColor_Vec4((struct ImVec4){a0_x, a0_y, a0_z, a0_w});
+}
 void ImDrawList_PushClipRect_cwrap(struct ImDrawList* a0, struct ImVec2* a1, struct ImVec2* a2, bool a3){
   return ImDrawList_PushClipRect(a0, *a1, *a2, a3);
 }
+void ImDrawList_PushClipRect_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2_x, float a2_y, bool a3){
+  return ImDrawList_PushClipRect(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, a3);
+}
 void ImDrawList_AddLine_cwrap(struct ImDrawList* a0, struct ImVec2* a1, struct ImVec2* a2, unsigned int a3, float a4){
   return ImDrawList_AddLine(a0, *a1, *a2, a3, a4);
 }
+void ImDrawList_AddLine_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2_x, float a2_y, unsigned int a3, float a4){
+  return ImDrawList_AddLine(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, a3, a4);
+}
 void ImDrawList_AddRect_cwrap(struct ImDrawList* a0, struct ImVec2* a1, struct ImVec2* a2, unsigned int a3, float a4, int a5, float a6){
   return ImDrawList_AddRect(a0, *a1, *a2, a3, a4, a5, a6);
 }
+void ImDrawList_AddRect_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2_x, float a2_y, unsigned int a3, float a4, int a5, float a6){
+  return ImDrawList_AddRect(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, a3, a4, a5, a6);
+}
 void ImDrawList_AddRectFilled_cwrap(struct ImDrawList* a0, struct ImVec2* a1, struct ImVec2* a2, unsigned int a3, float a4, int a5){
   return ImDrawList_AddRectFilled(a0, *a1, *a2, a3, a4, a5);
 }
+void ImDrawList_AddRectFilled_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2_x, float a2_y, unsigned int a3, float a4, int a5){
+  return ImDrawList_AddRectFilled(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, a3, a4, a5);
+}
 void ImDrawList_AddRectFilledMultiColor_cwrap(struct ImDrawList* a0, struct ImVec2* a1, struct ImVec2* a2, unsigned int a3, unsigned int a4, unsigned int a5, unsigned int a6){
   return ImDrawList_AddRectFilledMultiColor(a0, *a1, *a2, a3, a4, a5, a6);
 }
+void ImDrawList_AddRectFilledMultiColor_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2_x, float a2_y, unsigned int a3, unsigned int a4, unsigned int a5, unsigned int a6){
+  return ImDrawList_AddRectFilledMultiColor(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, a3, a4, a5, a6);
+}
 void ImDrawList_AddQuad_cwrap(struct ImDrawList* a0, struct ImVec2* a1, struct ImVec2* a2, struct ImVec2* a3, struct ImVec2* a4, unsigned int a5, float a6){
   return ImDrawList_AddQuad(a0, *a1, *a2, *a3, *a4, a5, a6);
 }
+void ImDrawList_AddQuad_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2_x, float a2_y, float a3_x, float a3_y, float a4_x, float a4_y, unsigned int a5, float a6){
+  return ImDrawList_AddQuad(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y}, (struct ImVec2){a4_x, a4_y}, a5, a6);
+}
 void ImDrawList_AddQuadFilled_cwrap(struct ImDrawList* a0, struct ImVec2* a1, struct ImVec2* a2, struct ImVec2* a3, struct ImVec2* a4, unsigned int a5){
   return ImDrawList_AddQuadFilled(a0, *a1, *a2, *a3, *a4, a5);
 }
+void ImDrawList_AddQuadFilled_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2_x, float a2_y, float a3_x, float a3_y, float a4_x, float a4_y, unsigned int a5){
+  return ImDrawList_AddQuadFilled(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y}, (struct ImVec2){a4_x, a4_y}, a5);
+}
 void ImDrawList_AddTriangle_cwrap(struct ImDrawList* a0, struct ImVec2* a1, struct ImVec2* a2, struct ImVec2* a3, unsigned int a4, float a5){
   return ImDrawList_AddTriangle(a0, *a1, *a2, *a3, a4, a5);
 }
+void ImDrawList_AddTriangle_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2_x, float a2_y, float a3_x, float a3_y, unsigned int a4, float a5){
+  return ImDrawList_AddTriangle(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y}, a4, a5);
+}
 void ImDrawList_AddTriangleFilled_cwrap(struct ImDrawList* a0, struct ImVec2* a1, struct ImVec2* a2, struct ImVec2* a3, unsigned int a4){
   return ImDrawList_AddTriangleFilled(a0, *a1, *a2, *a3, a4);
 }
+void ImDrawList_AddTriangleFilled_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2_x, float a2_y, float a3_x, float a3_y, unsigned int a4){
+  return ImDrawList_AddTriangleFilled(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y}, a4);
+}
 void ImDrawList_AddCircle_cwrap(struct ImDrawList* a0, struct ImVec2* a1, float a2, unsigned int a3, int a4, float a5){
   return ImDrawList_AddCircle(a0, *a1, a2, a3, a4, a5);
 }
+void ImDrawList_AddCircle_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2, unsigned int a3, int a4, float a5){
+  return ImDrawList_AddCircle(a0, (struct ImVec2){a1_x, a1_y}, a2, a3, a4, a5);
+}
 void ImDrawList_AddCircleFilled_cwrap(struct ImDrawList* a0, struct ImVec2* a1, float a2, unsigned int a3, int a4){
   return ImDrawList_AddCircleFilled(a0, *a1, a2, a3, a4);
 }
+void ImDrawList_AddCircleFilled_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2, unsigned int a3, int a4){
+  return ImDrawList_AddCircleFilled(a0, (struct ImVec2){a1_x, a1_y}, a2, a3, a4);
+}
 void ImDrawList_AddNgon_cwrap(struct ImDrawList* a0, struct ImVec2* a1, float a2, unsigned int a3, int a4, float a5){
   return ImDrawList_AddNgon(a0, *a1, a2, a3, a4, a5);
 }
+void ImDrawList_AddNgon_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2, unsigned int a3, int a4, float a5){
+  return ImDrawList_AddNgon(a0, (struct ImVec2){a1_x, a1_y}, a2, a3, a4, a5);
+}
 void ImDrawList_AddNgonFilled_cwrap(struct ImDrawList* a0, struct ImVec2* a1, float a2, unsigned int a3, int a4){
   return ImDrawList_AddNgonFilled(a0, *a1, a2, a3, a4);
 }
+void ImDrawList_AddNgonFilled_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2, unsigned int a3, int a4){
+  return ImDrawList_AddNgonFilled(a0, (struct ImVec2){a1_x, a1_y}, a2, a3, a4);
+}
 void ImDrawList_AddText_Vec2_cwrap(struct ImDrawList* a0, struct ImVec2* a1, unsigned int a2, char* a3, char* a4){
   return ImDrawList_AddText_Vec2(a0, *a1, a2, a3, a4);
 }
+void ImDrawList_AddText_Vec2_flat(struct ImDrawList* a0, float a1_x, float a1_y, unsigned int a2, char* a3, char* a4){
+  return ImDrawList_AddText_Vec2(a0, (struct ImVec2){a1_x, a1_y}, a2, a3, a4);
+}
 void ImDrawList_AddText_FontPtr_cwrap(struct ImDrawList* a0, struct ImFont* a1, float a2, struct ImVec2* a3, unsigned int a4, char* a5, char* a6, float a7, struct ImVec4* a8){
   return ImDrawList_AddText_FontPtr(a0, a1, a2, *a3, a4, a5, a6, a7, a8);
 }
+void ImDrawList_AddText_FontPtr_flat(struct ImDrawList* a0, struct ImFont* a1, float a2, float a3_x, float a3_y, unsigned int a4, char* a5, char* a6, float a7, struct ImVec4* a8){
+  return ImDrawList_AddText_FontPtr(a0, a1, a2, (struct ImVec2){a3_x, a3_y}, a4, a5, a6, a7, a8);
+}
 void ImDrawList_AddBezierCubic_cwrap(struct ImDrawList* a0, struct ImVec2* a1, struct ImVec2* a2, struct ImVec2* a3, struct ImVec2* a4, unsigned int a5, float a6, int a7){
   return ImDrawList_AddBezierCubic(a0, *a1, *a2, *a3, *a4, a5, a6, a7);
 }
+void ImDrawList_AddBezierCubic_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2_x, float a2_y, float a3_x, float a3_y, float a4_x, float a4_y, unsigned int a5, float a6, int a7){
+  return ImDrawList_AddBezierCubic(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y}, (struct ImVec2){a4_x, a4_y}, a5, a6, a7);
+}
 void ImDrawList_AddBezierQuadratic_cwrap(struct ImDrawList* a0, struct ImVec2* a1, struct ImVec2* a2, struct ImVec2* a3, unsigned int a4, float a5, int a6){
   return ImDrawList_AddBezierQuadratic(a0, *a1, *a2, *a3, a4, a5, a6);
 }
+void ImDrawList_AddBezierQuadratic_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2_x, float a2_y, float a3_x, float a3_y, unsigned int a4, float a5, int a6){
+  return ImDrawList_AddBezierQuadratic(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y}, a4, a5, a6);
+}
 void ImDrawList_AddImage_cwrap(struct ImDrawList* a0, void* a1, struct ImVec2* a2, struct ImVec2* a3, struct ImVec2* a4, struct ImVec2* a5, unsigned int a6){
   return ImDrawList_AddImage(a0, a1, *a2, *a3, *a4, *a5, a6);
 }
+void ImDrawList_AddImage_flat(struct ImDrawList* a0, void* a1, float a2_x, float a2_y, float a3_x, float a3_y, float a4_x, float a4_y, float a5_x, float a5_y, unsigned int a6){
+  return ImDrawList_AddImage(a0, a1, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y}, (struct ImVec2){a4_x, a4_y}, (struct ImVec2){a5_x, a5_y}, a6);
+}
 void ImDrawList_AddImageQuad_cwrap(struct ImDrawList* a0, void* a1, struct ImVec2* a2, struct ImVec2* a3, struct ImVec2* a4, struct ImVec2* a5, struct ImVec2* a6, struct ImVec2* a7, struct ImVec2* a8, struct ImVec2* a9, unsigned int a10){
   return ImDrawList_AddImageQuad(a0, a1, *a2, *a3, *a4, *a5, *a6, *a7, *a8, *a9, a10);
 }
+void ImDrawList_AddImageQuad_flat(struct ImDrawList* a0, void* a1, float a2_x, float a2_y, float a3_x, float a3_y, float a4_x, float a4_y, float a5_x, float a5_y, float a6_x, float a6_y, float a7_x, float a7_y, float a8_x, float a8_y, float a9_x, float a9_y, unsigned int a10){
+  return ImDrawList_AddImageQuad(a0, a1, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y}, (struct ImVec2){a4_x, a4_y}, (struct ImVec2){a5_x, a5_y}, (struct ImVec2){a6_x, a6_y}, (struct ImVec2){a7_x, a7_y}, (struct ImVec2){a8_x, a8_y}, (struct ImVec2){a9_x, a9_y}, a10);
+}
 void ImDrawList_AddImageRounded_cwrap(struct ImDrawList* a0, void* a1, struct ImVec2* a2, struct ImVec2* a3, struct ImVec2* a4, struct ImVec2* a5, unsigned int a6, float a7, int a8){
   return ImDrawList_AddImageRounded(a0, a1, *a2, *a3, *a4, *a5, a6, a7, a8);
 }
+void ImDrawList_AddImageRounded_flat(struct ImDrawList* a0, void* a1, float a2_x, float a2_y, float a3_x, float a3_y, float a4_x, float a4_y, float a5_x, float a5_y, unsigned int a6, float a7, int a8){
+  return ImDrawList_AddImageRounded(a0, a1, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y}, (struct ImVec2){a4_x, a4_y}, (struct ImVec2){a5_x, a5_y}, a6, a7, a8);
+}
 void ImDrawList_PathLineTo_cwrap(struct ImDrawList* a0, struct ImVec2* a1){
   return ImDrawList_PathLineTo(a0, *a1);
 }
+void ImDrawList_PathLineTo_flat(struct ImDrawList* a0, float a1_x, float a1_y){
+  return ImDrawList_PathLineTo(a0, (struct ImVec2){a1_x, a1_y});
+}
 void ImDrawList_PathLineToMergeDuplicate_cwrap(struct ImDrawList* a0, struct ImVec2* a1){
   return ImDrawList_PathLineToMergeDuplicate(a0, *a1);
 }
+void ImDrawList_PathLineToMergeDuplicate_flat(struct ImDrawList* a0, float a1_x, float a1_y){
+  return ImDrawList_PathLineToMergeDuplicate(a0, (struct ImVec2){a1_x, a1_y});
+}
 void ImDrawList_PathArcTo_cwrap(struct ImDrawList* a0, struct ImVec2* a1, float a2, float a3, float a4, int a5){
   return ImDrawList_PathArcTo(a0, *a1, a2, a3, a4, a5);
 }
+void ImDrawList_PathArcTo_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2, float a3, float a4, int a5){
+  return ImDrawList_PathArcTo(a0, (struct ImVec2){a1_x, a1_y}, a2, a3, a4, a5);
+}
 void ImDrawList_PathArcToFast_cwrap(struct ImDrawList* a0, struct ImVec2* a1, float a2, int a3, int a4){
   return ImDrawList_PathArcToFast(a0, *a1, a2, a3, a4);
 }
+void ImDrawList_PathArcToFast_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2, int a3, int a4){
+  return ImDrawList_PathArcToFast(a0, (struct ImVec2){a1_x, a1_y}, a2, a3, a4);
+}
 void ImDrawList_PathBezierCubicCurveTo_cwrap(struct ImDrawList* a0, struct ImVec2* a1, struct ImVec2* a2, struct ImVec2* a3, int a4){
   return ImDrawList_PathBezierCubicCurveTo(a0, *a1, *a2, *a3, a4);
 }
+void ImDrawList_PathBezierCubicCurveTo_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2_x, float a2_y, float a3_x, float a3_y, int a4){
+  return ImDrawList_PathBezierCubicCurveTo(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y}, a4);
+}
 void ImDrawList_PathBezierQuadraticCurveTo_cwrap(struct ImDrawList* a0, struct ImVec2* a1, struct ImVec2* a2, int a3){
   return ImDrawList_PathBezierQuadraticCurveTo(a0, *a1, *a2, a3);
 }
+void ImDrawList_PathBezierQuadraticCurveTo_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2_x, float a2_y, int a3){
+  return ImDrawList_PathBezierQuadraticCurveTo(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, a3);
+}
 void ImDrawList_PathRect_cwrap(struct ImDrawList* a0, struct ImVec2* a1, struct ImVec2* a2, float a3, int a4){
   return ImDrawList_PathRect(a0, *a1, *a2, a3, a4);
 }
+void ImDrawList_PathRect_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2_x, float a2_y, float a3, int a4){
+  return ImDrawList_PathRect(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, a3, a4);
+}
 void ImDrawList_PrimRect_cwrap(struct ImDrawList* a0, struct ImVec2* a1, struct ImVec2* a2, unsigned int a3){
   return ImDrawList_PrimRect(a0, *a1, *a2, a3);
 }
+void ImDrawList_PrimRect_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2_x, float a2_y, unsigned int a3){
+  return ImDrawList_PrimRect(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, a3);
+}
 void ImDrawList_PrimRectUV_cwrap(struct ImDrawList* a0, struct ImVec2* a1, struct ImVec2* a2, struct ImVec2* a3, struct ImVec2* a4, unsigned int a5){
   return ImDrawList_PrimRectUV(a0, *a1, *a2, *a3, *a4, a5);
 }
+void ImDrawList_PrimRectUV_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2_x, float a2_y, float a3_x, float a3_y, float a4_x, float a4_y, unsigned int a5){
+  return ImDrawList_PrimRectUV(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y}, (struct ImVec2){a4_x, a4_y}, a5);
+}
 void ImDrawList_PrimQuadUV_cwrap(struct ImDrawList* a0, struct ImVec2* a1, struct ImVec2* a2, struct ImVec2* a3, struct ImVec2* a4, struct ImVec2* a5, struct ImVec2* a6, struct ImVec2* a7, struct ImVec2* a8, unsigned int a9){
   return ImDrawList_PrimQuadUV(a0, *a1, *a2, *a3, *a4, *a5, *a6, *a7, *a8, a9);
 }
+void ImDrawList_PrimQuadUV_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2_x, float a2_y, float a3_x, float a3_y, float a4_x, float a4_y, float a5_x, float a5_y, float a6_x, float a6_y, float a7_x, float a7_y, float a8_x, float a8_y, unsigned int a9){
+  return ImDrawList_PrimQuadUV(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y}, (struct ImVec2){a4_x, a4_y}, (struct ImVec2){a5_x, a5_y}, (struct ImVec2){a6_x, a6_y}, (struct ImVec2){a7_x, a7_y}, (struct ImVec2){a8_x, a8_y}, a9);
+}
 void ImDrawList_PrimWriteVtx_cwrap(struct ImDrawList* a0, struct ImVec2* a1, struct ImVec2* a2, unsigned int a3){
   return ImDrawList_PrimWriteVtx(a0, *a1, *a2, a3);
 }
+void ImDrawList_PrimWriteVtx_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2_x, float a2_y, unsigned int a3){
+  return ImDrawList_PrimWriteVtx(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, a3);
+}
 void ImDrawList_PrimVtx_cwrap(struct ImDrawList* a0, struct ImVec2* a1, struct ImVec2* a2, unsigned int a3){
   return ImDrawList_PrimVtx(a0, *a1, *a2, a3);
 }
+void ImDrawList_PrimVtx_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2_x, float a2_y, unsigned int a3){
+  return ImDrawList_PrimVtx(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, a3);
+}
 void ImDrawList__PathArcToFastEx_cwrap(struct ImDrawList* a0, struct ImVec2* a1, float a2, int a3, int a4, int a5){
   return ImDrawList__PathArcToFastEx(a0, *a1, a2, a3, a4, a5);
 }
+void ImDrawList__PathArcToFastEx_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2, int a3, int a4, int a5){
+  return ImDrawList__PathArcToFastEx(a0, (struct ImVec2){a1_x, a1_y}, a2, a3, a4, a5);
+}
 void ImDrawList__PathArcToN_cwrap(struct ImDrawList* a0, struct ImVec2* a1, float a2, float a3, float a4, int a5){
   return ImDrawList__PathArcToN(a0, *a1, a2, a3, a4, a5);
 }
+void ImDrawList__PathArcToN_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2, float a3, float a4, int a5){
+  return ImDrawList__PathArcToN(a0, (struct ImVec2){a1_x, a1_y}, a2, a3, a4, a5);
+}
 void ImDrawData_ScaleClipRects_cwrap(struct ImDrawData* a0, struct ImVec2* a1){
   return ImDrawData_ScaleClipRects(a0, *a1);
 }
+void ImDrawData_ScaleClipRects_flat(struct ImDrawData* a0, float a1_x, float a1_y){
+  return ImDrawData_ScaleClipRects(a0, (struct ImVec2){a1_x, a1_y});
+}
 int ImFontAtlas_AddCustomRectFontGlyph_cwrap(struct ImFontAtlas* a0, struct ImFont* a1, short unsigned int a2, int a3, int a4, float a5, struct ImVec2* a6){
   return ImFontAtlas_AddCustomRectFontGlyph(a0, a1, a2, a3, a4, a5, *a6);
 }
+int ImFontAtlas_AddCustomRectFontGlyph_flat(struct ImFontAtlas* a0, struct ImFont* a1, short unsigned int a2, int a3, int a4, float a5, float a6_x, float a6_y){
+  return ImFontAtlas_AddCustomRectFontGlyph(a0, a1, a2, a3, a4, a5, (struct ImVec2){a6_x, a6_y});
+}
 void ImFont_RenderChar_cwrap(struct ImFont* a0, struct ImDrawList* a1, float a2, struct ImVec2* a3, unsigned int a4, short unsigned int a5){
   return ImFont_RenderChar(a0, a1, a2, *a3, a4, a5);
 }
+void ImFont_RenderChar_flat(struct ImFont* a0, struct ImDrawList* a1, float a2, float a3_x, float a3_y, unsigned int a4, short unsigned int a5){
+  return ImFont_RenderChar(a0, a1, a2, (struct ImVec2){a3_x, a3_y}, a4, a5);
+}
 void ImFont_RenderText_cwrap(struct ImFont* a0, struct ImDrawList* a1, float a2, struct ImVec2* a3, unsigned int a4, struct ImVec4* a5, char* a6, char* a7, float a8, bool a9){
   return ImFont_RenderText(a0, a1, a2, *a3, a4, *a5, a6, a7, a8, a9);
 }
+void ImFont_RenderText_flat(struct ImFont* a0, struct ImDrawList* a1, float a2, float a3_x, float a3_y, unsigned int a4, float a5_x, float a5_y, float a5_z, float a5_w, char* a6, char* a7, float a8, bool a9){
+  return ImFont_RenderText(a0, a1, a2, (struct ImVec2){a3_x, a3_y}, a4, (struct ImVec4){a5_x, a5_y, a5_z, a5_w}, a6, a7, a8, a9);
+}
 void igImMin_cwrap(struct ImVec2* a0, struct ImVec2* a1, struct ImVec2* a2){
   return igImMin(a0, *a1, *a2);
 }
+void igImMin_flat(struct ImVec2* a0, float a1_x, float a1_y, float a2_x, float a2_y){
+  return igImMin(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y});
+}
 void igImMax_cwrap(struct ImVec2* a0, struct ImVec2* a1, struct ImVec2* a2){
   return igImMax(a0, *a1, *a2);
 }
+void igImMax_flat(struct ImVec2* a0, float a1_x, float a1_y, float a2_x, float a2_y){
+  return igImMax(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y});
+}
 void igImClamp_cwrap(struct ImVec2* a0, struct ImVec2* a1, struct ImVec2* a2, struct ImVec2* a3){
   return igImClamp(a0, *a1, *a2, *a3);
 }
+void igImClamp_flat(struct ImVec2* a0, float a1_x, float a1_y, float a2_x, float a2_y, float a3_x, float a3_y){
+  return igImClamp(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y});
+}
 void igImLerp_Vec2Float_cwrap(struct ImVec2* a0, struct ImVec2* a1, struct ImVec2* a2, float a3){
   return igImLerp_Vec2Float(a0, *a1, *a2, a3);
 }
+void igImLerp_Vec2Float_flat(struct ImVec2* a0, float a1_x, float a1_y, float a2_x, float a2_y, float a3){
+  return igImLerp_Vec2Float(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, a3);
+}
 void igImLerp_Vec2Vec2_cwrap(struct ImVec2* a0, struct ImVec2* a1, struct ImVec2* a2, struct ImVec2* a3){
   return igImLerp_Vec2Vec2(a0, *a1, *a2, *a3);
 }
+void igImLerp_Vec2Vec2_flat(struct ImVec2* a0, float a1_x, float a1_y, float a2_x, float a2_y, float a3_x, float a3_y){
+  return igImLerp_Vec2Vec2(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y});
+}
 void igImLerp_Vec4_cwrap(struct ImVec4* a0, struct ImVec4* a1, struct ImVec4* a2, float a3){
   return igImLerp_Vec4(a0, *a1, *a2, a3);
 }
+void igImLerp_Vec4_flat(struct ImVec4* a0, float a1_x, float a1_y, float a1_z, float a1_w, float a2_x, float a2_y, float a2_z, float a2_w, float a3){
+  return igImLerp_Vec4(a0, (struct ImVec4){a1_x, a1_y, a1_z, a1_w}, (struct ImVec4){a2_x, a2_y, a2_z, a2_w}, a3);
+}
 float igImLengthSqr_Vec2_cwrap(struct ImVec2* a0){
   return igImLengthSqr_Vec2(*a0);
 }
+float igImLengthSqr_Vec2_flat(float a0_x, float a0_y){
+  return igImLengthSqr_Vec2((struct ImVec2){a0_x, a0_y});
+}
 float igImLengthSqr_Vec4_cwrap(struct ImVec4* a0){
   return igImLengthSqr_Vec4(*a0);
 }
+float igImLengthSqr_Vec4_flat(float a0_x, float a0_y, float a0_z, float a0_w){
+  return igImLengthSqr_Vec4((struct ImVec4){a0_x, a0_y, a0_z, a0_w});
+}
 float igImInvLength_cwrap(struct ImVec2* a0, float a1){
   return igImInvLength(*a0, a1);
 }
+float igImInvLength_flat(float a0_x, float a0_y, float a1){
+  return igImInvLength((struct ImVec2){a0_x, a0_y}, a1);
+}
 void igImFloor_Vec2_cwrap(struct ImVec2* a0, struct ImVec2* a1){
   return igImFloor_Vec2(a0, *a1);
 }
+void igImFloor_Vec2_flat(struct ImVec2* a0, float a1_x, float a1_y){
+  return igImFloor_Vec2(a0, (struct ImVec2){a1_x, a1_y});
+}
 void igImFloorSigned_Vec2_cwrap(struct ImVec2* a0, struct ImVec2* a1){
   return igImFloorSigned_Vec2(a0, *a1);
 }
+void igImFloorSigned_Vec2_flat(struct ImVec2* a0, float a1_x, float a1_y){
+  return igImFloorSigned_Vec2(a0, (struct ImVec2){a1_x, a1_y});
+}
 float igImDot_cwrap(struct ImVec2* a0, struct ImVec2* a1){
   return igImDot(*a0, *a1);
 }
+float igImDot_flat(float a0_x, float a0_y, float a1_x, float a1_y){
+  return igImDot((struct ImVec2){a0_x, a0_y}, (struct ImVec2){a1_x, a1_y});
+}
 void igImRotate_cwrap(struct ImVec2* a0, struct ImVec2* a1, float a2, float a3){
   return igImRotate(a0, *a1, a2, a3);
 }
+void igImRotate_flat(struct ImVec2* a0, float a1_x, float a1_y, float a2, float a3){
+  return igImRotate(a0, (struct ImVec2){a1_x, a1_y}, a2, a3);
+}
 void igImMul_cwrap(struct ImVec2* a0, struct ImVec2* a1, struct ImVec2* a2){
   return igImMul(a0, *a1, *a2);
 }
+void igImMul_flat(struct ImVec2* a0, float a1_x, float a1_y, float a2_x, float a2_y){
+  return igImMul(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y});
+}
 void igImBezierCubicCalc_cwrap(struct ImVec2* a0, struct ImVec2* a1, struct ImVec2* a2, struct ImVec2* a3, struct ImVec2* a4, float a5){
   return igImBezierCubicCalc(a0, *a1, *a2, *a3, *a4, a5);
 }
+void igImBezierCubicCalc_flat(struct ImVec2* a0, float a1_x, float a1_y, float a2_x, float a2_y, float a3_x, float a3_y, float a4_x, float a4_y, float a5){
+  return igImBezierCubicCalc(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y}, (struct ImVec2){a4_x, a4_y}, a5);
+}
 void igImBezierCubicClosestPoint_cwrap(struct ImVec2* a0, struct ImVec2* a1, struct ImVec2* a2, struct ImVec2* a3, struct ImVec2* a4, struct ImVec2* a5, int a6){
   return igImBezierCubicClosestPoint(a0, *a1, *a2, *a3, *a4, *a5, a6);
 }
+void igImBezierCubicClosestPoint_flat(struct ImVec2* a0, float a1_x, float a1_y, float a2_x, float a2_y, float a3_x, float a3_y, float a4_x, float a4_y, float a5_x, float a5_y, int a6){
+  return igImBezierCubicClosestPoint(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y}, (struct ImVec2){a4_x, a4_y}, (struct ImVec2){a5_x, a5_y}, a6);
+}
 void igImBezierCubicClosestPointCasteljau_cwrap(struct ImVec2* a0, struct ImVec2* a1, struct ImVec2* a2, struct ImVec2* a3, struct ImVec2* a4, struct ImVec2* a5, float a6){
   return igImBezierCubicClosestPointCasteljau(a0, *a1, *a2, *a3, *a4, *a5, a6);
 }
+void igImBezierCubicClosestPointCasteljau_flat(struct ImVec2* a0, float a1_x, float a1_y, float a2_x, float a2_y, float a3_x, float a3_y, float a4_x, float a4_y, float a5_x, float a5_y, float a6){
+  return igImBezierCubicClosestPointCasteljau(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y}, (struct ImVec2){a4_x, a4_y}, (struct ImVec2){a5_x, a5_y}, a6);
+}
 void igImBezierQuadraticCalc_cwrap(struct ImVec2* a0, struct ImVec2* a1, struct ImVec2* a2, struct ImVec2* a3, float a4){
   return igImBezierQuadraticCalc(a0, *a1, *a2, *a3, a4);
 }
+void igImBezierQuadraticCalc_flat(struct ImVec2* a0, float a1_x, float a1_y, float a2_x, float a2_y, float a3_x, float a3_y, float a4){
+  return igImBezierQuadraticCalc(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y}, a4);
+}
 void igImLineClosestPoint_cwrap(struct ImVec2* a0, struct ImVec2* a1, struct ImVec2* a2, struct ImVec2* a3){
   return igImLineClosestPoint(a0, *a1, *a2, *a3);
 }
+void igImLineClosestPoint_flat(struct ImVec2* a0, float a1_x, float a1_y, float a2_x, float a2_y, float a3_x, float a3_y){
+  return igImLineClosestPoint(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y});
+}
 bool igImTriangleContainsPoint_cwrap(struct ImVec2* a0, struct ImVec2* a1, struct ImVec2* a2, struct ImVec2* a3){
   return igImTriangleContainsPoint(*a0, *a1, *a2, *a3);
 }
+bool igImTriangleContainsPoint_flat(float a0_x, float a0_y, float a1_x, float a1_y, float a2_x, float a2_y, float a3_x, float a3_y){
+  return igImTriangleContainsPoint((struct ImVec2){a0_x, a0_y}, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y});
+}
 void igImTriangleClosestPoint_cwrap(struct ImVec2* a0, struct ImVec2* a1, struct ImVec2* a2, struct ImVec2* a3, struct ImVec2* a4){
   return igImTriangleClosestPoint(a0, *a1, *a2, *a3, *a4);
 }
+void igImTriangleClosestPoint_flat(struct ImVec2* a0, float a1_x, float a1_y, float a2_x, float a2_y, float a3_x, float a3_y, float a4_x, float a4_y){
+  return igImTriangleClosestPoint(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y}, (struct ImVec2){a4_x, a4_y});
+}
 void igImTriangleBarycentricCoords_cwrap(struct ImVec2* a0, struct ImVec2* a1, struct ImVec2* a2, struct ImVec2* a3, float* a4, float* a5, float* a6){
   return igImTriangleBarycentricCoords(*a0, *a1, *a2, *a3, a4, a5, a6);
 }
+void igImTriangleBarycentricCoords_flat(float a0_x, float a0_y, float a1_x, float a1_y, float a2_x, float a2_y, float a3_x, float a3_y, float* a4, float* a5, float* a6){
+  return igImTriangleBarycentricCoords((struct ImVec2){a0_x, a0_y}, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y}, a4, a5, a6);
+}
 float igImTriangleArea_cwrap(struct ImVec2* a0, struct ImVec2* a1, struct ImVec2* a2){
   return igImTriangleArea(*a0, *a1, *a2);
 }
+float igImTriangleArea_flat(float a0_x, float a0_y, float a1_x, float a1_y, float a2_x, float a2_y){
+  return igImTriangleArea((struct ImVec2){a0_x, a0_y}, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y});
+}
 struct ImVec2ih* ImVec2ih_ImVec2ih_Vec2_cwrap(struct ImVec2* a0){
   return ImVec2ih_ImVec2ih_Vec2(*a0);
 }
+struct ImVec2ih* ImVec2ih_ImVec2ih_Vec2_flat(float a0_x, float a0_y){
+  return ImVec2ih_ImVec2ih_Vec2((struct ImVec2){a0_x, a0_y});
+}
 struct ImRect* ImRect_ImRect_Vec2_cwrap(struct ImVec2* a0, struct ImVec2* a1){
   return ImRect_ImRect_Vec2(*a0, *a1);
 }
+struct ImRect* ImRect_ImRect_Vec2_flat(float a0_x, float a0_y, float a1_x, float a1_y){
+  return ImRect_ImRect_Vec2((struct ImVec2){a0_x, a0_y}, (struct ImVec2){a1_x, a1_y});
+}
 struct ImRect* ImRect_ImRect_Vec4_cwrap(struct ImVec4* a0){
   return ImRect_ImRect_Vec4(*a0);
 }
+struct ImRect* ImRect_ImRect_Vec4_flat(float a0_x, float a0_y, float a0_z, float a0_w){
+  return ImRect_ImRect_Vec4((struct ImVec4){a0_x, a0_y, a0_z, a0_w});
+}
 bool ImRect_Contains_Vec2_cwrap(struct ImRect* a0, struct ImVec2* a1){
   return ImRect_Contains_Vec2(a0, *a1);
 }
+bool ImRect_Contains_Vec2_flat(struct ImRect* a0, float a1_x, float a1_y){
+  return ImRect_Contains_Vec2(a0, (struct ImVec2){a1_x, a1_y});
+}
 bool ImRect_Contains_Rect_cwrap(struct ImRect* a0, struct ImRect* a1){
   return ImRect_Contains_Rect(a0, *a1);
 }
@@ -341,15 +668,24 @@ bool ImRect_Overlaps_cwrap(struct ImRect* a0, struct ImRect* a1){
 void ImRect_Add_Vec2_cwrap(struct ImRect* a0, struct ImVec2* a1){
   return ImRect_Add_Vec2(a0, *a1);
 }
+void ImRect_Add_Vec2_flat(struct ImRect* a0, float a1_x, float a1_y){
+  return ImRect_Add_Vec2(a0, (struct ImVec2){a1_x, a1_y});
+}
 void ImRect_Add_Rect_cwrap(struct ImRect* a0, struct ImRect* a1){
   return ImRect_Add_Rect(a0, *a1);
 }
 void ImRect_Expand_Vec2_cwrap(struct ImRect* a0, struct ImVec2* a1){
   return ImRect_Expand_Vec2(a0, *a1);
 }
+void ImRect_Expand_Vec2_flat(struct ImRect* a0, float a1_x, float a1_y){
+  return ImRect_Expand_Vec2(a0, (struct ImVec2){a1_x, a1_y});
+}
 void ImRect_Translate_cwrap(struct ImRect* a0, struct ImVec2* a1){
   return ImRect_Translate(a0, *a1);
 }
+void ImRect_Translate_flat(struct ImRect* a0, float a1_x, float a1_y){
+  return ImRect_Translate(a0, (struct ImVec2){a1_x, a1_y});
+}
 void ImRect_ClipWith_cwrap(struct ImRect* a0, struct ImRect* a1){
   return ImRect_ClipWith(a0, *a1);
 }
@@ -359,6 +695,9 @@ void ImRect_ClipWithFull_cwrap(struct ImRect* a0, struct ImRect* a1){
 struct ImGuiStyleMod* ImGuiStyleMod_ImGuiStyleMod_Vec2_cwrap(int a0, struct ImVec2* a1){
   return ImGuiStyleMod_ImGuiStyleMod_Vec2(a0, *a1);
 }
+struct ImGuiStyleMod* ImGuiStyleMod_ImGuiStyleMod_Vec2_flat(int a0, float a1_x, float a1_y){
+  return ImGuiStyleMod_ImGuiStyleMod_Vec2(a0, (struct ImVec2){a1_x, a1_y});
+}
 void ImGuiListClipperRange_FromIndices_cwrap(struct ImGuiListClipperRange* a0, int a1, int a2){
   *a0 = ImGuiListClipperRange_FromIndices(a1, a2);
 }
@@ -368,21 +707,36 @@ void ImGuiListClipperRange_FromPositions_cwrap(struct ImGuiListClipperRange* a0,
 void ImGuiViewportP_CalcWorkRectPos_cwrap(struct ImVec2* a0, struct ImGuiViewportP* a1, struct ImVec2* a2){
   return ImGuiViewportP_CalcWorkRectPos(a0, a1, *a2);
 }
+void ImGuiViewportP_CalcWorkRectPos_flat(struct ImVec2* a0, struct ImGuiViewportP* a1, float a2_x, float a2_y){
+  return ImGuiViewportP_CalcWorkRectPos(a0, a1, (struct ImVec2){a2_x, a2_y});
+}
 void ImGuiViewportP_CalcWorkRectSize_cwrap(struct ImVec2* a0, struct ImGuiViewportP* a1, struct ImVec2* a2, struct ImVec2* a3){
   return ImGuiViewportP_CalcWorkRectSize(a0, a1, *a2, *a3);
 }
+void ImGuiViewportP_CalcWorkRectSize_flat(struct ImVec2* a0, struct ImGuiViewportP* a1, float a2_x, float a2_y, float a3_x, float a3_y){
+  return ImGuiViewportP_CalcWorkRectSize(a0, a1, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y});
+}
 unsigned int ImGuiWindow_GetIDFromRectangle_cwrap(struct ImGuiWindow* a0, struct ImRect* a1){
   return ImGuiWindow_GetIDFromRectangle(a0, *a1);
 }
 void igSetWindowPos_WindowPtr_cwrap(struct ImGuiWindow* a0, struct ImVec2* a1, int a2){
   return igSetWindowPos_WindowPtr(a0, *a1, a2);
 }
+void igSetWindowPos_WindowPtr_flat(struct ImGuiWindow* a0, float a1_x, float a1_y, int a2){
+  return igSetWindowPos_WindowPtr(a0, (struct ImVec2){a1_x, a1_y}, a2);
+}
 void igSetWindowSize_WindowPtr_cwrap(struct ImGuiWindow* a0, struct ImVec2* a1, int a2){
   return igSetWindowSize_WindowPtr(a0, *a1, a2);
 }
+void igSetWindowSize_WindowPtr_flat(struct ImGuiWindow* a0, float a1_x, float a1_y, int a2){
+  return igSetWindowSize_WindowPtr(a0, (struct ImVec2){a1_x, a1_y}, a2);
+}
 void igSetWindowHitTestHole_cwrap(struct ImGuiWindow* a0, struct ImVec2* a1, struct ImVec2* a2){
   return igSetWindowHitTestHole(a0, *a1, *a2);
 }
+void igSetWindowHitTestHole_flat(struct ImGuiWindow* a0, float a1_x, float a1_y, float a2_x, float a2_y){
+  return igSetWindowHitTestHole(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y});
+}
 void igWindowRectAbsToRel_cwrap(struct ImRect* a0, struct ImGuiWindow* a1, struct ImRect* a2){
   return igWindowRectAbsToRel(a0, a1, *a2);
 }
@@ -392,6 +746,9 @@ void igWindowRectRelToAbs_cwrap(struct ImRect* a0, struct ImGuiWindow* a1, struc
 void igWindowPosRelToAbs_cwrap(struct ImVec2* a0, struct ImGuiWindow* a1, struct ImVec2* a2){
   return igWindowPosRelToAbs(a0, a1, *a2);
 }
+void igWindowPosRelToAbs_flat(struct ImVec2* a0, struct ImGuiWindow* a1, float a2_x, float a2_y){
+  return igWindowPosRelToAbs(a0, a1, (struct ImVec2){a2_x, a2_y});
+}
 void igScrollToRect_cwrap(struct ImGuiWindow* a0, struct ImRect* a1, int a2){
   return igScrollToRect(a0, *a1, a2);
 }
@@ -404,6 +761,9 @@ void igScrollToBringRectIntoView_cwrap(struct ImGuiWindow* a0, struct ImRect* a1
 void igItemSize_Vec2_cwrap(struct ImVec2* a0, float a1){
   return igItemSize_Vec2(*a0, a1);
 }
+void igItemSize_Vec2_flat(float a0_x, float a0_y, float a1){
+  return igItemSize_Vec2((struct ImVec2){a0_x, a0_y}, a1);
+}
 void igItemSize_Rect_cwrap(struct ImRect* a0, float a1){
   return igItemSize_Rect(*a0, a1);
 }
@@ -422,15 +782,27 @@ void igSetLastItemData_cwrap(unsigned int a0, int a1, int a2, struct ImRect* a3)
 void igCalcItemSize_cwrap(struct ImVec2* a0, struct ImVec2* a1, float a2, float a3){
   return igCalcItemSize(a0, *a1, a2, a3);
 }
+void igCalcItemSize_flat(struct ImVec2* a0, float a1_x, float a1_y, float a2, float a3){
+  return igCalcItemSize(a0, (struct ImVec2){a1_x, a1_y}, a2, a3);
+}
 float igCalcWrapWidthForPos_cwrap(struct ImVec2* a0, float a1){
   return igCalcWrapWidthForPos(*a0, a1);
 }
+float igCalcWrapWidthForPos_flat(float a0_x, float a0_y, float a1){
+  return igCalcWrapWidthForPos((struct ImVec2){a0_x, a0_y}, a1);
+}
 bool igBeginChildEx_cwrap(char* a0, unsigned int a1, struct ImVec2* a2, bool a3, int a4){
   return igBeginChildEx(a0, a1, *a2, a3, a4);
 }
+bool igBeginChildEx_flat(char* a0, unsigned int a1, float a2_x, float a2_y, bool a3, int a4){
+  return igBeginChildEx(a0, a1, (struct ImVec2){a2_x, a2_y}, a3, a4);
+}
 void igFindBestWindowPosForPopupEx_cwrap(struct ImVec2* a0, struct ImVec2* a1, struct ImVec2* a2, int* a3, struct ImRect* a4, struct ImRect* a5, ImGuiPopupPositionPolicy a6){
   return igFindBestWindowPosForPopupEx(a0, *a1, *a2, a3, *a4, *a5, a6);
 }
+void igFindBestWindowPosForPopupEx_flat(struct ImVec2* a0, float a1_x, float a1_y, float a2_x, float a2_y, int* a3, struct ImRect* a4, struct ImRect* a5, ImGuiPopupPositionPolicy a6){
+  return igFindBestWindowPosForPopupEx(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, a3, *a4, *a5, a6);
+}
 bool igBeginComboPopup_cwrap(unsigned int a0, struct ImRect* a1, int a2){
   return igBeginComboPopup(a0, *a1, a2);
 }
@@ -449,60 +821,108 @@ void igSetWindowClipRectBeforeSetChannel_cwrap(struct ImGuiWindow* a0, struct Im
 bool igBeginTableEx_cwrap(char* a0, unsigned int a1, int a2, int a3, struct ImVec2* a4, float a5){
   return igBeginTableEx(a0, a1, a2, a3, *a4, a5);
 }
+bool igBeginTableEx_flat(char* a0, unsigned int a1, int a2, int a3, float a4_x, float a4_y, float a5){
+  return igBeginTableEx(a0, a1, a2, a3, (struct ImVec2){a4_x, a4_y}, a5);
+}
 bool igBeginTabBarEx_cwrap(struct ImGuiTabBar* a0, struct ImRect* a1, int a2){
   return igBeginTabBarEx(a0, *a1, a2);
 }
 void igTabBarQueueReorderFromMousePos_cwrap(struct ImGuiTabBar* a0, struct ImGuiTabItem* a1, struct ImVec2* a2){
   return igTabBarQueueReorderFromMousePos(a0, a1, *a2);
 }
+void igTabBarQueueReorderFromMousePos_flat(struct ImGuiTabBar* a0, struct ImGuiTabItem* a1, float a2_x, float a2_y){
+  return igTabBarQueueReorderFromMousePos(a0, a1, (struct ImVec2){a2_x, a2_y});
+}
 void igTabItemBackground_cwrap(struct ImDrawList* a0, struct ImRect* a1, int a2, unsigned int a3){
   return igTabItemBackground(a0, *a1, a2, a3);
 }
 void igTabItemLabelAndCloseButton_cwrap(struct ImDrawList* a0, struct ImRect* a1, int a2, struct ImVec2* a3, char* a4, unsigned int a5, unsigned int a6, bool a7, bool* a8, bool* a9){
   return igTabItemLabelAndCloseButton(a0, *a1, a2, *a3, a4, a5, a6, a7, a8, a9);
 }
+void igTabItemLabelAndCloseButton_flat(struct ImDrawList* a0, struct ImRect* a1, int a2, float a3_x, float a3_y, char* a4, unsigned int a5, unsigned int a6, bool a7, bool* a8, bool* a9){
+  return igTabItemLabelAndCloseButton(a0, *a1, a2, (struct ImVec2){a3_x, a3_y}, a4, a5, a6, a7, a8, a9);
+}
 void igRenderText_cwrap(struct ImVec2* a0, char* a1, char* a2, bool a3){
   return igRenderText(*a0, a1, a2, a3);
 }
+void igRenderText_flat(float a0_x, float a0_y, char* a1, char* a2, bool a3){
+  return igRenderText((struct ImVec2){a0_x, a0_y}, a1, a2, a3);
+}
 void igRenderTextWrapped_cwrap(struct ImVec2* a0, char* a1, char* a2, float a3){
   return igRenderTextWrapped(*a0, a1, a2, a3);
 }
+void igRenderTextWrapped_flat(float a0_x, float a0_y, char* a1, char* a2, float a3){
+  return igRenderTextWrapped((struct ImVec2){a0_x, a0_y}, a1, a2, a3);
+}
 void igRenderTextClipped_cwrap(struct ImVec2* a0, struct ImVec2* a1, char* a2, char* a3, struct ImVec2* a4, struct ImVec2* a5, struct ImRect* a6){
   return igRenderTextClipped(*a0, *a1, a2, a3, a4, *a5, a6);
 }
+void igRenderTextClipped_flat(float a0_x, float a0_y, float a1_x, float a1_y, char* a2, char* a3, struct ImVec2* a4, float a5_x, float a5_y, struct ImRect* a6){
+  return igRenderTextClipped((struct ImVec2){a0_x, a0_y}, (struct ImVec2){a1_x, a1_y}, a2, a3, a4, (struct ImVec2){a5_x, a5_y}, a6);
+}
 void igRenderTextClippedEx_cwrap(struct ImDrawList* a0, struct ImVec2* a1, struct ImVec2* a2, char* a3, char* a4, struct ImVec2* a5, struct ImVec2* a6, struct ImRect* a7){
   return igRenderTextClippedEx(a0, *a1, *a2, a3, a4, a5, *a6, a7);
 }
+void igRenderTextClippedEx_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2_x, float a2_y, char* a3, char* a4, struct ImVec2* a5, float a6_x, float a6_y, struct ImRect* a7){
+  return igRenderTextClippedEx(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, a3, a4, a5, (struct ImVec2){a6_x, a6_y}, a7);
+}
 void igRenderTextEllipsis_cwrap(struct ImDrawList* a0, struct ImVec2* a1, struct ImVec2* a2, float a3, float a4, char* a5, char* a6, struct ImVec2* a7){
   return igRenderTextEllipsis(a0, *a1, *a2, a3, a4, a5, a6, a7);
 }
+void igRenderTextEllipsis_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2_x, float a2_y, float a3, float a4, char* a5, char* a6, struct ImVec2* a7){
+  return igRenderTextEllipsis(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, a3, a4, a5, a6, a7);
+}
 void igRenderFrame_cwrap(struct ImVec2* a0, struct ImVec2* a1, unsigned int a2, bool a3, float a4){
   return igRenderFrame(*a0, *a1, a2, a3, a4);
 }
+void igRenderFrame_flat(float a0_x, float a0_y, float a1_x, float a1_y, unsigned int a2, bool a3, float a4){
+  return igRenderFrame((struct ImVec2){a0_x, a0_y}, (struct ImVec2){a1_x, a1_y}, a2, a3, a4);
+}
 void igRenderFrameBorder_cwrap(struct ImVec2* a0, struct ImVec2* a1, float a2){
   return igRenderFrameBorder(*a0, *a1, a2);
 }
+void igRenderFrameBorder_flat(float a0_x, float a0_y, float a1_x, float a1_y, float a2){
+  return igRenderFrameBorder((struct ImVec2){a0_x, a0_y}, (struct ImVec2){a1_x, a1_y}, a2);
+}
 void igRenderColorRectWithAlphaCheckerboard_cwrap(struct ImDrawList* a0, struct ImVec2* a1, struct ImVec2* a2, unsigned int a3, float a4, struct ImVec2* a5, float a6, int a7){
   return igRenderColorRectWithAlphaCheckerboard(a0, *a1, *a2, a3, a4, *a5, a6, a7);
 }
+void igRenderColorRectWithAlphaCheckerboard_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2_x, float a2_y, unsigned int a3, float a4, float a5_x, float a5_y, float a6, int a7){
+  return igRenderColorRectWithAlphaCheckerboard(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, a3, a4, (struct ImVec2){a5_x, a5_y}, a6, a7);
+}
 void igRenderNavHighlight_cwrap(struct ImRect* a0, unsigned int a1, int a2){
   return igRenderNavHighlight(*a0, a1, a2);
 }
 void igRenderMouseCursor_cwrap(struct ImVec2* a0, float a1, int a2, unsigned int a3, unsigned int a4, unsigned int a5){
   return igRenderMouseCursor(*a0, a1, a2, a3, a4, a5);
 }
+void igRenderMouseCursor_flat(float a0_x, float a0_y, float a1, int a2, unsigned int a3, unsigned int a4, unsigned int a5){
+  return igRenderMouseCursor((struct ImVec2){a0_x, a0_y}, a1, a2, a3, a4, a5);
+}
 void igRenderArrow_cwrap(struct ImDrawList* a0, struct ImVec2* a1, unsigned int a2, int a3, float a4){
   return igRenderArrow(a0, *a1, a2, a3, a4);
 }
+void igRenderArrow_flat(struct ImDrawList* a0, float a1_x, float a1_y, unsigned int a2, int a3, float a4){
+  return igRenderArrow(a0, (struct ImVec2){a1_x, a1_y}, a2, a3, a4);
+}
 void igRenderBullet_cwrap(struct ImDrawList* a0, struct ImVec2* a1, unsigned int a2){
   return igRenderBullet(a0, *a1, a2);
 }
+void igRenderBullet_flat(struct ImDrawList* a0, float a1_x, float a1_y, unsigned int a2){
+  return igRenderBullet(a0, (struct ImVec2){a1_x, a1_y}, a2);
+}
 void igRenderCheckMark_cwrap(struct ImDrawList* a0, struct ImVec2* a1, unsigned int a2, float a3){
   return igRenderCheckMark(a0, *a1, a2, a3);
 }
+void igRenderCheckMark_flat(struct ImDrawList* a0, float a1_x, float a1_y, unsigned int a2, float a3){
+  return igRenderCheckMark(a0, (struct ImVec2){a1_x, a1_y}, a2, a3);
+}
 void igRenderArrowPointingAt_cwrap(struct ImDrawList* a0, struct ImVec2* a1, struct ImVec2* a2, int a3, unsigned int a4){
   return igRenderArrowPointingAt(a0, *a1, *a2, a3, a4);
 }
+void igRenderArrowPointingAt_flat(struct ImDrawList* a0, float a1_x, float a1_y, float a2_x, float a2_y, int a3, unsigned int a4){
+  return igRenderArrowPointingAt(a0, (struct ImVec2){a1_x, a1_y}, (struct ImVec2){a2_x, a2_y}, a3, a4);
+}
 void igRenderRectFilledRangeH_cwrap(struct ImDrawList* a0, struct ImRect* a1, unsigned int a2, float a3, float a4, float a5){
   return igRenderRectFilledRangeH(a0, *a1, a2, a3, a4, a5);
 }
@@ -512,18 +932,33 @@ void igRenderRectFilledWithHole_cwrap(struct ImDrawList* a0, struct ImRect* a1,
 bool igButtonEx_cwrap(char* a0, struct ImVec2* a1, int a2){
   return igButtonEx(a0, *a1, a2);
 }
+bool igButtonEx_flat(char* a0, float a1_x, float a1_y, int a2){
+  return igButtonEx(a0, (struct ImVec2){a1_x, a1_y}, a2);
+}
 bool igArrowButtonEx_cwrap(char* a0, int a1, struct ImVec2* a2, int a3){
   return igArrowButtonEx(a0, a1, *a2, a3);
 }
+bool igArrowButtonEx_flat(char* a0, int a1, float a2_x, float a2_y, int a3){
+  return igArrowButtonEx(a0, a1, (struct ImVec2){a2_x, a2_y}, a3);
+}
 bool igImageButtonEx_cwrap(unsigned int a0, void* a1, struct ImVec2* a2, struct ImVec2* a3, struct ImVec2* a4, struct ImVec4* a5, struct ImVec4* a6, int a7){
   return igImageButtonEx(a0, a1, *a2, *a3, *a4, *a5, *a6, a7);
 }
+bool igImageButtonEx_flat(unsigned int a0, void* a1, float a2_x, float a2_y, float a3_x, float a3_y, float a4_x, float a4_y, float a5_x, float a5_y, float a5_z, float a5_w, float a6_x, float a6_y, float a6_z, float a6_w, int a7){
+  return igImageButtonEx(a0, a1, (struct ImVec2){a2_x, a2_y}, (struct ImVec2){a3_x, a3_y}, (struct ImVec2){a4_x, a4_y}, (struct ImVec4){a5_x, a5_y, a5_z, a5_w}, (struct ImVec4){a6_x, a6_y, a6_z, a6_w}, a7);
+}
 bool igCloseButton_cwrap(unsigned int a0, struct ImVec2* a1){
   return igCloseButton(a0, *a1);
 }
+bool igCloseButton_flat(unsigned int a0, float a1_x, float a1_y){
+  return igCloseButton(a0, (struct ImVec2){a1_x, a1_y});
+}
 bool igCollapseButton_cwrap(unsigned int a0, struct ImVec2* a1){
   return igCollapseButton(a0, *a1);
 }
+bool igCollapseButton_flat(unsigned int a0, float a1_x, float a1_y){
+  return igCollapseButton(a0, (struct ImVec2){a1_x, a1_y});
+}
 bool igScrollbarEx_cwrap(struct ImRect* a0, unsigned int a1, ImGuiAxis a2, long long int* a3, long long int a4, long long int a5, int a6){
   return igScrollbarEx(*a0, a1, a2, a3, a4, a5, a6);
 }
@@ -539,6 +974,9 @@ bool igSplitterBehavior_cwrap(struct ImRect* a0, unsigned int a1, ImGuiAxis a2,
 bool igInputTextEx_cwrap(char* a0, char* a1, char* a2, int a3, struct ImVec2* a4, int a5, void* a6, void* a7){
   return igInputTextEx(a0, a1, a2, a3, *a4, a5, a6, a7);
 }
+bool igInputTextEx_flat(char* a0, char* a1, char* a2, int a3, float a4_x, float a4_y, int a5, void* a6, void* a7){
+  return igInputTextEx(a0, a1, a2, a3, (struct ImVec2){a4_x, a4_y}, a5, a6, a7);
+}
 bool igTempInputText_cwrap(struct ImRect* a0, unsigned int a1, char* a2, char* a3, int a4, int a5){
   return igTempInputText(*a0, a1, a2, a3, a4, a5);
 }
@@ -548,12 +986,21 @@ bool igTempInputScalar_cwrap(struct ImRect* a0, unsigned int a1, char* a2, int a
 int igPlotEx_cwrap(ImGuiPlotType a0, char* a1, void* a2, void* a3, int a4, int a5, char* a6, float a7, float a8, struct ImVec2* a9){
   return igPlotEx(a0, a1, a2, a3, a4, a5, a6, a7, a8, *a9);
 }
+int igPlotEx_flat(ImGuiPlotType a0, char* a1, void* a2, void* a3, int a4, int a5, char* a6, float a7, float a8, float a9_x, float a9_y){
+  return igPlotEx(a0, a1, a2, a3, a4, a5, a6, a7, a8, (struct ImVec2){a9_x, a9_y});
+}
 void igShadeVertsLinearColorGradientKeepAlpha_cwrap(struct ImDrawList* a0, int a1, int a2, struct ImVec2* a3, struct ImVec2* a4, unsigned int a5, unsigned int a6){
   return igShadeVertsLinearColorGradientKeepAlpha(a0, a1, a2, *a3, *a4, a5, a6);
 }
+void igShadeVertsLinearColorGradientKeepAlpha_flat(struct ImDrawList* a0, int a1, int a2, float a3_x, float a3_y, float a4_x, float a4_y, unsigned int a5, unsigned int a6){
+  return igShadeVertsLinearColorGradientKeepAlpha(a0, a1, a2, (struct ImVec2){a3_x, a3_y}, (struct ImVec2){a4_x, a4_y}, a5, a6);
+}
 void igShadeVertsLinearUV_cwrap(struct ImDrawList* a0, int a1, int a2, struct ImVec2* a3, struct ImVec2* a4, struct ImVec2* a5, struct ImVec2* a6, bool a7){
   return igShadeVertsLinearUV(a0, a1, a2, *a3, *a4, *a5, *a6, a7);
 }
+void igShadeVertsLinearUV_flat(struct ImDrawList* a0, int a1, int a2, float a3_x, float a3_y, float a4_x, float a4_y, float a5_x, float a5_y, float a6_x, float a6_y, bool a7){
+  return igShadeVertsLinearUV(a0, a1, a2, (struct ImVec2){a3_x, a3_y}, (struct ImVec2){a4_x, a4_y}, (struct ImVec2){a5_x, a5_y}, (struct ImVec2){a6_x, a6_y}, a7);
+}
 void igDebugRenderViewportThumbnail_cwrap(struct ImDrawList* a0, struct ImGuiViewportP* a1, struct ImRect* a2){
   return igDebugRenderViewportThumbnail(a0, a1, *a2);
 }
@@ -14,9 +14,21 @@ globalThis.on_init = function on_init(): void {
   }
 };
 
+// Expose the previous frame's temp arena usage and native allocations next
+// to the render metrics
+function publishTmpStats(): void {
+  setRuntimeMetric(METRIC_TMP_BYTES, tmpStatsFrameBytes());
+  setRuntimeMetric(METRIC_TMP_PEAK_BYTES, tmpStatsPeakBytes());
+  setRuntimeMetric(METRIC_TMP_BLOCKS, tmpStatsBlocks());
+  setRuntimeMetric(METRIC_TMP_ALLOCS, tmpStatsAllocs());
+  setRuntimeMetric(METRIC_NATIVE_ALLOCS, nativeStatsAllocs());
+  setRuntimeMetric(METRIC_NATIVE_ALLOC_BYTES, nativeStatsAllocBytes());
+}
+
 globalThis.on_frame = function on_frame(width: number, height: number, curTime: number): void {
   // Flush temporary allocations from previous frame
   flushAllocTmp();
+  publishTmpStats();
 
   // Render the React tree (callbacks are invoked directly during rendering)
   const imguiUnit = (globalThis as any).imguiUnit;
@@ -25,7 +37,33 @@ globalThis.on_frame = function on_frame(width: number, height: number, curTime:
   }
 };
 
-globalThis.on_event = function on_event(type: number, key_code: number, modifiers: number): void {
-  // Handle events if needed
-  // For now, we'll just pass through
+// Input events of the last frame, in arrival order (consecutive mouse moves
+// and scrolls merged unless sappConfig.raw_input_events is set). `count`
+// sapp_event records start at imgui_input_events(); they are only valid
+// during this call.
+const _imgui_input_events = $SHBuiltin.extern_c({}, function imgui_input_events(): c_ptr {
+  throw 0;
+});
+
+/// Pointer to the native sapp_event `index` of the current batch. Read its
+/// fields with the get_sapp_event_*() accessors in sapp.js, e.g.
+/// get_sapp_event_mouse_x(inputEvent(i)); nothing is marshalled.
+function inputEvent(index: number): c_ptr {
+  return _sh_ptr_add(_imgui_input_events(), index * _sizeof_sapp_event);
+}
+
+const _imgui_set_input_event_mask = $SHBuiltin.extern_c({}, function imgui_set_input_event_mask(mask: c_uint): void {
+  throw 0;
+});
+
+// The event types on_events() handles, as bits 1 << _SAPP_EVENTTYPE_*. The
+// runtime queues only these for it, and skips the call in frames without
+// any; every event still goes to ImGui. None for now: widgets get their
+// input through ImGui.
+const INPUT_EVENT_MASK = 0;
+_imgui_set_input_event_mask(INPUT_EVENT_MASK);
+
+globalThis.on_events = function on_events(count: number): void {
+  // Nothing is subscribed (INPUT_EVENT_MASK); handle the records of the
+  // types added there with inputEvent(i)
 };
@@ -0,0 +1,31 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// ID stack entry for renderer nodes.
+// Every node pushes its numeric id onto ImGui's ID stack, which hashes it
+// with the ID on top of the stack. The renderer keeps the resulting ImGuiID
+// on the node together with the seed it was hashed with; while the seed is
+// the same, which is every frame unless the node moved to another parent,
+// window or cell, the cached ID is pushed as is, without hashing.
+
+#define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
+#include "cimgui.h"
+
+// Seed of the last node_push_id() call.
+static ImGuiID s_seed;
+
+// Push the ID of node `n`. `seed` and `id` are the node's cached seed and
+// ID (0 if none); the ID of the node is returned, and if it differs from
+// `id`, node_id_seed() returns the seed it was hashed with.
+ImGuiID node_push_id(int n, ImGuiID seed, ImGuiID id) {
+  ImGuiWindow *window = igGetCurrentWindowRead();
+  ImGuiID top = window->IDStack.Data[window->IDStack.Size - 1];
+  if (id == 0 || seed != top)
+    id = igGetIDWithSeed_Int(n, top);
+  s_seed = top;
+  igPushOverrideID(id);
+  return id;
+}
+
+ImGuiID node_id_seed(void) { return s_seed; }
@@ -0,0 +1,55 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// <number>: a double formatted with snprintf() straight into ImGui, so that
+// numeric text never goes through React, text nodes or the UTF-8 encoder.
+// The format is encoded once per change of the prop and checked by
+// number_format_valid() before it is ever passed to snprintf().
+
+#define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
+#include "cimgui.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+// Whether `fmt` is safe to format one double with: any text, "%%" escapes
+// and exactly one floating point conversion (%f %F %e %E %g %G %a %A, with
+// flags, width, precision and an optional `l`, but no `*`).
+bool number_format_valid(const char *fmt) {
+  int conversions = 0;
+  for (const char *p = fmt; *p; ++p) {
+    if (*p != '%')
+      continue;
+    ++p;
+    if (*p == '%')
+      continue;
+    while (*p && strchr("-+ #0", *p))
+      ++p;
+    while (*p >= '0' && *p <= '9')
+      ++p;
+    if (*p == '.') {
+      ++p;
+      while (*p >= '0' && *p <= '9')
+        ++p;
+    }
+    if (*p == 'l')
+      ++p;
+    if (!*p || !strchr("fFeEgGaA", *p) || ++conversions > 1)
+      return false;
+  }
+  return conversions == 1;
+}
+
+// Submit `value` formatted by `fmt`, which number_format_valid() accepted,
+// as text. Output beyond the buffer is cut off.
+void number_text(const char *fmt, double value) {
+  char buf[128];
+  int n = snprintf(buf, sizeof(buf), fmt, value);
+  if (n < 0)
+    return;
+  if (n >= (int)sizeof(buf))
+    n = (int)sizeof(buf) - 1;
+  igTextUnformatted(buf, buf + n);
+}
@@ -0,0 +1,78 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// Downsampling for <plotlines> and <plothistogram>.
+// ImGui's PlotLines() samples one value per pixel and PlotHistogram() draws
+// a bar per value, so a series much longer than the plot is wide costs time
+// without adding detail, and loses its spikes between samples. The renderer
+// reduces such a series to the width of the plot instead: lines keep the
+// minimum and the maximum of every two-pixel bucket, in the order they
+// occur, so the envelope of the data survives; histograms keep the largest
+// value of every one-pixel bucket. NaNs are skipped.
+
+#define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
+#include "cimgui.h"
+#include <math.h>
+
+// The number of buckets of a plot `width` wide (0 for ImGui's item width).
+int plot_buckets(float width, bool histogram) {
+  float w = width > 0 ? width : igCalcItemWidth();
+  int pixels = (int)(w - 2 * igGetStyle()->FramePadding.x);
+  int buckets = histogram ? pixels : pixels / 2;
+  return buckets > 1 ? buckets : 1;
+}
+
+// Writes `n` values of the series, from value `start` of its logical order,
+// to `out`: all of them if at most `buckets` (histograms) or 2 * `buckets`
+// (lines), otherwise reduced to that many. Value i of the logical order is
+// values[(offset + i) % count], as with ImGui's values_offset. Returns the
+// number of values written.
+int plot_reduce(const float *values, int count, int offset, int start, int n,
+                int buckets, bool histogram, float *out) {
+  int index = (int)(((long long)offset + start) % count);
+  if (index < 0)
+    index += count;
+  int points = histogram ? buckets : 2 * buckets;
+  if (n <= points) {
+    for (int i = 0; i < n; ++i) {
+      out[i] = values[index];
+      if (++index == count)
+        index = 0;
+    }
+    return n;
+  }
+
+  int written = 0;
+  int i = 0;
+  for (int b = 0; b < buckets; ++b) {
+    int end = (int)((long long)n * (b + 1) / buckets);
+    float lo = NAN, hi = NAN;
+    int loAt = 0, hiAt = 0;
+    for (; i < end; ++i) {
+      float v = values[index];
+      if (++index == count)
+        index = 0;
+      if (isnan(v))
+        continue;
+      if (!(v >= lo)) {
+        lo = v;
+        loAt = i;
+      }
+      if (!(v <= hi)) {
+        hi = v;
+        hiAt = i;
+      }
+    }
+    if (histogram) {
+      out[written++] = hi;
+    } else if (loAt <= hiAt) {
+      out[written++] = lo;
+      out[written++] = hi;
+    } else {
+      out[written++] = hi;
+      out[written++] = lo;
+    }
+  }
+  return written;
+}
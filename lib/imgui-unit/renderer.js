@@ -7,55 +7,181 @@
 
 // ImGui renderer loaded
 
+// Development checks: prop validation messages and the tag table check.
+// With IMGUI_UNIT_CHECKS=OFF (the default of Release builds),
+// prune-externs.py replaces the constant with 0 and shermes drops the
+// blocks it guards. Values are still sanitized either way.
+const _IMGUI_UNIT_CHECKS = 1;
+
+// Node type tags, assigned by the reconciler (react-imgui-reconciler/node-tags.js).
+// Keep in sync with NodeTag there; checkNodeTags() verifies this at load time.
+const TAG_UNKNOWN = 0;
+const TAG_TEXT_NODE = 1;
+const TAG_ROOT = 2;
+const TAG_WINDOW = 3;
+const TAG_CHILD = 4;
+const TAG_BUTTON = 5;
+const TAG_TEXT = 6;
+const TAG_GROUP = 7;
+const TAG_SEPARATOR = 8;
+const TAG_SAMELINE = 9;
+const TAG_INDENT = 10;
+const TAG_COLLAPSINGHEADER = 11;
+const TAG_TABLE = 12;
+const TAG_TABLEHEADER = 13;
+const TAG_TABLEROW = 14;
+const TAG_TABLECELL = 15;
+const TAG_TABLECOLUMN = 16;
+const TAG_RECT = 17;
+const TAG_CIRCLE = 18;
+const TAG_RADIALMENU = 19;
+const TAG_CANVAS = 20;
+const TAG_PLOTLINES = 21;
+const TAG_PLOTHISTOGRAM = 22;
+const TAG_INPUTTEXT = 23;
+const TAG_COMBO = 24;
+const TAG_LISTBOX = 25;
+const TAG_IMAGE = 26;
+const TAG_VIRTUALLIST = 27;
+const TAG_TREENODE = 28;
+const TAG_DATAGRID = 29;
+const TAG_TEXTVIEW = 30;
+const TAG_HEATMAP = 31;
+const TAG_STATIC = 32;
+const TAG_TABBAR = 33;
+const TAG_TABITEM = 34;
+const TAG_FONT = 35;
+const TAG_NUMBER = 36;
+
 /**
- * Parse a color value to ImVec4 format.
+ * Verifies that the tags published by the reconciler match the ones above.
+ * A mismatch means the two tables were edited separately.
+ */
+function checkNodeTags(): void {
+  const registry = (globalThis as any).imguiNodeTags;
+  if (!registry) {
+    console.error("globalThis.imguiNodeTags is missing. Was the React unit loaded first?");
+    return;
+  }
+  const names: any = [
+    "root", "window", "child", "button", "text", "group", "separator",
+    "sameline", "indent", "collapsingheader", "table", "tableheader",
+    "tablerow", "tablecell", "tablecolumn", "rect", "circle", "radialmenu",
+    "canvas", "plotlines", "plothistogram", "inputtext", "combo", "listbox",
+    "image", "virtuallist", "treenode", "datagrid",
+    "textview", "heatmap", "static",
+    "tabbar", "tabitem", "font", "number",
+  ];
+  const tags: any = [
+    TAG_ROOT, TAG_WINDOW, TAG_CHILD, TAG_BUTTON, TAG_TEXT, TAG_GROUP, TAG_SEPARATOR,
+    TAG_SAMELINE, TAG_INDENT, TAG_COLLAPSINGHEADER, TAG_TABLE, TAG_TABLEHEADER,
+    TAG_TABLEROW, TAG_TABLECELL, TAG_TABLECOLUMN, TAG_RECT, TAG_CIRCLE, TAG_RADIALMENU,
+    TAG_CANVAS, TAG_PLOTLINES, TAG_PLOTHISTOGRAM, TAG_INPUTTEXT, TAG_COMBO, TAG_LISTBOX,
+    TAG_IMAGE, TAG_VIRTUALLIST, TAG_TREENODE, TAG_DATAGRID,
+    TAG_TEXTVIEW, TAG_HEATMAP, TAG_STATIC,
+    TAG_TABBAR, TAG_TABITEM, TAG_FONT, TAG_NUMBER,
+  ];
+  for (let i = 0; i < names.length; i++) {
+    if (registry[names[i]] !== tags[i]) {
+      console.error(
+        `Node tag mismatch for <${names[i]}>: reconciler=${registry[names[i]]}, renderer=${tags[i]}`
+      );
+    }
+  }
+}
+
+if (_IMGUI_UNIT_CHECKS) checkNodeTags();
+
+/**
+ * Returns the value of a hex digit character code, or -1.
+ */
+function hexDigitValue(code: number): number {
+  if (code >= 48 && code <= 57) return code - 48;        // 0-9
+  if (code >= 97 && code <= 102) return code - 87;       // a-f
+  if (code >= 65 && code <= 70) return code - 55;        // A-F
+  return -1;
+}
+
+/**
+ * Clamps a color channel to an integer in [0, 255].
+ */
+function colorChannel(v: number): number {
+  if (v <= 0) return 0;
+  if (v >= 255) return 255;
+  return Math.floor(v);
+}
+
+/**
+ * Parse a color value to ABGR format (ImU32, used by ImGui DrawList).
  * Supports hex strings (#RRGGBB or #RRGGBBAA) and objects {r,g,b,a}.
- * @param outVec Pointer to ImVec4 output buffer (caller must allocate)
- * @param color Color value to parse
+ * Invalid colors fall back to white.
+ * Returns a 32-bit unsigned integer in ABGR format.
  */
-function parseColorToImVec4(outVec: c_ptr, color: any): void {
+function parseColorToABGR(color: any): number {
   let r = 255, g = 255, b = 255, a = 255;
 
-  if (typeof color === 'string' && color.startsWith('#')) {
-    const hex = color.slice(1);
-    if (hex.length === 6 || hex.length === 8) {
-      r = parseInt(hex.slice(0, 2), 16);
-      g = parseInt(hex.slice(2, 4), 16);
-      b = parseInt(hex.slice(4, 6), 16);
-      a = hex.length > 6 ? parseInt(hex.slice(6, 8), 16) : 255;
+  if (typeof color === 'string') {
+    // Fast path: decode the hex digits directly from the character codes
+    const len = color.length;
+    if ((len === 7 || len === 9) && color.charCodeAt(0) === 35 /* '#' */) {
+      let v = 0;
+      let i = 1;
+      for (; i < len; ++i) {
+        const d = hexDigitValue(color.charCodeAt(i));
+        if (d < 0) break;
+        v = v * 16 + d;
+      }
+      if (i === len) {
+        if (len === 9) {
+          r = (v >>> 24) & 0xFF;
+          g = (v >>> 16) & 0xFF;
+          b = (v >>> 8) & 0xFF;
+          a = v & 0xFF;
+        } else {
+          r = (v >>> 16) & 0xFF;
+          g = (v >>> 8) & 0xFF;
+          b = v & 0xFF;
+        }
+      }
     }
-    // Invalid length - fall through with white
+    // Invalid format or digits - fall through with white
   } else if (typeof color === 'object' && color !== null) {
-    r = +color.r;
-    g = +color.g;
-    b = +color.b;
-    a = color.a !== undefined ? +color.a : 255;
+    const cr = +color.r;
+    const cg = +color.g;
+    const cb = +color.b;
+    const ca = color.a !== undefined ? +color.a : 255;
+    // NaN components fall back to white
+    if (!isNaN(cr + cg + cb + ca)) {
+      r = colorChannel(cr);
+      g = colorChannel(cg);
+      b = colorChannel(cb);
+      a = colorChannel(ca);
+    }
   }
 
-  // Check for NaN (invalid hex digits) - fall back to white
-  if (isNaN(r + g + b + a)) {
-    r = g = b = a = 255;
-  }
+  return ((a << 24) | (b << 16) | (g << 8) | r) >>> 0;
+}
 
-  set_ImVec4_x(outVec, r * (1/255));
-  set_ImVec4_y(outVec, g * (1/255));
-  set_ImVec4_z(outVec, b * (1/255));
-  set_ImVec4_w(outVec, a * (1/255));
+/**
+ * Store a packed ABGR color into an ImVec4 as normalized floats.
+ * @param outVec Pointer to ImVec4 output buffer (caller must allocate)
+ * @param abgr Packed color from parseColorToABGR()
+ */
+function setImVec4FromABGR(outVec: c_ptr, abgr: number): void {
+  set_ImVec4_x(outVec, (abgr & 0xFF) * (1/255));
+  set_ImVec4_y(outVec, ((abgr >>> 8) & 0xFF) * (1/255));
+  set_ImVec4_z(outVec, ((abgr >>> 16) & 0xFF) * (1/255));
+  set_ImVec4_w(outVec, (abgr >>> 24) * (1/255));
 }
 
 /**
- * Parse a color value to ABGR format (used by ImGui DrawList).
+ * Parse a color value to ImVec4 format.
  * Supports hex strings (#RRGGBB or #RRGGBBAA) and objects {r,g,b,a}.
- * Returns a 32-bit unsigned integer in ABGR format.
+ * @param outVec Pointer to ImVec4 output buffer (caller must allocate)
+ * @param color Color value to parse
  */
-function parseColorToABGR(color: any): number {
-  const vec = allocTmp(_sizeof_ImVec4);
-  parseColorToImVec4(vec, color);
-  const r = Math.floor(+get_ImVec4_x(vec) * 255);
-  const g = Math.floor(+get_ImVec4_y(vec) * 255);
-  const b = Math.floor(+get_ImVec4_z(vec) * 255);
-  const a = Math.floor(+get_ImVec4_w(vec) * 255);
-  return ((a << 24) | (b << 16) | (g << 8) | r) >>> 0;
+function parseColorToImVec4(outVec: c_ptr, color: any): void {
+  setImVec4FromABGR(outVec, parseColorToABGR(color));
 }
 
 /**
@@ -68,34 +194,317 @@ function parseColorToABGR(color: any): number {
 function validateNumber(value: any, defaultValue: number, propName: string): number {
   const num = +value;
   if (!Number.isFinite(num)) {
-    console.error(`Invalid ${propName}: ${value} (NaN or Infinity). Using ${defaultValue}.`);
+    if (_IMGUI_UNIT_CHECKS) {
+      console.error(`Invalid ${propName}: ${value} (NaN or Infinity). Using ${defaultValue}.`);
+    }
     return defaultValue;
   }
   return num;
 }
 
 /**
- * Safely invokes a callback with exception handling.
+ * Returns the persistent slot at `index` in a node's slot list, or -1.
+ */
+function nodeSlot(node: any, index: number): number {
+  const slots = node.nativeSlots;
+  if (!slots || slots[index] === undefined) return -1;
+  return +slots[index];
+}
+
+/**
+ * Records `slot` at `index` in a node's slot list.
+ */
+function setNodeSlot(node: any, index: number, slot: number): void {
+  let slots = node.nativeSlots;
+  if (!slots) {
+    slots = [];
+    node.nativeSlots = slots;
+  }
+  slots[index] = slot;
+}
+
+/**
+ * Encodes string `index` of a node into the node's persistent UTF-8 slot and
+ * returns the slot. Plan builders call this, so a label is re-encoded only
+ * when the node's plan is rebuilt. Slots are freed by releaseNode().
+ */
+function nodeUtf8(node: any, index: number, s: any): number {
+  const slot = setUtf8Slot(nodeSlot(node, index), s);
+  setNodeSlot(node, index, slot);
+  return slot;
+}
+
+/**
+ * Makes buffer `index` of a node hold at least `size` bytes and returns its
+ * persistent slot. Freed by releaseNode() like the node's labels.
+ */
+function nodeBuffer(node: any, index: number, size: number): number {
+  const slot = reserveSlot(nodeSlot(node, index), size);
+  setNodeSlot(node, index, slot);
+  return slot;
+}
+
+/**
+ * Frees the persistent slots of a node from `count` onwards.
+ */
+function trimNodeSlots(node: any, count: number): void {
+  const slots = node.nativeSlots;
+  if (!slots) return;
+  while (slots.length > count) {
+    const slot = slots.pop();
+    if (slot !== undefined) freeSlot(+slot);
+  }
+}
+
+// Native node state store. Render state read every frame (window geometry
+// and sync flags) is kept in native columns, one malloc'ed array per field
+// indexed by a node's row, instead of in JS objects on the node; the node
+// only holds the row (`storeIndex`). Rows are reused through a free list.
+const STORE_INITIAL_ROWS = 64;
+let storeRows = 0;         // Capacity of every column, in rows
+let storeUsed = 0;         // Rows handed out so far, free or not
+let storeFree: number[] = [];
+let storeFreeCount = 0;
+// float32 columns
+let storeX: c_ptr = c_null;
+let storeY: c_ptr = c_null;
+let storeWidth: c_ptr = c_null;
+let storeHeight: c_ptr = c_null;
+// uint32 column of STORE_FLAG_* bits
+let storeFlags: c_ptr = c_null;
+const STORE_COLUMNS = 5;   // Columns above, 4 bytes per row each
+
+const STORE_FLAG_POS_SYNCED = 1;   // storeX/storeY hold the last position
+const STORE_FLAG_SIZE_SYNCED = 2;  // storeWidth/storeHeight hold the last size
+const STORE_FLAG_STATE_PENDING = 4; // Changed during a drag, onWindowState not fired yet
+const STORE_FLAG_OVER_BUDGET = 8;  // Over its drawBudget, and warned about it
+
+/**
+ * Returns a copy of the 4-byte `column` of `storeRows` rows, grown to
+ * `rows` rows, and frees the old one. The new rows are zeroed.
+ */
+function growStoreColumn(column: c_ptr, rows: number): c_ptr {
+  const grown = _calloc(rows, 4);
+  if (storeRows > 0) {
+    _memcpy(grown, column, storeRows * 4);
+    _free(column);
+  }
+  return grown;
+}
+
+/**
+ * Returns the store row of a node, allocating a zeroed one on first use.
+ * Freed by releaseNode().
+ */
+function nodeStoreIndex(node: any): number {
+  const index = +node.storeIndex;
+  if (index >= 0) return index;
+  let row = 0;
+  if (storeFreeCount > 0) {
+    row = storeFree[--storeFreeCount];
+    const offset = row * 4;
+    _sh_ptr_write_c_float(storeX, offset, 0);
+    _sh_ptr_write_c_float(storeY, offset, 0);
+    _sh_ptr_write_c_float(storeWidth, offset, 0);
+    _sh_ptr_write_c_float(storeHeight, offset, 0);
+    _sh_ptr_write_c_uint(storeFlags, offset, 0);
+  } else {
+    if (storeUsed === storeRows) {
+      const rows = storeRows > 0 ? storeRows * 2 : STORE_INITIAL_ROWS;
+      storeX = growStoreColumn(storeX, rows);
+      storeY = growStoreColumn(storeY, rows);
+      storeWidth = growStoreColumn(storeWidth, rows);
+      storeHeight = growStoreColumn(storeHeight, rows);
+      storeFlags = growStoreColumn(storeFlags, rows);
+      storeRows = rows;
+    }
+    row = storeUsed++;
+  }
+  node.storeIndex = row;
+  return row;
+}
+
+/**
+ * Returns the store row of a node to the free list.
+ */
+function releaseStoreIndex(node: any): void {
+  const index = +node.storeIndex;
+  if (!(index >= 0)) return;
+  if (storeFreeCount < storeFree.length) {
+    storeFree[storeFreeCount] = index;
+  } else {
+    storeFree.push(index);
+  }
+  ++storeFreeCount;
+  node.storeIndex = -1;
+}
+
+// Animated values. An AnimatedValue of the React unit (the reconciler's
+// animated.js) passed as a numeric or color prop of <rect>, <circle> or
+// <text> (x={anim}) refers to a slot of the runtime's animation engine
+// (imgui-runtime/Animation.h), which the renderer reads every frame instead
+// of the prop. Drivers and timelines move the slots natively before
+// on_frame(), so an animation runs without JS: no setState, no
+// reconciliation, no commit. A slot is allocated by the first plan that
+// reads the value, or when the React unit first writes or animates it.
+// Color slots hold a packed ABGR color.
+const _imgui_anim_values = $SHBuiltin.extern_c({}, function imgui_anim_values(): c_ptr { throw 0; });
+const _imgui_anim_create = $SHBuiltin.extern_c({}, function imgui_anim_create(value: c_double): c_int { throw 0; });
+
+// The value column, fetched at the start of each frame, after a slot is
+// added and after every event callback, since any of them may add a slot
+// (__animCreate) and move it
+let animValues: c_ptr = c_null;
+
+function animatedValue(slot: number): number {
+  return _sh_ptr_read_c_double(animValues, slot * 8);
+}
+
+/**
+ * The slot of a prop value that is an AnimatedValue, allocating it on first
+ * use, or -1 for any other value.
+ */
+function animatedSlotOf(value: any): number {
+  if (value === null || typeof value !== "object" || value.isAnimatedValue !== true) return -1;
+  let slot = +value.slot;
+  if (!(slot >= 0)) {
+    slot = _imgui_anim_create(+value.initial);
+    value.slot = slot;
+    animValues = _imgui_anim_values();
+  }
+  return slot;
+}
+
+/**
+ * Releases the native resources owned by a removed subtree.
+ */
+function releaseNode(node: any): void {
+  trimNodeSlots(node, 0);
+  if (node.tag !== TAG_TEXT_NODE) {
+    releaseStoreIndex(node);
+    node.label = null;
+  }
+  if (node.tag === TAG_IMAGE && node.state !== null) releaseImage(node.state);
+  if (node.tag === TAG_TEXTVIEW && node.state !== null) releaseTextView(node.state);
+  if (node.tag === TAG_HEATMAP && node.state !== null) releaseHeatmap(node.state);
+  node.plan = null;
+  for (let c = node.firstChild; c; c = c.nextSibling) {
+    releaseNode(c);
+  }
+}
+
+// Labels of internal windows, encoded once at load time.
+const ROOT_WINDOW_LABEL = setUtf8Slot(-1, "##Root");
+const CHILD_WINDOW_LABEL = setUtf8Slot(-1, "Content");
+
+// Scratch registers: native buffers allocated once at load time and reused
+// by every render function, instead of bumping the temp arena per node.
+// ImVec2/ImVec4 arguments are passed as scalars through the generated
+// "_flat" bindings, so these only receive out-parameters (cursor position,
+// text size, ...). They must not be relied upon across a renderNode() call,
+// which reuses them. Anything that has to survive child rendering (e.g. a
+// window's p_open flag) still goes through allocTmp().
+const scratchVec2A = calloc(_sizeof_ImVec2);  // passed to render functions as `vec2`
+const scratchVec2C = calloc(_sizeof_ImVec2);
+const scratchInt = calloc(4);                 // int in/out parameters
+
+/**
+ * Returns the depth of ImGui's window stack (windows begun this frame and
+ * not yet ended, including the implicit fallback window).
+ */
+function currentWindowDepth(): number {
+  return get_ImVector_ImGuiWindowStackData_Size(
+    get_ImGuiContext_CurrentWindowStack(_igGetCurrentContext()));
+}
+
+/**
+ * Unwinds ImGui state after an exception: ends the windows and child windows
+ * begun above `windowDepth`, then restores the ID, style, color, group, tree
+ * and table stacks of the current window to their state at its Begin().
+ */
+function recoverImGuiState(windowDepth: number): void {
+  while (currentWindowDepth() > windowDepth) {
+    _igErrorCheckEndWindowRecover(c_null, c_null);
+    if (get_ImGuiWindow_Flags(_igGetCurrentWindow()) & _ImGuiWindowFlags_ChildWindow) {
+      _igEndChild();
+    } else {
+      _igEnd();
+    }
+  }
+  _igErrorCheckEndWindowRecover(c_null, c_null);
+}
+
+/**
+ * Logs an exception caught while rendering a node. The same error is
+ * typically thrown on every frame, so it is only logged when it changes.
+ */
+function reportRenderError(node: any, e: any): void {
+  const msg = (e && e.stack) ? String(e.stack) : String(e);
+  if (node.lastRenderError !== msg) {
+    node.lastRenderError = msg;
+    console.error(`Error rendering <${node.type}>:`, msg);
+  }
+}
+
+/**
+ * Renders the children of a window-level node. renderNode() has no
+ * exception frame of its own, so anything thrown below is caught here:
+ * ImGui state is unwound to this window's Begin() and the remaining
+ * children are skipped for this frame.
+ * Temporary allocations made by the subtree are released on return, so
+ * the arena only has to hold one window's worth of scratch data at a time.
+ */
+function renderWindowChildren(node: any): void {
+  if (!node.firstChild) return;
+  const windowDepth = currentWindowDepth();
+  const mark = tmpMark();
+  try {
+    for (let c = node.firstChild; c; c = c.nextSibling) {
+      renderNode(c);
+    }
+  } catch (e) {
+    recoverImGuiState(windowDepth);
+    reportRenderError(node, e);
+  }
+  tmpRelease(mark);
+}
+
+// Event kinds for globalThis.imguiEvents.dispatch() (EventKind in the
+// reconciler's event-priority.js): they pick the React priority of the
+// updates a callback schedules.
+const EVENT_DISCRETE = 0;    // clicks, edits, selections, close buttons
+const EVENT_CONTINUOUS = 1;  // window drag/resize
+
+/**
+ * Safely invokes a widget callback, as an event of the given kind, with
+ * exception handling.
+ * @param kind EVENT_DISCRETE or EVENT_CONTINUOUS
  * @param callback The callback function to invoke
  * @param args Arguments to pass to callback
  */
-function safeInvokeCallback(callback, ...args) {
+function safeInvokeEvent(kind: number, callback, ...args) {
   if (!callback || typeof callback !== 'function') {
     return;
   }
 
   try {
-    callback(...args);
+    const events = globalThis.imguiEvents;
+    if (events) {
+      events.dispatch(kind, callback, args);
+    } else {
+      callback(...args);
+    }
   } catch (e) {
     console.error("Error in callback:", e);
   }
+  animValues = _imgui_anim_values();
 }
 
 /**
- * Renders a window component with controlled/uncontrolled position and size.
+ * Builds the render plan for a window. Validation and conflict warnings run
+ * here, once per commit, instead of on every frame.
  */
-function renderWindow(node: any, vec2: c_ptr, vec4: c_ptr): void {
-  const props = node.props;
+function buildWindowPlan(props: any): any {
   const title = (props && props.title) ? props.title : "Window";
 
   // Track which properties are controlled vs uncontrolled
@@ -105,102 +514,307 @@ function renderWindow(node: any, vec2: c_ptr, vec4: c_ptr): void {
   const hasDefaultSize = props && (props.defaultWidth !== undefined || props.defaultHeight !== undefined);
 
   // Warn about conflicting props
-  if (hasControlledPos && hasDefaultPos) {
-    console.error(`Window "${title}" has both x/y and defaultX/defaultY props. Controlled props (x/y) will be used.`);
+  if (_IMGUI_UNIT_CHECKS) {
+    if (hasControlledPos && hasDefaultPos) {
+      console.error(`Window "${title}" has both x/y and defaultX/defaultY props. Controlled props (x/y) will be used.`);
+    }
+    if (hasControlledSize && hasDefaultSize) {
+      console.error(`Window "${title}" has both width/height and defaultWidth/defaultHeight props. Controlled props (width/height) will be used.`);
+    }
+  }
+
+  let x = 0, y = 0, width = 0, height = 0;
+  if (hasControlledPos) {
+    x = validateNumber(props.x !== undefined ? props.x : 0, 0, "window x");
+    y = validateNumber(props.y !== undefined ? props.y : 0, 0, "window y");
+  } else if (hasDefaultPos) {
+    x = validateNumber(props.defaultX !== undefined ? props.defaultX : 0, 0, "window defaultX");
+    y = validateNumber(props.defaultY !== undefined ? props.defaultY : 0, 0, "window defaultY");
+  }
+  if (hasControlledSize) {
+    width = validateNumber(props.width !== undefined ? props.width : 0, 0, "window width");
+    height = validateNumber(props.height !== undefined ? props.height : 0, 0, "window height");
+
+    // Validate positive dimensions
+    if (_IMGUI_UNIT_CHECKS && (width <= 0 || height <= 0)) {
+      console.error(`Window "${title}" has invalid size: ${width}x${height}. Size must be positive. Using defaults.`);
+    }
+  } else if (hasDefaultSize) {
+    width = validateNumber(props.defaultWidth !== undefined ? props.defaultWidth : 0, 0, "window defaultWidth");
+    height = validateNumber(props.defaultHeight !== undefined ? props.defaultHeight : 0, 0, "window defaultHeight");
+  }
+
+  return {
+    title: title,
+    controlledPos: !!hasControlledPos,
+    defaultPos: !hasControlledPos && !!hasDefaultPos,
+    controlledSize: !!hasControlledSize,
+    defaultSize: !hasControlledSize && !!hasDefaultSize,
+    x: x,
+    y: y,
+    width: width,
+    height: height,
+    flags: (props && props.flags !== undefined) ? props.flags : 0,
+    hasOnClose: !!(props && props.onClose),
+    stateOnEnd: !!(props && props.windowStateUpdate === "end"),
+    budget: buildDrawBudget(title, props ? props.drawBudget : undefined),
+    traceName: `vertices: ${title}`,
+    updateInterval: updateIntervalOf(props, `window "${title}"`),
+  };
+}
+
+/**
+ * The drawBudget of a window, a number of vertices or an object with
+ * `vertices`, `indices` and `commands` limits, as a [vertices, indices,
+ * commands] array with 0 for no limit, or null without one.
+ */
+function buildDrawBudget(title: string, budget: any): any {
+  if (budget === undefined || budget === null) return null;
+  if (typeof budget === "number") {
+    return [validateNumber(budget, 0, `window "${title}" drawBudget`), 0, 0];
+  }
+  return [
+    validateNumber(budget.vertices !== undefined ? budget.vertices : 0, 0, `window "${title}" drawBudget.vertices`),
+    validateNumber(budget.indices !== undefined ? budget.indices : 0, 0, `window "${title}" drawBudget.indices`),
+    validateNumber(budget.commands !== undefined ? budget.commands : 0, 0, `window "${title}" drawBudget.commands`),
+  ];
+}
+
+// Draw output of the top-level windows rendered by renderWindow(), measured
+// after their igEnd() (see window_stats.c). The first windowStatCount
+// entries are the windows of the last renderTree(), in render order: their
+// titles, and vertices, indices and draw commands at 3 * i.
+const _window_draw_stats = $SHBuiltin.extern_c({}, function window_draw_stats(window: c_ptr): c_int { throw 0; });
+const _window_draw_indices = $SHBuiltin.extern_c({}, function window_draw_indices(): c_int { throw 0; });
+const _window_draw_commands = $SHBuiltin.extern_c({}, function window_draw_commands(): c_int { throw 0; });
+
+let windowStatCount = 0;
+const windowStatTitles: any = [];
+const windowStatCounts: number[] = [];
+
+/**
+ * Record the draw output of the window of `node` that was just ended, add
+ * it to a running trace capture, and check it against the drawBudget prop.
+ * A window is reported once each time it goes over its budget.
+ */
+function recordWindowDraw(node: any, plan: any, window: c_ptr): void {
+  const vertices = _window_draw_stats(window);
+  const indices = _window_draw_indices();
+  const commands = _window_draw_commands();
+  const i = windowStatCount++;
+  if (i < windowStatTitles.length) {
+    windowStatTitles[i] = plan.title;
+    windowStatCounts[3 * i] = vertices;
+    windowStatCounts[3 * i + 1] = indices;
+    windowStatCounts[3 * i + 2] = commands;
+  } else {
+    windowStatTitles.push(plan.title);
+    windowStatCounts.push(vertices, indices, commands);
+  }
+  if (runtimeMetric(METRIC_TRACE_CAPTURING) !== 0) {
+    globalThis.trace.counter(plan.traceName, vertices);
+  }
+
+  const budget = plan.budget;
+  if (budget === null) return;
+  const over =
+    (budget[0] > 0 && vertices > budget[0]) ||
+    (budget[1] > 0 && indices > budget[1]) ||
+    (budget[2] > 0 && commands > budget[2]);
+  const offset = nodeStoreIndex(node) * 4;
+  const flags = _sh_ptr_read_c_uint(storeFlags, offset);
+  const warned = (flags & STORE_FLAG_OVER_BUDGET) !== 0;
+  if (over === warned) return;
+  _sh_ptr_write_c_uint(storeFlags, offset, flags ^ STORE_FLAG_OVER_BUDGET);
+  if (over) {
+    console.error(
+      `Window "${plan.title}" is over its drawBudget: ${vertices} vertices, ` +
+      `${indices} indices, ${commands} draw commands`);
+  }
+}
+
+// <window updateHz> and <child updateHz>: the children are traversed at
+// that rate, and on the frames in between the draw output of the last
+// traversal is emitted again (window_cache.c). The capture is kept in
+// buffer slot 1 of the node, and node.state holds the time of the next
+// traversal; both survive commits, whose changes show at that traversal.
+const _window_cache_emit = $SHBuiltin.extern_c({}, function window_cache_emit(cache: c_ptr): c_bool { throw 0; });
+const _window_cache_begin = $SHBuiltin.extern_c({}, function window_cache_begin(): c_int { throw 0; });
+const _window_cache_end = $SHBuiltin.extern_c({}, function window_cache_end(token: c_int, cache: c_ptr, cap: c_int): void { throw 0; });
+const _window_cache_buffer = $SHBuiltin.extern_c({}, function window_cache_buffer(): c_ptr { throw 0; });
+const _window_cache_capacity = $SHBuiltin.extern_c({}, function window_cache_capacity(): c_int { throw 0; });
+
+const WINDOW_CACHE_SLOT = 1;
+const WINDOW_CACHE_HEADER_BYTES = 96;  // sizeof(WindowCache)
+
+/**
+ * The traversal interval in seconds for the updateHz prop of a window or
+ * child, or 0 to traverse it every frame.
+ */
+function updateIntervalOf(props: any, what: string): number {
+  if (!props || props.updateHz === undefined || props.updateHz === null) return 0;
+  const hz = validateNumber(props.updateHz, 0, `${what} updateHz`);
+  return hz > 0 ? 1 / hz : 0;
+}
+
+/**
+ * Frees the capture of a node whose updateHz prop was removed.
+ */
+function dropWindowCache(node: any): void {
+  if (node.state === null) return;
+  node.state = null;
+  trimNodeSlots(node, WINDOW_CACHE_SLOT);
+}
+
+/**
+ * Called in the current window instead of traversing the children of
+ * `node`, which has an update interval of `interval` seconds. Returns -1
+ * if the last capture was emitted in their place, or else a token for
+ * windowCacheEnd(), to be called after the traversal.
+ */
+function windowCacheBegin(node: any, interval: number): number {
+  const now = +_igGetTime();
+  let state = node.state;
+  if (state === null) {
+    // A phase from the node ID, so that windows with the same rate don't
+    // all traverse on the same frame
+    state = { next: now + interval * ((+node.id * 0.6180339887) % 1) };
+    node.state = state;
+    const slot = nodeBuffer(node, WINDOW_CACHE_SLOT, WINDOW_CACHE_HEADER_BYTES);
+    _sh_ptr_write_c_int(slotPtr(slot), 0, 0);
+  }
+  if (now < +state.next) {
+    if (_window_cache_emit(slotPtr(nodeSlot(node, WINDOW_CACHE_SLOT)))) return -1;
+  } else {
+    let next = +state.next + interval;
+    if (next <= now) next = now + interval;
+    state.next = next;
+  }
+  return _window_cache_begin();
+}
+
+function windowCacheEnd(node: any, token: number): void {
+  const slot = nodeSlot(node, WINDOW_CACHE_SLOT);
+  _window_cache_end(token, slotPtr(slot), slotCapacity(slot));
+  // Capturing may have reallocated the cache buffer
+  adoptSlotBuffer(slot, _window_cache_buffer(), _window_cache_capacity());
+}
+
+/**
+ * Whether the user is moving or resizing the current window with the mouse:
+ * the active ID is its move ID or the ID of one of its resize grips or
+ * borders.
+ */
+function windowDragged(): boolean {
+  const activeId = _igGetActiveID();
+  if (activeId === 0) return false;
+  const window = _igGetCurrentWindow();
+  if (activeId === get_ImGuiWindow_MoveId(window)) return true;
+  for (let n = 0; n < 4; n++) {
+    if (activeId === _igGetWindowResizeCornerID(window, n)) return true;
+    if (activeId === _igGetWindowResizeBorderID(window, n)) return true;
   }
-  if (hasControlledSize && hasDefaultSize) {
-    console.error(`Window "${title}" has both width/height and defaultWidth/defaultHeight props. Controlled props (width/height) will be used.`);
+  return false;
+}
+
+/**
+ * Renders a window component with controlled/uncontrolled position and size.
+ */
+function renderWindow(node: any, vec2: c_ptr): void {
+  const props = node.props;
+  let plan = node.plan;
+  if (plan === null) {
+    plan = buildWindowPlan(props);
+    plan.titleSlot = nodeUtf8(node, 0, plan.title);
+    node.plan = plan;
+    if (+plan.updateInterval === 0) dropWindowCache(node);
   }
+  // Last position/size written to or read from ImGui, in the node's store
+  // row. Unlike the plan, this survives commits.
+  const offset = nodeStoreIndex(node) * 4;
+  let syncFlags = _sh_ptr_read_c_uint(storeFlags, offset);
+  let lastX = +_sh_ptr_read_c_float(storeX, offset);
+  let lastY = +_sh_ptr_read_c_float(storeY, offset);
+  let lastWidth = +_sh_ptr_read_c_float(storeWidth, offset);
+  let lastHeight = +_sh_ptr_read_c_float(storeHeight, offset);
 
   // Flags to track whether we should read from ImGui after rendering
   let shouldReadPos = false;
   let shouldReadSize = false;
+  // With windowStateUpdate="end", ImGui owns the geometry from the first
+  // change of a drag until onWindowState reports it at the end: the props
+  // are stale meanwhile and must not be written back.
+  const statePending = plan.stateOnEnd && (syncFlags & STORE_FLAG_STATE_PENDING) !== 0;
 
   // Handle controlled position
   // Strategy: Compare current prop values against last prop values we recorded
   // - If different -> React changed it -> write to ImGui, don't read
   // - If same -> React didn't change it -> read from ImGui (user may have moved window)
-  if (hasControlledPos) {
-    const propX = validateNumber(props.x !== undefined ? props.x : 0, 0, "window x");
-    const propY = validateNumber(props.y !== undefined ? props.y : 0, 0, "window y");
+  if (plan.controlledPos) {
+    // Compared as stored, in single precision
+    const propX = Math.fround(+plan.x);
+    const propY = Math.fround(+plan.y);
 
     // Check if this is first render or if React changed the position
-    const isFirstRender = node._lastPropX === undefined;
-    const posChanged = propX !== node._lastPropX || propY !== node._lastPropY;
+    const isFirstRender = (syncFlags & STORE_FLAG_POS_SYNCED) === 0;
+    const posChanged = propX !== lastX || propY !== lastY;
 
-    if (isFirstRender || posChanged) {
+    if (isFirstRender || (posChanged && !statePending)) {
       // First render or React changed position -> write to ImGui with ImGuiCond_Always
-      set_ImVec2_x(vec2, propX);
-      set_ImVec2_y(vec2, propY);
-      const pivot = allocTmp(_sizeof_ImVec2);
-      set_ImVec2_x(pivot, 0);
-      set_ImVec2_y(pivot, 0);
-      _igSetNextWindowPos(vec2, _ImGuiCond_Always, pivot);
+      _igSetNextWindowPos_flat(propX, propY, _ImGuiCond_Always, 0, 0);
 
       // Update last prop values
-      node._lastPropX = propX;
-      node._lastPropY = propY;
+      syncFlags |= STORE_FLAG_POS_SYNCED;
+      _sh_ptr_write_c_uint(storeFlags, offset, syncFlags);
+      _sh_ptr_write_c_float(storeX, offset, propX);
+      _sh_ptr_write_c_float(storeY, offset, propY);
+      lastX = propX;
+      lastY = propY;
     }
 
     // Always read back to sync with ImGui's actual state
     shouldReadPos = true;
-  } else if (hasDefaultPos) {
-    // Uncontrolled: set position once on first frame
-    const defaultX = validateNumber(props.defaultX !== undefined ? props.defaultX : 0, 0, "window defaultX");
-    const defaultY = validateNumber(props.defaultY !== undefined ? props.defaultY : 0, 0, "window defaultY");
-    set_ImVec2_x(vec2, defaultX);
-    set_ImVec2_y(vec2, defaultY);
-    const pivot = allocTmp(_sizeof_ImVec2);
-    set_ImVec2_x(pivot, 0);
-    set_ImVec2_y(pivot, 0);
-    _igSetNextWindowPos(vec2, _ImGuiCond_Once, pivot);
+  } else if (plan.defaultPos) {
+    // Uncontrolled: set position on first use, unless the settings file has one
+    _igSetNextWindowPos_flat(+plan.x, +plan.y, _ImGuiCond_FirstUseEver, 0, 0);
   }
 
   // Handle controlled size (same strategy as position)
-  if (hasControlledSize) {
-    const propWidth = validateNumber(props.width !== undefined ? props.width : 0, 0, "window width");
-    const propHeight = validateNumber(props.height !== undefined ? props.height : 0, 0, "window height");
-
-    // Validate positive dimensions
-    if (propWidth <= 0 || propHeight <= 0) {
-      console.error(`Window "${title}" has invalid size: ${propWidth}x${propHeight}. Size must be positive. Using defaults.`);
-    }
+  if (plan.controlledSize) {
+    const propWidth = Math.fround(+plan.width);
+    const propHeight = Math.fround(+plan.height);
 
     // Check if this is first render or if React changed the size
-    const isFirstRender = node._lastPropWidth === undefined;
-    const sizeChanged = propWidth !== node._lastPropWidth || propHeight !== node._lastPropHeight;
+    const isFirstRender = (syncFlags & STORE_FLAG_SIZE_SYNCED) === 0;
+    const sizeChanged = propWidth !== lastWidth || propHeight !== lastHeight;
 
-    if (isFirstRender || sizeChanged) {
+    if (isFirstRender || (sizeChanged && !statePending)) {
       // First render or React changed size -> write to ImGui with ImGuiCond_Always
       if (propWidth > 0 && propHeight > 0) {
-        set_ImVec2_x(vec2, propWidth);
-        set_ImVec2_y(vec2, propHeight);
-        _igSetNextWindowSize(vec2, _ImGuiCond_Always);
+        _igSetNextWindowSize_flat(propWidth, propHeight, _ImGuiCond_Always);
       }
 
       // Update last prop values
-      node._lastPropWidth = propWidth;
-      node._lastPropHeight = propHeight;
+      syncFlags |= STORE_FLAG_SIZE_SYNCED;
+      _sh_ptr_write_c_uint(storeFlags, offset, syncFlags);
+      _sh_ptr_write_c_float(storeWidth, offset, propWidth);
+      _sh_ptr_write_c_float(storeHeight, offset, propHeight);
+      lastWidth = propWidth;
+      lastHeight = propHeight;
     }
 
     // Always read back to sync with ImGui's actual state
     shouldReadSize = true;
-  } else if (hasDefaultSize) {
-    // Uncontrolled: set size once on first frame
-    const defaultWidth = validateNumber(props.defaultWidth !== undefined ? props.defaultWidth : 0, 0, "window defaultWidth");
-    const defaultHeight = validateNumber(props.defaultHeight !== undefined ? props.defaultHeight : 0, 0, "window defaultHeight");
-    set_ImVec2_x(vec2, defaultWidth);
-    set_ImVec2_y(vec2, defaultHeight);
-    _igSetNextWindowSize(vec2, _ImGuiCond_Once);
+  } else if (plan.defaultSize) {
+    // Uncontrolled: set size on first use, unless the settings file has one
+    _igSetNextWindowSize_flat(+plan.width, +plan.height, _ImGuiCond_FirstUseEver);
   }
 
-  // Get window flags
-  const windowFlags = (props && props.flags !== undefined) ? props.flags : 0;
-
   // Handle window close button via p_open parameter
-  // If onClose callback exists, allocate a boolean pointer and pass it to igBegin
+  // If onClose callback exists, allocate a boolean pointer and pass it to igBegin.
+  // It is read after the children render, so it cannot be a scratch register.
   // This enables the close button (X) in the window title bar
-  const hasOnClose = props && props.onClose;
+  const hasOnClose = plan.hasOnClose;
   const pOpen = hasOnClose ? allocTmp(_sizeof_c_bool) : c_null;
 
   if (hasOnClose) {
@@ -208,13 +822,16 @@ function renderWindow(node: any, vec2: c_ptr, vec4: c_ptr): void {
     _sh_ptr_write_c_bool(pOpen, 0, 1);
   }
 
-  if (_igBegin(tmpUtf8(title), pOpen, windowFlags)) {
+  const visible = _igBegin(utf8SlotPtr(plan.titleSlot), pOpen, plan.flags);
+  // Current until igEnd(), even when collapsed
+  const window = _igGetCurrentWindow();
+  if (visible) {
     // Read actual state from ImGui if needed and fire callback if changed
     let stateChanged = false;
-    let actualX = node._lastPropX !== undefined ? node._lastPropX : 0;
-    let actualY = node._lastPropY !== undefined ? node._lastPropY : 0;
-    let actualWidth = node._lastPropWidth !== undefined ? node._lastPropWidth : 0;
-    let actualHeight = node._lastPropHeight !== undefined ? node._lastPropHeight : 0;
+    let actualX = lastX;
+    let actualY = lastY;
+    let actualWidth = lastWidth;
+    let actualHeight = lastHeight;
 
     if (shouldReadPos) {
       _igGetWindowPos(vec2);
@@ -222,10 +839,10 @@ function renderWindow(node: any, vec2: c_ptr, vec4: c_ptr): void {
       actualY = +get_ImVec2_y(vec2);
 
       // Check if position changed (either user moved window or ImGui clamped our values)
-      if (actualX !== node._lastPropX || actualY !== node._lastPropY) {
+      if (actualX !== lastX || actualY !== lastY) {
         stateChanged = true;
-        node._lastPropX = actualX;
-        node._lastPropY = actualY;
+        _sh_ptr_write_c_float(storeX, offset, actualX);
+        _sh_ptr_write_c_float(storeY, offset, actualY);
       }
     }
 
@@ -235,33 +852,52 @@ function renderWindow(node: any, vec2: c_ptr, vec4: c_ptr): void {
       actualHeight = +get_ImVec2_y(vec2);
 
       // Check if size changed (either user resized window or ImGui adjusted our values)
-      if (actualWidth !== node._lastPropWidth || actualHeight !== node._lastPropHeight) {
+      if (actualWidth !== lastWidth || actualHeight !== lastHeight) {
         stateChanged = true;
-        node._lastPropWidth = actualWidth;
-        node._lastPropHeight = actualHeight;
+        _sh_ptr_write_c_float(storeWidth, offset, actualWidth);
+        _sh_ptr_write_c_float(storeHeight, offset, actualHeight);
       }
     }
 
-    // Fire callback if state changed
+    // Fire callback if state changed, or with windowStateUpdate="end" once
+    // the drag that changed it is over
+    if (plan.stateOnEnd && (stateChanged || statePending)) {
+      if (windowDragged()) {
+        if (!statePending) {
+          _sh_ptr_write_c_uint(storeFlags, offset, syncFlags | STORE_FLAG_STATE_PENDING);
+        }
+        stateChanged = false;
+      } else {
+        if (statePending) {
+          _sh_ptr_write_c_uint(storeFlags, offset, syncFlags & ~STORE_FLAG_STATE_PENDING);
+        }
+        stateChanged = true;
+      }
+    }
     if (stateChanged && props && props.onWindowState) {
-      safeInvokeCallback(props.onWindowState, actualX, actualY, actualWidth, actualHeight);
+      safeInvokeEvent(EVENT_CONTINUOUS, props.onWindowState, actualX, actualY, actualWidth, actualHeight);
     }
 
-    // Render children
-    if (node.children) {
-      for (let i = 0; i < node.children.length; i++) {
-        renderNode(node.children[i]);
+    // Render children, or with updateHz their last capture
+    if (+plan.updateInterval > 0) {
+      const token = windowCacheBegin(node, +plan.updateInterval);
+      if (token >= 0) {
+        renderWindowChildren(node);
+        windowCacheEnd(node, token);
       }
+    } else {
+      renderWindowChildren(node);
     }
   }
   _igEnd();
+  recordWindowDraw(node, plan, window);
 
   // Check if user clicked the close button
   if (hasOnClose) {
     const isStillOpen = _sh_ptr_read_c_bool(pOpen, 0);
     if (!isStillOpen) {
       // User clicked close button - invoke callback
-      safeInvokeCallback(props.onClose);
+      safeInvokeEvent(EVENT_DISCRETE, props.onClose);
     }
   }
 }
@@ -277,18 +913,9 @@ function renderRoot(node: any, vec2: c_ptr): void {
   const vpPos = get_ImGuiViewport_Pos(viewport);
   const vpSize = get_ImGuiViewport_Size(viewport);
 
-  // Copy viewport position into our buffer and set window position
-  set_ImVec2_x(vec2, +get_ImVec2_x(vpPos));
-  set_ImVec2_y(vec2, +get_ImVec2_y(vpPos));
-  const pivot = allocTmp(_sizeof_ImVec2);
-  set_ImVec2_x(pivot, 0);
-  set_ImVec2_y(pivot, 0);
-  _igSetNextWindowPos(vec2, _ImGuiCond_Always, pivot);
-
-  // Copy viewport size into our buffer and set window size
-  set_ImVec2_x(vec2, +get_ImVec2_x(vpSize));
-  set_ImVec2_y(vec2, +get_ImVec2_y(vpSize));
-  _igSetNextWindowSize(vec2, _ImGuiCond_Always);
+  // Cover the viewport
+  _igSetNextWindowPos_flat(+get_ImVec2_x(vpPos), +get_ImVec2_y(vpPos), _ImGuiCond_Always, 0, 0);
+  _igSetNextWindowSize_flat(+get_ImVec2_x(vpSize), +get_ImVec2_y(vpSize), _ImGuiCond_Always);
 
   // Combine required flags for root window behavior
   const rootFlags =
@@ -298,24 +925,57 @@ function renderRoot(node: any, vec2: c_ptr): void {
     _ImGuiWindowFlags_NoBringToFrontOnFocus |
     _ImGuiWindowFlags_NoBackground;
 
-  if (_igBegin(tmpUtf8("##Root"), c_null, rootFlags)) {
+  if (_igBegin(utf8SlotPtr(ROOT_WINDOW_LABEL), c_null, rootFlags)) {
     // Render children
-    if (node.children) {
-      for (let i = 0; i < node.children.length; i++) {
-        renderNode(node.children[i]);
+    renderWindowChildren(node);
+  }
+  _igEnd();
+}
+
+/**
+ * Collects the children of a node into an array, for the render plans of
+ * virtualized containers that need random access into their child list.
+ */
+function collectChildren(node: any): any {
+  const items: any = [];
+  for (let c = node.firstChild; c; c = c.nextSibling) {
+    items.push(c);
+  }
+  return items;
+}
+
+/**
+ * Renders a list of child nodes through an ImGuiListClipper, so only the
+ * entries inside the visible region are traversed. `items` is an array
+ * cached in the parent's render plan, which is rebuilt whenever the child
+ * list changes. All entries are expected to have the same height; an
+ * `itemHeight` <= 0 lets the clipper measure the first one.
+ */
+function renderClippedChildren(items: any, itemHeight: number): void {
+  const count = items.length;
+  if (count === 0) return;
+
+  const clipper = _ImGuiListClipper_ImGuiListClipper();
+  try {
+    _ImGuiListClipper_Begin(clipper, count, itemHeight > 0 ? itemHeight : -1.0);
+    while (_ImGuiListClipper_Step(clipper)) {
+      const end = get_ImGuiListClipper_DisplayEnd(clipper);
+      for (let i = get_ImGuiListClipper_DisplayStart(clipper); i < end; i++) {
+        renderNode(items[i]);
       }
     }
+  } finally {
+    // The destructor also ends the clipper, keeping ImGui's state balanced
+    _ImGuiListClipper_destroy(clipper);
   }
-  _igEnd();
 }
 
 /**
- * Renders a child window component.
+ * Builds the render plan for a child window.
  */
-function renderChild(node: any, vec2: c_ptr): void {
+function buildChildPlan(node: any): any {
   const props = node.props;
-  const childWidth = (props && props.width !== undefined) ? +props.width : 0;
-  const childHeight = (props && props.height !== undefined) ? +props.height : 0;
+  const virtualized = !!(props && props.virtualized);
   const childNoPadding = (props && props.noPadding !== undefined) ? props.noPadding : false;
   const childNoScrollbar = (props && props.noScrollbar !== undefined) ? props.noScrollbar : false;
 
@@ -326,22 +986,72 @@ function renderChild(node: any, vec2: c_ptr): void {
     childFlags |= _ImGuiWindowFlags_NoScrollWithMouse;
   }
 
-  // Push zero padding if requested (separate allocation needed - remains live on style stack)
-  if (childNoPadding) {
-    const zeroPadding = allocTmp(_sizeof_ImVec2);
-    set_ImVec2_x(zeroPadding, 0);
-    set_ImVec2_y(zeroPadding, 0);
-    _igPushStyleVar_Vec2(_ImGuiStyleVar_WindowPadding, zeroPadding);
+  return {
+    width: (props && props.width !== undefined) ? +props.width : 0,
+    height: (props && props.height !== undefined) ? +props.height : 0,
+    noPadding: !!childNoPadding,
+    flags: childFlags,
+    virtualized: virtualized,
+    items: virtualized ? collectChildren(node) : null,
+    rowHeight: (props && props.rowHeight !== undefined) ? +props.rowHeight : 0,
+    updateInterval: updateIntervalOf(props, "child"),
+  };
+}
+
+/**
+ * Renders the children of a <child> inside its child window.
+ */
+function renderChildContents(node: any, plan: any): void {
+  if (plan.virtualized) {
+    renderClippedChildren(plan.items, +plan.rowHeight);
+  } else {
+    for (let c = node.firstChild; c; c = c.nextSibling) {
+      renderNode(c);
+    }
+  }
+}
+
+/**
+ * Renders a child window component.
+ */
+function renderChild(node: any, vec2: c_ptr): void {
+  let plan = node.plan;
+  if (plan === null) {
+    plan = buildChildPlan(node);
+    node.plan = plan;
+    if (+plan.updateInterval === 0) dropWindowCache(node);
+  }
+  const childNoPadding = plan.noPadding;
+
+  // A child with an explicit size that is scrolled out of view only needs
+  // to reserve its layout space; skip Begin/EndChild and the subtree.
+  if (+plan.width > 0 && +plan.height > 0) {
+    set_ImVec2_x(vec2, +plan.width);
+    set_ImVec2_y(vec2, +plan.height);
+    if (!_igIsRectVisible_Nil(vec2)) {
+      _igDummy_flat(+plan.width, +plan.height);
+      return;
+    }
   }
 
-  set_ImVec2_x(vec2, childWidth);
-  set_ImVec2_y(vec2, childHeight);
+  // Push zero padding if requested
+  if (childNoPadding) {
+    _igPushStyleVar_Vec2_flat(_ImGuiStyleVar_WindowPadding, 0, 0);
+  }
 
-  if (_igBeginChild_Str(tmpUtf8("Content"), vec2, 0, childFlags)) {
-    if (node.children) {
-      for (let i = 0; i < node.children.length; i++) {
-        renderNode(node.children[i]);
+  if (_igBeginChild_Str_flat(utf8SlotPtr(CHILD_WINDOW_LABEL), +plan.width, +plan.height, 0, plan.flags)) {
+    if (+plan.updateInterval > 0) {
+      const token = windowCacheBegin(node, +plan.updateInterval);
+      if (token >= 0) {
+        // Ended even if the subtree throws, as nothing catches it here
+        try {
+          renderChildContents(node, plan);
+        } finally {
+          windowCacheEnd(node, token);
+        }
       }
+    } else {
+      renderChildContents(node, plan);
     }
   }
   _igEndChild();
@@ -353,68 +1063,428 @@ function renderChild(node: any, vec2: c_ptr): void {
 }
 
 /**
- * Renders a button component.
+ * Builds the render plan for a <virtuallist>.
  */
-function renderButton(node: any, vec2: c_ptr): void {
-  // Concatenate all text children for button label
-  let buttonText = "";
-  if (node.children) {
-    for (let i = 0; i < node.children.length; i++) {
-      const child = node.children[i];
-      if (child.text !== undefined) {
-        buttonText += child.text;
-      } else {
-        console.error(
-          `<button> only supports text children. Ignoring <${child.type}>.`
-        );
-      }
-    }
+function buildVirtualListPlan(node: any): any {
+  const props = node.props;
+  return {
+    width: (props && props.width !== undefined) ? +props.width : 0,
+    height: (props && props.height !== undefined) ? +props.height : 0,
+    noPadding: !!(props && props.noPadding),
+    itemCount: (props && props.itemCount > 0) ? Math.floor(+props.itemCount) : 0,
+    itemHeight: (props && props.itemHeight > 0) ? +props.itemHeight : 0,
+    first: (props && props.first > 0) ? Math.floor(+props.first) : 0,
+  };
+}
+
+/**
+ * Renders a <virtuallist>: a child window laid out as `itemCount` slots of
+ * `itemHeight`, of which only items first, first + 1, ... are mounted, as
+ * its children. Every frame it reports the range of slots in view through
+ * onRangeChange(start, end) when that changes, and the React side
+ * (VirtualList in react-imgui-reconciler/virtual-list.js) mounts that range
+ * plus some overscan. Only the mounted items in view are drawn, each at its
+ * slot; the rest of the scroll height is empty space.
+ */
+function renderVirtualList(node: any): void {
+  let plan = node.plan;
+  if (plan === null) {
+    plan = buildVirtualListPlan(node);
+    node.plan = plan;
+  }
+  let state = node.state;
+  if (state === null) {
+    state = { start: -1, end: -1 };
+    node.state = state;
   }
-  if (buttonText === "") {
-    buttonText = "Button";
+
+  if (plan.noPadding) {
+    _igPushStyleVar_Vec2_flat(_ImGuiStyleVar_WindowPadding, 0, 0);
   }
-  set_ImVec2_x(vec2, 0);
-  set_ImVec2_y(vec2, 0);
 
-  if (_igButton(tmpUtf8(buttonText), vec2)) {
-    // Button was clicked - invoke callback directly
-    if (node.props && node.props.onClick) {
-      console.debug("Button clicked:", buttonText);
-      safeInvokeCallback(node.props.onClick);
+  if (_igBeginChild_Str_flat(utf8SlotPtr(CHILD_WINDOW_LABEL), +plan.width, +plan.height, 0, 0)) {
+    const count = +plan.itemCount;
+    const itemHeight = +plan.itemHeight > 0 ? +plan.itemHeight : +_igGetTextLineHeightWithSpacing();
+    // Cursor and scroll positions are both in the window's content space
+    const top = +_igGetCursorPosY();
+    const scrollY = +_igGetScrollY();
+    let start = Math.floor((scrollY - top) / itemHeight);
+    let end = Math.ceil((scrollY + +_igGetWindowHeight() - top) / itemHeight);
+    if (start < 0) start = 0;
+    if (start > count) start = count;
+    if (end < start) end = start;
+    if (end > count) end = count;
+    if (start !== +state.start || end !== +state.end) {
+      state.start = start;
+      state.end = end;
+      safeInvokeEvent(EVENT_CONTINUOUS, node.props ? node.props.onRangeChange : null, start, end);
+    }
+
+    let index = +plan.first;
+    for (let c = node.firstChild; c && index < end; c = c.nextSibling) {
+      if (index >= start) {
+        _igSetCursorPosY(top + index * itemHeight);
+        renderNode(c);
+      }
+      index++;
     }
+
+    // Extend the content to the full list, for the scrollbar
+    _igSetCursorPosY(top + count * itemHeight);
+    _igDummy_flat(0, 0);
+  }
+  _igEndChild();
+
+  if (plan.noPadding) {
+    _igPopStyleVar(1);
   }
 }
 
 /**
- * Renders a text component.
+ * Concatenates the text children of a node into a single label.
+ * Non-text children are reported and ignored.
  */
-function renderText(node: any, vec4: c_ptr): void {
-  // Concatenate all text children
+function joinTextChildren(node: any): string {
   let text = "";
-  if (node.children) {
-    for (let i = 0; i < node.children.length; i++) {
-      const textChild = node.children[i];
-      if (textChild.text !== undefined) {
-        text += textChild.text;
-      } else {
-        console.error(
-          `<text> only supports text children. Ignoring <${textChild.type}>.`
-        );
-      }
+  for (let child = node.firstChild; child; child = child.nextSibling) {
+    if (child.text !== undefined) {
+      text += child.text;
+    } else if (_IMGUI_UNIT_CHECKS) {
+      console.error(
+        `<${node.type}> only supports text children. Ignoring <${child.type}>.`
+      );
+    }
+  }
+  return text;
+}
+
+/**
+ * Returns the slot 0 label holding the joined text children of a node, or
+ * `fallback` if there are none. The joined string is cached in `node.label`,
+ * which the host config clears when a text child changes or a child is
+ * inserted or removed, so a commit that only changes props rebuilds the
+ * plan without joining and encoding the text again.
+ */
+function textLabelSlot(node: any, fallback: string): number {
+  if (node.label !== null) {
+    return nodeSlot(node, 0);
+  }
+  let label = joinTextChildren(node);
+  if (label === "") {
+    label = fallback;
+  }
+  node.label = label;
+  return nodeUtf8(node, 0, label);
+}
+
+// Native <inputtext> helpers (input_text.c)
+const _input_text_edit = $SHBuiltin.extern_c({}, function input_text_edit(label: c_ptr, hint: c_ptr, buf: c_ptr, cap: c_int, flags: c_int, multiline: c_bool, w: c_float, h: c_float): c_bool { throw 0; });
+const _input_text_buffer = $SHBuiltin.extern_c({}, function input_text_buffer(): c_ptr { throw 0; });
+const _input_text_capacity = $SHBuiltin.extern_c({}, function input_text_capacity(): c_int { throw 0; });
+const _input_text_length = $SHBuiltin.extern_c({}, function input_text_length(): c_int { throw 0; });
+
+// Node slot holding the edit buffer of an <inputtext>
+const INPUT_TEXT_BUFFER_SLOT = 2;
+
+/**
+ * Builds the render plan for an input text. Slot 0 of the node holds the
+ * label, slot 1 the hint and slot 2 the edit buffer, which persists across
+ * commits. The buffer is only re-encoded when `value` differs from the text
+ * it already holds, so echoing an edit back through onChange -> value does
+ * not copy the text again.
+ */
+function buildInputTextPlan(node: any): any {
+  const props = node.props;
+  // Text currently held by the edit buffer, kept across commits
+  let state = node.state;
+  if (state === null) {
+    state = { text: "" };
+    node.state = state;
+  }
+  const label = (props && props.label !== undefined) ? String(props.label) : "";
+  const hint = (props && props.hint !== undefined) ? String(props.hint) : "";
+
+  if (props && props.value !== undefined) {
+    const value = String(props.value);
+    if (state.text !== value || nodeSlot(node, INPUT_TEXT_BUFFER_SLOT) < 0) {
+      nodeUtf8(node, INPUT_TEXT_BUFFER_SLOT, value);
+      state.text = value;
+    }
+  } else if (nodeSlot(node, INPUT_TEXT_BUFFER_SLOT) < 0) {
+    // Uncontrolled: only the initial text comes from props
+    const initial = (props && props.defaultValue !== undefined) ? String(props.defaultValue) : "";
+    nodeUtf8(node, INPUT_TEXT_BUFFER_SLOT, initial);
+    state.text = initial;
+  }
+
+  let flags = 0;
+  if (props && props.readOnly) flags |= _ImGuiInputTextFlags_ReadOnly;
+  if (props && props.password) flags |= _ImGuiInputTextFlags_Password;
+
+  return {
+    labelSlot: nodeUtf8(node, 0, label !== "" ? label : "##inputtext"),
+    hintSlot: nodeUtf8(node, 1, hint),
+    hasHint: hint !== "",
+    multiline: !!(props && props.multiline),
+    width: validateNumber((props && props.width !== undefined) ? props.width : 0, 0, "inputtext width"),
+    height: validateNumber((props && props.height !== undefined) ? props.height : 0, 0, "inputtext height"),
+    flags: flags,
+  };
+}
+
+/**
+ * Renders an input text component. The edit buffer lives in a persistent
+ * node slot and is grown by ImGui's resize callback; it is decoded back into
+ * a JS string only on frames where ImGui reports an edit.
+ */
+function renderInputText(node: any): void {
+  let plan = node.plan;
+  if (plan === null) {
+    plan = buildInputTextPlan(node);
+    node.plan = plan;
+  }
+
+  const slot = nodeSlot(node, INPUT_TEXT_BUFFER_SLOT);
+  const hint = plan.hasHint ? utf8SlotPtr(plan.hintSlot) : c_null;
+  const changed = _input_text_edit(utf8SlotPtr(plan.labelSlot), hint, slotPtr(slot),
+    slotCapacity(slot), plan.flags, plan.multiline, +plan.width, +plan.height);
+  // The resize callback may have reallocated the buffer
+  adoptSlotBuffer(slot, _input_text_buffer(), _input_text_capacity());
+
+  if (changed) {
+    const length = _input_text_length();
+    const text = utf8ToString(slotPtr(slot), length);
+    // ImGui edited the buffer in place: retain the glyphs it holds now
+    if (length !== text.length) retainSlotGlyphs(slot, 0, length);
+    else releaseSlotGlyphs(slot);
+    node.state.text = text;
+    if (node.props && node.props.onChange) {
+      safeInvokeEvent(EVENT_DISCRETE, node.props.onChange, text);
     }
   }
+}
+
+// Cached igCalcTextSize() (imgui-runtime's TextMeasure.cpp), for widgets
+// that measure the same labels every frame
+const _imgui_text_size = $SHBuiltin.extern_c({}, function imgui_text_size(out: c_ptr, text: c_ptr, text_end: c_ptr, hide_text_after_double_hash: c_bool, wrap_width: c_float): void { throw 0; });
+
+// Native string tables for <combo>/<listbox> (string_table.c)
+const _string_table_combo = $SHBuiltin.extern_c({}, function string_table_combo(label: c_ptr, current: c_ptr, table: c_ptr, indices: c_ptr, index_count: c_int, max_height_in_items: c_int): c_bool { throw 0; });
+const _string_table_listbox = $SHBuiltin.extern_c({}, function string_table_listbox(label: c_ptr, current: c_ptr, table: c_ptr, indices: c_ptr, index_count: c_int, height_in_items: c_int): c_bool { throw 0; });
 
+// Node slots holding the string table and the shown indices of a
+// <combo>/<listbox>
+const ITEM_TABLE_SLOT = 1;
+const ITEM_INDICES_SLOT = 2;
+
+/**
+ * Encodes `items` into node slot `index` as a StringTable (see
+ * string_table.c): an int32 count, int32 byte offsets, then the
+ * NUL-terminated UTF-8 strings. Returns the slot.
+ */
+function encodeStringTable(node: any, index: number, items: any): number {
+  "use unsafe";
+
+  const count = items.length;
+  const strings: any = [];
+  const header = 4 + count * 4;
+  let size = header;
+  for (let i = 0; i < count; i++) {
+    const str = String(items[i]);
+    strings.push(str);
+    size += str.length * 4 + 1;
+  }
+
+  const slot = nodeBuffer(node, index, size);
+  const buf = slotPtr(slot);
+  _sh_ptr_write_c_int(buf, 0, count);
+  let offset = header;
+  let units = 0;
+  for (let i = 0; i < count; i++) {
+    _sh_ptr_write_c_int(buf, 4 + i * 4, offset);
+    offset += copyToUtf8(strings[i], _sh_ptr_add(buf, offset), size - offset) + 1;
+    units += strings[i].length + 1;
+  }
+  // The strings, not the header, hold text for the glyph cache
+  if (offset - header !== units) retainSlotGlyphs(slot, header, offset);
+  return slot;
+}
+
+/**
+ * Builds the render plan for <combo>/<listbox>. Slot 0 of the node holds the
+ * label, slot 1 the string table. The table is only rebuilt when the `items`
+ * array changes identity, so changing the selection does not re-encode it.
+ * An `indices` array (e.g. from createFilterIndex()) is copied into slot 2,
+ * so filtering only copies the indices of the items shown.
+ */
+function buildItemListPlan(node: any, listbox: boolean): any {
   const props = node.props;
-  // Check for color prop
-  if (props && props.color) {
-    parseColorToImVec4(vec4, props.color);
-    _igTextColored(vec4, tmpUtf8(text));
+  const kind = listbox ? "listbox" : "combo";
+  const label = (props && props.label !== undefined) ? String(props.label) : "";
+  const items: any = (props && Array.isArray(props.items)) ? props.items : [];
+
+  // The encoded items and, for uncontrolled lists, the selection survive
+  // commits; only the initial selection comes from props.
+  let state = node.state;
+  if (state === null) {
+    state = {
+      items: null,
+      selected: (props && props.defaultSelected !== undefined) ? +props.defaultSelected : -1,
+    };
+    node.state = state;
+  }
+  if (state.items !== items || nodeSlot(node, ITEM_TABLE_SLOT) < 0) {
+    encodeStringTable(node, ITEM_TABLE_SLOT, items);
+    state.items = items;
+  }
+
+  const indices: any = props ? props.indices : undefined;
+  let indexCount = -1;
+  if (indices && typeof indices.length === 'number') {
+    indexCount = +indices.length;
+    const buf = slotPtr(nodeBuffer(node, ITEM_INDICES_SLOT, indexCount * 4 + 4));
+    for (let i = 0; i < indexCount; i++) {
+      _sh_ptr_write_c_int(buf, i * 4, +indices[i]);
+    }
+  } else {
+    trimNodeSlots(node, ITEM_INDICES_SLOT);
+  }
+
+  const controlled = props && props.selected !== undefined;
+
+  const heightProp = listbox ? "height" : "maxHeight";
+  return {
+    labelSlot: nodeUtf8(node, 0, label !== "" ? label : "##" + kind),
+    controlled: controlled,
+    indexCount: indexCount,
+    selected: controlled ? validateNumber(props.selected, -1, kind + " selected") : -1,
+    heightInItems: (props && props[heightProp] !== undefined)
+      ? validateNumber(props[heightProp], -1, kind + " " + heightProp) : -1,
+  };
+}
+
+/**
+ * Renders a <combo> or <listbox> over its native string table.
+ */
+function renderItemList(node: any, listbox: boolean): void {
+  let plan = node.plan;
+  if (plan === null) {
+    plan = buildItemListPlan(node, listbox);
+    node.plan = plan;
+  }
+
+  const state = node.state;
+  const current = plan.controlled ? +plan.selected : +state.selected;
+  _sh_ptr_write_c_int(scratchInt, 0, current);
+  const label = utf8SlotPtr(plan.labelSlot);
+  const table = slotPtr(nodeSlot(node, ITEM_TABLE_SLOT));
+  const indexCount = +plan.indexCount;
+  const indices = indexCount >= 0 ? slotPtr(nodeSlot(node, ITEM_INDICES_SLOT)) : c_null;
+  const changed = listbox
+    ? _string_table_listbox(label, scratchInt, table, indices, indexCount, +plan.heightInItems)
+    : _string_table_combo(label, scratchInt, table, indices, indexCount, +plan.heightInItems);
+
+  if (changed) {
+    const index = _sh_ptr_read_c_int(scratchInt, 0);
+    if (!plan.controlled) state.selected = index;
+    if (node.props && node.props.onChange) {
+      safeInvokeEvent(EVENT_DISCRETE, node.props.onChange, index, state.items[index]);
+    }
+  }
+}
+
+// Text submission. Labels go to igTextUnformatted() with the end pointer
+// of their slot, so ImGui neither parses them as a format string (where a
+// "%" in user data would be taken for a specifier) nor scans them with
+// strlen(). The colored, disabled and wrapped variants do what
+// igTextColored(), igTextDisabled() and igTextWrapped() do around it.
+
+/// Submit the string of persistent slot `slot` as text.
+function textSlot(slot: number): void {
+  _igTextUnformatted(utf8SlotPtr(slot), utf8SlotEnd(slot));
+}
+
+function textSlotColored(slot: number, r: number, g: number, b: number, a: number): void {
+  _igPushStyleColor_Vec4_flat(_ImGuiCol_Text, r, g, b, a);
+  textSlot(slot);
+  _igPopStyleColor(1);
+}
+
+function textSlotDisabled(slot: number): void {
+  const color = _igGetStyleColorVec4(_ImGuiCol_TextDisabled);
+  textSlotColored(slot, +get_ImVec4_x(color), +get_ImVec4_y(color),
+    +get_ImVec4_z(color), +get_ImVec4_w(color));
+}
+
+/// Wrapped at the end of the window, unless a wrap position is set already.
+function textSlotWrapped(slot: number): void {
+  const dc = get_ImGuiWindow_DC(_igGetCurrentWindowRead());
+  const push = +get_ImGuiWindowTempData_TextWrapPos(dc) < 0;
+  if (push) _igPushTextWrapPos(0);
+  textSlot(slot);
+  if (push) _igPopTextWrapPos();
+}
+
+// Text render modes, resolved once per commit from the text props.
+const TEXT_PLAIN = 0;
+const TEXT_COLORED = 1;
+const TEXT_DISABLED = 2;
+const TEXT_WRAPPED = 3;
+
+/**
+ * Builds the render plan for a text component.
+ */
+function buildTextPlan(node: any): any {
+  const props = node.props;
+  let mode = TEXT_PLAIN;
+  let color = 0;
+  const colorSlot = animatedSlotOf(props && props.color);
+  if (colorSlot >= 0) {
+    mode = TEXT_COLORED;
+  } else if (props && props.color) {
+    mode = TEXT_COLORED;
+    color = parseColorToABGR(props.color);
   } else if (props && props.disabled) {
-    _igTextDisabled(tmpUtf8(text));
+    mode = TEXT_DISABLED;
   } else if (props && props.wrapped) {
-    _igTextWrapped(tmpUtf8(text));
+    mode = TEXT_WRAPPED;
+  }
+  return {
+    labelSlot: textLabelSlot(node, ""),
+    mode: mode,
+    color: color,
+    colorSlot: colorSlot,
+    // Float components for igTextColored, so no conversion is needed per frame
+    r: (color & 0xFF) * (1/255),
+    g: ((color >>> 8) & 0xFF) * (1/255),
+    b: ((color >>> 16) & 0xFF) * (1/255),
+    a: (color >>> 24) * (1/255),
+  };
+}
+
+/**
+ * Renders a text component.
+ */
+function renderText(node: any): void {
+  let plan = node.plan;
+  if (plan === null) {
+    plan = buildTextPlan(node);
+    node.plan = plan;
+  }
+
+  const mode = plan.mode;
+  if (mode === TEXT_COLORED && plan.colorSlot >= 0) {
+    const color = animatedValue(+plan.colorSlot);
+    textSlotColored(plan.labelSlot, (color & 0xFF) * (1/255), ((color >>> 8) & 0xFF) * (1/255),
+      ((color >>> 16) & 0xFF) * (1/255), (color >>> 24) * (1/255));
+  } else if (mode === TEXT_COLORED) {
+    textSlotColored(plan.labelSlot, +plan.r, +plan.g, +plan.b, +plan.a);
+  } else if (mode === TEXT_DISABLED) {
+    textSlotDisabled(plan.labelSlot);
+  } else if (mode === TEXT_WRAPPED) {
+    textSlotWrapped(plan.labelSlot);
   } else {
-    _igText(tmpUtf8(text));
+    textSlot(plan.labelSlot);
   }
 }
 
@@ -423,181 +1493,1527 @@ function renderText(node: any, vec4: c_ptr): void {
  */
 function renderGroup(node: any): void {
   _igBeginGroup();
-  if (node.children) {
-    for (let i = 0; i < node.children.length; i++) {
-      renderNode(node.children[i]);
-    }
+  for (let c = node.firstChild; c; c = c.nextSibling) {
+    renderNode(c);
   }
   _igEndGroup();
 }
 
+// Compiled <static> subtrees: a flat list of instructions, each an opcode
+// followed by its operands, replayed without visiting the nodes.
+const STATIC_OP_TEXT = 0;          // label slot
+const STATIC_OP_TEXT_COLORED = 1;  // label slot, r, g, b, a
+const STATIC_OP_TEXT_DISABLED = 2; // label slot
+const STATIC_OP_TEXT_WRAPPED = 3;  // label slot
+const STATIC_OP_SEPARATOR = 4;
+const STATIC_OP_SAMELINE = 5;
+const STATIC_OP_INDENT = 6;
+const STATIC_OP_UNINDENT = 7;
+const STATIC_OP_BEGIN_GROUP = 8;
+const STATIC_OP_END_GROUP = 9;
+
+/**
+ * Appends the instructions of `node` and its subtree to `code`. The labels
+ * stay in the slots of the nodes' own plans, so releaseNode() frees them as
+ * usual. Returns false if the subtree holds a node that can't be compiled:
+ * anything interactive or stateful.
+ */
+function compileStaticNode(node: any, code: any): boolean {
+  const tag = +node.tag;
+  let plan = node.plan;
+  if (tag === TAG_TEXT_NODE) {
+    if (plan === null) {
+      plan = { labelSlot: nodeUtf8(node, 0, node.text) };
+      node.plan = plan;
+    }
+    code.push(STATIC_OP_TEXT, plan.labelSlot);
+    return true;
+  }
+  if (tag === TAG_TEXT) {
+    if (plan === null) {
+      plan = buildTextPlan(node);
+      node.plan = plan;
+    }
+    const mode = plan.mode;
+    if (mode === TEXT_COLORED) {
+      code.push(STATIC_OP_TEXT_COLORED, plan.labelSlot, plan.r, plan.g, plan.b, plan.a);
+    } else if (mode === TEXT_DISABLED) {
+      code.push(STATIC_OP_TEXT_DISABLED, plan.labelSlot);
+    } else if (mode === TEXT_WRAPPED) {
+      code.push(STATIC_OP_TEXT_WRAPPED, plan.labelSlot);
+    } else {
+      code.push(STATIC_OP_TEXT, plan.labelSlot);
+    }
+    return true;
+  }
+  if (tag === TAG_SEPARATOR) {
+    code.push(STATIC_OP_SEPARATOR);
+    return true;
+  }
+  if (tag === TAG_SAMELINE) {
+    code.push(STATIC_OP_SAMELINE);
+    return true;
+  }
+
+  let end = -1;
+  if (tag === TAG_GROUP) {
+    code.push(STATIC_OP_BEGIN_GROUP);
+    end = STATIC_OP_END_GROUP;
+  } else if (tag === TAG_INDENT) {
+    code.push(STATIC_OP_INDENT);
+    end = STATIC_OP_UNINDENT;
+  } else if (tag !== TAG_STATIC) {
+    return false;
+  }
+  for (let c = node.firstChild; c; c = c.nextSibling) {
+    if (!compileStaticNode(c, code)) return false;
+  }
+  if (end >= 0) code.push(end);
+  return true;
+}
+
+/**
+ * Builds the render plan for a <static>: its subtree compiled into one
+ * instruction list, or `code` null if it can't be. The plan is tied to the
+ * node's tree version, which every commit below it bumps.
+ */
+function buildStaticPlan(node: any): any {
+  const code: any = [];
+  let compiled = true;
+  for (let c = node.firstChild; c; c = c.nextSibling) {
+    if (!compileStaticNode(c, code)) {
+      compiled = false;
+      break;
+    }
+  }
+  return { version: node.version, code: compiled ? code : null };
+}
+
+/**
+ * Renders a <static>. A compiled subtree is replayed as a linear loop, with
+ * no per-node ID push/pop or dispatch; otherwise the children are rendered
+ * as usual.
+ */
+function renderStatic(node: any): void {
+  let plan = node.plan;
+  if (plan === null || plan.version !== node.version) {
+    plan = buildStaticPlan(node);
+    node.plan = plan;
+  }
+  const code = plan.code;
+  if (code === null) {
+    for (let c = node.firstChild; c; c = c.nextSibling) {
+      renderNode(c);
+    }
+    return;
+  }
+
+  const n = code.length;
+  let i = 0;
+  while (i < n) {
+    const op = +code[i];
+    if (op === STATIC_OP_TEXT) {
+      textSlot(+code[i + 1]);
+      i += 2;
+    } else if (op === STATIC_OP_TEXT_COLORED) {
+      textSlotColored(+code[i + 1], +code[i + 2], +code[i + 3], +code[i + 4], +code[i + 5]);
+      i += 6;
+    } else if (op === STATIC_OP_TEXT_DISABLED) {
+      textSlotDisabled(+code[i + 1]);
+      i += 2;
+    } else if (op === STATIC_OP_TEXT_WRAPPED) {
+      textSlotWrapped(+code[i + 1]);
+      i += 2;
+    } else {
+      if (op === STATIC_OP_SEPARATOR) {
+        _igSeparator();
+      } else if (op === STATIC_OP_SAMELINE) {
+        _igSameLine(0.0, -1.0);
+      } else if (op === STATIC_OP_INDENT) {
+        _igIndent(0.0);
+      } else if (op === STATIC_OP_UNINDENT) {
+        _igUnindent(0.0);
+      } else if (op === STATIC_OP_BEGIN_GROUP) {
+        _igBeginGroup();
+      } else {
+        _igEndGroup();
+      }
+      i += 1;
+    }
+  }
+}
+
+/**
+ * Builds the render plan for a tree node. `open` is -1 when the node is
+ * uncontrolled, otherwise 0 or 1.
+ */
+function buildTreeNodePlan(node: any): any {
+  const props = node.props;
+  const label = (props && props.label !== undefined) ? String(props.label) : "";
+  let flags = _ImGuiTreeNodeFlags_OpenOnArrow | _ImGuiTreeNodeFlags_OpenOnDoubleClick |
+    _ImGuiTreeNodeFlags_SpanAvailWidth;
+  const leaf = !!(props && props.leaf);
+  if (leaf) flags |= _ImGuiTreeNodeFlags_Leaf | _ImGuiTreeNodeFlags_NoTreePushOnOpen;
+  if (props && props.selected) flags |= _ImGuiTreeNodeFlags_Selected;
+  return {
+    labelSlot: nodeUtf8(node, 0, label),
+    flags: flags,
+    leaf: leaf,
+    open: (props && props.open !== undefined) ? (props.open ? 1 : 0) : -1,
+    defaultOpen: !!(props && props.defaultOpen),
+  };
+}
+
+/**
+ * Renders a <treenode> over igTreeNodeEx(). The children are only walked
+ * while it is open, and every toggle is reported through onExpand(open), so
+ * that React can mount them only then (LazyTreeNode in
+ * react-imgui-reconciler/lazy-tree.js). With an `open` prop the node is
+ * controlled: it shows that state whatever ImGui remembers.
+ */
+function renderTreeNode(node: any): void {
+  let plan = node.plan;
+  if (plan === null) {
+    plan = buildTreeNodePlan(node);
+    node.plan = plan;
+  }
+  let state = node.state;
+  if (state === null) {
+    state = { open: plan.open >= 0 ? plan.open === 1 : plan.defaultOpen };
+    node.state = state;
+    if (plan.open < 0) _igSetNextItemOpen(plan.defaultOpen, _ImGuiCond_Once);
+  }
+  if (plan.open >= 0) _igSetNextItemOpen(plan.open === 1, _ImGuiCond_Always);
+
+  const open = _igTreeNodeEx_Str(utf8SlotPtr(plan.labelSlot), plan.flags);
+  if (plan.leaf) return;
+  if (open) {
+    for (let c = node.firstChild; c; c = c.nextSibling) {
+      renderNode(c);
+    }
+    _igTreePop();
+  }
+  if (open !== state.open) {
+    state.open = open;
+    safeInvokeEvent(EVENT_DISCRETE, node.props ? node.props.onExpand : null, open);
+  }
+}
+
 /**
- * Renders a collapsing header component.
+ * Builds the render plan for a <tabitem>. `selected` is -1 when the tab is
+ * uncontrolled, otherwise 0 or 1.
  */
-function renderCollapsingHeader(node: any): void {
+function buildTabItemPlan(node: any): any {
   const props = node.props;
-  const headerTitle = (props && props.title) ? props.title : "Section";
-  if (_igCollapsingHeader_TreeNodeFlags(tmpUtf8(headerTitle), 0)) {
-    if (node.children) {
-      for (let i = 0; i < node.children.length; i++) {
-        renderNode(node.children[i]);
+  const label = (props && props.label !== undefined) ? String(props.label) : "";
+  return {
+    labelSlot: nodeUtf8(node, 0, label),
+    flags: (props && props.flags !== undefined) ? +props.flags : 0,
+    selected: (props && props.selected !== undefined) ? (props.selected ? 1 : 0) : -1,
+    closable: !!(props && props.onClose),
+  };
+}
+
+/**
+ * Renders a <tabitem> over igBeginTabItem(). Only the active tab's children
+ * are walked, and every change of the active tab is reported through
+ * onSelect(active), so that React can keep the others unmounted
+ * (LazyTabItem in react-imgui-reconciler/lazy-tabs.js). With `selected` the
+ * tab is controlled: a tab that should be active is selected again, and
+ * snaps back unless React follows.
+ */
+function renderTabItem(node: any): void {
+  let plan = node.plan;
+  if (plan === null) {
+    plan = buildTabItemPlan(node);
+    node.plan = plan;
+  }
+  let state = node.state;
+  if (state === null) {
+    state = { active: false };
+    node.state = state;
+  }
+
+  let flags = plan.flags;
+  if (plan.selected === 1 && !state.active) flags |= _ImGuiTabItemFlags_SetSelected;
+  // Read after the children render, so it cannot be a scratch register
+  const pOpen = plan.closable ? allocTmp(_sizeof_c_bool) : c_null;
+  if (plan.closable) _sh_ptr_write_c_bool(pOpen, 0, 1);
+
+  const active = _igBeginTabItem(utf8SlotPtr(plan.labelSlot), pOpen, flags);
+  if (active) {
+    for (let c = node.firstChild; c; c = c.nextSibling) {
+      renderNode(c);
+    }
+    _igEndTabItem();
+  }
+  if (active !== state.active) {
+    state.active = active;
+    safeInvokeEvent(EVENT_DISCRETE, node.props ? node.props.onSelect : null, active);
+  }
+  if (plan.closable && !_sh_ptr_read_c_bool(pOpen, 0)) {
+    safeInvokeEvent(EVENT_DISCRETE, node.props.onClose);
+  }
+}
+
+/**
+ * Builds the render plan for a table. An invalid column count is reported
+ * once here and the plan is marked invalid so rendering skips the table.
+ * Virtualized tables split their children into setup children (columns,
+ * header) and the rows handed to the clipper.
+ */
+function buildTablePlan(node: any): any {
+  const props = node.props;
+  const tableId = (props && props.id) ? props.id : "table";
+  const columnCount = (props && props.columns !== undefined) ? +props.columns : 1;
+  const valid = +columnCount > 0;
+  if (_IMGUI_UNIT_CHECKS && !valid) {
+    console.error(
+      `<table> requires a positive 'columns' prop. Got: columns=${columnCount}. Skipping table.`
+    );
+  }
+  const tableFlags = (props && props.flags !== undefined) ? props.flags : _ImGuiTableFlags_Resizable;
+
+  const virtualized = !!(props && props.virtualized);
+  const setupChildren: any = [];
+  const rows: any = [];
+  if (virtualized) {
+    for (let c = node.firstChild; c; c = c.nextSibling) {
+      if (c.tag === TAG_TABLEROW) {
+        rows.push(c);
+      } else {
+        setupChildren.push(c);
       }
     }
   }
+
+  return {
+    id: tableId,
+    columns: columnCount,
+    flags: tableFlags,
+    valid: valid,
+    virtualized: virtualized,
+    rowHeight: (props && props.rowHeight !== undefined) ? +props.rowHeight : 0,
+    setupChildren: setupChildren,
+    rows: rows,
+  };
+}
+
+/**
+ * Renders a table component.
+ */
+function renderTable(node: any, vec2: c_ptr): void {
+  let plan = node.plan;
+  if (plan === null) {
+    plan = buildTablePlan(node);
+    plan.idSlot = nodeUtf8(node, 0, plan.id);
+    node.plan = plan;
+  }
+  if (!plan.valid) return;
+
+  if (_igBeginTable_flat(utf8SlotPtr(plan.idSlot), plan.columns, plan.flags, 0, 0, 0)) {
+    if (plan.virtualized) {
+      const setupChildren: any = plan.setupChildren;
+      for (let i = 0; i < setupChildren.length; i++) {
+        renderNode(setupChildren[i]);
+      }
+      renderClippedChildren(plan.rows, +plan.rowHeight);
+    } else {
+      for (let c = node.firstChild; c; c = c.nextSibling) {
+        renderNode(c);
+      }
+    }
+    _igEndTable();
+  }
 }
 
 /**
- * Renders an indent component.
+ * Renders a table row component.
  */
-function renderIndent(node: any): void {
-  _igIndent(0.0);
-  if (node.children) {
-    for (let i = 0; i < node.children.length; i++) {
-      renderNode(node.children[i]);
+function renderTableRow(node: any): void {
+  let plan = node.plan;
+  if (plan === null) {
+    const props = node.props;
+    plan = {
+      flags: (props && props.flags !== undefined) ? props.flags : 0,
+      minHeight: (props && props.minHeight !== undefined) ? props.minHeight : 0,
+    };
+    node.plan = plan;
+  }
+  _igTableNextRow(plan.flags, plan.minHeight);
+
+  for (let c = node.firstChild; c; c = c.nextSibling) {
+    renderNode(c);
+  }
+}
+
+/**
+ * Renders a table cell component.
+ */
+function renderTableCell(node: any): void {
+  let plan = node.plan;
+  if (plan === null) {
+    const props = node.props;
+    plan = { index: (props && props.index !== undefined) ? props.index : 0 };
+    node.plan = plan;
+  }
+  _igTableSetColumnIndex(plan.index);
+
+  for (let c = node.firstChild; c; c = c.nextSibling) {
+    renderNode(c);
+  }
+}
+
+/**
+ * Renders a table column setup.
+ */
+function renderTableColumn(node: any): void {
+  let plan = node.plan;
+  if (plan === null) {
+    const props = node.props;
+    plan = {
+      labelSlot: nodeUtf8(node, 0, (props && props.label) ? props.label : ""),
+      flags: (props && props.flags !== undefined) ? props.flags : _ImGuiTableColumnFlags_None,
+      width: (props && props.width !== undefined) ? props.width : 0,
+    };
+    node.plan = plan;
+  }
+  _igTableSetupColumn(utf8SlotPtr(plan.labelSlot), plan.flags, plan.width, 0);
+}
+
+/**
+ * Builds the render plan for a rectangle.
+ */
+function buildRectPlan(props: any): any {
+  const xSlot = animatedSlotOf(props && props.x);
+  const ySlot = animatedSlotOf(props && props.y);
+  const widthSlot = animatedSlotOf(props && props.width);
+  const heightSlot = animatedSlotOf(props && props.height);
+  const rectX = xSlot >= 0 ? 0 : validateNumber((props && props.x !== undefined) ? props.x : 0, 0, "rect x");
+  const rectY = ySlot >= 0 ? 0 : validateNumber((props && props.y !== undefined) ? props.y : 0, 0, "rect y");
+  const rectWidth = widthSlot >= 0 ? 0 : validateNumber((props && props.width !== undefined) ? props.width : 100, 100, "rect width");
+  const rectHeight = heightSlot >= 0 ? 0 : validateNumber((props && props.height !== undefined) ? props.height : 100, 100, "rect height");
+  const rectFilled = (props && props.filled !== undefined) ? props.filled : true;
+  const colorSlot = animatedSlotOf(props && props.color);
+  // Parse color (default: white)
+  const rectColor = (colorSlot < 0 && props && props.color)
+    ? parseColorToABGR(props.color)
+    : 0xFFFFFFFF;
+  return {
+    x: rectX, y: rectY, width: rectWidth, height: rectHeight,
+    filled: rectFilled, color: rectColor,
+    xSlot: xSlot, ySlot: ySlot, widthSlot: widthSlot, heightSlot: heightSlot,
+    colorSlot: colorSlot,
+  };
+}
+
+/**
+ * Renders a rectangle component.
+ */
+function renderRect(node: any, vec2: c_ptr): void {
+  let plan = node.plan;
+  if (plan === null) {
+    plan = buildRectPlan(node.props);
+    node.plan = plan;
+  }
+  const drawList = _igGetWindowDrawList();
+  const rectX = plan.xSlot >= 0 ? animatedValue(+plan.xSlot) : +plan.x;
+  const rectY = plan.ySlot >= 0 ? animatedValue(+plan.ySlot) : +plan.y;
+  const rectWidth = plan.widthSlot >= 0 ? animatedValue(+plan.widthSlot) : +plan.width;
+  const rectHeight = plan.heightSlot >= 0 ? animatedValue(+plan.heightSlot) : +plan.height;
+  const rectColor = plan.colorSlot >= 0 ? animatedValue(+plan.colorSlot) : +plan.color;
+
+  // Get window cursor position (top-left of content area)
+  _igGetCursorScreenPos(vec2);
+  const winX = +get_ImVec2_x(vec2);
+  const winY = +get_ImVec2_y(vec2);
+
+  // Calculate absolute screen coordinates
+  const minX = winX + rectX;
+  const minY = winY + rectY;
+  const maxX = minX + rectWidth;
+  const maxY = minY + rectHeight;
+
+  // Cull when scrolled out of the current clip rect
+  if (!_igIsRectVisible_Vec2_flat(minX, minY, maxX, maxY)) return;
+
+  if (plan.filled) {
+    _ImDrawList_AddRectFilled_flat(drawList, minX, minY, maxX, maxY, rectColor, 0.0, 0);
+  } else {
+    _ImDrawList_AddRect_flat(drawList, minX, minY, maxX, maxY, rectColor, 0.0, 0, 1.0);
+  }
+}
+
+/**
+ * Builds the render plan for a circle.
+ */
+function buildCirclePlan(props: any): any {
+  const xSlot = animatedSlotOf(props && props.x);
+  const ySlot = animatedSlotOf(props && props.y);
+  const radiusSlot = animatedSlotOf(props && props.radius);
+  const circleX = xSlot >= 0 ? 0 : validateNumber((props && props.x !== undefined) ? props.x : 50, 50, "circle x");
+  const circleY = ySlot >= 0 ? 0 : validateNumber((props && props.y !== undefined) ? props.y : 50, 50, "circle y");
+  const circleRadius = radiusSlot >= 0 ? 0 : validateNumber((props && props.radius !== undefined) ? props.radius : 10, 10, "circle radius");
+  const circleFilled = (props && props.filled !== undefined) ? props.filled : true;
+  const circleSegments = validateNumber((props && props.segments !== undefined) ? props.segments : 12, 12, "circle segments");
+  const colorSlot = animatedSlotOf(props && props.color);
+  // Parse color (default: white)
+  const circleColor = (colorSlot < 0 && props && props.color)
+    ? parseColorToABGR(props.color)
+    : 0xFFFFFFFF;
+  return {
+    x: circleX, y: circleY, radius: circleRadius, filled: circleFilled,
+    segments: circleSegments, color: circleColor,
+    xSlot: xSlot, ySlot: ySlot, radiusSlot: radiusSlot, colorSlot: colorSlot,
+  };
+}
+
+/**
+ * Renders a circle component.
+ */
+function renderCircle(node: any, vec2: c_ptr): void {
+  let plan = node.plan;
+  if (plan === null) {
+    plan = buildCirclePlan(node.props);
+    node.plan = plan;
+  }
+  const circleDrawList = _igGetWindowDrawList();
+
+  // Get window cursor position
+  _igGetCursorScreenPos(vec2);
+  const circleWinX = +get_ImVec2_x(vec2);
+  const circleWinY = +get_ImVec2_y(vec2);
+  const centerX = circleWinX + (plan.xSlot >= 0 ? animatedValue(+plan.xSlot) : +plan.x);
+  const centerY = circleWinY + (plan.ySlot >= 0 ? animatedValue(+plan.ySlot) : +plan.y);
+  const radius = plan.radiusSlot >= 0 ? animatedValue(+plan.radiusSlot) : +plan.radius;
+  const circleColor = plan.colorSlot >= 0 ? animatedValue(+plan.colorSlot) : +plan.color;
+
+  // Cull when the bounding box is scrolled out of the current clip rect
+  if (!_igIsRectVisible_Vec2_flat(centerX - radius, centerY - radius, centerX + radius, centerY + radius)) return;
+
+  if (plan.filled) {
+    _ImDrawList_AddCircleFilled_flat(circleDrawList, centerX, centerY, radius, circleColor, plan.segments);
+  } else {
+    _ImDrawList_AddCircle_flat(circleDrawList, centerX, centerY, radius, circleColor, plan.segments, 1.0);
+  }
+}
+
+// Native image helpers (imgui-runtime.cpp)
+const _image_texture = $SHBuiltin.extern_c({}, function image_texture(index: c_int, uv: c_ptr): c_ptr { throw 0; });
+const _image_width = $SHBuiltin.extern_c({}, function image_width(index: c_int): c_int { throw 0; });
+const _image_height = $SHBuiltin.extern_c({}, function image_height(index: c_int): c_int { throw 0; });
+
+// Receives the UV rectangle of an image in its texture (u0, v0, u1, v1)
+const scratchImageUV = calloc(16);
+
+/**
+ * Drops the image an <image> loaded from `src`. A load still in flight
+ * unloads its result when it completes.
+ */
+function releaseImage(state: any): void {
+  if (state.handle >= 0) (globalThis as any).unloadImage(state.handle);
+  state.handle = -1;
+  state.src = null;
+}
+
+/**
+ * Starts loading `src` for an <image>. The previous image stays drawn until
+ * the new one is ready, then is released.
+ */
+function loadNodeImage(state: any, src: string, mipmaps: boolean): void {
+  state.src = src;
+  state.mipmaps = mipmaps;
+  const options = { mipmaps: mipmaps };
+  (globalThis as any).loadImageAsync(src, options).then(function (handle: any): void {
+    if (state.src !== src || state.mipmaps !== mipmaps) {
+      // Released, or src changed again meanwhile
+      (globalThis as any).unloadImage(handle);
+      return;
+    }
+    if (state.handle >= 0) (globalThis as any).unloadImage(state.handle);
+    state.handle = handle;
+  }, function (e: any): void {
+    console.error(`<image> failed to load ${src}: ${e && e.message ? e.message : e}`);
+  });
+}
+
+/**
+ * Reads a [u, v] prop, or returns `def` (the default corner).
+ */
+function imageUVProp(value: any, index: number, def: number, propName: string): number {
+  if (value === undefined || value === null) return def;
+  return validateNumber(value[index], def, propName);
+}
+
+/**
+ * Builds the render plan for an image. An image given by `src` is loaded
+ * through loadImageAsync() when `src` changes, into node.state, which owns
+ * the handle; a `handle` prop is drawn as is and stays owned by the caller.
+ */
+function buildImagePlan(node: any): any {
+  const props = node.props;
+  let state = node.state;
+  if (state === null) {
+    state = { src: null, mipmaps: false, handle: -1 };
+    node.state = state;
+  }
+  const handle = (props && props.handle !== undefined)
+    ? validateNumber(props.handle, -1, "image handle")
+    : -1;
+  if (handle < 0 && props && props.src) {
+    const src = String(props.src);
+    const mipmaps = !!props.mipmaps;
+    if (state.src !== src || state.mipmaps !== mipmaps) {
+      loadNodeImage(state, src, mipmaps);
+    }
+  } else if (state.src !== null) {
+    releaseImage(state);
+  }
+
+  const uv0 = props ? props.uv0 : undefined;
+  const uv1 = props ? props.uv1 : undefined;
+  const tint = (props && props.tint) ? parseColorToABGR(props.tint) : 0xFFFFFFFF;
+  return {
+    handle: handle,
+    // 0 for the size of the image
+    width: validateNumber((props && props.width !== undefined) ? props.width : 0, 0, "image width"),
+    height: validateNumber((props && props.height !== undefined) ? props.height : 0, 0, "image height"),
+    u0: imageUVProp(uv0, 0, 0, "image uv0"),
+    v0: imageUVProp(uv0, 1, 0, "image uv0"),
+    u1: imageUVProp(uv1, 0, 1, "image uv1"),
+    v1: imageUVProp(uv1, 1, 1, "image uv1"),
+    tintR: (tint & 0xFF) * (1/255),
+    tintG: ((tint >>> 8) & 0xFF) * (1/255),
+    tintB: ((tint >>> 16) & 0xFF) * (1/255),
+    tintA: (tint >>> 24) * (1/255),
+  };
+}
+
+/**
+ * Renders an image component. The texture and its atlas UVs come from one
+ * native call on the cached handle; until an image given by `src` is
+ * loaded, the placeholder is drawn.
+ */
+function renderImage(node: any): void {
+  let plan = node.plan;
+  if (plan === null) {
+    plan = buildImagePlan(node);
+    node.plan = plan;
+  }
+  const handle = plan.handle >= 0 ? +plan.handle : +node.state.handle;
+
+  let width = +plan.width;
+  let height = +plan.height;
+  if (width <= 0 || height <= 0) {
+    const w = _image_width(handle);
+    const h = _image_height(handle);
+    if (width <= 0 && height <= 0) {
+      width = w;
+      height = h;
+    } else if (width <= 0) {
+      width = h > 0 ? height * w / h : 0;
+    } else {
+      height = w > 0 ? width * h / w : 0;
+    }
+  }
+
+  // Map the requested UVs into the image's rectangle of its texture
+  const texture = _image_texture(handle, scratchImageUV);
+  const au0 = +_sh_ptr_read_c_float(scratchImageUV, 0);
+  const av0 = +_sh_ptr_read_c_float(scratchImageUV, 4);
+  const aw = +_sh_ptr_read_c_float(scratchImageUV, 8) - au0;
+  const ah = +_sh_ptr_read_c_float(scratchImageUV, 12) - av0;
+  _igImage_flat(texture, width, height,
+    au0 + plan.u0 * aw, av0 + plan.v0 * ah, au0 + plan.u1 * aw, av0 + plan.v1 * ah,
+    +plan.tintR, +plan.tintG, +plan.tintB, +plan.tintA, 0, 0, 0, 0);
+}
+
+// Heatmaps: a value grid mapped to colors (heatmap.c) into the pixels of a
+// stream texture (imgui-runtime's StreamTexture), drawn as one image
+const _heatmap_range = $SHBuiltin.extern_c({}, function heatmap_range(values: c_ptr, count: c_int, out: c_ptr): c_bool { throw 0; });
+const _heatmap_fill = $SHBuiltin.extern_c({}, function heatmap_fill(values: c_ptr, count: c_int, total: c_int, lo: c_float, hi: c_float, lut: c_ptr, pixels: c_ptr): void { throw 0; });
+const _stream_texture_pixels = $SHBuiltin.extern_c({}, function stream_texture_pixels(index: c_int): c_ptr { throw 0; });
+const _stream_texture_update = $SHBuiltin.extern_c({}, function stream_texture_update(index: c_int): void { throw 0; });
+
+// Node slots of a <heatmap>: the palette lookup table and the values of a
+// grid that is not shared
+const HEATMAP_LUT_SLOT = 0;
+const HEATMAP_DATA_SLOT = 1;
+const HEATMAP_LUT_SIZE = 256;
+
+// Viridis, the default palette
+const HEATMAP_DEFAULT_PALETTE: any = ["#440154", "#3B528B", "#21918C", "#5EC962", "#FDE725"];
+
+/**
+ * Writes HEATMAP_LUT_SIZE ABGR colors into `buf`, interpolated between the
+ * colors of `palette` (spread evenly from the lowest to the highest value).
+ */
+function fillHeatmapLUT(buf: c_ptr, palette: any): void {
+  "use unsafe";
+
+  const stops: any = [];
+  for (let i = 0; i < palette.length; i++) stops.push(parseColorToABGR(palette[i]));
+  const last = stops.length - 1;
+  for (let i = 0; i < HEATMAP_LUT_SIZE; i++) {
+    const t = last * i / (HEATMAP_LUT_SIZE - 1);
+    const k = t < last ? Math.floor(t) : last - 1;
+    const f = t - k;
+    const a = +stops[k];
+    const b = +stops[k + 1];
+    let color = 0;
+    for (let shift = 0; shift < 32; shift += 8) {
+      const ca = (a >>> shift) & 0xFF;
+      const cb = (b >>> shift) & 0xFF;
+      color |= Math.round(ca + (cb - ca) * f) << shift;
+    }
+    _sh_ptr_write_c_uint(buf, i * 4, color >>> 0);
+  }
+}
+
+/**
+ * Builds the render plan for a <heatmap>. The palette is resolved into a
+ * lookup table here; a `values` array from createSharedArray() is read in
+ * place, any other is converted to floats once, like <plotlines>.
+ */
+function buildHeatmapPlan(node: any): any {
+  "use unsafe";
+
+  const props = node.props;
+  const values: any = props ? props.values : undefined;
+  const count = (values && typeof values.length === 'number') ? +values.length : 0;
+  const columns = Math.floor(validateNumber((props && props.columns !== undefined) ? props.columns : 0, 0, "heatmap columns"));
+  const rows = (props && props.rows !== undefined)
+    ? Math.floor(validateNumber(props.rows, 0, "heatmap rows"))
+    : (columns > 0 ? Math.ceil(count / columns) : 0);
+  const valid = columns > 0 && rows > 0;
+  if (_IMGUI_UNIT_CHECKS && !valid) {
+    console.error(`<heatmap> requires a positive 'columns' prop and values. Got: columns=${columns}, rows=${rows}.`);
+  }
+
+  const shared = isSharedArray(values) && values instanceof Float32Array;
+  const used = count < columns * rows ? count : columns * rows;
+  let dataSlot = -1;
+  if (!shared && used > 0) {
+    dataSlot = nodeBuffer(node, HEATMAP_DATA_SLOT, used * 4);
+    const buf = slotPtr(dataSlot);
+    for (let i = 0; i < used; i++) {
+      _sh_ptr_write_c_float(buf, i * 4, +values[i]);
+    }
+  }
+  if (dataSlot < 0) trimNodeSlots(node, HEATMAP_DATA_SLOT);
+
+  const palette: any = (props && Array.isArray(props.palette) && props.palette.length >= 2)
+    ? props.palette : HEATMAP_DEFAULT_PALETTE;
+  const lutSlot = nodeBuffer(node, HEATMAP_LUT_SLOT, HEATMAP_LUT_SIZE * 4);
+  fillHeatmapLUT(slotPtr(lutSlot), palette);
+
+  // Either end of the value range left out is that of the data
+  const hasMin = !!(props && props.min !== undefined);
+  const hasMax = !!(props && props.max !== undefined);
+
+  return {
+    valid: valid,
+    columns: columns,
+    rows: rows,
+    count: used,
+    shared: shared,
+    dataSlot: dataSlot,
+    lutSlot: lutSlot,
+    hasMin: hasMin,
+    hasMax: hasMax,
+    min: hasMin ? validateNumber(props.min, 0, "heatmap min") : 0,
+    max: hasMax ? validateNumber(props.max, 1, "heatmap max") : 1,
+    // Without a version, a shared grid may change on any frame
+    cacheable: !shared || (props && props.version !== undefined),
+    width: validateNumber((props && props.width !== undefined) ? props.width : columns, columns, "heatmap width"),
+    height: validateNumber((props && props.height !== undefined) ? props.height : rows, rows, "heatmap height"),
+  };
+}
+
+/**
+ * Drops the stream texture of a <heatmap>.
+ */
+function releaseHeatmap(state: any): void {
+  if (state.handle >= 0) (globalThis as any).unloadImage(state.handle);
+  state.handle = -1;
+  state.filled = null;
+}
+
+/**
+ * Renders a <heatmap>: the grid is mapped to colors into its stream texture
+ * when the plan changes (or on every frame for a shared grid without a
+ * version), and drawn as a single textured quad, whatever the cell count.
+ */
+function renderHeatmap(node: any): void {
+  let plan = node.plan;
+  if (plan === null) {
+    plan = buildHeatmapPlan(node);
+    node.plan = plan;
+  }
+  if (!plan.valid) return;
+
+  let state = node.state;
+  if (state === null) {
+    state = { handle: -1, columns: 0, rows: 0, filled: null };
+    node.state = state;
+  }
+  if (state.handle < 0 || state.columns !== plan.columns || state.rows !== plan.rows) {
+    releaseHeatmap(state);
+    state.handle = +(globalThis as any).createStreamTexture(plan.columns, plan.rows).handle;
+    state.columns = plan.columns;
+    state.rows = plan.rows;
+  }
+
+  if (state.filled !== plan || !plan.cacheable) {
+    let data: c_ptr = c_null;
+    let count = 0;
+    if (plan.shared) {
+      // The lookup fails once the array is gone
+      if (isSharedArray(node.props.values)) {
+        data = sharedArrayPtr(node.props.values);
+        count = +plan.count;
+      }
+    } else if (plan.dataSlot >= 0) {
+      data = slotPtr(plan.dataSlot);
+      count = +plan.count;
+    }
+    let lo = +plan.min;
+    let hi = +plan.max;
+    if ((!plan.hasMin || !plan.hasMax) && count > 0 && _heatmap_range(data, count, scratchVec2C)) {
+      if (!plan.hasMin) lo = +_sh_ptr_read_c_float(scratchVec2C, 0);
+      if (!plan.hasMax) hi = +_sh_ptr_read_c_float(scratchVec2C, 4);
+    }
+    _heatmap_fill(data, count, plan.columns * plan.rows, lo, hi,
+      slotPtr(plan.lutSlot), _stream_texture_pixels(state.handle));
+    _stream_texture_update(state.handle);
+    state.filled = plan;
+  }
+
+  // The texture is uploaded before the frame's draws
+  const texture = _image_texture(state.handle, scratchImageUV);
+  _igImage_flat(texture, +plan.width, +plan.height, 0, 0, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0);
+}
+
+// Line-indexed text views for <textview> (imgui-runtime's TextView.cpp)
+const _text_view_open_file = $SHBuiltin.extern_c({}, function text_view_open_file(path: c_ptr, follow: c_bool): c_int { throw 0; });
+const _text_view_open_buffer = $SHBuiltin.extern_c({}, function text_view_open_buffer(handle: c_int, offset: c_size_t, length: c_size_t): c_int { throw 0; });
+const _text_view_close = $SHBuiltin.extern_c({}, function text_view_close(view: c_int): void { throw 0; });
+const _text_view_render = $SHBuiltin.extern_c({}, function text_view_render(view: c_int, id: c_ptr, width: c_float, height: c_float, stick_to_end: c_bool): void { throw 0; });
+
+/**
+ * Builds the render plan for a <textview>. Slot 0 of the node holds the id,
+ * slot 1 the path of the file.
+ */
+function buildTextViewPlan(node: any): any {
+  const props = node.props;
+  const file = (props && props.file !== undefined && props.file !== null) ? String(props.file) : "";
+  // A tail from fs.watchTail() is followed unless follow={false}
+  const tail = (file === "" && props && props.tail) ? props.tail : null;
+  return {
+    idSlot: nodeUtf8(node, 0, (props && props.id !== undefined) ? String(props.id) : "textview"),
+    file: file,
+    fileSlot: nodeUtf8(node, 1, file),
+    buffer: (file === "" && tail === null && props) ? props.buffer : undefined,
+    tail: tail,
+    follow: tail !== null ? props.follow !== false : !!(props && props.follow),
+    width: validateNumber((props && props.width !== undefined) ? props.width : 0, 0, "textview width"),
+    height: validateNumber((props && props.height !== undefined) ? props.height : 0, 0, "textview height"),
+  };
+}
+
+/**
+ * Closes the native view of a <textview>.
+ */
+function releaseTextView(state: any): void {
+  if (state.view >= 0) _text_view_close(state.view);
+  state.view = -1;
+}
+
+/**
+ * Renders a <textview>: the lines in view of a mapped file, a shared
+ * buffer or a tail, drawn natively from its memory. The view is opened
+ * again when its source changes; a tail's view belongs to the tail.
+ */
+function renderTextView(node: any): void {
+  let plan = node.plan;
+  if (plan === null) {
+    plan = buildTextViewPlan(node);
+    node.plan = plan;
+  }
+  if (plan.tail !== null) {
+    // A view opened for an earlier file or buffer
+    if (node.state !== null) {
+      releaseTextView(node.state);
+      node.state = null;
+    }
+    // -1 once the tail is closed
+    const view = +plan.tail.view;
+    if (view >= 0) {
+      _text_view_render(view, utf8SlotPtr(plan.idSlot), +plan.width, +plan.height, plan.follow);
+    }
+    return;
+  }
+  let state = node.state;
+  if (state === null) {
+    state = { view: -1, file: "", buffer: undefined, follow: false };
+    node.state = state;
+  }
+  if (state.file !== plan.file || state.buffer !== plan.buffer || state.follow !== plan.follow) {
+    releaseTextView(state);
+    state.file = plan.file;
+    state.buffer = plan.buffer;
+    state.follow = plan.follow;
+    const buffer = plan.buffer;
+    if (plan.file !== "") {
+      state.view = _text_view_open_file(utf8SlotPtr(plan.fileSlot), plan.follow);
+    } else if (isSharedArray(buffer)) {
+      state.view = _text_view_open_buffer(+buffer.nativeHandle, +buffer.byteOffset, +buffer.byteLength);
+    } else if (buffer !== undefined && buffer !== null) {
+      console.error("<textview> buffer must be an array from createSharedArray()");
+    }
+  }
+  if (state.view >= 0) {
+    _text_view_render(state.view, utf8SlotPtr(plan.idSlot), +plan.width, +plan.height, plan.follow);
+  }
+}
+
+// Fonts for <font> (imgui-runtime's FontRegistry.cpp)
+const _font_load = $SHBuiltin.extern_c({}, function font_load(file: c_ptr, size: c_float, ranges: c_int): c_int { throw 0; });
+const _font_push = $SHBuiltin.extern_c({}, function font_push(handle: c_int): c_bool { throw 0; });
+
+// Glyph ranges of <font ranges>, by name. Must match FontRanges in
+// FontRegistry.h.
+const FONT_RANGES: any = {
+  default: 0, greek: 1, cyrillic: 2, korean: 3, japanese: 4,
+  chinese: 5, "chinese-full": 6, thai: 7, vietnamese: 8,
+};
+
+/**
+ * Builds the render plan for a <font>. The font is loaded here, once per
+ * (name, size, ranges) for the whole app; slot 0 of the node holds the
+ * name for the call.
+ */
+function buildFontPlan(node: any): any {
+  const props = node.props;
+  const name = (props && props.name !== undefined && props.name !== null) ? String(props.name) : "";
+  const size = validateNumber((props && props.size !== undefined) ? props.size : 13, 13, "font size");
+  let ranges = 0;
+  if (props && props.ranges !== undefined) {
+    const r = FONT_RANGES[String(props.ranges)];
+    if (r !== undefined) {
+      ranges = r;
+    } else if (_IMGUI_UNIT_CHECKS) {
+      console.error(`Invalid font ranges: ${props.ranges}. Using default.`);
+    }
+  }
+  return { handle: _font_load(utf8SlotPtr(nodeUtf8(node, 0, name)), size, ranges) };
+}
+
+/**
+ * Renders a <font>: its children with the font pushed, or in the current
+ * font while it loads.
+ */
+function renderFont(node: any): void {
+  let plan = node.plan;
+  if (plan === null) {
+    plan = buildFontPlan(node);
+    node.plan = plan;
+  }
+  const pushed = _font_push(plan.handle);
+  for (let c = node.firstChild; c; c = c.nextSibling) {
+    renderNode(c);
+  }
+  if (pushed) _igPopFont();
+}
+
+const _number_format_valid = $SHBuiltin.extern_c({}, function number_format_valid(fmt: c_ptr): c_bool { throw 0; });
+const _number_text = $SHBuiltin.extern_c({}, function number_text(fmt: c_ptr, value: c_double): void { throw 0; });
+
+const NUMBER_DEFAULT_FORMAT = "%g";
+
+/**
+ * Builds the render plan for a <number>. Slot 0 of the node holds the
+ * format, encoded and checked by number_format_valid() only when the prop
+ * changes; the value is formatted in C every frame.
+ */
+function buildNumberPlan(node: any): any {
+  const props = node.props;
+  const format = (props && props.format !== undefined && props.format !== null)
+    ? String(props.format) : NUMBER_DEFAULT_FORMAT;
+  const state = node.state;
+  if (state === null || state.format !== format) {
+    if (!_number_format_valid(utf8SlotPtr(nodeUtf8(node, 0, format)))) {
+      if (_IMGUI_UNIT_CHECKS) {
+        console.error(`Invalid number format: ${format}. Expected one %f, %e, %g or %a conversion.`);
+      }
+      nodeUtf8(node, 0, NUMBER_DEFAULT_FORMAT);
+    }
+    node.state = { format: format };
+  }
+
+  const valueSlot = animatedSlotOf(props && props.value);
+  const value = valueSlot >= 0 ? 0
+    : validateNumber((props && props.value !== undefined) ? props.value : 0, 0, "number value");
+  const colorSlot = animatedSlotOf(props && props.color);
+  const color = (colorSlot < 0 && props && props.color) ? parseColorToABGR(props.color) : 0;
+  return {
+    formatSlot: nodeSlot(node, 0),
+    value: value,
+    valueSlot: valueSlot,
+    colored: colorSlot >= 0 || !!(props && props.color),
+    colorSlot: colorSlot,
+    r: (color & 0xFF) * (1/255),
+    g: ((color >>> 8) & 0xFF) * (1/255),
+    b: ((color >>> 16) & 0xFF) * (1/255),
+    a: (color >>> 24) * (1/255),
+  };
+}
+
+/**
+ * Renders a <number>: its value formatted by snprintf() into ImGui, with no
+ * string made on the JS side.
+ */
+function renderNumber(node: any): void {
+  let plan = node.plan;
+  if (plan === null) {
+    plan = buildNumberPlan(node);
+    node.plan = plan;
+  }
+  const value = plan.valueSlot >= 0 ? animatedValue(+plan.valueSlot) : +plan.value;
+  if (plan.colored) {
+    if (plan.colorSlot >= 0) {
+      const color = animatedValue(+plan.colorSlot);
+      _igPushStyleColor_Vec4_flat(_ImGuiCol_Text, (color & 0xFF) * (1/255), ((color >>> 8) & 0xFF) * (1/255),
+        ((color >>> 16) & 0xFF) * (1/255), (color >>> 24) * (1/255));
+    } else {
+      _igPushStyleColor_Vec4_flat(_ImGuiCol_Text, +plan.r, +plan.g, +plan.b, +plan.a);
+    }
+    _number_text(utf8SlotPtr(plan.formatSlot), value);
+    _igPopStyleColor(1);
+  } else {
+    _number_text(utf8SlotPtr(plan.formatSlot), value);
+  }
+}
+
+// Packed draw commands for <canvas>. The record layout must match DrawCommand
+// in draw_commands.c and DrawCommands in react-imgui-reconciler/draw-commands.js.
+const DRAW_RECORD_FIELDS = 8;  // numbers per record in the `commands` array
+const DRAW_RECORD_BYTES = 32;  // sizeof(DrawCommand)
+
+const _draw_commands_replay = $SHBuiltin.extern_c({}, function draw_commands_replay(dl: c_ptr, cmds: c_ptr, count: c_int, ox: c_float, oy: c_float): void { throw 0; });
+const _draw_commands_replay_cached = $SHBuiltin.extern_c({}, function draw_commands_replay_cached(dl: c_ptr, cmds: c_ptr, count: c_int, ox: c_float, oy: c_float, cache: c_ptr, cap: c_int): void { throw 0; });
+const _draw_cache_buffer = $SHBuiltin.extern_c({}, function draw_cache_buffer(): c_ptr { throw 0; });
+const _draw_cache_capacity = $SHBuiltin.extern_c({}, function draw_cache_capacity(): c_int { throw 0; });
+
+// Node slot holding the captured geometry of a <canvas cache>
+const CANVAS_CACHE_SLOT = 1;
+const DRAW_CACHE_HEADER_BYTES = 40;  // sizeof(DrawCache)
+
+/**
+ * Builds the render plan for a canvas: encodes the `commands` array into the
+ * node's native buffer, so per-frame rendering is a single replay call.
+ */
+function buildCanvasPlan(node: any): any {
+  "use unsafe";
+
+  const props = node.props;
+  const width = validateNumber((props && props.width !== undefined) ? props.width : 0, 0, "canvas width");
+  const height = validateNumber((props && props.height !== undefined) ? props.height : 0, 0, "canvas height");
+
+  let count = 0;
+  let slot = -1;
+  if (props && Array.isArray(props.commands)) {
+    const cmds: any = props.commands;
+    count = Math.floor(cmds.length / DRAW_RECORD_FIELDS);
+    slot = nodeBuffer(node, 0, (count > 0 ? count : 1) * DRAW_RECORD_BYTES);
+    const buf = slotPtr(slot);
+    for (let i = 0; i < count; i++) {
+      const src = i * DRAW_RECORD_FIELDS;
+      const dst = i * DRAW_RECORD_BYTES;
+      const color = cmds[src + 1];
+      _sh_ptr_write_c_uint(buf, dst, (+cmds[src]) >>> 0);
+      _sh_ptr_write_c_uint(buf, dst + 4,
+        typeof color === 'number' ? color >>> 0 : parseColorToABGR(color));
+      for (let j = 0; j < 6; j++) {
+        _sh_ptr_write_c_float(buf, dst + 8 + j * 4, +cmds[src + 2 + j]);
+      }
+    }
+  }
+
+  // The captured geometry is of the old commands; the header's first field
+  // marks it invalid
+  const cache = !!(props && props.cache) && count > 0;
+  let cacheSlot = -1;
+  if (cache) {
+    cacheSlot = nodeBuffer(node, CANVAS_CACHE_SLOT, DRAW_CACHE_HEADER_BYTES);
+    _sh_ptr_write_c_int(slotPtr(cacheSlot), 0, 0);
+  } else {
+    trimNodeSlots(node, CANVAS_CACHE_SLOT);
+  }
+
+  return { width: width, height: height, count: count, slot: slot, cache: cache, cacheSlot: cacheSlot };
+}
+
+/**
+ * Renders a canvas component: replays its packed draw commands relative to
+ * the cursor position and reserves width x height of layout space. With
+ * `cache`, the geometry of the first replay is kept and re-emitted, moved to
+ * the cursor position, until the commands change.
+ */
+function renderCanvas(node: any, vec2: c_ptr): void {
+  let plan = node.plan;
+  if (plan === null) {
+    plan = buildCanvasPlan(node);
+    node.plan = plan;
+  }
+  const width = +plan.width;
+  const height = +plan.height;
+  const hasSize = width > 0 && height > 0;
+
+  _igGetCursorScreenPos(vec2);
+  const originX = +get_ImVec2_x(vec2);
+  const originY = +get_ImVec2_y(vec2);
+
+  // Cull when a sized canvas is scrolled out of the current clip rect
+  let visible = true;
+  if (hasSize) {
+    visible = _igIsRectVisible_Vec2_flat(originX, originY, originX + width, originY + height);
+  }
+
+  if (visible && plan.cache) {
+    const cacheSlot = plan.cacheSlot;
+    _draw_commands_replay_cached(_igGetWindowDrawList(), slotPtr(plan.slot), plan.count,
+      originX, originY, slotPtr(cacheSlot), slotCapacity(cacheSlot));
+    // Capturing may have reallocated the cache buffer
+    adoptSlotBuffer(cacheSlot, _draw_cache_buffer(), _draw_cache_capacity());
+  } else if (visible && plan.count > 0) {
+    _draw_commands_replay(_igGetWindowDrawList(), slotPtr(plan.slot), plan.count, originX, originY);
+  }
+
+  if (hasSize) {
+    _igDummy_flat(width, height);
+  }
+}
+
+// ImGui's "auto" scale for plots
+const PLOT_SCALE_AUTO = +_igGET_FLT_MAX();
+
+// Downsampling of long series to the plot's width (plot_reduce.c)
+const _plot_buckets = $SHBuiltin.extern_c({}, function plot_buckets(width: c_float, histogram: c_bool): c_int { throw 0; });
+const _plot_reduce = $SHBuiltin.extern_c({}, function plot_reduce(values: c_ptr, count: c_int, offset: c_int, start: c_int, n: c_int, buckets: c_int, histogram: c_bool, out: c_ptr): c_int { throw 0; });
+
+// Time series of jslib's createTimeSeries() (TimeSeries.cpp)
+const _time_series_plot = $SHBuiltin.extern_c({}, function time_series_plot(series: c_uint, from: c_double, to: c_double, buckets: c_int, out: c_ptr): c_int { throw 0; });
+const _time_series_newest = $SHBuiltin.extern_c({}, function time_series_newest(series: c_uint): c_double { throw 0; });
+
+// Node slot holding the reduced series of a plot
+const PLOT_REDUCED_SLOT = 3;
+
+/**
+ * Builds the render plan for <plotlines>/<plothistogram>. Slot 0 of the node
+ * holds the label, slot 1 the overlay text. A `values` array backed by
+ * shared native memory (createSharedArray()) is read in place every frame;
+ * any other array is converted to floats once, into slot 2. `viewStart` and
+ * `viewCount` select the part of the series shown. A `series` (a
+ * createTimeSeries()) of <plotlines> replaces `values`: the `timeSpan`
+ * milliseconds up to `timeEnd` (default: the newest sample) are queried
+ * on every frame.
+ */
+function buildPlotPlan(node: any, kind: string): any {
+  "use unsafe";
+
+  const props = node.props;
+  const label = (props && props.label !== undefined) ? String(props.label) : "";
+  const overlay = (props && props.overlay !== undefined) ? String(props.overlay) : "";
+  const values: any = props ? props.values : undefined;
+  const series: any = (props && kind === "plotlines") ? props.series : undefined;
+
+  let count = 0;
+  let shared = false;
+  let dataSlot = -1;
+  if (series && typeof series.id === 'number') {
+    // Queried on every frame, see renderPlot()
+  } else if (values && typeof values.length === 'number') {
+    count = +values.length;
+    shared = isSharedArray(values) && values instanceof Float32Array;
+    if (!shared && count > 0) {
+      dataSlot = nodeBuffer(node, 2, count * 4);
+      const buf = slotPtr(dataSlot);
+      for (let i = 0; i < count; i++) {
+        _sh_ptr_write_c_float(buf, i * 4, +values[i]);
+      }
     }
   }
-  _igUnindent(0.0);
+  if (dataSlot < 0) trimNodeSlots(node, 2);
+
+  const viewStart = (props && props.viewStart !== undefined)
+    ? Math.floor(validateNumber(props.viewStart, 0, kind + " viewStart")) : 0;
+  const start = viewStart > 0 ? (viewStart < count ? viewStart : count) : 0;
+  const viewCount = (props && props.viewCount !== undefined)
+    ? Math.floor(validateNumber(props.viewCount, count, kind + " viewCount")) : count;
+
+  return {
+    labelSlot: nodeUtf8(node, 0, label !== "" ? label : "##" + kind),
+    overlaySlot: nodeUtf8(node, 1, overlay),
+    hasOverlay: overlay !== "",
+    series: (series && typeof series.id === 'number') ? +series.id : 0,
+    timeSpan: (props && props.timeSpan !== undefined)
+      ? validateNumber(props.timeSpan, 60000, kind + " timeSpan") : 60000,
+    timeEnd: (props && props.timeEnd !== undefined)
+      ? validateNumber(props.timeEnd, NaN, kind + " timeEnd") : NaN,
+    count: count,
+    shared: shared,
+    dataSlot: dataSlot,
+    viewStart: start,
+    viewCount: viewCount > 0 ? (viewCount < count - start ? viewCount : count - start) : 0,
+    downsample: !(props && props.downsample === false),
+    // Without a version, a shared series may change on any frame
+    cacheReduced: !shared || (props && props.version !== undefined),
+    offset: validateNumber((props && props.offset !== undefined) ? props.offset : 0, 0, kind + " offset"),
+    scaleMin: (props && props.scaleMin !== undefined)
+      ? validateNumber(props.scaleMin, 0, kind + " scaleMin") : PLOT_SCALE_AUTO,
+    scaleMax: (props && props.scaleMax !== undefined)
+      ? validateNumber(props.scaleMax, 0, kind + " scaleMax") : PLOT_SCALE_AUTO,
+    width: validateNumber((props && props.width !== undefined) ? props.width : 0, 0, kind + " width"),
+    height: validateNumber((props && props.height !== undefined) ? props.height : 0, 0, kind + " height"),
+  };
 }
 
 /**
- * Renders a table component.
+ * Renders a <plotlines> or <plothistogram> component. A view of the series
+ * that has more values than the plot has pixels is first reduced to its
+ * width by plot_reduce(), into slot 3. The result is kept in node.state
+ * until the plan (the data, its version or the view) or the width changes.
  */
-function renderTable(node: any, vec2: c_ptr): void {
-  const props = node.props;
-  const tableId = (props && props.id) ? props.id : "table";
-  const columnCount = (props && props.columns !== undefined) ? +props.columns : 1;
-
-  if (+columnCount <= 0) {
-    console.error(
-      `<table> requires a positive 'columns' prop. Got: columns=${columnCount}. Skipping table.`
-    );
+function renderPlot(node: any, histogram: boolean): void {
+  let plan = node.plan;
+  if (plan === null) {
+    plan = buildPlotPlan(node, histogram ? "plothistogram" : "plotlines");
+    node.plan = plan;
+  }
+  if (plan.series !== 0) {
+    renderSeriesPlot(node, plan);
     return;
   }
+  const count = +plan.count;
+  const n = +plan.viewCount;
+  if (n === 0) return;
+
+  // Shared arrays may be written in place, so their memory is looked up on
+  // every frame; the lookup fails once the array is gone.
+  let data: c_ptr = c_null;
+  if (plan.shared) {
+    const values = node.props.values;
+    if (!isSharedArray(values)) return;
+    data = sharedArrayPtr(values);
+  } else {
+    data = slotPtr(plan.dataSlot);
+  }
 
-  const tableFlags = (props && props.flags !== undefined) ? props.flags : _ImGuiTableFlags_Resizable;
-  set_ImVec2_x(vec2, 0);
-  set_ImVec2_y(vec2, 0);
-
-  if (_igBeginTable(tmpUtf8(tableId), columnCount, tableFlags, vec2, 0)) {
-    if (node.children) {
-      for (let i = 0; i < node.children.length; i++) {
-        renderNode(node.children[i]);
-      }
+  let offset = +plan.offset;
+  let points = n;
+  const buckets = plan.downsample ? _plot_buckets(+plan.width, histogram) : 0;
+  if ((buckets > 0 && n > (histogram ? buckets : 2 * buckets)) || (n !== count && offset !== 0)) {
+    let state = node.state;
+    if (state === null) {
+      state = { plan: null, buckets: 0, points: 0 };
+      node.state = state;
     }
-    _igEndTable();
+    if (state.plan !== plan || state.buckets !== buckets || !plan.cacheReduced) {
+      const capacity = buckets > 0 && n > 2 * buckets ? 2 * buckets : n;
+      const out = slotPtr(nodeBuffer(node, PLOT_REDUCED_SLOT, capacity * 4));
+      state.points = _plot_reduce(data, count, offset, +plan.viewStart, n,
+        buckets > 0 ? buckets : n, histogram, out);
+      state.plan = plan;
+      state.buckets = buckets;
+    }
+    data = slotPtr(nodeSlot(node, PLOT_REDUCED_SLOT));
+    points = +state.points;
+    offset = 0;
+  } else if (n !== count) {
+    // A view of an unrotated series is drawn in place
+    data = _sh_ptr_add(data, plan.viewStart * 4);
+  }
+
+  const overlay = plan.hasOverlay ? utf8SlotPtr(plan.overlaySlot) : c_null;
+  if (histogram) {
+    _igPlotHistogram_FloatPtr_flat(utf8SlotPtr(plan.labelSlot), data, points, offset,
+      overlay, +plan.scaleMin, +plan.scaleMax, +plan.width, +plan.height, 4);
+  } else {
+    _igPlotLines_FloatPtr_flat(utf8SlotPtr(plan.labelSlot), data, points, offset,
+      overlay, +plan.scaleMin, +plan.scaleMax, +plan.width, +plan.height, 4);
   }
 }
 
 /**
- * Renders a table row component.
+ * Renders a <plotlines series>: the plot's buckets of the time range,
+ * queried natively from the series' finest level that covers it into
+ * slot 3, in O(width) whatever the range.
  */
-function renderTableRow(node: any): void {
-  const props = node.props;
-  const rowFlags = (props && props.flags !== undefined) ? props.flags : 0;
-  const minHeight = (props && props.minHeight !== undefined) ? props.minHeight : 0;
-  _igTableNextRow(rowFlags, minHeight);
-
-  if (node.children) {
-    for (let i = 0; i < node.children.length; i++) {
-      renderNode(node.children[i]);
-    }
-  }
+function renderSeriesPlot(node: any, plan: any): void {
+  const buckets = _plot_buckets(+plan.width, false);
+  let end = +plan.timeEnd;
+  if (end !== end) end = _time_series_newest(plan.series);
+  const span = +plan.timeSpan;
+  const out = slotPtr(nodeBuffer(node, PLOT_REDUCED_SLOT, 2 * buckets * 4));
+  const points = end === end && span > 0
+    ? _time_series_plot(plan.series, end - span, end, buckets, out) : 0;
+  if (points === 0) return;
+  _igPlotLines_FloatPtr_flat(utf8SlotPtr(plan.labelSlot), out, points, 0,
+    plan.hasOverlay ? utf8SlotPtr(plan.overlaySlot) : c_null,
+    +plan.scaleMin, +plan.scaleMax, +plan.width, +plan.height, 4);
 }
 
+// Native cells for <datagrid>. The record layout must match DataGridColumn
+// in data_grid.c.
+const DATA_GRID_F64 = 0;
+const DATA_GRID_F32 = 1;
+const DATA_GRID_I32 = 2;
+const DATA_GRID_STRING = 3;
+const DATA_GRID_ALIGN_RIGHT = 1;
+const DATA_GRID_COLUMN_BYTES = 56;  // sizeof(DataGridColumn)
+const DATA_GRID_FLASH_HEADER_BYTES = 8;  // sizeof(DataGridFlash)
+const DATA_GRID_FLASH_CELL_BYTES = 24;   // sizeof(DataGridFlashCell)
+// Defaults of a column's `flash`
+const DATA_GRID_FLASH_UP = "#00FF0060";
+const DATA_GRID_FLASH_DOWN = "#FF000060";
+const DATA_GRID_FLASH_MS = 800;
+
+// Node slots of a <datagrid>: the id, the header string table, the palette,
+// the column records, then the values, colors and flash state of each
+// column in turn
+const GRID_HEADER_SLOT = 1;
+const GRID_PALETTE_SLOT = 2;
+const GRID_COLUMN_SLOT = 3;
+const GRID_DATA_SLOT = 4;
+
+const _data_grid_render = $SHBuiltin.extern_c({}, function data_grid_render(id: c_ptr, headers: c_ptr, columns: c_ptr, column_count: c_int, rows: c_int, palette: c_ptr, palette_count: c_int, flags: c_int, width: c_float, height: c_float): c_int { throw 0; });
+
 /**
- * Renders a table cell component.
+ * Returns the DATA_GRID_* cell type of a column's `values`: the element type
+ * of a 32-bit or double typed array, strings, or doubles for anything else.
  */
-function renderTableCell(node: any): void {
-  const props = node.props;
-  const colIndex = (props && props.index !== undefined) ? props.index : 0;
-  _igTableSetColumnIndex(colIndex);
-
-  if (node.children) {
-    for (let i = 0; i < node.children.length; i++) {
-      renderNode(node.children[i]);
-    }
+function dataGridType(values: any): number {
+  if (values instanceof Float32Array) return DATA_GRID_F32;
+  if (values instanceof Int32Array) return DATA_GRID_I32;
+  if (values instanceof Float64Array) return DATA_GRID_F64;
+  if (Array.isArray(values) && values.length > 0 && typeof values[0] === 'string') {
+    return DATA_GRID_STRING;
   }
+  return DATA_GRID_F64;
 }
 
 /**
- * Renders a table column setup.
+ * Copies the values of a column that is not shared into node slot `index`,
+ * as elements of `type`. Returns the slot.
  */
-function renderTableColumn(node: any): void {
-  const props = node.props;
-  const colLabel = (props && props.label) ? props.label : "";
-  const colFlags = (props && props.flags !== undefined) ? props.flags : _ImGuiTableColumnFlags_None;
-  const colWidth = (props && props.width !== undefined) ? props.width : 0;
-  _igTableSetupColumn(tmpUtf8(colLabel), colFlags, colWidth, 0);
+function encodeDataGridValues(node: any, index: number, values: any, type: number, count: number): number {
+  "use unsafe";
+
+  if (type === DATA_GRID_STRING) return encodeStringTable(node, index, values);
+  const slot = nodeBuffer(node, index, (count > 0 ? count : 1) * (type === DATA_GRID_F64 ? 8 : 4));
+  const buf = slotPtr(slot);
+  for (let i = 0; i < count; i++) {
+    if (type === DATA_GRID_F32) {
+      _sh_ptr_write_c_float(buf, i * 4, +values[i]);
+    } else if (type === DATA_GRID_I32) {
+      _sh_ptr_write_c_int(buf, i * 4, +values[i] | 0);
+    } else {
+      _sh_ptr_write_c_double(buf, i * 8, +values[i]);
+    }
+  }
+  return slot;
 }
 
 /**
- * Renders a rectangle component.
+ * Builds the render plan for a <datagrid>. Each entry of `columns` describes
+ * one column ({label, values, colors, decimals, width, align}). Typed arrays
+ * from createSharedArray() are read in place on every frame, so only their
+ * pointers are patched into the column records then; anything else is
+ * copied into the node's slots here, once per commit. The number of rows is
+ * `rows`, clamped to the shortest numeric column.
  */
-function renderRect(node: any, vec2: c_ptr): void {
+function buildDataGridPlan(node: any): any {
+  "use unsafe";
+
   const props = node.props;
-  const drawList = _igGetWindowDrawList();
-  const rectX = validateNumber((props && props.x !== undefined) ? props.x : 0, 0, "rect x");
-  const rectY = validateNumber((props && props.y !== undefined) ? props.y : 0, 0, "rect y");
-  const rectWidth = validateNumber((props && props.width !== undefined) ? props.width : 100, 100, "rect width");
-  const rectHeight = validateNumber((props && props.height !== undefined) ? props.height : 100, 100, "rect height");
-  const rectFilled = (props && props.filled !== undefined) ? props.filled : true;
+  const specs: any = (props && Array.isArray(props.columns)) ? props.columns : [];
+  const count = specs.length;
+
+  let rows = (props && props.rows !== undefined) ? validateNumber(props.rows, 0, "datagrid rows") : Infinity;
+  const labels: any = [];
+  const columns: any = [];
+  const sharedColumns: any = [];
+  for (let c = 0; c < count; c++) {
+    const spec = specs[c];
+    const values: any = spec ? spec.values : undefined;
+    const type = values ? dataGridType(values) : DATA_GRID_F64;
+    const length = (values && typeof values.length === 'number') ? +values.length : 0;
+    if (type !== DATA_GRID_STRING && length < rows) rows = length;
+    labels.push((spec && spec.label !== undefined) ? String(spec.label) : "");
+    columns.push({
+      values: values,
+      colors: spec ? spec.colors : undefined,
+      type: type,
+      length: length,
+      sharedValues: isSharedArray(values) && (values instanceof Float64Array ||
+        values instanceof Float32Array || values instanceof Int32Array),
+      decimals: (spec && spec.decimals !== undefined)
+        ? validateNumber(spec.decimals, -1, "datagrid decimals") : -1,
+      width: (spec && spec.width !== undefined) ? validateNumber(spec.width, 0, "datagrid width") : 0,
+      flags: (spec && spec.align === "right") ? DATA_GRID_ALIGN_RIGHT : 0,
+      flash: (spec && spec.flash && type !== DATA_GRID_STRING) ? spec.flash : null,
+    });
+  }
+  if (!(rows > 0)) rows = 0;
+  rows = Math.floor(rows);
 
-  // Get window cursor position (top-left of content area)
-  _igGetCursorScreenPos(vec2);
-  const winX = +get_ImVec2_x(vec2);
-  const winY = +get_ImVec2_y(vec2);
+  const headerSlot = encodeStringTable(node, GRID_HEADER_SLOT, labels);
 
-  // Calculate absolute screen coordinates
-  set_ImVec2_x(vec2, winX + rectX);
-  set_ImVec2_y(vec2, winY + rectY);
+  // Index 0 is the default text color and is never looked up
+  const palette: any = (props && Array.isArray(props.palette)) ? props.palette : [];
+  const paletteSlot = nodeBuffer(node, GRID_PALETTE_SLOT, (palette.length > 0 ? palette.length : 1) * 4);
+  const paletteBuf = slotPtr(paletteSlot);
+  for (let i = 0; i < palette.length; i++) {
+    _sh_ptr_write_c_uint(paletteBuf, i * 4, parseColorToABGR(palette[i]));
+  }
 
-  const rectMax = allocTmp(_sizeof_ImVec2);
-  set_ImVec2_x(rectMax, winX + rectX + rectWidth);
-  set_ImVec2_y(rectMax, winY + rectY + rectHeight);
+  const columnSlot = nodeBuffer(node, GRID_COLUMN_SLOT, (count > 0 ? count : 1) * DATA_GRID_COLUMN_BYTES);
+  const columnBuf = slotPtr(columnSlot);
+  for (let c = 0; c < count; c++) {
+    const column = columns[c];
+    const dst = c * DATA_GRID_COLUMN_BYTES;
+    let valuesPtr: c_ptr = c_null;
+    if (column.values && !column.sharedValues) {
+      valuesPtr = slotPtr(encodeDataGridValues(node, GRID_DATA_SLOT + c * 3,
+        column.values, column.type, column.length));
+    }
 
-  // Parse color (default: white)
-  const rectColor = (props && props.color)
-    ? parseColorToABGR(props.color)
-    : 0xFFFFFFFF;
+    // Colors are dropped unless they cover every row
+    const colors: any = column.colors;
+    let colorsPtr: c_ptr = c_null;
+    let sharedColors = false;
+    if (colors && typeof colors.length === 'number' && +colors.length >= rows) {
+      sharedColors = isSharedArray(colors) && colors instanceof Uint8Array;
+      if (!sharedColors) {
+        const colorSlot = nodeBuffer(node, GRID_DATA_SLOT + c * 3 + 1, rows > 0 ? rows : 1);
+        colorsPtr = slotPtr(colorSlot);
+        for (let i = 0; i < rows; i++) {
+          _sh_ptr_write_c_uchar(colorsPtr, i, +colors[i] & 0xFF);
+        }
+      }
+    }
+    if (column.sharedValues || sharedColors) {
+      sharedColumns.push({ index: c, values: column.sharedValues, colors: sharedColors });
+    }
 
-  if (rectFilled) {
-    _ImDrawList_AddRectFilled(drawList, vec2, rectMax, rectColor, 0.0, 0);
-  } else {
-    _ImDrawList_AddRect(drawList, vec2, rectMax, rectColor, 0.0, 0, 1.0);
+    // The flash state survives rebuilds, so that a change arriving with a
+    // commit still flashes; a new or grown buffer starts with no rows
+    const flash: any = column.flash;
+    let flashPtr: c_ptr = c_null;
+    let flashUp = 0;
+    let flashDown = 0;
+    let flashSeconds = 0;
+    if (flash) {
+      const index = GRID_DATA_SLOT + c * 3 + 2;
+      const old = nodeSlot(node, index);
+      const had = old >= 0 ? slotCapacity(old) : 0;
+      const size = DATA_GRID_FLASH_HEADER_BYTES + (rows > 0 ? rows : 1) * DATA_GRID_FLASH_CELL_BYTES;
+      flashPtr = slotPtr(nodeBuffer(node, index, size));
+      if (had < size) _sh_ptr_write_c_int(flashPtr, 0, 0);
+      flashUp = parseColorToABGR(flash.up !== undefined ? flash.up : DATA_GRID_FLASH_UP);
+      flashDown = parseColorToABGR(flash.down !== undefined ? flash.down : DATA_GRID_FLASH_DOWN);
+      flashSeconds = validateNumber(flash.duration !== undefined ? flash.duration : DATA_GRID_FLASH_MS,
+        DATA_GRID_FLASH_MS, "datagrid flash duration") / 1000;
+    }
+
+    _sh_ptr_write_c_ptr(columnBuf, dst, valuesPtr);
+    _sh_ptr_write_c_ptr(columnBuf, dst + 8, colorsPtr);
+    _sh_ptr_write_c_int(columnBuf, dst + 16, column.type);
+    _sh_ptr_write_c_int(columnBuf, dst + 20, column.decimals);
+    _sh_ptr_write_c_float(columnBuf, dst + 24, column.width);
+    _sh_ptr_write_c_int(columnBuf, dst + 28, column.flags);
+    _sh_ptr_write_c_ptr(columnBuf, dst + 32, flashPtr);
+    _sh_ptr_write_c_uint(columnBuf, dst + 40, flashUp);
+    _sh_ptr_write_c_uint(columnBuf, dst + 44, flashDown);
+    _sh_ptr_write_c_float(columnBuf, dst + 48, flashSeconds);
+    _sh_ptr_write_c_int(columnBuf, dst + 52, 0);
   }
+  trimNodeSlots(node, GRID_DATA_SLOT + count * 3);
+
+  return {
+    idSlot: nodeUtf8(node, 0, (props && props.id !== undefined) ? String(props.id) : "datagrid"),
+    headerSlot: headerSlot,
+    paletteSlot: paletteSlot,
+    paletteCount: palette.length,
+    columnSlot: columnSlot,
+    columnCount: count,
+    sharedColumns: sharedColumns,
+    rows: rows,
+    flags: (props && props.flags !== undefined) ? +props.flags
+      : _ImGuiTableFlags_Resizable | _ImGuiTableFlags_RowBg | _ImGuiTableFlags_BordersInnerV |
+        _ImGuiTableFlags_ScrollY,
+    width: validateNumber((props && props.width !== undefined) ? props.width : 0, 0, "datagrid width"),
+    height: validateNumber((props && props.height !== undefined) ? props.height : 0, 0, "datagrid height"),
+  };
 }
 
 /**
- * Renders a circle component.
+ * Renders a <datagrid>: one native call draws the visible rows of the table
+ * from the column buffers, with no tree node per cell. Reports a click on a
+ * row through onRowClick(row).
  */
-function renderCircle(node: any, vec2: c_ptr): void {
-  const props = node.props;
-  const circleDrawList = _igGetWindowDrawList();
-  const circleX = validateNumber((props && props.x !== undefined) ? props.x : 50, 50, "circle x");
-  const circleY = validateNumber((props && props.y !== undefined) ? props.y : 50, 50, "circle y");
-  const circleRadius = validateNumber((props && props.radius !== undefined) ? props.radius : 10, 10, "circle radius");
-  const circleFilled = (props && props.filled !== undefined) ? props.filled : true;
-  const circleSegments = validateNumber((props && props.segments !== undefined) ? props.segments : 12, 12, "circle segments");
-
-  // Get window cursor position
-  _igGetCursorScreenPos(vec2);
-  const circleWinX = +get_ImVec2_x(vec2);
-  const circleWinY = +get_ImVec2_y(vec2);
+function renderDataGrid(node: any): void {
+  let plan = node.plan;
+  if (plan === null) {
+    plan = buildDataGridPlan(node);
+    node.plan = plan;
+  }
 
-  // Calculate absolute center position
-  set_ImVec2_x(vec2, circleWinX + circleX);
-  set_ImVec2_y(vec2, circleWinY + circleY);
+  // Shared arrays may be written in place, so their memory is looked up on
+  // every frame like in renderPlot()
+  const columnBuf = slotPtr(plan.columnSlot);
+  const sharedColumns: any = plan.sharedColumns;
+  for (let i = 0; i < sharedColumns.length; i++) {
+    const shared = sharedColumns[i];
+    const spec = node.props.columns[shared.index];
+    const dst = shared.index * DATA_GRID_COLUMN_BYTES;
+    if (shared.values) _sh_ptr_write_c_ptr(columnBuf, dst, sharedArrayPtr(spec.values));
+    if (shared.colors) _sh_ptr_write_c_ptr(columnBuf, dst + 8, sharedArrayPtr(spec.colors));
+  }
 
-  // Parse color (default: white)
-  const circleColor = (props && props.color)
-    ? parseColorToABGR(props.color)
-    : 0xFFFFFFFF;
+  const clicked = _data_grid_render(utf8SlotPtr(plan.idSlot), slotPtr(plan.headerSlot),
+    columnBuf, plan.columnCount, plan.rows, slotPtr(plan.paletteSlot), plan.paletteCount,
+    plan.flags, +plan.width, +plan.height);
+  if (clicked >= 0) {
+    safeInvokeEvent(EVENT_DISCRETE, node.props ? node.props.onRowClick : null, clicked);
+  }
+}
 
-  if (circleFilled) {
-    _ImDrawList_AddCircleFilled(circleDrawList, vec2, circleRadius, circleColor, circleSegments);
-  } else {
-    _ImDrawList_AddCircle(circleDrawList, vec2, circleRadius, circleColor, circleSegments, 1.0);
+/**
+ * Builds the render plan for a radial menu. Item labels are stringified and
+ * encoded once here instead of on every frame. Slot 0 of the node holds the
+ * center text, slots 1..n the item labels.
+ */
+function buildRadialMenuPlan(node: any): any {
+  const props = node.props;
+  const menuRadius = validateNumber((props && props.radius !== undefined) ? props.radius : 80, 80, "radialmenu radius");
+  const centerText = (props && props.centerText) ? String(props.centerText) : "";
+  const centerTextSlot = nodeUtf8(node, 0, centerText);
+  const labelSlots: any = [];
+  if (props && props.items && Array.isArray(props.items)) {
+    const items: any = props.items;
+    for (let i = 0; i < items.length; i++) {
+      labelSlots.push(nodeUtf8(node, i + 1, String(items[i])));
+    }
   }
+  trimNodeSlots(node, labelSlots.length + 1);
+  return {
+    radius: menuRadius,
+    labelSlots: labelSlots,
+    hasCenterText: centerText !== "",
+    centerTextSlot: centerTextSlot,
+  };
 }
 
 /**
@@ -605,26 +3021,36 @@ function renderCircle(node: any, vec2: c_ptr): void {
  * This demonstrates creating custom interactive widgets using ImGui's draw list API.
  */
 function renderRadialMenu(node: any, vec2: c_ptr): void {
-  const props = node.props;
-  const drawList = _igGetWindowDrawList();
+  let plan = node.plan;
+  if (plan === null) {
+    plan = buildRadialMenuPlan(node);
+    node.plan = plan;
+  }
 
   // Get menu properties
-  const menuRadius = validateNumber((props && props.radius !== undefined) ? props.radius : 80, 80, "radialmenu radius");
+  const menuRadius = +plan.radius;
   const innerRadius = menuRadius * 0.3; // Inner circle is 30% of outer radius
 
-  // Get items array - return early if not provided
-  if (!props || !props.items || !Array.isArray(props.items)) {
-    return;
-  }
-  const items: any = props.items;
+  // Get items - return early if not provided
+  const items: any = plan.labelSlots;
   const itemCount = items.length;
   if (itemCount === 0) return;
 
+  const menuDiameter = menuRadius * 2;
+
   // Get window cursor position - this is where we'll draw
   _igGetCursorScreenPos(vec2);
   const winX = +get_ImVec2_x(vec2);
   const winY = +get_ImVec2_y(vec2);
 
+  // Cull when scrolled out of view: only reserve the layout space
+  if (!_igIsRectVisible_Vec2_flat(winX, winY, winX + menuDiameter, winY + menuDiameter)) {
+    _igDummy_flat(menuDiameter, menuDiameter);
+    return;
+  }
+
+  const drawList = _igGetWindowDrawList();
+
   // Menu center is offset from top-left by radius (so full circle is visible)
   const centerX = winX + menuRadius;
   const centerY = winY + menuRadius;
@@ -664,11 +3090,6 @@ function renderRadialMenu(node: any, vec2: c_ptr): void {
   const borderColor = 0xFF888888;    // Light gray border
   const textColor = 0xFFFFFFFF;      // White text
 
-  // Allocate center point buffer
-  const centerPtr = allocTmp(_sizeof_ImVec2);
-  set_ImVec2_x(centerPtr, centerX);
-  set_ImVec2_y(centerPtr, centerY);
-
   const anglePerSector = 6.28318530718 / itemCount; // 2*PI / itemCount
 
   // First pass: Draw all filled sectors and outlines
@@ -681,14 +3102,14 @@ function renderRadialMenu(node: any, vec2: c_ptr): void {
 
     // Draw filled sector using path API
     _ImDrawList_PathClear(drawList);
-    _ImDrawList_PathLineTo(drawList, centerPtr); // Start at center
-    _ImDrawList_PathArcTo(drawList, centerPtr, menuRadius, angleStart, angleEnd, 32);
-    _ImDrawList_PathLineTo(drawList, centerPtr); // Back to center
+    _ImDrawList_PathLineTo_flat(drawList, centerX, centerY); // Start at center
+    _ImDrawList_PathArcTo_flat(drawList, centerX, centerY, menuRadius, angleStart, angleEnd, 32);
+    _ImDrawList_PathLineTo_flat(drawList, centerX, centerY); // Back to center
     _ImDrawList_PathFillConvex(drawList, sectorColor);
 
     // Draw sector outline
     _ImDrawList_PathClear(drawList);
-    _ImDrawList_PathArcTo(drawList, centerPtr, menuRadius, angleStart, angleEnd, 32);
+    _ImDrawList_PathArcTo_flat(drawList, centerX, centerY, menuRadius, angleStart, angleEnd, 32);
     _ImDrawList_PathStroke(drawList, borderColor, 0, 1.0);
   }
 
@@ -701,12 +3122,7 @@ function renderRadialMenu(node: any, vec2: c_ptr): void {
     const lineEndX = centerX + Math.cos(lineAngle) * menuRadius;
     const lineEndY = centerY + Math.sin(lineAngle) * menuRadius;
 
-    set_ImVec2_x(vec2, lineStartX);
-    set_ImVec2_y(vec2, lineStartY);
-    const lineEnd = allocTmp(_sizeof_ImVec2);
-    set_ImVec2_x(lineEnd, lineEndX);
-    set_ImVec2_y(lineEnd, lineEndY);
-    _ImDrawList_AddLine(drawList, vec2, lineEnd, borderColor, 1.0);
+    _ImDrawList_AddLine_flat(drawList, lineStartX, lineStartY, lineEndX, lineEndY, borderColor, 1.0);
   }
 
   // Third pass: Draw text labels and handle clicks
@@ -718,190 +3134,792 @@ function renderRadialMenu(node: any, vec2: c_ptr): void {
     const labelY = centerY + Math.sin(labelAngle) * labelRadius;
 
     // Calculate text size for centering
-    const labelText = String(items[i]);
-    const textSizePtr = allocTmp(_sizeof_ImVec2);
-    _igCalcTextSize(textSizePtr, tmpUtf8(labelText), c_null, 0, -1.0);
+    const labelText = utf8SlotPtr(+items[i]);
+    const labelEnd = utf8SlotEnd(+items[i]);
+    const textSizePtr = scratchVec2C;
+    _imgui_text_size(textSizePtr, labelText, labelEnd, false, -1.0);
     const textWidth = +get_ImVec2_x(textSizePtr);
     const textHeight = +get_ImVec2_y(textSizePtr);
 
     // Draw centered text
-    set_ImVec2_x(vec2, labelX - textWidth / 2.0);
-    set_ImVec2_y(vec2, labelY - textHeight / 2.0);
-    _ImDrawList_AddText_Vec2(drawList, vec2, textColor, tmpUtf8(labelText), c_null);
+    _ImDrawList_AddText_Vec2_flat(drawList, labelX - textWidth / 2.0, labelY - textHeight / 2.0, textColor, labelText, labelEnd);
 
     // Handle click on this sector
     if (wasClicked && i === hoveredSector) {
-      safeInvokeCallback(node.props.onItemClick, i);
+      safeInvokeEvent(EVENT_DISCRETE, node.props.onItemClick, i);
     }
   }
 
   // Draw inner circle (center)
   const centerCircleColor = 0xFF333333;
-  _ImDrawList_AddCircleFilled(drawList, centerPtr, innerRadius, centerCircleColor, 32);
-  _ImDrawList_AddCircle(drawList, centerPtr, innerRadius, borderColor, 32, 1.0);
+  _ImDrawList_AddCircleFilled_flat(drawList, centerX, centerY, innerRadius, centerCircleColor, 32);
+  _ImDrawList_AddCircle_flat(drawList, centerX, centerY, innerRadius, borderColor, 32, 1.0);
 
   // Draw center text if provided
-  const centerText = (props && props.centerText) ? String(props.centerText) : "";
-  if (centerText !== "") {
-    const centerTextSizePtr = allocTmp(_sizeof_ImVec2);
-    _igCalcTextSize(centerTextSizePtr, tmpUtf8(centerText), c_null, 0, -1.0);
+  if (plan.hasCenterText) {
+    const centerText = utf8SlotPtr(plan.centerTextSlot);
+    const centerTextEnd = utf8SlotEnd(plan.centerTextSlot);
+    const centerTextSizePtr = scratchVec2C;
+    _imgui_text_size(centerTextSizePtr, centerText, centerTextEnd, false, -1.0);
     const centerTextWidth = +get_ImVec2_x(centerTextSizePtr);
     const centerTextHeight = +get_ImVec2_y(centerTextSizePtr);
 
-    set_ImVec2_x(vec2, centerX - centerTextWidth / 2.0);
-    set_ImVec2_y(vec2, centerY - centerTextHeight / 2.0);
-    _ImDrawList_AddText_Vec2(drawList, vec2, textColor, tmpUtf8(centerText), c_null);
+    _ImDrawList_AddText_Vec2_flat(drawList, centerX - centerTextWidth / 2.0, centerY - centerTextHeight / 2.0, textColor, centerText, centerTextEnd);
   }
 
   // Advance cursor to reserve space
-  const menuDiameter = menuRadius * 2;
-  set_ImVec2_x(vec2, menuDiameter);
-  set_ImVec2_y(vec2, menuDiameter);
-  _igDummy(vec2);
+  _igDummy_flat(menuDiameter, menuDiameter);
+}
+
+// Render profiler, off unless sappConfig.render_profiler is set or
+// imguiUnit.setProfiling(true) is called. While it is on, renderNode()
+// times every node and adds its inclusive time, exclusive time (without
+// its children) and a call to the totals of its node type. Windows (by
+// title) and nodes with a `debugName` prop (naming the component that
+// rendered them) are subtree roots, which also get totals; their exclusive
+// time leaves out nested subtree roots. Every PROFILE_WINDOW_FRAMES frames
+// the totals become the per-frame averages shown in the "Render Profiler"
+// window, most expensive first. While the tree inspector is open, each
+// node's inclusive time is kept as well, for its "ms" column.
+const _imgui_now_ms = $SHBuiltin.extern_c({}, function imgui_now_ms(): c_double { throw 0; });
+
+const PROFILE_WINDOW_FRAMES = 60;
+const PROFILE_TOP_N = 10;
+
+let profiling: boolean = false;
+// Set by renderNodeProfiled() for the renderNode() call it times.
+let profileBypass: boolean = false;
+// Time spent in the children of the node being timed.
+let profileChildMs: number = 0;
+// Time spent in subtree roots nested in the innermost subtree root.
+let profileNestedMs: number = 0;
+let profileFrames: number = 0;
+let profileRenderMs: number = 0;
+let profileTypes: any = null;
+let profileSubtrees: any = null;
+// Inclusive time by node ID, kept while inspecting.
+let profileNodes: any = null;
+// Report of the last complete window, or null before the first one.
+let profileReport: any = null;
+const profileOpen = calloc(_sizeof_c_bool);
+
+/// Totals keyed by name: `index` maps names to entries, `entries` keeps
+/// them in an array for sorting.
+function newProfileTable(): any {
+  return { index: Object.create(null), entries: [] };
+}
+
+function profileEntry(table: any, name: any): any {
+  let entry = table.index[name];
+  if (entry === undefined) {
+    entry = { name: name, calls: 0, inclusiveMs: 0, exclusiveMs: 0 };
+    table.index[name] = entry;
+    table.entries.push(entry);
+  }
+  return entry;
+}
+
+function resetProfile(): void {
+  profileFrames = 0;
+  profileRenderMs = 0;
+  profileTypes = newProfileTable();
+  profileSubtrees = newProfileTable();
+  profileNodes = Object.create(null);
+}
+
+function setProfiling(on: boolean): void {
+  if (on && !profiling) {
+    resetProfile();
+    profileReport = null;
+  }
+  profiling = on;
+}
+
+/// Name of the subtree rooted at `node`, or null if it isn't a subtree root.
+function profileSubtreeName(node: any): any {
+  const props = node.props;
+  if (props && props.debugName) return String(props.debugName);
+  if (+node.tag === TAG_WINDOW) {
+    return `Window "${(props && props.title) ? props.title : "Window"}"`;
+  }
+  return null;
+}
+
+function renderNodeProfiled(node: any): void {
+  const outerChildMs = profileChildMs;
+  profileChildMs = 0;
+  const subtreeName = profileSubtreeName(node);
+  const outerNestedMs = profileNestedMs;
+  if (subtreeName !== null) profileNestedMs = 0;
+
+  const start = +_imgui_now_ms();
+  profileBypass = true;
+  try {
+    renderNode(node);
+  } finally {
+    const ms = +_imgui_now_ms() - start;
+    const type = profileEntry(profileTypes, +node.tag === TAG_TEXT_NODE ? "#text" : node.type);
+    type.calls++;
+    type.inclusiveMs += ms;
+    type.exclusiveMs += ms - profileChildMs;
+    if (subtreeName !== null) {
+      const subtree = profileEntry(profileSubtrees, subtreeName);
+      subtree.calls++;
+      subtree.inclusiveMs += ms;
+      subtree.exclusiveMs += ms - profileNestedMs;
+      profileNestedMs = outerNestedMs + ms;
+    }
+    if (inspecting) {
+      const total = profileNodes[node.id];
+      profileNodes[node.id] = total === undefined ? ms : total + ms;
+    }
+    profileChildMs = outerChildMs + ms;
+  }
+}
+
+/// The PROFILE_TOP_N entries of `table` with the highest inclusive time,
+/// as per-frame averages.
+function profileTop(table: any, frames: number): any {
+  const entries = table.entries.slice();
+  entries.sort((a: any, b: any) => b.inclusiveMs - a.inclusiveMs);
+  const top: any = [];
+  for (let i = 0; i < entries.length && i < PROFILE_TOP_N; i++) {
+    const e = entries[i];
+    top.push({
+      name: e.name,
+      calls: e.calls / frames,
+      inclusiveMs: e.inclusiveMs / frames,
+      exclusiveMs: e.exclusiveMs / frames,
+    });
+  }
+  return top;
+}
+
+/// Count a profiled frame whose renderTree() took `ms`, and turn the totals
+/// into the report once the window is complete.
+function endProfileFrame(ms: number): void {
+  profileChildMs = 0;
+  profileNestedMs = 0;
+  profileRenderMs += ms;
+  if (++profileFrames < PROFILE_WINDOW_FRAMES) return;
+  profileReport = {
+    frames: profileFrames,
+    renderMs: profileRenderMs / profileFrames,
+    subtrees: profileTop(profileSubtrees, profileFrames),
+    types: profileTop(profileTypes, profileFrames),
+    nodes: profileNodes,
+  };
+  resetProfile();
+}
+
+function renderProfileTable(id: string, firstColumn: string, rows: any): void {
+  const flags = _ImGuiTableFlags_RowBg | _ImGuiTableFlags_Borders;
+  if (!_igBeginTable_flat(tmpUtf8(id), 4, flags, 0, 0, 0)) return;
+  _igTableSetupColumn(tmpUtf8(firstColumn), _ImGuiTableColumnFlags_WidthStretch, 0, 0);
+  _igTableSetupColumn(tmpUtf8("Incl ms"), _ImGuiTableColumnFlags_WidthFixed, 0, 0);
+  _igTableSetupColumn(tmpUtf8("Excl ms"), _ImGuiTableColumnFlags_WidthFixed, 0, 0);
+  _igTableSetupColumn(tmpUtf8("Calls"), _ImGuiTableColumnFlags_WidthFixed, 0, 0);
+  _igTableHeadersRow();
+  for (let i = 0; i < rows.length; i++) {
+    const row = rows[i];
+    _igTableNextRow(0, 0);
+    _igTableSetColumnIndex(0);
+    _igTextUnformatted(tmpUtf8(row.name), c_null);
+    _igTableSetColumnIndex(1);
+    _igTextUnformatted(tmpUtf8(row.inclusiveMs.toFixed(3)), c_null);
+    _igTableSetColumnIndex(2);
+    _igTextUnformatted(tmpUtf8(row.exclusiveMs.toFixed(3)), c_null);
+    _igTableSetColumnIndex(3);
+    _igTextUnformatted(tmpUtf8(row.calls.toFixed(1)), c_null);
+  }
+  _igEndTable();
+}
+
+/// The "Render Profiler" window. Closing it turns profiling off.
+function renderProfilerWindow(): void {
+  _igSetNextWindowSize_flat(480, 420, _ImGuiCond_FirstUseEver);
+  _sh_ptr_write_c_bool(profileOpen, 0, 1);
+  if (_igBegin(tmpUtf8("Render Profiler"), profileOpen, 0)) {
+    const report = profileReport;
+    if (report === null) {
+      _igTextUnformatted(tmpUtf8("Collecting..."), c_null);
+    } else {
+      _igTextUnformatted(tmpUtf8(
+        `renderTree ${report.renderMs.toFixed(3)}ms per frame, ` +
+        `averaged over ${report.frames} frames`), c_null);
+      renderProfileTable("##subtrees", "Subtree", report.subtrees);
+      renderProfileTable("##types", "Node type", report.types);
+    }
+  }
+  _igEnd();
+  if (!_sh_ptr_read_c_bool(profileOpen, 0)) setProfiling(false);
+}
+
+/// Start profiling right away if sappConfig.render_profiler is set.
+function initRenderProfiler(): void {
+  const config = (globalThis as any).sappConfig;
+  if (config && config.render_profiler) setProfiling(true);
+}
+
+initRenderProfiler();
+
+// Tree inspector, off unless sappConfig.tree_inspector is set or
+// imguiUnit.setInspector(true) is called. The "Tree Inspector" window lists
+// the host tree of every root with each node's type, props, ID, node count,
+// the tree version of the last change in its subtree and, while the render
+// profiler runs, its inclusive render time per frame. Hovering a row
+// outlines what the node drew: the next renderNode() of that node runs
+// between inspector_rect_begin() and inspector_rect_end()
+// (inspector_rect.c), and the inspector draws the outline after the tree,
+// one frame late.
+const _inspector_rect_begin = $SHBuiltin.extern_c({}, function inspector_rect_begin(): void { throw 0; });
+const _inspector_rect_end = $SHBuiltin.extern_c({}, function inspector_rect_end(windowName: c_ptr): void { throw 0; });
+const _inspector_draw_highlight = $SHBuiltin.extern_c({}, function inspector_draw_highlight(): void { throw 0; });
+
+// Rows listed under one node; the other children are summed up in a row.
+const INSPECTOR_MAX_CHILDREN = 500;
+// Longest props summary and text node excerpt, in characters.
+const INSPECTOR_SUMMARY_CHARS = 80;
+// Subtree counts cached before the cache is dropped, so that the entries of
+// deleted nodes don't pile up.
+const INSPECTOR_COUNT_CACHE_LIMIT = 65536;
+
+let inspecting: boolean = false;
+// Node hovered in the inspector in the last frame, whose drawing
+// renderNode() measures; 0 for none (node IDs start at 1).
+let inspectHighlightId: number = 0;
+// Set by renderNodeHighlighted() for the renderNode() call it measures.
+let inspectBypass: boolean = false;
+// Node hovered in the inspector in this frame.
+let inspectHoverId: number = 0;
+// Subtree node counts by node ID as {version, count}, valid while the node
+// keeps that version: any change below a node stamps it with a new one.
+let inspectCounts: any = null;
+let inspectCountEntries: number = 0;
+const inspectorOpen = calloc(_sizeof_c_bool);
+const inspectorProfile = calloc(_sizeof_c_bool);
+
+function setInspector(on: boolean): void {
+  if (on && !inspecting) {
+    inspectCounts = Object.create(null);
+    inspectCountEntries = 0;
+  } else if (!on) {
+    inspectCounts = null;
+    inspectHighlightId = 0;
+  }
+  inspecting = on;
+}
+
+function renderNodeHighlighted(node: any): void {
+  inspectBypass = true;
+  profileBypass = profiling;
+  _inspector_rect_begin();
+  let windowName = c_null;
+  try {
+    renderNode(node);
+  } finally {
+    const tag = +node.tag;
+    if (tag === TAG_ROOT) {
+      windowName = utf8SlotPtr(ROOT_WINDOW_LABEL);
+    } else if (tag === TAG_WINDOW && node.plan !== null) {
+      windowName = utf8SlotPtr(node.plan.titleSlot);
+    }
+    _inspector_rect_end(windowName);
+  }
+}
+
+/// Number of nodes in the subtree of `node`, itself included.
+function inspectorCount(node: any): number {
+  if (+node.tag === TAG_TEXT_NODE) return 1;
+  const cached = inspectCounts[node.id];
+  if (cached !== undefined && cached.version === node.version) {
+    return cached.count;
+  }
+  let count = 1;
+  for (let c = node.firstChild; c; c = c.nextSibling) {
+    count += inspectorCount(c);
+  }
+  if (cached !== undefined) {
+    cached.version = node.version;
+    cached.count = count;
+  } else {
+    if (inspectCountEntries >= INSPECTOR_COUNT_CACHE_LIMIT) {
+      inspectCounts = Object.create(null);
+      inspectCountEntries = 0;
+    }
+    inspectCounts[node.id] = { version: node.version, count: count };
+    inspectCountEntries++;
+  }
+  return count;
+}
+
+function inspectorClip(text: any): any {
+  return text.length > INSPECTOR_SUMMARY_CHARS
+    ? text.slice(0, INSPECTOR_SUMMARY_CHARS) + "..."
+    : text;
+}
+
+/// One line of `props`: functions as "fn", objects by their shape.
+function inspectorProps(props: any): any {
+  if (!props) return "";
+  const keys = Object.keys(props);
+  let text = "";
+  for (let i = 0; i < keys.length && text.length <= INSPECTOR_SUMMARY_CHARS; i++) {
+    const key = keys[i];
+    if (key === "children") continue;
+    const value = props[key];
+    let shown: any;
+    if (typeof value === "function") {
+      shown = "fn";
+    } else if (typeof value === "string") {
+      shown = `"${value}"`;
+    } else if (Array.isArray(value)) {
+      shown = `[${value.length}]`;
+    } else if (value !== null && typeof value === "object") {
+      shown = "{...}";
+    } else {
+      shown = String(value);
+    }
+    text += (text.length > 0 ? " " : "") + key + "=" + shown;
+  }
+  return inspectorClip(text);
+}
+
+function inspectorCell(column: number, text: any): void {
+  _igTableSetColumnIndex(column);
+  _igTextUnformatted(tmpUtf8(text), c_null);
+}
+
+/// The row of `node` and, while it is open, those of its children.
+function inspectorRow(node: any, report: any): void {
+  const isText = +node.tag === TAG_TEXT_NODE;
+  const hasChildren = !isText && node.firstChild !== null;
+  let flags = _ImGuiTreeNodeFlags_SpanFullWidth | _ImGuiTreeNodeFlags_OpenOnArrow;
+  if (!hasChildren) {
+    flags |= _ImGuiTreeNodeFlags_Leaf | _ImGuiTreeNodeFlags_NoTreePushOnOpen;
+  }
+  _igTableNextRow(0, 0);
+  _igTableSetColumnIndex(0);
+  const name = isText ? "#text" : `<${node.type}>`;
+  const open = _igTreeNodeEx_Str(tmpUtf8(`${name}##${node.id}`), flags);
+  if (_igIsItemHovered(0)) inspectHoverId = node.id;
+  inspectorCell(1, isText ? `"${inspectorClip(String(node.text))}"` : inspectorProps(node.props));
+  inspectorCell(2, String(node.id));
+  inspectorCell(3, String(inspectorCount(node)));
+  inspectorCell(4, String(node.version));
+  const ms = report !== null ? report.nodes[node.id] : undefined;
+  inspectorCell(5, ms !== undefined ? (ms / report.frames).toFixed(3) : "-");
+  if (!open || !hasChildren) return;
+  let shown = 0;
+  for (let c = node.firstChild; c; c = c.nextSibling) {
+    if (shown === INSPECTOR_MAX_CHILDREN) {
+      _igTableNextRow(0, 0);
+      inspectorCell(0, `... ${node.childCount - shown} more`);
+      break;
+    }
+    inspectorRow(c, report);
+    shown++;
+  }
+  _igTreePop();
+}
+
+/// The row of a root container and, while it is open, its root nodes.
+function inspectorRootRow(container: any, report: any): void {
+  const rootChildren = container.rootChildren;
+  let count = 0;
+  for (let i = 0; i < rootChildren.length; i++) {
+    count += inspectorCount(rootChildren[i]);
+  }
+  _igTableNextRow(0, 0);
+  _igTableSetColumnIndex(0);
+  const open = _igTreeNodeEx_Str(
+    tmpUtf8(`root "${container.name}"##root-${container.name}`),
+    _ImGuiTreeNodeFlags_SpanFullWidth | _ImGuiTreeNodeFlags_DefaultOpen);
+  inspectorCell(1, `${container.commitCount} commits`);
+  inspectorCell(3, String(count));
+  inspectorCell(4, String(container.treeVersion));
+  if (!open) return;
+  for (let i = 0; i < rootChildren.length; i++) {
+    inspectorRow(rootChildren[i], report);
+  }
+  _igTreePop();
+}
+
+/// The "Tree Inspector" window. Closing it turns inspecting off.
+function renderInspectorWindow(): void {
+  _inspector_draw_highlight();
+  inspectHoverId = 0;
+  _igSetNextWindowSize_flat(720, 480, _ImGuiCond_FirstUseEver);
+  _sh_ptr_write_c_bool(inspectorOpen, 0, 1);
+  if (_igBegin(tmpUtf8("Tree Inspector"), inspectorOpen, 0)) {
+    _sh_ptr_write_c_bool(inspectorProfile, 0, profiling ? 1 : 0);
+    if (_igCheckbox(tmpUtf8("Render cost (render profiler)"), inspectorProfile)) {
+      setProfiling(!!_sh_ptr_read_c_bool(inspectorProfile, 0));
+    }
+    const report = profiling ? profileReport : null;
+    const flags = _ImGuiTableFlags_RowBg | _ImGuiTableFlags_BordersInnerV |
+      _ImGuiTableFlags_Resizable | _ImGuiTableFlags_ScrollY;
+    if (_igBeginTable_flat(tmpUtf8("##tree"), 6, flags, 0, 0, 0)) {
+      _igTableSetupScrollFreeze(0, 1);
+      _igTableSetupColumn(tmpUtf8("Node"), _ImGuiTableColumnFlags_WidthStretch, 0, 0);
+      _igTableSetupColumn(tmpUtf8("Props"), _ImGuiTableColumnFlags_WidthStretch, 0, 0);
+      _igTableSetupColumn(tmpUtf8("ID"), _ImGuiTableColumnFlags_WidthFixed, 0, 0);
+      _igTableSetupColumn(tmpUtf8("Nodes"), _ImGuiTableColumnFlags_WidthFixed, 0, 0);
+      _igTableSetupColumn(tmpUtf8("Version"), _ImGuiTableColumnFlags_WidthFixed, 0, 0);
+      _igTableSetupColumn(tmpUtf8("ms"), _ImGuiTableColumnFlags_WidthFixed, 0, 0);
+      _igTableHeadersRow();
+      const containers = globalThis.imguiRootContainers;
+      if (containers) {
+        for (let r = 0; r < containers.length; r++) {
+          inspectorRootRow(containers[r], report);
+        }
+      }
+      _igEndTable();
+    }
+  }
+  _igEnd();
+  inspectHighlightId = inspectHoverId;
+  if (!_sh_ptr_read_c_bool(inspectorOpen, 0)) setInspector(false);
+}
+
+/// Open the inspector right away if sappConfig.tree_inspector is set.
+function initTreeInspector(): void {
+  const config = (globalThis as any).sappConfig;
+  if (config && config.tree_inspector) setInspector(true);
+}
+
+initTreeInspector();
+
+/// Apply sappConfig.tmp_arena_limit_kb, which the embedded memory profile
+/// sets by default.
+function initTmpArenaLimit(): void {
+  const config = (globalThis as any).sappConfig;
+  if (config && typeof config.tmp_arena_limit_kb === "number" &&
+      config.tmp_arena_limit_kb >= 0) {
+    setTmpArenaLimit(+config.tmp_arena_limit_kb * 1024);
+  }
+}
+
+initTmpArenaLimit();
+
+// Node ID stack entries (node_id.c)
+const _node_push_id = $SHBuiltin.extern_c({}, function node_push_id(n: c_int, seed: c_uint, id: c_uint): c_uint { throw 0; });
+const _node_id_seed = $SHBuiltin.extern_c({}, function node_id_seed(): c_uint { throw 0; });
+
+// Host component types already reported by reportUnrendered().
+const unrenderedTypes: any = {};
+
+/**
+ * Reports, once per type, a component whose case the specialized renderer
+ * of this app (REACT_IMGUI_SPECIALIZE_RENDERER) doesn't have: its bundles
+ * didn't name it, so it has to be listed in SPECIALIZE_INCLUDE.
+ */
+function reportUnrendered(node: any): void {
+  const type = node.type;
+  if (!unrenderedTypes[type]) {
+    unrenderedTypes[type] = true;
+    console.error(
+      `<${type}> isn't in this app's specialized renderer; add it to SPECIALIZE_INCLUDE. Rendering its children only.`
+    );
+  }
 }
 
 // Tree traversal and rendering
 function renderNode(node: any): void {
   if (!node) return;
 
+  if (profiling) {
+    if (profileBypass) {
+      profileBypass = false;
+    } else {
+      renderNodeProfiled(node);
+      return;
+    }
+  }
+  if (node.id === inspectHighlightId) {
+    if (inspectBypass) {
+      inspectBypass = false;
+    } else {
+      renderNodeHighlighted(node);
+      return;
+    }
+  }
+
   // Push this node's unique ID onto ImGui's ID stack.
   // This ensures each TreeNode instance gets a stable ImGui ID for its lifetime.
   // React maintains TreeNode identity across renders, so the ID remains stable.
-  // Use try/finally to guarantee PopID is called even if rendering throws.
-  _igPushID_Int(node.id);
+  // The hashed ID is cached on the node with the seed it was hashed with, so
+  // it is only hashed again once the node lands under a different seed.
+  // There is no try/finally here: if rendering throws, the enclosing window
+  // (renderWindowChildren) or renderTree unwinds the ID stack.
+  const imguiId = _node_push_id(node.id, node.idSeed, node.imguiId);
+  if (imguiId !== node.imguiId) {
+    node.imguiId = imguiId;
+    node.idSeed = _node_id_seed();
+  }
 
-  try {
-    // Handle text nodes
-    if (node.text !== undefined) {
-      _igText(tmpUtf8(node.text));
-      return;
+  const tag = +node.tag;
+
+  // Handle text nodes
+  if (tag === TAG_TEXT_NODE) {
+    let plan = node.plan;
+    if (plan === null) {
+      plan = { labelSlot: nodeUtf8(node, 0, node.text) };
+      node.plan = plan;
     }
+    textSlot(plan.labelSlot);
+    _igPopID();
+    return;
+  }
 
-    // Reusable buffers for ImVec2 and ImVec4 to reduce allocations
-    const vec2 = allocTmp(_sizeof_ImVec2);
-    const vec4 = allocTmp(_sizeof_ImVec4);
+  // Shared scratch buffer for ImVec2 out-parameters (see scratchVec2A)
+  const vec2 = scratchVec2A;
 
-    // Handle component nodes by delegating to specific render functions
-    switch (node.type) {
-    case "root":
-      renderRoot(node, vec2);
-      break;
+  // Handle component nodes by delegating to specific render functions.
+  // Tags are dense small integers, so this compiles to a jump table.
+  switch (tag) {
+  case TAG_ROOT:
+    renderRoot(node, vec2);
+    break;
 
-    case "window":
-      renderWindow(node, vec2, vec4);
-      break;
+  case TAG_WINDOW:
+    renderWindow(node, vec2);
+    break;
 
-    case "child":
-      renderChild(node, vec2);
-      break;
+  case TAG_CHILD:
+    renderChild(node, vec2);
+    break;
 
-    case "button":
-      renderButton(node, vec2);
-      break;
+  case TAG_BUTTON:
+    renderButton(node);
+    break;
 
-    case "text":
-      renderText(node, vec4);
-      break;
+  case TAG_TEXT:
+    renderText(node);
+    break;
 
-    case "group":
-      renderGroup(node);
-      break;
+  case TAG_GROUP:
+    renderGroup(node);
+    break;
 
-    case "separator":
-      _igSeparator();
-      break;
+  case TAG_SEPARATOR:
+    _igSeparator();
+    break;
 
-    case "sameline":
-      _igSameLine(0.0, -1.0);
-      break;
+  case TAG_SAMELINE:
+    _igSameLine(0.0, -1.0);
+    break;
 
-    case "indent":
-      renderIndent(node);
-      break;
+  case TAG_INDENT:
+    renderIndent(node);
+    break;
 
-    case "collapsingheader":
-      renderCollapsingHeader(node);
-      break;
+  case TAG_COLLAPSINGHEADER:
+    renderCollapsingHeader(node);
+    break;
 
-    case "table":
-      renderTable(node, vec2);
-      break;
+  case TAG_TABLE:
+    renderTable(node, vec2);
+    break;
 
-    case "tableheader":
-      _igTableHeadersRow();
-      break;
+  case TAG_TABLEHEADER:
+    _igTableHeadersRow();
+    break;
+
+  case TAG_TABLEROW:
+    renderTableRow(node);
+    break;
+
+  case TAG_TABLECELL:
+    renderTableCell(node);
+    break;
+
+  case TAG_TABLECOLUMN:
+    renderTableColumn(node);
+    break;
+
+  case TAG_RECT:
+    renderRect(node, vec2);
+    break;
+
+  case TAG_CIRCLE:
+    renderCircle(node, vec2);
+    break;
+
+  case TAG_RADIALMENU:
+    renderRadialMenu(node, vec2);
+    break;
+
+  case TAG_CANVAS:
+    renderCanvas(node, vec2);
+    break;
+
+  case TAG_PLOTLINES:
+    renderPlot(node, false);
+    break;
+
+  case TAG_PLOTHISTOGRAM:
+    renderPlot(node, true);
+    break;
+
+  case TAG_INPUTTEXT:
+    renderInputText(node);
+    break;
+
+  case TAG_COMBO:
+    renderItemList(node, false);
+    break;
+
+  case TAG_LISTBOX:
+    renderItemList(node, true);
+    break;
+
+  case TAG_IMAGE:
+    renderImage(node);
+    break;
+
+  case TAG_VIRTUALLIST:
+    renderVirtualList(node);
+    break;
 
-    case "tablerow":
-      renderTableRow(node);
-      break;
+  case TAG_TREENODE:
+    renderTreeNode(node);
+    break;
 
-    case "tablecell":
-      renderTableCell(node);
-      break;
+  case TAG_DATAGRID:
+    renderDataGrid(node);
+    break;
 
-    case "tablecolumn":
-      renderTableColumn(node);
-      break;
+  case TAG_TEXTVIEW:
+    renderTextView(node);
+    break;
 
-    case "rect":
-      renderRect(node, vec2);
-      break;
+  case TAG_HEATMAP:
+    renderHeatmap(node);
+    break;
 
-    case "circle":
-      renderCircle(node, vec2);
-      break;
+  case TAG_STATIC:
+    renderStatic(node);
+    break;
 
-    case "radialmenu":
-      renderRadialMenu(node, vec2);
-      break;
+  case TAG_TABBAR:
+    renderTabBar(node);
+    break;
 
-    default:
-      // Unknown type - just render children
-      if (node.children) {
-        for (let i = 0; i < node.children.length; i++) {
-          renderNode(node.children[i]);
-        }
-      }
-      break;
+  case TAG_TABITEM:
+    renderTabItem(node);
+    break;
+
+  case TAG_FONT:
+    renderFont(node);
+    break;
+
+  case TAG_NUMBER:
+    renderNumber(node);
+    break;
+
+  default:
+    // Unknown type (TAG_UNKNOWN) - just render children. Any other tag is
+    // a component that a specialized renderer left out.
+    if (_IMGUI_UNIT_CHECKS && tag !== TAG_UNKNOWN) reportUnrendered(node);
+    for (let c = node.firstChild; c; c = c.nextSibling) {
+      renderNode(c);
     }
-  } finally {
-    // Always pop the ID we pushed, even if an exception occurred
-    _igPopID();
+    break;
   }
+
+  _igPopID();
 }
 
 // Export render function
 globalThis.imguiUnit = {
   renderTree: function(): void {
+    _imgui_trace_begin(TRACE_RENDER_TREE);
     const startTime = globalThis.performance.now();
 
-    const reactApp = globalThis.reactApp;
-    if (reactApp && reactApp.rootChildren) {
-      // Validate that only one root component exists
-      let rootCount = 0;
-      for (let i = 0; i < reactApp.rootChildren.length; i++) {
-        if (reactApp.rootChildren[i].type === 'root') {
-          rootCount++;
+    animValues = _imgui_anim_values();
+    windowStatCount = 0;
+
+    // The root containers are created by createRoot() in the React unit,
+    // one per root in creation order. Their rootChildren arrays are updated
+    // in place by the host config, which also enforces the single-<root>
+    // rule.
+    const containers = globalThis.imguiRootContainers;
+    if (containers) {
+      const windowDepth = currentWindowDepth();
+      for (let r = 0; r < containers.length; r++) {
+        const rootChildren = containers[r].rootChildren;
+        // Render all root children (supports fragments with multiple
+        // windows). An exception in one of them is recovered from so the
+        // others still render.
+        for (let i = 0; i < rootChildren.length; i++) {
+          const child = rootChildren[i];
+          try {
+            renderNode(child);
+          } catch (e) {
+            recoverImGuiState(windowDepth);
+            reportRenderError(child, e);
+          }
         }
       }
-
-      if (rootCount > 1) {
-        console.error(`Multiple <root> components detected (${rootCount}). Only one <root> component is allowed.`);
-      }
-
-      // Render all root children (supports fragments with multiple windows)
-      for (let i = 0; i < reactApp.rootChildren.length; i++) {
-        renderNode(reactApp.rootChildren[i]);
-      }
     }
 
     const duration = globalThis.performance.now() - startTime;
 
     // Store for C++ to read
-    if (!globalThis.perfMetrics) {
-      globalThis.perfMetrics = {};
+    setRuntimeMetric(METRIC_RENDER_TIME, duration);
+    _imgui_trace_end();
+
+    // Drawn after the measurement, so it doesn't show up in its own report.
+    if (profiling) {
+      endProfileFrame(duration);
+      renderProfilerWindow();
+    }
+    if (inspecting) renderInspectorWindow();
+  },
+
+  /// Turn the render profiler on or off (see renderNodeProfiled()).
+  setProfiling: function(on: any): void {
+    setProfiling(!!on);
+  },
+
+  /// Open or close the tree inspector (see renderInspectorWindow()).
+  setInspector: function(on: any): void {
+    setInspector(!!on);
+  },
+
+  /// The imgui unit's share of runtime.memoryReport(): the persistent
+  /// native buffers of the tree's nodes (labels, draw commands, columns)
+  /// and the rows of the native state store.
+  memoryStats: function(): any {
+    return {
+      slots: slotStatsCount(),
+      slotBytes: slotStatsBytes(),
+      storeRows: storeRows,
+      storeRowsUsed: storeUsed - storeFreeCount,
+      storeBytes: storeRows * 4 * STORE_COLUMNS,
+    };
+  },
+
+  /// The draw output of each <window> of the last frame, in render order:
+  /// {title, vertices, indices, commands}, counting the window's child
+  /// windows.
+  windowDrawStats: function(): any {
+    const stats: any = [];
+    for (let i = 0; i < windowStatCount; i++) {
+      stats.push({
+        title: windowStatTitles[i],
+        vertices: windowStatCounts[3 * i],
+        indices: windowStatCounts[3 * i + 1],
+        commands: windowStatCounts[3 * i + 2],
+      });
     }
-    globalThis.perfMetrics.renderTime = duration;
+    return stats;
+  },
+
+  releaseNode: function(node: any): void {
+    // Called by React unit when a subtree is removed from the tree
+    releaseNode(node);
   },
 
   onTreeUpdate: function(): void {
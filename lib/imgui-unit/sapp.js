@@ -168,3 +168,115 @@ const _SAPP_MODIFIER_SUPER = 8;
 const _SAPP_MODIFIER_LMB = 256;
 const _SAPP_MODIFIER_RMB = 512;
 const _SAPP_MODIFIER_MMB = 1024;
+
+// sapp_event and sapp_touchpoint, laid out as on 64-bit Linux and macOS
+// (imgui-runtime static_asserts the sizes). Read-only: events are owned by
+// the runtime.
+const _sizeof_sapp_touchpoint = 24;
+const _sizeof_sapp_event = 272;
+function get_sapp_touchpoint_identifier(s: c_ptr): c_ulong {
+  "inline";
+  return _sh_ptr_read_c_ulong(s, 0);
+}
+function get_sapp_touchpoint_pos_x(s: c_ptr): c_float {
+  "inline";
+  return _sh_ptr_read_c_float(s, 8);
+}
+function get_sapp_touchpoint_pos_y(s: c_ptr): c_float {
+  "inline";
+  return _sh_ptr_read_c_float(s, 12);
+}
+function get_sapp_touchpoint_android_tooltype(s: c_ptr): c_int {
+  "inline";
+  return _sh_ptr_read_c_int(s, 16);
+}
+function get_sapp_touchpoint_changed(s: c_ptr): c_bool {
+  "inline";
+  return _sh_ptr_read_c_bool(s, 20);
+}
+function get_sapp_event_frame_count(s: c_ptr): c_ulonglong {
+  "inline";
+  return _sh_ptr_read_c_ulonglong(s, 0);
+}
+function get_sapp_event_type(s: c_ptr): c_int {
+  "inline";
+  return _sh_ptr_read_c_int(s, 8);
+}
+function get_sapp_event_key_code(s: c_ptr): c_int {
+  "inline";
+  return _sh_ptr_read_c_int(s, 12);
+}
+function get_sapp_event_char_code(s: c_ptr): c_uint {
+  "inline";
+  return _sh_ptr_read_c_uint(s, 16);
+}
+function get_sapp_event_key_repeat(s: c_ptr): c_bool {
+  "inline";
+  return _sh_ptr_read_c_bool(s, 20);
+}
+function get_sapp_event_modifiers(s: c_ptr): c_uint {
+  "inline";
+  return _sh_ptr_read_c_uint(s, 24);
+}
+function get_sapp_event_mouse_button(s: c_ptr): c_int {
+  "inline";
+  return _sh_ptr_read_c_int(s, 28);
+}
+function get_sapp_event_mouse_x(s: c_ptr): c_float {
+  "inline";
+  return _sh_ptr_read_c_float(s, 32);
+}
+function get_sapp_event_mouse_y(s: c_ptr): c_float {
+  "inline";
+  return _sh_ptr_read_c_float(s, 36);
+}
+function get_sapp_event_mouse_dx(s: c_ptr): c_float {
+  "inline";
+  return _sh_ptr_read_c_float(s, 40);
+}
+function get_sapp_event_mouse_dy(s: c_ptr): c_float {
+  "inline";
+  return _sh_ptr_read_c_float(s, 44);
+}
+function get_sapp_event_scroll_x(s: c_ptr): c_float {
+  "inline";
+  return _sh_ptr_read_c_float(s, 48);
+}
+function get_sapp_event_scroll_y(s: c_ptr): c_float {
+  "inline";
+  return _sh_ptr_read_c_float(s, 52);
+}
+function get_sapp_event_num_touches(s: c_ptr): c_int {
+  "inline";
+  return _sh_ptr_read_c_int(s, 56);
+}
+function get_sapp_event_touches(s: c_ptr): c_ptr {
+  "inline";
+  return _sh_ptr_add(s, 64);
+}
+function get_sapp_event_window_width(s: c_ptr): c_int {
+  "inline";
+  return _sh_ptr_read_c_int(s, 256);
+}
+function get_sapp_event_window_height(s: c_ptr): c_int {
+  "inline";
+  return _sh_ptr_read_c_int(s, 260);
+}
+function get_sapp_event_framebuffer_width(s: c_ptr): c_int {
+  "inline";
+  return _sh_ptr_read_c_int(s, 264);
+}
+function get_sapp_event_framebuffer_height(s: c_ptr): c_int {
+  "inline";
+  return _sh_ptr_read_c_int(s, 268);
+}
+
+// Data that a sapp_event only announces: the paths of FILES_DROPPED and the
+// text of CLIPBOARD_PASTED. Strings are NUL-terminated UTF-8.
+const _sapp_get_num_dropped_files = $SHBuiltin.extern_c({}, function sapp_get_num_dropped_files(): c_int { throw 0; });
+const _sapp_get_dropped_file_path = $SHBuiltin.extern_c({}, function sapp_get_dropped_file_path(_index: c_int): c_ptr { throw 0; });
+const _sapp_get_clipboard_string = $SHBuiltin.extern_c({}, function sapp_get_clipboard_string(): c_ptr { throw 0; });
+
+// Swap interval of the running app (external/sokol/sokol.c).
+const _sapp_set_swap_interval = $SHBuiltin.extern_c({}, function sapp_set_swap_interval(_interval: c_int): void { throw 0; });
+const _sapp_swap_interval = $SHBuiltin.extern_c({}, function sapp_swap_interval(): c_int { throw 0; });
@@ -0,0 +1,145 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// Native string tables for <combo> and <listbox>.
+// The renderer encodes the `items` array once per change into a single
+// buffer, laid out as
+//   int32 count
+//   int32 offsets[count]   byte offset of each string from the table start
+//   char  strings[]        NUL-terminated UTF-8
+// and the widgets read labels straight out of it, so a large list costs
+// nothing while closed and only the visible rows while open. An index
+// array (the `indices` prop, e.g. a createFilterIndex() result) shows only
+// those items, in its order, without re-encoding the table; *current stays
+// an index into the table.
+
+#define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
+#include "cimgui.h"
+#include <float.h>
+#include <stdint.h>
+
+typedef struct StringTable {
+  int32_t count;
+  int32_t offsets[];
+} StringTable;
+
+static const char *string_table_at(const StringTable *table, int idx) {
+  return (const char *)table + table->offsets[idx];
+}
+
+// items_getter for the ImGui list widgets.
+static bool string_table_getter(void *data, int idx, const char **out_text) {
+  const StringTable *table = (const StringTable *)data;
+  if (idx < 0 || idx >= table->count)
+    return false;
+  *out_text = string_table_at(table, idx);
+  return true;
+}
+
+// The table index of row `row` of a list showing `indices` (NULL: all),
+// or -1 if it is out of the table.
+static int string_table_item(const StringTable *table, const int32_t *indices,
+                             int row) {
+  int idx = indices ? indices[row] : row;
+  return idx >= 0 && idx < table->count ? idx : -1;
+}
+
+// The row showing table index `idx`, or -1.
+static int string_table_row(const StringTable *table, const int32_t *indices,
+                            int count, int idx) {
+  if (!indices)
+    return idx >= 0 && idx < table->count ? idx : -1;
+  for (int row = 0; row < count; ++row) {
+    if (indices[row] == idx)
+      return row;
+  }
+  return -1;
+}
+
+// The Selectable()s of the rows of a list in view, clipped with
+// ImGuiListClipper (the selected item is always submitted so that
+// SetItemDefaultFocus() works on the appearing frame).
+// Returns true if *current changed.
+static bool string_table_rows(int *current, const StringTable *table,
+                              const int32_t *indices, int count,
+                              float item_height) {
+  bool changed = false;
+  ImGuiListClipper *clipper = ImGuiListClipper_ImGuiListClipper();
+  ImGuiListClipper_Begin(clipper, count, item_height);
+  int selected_row = string_table_row(table, indices, count, *current);
+  if (selected_row >= 0)
+    ImGuiListClipper_IncludeItemByIndex(clipper, selected_row);
+  while (ImGuiListClipper_Step(clipper)) {
+    for (int row = clipper->DisplayStart; row < clipper->DisplayEnd; ++row) {
+      int i = string_table_item(table, indices, row);
+      if (i < 0)
+        continue;
+      igPushID_Int(i);
+      bool selected = i == *current;
+      if (igSelectable_Bool(string_table_at(table, i), selected, 0,
+                            (ImVec2){0, 0}) &&
+          !selected) {
+        *current = i;
+        changed = true;
+      }
+      if (selected)
+        igSetItemDefaultFocus();
+      igPopID();
+    }
+  }
+  ImGuiListClipper_destroy(clipper);
+  return changed;
+}
+
+// Like ImGui::Combo() with an items getter, but the popup is clipped (see
+// string_table_rows()). `indices` (NULL: all items) lists the
+// `index_count` items shown.
+// Returns true if *current changed.
+bool string_table_combo(const char *label, int *current,
+                        const StringTable *table, const int32_t *indices,
+                        int index_count, int max_height_in_items) {
+  const char *preview = NULL;
+  if (*current >= 0 && *current < table->count)
+    preview = string_table_at(table, *current);
+
+  if (max_height_in_items > 0) {
+    // ImGui's CalcMaxPopupHeightFromItemCount()
+    ImGuiStyle *style = igGetStyle();
+    float h = (igGetFontSize() + style->ItemSpacing.y) * max_height_in_items -
+              style->ItemSpacing.y + style->WindowPadding.y * 2;
+    igSetNextWindowSizeConstraints((ImVec2){0, 0}, (ImVec2){FLT_MAX, h}, NULL,
+                                   NULL);
+  }
+
+  if (!igBeginCombo(label, preview, 0))
+    return false;
+
+  bool changed = string_table_rows(current, table, indices,
+                                   indices ? index_count : table->count, -1.0f);
+  igEndCombo();
+  return changed;
+}
+
+// ImGui::ListBox() over a string table (ListBox clips by itself), or over
+// the `index_count` items of `indices` with the same size.
+// Returns true if *current changed.
+bool string_table_listbox(const char *label, int *current,
+                          const StringTable *table, const int32_t *indices,
+                          int index_count, int height_in_items) {
+  if (!indices)
+    return igListBox_FnBoolPtr(label, current, string_table_getter,
+                               (void *)table, table->count, height_in_items);
+
+  if (height_in_items < 0)
+    height_in_items = index_count < 7 ? index_count : 7;
+  float item_height = igGetTextLineHeightWithSpacing();
+  float height = (float)(int)(item_height * (height_in_items + 0.25f) +
+                              igGetStyle()->FramePadding.y * 2);
+  if (!igBeginListBox(label, (ImVec2){0, height}))
+    return false;
+  bool changed =
+      string_table_rows(current, table, indices, index_count, item_height);
+  igEndListBox();
+  return changed;
+}
@@ -0,0 +1,106 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// Host tree mutations, compiled with the imgui unit.
+// The host config of the React unit changes the tree only through the
+// `treeOps` of react-imgui-reconciler/tree-node.js: linking and unlinking
+// children, replacing props and text, dropping the cached render plans and
+// labels and stamping tree versions. The unit installs these versions in
+// their place when it loads, so mutations run as compiled code even in
+// modes 1 and 2, where the React unit is bytecode or source. They must
+// behave like the JS ones. The nodes are the reconciler's TreeNode and
+// TextNode objects, whose fields are all declared in init(), so each access
+// sees one of two shapes.
+
+function treeUnlink(parent: any, child: any): void {
+  const prev = child.prevSibling;
+  const next = child.nextSibling;
+  if (prev) {
+    prev.nextSibling = next;
+  } else {
+    parent.firstChild = next;
+  }
+  if (next) {
+    next.prevSibling = prev;
+  } else {
+    parent.lastChild = prev;
+  }
+  child.prevSibling = null;
+  child.nextSibling = null;
+  child.parent = null;
+  parent.childCount = parent.childCount - 1;
+}
+
+function treeLink(parent: any, child: any, beforeChild: any): void {
+  if (child.parent) {
+    treeUnlink(child.parent, child);
+  }
+  const prev = beforeChild ? beforeChild.prevSibling : parent.lastChild;
+  child.prevSibling = prev;
+  child.nextSibling = beforeChild;
+  if (prev) {
+    prev.nextSibling = child;
+  } else {
+    parent.firstChild = child;
+  }
+  if (beforeChild) {
+    beforeChild.prevSibling = child;
+  } else {
+    parent.lastChild = child;
+  }
+  child.parent = parent;
+  parent.childCount = parent.childCount + 1;
+}
+
+function treeStamp(node: any, version: number): void {
+  while (node && node.version !== version) {
+    node.version = version;
+    node = node.parent;
+  }
+}
+
+function treeInvalidate(node: any): void {
+  if (node) {
+    node.plan = null;
+    node.label = null;
+  }
+}
+
+const installTreeOps = (globalThis as any).imguiInstallTreeOps;
+if (installTreeOps) {
+  installTreeOps({
+    link: function(parent: any, child: any, beforeChild: any): void {
+      treeLink(parent, child, beforeChild);
+    },
+    unlink: function(parent: any, child: any): void {
+      treeUnlink(parent, child);
+    },
+    insert: function(parent: any, child: any, beforeChild: any, version: number): void {
+      treeLink(parent, child, beforeChild);
+      treeInvalidate(parent);
+      treeStamp(parent, version);
+    },
+    remove: function(parent: any, child: any, version: number): void {
+      if (child.parent === parent) treeUnlink(parent, child);
+      treeInvalidate(parent);
+      treeStamp(parent, version);
+    },
+    updateProps: function(node: any, props: any, count: number, flags: number, version: number): void {
+      node.props = props;
+      node.propCount = count;
+      node.updateFlags = flags;
+      // UpdateFlags.VALUES
+      if (flags & 1) {
+        node.plan = null;
+        treeStamp(node, version);
+      }
+    },
+    updateText: function(node: any, text: any, version: number): void {
+      node.text = text;
+      node.plan = null;
+      treeInvalidate(node.parent);
+      treeStamp(node, version);
+    },
+  });
+}
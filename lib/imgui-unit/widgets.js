@@ -0,0 +1,101 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// Generated by tools/widgetgen.py from lib/imgui-unit/widgets.json; do not edit.
+// Renderer functions of the widgets described by the schema, compiled
+// after renderer.js, whose helpers they use.
+
+/**
+ * Builds the render plan for a <button>.
+ */
+function buildButtonPlan(node: any): any {
+  return {
+    labelSlot: textLabelSlot(node, "Button"),
+  };
+}
+
+/**
+ * Renders a <button> over igButton(), labeled by its text children.
+ */
+function renderButton(node: any): void {
+  let plan = node.plan;
+  if (plan === null) {
+    plan = buildButtonPlan(node);
+    node.plan = plan;
+  }
+  if (_igButton_flat(utf8SlotPtr(plan.labelSlot), 0, 0)) {
+    safeInvokeEvent(EVENT_DISCRETE, node.props ? node.props.onClick : null);
+  }
+}
+
+/**
+ * Builds the render plan for a <collapsingheader>.
+ */
+function buildCollapsingHeaderPlan(node: any): any {
+  const props = node.props;
+  const title = (props && props.title !== undefined) ? String(props.title) : "Section";
+  return {
+    titleSlot: nodeUtf8(node, 0, title),
+  };
+}
+
+/**
+ * Renders a <collapsingheader> over igCollapsingHeader(). The children are
+ * only walked while it is open.
+ */
+function renderCollapsingHeader(node: any): void {
+  let plan = node.plan;
+  if (plan === null) {
+    plan = buildCollapsingHeaderPlan(node);
+    node.plan = plan;
+  }
+  if (_igCollapsingHeader_TreeNodeFlags(utf8SlotPtr(plan.titleSlot), 0)) {
+    for (let c = node.firstChild; c; c = c.nextSibling) {
+      renderNode(c);
+    }
+  }
+}
+
+/**
+ * Builds the render plan for a <tabbar>.
+ */
+function buildTabBarPlan(node: any): any {
+  const props = node.props;
+  const id = (props && props.id !== undefined) ? String(props.id) : "tabbar";
+  let flags = (props && props.flags !== undefined) ? +props.flags : 0;
+  if (props && props.reorderable) flags |= _ImGuiTabBarFlags_Reorderable;
+  return {
+    idSlot: nodeUtf8(node, 0, id),
+    flags: flags,
+  };
+}
+
+/**
+ * Renders a <tabbar> over igBeginTabBar(). Its <tabitem> children do the
+ * rest.
+ */
+function renderTabBar(node: any): void {
+  let plan = node.plan;
+  if (plan === null) {
+    plan = buildTabBarPlan(node);
+    node.plan = plan;
+  }
+  if (_igBeginTabBar(utf8SlotPtr(plan.idSlot), plan.flags)) {
+    for (let c = node.firstChild; c; c = c.nextSibling) {
+      renderNode(c);
+    }
+    _igEndTabBar();
+  }
+}
+
+/**
+ * Renders an <indent>: its children, indented by one level.
+ */
+function renderIndent(node: any): void {
+  _igIndent(0.0);
+  for (let c = node.firstChild; c; c = c.nextSibling) {
+    renderNode(c);
+  }
+  _igUnindent(0.0);
+}
@@ -0,0 +1,279 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// Contents of a <window updateHz> or <child updateHz> between traversals.
+// window_cache_begin()/window_cache_end() wrap a traversal of the children
+// and copy what it added to the window's draw list: the draw commands
+// (clip rect, texture, index count), the vertices and the indices, and the
+// extent of the layout. On the frames in between, window_cache_emit() adds
+// them to the draw list again, moved with the window, and restores the
+// layout extent, so the content size, scrollbars and auto-resize don't
+// change. igBegin()/igEnd() still run every frame.
+//
+// A capture is not emitted while the window needs its items: when it or
+// one of its child windows is hovered, holds the active item or has the
+// keyboard navigation cursor, while a popup is open or a drag and drop is
+// in progress. Nor when the window's size, scroll position, clip rect, font
+// size or draw list settings changed since it was taken. A traversal that
+// submitted child windows, used draw callbacks or emitted too many vertices
+// for 16-bit indices is not captured at all.
+
+#define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
+#include "cimgui.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Header of a cache buffer (96 bytes, WINDOW_CACHE_HEADER_BYTES in
+// renderer.js), followed by cmd_count WindowCacheCmd, vtx_count ImDrawVert
+// and idx_count ImDrawIdx. The buffer comes from
+// malloc() in asciiz.js and is grown with realloc().
+typedef struct WindowCache {
+  int valid;
+  int cmd_count;
+  int vtx_count;
+  int idx_count;
+  int flags;          // ImDrawList flags (anti-aliasing) at capture
+  ImVec2 white;       // font atlas white pixel at capture
+  float fringe;       // fringe scale at capture
+  float font_size;    // igGetFontSize() at capture
+  ImVec2 pos;         // window position at capture
+  ImVec2 size;        // window size at capture
+  ImVec2 scroll;      // window scroll position at capture
+  ImVec4 clip;        // InnerClipRect, relative to `pos`
+  ImVec2 max_pos;     // DC.CursorMaxPos, relative to `pos`
+  ImVec2 ideal_pos;   // DC.IdealMaxPos, relative to `pos`
+  int reserved;
+} WindowCache;
+
+typedef struct WindowCacheCmd {
+  ImVec4 clip;        // at capture, moved with the vertices
+  ImTextureID texture;
+  unsigned int elem_count;
+} WindowCacheCmd;
+
+// Draw list position at a window_cache_begin() call.
+typedef struct WindowCapture {
+  ImGuiWindow *window;
+  int cmd0;
+  unsigned int elem0;  // indices in command `cmd0` before the capture
+  int vtx0;
+} WindowCapture;
+
+// Nested captures (a <child updateHz> in a <window updateHz>)
+#define MAX_CAPTURES 16
+static WindowCapture s_captures[MAX_CAPTURES];
+static int s_depth;
+
+// Cache buffer of the last window_cache_end() call.
+static WindowCache *s_buf;
+static int s_cap;
+
+static bool in_window(ImGuiWindow *w, ImGuiWindow *window) {
+  return w && (w == window || igIsWindowChildOf(w, window, false));
+}
+
+// Whether `window` must submit its items this frame.
+static bool window_live(ImGuiWindow *window) {
+  ImGuiContext *g = igGetCurrentContext();
+  return in_window(g->HoveredWindow, window) ||
+         (g->ActiveId != 0 && in_window(g->ActiveIdWindow, window)) ||
+         (!g->NavDisableHighlight && in_window(g->NavWindow, window)) ||
+         g->OpenPopupStack.Size > 0 || g->DragDropActive;
+}
+
+static bool vec2_eq(ImVec2 a, ImVec2 b) { return a.x == b.x && a.y == b.y; }
+
+// Whether the capture in `cache` can be emitted into the current window.
+static bool cache_matches(const WindowCache *cache, ImGuiWindow *window) {
+  const ImDrawList *dl = window->DrawList;
+  ImRect clip = window->InnerClipRect;
+  return cache->valid && cache->flags == dl->Flags &&
+         vec2_eq(cache->white, dl->_Data->TexUvWhitePixel) &&
+         cache->fringe == dl->_FringeScale &&
+         cache->font_size == igGetFontSize() &&
+         vec2_eq(cache->size, window->Size) &&
+         vec2_eq(cache->scroll, window->Scroll) &&
+         cache->clip.x == clip.Min.x - window->Pos.x &&
+         cache->clip.y == clip.Min.y - window->Pos.y &&
+         cache->clip.z == clip.Max.x - window->Pos.x &&
+         cache->clip.w == clip.Max.y - window->Pos.y;
+}
+
+// Emit the capture in `cache` into the current window instead of traversing
+// its children, if it is still valid and the window doesn't need its items.
+// Returns whether it did.
+bool window_cache_emit(void *cache_buf) {
+  const WindowCache *cache = (const WindowCache *)cache_buf;
+  ImGuiWindow *window = igGetCurrentWindow();
+  if (!cache_matches(cache, window) || window_live(window))
+    return false;
+
+  ImDrawList *dl = window->DrawList;
+  const WindowCacheCmd *cmds = (const WindowCacheCmd *)(cache + 1);
+  const ImDrawVert *vtx = (const ImDrawVert *)(cmds + cache->cmd_count);
+  const ImDrawIdx *idx = (const ImDrawIdx *)(vtx + cache->vtx_count);
+  float dx = window->Pos.x - cache->pos.x;
+  float dy = window->Pos.y - cache->pos.y;
+
+  // All vertices first; may start a new command with a vertex offset, so
+  // read the base after it
+  ImDrawList_PrimReserve(dl, 0, cache->vtx_count);
+  unsigned int base = dl->_VtxCurrentIdx;
+  ImDrawVert *vw = dl->_VtxWritePtr;
+  for (int i = 0; i < cache->vtx_count; ++i) {
+    vw[i] = vtx[i];
+    vw[i].pos.x += dx;
+    vw[i].pos.y += dy;
+  }
+  dl->_VtxWritePtr += cache->vtx_count;
+  dl->_VtxCurrentIdx += cache->vtx_count;
+
+  for (int c = 0; c < cache->cmd_count; ++c) {
+    const WindowCacheCmd *cmd = &cmds[c];
+    ImVec2 clip_min = {cmd->clip.x + dx, cmd->clip.y + dy};
+    ImVec2 clip_max = {cmd->clip.z + dx, cmd->clip.w + dy};
+    ImDrawList_PushClipRect(dl, clip_min, clip_max, false);
+    ImDrawList_PushTextureID(dl, cmd->texture);
+    ImDrawList_PrimReserve(dl, (int)cmd->elem_count, 0);
+    ImDrawIdx *iw = dl->_IdxWritePtr;
+    for (unsigned int i = 0; i < cmd->elem_count; ++i)
+      iw[i] = (ImDrawIdx)(idx[i] + base);
+    dl->_IdxWritePtr += cmd->elem_count;
+    idx += cmd->elem_count;
+    ImDrawList_PopTextureID(dl);
+    ImDrawList_PopClipRect(dl);
+  }
+
+  window->DC.CursorMaxPos.x = window->Pos.x + cache->max_pos.x;
+  window->DC.CursorMaxPos.y = window->Pos.y + cache->max_pos.y;
+  window->DC.IdealMaxPos.x = window->Pos.x + cache->ideal_pos.x;
+  window->DC.IdealMaxPos.y = window->Pos.y + cache->ideal_pos.y;
+  return true;
+}
+
+// Start capturing what the current window's children draw. Returns a token
+// for window_cache_end().
+int window_cache_begin(void) {
+  int token = s_depth++;
+  if (token < MAX_CAPTURES) {
+    ImGuiWindow *window = igGetCurrentWindow();
+    ImDrawList *dl = window->DrawList;
+    WindowCapture *capture = &s_captures[token];
+    capture->window = window;
+    capture->cmd0 = dl->CmdBuffer.Size - 1;
+    capture->elem0 = dl->CmdBuffer.Data[capture->cmd0].ElemCount;
+    capture->vtx0 = dl->VtxBuffer.Size;
+  }
+  return token;
+}
+
+static bool reserve(int need) {
+  if (need <= s_cap)
+    return true;
+  int cap = s_cap > 0 ? s_cap : 256;
+  while (cap < need)
+    cap *= 2;
+  WindowCache *buf = (WindowCache *)realloc(s_buf, cap);
+  if (!buf)
+    return false;
+  s_buf = buf;
+  s_cap = cap;
+  return true;
+}
+
+// Finish the capture of `token` into the cache buffer `cache` of `cap`
+// bytes (at least sizeof(WindowCache)), before the window's igEnd() or
+// igEndChild(). The (possibly reallocated) buffer and its capacity are
+// returned through window_cache_buffer()/window_cache_capacity().
+void window_cache_end(int token, void *cache, int cap) {
+  s_buf = (WindowCache *)cache;
+  s_cap = cap;
+  s_buf->valid = 0;
+  // Also unwinds the captures of inner windows whose rendering threw
+  s_depth = token;
+  if (token >= MAX_CAPTURES)
+    return;
+  const WindowCapture *capture = &s_captures[token];
+  ImGuiWindow *window = capture->window;
+  ImDrawList *dl = window->DrawList;
+  int vtx_count = dl->VtxBuffer.Size - capture->vtx0;
+  if (window->DC.ChildWindows.Size > 0 ||
+      (sizeof(ImDrawIdx) == 2 && vtx_count > 0xFFFF))
+    return;
+
+  // Count the commands with indices, and check that they can be emitted
+  // again through one vertex range
+  int cmd_count = 0;
+  int idx_count = 0;
+  for (int c = capture->cmd0; c < dl->CmdBuffer.Size; ++c) {
+    const ImDrawCmd *cmd = &dl->CmdBuffer.Data[c];
+    unsigned int elem0 = c == capture->cmd0 ? capture->elem0 : 0;
+    if (cmd->UserCallback)
+      return;
+    if (cmd->ElemCount == elem0)
+      continue;
+    if (cmd->VtxOffset > (unsigned int)capture->vtx0)
+      return;
+    ++cmd_count;
+    idx_count += (int)(cmd->ElemCount - elem0);
+  }
+  int need = (int)sizeof(WindowCache) +
+             cmd_count * (int)sizeof(WindowCacheCmd) +
+             vtx_count * (int)sizeof(ImDrawVert) +
+             idx_count * (int)sizeof(ImDrawIdx);
+  if (!reserve(need))
+    return;
+
+  WindowCache *out = s_buf;
+  WindowCacheCmd *cmds = (WindowCacheCmd *)(out + 1);
+  ImDrawVert *vtx = (ImDrawVert *)(cmds + cmd_count);
+  ImDrawIdx *idx = (ImDrawIdx *)(vtx + vtx_count);
+  memcpy(vtx, dl->VtxBuffer.Data + capture->vtx0,
+         vtx_count * sizeof(ImDrawVert));
+  int n = 0;
+  for (int c = capture->cmd0; c < dl->CmdBuffer.Size; ++c) {
+    const ImDrawCmd *cmd = &dl->CmdBuffer.Data[c];
+    unsigned int elem0 = c == capture->cmd0 ? capture->elem0 : 0;
+    if (cmd->ElemCount == elem0)
+      continue;
+    cmds[n].clip = cmd->ClipRect;
+    cmds[n].texture = cmd->TextureId;
+    cmds[n].elem_count = cmd->ElemCount - elem0;
+    // Indices relative to the first captured vertex
+    unsigned int rebase = (unsigned int)capture->vtx0 - cmd->VtxOffset;
+    const ImDrawIdx *src = dl->IdxBuffer.Data + cmd->IdxOffset + elem0;
+    for (unsigned int i = 0; i < cmds[n].elem_count; ++i)
+      *idx++ = (ImDrawIdx)(src[i] - rebase);
+    ++n;
+  }
+
+  out->valid = 1;
+  out->cmd_count = cmd_count;
+  out->vtx_count = vtx_count;
+  out->idx_count = idx_count;
+  out->flags = dl->Flags;
+  out->white = dl->_Data->TexUvWhitePixel;
+  out->fringe = dl->_FringeScale;
+  out->font_size = igGetFontSize();
+  out->pos = window->Pos;
+  out->size = window->Size;
+  out->scroll = window->Scroll;
+  out->clip.x = window->InnerClipRect.Min.x - window->Pos.x;
+  out->clip.y = window->InnerClipRect.Min.y - window->Pos.y;
+  out->clip.z = window->InnerClipRect.Max.x - window->Pos.x;
+  out->clip.w = window->InnerClipRect.Max.y - window->Pos.y;
+  out->max_pos.x = window->DC.CursorMaxPos.x - window->Pos.x;
+  out->max_pos.y = window->DC.CursorMaxPos.y - window->Pos.y;
+  out->ideal_pos.x = window->DC.IdealMaxPos.x - window->Pos.x;
+  out->ideal_pos.y = window->DC.IdealMaxPos.y - window->Pos.y;
+}
+
+// Cache buffer after the last window_cache_end() call (may have been
+// reallocated).
+void *window_cache_buffer(void) { return s_buf; }
+
+// Capacity of window_cache_buffer() in bytes.
+int window_cache_capacity(void) { return s_cap; }
@@ -0,0 +1,48 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// Draw output of a top-level window, for the renderer's per-window draw
+// statistics and the drawBudget prop of <window>. Measured right after the
+// window's igEnd(): nothing is added to its draw lists after that, and
+// igRender() only copies them into the frame's draw data. Child windows
+// (<child>, tables with scrolling) have draw lists of their own, which are
+// counted with their parent; popups and tooltips are windows of their own.
+
+#define CIMGUI_DEFINE_ENUMS_AND_STRUCTS
+#include "cimgui.h"
+
+// Indices and draw commands of the last window_draw_stats() call.
+static int s_indices;
+static int s_commands;
+
+static int add_window(ImGuiWindow *window) {
+  // Hidden windows (e.g. auto-fitting in their first frame) aren't drawn
+  if (!window->Active || window->Hidden)
+    return 0;
+  ImDrawList *list = window->DrawList;
+  int vertices = list->VtxBuffer.Size;
+  s_indices += list->IdxBuffer.Size;
+  // The open command at the end is dropped by igRender() while empty
+  for (int i = 0; i < list->CmdBuffer.Size; ++i) {
+    if (list->CmdBuffer.Data[i].ElemCount > 0 ||
+        list->CmdBuffer.Data[i].UserCallback)
+      ++s_commands;
+  }
+  for (int i = 0; i < window->DC.ChildWindows.Size; ++i)
+    vertices += add_window(window->DC.ChildWindows.Data[i]);
+  return vertices;
+}
+
+// Count the draw output of `window` and its child windows in this frame.
+// Returns the vertices; window_draw_indices() and window_draw_commands()
+// return the rest.
+int window_draw_stats(ImGuiWindow *window) {
+  s_indices = 0;
+  s_commands = 0;
+  return add_window(window);
+}
+
+int window_draw_indices(void) { return s_indices; }
+
+int window_draw_commands(void) { return s_commands; }
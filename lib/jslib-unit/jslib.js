@@ -9,141 +9,2923 @@
 (function () {
   'use strict';
 
+  // Pending tasks form a binary min-heap ordered by (deadline, id). IDs are
+  // increasing, so tasks with the same deadline run in FIFO order.
+  // clearTimeout() only marks a task as cancelled; cancelled tasks are
+  // discarded when they reach the top of the heap, or all at once when they
+  // make up more than half of it. Intervals are tasks too: they stay in the
+  // heap and are re-keyed in place to their next tick.
   var tasks = [];
+  var liveTasks = {}; // Map of task IDs to pending (not cancelled) tasks
+  var cancelledCount = 0;
   var nextTaskID = 0;
   var curTime = 0;
-  var intervals = {}; // Map of interval IDs to their state
+
+  // setImmediate() callbacks bypass the heap: they wait in a FIFO ring
+  // buffer that is drained before the timers. Immediates have their own
+  // consecutive IDs, so the slot of an ID is found in O(1) and
+  // clearImmediate() just leaves a null tombstone in it.
+  var immFns = new Array(16);
+  var immArgs = new Array(16);
+  var immHead = 0; // Slot of the oldest entry
+  var immLength = 0; // Entries in the buffer, including tombstones
+  var immLive = 0; // Entries that weren't cancelled
+  var immFirstId = 1; // ID of the entry at immHead
+
+  var deferredTasks = 0; // Due tasks moved to a later frame by runReady()
+  var budgetOverruns = 0; // runReady() calls that took longer than budgetMs
+  // How late runReady() started the timers of the last 5 seconds, in ms: a
+  // RollingStats, created once the class below is defined.
+  var timerLateness = null;
+
+  // Performance counters live in the runtime's native RuntimeMetrics block
+  // (lib/imgui-runtime/RuntimeMetrics.h), which the host reads directly.
+  // Once this unit has loaded, the host installs globalThis.__runtimeMetrics,
+  // a Float64Array over the block. The names are in field order;
+  // globalThis.perfMetrics reads and writes the fields by name.
+  var METRIC_NAMES = [
+    'renderTime',
+    'reconciliationAvg',
+    'reconciliationMax',
+    'deferredTasks',
+    'budgetOverruns',
+    'tmpBytes',
+    'tmpPeakBytes',
+    'tmpBlocks',
+    'inputLatency',
+    'inputLatencyAvg',
+    'inputLatencyMax',
+    'commitTime',
+    'traceCapturing',
+    'commitCreateInstance',
+    'commitCreateTextInstance',
+    'commitAppendChild',
+    'commitInsertBefore',
+    'commitRemoveChild',
+    'commitUpdate',
+    'commitTextUpdate',
+    'lastCommitTime',
+    'reconciliationP50',
+    'reconciliationP95',
+    'reconciliationP99',
+    'gcCount',
+    'gcPauseTime',
+    'heapSize',
+    'heapAllocated',
+    'tmpAllocs',
+    'nativeAllocs',
+    'nativeAllocBytes',
+    'imguiAllocs',
+    'imguiAllocBytes',
+    'jsAllocBytes',
+    'frameTasks',
+    'frameRafCallbacks',
+    'tasksPerFrame',
+    'rafCallbacksPerFrame',
+    'macrotaskQueueDepth',
+    'timerLatenessAvg',
+    'timerLatenessP95',
+    'timerLatenessMax',
+    'microtaskDrainTime',
+    'drawBufferVertices',
+    'drawBufferIndices',
+    'drawBufferVertexCapacity',
+    'drawBufferIndexCapacity',
+    'drawBufferResizes',
+    'microtaskDrains',
+  ];
+  var METRIC_DEFERRED_TASKS = 3;
+  var METRIC_BUDGET_OVERRUNS = 4;
+  var METRIC_FRAME_TASKS = 34;
+  var METRIC_FRAME_RAF_CALLBACKS = 35;
+  var METRIC_MACROTASK_QUEUE_DEPTH = 38;
+  var METRIC_TIMER_LATENESS_AVG = 39;
+  var METRIC_TIMER_LATENESS_P95 = 40;
+  var METRIC_TIMER_LATENESS_MAX = 41;
+  var metrics = null; // globalThis.__runtimeMetrics, looked up on first use
+
+  var perfMetrics = {};
+  METRIC_NAMES.forEach(function (name, i) {
+    Object.defineProperty(perfMetrics, name, {
+      enumerable: true,
+      get: function () {
+        var m = globalThis.__runtimeMetrics;
+        return m ? m[i] : 0;
+      },
+      set: function (value) {
+        var m = globalThis.__runtimeMetrics;
+        if (m) m[i] = value;
+      },
+    });
+  });
+  globalThis.perfMetrics = perfMetrics;
+
+  // globalThis.runtime.memoryReport() breaks memory use down by subsystem,
+  // in bytes: the native side from __memoryReport(), the temp arena from
+  // the metrics and the node buffers from the imgui unit.
+  // runtime.collectGarbage() runs a full collection.
+  globalThis.runtime = {
+    memoryReport: function () {
+      var report = __memoryReport();
+      report.tempArena = {
+        peakBytes: perfMetrics.tmpPeakBytes,
+        blocks: perfMetrics.tmpBlocks,
+      };
+      var unit = globalThis.imguiUnit;
+      report.nodeBuffers =
+        unit && unit.memoryStats
+          ? unit.memoryStats()
+          : { slots: 0, slotBytes: 0, storeRows: 0, storeRowsUsed: 0,
+              storeBytes: 0 };
+      return report;
+    },
+    // A full collection, so that only reachable objects remain
+    collectGarbage: function () {
+      __collectGarbage();
+    },
+  };
+
+  // globalThis.trace adds markers to the runtime's trace captures (F4 or the
+  // IMGUI_TRACE environment variable). While no capture runs, begin() and
+  // end() only read the traceCapturing metric, so markers can stay in place.
+  // Each begin() must be matched by an end() on the same frame phase.
+  var METRIC_TRACE_CAPTURING = 12;
+  var traceIds = {}; // Event name -> ID returned by __traceIntern()
+  var traceDepth = 0; // begin() calls recorded and not ended yet
+
+  globalThis.trace = {
+    get capturing() {
+      var m = globalThis.__runtimeMetrics;
+      return !!(m && m[METRIC_TRACE_CAPTURING]);
+    },
+    begin: function (name) {
+      var m = globalThis.__runtimeMetrics;
+      if (!m || !m[METRIC_TRACE_CAPTURING]) return;
+      var id = traceIds[name];
+      if (id === undefined) id = traceIds[name] = __traceIntern(String(name));
+      __traceBegin(id);
+      traceDepth++;
+    },
+    end: function () {
+      // An end() whose begin() was skipped because the capture started in
+      // between must not close a native event.
+      if (traceDepth === 0) return;
+      traceDepth--;
+      __traceEnd();
+    },
+    // Record `value` on the counter track `name`.
+    counter: function (name, value) {
+      var m = globalThis.__runtimeMetrics;
+      if (!m || !m[METRIC_TRACE_CAPTURING]) return;
+      var id = traceIds[name];
+      if (id === undefined) id = traceIds[name] = __traceIntern(String(name));
+      __traceCounter(id, +value);
+    },
+  };
+
+  // RollingStats keeps the samples of a measurement (render time, frame time,
+  // GC pauses, ...) no older than `windowMs` and at most `capacity` of them,
+  // in typed-array ring buffers. A log-scale histogram of the same samples
+  // is updated as they come and go, so percentiles cost a walk over a fixed
+  // number of buckets instead of a sort. Bucket edges grow by 5%, covering
+  // 1us to over 10s; percentiles are the upper edge of their bucket, capped
+  // at the exact maximum. Samples only expire in add() and expire().
+  var HIST_MIN = 0.001;
+  var HIST_LOG_GROWTH = Math.log(1.05);
+  var HIST_BUCKETS = 340;
+
+  function histBucket(value) {
+    if (!(value > HIST_MIN)) return 0;
+    var b = Math.floor(Math.log(value / HIST_MIN) / HIST_LOG_GROWTH) + 1;
+    return b < HIST_BUCKETS ? b : HIST_BUCKETS - 1;
+  }
+
+  function RollingStats(options) {
+    var capacity = options && options.capacity > 0 ? options.capacity | 0 : 256;
+    this.windowMs =
+      options && options.windowMs > 0 ? options.windowMs : Infinity;
+    this.values = new Float64Array(capacity);
+    this.times = new Float64Array(capacity);
+    this.buckets = new Int32Array(HIST_BUCKETS);
+    this.head = 0; // Slot of the oldest sample
+    this.count = 0;
+    this.sum = 0;
+    this.maxValue = 0;
+    this.maxStale = false; // The maximum sample was evicted
+  }
+
+  RollingStats.prototype.add = function (value, now) {
+    if (now === undefined) now = performance.now();
+    this.expire(now);
+    var capacity = this.values.length;
+    if (this.count === capacity) this.evictOldest();
+    var slot = (this.head + this.count) % capacity;
+    this.values[slot] = value;
+    this.times[slot] = now;
+    this.count++;
+    this.sum += value;
+    this.buckets[histBucket(value)]++;
+    if (!this.maxStale && value > this.maxValue) this.maxValue = value;
+  };
+
+  // Drop the samples that fell out of the window at time `now`.
+  RollingStats.prototype.expire = function (now) {
+    var cutoff = now - this.windowMs;
+    while (this.count > 0 && this.times[this.head] < cutoff) {
+      this.evictOldest();
+    }
+  };
+
+  RollingStats.prototype.evictOldest = function () {
+    var value = this.values[this.head];
+    this.buckets[histBucket(value)]--;
+    this.head = (this.head + 1) % this.values.length;
+    if (--this.count === 0) {
+      // Rounding errors don't outlive the samples
+      this.sum = 0;
+      this.maxValue = 0;
+      this.maxStale = false;
+      return;
+    }
+    this.sum -= value;
+    if (value >= this.maxValue) this.maxStale = true;
+  };
+
+  RollingStats.prototype.average = function () {
+    return this.count ? this.sum / this.count : 0;
+  };
+
+  RollingStats.prototype.max = function () {
+    if (this.maxStale) {
+      // Only rescanned when the maximum itself was evicted
+      var capacity = this.values.length;
+      var max = 0;
+      for (var i = 0; i < this.count; i++) {
+        var v = this.values[(this.head + i) % capacity];
+        if (v > max) max = v;
+      }
+      this.maxValue = max;
+      this.maxStale = false;
+    }
+    return this.maxValue;
+  };
+
+  // The value below which a fraction `p` (0..1) of the samples fall.
+  RollingStats.prototype.percentile = function (p) {
+    if (this.count === 0) return 0;
+    var rank = Math.max(1, Math.ceil(p * this.count));
+    var seen = 0;
+    for (var b = 0; b < HIST_BUCKETS; b++) {
+      seen += this.buckets[b];
+      if (seen >= rank) {
+        return Math.min(HIST_MIN * Math.exp(b * HIST_LOG_GROWTH), this.max());
+      }
+    }
+    return this.max();
+  };
+
+  globalThis.RollingStats = RollingStats;
+
+  timerLateness = new RollingStats({ capacity: 512, windowMs: 5000 });
+
+  // globalThis.profiler runs the Hermes sampling profiler, like F5 and the
+  // IMGUI_PROFILE environment variable, and writes the samples as a
+  // .cpuprofile for Chrome DevTools when it stops. start(seconds) stops by
+  // itself after `seconds` (default IMGUI_PROFILE_SECONDS or 10; 0 runs
+  // until stop()).
+  globalThis.profiler = {
+    start: function (seconds) {
+      __profilerStart(seconds === undefined ? -1 : +seconds);
+    },
+    stop: function () {
+      __profilerStop();
+    },
+  };
+
+  // globalThis.startupTimes() returns how long each startup phase took in
+  // ms, as printed with the IMGUI_STARTUP_TIMES environment variable:
+  // runtimeInit, jslibUnit, imguiMain (with bundleMap and bundleEval),
+  // imguiUnit, window, gfxSetup (with fontAtlas), onInit, firstFrame and
+  // total, and the peak RSS at that point in bytes (peakRss). Phases that
+  // didn't run are missing. Returns null until the first frame has been
+  // presented.
+  globalThis.startupTimes = function () {
+    return __startupTimes();
+  };
+
+  // Source map symbolication of CPU profiles, used by the runtime when the
+  // bundle wasn't evaluated from source together with its source map.
+  var VLQ_CHARS =
+    'ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/';
+  var vlqDigits = null; // Char code -> base64 digit
+
+  // Decode the "mappings" of a source map into one array per generated
+  // line, holding (generated column, source, line, column) quadruples by
+  // increasing column. Segments without a source have source -1.
+  function decodeMappings(mappings) {
+    if (!vlqDigits) {
+      vlqDigits = new Int8Array(128);
+      for (var i = 0; i < 64; i++) vlqDigits[VLQ_CHARS.charCodeAt(i)] = i;
+    }
+    var lines = [];
+    var line = [];
+    // genColumn, source, origLine, origColumn, name; all but the first are
+    // relative to the previous segment of any line.
+    var fields = [0, 0, 0, 0, 0];
+    var field = 0;
+    var value = 0;
+    var shift = 0;
+    for (var i = 0; i <= mappings.length; i++) {
+      var c = i < mappings.length ? mappings.charCodeAt(i) : 59;
+      if (c === 44 || c === 59) {
+        // ',' ends a segment, ';' a line.
+        if (field > 0) {
+          var source = field >= 4 ? fields[1] : -1;
+          line.push(fields[0], source, fields[2], fields[3]);
+        }
+        field = 0;
+        if (c === 59) {
+          lines.push(line);
+          line = [];
+          fields[0] = 0;
+        }
+        continue;
+      }
+      var digit = vlqDigits[c & 127];
+      value += (digit & 31) << shift;
+      if (digit & 32) {
+        shift += 5;
+        continue;
+      }
+      fields[field++] += value & 1 ? -(value >>> 1) : value >>> 1;
+      value = 0;
+      shift = 0;
+    }
+    return lines;
+  }
+
+  // Map the call frames of the DevTools profile `profileText` that are in a
+  // file named in `bundleNames` to the original sources of the source map
+  // `mapText`. Returns the profile text; function names are kept.
+  function symbolicateProfile(profileText, mapText, bundleNames) {
+    var map = JSON.parse(mapText);
+    var lines = decodeMappings(map.mappings);
+    var sourceRoot = map.sourceRoot || '';
+    var profile = JSON.parse(profileText);
+    var nodes = (profile.profile || profile).nodes || [];
+    for (var n = 0; n < nodes.length; n++) {
+      var frame = nodes[n].callFrame;
+      if (!frame || !(frame.lineNumber >= 0)) continue;
+      var url = String(frame.url);
+      if (bundleNames.indexOf(url.slice(url.lastIndexOf('/') + 1)) < 0) {
+        continue;
+      }
+      var segs = lines[frame.lineNumber];
+      if (!segs || segs.length === 0) continue;
+      // Last segment starting at or before the column.
+      var lo = 0;
+      var hi = segs.length / 4 - 1;
+      var col = frame.columnNumber > 0 ? frame.columnNumber : 0;
+      if (segs[0] > col) continue;
+      while (lo < hi) {
+        var mid = (lo + hi + 1) >> 1;
+        if (segs[mid * 4] <= col) lo = mid;
+        else hi = mid - 1;
+      }
+      if (segs[lo * 4 + 1] < 0) continue;
+      frame.url = sourceRoot + map.sources[segs[lo * 4 + 1]];
+      frame.lineNumber = segs[lo * 4 + 2];
+      frame.columnNumber = segs[lo * 4 + 3];
+    }
+    return JSON.stringify(profile);
+  }
+
+  function taskBefore(a, b) {
+    return (
+      a.deadline < b.deadline || (a.deadline === b.deadline && a.id < b.id)
+    );
+  }
+
+  function siftUp(i) {
+    var task = tasks[i];
+    while (i > 0) {
+      var parent = (i - 1) >> 1;
+      if (!taskBefore(task, tasks[parent])) break;
+      tasks[i] = tasks[parent];
+      i = parent;
+    }
+    tasks[i] = task;
+  }
+
+  function siftDown(i) {
+    var n = tasks.length;
+    var task = tasks[i];
+    for (;;) {
+      var child = 2 * i + 1;
+      if (child >= n) break;
+      if (child + 1 < n && taskBefore(tasks[child + 1], tasks[child])) {
+        child++;
+      }
+      if (!taskBefore(tasks[child], task)) break;
+      tasks[i] = tasks[child];
+      i = child;
+    }
+    tasks[i] = task;
+  }
+
+  // Remove and return the first task of the heap.
+  function popTask() {
+    var top = tasks[0];
+    var last = tasks.pop();
+    if (tasks.length) {
+      tasks[0] = last;
+      siftDown(0);
+    }
+    return top;
+  }
+
+  // Drop cancelled tasks from the top of the heap.
+  function skipCancelled() {
+    while (tasks.length && tasks[0].cancelled) {
+      popTask();
+      cancelledCount--;
+    }
+  }
+
+  // Rebuild the heap without its cancelled tasks.
+  function compactTasks() {
+    var live = [];
+    for (var i = 0; i < tasks.length; i++) {
+      if (!tasks[i].cancelled) live.push(tasks[i]);
+    }
+    tasks = live;
+    cancelledCount = 0;
+    for (var j = (tasks.length >> 1) - 1; j >= 0; j--) {
+      siftDown(j);
+    }
+  }
+
+  // Number of live tasks of the heap rooted at `i` that are due at `tm`.
+  // Only the due part of the heap is visited, since a task is never due
+  // before its parent.
+  function countDue(i, tm) {
+    if (i >= tasks.length || tasks[i].deadline > tm) return 0;
+    return (
+      (tasks[i].cancelled ? 0 : 1) +
+      countDue(2 * i + 1, tm) +
+      countDue(2 * i + 2, tm)
+    );
+  }
+
+  // Take the due task at the top of the heap for running. A timeout leaves
+  // the heap; an interval is re-keyed in place to its next tick, computed
+  // from its original schedule rather than from `tm`, so it doesn't drift.
+  // Missed ticks of a coalescing interval are skipped, the others are run
+  // back to back until the interval has caught up.
+  function takeTask(tm) {
+    var task = tasks[0];
+    if (!task.interval) {
+      popTask();
+      delete liveTasks[task.id];
+      return task;
+    }
+    var next = task.deadline + task.interval;
+    if (task.coalesce && next <= tm) {
+      next += Math.floor((tm - next) / task.interval + 1) * task.interval;
+    }
+    task.deadline = next;
+    siftDown(0);
+    return task;
+  }
+
+  function pushImmediate(fn, args) {
+    if (immLength === immFns.length) growImmediates();
+    var i = (immHead + immLength) & (immFns.length - 1);
+    immFns[i] = fn;
+    immArgs[i] = args;
+    immLength++;
+    immLive++;
+    return immFirstId + immLength - 1;
+  }
+
+  // Double the ring buffer, moving the entries to the start of it.
+  function growImmediates() {
+    var cap = immFns.length;
+    var fns = new Array(cap * 2);
+    var args = new Array(cap * 2);
+    for (var k = 0; k < immLength; k++) {
+      fns[k] = immFns[(immHead + k) & (cap - 1)];
+      args[k] = immArgs[(immHead + k) & (cap - 1)];
+    }
+    immFns = fns;
+    immArgs = args;
+    immHead = 0;
+  }
+
+  // Remove the oldest entry of the ring buffer and run it, unless it's a
+  // tombstone.
+  function runImmediate() {
+    var i = immHead;
+    var fn = immFns[i];
+    var args = immArgs[i];
+    immFns[i] = null;
+    immArgs[i] = null;
+    immHead = (i + 1) & (immFns.length - 1);
+    immLength--;
+    immFirstId++;
+    if (fn === null) return;
+    immLive--;
+    if (args === null) fn();
+    else fn.apply(undefined, args);
+  }
 
   // Return the deadline of the next task, or -1 if there is no task.
+  // Pending immediates are due now.
   function peekMacroTask() {
+    if (immLive) return curTime;
+    skipCancelled();
+    return tasks.length ? tasks[0].deadline : -1;
+  }
+
+  // Run the next immediate, or the next timer if it's time.
+  // `tm` is the current time in milliseconds.
+  function runMacroTask(tm) {
+    curTime = tm;
+    while (immLength) {
+      if (immFns[immHead] !== null) {
+        runImmediate();
+        return;
+      }
+      runImmediate();
+    }
+    skipCancelled();
+    if (tasks.length && tasks[0].deadline <= tm) {
+      var task = takeTask(tm);
+      task.fn.apply(undefined, task.args);
+    }
+  }
+
+  // Run the immediates and every timer that is due at `tm`, draining the
+  // microtask queue after each one through the host's __drainMicrotasks()
+  // hook (if the drain policy installed it). Work proceeds in passes: the immediates queued before a pass run
+  // first, then the due timers, so neither can starve the other. Stops
+  // early once `budgetMs` milliseconds have been spent (at least one task
+  // always runs). Returns the deadline of the next task (`tm` if
+  // immediates are left), or -1 if there is none. This lets the host run a
+  // frame's macrotasks with a single call.
+  // Tasks left for a later frame and calls that took longer than the budget
+  // are counted in perfMetrics.deferredTasks and perfMetrics.budgetOverruns.
+  // The tasks run are added to perfMetrics.frameTasks, the tasks left are
+  // perfMetrics.macrotaskQueueDepth, and how late each timer started (`tm`
+  // plus the time spent in this call, minus its deadline) goes to the
+  // perfMetrics.timerLateness* statistics and the "timer lateness" trace
+  // counter.
+  function runReady(tm, budgetMs) {
+    curTime = tm;
+    var drain = globalThis.__drainMicrotasks;
+    var perf = globalThis.performance;
+    var start = perf.now();
+    var first = true;
+    var ran = 0; // Tasks run
+    var latenessCount = timerLateness.count;
+    var batch = immLength; // Immediates left in the current pass
+    for (;;) {
+      var immediate = batch > 0;
+      if (!immediate) {
+        skipCancelled();
+        if (!tasks.length || tasks[0].deadline > tm) {
+          // The due timers are done: start the next pass.
+          if (!immLength) break;
+          batch = immLength;
+          immediate = true;
+        }
+      }
+      if (!first && perf.now() - start >= budgetMs) {
+        deferredTasks += immLive + countDue(0, tm);
+        break;
+      }
+      first = false;
+      ran++;
+      try {
+        if (immediate) {
+          batch--;
+          runImmediate();
+        } else {
+          var now = tm + (perf.now() - start);
+          var late = Math.max(0, now - tasks[0].deadline);
+          timerLateness.add(late, now);
+          globalThis.trace.counter('timer lateness', late);
+          var task = takeTask(tm);
+          task.fn.apply(undefined, task.args);
+        }
+      } catch (e) {
+        reportError(e);
+      }
+      if (drain) drain();
+    }
+    if (!first && perf.now() - start > budgetMs) budgetOverruns++;
+    if (!metrics) metrics = globalThis.__runtimeMetrics || null;
+    if (metrics) {
+      metrics[METRIC_DEFERRED_TASKS] = deferredTasks;
+      metrics[METRIC_BUDGET_OVERRUNS] = budgetOverruns;
+      metrics[METRIC_FRAME_TASKS] += ran;
+      metrics[METRIC_MACROTASK_QUEUE_DEPTH] =
+        immLive + tasks.length - cancelledCount;
+      timerLateness.expire(tm);
+      if (ran || timerLateness.count !== latenessCount) {
+        metrics[METRIC_TIMER_LATENESS_AVG] = timerLateness.average();
+        metrics[METRIC_TIMER_LATENESS_P95] = timerLateness.percentile(0.95);
+        metrics[METRIC_TIMER_LATENESS_MAX] = timerLateness.max();
+      }
+    }
+    if (immLive) return tm;
+    skipCancelled();
     return tasks.length ? tasks[0].deadline : -1;
   }
 
-  // Run the next task if it's time.
-  // `tm` is the current time in milliseconds.
-  function runMacroTask(tm) {
-    curTime = tm;
-    if (tasks.length && tasks[0].deadline <= tm) {
-      var task = tasks.shift();
-      task.fn.apply(undefined, task.args);
+  // Schedule a task. `interval` is 0 for a timeout, or the period of an
+  // interval in milliseconds.
+  function addTask(fn, delay, interval, coalesce, args) {
+    var id = nextTaskID++;
+    var task = {
+      id,
+      fn,
+      deadline: curTime + delay,
+      args,
+      cancelled: false,
+      interval,
+      coalesce,
+    };
+    liveTasks[id] = task;
+    tasks.push(task);
+    siftUp(tasks.length - 1);
+    return id;
+  }
+
+  function setTimeout(fn, ms = 0, ...args) {
+    return addTask(fn, Math.max(0, ms | 0), 0, false, args);
+  }
+
+  function clearTimeout(id) {
+    var task = liveTasks[id];
+    if (task === undefined) return;
+    delete liveTasks[id];
+    task.cancelled = true;
+    if (++cancelledCount > tasks.length >> 1) {
+      compactTasks();
+    }
+  }
+
+  // Arguments are only copied when there are any, so the common
+  // setImmediate(fn) allocates nothing.
+  function setImmediate(fn) {
+    return pushImmediate(
+      fn,
+      arguments.length > 1 ? Array.prototype.slice.call(arguments, 1) : null
+    );
+  }
+
+  // Immediate IDs are separate from timer IDs: clearTimeout() doesn't cancel
+  // an immediate, nor clearImmediate() a timer.
+  function clearImmediate(id) {
+    var k = id - immFirstId;
+    if (k < 0 || k >= immLength) return;
+    var i = (immHead + k) & (immFns.length - 1);
+    if (immFns[i] !== null) {
+      immFns[i] = null;
+      immArgs[i] = null;
+      immLive--;
+    }
+  }
+
+  // Minimal MessageChannel: postMessage() on one port delivers {data} to the
+  // onmessage handler of the other port as an immediate. This is all React's
+  // Scheduler needs when setImmediate() is unavailable to it.
+  function MessagePort() {
+    this.onmessage = null;
+    this.other = null;
+  }
+  MessagePort.prototype.postMessage = function (data) {
+    setImmediate(deliverMessage, this.other, data);
+  };
+  MessagePort.prototype.start = function () {};
+  MessagePort.prototype.close = function () {
+    this.onmessage = null;
+  };
+
+  function deliverMessage(port, data) {
+    if (typeof port.onmessage === 'function') port.onmessage({ data });
+  }
+
+  function MessageChannel() {
+    this.port1 = new MessagePort();
+    this.port2 = new MessagePort();
+    this.port1.other = this.port2;
+    this.port2.other = this.port1;
+  }
+
+  // Web Workers. A Worker runs a worker unit (add_react_imgui_app(WORKERS
+  // ...)), or a .hbc or .js file, on its own Hermes runtime and thread. Its
+  // jslib has an event loop of its own. There is no shared heap, so messages
+  // are copied as JSON: functions, Maps and Sets don't survive the trip.
+  // ArrayBuffers and typed arrays travel next to the JSON as native memory
+  // and are replaced in it by markers. The memory of a buffer from
+  // createSharedBuffer() is shared by every message that carries it; that of
+  // a buffer in the transfer list is moved when it is native (fs.promises
+  // results, received buffers) and copied once otherwise. Messages are
+  // delivered as immediates on both sides.
+  var transferredBuffers = new WeakSet();
+
+  function checkNotTransferred(buffer) {
+    if (transferredBuffers.has(buffer)) {
+      throw new Error('An ArrayBuffer in the message was already transferred');
+    }
+  }
+
+  // `transfer` is postMessage()'s second argument: an array of ArrayBuffers
+  // or { transfer: [...] }.
+  function encodeMessage(data, transfer) {
+    var list =
+      transfer && !Array.isArray(transfer) ? transfer.transfer : transfer;
+    var moved = [];
+    if (list) {
+      for (var i = 0; i < list.length; ++i) {
+        if (!(list[i] instanceof ArrayBuffer)) {
+          throw new TypeError('Only ArrayBuffers can be transferred');
+        }
+        checkNotTransferred(list[i]);
+        moved.push(list[i]);
+      }
+    }
+    var buffers = [];
+    function bufferIndex(buffer) {
+      checkNotTransferred(buffer);
+      var index = buffers.indexOf(buffer);
+      if (index < 0) index = buffers.push(buffer) - 1;
+      return index;
+    }
+    var text =
+      data === undefined
+        ? ''
+        : JSON.stringify(data, function (key, value) {
+            if (value instanceof ArrayBuffer) {
+              return { '\u0000b': bufferIndex(value) };
+            }
+            if (ArrayBuffer.isView(value)) {
+              return {
+                '\u0000v': bufferIndex(value.buffer),
+                t: value.constructor.name,
+                o: value.byteOffset,
+                n: value instanceof DataView ? value.byteLength : value.length,
+              };
+            }
+            return value;
+          });
+    var flags = buffers.map(function (buffer) {
+      return moved.indexOf(buffer) >= 0;
+    });
+    // The sender's view of a transferred buffer can't be detached; posting
+    // it again is refused instead.
+    moved.forEach(function (buffer) {
+      transferredBuffers.add(buffer);
+    });
+    return { text, buffers, transfer: flags };
+  }
+
+  function decodeMessage(text, buffers) {
+    if (text === '') return undefined;
+    return JSON.parse(text, function (key, value) {
+      if (value === null || typeof value !== 'object') return value;
+      if ('\u0000b' in value) return buffers[value['\u0000b']];
+      if ('\u0000v' in value) {
+        return new globalThis[value.t](
+          buffers[value['\u0000v']],
+          value.o,
+          value.n
+        );
+      }
+      return value;
+    });
+  }
+
+  // `options.maxHeap` caps the worker's heap, in bytes; by default it has
+  // the settings of the main runtime.
+  function Worker(name, options) {
+    if (typeof globalThis.__workerCreate !== 'function') {
+      throw new Error('Workers can only be started from the main runtime');
+    }
+    var maxHeap = options && options.maxHeap ? Number(options.maxHeap) : 0;
+    if (!(maxHeap >= 0)) {
+      throw new RangeError('Worker: maxHeap must be a number of bytes');
+    }
+    this.onmessage = null;
+    this.onerror = null;
+    var worker = this;
+    this.id = globalThis.__workerCreate(
+      String(name),
+      function (kind, text, buffers) {
+        setImmediate(deliverWorkerEvent, worker, kind, text, buffers);
+      },
+      maxHeap
+    );
+  }
+  Worker.prototype.postMessage = function (data, transfer) {
+    if (!this.id) return;
+    var message = encodeMessage(data, transfer);
+    globalThis.__workerPost(
+      this.id,
+      message.text,
+      message.buffers,
+      message.transfer
+    );
+  };
+  // Stops the worker once its current task returns; a task that never
+  // returns keeps its thread busy.
+  Worker.prototype.terminate = function () {
+    if (!this.id) return;
+    globalThis.__workerTerminate(this.id);
+    this.id = 0;
+  };
+
+  // `kind` is 'message', 'error' (the worker failed to load or threw while
+  // loading) or 'exit' (it called close()).
+  function deliverWorkerEvent(worker, kind, text, buffers) {
+    if (kind === 'message') {
+      if (worker.id && typeof worker.onmessage === 'function') {
+        worker.onmessage({ data: decodeMessage(text, buffers) });
+      }
+      return;
+    }
+    worker.id = 0;
+    if (kind === 'error') {
+      if (typeof worker.onerror === 'function') {
+        worker.onerror({ message: text });
+      } else {
+        reportError(new Error(text));
+      }
+    }
+  }
+
+  // Called by the host in a worker's runtime before the worker unit runs:
+  // `post(text, buffers, transfer)` sends a message to the Worker object,
+  // and `close()` ends the worker once the current task returns.
+  function workerScope(post, close) {
+    inWorker = true;
+    globalThis.self = globalThis;
+    globalThis.onmessage = null;
+    globalThis.postMessage = function (data, transfer) {
+      var message = encodeMessage(data, transfer);
+      post(message.text, message.buffers, message.transfer);
+    };
+    globalThis.close = close;
+  }
+
+  // A message from the Worker object, queued by a worker's host.
+  function queueMessage(text, buffers) {
+    setImmediate(deliverToScope, text, buffers);
+  }
+
+  function deliverToScope(text, buffers) {
+    if (typeof globalThis.onmessage === 'function') {
+      globalThis.onmessage({ data: decodeMessage(text, buffers) });
+    }
+  }
+
+  // Hermes has neither SharedArrayBuffer nor Atomics. createSharedBuffer()
+  // returns an ArrayBuffer whose memory the main runtime and the workers
+  // share when it is posted, and Atomics is implemented by host calls on the
+  // Int32Arrays and Uint32Arrays over it. Only workers may block in
+  // Atomics.wait(): the UI thread must keep rendering.
+  var inWorker = false;
+
+  function createSharedBuffer(size) {
+    return globalThis.__createSharedMemory(size);
+  }
+
+  function atomicView(ta, index) {
+    if (!(ta instanceof Int32Array) && !(ta instanceof Uint32Array)) {
+      throw new TypeError('Atomics only supports Int32Array and Uint32Array');
+    }
+    if (!Number.isInteger(index) || index < 0 || index >= ta.length) {
+      throw new RangeError('Atomics: index out of range');
+    }
+    return ta.byteOffset + index * 4;
+  }
+
+  function atomicOp(op) {
+    return function (ta, index, value, replacement) {
+      var result = globalThis.__atomics(
+        op,
+        ta.buffer,
+        atomicView(ta, index),
+        Number(value),
+        Number(replacement)
+      );
+      return ta instanceof Uint32Array ? result >>> 0 : result;
+    };
+  }
+
+  // The numbering of AtomicOp in SharedBuffer.h.
+  var AtomicsPolyfill = {
+    load: atomicOp(0),
+    store: atomicOp(1),
+    add: atomicOp(2),
+    sub: atomicOp(3),
+    and: atomicOp(4),
+    or: atomicOp(5),
+    xor: atomicOp(6),
+    exchange: atomicOp(7),
+    compareExchange: atomicOp(8),
+    wait: function (ta, index, value, timeout) {
+      if (!(ta instanceof Int32Array)) {
+        throw new TypeError('Atomics.wait only supports Int32Array');
+      }
+      if (!inWorker) {
+        throw new Error('Atomics.wait cannot be called on the UI thread');
+      }
+      var ms = timeout === undefined ? Infinity : Number(timeout);
+      return globalThis.__atomicsWait(
+        ta.buffer,
+        atomicView(ta, index),
+        Number(value),
+        ms === Infinity || isNaN(ms) ? -1 : Math.max(0, ms)
+      );
+    },
+    notify: function (ta, index, count) {
+      return globalThis.__atomicsNotify(
+        ta.buffer,
+        atomicView(ta, index),
+        count === undefined
+          ? Infinity
+          : Math.max(0, Math.trunc(Number(count)) || 0)
+      );
+    },
+  };
+
+  // Intervals shorter than 1ms would never leave the ready part of the heap.
+  function setInterval(fn, ms = 0, ...args) {
+    var period = Math.max(1, ms | 0);
+    return addTask(fn, period, period, false, args);
+  }
+
+  // Like setInterval(), but ticks missed while the event loop was busy (or
+  // the app was idle) are dropped instead of run back to back. The ticks
+  // still follow the original schedule.
+  function setCoalescedInterval(fn, ms = 0, ...args) {
+    var period = Math.max(1, ms | 0);
+    return addTask(fn, period, period, true, args);
+  }
+
+  function clearInterval(id) {
+    return clearTimeout(id);
+  }
+
+  // requestAnimationFrame polyfill that adapts to the host's tick rate.
+  // We batch callbacks and flush them on the next macro task, so the
+  // frequency naturally follows the platform refresh cadence (e.g., 60/90/120Hz)
+  // if the host drives the event loop once per frame.
+  //
+  // Callbacks live in two arrays that swap roles every frame: `rafPending`
+  // collects the callbacks of the next frame while `rafRunning` holds the
+  // ones being flushed. IDs are consecutive, so a callback's index is its ID
+  // minus the first ID of its generation, and cancelAnimationFrame() just
+  // replaces it with a null tombstone. Nothing is allocated per frame.
+  var rafPending = [];
+  var rafRunning = [];
+  var rafPendingFirstId = 1; // ID of rafPending[0]
+  var rafRunningFirstId = 1; // ID of rafRunning[0]
+  var rafPendingCount = 0; // Callbacks in rafPending that weren't cancelled
+  var rafNextId = 1;
+
+  // Report an exception thrown by a task or callback without letting it
+  // escape into the host.
+  function reportError(e) {
+    try {
+      if (
+        globalThis &&
+        globalThis.console &&
+        typeof globalThis.console.error === 'function'
+      ) {
+        globalThis.console.error(e);
+      } else if (typeof print === 'function') {
+        print('ERROR:', String(e && e.message ? e.message : e));
+      }
+    } catch (_) {}
+  }
+
+  // Run the queued requestAnimationFrame() callbacks, adding their number to
+  // perfMetrics.frameRafCallbacks. Returns true if callbacks were queued for
+  // the next frame meanwhile, so the host knows it has to keep rendering.
+  function flushRaf() {
+    // Swap the generations, so rAFs scheduled inside a callback run on the
+    // next tick (matching browser semantics).
+    var cbs = rafPending;
+    rafPending = rafRunning;
+    rafRunning = cbs;
+    rafRunningFirstId = rafPendingFirstId;
+    rafPendingFirstId = rafNextId;
+    rafPendingCount = 0;
+
+    // Like a browser, the microtasks of a callback run before the next one
+    // (unless the host's drain policy left out __drainMicrotasks())
+    var drain = globalThis.__drainMicrotasks;
+    var ts = curTime;
+    var ran = 0;
+    for (var i = 0; i < cbs.length; i++) {
+      var cb = cbs[i];
+      if (cb === null) continue;
+      cbs[i] = null;
+      ran++;
+      try {
+        cb(ts);
+      } catch (e) {
+        reportError(e);
+      }
+      if (drain) drain();
+    }
+    cbs.length = 0;
+    if (ran) {
+      if (!metrics) metrics = globalThis.__runtimeMetrics || null;
+      if (metrics) metrics[METRIC_FRAME_RAF_CALLBACKS] += ran;
+    }
+    rafRunningFirstId = rafNextId;
+    return rafPendingCount > 0;
+  }
+
+  function requestAnimationFrame(callback) {
+    rafPending.push(callback);
+    rafPendingCount++;
+    return rafNextId++;
+  }
+
+  function cancelAnimationFrame(id) {
+    // Callbacks of the generation being flushed can be cancelled too.
+    var i = id - rafPendingFirstId;
+    if (i >= 0 && i < rafPending.length) {
+      if (rafPending[i] !== null) {
+        rafPending[i] = null;
+        rafPendingCount--;
+      }
+      return;
+    }
+    i = id - rafRunningFirstId;
+    if (i >= 0 && i < rafRunning.length) rafRunning[i] = null;
+  }
+
+  // Watchers of the host's I/O reactor, keyed by file descriptor. The host
+  // polls the watched fds before running the frame's macrotasks and reports
+  // each ready one through queueIo(); its callback then runs as an
+  // immediate, ahead of the timers. The reactor is level-triggered, so a
+  // callback keeps being called while its fd stays ready.
+  var IO_READABLE = 1;
+  var IO_WRITABLE = 2;
+  var ioWatchers = {};
+
+  function ioWatch(fd, events, callback) {
+    if (!globalThis.__ioWatch(fd, events)) {
+      throw new Error('ioReactor.watch: cannot watch fd ' + fd);
+    }
+    var watcher = ioWatchers[fd];
+    if (watcher === undefined) {
+      ioWatchers[fd] = { fd, fn: callback, pending: 0 };
+    } else {
+      watcher.fn = callback;
+    }
+  }
+
+  function ioUnwatch(fd) {
+    if (ioWatchers[fd] === undefined) return;
+    delete ioWatchers[fd];
+    globalThis.__ioUnwatch(fd);
+  }
+
+  // Called by the host for every ready fd. A watcher whose callback is still
+  // queued (deferred by the frame budget) only accumulates the events.
+  function queueIo(fd, events) {
+    var watcher = ioWatchers[fd];
+    if (watcher === undefined) return;
+    if (watcher.pending) {
+      watcher.pending |= events;
+      return;
+    }
+    watcher.pending = events;
+    pushImmediate(runIoWatcher, [watcher]);
+  }
+
+  function runIoWatcher(watcher) {
+    var events = watcher.pending;
+    watcher.pending = 0;
+    // Skip watchers that were removed or replaced meanwhile.
+    if (ioWatchers[watcher.fd] === watcher) watcher.fn(watcher.fd, events);
+  }
+
+  // fs.promises subset. The host runs the file operations on its worker
+  // threads (__fsAsync()) and calls back on the JS thread, so the promises
+  // settle in the frame's macrotask phase. readFile() returns a Uint8Array
+  // over native memory (large files are memory mapped, not copied) or, with
+  // the 'utf8' encoding, a string.
+  var S_IFMT = 0o170000;
+  var S_IFREG = 0o100000;
+  var S_IFDIR = 0o040000;
+
+  function FsStats(raw) {
+    this.size = raw[0];
+    this.mode = raw[1];
+    this.mtimeMs = raw[2];
+    this.atimeMs = raw[3];
+    this.ctimeMs = raw[4];
+  }
+  FsStats.prototype.isFile = function () {
+    return (this.mode & S_IFMT) === S_IFREG;
+  };
+  FsStats.prototype.isDirectory = function () {
+    return (this.mode & S_IFMT) === S_IFDIR;
+  };
+
+  function fsRequest(op, path, utf8, wrap) {
+    return new Promise(function (resolve, reject) {
+      globalThis.__fsAsync(
+        op,
+        String(path),
+        utf8,
+        function (code, message, result) {
+          if (code !== null) {
+            var err = new Error(message);
+            err.code = code;
+            err.path = String(path);
+            reject(err);
+          } else {
+            resolve(wrap(result));
+          }
+        }
+      );
+    });
+  }
+
+  function fsIdentity(result) {
+    return result;
+  }
+  function fsBytes(result) {
+    return new Uint8Array(result);
+  }
+  function fsMakeStats(result) {
+    return new FsStats(result);
+  }
+
+  function fsReadFile(path, options) {
+    var encoding =
+      typeof options === 'string' ? options : options && options.encoding;
+    if (encoding === undefined || encoding === null) {
+      return fsRequest('readFile', path, false, fsBytes);
+    }
+    if (encoding === 'utf8' || encoding === 'utf-8') {
+      return fsRequest('readFile', path, true, fsIdentity);
+    }
+    return Promise.reject(
+      new Error('fs.promises.readFile: unsupported encoding ' + encoding)
+    );
+  }
+
+  function fsStat(path) {
+    return fsRequest('stat', path, false, fsMakeStats);
+  }
+
+  function fsReaddir(path) {
+    return fsRequest('readdir', path, false, fsIdentity);
+  }
+
+  // openFileStream(path, options) reads a file in chunks on the worker
+  // threads, so that a large file can be processed as it arrives instead of
+  // after it is all in memory. read() resolves to the next chunk, a
+  // Uint8Array over native memory (a slice of the mapped file for regular
+  // files), or to null at the end of the file; reads are queued, one chunk
+  // in flight at a time. options.chunkSize is the size of a chunk (1 MiB by
+  // default); with options.lines, a chunk ends after its last newline, so
+  // that it holds whole lines unless one is longer than chunkSize. The
+  // stream is also an async iterator, and close() stops it early.
+  function FileStream(path, options) {
+    if (typeof globalThis.__fsStreamOpen !== 'function') {
+      throw new Error('openFileStream is only available on the main runtime');
+    }
+    this.path = String(path);
+    // Where the next chunk starts in the file
+    this.position = 0;
+    this._id = globalThis.__fsStreamOpen(
+      this.path,
+      options && options.chunkSize !== undefined
+        ? Number(options.chunkSize)
+        : undefined,
+      !!(options && options.lines)
+    );
+    this._tail = Promise.resolve(null);
+  }
+
+  function fsStreamRead(stream) {
+    return new Promise(function (resolve, reject) {
+      if (stream._id === 0) {
+        resolve(null);
+        return;
+      }
+      globalThis.__fsStreamRead(
+        stream._id,
+        function (code, message, chunk, offset) {
+          if (code !== null) {
+            var err = new Error(message);
+            err.code = code;
+            err.path = stream.path;
+            stream.close();
+            reject(err);
+          } else if (chunk === null) {
+            stream.close();
+            resolve(null);
+          } else {
+            var bytes = new Uint8Array(chunk);
+            stream.position = offset + bytes.length;
+            resolve(bytes);
+          }
+        }
+      );
+    });
+  }
+
+  function fsIgnore() {}
+
+  FileStream.prototype.read = function () {
+    var self = this;
+    var next = this._tail.then(function () {
+      return fsStreamRead(self);
+    });
+    this._tail = next.then(fsIgnore, fsIgnore);
+    return next;
+  };
+  FileStream.prototype.close = function () {
+    if (this._id === 0) return;
+    globalThis.__fsStreamClose(this._id);
+    this._id = 0;
+  };
+  FileStream.prototype.next = function () {
+    return this.read().then(function (chunk) {
+      return chunk === null
+        ? { done: true, value: undefined }
+        : { done: false, value: chunk };
+    });
+  };
+  FileStream.prototype.return = function () {
+    this.close();
+    return Promise.resolve({ done: true, value: undefined });
+  };
+  if (typeof Symbol === 'function' && Symbol.asyncIterator) {
+    FileStream.prototype[Symbol.asyncIterator] = function () {
+      return this;
+    };
+  }
+
+  function openFileStream(path, options) {
+    return new FileStream(path, options);
+  }
+
+  // fs.watchTail(path) follows a growing file, such as a log. The host
+  // watches it with inotify or kqueue and indexes its new lines on the
+  // worker threads; nothing polls and nothing is read twice. onChange(fn)
+  // calls fn({ size, lines, added, error }) once per frame in which lines
+  // were indexed (lines drops when the file is truncated or replaced, error
+  // is set while it can't be read); getLines(start, count) returns lines
+  // as strings; <textview tail={tail}> draws it natively. close() stops it.
+  function FileTail(path) {
+    if (typeof globalThis.__tailOpen !== 'function') {
+      throw new Error('fs.watchTail is only available on the main runtime');
+    }
+    this.path = String(path);
+    this.size = 0;
+    this.lines = 0;
+    this.error = null;
+    this._listeners = [];
+    var self = this;
+    this.view = globalThis.__tailOpen(
+      this.path,
+      function (message, size, lines) {
+        var added = lines - self.lines;
+        self.size = size;
+        self.lines = lines;
+        self.error = message;
+        var change = { size: size, lines: lines, added: added, error: message };
+        var listeners = self._listeners.slice();
+        for (var i = 0; i < listeners.length; ++i) {
+          try {
+            listeners[i](change);
+          } catch (e) {
+            reportError(e);
+          }
+        }
+      }
+    );
+  }
+
+  // Calls fn with each change; returns a function removing it.
+  FileTail.prototype.onChange = function (fn) {
+    var listeners = this._listeners;
+    listeners.push(fn);
+    return function () {
+      var index = listeners.indexOf(fn);
+      if (index >= 0) listeners.splice(index, 1);
+    };
+  };
+
+  // Lines start to start + count (by default the rest, up to 100000) of
+  // what is indexed, without their line endings.
+  FileTail.prototype.getLines = function (start, count) {
+    if (this.view < 0) return [];
+    return globalThis.__tailLines(this.view, start || 0, count);
+  };
+
+  FileTail.prototype.close = function () {
+    if (this.view < 0) return;
+    globalThis.__tailClose(this.view);
+    this.view = -1;
+    this._listeners = [];
+  };
+
+  function fsWatchTail(path) {
+    return new FileTail(path);
+  }
+
+  // Dropped files. onFilesDropped(fn) calls fn(files) when files are
+  // dropped on the window (sappConfig.enable_dragndrop), in the next frame's
+  // macrotask phase. Each file has its `path` and `name`; read() resolves to
+  // its contents (fs.promises.readFile(), mapped for large files) and
+  // stream(options) is its openFileStream(). It returns a function that
+  // removes fn.
+  var dropListeners = [];
+
+  function DroppedFile(path) {
+    this.path = path;
+    this.name = path.slice(
+      Math.max(path.lastIndexOf('/'), path.lastIndexOf('\\')) + 1
+    );
+  }
+  DroppedFile.prototype.read = function () {
+    return fsReadFile(this.path);
+  };
+  DroppedFile.prototype.stream = function (options) {
+    return new FileStream(this.path, options);
+  };
+
+  function dispatchFilesDropped(paths) {
+    var files = [];
+    for (var i = 0; i < paths.length; ++i) {
+      files.push(new DroppedFile(paths[i]));
+    }
+    var listeners = dropListeners.slice();
+    for (var j = 0; j < listeners.length; ++j) {
+      try {
+        listeners[j](files);
+      } catch (e) {
+        reportError(e);
+      }
+    }
+  }
+
+  function onFilesDropped(fn) {
+    if (typeof globalThis.__onFilesDropped !== 'function') {
+      throw new Error('onFilesDropped is only available on the main runtime');
+    }
+    if (typeof fn !== 'function') {
+      throw new TypeError('onFilesDropped expects a function');
+    }
+    if (dropListeners.length === 0) {
+      globalThis.__onFilesDropped(dispatchFilesDropped);
+    }
+    dropListeners.push(fn);
+    var removed = false;
+    return function () {
+      if (removed) return;
+      removed = true;
+      dropListeners.splice(dropListeners.indexOf(fn), 1);
+      if (dropListeners.length === 0) {
+        globalThis.__onFilesDropped(undefined);
+      }
+    };
+  }
+
+  // WebSocket over the host's I/O thread, which does the TLS, the upgrade
+  // and the framing. What it receives arrives in one __wsOnEvents() batch
+  // per frame for all the sockets: 5 values per event (WS_EVENT_FIELDS),
+  // the socket id, the kind, the data (a string, or an ArrayBuffer for
+  // binary messages), the close code and whether the close was clean.
+  // Kinds match EventKind in imgui-runtime's WebSocket.cpp.
+  var WS_EVENT_OPEN = 0;
+  var WS_EVENT_TEXT = 1;
+  var WS_EVENT_BINARY = 2;
+  var WS_EVENT_ERROR = 3;
+  var WS_EVENT_CLOSE = 4;
+  var WS_EVENT_FIELDS = 5;
+  var webSockets = new Map();
+
+  function utf8Length(text) {
+    var n = 0;
+    for (var i = 0; i < text.length; ++i) {
+      var c = text.charCodeAt(i);
+      if (c < 0x80) n += 1;
+      else if (c < 0x800) n += 2;
+      else if (c >= 0xd800 && c < 0xdc00 && i + 1 < text.length) {
+        n += 4;
+        ++i;
+      } else n += 3;
+    }
+    return n;
+  }
+
+  function WebSocket(url, protocols) {
+    if (typeof globalThis.__wsConnect !== 'function') {
+      throw new Error('WebSocket is only available on the main runtime');
+    }
+    if (protocols === undefined) protocols = [];
+    else if (!Array.isArray(protocols)) protocols = [protocols];
+    for (var i = 0; i < protocols.length; ++i) {
+      protocols[i] = String(protocols[i]);
+      if (!/^[!#$%&'*+\-.^_`|~0-9A-Za-z]+$/.test(protocols[i])) {
+        throw new SyntaxError("Invalid subprotocol '" + protocols[i] + "'");
+      }
+      if (protocols.indexOf(protocols[i]) !== i) {
+        throw new SyntaxError("Duplicate subprotocol '" + protocols[i] + "'");
+      }
+    }
+    if (webSockets.size === 0) {
+      globalThis.__wsOnEvents(dispatchWebSocketEvents);
+    }
+    this.url = String(url);
+    this.protocol = '';
+    this.extensions = '';
+    this.readyState = WebSocket.CONNECTING;
+    // Binary messages are always ArrayBuffers; there is no Blob
+    this.binaryType = 'arraybuffer';
+    this.onopen = null;
+    this.onmessage = null;
+    this.onerror = null;
+    this.onclose = null;
+    this._listeners = {};
+    this._id = globalThis.__wsConnect(this.url, protocols.join(', '));
+    webSockets.set(this._id, this);
+  }
+  WebSocket.CONNECTING = WebSocket.prototype.CONNECTING = 0;
+  WebSocket.OPEN = WebSocket.prototype.OPEN = 1;
+  WebSocket.CLOSING = WebSocket.prototype.CLOSING = 2;
+  WebSocket.CLOSED = WebSocket.prototype.CLOSED = 3;
+
+  // Bytes of the sent messages that are not written to the socket yet.
+  Object.defineProperty(WebSocket.prototype, 'bufferedAmount', {
+    get: function () {
+      return globalThis.__wsBufferedAmount(this._id);
+    },
+  });
+
+  // Queues a string as a text message, or an ArrayBuffer or a view as a
+  // binary one (copied for the I/O thread). Ignored once closing.
+  WebSocket.prototype.send = function (data) {
+    if (this.readyState === WebSocket.CONNECTING) {
+      throw new Error("WebSocket.send: the socket isn't open yet");
+    }
+    if (this.readyState !== WebSocket.OPEN) return;
+    if (data instanceof ArrayBuffer) {
+      globalThis.__wsSend(this._id, data);
+    } else if (ArrayBuffer.isView(data)) {
+      globalThis.__wsSend(
+        this._id,
+        data.buffer,
+        data.byteOffset,
+        data.byteLength
+      );
+    } else {
+      globalThis.__wsSend(this._id, String(data));
+    }
+  };
+
+  // Starts the close handshake, with an optional code (1000 or 3000-4999)
+  // and reason (up to 123 bytes of UTF-8).
+  WebSocket.prototype.close = function (code, reason) {
+    if (code !== undefined) {
+      code = Math.floor(+code);
+      if (code !== 1000 && !(code >= 3000 && code <= 4999)) {
+        throw new Error('WebSocket.close: invalid code ' + code);
+      }
+    }
+    reason = reason === undefined ? '' : String(reason);
+    if (utf8Length(reason) > 123) {
+      throw new SyntaxError('WebSocket.close: the reason is too long');
+    }
+    if (this.readyState >= WebSocket.CLOSING) return;
+    this.readyState = WebSocket.CLOSING;
+    globalThis.__wsClose(this._id, code === undefined ? 0 : code, reason);
+  };
+
+  // Decodes the binary messages into a record decoder on the I/O thread
+  // instead of firing message events; null fires them again.
+  WebSocket.prototype.decodeInto = function (decoder) {
+    globalThis.__wsDecodeInto(this._id, decoder ? decoder.id : 0);
+  };
+
+  WebSocket.prototype.addEventListener = function (type, fn) {
+    var list = this._listeners[type] || (this._listeners[type] = []);
+    if (typeof fn === 'function' && list.indexOf(fn) < 0) list.push(fn);
+  };
+  WebSocket.prototype.removeEventListener = function (type, fn) {
+    var list = this._listeners[type];
+    var index = list ? list.indexOf(fn) : -1;
+    if (index >= 0) list.splice(index, 1);
+  };
+
+  function fireWebSocketEvent(ws, event) {
+    event.target = ws;
+    var handler = ws['on' + event.type];
+    var listeners = (ws._listeners[event.type] || []).slice();
+    if (typeof handler === 'function') listeners.unshift(handler);
+    for (var i = 0; i < listeners.length; ++i) {
+      try {
+        listeners[i].call(ws, event);
+      } catch (e) {
+        reportError(e);
+      }
+    }
+  }
+
+  function dispatchWebSocketEvents(batch) {
+    for (var i = 0; i < batch.length; i += WS_EVENT_FIELDS) {
+      var ws = webSockets.get(batch[i]);
+      if (!ws) continue;
+      var data = batch[i + 2];
+      switch (batch[i + 1]) {
+        case WS_EVENT_OPEN:
+          // A close() before the open still waits for its close event
+          if (ws.readyState === WebSocket.CONNECTING) {
+            ws.readyState = WebSocket.OPEN;
+          }
+          ws.protocol = data;
+          fireWebSocketEvent(ws, { type: 'open' });
+          break;
+        case WS_EVENT_TEXT:
+        case WS_EVENT_BINARY:
+          fireWebSocketEvent(ws, { type: 'message', data: data });
+          break;
+        case WS_EVENT_ERROR:
+          fireWebSocketEvent(ws, { type: 'error', message: data });
+          break;
+        case WS_EVENT_CLOSE:
+          ws.readyState = WebSocket.CLOSED;
+          webSockets.delete(ws._id);
+          fireWebSocketEvent(ws, {
+            type: 'close',
+            code: batch[i + 3],
+            reason: data,
+            wasClean: batch[i + 4],
+          });
+          break;
+      }
+    }
+    if (webSockets.size === 0) globalThis.__wsOnEvents(undefined);
+  }
+
+  // fetch() over the host's HTTP/1.1 client, which runs the requests on
+  // the worker threads and keeps connections alive per origin. It resolves
+  // once the response head is in; the body stays on the socket until it is
+  // read, one operation at a time: response.body in chunks (Uint8Arrays over
+  // native memory), arrayBuffer() into one native buffer, text()/json(), or
+  // saveTo(path) straight into a file, without passing through JS. init
+  // takes method, headers, body (a string, an ArrayBuffer or a view),
+  // redirect ('follow', 'manual' or 'error') and timeout, the milliseconds a
+  // connect, read or write may take (FETCH_TIMEOUT by default, 0 for none).
+  var FETCH_TIMEOUT = 60000;
+
+  function Headers(init) {
+    // Lowercase name -> values
+    this._map = new Map();
+    if (init === undefined || init === null) return;
+    var self = this;
+    if (init instanceof Headers) {
+      init.forEach(function (value, name) {
+        self.append(name, value);
+      });
+    } else if (Array.isArray(init)) {
+      init.forEach(function (pair) {
+        self.append(pair[0], pair[1]);
+      });
+    } else {
+      Object.keys(init).forEach(function (name) {
+        self.append(name, init[name]);
+      });
+    }
+  }
+  function headerName(name) {
+    name = String(name);
+    if (!/^[!#$%&'*+\-.^_`|~0-9A-Za-z]+$/.test(name)) {
+      throw new TypeError("Invalid header name '" + name + "'");
+    }
+    return name.toLowerCase();
+  }
+  function headerValue(value) {
+    value = String(value).trim();
+    if (/[\r\n\0]/.test(value)) {
+      throw new TypeError("Invalid header value '" + value + "'");
+    }
+    return value;
+  }
+  Headers.prototype.append = function (name, value) {
+    var key = headerName(name);
+    var values = this._map.get(key);
+    if (values) values.push(headerValue(value));
+    else this._map.set(key, [headerValue(value)]);
+  };
+  Headers.prototype.set = function (name, value) {
+    this._map.set(headerName(name), [headerValue(value)]);
+  };
+  Headers.prototype.get = function (name) {
+    var values = this._map.get(headerName(name));
+    return values ? values.join(', ') : null;
+  };
+  Headers.prototype.has = function (name) {
+    return this._map.has(headerName(name));
+  };
+  Headers.prototype.delete = function (name) {
+    this._map.delete(headerName(name));
+  };
+  // Sorted by name, as in the browser.
+  Headers.prototype.entries = function () {
+    var self = this;
+    return Array.from(this._map.keys())
+      .sort()
+      .map(function (name) {
+        return [name, self.get(name)];
+      })
+      [Symbol.iterator]();
+  };
+  Headers.prototype.keys = function () {
+    return Array.from(this._map.keys()).sort()[Symbol.iterator]();
+  };
+  Headers.prototype.values = function () {
+    return Array.from(this.entries(), function (entry) {
+      return entry[1];
+    })[Symbol.iterator]();
+  };
+  Headers.prototype.forEach = function (fn, thisArg) {
+    for (var entry of this.entries()) fn.call(thisArg, entry[1], entry[0], this);
+  };
+  Headers.prototype[Symbol.iterator] = Headers.prototype.entries;
+
+  function Response(id, status, statusText, url, redirected, pairs) {
+    this._id = id;
+    // Body operations run one after the other
+    this._tail = Promise.resolve();
+    this._body = null;
+    this.status = status;
+    this.statusText = statusText;
+    this.ok = status >= 200 && status < 300;
+    this.url = url;
+    this.redirected = redirected;
+    this.type = 'basic';
+    this.bodyUsed = false;
+    this.headers = new Headers();
+    for (var i = 0; i < pairs.length; i += 2) {
+      this.headers.append(pairs[i], pairs[i + 1]);
+    }
+  }
+
+  // Drops the native response; its connection is pooled if the body was
+  // read, closed otherwise.
+  function fetchClose(response) {
+    if (response._id === 0) return;
+    globalThis.__fetchClose(response._id);
+    response._id = 0;
+  }
+
+  // Queues start(callback), a native body operation calling
+  // callback(message, result), behind the response's earlier ones.
+  function fetchBodyOp(response, start) {
+    var next = response._tail.then(function () {
+      return new Promise(function (resolve, reject) {
+        if (response._id === 0) {
+          reject(new TypeError('The body was cancelled'));
+          return;
+        }
+        start(response._id, function (message, result) {
+          if (message !== null) {
+            fetchClose(response);
+            reject(new TypeError(message));
+          } else {
+            resolve(result);
+          }
+        });
+      });
+    });
+    response._tail = next.then(fsIgnore, fsIgnore);
+    return next;
+  }
+
+  // Marks the body used by a whole-body method, which then closes the
+  // response.
+  function fetchConsume(response, start) {
+    if (response.bodyUsed || (response._body && response._body.locked)) {
+      return Promise.reject(new TypeError('The body has already been used'));
     }
+    response.bodyUsed = true;
+    return fetchBodyOp(response, start).then(function (result) {
+      fetchClose(response);
+      return result;
+    });
   }
 
-  function setTimeout(fn, ms = 0, ...args) {
-    var id = nextTaskID++;
-    var task = { id, fn, deadline: curTime + Math.max(0, ms | 0), args };
-    // Insert the task in the sorted list.
-    var i = 0;
-    for (i = 0; i < tasks.length; ++i) {
-      if (tasks[i].deadline > task.deadline) {
-        break;
+  Response.prototype.arrayBuffer = function () {
+    return fetchConsume(this, function (id, callback) {
+      globalThis.__fetchReadAll(id, false, callback);
+    });
+  };
+  Response.prototype.bytes = function () {
+    return this.arrayBuffer().then(fsBytes);
+  };
+  Response.prototype.text = function () {
+    return fetchConsume(this, function (id, callback) {
+      globalThis.__fetchReadAll(id, true, callback);
+    });
+  };
+  Response.prototype.json = function () {
+    return this.text().then(JSON.parse);
+  };
+  // Writes the body to `path` on a worker (through a temporary file renamed
+  // at the end) and resolves to its size, e.g. for parseColumns(path).
+  Response.prototype.saveTo = function (path) {
+    return fetchConsume(this, function (id, callback) {
+      globalThis.__fetchSave(id, String(path), callback);
+    });
+  };
+  // The body as a stream: getReader().read() resolves to { done, value }
+  // with the next chunk, what arrived up to 64 KiB. It is also an async
+  // iterator, and cancel() closes the connection.
+  Object.defineProperty(Response.prototype, 'body', {
+    get: function () {
+      if (!this._body) this._body = new ReadableStream(this);
+      return this._body;
+    },
+  });
+
+  // The ReadableStream of a response body; only reading is supported.
+  function ReadableStream(response) {
+    this._response = response;
+    this.locked = false;
+  }
+  ReadableStream.prototype.getReader = function () {
+    if (this.locked) throw new TypeError('The stream is locked');
+    this.locked = true;
+    return new ReadableStreamReader(this);
+  };
+  ReadableStream.prototype.cancel = function () {
+    fetchClose(this._response);
+    return Promise.resolve();
+  };
+  if (typeof Symbol === 'function' && Symbol.asyncIterator) {
+    ReadableStream.prototype[Symbol.asyncIterator] = function () {
+      var reader = this.getReader();
+      return {
+        next: function () {
+          return reader.read();
+        },
+        return: function () {
+          return reader.cancel().then(function () {
+            return { done: true, value: undefined };
+          });
+        },
+      };
+    };
+  }
+
+  function ReadableStreamReader(stream) {
+    this._stream = stream;
+  }
+  ReadableStreamReader.prototype.read = function () {
+    var response = this._stream._response;
+    if (response.bodyUsed && response._id === 0) {
+      return Promise.resolve({ done: true, value: undefined });
+    }
+    response.bodyUsed = true;
+    return fetchBodyOp(response, function (id, callback) {
+      globalThis.__fetchRead(id, undefined, callback);
+    }).then(function (chunk) {
+      if (chunk === null) {
+        fetchClose(response);
+        return { done: true, value: undefined };
       }
+      return { done: false, value: new Uint8Array(chunk) };
+    });
+  };
+  ReadableStreamReader.prototype.cancel = function () {
+    return this._stream.cancel();
+  };
+  ReadableStreamReader.prototype.releaseLock = function () {
+    this._stream.locked = false;
+  };
+
+  function fetch(input, init) {
+    return new Promise(function (resolve, reject) {
+      if (typeof globalThis.__fetch !== 'function') {
+        throw new Error('fetch is only available on the main runtime');
+      }
+      init = init || {};
+      var url =
+        input !== null && typeof input === 'object' && 'url' in input
+          ? input.url
+          : input;
+      var method = String(init.method || 'GET').toUpperCase();
+      var headers = new Headers(init.headers);
+      var body = init.body;
+      if (body === null) body = undefined;
+      if (ArrayBuffer.isView(body)) {
+        body = body.buffer.slice(
+          body.byteOffset,
+          body.byteOffset + body.byteLength
+        );
+      } else if (body !== undefined && !(body instanceof ArrayBuffer)) {
+        body = String(body);
+        if (!headers.has('content-type')) {
+          headers.set('content-type', 'text/plain;charset=UTF-8');
+        }
+      }
+      if (body !== undefined && (method === 'GET' || method === 'HEAD')) {
+        throw new TypeError(method + " requests can't have a body");
+      }
+      var flat = [];
+      headers.forEach(function (value, name) {
+        flat.push(name, value);
+      });
+      globalThis.__fetch(
+        method,
+        String(url),
+        flat,
+        body,
+        init.redirect || 'follow',
+        init.timeout === undefined ? FETCH_TIMEOUT : Number(init.timeout),
+        function (message, id, status, statusText, finalUrl, redirected, pairs) {
+          if (message !== null) {
+            reject(new TypeError('fetch failed: ' + message));
+            return;
+          }
+          resolve(
+            new Response(id, status, statusText, finalUrl, redirected, pairs)
+          );
+        }
+      );
+    });
+  }
+
+  // A promise of a job on the host's worker threads, with a cancel() that
+  // cancels the job and rejects the promise. start(resolve, reject) starts
+  // the job and returns its __cancelTask() ID. A cancelled job doesn't start
+  // if it is still queued, and native code may check for it as it runs.
+  function cancellable(what, start) {
+    var id;
+    var rejectPromise;
+    var promise = new Promise(function (resolve, reject) {
+      rejectPromise = reject;
+      id = start(resolve, reject);
+    });
+    promise.cancel = function () {
+      if (id !== undefined) {
+        globalThis.__cancelTask(id);
+        id = undefined;
+      }
+      rejectPromise(new Error(what + ': cancelled'));
+    };
+    return promise;
+  }
+
+  // Native tasks. runNative(name, input, params, options) runs the kernel
+  // that the app registered as `name` (IMGUI_NATIVE_TASK()) on the host's
+  // worker threads, with a native copy of `input` (an ArrayBuffer or a view
+  // of one; the memory itself for shared buffers) and `params` as JSON.
+  // options.priority is 'interactive', 'normal' (the default) or
+  // 'background'. It resolves to { result, buffer } in a later frame's
+  // macrotask phase: the kernel's JSON result and its output buffer or, if
+  // it had none, the input as the kernel left it, as a view of the input's
+  // type. The promise has a cancel().
+  function runNative(name, input, params, options) {
+    return cancellable('runNative', function (resolve, reject) {
+      if (typeof globalThis.__runNative !== 'function') {
+        throw new Error('Native tasks can only run on the main runtime');
+      }
+      var view = ArrayBuffer.isView(input) ? input : null;
+      var buffer = view ? view.buffer : input;
+      if (buffer != null && !(buffer instanceof ArrayBuffer)) {
+        throw new TypeError('runNative: input must be an ArrayBuffer or a view');
+      }
+      return globalThis.__runNative(
+        String(name),
+        buffer == null ? null : buffer,
+        view ? view.byteOffset : 0,
+        buffer == null ? 0 : view ? view.byteLength : buffer.byteLength,
+        params === undefined ? '' : JSON.stringify(params),
+        function (message, result, output, inPlace) {
+          if (message !== null) {
+            reject(new Error(message));
+            return;
+          }
+          // A copy of the input keeps the offsets of the original
+          if (inPlace && view && output) {
+            var length =
+              view instanceof DataView ? view.byteLength : view.length;
+            output = new view.constructor(output, view.byteOffset, length);
+          }
+          resolve({
+            result: result === '' ? undefined : JSON.parse(result),
+            buffer: output,
+          });
+        },
+        options && options.priority
+      );
+    });
+  }
+
+  // Columnar parsing. parseColumns(source, options) parses CSV, a JSON
+  // array of flat objects or newline-delimited JSON (options.format 'csv',
+  // 'json' or 'ndjson') from a path or an ArrayBuffer on the host's worker
+  // threads, without creating a JS object per row. It resolves to
+  // { rows, columns }: per column a Float64Array, an Int32Array or a
+  // StringColumn, over native memory. options.columns ({ name: 'f64' |
+  // 'i32' | 'string' }) picks the columns and their types; by default all
+  // are kept, typed by their first value. CSV takes options.delimiter and
+  // options.header (false numbers the columns from '0').
+  function StringColumn(offsets, bytes) {
+    this.offsets = offsets;
+    this.bytes = bytes;
+    this.length = offsets.length - 1;
+  }
+  // The string of row `i`, decoded from UTF-8.
+  StringColumn.prototype.get = function (i) {
+    return decodeUtf8(this.bytes, this.offsets[i], this.offsets[i + 1]);
+  };
+
+  function decodeUtf8(bytes, start, end) {
+    var result = '';
+    var i = start;
+    while (i < end) {
+      var c = bytes[i++];
+      if (c >= 0x80) {
+        var extra = c >= 0xf0 ? 3 : c >= 0xe0 ? 2 : c >= 0xc0 ? 1 : 0;
+        c = extra ? c & (0x3f >> extra) : 0xfffd;
+        for (var k = 0; k < extra && i < end; ++k) {
+          c = (c << 6) | (bytes[i++] & 0x3f);
+        }
+      }
+      result += String.fromCodePoint(c);
     }
-    tasks.splice(i, 0, task);
-    return id;
+    return result;
   }
 
-  function clearTimeout(id) {
-    for (var i = 0; i < tasks.length; i++) {
-      if (tasks[i].id === id) {
-        tasks.splice(i, 1);
-        break;
+  function parseColumns(source, options) {
+    options = options || {};
+    return new Promise(function (resolve, reject) {
+      if (typeof globalThis.__parseColumns !== 'function') {
+        throw new Error('parseColumns is only available on the main runtime');
+      }
+      if (ArrayBuffer.isView(source)) {
+        source = source.buffer.slice(
+          source.byteOffset,
+          source.byteOffset + source.byteLength
+        );
+      }
+      var names = options.columns ? Object.keys(options.columns) : [];
+      globalThis.__parseColumns(
+        source instanceof ArrayBuffer ? source : String(source),
+        options.format || 'csv',
+        options.delimiter || ',',
+        options.header !== false,
+        names,
+        names.map(function (name) {
+          return options.columns[name];
+        }),
+        function (message, rows, columnNames, types, buffers) {
+          if (message !== null) {
+            reject(new Error(message));
+            return;
+          }
+          resolve({
+            rows: rows,
+            columns: columnsOf(columnNames, types, buffers),
+          });
+        }
+      );
+    });
+  }
+
+  // The columns over the native buffers of a parse or a decoder: one per
+  // 'f64' or 'i32' column, two (offsets and bytes) per 'string' one.
+  function columnsOf(names, types, buffers) {
+    var columns = {};
+    var next = 0;
+    for (var i = 0; i < names.length; ++i) {
+      var type = types[i];
+      if (type === 'string') {
+        columns[names[i]] = new StringColumn(
+          new Uint32Array(buffers[next]),
+          new Uint8Array(buffers[next + 1])
+        );
+        next += 2;
+      } else {
+        columns[names[i]] =
+          type === 'i32'
+            ? new Int32Array(buffers[next++])
+            : new Float64Array(buffers[next++]);
       }
     }
+    return columns;
   }
 
-  function setImmediate(fn, ...args) {
-    return setTimeout(fn, 0, ...args);
+  // Record decoding. createRecordDecoder(layout) decodes binary records
+  // into columns on the host's threads: layout.framing is 'fixed'
+  // (layout.recordSize bytes, by default the sum of the fields), 'u8',
+  // 'u16' or 'u32' (each record after its length) or 'msgpack' (a map by
+  // field name or an array by position), layout.littleEndian (default true)
+  // the byte order of the binary ones. layout.fields lists { name, type }:
+  // 'u8' to 'i64', 'f32', 'f64', 'string' ({ size } bytes cut at the first
+  // NUL, or with { lengthPrefix: 1 | 2 } after their length) or 'skip'
+  // ({ size } bytes). Integers up to 16 bits and 'i32' become Int32Array
+  // columns, the others Float64Array, strings StringColumns.
+  //
+  // feed(buffer) takes an ArrayBuffer or a view (copied) of a stream whose
+  // records may span feeds; feedFile(path) resolves to the number of
+  // records in a file; ws.decodeInto(decoder) decodes each binary message
+  // of a WebSocket on its I/O thread. The rows decoded meanwhile come once
+  // per frame to the onRows(fn) listeners as { rows, columns, errors }, new
+  // columns holding only the new rows, `errors` counting the records that
+  // didn't decode.
+  var DECODER_INT_TYPES = ['u8', 'i8', 'u16', 'i16', 'i32'];
+  var DECODER_WIDTHS = {
+    u8: 1, i8: 1, u16: 2, i16: 2, u32: 4, i32: 4, f32: 4, u64: 8, i64: 8,
+    f64: 8,
+  };
+
+  function RecordDecoder(layout) {
+    var framing = layout.framing || 'fixed';
+    var fields = layout.fields || [];
+    var names = [];
+    var types = [];
+    var sizes = [];
+    var recordSize = 0;
+    this._names = [];
+    this._types = [];
+    for (var i = 0; i < fields.length; ++i) {
+      var field = fields[i];
+      var type = String(field.type);
+      var size = field.size | 0;
+      if (type === 'string' && field.lengthPrefix) {
+        if (field.lengthPrefix !== 1 && field.lengthPrefix !== 2) {
+          throw new Error('createRecordDecoder: lengthPrefix must be 1 or 2');
+        }
+        type = 'string' + field.lengthPrefix * 8;
+      }
+      names.push(String(field.name));
+      types.push(type);
+      sizes.push(size);
+      recordSize += DECODER_WIDTHS[type] || size;
+      if (type !== 'skip') {
+        this._names.push(names[i]);
+        this._types.push(
+          type.indexOf('string') === 0
+            ? 'string'
+            : DECODER_INT_TYPES.indexOf(type) >= 0
+              ? 'i32'
+              : 'f64'
+        );
+      }
+    }
+    this._listeners = [];
+    var self = this;
+    this.id = globalThis.__decoderCreate(
+      framing,
+      layout.littleEndian !== false,
+      layout.recordSize === undefined ? recordSize : layout.recordSize,
+      names,
+      types,
+      sizes,
+      function (rows, buffers, errors) {
+        var batch = {
+          rows: rows,
+          columns: columnsOf(self._names, self._types, buffers),
+          errors: errors,
+        };
+        var listeners = self._listeners.slice();
+        for (var k = 0; k < listeners.length; ++k) {
+          try {
+            listeners[k](batch);
+          } catch (e) {
+            reportError(e);
+          }
+        }
+      }
+    );
   }
-  function clearImmediate(id) {
-    return clearTimeout(id);
+
+  // Calls fn with each batch of rows; returns a function removing it.
+  RecordDecoder.prototype.onRows = function (fn) {
+    var listeners = this._listeners;
+    listeners.push(fn);
+    return function () {
+      var index = listeners.indexOf(fn);
+      if (index >= 0) listeners.splice(index, 1);
+    };
+  };
+
+  RecordDecoder.prototype.feed = function (data) {
+    if (ArrayBuffer.isView(data)) {
+      globalThis.__decoderFeed(
+        this.id,
+        data.buffer,
+        data.byteOffset,
+        data.byteLength
+      );
+    } else {
+      globalThis.__decoderFeed(this.id, data);
+    }
+  };
+
+  RecordDecoder.prototype.feedFile = function (path) {
+    var id = this.id;
+    return new Promise(function (resolve, reject) {
+      globalThis.__decoderFeedFile(id, String(path), function (message, n) {
+        if (message !== null) reject(new Error(message));
+        else resolve(n);
+      });
+    });
+  };
+
+  // Stops decoding; input still queued and WebSockets decoding into it are
+  // ignored.
+  RecordDecoder.prototype.close = function () {
+    globalThis.__decoderClose(this.id);
+    this._listeners = [];
+  };
+
+  function createRecordDecoder(layout) {
+    if (typeof globalThis.__decoderCreate !== 'function') {
+      throw new Error(
+        'createRecordDecoder is only available on the main runtime'
+      );
+    }
+    return new RecordDecoder(layout || {});
   }
 
-  function setInterval(fn, ms = 0, ...args) {
-    var id = nextTaskID++;
-    intervals[id] = {
-      fn: fn,
-      ms: ms,
-      args: args,
-      timeoutId: null,
+  // Time series for live charts. createTimeSeries(options) keeps the newest
+  // options.capacity samples (default 65536) and, in options.buckets
+  // buckets per level (default 3600), the minimum, maximum and last value
+  // of every second, 10 seconds and minute, so memory is bounded however
+  // long it runs. Times are in milliseconds and only go forward.
+  // query(from, to, width) reduces [from, to) to `width` pixels from the
+  // finest source that covers it, as { min, max, last } Float32Arrays, in
+  // O(width); <plotlines series={s}> draws the same natively.
+  function TimeSeries(options) {
+    this.id = globalThis.__seriesCreate(
+      options.capacity === undefined ? 65536 : options.capacity,
+      options.buckets === undefined ? 3600 : options.buckets
+    );
+  }
+
+  TimeSeries.prototype.push = function (time, value) {
+    globalThis.__seriesPush(this.id, +time, +value);
+  };
+
+  // Adds times[i], values[i] for each i (arrays or typed arrays).
+  TimeSeries.prototype.pushMany = function (times, values) {
+    var t = times instanceof Float64Array ? times : new Float64Array(times);
+    var v = values instanceof Float32Array ? values : new Float32Array(values);
+    if (t.length !== v.length) {
+      throw new Error('TimeSeries.pushMany: as many times as values expected');
+    }
+    globalThis.__seriesPushMany(
+      this.id,
+      t.buffer,
+      t.byteOffset,
+      v.buffer,
+      v.byteOffset,
+      t.length
+    );
+  };
+
+  // Pixels without samples repeat the last value before them (NaN before
+  // the first sample).
+  TimeSeries.prototype.query = function (from, to, width) {
+    width = Math.max(1, Math.floor(width));
+    var min = new Float32Array(width);
+    var max = new Float32Array(width);
+    var last = new Float32Array(width);
+    globalThis.__seriesQuery(
+      this.id,
+      +from,
+      +to,
+      width,
+      min.buffer,
+      0,
+      max.buffer,
+      0,
+      last.buffer,
+      0
+    );
+    return { min: min, max: max, last: last };
+  };
+
+  // { oldest, newest, count } of the samples pushed so far, null before the
+  // first.
+  TimeSeries.prototype.range = function () {
+    var range = globalThis.__seriesRange(this.id);
+    return range === null
+      ? null
+      : { oldest: range[0], newest: range[1], count: range[2] };
+  };
+
+  TimeSeries.prototype.close = function () {
+    globalThis.__seriesClose(this.id);
+  };
+
+  function createTimeSeries(options) {
+    if (typeof globalThis.__seriesCreate !== 'function') {
+      throw new Error('createTimeSeries is only available on the main runtime');
+    }
+    return new TimeSeries(options || {});
+  }
+
+  // Type-to-filter over large string lists. createFilterIndex(strings)
+  // copies an array of strings or a StringColumn into a native index once;
+  // filter(query) returns an Int32Array of the indices of the strings
+  // containing `query`, ignoring ASCII case, for <combo indices>,
+  // <listbox indices> or a VirtualList. The scan is SIMD over all strings,
+  // and a query that extends the last one only rechecks its matches.
+  function FilterIndex(strings) {
+    if (strings instanceof StringColumn) {
+      this.id = globalThis.__filterCreate(
+        null,
+        strings.offsets.buffer,
+        strings.offsets.byteOffset,
+        strings.offsets.length,
+        strings.bytes.buffer,
+        strings.bytes.byteOffset,
+        strings.bytes.length
+      );
+    } else {
+      this.id = globalThis.__filterCreate(strings);
+    }
+    this.length = strings.length;
+  }
+
+  FilterIndex.prototype.filter = function (query) {
+    return new Int32Array(globalThis.__filterQuery(this.id, String(query)));
+  };
+
+  FilterIndex.prototype.close = function () {
+    globalThis.__filterClose(this.id);
+  };
+
+  function createFilterIndex(strings) {
+    if (typeof globalThis.__filterCreate !== 'function') {
+      throw new Error('createFilterIndex is only available on the main runtime');
+    }
+    return new FilterIndex(strings);
+  }
+
+  // Table operations over columns: Float64Array, Int32Array, Uint32Array
+  // and StringColumn (or arrays of numbers, copied). They run in parallel on
+  // the host's worker threads, reading parseColumns() and shared buffer
+  // columns in place, and resolve to Uint32Arrays of row indices:
+  //   sort(keys, indices): the rows ordered by keys, each a column or
+  //     { column, descending }, ties by row (a stable sort). NaNs sort last;
+  //     strings by their UTF-8 bytes.
+  //   resort(order, keys, changed): sort() again after the rows in changed
+  //     changed value (or were added), merging them into the previous order
+  //     instead of sorting every row.
+  //   filter(column, op, value, indices): the rows where the value compares
+  //     to value with op: '==', '!=', '<', '<=', '>', '>=', 'between' (value
+  //     is [low, high], inclusive) or, for strings, 'contains', 'startsWith'
+  //     and 'endsWith'.
+  //   groupBy(key, aggregates, indices): { groups, first, count, values }.
+  //     The groups of equal key values, in order of first appearance, with
+  //     the first row and the row count of each, and per aggregate
+  //     ({ op, column }, op 'count', 'sum', 'min', 'max' or 'mean') a
+  //     Float64Array of its value per group. NaNs are left out.
+  // indices, optional, limits an operation to those rows, in that order.
+  // The promises have a cancel().
+  function describeColumn(column) {
+    if (column instanceof StringColumn) {
+      return {
+        kind: 'string',
+        offsets: column.offsets.buffer,
+        offsetsOffset: column.offsets.byteOffset,
+        data: column.bytes.buffer,
+        offset: column.bytes.byteOffset,
+        bytes: column.bytes.byteLength,
+        rows: column.length,
+      };
+    }
+    if (Array.isArray(column)) {
+      column = new Float64Array(column);
+    }
+    var kind =
+      column instanceof Float64Array
+        ? 'f64'
+        : column instanceof Int32Array
+          ? 'i32'
+          : column instanceof Uint32Array
+            ? 'u32'
+            : null;
+    if (kind === null) {
+      throw new TypeError('tableOps: unsupported column type');
+    }
+    return {
+      kind: kind,
+      data: column.buffer,
+      offset: column.byteOffset,
+      rows: column.length,
     };
+  }
 
-    function repeat() {
-      // Check if interval was cleared
-      if (!intervals[id]) {
-        return;
-      }
+  function describeIndices(indices) {
+    if (indices === undefined || indices === null) {
+      return undefined;
+    }
+    return describeColumn(
+      indices instanceof Uint32Array ? indices : new Uint32Array(indices)
+    );
+  }
 
-      // Call the function
-      fn.apply(undefined, args);
+  function describeKeys(keys) {
+    if (!Array.isArray(keys)) {
+      keys = [keys];
+    }
+    return keys.map(function (key) {
+      return key && key.column !== undefined
+        ? { column: describeColumn(key.column), descending: !!key.descending }
+        : { column: describeColumn(key), descending: false };
+    });
+  }
 
-      // Schedule next execution
-      if (intervals[id]) {
-        intervals[id].timeoutId = setTimeout(repeat, ms);
+  function tableOp(op, describe) {
+    return cancellable('tableOps.' + op, function (resolve, reject) {
+      if (typeof globalThis.__tableOp !== 'function') {
+        throw new Error('tableOps is only available on the main runtime');
       }
+      return globalThis.__tableOp(op, describe(), function (message, result) {
+        if (message !== null) {
+          reject(new Error(message));
+        } else if (op !== 'groupBy') {
+          resolve(new Uint32Array(result));
+        } else {
+          resolve({
+            groups: result.first.byteLength / 4,
+            first: new Uint32Array(result.first),
+            count: new Uint32Array(result.count),
+            values: result.values.map(function (buffer) {
+              return new Float64Array(buffer);
+            }),
+          });
+        }
+      });
+    });
+  }
+
+  var tableOps = {
+    sort: function (keys, indices) {
+      return tableOp('sort', function () {
+        return { keys: describeKeys(keys), indices: describeIndices(indices) };
+      });
+    },
+    resort: function (order, keys, changed) {
+      return tableOp('resort', function () {
+        return {
+          keys: describeKeys(keys),
+          order: describeIndices(order),
+          changed: describeIndices(changed),
+        };
+      });
+    },
+    filter: function (column, op, value, indices) {
+      return tableOp('filter', function () {
+        var between = op === 'between';
+        return {
+          column: describeColumn(column),
+          op: op,
+          value: between ? value[0] : value,
+          value2: between ? value[1] : undefined,
+          indices: describeIndices(indices),
+        };
+      });
+    },
+    groupBy: function (key, aggregates, indices) {
+      return tableOp('groupBy', function () {
+        return {
+          key: describeColumn(key),
+          aggregates: (aggregates || []).map(function (agg) {
+            return {
+              op: agg.op,
+              column:
+                agg.column === undefined
+                  ? undefined
+                  : describeColumn(agg.column),
+            };
+          }),
+          indices: describeIndices(indices),
+        };
+      });
+    },
+  };
+
+  // Record rings. recordRing(name) returns the ring a native producer
+  // writes fixed-size records into (imgui_create_record_ring()), or null.
+  // The host publishes the records written since the last frame before the
+  // frame's macrotasks; drain(fn) calls fn(view, byteOffset) for each of
+  // them, in place in the ring's memory, and hands their slots back to the
+  // producer at the next frame. The header layout is RecordRing's.
+  var RING_RECORD_SIZE = 0;
+  var RING_CAPACITY = 1;
+  var RING_READ = 2;
+  var RING_END = 3;
+  var RING_DROPPED = 4;
+  var RING_HEADER_BYTES = 64;
+
+  function RecordRing(memory) {
+    this.header = new Uint32Array(memory, 0, RING_HEADER_BYTES / 4);
+    this.view = new DataView(memory);
+    this.recordSize = this.header[RING_RECORD_SIZE];
+    this.capacity = this.header[RING_CAPACITY];
+  }
+  // Records published and not drained yet.
+  RecordRing.prototype.available = function () {
+    return (this.header[RING_END] - this.header[RING_READ]) >>> 0;
+  };
+  // Records the producer dropped because the ring was full.
+  RecordRing.prototype.dropped = function () {
+    return this.header[RING_DROPPED];
+  };
+  // A record's bytes are only valid until the next frame; copy what must be
+  // kept.
+  RecordRing.prototype.drain = function (fn) {
+    var header = this.header;
+    var read = header[RING_READ];
+    var count = (header[RING_END] - read) >>> 0;
+    var mask = this.capacity - 1;
+    for (var i = 0; i < count; ++i) {
+      fn(
+        this.view,
+        RING_HEADER_BYTES + ((read + i) & mask) * this.recordSize
+      );
     }
+    header[RING_READ] = (read + count) >>> 0;
+    return count;
+  };
 
-    // Start the interval
-    intervals[id].timeoutId = setTimeout(repeat, ms);
-    return id;
+  var recordRings = Object.create(null);
+
+  function recordRing(name) {
+    name = String(name);
+    if (!recordRings[name]) {
+      var memory =
+        typeof globalThis.__recordRing === 'function'
+          ? globalThis.__recordRing(name)
+          : undefined;
+      if (memory === undefined) return null;
+      recordRings[name] = new RecordRing(memory);
+    }
+    return recordRings[name];
   }
 
-  function clearInterval(id) {
-    if (intervals[id]) {
-      if (intervals[id].timeoutId !== null) {
-        clearTimeout(intervals[id].timeoutId);
+  // Notifications. notify(name, count) signals the notifier `name`, from
+  // the main runtime or a worker; native threads use
+  // imgui_notifier(name).signal(). onNotify(name, fn) calls fn(count) on the
+  // main runtime once per batch: all the signals since the last call, in
+  // the next frame's macrotask phase, which they wake from an idle sleep
+  // (and schedule, in on-demand mode). It returns a function that removes
+  // the listener.
+  var notifyListeners = Object.create(null);
+
+  function notify(name, count) {
+    globalThis.__notify(String(name), count === undefined ? 1 : count);
+  }
+
+  function onNotify(name, fn) {
+    if (typeof globalThis.__onNotify !== 'function') {
+      throw new Error('onNotify is only available on the main runtime');
+    }
+    name = String(name);
+    var listeners = notifyListeners[name];
+    if (!listeners) {
+      listeners = notifyListeners[name] = [];
+      globalThis.__onNotify(name, function (count) {
+        var current = listeners.slice();
+        for (var i = 0; i < current.length; ++i) {
+          try {
+            current[i](count);
+          } catch (e) {
+            reportError(e);
+          }
+        }
+      });
+    }
+    listeners.push(fn);
+    return function () {
+      var index = listeners.indexOf(fn);
+      if (index < 0) return;
+      listeners.splice(index, 1);
+      if (listeners.length === 0 && notifyListeners[name] === listeners) {
+        delete notifyListeners[name];
+        globalThis.__onNotify(name, undefined);
       }
-      delete intervals[id];
+    };
+  }
+
+  // Hotkeys. registerHotkey(chord, fn, options) calls fn() when the chord
+  // ("Ctrl+S", "Mod+Shift+P", "F2"; Mod is Cmd on macOS and Ctrl
+  // elsewhere) is pressed, in the next frame's macrotask phase. The key
+  // events are matched natively, so the app doesn't look at every keystroke;
+  // the matched ones don't reach ImGui. options.repeat also fires on key
+  // repeat. It returns a function that removes the hotkey.
+  function registerHotkey(chord, fn, options) {
+    if (typeof globalThis.__hotkeyRegister !== 'function') {
+      throw new Error('registerHotkey is only available on the main runtime');
+    }
+    if (typeof fn !== 'function') {
+      throw new TypeError('registerHotkey expects a function');
     }
+    var id = globalThis.__hotkeyRegister(
+      String(chord),
+      function () {
+        try {
+          fn();
+        } catch (e) {
+          reportError(e);
+        }
+      },
+      !!(options && options.repeat)
+    );
+    return function () {
+      if (id === 0) return;
+      globalThis.__hotkeyUnregister(id);
+      id = 0;
+    };
   }
 
-  // requestAnimationFrame polyfill that adapts to the host's tick rate.
-  // We batch callbacks and flush them on the next macro task, so the
-  // frequency naturally follows the platform refresh cadence (e.g., 60/90/120Hz)
-  // if the host drives the event loop once per frame.
-  var rafQueue = {};
-  var rafNextId = 1;
+  // Window size. The host calls windowResized() before every frame whose
+  // window size (in framebuffer pixels, as on_frame() gets it) differs from
+  // the previous one's, so every frame of a drag of the window border.
+  // onWindowResize(fn, options) calls fn(width, height) at most once per
+  // options.throttleMs (100 by default): a change after a quiet interval
+  // right away, and otherwise the latest size once the interval is over, so
+  // that the final size of a drag always arrives. With options.settle, fn
+  // only gets the size once it has stopped changing for throttleMs, i.e. at
+  // the end of the drag. ImGui lays out the frames in between on its own.
+  // windowSize() returns the current { width, height }, 0 before the first
+  // frame. onWindowResize() returns a function that removes fn.
+  var windowWidth = 0;
+  var windowHeight = 0;
+  var resizeListeners = [];
 
-  function flushRaf() {
-    // Take a snapshot of callbacks and clear the queue so rAFs scheduled
-    // inside a callback run on the next tick (matching browser semantics).
-    var cbs = [];
-    for (var id in rafQueue) {
-      if (Object.prototype.hasOwnProperty.call(rafQueue, id)) {
-        cbs.push(rafQueue[id]);
-        delete rafQueue[id];
-      }
+  function windowResized(width, height) {
+    windowWidth = width;
+    windowHeight = height;
+    for (var i = 0; i < resizeListeners.length; ++i) {
+      scheduleResize(resizeListeners[i]);
     }
-    var ts = curTime;
-    for (var i = 0; i < cbs.length; i++) {
+  }
+
+  function scheduleResize(listener) {
+    if (listener.settle) {
+      if (listener.timer !== 0) clearTimeout(listener.timer);
+      listener.timer = setTimeout(deliverResize, listener.interval, listener);
+    } else if (listener.timer === 0) {
+      // A pending delivery picks up the latest size
+      listener.timer = setTimeout(
+        deliverResize,
+        listener.last + listener.interval - curTime,
+        listener
+      );
+    }
+  }
+
+  function deliverResize(listener) {
+    listener.timer = 0;
+    listener.last = curTime;
+    if (listener.width === windowWidth && listener.height === windowHeight) {
+      return;
+    }
+    listener.width = windowWidth;
+    listener.height = windowHeight;
+    try {
+      listener.fn(windowWidth, windowHeight);
+    } catch (e) {
+      reportError(e);
+    }
+  }
+
+  function windowSize() {
+    return { width: windowWidth, height: windowHeight };
+  }
+
+  function onWindowResize(fn, options) {
+    if (typeof fn !== 'function') {
+      throw new TypeError('onWindowResize expects a function');
+    }
+    var listener = {
+      fn: fn,
+      interval:
+        options && options.throttleMs !== undefined
+          ? Math.max(0, Number(options.throttleMs))
+          : 100,
+      settle: !!(options && options.settle),
+      timer: 0,
+      last: -Infinity,
+      // The size fn last got; the current one counts as delivered
+      width: windowWidth,
+      height: windowHeight,
+    };
+    resizeListeners.push(listener);
+    return function () {
+      var index = resizeListeners.indexOf(listener);
+      if (index < 0) return;
+      resizeListeners.splice(index, 1);
+      if (listener.timer !== 0) clearTimeout(listener.timer);
+      listener.timer = 0;
+    };
+  }
+
+  // Hot reload. A mode 2 app with sappConfig.hot_reload evaluates its bundle
+  // again in the same runtime when the file changes. This event loop, loaded
+  // images and ImGui's window state survive it, and so does whatever the old
+  // code left running. onHotReload(fn) registers fn to dispose of something
+  // (an interval, a listener, a socket) before the next reload; the handlers
+  // run once, newest first. The reconciler registers one that unmounts its
+  // roots.
+  var hotReloadHandlers = [];
+
+  function onHotReload(fn) {
+    if (typeof fn !== 'function') {
+      throw new TypeError('onHotReload expects a function');
+    }
+    hotReloadHandlers.push(fn);
+  }
+
+  // Called by the host right before it evaluates the bundle again.
+  function beforeHotReload() {
+    var handlers = hotReloadHandlers;
+    hotReloadHandlers = [];
+    for (var i = handlers.length - 1; i >= 0; --i) {
       try {
-        cbs[i](ts);
+        handlers[i]();
       } catch (e) {
-        try {
-          if (
-            globalThis &&
-            globalThis.console &&
-            typeof globalThis.console.error === 'function'
-          ) {
-            globalThis.console.error(e);
-          } else if (typeof print === 'function') {
-            print('ERROR:', String(e && e.message ? e.message : e));
-          }
-        } catch (_) {}
+        reportError(e);
       }
     }
   }
 
-  function requestAnimationFrame(callback) {
-    var id = rafNextId++;
-    rafQueue[id] = callback;
+  // App settings, kept with ImGui's window and table settings in the
+  // settings file of the runtime (sappConfig.settings, IMGUI_SETTINGS):
+  // appSettings.get(key) returns the value stored under `key`, or undefined;
+  // set(key, value) stores a JSON-serializable value, and remove(key) the
+  // entry. Changes are written with ImGui's, a few seconds later, and when
+  // the app exits. Without a settings file, they last until then.
+  function checkSettings() {
+    if (typeof globalThis.__settingsGet !== 'function') {
+      throw new Error('appSettings is only available on the main runtime');
+    }
+  }
+
+  var appSettings = {
+    get: function (key) {
+      checkSettings();
+      var json = globalThis.__settingsGet(String(key));
+      return json === undefined ? undefined : JSON.parse(json);
+    },
+    set: function (key, value) {
+      checkSettings();
+      var json = JSON.stringify(value);
+      if (json === undefined) {
+        throw new TypeError('appSettings.set: the value is not serializable');
+      }
+      globalThis.__settingsSet(String(key), json);
+    },
+    remove: function (key) {
+      checkSettings();
+      globalThis.__settingsSet(String(key));
+    },
+  };
+
+  // Images. loadImageAsync() decodes a file, or an image embedded with
+  // IMPORT_IMAGE, on the host's worker threads and uploads it at the start
+  // of a later frame. It resolves to the image handle in that frame's
+  // macrotask phase. Loading a path that is already loaded resolves to the
+  // same handle. Every load needs an unloadImage(), and the last one frees
+  // the texture. imagePlaceholder() is the handle of a 1x1 gray texture to
+  // draw until the image is ready. imageInfo() returns the size of an image
+  // and where to draw it from: its ImGui `texture` ID and UV rectangle
+  // (u0, v0, u1, v1), which is part of a shared page for the small images
+  // of sappConfig.image_atlas. With the `mipmaps` option the image gets a
+  // mip chain, made on the worker, and a trilinear sampler, for drawing it
+  // scaled down; it is cached apart from the same path without mipmaps.
+  function loadImageAsync(path, options) {
+    var mipmaps = !!(options && options.mipmaps);
+    return new Promise(function (resolve, reject) {
+      globalThis.__loadImageAsync(
+        String(path),
+        function (message, handle) {
+          if (message !== null) {
+            var err = new Error(message);
+            err.path = String(path);
+            reject(err);
+          } else {
+            resolve(handle);
+          }
+        },
+        mipmaps
+      );
+    });
+  }
+
+  function unloadImage(handle) {
+    globalThis.__unloadImage(handle);
+  }
+
+  function imageInfo(handle) {
+    return globalThis.__imageInfo(handle);
+  }
+
+  function imagePlaceholder() {
+    return globalThis.__imagePlaceholder();
+  }
+
+  // Screenshots. captureFrame() captures the next frame drawn, as options
+  // .format 'png' (default) or 'qoi', which encodes several times faster.
+  // With options.path it writes the file and resolves to { width, height };
+  // without, to { width, height, bytes } with the encoded ArrayBuffer. The
+  // GPU copies the frame into a buffer that is read a few frames later, and
+  // the encoding runs on the host's worker threads, so periodic captures
+  // don't slow the frames down.
+  function captureFrame(options) {
+    options = options || {};
+    return new Promise(function (resolve, reject) {
+      if (typeof globalThis.__captureFrame !== 'function') {
+        throw new Error('captureFrame is only available on the main runtime');
+      }
+      var path = options.path != null ? String(options.path) : null;
+      globalThis.__captureFrame(
+        path,
+        options.format || 'png',
+        function (message, bytes, width, height) {
+          if (message !== null) {
+            reject(new Error(message));
+          } else if (path !== null) {
+            resolve({ width: width, height: height });
+          } else {
+            resolve({ width: width, height: height, bytes: bytes });
+          }
+        }
+      );
+    });
+  }
+
+  // Audio. audio.load() decodes a sound file (WAV, MP3, FLAC or Ogg Vorbis)
+  // into memory on the host's worker threads and resolves to its handle; the
+  // first load opens the output device. play(), stopAll() and setVolume()
+  // only queue a command for the audio thread, which applies it at the start
+  // of the next buffer it mixes, so they never wait for the mixer. They
+  // return false if the command was dropped: no device, or the queue is
+  // full. Samples stay loaded until the app exits.
+  var audio = {
+    load: function (path) {
+      return new Promise(function (resolve, reject) {
+        globalThis.__audioLoad(String(path), function (message, handle) {
+          if (message !== null) {
+            var err = new Error(message);
+            err.path = String(path);
+            reject(err);
+          } else {
+            resolve(handle);
+          }
+        });
+      });
+    },
+    // `volume` is the gain (1 by default), `pan` -1 (left) to 1 (right).
+    play: function (handle, volume, pan) {
+      return globalThis.__audioPlay(
+        handle,
+        volume === undefined ? 1 : volume,
+        pan === undefined ? 0 : pan
+      );
+    },
+    stopAll: function () {
+      return globalThis.__audioStopAll();
+    },
+    // The gain of every sound, 1 by default.
+    setVolume: function (volume) {
+      return globalThis.__audioSetVolume(volume);
+    },
+  };
+
+  // A texture that JS rewrites every frame. `pixels` is a width * height * 4
+  // RGBA8 view of native memory. After filling it, update() queues it for
+  // upload at the start of the next frame and points `pixels` at the other
+  // buffer, so the next frame can be filled while this one uploads. Draw it
+  // through imageInfo(handle) like any image, and free it with
+  // unloadImage(handle).
+  function StreamTexture(width, height) {
+    var created = globalThis.__createStreamTexture(width, height);
+    this.handle = created.handle;
+    this.width = width;
+    this.height = height;
+    this._buffers = [
+      new Uint8Array(created.buffers[0]),
+      new Uint8Array(created.buffers[1]),
+    ];
+    this.pixels = this._buffers[0];
+  }
+
+  StreamTexture.prototype.update = function () {
+    this.pixels = this._buffers[globalThis.__updateStreamTexture(this.handle)];
+  };
+
+  function createStreamTexture(width, height) {
+    return new StreamTexture(width, height);
+  }
+
+  // requestIdleCallback() runs callbacks in the time left between the end of
+  // a frame and the next expected vsync; the host calls runIdle() with that
+  // time after submitting the frame. Callbacks queued by an idle callback run
+  // on a later frame. A callback whose `timeout` option expired runs even
+  // without slack, with didTimeout set.
+  var idleQueue = [];
+  var idleSpare = [];
+  var idleById = {}; // Map of IDs to queued idle callbacks
+  var idleNextId = 1;
+  var idleEnd = 0; // performance.now() time at which the idle period ends
+
+  // Passed to every idle callback; only valid during the call.
+  var idleDeadline = {
+    didTimeout: false,
+    timeRemaining: function () {
+      return Math.max(0, idleEnd - globalThis.performance.now());
+    },
+  };
+
+  function requestIdleCallback(callback, options) {
+    var id = idleNextId++;
+    var timeout = options && options.timeout > 0 ? options.timeout : -1;
+    var entry = {
+      id,
+      fn: callback,
+      timeoutAt: timeout >= 0 ? globalThis.performance.now() + timeout : -1,
+    };
+    idleById[id] = entry;
+    idleQueue.push(entry);
     return id;
   }
 
-  function cancelAnimationFrame(id) {
-    if (rafQueue[id]) {
-      delete rafQueue[id];
+  function cancelIdleCallback(id) {
+    var entry = idleById[id];
+    if (entry === undefined) return;
+    delete idleById[id];
+    entry.fn = null;
+  }
+
+  // Run idle callbacks for up to `remainingMs` milliseconds. Returns true if
+  // idle callbacks are still queued.
+  function runIdle(remainingMs) {
+    if (!idleQueue.length) return false;
+    var perf = globalThis.performance;
+    var drain = globalThis.__drainMicrotasks;
+    idleEnd = perf.now() + remainingMs;
+
+    var entries = idleQueue;
+    idleQueue = idleSpare;
+    var kept = 0; // Entries that wait for the next idle period
+    for (var i = 0; i < entries.length; i++) {
+      var entry = entries[i];
+      if (entry.fn === null) continue;
+      var now = perf.now();
+      var timedOut = entry.timeoutAt >= 0 && entry.timeoutAt <= now;
+      if (now >= idleEnd && !timedOut) {
+        entries[kept++] = entry;
+        continue;
+      }
+      delete idleById[entry.id];
+      idleDeadline.didTimeout = now >= idleEnd;
+      try {
+        entry.fn(idleDeadline);
+      } catch (e) {
+        reportError(e);
+      }
+      if (drain) drain();
+    }
+
+    // The entries that didn't run stay ahead of the ones queued meanwhile.
+    if (kept) {
+      for (var j = 0; j < idleQueue.length; j++) entries[kept++] = idleQueue[j];
+      entries.length = kept;
+      idleQueue.length = 0;
+      idleSpare = idleQueue;
+      idleQueue = entries;
+    } else {
+      entries.length = 0;
+      idleSpare = entries;
     }
+    return idleQueue.length > 0;
   }
 
   // Expose to global scope
@@ -151,10 +2933,57 @@
   globalThis.clearTimeout = clearTimeout;
   globalThis.setImmediate = setImmediate;
   globalThis.clearImmediate = clearImmediate;
+  if (typeof globalThis.MessageChannel === 'undefined') {
+    globalThis.MessageChannel = MessageChannel;
+  }
   globalThis.setInterval = setInterval;
+  globalThis.setCoalescedInterval = setCoalescedInterval;
   globalThis.clearInterval = clearInterval;
+  globalThis.Worker = Worker;
+  globalThis.WebSocket = WebSocket;
+  globalThis.fetch = fetch;
+  globalThis.Headers = Headers;
+  globalThis.createSharedBuffer = createSharedBuffer;
+  globalThis.runNative = runNative;
+  globalThis.recordRing = recordRing;
+  globalThis.notify = notify;
+  globalThis.onNotify = onNotify;
+  globalThis.registerHotkey = registerHotkey;
+  globalThis.onWindowResize = onWindowResize;
+  globalThis.windowSize = windowSize;
+  globalThis.onHotReload = onHotReload;
+  globalThis.onFilesDropped = onFilesDropped;
+  globalThis.openFileStream = openFileStream;
+  globalThis.appSettings = appSettings;
+  globalThis.parseColumns = parseColumns;
+  globalThis.createRecordDecoder = createRecordDecoder;
+  globalThis.createTimeSeries = createTimeSeries;
+  globalThis.createFilterIndex = createFilterIndex;
+  globalThis.tableOps = tableOps;
+  if (typeof globalThis.Atomics === 'undefined') {
+    globalThis.Atomics = AtomicsPolyfill;
+  }
   globalThis.requestAnimationFrame = requestAnimationFrame;
   globalThis.cancelAnimationFrame = cancelAnimationFrame;
+  globalThis.requestIdleCallback = requestIdleCallback;
+  globalThis.cancelIdleCallback = cancelIdleCallback;
+  globalThis.fs = {
+    promises: { readFile: fsReadFile, stat: fsStat, readdir: fsReaddir },
+    watchTail: fsWatchTail,
+  };
+  globalThis.loadImageAsync = loadImageAsync;
+  globalThis.unloadImage = unloadImage;
+  globalThis.audio = audio;
+  globalThis.imageInfo = imageInfo;
+  globalThis.imagePlaceholder = imagePlaceholder;
+  globalThis.captureFrame = captureFrame;
+  globalThis.createStreamTexture = createStreamTexture;
+  globalThis.ioReactor = {
+    READABLE: IO_READABLE,
+    WRITABLE: IO_WRITABLE,
+    watch: ioWatch,
+    unwatch: ioUnwatch,
+  };
 
   // Polyfills needed by React
   // NODE_ENV will be set from C++ based on build configuration
@@ -218,6 +3047,31 @@
     },
   };
 
+  // Replace Math.random() with a generator seeded with `seed` (mulberry32),
+  // so that benchmark runs (--seed=N) draw the same numbers every time.
+  function seedRandom(seed) {
+    var state = seed >>> 0;
+    Math.random = function random() {
+      state = (state + 0x6d2b79f5) | 0;
+      var t = Math.imul(state ^ (state >>> 15), 1 | state);
+      t = (t + Math.imul(t ^ (t >>> 7), 61 | t)) ^ t;
+      return ((t ^ (t >>> 14)) >>> 0) / 4294967296;
+    };
+  }
+
   // Return helper functions for C++ to use
-  return { peek: peekMacroTask, run: runMacroTask, flushRaf };
+  return {
+    peek: peekMacroTask,
+    run: runMacroTask,
+    runReady,
+    flushRaf,
+    runIdle,
+    queueIo,
+    windowResized,
+    beforeHotReload,
+    symbolicateProfile,
+    workerScope,
+    queueMessage,
+    seedRandom,
+  };
 })();
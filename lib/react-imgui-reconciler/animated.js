@@ -0,0 +1,336 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+import { useEffect, useState } from 'react';
+
+/**
+ * Animated values driven natively, like React Native's `useNativeDriver`.
+ * An AnimatedValue passed as a numeric or color prop of `<rect>`,
+ * `<circle>` or `<text>` (`x={anim}`, `color={flash}`) is read by the typed
+ * renderer from a native slot every frame. Drivers (spring, decay, bounce)
+ * and timelines of tweens move the slots in the runtime before each frame's
+ * on_frame(), and setValue() writes them directly; none of them runs JS per
+ * frame or causes a React render or commit.
+ *
+ *   const x = useAnimatedValue(0);
+ *   <circle x={x} y={50} radius={10} />
+ *   x.spring({ to: 300 }).then(({ finished }) => ...);
+ *
+ *   const flash = useAnimatedValue('#00000000');
+ *   <text color={flash}>{price}</text>
+ *   play(sequence(tween(flash, { to: '#40FF40', duration: 80 }),
+ *                 tween(flash, { to: '#FFFFFF', duration: 600 })));
+ *
+ * Only a new AnimatedValue object in a prop causes a commit; keep one per
+ * component (useAnimatedValue()) rather than creating it in render.
+ */
+
+// AnimDriver and AnimEasing in imgui-runtime's Animation.cpp
+const Driver = { SPRING: 2, DECAY: 3, BOUNCE: 4 };
+const Easing = { linear: 0, easeIn: 1, easeOut: 2, easeInOut: 3, easeOutBack: 4 };
+
+// Doubles per tween passed to __animPlay() (kTweenFields)
+const TWEEN_FIELDS = 7;
+
+// Running drivers with a promise, by slot, and running timelines by id
+const running = new Map();
+const timelines = new Map();
+
+let listening = false;
+
+function animation() {
+  if (typeof globalThis.__animCreate !== 'function') {
+    throw new Error('AnimatedValue needs the imgui runtime');
+  }
+  if (!listening) {
+    listening = true;
+    // kind 0: the driver of slot `id` ended; 1: timeline `id` ended
+    globalThis.__animOnFinished((kind, id, generation, finished) => {
+      if (kind === 0) {
+        const value = running.get(id);
+        if (value && value._generation === generation) value._settle(finished);
+      } else {
+        const timeline = timelines.get(id);
+        if (timeline) timeline._settle(finished);
+      }
+    });
+  }
+  return globalThis;
+}
+
+/**
+ * A color as a packed ABGR number, as the renderer draws it: '#RRGGBB',
+ * '#RRGGBBAA' or { r, g, b, a } with channels 0-255.
+ */
+function parseColor(color) {
+  let r = 255;
+  let g = 255;
+  let b = 255;
+  let a = 255;
+  if (typeof color === 'string' && /^#([0-9a-f]{6}|[0-9a-f]{8})$/i.test(color)) {
+    const v = parseInt(color.slice(1), 16);
+    if (color.length === 9) {
+      r = (v >>> 24) & 0xff;
+      g = (v >>> 16) & 0xff;
+      b = (v >>> 8) & 0xff;
+      a = v & 0xff;
+    } else {
+      r = (v >>> 16) & 0xff;
+      g = (v >>> 8) & 0xff;
+      b = v & 0xff;
+    }
+  } else if (color !== null && typeof color === 'object') {
+    const channel = (c, fallback) =>
+      c === undefined ? fallback : Math.max(0, Math.min(255, Math.floor(+c) || 0));
+    r = channel(color.r, 255);
+    g = channel(color.g, 255);
+    b = channel(color.b, 255);
+    a = channel(color.a, 255);
+  } else {
+    throw new Error(`Invalid color ${String(color)}`);
+  }
+  return ((a << 24) | (b << 16) | (g << 8) | r) >>> 0;
+}
+
+export class AnimatedValue {
+  /**
+   * A number, or a color ('#RRGGBB', '#RRGGBBAA', { r, g, b, a }) for a
+   * color prop, whose tweens then interpolate each channel.
+   */
+  constructor(value = 0) {
+    this.isColor = typeof value !== 'number';
+    // Read by the renderer, which allocates the slot if it is still -1
+    this.isAnimatedValue = true;
+    this.slot = -1;
+    this.initial = this._toNative(value);
+    this._generation = 0;
+    this._resolve = null;
+  }
+
+  _toNative(value) {
+    return this.isColor ? parseColor(value) : +value;
+  }
+
+  _ensureSlot() {
+    if (this.slot < 0) this.slot = animation().__animCreate(this.initial);
+    return this.slot;
+  }
+
+  /** Resolve the promise of the running driver, if any. */
+  _settle(finished) {
+    const resolve = this._resolve;
+    if (!resolve) return;
+    this._resolve = null;
+    running.delete(this.slot);
+    resolve({ finished });
+  }
+
+  _start(driver, to, param1, param2, velocity) {
+    if (this.isColor) throw new Error('Only tweens animate a color');
+    const slot = this._ensureSlot();
+    this._settle(false);
+    this._generation = animation().__animStart(slot, driver, to, param1, param2, velocity);
+    running.set(slot, this);
+    return new Promise((resolve) => {
+      this._resolve = resolve;
+    });
+  }
+
+  /** The current value, as last drawn or set; a packed ABGR color for colors. */
+  get value() {
+    return this.slot < 0 ? this.initial : animation().__animGet(this.slot);
+  }
+
+  /** The current velocity in units per second. */
+  get velocity() {
+    return this.slot < 0 ? 0 : animation().__animVelocity(this.slot);
+  }
+
+  /** Stop any animation and jump to `value`. */
+  setValue(value) {
+    const v = this._toNative(value);
+    if (this.slot < 0 && typeof globalThis.__animCreate !== 'function') {
+      this.initial = v;
+      return;
+    }
+    animation().__animSet(this._ensureSlot(), v);
+    this._settle(false);
+  }
+
+  /**
+   * Animate to `to` over `duration` ms, a timeline of one tween (see
+   * tween()). Resolves to `{ finished }`, false if it was stopped or
+   * replaced.
+   */
+  timing(options) {
+    return play(tween(this, options)).finished;
+  }
+
+  /**
+   * Spring to `to` (mass 1), starting at the current velocity unless
+   * `velocity` is given.
+   */
+  spring({ to, stiffness = 170, damping = 26, velocity }) {
+    const v = velocity === undefined ? this.velocity : +velocity;
+    return this._start(Driver.SPRING, +to, +stiffness, +damping, v);
+  }
+
+  /**
+   * Coast from `velocity` (units per second), slowing down by
+   * `deceleration` per ms, e.g. after a fling.
+   */
+  decay({ velocity, deceleration = 0.998 }) {
+    return this._start(Driver.DECAY, +velocity, +deceleration, 0, +velocity);
+  }
+
+  /**
+   * Move at `velocity` (units per second) forever, reflected at `min` and
+   * `max`. Runs until stopped.
+   */
+  bounce({ velocity, min, max }) {
+    return this._start(Driver.BOUNCE, 0, +min, +max, +velocity);
+  }
+
+  /** Stop the running driver or tween where it is. */
+  stop() {
+    if (this.slot < 0) return;
+    animation().__animStop(this.slot);
+    this._settle(false);
+  }
+
+  /**
+   * Free the slot. Nothing may render the value afterwards: the slot is
+   * reused by the next AnimatedValue.
+   */
+  release() {
+    if (this.slot < 0) return;
+    this._settle(false);
+    const native = animation();
+    this.initial = native.__animGet(this.slot);
+    native.__animRelease(this.slot);
+    this.slot = -1;
+  }
+}
+
+/**
+ * A tween of `value` to `to` over `duration` ms after `delay` ms, with an
+ * easing curve ('linear', 'easeIn', 'easeOut', 'easeInOut' or
+ * 'easeOutBack'), from `from` or else from wherever the value is when the
+ * tween starts. Colors take colors. Played by play(), alone or combined by
+ * sequence(), parallel() and stagger().
+ */
+export function tween(value, { to, from, duration = 300, delay = 0, easing = 'easeInOut' }) {
+  if (!(value instanceof AnimatedValue)) throw new Error('tween() animates an AnimatedValue');
+  const curve = Easing[easing];
+  if (curve === undefined) throw new Error(`Unknown easing '${easing}'`);
+  duration = Math.max(0, +duration);
+  delay = Math.max(0, +delay);
+  return {
+    tweens: [
+      {
+        value,
+        delay,
+        duration,
+        from: from === undefined ? NaN : value._toNative(from),
+        to: value._toNative(to),
+        easing: curve,
+      },
+    ],
+    duration: delay + duration,
+  };
+}
+
+function shift(part, delay) {
+  return part.tweens.map((t) => ({ ...t, delay: t.delay + delay }));
+}
+
+/** Play `parts` one after the other. */
+export function sequence(...parts) {
+  const tweens = [];
+  let at = 0;
+  for (const part of parts) {
+    tweens.push(...shift(part, at));
+    at += part.duration;
+  }
+  return { tweens, duration: at };
+}
+
+/** Play `parts` together; lasts as long as the longest. */
+export function parallel(...parts) {
+  return stagger(0, parts);
+}
+
+/**
+ * Play `parts` together, each starting `each` ms after the one before, e.g.
+ * one fade-in per row of a list.
+ */
+export function stagger(each, parts) {
+  const tweens = [];
+  let duration = 0;
+  parts.forEach((part, i) => {
+    tweens.push(...shift(part, i * each));
+    duration = Math.max(duration, i * each + part.duration);
+  });
+  return { tweens, duration };
+}
+
+class Timeline {
+  constructor(id) {
+    this.id = id;
+    this._resolve = null;
+    /** Resolves to `{ finished }`, false if it was stopped or a tween was replaced. */
+    this.finished = new Promise((resolve) => {
+      this._resolve = resolve;
+    });
+  }
+
+  _settle(finished) {
+    const resolve = this._resolve;
+    if (!resolve) return;
+    this._resolve = null;
+    timelines.delete(this.id);
+    resolve({ finished });
+  }
+
+  /** Stop the timeline, leaving its values where they are. */
+  stop() {
+    if (!this._resolve) return;
+    animation().__animStopTimeline(this.id);
+    this._settle(false);
+  }
+}
+
+/**
+ * Start a timeline built by tween(), sequence(), parallel() and stagger().
+ * The runtime moves its values every frame until the last tween ends; a
+ * tween takes its value over from any driver or earlier tween when it
+ * starts. Returns a handle with `finished` and stop().
+ */
+export function play(part) {
+  const records = new Float64Array(part.tweens.length * TWEEN_FIELDS);
+  part.tweens.forEach((t, i) => {
+    const o = i * TWEEN_FIELDS;
+    records[o] = t.value._ensureSlot();
+    records[o + 1] = t.delay;
+    records[o + 2] = t.duration;
+    records[o + 3] = t.from;
+    records[o + 4] = t.to;
+    records[o + 5] = t.easing;
+    records[o + 6] = t.value.isColor ? 1 : 0;
+  });
+  const timeline = new Timeline(animation().__animPlay(records.buffer));
+  timelines.set(timeline.id, timeline);
+  return timeline;
+}
+
+/**
+ * Hook: an AnimatedValue that lives as long as the component, starting at
+ * `initial` (a number or a color). Its slot is released on unmount,
+ * together with the elements that draw it.
+ */
+export function useAnimatedValue(initial = 0) {
+  const [value] = useState(() => new AnimatedValue(initial));
+  useEffect(() => () => value.release(), [value]);
+  return value;
+}
@@ -0,0 +1,309 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+import { useEffect, useMemo, useSyncExternalStore } from 'react';
+import { createSharedArray } from './shared-buffer.js';
+
+/**
+ * Observable column stores: tables of typed columns over shared native
+ * memory, versioned natively per column and per block of 1024 rows
+ * (imgui-runtime's ColumnStore.cpp). Components select a row range and
+ * some columns with useStoreSelector(); once per frame the runtime diffs
+ * the selections against the blocks written since and wakes only the
+ * components whose selection changed.
+ *
+ *   const quotes = createColumnStore({
+ *     capacity: 1_000_000,
+ *     columns: { price: 'f64', size: 'i32' },
+ *   });
+ *   quotes.append({ price: [101.5], size: [300] });
+ *   quotes.update('price', rows, prices); // scattered writes
+ *
+ *   function Visible({ first, count }) {
+ *     const { columns, rowCount } =
+ *       useStoreSelector(quotes, [first, first + count], ['price']);
+ *     return <datagrid ... />;
+ *   }
+ *
+ * The columns are createSharedArray() arrays of `capacity` elements, so
+ * they can be passed to <datagrid> or <plotlines> as they are. Write
+ * through the store (or call touch() after writing in place); writes that
+ * bypass it aren't seen by the selectors.
+ */
+
+const ARRAY_TYPES = {
+  f64: Float64Array,
+  f32: Float32Array,
+  i32: Int32Array,
+  u32: Uint32Array,
+};
+
+// Selections with subscribers, by native ID
+const selections = new Map();
+
+let listening = false;
+
+function stores() {
+  if (typeof globalThis.__storeCreate !== 'function') {
+    throw new Error('Column stores need the imgui runtime');
+  }
+  if (!listening) {
+    listening = true;
+    // Selection IDs and their new versions, in pairs
+    globalThis.__storeOnChanges((changes) => {
+      for (let i = 0; i < changes.length; i += 2) {
+        const selection = selections.get(changes[i]);
+        if (selection) selection._changed(changes[i + 1]);
+      }
+    });
+  }
+  return globalThis;
+}
+
+/** `values` as a typed array of `ArrayType`, copied only if it isn't one. */
+function typed(ArrayType, values) {
+  return values instanceof ArrayType ? values : new ArrayType(values);
+}
+
+export class ColumnStore {
+  /**
+   * options.capacity is the number of rows the columns hold; options.columns
+   * maps each column name to its type, 'f64', 'f32', 'i32' or 'u32'.
+   */
+  constructor({ capacity, columns }) {
+    this.capacity = Math.max(0, Math.floor(capacity));
+    this.names = Object.keys(columns);
+    this.columns = {};
+    this._types = [];
+    const handles = [];
+    for (const name of this.names) {
+      const ArrayType = ARRAY_TYPES[columns[name]];
+      if (!ArrayType) {
+        throw new Error(
+          `createColumnStore: unknown type '${columns[name]}' of column '${name}'`
+        );
+      }
+      const array = createSharedArray(ArrayType, this.capacity);
+      this.columns[name] = array;
+      this._types.push(ArrayType);
+      handles.push(array.nativeHandle);
+    }
+    this.id = stores().__storeCreate(
+      this.capacity,
+      handles,
+      this.names.map((name) => columns[name])
+    );
+  }
+
+  _column(name) {
+    const index = this.names.indexOf(name);
+    if (index < 0) throw new Error(`ColumnStore: no column '${name}'`);
+    return index;
+  }
+
+  /** The number of rows, which native producers may also change. */
+  get rowCount() {
+    return globalThis.__storeRowCount(this.id);
+  }
+
+  set rowCount(rows) {
+    globalThis.__storeSetRowCount(this.id, rows);
+  }
+
+  /**
+   * Append rows: `rows` maps every column to its values (arrays or typed
+   * arrays of the same length). Returns the index of the first.
+   */
+  append(rows) {
+    const buffers = [];
+    const offsets = [];
+    let count = -1;
+    this.names.forEach((name, i) => {
+      const values = typed(this._types[i], rows[name]);
+      if (count >= 0 && values.length !== count) {
+        throw new Error(
+          'ColumnStore.append: the columns have different lengths'
+        );
+      }
+      count = values.length;
+      buffers.push(values.buffer);
+      offsets.push(values.byteOffset);
+    });
+    return globalThis.__storeAppend(
+      this.id,
+      buffers,
+      offsets,
+      Math.max(count, 0)
+    );
+  }
+
+  /** Write `values` into rows `firstRow` onwards of column `name`. */
+  write(name, firstRow, values) {
+    const column = this._column(name);
+    const array = typed(this._types[column], values);
+    globalThis.__storeWrite(
+      this.id,
+      column,
+      firstRow,
+      array.buffer,
+      array.byteOffset,
+      array.length
+    );
+  }
+
+  /** Write values[i] into row rows[i] of column `name`. */
+  update(name, rows, values) {
+    const column = this._column(name);
+    const indices = typed(Uint32Array, rows);
+    const array = typed(this._types[column], values);
+    if (indices.length !== array.length) {
+      throw new Error('ColumnStore.update: as many rows as values expected');
+    }
+    globalThis.__storeUpdate(
+      this.id,
+      column,
+      indices.buffer,
+      indices.byteOffset,
+      array.buffer,
+      array.byteOffset,
+      array.length
+    );
+  }
+
+  /**
+   * Mark `count` rows from `firstRow` as changed after writing them in place
+   * through `columns`; `name` undefined marks every column.
+   */
+  touch(name, firstRow, count) {
+    const column = name === undefined ? -1 : this._column(name);
+    globalThis.__storeTouch(this.id, column, firstRow, count);
+  }
+
+  /** Drop the store's native versions and selections. */
+  close() {
+    globalThis.__storeClose(this.id);
+  }
+}
+
+/**
+ * Rows [start, end) of some columns, registered natively while something
+ * subscribes to it.
+ */
+class StoreSelection {
+  constructor(store, start, end, names) {
+    this.store = store;
+    this.start = Math.max(0, Math.floor(start));
+    this.end =
+      end === Infinity
+        ? store.capacity
+        : Math.min(store.capacity, Math.floor(end));
+    this.names = names || store.names;
+    this._columns = names ? names.map((name) => store._column(name)) : [];
+    this._listeners = new Set();
+    this._id = 0;
+    // Before anything subscribes, the store's version of the selection
+    this.version = this._select();
+    this._release();
+    this.subscribe = this.subscribe.bind(this);
+    this.getVersion = this.getVersion.bind(this);
+  }
+
+  _select() {
+    const g = stores();
+    this._id = g.__storeSelect(
+      this.store.id,
+      this.start,
+      Math.max(0, this.end - this.start),
+      this._columns
+    );
+    return g.__storeSelectionVersion(this._id);
+  }
+
+  _release() {
+    globalThis.__storeUnselect(this._id);
+    this._id = 0;
+  }
+
+  _changed(version) {
+    this.version = version;
+    for (const listener of [...this._listeners]) listener();
+  }
+
+  subscribe(listener) {
+    if (this._listeners.size === 0) {
+      // Writes since the render are caught by the version check of
+      // useSyncExternalStore() after subscribing
+      this.version = this._select();
+      selections.set(this._id, this);
+    }
+    this._listeners.add(listener);
+    return () => {
+      this._listeners.delete(listener);
+      if (this._listeners.size === 0) {
+        selections.delete(this._id);
+        this._release();
+      }
+    };
+  }
+
+  getVersion() {
+    return this.version;
+  }
+
+  /** The selected rows of each column, as views of the store's arrays. */
+  snapshot() {
+    const rowCount = this.store.rowCount;
+    const end = Math.min(this.end, rowCount);
+    const columns = {};
+    for (const name of this.names) {
+      columns[name] = this.store.columns[name].subarray(
+        Math.min(this.start, end),
+        end
+      );
+    }
+    const { version, start } = this;
+    return { version, rowCount, start, end, columns };
+  }
+}
+
+/** Create a store; see ColumnStore. */
+export function createColumnStore(options) {
+  return new ColumnStore(options);
+}
+
+/**
+ * Hook: rows [start, end) of columns `names` of `store` (all of them by
+ * default; `range` null selects every row), as
+ * `{ version, rowCount, start, end, columns }` with a subarray per column,
+ * clipped to the rows there are. The component re-renders only when a
+ * write, an append or a row count change touches the selected rows of
+ * these columns. Scrolling passes a new range, which selects again.
+ */
+export function useStoreSelector(store, range, names) {
+  const start = range ? range[0] : 0;
+  const end = range ? range[1] : Infinity;
+  const key = names ? names.join('\0') : '';
+  const selection = useMemo(
+    () => new StoreSelection(store, start, end, names),
+    // names by content, so that an inline array doesn't select again
+    // eslint-disable-next-line react-hooks/exhaustive-deps
+    [store, start, end, key]
+  );
+  const version = useSyncExternalStore(
+    selection.subscribe,
+    selection.getVersion
+  );
+  return useMemo(() => selection.snapshot(), [selection, version]);
+}
+
+/**
+ * Hook: a store that lives as long as the component; see ColumnStore.
+ * `options` are only read on mount.
+ */
+export function useColumnStore(options) {
+  // eslint-disable-next-line react-hooks/exhaustive-deps
+  const store = useMemo(() => new ColumnStore(options), []);
+  useEffect(() => () => store.close(), [store]);
+  return store;
+}
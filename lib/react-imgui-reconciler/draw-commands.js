@@ -0,0 +1,67 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+/**
+ * Builder for the packed `commands` array of <canvas>.
+ *
+ * Each shape is one record of DRAW_RECORD_FIELDS numbers:
+ *   [op, color, a, b, c, d, e, f]
+ * The renderer copies the records into a native buffer when the prop changes
+ * and replays the whole buffer with one native call per frame, so a canvas
+ * can hold thousands of shapes. Coordinates are relative to the canvas
+ * origin. Colors are packed ABGR numbers (see rgba()) or anything accepted
+ * by the `color` prop of <rect>.
+ *
+ * A canvas only re-encodes its commands when the `commands` prop changes
+ * identity, so build a new DrawCommands whenever the scene changes.
+ */
+
+/**
+ * Draw operations. Must match DRAW_OP_* in lib/imgui-unit/draw_commands.c.
+ */
+export const DrawOp = Object.freeze({
+  RECT: 1,
+  CIRCLE: 2,
+  LINE: 3,
+});
+
+/** Number of array elements per record. */
+export const DRAW_RECORD_FIELDS = 8;
+
+/**
+ * Pack 8-bit color components into ABGR, the format used by ImGui draw lists.
+ */
+export function rgba(r, g, b, a = 255) {
+  return ((a << 24) | (b << 16) | (g << 8) | r) >>> 0;
+}
+
+export class DrawCommands {
+  constructor() {
+    this.data = []; // Flat record array, pass as <canvas commands={...}>
+  }
+
+  /** Add a rectangle with top-left corner (x, y). */
+  rect(x, y, width, height, color, filled = true, thickness = 1, rounding = 0) {
+    this.data.push(
+      DrawOp.RECT, color, x, y, x + width, y + height,
+      filled ? 0 : thickness, rounding
+    );
+    return this;
+  }
+
+  /** Add a circle centered at (x, y). */
+  circle(x, y, radius, color, filled = true, segments = 12, thickness = 1) {
+    this.data.push(
+      DrawOp.CIRCLE, color, x, y, radius, segments,
+      filled ? 0 : thickness, 0
+    );
+    return this;
+  }
+
+  /** Add a line from (x1, y1) to (x2, y2). */
+  line(x1, y1, x2, y2, color, thickness = 1) {
+    this.data.push(DrawOp.LINE, color, x1, y1, x2, y2, thickness, 0);
+    return this;
+  }
+}
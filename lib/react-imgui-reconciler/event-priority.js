@@ -0,0 +1,96 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+import {
+  NoEventPriority,
+  DiscreteEventPriority,
+  ContinuousEventPriority,
+  DefaultEventPriority,
+  IdleEventPriority,
+} from 'react-reconciler/constants';
+
+/**
+ * Event priorities for updates scheduled from ImGui callbacks.
+ *
+ * The typed imgui unit invokes widget callbacks through
+ * globalThis.imguiEvents.dispatch(), tagging each with an event kind. Updates
+ * scheduled while the callback runs get the matching React priority:
+ * clicks, edits and close buttons are discrete, window drags and resizes are
+ * continuous. Updates from timers or native data pushes get the default
+ * priority, or idle priority inside runIdleUpdates().
+ *
+ * Priorities only reorder work on a concurrent root; a legacy root renders
+ * every update synchronously.
+ */
+
+// Event kinds passed by the imgui unit (see EVENT_* in renderer.js)
+export const EventKind = {
+  DISCRETE: 0,
+  CONTINUOUS: 1,
+};
+
+const kindPriorities = [DiscreteEventPriority, ContinuousEventPriority];
+
+// Priority of the event being dispatched, DefaultEventPriority outside one
+let currentEventPriority = DefaultEventPriority;
+// Priority set by React through setCurrentUpdatePriority()
+let currentUpdatePriority = NoEventPriority;
+
+/**
+ * Run `fn` with `priority` as the current event priority and return its
+ * result.
+ */
+export function runWithEventPriority(priority, fn) {
+  const previous = currentEventPriority;
+  currentEventPriority = priority;
+  try {
+    return fn();
+  } finally {
+    currentEventPriority = previous;
+  }
+}
+
+/**
+ * Run `fn` so that the updates it schedules get idle priority. Intended for
+ * background data refreshes that should never delay user input.
+ */
+export function runIdleUpdates(fn) {
+  return runWithEventPriority(IdleEventPriority, fn);
+}
+
+export function getCurrentEventPriority() {
+  return currentEventPriority;
+}
+
+export function getCurrentUpdatePriority() {
+  return currentUpdatePriority;
+}
+
+export function setCurrentUpdatePriority(priority) {
+  currentUpdatePriority = priority;
+}
+
+/**
+ * Priority for a new update: the one React set explicitly (e.g. inside
+ * flushSync or startTransition), else the priority of the current event.
+ */
+export function resolveUpdatePriority() {
+  return currentUpdatePriority !== NoEventPriority
+    ? currentUpdatePriority
+    : currentEventPriority;
+}
+
+globalThis.imguiEvents = {
+  /**
+   * Invoke an ImGui widget callback with the priority of event `kind`.
+   * Exceptions propagate to the caller.
+   */
+  dispatch(kind, callback, args) {
+    const priority = kindPriorities[kind];
+    return runWithEventPriority(
+      priority !== undefined ? priority : DefaultEventPriority,
+      () => callback(...args)
+    );
+  },
+};
@@ -2,14 +2,189 @@
 // SPDX-License-Identifier: MIT
 // See LICENSE file for full license text
 
-import { TreeNode, TextNode } from './tree-node.js';
-import { updateReconciliationStats } from './perf-stats.js';
+import {
+  createTreeNode,
+  createTextNode,
+  recycleTreeNode,
+  treeOps,
+} from './tree-node.js';
+import { NodeTag } from './node-tags.js';
+import { leakTracking, trackCreated, trackDeleted } from './leak-check.js';
+import { PropKind, widgetProps } from './widget-props.js';
+import {
+  Mutation,
+  mutationCounts,
+  recordCommitMutations,
+  updateReconciliationStats,
+} from './perf-stats.js';
+import {
+  getCurrentEventPriority,
+  getCurrentUpdatePriority,
+  setCurrentUpdatePriority,
+  resolveUpdatePriority,
+} from './event-priority.js';
 
 // React host config loaded
 
+// Debug logging: every console.debug() call is written as a statement with
+// the `DEBUG:` label. Production bundles drop all `DEBUG:` statements at
+// build time (esbuild `dropLabels`), so the template strings and property
+// lookups that build the messages are not even evaluated.
+
 // Timing for reconciliation
 let reconciliationStartTime = 0;
 
+// Tree versioning: `treeVersion` counts the commits that changed the tree.
+// Every mutation during a commit stamps the affected node and all of its
+// ancestors with the version that commit will get (`node.version`), so a
+// consumer can tell whether a subtree changed since version N with a single
+// comparison. Root container changes only bump the counter.
+//
+// The mutations themselves (linking, dropping the cached render plans and
+// labels, stamping) go through `treeOps` (tree-node.js), which the imgui
+// unit replaces with native code.
+let treeVersion = 0;
+let treeChanged = false;
+
+/**
+ * Bits of the update payload computed by diffProps(): which kinds of props
+ * changed in an update.
+ */
+export const UpdateFlags = {
+  VALUES: 1, // A non-callback prop changed, or a callback was added/removed
+  CALLBACKS: 2, // A callback prop was replaced by another function
+  CHILDREN: 4, // The React `children` prop changed
+};
+
+// Number of keys of the `newProps` of the last diffProps() call, which the
+// caller stores as the node's `propCount`.
+let diffPropCount = 0;
+
+// Whether a callback replaced by another function is ignored by diffProps().
+let stableHandlers = false;
+
+/**
+ * Opt into stable event handlers: a callback prop replaced by another
+ * function (the inline `onClick={() => ...}` of every parent render) no
+ * longer counts as a change. The renderer reads callbacks from `node.props`
+ * when it invokes them, and commitUpdate() still replaces the props, so the
+ * latest closure is the one called; an update that only swapped handlers
+ * just isn't counted as a mutation. Adding or removing a callback is still
+ * a change.
+ */
+export function setStableHandlers(enabled) {
+  stableHandlers = !!enabled;
+}
+
+/**
+ * Compare two props objects and return the UpdateFlags bitmask of the
+ * changed keys (0 if none changed). Values are compared by identity.
+ *
+ * `oldCount` is the number of keys of `oldProps`, or -1 if unknown. The
+ * first loop counts the keys of `newProps` that `oldProps` also has; if
+ * that is all of `oldProps`, nothing was removed and `oldProps` isn't
+ * enumerated at all, so an update walks only one props object.
+ *
+ * `known` is the prop table of a generated widget (widget-props.js), or
+ * undefined. Its renderer reads only the listed props, and callbacks only
+ * when they fire, so other props are ignored and adding or removing a
+ * callback is a CALLBACKS change: neither drops the plan.
+ */
+function diffProps(oldProps, newProps, oldCount, known) {
+  diffPropCount = -1;
+  if (oldProps === newProps) {
+    diffPropCount = oldCount;
+    return 0;
+  }
+  if (!oldProps || !newProps) return UpdateFlags.VALUES;
+
+  let flags = 0;
+  let count = 0;
+  let shared = 0;
+  for (const key in newProps) {
+    count++;
+    const oldValue = oldProps[key];
+    const newValue = newProps[key];
+    const inOld = oldValue !== undefined || key in oldProps;
+    if (inOld) shared++;
+    if (oldValue === newValue && inOld) {
+      continue;
+    }
+    if (key === 'children') {
+      flags |= UpdateFlags.CHILDREN;
+    } else if (
+      typeof oldValue === 'function' &&
+      typeof newValue === 'function'
+    ) {
+      if (!stableHandlers) flags |= UpdateFlags.CALLBACKS;
+    } else if (known === undefined) {
+      flags |= UpdateFlags.VALUES;
+    } else {
+      flags |= knownPropChange(known, key);
+    }
+  }
+  diffPropCount = count;
+  if (shared !== oldCount) {
+    for (const key in oldProps) {
+      if (key in newProps) continue;
+      if (key === 'children') {
+        flags |= UpdateFlags.CHILDREN;
+      } else if (known === undefined) {
+        flags |= UpdateFlags.VALUES;
+      } else {
+        flags |= knownPropChange(known, key);
+      }
+    }
+  }
+  return flags;
+}
+
+/**
+ * The UpdateFlags bit of a changed prop of a generated widget.
+ */
+function knownPropChange(known, key) {
+  const kind = known[key];
+  if (kind === PropKind.PLAN) return UpdateFlags.VALUES;
+  if (kind === PropKind.EVENT) return UpdateFlags.CALLBACKS;
+  return 0;
+}
+
+/**
+ * Track a child added to the root container. The single-<root> invariant is
+ * checked here, once per insertion, rather than by the renderer every frame.
+ */
+function addRootChild(container, child) {
+  child.parent = null; // Root has no parent
+  if (child.tag === NodeTag.ROOT && ++container.rootCount > 1) {
+    console.error(
+      `Multiple <root> components detected (${container.rootCount}). Only one <root> component is allowed.`
+    );
+  }
+  treeChanged = true;
+}
+
+/**
+ * Track a child removed from the root container.
+ */
+function removeRootChild(container, child) {
+  child.parent = null;
+  if (child.tag === NodeTag.ROOT) {
+    container.rootCount--;
+  }
+  treeChanged = true;
+}
+
+/**
+ * Release the native resources (cached UTF-8 labels) held by a removed
+ * subtree. The imgui unit owns them, so this is a no-op until it is loaded.
+ */
+function releaseSubtree(node) {
+  const imguiUnit = globalThis.imguiUnit;
+  if (imguiUnit && imguiUnit.releaseNode) {
+    imguiUnit.releaseNode(node);
+  }
+}
+
 /**
  * Host Config for React Reconciler
  *
@@ -37,11 +212,15 @@ const hostConfig = {
    * @returns A new TreeNode instance
    */
   createInstance(type, props, rootContainer, hostContext, internalHandle) {
-    console.debug(
+    DEBUG: console.debug(
       `createInstance: ${type}`,
       props && props.title ? `title="${props.title}"` : ''
     );
-    return new TreeNode(type, props);
+    mutationCounts[Mutation.CREATE_INSTANCE]++;
+    const node = createTreeNode(type, props);
+    node.version = treeVersion + 1;
+    if (leakTracking) trackCreated(node);
+    return node;
   },
 
   /**
@@ -55,8 +234,12 @@ const hostConfig = {
    * @returns A new TextNode instance
    */
   createTextInstance(text, rootContainer, hostContext, internalHandle) {
-    console.debug(`createTextInstance: "${text}"`);
-    return new TextNode(text);
+    DEBUG: console.debug(`createTextInstance: "${text}"`);
+    mutationCounts[Mutation.CREATE_TEXT_INSTANCE]++;
+    const node = createTextNode(text);
+    node.version = treeVersion + 1;
+    if (leakTracking) trackCreated(node);
+    return node;
   },
 
   //
@@ -71,11 +254,11 @@ const hostConfig = {
    * @param child - The child TreeNode or TextNode
    */
   appendInitialChild(parent, child) {
-    console.debug(
+    DEBUG: console.debug(
       `appendInitialChild: ${parent.type} <- ${child.type || `"${child.text}"`}`
     );
-    parent.children.push(child);
-    child.parent = parent;
+    mutationCounts[Mutation.APPEND_CHILD]++;
+    treeOps.link(parent, child, null);
   },
 
   /**
@@ -86,11 +269,12 @@ const hostConfig = {
    * @param child - The child TreeNode or TextNode
    */
   appendChild(parent, child) {
-    console.debug(
+    DEBUG: console.debug(
       `appendChild: ${parent.type} <- ${child.type || `"${child.text}"`}`
     );
-    parent.children.push(child);
-    child.parent = parent;
+    mutationCounts[Mutation.APPEND_CHILD]++;
+    treeOps.insert(parent, child, null, treeVersion + 1);
+    treeChanged = true;
   },
 
   /**
@@ -101,12 +285,16 @@ const hostConfig = {
    * @param child - The root TreeNode
    */
   appendChildToContainer(container, child) {
-    console.debug(`appendChildToContainer: root <- ${child.type}`);
-    if (!container.rootChildren) {
-      container.rootChildren = [];
+    DEBUG: console.debug(`appendChildToContainer: root <- ${child.type}`);
+    mutationCounts[Mutation.APPEND_CHILD]++;
+    const index = container.rootChildren.indexOf(child);
+    if (index !== -1) {
+      // React moves an existing root child by appending it again
+      container.rootChildren.splice(index, 1);
+      removeRootChild(container, child);
     }
     container.rootChildren.push(child);
-    child.parent = null; // Root has no parent
+    addRootChild(container, child);
   },
 
   /**
@@ -117,14 +305,15 @@ const hostConfig = {
    * @param child - The child to remove
    */
   removeChild(parent, child) {
-    console.debug(
+    DEBUG: console.debug(
       `removeChild: ${parent.type} -> ${child.type || `"${child.text}"`}`
     );
-    const index = parent.children.indexOf(child);
-    if (index !== -1) {
-      parent.children.splice(index, 1);
-    }
-    child.parent = null;
+    mutationCounts[Mutation.REMOVE_CHILD]++;
+    treeOps.remove(parent, child, treeVersion + 1);
+    treeChanged = true;
+    releaseSubtree(child);
+    // React only detaches host components; a lone text child ends here
+    if (leakTracking && child.tag === NodeTag.TEXT_NODE) trackDeleted(child);
   },
 
   /**
@@ -135,19 +324,19 @@ const hostConfig = {
    * @param child - The child to remove
    */
   removeChildFromContainer(container, child) {
-    console.debug(`removeChildFromContainer: root -> ${child.type}`);
-    if (container.rootChildren) {
-      const index = container.rootChildren.indexOf(child);
-      if (index !== -1) {
-        container.rootChildren.splice(index, 1);
-      } else {
-        console.error(
-          `removeChildFromContainer: child not found in rootChildren!`,
-          { child: child.type }
-        );
-      }
+    DEBUG: console.debug(`removeChildFromContainer: root -> ${child.type}`);
+    mutationCounts[Mutation.REMOVE_CHILD]++;
+    const index = container.rootChildren.indexOf(child);
+    if (index !== -1) {
+      container.rootChildren.splice(index, 1);
+      removeRootChild(container, child);
+    } else {
+      console.error(
+        `removeChildFromContainer: child not found in rootChildren!`,
+        { child: child.type }
+      );
     }
-    child.parent = null;
+    releaseSubtree(child);
   },
 
   /**
@@ -159,11 +348,11 @@ const hostConfig = {
    * @param beforeChild - The child to insert before
    */
   insertBefore(parent, child, beforeChild) {
-    console.debug(
+    DEBUG: console.debug(
       `insertBefore: ${parent.type} <- ${child.type || `"${child.text}"`} before ${beforeChild.type || `"${beforeChild.text}"`}`
     );
-    const index = parent.children.indexOf(beforeChild);
-    if (index === -1) {
+    mutationCounts[Mutation.INSERT_BEFORE]++;
+    if (beforeChild.parent !== parent) {
       // This should never happen - it indicates a bug in React or our reconciler
       console.error(
         `insertBefore: beforeChild not found in parent! Appending instead.`,
@@ -173,11 +362,10 @@ const hostConfig = {
           beforeChild: beforeChild.type || beforeChild.text,
         }
       );
-      parent.children.push(child);
-    } else {
-      parent.children.splice(index, 0, child);
+      beforeChild = null;
     }
-    child.parent = parent;
+    treeOps.insert(parent, child, beforeChild, treeVersion + 1);
+    treeChanged = true;
   },
 
   /**
@@ -189,24 +377,29 @@ const hostConfig = {
    * @param beforeChild - The child to insert before
    */
   insertInContainerBefore(container, child, beforeChild) {
-    console.debug(
+    DEBUG: console.debug(
       `insertInContainerBefore: root <- ${child.type} before ${beforeChild.type}`
     );
-    if (!container.rootChildren) {
-      container.rootChildren = [];
+    mutationCounts[Mutation.INSERT_BEFORE]++;
+    const rootChildren = container.rootChildren;
+    const oldIndex = rootChildren.indexOf(child);
+    if (oldIndex !== -1) {
+      // React moves an existing root child by inserting it again
+      rootChildren.splice(oldIndex, 1);
+      removeRootChild(container, child);
     }
-    const index = container.rootChildren.indexOf(beforeChild);
+    const index = rootChildren.indexOf(beforeChild);
     if (index !== -1) {
-      container.rootChildren.splice(index, 0, child);
+      rootChildren.splice(index, 0, child);
     } else {
       // If beforeChild not found, append (should never happen - indicates a bug)
       console.error(
         `insertInContainerBefore: beforeChild not found in rootChildren! Appending instead.`,
         { beforeChild: beforeChild.type }
       );
-      container.rootChildren.push(child);
+      rootChildren.push(child);
     }
-    child.parent = null;
+    addRootChild(container, child);
   },
 
   //
@@ -215,20 +408,19 @@ const hostConfig = {
 
   /**
    * Prepare an update for a component.
-   * Called when props change. Returns an "update payload" that describes what changed.
-   * If this returns null, commitUpdate won't be called.
-   *
-   * For simplicity, we return true whenever props changed (indicating update needed).
+   * Returns the UpdateFlags bitmask describing what changed, or null if
+   * nothing did (in which case commitUpdate won't be called).
    *
-   * Note: This uses referential equality (===) for prop comparison, which means
-   * inline arrow functions will always trigger updates. To optimize, use useCallback
-   * or define handlers outside the render function.
+   * react-reconciler 0.33 no longer calls this and diffs in commitUpdate
+   * instead; it is kept for reconcilers that still use update payloads.
+   * A new closure for an existing callback is an update unless
+   * setStableHandlers() is on.
    *
    * @param instance - The TreeNode instance
    * @param type - The component type
    * @param oldProps - Previous props
    * @param newProps - New props
-   * @returns Update payload (we just return true) or null for no update
+   * @returns UpdateFlags bitmask or null for no update
    */
   prepareUpdate(
     instance,
@@ -238,39 +430,23 @@ const hostConfig = {
     rootContainer,
     hostContext
   ) {
-    // Only update if props actually changed
-    // Check if the props objects are different (shallow comparison)
-    if (oldProps === newProps) {
-      return null; // No update needed
-    }
-
-    // Handle null/undefined edge cases
-    if (!oldProps && !newProps) return null;
-    if (!oldProps || !newProps) return true;
-
-    // Get keys from both objects
-    const oldKeys = Object.keys(oldProps);
-    const newKeys = Object.keys(newProps);
-
-    // Quick check: different number of props
-    if (oldKeys.length !== newKeys.length) {
-      return true; // Different number of props
-    }
-
-    // Check if all keys in newProps exist in oldProps and have same values
-    for (const key of newKeys) {
-      if (!(key in oldProps) || oldProps[key] !== newProps[key]) {
-        return true; // Prop added, removed, or value changed
-      }
-    }
-
-    return null; // No changes detected
+    const flags = diffProps(
+      oldProps,
+      newProps,
+      instance.propCount,
+      widgetProps[type]
+    );
+    return flags !== 0 ? flags : null;
   },
 
   /**
    * Commit an update to a component.
-   * Called after prepareUpdate returns a non-null payload.
-   * This is where we actually apply the prop changes.
+   * Called when React has new props for an instance.
+   * The props are always replaced, but the render plan is only dropped when
+   * a value it may depend on changed: a new closure for an existing
+   * callback, or new React children elements (text changes arrive through
+   * commitTextUpdate), leave the plan intact. With setStableHandlers(), an
+   * update that only replaced callbacks isn't counted as a mutation.
    *
    * @param instance - The TreeNode instance
    * @param type - The component type
@@ -279,15 +455,30 @@ const hostConfig = {
    * @param internalHandle - React's internal fiber node
    */
   commitUpdate(instance, type, oldProps, newProps, internalHandle) {
-    console.debug(
+    DEBUG: console.debug(
       `commitUpdate: ${type}`,
       'oldProps.title:',
       oldProps && oldProps.title,
       'newProps.title:',
       newProps && newProps.title
     );
-    // Update the instance's props
-    instance.props = newProps;
+    const flags = diffProps(
+      oldProps,
+      newProps,
+      instance.propCount,
+      widgetProps[type]
+    );
+    if (flags !== 0 || !stableHandlers) {
+      mutationCounts[Mutation.COMMIT_UPDATE]++;
+    }
+    treeOps.updateProps(
+      instance,
+      newProps,
+      diffPropCount,
+      flags,
+      treeVersion + 1
+    );
+    if (flags & UpdateFlags.VALUES) treeChanged = true;
   },
 
   /**
@@ -299,8 +490,10 @@ const hostConfig = {
    * @param newText - New text
    */
   commitTextUpdate(textInstance, oldText, newText) {
-    console.debug(`commitTextUpdate: "${oldText}" -> "${newText}"`);
-    textInstance.text = newText;
+    DEBUG: console.debug(`commitTextUpdate: "${oldText}" -> "${newText}"`);
+    mutationCounts[Mutation.COMMIT_TEXT_UPDATE]++;
+    treeOps.updateText(textInstance, newText, treeVersion + 1);
+    treeChanged = true;
   },
 
   //
@@ -381,26 +574,47 @@ const hostConfig = {
    */
   prepareForCommit(containerInfo) {
     reconciliationStartTime = performance.now();
+    // Shows as the builtin "React commit" event in trace captures.
+    trace.begin('React commit');
     return null;
   },
 
   /**
    * Reset after commit phase.
    * Called after React commits changes. Can be used to restore state.
-   * This syncs our tree to globalThis so the ImGui renderer can access it.
+   * The renderer holds the container itself (in
+   * globalThis.imguiRootContainers), whose rootChildren array is updated in
+   * place, so nothing needs to be synced here besides the tree version.
    */
   resetAfterCommit(containerInfo) {
+    trace.end();
     // Measure reconciliation time
     if (reconciliationStartTime > 0) {
       const duration = performance.now() - reconciliationStartTime;
       // console.log(`Reconciliation took ${duration.toFixed(3)}ms`);
       updateReconciliationStats(duration);
+      recordCommitMutations(
+        duration,
+        containerInfo.commitCount === 0,
+        containerInfo.name
+      );
       reconciliationStartTime = 0;
     }
 
-    // Update global reference after every reconciliation
-    if (globalThis.reactApp) {
-      globalThis.reactApp.rootChildren = containerInfo.rootChildren || [];
+    // Versions are global, so the version of a root's last change can be
+    // compared with node versions and with the other roots.
+    containerInfo.commitCount++;
+    if (treeChanged) {
+      treeChanged = false;
+      treeVersion++;
+      containerInfo.treeVersion = treeVersion;
+      // imgui-runtime keeps a native copy for the C++ frame loop
+      if (globalThis.__setTreeVersion) {
+        globalThis.__setTreeVersion(treeVersion);
+      }
+    }
+    if (containerInfo.onCommit !== null) {
+      containerInfo.onCommit(containerInfo);
     }
   },
 
@@ -457,24 +671,17 @@ const hostConfig = {
   supportsHydration: false,
 
   //
-  // Methods we don't need (stubs)
+  // Update priorities (see event-priority.js)
   //
 
-  getCurrentEventPriority() {
-    return 16; // DefaultEventPriority constant from React
-  },
+  getCurrentEventPriority,
+  resolveUpdatePriority,
+  getCurrentUpdatePriority,
+  setCurrentUpdatePriority,
 
-  resolveUpdatePriority() {
-    return 16; // DefaultEventPriority
-  },
-
-  getCurrentUpdatePriority() {
-    return 0; // NoEventPriority - no specific priority
-  },
-
-  setCurrentUpdatePriority(priority) {
-    // No-op - we don't track priority
-  },
+  //
+  // Methods we don't need (stubs)
+  //
 
   resolveEventTimeStamp() {
     return Date.now();
@@ -504,13 +711,26 @@ const hostConfig = {
     return null;
   },
 
-  detachDeletedInstance() {
-    // No-op
+  /**
+   * Called for every host instance of a deleted subtree once React is done
+   * with it. Its native resources were already released by removeChild();
+   * the node goes back to the pool if pooling is enabled.
+   */
+  detachDeletedInstance(node) {
+    if (leakTracking) trackDeleted(node);
+    recycleTreeNode(node);
   },
 
   clearContainer(container) {
-    console.debug('clearContainer');
-    container.rootChildren = [];
+    DEBUG: console.debug('clearContainer');
+    for (const child of container.rootChildren) {
+      child.parent = null;
+      releaseSubtree(child);
+    }
+    // Cleared in place: the renderer keeps a reference to the array
+    container.rootChildren.length = 0;
+    container.rootCount = 0;
+    treeChanged = true;
   },
 
   trackSchedulerEvent() {
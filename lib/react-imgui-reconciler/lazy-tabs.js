@@ -0,0 +1,63 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+import React, { useCallback, useLayoutEffect, useRef, useState } from 'react';
+
+/**
+ * A <tabitem> whose children are mounted only while it is the active tab:
+ *
+ *   <tabbar id="workspace">
+ *     <LazyTabItem label="Orders">{() => <OrdersPanel />}</LazyTabItem>
+ *     <LazyTabItem label="Risk" keepMounted><RiskPanel /></LazyTabItem>
+ *   </tabbar>
+ *
+ * `children` may be a function, called only while the tab is active.
+ * Switching away unmounts the subtree, so a dormant tab costs nothing.
+ *
+ * With `keepMounted`, a tab keeps its subtree (and its React state) once it
+ * has been shown. The renderer still skips it while the tab is inactive,
+ * and the element from its last active render is reused, so a re-render of
+ * the tab doesn't reach it either; updates from inside it still apply.
+ *
+ * `onSelect(active)` is called after every change and `defaultSelected`
+ * selects the tab initially. `flags` and `onClose` go to the host element.
+ */
+export function LazyTabItem({
+  label,
+  defaultSelected = false,
+  keepMounted = false,
+  onSelect,
+  children,
+  ...rest
+}) {
+  const [active, setActive] = useState(!!defaultSelected);
+  // Controls the host only until ImGui has reported the first selection
+  const [selected, setSelected] = useState(defaultSelected ? true : undefined);
+  // The latest onSelect, so that the host's callback stays the same
+  const onSelectRef = useRef(onSelect);
+  useLayoutEffect(() => {
+    onSelectRef.current = onSelect;
+  });
+  // The content of the last active render, kept for keepMounted
+  const kept = useRef(null);
+
+  const onToggle = useCallback((next) => {
+    setActive(next);
+    setSelected(undefined);
+    if (onSelectRef.current) onSelectRef.current(next);
+  }, []);
+
+  let content = null;
+  if (active) {
+    content = typeof children === 'function' ? children() : children;
+    if (keepMounted) kept.current = content;
+  } else if (keepMounted) {
+    content = kept.current;
+  }
+  return React.createElement(
+    'tabitem',
+    { ...rest, label, selected, onSelect: onToggle },
+    content,
+  );
+}
@@ -0,0 +1,50 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+import React, { useCallback, useLayoutEffect, useRef, useState } from 'react';
+
+/**
+ * A <treenode> whose children are mounted only while it is open:
+ *
+ *   <LazyTreeNode label={venue.name}>
+ *     {() => venue.books.map((b) => <LazyTreeNode key={b.id} ... />)}
+ *   </LazyTreeNode>
+ *
+ * `children` may be a function, called only while the node is open, so a
+ * collapsed branch doesn't even create its elements. Closing a node
+ * unmounts its subtree; opening one mounts only its direct children. A tree
+ * of any size then costs React and the renderer only its visible branches.
+ *
+ * `onExpand(open)` is called after every toggle and `defaultOpen` is the
+ * initial state. `leaf` and `selected` go to the host element.
+ */
+export function LazyTreeNode({
+  label,
+  defaultOpen = false,
+  onExpand,
+  children,
+  ...rest
+}) {
+  const [open, setOpen] = useState(!!defaultOpen);
+  // The latest onExpand, so that the host's callback stays the same
+  const onExpandRef = useRef(onExpand);
+  useLayoutEffect(() => {
+    onExpandRef.current = onExpand;
+  });
+
+  const onToggle = useCallback((next) => {
+    setOpen(next);
+    if (onExpandRef.current) onExpandRef.current(next);
+  }, []);
+
+  let content = null;
+  if (open && !rest.leaf) {
+    content = typeof children === 'function' ? children() : children;
+  }
+  return React.createElement(
+    'treenode',
+    { ...rest, label, open, onExpand: onToggle },
+    content,
+  );
+}
@@ -0,0 +1,105 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+import React, { useEffect, useState } from 'react';
+import jsxRuntime from 'react/jsx-runtime';
+import compilerRuntime from 'react/compiler-runtime';
+import * as reconciler from './reconciler.js';
+
+/**
+ * Lazy units: parts of an app that are bundled and compiled separately
+ * (add_react_imgui_app(LAZY_UNITS <name>=<entry>)) and only evaluated the
+ * first time they are needed, e.g. rarely opened tool windows. Startup then
+ * only evaluates what the first screen needs.
+ *
+ * A lazy unit's entry module exports what the app needs from it:
+ *
+ *   // Inspector.jsx
+ *   export function Inspector() { ... }
+ *
+ *   // app.jsx
+ *   const unit = useLazyUnit('inspector');
+ *   return unit ? <unit.Inspector /> : <text>Loading...</text>;
+ *
+ * Lazy units use the main bundle's React and reconciler (the modules in
+ * SHARED_MODULES of scripts/bundle-react-unit.js), so they can't import any
+ * other module of react-imgui-reconciler. This module must be imported by
+ * the main bundle for them to load.
+ */
+
+globalThis.__lazyUnitShared = {
+  react: React,
+  'react/jsx-runtime': jsxRuntime,
+  'react/compiler-runtime': compilerRuntime,
+  'react-imgui-reconciler/reconciler.js': reconciler,
+};
+
+// Exports of the evaluated units, by name
+const loadedUnits = new Map();
+// Promises of the units that were asked for, by name
+const pendingUnits = new Map();
+
+// Called by the code that bundle-react-unit.js appends to every lazy unit
+globalThis.__lazyUnitLoaded = (name, exports) => {
+  loadedUnits.set(name, exports);
+};
+
+/**
+ * Exports of the lazy unit `name` if it has been evaluated, otherwise null.
+ */
+export function getLazyUnit(name) {
+  return loadedUnits.get(name) || null;
+}
+
+/**
+ * Load the lazy unit `name`. Returns a Promise of its exports. The unit is
+ * evaluated in a later macrotask rather than in the caller's render, and
+ * only once.
+ */
+export function lazyUnit(name) {
+  let pending = pendingUnits.get(name);
+  if (!pending) {
+    pending = new Promise((resolve, reject) => {
+      setTimeout(() => {
+        try {
+          if (!loadedUnits.has(name)) __loadLazyUnit(name);
+          if (!loadedUnits.has(name)) {
+            throw new Error(`lazy unit '${name}' didn't register its exports`);
+          }
+          resolve(loadedUnits.get(name));
+        } catch (e) {
+          pendingUnits.delete(name);
+          reject(e);
+        }
+      }, 0);
+    });
+    pendingUnits.set(name, pending);
+  }
+  return pending;
+}
+
+/**
+ * Hook: the exports of the lazy unit `name`, or null while it loads. The
+ * first component that uses it starts loading the unit.
+ */
+export function useLazyUnit(name) {
+  const [, setLoadCount] = useState(0);
+  const unit = getLazyUnit(name);
+
+  useEffect(() => {
+    if (unit) return undefined;
+    let mounted = true;
+    lazyUnit(name).then(
+      () => {
+        if (mounted) setLoadCount((n) => n + 1);
+      },
+      (e) => console.error(`Failed to load lazy unit '${name}':`, e),
+    );
+    return () => {
+      mounted = false;
+    };
+  }, [name, unit]);
+
+  return unit;
+}
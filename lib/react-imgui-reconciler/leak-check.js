@@ -0,0 +1,222 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// Leak tracking (opt-in, for debugging long-running sessions).
+//
+// While enabled, the host config reports every node it creates and every
+// node React deletes. leakCheckpoint() then compares, per node type:
+//
+// - `live`: nodes created and not deleted since tracking started;
+// - `inTree`: nodes reachable from the roots, and the native slots and
+//   store rows they hold;
+// - `retained`: deleted nodes that survive a full collection, i.e. that a
+//   closure, ref or cache still references, with their native slots.
+//
+// and the native slots that no node in the tree owns. Each checkpoint
+// reports the change since the previous one, so a count that keeps growing
+// between two checkpoints taken in the same UI state points at the leak.
+
+import { NodeTag } from './node-tags.js';
+import { isPooledNode } from './tree-node.js';
+
+export let leakTracking = false;
+
+const TEXT_TYPE = '#text';
+// Nodes created minus nodes deleted, by type
+let liveCounts = new Map();
+// Deleted nodes, held weakly: { ref, id, type }
+let deleted = [];
+// The report of the previous checkpoint
+let previous = null;
+
+/**
+ * Turn leak tracking on or off. Turning it on starts counting from zero, so
+ * nodes created before are not counted as live.
+ */
+export function setLeakTracking(enabled) {
+  leakTracking = !!enabled;
+  liveCounts = new Map();
+  deleted = [];
+  previous = null;
+}
+
+function typeOf(node) {
+  return node.tag === NodeTag.TEXT_NODE ? TEXT_TYPE : node.type;
+}
+
+function count(map, type, n) {
+  map.set(type, (map.get(type) || 0) + n);
+}
+
+/**
+ * Record a node created by the host config.
+ */
+export function trackCreated(node) {
+  count(liveCounts, typeOf(node), 1);
+}
+
+function trackDeletedNode(node) {
+  count(liveCounts, typeOf(node), -1);
+  if (typeof WeakRef === 'function') {
+    deleted.push({ ref: new WeakRef(node), id: node.id, type: typeOf(node) });
+  }
+}
+
+/**
+ * Record a node deleted by React, together with its text children: React
+ * only detaches host components, and their text goes with them.
+ */
+export function trackDeleted(node) {
+  if (node.tag !== NodeTag.TEXT_NODE) {
+    for (let c = node.firstChild; c; c = c.nextSibling) {
+      if (c.tag === NodeTag.TEXT_NODE) trackDeletedNode(c);
+    }
+  }
+  trackDeletedNode(node);
+}
+
+function slotsOf(node) {
+  return node.nativeSlots !== null ? node.nativeSlots.length : 0;
+}
+
+function entryFor(types, type) {
+  let entry = types[type];
+  if (entry === undefined) {
+    entry = types[type] = {
+      live: 0,
+      inTree: 0,
+      retained: 0,
+      treeSlots: 0,
+      retainedSlots: 0,
+      retainedStoreRows: 0,
+    };
+  }
+  return entry;
+}
+
+function walkTree(node, types, totals) {
+  const entry = entryFor(types, typeOf(node));
+  entry.inTree++;
+  entry.treeSlots += slotsOf(node);
+  totals.treeSlots += slotsOf(node);
+  if (node.tag !== NodeTag.TEXT_NODE) {
+    if (node.storeIndex >= 0) totals.treeStoreRows++;
+    for (let c = node.firstChild; c; c = c.nextSibling) {
+      walkTree(c, types, totals);
+    }
+  }
+}
+
+/**
+ * Take a leak checkpoint: collect garbage, count the live, attached and
+ * retained nodes and the native resources they hold, and log what grew
+ * since the previous checkpoint. Returns the report, whose `delta` holds
+ * the changes (null for the first checkpoint).
+ *
+ * @param label - Optional name for the log lines
+ */
+export function leakCheckpoint(label) {
+  if (!leakTracking) {
+    throw new Error('leakCheckpoint: call setLeakTracking(true) first');
+  }
+  const runtime = globalThis.runtime;
+  if (runtime && runtime.collectGarbage) runtime.collectGarbage();
+
+  const types = {};
+  for (const [type, n] of liveCounts) entryFor(types, type).live = n;
+
+  const totals = { treeSlots: 0, treeStoreRows: 0 };
+  const containers = globalThis.imguiRootContainers || [];
+  for (const container of containers) {
+    for (const child of container.rootChildren) walkTree(child, types, totals);
+  }
+
+  // Deleted nodes still reachable. Nodes reused by the pool (new id) or
+  // waiting in it are not leaks.
+  let retainedSlots = 0;
+  const kept = [];
+  for (const d of deleted) {
+    const node = d.ref.deref();
+    if (node === undefined || node.id !== d.id) continue;
+    kept.push(d);
+    if (isPooledNode(node)) continue;
+    const entry = entryFor(types, d.type);
+    entry.retained++;
+    entry.retainedSlots += slotsOf(node);
+    retainedSlots += slotsOf(node);
+    if (node.tag !== NodeTag.TEXT_NODE && node.storeIndex >= 0) {
+      entry.retainedStoreRows++;
+    }
+  }
+  deleted = kept;
+
+  const unit = globalThis.imguiUnit;
+  const native = unit && unit.memoryStats ? unit.memoryStats() : null;
+  const memory = runtime && runtime.memoryReport ? runtime.memoryReport() : null;
+  const report = {
+    types,
+    slots: native ? native.slots : 0,
+    treeSlots: totals.treeSlots,
+    // Slots owned by no node of the tree: internal labels, which are
+    // constant, plus leaked ones
+    untrackedSlots: native ? native.slots - totals.treeSlots : 0,
+    retainedSlots,
+    storeRowsUsed: native ? native.storeRowsUsed : 0,
+    treeStoreRows: totals.treeStoreRows,
+    images: memory ? memory.textures.images.length : 0,
+    delta: null,
+  };
+
+  if (previous !== null) {
+    const delta = { types: {} };
+    for (const type of Object.keys(types)) {
+      const now = types[type];
+      const before = previous.types[type];
+      const d = {};
+      let changed = false;
+      for (const key of Object.keys(now)) {
+        d[key] = now[key] - (before ? before[key] : 0);
+        if (d[key] !== 0) changed = true;
+      }
+      if (changed) delta.types[type] = d;
+    }
+    for (const key of [
+      'slots',
+      'untrackedSlots',
+      'retainedSlots',
+      'storeRowsUsed',
+      'images',
+    ]) {
+      delta[key] = report[key] - previous[key];
+    }
+    report.delta = delta;
+    logDelta(label, delta);
+  }
+  previous = report;
+  return report;
+}
+
+function signed(n) {
+  return n > 0 ? `+${n}` : `${n}`;
+}
+
+function logDelta(label, delta) {
+  const prefix = label ? `leakCheckpoint(${label})` : 'leakCheckpoint';
+  const lines = [];
+  for (const type of Object.keys(delta.types)) {
+    const d = delta.types[type];
+    lines.push(
+      `  <${type}>: live ${signed(d.live)}, in tree ${signed(d.inTree)}, ` +
+        `retained ${signed(d.retained)} (slots ${signed(d.retainedSlots)})`
+    );
+  }
+  console.log(
+    `${prefix}: slots ${signed(delta.slots)} ` +
+      `(untracked ${signed(delta.untrackedSlots)}, ` +
+      `retained ${signed(delta.retainedSlots)}), ` +
+      `store rows ${signed(delta.storeRowsUsed)}, ` +
+      `images ${signed(delta.images)}` +
+      (lines.length ? '\n' + lines.join('\n') : '')
+  );
+}
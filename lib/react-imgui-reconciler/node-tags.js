@@ -0,0 +1,108 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+/**
+ * Integer tags for host node types.
+ *
+ * Every TreeNode and TextNode gets a tag when it is created, so the typed
+ * renderer can dispatch on a small integer instead of comparing type strings.
+ * The renderer (lib/imgui-unit/renderer.js) keeps its own copy of these
+ * values and checks it against globalThis.imguiNodeTags when it loads, so
+ * both tables must be updated together when a component is added.
+ */
+export const NodeTag = Object.freeze({
+  UNKNOWN: 0,
+  TEXT_NODE: 1,
+  ROOT: 2,
+  WINDOW: 3,
+  CHILD: 4,
+  BUTTON: 5,
+  TEXT: 6,
+  GROUP: 7,
+  SEPARATOR: 8,
+  SAMELINE: 9,
+  INDENT: 10,
+  COLLAPSINGHEADER: 11,
+  TABLE: 12,
+  TABLEHEADER: 13,
+  TABLEROW: 14,
+  TABLECELL: 15,
+  TABLECOLUMN: 16,
+  RECT: 17,
+  CIRCLE: 18,
+  RADIALMENU: 19,
+  CANVAS: 20,
+  PLOTLINES: 21,
+  PLOTHISTOGRAM: 22,
+  INPUTTEXT: 23,
+  COMBO: 24,
+  LISTBOX: 25,
+  IMAGE: 26,
+  VIRTUALLIST: 27,
+  TREENODE: 28,
+  DATAGRID: 29,
+  TEXTVIEW: 30,
+  HEATMAP: 31,
+  STATIC: 32,
+  TABBAR: 33,
+  TABITEM: 34,
+  FONT: 35,
+  NUMBER: 36,
+});
+
+/**
+ * Map from host component type (JSX element name) to its tag.
+ */
+const typeTags = Object.freeze({
+  root: NodeTag.ROOT,
+  window: NodeTag.WINDOW,
+  child: NodeTag.CHILD,
+  button: NodeTag.BUTTON,
+  text: NodeTag.TEXT,
+  group: NodeTag.GROUP,
+  separator: NodeTag.SEPARATOR,
+  sameline: NodeTag.SAMELINE,
+  indent: NodeTag.INDENT,
+  collapsingheader: NodeTag.COLLAPSINGHEADER,
+  table: NodeTag.TABLE,
+  tableheader: NodeTag.TABLEHEADER,
+  tablerow: NodeTag.TABLEROW,
+  tablecell: NodeTag.TABLECELL,
+  tablecolumn: NodeTag.TABLECOLUMN,
+  rect: NodeTag.RECT,
+  circle: NodeTag.CIRCLE,
+  radialmenu: NodeTag.RADIALMENU,
+  canvas: NodeTag.CANVAS,
+  plotlines: NodeTag.PLOTLINES,
+  plothistogram: NodeTag.PLOTHISTOGRAM,
+  inputtext: NodeTag.INPUTTEXT,
+  combo: NodeTag.COMBO,
+  listbox: NodeTag.LISTBOX,
+  image: NodeTag.IMAGE,
+  virtuallist: NodeTag.VIRTUALLIST,
+  treenode: NodeTag.TREENODE,
+  datagrid: NodeTag.DATAGRID,
+  textview: NodeTag.TEXTVIEW,
+  heatmap: NodeTag.HEATMAP,
+  static: NodeTag.STATIC,
+  tabbar: NodeTag.TABBAR,
+  tabitem: NodeTag.TABITEM,
+  font: NodeTag.FONT,
+  number: NodeTag.NUMBER,
+});
+
+// Published for the consistency check in the imgui unit, which loads later.
+globalThis.imguiNodeTags = typeTags;
+
+/**
+ * Get the tag for a host component type.
+ *
+ * @param type - The component type string (e.g., "window", "button")
+ * @returns The tag, or NodeTag.UNKNOWN for unsupported types
+ */
+export function tagForType(type) {
+  return Object.prototype.hasOwnProperty.call(typeTags, type)
+    ? typeTags[type]
+    : NodeTag.UNKNOWN;
+}
@@ -2,51 +2,118 @@
 // SPDX-License-Identifier: MIT
 // See LICENSE file for full license text
 
-// Reconciliation timing statistics - module scope for efficiency
-const RECONCILIATION_SAMPLE_SIZE = 30;
-const MAX_WINDOW_SECONDS = 5;
+// Reconciliation timing statistics over the commits of the last
+// RECONCILIATION_WINDOW_MS, at most RECONCILIATION_CAPACITY of them
+// (RollingStats from jslib).
+const RECONCILIATION_CAPACITY = 512;
+const RECONCILIATION_WINDOW_MS = 5000;
 
-let reconciliationSamples = []; // Array of {time: timestamp, duration: ms}
-let reconciliationAverage = 0;
-let reconciliationMax = 0;
+const reconciliationStats = new RollingStats({
+  capacity: RECONCILIATION_CAPACITY,
+  windowMs: RECONCILIATION_WINDOW_MS,
+});
+
+// Indices of the reconciliation fields in globalThis.__runtimeMetrics, the
+// runtime's native metrics block (see METRIC_NAMES in jslib.js).
+const METRIC_RECONCILIATION_AVG = 1;
+const METRIC_RECONCILIATION_MAX = 2;
+const METRIC_COMMIT_TIME = 11;
+const METRIC_COMMIT_MUTATIONS = 13; // commitCreateInstance, then one per kind
+const METRIC_LAST_COMMIT_TIME = 20;
+const METRIC_RECONCILIATION_P50 = 21;
+const METRIC_RECONCILIATION_P95 = 22;
+const METRIC_RECONCILIATION_P99 = 23;
+
+// Host config mutations counted since the last commit, indexed by the
+// Mutation values. Nodes are created in the render phase, before the commit
+// that inserts them, so they count towards that commit.
+export const Mutation = Object.freeze({
+  CREATE_INSTANCE: 0,
+  CREATE_TEXT_INSTANCE: 1,
+  APPEND_CHILD: 2,
+  INSERT_BEFORE: 3,
+  REMOVE_CHILD: 4,
+  COMMIT_UPDATE: 5,
+  COMMIT_TEXT_UPDATE: 6,
+});
+const MUTATION_NAMES = [
+  'createInstance',
+  'createTextInstance',
+  'appendChild',
+  'insertBefore',
+  'removeChild',
+  'commitUpdate',
+  'commitTextUpdate',
+];
+export const mutationCounts = new Array(MUTATION_NAMES.length).fill(0);
+
+// Updates (not mounts) with more mutations than this are logged, since
+// they usually come from a missing key or an unstable prop.
+// Configurable through globalThis.sappConfig.commit_warn_mutations
+// (0 disables the warning).
+const DEFAULT_COMMIT_WARN_MUTATIONS = 1000;
 
 /**
- * Update reconciliation timing statistics.
- * Maintains a moving average of the last N samples and a time-windowed max.
+ * Publish the mutation counts of the commit that just finished in
+ * `duration` ms and reset them. `isMount` is true for the first commit of a
+ * root, which is expected to create the whole tree.
  */
-export function updateReconciliationStats(duration) {
-  const now = performance.now();
+export function recordCommitMutations(duration, isMount, rootName) {
+  let total = 0;
+  for (let i = 0; i < mutationCounts.length; i++) total += mutationCounts[i];
 
-  // Add new sample
-  reconciliationSamples.push({ time: now, duration });
-
-  // Keep only last N samples for average
-  if (reconciliationSamples.length > RECONCILIATION_SAMPLE_SIZE) {
-    reconciliationSamples.shift();
+  const metrics = globalThis.__runtimeMetrics;
+  if (metrics) {
+    for (let i = 0; i < mutationCounts.length; i++) {
+      metrics[METRIC_COMMIT_MUTATIONS + i] = mutationCounts[i];
+    }
+    metrics[METRIC_LAST_COMMIT_TIME] = duration;
   }
-
-  // Calculate average from all samples
-  let sum = 0;
-  for (let i = 0; i < reconciliationSamples.length; i++) {
-    sum += reconciliationSamples[i].duration;
+  if (trace.capturing) {
+    for (let i = 0; i < mutationCounts.length; i++) {
+      trace.counter(MUTATION_NAMES[i], mutationCounts[i]);
+    }
   }
-  reconciliationAverage = sum / reconciliationSamples.length;
-
-  // Calculate max from samples within time window
-  const cutoffTime = now - MAX_WINDOW_SECONDS * 1000;
-  reconciliationMax = 0;
-  for (let i = 0; i < reconciliationSamples.length; i++) {
-    if (reconciliationSamples[i].time >= cutoffTime) {
-      if (reconciliationSamples[i].duration > reconciliationMax) {
-        reconciliationMax = reconciliationSamples[i].duration;
+
+  const config = globalThis.sappConfig;
+  const limit =
+    config && typeof config.commit_warn_mutations === 'number'
+      ? config.commit_warn_mutations
+      : DEFAULT_COMMIT_WARN_MUTATIONS;
+  if (!isMount && limit > 0 && total > limit) {
+    const parts = [];
+    for (let i = 0; i < mutationCounts.length; i++) {
+      if (mutationCounts[i]) {
+        parts.push(`${MUTATION_NAMES[i]} ${mutationCounts[i]}`);
       }
     }
+    console.warn(
+      `Commit of root "${rootName}" made ${total} mutations in ` +
+        `${duration.toFixed(2)}ms (${parts.join(', ')}). ` +
+        'Check for missing keys or props that change every render.'
+    );
   }
 
-  // Expose to globalThis for C++ access
-  if (!globalThis.perfMetrics) {
-    globalThis.perfMetrics = {};
+  mutationCounts.fill(0);
+}
+
+/**
+ * Update reconciliation timing statistics: average, percentiles and max of
+ * the commits in the window.
+ */
+export function updateReconciliationStats(duration) {
+  const stats = reconciliationStats;
+  stats.add(duration, performance.now());
+
+  // Store for C++ to read
+  const metrics = globalThis.__runtimeMetrics;
+  if (metrics) {
+    metrics[METRIC_RECONCILIATION_AVG] = stats.average();
+    metrics[METRIC_RECONCILIATION_MAX] = stats.max();
+    metrics[METRIC_RECONCILIATION_P50] = stats.percentile(0.5);
+    metrics[METRIC_RECONCILIATION_P95] = stats.percentile(0.95);
+    metrics[METRIC_RECONCILIATION_P99] = stats.percentile(0.99);
+    // Per-frame total, collected by the perf HUD.
+    metrics[METRIC_COMMIT_TIME] += duration;
   }
-  globalThis.perfMetrics.reconciliationAvg = reconciliationAverage;
-  globalThis.perfMetrics.reconciliationMax = reconciliationMax;
 }
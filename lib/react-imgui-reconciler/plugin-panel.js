@@ -0,0 +1,452 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+import React, {
+  memo,
+  useEffect,
+  useLayoutEffect,
+  useRef,
+  useState,
+} from 'react';
+import { DiscreteEventPriority } from 'react-reconciler/constants';
+import { batchExternalUpdates, createRoot, render } from './reconciler.js';
+import { runWithEventPriority } from './event-priority.js';
+import { NodeTag } from './node-tags.js';
+
+/**
+ * Plugin panels: third-party UI running on a Hermes runtime and thread of
+ * its own, so that its collections, long tasks and memory don't stall or
+ * starve the app.
+ *
+ * A panel is a worker (a .hbc or .js bundle, or a WORKERS unit) that
+ * renders into createPanelRoot() instead of createRoot():
+ *
+ *   // panel.jsx, bundled with React and the reconciler like an app
+ *   createPanelRoot().render(<OrdersWindow />);
+ *
+ * and the app shows it with <PluginPanel>:
+ *
+ *   <PluginPanel src="plugins/orders.hbc" maxHeap={64 << 20} />
+ *
+ * The panel's React commits run on its thread. After each task that
+ * committed, the panel root posts the nodes that changed since the last
+ * batch, found through the tree versions, as records of a command buffer:
+ * [id, type, props, handlers, children], with null for the parts that
+ * didn't change (type null: a text node, props its text). <PluginPanel>
+ * applies them to a mirror of the panel's tree and renders the mirror with
+ * the app's renderer, re-rendering only the changed nodes and their
+ * ancestors, at most once per frame (batchExternalUpdates()). A panel that
+ * is busy or collecting keeps showing its last tree meanwhile.
+ *
+ * Props are copied as worker messages: functions nested in other values,
+ * Maps and Sets don't survive the trip. Top-level callback props are
+ * replaced by proxies that post their arguments back to the panel, which
+ * calls its own callback with discrete priority; their return values are
+ * lost. A controlled widget shows the panel's value once the panel has
+ * committed it, a round trip later.
+ */
+
+//
+// Panel side
+//
+
+// The panel root of this worker, if any
+let panelRoot = null;
+
+/**
+ * Whether two ID lists are equal.
+ */
+function sameIds(a, b) {
+  if (a.length !== b.length) return false;
+  for (let i = 0; i < a.length; i++) {
+    if (a[i] !== b[i]) return false;
+  }
+  return true;
+}
+
+/**
+ * Append the IDs of `before` that aren't in `after` to `removed`.
+ */
+function collectRemoved(before, after, removed) {
+  const kept = new Set(after);
+  for (let i = 0; i < before.length; i++) {
+    if (!kept.has(before[i])) removed.push(before[i]);
+  }
+}
+
+/**
+ * The props of a node as sent: data props, without `children` (the child
+ * nodes are sent instead), and the names of the callback props.
+ */
+function encodeProps(props) {
+  const data = {};
+  let handlers = null;
+  for (const key in props) {
+    if (key === 'children') continue;
+    const value = props[key];
+    if (typeof value === 'function') {
+      if (handlers === null) handlers = [];
+      handlers.push(key);
+    } else {
+      data[key] = value;
+    }
+  }
+  return [data, handlers];
+}
+
+/**
+ * Whether the node sent as `id` is still in the panel's tree: not recycled
+ * by the node pool, and below one of the root's children.
+ */
+function isAttached(panel, entry, id) {
+  let node = entry.node;
+  if (node.id !== id) return false;
+  while (node.parent !== null) node = node.parent;
+  return panel.root.container.rootChildren.indexOf(node) !== -1;
+}
+
+/**
+ * Forget the node sent as `id` and those of its subtree that weren't moved
+ * elsewhere, appending their IDs to `dropped`.
+ */
+function dropEntry(panel, id, dropped) {
+  const entry = panel.entries.get(id);
+  if (entry === undefined) return;
+  panel.entries.delete(id);
+  dropped.push(id);
+  const children = entry.children;
+  if (children === null) return;
+  for (let i = 0; i < children.length; i++) {
+    const child = panel.entries.get(children[i]);
+    if (child !== undefined && !isAttached(panel, child, children[i])) {
+      dropEntry(panel, children[i], dropped);
+    }
+  }
+}
+
+/**
+ * Add the records of `node` and of its descendants that changed after tree
+ * version `since` to `records`, parents first. Children that left a list
+ * go to `removed`.
+ */
+function visit(panel, node, since, records, removed) {
+  let entry = panel.entries.get(node.id);
+  if (entry !== undefined && node.version <= since) return;
+  const isNew = entry === undefined;
+  if (isNew) {
+    entry = { node, props: undefined, children: null };
+    panel.entries.set(node.id, entry);
+  }
+  if (node.tag === NodeTag.TEXT_NODE) {
+    if (entry.props !== node.text) {
+      entry.props = node.text;
+      records.push([node.id, null, node.text, null, null]);
+    }
+    return;
+  }
+
+  let props = null;
+  let handlers = null;
+  if (entry.props !== node.props) {
+    entry.props = node.props;
+    [props, handlers] = encodeProps(node.props);
+  }
+  const ids = [];
+  for (let child = node.firstChild; child !== null; child = child.nextSibling) {
+    ids.push(child.id);
+  }
+  let children = null;
+  if (entry.children === null || !sameIds(entry.children, ids)) {
+    if (entry.children !== null) collectRemoved(entry.children, ids, removed);
+    entry.children = children = ids;
+  }
+  if (isNew || props !== null || children !== null) {
+    records.push([node.id, node.type, props, handlers, children]);
+  }
+  for (let child = node.firstChild; child !== null; child = child.nextSibling) {
+    visit(panel, child, since, records, removed);
+  }
+}
+
+/**
+ * Post the changes of the commits since the last batch.
+ */
+function flushPanel(panel) {
+  panel.scheduled = false;
+  const container = panel.root.container;
+  if (container.treeVersion === panel.sentVersion) return;
+
+  const records = [];
+  const removed = [];
+  const rootChildren = container.rootChildren;
+  for (let i = 0; i < rootChildren.length; i++) {
+    visit(panel, rootChildren[i], panel.sentVersion, records, removed);
+  }
+  let roots = rootChildren.map((node) => node.id);
+  if (sameIds(roots, panel.roots)) {
+    roots = null;
+  } else {
+    collectRemoved(panel.roots, roots, removed);
+    panel.roots = roots;
+  }
+  const dropped = [];
+  for (let i = 0; i < removed.length; i++) {
+    const entry = panel.entries.get(removed[i]);
+    if (entry !== undefined && !isAttached(panel, entry, removed[i])) {
+      dropEntry(panel, removed[i], dropped);
+    }
+  }
+  panel.sentVersion = container.treeVersion;
+  globalThis.postMessage({ panel: 'commit', records, roots, dropped });
+}
+
+/**
+ * Call the callback `name` of node `id` for a proxy of <PluginPanel>.
+ */
+function callHandler(panel, id, name, args) {
+  const entry = panel.entries.get(id);
+  if (entry === undefined || entry.node.id !== id || !entry.node.props) return;
+  const callback = entry.node.props[name];
+  if (typeof callback !== 'function') return;
+  try {
+    runWithEventPriority(DiscreteEventPriority, () => callback(...args));
+  } catch (e) {
+    console.error('Error in callback:', e);
+  }
+}
+
+/**
+ * Create the root of a plugin panel, in the worker that runs it. `options`
+ * are those of createRoot() (`concurrent`, `name`). Messages of the app
+ * that aren't for the panel root go to the worker's previous onmessage.
+ *
+ * @returns An object with:
+ *   - root: the root from createRoot()
+ *   - render(element): renders `element` into it, like render()
+ */
+export function createPanelRoot(options) {
+  if (typeof globalThis.postMessage !== 'function') {
+    throw new Error('createPanelRoot: panels run in a worker (<PluginPanel>)');
+  }
+  if (panelRoot !== null) {
+    throw new Error('createPanelRoot: a worker has one panel root');
+  }
+  const panel = {
+    root: null,
+    entries: new Map(), // Node ID -> { node, props, children } as sent
+    roots: [], // IDs of the root children as sent
+    sentVersion: 0, // Tree version of the last batch
+    scheduled: false,
+  };
+  panel.root = createRoot({
+    ...options,
+    onCommit() {
+      // One batch for all the commits of a task
+      if (!panel.scheduled) {
+        panel.scheduled = true;
+        setImmediate(flushPanel, panel);
+      }
+    },
+  });
+  panelRoot = panel;
+
+  const previous = globalThis.onmessage;
+  globalThis.onmessage = (event) => {
+    const data = event.data;
+    if (data !== null && typeof data === 'object' && data.panel === 'call') {
+      callHandler(panel, data.id, data.name, data.args || []);
+    } else if (typeof previous === 'function') {
+      previous(event);
+    }
+  };
+
+  return {
+    root: panel.root,
+    render(element) {
+      return render(element, panel.root);
+    },
+  };
+}
+
+//
+// App side
+//
+
+/**
+ * Apply a batch of the panel to `mirror`, stamping the changed nodes and
+ * their ancestors with a new version.
+ */
+function applyCommit(mirror, batch) {
+  const version = ++mirror.version;
+  const nodes = mirror.nodes;
+  const records = batch.records;
+  const touched = [];
+  for (let i = 0; i < records.length; i++) {
+    const [id, type, props, handlers, children] = records[i];
+    let node = nodes.get(id);
+    if (node === undefined) {
+      node = {
+        id,
+        type,
+        props: null,
+        text: '',
+        children: [],
+        parent: null,
+        proxies: null, // Callback name -> proxy, kept across updates
+        version: 0,
+      };
+      nodes.set(id, node);
+    }
+    if (type === null) {
+      node.text = props;
+    } else if (props !== null) {
+      node.props =
+        handlers !== null
+          ? withProxies(mirror, node, props, handlers)
+          : props;
+    }
+    touched.push(node);
+  }
+  // Children can come after their parent: link once all exist
+  for (let i = 0; i < records.length; i++) {
+    const children = records[i][4];
+    if (children === null) continue;
+    const node = nodes.get(records[i][0]);
+    node.children = [];
+    for (let j = 0; j < children.length; j++) {
+      const child = nodes.get(children[j]);
+      if (child === undefined) continue;
+      child.parent = node;
+      node.children.push(child);
+    }
+  }
+  if (batch.roots !== null) {
+    mirror.roots = [];
+    for (let i = 0; i < batch.roots.length; i++) {
+      const node = nodes.get(batch.roots[i]);
+      if (node === undefined) continue;
+      node.parent = null;
+      mirror.roots.push(node);
+    }
+  }
+  for (let i = 0; i < batch.dropped.length; i++) {
+    nodes.delete(batch.dropped[i]);
+  }
+  for (let i = 0; i < touched.length; i++) {
+    let node = touched[i];
+    while (node !== null && node.version !== version) {
+      node.version = version;
+      node = node.parent;
+    }
+  }
+}
+
+/**
+ * `props` with the callbacks named in `handlers` replaced by proxies that
+ * post their calls to the panel.
+ */
+function withProxies(mirror, node, props, handlers) {
+  if (node.proxies === null) node.proxies = {};
+  for (let i = 0; i < handlers.length; i++) {
+    const name = handlers[i];
+    let proxy = node.proxies[name];
+    if (proxy === undefined) {
+      proxy = node.proxies[name] = (...args) => {
+        if (mirror.worker === null) return;
+        try {
+          mirror.worker.postMessage({ panel: 'call', id: node.id, name, args });
+        } catch (e) {
+          console.error(`PluginPanel: can't pass the arguments of ${name}:`, e);
+        }
+      };
+    }
+    props[name] = proxy;
+  }
+  return props;
+}
+
+/**
+ * A node of the mirror. Only re-renders when its version changed, which it
+ * does with its subtree.
+ */
+const MirrorNode = memo(function MirrorNode({ node }) {
+  if (node.type === null) return node.text;
+  return React.createElement(
+    node.type,
+    node.props,
+    ...node.children.map(mirrorElement)
+  );
+});
+
+function mirrorElement(node) {
+  return React.createElement(MirrorNode, {
+    key: node.id,
+    node,
+    version: node.version,
+  });
+}
+
+/**
+ * Show the plugin panel `src` (a worker unit name, or the path of a .hbc or
+ * .js file), running on its own runtime and thread. `maxHeap` caps the
+ * panel's heap, in bytes. If the panel fails to load or dies, `onError` is
+ * called with the message and `fallback` is shown instead: an element, or a
+ * function of the message. Changing `src` or `maxHeap` restarts the panel;
+ * unmounting stops it.
+ */
+export function PluginPanel({ src, maxHeap = 0, onError, fallback = null }) {
+  const [, setVersion] = useState(0);
+  const [error, setError] = useState(null);
+  const mirrorRef = useRef(null);
+  // The latest onError, so that a new closure doesn't restart the panel
+  const onErrorRef = useRef(onError);
+  useLayoutEffect(() => {
+    onErrorRef.current = onError;
+  });
+
+  useEffect(() => {
+    const mirror = { worker: null, nodes: new Map(), roots: [], version: 0 };
+    const fail = (message) => {
+      setError(message);
+      if (onErrorRef.current) onErrorRef.current(message);
+    };
+    setError(null);
+    let worker;
+    try {
+      worker = new Worker(src, maxHeap > 0 ? { maxHeap } : undefined);
+    } catch (e) {
+      fail(e && e.message ? e.message : String(e));
+      return undefined;
+    }
+    mirror.worker = worker;
+    mirrorRef.current = mirror;
+    worker.onmessage = (event) => {
+      const data = event.data;
+      if (
+        data === null ||
+        typeof data !== 'object' ||
+        data.panel !== 'commit'
+      ) {
+        return;
+      }
+      applyCommit(mirror, data);
+      batchExternalUpdates(() => setVersion(mirror.version));
+    };
+    worker.onerror = (event) => {
+      mirror.worker = null;
+      fail(event.message);
+    };
+    return () => {
+      worker.terminate();
+      mirror.worker = null;
+      if (mirrorRef.current === mirror) mirrorRef.current = null;
+    };
+  }, [src, maxHeap]);
+
+  if (error !== null) {
+    return typeof fallback === 'function' ? fallback(error) : fallback;
+  }
+  const mirror = mirrorRef.current;
+  return mirror !== null ? mirror.roots.map(mirrorElement) : null;
+}
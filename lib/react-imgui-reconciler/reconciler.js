@@ -3,33 +3,103 @@
 // See LICENSE file for full license text
 
 import Reconciler from 'react-reconciler';
+import { ConcurrentRoot, LegacyRoot } from 'react-reconciler/constants';
 import hostConfig from './host-config.js';
 
+export { setNodePoolCapacity, getNodePoolStats } from './tree-node.js';
+export { runWithEventPriority, runIdleUpdates } from './event-priority.js';
+export { setStableHandlers } from './host-config.js';
+export { setLeakTracking, leakCheckpoint } from './leak-check.js';
+
 /**
  * Create the React reconciler instance by passing it our host config.
  * This gives us a reconciler that knows how to manipulate our tree structure.
  */
 const reconciler = Reconciler(hostConfig);
 
+// The containers of all roots, in creation order. The imgui unit renders
+// them in this order every frame; the array is updated in place.
+const rootContainers = [];
+globalThis.imguiRootContainers = rootContainers;
+
+let nextRootId = 1;
+
+// A hot reload evaluates a new copy of this module, with roots of its own.
+// The old roots are unmounted first, committing synchronously, so that
+// their effects are cleaned up and their images unloaded before the new
+// ones mount.
+if (typeof globalThis.onHotReload === 'function') {
+  globalThis.onHotReload(() => {
+    const roots = rootContainers.map((container) => container.root);
+    const unmountAll = () => {
+      for (const root of roots) {
+        root.pendingUpdates.length = 0;
+        reconciler.updateContainer(null, root.fiberRoot, null, null);
+      }
+    };
+    if (typeof reconciler.flushSyncFromReconciler === 'function') {
+      reconciler.flushSyncFromReconciler(unmountAll);
+    } else {
+      reconciler.batchedUpdates(unmountAll);
+    }
+    rootContainers.length = 0;
+  });
+}
+
 /**
  * Create a root container for rendering.
- * This is the entry point - call this once to create a render target.
+ * This is the entry point - call this once per render target. Apps usually
+ * have one root; tool windows that update independently (e.g. a heavy
+ * blotter next to small panels) can each get their own, named one. A commit
+ * in one root doesn't reconcile the others.
+ *
+ * By default the root is a LegacyRoot: every update renders synchronously to
+ * completion. With `{ concurrent: true }` it is a ConcurrentRoot, whose
+ * renders yield to the event loop every few milliseconds (React's
+ * scheduler runs on setImmediate). The C++ frame loop stops running
+ * macrotasks once the frame's macrotask budget is spent
+ * (sappConfig.macrotask_budget, a fraction of the frame duration), so a large
+ * re-render is spread across frames instead of dropping them, and input
+ * updates (discrete priority) can interrupt it.
+ *
+ * `updateIntervalMs` sets the root's cadence for batchExternalUpdates():
+ * its queued updates are committed at most that often (default: every
+ * frame). Updates from event handlers and effects are not affected.
  *
+ * `onCommit(container)` is called at the end of each commit of the root,
+ * after the tree version has been updated (see plugin-panel.js).
+ *
+ * @param options - Optional `{ concurrent: boolean, name: string,
+ *   updateIntervalMs: number, onCommit: function }`
  * @returns An object with:
+ *   - name: The root's name (`root<N>` if none was given)
  *   - container: Our container object that will hold the tree
  *   - fiberRoot: React's internal fiber root
  */
-export function createRoot() {
-  // This is our container - it will hold the root of our tree
+export function createRoot(options) {
+  const concurrent = !!(options && options.concurrent);
+  const id = nextRootId++;
+  const name = (options && options.name) || `root${id}`;
+  if (getRoot(name)) {
+    throw new Error(`createRoot: a root named '${name}' already exists`);
+  }
+
+  // This is our container - it will hold the root of our tree. The imgui
+  // unit renders it directly, so its fields are only ever updated in place.
   const container = {
-    rootChildren: [], // Will hold root TreeNode(s) when we render
+    name,
+    rootChildren: [], // Root TreeNode(s), in order (supports Fragments)
+    rootCount: 0, // Number of <root> nodes in rootChildren
+    treeVersion: 0, // Tree version of the last commit that changed this root
+    commitCount: 0, // Commits of this root, changing it or not
+    onCommit: (options && options.onCommit) || null, // Called after commits
   };
 
   // Create React's internal fiber root
   // This is React's internal data structure for tracking the component tree
   const fiberRoot = reconciler.createContainer(
     container, // Our container object
-    0, // Tag: 0 = LegacyRoot (doesn't matter much for us)
+    concurrent ? ConcurrentRoot : LegacyRoot, // Root tag
     null, // Hydration callbacks (for SSR, we don't use)
     false, // isStrictMode
     null, // concurrentUpdatesByDefaultOverride
@@ -44,7 +114,43 @@ export function createRoot() {
     null // transitionCallbacks
   );
 
-  return { container, fiberRoot };
+  const root = {
+    name,
+    container,
+    fiberRoot,
+    updateIntervalMs: (options && options.updateIntervalMs) || 0,
+    // batchExternalUpdates() state
+    pendingUpdates: [],
+    lastFlushTime: -Infinity,
+  };
+  container.root = root;
+  rootContainers.push(container);
+  return root;
+}
+
+/**
+ * The root created with `name`, or undefined.
+ */
+export function getRoot(name) {
+  for (let i = 0; i < rootContainers.length; i++) {
+    if (rootContainers[i].name === name) return rootContainers[i].root;
+  }
+  return undefined;
+}
+
+/**
+ * Unmount everything rendered into `root` and stop rendering it. Returns a
+ * Promise that resolves once the tree has been removed.
+ */
+export function destroyRoot(root) {
+  return new Promise((resolve) => {
+    root.pendingUpdates.length = 0;
+    reconciler.updateContainer(null, root.fiberRoot, null, () => {
+      const index = rootContainers.indexOf(root.container);
+      if (index !== -1) rootContainers.splice(index, 1);
+      resolve();
+    });
+  });
 }
 
 /**
@@ -73,3 +179,100 @@ export function render(element, root) {
     );
   });
 }
+
+//
+// Frame-aligned external updates
+//
+
+// Roots with queued external updates. The flush runs from one rAF callback
+// for all of them, so a frame still gets at most one flush per root.
+const rootsWithUpdates = [];
+let externalFlushScheduled = false;
+
+function scheduleExternalFlush() {
+  if (!externalFlushScheduled) {
+    externalFlushScheduled = true;
+    requestAnimationFrame(flushExternalUpdates);
+  }
+}
+
+/**
+ * Run the queued external updates of one root as one batch, so they produce
+ * a single React commit. flushSyncFromReconciler() commits before returning
+ * on any root type; batchedUpdates() is enough for a legacy root.
+ */
+function flushRootUpdates(root) {
+  const updates = root.pendingUpdates;
+  root.pendingUpdates = [];
+
+  const runAll = () => {
+    for (let i = 0; i < updates.length; i++) {
+      try {
+        updates[i]();
+      } catch (e) {
+        console.error('Error in external update:', e);
+      }
+    }
+  };
+  if (typeof reconciler.flushSyncFromReconciler === 'function') {
+    reconciler.flushSyncFromReconciler(runAll);
+  } else {
+    reconciler.batchedUpdates(runAll);
+  }
+}
+
+/**
+ * Flush every root with queued updates whose update interval has elapsed.
+ * The others keep their updates for a later frame.
+ */
+function flushExternalUpdates(now) {
+  externalFlushScheduled = false;
+  const roots = rootsWithUpdates.splice(0, rootsWithUpdates.length);
+  let waitMs = Infinity;
+  for (let i = 0; i < roots.length; i++) {
+    const root = roots[i];
+    const dueIn = root.lastFlushTime + root.updateIntervalMs - now;
+    if (dueIn > 0) {
+      rootsWithUpdates.push(root);
+      waitMs = Math.min(waitMs, dueIn);
+      continue;
+    }
+    root.lastFlushTime = now;
+    flushRootUpdates(root);
+  }
+  // Throttled roots are flushed by the first frame after their interval; a
+  // timer rather than a rAF chain waits for it, so the app can go idle.
+  if (rootsWithUpdates.length && !externalFlushScheduled) {
+    setTimeout(scheduleExternalFlush, waitMs);
+  }
+}
+
+/**
+ * Queue `fn`, which typically calls setState() or updates a store, to run
+ * right before the next frame is rendered. All updates queued between two
+ * frames run together and are committed once, so data arriving from native
+ * code or sockets at a high message rate costs one reconciliation per frame
+ * instead of one per message.
+ *
+ * The queue is flushed from requestAnimationFrame(), which the C++ loop runs
+ * after the frame's macrotasks and just before on_frame(). Updates are
+ * queued per root: `root` (default: the first root created) is flushed at
+ * its own `updateIntervalMs` cadence, so a busy feed into one root doesn't
+ * commit the others.
+ *
+ * @param fn - Function performing the updates
+ * @param root - Optional root from createRoot() whose state `fn` updates
+ */
+export function batchExternalUpdates(fn, root) {
+  if (!root) {
+    root = rootContainers.length ? rootContainers[0].root : null;
+    if (!root) {
+      throw new Error('batchExternalUpdates: no root has been created');
+    }
+  }
+  if (root.pendingUpdates.length === 0) {
+    rootsWithUpdates.push(root);
+  }
+  root.pendingUpdates.push(fn);
+  scheduleExternalFlush();
+}
@@ -0,0 +1,47 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+/**
+ * Typed arrays backed by native memory shared with the imgui unit.
+ *
+ * The memory is allocated by imgui-runtime (__createSharedBuffer) and exposed
+ * here as an ordinary ArrayBuffer, while the typed unit reads the same bytes
+ * through a c_ptr (sharedArrayPtr() in lib/imgui-unit/asciiz.js). Passing
+ * such an array as a prop therefore hands bulk numeric data to the renderer
+ * without boxing or copying.
+ *
+ * The renderer cannot observe in-place writes: after mutating a shared array,
+ * re-render with a changed prop (or a new array) if the component caches
+ * anything derived from it.
+ */
+
+/**
+ * Allocate a typed array of `length` elements over shared native memory.
+ * @param {Function} ArrayType - Typed array constructor, e.g. Float32Array
+ * @param {number} length - Number of elements
+ */
+export function createSharedArray(ArrayType, length) {
+  const { handle, buffer } = globalThis.__createSharedBuffer(
+    length * ArrayType.BYTES_PER_ELEMENT
+  );
+  const array = new ArrayType(buffer);
+  // Read by the imgui unit to find the native memory
+  array.nativeHandle = handle;
+  return array;
+}
+
+/**
+ * Allocate a Float32Array over shared native memory.
+ * @param {number} length - Number of elements
+ */
+export function createSharedFloat32Array(length) {
+  return createSharedArray(Float32Array, length);
+}
+
+/**
+ * Whether `array` is backed by shared native memory.
+ */
+export function isSharedArray(array) {
+  return array != null && typeof array.nativeHandle === 'number';
+}
@@ -2,6 +2,8 @@
 // SPDX-License-Identifier: MIT
 // See LICENSE file for full license text
 
+import { NodeTag, tagForType } from './node-tags.js';
+
 /**
  * Global counter for assigning unique IDs to TreeNodes.
  * Each TreeNode gets a unique ID that persists for its lifetime,
@@ -15,11 +17,39 @@ let nextNodeId = 1;
  */
 export class TreeNode {
   constructor(type, props) {
+    this.init(type, props);
+  }
+
+  /**
+   * Initialize every field. Also used to recycle pooled nodes, so a reused
+   * node has the same shape and a fresh ID.
+   */
+  init(type, props) {
     this.id = nextNodeId++; // Unique ID for ImGui ID stack
     this.type = type; // Component type like "Window", "Button", etc.
+    this.tag = tagForType(type); // Integer type tag used by the renderer
     this.props = props; // Props object passed to the component
-    this.children = []; // Array of child TreeNodes or TextNodes
+    this.propCount = -1; // Number of keys of props, once an update counted them
     this.parent = null; // Parent TreeNode (for debugging/traversal)
+    // Children form an intrusive doubly-linked list, so React's insertions
+    // and removals are O(1) and the renderer walks it without an array.
+    this.firstChild = null; // First child TreeNode or TextNode
+    this.lastChild = null; // Last child TreeNode or TextNode
+    this.childCount = 0; // Number of children in the list
+    this.prevSibling = null; // Previous node in the parent's child list
+    this.nextSibling = null; // Next node in the parent's child list
+    this.plan = null; // Render plan cached by the imgui unit; reset on commit
+    this.label = null; // Joined text children, cached by the imgui unit
+    // State owned by the imgui unit, declared here so that every node has
+    // the same shape and property accesses in the renderer stay monomorphic
+    this.state = null; // Per-type render state that survives commits
+    this.nativeSlots = null; // Persistent native buffers (integer slots)
+    this.storeIndex = -1; // Row in the imgui unit's native state store
+    this.imguiId = 0; // ImGuiID hashed from `id` by the imgui unit, or 0
+    this.idSeed = 0; // ID stack seed `imguiId` was hashed with
+    this.lastRenderError = null; // Last render exception logged for the node
+    this.updateFlags = 0; // UpdateFlags of the last commitUpdate
+    this.version = 0; // Tree version of the last change in this subtree
   }
 }
 
@@ -29,8 +59,299 @@ export class TreeNode {
  */
 export class TextNode {
   constructor(text) {
+    this.init(text);
+  }
+
+  /**
+   * Initialize every field. Also used to recycle pooled nodes.
+   */
+  init(text) {
     this.id = nextNodeId++; // Unique ID for ImGui ID stack
+    this.tag = NodeTag.TEXT_NODE; // Integer type tag used by the renderer
     this.text = text; // The text content
     this.parent = null; // Parent TreeNode
+    this.prevSibling = null; // Previous node in the parent's child list
+    this.nextSibling = null; // Next node in the parent's child list
+    this.plan = null; // Render plan cached by the imgui unit; reset on commit
+    this.nativeSlots = null; // Persistent native buffers owned by the imgui unit
+    this.imguiId = 0; // ImGuiID hashed from `id` by the imgui unit, or 0
+    this.idSeed = 0; // ID stack seed `imguiId` was hashed with
+    this.version = 0; // Tree version of the last change to the text
+  }
+}
+
+//
+// Node pooling (opt-in)
+//
+// High-churn subtrees (dynamic windows, filtered tables) create and delete
+// thousands of nodes per second. With a non-zero pool capacity, deleted
+// nodes are kept and re-initialized by the next createTreeNode() or
+// createTextNode() instead of being left to the GC. Pooling is off by
+// default because refs to deleted host instances then alias new nodes.
+//
+
+let poolCapacity = 0;
+const treeNodePool = [];
+const textNodePool = [];
+const poolStats = { hits: 0, misses: 0, recycled: 0, dropped: 0 };
+
+/**
+ * Set the maximum number of pooled nodes of each class. 0 (the default)
+ * disables pooling and empties the pools.
+ */
+export function setNodePoolCapacity(capacity) {
+  poolCapacity = capacity > 0 ? capacity : 0;
+  if (treeNodePool.length > poolCapacity) treeNodePool.length = poolCapacity;
+  if (textNodePool.length > poolCapacity) textNodePool.length = poolCapacity;
+}
+
+/**
+ * Pool counters: `hits`/`misses` count node creations served from the pool
+ * or allocated while pooling is enabled, `recycled` the nodes returned to
+ * the pool and `dropped` those discarded because the pool was full or
+ * still held native resources.
+ */
+export function getNodePoolStats() {
+  return {
+    hits: poolStats.hits,
+    misses: poolStats.misses,
+    recycled: poolStats.recycled,
+    dropped: poolStats.dropped,
+    treeNodes: treeNodePool.length,
+    textNodes: textNodePool.length,
+    capacity: poolCapacity,
+  };
+}
+
+/**
+ * Whether `node` is waiting in a pool. Linear in the pool size.
+ */
+export function isPooledNode(node) {
+  const pool = node.text !== undefined ? textNodePool : treeNodePool;
+  return pool.indexOf(node) !== -1;
+}
+
+/**
+ * Create a TreeNode, reusing a pooled one if available.
+ */
+export function createTreeNode(type, props) {
+  if (poolCapacity === 0) return new TreeNode(type, props);
+  const node = treeNodePool.pop();
+  if (node === undefined) {
+    poolStats.misses++;
+    return new TreeNode(type, props);
+  }
+  poolStats.hits++;
+  node.init(type, props);
+  return node;
+}
+
+/**
+ * Create a TextNode, reusing a pooled one if available.
+ */
+export function createTextNode(text) {
+  if (poolCapacity === 0) return new TextNode(text);
+  const node = textNodePool.pop();
+  if (node === undefined) {
+    poolStats.misses++;
+    return new TextNode(text);
+  }
+  poolStats.hits++;
+  node.init(text);
+  return node;
+}
+
+/**
+ * Whether a node still owns native buffers. They are normally freed when
+ * the removed subtree is handed to the imgui unit, before React detaches
+ * the instances; a node that still has them is not reused.
+ */
+function holdsNativeSlots(node) {
+  return (node.nativeSlots !== null && node.nativeSlots.length > 0) ||
+    node.storeIndex >= 0;
+}
+
+function poolNode(pool, node) {
+  if (pool.length >= poolCapacity || holdsNativeSlots(node)) {
+    poolStats.dropped++;
+    return;
+  }
+  // Drop references so pooled nodes don't keep props or render data alive
+  node.plan = null;
+  if (node.text !== undefined) {
+    node.text = '';
+  } else {
+    node.props = null;
+    node.state = null;
   }
+  pool.push(node);
+  poolStats.recycled++;
 }
+
+/**
+ * Return a deleted TreeNode, and the text nodes still attached to it, to
+ * the pool. Called from the host config's detachDeletedInstance(), which
+ * React invokes for every host instance of a deleted subtree, children
+ * before parents. Each node unlinks itself from its parent so that the
+ * parent's child list stays valid until the parent is recycled too.
+ */
+export function recycleTreeNode(node) {
+  if (poolCapacity === 0) return;
+  if (node.parent) {
+    treeOps.unlink(node.parent, node);
+  }
+  let child = node.firstChild;
+  while (child) {
+    const next = child.nextSibling;
+    treeOps.unlink(node, child);
+    if (child.text !== undefined) {
+      poolNode(textNodePool, child);
+    }
+    child = next;
+  }
+  poolNode(treeNodePool, node);
+}
+
+/**
+ * Insert `child` into the child list of `parent` before `beforeChild`, or
+ * at the end if `beforeChild` is null. React moves existing children by
+ * inserting them again, so a child that is already linked is unlinked first.
+ */
+export function insertChildNode(parent, child, beforeChild) {
+  if (child.parent) {
+    removeChildNode(child.parent, child);
+  }
+  const prev = beforeChild ? beforeChild.prevSibling : parent.lastChild;
+  child.prevSibling = prev;
+  child.nextSibling = beforeChild;
+  if (prev) {
+    prev.nextSibling = child;
+  } else {
+    parent.firstChild = child;
+  }
+  if (beforeChild) {
+    beforeChild.prevSibling = child;
+  } else {
+    parent.lastChild = child;
+  }
+  child.parent = parent;
+  parent.childCount++;
+}
+
+/**
+ * Unlink `child` from the child list of `parent`.
+ */
+export function removeChildNode(parent, child) {
+  const prev = child.prevSibling;
+  const next = child.nextSibling;
+  if (prev) {
+    prev.nextSibling = next;
+  } else {
+    parent.firstChild = next;
+  }
+  if (next) {
+    next.prevSibling = prev;
+  } else {
+    parent.lastChild = prev;
+  }
+  child.prevSibling = null;
+  child.nextSibling = null;
+  child.parent = null;
+  parent.childCount--;
+}
+
+/**
+ * Stamp `node` and its ancestors with the tree version `version`. Stops at
+ * the first ancestor already stamped with it.
+ */
+function stampVersion(node, version) {
+  while (node && node.version !== version) {
+    node.version = version;
+    node = node.parent;
+  }
+}
+
+/**
+ * Drop the render plan and joined text cached on a node whose children or
+ * props changed.
+ */
+function invalidateCaches(node) {
+  if (node) {
+    node.plan = null;
+    node.label = null;
+  }
+}
+
+//
+// Tree mutations
+//
+// The host config changes the tree only through `treeOps`. When the imgui
+// unit loads, it replaces these JS versions with native ones
+// (lib/imgui-unit/tree_ops.js), so mutations run as compiled code in every
+// bundle mode, not just mode 0. Both versions must behave the same.
+//
+
+export const treeOps = {
+  /** Link `child` into `parent` before `beforeChild` (null: at the end). */
+  link: insertChildNode,
+  /** Unlink `child` from `parent`. */
+  unlink: removeChildNode,
+  /**
+   * Link `child` into a committed `parent`, drop the parent's caches and
+   * stamp it and its ancestors with `version`.
+   */
+  insert(parent, child, beforeChild, version) {
+    insertChildNode(parent, child, beforeChild);
+    invalidateCaches(parent);
+    stampVersion(parent, version);
+  },
+  /**
+   * Unlink `child` from a committed `parent` if it is still linked there,
+   * drop the parent's caches and stamp it with `version`.
+   */
+  remove(parent, child, version) {
+    if (child.parent === parent) removeChildNode(parent, child);
+    invalidateCaches(parent);
+    stampVersion(parent, version);
+  },
+  /**
+   * Replace the props of `node`. `count` is their number of keys and
+   * `flags` the UpdateFlags of the change; with UpdateFlags.VALUES (1), the
+   * plan is dropped and the node stamped with `version`.
+   */
+  updateProps(node, props, count, flags, version) {
+    node.props = props;
+    node.propCount = count;
+    node.updateFlags = flags;
+    if (flags & 1) {
+      node.plan = null;
+      stampVersion(node, version);
+    }
+  },
+  /**
+   * Replace the text of a text node, drop its plan and its parent's caches
+   * and stamp it with `version`.
+   */
+  updateText(node, text, version) {
+    node.text = text;
+    node.plan = null;
+    invalidateCaches(node.parent);
+    stampVersion(node, version);
+  },
+};
+
+/**
+ * Replace the functions of `treeOps` with those of `ops`. Called by the
+ * imgui unit through globalThis.imguiInstallTreeOps when it loads.
+ */
+function installTreeOps(ops) {
+  for (const name of Object.keys(treeOps)) {
+    if (typeof ops[name] !== 'function') {
+      console.error(`installTreeOps: '${name}' is missing; keeping the JS tree operations`);
+      return;
+    }
+  }
+  Object.assign(treeOps, ops);
+}
+
+globalThis.imguiInstallTreeOps = installTreeOps;
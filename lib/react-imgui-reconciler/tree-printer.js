@@ -4,24 +4,27 @@
 
 /**
  * Pretty-print the tree structure to console.
- * This lets us visualize what React built.
+ * This lets us visualize what React built. For a live view while the app
+ * runs, use the imgui unit's tree inspector (imguiUnit.setInspector(true)).
  */
 
 /**
  * Print the entire tree from a container.
  *
- * @param container - The container object from render()
+ * @param container - A root container (globalThis.imguiRootContainers)
  * @param indent - Starting indentation level (default 0)
  */
 export function printTree(container, indent = 0) {
-  console.log('\n=== Tree Structure ===');
+  console.log(`\n=== Tree Structure (${container.name}) ===`);
 
-  if (!container.rootNode) {
+  if (container.rootChildren.length === 0) {
     console.log('(empty tree)');
     return;
   }
 
-  printNode(container.rootNode, indent);
+  for (const node of container.rootChildren) {
+    printNode(node, indent);
+  }
   console.log('======================\n');
 }
 
@@ -43,7 +46,7 @@ function printNode(node, indent) {
     console.log(`${spaces}<${node.type}${propsStr}>`);
 
     // Print children
-    for (const child of node.children) {
+    for (let child = node.firstChild; child; child = child.nextSibling) {
       printNode(child, indent + 1);
     }
   }
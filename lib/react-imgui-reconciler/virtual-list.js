@@ -0,0 +1,61 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+import React, { useCallback, useState } from 'react';
+
+/**
+ * A scrolling list of `itemCount` items of `itemHeight` pixels, of which
+ * only the ones in view (plus `overscan` on either side) are mounted:
+ *
+ *   <VirtualList
+ *     height={400}
+ *     itemCount={rows.length}
+ *     itemHeight={20}
+ *     renderItem={(i) => <text>{rows[i].name}</text>}
+ *   />
+ *
+ * `renderItem(index)` must return exactly one element, which is drawn in
+ * the item's slot and keyed by its index. The host <virtuallist> reports
+ * the range in view from ImGui's scroll position; the list re-renders only
+ * when that range leaves the mounted one, which is then centered on it
+ * again. So fibers, tree nodes and commit time scale with the viewport, not
+ * with `itemCount`.
+ *
+ * Other props (`width`, `height`, `noPadding`) go to the host element.
+ */
+export function VirtualList({
+  itemCount,
+  itemHeight,
+  renderItem,
+  overscan = 8,
+  ...rest
+}) {
+  // The range in view when the mounted items were last chosen
+  const [range, setRange] = useState({ start: 0, end: 0 });
+
+  const onRangeChange = useCallback(
+    (start, end) => {
+      setRange((prev) =>
+        start >= prev.start - overscan && end <= prev.end + overscan
+          ? prev
+          : { start, end },
+      );
+    },
+    [overscan],
+  );
+
+  const count = itemCount > 0 ? Math.floor(itemCount) : 0;
+  const first = Math.min(Math.max(0, range.start - overscan), count);
+  const last = Math.min(range.end + overscan, count);
+  const items = [];
+  for (let i = first; i < last; i++) {
+    items.push(React.createElement(React.Fragment, { key: i }, renderItem(i)));
+  }
+
+  return React.createElement(
+    'virtuallist',
+    { ...rest, itemCount: count, itemHeight, first, onRangeChange },
+    items,
+  );
+}
@@ -0,0 +1,29 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// Generated by tools/widgetgen.py from lib/imgui-unit/widgets.json; do not edit.
+
+/**
+ * How a generated renderer reads a prop: PLAN props are read into the
+ * node's render plan, EVENT props when the event fires.
+ */
+export const PropKind = Object.freeze({
+  PLAN: 1,
+  EVENT: 2,
+});
+
+/**
+ * The props read by the renderer of each generated widget. A prop that
+ * isn't listed can't change what the widget renders.
+ */
+export const widgetProps = Object.freeze({
+  button: Object.freeze({ onClick: PropKind.EVENT }),
+  collapsingheader: Object.freeze({ title: PropKind.PLAN }),
+  tabbar: Object.freeze({
+    id: PropKind.PLAN,
+    flags: PropKind.PLAN,
+    reorderable: PropKind.PLAN,
+  }),
+  indent: Object.freeze({}),
+});
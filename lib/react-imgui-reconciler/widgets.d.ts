@@ -0,0 +1,48 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// Generated by tools/widgetgen.py from lib/imgui-unit/widgets.json; do not edit.
+
+import type { ReactNode } from 'react';
+
+/** Props of <button>. */
+export interface ButtonProps {
+  /** The label; "Button" if empty */
+  children?: string | number | (string | number)[];
+  /** Called when the button is clicked */
+  onClick?: () => void;
+}
+
+/** Props of <collapsingheader>. */
+export interface CollapsingHeaderProps {
+  children?: ReactNode;
+  /** Header label (default: "Section") */
+  title?: string;
+}
+
+/** Props of <tabbar>. */
+export interface TabBarProps {
+  children?: ReactNode;
+  /** ImGui ID of the tab bar (default: "tabbar") */
+  id?: string;
+  /** ImGuiTabBarFlags (default: 0) */
+  flags?: number;
+  /** Let the user drag the tabs to reorder them */
+  reorderable?: boolean;
+}
+
+/** Props of <indent>. */
+export interface IndentProps {
+  children?: ReactNode;
+}
+
+/**
+ * The generated host elements, for merging into JSX.IntrinsicElements.
+ */
+export interface WidgetElements {
+  button: ButtonProps;
+  collapsingheader: CollapsingHeaderProps;
+  tabbar: TabBarProps;
+  indent: IndentProps;
+}
@@ -0,0 +1,37 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+import { useEffect, useState } from 'react';
+
+/**
+ * Hook: the window size `{ width, height }` in framebuffer pixels, updated
+ * through jslib's onWindowResize(). While the user drags the window border,
+ * the component re-renders at most once per `throttleMs` (100 by default),
+ * or with `settle` only once the size has stopped changing, instead of
+ * committing in every frame of the drag. ImGui keeps laying out the
+ * `<window>`s in between, so only layout derived from the size in React
+ * lags behind.
+ *
+ *   const { width } = useWindowSize({ throttleMs: 250 });
+ *   return width < 800 ? <CompactLayout /> : <WideLayout />;
+ */
+export function useWindowSize({ throttleMs = 100, settle = false } = {}) {
+  const [size, setSize] = useState(windowSize);
+
+  useEffect(() => {
+    // The size may have changed between the render and the effect
+    const current = windowSize();
+    setSize((prev) =>
+      prev.width === current.width && prev.height === current.height
+        ? prev
+        : current,
+    );
+    return onWindowResize((width, height) => setSize({ width, height }), {
+      throttleMs,
+      settle,
+    });
+  }, [throttleMs, settle]);
+
+  return size;
+}
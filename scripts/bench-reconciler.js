@@ -0,0 +1,140 @@
+#!/usr/bin/env node
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+import * as esbuild from 'esbuild';
+import { spawnSync } from 'child_process';
+import { readFileSync, rmSync, writeFileSync } from 'fs';
+import { tmpdir } from 'os';
+import { dirname, join, resolve } from 'path';
+import { fileURLToPath } from 'url';
+
+// Usage: bench-reconciler.js [--hermes=<path>] [--nodes=10000] [--time=1000]
+//        [--filter=<name>] [--node-pool=0] [--json=<file>]
+//        [--baseline=<file.json>] [--tolerance=0.1]
+//
+// Benchmarks react-imgui-reconciler without graphics: the workloads of
+// reconciler-bench/workloads.js (mount, update, reorder, windows) render
+// into a root whose tree is walked by a stub of the typed renderer
+// (reconciler-bench/stub-renderer.js). The suite is bundled like an app's
+// React unit (production React, `DEBUG:` statements dropped) and run under
+// Node, or with --hermes under the `hermes` CLI of the Hermes build.
+//
+// Every workload runs for `time` ms; ops/sec and the bytes allocated per
+// operation are reported. Hermes counts allocations exactly; under Node
+// they are the heap growth from a collected heap (marked `~`). --json
+// writes the results; --baseline compares them with such a file and exits
+// with status 1 if a workload's ops/sec dropped by more than `tolerance`
+// (a fraction).
+
+const args = process.argv.slice(2);
+const option = (name, fallback) => {
+  const arg = args.find((a) => a.startsWith(`--${name}=`));
+  return arg ? arg.slice(name.length + 3) : fallback;
+};
+const hermes = option('hermes', null);
+const nodes = Number(option('nodes', 10000));
+const timeMs = Number(option('time', 1000));
+const nodePool = Number(option('node-pool', 0));
+const tolerance = Number(option('tolerance', 0.1));
+const jsonFile = option('json', null);
+const baselineFile = option('baseline', null);
+
+if (
+  args.some((a) => !/^--(hermes|nodes|time|filter|node-pool|json|baseline|tolerance)=/.test(a)) ||
+  !(nodes > 0) ||
+  !(timeMs > 0) ||
+  !(nodePool >= 0) ||
+  !(tolerance >= 0)
+) {
+  console.error(
+    'Usage: bench-reconciler.js [--hermes=<path>] [--nodes=10000] [--time=1000] [--filter=<name>]'
+  );
+  console.error(
+    '                           [--node-pool=0] [--json=<file>] [--baseline=<file.json>] [--tolerance=0.1]'
+  );
+  process.exit(1);
+}
+
+const __dirname = dirname(fileURLToPath(import.meta.url));
+const libDir = resolve(__dirname, '../lib/react-imgui-reconciler');
+const bundlePath = join(tmpdir(), `reconciler-bench-${process.pid}.js`);
+
+await esbuild.build({
+  entryPoints: [join(__dirname, 'reconciler-bench/main.js')],
+  bundle: true,
+  outfile: bundlePath,
+  platform: 'neutral',
+  format: 'iife',
+  target: 'esnext',
+  alias: {
+    'react-imgui-reconciler': libDir,
+  },
+  define: {
+    'process.env.NODE_ENV': JSON.stringify('production'),
+    __BENCH_OPTIONS__: JSON.stringify({
+      nodes,
+      timeMs,
+      minOps: 5,
+      warmup: 5,
+      nodePool,
+      filter: option('filter', ''),
+    }),
+  },
+  dropLabels: ['DEBUG'],
+  logLevel: 'warning',
+});
+
+// Under Node, a young generation large enough for the biggest operation
+// keeps scavenges from hiding its allocations.
+const command = hermes
+  ? [hermes, ['-O', '-Xes6-block-scoping', bundlePath]]
+  : [process.execPath, ['--expose-gc', '--min-semi-space-size=64', '--max-semi-space-size=64', bundlePath]];
+const run = spawnSync(command[0], command[1], { encoding: 'utf8', stdio: ['ignore', 'pipe', 'inherit'] });
+rmSync(bundlePath, { force: true });
+if (run.status !== 0) {
+  process.stdout.write(run.stdout || '');
+  console.error(`bench-reconciler: ${command[0]} exited with ${run.error || `status ${run.status}`}`);
+  process.exit(1);
+}
+
+const results = [];
+for (const line of run.stdout.split('\n')) {
+  if (line.startsWith('{')) results.push(JSON.parse(line));
+  else if (line) console.log(line);
+}
+
+const kb = (r) =>
+  r.bytesPerOp === null ? 'n/a' : `${r.exactBytes ? '' : '~'}${(r.bytesPerOp / 1024).toFixed(0)} KB`;
+console.log(`Reconciler benchmarks (${hermes ? 'hermes' : `node ${process.version}`}, ${nodes} nodes)`);
+for (const r of results) {
+  console.log(
+    `  ${r.name.padEnd(8)} ${r.opsPerSec.toFixed(1).padStart(9)} ops/s ${r.msPerOp.toFixed(3).padStart(9)} ms/op ` +
+      `${kb(r).padStart(10)}/op  ${r.description}`
+  );
+}
+
+if (jsonFile) {
+  writeFileSync(jsonFile, JSON.stringify({ nodes, results }, null, 2) + '\n');
+}
+
+if (baselineFile) {
+  const baseline = JSON.parse(readFileSync(baselineFile, 'utf8'));
+  let failed = false;
+  for (const r of results) {
+    const base = baseline.results.find((b) => b.name === r.name);
+    if (!base) continue;
+    const change = r.opsPerSec / base.opsPerSec - 1;
+    const regressed = change < -tolerance;
+    failed = failed || regressed;
+    console.log(
+      `  ${regressed ? 'SLOWER' : 'ok    '} ${r.name.padEnd(8)} ${(change * 100).toFixed(1).padStart(6)}% ` +
+        `(${base.opsPerSec.toFixed(1)} -> ${r.opsPerSec.toFixed(1)} ops/s)`
+    );
+  }
+  if (baseline.nodes !== nodes) {
+    console.log(`  (baseline was run with ${baseline.nodes} nodes)`);
+  }
+  if (failed) process.exit(1);
+}
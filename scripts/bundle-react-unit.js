@@ -4,22 +4,65 @@
 // See LICENSE file for full license text
 
 import * as esbuild from 'esbuild';
-import { mkdirSync, rmSync, readFileSync, writeFileSync } from 'fs';
+import { mkdirSync, readdirSync, renameSync, rmSync, readFileSync, writeFileSync } from 'fs';
 import { dirname, resolve, join, relative } from 'path';
 import { fileURLToPath } from 'url';
 import { transformAsync } from '@babel/core';
 import { glob } from 'glob';
 
-// Usage: bundle-react-unit.js <entry-point> <output-file> [node-env]
+// Usage: bundle-react-unit.js <entry-point> <output-file> [node-env] [--lazy-unit=<name>] [--use-vendor] [--minify] [--minify-identifiers]
+//        bundle-react-unit.js --vendor <output-file> [node-env]
 // Example: bundle-react-unit.js src/react-unit/index.js build/react-bundle.js production
+//
+// With --lazy-unit, the bundle is a lazy unit for lazyUnit('<name>')
+// (lib/react-imgui-reconciler/lazy-unit.js): instead of bundling its own
+// copies of the modules in SHARED_MODULES, it uses the main bundle's, and its
+// exports are handed to __lazyUnitLoaded() once it has been evaluated.
+//
+// With --vendor, the bundle is the vendor unit of native builds: React and
+// every module of react-imgui-reconciler (vendorModules()), registered in
+// globalThis.__reactVendor. An app bundle built with --use-vendor takes
+// those modules from there instead of bundling them, so that editing the
+// app only recompiles the app.
+//
+// --minify is the profile of production bundles that hermes compiles or
+// loads as source (modes 1 and 2): syntax and whitespace minification,
+// removal of code marked /* @__PURE__ */ whose result is unused, of
+// console.debug() calls and of debugger statements. --minify-identifiers
+// also renames local identifiers. The source map is kept either way.
 
 const useReactCompiler = process.env.USE_REACT_COMPILER === 'true';
-const entryPoint = process.argv[2];
-const outfile = process.argv[3];
-const nodeEnv = process.argv[4] || 'production';
+const options = process.argv.slice(2).filter((arg) => arg.startsWith('--'));
+const args = process.argv.slice(2).filter((arg) => !arg.startsWith('--'));
+const vendor = options.includes('--vendor');
+const useVendor = options.includes('--use-vendor');
+// The vendor unit has no entry point
+if (vendor) args.unshift(null);
+const entryPoint = args[0];
+const outfile = args[1];
+const nodeEnv = args[2] || 'production';
+const lazyUnitOption = options.find((arg) => arg.startsWith('--lazy-unit='));
+const lazyUnit = lazyUnitOption ? lazyUnitOption.slice(12) : null;
+const minifyIdentifiers = options.includes('--minify-identifiers');
+const minify = minifyIdentifiers || options.includes('--minify');
 
-if (!entryPoint || !outfile) {
-  console.error('Usage: bundle-react-unit.js <entry-point> <output-file> [node-env]');
+// Modules that lazy units share with the main bundle, which registers them
+// in globalThis.__lazyUnitShared (see lazy-unit.js).
+const SHARED_MODULES = [
+  'react',
+  'react/jsx-runtime',
+  'react/compiler-runtime',
+  'react-imgui-reconciler/reconciler.js',
+];
+
+if (
+  (!entryPoint && !vendor) ||
+  !outfile ||
+  (lazyUnitOption && !/^\w+$/.test(lazyUnit)) ||
+  (vendor && (lazyUnit || useVendor))
+) {
+  console.error('Usage: bundle-react-unit.js <entry-point> <output-file> [node-env] [--lazy-unit=<name>] [--use-vendor] [--minify] [--minify-identifiers]');
+  console.error('       bundle-react-unit.js --vendor <output-file> [node-env]');
   console.error('Example: bundle-react-unit.js src/react-unit/index.js build/react-bundle.js production');
   process.exit(1);
 }
@@ -35,14 +78,19 @@ const babelConfigPath = resolve(projectRoot, '.babelrc.cjs');
 mkdirSync(dirname(outfile), { recursive: true });
 
 // Make entry point absolute for proper resolution
-const absEntryPoint = resolve(entryPoint);
+const absEntryPoint = vendor ? null : resolve(entryPoint);
 let actualEntryPoint = absEntryPoint;
 
-// If React Compiler is enabled, preprocess with Babel
-if (useReactCompiler) {
+// If React Compiler is enabled, preprocess with Babel. The vendor unit has
+// no components of its own.
+if (useReactCompiler && !vendor) {
   console.log('React Compiler: Preprocessing JSX files...');
 
-  const tempDir = join(dirname(outfile), '.babel-temp');
+  // Lazy units are bundled next to the main bundle, possibly in parallel
+  const tempDir = join(
+    dirname(outfile),
+    lazyUnit ? `.babel-temp-${lazyUnit}` : '.babel-temp',
+  );
   rmSync(tempDir, { recursive: true, force: true });
   mkdirSync(tempDir, { recursive: true });
 
@@ -76,14 +124,97 @@ if (useReactCompiler) {
   console.log('React Compiler: Preprocessing complete');
 }
 
-await esbuild.build({
-  entryPoints: [actualEntryPoint],
+// The modules of the vendor unit
+function vendorModules() {
+  const libModules = readdirSync(libDir)
+    .filter((file) => file.endsWith('.js'))
+    .sort()
+    .map((file) => `react-imgui-reconciler/${file}`);
+  return ['react', 'react/jsx-runtime', 'react/compiler-runtime', ...libModules];
+}
+
+// The entry of the vendor unit: imports every vendor module and registers
+// it by its import path. React's modules are CommonJS and registered as
+// their module.exports; the reconciler's are ES modules and registered as
+// their namespace, marked so that a default import gets `default`.
+function vendorEntry(modules) {
+  const lines = [];
+  modules.forEach((path, i) => {
+    const isEsm = path.startsWith('react-imgui-reconciler/');
+    lines.push(`import ${isEsm ? '* as ' : ''}m${i} from ${JSON.stringify(path)};`);
+    if (isEsm) {
+      lines.push(`Object.defineProperty(m${i}, '__esModule', { value: true });`);
+    }
+  });
+  lines.push('globalThis.__reactVendor = {');
+  modules.forEach((path, i) => lines.push(`  ${JSON.stringify(path)}: m${i},`));
+  lines.push('};');
+  return lines.join('\n') + '\n';
+}
+
+// Resolves `modules` to the instances that another unit (`owner`)
+// registered in globalThis[`registry`], instead of bundling copies. Other
+// imports of React or the reconciler are errors: a second copy would not
+// share their state.
+function externalModulesPlugin(modules, registry, unitKind, owner) {
+  return {
+    name: `external-modules-${registry}`,
+    setup(build) {
+      build.onResolve({ filter: /^react(-imgui-reconciler)?(\/|$)/ }, (args) => {
+        if (modules.includes(args.path)) {
+          return { path: args.path, namespace: registry };
+        }
+        return {
+          errors: [{
+            text: `${unitKind} can only use ${modules.join(', ')} ` +
+              `from ${owner}, not '${args.path}'`,
+          }],
+        };
+      });
+      build.onLoad({ filter: /.*/, namespace: registry }, (args) => ({
+        contents:
+          `module.exports = globalThis.${registry}[${JSON.stringify(args.path)}];`,
+        loader: 'js',
+      }));
+    },
+  };
+}
+
+// Resolves the shared modules of a lazy unit to the main bundle's instances
+const sharedModulesPlugin = externalModulesPlugin(
+  SHARED_MODULES,
+  '__lazyUnitShared',
+  'Lazy units',
+  'the main bundle',
+);
+
+const result = await esbuild.build({
+  ...(vendor ? {
+    stdin: {
+      contents: vendorEntry(vendorModules()),
+      resolveDir: projectRoot,
+      sourcefile: 'react-vendor-entry.js',
+      loader: 'js',
+    },
+  } : {
+    entryPoints: [actualEntryPoint],
+  }),
   bundle: true,
   outfile: outfile,
+  // Written below
+  write: false,
   platform: 'neutral',
   format: 'iife',
   target: 'esnext',
-  minify: false,
+  minifySyntax: minify,
+  minifyWhitespace: minify,
+  minifyIdentifiers: minifyIdentifiers,
+  // Unused results of /* @__PURE__ */ calls are dropped by tree shaking
+  ignoreAnnotations: false,
+  ...(minify ? {
+    pure: ['console.debug'],
+    drop: ['debugger'],
+  } : {}),
   sourcemap: true,
   // When React Compiler is enabled, entry point is in temp dir,
   // so we need to ensure module resolution works from project root
@@ -101,6 +232,35 @@ await esbuild.build({
   define: {
     'process.env.NODE_ENV': JSON.stringify(nodeEnv),
   },
+  // Strip `DEBUG:` labeled statements (debug logging) from production builds
+  dropLabels: nodeEnv === 'production' ? ['DEBUG'] : [],
+  ...(lazyUnit ? {
+    plugins: [sharedModulesPlugin],
+    globalName: '__lazyUnitExports',
+    footer: { js: `__lazyUnitLoaded(${JSON.stringify(lazyUnit)}, __lazyUnitExports);` },
+  } : useVendor ? {
+    plugins: [externalModulesPlugin(
+      vendorModules(), '__reactVendor', 'Apps built with the vendor unit', 'it')],
+  } : {}),
 });
 
-console.log('React unit bundle created:', outfile, `(NODE_ENV=${nodeEnv}, React Compiler=${useReactCompiler})`);
+// Each file is written next to its path and renamed over it, the source map
+// before the bundle: a mode 2 app hot reloading the bundle
+// (sappConfig.hot_reload) never reads a partial file.
+const bundlePath = resolve(outfile);
+const outputs = result.outputFiles
+  .slice()
+  .sort((a, b) => (a.path === bundlePath) - (b.path === bundlePath));
+for (const output of outputs) {
+  const tmpPath = `${output.path}.${process.pid}`;
+  writeFileSync(tmpPath, output.contents);
+  renameSync(tmpPath, output.path);
+}
+
+console.log(
+  lazyUnit ? `Lazy unit '${lazyUnit}' bundle created:` :
+    vendor ? 'React vendor unit bundle created:' : 'React unit bundle created:',
+  outfile,
+  `(NODE_ENV=${nodeEnv}, React Compiler=${useReactCompiler}` +
+    (minify ? `, minified${minifyIdentifiers ? ' with identifiers' : ''})` : ')'),
+);
@@ -0,0 +1,68 @@
+#!/usr/bin/env node
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+import { readFileSync } from 'fs';
+
+// Usage: compare-bench-report.js <baseline.json> <report.json> [--tolerance=0.1] [--min-ms=0.05]
+// Compares two headless --report files and exits with status 1 if a frame
+// or phase percentile got slower than the baseline by more than `tolerance`
+// (a fraction) and `min-ms`, which keeps sub-noise differences from failing.
+
+const args = process.argv.slice(2);
+const files = args.filter((arg) => !arg.startsWith('--'));
+let tolerance = 0.1;
+let minMs = 0.05;
+for (const arg of args) {
+  if (arg.startsWith('--tolerance=')) tolerance = Number(arg.slice(12));
+  else if (arg.startsWith('--min-ms=')) minMs = Number(arg.slice(9));
+}
+
+if (files.length !== 2 || !(tolerance >= 0) || !(minMs >= 0)) {
+  console.error(
+    'Usage: compare-bench-report.js <baseline.json> <report.json> [--tolerance=0.1] [--min-ms=0.05]',
+  );
+  process.exit(1);
+}
+
+const baseline = JSON.parse(readFileSync(files[0], 'utf8'));
+const current = JSON.parse(readFileSync(files[1], 'utf8'));
+
+// Label -> percentiles of every measurement of a report.
+function measurements(report) {
+  const result = { frame: report.frame, reconciliation: report.reactCommit };
+  for (const [name, stats] of Object.entries(report.phases || {})) {
+    result[name] = stats;
+  }
+  return result;
+}
+
+const base = measurements(baseline);
+const cur = measurements(current);
+let regressions = 0;
+console.log(
+  `Tolerance ${(tolerance * 100).toFixed(0)}%, at least ${minMs}ms` +
+    (baseline.frames !== current.frames
+      ? ` (frames: ${baseline.frames} vs ${current.frames})`
+      : ''),
+);
+for (const name of Object.keys(cur)) {
+  if (!base[name] || !cur[name]) continue;
+  for (const key of ['p50', 'p95', 'p99']) {
+    const before = base[name][key];
+    const after = cur[name][key];
+    if (typeof before !== 'number' || typeof after !== 'number') continue;
+    const slower = after - before > Math.max(before * tolerance, minMs);
+    if (slower) regressions++;
+    console.log(
+      `${slower ? 'SLOWER' : 'ok    '} ${name} ${key}: ` +
+        `${before.toFixed(3)}ms -> ${after.toFixed(3)}ms`,
+    );
+  }
+}
+
+if (regressions > 0) {
+  console.error(`${regressions} regression(s) against ${files[0]}`);
+  process.exit(1);
+}
@@ -0,0 +1,86 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// The parts of the runtime that react-imgui-reconciler expects, for running
+// it without jslib and the native runtime: under Node or the plain `hermes`
+// CLI, which has print() but no console, performance or setImmediate. Must
+// be imported before the reconciler, which uses some of them when it loads.
+
+if (typeof globalThis.console === 'undefined') {
+  const log = (...args) => print(args.join(' '));
+  globalThis.console = { log, info: log, warn: log, error: log, debug: log };
+}
+
+if (typeof globalThis.performance === 'undefined') {
+  // Millisecond resolution: the suite runs every workload for long enough
+  globalThis.performance = { now: () => Date.now() };
+}
+
+// Timers for the React scheduler and scheduleTimeout(). The suite commits
+// synchronously (legacy roots) and runs what is left after every operation
+// with drainTasks(), so the host's own timers are not needed.
+const tasks = [];
+let nextTaskId = 1;
+
+function queueTask(fn, args) {
+  const id = nextTaskId++;
+  tasks.push({ id, fn, args });
+  return id;
+}
+
+function cancelTask(id) {
+  for (let i = 0; i < tasks.length; i++) {
+    if (tasks[i].id === id) {
+      tasks.splice(i, 1);
+      return;
+    }
+  }
+}
+
+globalThis.setTimeout = (fn, ms, ...args) => queueTask(fn, args);
+globalThis.clearTimeout = cancelTask;
+globalThis.setImmediate = (fn, ...args) => queueTask(fn, args);
+globalThis.clearImmediate = cancelTask;
+globalThis.requestAnimationFrame = (fn) => queueTask(fn, [performance.now()]);
+
+/**
+ * Run the queued timer callbacks, including those they queue.
+ */
+export function drainTasks() {
+  while (tasks.length) {
+    const task = tasks.shift();
+    task.fn(...task.args);
+  }
+}
+
+// Inactive trace markers, as in jslib while no capture runs
+globalThis.trace = {
+  capturing: false,
+  begin() {},
+  end() {},
+  counter() {},
+};
+
+// Commit statistics are kept but never read here: a sample counter is
+// enough for perf-stats.js.
+globalThis.RollingStats = class {
+  constructor() {
+    this.count = 0;
+  }
+  add() {
+    this.count++;
+  }
+  average() {
+    return 0;
+  }
+  max() {
+    return 0;
+  }
+  percentile() {
+    return 0;
+  }
+};
+
+// Large updates are what the suite measures; don't warn about them
+globalThis.sappConfig = { commit_warn_mutations: 0 };
@@ -0,0 +1,97 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// Entry point of the reconciler benchmark bundle, built and run by
+// scripts/bench-reconciler.js. Prints one JSON line per workload.
+import { drainTasks } from './env.js';
+import { renderFrame } from './stub-renderer.js';
+import { createWorkloads } from './workloads.js';
+import { createRoot, render, setNodePoolCapacity } from 'react-imgui-reconciler/reconciler.js';
+
+// Set by bench-reconciler.js at build time
+const options = __BENCH_OPTIONS__;
+
+const engine = typeof HermesInternal === 'object' ? 'hermes' : 'node';
+
+// Bytes allocated by the JS heap during an operation. Hermes counts them;
+// under Node (--expose-gc) the heap is collected before the operation and
+// its growth read after, which undercounts if a scavenge runs in between
+// (bench-reconciler.js makes the young generation large enough).
+function hermesAllocated() {
+  return HermesInternal.getInstrumentedStats().js_totalAllocatedBytes;
+}
+
+function nodeHeapUsed() {
+  return process.memoryUsage().heapUsed;
+}
+
+const allocations =
+  engine === 'hermes' && typeof HermesInternal.getInstrumentedStats === 'function'
+    ? { exact: true, start: hermesAllocated, end: hermesAllocated }
+    : typeof gc === 'function' && typeof process === 'object'
+      ? {
+          exact: false,
+          start() {
+            gc();
+            return nodeHeapUsed();
+          },
+          end: nodeHeapUsed,
+        }
+      : null;
+
+setNodePoolCapacity(options.nodePool);
+const root = createRoot({ name: 'bench' });
+
+/**
+ * Run `workload` for at least `options.timeMs` and `options.minOps`
+ * operations, after `options.warmup` untimed ones.
+ */
+function measure(workload) {
+  workload.setup();
+  drainTasks();
+  renderFrame();
+
+  let i = 0;
+  for (; i < options.warmup; i++) {
+    workload.run(i);
+    drainTasks();
+    renderFrame();
+    if (workload.reset) workload.reset();
+  }
+
+  let ops = 0;
+  let elapsed = 0;
+  let bytes = 0;
+  let plans = 0;
+  while (elapsed < options.timeMs || ops < options.minOps) {
+    const before = allocations ? allocations.start() : 0;
+    const start = performance.now();
+    workload.run(i++);
+    elapsed += performance.now() - start;
+    if (allocations) bytes += Math.max(0, allocations.end() - before);
+    ops++;
+    drainTasks();
+    plans += renderFrame();
+    if (workload.reset) workload.reset();
+  }
+
+  render(null, root);
+  drainTasks();
+  return {
+    name: workload.name,
+    description: workload.description,
+    engine,
+    ops,
+    opsPerSec: (ops * 1000) / elapsed,
+    msPerOp: elapsed / ops,
+    bytesPerOp: allocations ? bytes / ops : null,
+    exactBytes: allocations ? allocations.exact : false,
+    plansPerOp: plans / ops,
+  };
+}
+
+for (const workload of createWorkloads(root, options.nodes)) {
+  if (options.filter && !workload.name.includes(options.filter)) continue;
+  console.log(JSON.stringify(measure(workload)));
+}
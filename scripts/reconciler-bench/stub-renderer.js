@@ -0,0 +1,61 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// A stand-in for the typed imgui unit: it walks the roots the way
+// renderer.js does and rebuilds the plans and labels that a commit
+// dropped, but draws nothing. The tree operations stay the JS ones of
+// tree-node.js, as no native treeOps are installed.
+
+/**
+ * The imgui unit's releaseNode(), for removed subtrees: their plans,
+ * labels and native slots are dropped.
+ */
+function releaseNode(node) {
+  node.plan = null;
+  node.nativeSlots = null;
+  if (node.text === undefined) {
+    node.label = null;
+    node.state = null;
+    for (let c = node.firstChild; c; c = c.nextSibling) releaseNode(c);
+  }
+}
+
+globalThis.imguiUnit = { releaseNode };
+
+// Nodes whose plan had to be rebuilt by the last renderFrame()
+let rebuiltPlans = 0;
+
+function renderNode(node) {
+  if (node.text !== undefined) {
+    if (node.plan === null) {
+      rebuiltPlans++;
+      node.plan = { text: node.text };
+    }
+    return;
+  }
+  if (node.plan === null) {
+    rebuiltPlans++;
+    // Like the renderer's label cache: the joined text children
+    let label = '';
+    for (let c = node.firstChild; c; c = c.nextSibling) {
+      if (c.text !== undefined) label += c.text;
+    }
+    node.label = label;
+    node.plan = { tag: node.tag, props: node.props };
+  }
+  for (let c = node.firstChild; c; c = c.nextSibling) renderNode(c);
+}
+
+/**
+ * Render every root once. Returns the number of plans that were rebuilt.
+ */
+export function renderFrame() {
+  rebuiltPlans = 0;
+  const containers = globalThis.imguiRootContainers || [];
+  for (let i = 0; i < containers.length; i++) {
+    const children = containers[i].rootChildren;
+    for (let j = 0; j < children.length; j++) renderNode(children[j]);
+  }
+  return rebuiltPlans;
+}
@@ -0,0 +1,109 @@
+// Copyright (c) Tzvetan Mikov and contributors
+// SPDX-License-Identifier: MIT
+// See LICENSE file for full license text
+
+// The workloads of the reconciler benchmark suite. Each one renders host
+// elements straight into a legacy root, which commits synchronously, so an
+// operation is one React render and commit: creating the elements, diffing
+// the props and the host config's mutations. A row is five nodes: a
+// <group> with a <text> and a <button>, each with a text child.
+//
+// setup() and reset() are not timed; run(i) is operation i.
+import React from 'react';
+import { render } from 'react-imgui-reconciler/reconciler.js';
+
+const h = React.createElement;
+const COLORS = ['#FFFFFF', '#FF8080', '#80FF80', '#8080FF'];
+const NODES_PER_ROW = 5;
+
+function noop() {}
+
+function makeRows(count, prefix) {
+  const rows = new Array(count);
+  for (let i = 0; i < count; i++) {
+    rows[i] = { id: `${prefix}${i}`, label: `Row ${i}`, color: COLORS[0] };
+  }
+  return rows;
+}
+
+function rowElement(row) {
+  return h(
+    'group',
+    { key: row.id },
+    h('text', { color: row.color }, row.label),
+    h('button', { onClick: noop }, 'Edit')
+  );
+}
+
+function windowElement(title, rows) {
+  return h('window', { key: title, title, defaultWidth: 400 }, rows.map(rowElement));
+}
+
+/**
+ * The workloads for trees of about `nodes` nodes, rendered into `root`.
+ */
+export function createWorkloads(root, nodes) {
+  const rowCount = Math.max(1, Math.round(nodes / NODES_PER_ROW));
+  let rows = null;
+
+  return [
+    {
+      name: 'mount',
+      description: `Mount a window of ${rowCount * NODES_PER_ROW} nodes`,
+      setup() {
+        rows = makeRows(rowCount, 'r');
+      },
+      run() {
+        render(windowElement('Bench', rows), root);
+      },
+      reset() {
+        render(null, root);
+      },
+    },
+    {
+      name: 'update',
+      description: `Change a prop of 10% of ${rowCount} rows`,
+      setup() {
+        rows = makeRows(rowCount, 'r');
+        render(windowElement('Bench', rows), root);
+      },
+      run(i) {
+        // A different tenth of the rows every time, with a new color
+        const next = rows.slice();
+        const color = COLORS[(Math.floor(i / 10) % (COLORS.length - 1)) + 1];
+        for (let j = i % 10; j < next.length; j += 10) {
+          next[j] = { id: next[j].id, label: next[j].label, color };
+        }
+        rows = next;
+        render(windowElement('Bench', rows), root);
+      },
+    },
+    {
+      name: 'reorder',
+      description: `Reverse a keyed list of ${rowCount} rows`,
+      setup() {
+        rows = makeRows(rowCount, 'r');
+        render(windowElement('Bench', rows), root);
+      },
+      run() {
+        rows = rows.slice().reverse();
+        render(windowElement('Bench', rows), root);
+      },
+    },
+    {
+      name: 'windows',
+      description: `Mount or unmount 10 windows of ${Math.ceil(rowCount / 10) * NODES_PER_ROW} nodes`,
+      setup() {
+        rows = makeRows(Math.ceil(rowCount / 10), 'r');
+        render(null, root);
+      },
+      run(i) {
+        const windows = [];
+        if (i % 2 === 0) {
+          for (let w = 0; w < 10; w++) windows.push(windowElement(`Window ${w}`, rows));
+        }
+        render(h(React.Fragment, null, windows), root);
+      },
+    },
+  ];
+}
@@ -109,6 +109,28 @@ def need_cwrap(id):
     return id_to_element[id].tag == "Struct" or id_to_element[id].tag == "Union"
 
 
+# Mapping from a struct ID to its field names, for small structs made only of
+# floats (ImVec2, ImVec4). Such structs can be passed to the generated
+# "_flat" wrappers as individual scalars instead of through a pointer.
+flat_struct_fields = {}
+
+
+# Returns the field names if a type can be passed flattened, otherwise None.
+def flat_fields(id):
+    elem = id_to_element[id]
+    if elem.tag != "Struct":
+        return None
+    return flat_struct_fields.get(elem.get("id"))
+
+
+# Whether any argument of a function can be flattened.
+def has_flat_args(func):
+    for arg in func.findall(".//Argument"):
+        if flat_fields(arg.get("type")):
+            return True
+    return False
+
+
 # Get the filename from the command line arguments
 if len(sys.argv) < 3:
     print("Usage: ffigen.py <cwrap|js> <filename> [filter filenames]")
@@ -164,6 +186,19 @@ for typedef in root.findall(".//Typedef"):
 for cv in root.findall(".//CvQualifiedType"):
     id_to_element[cv.get("id")] = id_to_element[cv.get("type")]
 
+# Find the structs whose fields are all floats.
+for struct in root.findall(".//Struct"):
+    struct_id = struct.get("id")
+    fields = [f for f in root.findall(".//Field") if f.get("context") == struct_id]
+    if not fields or len(fields) > 4:
+        continue
+    if all(
+        id_to_element[f.get("type")].tag == "FundamentalType"
+        and id_to_element[f.get("type")].get("name") == "float"
+        for f in fields
+    ):
+        flat_struct_fields[struct_id] = [f.get("name") for f in fields]
+
 if mode == "js":
     # Generate JS declarations
     for func in root.findall(".//Function"):
@@ -213,6 +248,32 @@ if mode == "js":
         )
         print(js_declaration)
 
+        # Also emit a variant that accepts float-only struct arguments as
+        # scalars, so callers don't need a temporary struct.
+        if has_flat_args(func):
+            flat_args = []
+            if return_cwrap:
+                flat_args.append(f"_out: c_ptr")
+            for arg in func.findall(".//Argument"):
+                arg_name = arg.get("name") or f"{len(flat_args)}"
+                fields = flat_fields(arg.get("type"))
+                if fields:
+                    for field in fields:
+                        flat_args.append(f"_{arg_name}_{field}: c_float")
+                else:
+                    flat_args.append(f"_{arg_name}: {to_sh_name(arg.get('type'))}")
+            print(
+                "const _"
+                + name
+                + "_flat = $SHBuiltin.extern_c({}, function "
+                + name
+                + "_flat("
+                + ", ".join(flat_args)
+                + "): "
+                + return_type
+                + " { throw 0; });"
+            )
+
     # Generate struct and union sizes.
     for type in ["Struct", "Union"]:
         for elem in root.findall(".//" + type):
@@ -224,7 +285,12 @@ if mode == "js":
                 size = int(size) // 8
                 print(f"const _sizeof_{name} = {size};")
 
-    # Generate struct accessors
+    # Generate struct accessors. They are "inline" JS functions over the
+    # _sh_ptr_* helpers, which ffi_helpers.js binds to static inline
+    # functions in ffi_helpers.h, so in native builds each field access
+    # compiles to a single load or store at a constant offset. Keep them
+    # that way: emitting them as extern_c declarations here would turn them
+    # into out-of-line calls through js_externs_cwrap.c.
     for field in root.findall(".//Field"):
         if field.get("file") not in allowed_file_ids:
             continue
@@ -324,3 +390,34 @@ elif mode == "cwrap":
         print(
             f"{return_type} {func_name}_cwrap({', '.join(params)}){{\n  " + body + "}"
         )
+
+        if not has_flat_args(func):
+            continue
+
+        # The "_flat" variant takes float-only structs as scalars and
+        # rebuilds them with a compound literal.
+        params = []
+        args = []
+        n = 0
+        if need_cwrap(return_id):
+            params.append(to_c_name(return_id) + f"* a{n}")
+            n += 1
+        for arg in func.findall(".//Argument"):
+            fields = flat_fields(arg.get("type"))
+            if fields:
+                params.extend(f"float a{n}_{field}" for field in fields)
+                field_args = ", ".join(f"a{n}_{field}" for field in fields)
+                args.append(f"({to_c_name(arg.get('type'))}){{{field_args}}}")
+            elif need_cwrap(arg.get("type")):
+                params.append(to_c_name(arg.get("type")) + f"* a{n}")
+                args.append(f"*a{n}")
+            else:
+                params.append(to_c_name(arg.get("type")) + f" a{n}")
+                args.append(f"a{n}")
+            n += 1
+
+        body = ("*a0 = " if need_cwrap(return_id) else "return ") + func_name
+        body += "(" + ", ".join(args) + ");\n"
+        print(
+            f"{return_type} {func_name}_flat({', '.join(params)}){{\n  " + body + "}"
+        )
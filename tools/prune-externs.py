@@ -0,0 +1,227 @@
+#!/usr/bin/env python3
+# Copyright (c) Tzvetan Mikov and contributors
+# SPDX-License-Identifier: MIT
+# See LICENSE file for full license text
+
+"""
+Prune the generated FFI bindings of the imgui unit down to the symbols that
+are actually referenced.
+
+js_externs.js declares every function, struct size, field accessor and
+constant of the bundled headers. Every extern_c declaration becomes a native
+function object created at unit initialization, so most apps pay for about a
+thousand bindings they never call. This script scans the unit sources (and an
+optional allowlist) for identifiers and writes copies of js_externs.js and
+js_externs_cwrap.c that only contain the referenced declarations.
+
+Usage:
+  prune-externs.py --externs js_externs.js --cwrap js_externs_cwrap.c \\
+      --out-externs pruned.js --out-cwrap pruned.c \\
+      [--allowlist symbols.txt] source.js...
+
+The allowlist contains one JS binding name per line (e.g. `_igPlotLines`);
+blank lines and lines starting with `#` are ignored.
+
+With --out-sources DIR, the generated numeric constants (`const _X = 4;` in
+js_externs.js and in the sources, e.g. sapp.js) are also replaced by their
+values in the sources, which are written to DIR. The constants are globals
+otherwise, looked up at runtime, while shermes folds a literal. Their
+declarations are pruned like any other unreferenced binding; definitions in
+the sources become blank lines, so that line numbers stay the same.
+
+--define NAME=VALUE sets the value of a numeric constant of the sources,
+overriding its definition, e.g. `--define _IMGUI_UNIT_CHECKS=0` to compile
+out the development checks of renderer.js.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+IDENT_RE = re.compile(r"[A-Za-z_$][\w$]*")
+CONST_RE = re.compile(r"^const (\w+) = ")
+FUNC_RE = re.compile(r"^function (\w+)\(")
+EXTERN_NAME_RE = re.compile(r"extern_c\(\{[^}]*\}, function (\w+)\(")
+CWRAP_RE = re.compile(r"^[^\s].*?\b(\w+)\(.*\)\{$")
+NUMERIC_CONST_RE = re.compile(r"^const (_\w+) = (-?[0-9][0-9a-fA-Fx.e]*);$")
+# A use of a constant: not a property name and not part of a longer name.
+CONST_USE_RE = re.compile(r"(?<![\w$.])_\w+(?![\w$])")
+
+
+def read_identifiers(text):
+    return set(IDENT_RE.findall(text))
+
+
+def parse_declarations(lines):
+    """Split js_externs.js into top-level declarations: (name, text)."""
+    decls = []
+    i = 0
+    while i < len(lines):
+        line = lines[i]
+        m = CONST_RE.match(line)
+        if m:
+            decls.append((m.group(1), line))
+            i += 1
+            continue
+        m = FUNC_RE.match(line)
+        if m:
+            # Accessor functions end with a closing brace at column 0.
+            start = i
+            while not lines[i].startswith("}"):
+                i += 1
+            decls.append((m.group(1), "".join(lines[start : i + 1])))
+            i += 1
+            continue
+        # Blank lines and anything else are kept as-is.
+        decls.append((None, line))
+        i += 1
+    return decls
+
+
+def prune_externs(decls, referenced):
+    """Keep the declarations whose names are referenced, transitively."""
+    keep = set()
+    pending = set(referenced)
+    names = {name for name, _ in decls if name}
+    while pending:
+        name = pending.pop()
+        if name in keep or name not in names:
+            continue
+        keep.add(name)
+        for name2, text in decls:
+            if name2 == name:
+                pending |= read_identifiers(text) & names
+    return keep
+
+
+def numeric_constants(lines):
+    """Map the name of every generated numeric constant to its value."""
+    constants = {}
+    for line in lines:
+        m = NUMERIC_CONST_RE.match(line.rstrip("\n"))
+        if m:
+            constants[m.group(1)] = m.group(2)
+    return constants
+
+
+def inline_constants(text, constants, annotate=False):
+    """Replace the uses of `constants` in `text` with their values, followed
+    by the name in a comment if `annotate` is set."""
+
+    def value(m):
+        name = m.group(0)
+        if name not in constants:
+            return name
+        literal = constants[name]
+        if literal.startswith("-"):
+            literal = "(" + literal + ")"
+        return literal + " /* " + name + " */" if annotate else literal
+
+    return CONST_USE_RE.sub(value, text)
+
+
+def prune_cwrap(lines, c_names):
+    """Keep the header of the C wrapper file and the listed wrappers."""
+    out = []
+    i = 0
+    while i < len(lines):
+        m = CWRAP_RE.match(lines[i])
+        if m and lines[i].rstrip().endswith("){"):
+            # Wrappers are generated as three lines: signature, body, brace.
+            end = i
+            while not lines[end].startswith("}"):
+                end += 1
+            if m.group(1) in c_names:
+                out.extend(lines[i : end + 1])
+            i = end + 1
+            continue
+        out.append(lines[i])
+        i += 1
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[1])
+    parser.add_argument("--externs", required=True)
+    parser.add_argument("--cwrap", required=True)
+    parser.add_argument("--out-externs", required=True)
+    parser.add_argument("--out-cwrap", required=True)
+    parser.add_argument("--allowlist")
+    parser.add_argument("--out-sources")
+    parser.add_argument("--define", action="append", default=[])
+    parser.add_argument("sources", nargs="+")
+    args = parser.parse_args()
+
+    with open(args.externs, "r") as f:
+        extern_lines = f.readlines()
+    sources = {}
+    for source in args.sources:
+        with open(source, "r") as f:
+            sources[source] = f.readlines()
+
+    constants = {}
+    if args.out_sources:
+        constants = numeric_constants(extern_lines)
+        for lines in sources.values():
+            constants.update(numeric_constants(lines))
+        for define in args.define:
+            name, sep, literal = define.partition("=")
+            if not sep or not NUMERIC_CONST_RE.match(f"const {name} = {literal};"):
+                parser.error(f"--define: expected _NAME=NUMBER, got '{define}'")
+            constants[name] = literal
+        os.makedirs(args.out_sources, exist_ok=True)
+        for source, lines in sources.items():
+            lines = [
+                "\n" if NUMERIC_CONST_RE.match(line.rstrip("\n")) else line
+                for line in lines
+            ]
+            out = os.path.join(args.out_sources, os.path.basename(source))
+            with open(out, "w") as f:
+                f.writelines(inline_constants(l, constants, True) for l in lines)
+            sources[source] = [inline_constants(l, constants) for l in lines]
+
+    referenced = set()
+    for lines in sources.values():
+        referenced |= read_identifiers("".join(lines))
+    if args.allowlist:
+        with open(args.allowlist, "r") as f:
+            for line in f:
+                line = line.strip()
+                if line and not line.startswith("#"):
+                    referenced.add(line)
+
+    decls = parse_declarations(extern_lines)
+    if constants:
+        decls = [
+            (name, text)
+            if name is None or NUMERIC_CONST_RE.match(text.rstrip("\n"))
+            else (name, inline_constants(text, constants))
+            for name, text in decls
+        ]
+    keep = prune_externs(decls, referenced)
+
+    c_names = set()
+    with open(args.out_externs, "w") as f:
+        for name, text in decls:
+            if name is None or name in keep:
+                f.write(text)
+                m = EXTERN_NAME_RE.search(text)
+                if m:
+                    c_names.add(m.group(1))
+
+    with open(args.cwrap, "r") as f:
+        cwrap_lines = f.readlines()
+    with open(args.out_cwrap, "w") as f:
+        f.writelines(prune_cwrap(cwrap_lines, c_names))
+
+    total = sum(1 for name, _ in decls if name)
+    print(
+        f"prune-externs: kept {len(keep)} of {total} bindings"
+        + (f", inlined {len(constants)} constants" if constants else ""),
+        file=sys.stderr,
+    )
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,363 @@
+#!/usr/bin/env python3
+# Copyright (c) Tzvetan Mikov and contributors
+# SPDX-License-Identifier: MIT
+# See LICENSE file for full license text
+
+"""
+Break the size of an app executable down by library and by compiled unit.
+
+The sizes come from the linker map written next to the executable
+(add_react_imgui_app() passes -Map/-map to the linker): every input section
+is attributed to the archive and object it came from, and the compiled
+units are recognized by their object names (jslib-unit.o, imgui-unit.o,
+react-unit.o, ...). GNU ld, lld and ld64 maps are understood.
+
+Usage:
+  size-report.py --map app.map --executable app \\
+      [--output app.size.json] [--history app.jsonl] [--baseline old.json]
+
+--output writes the report as JSON. --history appends a one-line summary
+(time, git revision, totals by library and unit) to a JSON Lines file, so
+that the size can be followed over time. --baseline compares with a report
+written earlier by --output and prints the differences.
+
+Sizes are split into text, rodata, data and bss; bss takes no space in the
+file. Shared libraries (e.g. a system ICU) aren't part of the executable and
+don't appear.
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+import time
+
+KINDS = ("text", "rodata", "data", "bss", "other")
+
+# Object name -> compiled unit
+UNIT_PATTERNS = [
+    (re.compile(r"^jslib-unit\.o(bj)?$"), "jslib"),
+    (re.compile(r"^imgui(-specialized)?-unit\.o(bj)?$"), "imgui"),
+    (re.compile(r"^js_externs_cwrap(\.pruned)?\.c\.o(bj)?$"), "imgui bindings"),
+    (re.compile(r"^react-unit\.o(bj)?$"), "react"),
+    (re.compile(r"^react-vendor-unit\.o(bj)?$"), "react vendor"),
+    (re.compile(r"^react-lazy-(\w+)\.o(bj)?$"), "lazy:{0}"),
+    (re.compile(r"^worker-(\w+)\.o(bj)?$"), "worker:{0}"),
+]
+NATIVE_UNIT = "native"
+
+# Output sections that aren't loaded
+SKIPPED_SECTION_RE = re.compile(
+    r"^(/DISCARD/|\.debug|\.comment|\.note\.GNU-stack|\.gnu\.build\.attributes"
+    r"|\.stab|\.symtab|\.strtab|\.shstrtab|\.gnu_debuglink)"
+)
+ARCHIVE_MEMBER_RE = re.compile(r"^(.*)\(([^()]*)\)$")
+
+
+def section_kind(name):
+    """The kind of an ELF section."""
+    if name.startswith((".tbss", ".bss")) or name == "COMMON":
+        return "bss"
+    if name.startswith((".text", ".init", ".fini", ".plt")):
+        return "text"
+    if name.startswith((".rodata", ".eh_frame", ".gcc_except_table", ".interp",
+                        ".note", ".hash", ".gnu.hash", ".dynsym", ".dynstr",
+                        ".gnu.version", ".rela", ".rel.")):
+        return "rodata"
+    if name.startswith((".data", ".tdata", ".got", ".init_array", ".fini_array",
+                        ".preinit_array", ".dynamic", ".ctors", ".dtors")):
+        return "data"
+    return "other"
+
+
+def macho_kind(segment, section):
+    """The kind of a Mach-O section."""
+    if section in ("__bss", "__common", "__thread_bss"):
+        return "bss"
+    if segment == "__TEXT":
+        if section in ("__text", "__stubs", "__stub_helper"):
+            return "text"
+        return "rodata"
+    if segment.startswith("__DATA"):
+        return "data"
+    return "other"
+
+
+def split_input(path):
+    """Split an input file into (archive, object); archive is None for an
+    object linked directly."""
+    match = ARCHIVE_MEMBER_RE.match(path)
+    if match:
+        return match.group(1), match.group(2)
+    return None, path
+
+
+def parse_gnu_map(lines):
+    """Parse a GNU ld map: yields (output section, input section, file, size)."""
+    out = None
+    started = False
+    pending = None
+    for line in lines:
+        line = line.rstrip("\n")
+        if not started:
+            started = line.startswith("Linker script and memory map")
+            continue
+        if not line.strip():
+            continue
+        if not line[0].isspace():
+            # An output section: ".text  0x...  0x..." or a lone name
+            out = line.split()[0]
+            pending = None
+            continue
+        if out is None or SKIPPED_SECTION_RE.match(out):
+            continue
+        fields = line.split()
+        if pending is None and len(fields) == 1 and not fields[0].startswith("0x"):
+            # A long input section name, with the rest on the next line
+            pending = fields[0]
+            continue
+        if pending is not None:
+            fields = [pending] + fields
+            pending = None
+        if len(fields) < 4 or not fields[1].startswith("0x") or not fields[2].startswith("0x"):
+            continue
+        section = fields[0]
+        if section == "*fill*" or section.startswith("*("):
+            continue
+        size = int(fields[2], 16)
+        if size:
+            yield out, section, " ".join(fields[3:]), size
+
+
+def parse_lld_map(lines):
+    """Parse an lld map: yields (output section, input section, file, size)."""
+    header = next(lines)
+    out_col = header.index("Out")
+    in_col = header.index("In ")
+    out = None
+    for line in lines:
+        line = line.rstrip("\n")
+        fields = line.split(None, 4)
+        if len(fields) < 5:
+            continue
+        rest = fields[4]
+        col = len(line) - len(rest)
+        if col <= out_col:
+            out = rest
+            continue
+        if col > in_col or SKIPPED_SECTION_RE.match(out):
+            continue
+        size = int(fields[2], 16)
+        # "<file>:(<section>)"
+        idx = rest.rfind(":(")
+        if size and idx >= 0:
+            yield out, rest[idx + 2:-1], rest[:idx], size
+
+
+def parse_ld64_map(lines):
+    """Parse an ld64 map: yields (kind, file, size)."""
+    files = {}
+    sections = []
+    part = None
+    for line in lines:
+        line = line.rstrip("\n")
+        if line.startswith("#"):
+            if line.startswith("# Object files:"):
+                part = "objects"
+            elif line.startswith("# Sections:"):
+                part = "sections"
+            elif line.startswith("# Symbols:"):
+                part = "symbols"
+            elif line.startswith("# Dead Stripped Symbols:"):
+                part = None
+            continue
+        if part == "objects":
+            match = re.match(r"^\[\s*(\d+)\]\s+(.*)$", line)
+            if match:
+                files[int(match.group(1))] = match.group(2)
+        elif part == "sections":
+            fields = line.split()
+            if len(fields) >= 4:
+                sections.append((int(fields[0], 16), int(fields[1], 16),
+                                 macho_kind(fields[2], fields[3])))
+        elif part == "symbols":
+            match = re.match(r"^(0x[0-9A-Fa-f]+)\s+(0x[0-9A-Fa-f]+)\s+\[\s*(\d+)\]", line)
+            if not match:
+                continue
+            addr = int(match.group(1), 16)
+            size = int(match.group(2), 16)
+            kind = "other"
+            for start, length, k in sections:
+                if start <= addr < start + length:
+                    kind = k
+                    break
+            yield kind, files.get(int(match.group(3)), "<unknown>"), size
+
+
+def read_map(path):
+    """Yield (kind, file, size) for every input section of a linker map."""
+    with open(path, errors="replace") as f:
+        first = f.readline()
+        f.seek(0)
+        if first.startswith("# Path:"):
+            yield from parse_ld64_map(iter(f))
+            return
+        if "VMA" in first and "LMA" in first:
+            for out, section, file, size in parse_lld_map(iter(f)):
+                yield section_kind(out), file, size
+            return
+        for out, section, file, size in parse_gnu_map(iter(f)):
+            yield section_kind(out), file, size
+
+
+def unit_of(obj):
+    name = os.path.basename(obj)
+    for pattern, unit in UNIT_PATTERNS:
+        match = pattern.match(name)
+        if match:
+            return unit.format(*match.groups())
+    return NATIVE_UNIT
+
+
+def library_of(archive, obj, app):
+    if archive is None:
+        if obj.startswith("<"):
+            return "<linker>"
+        # The app's own objects (CMake's or the units'), or the C runtime's
+        if ".dir/" in obj or unit_of(obj) != NATIVE_UNIT:
+            return app
+        return "<system>"
+    name = os.path.basename(archive)
+    if name.startswith("lib"):
+        name = name[3:]
+    return os.path.splitext(name)[0]
+
+
+def add(table, key, kind, size):
+    entry = table.setdefault(key, {k: 0 for k in KINDS})
+    entry[kind] += size
+
+
+def file_bytes(entry):
+    return sum(v for k, v in entry.items() if k != "bss")
+
+
+def build_report(map_path, executable, app):
+    libraries = {}
+    units = {}
+    totals = {k: 0 for k in KINDS}
+    for kind, file, size in read_map(map_path):
+        archive, obj = split_input(file.strip())
+        add(libraries, library_of(archive, obj, app), kind, size)
+        add(units, unit_of(obj), kind, size)
+        totals[kind] += size
+    return {
+        "app": app,
+        "executable": os.path.getsize(executable) if executable and os.path.exists(executable) else None,
+        "totals": totals,
+        "libraries": libraries,
+        "units": units,
+    }
+
+
+def git_revision():
+    try:
+        return subprocess.run(
+            ["git", "rev-parse", "--short", "HEAD"],
+            cwd=os.path.dirname(os.path.abspath(__file__)),
+            capture_output=True, text=True, check=True,
+        ).stdout.strip()
+    except (OSError, subprocess.CalledProcessError):
+        return None
+
+
+def kb(n):
+    return "%.1f KB" % (n / 1024.0)
+
+
+def signed_kb(n):
+    return ("+" if n > 0 else "") + kb(n)
+
+
+def print_table(title, table):
+    print("\n%s:" % title)
+    print("  %-28s %12s %12s %12s %12s %12s" % ("", "file", "text", "rodata", "data", "bss"))
+    for key in sorted(table, key=lambda k: -file_bytes(table[k])):
+        e = table[key]
+        print("  %-28s %12s %12s %12s %12s %12s" % (
+            key, kb(file_bytes(e)), kb(e["text"]), kb(e["rodata"]), kb(e["data"]), kb(e["bss"])))
+
+
+def print_report(report):
+    line = "%s: %s in sections" % (report["app"], kb(file_bytes(report["totals"])))
+    if report["executable"] is not None:
+        line += ", executable %s" % kb(report["executable"])
+    print(line)
+    print_table("By library", report["libraries"])
+    print_table("By unit", report["units"])
+
+
+def print_comparison(report, baseline):
+    print("\nChange since the baseline:")
+    delta = file_bytes(report["totals"]) - file_bytes(baseline["totals"])
+    print("  %-28s %12s" % ("total", signed_kb(delta)))
+    if report["executable"] is not None and baseline.get("executable") is not None:
+        print("  %-28s %12s" % ("executable", signed_kb(report["executable"] - baseline["executable"])))
+    for part, label in (("libraries", "library"), ("units", "unit")):
+        now = report[part]
+        before = baseline.get(part, {})
+        changes = []
+        for key in set(now) | set(before):
+            d = (file_bytes(now[key]) if key in now else 0) - \
+                (file_bytes(before[key]) if key in before else 0)
+            if d:
+                changes.append((key, d))
+        for key, d in sorted(changes, key=lambda c: -abs(c[1])):
+            print("  %-28s %12s" % ("%s %s" % (label, key), signed_kb(d)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[1])
+    parser.add_argument("--map", required=True)
+    parser.add_argument("--executable")
+    parser.add_argument("--app")
+    parser.add_argument("--output")
+    parser.add_argument("--history")
+    parser.add_argument("--baseline")
+    args = parser.parse_args()
+
+    if not os.path.exists(args.map):
+        sys.stderr.write("size-report: %s not found; link the app first\n" % args.map)
+        sys.exit(1)
+    app = args.app or os.path.splitext(os.path.basename(args.map))[0]
+    report = build_report(args.map, args.executable, app)
+    print_report(report)
+
+    if args.output:
+        with open(args.output, "w") as f:
+            json.dump(report, f, indent=2, sort_keys=True)
+            f.write("\n")
+    if args.history:
+        os.makedirs(os.path.dirname(os.path.abspath(args.history)), exist_ok=True)
+        entry = {
+            "time": time.strftime("%Y-%m-%dT%H:%M:%S%z"),
+            "revision": git_revision(),
+            "total": file_bytes(report["totals"]),
+            "executable": report["executable"],
+            "libraries": {k: file_bytes(v) for k, v in report["libraries"].items()},
+            "units": {k: file_bytes(v) for k, v in report["units"].items()},
+        }
+        with open(args.history, "a") as f:
+            f.write(json.dumps(entry, sort_keys=True) + "\n")
+    if args.baseline:
+        if os.path.exists(args.baseline):
+            with open(args.baseline) as f:
+                print_comparison(report, json.load(f))
+        else:
+            print("\nNo baseline at %s yet" % args.baseline)
+
+
+if __name__ == "__main__":
+    main()
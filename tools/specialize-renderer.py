@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+# Copyright (c) Tzvetan Mikov and contributors
+# SPDX-License-Identifier: MIT
+# See LICENSE file for full license text
+
+"""
+Specialize the imgui unit sources for the host components an app uses.
+
+The shared imgui unit renders every host component. For one app, this
+script keeps only the renderNode() cases of the components that appear in
+its bundles: a component is used if its JSX name appears as a string
+literal ("window", 'tabbar') in one of the scanned files. The render
+functions that no kept code references anymore are then removed too, and
+prune-externs.py drops the bindings that only they used. Removed lines
+become blank lines, so that line numbers stay the same.
+
+Usage:
+  specialize-renderer.py --node-tags node-tags.js --out-dir DIR \\
+      --scan bundle.js [--scan ...] [--include name,...] source.js...
+
+The sources are the imgui unit sources, all of which are written to DIR;
+only the ones holding the renderNode() switch or removed functions change.
+--include adds components that the scan can't see, e.g. element types
+computed at run time. <root> is always kept.
+
+A function is only removed if the removed cases made it unreferenced:
+functions that nothing in the sources references, such as entry points
+called by name from native code, are always kept.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+TYPE_TAGS_RE = re.compile(r"const typeTags = Object\.freeze\(\{(.*?)\}\);", re.S)
+IDENT_RE = re.compile(r"[A-Za-z_$][\w$]*")
+FUNC_RE = re.compile(r"^function (\w+)\(")
+SWITCH_RE = re.compile(r"^  switch \(tag\) \{$")
+CASE_RE = re.compile(r"^  case TAG_(\w+):$")
+CASE_END_RE = re.compile(r"^    break;$")
+
+
+def read_type_tags(path):
+    with open(path) as f:
+        match = TYPE_TAGS_RE.search(f.read())
+    if not match:
+        sys.exit("specialize-renderer: %s: typeTags not found" % path)
+    return re.findall(r"^\s*(\w+):", match.group(1), re.M)
+
+
+def used_types(types, scanned, include):
+    text = ""
+    for path in scanned:
+        with open(path, errors="replace") as f:
+            text += f.read()
+    # The containers of createRoot() are always there
+    used = {"root"} | set(include)
+    for t in types:
+        if re.search(r"""["']%s["']""" % re.escape(t), text):
+            used.add(t)
+    return used
+
+
+def remove_cases(lines, used):
+    """Blank the renderNode() cases of the unused components. Returns the
+    names of the removed ones."""
+    removed = []
+    i = 0
+    while i < len(lines) and not SWITCH_RE.match(lines[i].rstrip("\n")):
+        i += 1
+    while i < len(lines) and lines[i].rstrip("\n") != "  }":
+        m = CASE_RE.match(lines[i].rstrip("\n"))
+        if m and m.group(1).lower() not in used:
+            end = i
+            while not CASE_END_RE.match(lines[end].rstrip("\n")):
+                end += 1
+            for j in range(i, end + 1):
+                lines[j] = "\n"
+            removed.append(m.group(1).lower())
+            i = end
+        i += 1
+    return removed
+
+
+def functions(sources):
+    """Map every top-level function to (source, first line, last line)."""
+    funcs = {}
+    for source, lines in sources.items():
+        i = 0
+        while i < len(lines):
+            m = FUNC_RE.match(lines[i])
+            if m:
+                end = i
+                while not lines[end].startswith("}"):
+                    end += 1
+                funcs[m.group(1)] = (source, i, end)
+                i = end
+            i += 1
+    return funcs
+
+
+def referenced(sources, funcs):
+    """The functions referenced from outside their own bodies."""
+    refs = set()
+    names = set(funcs)
+    for source, lines in sources.items():
+        own = {}
+        for name, (s, start, end) in funcs.items():
+            if s == source:
+                for j in range(start, end + 1):
+                    own[j] = name
+        for j, line in enumerate(lines):
+            for ident in IDENT_RE.findall(line):
+                if ident in names and own.get(j) != ident:
+                    refs.add(ident)
+    return refs
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[1])
+    parser.add_argument("--node-tags", required=True)
+    parser.add_argument("--out-dir", required=True)
+    parser.add_argument("--scan", action="append", default=[])
+    parser.add_argument("--include", default="")
+    parser.add_argument("sources", nargs="+")
+    args = parser.parse_args()
+
+    types = read_type_tags(args.node_tags)
+    include = [t for t in args.include.replace(";", ",").split(",") if t]
+    for t in include:
+        if t not in types:
+            parser.error("--include: unknown component '%s'" % t)
+    used = used_types(types, args.scan, include)
+
+    sources = {}
+    for source in args.sources:
+        with open(source) as f:
+            sources[source] = f.readlines()
+
+    before = referenced(sources, functions(sources))
+    removed_cases = []
+    for lines in sources.values():
+        removed_cases += remove_cases(lines, used)
+
+    # Remove the functions that lost their last reference, until none does
+    removed_funcs = 0
+    while True:
+        funcs = functions(sources)
+        refs = referenced(sources, funcs)
+        dead = [name for name in funcs if name in before and name not in refs]
+        if not dead:
+            break
+        for name in dead:
+            source, start, end = funcs[name]
+            lines = sources[source]
+            # With the doc comment just above it
+            while start > 0 and lines[start - 1].startswith((" *", "/**")):
+                start -= 1
+            for j in range(start, end + 1):
+                lines[j] = "\n"
+            removed_funcs += 1
+
+    os.makedirs(args.out_dir, exist_ok=True)
+    for source, lines in sources.items():
+        with open(os.path.join(args.out_dir, os.path.basename(source)), "w") as f:
+            f.writelines(lines)
+
+    print(
+        "specialize-renderer: kept %d of %d components (removed %s), %d functions"
+        % (len(types) - len(removed_cases), len(types),
+           ", ".join(removed_cases) or "none", removed_funcs),
+        file=sys.stderr,
+    )
+
+
+if __name__ == "__main__":
+    main()
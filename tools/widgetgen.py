@@ -0,0 +1,385 @@
+#!/usr/bin/env python3
+# Copyright (c) Tzvetan Mikov and contributors
+# SPDX-License-Identifier: MIT
+# See LICENSE file for full license text
+
+"""
+Generate the renderer functions of the simple widgets from their schema.
+
+lib/imgui-unit/widgets.json describes each widget by its props (type,
+default, doc) and the ImGui calls that render it. From it this script
+writes:
+
+- the typed renderer functions (lib/imgui-unit/widgets.js): a
+  build<Name>Plan() that reads every value prop once per commit into the
+  node's render plan, with strings encoded into the node's persistent UTF-8
+  slots, and a render<Name>() that only passes plan fields to the scalar
+  `_flat`/FFI bindings;
+- the prop table of the host config
+  (lib/react-imgui-reconciler/widget-props.js), which tells diffProps() the
+  props each widget reads, so that other props and callbacks don't drop
+  its plan;
+- the TypeScript typings of the props
+  (lib/react-imgui-reconciler/widgets.d.ts).
+
+Usage:
+  widgetgen.py --schema widgets.json --node-tags node-tags.js \\
+      --renderer widgets.js --props widget-props.js --typings widgets.d.ts
+
+Schema entries, keyed by the JSX element name (which must have a tag in
+node-tags.js; the renderNode() case stays hand-written):
+
+  name      Capitalized name used in the function names
+  doc       Doc comment of the render function
+  text      The widget is labeled by its text children; the fallback label
+  props     name -> { type, default, doc, flag }. `type` is one of
+            string, number, flags, bool or event. A bool with `flag` ORs
+            that constant into the `flags` prop instead of being a field.
+  call      The ImGui call, e.g. `_igBeginTabBar(id, flags)`. Arguments
+            naming a prop (or `text`) are replaced by its plan field;
+            anything else is passed as written.
+  event     Event prop invoked when the call returns true
+  children  `open`: walk the children while the call returns true;
+            `always`: walk them whatever it returns
+  end       Call closing the scope: after the children, and only when the
+            call returned true for `open`
+"""
+
+import argparse
+import json
+import re
+import sys
+from collections import OrderedDict
+
+HEADER = "Generated by tools/widgetgen.py from lib/imgui-unit/widgets.json; do not edit."
+CALL_RE = re.compile(r"^(\w+)\((.*)\)$")
+TYPE_TAGS_RE = re.compile(r"const typeTags = Object\.freeze\(\{(.*?)\}\);", re.S)
+PROP_TYPES = ("string", "number", "flags", "bool", "event")
+TS_TYPES = {
+    "string": "string",
+    "number": "number",
+    "flags": "number",
+    "bool": "boolean",
+}
+# Kinds of the prop table; keep in sync with PropKind in widget-props.js
+PROP_KIND_PLAN = 1
+PROP_KIND_EVENT = 2
+
+
+def fail(message):
+    sys.stderr.write("widgetgen: %s\n" % message)
+    sys.exit(1)
+
+
+def js_string(s):
+    return json.dumps(s)
+
+
+def read_type_tags(path):
+    with open(path) as f:
+        match = TYPE_TAGS_RE.search(f.read())
+    if not match:
+        fail("%s: typeTags not found" % path)
+    return set(re.findall(r"^\s*(\w+):", match.group(1), re.M))
+
+
+def parse_call(widget, call):
+    match = CALL_RE.match(call.strip())
+    if not match:
+        fail("<%s>: can't parse call '%s'" % (widget, call))
+    args = [a.strip() for a in match.group(2).split(",")] if match.group(2).strip() else []
+    return match.group(1), args
+
+
+class Widget:
+    def __init__(self, element, spec, tags):
+        self.element = element
+        if element not in tags:
+            fail("<%s> has no tag in node-tags.js" % element)
+        for key in ("name", "doc", "call"):
+            if key not in spec:
+                fail("<%s>: missing '%s'" % (element, key))
+        self.name = spec["name"]
+        self.doc = spec["doc"]
+        self.text = spec.get("text")
+        self.props = spec.get("props", OrderedDict())
+        self.event = spec.get("event")
+        self.children = spec.get("children")
+        self.end = spec.get("end")
+        if self.children not in (None, "open", "always"):
+            fail("<%s>: children must be 'open' or 'always'" % element)
+        if self.event and self.children:
+            fail("<%s>: a widget has either an event or children" % element)
+        if self.end and not self.children:
+            fail("<%s>: 'end' needs 'children'" % element)
+
+        # Persistent node slots: the text label first, then the strings
+        self.slots = OrderedDict()
+        if self.text is not None:
+            self.slots["text"] = 0
+        for prop, p in self.props.items():
+            if prop in ("node", "props", "plan", "c", "text"):
+                fail("<%s>: prop name '%s' is reserved" % (element, prop))
+            if p.get("type") not in PROP_TYPES:
+                fail("<%s>: prop '%s' has no valid type" % (element, prop))
+            if p.get("flag") and (p["type"] != "bool" or "flags" not in self.props):
+                fail("<%s>: flag prop '%s' must be a bool next to a 'flags' prop" % (element, prop))
+            if p["type"] == "string":
+                self.slots[prop] = len(self.slots)
+        if self.event and self.props.get(self.event, {}).get("type") != "event":
+            fail("<%s>: '%s' is not an event prop" % (element, self.event))
+
+        self.fn, self.args = parse_call(element, spec["call"])
+        for arg in self.args:
+            if arg in self.props and self.props[arg]["type"] == "event":
+                fail("<%s>: event '%s' passed to the call" % (element, arg))
+        if self.end:
+            self.end_fn, self.end_args = parse_call(element, self.end)
+
+    def plan_locals(self):
+        """The locals of the plan builder: (name, expression)."""
+        return [
+            (prop, "(props && props.%s !== undefined) ? String(props.%s) : %s"
+             % (prop, prop, js_string(str(p.get("default", "")))))
+            for prop, p in self.props.items() if p["type"] == "string"
+        ]
+
+    def plan_fields(self):
+        """The plan fields: (field, expression), in prop order."""
+        fields = []
+        if self.text is not None:
+            fields.append(("labelSlot", "textLabelSlot(node, %s)" % js_string(self.text)))
+        for prop, p in self.props.items():
+            t = p["type"]
+            if t == "event" or (t == "bool" and p.get("flag")):
+                continue
+            value = "props.%s" % prop
+            defined = "(props && %s !== undefined)" % value
+            if t == "string":
+                fields.append(("%sSlot" % prop, "nodeUtf8(node, %d, %s)" % (self.slots[prop], prop)))
+            elif t == "number":
+                default = repr(float(p.get("default", 0)))
+                fields.append((prop, "%s ? validateNumber(%s, %s, %s) : %s"
+                               % (defined, value, default, js_string(prop), default)))
+            elif t == "flags":
+                fields.append((prop, "%s ? +%s : %d" % (defined, value, int(p.get("default", 0)))))
+            else:
+                fields.append((prop, "!!(props && %s)" % value))
+        return fields
+
+    def flag_props(self):
+        return [(prop, p["flag"]) for prop, p in self.props.items() if p.get("flag")]
+
+    def arg_expr(self, arg):
+        if arg == "text" and self.text is not None:
+            return "utf8SlotPtr(plan.labelSlot)"
+        if arg in self.slots:
+            return "utf8SlotPtr(plan.%sSlot)" % arg
+        if arg in self.props:
+            return "plan.%s" % arg
+        return arg
+
+    def reads_props(self):
+        return any(p["type"] != "event" for p in self.props.values())
+
+
+def emit_renderer(widgets):
+    out = []
+    out.append("// Copyright (c) Tzvetan Mikov and contributors")
+    out.append("// SPDX-License-Identifier: MIT")
+    out.append("// See LICENSE file for full license text")
+    out.append("")
+    out.append("// " + HEADER)
+    out.append("// Renderer functions of the widgets described by the schema, compiled")
+    out.append("// after renderer.js, whose helpers they use.")
+    for w in widgets:
+        fields = w.plan_fields()
+        if fields:
+            out.append("")
+            out.append("/**")
+            out.append(" * Builds the render plan for a <%s>." % w.element)
+            out.append(" */")
+            out.append("function build%sPlan(node: any): any {" % w.name)
+            if w.reads_props():
+                out.append("  const props = node.props;")
+            for name, expr in w.plan_locals():
+                out.append("  const %s = %s;" % (name, expr))
+            flags = w.flag_props()
+            if flags:
+                flags_expr = dict(fields)["flags"]
+                out.append("  let flags = %s;" % flags_expr)
+                for prop, flag in flags:
+                    out.append("  if (props && props.%s) flags |= %s;" % (prop, flag))
+            out.append("  return {")
+            for field, expr in fields:
+                if flags and field == "flags":
+                    expr = "flags"
+                out.append("    %s: %s," % (field, expr))
+            out.append("  };")
+            out.append("}")
+
+        out.append("")
+        out.append("/**")
+        for line in wrap_doc(w.doc, 74):
+            out.append(" * " + line)
+        out.append(" */")
+        out.append("function render%s(node: any): void {" % w.name)
+        if fields:
+            out.append("  let plan = node.plan;")
+            out.append("  if (plan === null) {")
+            out.append("    plan = build%sPlan(node);" % w.name)
+            out.append("    node.plan = plan;")
+            out.append("  }")
+        call = "%s(%s)" % (w.fn, ", ".join(w.arg_expr(a) for a in w.args))
+        end = None
+        if w.end:
+            end = "%s(%s)" % (w.end_fn, ", ".join(w.arg_expr(a) for a in w.end_args))
+        if w.event:
+            out.append("  if (%s) {" % call)
+            out.append("    safeInvokeEvent(EVENT_DISCRETE, node.props ? node.props.%s : null);" % w.event)
+            out.append("  }")
+        elif w.children == "open":
+            out.append("  if (%s) {" % call)
+            out.extend(children_loop("    "))
+            if end:
+                out.append("    %s;" % end)
+            out.append("  }")
+        else:
+            out.append("  %s;" % call)
+            if w.children == "always":
+                out.extend(children_loop("  "))
+            if end:
+                out.append("  %s;" % end)
+        out.append("}")
+    return "\n".join(out) + "\n"
+
+
+def children_loop(indent):
+    return [
+        indent + "for (let c = node.firstChild; c; c = c.nextSibling) {",
+        indent + "  renderNode(c);",
+        indent + "}",
+    ]
+
+
+def wrap_doc(text, width):
+    lines = []
+    line = ""
+    for word in text.split():
+        if line and len(line) + 1 + len(word) > width:
+            lines.append(line)
+            line = word
+        else:
+            line = word if not line else line + " " + word
+    if line:
+        lines.append(line)
+    return lines
+
+
+def emit_props(widgets):
+    out = []
+    out.append("// Copyright (c) Tzvetan Mikov and contributors")
+    out.append("// SPDX-License-Identifier: MIT")
+    out.append("// See LICENSE file for full license text")
+    out.append("")
+    out.append("// " + HEADER)
+    out.append("")
+    out.append("/**")
+    out.append(" * How a generated renderer reads a prop: PLAN props are read into the")
+    out.append(" * node's render plan, EVENT props when the event fires.")
+    out.append(" */")
+    out.append("export const PropKind = Object.freeze({")
+    out.append("  PLAN: %d," % PROP_KIND_PLAN)
+    out.append("  EVENT: %d," % PROP_KIND_EVENT)
+    out.append("});")
+    out.append("")
+    out.append("/**")
+    out.append(" * The props read by the renderer of each generated widget. A prop that")
+    out.append(" * isn't listed can't change what the widget renders.")
+    out.append(" */")
+    out.append("export const widgetProps = Object.freeze({")
+    for w in widgets:
+        entries = []
+        for prop, p in w.props.items():
+            kind = "PropKind.EVENT" if p["type"] == "event" else "PropKind.PLAN"
+            entries.append("%s: %s" % (prop, kind))
+        line = "  %s: Object.freeze({ %s })," % (w.element, ", ".join(entries))
+        if not entries:
+            out.append("  %s: Object.freeze({})," % w.element)
+        elif len(line) <= 80:
+            out.append(line)
+        else:
+            out.append("  %s: Object.freeze({" % w.element)
+            for entry in entries:
+                out.append("    %s," % entry)
+            out.append("  }),")
+    out.append("});")
+    return "\n".join(out) + "\n"
+
+
+def emit_typings(widgets):
+    out = []
+    out.append("// Copyright (c) Tzvetan Mikov and contributors")
+    out.append("// SPDX-License-Identifier: MIT")
+    out.append("// See LICENSE file for full license text")
+    out.append("")
+    out.append("// " + HEADER)
+    out.append("")
+    out.append("import type { ReactNode } from 'react';")
+    for w in widgets:
+        out.append("")
+        out.append("/** Props of <%s>. */" % w.element)
+        out.append("export interface %sProps {" % w.name)
+        if w.text is not None:
+            out.append("  /** The label; \"%s\" if empty */" % w.text)
+            out.append("  children?: string | number | (string | number)[];")
+        elif w.children:
+            out.append("  children?: ReactNode;")
+        for prop, p in w.props.items():
+            doc = p.get("doc")
+            if doc:
+                if "default" in p:
+                    doc += " (default: %s)" % json.dumps(p["default"])
+                out.append("  /** %s */" % doc)
+            if p["type"] == "event":
+                out.append("  %s?: () => void;" % prop)
+            else:
+                out.append("  %s?: %s;" % (prop, TS_TYPES[p["type"]]))
+        out.append("}")
+    out.append("")
+    out.append("/**")
+    out.append(" * The generated host elements, for merging into JSX.IntrinsicElements.")
+    out.append(" */")
+    out.append("export interface WidgetElements {")
+    for w in widgets:
+        out.append("  %s: %sProps;" % (w.element, w.name))
+    out.append("}")
+    return "\n".join(out) + "\n"
+
+
+def write(path, text):
+    with open(path, "w") as f:
+        f.write(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[1])
+    parser.add_argument("--schema", required=True)
+    parser.add_argument("--node-tags", required=True)
+    parser.add_argument("--renderer", required=True)
+    parser.add_argument("--props", required=True)
+    parser.add_argument("--typings", required=True)
+    args = parser.parse_args()
+
+    with open(args.schema) as f:
+        schema = json.load(f, object_pairs_hook=OrderedDict)
+    tags = read_type_tags(args.node_tags)
+    widgets = [Widget(element, spec, tags) for element, spec in schema.items()]
+
+    write(args.renderer, emit_renderer(widgets))
+    write(args.props, emit_props(widgets))
+    write(args.typings, emit_typings(widgets))
+
+
+if __name__ == "__main__":
+    main()